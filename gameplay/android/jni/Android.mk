@@ -19,47 +19,70 @@ LOCAL_SRC_FILES := \
     AudioController.cpp \
     AudioListener.cpp \
     AudioSource.cpp \
+    BillboardSet.cpp \
     BoundingBox.cpp \
     BoundingSphere.cpp \
     Bundle.cpp \
     Button.cpp \
     Camera.cpp \
     CheckBox.cpp \
+    CommandBuffer.cpp \
     Container.cpp \
     Control.cpp \
     ControlFactory.cpp \
     Curve.cpp \
+    DebugDraw.cpp \
     DebugNew.cpp \
+    DepthPyramid.cpp \
     DepthStencilTarget.cpp \
+    DynamicResolution.cpp \
     Effect.cpp \
     FileSystem.cpp \
     FlowLayout.cpp \
     Font.cpp \
     Form.cpp \
     FrameBuffer.cpp \
+    FramePacer.cpp \
     Frustum.cpp \
     Game.cpp \
     Gamepad.cpp \
+    GLStateCache.cpp \
+    GlyphCache.cpp \
+    GraphicsMemory.cpp \
+    GraphicsResource.cpp \
     HeightField.cpp \
     Image.cpp \
     ImageControl.cpp \
+    InputQueue.cpp \
+    InputRecorder.cpp \
+    JobScheduler.cpp \
     Joint.cpp \
     JoystickControl.cpp \
     Label.cpp \
     Layout.cpp \
     Light.cpp \
+    LightClusters.cpp \
+    ListView.cpp \
     Logger.cpp \
     Material.cpp \
     MaterialParameter.cpp \
     MathUtil.cpp \
     Matrix.cpp \
+    MemoryPool.cpp \
+    MemoryTracker.cpp \
     Mesh.cpp \
     MeshBatch.cpp \
+    MeshBVH.cpp \
     MeshPart.cpp \
     MeshSkin.cpp \
     Model.cpp \
+    NavMesh.cpp \
     Node.cpp \
+    NullGL.cpp \
+    OcclusionCuller.cpp \
+    Octree.cpp \
     ParticleEmitter.cpp \
+    ParticleEmitterPool.cpp \
     Pass.cpp \
     PhysicsCharacter.cpp \
     PhysicsCollisionObject.cpp \
@@ -78,35 +101,57 @@ LOCAL_SRC_FILES := \
     Plane.cpp \
     Platform.cpp \
     PlatformAndroid.cpp \
+    PlatformHeadless.cpp \
+    PostProcessChain.cpp \
+    Profiler.cpp \
     Properties.cpp \
     Quaternion.cpp \
     RadioButton.cpp \
     Ray.cpp \
     Rectangle.cpp \
     Ref.cpp \
+    ReflectionProbe.cpp \
+    RenderQueue.cpp \
     RenderState.cpp \
     RenderTarget.cpp \
+    RenderTargetPool.cpp \
+    RenderThread.cpp \
     Scene.cpp \
     SceneLoader.cpp \
+    SceneSnapshot.cpp \
+    SceneView.cpp \
+    ScratchMemory.cpp \
     ScreenDisplayer.cpp \
     ScriptController.cpp \
+    ScriptFunction.cpp \
     ScriptTarget.cpp \
+    ShadowMap.cpp \
     Slider.cpp \
     SpriteBatch.cpp \
+    SpriteRenderer.cpp \
+    StartupTrace.cpp \
+    StaticGeometry.cpp \
     Technique.cpp \
+    Telemetry.cpp \
     Terrain.cpp \
+    TerrainPager.cpp \
     TerrainPatch.cpp \
     TextBox.cpp \
     Texture.cpp \
+    TextureAtlas.cpp \
     Theme.cpp \
     ThemeStyle.cpp \
+    Thread.cpp \
+    TimerWheel.cpp \
     Transform.cpp \
+    TransformReplicator.cpp \
     Vector2.cpp \
     Vector3.cpp \
     Vector4.cpp \
     VertexAttributeBinding.cpp \
     VertexFormat.cpp \
     VerticalLayout.cpp \
+    VisibilitySet.cpp \
     lua/lua_AbsoluteLayout.cpp \
     lua/lua_AIAgent.cpp \
     lua/lua_AIAgentListener.cpp \
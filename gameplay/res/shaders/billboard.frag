@@ -0,0 +1,26 @@
+#ifdef OPENGL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform sampler2D u_texture;
+uniform float u_alphaThreshold;
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+
+void main()
+{
+    vec4 color = v_color * texture2D(u_texture, v_texCoord);
+    if (color.a < u_alphaThreshold)
+        discard;
+    gl_FragColor = color;
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////
+// Attributes
+attribute vec3 a_position;
+attribute vec2 a_texCoord;
+attribute vec2 a_texCoord1;
+attribute float a_texCoord2;
+attribute vec4 a_color;
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform mat4 u_viewProjectionMatrix;
+uniform vec3 u_cameraPosition;
+uniform vec3 u_cameraRight;
+uniform vec3 u_cameraUp;
+uniform float u_upright;
+uniform vec2 u_frameSize;
+uniform float u_frameColumns;
+uniform float u_viewCount;
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+
+void main()
+{
+    // a_position is the center of the billboard, a_texCoord the corner of the vertex,
+    // a_texCoord1 the size of the billboard and a_texCoord2 its first frame.
+    vec3 toCamera = u_cameraPosition - a_position;
+    vec3 right = u_cameraRight;
+    vec3 up = u_cameraUp;
+    if (u_upright > 0.5)
+    {
+        vec3 side = vec3(toCamera.z, 0.0, -toCamera.x);
+        right = side / max(length(side), 0.0001);
+        up = vec3(0.0, 1.0, 0.0);
+    }
+
+    // Impostors show the capture taken from the direction nearest to the camera.
+    float frame = a_texCoord2;
+    if (u_viewCount > 1.0)
+    {
+        float view = floor(atan(toCamera.x, toCamera.z) * u_viewCount / 6.2831853 + 0.5);
+        frame += mod(view, u_viewCount);
+    }
+
+    vec2 cell = vec2(mod(frame, u_frameColumns), floor((frame + 0.5) / u_frameColumns));
+    v_texCoord = vec2((cell.x + a_texCoord.x) * u_frameSize.x, 1.0 - (cell.y + 1.0 - a_texCoord.y) * u_frameSize.y);
+    v_color = a_color;
+
+    vec3 position = a_position + right * ((a_texCoord.x - 0.5) * a_texCoord1.x) + up * ((a_texCoord.y - 0.5) * a_texCoord1.y);
+    gl_Position = u_viewProjectionMatrix * vec4(position, 1.0);
+}
@@ -7,14 +7,24 @@
 #ifndef POINT_LIGHT_COUNT
 #define POINT_LIGHT_COUNT 0
 #endif
-#if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
+#if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(CLUSTERED_LIGHTING)
 #define LIGHTING
 #endif
+#if defined(LIGHTING) && (defined(SHADOW_CASCADE_COUNT) || defined(SPOT_SHADOW))
+#define SHADOWS
+#endif
+#if defined(LIGHTING) && defined(REFLECTION_PROBE)
+#define REFLECTIONS
+#endif
 
 ///////////////////////////////////////////////////////////
 // Attributes
 attribute vec4 a_position;
 
+#if defined(INSTANCED)
+attribute mat4 a_instanceMatrix;
+#endif
+
 #if defined(SKINNING)
 attribute vec4 a_blendWeights;
 attribute vec4 a_blendIndices;
@@ -34,18 +44,46 @@ attribute vec3 a_color;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
+#if defined(INSTANCED)
+// The world matrix of each instance is supplied as a vertex attribute,
+// so world-dependent matrices are derived from the view matrices.
+// Normals assume the instance matrices contain only uniform scaling.
+#if defined(FRAME_UNIFORMS)
+#include "frame-uniforms.vert"
+#else
+uniform mat4 u_viewProjectionMatrix;
+#if defined(LIGHTING)
+uniform mat4 u_viewMatrix;
+#endif
+#endif
+#define u_worldViewProjectionMatrix (u_viewProjectionMatrix * a_instanceMatrix)
+#if defined(LIGHTING)
+#define u_worldViewMatrix (u_viewMatrix * a_instanceMatrix)
+#define u_inverseTransposeWorldViewMatrix u_worldViewMatrix
+#endif
+#else
 uniform mat4 u_worldViewProjectionMatrix;
+#endif
 
 #if defined(SKINNING)
+#if defined(SKINNING_PALETTE_TEXTURE)
+uniform sampler2D u_matrixPaletteTexture;
+uniform vec2 u_matrixPaletteTexelSize;
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
 #endif
+#endif
 
 #if defined(LIGHTING)
+#if !defined(INSTANCED)
 uniform mat4 u_inverseTransposeWorldViewMatrix;
 
-#if (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(SPECULAR)
+#if (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(SPECULAR) || defined(CLUSTERED_LIGHTING) || defined(SHADOWS)
 uniform mat4 u_worldViewMatrix;
 #endif
+#endif
 
 #if (DIRECTIONAL_LIGHT_COUNT > 0)
 uniform vec3 u_directionalLightDirection[DIRECTIONAL_LIGHT_COUNT];
@@ -96,8 +134,20 @@ varying vec3 v_vertexToSpotLightDirection[SPOT_LIGHT_COUNT];
 varying vec3 v_cameraDirection;
 #endif
 
+#if defined(CLUSTERED_LIGHTING)
+varying vec3 v_positionViewSpace;
+#endif
+
 #include "lighting.vert"
 
+#if defined(SHADOWS)
+#include "shadow-receiver.vert"
+#endif
+
+#if defined(REFLECTIONS)
+#include "reflection-probe.vert"
+#endif
+
 #endif
 
 #if defined(SKINNING)
@@ -123,6 +173,14 @@ void main()
     // Apply light.
     applyLight(position);
 
+    #if defined(SHADOWS)
+    applyShadow(position);
+    #endif
+
+    #if defined(REFLECTIONS)
+    applyReflection(position, normal);
+    #endif
+
     #endif
 
     // Pass the lightmap texture coordinate
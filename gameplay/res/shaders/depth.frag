@@ -0,0 +1,13 @@
+#ifdef OPENGL_ES
+precision mediump float;
+#endif
+
+///////////////////////////////////////////////////////////
+// Fragment shader of the depth pre-pass, which only writes depth.
+// It is linked with the vertex shader of the pass it draws the depth of,
+// so that the pass draws the same depths again when testing for equality.
+
+void main()
+{
+    gl_FragColor = vec4(0.0);
+}
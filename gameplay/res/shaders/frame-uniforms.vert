@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////
+// Frame uniforms
+//
+// Camera parameters shared by all effects through a single uniform buffer,
+// which is only updated when the active camera changes. Shaders include this
+// file when FRAME_UNIFORMS is defined, instead of declaring these uniforms.
+layout(std140) uniform FrameUniforms
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    mat4 u_viewProjectionMatrix;
+    vec3 u_cameraWorldPosition;
+    vec3 u_cameraViewPosition;
+};
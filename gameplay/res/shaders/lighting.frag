@@ -26,6 +26,48 @@ vec3 computeLighting(vec3 normalVector, vec3 lightDirection, vec3 lightColor, fl
     #endif
 }
 
+#if defined(CLUSTERED_LIGHTING)
+// Must match LightClusters::MAX_CLUSTER_LIGHTS.
+#define CLUSTER_LIGHT_COUNT 32
+
+vec4 getLightClusterTexel(float index)
+{
+    float row = floor(index / u_lightClusterLayout.z);
+    vec2 texel = vec2(index - row * u_lightClusterLayout.z, row) + 0.5;
+    return texture2D(u_lightClusterTexture, texel * u_lightClusterTexelSize);
+}
+
+vec3 computeClusteredLighting(vec3 normalVector)
+{
+    // Find the cluster of the pixel from its screen tile and view-space depth.
+    vec2 tile = floor((gl_FragCoord.xy - u_lightClusterViewport.xy) * u_lightClusterViewport.zw * u_lightClusterGrid.xy);
+    float slice = floor(log(-v_positionViewSpace.z) * u_lightClusterDepth.x + u_lightClusterDepth.y);
+    vec3 cluster = clamp(vec3(tile, slice), vec3(0.0), u_lightClusterGrid - 1.0);
+    vec4 header = getLightClusterTexel(u_lightClusterLayout.x + cluster.x + (cluster.y + cluster.z * u_lightClusterGrid.y) * u_lightClusterGrid.x);
+
+    vec3 combinedColor = vec3(0.0);
+    for (int i = 0; i < CLUSTER_LIGHT_COUNT; ++i)
+    {
+        if (float(i) >= header.y)
+            break;
+
+        // Light lists store four light indices per texel.
+        float listIndex = header.x + float(i);
+        vec4 indices = getLightClusterTexel(u_lightClusterLayout.y + floor(listIndex / 4.0));
+        float slot = listIndex - floor(listIndex / 4.0) * 4.0;
+        float light = slot < 1.0 ? indices.x : (slot < 2.0 ? indices.y : (slot < 3.0 ? indices.z : indices.w));
+
+        vec4 position = getLightClusterTexel(light * 2.0);
+        vec3 color = getLightClusterTexel(light * 2.0 + 1.0).rgb;
+        vec3 vertexToLightDirection = position.xyz - v_positionViewSpace;
+        vec3 ldir = vertexToLightDirection * position.w;
+        float attenuation = clamp(1.0 - dot(ldir, ldir), 0.0, 1.0);
+        combinedColor += computeLighting(normalVector, normalize(vertexToLightDirection), color, attenuation);
+    }
+    return combinedColor;
+}
+#endif
+
 vec3 getLitPixel()
 {
     #if defined(BUMPED)
@@ -41,8 +83,13 @@ vec3 getLitPixel()
     vec3 ambientColor = _baseColor.rgb * u_ambientColor;
     vec3 combinedColor = ambientColor;
 
-    // Directional light contribution
+    // Directional light contribution, the first light being shadowed by cascaded shadow maps
     #if (DIRECTIONAL_LIGHT_COUNT > 0)
+    #if defined(SHADOW_CASCADE_COUNT)
+    float directionalShadow = getDirectionalShadow();
+    #else
+    float directionalShadow = 1.0;
+    #endif
     for (int i = 0; i < DIRECTIONAL_LIGHT_COUNT; ++i)
     {
         #if defined(BUMPED)
@@ -50,7 +97,7 @@ vec3 getLitPixel()
         #else
         vec3 lightDirection = normalize(u_directionalLightDirection[i] * 2.0);
         #endif 
-        combinedColor += computeLighting(normalVector, -lightDirection, u_directionalLightColor[i], 1.0);
+        combinedColor += computeLighting(normalVector, -lightDirection, u_directionalLightColor[i], i == 0 ? directionalShadow : 1.0);
     }
     #endif
 
@@ -64,8 +111,13 @@ vec3 getLitPixel()
     }
     #endif
 
-    // Spot light contribution
+    // Spot light contribution, the first light being shadowed by a shadow map
     #if (SPOT_LIGHT_COUNT > 0)
+    #if defined(SPOT_SHADOW)
+    float spotShadow = getSpotShadow();
+    #else
+    float spotShadow = 1.0;
+    #endif
     for (int i = 0; i < SPOT_LIGHT_COUNT; ++i)
     {
         // Compute range attenuation
@@ -84,9 +136,16 @@ vec3 getLitPixel()
 
 		// Apply spot attenuation
         attenuation *= smoothstep(u_spotLightOuterAngleCos[i], u_spotLightInnerAngleCos[i], spotCurrentAngleCos);
+        if (i == 0)
+            attenuation *= spotShadow;
         combinedColor += computeLighting(normalVector, vertexToSpotLightDirection, u_spotLightColor[i], attenuation);
     }
     #endif
 
+    // Clustered point light contribution
+    #if defined(CLUSTERED_LIGHTING)
+    combinedColor += computeClusteredLighting(normalVector);
+    #endif
+
     return combinedColor;
 }
@@ -39,10 +39,14 @@ void applyLight(vec4 position, mat3 tangentSpaceTransformMatrix)
 #else
 void applyLight(vec4 position)
 {
-    #if defined(SPECULAR) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
+    #if defined(SPECULAR) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(CLUSTERED_LIGHTING)
 	vec4 positionWorldViewSpace = u_worldViewMatrix * position;
     #endif
 
+    #if defined(CLUSTERED_LIGHTING)
+    v_positionViewSpace = positionWorldViewSpace.xyz;
+    #endif
+
     #if (POINT_LIGHT_COUNT > 0)
     for (int i = 0; i < POINT_LIGHT_COUNT; ++i)
     {
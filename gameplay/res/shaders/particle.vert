@@ -0,0 +1,117 @@
+#ifndef SPRITE_FRAME_COUNT
+#define SPRITE_FRAME_COUNT 1
+#endif
+
+///////////////////////////////////////////////////////////
+// Attributes
+attribute vec2 a_position;                  // Billboard corner, in the range [-0.5, 0.5]
+attribute vec2 a_texCoord;                  // Particle slot index, random seed
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform mat4 u_worldMatrix;
+uniform mat4 u_viewProjectionMatrix;
+uniform vec3 u_cameraRight;
+uniform vec3 u_cameraUp;
+uniform vec4 u_time;                        // Current time, stop time, emission rate, slot count
+uniform vec2 u_energy;                      // Min, max energy (in seconds)
+uniform vec3 u_position;
+uniform vec3 u_positionVar;
+uniform vec3 u_velocity;
+uniform vec3 u_velocityVar;
+uniform vec3 u_acceleration;
+uniform vec3 u_accelerationVar;
+uniform vec4 u_colorStart;
+uniform vec4 u_colorStartVar;
+uniform vec4 u_colorEnd;
+uniform vec4 u_colorEndVar;
+uniform vec4 u_size;                        // Start min, start max, end min, end max
+uniform vec2 u_rotationPerParticleSpeed;    // Min, max
+uniform vec4 u_sprite;                      // Ellipsoid, animated, looped, frame duration (in seconds)
+uniform float u_spriteFrameRandomOffset;
+uniform vec4 u_spriteFrames[SPRITE_FRAME_COUNT];
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+float random(float seed, float cycle, float n)
+{
+    return fract(sin(seed * 12.9898 + cycle * 78.233 + n * 37.719) * 43758.5453);
+}
+
+vec3 random3(float seed, float cycle, float n)
+{
+    return vec3(random(seed, cycle, n), random(seed, cycle, n + 1.0), random(seed, cycle, n + 2.0)) * 2.0 - 1.0;
+}
+
+vec4 random4(float seed, float cycle, float n)
+{
+    return vec4(random3(seed, cycle, n), random(seed, cycle, n + 3.0) * 2.0 - 1.0);
+}
+
+void main()
+{
+    // Each slot re-emits a particle once every period, so the properties of the
+    // current particle in this slot are derived from the slot seed and the cycle.
+    float period = u_time.w / u_time.z;
+    float elapsed = u_time.x - a_texCoord.x / u_time.z;
+    float cycle = floor(elapsed / period);
+    float age = elapsed - cycle * period;
+    float seed = a_texCoord.y;
+    float energy = mix(u_energy.x, u_energy.y, random(seed, cycle, 0.0));
+
+    // Collapse particles that are not yet emitted, dead or emitted after the emitter was stopped.
+    if (elapsed < 0.0 || age >= energy || u_time.x - age > u_time.y)
+    {
+        gl_Position = vec4(0.0);
+        v_texCoord = vec2(0.0);
+        v_color = vec4(0.0);
+        return;
+    }
+    float percent = age / energy;
+
+    vec3 offset = random3(seed, cycle, 1.0);
+    if (u_sprite.x > 0.5)
+    {
+        offset = normalize(offset + vec3(0.0001)) * pow(random(seed, cycle, 4.0), 1.0 / 3.0);
+    }
+    vec3 velocity = u_velocity + u_velocityVar * random3(seed, cycle, 5.0);
+    vec3 acceleration = u_acceleration + u_accelerationVar * random3(seed, cycle, 8.0);
+    vec3 position = u_position + u_positionVar * offset + velocity * age + acceleration * (0.5 * age * age);
+
+    vec4 colorStart = u_colorStart + u_colorStartVar * random4(seed, cycle, 11.0);
+    vec4 colorEnd = u_colorEnd + u_colorEndVar * random4(seed, cycle, 15.0);
+    v_color = mix(colorStart, colorEnd, percent);
+
+    float sizeStart = mix(u_size.x, u_size.y, random(seed, cycle, 19.0));
+    float sizeEnd = mix(u_size.z, u_size.w, random(seed, cycle, 20.0));
+    float size = mix(sizeStart, sizeEnd, percent);
+
+    float rotationSpeed = mix(u_rotationPerParticleSpeed.x, u_rotationPerParticleSpeed.y, random(seed, cycle, 21.0));
+    float angle = rotationSpeed * (random(seed, cycle, 22.0) + age);
+
+    float frame = floor(random(seed, cycle, 23.0) * u_spriteFrameRandomOffset);
+    if (u_sprite.y > 0.5)
+    {
+        if (u_sprite.z > 0.5)
+        {
+            frame = mod(frame + floor(age / max(u_sprite.w, 0.0001)), float(SPRITE_FRAME_COUNT));
+        }
+        else
+        {
+            frame = min(frame + floor(percent * float(SPRITE_FRAME_COUNT)), float(SPRITE_FRAME_COUNT - 1));
+        }
+    }
+    vec4 frameCoords = u_spriteFrames[int(min(frame, float(SPRITE_FRAME_COUNT - 1)))];
+    v_texCoord = mix(frameCoords.xy, frameCoords.zw, a_position + 0.5);
+
+    // Rotate the billboard corner and orient it towards the camera.
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = vec2(a_position.x * c - a_position.y * s, a_position.x * s + a_position.y * c) * size;
+    vec4 worldPosition = u_worldMatrix * vec4(position, 1.0);
+    worldPosition.xyz += u_cameraRight * corner.x + u_cameraUp * corner.y;
+    gl_Position = u_viewProjectionMatrix * worldPosition;
+}
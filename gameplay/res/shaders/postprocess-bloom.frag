@@ -0,0 +1,12 @@
+///////////////////////////////////////////////////////////
+// Post-processing texture pass that adds the blurred bright parts of the
+// image (its source) back onto the input of the chain.
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform float u_bloomIntensity;
+
+vec4 processTexture(sampler2D source, vec2 texCoord, vec2 texelSize)
+{
+    return texture2D(u_sceneTexture, texCoord) + texture2D(source, texCoord) * u_bloomIntensity;
+}
@@ -0,0 +1,16 @@
+///////////////////////////////////////////////////////////
+// Post-processing texture pass that applies a 9-tap gaussian blur along
+// u_blurDirection (1,0 or 0,1), using linear filtering to read two taps at once.
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform vec2 u_blurDirection;
+
+vec4 processTexture(sampler2D source, vec2 texCoord, vec2 texelSize)
+{
+    vec2 offset1 = u_blurDirection * texelSize * 1.3846153846;
+    vec2 offset2 = u_blurDirection * texelSize * 3.2307692308;
+    return texture2D(source, texCoord) * 0.2270270270 +
+           (texture2D(source, texCoord + offset1) + texture2D(source, texCoord - offset1)) * 0.3162162162 +
+           (texture2D(source, texCoord + offset2) + texture2D(source, texCoord - offset2)) * 0.0702702703;
+}
@@ -0,0 +1,17 @@
+///////////////////////////////////////////////////////////
+// Post-processing texture pass that keeps the bright parts of the image,
+// averaging four texels so that it can downsample at half resolution.
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform float u_bloomThreshold;
+
+vec4 processTexture(sampler2D source, vec2 texCoord, vec2 texelSize)
+{
+    vec4 color = 0.25 * (texture2D(source, texCoord + vec2(-0.5, -0.5) * texelSize) +
+                         texture2D(source, texCoord + vec2(0.5, -0.5) * texelSize) +
+                         texture2D(source, texCoord + vec2(-0.5, 0.5) * texelSize) +
+                         texture2D(source, texCoord + vec2(0.5, 0.5) * texelSize));
+    float luminance = dot(color.rgb, vec3(0.299, 0.587, 0.114));
+    return color * (max(luminance - u_bloomThreshold, 0.0) / max(luminance, 0.0001));
+}
@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////////////
+// Post-processing texture pass that applies fast approximate anti-aliasing (FXAA).
+
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_SPAN_MAX 8.0
+
+vec4 processTexture(sampler2D source, vec2 texCoord, vec2 texelSize)
+{
+    vec3 luma = vec3(0.299, 0.587, 0.114);
+    float lumaNW = dot(texture2D(source, texCoord + vec2(-1.0, -1.0) * texelSize).rgb, luma);
+    float lumaNE = dot(texture2D(source, texCoord + vec2(1.0, -1.0) * texelSize).rgb, luma);
+    float lumaSW = dot(texture2D(source, texCoord + vec2(-1.0, 1.0) * texelSize).rgb, luma);
+    float lumaSE = dot(texture2D(source, texCoord + vec2(1.0, 1.0) * texelSize).rgb, luma);
+    vec4 colorM = texture2D(source, texCoord);
+    float lumaM = dot(colorM.rgb, luma);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Blur along the edge, by an amount that depends on its contrast.
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float inverseDirectionMin = 1.0 / (min(abs(direction.x), abs(direction.y)) + directionReduce);
+    direction = clamp(direction * inverseDirectionMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texelSize;
+
+    vec3 colorA = 0.5 * (texture2D(source, texCoord + direction * (1.0 / 3.0 - 0.5)).rgb +
+                         texture2D(source, texCoord + direction * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 colorB = colorA * 0.5 + 0.25 * (texture2D(source, texCoord - direction * 0.5).rgb +
+                                         texture2D(source, texCoord + direction * 0.5).rgb);
+    float lumaB = dot(colorB, luma);
+    if (lumaB < lumaMin || lumaB > lumaMax)
+        return vec4(colorA, colorM.a);
+    return vec4(colorB, colorM.a);
+}
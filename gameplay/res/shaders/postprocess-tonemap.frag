@@ -0,0 +1,12 @@
+///////////////////////////////////////////////////////////
+// Post-processing color pass that applies exposure and the Reinhard tone mapping operator.
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform float u_exposure;
+
+vec4 processColor(vec4 color)
+{
+    vec3 exposed = color.rgb * u_exposure;
+    return vec4(exposed / (vec3(1.0) + exposed), color.a);
+}
@@ -0,0 +1,9 @@
+uniform samplerCube u_reflectionTexture;
+uniform float u_reflectivity;
+
+varying vec3 v_reflectionDirection;
+
+vec3 applyReflection(vec3 color)
+{
+    return mix(color, textureCube(u_reflectionTexture, v_reflectionDirection).rgb, u_reflectivity);
+}
@@ -0,0 +1,22 @@
+#if !defined(SHADOWS)
+#if defined(INSTANCED)
+#define u_worldMatrix a_instanceMatrix
+#else
+uniform mat4 u_worldMatrix;
+#endif
+#endif
+
+#if !defined(SPECULAR)
+uniform vec3 u_cameraPosition;
+#endif
+
+varying vec3 v_reflectionDirection;
+
+void applyReflection(vec4 position, vec3 normal)
+{
+    // The cube map of the probe is looked up in world space. The normal
+    // assumes the world matrix contains only uniform scaling.
+    vec3 positionWorld = (u_worldMatrix * position).xyz;
+    vec3 normalWorld = normalize(mat3(u_worldMatrix[0].xyz, u_worldMatrix[1].xyz, u_worldMatrix[2].xyz) * normal);
+    v_reflectionDirection = reflect(positionWorld - u_cameraPosition, normalWorld);
+}
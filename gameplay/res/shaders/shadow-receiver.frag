@@ -0,0 +1,59 @@
+#if defined(SHADOW_CASCADE_COUNT)
+uniform mat4 u_shadowMatrix[SHADOW_CASCADE_COUNT];
+uniform vec4 u_shadowCascadeFar;
+uniform sampler2D u_shadowTexture;
+uniform vec2 u_shadowTexelSize;
+#endif
+
+#if defined(SPOT_SHADOW)
+uniform mat4 u_spotShadowMatrix;
+uniform sampler2D u_spotShadowTexture;
+uniform vec2 u_spotShadowTexelSize;
+#endif
+
+varying vec3 v_shadowPosition;
+varying float v_shadowDepth;
+
+// Must match the depth packing of the ShadowMap caster effect.
+float unpackShadowDepth(vec4 color)
+{
+    return dot(color, vec4(1.0, 1.0 / 255.0, 1.0 / 65025.0, 1.0 / 16581375.0));
+}
+
+float sampleShadow(sampler2D shadowTexture, vec2 texelSize, vec3 coord)
+{
+    // Percentage closer filtering of four taps around the pixel.
+    float lit = step(coord.z, unpackShadowDepth(texture2D(shadowTexture, coord.xy + vec2(-0.5, -0.5) * texelSize)));
+    lit += step(coord.z, unpackShadowDepth(texture2D(shadowTexture, coord.xy + vec2(0.5, -0.5) * texelSize)));
+    lit += step(coord.z, unpackShadowDepth(texture2D(shadowTexture, coord.xy + vec2(-0.5, 0.5) * texelSize)));
+    lit += step(coord.z, unpackShadowDepth(texture2D(shadowTexture, coord.xy + vec2(0.5, 0.5) * texelSize)));
+    return lit * 0.25;
+}
+
+#if defined(SHADOW_CASCADE_COUNT)
+float getDirectionalShadow()
+{
+    vec4 position = vec4(v_shadowPosition, 1.0);
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+    {
+        if (v_shadowDepth < u_shadowCascadeFar[i])
+        {
+            vec4 coord = u_shadowMatrix[i] * position;
+            return sampleShadow(u_shadowTexture, u_shadowTexelSize, coord.xyz);
+        }
+    }
+
+    // Beyond the shadow distance.
+    return 1.0;
+}
+#endif
+
+#if defined(SPOT_SHADOW)
+float getSpotShadow()
+{
+    vec4 coord = u_spotShadowMatrix * vec4(v_shadowPosition, 1.0);
+    if (coord.w <= 0.0)
+        return 1.0;
+    return sampleShadow(u_spotShadowTexture, u_spotShadowTexelSize, coord.xyz / coord.w);
+}
+#endif
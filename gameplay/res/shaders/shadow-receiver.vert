@@ -0,0 +1,16 @@
+#if defined(INSTANCED)
+#define u_worldMatrix a_instanceMatrix
+#else
+uniform mat4 u_worldMatrix;
+#endif
+
+varying vec3 v_shadowPosition;
+varying float v_shadowDepth;
+
+void applyShadow(vec4 position)
+{
+    // The shadow maps are looked up from the world-space position, and the
+    // cascade is chosen from the view-space distance.
+    v_shadowPosition = (u_worldMatrix * position).xyz;
+    v_shadowDepth = -(u_worldViewMatrix * position).z;
+}
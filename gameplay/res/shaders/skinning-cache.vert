@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////
+// Vertex shader that skins the vertices of a mesh for transform feedback to capture,
+// so that every pass drawing the skinned mesh reads them instead of skinning them again.
+// The elements that are not skinned are copied, and each one is declared by a define
+// naming its type, such as TEXCOORD0_TYPE vec2.
+
+///////////////////////////////////////////////////////////
+// Attributes
+attribute vec4 a_position;
+attribute vec4 a_blendWeights;
+attribute vec4 a_blendIndices;
+
+#if defined(LIGHTING)
+attribute vec3 a_normal;
+#if defined(BUMPED)
+attribute vec3 a_tangent;
+attribute vec3 a_binormal;
+#endif
+#endif
+
+#if defined(COLOR_TYPE)
+attribute COLOR_TYPE a_color;
+#endif
+#if defined(TEXCOORD0_TYPE)
+attribute TEXCOORD0_TYPE a_texCoord0;
+#endif
+#if defined(TEXCOORD1_TYPE)
+attribute TEXCOORD1_TYPE a_texCoord1;
+#endif
+#if defined(TEXCOORD2_TYPE)
+attribute TEXCOORD2_TYPE a_texCoord2;
+#endif
+#if defined(TEXCOORD3_TYPE)
+attribute TEXCOORD3_TYPE a_texCoord3;
+#endif
+#if defined(TEXCOORD4_TYPE)
+attribute TEXCOORD4_TYPE a_texCoord4;
+#endif
+#if defined(TEXCOORD5_TYPE)
+attribute TEXCOORD5_TYPE a_texCoord5;
+#endif
+#if defined(TEXCOORD6_TYPE)
+attribute TEXCOORD6_TYPE a_texCoord6;
+#endif
+#if defined(TEXCOORD7_TYPE)
+attribute TEXCOORD7_TYPE a_texCoord7;
+#endif
+
+///////////////////////////////////////////////////////////
+// Uniforms
+#if defined(SKINNING_PALETTE_TEXTURE)
+uniform sampler2D u_matrixPaletteTexture;
+uniform vec2 u_matrixPaletteTexelSize;
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];
+#else
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
+#endif
+
+///////////////////////////////////////////////////////////
+// Variables
+#include "skinning.vert"
+
+///////////////////////////////////////////////////////////
+// Varyings, captured in the order of the vertex elements
+varying vec3 o_position;
+
+#if defined(LIGHTING)
+varying vec3 o_normal;
+#if defined(BUMPED)
+varying vec3 o_tangent;
+varying vec3 o_binormal;
+#endif
+#endif
+
+#if defined(COLOR_TYPE)
+varying COLOR_TYPE o_color;
+#endif
+#if defined(TEXCOORD0_TYPE)
+varying TEXCOORD0_TYPE o_texCoord0;
+#endif
+#if defined(TEXCOORD1_TYPE)
+varying TEXCOORD1_TYPE o_texCoord1;
+#endif
+#if defined(TEXCOORD2_TYPE)
+varying TEXCOORD2_TYPE o_texCoord2;
+#endif
+#if defined(TEXCOORD3_TYPE)
+varying TEXCOORD3_TYPE o_texCoord3;
+#endif
+#if defined(TEXCOORD4_TYPE)
+varying TEXCOORD4_TYPE o_texCoord4;
+#endif
+#if defined(TEXCOORD5_TYPE)
+varying TEXCOORD5_TYPE o_texCoord5;
+#endif
+#if defined(TEXCOORD6_TYPE)
+varying TEXCOORD6_TYPE o_texCoord6;
+#endif
+#if defined(TEXCOORD7_TYPE)
+varying TEXCOORD7_TYPE o_texCoord7;
+#endif
+
+void main()
+{
+    vec4 position = getPosition();
+    o_position = position.xyz / position.w;
+
+    #if defined(LIGHTING)
+    o_normal = getNormal();
+    #if defined(BUMPED)
+    o_tangent = getTangent();
+    o_binormal = getBinormal();
+    #endif
+    #endif
+
+    #if defined(COLOR_TYPE)
+    o_color = a_color;
+    #endif
+    #if defined(TEXCOORD0_TYPE)
+    o_texCoord0 = a_texCoord0;
+    #endif
+    #if defined(TEXCOORD1_TYPE)
+    o_texCoord1 = a_texCoord1;
+    #endif
+    #if defined(TEXCOORD2_TYPE)
+    o_texCoord2 = a_texCoord2;
+    #endif
+    #if defined(TEXCOORD3_TYPE)
+    o_texCoord3 = a_texCoord3;
+    #endif
+    #if defined(TEXCOORD4_TYPE)
+    o_texCoord4 = a_texCoord4;
+    #endif
+    #if defined(TEXCOORD5_TYPE)
+    o_texCoord5 = a_texCoord5;
+    #endif
+    #if defined(TEXCOORD6_TYPE)
+    o_texCoord6 = a_texCoord6;
+    #endif
+    #if defined(TEXCOORD7_TYPE)
+    o_texCoord7 = a_texCoord7;
+    #endif
+
+    // Nothing is rasterized while the vertices are captured.
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
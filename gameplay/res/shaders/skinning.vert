@@ -1,12 +1,90 @@
 
+#if defined(SKINNING_PALETTE_TEXTURE)
+
+// The palette rows are stored left to right, top to bottom in a floating point texture.
+vec4 getPaletteRow(int index)
+{
+    float i = float(index);
+    float width = 1.0 / u_matrixPaletteTexelSize.x;
+    float y = floor((i + 0.5) * u_matrixPaletteTexelSize.x);
+    float x = i - y * width;
+    return texture2DLod(u_matrixPaletteTexture, (vec2(x, y) + 0.5) * u_matrixPaletteTexelSize, 0.0);
+}
+
+#else
+
+vec4 getPaletteRow(int index)
+{
+    return u_matrixPalette[index];
+}
+
+#endif
+
+#if defined(SKINNING_DUAL_QUATERNION)
+
+// Each joint is a unit dual quaternion stored in 2 rows: the rotation (real part) and the translation (dual part).
+vec4 _skinnedReal;
+vec4 _skinnedDual;
+
+void skinDualQuaternion(float blendWeight, int jointIndex, vec4 firstReal)
+{
+    vec4 real = getPaletteRow(jointIndex * 2);
+    vec4 dual = getPaletteRow(jointIndex * 2 + 1);
+
+    // Blend along the shortest path from the first joint's rotation.
+    if (dot(real, firstReal) < 0.0)
+        blendWeight = -blendWeight;
+    _skinnedReal += blendWeight * real;
+    _skinnedDual += blendWeight * dual;
+}
+
+void blendDualQuaternions()
+{
+    vec4 firstReal = getPaletteRow(int(a_blendIndices[0]) * 2);
+    _skinnedReal = vec4(0.0);
+    _skinnedDual = vec4(0.0);
+    skinDualQuaternion(a_blendWeights[0], int(a_blendIndices[0]), firstReal);
+    skinDualQuaternion(a_blendWeights[1], int(a_blendIndices[1]), firstReal);
+    skinDualQuaternion(a_blendWeights[2], int(a_blendIndices[2]), firstReal);
+    skinDualQuaternion(a_blendWeights[3], int(a_blendIndices[3]), firstReal);
+
+    float norm = length(_skinnedReal);
+    _skinnedReal /= norm;
+    _skinnedDual /= norm;
+}
+
+vec3 rotateVector(vec3 vector)
+{
+    return vector + 2.0 * cross(_skinnedReal.xyz, cross(_skinnedReal.xyz, vector) + _skinnedReal.w * vector);
+}
+
+vec4 getPosition()
+{
+    blendDualQuaternions();
+    vec3 translation = 2.0 * (_skinnedReal.w * _skinnedDual.xyz - _skinnedDual.w * _skinnedReal.xyz + cross(_skinnedReal.xyz, _skinnedDual.xyz));
+    return vec4(rotateVector(a_position.xyz) + translation * a_position.w, a_position.w);
+}
+
+#if defined(LIGHTING)
+
+vec3 getTangentSpaceVector(vec3 vector)
+{
+    // The blended rotation is left over from getPosition().
+    return rotateVector(vector);
+}
+
+#endif
+
+#else
+
 vec4 _skinnedPosition;
 
 void skinPosition(float blendWeight, int matrixIndex)
 {
     vec4 tmp;
-    tmp.x = dot(a_position, u_matrixPalette[matrixIndex]);
-    tmp.y = dot(a_position, u_matrixPalette[matrixIndex + 1]);
-    tmp.z = dot(a_position, u_matrixPalette[matrixIndex + 2]);
+    tmp.x = dot(a_position, getPaletteRow(matrixIndex));
+    tmp.y = dot(a_position, getPaletteRow(matrixIndex + 1));
+    tmp.z = dot(a_position, getPaletteRow(matrixIndex + 2));
     tmp.w = a_position.w;
     _skinnedPosition += blendWeight * tmp;
 }
@@ -26,7 +104,7 @@ vec4 getPosition()
     blendWeight = a_blendWeights[3];
     matrixIndex = int(a_blendIndices[3]) * 3;
     skinPosition(blendWeight, matrixIndex);
-    return _skinnedPosition;    
+    return _skinnedPosition;
 }
 
 #if defined(LIGHTING)
@@ -36,9 +114,9 @@ vec3 _skinnedNormal;
 void skinTangentSpaceVector(vec3 vector, float blendWeight, int matrixIndex)
 {
     vec3 tmp;
-    tmp.x = dot(vector, u_matrixPalette[matrixIndex].xyz);
-    tmp.y = dot(vector, u_matrixPalette[matrixIndex + 1].xyz);
-    tmp.z = dot(vector, u_matrixPalette[matrixIndex + 2].xyz);
+    tmp.x = dot(vector, getPaletteRow(matrixIndex).xyz);
+    tmp.y = dot(vector, getPaletteRow(matrixIndex + 1).xyz);
+    tmp.z = dot(vector, getPaletteRow(matrixIndex + 2).xyz);
     _skinnedNormal += blendWeight * tmp;
 }
 
@@ -61,6 +139,12 @@ vec3 getTangentSpaceVector(vec3 vector)
     return _skinnedNormal;
 }
 
+#endif
+
+#endif
+
+#if defined(LIGHTING)
+
 vec3 getNormal()
 {
     return getTangentSpaceVector(a_normal);
@@ -81,4 +165,3 @@ vec3 getBinormal()
 #endif
 
 #endif
-
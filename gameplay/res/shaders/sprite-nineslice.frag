@@ -0,0 +1,35 @@
+#ifdef OPENGL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform sampler2D u_texture;
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec4 v_color;
+varying vec4 v_edges;       // distances to the left, top, right and bottom edges of the sprite
+varying vec4 v_border;      // widths of the left, top, right and bottom borders of the sprite
+varying vec4 v_uvs;         // texture coordinates of the outer edges of the source
+varying vec4 v_innerUVs;    // texture coordinates of the inner edges of the source borders
+
+
+void main()
+{
+    // Map the position in each slice to the texture coordinates of the same slice in the source.
+    vec2 size = v_edges.xy + v_edges.zw;
+    vec2 first = mix(v_uvs.xy, v_innerUVs.xy, v_edges.xy / max(v_border.xy, 0.0001));
+    vec2 last = mix(v_uvs.zw, v_innerUVs.zw, v_edges.zw / max(v_border.zw, 0.0001));
+    vec2 middle = mix(v_innerUVs.xy, v_innerUVs.zw, (v_edges.xy - v_border.xy) / max(size - v_border.xy - v_border.zw, 0.0001));
+
+    vec2 inFirst = 1.0 - step(v_border.xy, v_edges.xy);
+    vec2 inLast = (1.0 - inFirst) * (1.0 - step(v_border.zw, v_edges.zw));
+    vec2 texCoord = mix(mix(middle, first, inFirst), last, inLast);
+
+    gl_FragColor = v_color * texture2D(u_texture, texCoord);
+}
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////
+// Attributes
+attribute vec3 a_position;
+attribute vec4 a_color;
+attribute vec4 a_texCoord;
+attribute vec4 a_texCoord1;
+attribute vec4 a_texCoord2;
+attribute vec4 a_texCoord3;
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform mat4 u_projectionMatrix;
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec4 v_color;
+varying vec4 v_edges;
+varying vec4 v_border;
+varying vec4 v_uvs;
+varying vec4 v_innerUVs;
+
+
+void main()
+{
+    gl_Position = u_projectionMatrix * vec4(a_position, 1);
+    v_color = a_color;
+    v_edges = a_texCoord;
+    v_border = a_texCoord1;
+    v_uvs = a_texCoord2;
+    v_innerUVs = a_texCoord3;
+}
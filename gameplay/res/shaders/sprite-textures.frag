@@ -0,0 +1,56 @@
+#ifdef OPENGL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform sampler2D u_textures[TEXTURE_COUNT];
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+varying float v_texture;
+
+
+void main()
+{
+    // GLSL ES 1.0 only indexes sampler arrays with constants, so select the sampler of the sprite by branching.
+    vec4 color;
+    if (v_texture < 0.5)
+        color = texture2D(u_textures[0], v_texCoord);
+    #if TEXTURE_COUNT > 1
+    else if (v_texture < 1.5)
+        color = texture2D(u_textures[1], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 2
+    else if (v_texture < 2.5)
+        color = texture2D(u_textures[2], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 3
+    else if (v_texture < 3.5)
+        color = texture2D(u_textures[3], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 4
+    else if (v_texture < 4.5)
+        color = texture2D(u_textures[4], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 5
+    else if (v_texture < 5.5)
+        color = texture2D(u_textures[5], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 6
+    else if (v_texture < 6.5)
+        color = texture2D(u_textures[6], v_texCoord);
+    #endif
+    #if TEXTURE_COUNT > 7
+    else if (v_texture < 7.5)
+        color = texture2D(u_textures[7], v_texCoord);
+    #endif
+
+    gl_FragColor = v_color * color;
+}
@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////////////
+// Attributes
+attribute vec3 a_position;
+attribute vec2 a_texCoord;
+attribute vec4 a_color;
+attribute float a_texCoord1;
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform mat4 u_projectionMatrix;
+
+///////////////////////////////////////////////////////////
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+varying float v_texture;
+
+
+void main()
+{
+    gl_Position = u_projectionMatrix * vec4(a_position, 1);
+    v_texCoord = a_texCoord;
+    v_color = a_color;
+    v_texture = a_texCoord1;
+}
@@ -18,6 +18,9 @@ precision mediump float;
 #if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
 #define LIGHTING
 #endif
+#if defined(COMPOSITE_BAKE)
+#undef LIGHTING
+#endif
 
 ///////////////////////////////////////////////////////////
 // Uniforms
@@ -60,6 +63,10 @@ uniform float u_column;
 uniform sampler2D u_surfaceLayerMaps[SAMPLER_COUNT];
 #endif
 
+#if defined(COMPOSITE)
+uniform sampler2D u_compositeMap;
+#endif
+
 ///////////////////////////////////////////////////////////
 // Variables
 vec4 _baseColor;
@@ -100,7 +107,11 @@ void blendLayer(sampler2D textureMap, vec2 texCoord, float alphaBlend)
 
 void main()
 {
-    #if (LAYER_COUNT > 0)
+    #if defined(COMPOSITE)
+    // Distant patches sample the layers baked into the composite texture
+    _baseColor.rgb = texture2D(u_compositeMap, v_texCoord0).rgb;
+    _baseColor.a = 1.0;
+    #elif (LAYER_COUNT > 0)
     // Sample base texture
 	_baseColor.rgb = texture2D(u_surfaceLayerMaps[TEXTURE_INDEX_0], mod(v_texCoordLayer0, vec2(1,1))).rgb;
     _baseColor.a = 1.0;
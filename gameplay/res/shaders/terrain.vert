@@ -10,6 +10,9 @@
 #if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
 #define LIGHTING
 #endif
+#if defined(COMPOSITE_BAKE)
+#undef LIGHTING
+#endif
 
 ///////////////////////////////////////////////////////////
 // Attributes
@@ -18,6 +21,9 @@ attribute vec4 a_position;
 attribute vec3 a_normal;
 #endif
 attribute vec2 a_texCoord0;
+#if defined(MORPHING)
+attribute vec2 a_texCoord1;
+#endif
 
 ///////////////////////////////////////////////////////////
 // Uniforms
@@ -25,15 +31,17 @@ uniform mat4 u_worldViewProjectionMatrix;
 #if !defined(NORMAL_MAP) && defined(LIGHTING)
 uniform mat4 u_normalMatrix;
 #endif
+#if defined(MORPHING)
+uniform vec3 u_morph;
+#endif
+#if defined(MORPHING) || (defined(LIGHTING) && ((POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)))
+uniform mat4 u_worldViewMatrix;
+#endif
 
 #if defined(LIGHTING)
 
 uniform mat4 u_inverseTransposeWorldViewMatrix;
 
-#if (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
-uniform mat4 u_worldViewMatrix;
-#endif
-
 #if (DIRECTIONAL_LIGHT_COUNT > 0)
 uniform vec3 u_directionalLightDirection[DIRECTIONAL_LIGHT_COUNT];
 #endif
@@ -85,8 +93,23 @@ varying vec2 v_texCoordLayer2;
 
 void main()
 {
+    vec4 position = a_position;
+
+    #if defined(MORPHING)
+    // Morph vertices of this level toward the next level's height as they get further from the camera.
+    // u_morph holds the level, the distance morphing starts at and the inverse of the morph distance.
+    float morph = clamp((length((u_worldViewMatrix * a_position).xyz) - u_morph.y) * u_morph.z, 0.0, 1.0);
+    morph *= step(abs(a_texCoord1.y - u_morph.x), 0.5);
+    position.y = mix(position.y, a_texCoord1.x, morph);
+    #endif
+
+    #if defined(COMPOSITE_BAKE)
+    // Draw over the region of the composite texture that the patch covers.
+    gl_Position = vec4(a_texCoord0 * 2.0 - 1.0, 0.0, 1.0);
+    #else
     // Transform position to clip space.
-    gl_Position = u_worldViewProjectionMatrix * a_position;
+    gl_Position = u_worldViewProjectionMatrix * position;
+    #endif
 
     #if defined(LIGHTING)
 
@@ -94,7 +117,7 @@ void main()
     v_normalVector = normalize((u_normalMatrix * vec4(a_normal.x, a_normal.y, a_normal.z, 0)).xyz);
     #endif
 
-    applyLight(a_position);
+    applyLight(position);
 
     #endif
 
@@ -15,9 +15,15 @@ precision mediump float;
 #ifndef POINT_LIGHT_COUNT
 #define POINT_LIGHT_COUNT 0
 #endif
-#if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
+#if (DIRECTIONAL_LIGHT_COUNT > 0) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(CLUSTERED_LIGHTING)
 #define LIGHTING
 #endif
+#if defined(LIGHTING) && (defined(SHADOW_CASCADE_COUNT) || defined(SPOT_SHADOW))
+#define SHADOWS
+#endif
+#if defined(LIGHTING) && defined(REFLECTION_PROBE)
+#define REFLECTIONS
+#endif
 
 ///////////////////////////////////////////////////////////
 // Uniforms
@@ -62,6 +68,15 @@ uniform vec3 u_spotLightDirection[SPOT_LIGHT_COUNT];
 uniform float u_specularExponent;
 #endif
 
+#if defined(CLUSTERED_LIGHTING)
+uniform sampler2D u_lightClusterTexture;
+uniform vec2 u_lightClusterTexelSize;
+uniform vec3 u_lightClusterGrid;
+uniform vec3 u_lightClusterLayout;
+uniform vec2 u_lightClusterDepth;
+uniform vec4 u_lightClusterViewport;
+#endif
+
 #endif
 
 #if defined(MODULATE_COLOR)
@@ -109,6 +124,18 @@ varying vec3 v_spotLightDirection[SPOT_LIGHT_COUNT];
 varying vec3 v_cameraDirection; 
 #endif
 
+#if defined(CLUSTERED_LIGHTING)
+varying vec3 v_positionViewSpace;
+#endif
+
+#if defined(SHADOWS)
+#include "shadow-receiver.frag"
+#endif
+
+#if defined(REFLECTIONS)
+#include "reflection-probe.frag"
+#endif
+
 #include "lighting.frag"
 
 #endif
@@ -128,6 +155,9 @@ void main()
     #if defined(LIGHTING)
 
     gl_FragColor.rgb = getLitPixel();
+    #if defined(REFLECTIONS)
+    gl_FragColor.rgb = applyReflection(gl_FragColor.rgb);
+    #endif
     #else
     gl_FragColor.rgb = _baseColor.rgb;
     #endif
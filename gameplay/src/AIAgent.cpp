@@ -2,15 +2,27 @@
 #include "AIAgent.h"
 #include "Node.h"
 
+// The script events of agents.
+#define AIAGENT_EVENT_MESSAGE 0
+#define AIAGENT_EVENT_PATH 1
+
 namespace gameplay
 {
 
+static const ScriptTarget::Event __agentEvents[] =
+{
+    { "message", "<AIMessage>" },
+    { "path", "b" }
+};
+
 AIAgent::AIAgent()
-    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _next(NULL)
+    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _next(NULL),
+    _updateInterval(0.0f), _elapsedTime(0.0f), _urgency(0.0f), _pathNavMesh(NULL), _pathRequestId(0),
+    _pathRequested(false), _pathPending(false)
 {
     _stateMachine = new AIStateMachine(this);
 
-    addScriptEvent("message", "<AIMessage>");
+    setScriptEvents(__agentEvents, 2);
 }
 
 AIAgent::~AIAgent()
@@ -56,6 +68,55 @@ void AIAgent::setListener(Listener* listener)
     _listener = listener;
 }
 
+float AIAgent::getUpdateInterval() const
+{
+    return _updateInterval;
+}
+
+void AIAgent::setUpdateInterval(float interval)
+{
+    _updateInterval = std::max(interval, 0.0f);
+}
+
+void AIAgent::findPath(NavMesh* navMesh, const Vector3& destination)
+{
+    findPath(navMesh, _node ? _node->getTranslationWorld() : Vector3::zero(), destination);
+}
+
+void AIAgent::findPath(NavMesh* navMesh, const Vector3& start, const Vector3& end)
+{
+    GP_ASSERT(navMesh);
+
+    // The request is picked up by the AIController on the game thread.
+    _pathNavMesh = navMesh;
+    _pathStart = start;
+    _pathEnd = end;
+    ++_pathRequestId;
+    _pathRequested = true;
+    _pathPending = true;
+}
+
+bool AIAgent::isPathPending() const
+{
+    return _pathPending;
+}
+
+const std::vector<Vector3>& AIAgent::getPath() const
+{
+    return _path;
+}
+
+void AIAgent::completePath(std::vector<Vector3>* path, bool found)
+{
+    _path.swap(*path);
+    _pathPending = false;
+
+    if (_listener)
+        _listener->pathCompleted(found);
+
+    fireScriptEvent<void>(AIAGENT_EVENT_PATH, found);
+}
+
 void AIAgent::update(float elapsedTime)
 {
     _stateMachine->update(elapsedTime);
@@ -68,14 +129,10 @@ bool AIAgent::processMessage(AIMessage* message)
     {
     case AIMessage::MESSAGE_TYPE_STATE_CHANGE:
         {
-            // Change state message
-            const char* stateId = message->getString(0);
-            if (stateId)
-            {
-                AIState* state = _stateMachine->getState(stateId);
-                if (state)
-                    _stateMachine->setStateInternal(state);
-            }
+            // Change state message, which holds the key of the new state.
+            AIState* state = _stateMachine->getState((unsigned int)message->getInt(0));
+            if (state)
+                _stateMachine->setStateInternal(state);
         }
         break;
     }
@@ -84,7 +141,7 @@ bool AIAgent::processMessage(AIMessage* message)
     if (_listener && _listener->messageReceived(message))
         return true;
     
-    if (fireScriptEvent<bool>("message", message))
+    if (fireScriptEvent<bool>(AIAGENT_EVENT_MESSAGE, message))
         return true;
     
     return false;
@@ -5,6 +5,7 @@
 #include "AIStateMachine.h"
 #include "AIMessage.h"
 #include "ScriptTarget.h"
+#include "NavMesh.h"
 
 namespace gameplay
 {
@@ -53,6 +54,15 @@ public:
          * @return true to mark the message as handled, false otherwise.
          */
         virtual bool messageReceived(AIMessage* message) = 0;
+
+        /**
+         * Called when a path requested with AIAgent::findPath() has been processed.
+         *
+         * The points of the path are returned by AIAgent::getPath().
+         *
+         * @param found true if a path was found, false otherwise.
+         */
+        virtual void pathCompleted(bool found) { };
     };
 
     /**
@@ -111,6 +121,73 @@ public:
      */
     void setEnabled(bool enabled);
 
+    /**
+     * Returns the interval between updates of this AIAgent's state machine.
+     *
+     * @return The update interval, in milliseconds.
+     */
+    float getUpdateInterval() const;
+
+    /**
+     * Sets the interval between updates of this AIAgent's state machine.
+     *
+     * Agents that do not need to think every frame can be updated less often, which lets the
+     * AIController spread the cost of many agents across frames. The state machine receives
+     * the total time elapsed since its previous update. The default interval is zero, which
+     * updates the agent every frame (within the AIController's update budget).
+     *
+     * @param interval The update interval, in milliseconds.
+     */
+    void setUpdateInterval(float interval);
+
+    /**
+     * Requests a path on a navigation mesh from the agent's node to the specified point.
+     *
+     * @param navMesh The navigation mesh to find the path on.
+     * @param destination The end point of the path.
+     *
+     * @see findPath(NavMesh*, const Vector3&, const Vector3&)
+     * @script{ignore}
+     */
+    void findPath(NavMesh* navMesh, const Vector3& destination);
+
+    /**
+     * Requests a path on a navigation mesh between the specified points.
+     *
+     * The path is found asynchronously by the AIController, which processes the requests of
+     * all agents in batches on worker threads within its path budget, so this method returns
+     * immediately. Once the path has been processed, the pathCompleted() method of the listener
+     * and the 'path' script event are called on the game thread, and the path is returned by
+     * getPath(). A new request replaces any pending request of this agent.
+     *
+     * This method can be called from a state update running in parallel. The navigation mesh
+     * must stay alive until the next update of the AIController, which then retains it until
+     * the path is processed.
+     *
+     * @param navMesh The navigation mesh to find the path on.
+     * @param start The start point of the path.
+     * @param end The end point of the path.
+     * @script{ignore}
+     */
+    void findPath(NavMesh* navMesh, const Vector3& start, const Vector3& end);
+
+    /**
+     * Determines if a path requested with findPath() has not been processed yet.
+     *
+     * @return true if a path request is pending, false otherwise.
+     */
+    bool isPathPending() const;
+
+    /**
+     * Returns the last path found for this agent.
+     *
+     * The path is empty if no path was found by the last processed request.
+     *
+     * @return The points of the path, from the start point to the end point.
+     * @script{ignore}
+     */
+    const std::vector<Vector3>& getPath() const;
+
     /**
      * Sets an event listener for this AIAgent.
      *
@@ -156,11 +233,29 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Called by the AIController when a path request of the AIAgent has been processed.
+     *
+     * @param path The points of the path, swapped into the agent's path.
+     * @param found true if a path was found, false otherwise.
+     */
+    void completePath(std::vector<Vector3>* path, bool found);
+
     AIStateMachine* _stateMachine;
     Node* _node;
     bool _enabled;
     Listener* _listener;
     AIAgent* _next;
+    float _updateInterval;
+    float _elapsedTime;
+    float _urgency;
+    NavMesh* _pathNavMesh;
+    Vector3 _pathStart;
+    Vector3 _pathEnd;
+    unsigned int _pathRequestId;
+    bool _pathRequested;
+    bool _pathPending;
+    std::vector<Vector3> _path;
 
 };
 
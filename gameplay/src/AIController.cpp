@@ -1,12 +1,20 @@
 #include "Base.h"
 #include "AIController.h"
 #include "Game.h"
+#include "Scene.h"
+
+// Number of agents per thread updated in each parallel batch when there is an update budget.
+#define PARALLEL_BATCH_SIZE 8
+
+// Number of path requests per thread processed in each batch.
+#define PATH_BATCH_SIZE 4
 
 namespace gameplay
 {
 
 AIController::AIController()
-    : _paused(false), _firstMessage(NULL), _firstAgent(NULL)
+    : _paused(false), _firstAgent(NULL), _updateBudget(0.0f), _parallel(false), _updatingInParallel(false),
+    _pathBudget(2.0f)
 {
 }
 
@@ -30,15 +38,29 @@ void AIController::finalize()
     }
     _firstAgent = NULL;
 
+    // Remove all path requests
+    for (std::list<PathRequest*>::iterator itr = _pathRequests.begin(); itr != _pathRequests.end(); ++itr)
+    {
+        SAFE_RELEASE((*itr)->navMesh);
+        SAFE_DELETE(*itr);
+    }
+    _pathRequests.clear();
+
     // Remove all messages
-    AIMessage* message = _firstMessage;
-    while (message)
+    for (size_t i = 0, count = _messages.size(); i < count; ++i)
     {
-        AIMessage* temp = message;
-        message = message->_next;
-        AIMessage::destroy(temp);
+        AIMessage::destroy(_messages[i]);
+    }
+    _messages.clear();
+    {
+        Mutex::Lock lock(_postMutex);
+        for (size_t i = 0, count = _postedMessages.size(); i < count; ++i)
+        {
+            AIMessage::destroy(_postedMessages[i]);
+        }
+        _postedMessages.clear();
     }
-    _firstMessage = NULL;
+    AIMessage::clearPool();
 }
 
 void AIController::pause()
@@ -53,6 +75,14 @@ void AIController::resume()
 
 void AIController::sendMessage(AIMessage* message, float delay)
 {
+    // Agents updating on worker threads cannot change states directly, so their messages
+    // are delivered in the merge step on the game thread.
+    if (_updatingInParallel)
+    {
+        postMessage(message, delay);
+        return;
+    }
+
     if (delay <= 0)
     {
         // Send instantly
@@ -86,13 +116,23 @@ void AIController::sendMessage(AIMessage* message, float delay)
     }
     else
     {
-        // Queue for later delivery
-        if (_firstMessage)
-            message->_next = _firstMessage;
-        _firstMessage = message;
+        // Queue for later delivery, ordered by delivery time
+        message->_deliveryTime = Game::getGameTime() + delay;
+        _messages.push_back(message);
+        std::push_heap(_messages.begin(), _messages.end(), compareMessages);
     }
 }
 
+void AIController::postMessage(AIMessage* message, float delay)
+{
+    GP_ASSERT(message);
+
+    // The delay is kept in the delivery time until the message is received on the game thread.
+    Mutex::Lock lock(_postMutex);
+    message->_deliveryTime = delay;
+    _postedMessages.push_back(message);
+}
+
 void AIController::update(float elapsedTime)
 {
     if (_paused)
@@ -100,39 +140,269 @@ void AIController::update(float elapsedTime)
 
     static Game* game = Game::getInstance();
 
-    // Send all pending messages that have expired
-    AIMessage* prevMsg = NULL;
-    AIMessage* msg = _firstMessage;
-    while (msg)
+    receivePostedMessages();
+
+    // Send all pending messages that have expired (this also deletes them)
+    double gameTime = game->getGameTime();
+    while (!_messages.empty() && _messages.front()->getDeliveryTime() <= gameTime)
+    {
+        std::pop_heap(_messages.begin(), _messages.end(), compareMessages);
+        AIMessage* message = _messages.back();
+        _messages.pop_back();
+        sendMessage(message);
+    }
+
+    // Find the enabled agents whose update interval has passed.
+    _dueAgents.clear();
+    AIAgent* agent = _firstAgent;
+    while (agent)
     {
-        // If the message delivery time has expired, send it (this also deletes it)
-        if (msg->getDeliveryTime() >= game->getGameTime())
+        if (agent->isEnabled())
         {
-            // Link the message out of our list
-            if (prevMsg)
-                prevMsg->_next = msg->_next;
-
-            AIMessage* temp = msg;
-            msg = msg->_next;
-            temp->_next = NULL;
-            sendMessage(temp);
+            agent->_elapsedTime += elapsedTime;
+            if (agent->_elapsedTime >= agent->_updateInterval)
+            {
+                _dueAgents.push_back(agent);
+            }
+        }
+
+        agent = agent->_next;
+    }
+
+    // With a budget, update the most urgent agents first: the longer an agent has waited
+    // and the closer it is to the camera, the sooner it is updated.
+    if (_updateBudget > 0.0f && _dueAgents.size() > 1)
+    {
+        for (size_t i = 0, count = _dueAgents.size(); i < count; ++i)
+        {
+            agent = _dueAgents[i];
+            float distance = 0.0f;
+            Node* node = agent->getNode();
+            Scene* scene = node ? node->getScene() : NULL;
+            Camera* camera = scene ? scene->getActiveCamera() : NULL;
+            if (camera && camera->getNode())
+            {
+                distance = node->getTranslationWorld().distance(camera->getNode()->getTranslationWorld());
+            }
+            agent->_urgency = agent->_elapsedTime / (1.0f + distance);
+        }
+        std::sort(_dueAgents.begin(), _dueAgents.end(), compareAgents);
+    }
+
+    JobScheduler* scheduler = game->getJobScheduler();
+    unsigned int workerCount = scheduler ? scheduler->getWorkerCount() : 0;
+    bool parallel = _parallel && workerCount > 0;
+
+    // Without a budget all the due agents are updated at once. With a budget, agents are
+    // updated in batches and the budget is checked between batches.
+    size_t batchSize = 1;
+    if (parallel)
+        batchSize = _updateBudget > 0.0f ? (workerCount + 1) * PARALLEL_BATCH_SIZE : _dueAgents.size();
+
+    double start = Game::getAbsoluteTime();
+    for (size_t i = 0, count = _dueAgents.size(); i < count; i += batchSize)
+    {
+        if (i > 0 && _updateBudget > 0.0f && Game::getAbsoluteTime() - start >= _updateBudget)
+            break;
+
+        size_t end = std::min(i + batchSize, count);
+        if (parallel)
+        {
+            // Agents running script update callbacks must stay on the game thread.
+            _parallelAgents.clear();
+            _serialAgents.clear();
+            for (size_t j = i; j < end; ++j)
+            {
+                agent = _dueAgents[j];
+                AIState* state = agent->getStateMachine()->getActiveState();
+                if (state && state->hasScriptUpdate())
+                    _serialAgents.push_back(agent);
+                else
+                    _parallelAgents.push_back(agent);
+            }
+
+            if (!_parallelAgents.empty())
+            {
+                _updatingInParallel = true;
+                scheduler->parallelFor((unsigned int)_parallelAgents.size(), &AIController::updateAgents, &_parallelAgents);
+                _updatingInParallel = false;
+            }
+
+            // Merge step: deliver the messages and state changes from the parallel updates.
+            receivePostedMessages();
+
+            if (!_serialAgents.empty())
+            {
+                updateAgents(&_serialAgents, 0, (unsigned int)_serialAgents.size());
+            }
         }
         else
         {
-            prevMsg = msg;
-            msg = msg->_next;
+            updateAgents(&_dueAgents, (unsigned int)i, (unsigned int)end);
         }
     }
 
-    // Update all enabled agents
+    processPathRequests();
+}
+
+void AIController::processPathRequests()
+{
+    // Pick up the paths requested by agents since the previous update.
     AIAgent* agent = _firstAgent;
     while (agent)
     {
-        if (agent->isEnabled())
-            agent->update(elapsedTime);
+        if (agent->_pathRequested)
+        {
+            agent->_pathRequested = false;
+
+            PathRequest* request = new PathRequest();
+            request->agent = agent;
+            request->navMesh = agent->_pathNavMesh;
+            request->navMesh->addRef();
+            request->start = agent->_pathStart;
+            request->end = agent->_pathEnd;
+            request->id = agent->_pathRequestId;
+            request->found = false;
+            _pathRequests.push_back(request);
+        }
 
         agent = agent->_next;
     }
+
+    if (_pathRequests.empty())
+        return;
+
+    static Game* game = Game::getInstance();
+    JobScheduler* scheduler = game->getJobScheduler();
+    unsigned int workerCount = scheduler ? scheduler->getWorkerCount() : 0;
+    size_t batchSize = (workerCount + 1) * PATH_BATCH_SIZE;
+
+    // Process batches of requests until the budget is spent, and at least one batch per frame.
+    double start = Game::getAbsoluteTime();
+    bool processed = false;
+    while (!_pathRequests.empty())
+    {
+        if (processed && _pathBudget > 0.0f && Game::getAbsoluteTime() - start >= _pathBudget)
+            break;
+
+        // Requests replaced by a newer request of the same agent are dropped.
+        _pathBatch.clear();
+        while (!_pathRequests.empty() && _pathBatch.size() < batchSize)
+        {
+            PathRequest* request = _pathRequests.front();
+            _pathRequests.pop_front();
+            if (request->id == request->agent->_pathRequestId)
+            {
+                _pathBatch.push_back(request);
+            }
+            else
+            {
+                SAFE_RELEASE(request->navMesh);
+                SAFE_DELETE(request);
+            }
+        }
+        if (_pathBatch.empty())
+            break;
+
+        if (workerCount > 0)
+            scheduler->parallelFor((unsigned int)_pathBatch.size(), &AIController::findPaths, &_pathBatch);
+        else
+            findPaths(&_pathBatch, 0, (unsigned int)_pathBatch.size());
+        processed = true;
+
+        // Deliver the results on the game thread.
+        for (size_t i = 0, count = _pathBatch.size(); i < count; ++i)
+        {
+            PathRequest* request = _pathBatch[i];
+            request->agent->completePath(&request->path, request->found);
+            SAFE_RELEASE(request->navMesh);
+            SAFE_DELETE(request);
+        }
+    }
+    _pathBatch.clear();
+}
+
+void AIController::findPaths(void* arg, unsigned int start, unsigned int end)
+{
+    std::vector<PathRequest*>& requests = *(std::vector<PathRequest*>*)arg;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        PathRequest* request = requests[i];
+        request->found = request->navMesh->findPath(request->start, request->end, &request->path);
+    }
+}
+
+void AIController::receivePostedMessages()
+{
+    // Hold the lock only to swap the list.
+    {
+        Mutex::Lock lock(_postMutex);
+        _receivedMessages.swap(_postedMessages);
+    }
+    for (size_t i = 0, count = _receivedMessages.size(); i < count; ++i)
+    {
+        AIMessage* message = _receivedMessages[i];
+        sendMessage(message, (float)message->_deliveryTime);
+    }
+    _receivedMessages.clear();
+}
+
+void AIController::updateAgents(void* arg, unsigned int start, unsigned int end)
+{
+    std::vector<AIAgent*>& agents = *(std::vector<AIAgent*>*)arg;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        // The state machine integrates all the time since its previous update.
+        AIAgent* agent = agents[i];
+        float agentTime = agent->_elapsedTime;
+        agent->_elapsedTime = 0.0f;
+        agent->update(agentTime);
+    }
+}
+
+float AIController::getPathBudget() const
+{
+    return _pathBudget;
+}
+
+void AIController::setPathBudget(float budget)
+{
+    _pathBudget = std::max(budget, 0.0f);
+}
+
+unsigned int AIController::getPendingPathCount() const
+{
+    return (unsigned int)_pathRequests.size();
+}
+
+bool AIController::isParallelUpdate() const
+{
+    return _parallel;
+}
+
+void AIController::setParallelUpdate(bool parallel)
+{
+    _parallel = parallel;
+}
+
+float AIController::getUpdateBudget() const
+{
+    return _updateBudget;
+}
+
+void AIController::setUpdateBudget(float budget)
+{
+    _updateBudget = std::max(budget, 0.0f);
+}
+
+bool AIController::compareMessages(const AIMessage* a, const AIMessage* b)
+{
+    return a->_deliveryTime > b->_deliveryTime;
+}
+
+bool AIController::compareAgents(const AIAgent* a, const AIAgent* b)
+{
+    return a->_urgency > b->_urgency;
 }
 
 void AIController::addAgent(AIAgent* agent)
@@ -160,6 +430,24 @@ void AIController::removeAgent(AIAgent* agent)
                 _firstAgent = agent->_next;
 
             agent->_next = NULL;
+
+            // Drop the pending path requests of the agent.
+            for (std::list<PathRequest*>::iterator request = _pathRequests.begin(); request != _pathRequests.end();)
+            {
+                if ((*request)->agent == agent)
+                {
+                    SAFE_RELEASE((*request)->navMesh);
+                    SAFE_DELETE(*request);
+                    request = _pathRequests.erase(request);
+                }
+                else
+                {
+                    ++request;
+                }
+            }
+            agent->_pathRequested = false;
+            agent->_pathPending = false;
+
             agent->release();
             break;
         }
@@ -3,6 +3,7 @@
 
 #include "AIAgent.h"
 #include "AIMessage.h"
+#include "Thread.h"
 
 namespace gameplay
 {
@@ -11,11 +12,40 @@ namespace gameplay
  * Defines and facilitates the state machine execution and message passing
  * between AI objects in the game. This class is generally not interfaced
  * with directly.
+ *
+ * Each frame, the agents whose update interval has passed are due for an update. When an
+ * update budget is set, the due agents are updated in order of urgency until the budget is
+ * spent and the others wait for the next frame. Urgency grows with the time an agent has
+ * waited and shrinks with its distance from the active camera of its scene, so agents near
+ * the camera are updated first but distant agents are never starved.
+ *
+ * With parallel updates enabled, the due agents are updated on the worker threads of the
+ * game's JobScheduler. An AIState::Listener::stateUpdate() implementation is then called from
+ * any thread, concurrently with the updates of other agents, and must follow these rules:
+ *
+ * - It may read its own agent, the agent's node and any engine state that is not modified
+ *   during the AI update, such as node transforms, the game time and the scene graph.
+ * - It may only modify data owned by its own agent.
+ * - It must not make graphics, audio, physics or script calls, modify nodes, or create Ref
+ *   objects. It may retain and release shared Ref objects, since reference counts are atomic
+ *   (unless the engine is built with GP_NO_ATOMIC_REF_COUNT), but must not release the last
+ *   reference to one, since the object would be destroyed while other agents may use it.
+ * - It may send messages and change states. These are deferred while the agents update in
+ *   parallel and are delivered in a merge step on the game thread, so the enter and exit
+ *   events and the message listeners are always called on the game thread.
+ *
+ * Agents whose active state has Lua script update callbacks are updated on the game thread after
+ * the merge step, since the script runtime is single-threaded.
+ *
+ * Paths requested with AIAgent::findPath() are found after the agents are updated. The
+ * requests are processed in batches on the job system's worker threads, and batches are
+ * processed until the path budget is spent. The remaining requests wait for the next frame.
  */
 class AIController
 {
     friend class Game;
     friend class Node;
+    friend class AIStateMachine;
 
 public:
 
@@ -34,6 +64,19 @@ public:
      */
     void sendMessage(AIMessage* message, float delay = 0);
 
+    /**
+     * Posts the specified message for delivery from the game thread.
+     *
+     * Unlike sendMessage(), which must be called from the game thread, this method can be
+     * called from any thread, such as jobs running AI logic in parallel. The message is
+     * delivered, or queued for delayed delivery, during the next update of the AIController.
+     *
+     * @param message The message to post.
+     * @param delay The delay (in milliseconds) to wait before sending the message,
+     *      counted from the next update.
+     */
+    void postMessage(AIMessage* message, float delay = 0);
+
     /**
      * Searches for an AIAgent that is registered with the AIController with the specified ID.
      *
@@ -43,8 +86,84 @@ public:
      */
     AIAgent* findAgent(const char* id) const;
 
+    /**
+     * Returns the time budget for updating agents each frame.
+     *
+     * @return The update budget, in milliseconds, or zero if there is no limit.
+     */
+    float getUpdateBudget() const;
+
+    /**
+     * Sets the time budget for updating agents each frame.
+     *
+     * At least one due agent is updated every frame, even if it takes longer than the budget.
+     * The budget can also be set by the 'updateBudget' property in the 'ai' section of the game
+     * configuration file.
+     *
+     * @param budget The update budget, in milliseconds, or zero to update all the due agents every frame.
+     */
+    void setUpdateBudget(float budget);
+
+    /**
+     * Returns whether agents are updated in parallel on the job system's worker threads.
+     *
+     * @return True if agents are updated in parallel.
+     */
+    bool isParallelUpdate() const;
+
+    /**
+     * Sets whether agents are updated in parallel on the job system's worker threads.
+     *
+     * State listeners must follow the thread-safety rules described in the class
+     * documentation before this is enabled. When the job system has no worker threads,
+     * the agents are updated on the game thread. This can also be set by the 'parallel'
+     * property in the 'ai' section of the game configuration file.
+     *
+     * @param parallel True to update agents in parallel, false to update them on the game thread.
+     */
+    void setParallelUpdate(bool parallel);
+
+    /**
+     * Returns the time budget for finding the paths requested by agents each frame.
+     *
+     * @return The path budget, in milliseconds, or zero if there is no limit.
+     */
+    float getPathBudget() const;
+
+    /**
+     * Sets the time budget for finding the paths requested by agents each frame.
+     *
+     * At least one batch of requests is processed every frame, even if it takes longer than
+     * the budget. The default budget is 2 milliseconds. The budget can also be set by the
+     * 'pathBudget' property in the 'ai' section of the game configuration file.
+     *
+     * @param budget The path budget, in milliseconds, or zero to process all requests every frame.
+     */
+    void setPathBudget(float budget);
+
+    /**
+     * Returns the number of path requests waiting to be processed.
+     *
+     * @return The number of pending path requests.
+     */
+    unsigned int getPendingPathCount() const;
+
 private:
 
+    /**
+     * Defines a path request of an agent.
+     */
+    struct PathRequest
+    {
+        AIAgent* agent;
+        NavMesh* navMesh;
+        Vector3 start;
+        Vector3 end;
+        unsigned int id;
+        bool found;
+        std::vector<Vector3> path;
+    };
+
     /**
      * Constructor.
      */
@@ -96,9 +215,51 @@ private:
 
     void removeAgent(AIAgent* agent);
 
+    /**
+     * Delivers the messages posted from other threads, or queues the delayed ones.
+     */
+    void receivePostedMessages();
+
+    /**
+     * Updates a range of the agents in a vector by the time elapsed since their previous update.
+     */
+    static void updateAgents(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Queues the paths requested by agents and processes the queued requests within the path budget.
+     */
+    void processPathRequests();
+
+    /**
+     * Finds the paths of a range of the requests in a vector.
+     */
+    static void findPaths(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Orders agents by decreasing urgency.
+     */
+    static bool compareAgents(const AIAgent* a, const AIAgent* b);
+
+    /**
+     * Orders the message heap so that the earliest delivery time is at the front.
+     */
+    static bool compareMessages(const AIMessage* a, const AIMessage* b);
+
     bool _paused;
-    AIMessage* _firstMessage;
+    std::vector<AIMessage*> _messages;
+    std::vector<AIMessage*> _postedMessages;
+    std::vector<AIMessage*> _receivedMessages;
+    Mutex _postMutex;
     AIAgent* _firstAgent;
+    float _updateBudget;
+    std::vector<AIAgent*> _dueAgents;
+    bool _parallel;
+    bool _updatingInParallel;
+    std::vector<AIAgent*> _parallelAgents;
+    std::vector<AIAgent*> _serialAgents;
+    float _pathBudget;
+    std::list<PathRequest*> _pathRequests;
+    std::vector<PathRequest*> _pathBatch;
 
 };
 
@@ -1,11 +1,20 @@
 #include "Base.h"
 #include "AIMessage.h"
+#include "Thread.h"
+
+// The maximum number of destroyed messages kept for reuse.
+#define AI_MESSAGE_POOL_SIZE 1024
 
 namespace gameplay
 {
 
+// Destroyed messages linked through their _next pointer.
+static AIMessage* __freeMessages = NULL;
+static unsigned int __freeMessageCount = 0;
+static Mutex __poolMutex;
+
 AIMessage::AIMessage()
-    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
+    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _parameterCapacity(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
 {
 }
 
@@ -16,21 +25,75 @@ AIMessage::~AIMessage()
 
 AIMessage* AIMessage::create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount)
 {
-    AIMessage* message = new AIMessage();
+    // Reuse a destroyed message if there is one.
+    AIMessage* message = NULL;
+    {
+        Mutex::Lock lock(__poolMutex);
+        if (__freeMessages)
+        {
+            message = __freeMessages;
+            __freeMessages = message->_next;
+            message->_next = NULL;
+            --__freeMessageCount;
+        }
+    }
+    if (message == NULL)
+    {
+        message = new AIMessage();
+    }
+
     message->_id = id;
-    message->_sender = sender;
-    message->_receiver = receiver;
-    message->_parameterCount = parameterCount;
-    if (parameterCount > 0)
+    message->_sender = sender ? sender : "";
+    message->_receiver = receiver ? receiver : "";
+    message->_deliveryTime = 0;
+    message->_messageType = MESSAGE_TYPE_CUSTOM;
+    if (parameterCount > message->_parameterCapacity)
+    {
+        SAFE_DELETE_ARRAY(message->_parameters);
         message->_parameters = new AIMessage::Parameter[parameterCount];
+        message->_parameterCapacity = parameterCount;
+    }
+    message->_parameterCount = parameterCount;
     return message;
 }
 
 void AIMessage::destroy(AIMessage* message)
 {
+    if (message == NULL)
+        return;
+
+    // Free string parameters now, so pooled messages only hold on to their parameter array.
+    for (unsigned int i = 0; i < message->_parameterCount; ++i)
+    {
+        message->clearParameter(i);
+    }
+    message->_parameterCount = 0;
+
+    {
+        Mutex::Lock lock(__poolMutex);
+        if (__freeMessageCount < AI_MESSAGE_POOL_SIZE)
+        {
+            message->_next = __freeMessages;
+            __freeMessages = message;
+            ++__freeMessageCount;
+            return;
+        }
+    }
     SAFE_DELETE(message);
 }
 
+void AIMessage::clearPool()
+{
+    Mutex::Lock lock(__poolMutex);
+    while (__freeMessages)
+    {
+        AIMessage* message = __freeMessages;
+        __freeMessages = message->_next;
+        SAFE_DELETE(message);
+    }
+    __freeMessageCount = 0;
+}
+
 unsigned int AIMessage::getId() const
 {
     return _id;
@@ -61,6 +61,10 @@ public:
      * sent. However, in the rare case where an AIMessage is constructed and not
      * passed to AIController::sendMessage, this method should be called to destroy
      * the message.
+     *
+     * Destroyed messages are kept in a pool and reused by create(), along with their
+     * parameter arrays, so sending messages does not allocate memory once the pool is
+     * warm. Messages can be created and destroyed from any thread.
      */
     static void destroy(AIMessage* message);
 
@@ -267,12 +271,18 @@ private:
 
     void clearParameter(unsigned int index);
 
+    /**
+     * Frees the messages kept for reuse.
+     */
+    static void clearPool();
+
     unsigned int _id;
     std::string _sender;
     std::string _receiver;
     double _deliveryTime;
     Parameter* _parameters;
     unsigned int _parameterCount;
+    unsigned int _parameterCapacity;
     MessageType _messageType;
     AIMessage* _next;
 
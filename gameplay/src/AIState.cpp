@@ -2,17 +2,42 @@
 #include "AIState.h"
 #include "AIStateMachine.h"
 
+// The script events of states.
+#define AISTATE_EVENT_ENTER 0
+#define AISTATE_EVENT_EXIT 1
+#define AISTATE_EVENT_UPDATE 2
+
 namespace gameplay
 {
 
+static const ScriptTarget::Event __stateEvents[] =
+{
+    { "enter", "<AIAgent><AIState>" },
+    { "exit", "<AIAgent><AIState>" },
+    { "update", "<AIAgent><AIState>f" }
+};
+
 AIState* AIState::_empty = NULL;
 
+// The interned state IDs, indexed by key, and the keys of the IDs by hash.
+static std::vector<std::string> __stateIds;
+static std::multimap<unsigned int, unsigned int> __stateKeys;
+
+static unsigned int hashStateId(const char* id)
+{
+    // FNV-1a, as for node IDs.
+    unsigned int hash = 2166136261u;
+    for (; *id; ++id)
+    {
+        hash = (hash ^ (unsigned char)*id) * 16777619u;
+    }
+    return hash;
+}
+
 AIState::AIState(const char* id)
-    : _id(id), _listener(NULL)
+    : _id(id), _key(getKey(id, true)), _listener(NULL)
 {
-    addScriptEvent("enter", "<AIAgent><AIState>");
-    addScriptEvent("exit", "<AIAgent><AIState>");
-    addScriptEvent("update", "<AIAgent><AIState>f");
+    setScriptEvents(__stateEvents, 3);
 }
 
 AIState::~AIState()
@@ -29,6 +54,32 @@ const char* AIState::getId() const
     return _id.c_str();
 }
 
+unsigned int AIState::getKey() const
+{
+    return _key;
+}
+
+unsigned int AIState::getKey(const char* id, bool intern)
+{
+    GP_ASSERT(id);
+
+    unsigned int hash = hashStateId(id);
+    std::pair<std::multimap<unsigned int, unsigned int>::const_iterator, std::multimap<unsigned int, unsigned int>::const_iterator> range = __stateKeys.equal_range(hash);
+    for (std::multimap<unsigned int, unsigned int>::const_iterator itr = range.first; itr != range.second; ++itr)
+    {
+        if (__stateIds[itr->second] == id)
+            return itr->second;
+    }
+
+    if (!intern)
+        return KEY_NONE;
+
+    unsigned int key = (unsigned int)__stateIds.size();
+    __stateIds.push_back(id);
+    __stateKeys.insert(std::make_pair(hash, key));
+    return key;
+}
+
 void AIState::setListener(Listener* listener)
 {
     _listener = listener;
@@ -39,7 +90,7 @@ void AIState::enter(AIStateMachine* stateMachine)
     if (_listener)
         _listener->stateEnter(stateMachine->getAgent(), this);
 
-    fireScriptEvent<void>("enter", stateMachine->getAgent(), this);
+    fireScriptEvent<void>(AISTATE_EVENT_ENTER, stateMachine->getAgent(), this);
 }
 
 void AIState::exit(AIStateMachine* stateMachine)
@@ -47,7 +98,7 @@ void AIState::exit(AIStateMachine* stateMachine)
     if (_listener)
         _listener->stateExit(stateMachine->getAgent(), this);
 
-    fireScriptEvent<void>("exit", stateMachine->getAgent(), this);
+    fireScriptEvent<void>(AISTATE_EVENT_EXIT, stateMachine->getAgent(), this);
 }
 
 void AIState::update(AIStateMachine* stateMachine, float elapsedTime)
@@ -55,7 +106,12 @@ void AIState::update(AIStateMachine* stateMachine, float elapsedTime)
     if (_listener)
         _listener->stateUpdate(stateMachine->getAgent(), this, elapsedTime);
 
-    fireScriptEvent<void>("update", stateMachine->getAgent(), this, elapsedTime);
+    fireScriptEvent<void>(AISTATE_EVENT_UPDATE, stateMachine->getAgent(), this, elapsedTime);
+}
+
+bool AIState::hasScriptUpdate() const
+{
+    return hasScriptCallbacks(AISTATE_EVENT_UPDATE);
 }
 
 AIState::Listener::~Listener()
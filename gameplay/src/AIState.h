@@ -16,10 +16,15 @@ class AIStateMachine;
  * An AIState encapsulates a state and unit of work within an AI
  * state machine. Events can be programmed or scripted when the
  * state is entered, exited and each frame/tick in its update event.
+ *
+ * State IDs are interned into integer keys, shared by all the states with the same ID,
+ * which state machines index their states by. Looking a key up once with getKey(const char*, bool)
+ * lets agents find and change states without comparing strings.
  */
 class AIState : public Ref, public ScriptTarget
 {
     friend class AIStateMachine;
+    friend class AIController;
 
 public:
 
@@ -55,6 +60,8 @@ public:
          * Called once per frame when for a state when it is active.
          *
          * This method is normally where the logic for a state is implemented.
+         * When the AIController updates agents in parallel, this is called from a
+         * worker thread and must follow the rules described in AIController.
          *
          * @param agent The AIAgent this state event is for.
          * @param state The active AIState.
@@ -63,6 +70,11 @@ public:
         virtual void stateUpdate(AIAgent* agent, AIState* state, float elapsedTime);
     };
 
+    /**
+     * The key returned by getKey(const char*, bool) for an ID that is not interned.
+     */
+    static const unsigned int KEY_NONE = 0xFFFFFFFF;
+
     /**
      * Creates a new AISTate.
      *
@@ -80,6 +92,27 @@ public:
      */
     const char* getId() const;
 
+    /**
+     * Returns the interned key of the ID of this state.
+     *
+     * @return The state key.
+     * @script{ignore}
+     */
+    unsigned int getKey() const;
+
+    /**
+     * Returns the interned key of a state ID.
+     *
+     * IDs are interned on the game thread, when states are created or when requested.
+     *
+     * @param id The state ID.
+     * @param intern true to intern the ID if it is not interned yet.
+     *
+     * @return The key of the ID, or KEY_NONE if the ID is not interned.
+     * @script{ignore}
+     */
+    static unsigned int getKey(const char* id, bool intern = true);
+
     /**
      * Sets a listener to dispatch state events to.
      * 
@@ -124,7 +157,13 @@ private:
      */
     void update(AIStateMachine* stateMachine, float elapsedTime);
 
+    /**
+     * Returns whether any Lua script callbacks are registered for the update event of this state.
+     */
+    bool hasScriptUpdate() const;
+
     std::string _id;
+    unsigned int _key;
     Listener* _listener;
 
     // The default/empty state.
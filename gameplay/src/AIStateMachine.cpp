@@ -48,6 +48,7 @@ AIState* AIStateMachine::addState(const char* id)
 {
     AIState* state = AIState::create(id);
     _states.push_back(state);
+    indexState(state);
     return state;
 }
 
@@ -55,6 +56,18 @@ void AIStateMachine::addState(AIState* state)
 {
     state->addRef();
     _states.push_back(state);
+    indexState(state);
+}
+
+void AIStateMachine::indexState(AIState* state)
+{
+    GP_ASSERT(state);
+
+    unsigned int key = state->_key;
+    if (key >= _stateTable.size())
+        _stateTable.resize(key + 1, NULL);
+    if (_stateTable[key] == NULL)
+        _stateTable[key] = state;
 }
 
 void AIStateMachine::removeState(AIState* state)
@@ -63,6 +76,20 @@ void AIStateMachine::removeState(AIState* state)
     if (itr != _states.end())
     {
         _states.erase(itr);
+
+        // Another state with the same ID takes over the entry of the state in the table.
+        if (_stateTable[state->_key] == state)
+        {
+            _stateTable[state->_key] = NULL;
+            for (itr = _states.begin(); itr != _states.end(); ++itr)
+            {
+                if ((*itr)->_key == state->_key)
+                {
+                    _stateTable[state->_key] = *itr;
+                    break;
+                }
+            }
+        }
         state->release();
     }
 }
@@ -71,15 +98,13 @@ AIState* AIStateMachine::getState(const char* id) const
 {
     GP_ASSERT(id);
 
-    for (std::list<AIState*>::const_iterator itr = _states.begin(); itr != _states.end(); ++itr)
-    {
-        AIState* state = (*itr);
-
-        if (strcmp(id, state->getId()) == 0)
-            return state;
-    }
+    // IDs that are not interned can't belong to any state.
+    return getState(AIState::getKey(id, false));
+}
 
-    return NULL;
+AIState* AIStateMachine::getState(unsigned int key) const
+{
+    return key < _stateTable.size() ? _stateTable[key] : NULL;
 }
 
 AIState* AIStateMachine::getActiveState() const
@@ -91,6 +116,8 @@ bool AIStateMachine::hasState(AIState* state) const
 {
     GP_ASSERT(state);
 
+    if (getState(state->_key) == state)
+        return true;
     return (std::find(_states.begin(), _states.end(), state) != _states.end());
 }
 
@@ -113,11 +140,41 @@ bool AIStateMachine::setState(AIState* state)
     return false;
 }
 
+AIState* AIStateMachine::setState(unsigned int key)
+{
+    AIState* state = getState(key);
+    if (state)
+        sendChangeStateMessage(state);
+    return state;
+}
+
+bool AIStateMachine::changeState(AIState* state)
+{
+    if (!hasState(state))
+        return false;
+
+    // States can only be entered and exited on the game thread.
+    if (Game::getInstance()->getAIController()->_updatingInParallel)
+        sendChangeStateMessage(state);
+    else
+        setStateInternal(state);
+    return true;
+}
+
+AIState* AIStateMachine::changeState(unsigned int key)
+{
+    AIState* state = getState(key);
+    if (state)
+        changeState(state);
+    return state;
+}
+
 void AIStateMachine::sendChangeStateMessage(AIState* newState)
 {
+    // The state is sent by key, so that the agent finds it without comparing strings.
     AIMessage* message = AIMessage::create(0, _agent->getId(), _agent->getId(), 1);
     message->_messageType = AIMessage::MESSAGE_TYPE_STATE_CHANGE;
-    message->setString(0, newState->getId());
+    message->setInt(0, (int)newState->_key);
     Game::getInstance()->getAIController()->sendMessage(message);
 }
 
@@ -30,6 +30,7 @@ class AIAgent;
 class AIStateMachine
 {
     friend class AIAgent;
+    friend class SceneSnapshot;
 
 public:
 
@@ -76,6 +77,16 @@ public:
      */
     AIState* getState(const char* id) const;
 
+    /**
+     * Returns a state registered with this state machine, by the interned key of its ID.
+     *
+     * @param key The key of the ID of the state to return (see AIState::getKey).
+     *
+     * @return The state with the given key, or NULL if no such state exists.
+     * @script{ignore}
+     */
+    AIState* getState(unsigned int key) const;
+
     /**
      * Returns the active state for this state machine.
      *
@@ -107,6 +118,47 @@ public:
      */
     bool setState(AIState* state);
 
+    /**
+     * Changes the state of this state machine to the state with the given key.
+     *
+     * Like setState(const char*), the state changes when the message sent to the agent is
+     * delivered, but the state is found and sent without comparing strings.
+     *
+     * @param key The key of the ID of the new state (see AIState::getKey).
+     *
+     * @return The new state, or NULL if no matching state could be found.
+     * @script{ignore}
+     */
+    AIState* setState(unsigned int key);
+
+    /**
+     * Changes the state of this state machine to the given state immediately.
+     *
+     * The exit event of the active state and the enter event of the new state are fired
+     * before this method returns, without sending a message, so the message listener of
+     * the agent is not notified. While agents are updated in parallel, the state changes
+     * in the merge step on the game thread instead, as for setState().
+     *
+     * @param state The new state.
+     *
+     * @return true if the state is changed (or will be, in the merge step), false if the
+     *      state is not registered with this state machine.
+     * @script{ignore}
+     */
+    bool changeState(AIState* state);
+
+    /**
+     * Changes the state of this state machine to the state with the given key immediately.
+     *
+     * @param key The key of the ID of the new state (see AIState::getKey).
+     *
+     * @return The new state, or NULL if no matching state could be found.
+     *
+     * @see changeState(AIState*)
+     * @script{ignore}
+     */
+    AIState* changeState(unsigned int key);
+
 private:
 
     /**
@@ -144,6 +196,11 @@ private:
      */
     bool hasState(AIState* state) const;
 
+    /**
+     * Enters a state in the state table, unless a state with the same key already is.
+     */
+    void indexState(AIState* state);
+
     /**
      * Called by AIController to update the state machine each frame.
      */
@@ -153,6 +210,9 @@ private:
     AIState* _currentState;
     std::list<AIState*> _states;
 
+    // The first registered state of each key, indexed by key.
+    std::vector<AIState*> _stateTable;
+
 };
 
 }
@@ -6,6 +6,7 @@
 #include "Game.h"
 #include "Transform.h"
 #include "Properties.h"
+#include "Bundle.h"
 
 #define ANIMATION_INDEFINITE_STR "INDEFINITE"
 #define ANIMATION_DEFAULT_CLIP 0
@@ -16,7 +17,7 @@ namespace gameplay
 {
 
 Animation::Animation(const char* id, AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL)
 {
     createChannel(target, propertyId, keyCount, keyTimes, keyValues, type);
 
@@ -26,7 +27,7 @@ Animation::Animation(const char* id, AnimationTarget* target, int propertyId, un
 }
 
 Animation::Animation(const char* id, AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, float* keyInValue, float* keyOutValue, unsigned int type)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL)
 {
     createChannel(target, propertyId, keyCount, keyTimes, keyValues, keyInValue, keyOutValue, type);
     // Release the animation because a newly created animation has a ref count of 1 and the channels hold the ref to animation.
@@ -34,8 +35,17 @@ Animation::Animation(const char* id, AnimationTarget* target, int propertyId, un
     GP_ASSERT(getRefCount() == 1);
 }
 
+Animation::Animation(const char* id, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL)
+{
+    createChannel(target, propertyId, curve, duration);
+    // Release the animation because a newly created animation has a ref count of 1 and the channels hold the ref to animation.
+    release();
+    GP_ASSERT(getRefCount() == 1);
+}
+
 Animation::Animation(const char* id)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL)
 {
 }
 
@@ -72,24 +82,25 @@ Animation::~Animation()
         _clips->clear();
     }
     SAFE_DELETE(_clips);
+    SAFE_RELEASE(_bundle);
 }
 
 Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration)
-    : _animation(animation), _target(target), _propertyId(propertyId), _curve(curve), _duration(duration)
+    : _animation(animation), _target(target), _propertyId(propertyId), _curve(curve), _duration(duration), _curveOffset(-1L)
 {
     GP_ASSERT(_animation);
     GP_ASSERT(_target);
-    GP_ASSERT(_curve);
 
     // get property component count, and ensure the property exists on the AnimationTarget by getting the property component count.
     GP_ASSERT(_target->getAnimationPropertyComponentCount(propertyId));
-    _curve->addRef();
+    if (_curve)
+        _curve->addRef();
     _target->addChannel(this);
     _animation->addRef();
 }
 
 Animation::Channel::Channel(const Channel& copy, Animation* animation, AnimationTarget* target)
-    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve), _duration(copy._duration)
+    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve), _duration(copy._duration), _curveOffset(-1L)
 {
     GP_ASSERT(_curve);
     GP_ASSERT(_target);
@@ -313,10 +324,23 @@ AnimationClip* Animation::findClip(const char* id) const
 }
 
 Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type)
+{
+    unsigned long duration;
+    Curve* curve = createCurve(target, propertyId, keyCount, keyTimes, keyValues, type, &duration);
+
+    Channel* channel = new Channel(this, target, propertyId, curve, duration);
+    curve->release();
+    addChannel(channel);
+    return channel;
+}
+
+Curve* Animation::createCurve(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues,
+                              unsigned int type, unsigned long* duration)
 {
     GP_ASSERT(target);
     GP_ASSERT(keyTimes);
     GP_ASSERT(keyValues);
+    GP_ASSERT(duration);
 
     unsigned int propertyComponentCount = target->getAnimationPropertyComponentCount(propertyId);
     GP_ASSERT(propertyComponentCount > 0);
@@ -327,7 +351,7 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
         setTransformRotationOffset(curve, propertyId);
 
     unsigned int lowest = keyTimes[0];
-    unsigned long duration = keyTimes[keyCount-1] - lowest;
+    *duration = keyTimes[keyCount-1] - lowest;
 
     float* normalizedKeyTimes = new float[keyCount];
 
@@ -338,7 +362,7 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     unsigned int i = 1;
     for (; i < keyCount - 1; i++)
     {
-        normalizedKeyTimes[i] = (float) (keyTimes[i] - lowest) / (float) duration;
+        normalizedKeyTimes[i] = (float) (keyTimes[i] - lowest) / (float) *duration;
         curve->setPoint(i, normalizedKeyTimes[i], (keyValues + pointOffset), (Curve::InterpolationType) type);
         pointOffset += propertyComponentCount;
     }
@@ -350,10 +374,7 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
 
     SAFE_DELETE_ARRAY(normalizedKeyTimes);
 
-    Channel* channel = new Channel(this, target, propertyId, curve, duration);
-    curve->release();
-    addChannel(channel);
-    return channel;
+    return curve;
 }
 
 Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, float* keyInValue, float* keyOutValue, unsigned int type)
@@ -398,6 +419,46 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     return channel;
 }
 
+Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration)
+{
+    GP_ASSERT(target);
+    GP_ASSERT(curve == NULL || curve->getComponentCount() == target->getAnimationPropertyComponentCount(propertyId));
+
+    Channel* channel = new Channel(this, target, propertyId, curve, duration);
+    addChannel(channel);
+    return channel;
+}
+
+void Animation::loadCurves()
+{
+    if (_bundle == NULL)
+        return;
+
+    for (size_t i = 0, count = _channels.size(); i < count; ++i)
+    {
+        Channel* channel = _channels[i];
+        if (channel->_curve == NULL)
+        {
+            channel->_curve = _bundle->loadAnimationCurve(_id.c_str(), channel->_target, channel->_propertyId, channel->_curveOffset);
+            if (channel->_curve == NULL)
+            {
+                // Hold the current value of the property so the channel can still be evaluated.
+                unsigned int componentCount = channel->_target->getAnimationPropertyComponentCount(channel->_propertyId);
+                AnimationValue value(componentCount);
+                channel->_target->getAnimationPropertyValue(channel->_propertyId, &value);
+                std::vector<float> values(componentCount);
+                value.getFloats(0, &values[0], componentCount);
+                channel->_curve = Curve::create(1, componentCount);
+                if (channel->_target->_targetType == AnimationTarget::TRANSFORM)
+                    setTransformRotationOffset(channel->_curve, channel->_propertyId);
+                channel->_curve->setPoint(0, 0.0f, &values[0], Curve::LINEAR);
+            }
+            channel->_curveOffset = -1L;
+        }
+    }
+    SAFE_RELEASE(_bundle);
+}
+
 void Animation::addChannel(Channel* channel)
 {
     GP_ASSERT(channel);
@@ -447,6 +508,9 @@ Animation* Animation::clone(Channel* channel, AnimationTarget* target)
 {
     GP_ASSERT(channel);
 
+    // The clone shares the curves, so they must have been read.
+    loadCurves();
+
     Animation* animation = new Animation(getId());
 
     Animation::Channel* channelCopy = new Animation::Channel(*channel, animation, target);
@@ -11,6 +11,7 @@ namespace gameplay
 class AnimationTarget;
 class AnimationController;
 class AnimationClip;
+class Bundle;
 
 /**
  * Defines a generic property animation.
@@ -25,8 +26,10 @@ class AnimationClip;
 class Animation : public Ref
 {
     friend class AnimationClip;
+    friend class AnimationController;
     friend class AnimationTarget;
     friend class Bundle;
+    friend class SceneSnapshot;
 
 public:
 
@@ -123,8 +126,11 @@ private:
     class Channel
     {
         friend class AnimationClip;
+        friend class AnimationController;
         friend class Animation;
         friend class AnimationTarget;
+        friend class SceneSnapshot;
+        friend class Bundle;
 
     private:
 
@@ -138,8 +144,9 @@ private:
         Animation* _animation;                // Reference to the animation this channel belongs to.
         AnimationTarget* _target;             // The target of this channel.
         int _propertyId;                      // The target property this channel targets.
-        Curve* _curve;                        // The curve used to represent the animation data.
+        Curve* _curve;                        // The curve used to represent the animation data (NULL until a lazily loaded channel is played).
         unsigned long _duration;              // The length of the animation (in milliseconds).
+        long _curveOffset;                    // The offset of the curve data in the bundle of a lazily loaded channel.
     };
 
     /**
@@ -157,6 +164,11 @@ private:
      */
     Animation(const char* id, AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type);
 
+    /**
+     * Constructor.
+     */
+    Animation(const char* id, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration);
+
     /**
      * Constructor.
      */
@@ -202,6 +214,26 @@ private:
      */
     Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, float* keyInValue, float* keyOutValue, unsigned int type);
 
+    /**
+     * Creates a channel within this animation from an existing curve (such as a quantized curve loaded from a bundle).
+     *
+     * The curve is NULL for a channel whose curve is read from the bundle of the animation when it is first played.
+     */
+    Channel* createChannel(AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration);
+
+    /**
+     * Creates the curve of linear key values for a property of a target.
+     *
+     * @param duration Set to the duration of the curve, in milliseconds.
+     */
+    static Curve* createCurve(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues,
+                              unsigned int type, unsigned long* duration);
+
+    /**
+     * Reads the curves of the lazily loaded channels from the bundle of the animation. Called before the animation is played or cloned.
+     */
+    void loadCurves();
+
     /**
      * Adds a channel to the animation.
      */
@@ -215,7 +247,7 @@ private:
     /**
      * Sets the rotation offset in a Curve representing a Transform's animation data.
      */
-    void setTransformRotationOffset(Curve* curve, unsigned int propertyId);
+    static void setTransformRotationOffset(Curve* curve, unsigned int propertyId);
 
     /**
      * Clones this animation.
@@ -233,6 +265,7 @@ private:
     std::vector<Channel*> _channels;        // The channels within this Animation.
     AnimationClip* _defaultClip;            // The Animation's default clip.
     std::vector<AnimationClip*>* _clips;    // All the clips created from this Animation.
+    Bundle* _bundle;                        // The bundle to read the curves of lazily loaded channels from, or NULL.
 
 };
 
@@ -4,7 +4,9 @@
 #include "AnimationTarget.h"
 #include "Game.h"
 #include "Quaternion.h"
+#include "Node.h"
 #include "ScriptController.h"
+#include "MemoryPool.h"
 
 namespace gameplay
 {
@@ -13,17 +15,20 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
     : _id(id), _animation(animation), _startTime(startTime), _endTime(endTime), _duration(_endTime - _startTime), 
       _stateBits(0x00), _repeatCount(1.0f), _loopBlendTime(0), _activeDuration(_duration * _repeatCount), _speed(1.0f), _timeStarted(0), 
       _elapsedTime(0), _crossFadeToClip(NULL), _crossFadeOutElapsed(0), _crossFadeOutDuration(0), _blendWeight(1.0f),
-      _beginListeners(NULL), _endListeners(NULL), _listeners(NULL), _listenerItr(NULL), _scriptListeners(NULL)
+      _updateInterval(1), _updateCount(0), _lod(0), _frozen(false), _visibilityNode(NULL), _poseSharing(false), _listenerCursor(0),
+      _listenerTime(0)
 {
     GP_ASSERT(_animation);
     GP_ASSERT(0 <= startTime && startTime <= _animation->_duration && 0 <= endTime && endTime <= _animation->_duration);
 
     for (size_t i = 0, count = _animation->_channels.size(); i < count; i++)
     {
-        GP_ASSERT(_animation->_channels[i]);
-        GP_ASSERT(_animation->_channels[i]->getCurve());
-        _values.push_back(new AnimationValue(_animation->_channels[i]->getCurve()->getComponentCount()));
+        // The curves of lazily loaded channels are only read when the clip plays, so the values follow the targets.
+        Animation::Channel* channel = _animation->_channels[i];
+        GP_ASSERT(channel);
+        _values.push_back(new AnimationValue(channel->_target->getAnimationPropertyComponentCount(channel->_propertyId)));
     }
+    _keyframeCursors.resize(_values.size(), 0);
 }
 
 AnimationClip::~AnimationClip()
@@ -37,40 +42,34 @@ AnimationClip::~AnimationClip()
     _values.clear();
 
     SAFE_RELEASE(_crossFadeToClip);
-    SAFE_DELETE(_beginListeners);
-    SAFE_DELETE(_endListeners);
+    SAFE_RELEASE(_visibilityNode);
 
-    if (_scriptListeners)
+    for (size_t i = 0; i < _scriptListeners.size(); i++)
     {
-        for (size_t i = 0; i < _scriptListeners->size(); i++)
-        {
-            SAFE_DELETE((*_scriptListeners)[i]);
-        }
-        SAFE_DELETE(_scriptListeners);
+        SAFE_DELETE(_scriptListeners[i]);
     }
+}
 
-    if (_listeners)
-    {
-        *_listenerItr = _listeners->begin();
-        while (*_listenerItr != _listeners->end())
-        {
-            ListenerEvent* lEvt = **_listenerItr;
-            SAFE_DELETE(lEvt);
-            ++*_listenerItr;
-        }
-        SAFE_DELETE(_listeners);
-    }
-    SAFE_DELETE(_listenerItr);
+#ifndef GP_USE_MEM_LEAK_DETECTION
+void* AnimationClip::operator new(size_t size)
+{
+    return MemoryPool::allocate(size);
 }
 
+void AnimationClip::operator delete(void* pointer)
+{
+    MemoryPool::deallocate(pointer);
+}
+#endif
+
 AnimationClip::ListenerEvent::ListenerEvent(Listener* listener, unsigned long eventTime)
+    : _listener(listener), _eventTime(eventTime)
 {
-    _listener = listener;
-    _eventTime = eventTime;
 }
 
-AnimationClip::ListenerEvent::~ListenerEvent()
+bool AnimationClip::compareListenerEvents(const ListenerEvent& e1, const ListenerEvent& e2)
 {
+    return e1._eventTime < e2._eventTime;
 }
 
 const char* AnimationClip::getId() const
@@ -170,6 +169,79 @@ float AnimationClip::getBlendWeight() const
     return _blendWeight;
 }
 
+void AnimationClip::setUpdateInterval(unsigned int interval)
+{
+    GP_ASSERT(interval > 0);
+
+    // Spread the evaluations of the clips of a controller sharing an interval over its updates.
+    GP_ASSERT(_animation && _animation->_controller);
+    _updateInterval = interval > 0 ? interval : 1;
+    _updateCount = _animation->_controller->_updatePhase++ % _updateInterval;
+}
+
+unsigned int AnimationClip::getUpdateInterval() const
+{
+    return _updateInterval;
+}
+
+void AnimationClip::setLod(unsigned int lod)
+{
+    _lod = lod;
+    _skippedChannels.clear();
+    if (_lod == 0)
+        return;
+
+    size_t channelCount = _animation->_channels.size();
+    _skippedChannels.resize(channelCount, false);
+    for (size_t i = 0; i < channelCount; i++)
+    {
+        GP_ASSERT(_animation->_channels[i] && _animation->_channels[i]->_target);
+        unsigned int skipLod = _animation->_channels[i]->_target->getAnimationSkipLod();
+        _skippedChannels[i] = skipLod > 0 && _lod >= skipLod;
+    }
+}
+
+unsigned int AnimationClip::getLod() const
+{
+    return _lod;
+}
+
+void AnimationClip::setFrozen(bool frozen)
+{
+    _frozen = frozen;
+}
+
+bool AnimationClip::isFrozen() const
+{
+    return _frozen;
+}
+
+void AnimationClip::setVisibilityNode(Node* node)
+{
+    if (node == _visibilityNode)
+        return;
+
+    SAFE_RELEASE(_visibilityNode);
+    _visibilityNode = node;
+    if (_visibilityNode)
+        _visibilityNode->addRef();
+}
+
+Node* AnimationClip::getVisibilityNode() const
+{
+    return _visibilityNode;
+}
+
+void AnimationClip::setPoseSharingEnabled(bool enabled)
+{
+    _poseSharing = enabled;
+}
+
+bool AnimationClip::isPoseSharingEnabled() const
+{
+    return _poseSharing;
+}
+
 void AnimationClip::setLoopBlendTime(float loopBlendTime)
 {
     _loopBlendTime = loopBlendTime;
@@ -281,90 +353,54 @@ void AnimationClip::crossFade(AnimationClip* clip, unsigned long duration)
 void AnimationClip::addListener(AnimationClip::Listener* listener, unsigned long eventTime)
 {
     GP_ASSERT(listener);
-    GP_ASSERT(eventTime < _activeDuration);
+    GP_ASSERT(eventTime <= _duration + _loopBlendTime);
 
-    ListenerEvent* listenerEvent = new ListenerEvent(listener, eventTime);
+    // Insert after the events at the same time, so they are triggered in the order they were added.
+    ListenerEvent listenerEvent(listener, eventTime);
+    std::vector<ListenerEvent>::iterator itr = std::upper_bound(_listeners.begin(), _listeners.end(), listenerEvent, compareListenerEvents);
+    unsigned int index = (unsigned int)(itr - _listeners.begin());
+    _listeners.insert(itr, listenerEvent);
 
-    if (!_listeners)
+    // The events before the cursor have been triggered when playing forward, and the ones after it when
+    // playing in reverse. If playing, keep the new event on the side of the cursor it belongs to;
+    // otherwise, the cursor will just be set the next time the clip gets played.
+    if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
     {
-        _listeners = new std::list<ListenerEvent*>;
-        _listeners->push_front(listenerEvent);
-
-        _listenerItr = new std::list<ListenerEvent*>::iterator;
-        if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-            *_listenerItr = _listeners->begin();
-    }
-    else
-    {
-        for (std::list<ListenerEvent*>::iterator itr = _listeners->begin(); itr != _listeners->end(); itr++)
-        {
-            GP_ASSERT(*itr);
-            if (eventTime < (*itr)->_eventTime)
-            {
-                itr = _listeners->insert(itr, listenerEvent);
-
-                // If playing, update the iterator if we need to.
-                // otherwise, it will just be set the next time the clip gets played.
-                if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-                {
-                    float currentTime = fmodf(_elapsedTime, (float)_duration);
-                    GP_ASSERT(**_listenerItr || *_listenerItr == _listeners->end());
-                    if ((_speed >= 0.0f && currentTime < eventTime && (*_listenerItr == _listeners->end() || eventTime < (**_listenerItr)->_eventTime)) || 
-                        (_speed <= 0 && currentTime > eventTime && (*_listenerItr == _listeners->begin() || eventTime > (**_listenerItr)->_eventTime)))
-                        *_listenerItr = itr;
-                }
-                return;
-            }
-        }
-        _listeners->push_back(listenerEvent);
+        if (index < _listenerCursor || (index == _listenerCursor && (float)eventTime < _listenerTime))
+            ++_listenerCursor;
     }
 }
 
 void AnimationClip::addBeginListener(AnimationClip::Listener* listener)
 {
-    if (!_beginListeners)
-        _beginListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _beginListeners->push_back(listener);
+    _beginListeners.push_back(listener);
 }
 
 void AnimationClip::addEndListener(AnimationClip::Listener* listener)
 {
-    if (!_endListeners)
-        _endListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _endListeners->push_back(listener);
+    _endListeners.push_back(listener);
 }
 
 void AnimationClip::addBeginListener(const char* function)
 {
-    if (!_scriptListeners)
-        _scriptListeners = new std::vector<ScriptListener*>;
-
     ScriptListener* listener = new ScriptListener(function);
-    _scriptListeners->push_back(listener);
+    _scriptListeners.push_back(listener);
     addBeginListener(listener);
 }
 
 void AnimationClip::addEndListener(const char* function)
 {
-    if (!_scriptListeners)
-        _scriptListeners = new std::vector<ScriptListener*>;
-
     ScriptListener* listener = new ScriptListener(function);
-    _scriptListeners->push_back(listener);
+    _scriptListeners.push_back(listener);
     addEndListener(listener);
 }
 
 void AnimationClip::addListener(const char* function, unsigned long eventTime)
 {
-    if (!_scriptListeners)
-        _scriptListeners = new std::vector<ScriptListener*>;
-
     ScriptListener* listener = new ScriptListener(function);
-    _scriptListeners->push_back(listener);
+    _scriptListeners.push_back(listener);
     addListener(listener, eventTime);
 }
 
@@ -378,26 +414,33 @@ bool AnimationClip::update(float elapsedTime)
     if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT))
     {
         // If the marked for removal bit is set, it means stop() was called on the AnimationClip at some point
-        // after the last update call. Reset the flag, and return true so the AnimationClip is removed from the 
+        // after the last update call. Return true so the AnimationClip is ended and removed from the 
         // running clips on the AnimationController.
-        onEnd();
         return true;
     }
 
+    // Elapsed times the listener events are triggered between, before wrapping
+    float previousTime;
+    float playedTime;
+
     if (!isClipStateBitSet(CLIP_IS_STARTED_BIT))
     {
         // Clip is just starting
         onBegin();
+        previousTime = _speed >= 0.0f ? 0.0f : (float)_activeDuration;
+        playedTime = _elapsedTime;
     }
     else
     {
         // Clip was already running
+        previousTime = _elapsedTime;
         _elapsedTime += elapsedTime * _speed;
+        playedTime = _elapsedTime;
 
         if (_repeatCount == REPEAT_INDEFINITE && _elapsedTime <= 0)
         {
             // Elapsed time is moving backwards, so wrap it back around the end when it falls below zero
-            _elapsedTime = _activeDuration + _elapsedTime;
+            _elapsedTime = _activeDuration + fmodf(_elapsedTime, (float)_activeDuration);
 
             // TODO: account for _loopBlendTime
         }
@@ -414,6 +457,7 @@ bool AnimationClip::update(float elapsedTime)
 
         // Ensure we end off at the endpoints of our clip (-speed==0, +speed==_duration)
         currentTime = _speed < 0.0f ? 0.0f : _duration;
+        notifyListeners(previousTime, _speed < 0.0f ? 0.0f : (float)_activeDuration, true);
     }
     else
     {
@@ -427,37 +471,7 @@ bool AnimationClip::update(float elapsedTime)
             // Animation is running normally.
             currentTime = fmodf(_elapsedTime, _duration + _loopBlendTime);
         }
-    }
-
-    // Notify any listeners of Animation events.
-    if (_listeners)
-    {
-        GP_ASSERT(_listenerItr);
-
-        if (_speed >= 0.0f)
-        {
-            while (*_listenerItr != _listeners->end() && _elapsedTime >= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                ++*_listenerItr;
-            }
-        }
-        else
-        {
-            while (*_listenerItr != _listeners->begin() && _elapsedTime <= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                --*_listenerItr;
-            }
-        }
+        notifyListeners(previousTime, playedTime, false);
     }
 
     // Add back in start time, and divide by the total animation's duration to get the actual percentage complete
@@ -519,7 +533,17 @@ bool AnimationClip::update(float elapsedTime)
         }
     }
     
-    // Evaluate this clip.
+    // A clip that has ended is always evaluated, so that its final values are applied.
+    bool ended = isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT);
+    if (!ended && !isEvaluated())
+    {
+        queueLastValues();
+        return false;
+    }
+
+    // Evaluate this clip. The values are applied to the targets once all the running clips have been evaluated.
+    AnimationController* controller = _animation->_controller;
+    GP_ASSERT(controller);
     Animation::Channel* channel = NULL;
     AnimationValue* value = NULL;
     AnimationTarget* target = NULL;
@@ -527,8 +551,22 @@ bool AnimationClip::update(float elapsedTime)
     float percentageStart = (float)_startTime / (float)_animation->_duration;
     float percentageEnd = (float)_endTime / (float)_animation->_duration;
     float percentageBlend = (float)_loopBlendTime / (float)_animation->_duration;
+
+    // Reuse the pose of an identical clip evaluated at the same time during this update.
+    float evaluationTime[] = { percentComplete, percentageStart, percentageEnd, percentageBlend };
+    unsigned int firstResult = (unsigned int)controller->_results.size();
+    if (_poseSharing && controller->queueSharedPose(this, evaluationTime))
+    {
+        storeLastValues(firstResult);
+        return ended;
+    }
+
+    bool skipChannels = _lod > 0 && _skippedChannels.size() == channelCount;
     for (size_t i = 0; i < channelCount; i++)
     {
+        if (skipChannels && _skippedChannels[i])
+            continue;
+
         channel = _animation->_channels[i];
         GP_ASSERT(channel);
         target = channel->_target;
@@ -536,22 +574,140 @@ bool AnimationClip::update(float elapsedTime)
         value = _values[i];
         GP_ASSERT(value);
 
-        // Evaluate the point on Curve
+        // Evaluate the point on Curve into the controller's result buffer.
         GP_ASSERT(channel->getCurve());
-        channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value);
+        float* result = controller->queueResult(target, channel->_propertyId, value, _blendWeight);
+        channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, result, &_keyframeCursors[i]);
+    }
 
-        // Set the animation value on the target property.
-        target->setAnimationPropertyValue(channel->_propertyId, value, _blendWeight);
+    if (_poseSharing)
+        controller->addSharedPose(this, evaluationTime, firstResult);
+    storeLastValues(firstResult);
+
+    return ended;
+}
+
+void AnimationClip::storeLastValues(unsigned int firstResult)
+{
+    AnimationController* controller = _animation->_controller;
+    GP_ASSERT(controller);
+
+    // The results of an evaluation are queued in channel order, skipping the channels skipped at the level of detail.
+    size_t channelCount = _animation->_channels.size();
+    bool skipChannels = _lod > 0 && _skippedChannels.size() == channelCount;
+    _lastChannels.clear();
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        if (!skipChannels || !_skippedChannels[i])
+            _lastChannels.push_back((unsigned int)i);
     }
+    GP_ASSERT(_lastChannels.size() == controller->_results.size() - firstResult);
 
-    // When ended. Probably should move to it's own method so we can call it when the clip is ended early.
-    if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT))
+    if (firstResult < controller->_results.size())
+        _lastValues.assign(controller->_resultValues.begin() + controller->_results[firstResult].offset, controller->_resultValues.end());
+    else
+        _lastValues.clear();
+}
+
+void AnimationClip::queueLastValues()
+{
+    AnimationController* controller = _animation->_controller;
+    GP_ASSERT(controller);
+
+    size_t offset = 0;
+    for (size_t i = 0, count = _lastChannels.size(); i < count; ++i)
     {
-        onEnd();
-        return true;
+        unsigned int index = _lastChannels[i];
+        Animation::Channel* channel = _animation->_channels[index];
+        AnimationValue* value = _values[index];
+        GP_ASSERT(offset + value->_componentCount <= _lastValues.size());
+        float* result = controller->queueResult(channel->_target, channel->_propertyId, value, _blendWeight);
+        memcpy(result, &_lastValues[offset], sizeof(float) * value->_componentCount);
+        offset += value->_componentCount;
+    }
+}
+
+void AnimationClip::notifyListeners(float fromTime, float toTime, bool ending)
+{
+    // Listener event times are within a loop of the clip. A time on a loop boundary belongs to the loop
+    // playback is moving into, except at the end of the active duration, which belongs to the last loop.
+    bool reverse = _speed < 0.0f;
+    float loopDuration = _duration + _loopBlendTime;
+    float fromLoop = 0.0f;
+    float toLoop = 0.0f;
+    if (loopDuration > 0.0f)
+    {
+        fromLoop = reverse ? ceilf(fromTime / loopDuration) - 1.0f : floorf(fromTime / loopDuration);
+        toLoop = reverse != ending ? ceilf(toTime / loopDuration) - 1.0f : floorf(toTime / loopDuration);
+    }
+    float loopsCrossed = reverse ? fromLoop - toLoop : toLoop - fromLoop;
+    float loopTime = toTime - toLoop * loopDuration;
+
+    // Notify any listeners of Animation events. The cursor is moved before each call back,
+    // since a listener may add more listeners to the clip.
+    if (!reverse)
+    {
+        for (; loopsCrossed > 0.0f; loopsCrossed -= 1.0f)
+        {
+            // Trigger the rest of the loop's events, then start over on the next loop.
+            _listenerTime = loopDuration;
+            while (_listenerCursor < _listeners.size())
+            {
+                Listener* listener = _listeners[_listenerCursor++]._listener;
+                GP_ASSERT(listener);
+                listener->animationEvent(this, Listener::TIME);
+            }
+            _listenerCursor = 0;
+        }
+
+        _listenerTime = loopTime;
+        while (_listenerCursor < _listeners.size() && loopTime >= (float)_listeners[_listenerCursor]._eventTime)
+        {
+            Listener* listener = _listeners[_listenerCursor++]._listener;
+            GP_ASSERT(listener);
+            listener->animationEvent(this, Listener::TIME);
+        }
     }
+    else
+    {
+        for (; loopsCrossed > 0.0f; loopsCrossed -= 1.0f)
+        {
+            // Trigger the rest of the loop's events, then start over at the end of the previous loop.
+            _listenerTime = 0.0f;
+            while (_listenerCursor > 0)
+            {
+                Listener* listener = _listeners[--_listenerCursor]._listener;
+                GP_ASSERT(listener);
+                listener->animationEvent(this, Listener::TIME);
+            }
+            _listenerCursor = (unsigned int)_listeners.size();
+        }
 
-    return false;
+        _listenerTime = loopTime;
+        while (_listenerCursor > 0 && loopTime <= (float)_listeners[_listenerCursor - 1]._eventTime)
+        {
+            Listener* listener = _listeners[--_listenerCursor]._listener;
+            GP_ASSERT(listener);
+            listener->animationEvent(this, Listener::TIME);
+        }
+    }
+}
+
+bool AnimationClip::isEvaluated()
+{
+    GP_ASSERT(_animation && _animation->_controller);
+
+    if (_frozen || (_visibilityNode && !_animation->_controller->isNodeVisible(_visibilityNode)))
+    {
+        // Evaluate as soon as the clip is unfrozen.
+        _updateCount = _updateInterval - 1;
+        return false;
+    }
+
+    if (++_updateCount < _updateInterval)
+        return false;
+    _updateCount = 0;
+    return true;
 }
 
 void AnimationClip::onBegin()
@@ -560,31 +716,26 @@ void AnimationClip::onBegin()
 
     // Initialize animation to play.
     setClipStateBit(CLIP_IS_STARTED_BIT);
+    _lastChannels.clear();
+    _lastValues.clear();
     if (_speed >= 0)
     {
         _elapsedTime = (Game::getGameTime() - _timeStarted) * _speed;
-
-        if (_listeners)
-            *_listenerItr = _listeners->begin();
+        _listenerCursor = 0;
+        _listenerTime = 0.0f;
     }
     else
     {
         _elapsedTime = _activeDuration + (Game::getGameTime() - _timeStarted) * _speed;
-
-        if (_listeners)
-            *_listenerItr = _listeners->end();
+        _listenerCursor = (unsigned int)_listeners.size();
+        _listenerTime = _duration + _loopBlendTime;
     }
     
     // Notify begin listeners if any.
-    if (_beginListeners)
+    for (size_t i = 0; i < _beginListeners.size(); i++)
     {
-        std::vector<Listener*>::iterator listener = _beginListeners->begin();
-        while (listener != _beginListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::BEGIN);
-            listener++;
-        }
+        GP_ASSERT(_beginListeners[i]);
+        _beginListeners[i]->animationEvent(this, Listener::BEGIN);
     }
 
     release();
@@ -598,15 +749,10 @@ void AnimationClip::onEnd()
     resetClipStateBit(CLIP_ALL_BITS);
 
     // Notify end listeners if any.
-    if (_endListeners)
+    for (size_t i = 0; i < _endListeners.size(); i++)
     {
-        std::vector<Listener*>::iterator listener = _endListeners->begin();
-        while (listener != _endListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::END);
-            listener++;
-        }
+        GP_ASSERT(_endListeners[i]);
+        _endListeners[i]->animationEvent(this, Listener::END);
     }
 
     release();
@@ -634,6 +780,9 @@ AnimationClip* AnimationClip::clone(Animation* animation) const
     newClip->setSpeed(getSpeed());
     newClip->setRepeatCount(getRepeatCount());
     newClip->setBlendWeight(getBlendWeight());
+    newClip->setUpdateInterval(getUpdateInterval());
+    newClip->setFrozen(isFrozen());
+    newClip->setPoseSharingEnabled(isPoseSharingEnabled());
     
     size_t size = _values.size();
     newClip->_values.resize(size, NULL);
@@ -648,18 +797,19 @@ AnimationClip* AnimationClip::clone(Animation* animation) const
             *newClip->_values[i] = *_values[i];
         }
     }
+    newClip->_keyframeCursors.resize(size, 0);
+    newClip->setLod(getLod());
     return newClip;
 }
 
 AnimationClip::ScriptListener::ScriptListener(const std::string& function)
+    : function(Game::getInstance()->getScriptController()->loadUrl(function.c_str()).c_str())
 {
-    // Store the function name.
-    this->function = Game::getInstance()->getScriptController()->loadUrl(function.c_str());
 }
 
 void AnimationClip::ScriptListener::animationEvent(AnimationClip* clip, EventType type)
 {
-    Game::getInstance()->getScriptController()->executeFunction<void>(function.c_str(), "<AnimationClip>[AnimationClip::Listener::EventType]", clip, type);
+    function.call<void>(ScriptFunction::Object("AnimationClip", clip), ScriptFunction::Enum("AnimationClip::Listener::EventType", type));
 }
 
 
@@ -5,12 +5,14 @@
 #include "AnimationValue.h"
 #include "Curve.h"
 #include "Animation.h"
+#include "ScriptFunction.h"
 
 namespace gameplay
 {
 
 class Animation;
 class AnimationValue;
+class Node;
 class ScriptListener;
 
 /**
@@ -20,6 +22,7 @@ class AnimationClip : public Ref
 {
     friend class AnimationController;
     friend class Animation;
+    friend class SceneSnapshot;
 
 public:
 
@@ -178,6 +181,100 @@ public:
      */
     float getBlendWeight() const;
 
+    /**
+     * Sets the number of animation updates between evaluations of the AnimationClip.
+     *
+     * The clip keeps advancing in time on every update, but its channels are only evaluated
+     * on one update out of the interval, and its targets hold their values in between. This
+     * lowers the cost of distant characters. Clips blending on the same targets should use
+     * the same interval. The default interval is 1, evaluating the clip on every update.
+     *
+     * @param interval The number of updates between evaluations (at least 1).
+     */
+    void setUpdateInterval(unsigned int interval);
+
+    /**
+     * Gets the number of animation updates between evaluations of the AnimationClip.
+     *
+     * @return The update interval of the clip.
+     */
+    unsigned int getUpdateInterval() const;
+
+    /**
+     * Sets the level of detail of the AnimationClip.
+     *
+     * Channels whose target is skipped at this level of detail are not evaluated (see
+     * AnimationTarget::getAnimationSkipLod). For skeletons, level 1 skips the leaf joints,
+     * level 2 skips the joints above them too, and so on. The default level is 0, evaluating
+     * all the channels. The channels to skip are determined when the level is set, so it
+     * must be set again if the joint hierarchy changes.
+     *
+     * @param lod The level of detail.
+     */
+    void setLod(unsigned int lod);
+
+    /**
+     * Gets the level of detail of the AnimationClip.
+     *
+     * @return The level of detail of the clip.
+     */
+    unsigned int getLod() const;
+
+    /**
+     * Freezes the AnimationClip, or unfreezes it.
+     *
+     * A frozen clip keeps advancing in time and firing its listeners, but is not evaluated,
+     * so its targets hold their last values. This is meant for characters that are off screen.
+     *
+     * @param frozen true to freeze the clip, false to unfreeze it.
+     */
+    void setFrozen(bool frozen);
+
+    /**
+     * Checks if the AnimationClip is frozen.
+     *
+     * @return true if the clip is frozen, false otherwise.
+     */
+    bool isFrozen() const;
+
+    /**
+     * Sets the node whose visibility decides whether the AnimationClip is evaluated.
+     *
+     * When the AnimationController has a set of visible nodes (see
+     * AnimationController::setVisibleNodes), the clip is frozen on the updates where
+     * this node is not in the set. This is typically the node of the character's model.
+     *
+     * @param node The visibility node, or NULL for the clip to ignore the visible nodes.
+     */
+    void setVisibilityNode(Node* node);
+
+    /**
+     * Gets the node whose visibility decides whether the AnimationClip is evaluated.
+     *
+     * @return The visibility node, or NULL if there is none.
+     */
+    Node* getVisibilityNode() const;
+
+    /**
+     * Enables or disables pose sharing for the AnimationClip.
+     *
+     * When several clips with pose sharing enabled play the same curves at the same time
+     * during an update, only the first one is evaluated and the others reuse its values.
+     * The curves of an animation are shared by its clones (see Node::clone), so a crowd of
+     * cloned characters playing the same clip started on the same update evaluates a single
+     * pose. Each character keeps its own root transform, joints and matrix palette.
+     *
+     * @param enabled true to enable pose sharing, false to disable it.
+     */
+    void setPoseSharingEnabled(bool enabled);
+
+    /**
+     * Checks if pose sharing is enabled for the AnimationClip.
+     *
+     * @return true if pose sharing is enabled, false otherwise.
+     */
+    bool isPoseSharingEnabled() const;
+
     /**
      * Sets the time (in milliseconds) to append to the clip's active duration
      * to use for blending the end points of the clip when looping.
@@ -245,7 +342,8 @@ public:
      * @param listener The listener to be called when the AnimationClip reaches the 
      *      specified time in its playback.
      * @param eventTime The time the listener will be called during the playback of the AnimationClip. 
-     *      Must be between 0 and the duration of the AnimationClip.
+     *      Must be between 0 and the duration of the AnimationClip. The time is within a loop of the
+     *      clip, so a repeating clip calls the listener on each loop.
      */
     void addListener(AnimationClip::Listener* listener, unsigned long eventTime);
 
@@ -276,10 +374,32 @@ public:
      * @param function The Lua script function to be called when an AnimationClip reaches the 
      *      specified time in its playback.
      * @param eventTime The time the listener will be called during the playback of the AnimationClip. 
-     *      Must be between 0 and the duration of the AnimationClip.
+     *      Must be between 0 and the duration of the AnimationClip. The time is within a loop of the
+     *      clip, so a repeating clip calls the listener on each loop.
      */
     void addListener(const char* function, unsigned long eventTime);
 
+#ifndef GP_USE_MEM_LEAK_DETECTION
+    /**
+     * Allocates animation clips from the current memory pool.
+     *
+     * @param size The size of the object to allocate.
+     *
+     * @return The allocated memory.
+     * @see MemoryPool
+     * @script{ignore}
+     */
+    static void* operator new(size_t size);
+
+    /**
+     * Returns the memory of animation clips to the memory pool it was allocated from.
+     *
+     * @param pointer The memory to free.
+     * @script{ignore}
+     */
+    static void operator delete(void* pointer);
+#endif
+
 private:
     
     static const unsigned char CLIP_IS_PLAYING_BIT = 0x01;             // Bit representing whether AnimationClip is a running clip in AnimationController
@@ -304,20 +424,15 @@ private:
          */
         ListenerEvent(Listener* listener, unsigned long eventTime);
 
-        /**
-         * Destructor.
-         */
-        ~ListenerEvent();
-
-        /**
-         * Hidden copy assignment operator.
-         */
-        ListenerEvent& operator=(const ListenerEvent&);
-
         Listener* _listener;        // This listener to call back when this event is triggered.
         unsigned long _eventTime;   // The time at which the listener will be called back at during the playback of the AnimationClip.
     };
 
+    /**
+     * Orders listener events by event time.
+     */
+    static bool compareListenerEvents(const ListenerEvent& e1, const ListenerEvent& e2);
+
     /**
      * Listener implementation for script callbacks.
      */
@@ -334,7 +449,7 @@ private:
         void animationEvent(AnimationClip* clip, EventType type);
 
         /** The function to call back when an animation event occurs. */
-        std::string function;
+        ScriptFunction function;
     };
 
     /**
@@ -363,10 +478,40 @@ private:
     AnimationClip& operator=(const AnimationClip&);
 
     /**
-     * Updates the animation with the elapsed time.
+     * Updates the animation with the elapsed time, and queues the evaluated values of its
+     * channels on the AnimationController.
+     *
+     * @return true if the clip has ended, in which case the controller calls onEnd() once
+     *      the queued values have been applied.
      */
     bool update(float elapsedTime);
 
+    /**
+     * Triggers the listener events passed while playing from one elapsed time to another, on each
+     * loop it goes through.
+     *
+     * @param fromTime The elapsed time of the previous update.
+     * @param toTime The elapsed time of this update, before it is wrapped around the ends of the clip.
+     * @param ending true if toTime is the end of the clip's active duration.
+     */
+    void notifyListeners(float fromTime, float toTime, bool ending);
+
+    /**
+     * Determines whether the clip's channels are evaluated on the current update.
+     */
+    bool isEvaluated();
+
+    /**
+     * Keeps a copy of the values queued by an evaluation, starting at the specified result of the controller.
+     */
+    void storeLastValues(unsigned int firstResult);
+
+    /**
+     * Queues the values of the last evaluation again, with the current blend weight, for an update where
+     * the clip is not evaluated, so that the targets it blends with other clips keep their balance.
+     */
+    void queueLastValues();
+
     /**
      * Handles when the AnimationClip begins.
      */
@@ -418,11 +563,22 @@ private:
     unsigned long _crossFadeOutDuration;                // The duration of the cross fade.
     float _blendWeight;                                 // The clip's blendweight.
     std::vector<AnimationValue*> _values;               // AnimationValue holder.
-    std::vector<Listener*>* _beginListeners;            // Collection of begin listeners on the clip.
-    std::vector<Listener*>* _endListeners;              // Collection of end listeners on the clip.
-    std::list<ListenerEvent*>* _listeners;              // Ordered collection of listeners on the clip.
-    std::list<ListenerEvent*>::iterator* _listenerItr;  // Iterator that points to the next listener event to be triggered.
-    std::vector<ScriptListener*>* _scriptListeners;     // Collection of listeners that are bound to Lua script functions.
+    std::vector<unsigned int> _keyframeCursors;         // The last keyframe evaluated on the curve of each channel.
+    unsigned int _updateInterval;                       // The number of updates between evaluations.
+    unsigned int _updateCount;                          // The number of updates since the last evaluation.
+    unsigned int _lod;                                  // The level of detail of the clip.
+    std::vector<bool> _skippedChannels;                 // Whether each channel is skipped at the level of detail.
+    std::vector<unsigned int> _lastChannels;            // The channels queued by the last evaluation.
+    std::vector<float> _lastValues;                     // The values queued by the last evaluation.
+    bool _frozen;                                       // Whether the clip is frozen.
+    Node* _visibilityNode;                              // The node whose visibility decides whether the clip is evaluated.
+    bool _poseSharing;                                  // Whether the clip shares its evaluated pose with identical clips.
+    std::vector<Listener*> _beginListeners;             // Collection of begin listeners on the clip.
+    std::vector<Listener*> _endListeners;               // Collection of end listeners on the clip.
+    std::vector<ListenerEvent> _listeners;              // The listener events on the clip, sorted by event time.
+    unsigned int _listenerCursor;                       // The index of the next listener event to trigger (one past it when playing in reverse).
+    float _listenerTime;                                // The time within the current loop the listener events were triggered up to.
+    std::vector<ScriptListener*> _scriptListeners;      // Collection of listeners that are bound to Lua script functions.
 };
 
 }
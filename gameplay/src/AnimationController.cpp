@@ -2,12 +2,18 @@
 #include "AnimationController.h"
 #include "Game.h"
 #include "Curve.h"
+#include "MathUtil.h"
+#include "FramePacer.h"
+
+// The number of components of the pose of a transform: the scale, the rotation and the translation.
+#define TRANSFORM_POSE_SIZE 10
 
 namespace gameplay
 {
 
 AnimationController::AnimationController()
-    : _state(STOPPED)
+    : _state(STOPPED), _updating(false), _visibilityCulling(false), _blendedVectorData(NULL), _blendedVectorCapacity(0),
+      _updatePhase(0)
 {
 }
 
@@ -17,16 +23,32 @@ AnimationController::~AnimationController()
 
 void AnimationController::stopAllAnimations() 
 {
-    std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
-    while (clipIter != _runningClips.end())
+    for (size_t i = 0, count = _runningClips.size(); i < count; ++i)
     {
-        AnimationClip* clip = *clipIter;
-        GP_ASSERT(clip);
-        clip->stop();
-        clipIter++;
+        AnimationClip* clip = _runningClips[i];
+        if (clip)
+            clip->stop();
     }
 }
 
+void AnimationController::setVisibleNodes(const std::vector<Node*>& nodes)
+{
+    _visibleNodes = nodes;
+    std::sort(_visibleNodes.begin(), _visibleNodes.end());
+    _visibilityCulling = true;
+}
+
+void AnimationController::clearVisibleNodes()
+{
+    _visibleNodes.clear();
+    _visibilityCulling = false;
+}
+
+bool AnimationController::isNodeVisible(Node* node) const
+{
+    return !_visibilityCulling || std::binary_search(_visibleNodes.begin(), _visibleNodes.end(), node);
+}
+
 AnimationController::State AnimationController::getState() const
 {
     return _state;
@@ -39,11 +61,9 @@ void AnimationController::initialize()
 
 void AnimationController::finalize()
 {
-    std::list<AnimationClip*>::iterator itr = _runningClips.begin();
-    for ( ; itr != _runningClips.end(); itr++)
+    for (size_t i = 0, count = _runningClips.size(); i < count; ++i)
     {
-        AnimationClip* clip = *itr;
-        SAFE_RELEASE(clip);
+        SAFE_RELEASE(_runningClips[i]);
     }
     _runningClips.clear();
     _state = STOPPED;
@@ -70,23 +90,26 @@ void AnimationController::schedule(AnimationClip* clip)
     }
 
     GP_ASSERT(clip);
+    GP_ASSERT(clip->_animation);
+
+    // Read the curves of lazily loaded animations before they are first evaluated.
+    clip->_animation->loadCurves();
+
     clip->addRef();
     _runningClips.push_back(clip);
 }
 
 void AnimationController::unschedule(AnimationClip* clip)
 {
-    std::list<AnimationClip*>::iterator clipItr = _runningClips.begin();
-    while (clipItr != _runningClips.end())
+    std::vector<AnimationClip*>::iterator itr = std::find(_runningClips.begin(), _runningClips.end(), clip);
+    if (itr != _runningClips.end())
     {
-        AnimationClip* rClip = (*clipItr);
-        if (rClip == clip)
-        {
-            _runningClips.erase(clipItr);
-            SAFE_RELEASE(clip);
-            break;
-        }
-        clipItr++;
+        // Clear the slot while updating, since the update is iterating over the clips.
+        if (_updating)
+            *itr = NULL;
+        else
+            _runningClips.erase(itr);
+        SAFE_RELEASE(clip);
     }
 
     if (_runningClips.empty())
@@ -97,40 +120,361 @@ void AnimationController::update(float elapsedTime)
 {
     if (_state != RUNNING)
         return;
-    
+
+    // The running clips change what is drawn, even when they don't animate transforms.
+    FramePacer::wake();
+
     Transform::suspendTransformChanged();
 
-    // Loop through running clips and call update() on them.
-    std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
-    while (clipIter != _runningClips.end())
+    // Update the running clips. Clips that are scheduled or restarted during the update
+    // are added to the end, so they are updated in the same pass.
+    _updating = true;
+    for (size_t i = 0; i < _runningClips.size(); ++i)
     {
-        AnimationClip* clip = (*clipIter);
-        GP_ASSERT(clip);
-        clip->addRef();
+        AnimationClip* clip = _runningClips[i];
+        if (clip == NULL)
+            continue;
+
         if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_RESTARTED_BIT))
         {   // If the CLIP_IS_RESTARTED_BIT is set, we should end the clip and 
-            // move it from where it is in the running clips list to the back.
+            // move it from where it is in the running clips to the back.
             clip->onEnd();
             clip->setClipStateBit(AnimationClip::CLIP_IS_PLAYING_BIT);
+            _runningClips[i] = NULL;
             _runningClips.push_back(clip);
-            clipIter = _runningClips.erase(clipIter);
-        }
-        else if (clip->update(elapsedTime))
-        {
-            clip->release();
-            clipIter = _runningClips.erase(clipIter);
+            continue;
         }
-        else
+
+        // Keep the clip alive until its queued values have been applied.
+        clip->addRef();
+        _updatedClips.push_back(clip);
+        if (clip->update(elapsedTime) && _runningClips[i] == clip)
         {
-            clipIter++;
+            // The clip has ended. It is removed from the running clips now, and ended once its final values are applied.
+            _runningClips[i] = NULL;
+            _endedClips.push_back(clip);
         }
-        clip->release();
     }
 
+    // Apply the evaluated values once all the clips have been updated.
+    applyResults();
+
+    for (size_t i = 0, count = _endedClips.size(); i < count; ++i)
+    {
+        _endedClips[i]->onEnd();
+        SAFE_RELEASE(_endedClips[i]);
+    }
+    _endedClips.clear();
+    for (size_t i = 0, count = _updatedClips.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_updatedClips[i]);
+    }
+    _updatedClips.clear();
+    _sharedPoses.clear();
+    _updating = false;
+
+    _runningClips.erase(std::remove(_runningClips.begin(), _runningClips.end(), (AnimationClip*)NULL), _runningClips.end());
+
     Transform::resumeTransformChanged();
 
     if (_runningClips.empty())
         _state = IDLE;
 }
 
+float* AnimationController::queueResult(AnimationTarget* target, int propertyId, AnimationValue* value, float blendWeight)
+{
+    GP_ASSERT(target);
+    GP_ASSERT(value);
+
+    Result result;
+    result.target = target;
+    result.propertyId = propertyId;
+    result.value = value;
+    result.offset = (unsigned int)_resultValues.size();
+    result.blendWeight = blendWeight;
+    result.order = (unsigned int)_results.size();
+    _results.push_back(result);
+
+    _resultValues.resize(result.offset + value->_componentCount);
+    return &_resultValues[result.offset];
+}
+
+void AnimationController::applyResults()
+{
+    // Group the values by target, keeping the order the clips were updated in within each target.
+    std::sort(_results.begin(), _results.end(), compareResults);
+
+    for (size_t i = 0, count = _results.size(); i < count; )
+    {
+        AnimationTarget* target = _results[i].target;
+        size_t end = i + 1;
+        while (end < count && _results[end].target == target)
+        {
+            ++end;
+        }
+        _resultRanges.push_back(std::make_pair(i, end));
+        i = end;
+    }
+
+    // Blend the values of each transform into a pose, starting from its current scale, rotation and translation.
+    for (size_t r = 0, rangeCount = _resultRanges.size(); r < rangeCount; ++r)
+    {
+        AnimationTarget* target = _results[_resultRanges[r].first].target;
+        Transform* transform = target->_targetType == AnimationTarget::TRANSFORM ? static_cast<Transform*>(target) : NULL;
+        if (transform == NULL || transform->isStatic())
+        {
+            _rangePoses.push_back(-1);
+            continue;
+        }
+
+        _rangePoses.push_back((int)_poseTransforms.size());
+        _poseTransforms.push_back(transform);
+        const Vector3& scale = transform->getScale();
+        const Quaternion& rotation = transform->getRotation();
+        const Vector3& translation = transform->getTranslation();
+        float pose[TRANSFORM_POSE_SIZE] = { scale.x, scale.y, scale.z, rotation.x, rotation.y, rotation.z, rotation.w, translation.x, translation.y, translation.z };
+        _poseValues.insert(_poseValues.end(), pose, pose + TRANSFORM_POSE_SIZE);
+        _poseDirtyBits.push_back(0);
+    }
+
+    // A round blends at most a scale and a translation per target. The arrays are aligned for MathUtil::lerpArray.
+    unsigned int vectorCapacity = (unsigned int)_resultRanges.size() * 2;
+    if (vectorCapacity > _blendedVectorCapacity)
+    {
+        _blendedVectorCapacity = vectorCapacity;
+        _blendedVectors.resize(vectorCapacity * 12 + 3);
+        _blendedVectorData = (float*)(((size_t)&_blendedVectors[0] + 15) & ~(size_t)15);
+    }
+
+    // Each round applies the next value of every target, so a target blends at most one rotation per round.
+    bool batchRotations = Curve::getRotationInterpolation() == Curve::ROTATION_NLERP;
+    bool applied = true;
+    while (applied)
+    {
+        applied = false;
+        for (size_t r = 0, rangeCount = _resultRanges.size(); r < rangeCount; ++r)
+        {
+            size_t& j = _resultRanges[r].first;
+            size_t end = _resultRanges[r].second;
+            for (; j < end; ++j)
+            {
+                // A later value applied with full weight to the same property replaces this one.
+                bool replaced = false;
+                for (size_t k = j + 1; k < end && !replaced; ++k)
+                {
+                    replaced = _results[k].propertyId == _results[j].propertyId && _results[k].blendWeight >= 1.0f;
+                }
+                if (!replaced)
+                    break;
+            }
+            if (j == end)
+                continue;
+
+            const Result& result = _results[j++];
+            applied = true;
+
+            int pose = _rangePoses[r];
+            if (pose < 0)
+            {
+                AnimationValue* value = result.value;
+                memcpy(value->_value, &_resultValues[result.offset], sizeof(float) * value->_componentCount);
+                result.target->setAnimationPropertyValue(result.propertyId, value, result.blendWeight);
+                continue;
+            }
+
+            const signed char* layout = Transform::getAnimationPoseLayout(result.propertyId);
+            if (layout == NULL)
+                continue;
+
+            const float* value = &_resultValues[result.offset];
+            unsigned int poseOffset = (unsigned int)pose * TRANSFORM_POSE_SIZE;
+            char& dirtyBits = _poseDirtyBits[pose];
+            if (queueBlendedVector(poseOffset, layout, value, result.blendWeight))
+                dirtyBits |= Transform::DIRTY_SCALE;
+            if (queueBlendedVector(poseOffset + 7, layout + 7, value, result.blendWeight))
+                dirtyBits |= Transform::DIRTY_TRANSLATION;
+            if (layout[3] >= 0)
+            {
+                float* rotation = &_poseValues[poseOffset + 3];
+                const float* blended = value + layout[3];
+                if (batchRotations)
+                {
+                    _blendedPoses.push_back((unsigned int)pose);
+                    _blendedRotations.insert(_blendedRotations.end(), rotation, rotation + 4);
+                    _blendedValues.insert(_blendedValues.end(), blended, blended + 4);
+                    _blendedWeights.push_back(result.blendWeight);
+                }
+                else
+                {
+                    Quaternion q;
+                    Quaternion::slerp(Quaternion(rotation), Quaternion(blended[0], blended[1], blended[2], blended[3]), result.blendWeight, &q);
+                    rotation[0] = q.x;
+                    rotation[1] = q.y;
+                    rotation[2] = q.z;
+                    rotation[3] = q.w;
+                }
+                dirtyBits |= Transform::DIRTY_ROTATION;
+            }
+        }
+        applyBlendedVectors();
+        applyBlendedRotations();
+    }
+
+    // Set each pose on its transform once, so that it is marked dirty once.
+    for (size_t i = 0, count = _poseTransforms.size(); i < count; ++i)
+    {
+        _poseTransforms[i]->setAnimationPose(&_poseValues[i * TRANSFORM_POSE_SIZE], _poseDirtyBits[i]);
+    }
+
+    _poseTransforms.clear();
+    _poseValues.clear();
+    _poseDirtyBits.clear();
+    _rangePoses.clear();
+    _resultRanges.clear();
+    _results.clear();
+    _resultValues.clear();
+}
+
+bool AnimationController::queueBlendedVector(unsigned int poseOffset, const signed char* layout, const float* value, float blendWeight)
+{
+    GP_ASSERT(layout);
+    GP_ASSERT(value);
+
+    if (layout[0] < 0 && layout[1] < 0 && layout[2] < 0)
+        return false;
+
+    GP_ASSERT(_blendedVectorOffsets.size() < _blendedVectorCapacity);
+    unsigned int i = (unsigned int)_blendedVectorOffsets.size() * 4;
+    float* start = _blendedVectorData + i;
+    float* end = _blendedVectorData + _blendedVectorCapacity * 4 + i;
+    float* weight = _blendedVectorData + _blendedVectorCapacity * 8 + i;
+    const float* pose = &_poseValues[poseOffset];
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        // The components the property does not set blend towards themselves.
+        start[c] = pose[c];
+        end[c] = layout[c] >= 0 ? value[layout[c]] : pose[c];
+        weight[c] = blendWeight;
+    }
+    start[3] = end[3] = weight[3] = 0.0f;
+    _blendedVectorOffsets.push_back(poseOffset);
+    return true;
+}
+
+void AnimationController::applyBlendedVectors()
+{
+    if (_blendedVectorOffsets.empty())
+        return;
+
+    unsigned int count = (unsigned int)_blendedVectorOffsets.size();
+    float* start = _blendedVectorData;
+    MathUtil::lerpArray(start, start + _blendedVectorCapacity * 4, start + _blendedVectorCapacity * 8, start, count * 4);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float* pose = &_poseValues[_blendedVectorOffsets[i]];
+        pose[0] = start[i * 4];
+        pose[1] = start[i * 4 + 1];
+        pose[2] = start[i * 4 + 2];
+    }
+
+    _blendedVectorOffsets.clear();
+}
+
+void AnimationController::applyBlendedRotations()
+{
+    if (_blendedPoses.empty())
+        return;
+
+    unsigned int count = (unsigned int)_blendedPoses.size();
+    Quaternion::nlerp(&_blendedRotations[0], &_blendedValues[0], &_blendedWeights[0], &_blendedRotations[0], count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        memcpy(&_poseValues[_blendedPoses[i] * TRANSFORM_POSE_SIZE + 3], &_blendedRotations[i * 4], sizeof(float) * 4);
+    }
+
+    _blendedPoses.clear();
+    _blendedRotations.clear();
+    _blendedValues.clear();
+    _blendedWeights.clear();
+}
+
+bool AnimationController::compareResults(const Result& r1, const Result& r2)
+{
+    if (r1.target != r2.target)
+        return r1.target < r2.target;
+    return r1.order < r2.order;
+}
+
+bool AnimationController::queueSharedPose(AnimationClip* clip, const float* time)
+{
+    GP_ASSERT(clip && clip->_animation);
+    GP_ASSERT(time);
+
+    std::vector<Animation::Channel*>& channels = clip->_animation->_channels;
+    if (channels.empty())
+        return false;
+
+    // Find a pose of the same curves at the same time.
+    typedef std::multimap<Curve*, SharedPose>::const_iterator PoseIterator;
+    std::pair<PoseIterator, PoseIterator> range = _sharedPoses.equal_range(channels[0]->_curve);
+    const SharedPose* pose = NULL;
+    for (PoseIterator itr = range.first; itr != range.second; ++itr)
+    {
+        if (memcmp(itr->second.time, time, sizeof(itr->second.time)) == 0 && isSamePose(itr->second.clip, clip))
+        {
+            pose = &itr->second;
+            break;
+        }
+    }
+    if (pose == NULL)
+        return false;
+
+    // Queue a copy of each of its values for the corresponding channel of the clip.
+    bool skipChannels = clip->_lod > 0 && clip->_skippedChannels.size() == channels.size();
+    unsigned int result = pose->firstResult;
+    for (size_t i = 0, count = channels.size(); i < count; ++i)
+    {
+        if (skipChannels && clip->_skippedChannels[i])
+            continue;
+
+        GP_ASSERT(result < pose->firstResult + pose->resultCount);
+        unsigned int offset = _results[result++].offset;
+        AnimationValue* value = clip->_values[i];
+        float* dst = queueResult(channels[i]->_target, channels[i]->_propertyId, value, clip->_blendWeight);
+        memcpy(dst, &_resultValues[offset], sizeof(float) * value->_componentCount);
+    }
+    return true;
+}
+
+void AnimationController::addSharedPose(AnimationClip* clip, const float* time, unsigned int firstResult)
+{
+    GP_ASSERT(clip && clip->_animation);
+    GP_ASSERT(time);
+
+    if (clip->_animation->_channels.empty())
+        return;
+
+    SharedPose pose;
+    pose.clip = clip;
+    memcpy(pose.time, time, sizeof(pose.time));
+    pose.firstResult = firstResult;
+    pose.resultCount = (unsigned int)_results.size() - firstResult;
+    _sharedPoses.insert(std::make_pair(clip->_animation->_channels[0]->_curve, pose));
+}
+
+bool AnimationController::isSamePose(const AnimationClip* clip1, const AnimationClip* clip2)
+{
+    const std::vector<Animation::Channel*>& channels1 = clip1->_animation->_channels;
+    const std::vector<Animation::Channel*>& channels2 = clip2->_animation->_channels;
+    if (channels1.size() != channels2.size() || clip1->_lod != clip2->_lod || clip1->_skippedChannels != clip2->_skippedChannels)
+        return false;
+
+    for (size_t i = 0, count = channels1.size(); i < count; ++i)
+    {
+        if (channels1[i]->_curve != channels2[i]->_curve || channels1[i]->_propertyId != channels2[i]->_propertyId)
+            return false;
+    }
+    return true;
+}
+
 }
@@ -9,6 +9,9 @@
 namespace gameplay
 {
 
+class Node;
+class Transform;
+
 /**
  * Defines a class for controlling game animation.
  */
@@ -18,6 +21,7 @@ class AnimationController
     friend class Animation;
     friend class AnimationClip;
     friend class SceneLoader;
+    friend class SceneSnapshot;
 
 public:
 
@@ -25,6 +29,36 @@ public:
      * Stops all AnimationClips currently playing on the AnimationController.
      */
     void stopAllAnimations();
+
+    /**
+     * Sets the nodes that are visible, such as the nodes found by Scene::cull().
+     *
+     * Clips with a visibility node (see AnimationClip::setVisibilityNode) that is not
+     * in this set are frozen: they keep advancing in time but are not evaluated, so their
+     * targets hold their last values until the node is visible again. The set is used by
+     * every update until it is set again or cleared.
+     *
+     * @param nodes The visible nodes.
+     * @script{ignore}
+     */
+    void setVisibleNodes(const std::vector<Node*>& nodes);
+
+    /**
+     * Clears the set of visible nodes, so that clips are evaluated regardless of the
+     * visibility of their visibility nodes.
+     */
+    void clearVisibleNodes();
+
+    /**
+     * Advances the scheduled clips and applies their values to their targets.
+     *
+     * This is called by the game every frame. Call it directly only to step the animations
+     * outside of the game loop, for instance in tools and benchmarks.
+     *
+     * @param elapsedTime The elapsed time, in milliseconds.
+     * @script{ignore}
+     */
+    void update(float elapsedTime);
        
 private:
 
@@ -91,13 +125,139 @@ private:
      */
     void unschedule(AnimationClip* clip);
     
+
     /**
-     * Callback for when the controller receives a frame update event.
+     * Determines whether the specified node is visible, according to the set of visible nodes.
+     *
+     * @return true if there is no set of visible nodes or the node is in it, false otherwise.
      */
-    void update(float elapsedTime);
-    
+    bool isNodeVisible(Node* node) const;
+
+    /**
+     * Defines the value of an animated property evaluated by a clip during an update.
+     */
+    struct Result
+    {
+        AnimationTarget* target;
+        int propertyId;
+        AnimationValue* value;
+        unsigned int offset;
+        float blendWeight;
+        unsigned int order;
+    };
+
+    /**
+     * Queues a value for an animated property, to be applied to its target at the end of the update.
+     *
+     * @param target The animation target.
+     * @param propertyId The animated property.
+     * @param value The value that is passed to the target, with the number of components of the property.
+     * @param blendWeight The blend weight of the clip.
+     *
+     * @return The location the property value must be evaluated into, valid until the next call.
+     */
+    float* queueResult(AnimationTarget* target, int propertyId, AnimationValue* value, float blendWeight);
+
+    /**
+     * Applies the queued property values to their targets, grouped by target and property.
+     *
+     * The values are applied in rounds of one value for each target. The values animating a
+     * transform are blended into a pose of the transform instead of the transform itself, and
+     * the pose is set on the transform once all of them are blended, so that a joint animated
+     * by several channels or clips is only marked dirty once. The scales and translations
+     * blended into poses in a round are interpolated in one batch, and so are the rotations
+     * when the rotation interpolation is Curve::ROTATION_NLERP.
+     */
+    void applyResults();
+
+    /**
+     * Queues the blend of the scale or the translation of a pose with a property value, for the current round.
+     *
+     * @param poseOffset The offset of the scale or the translation in the poses.
+     * @param layout The components of the property value that set the three components, or -1.
+     * @param value The property value.
+     * @param blendWeight The blend weight.
+     *
+     * @return true if the property sets any of the three components, false otherwise.
+     */
+    bool queueBlendedVector(unsigned int poseOffset, const signed char* layout, const float* value, float blendWeight);
+
+    /**
+     * Interpolates the scales and translations queued for blending in the current round into their poses.
+     */
+    void applyBlendedVectors();
+
+    /**
+     * Interpolates the rotations queued for blending in the current round into their poses.
+     */
+    void applyBlendedRotations();
+
+    /**
+     * Orders results by target and property, keeping the order in which they were queued.
+     */
+    static bool compareResults(const Result& r1, const Result& r2);
+
+    /**
+     * Defines a pose evaluated by a clip with pose sharing enabled during an update.
+     */
+    struct SharedPose
+    {
+        AnimationClip* clip;
+        float time[4];
+        unsigned int firstResult;
+        unsigned int resultCount;
+    };
+
+    /**
+     * Queues the values of a pose evaluated earlier in the update by a clip with the same curves
+     * at the same time, as the values of the specified clip.
+     *
+     * @param clip The clip to queue values for.
+     * @param time The percent complete, start, end and loop blend time the clip is evaluated at.
+     *
+     * @return true if a matching pose was found and queued, false if the clip must be evaluated.
+     */
+    bool queueSharedPose(AnimationClip* clip, const float* time);
+
+    /**
+     * Records the values just queued by a clip with pose sharing enabled, so clips with the same
+     * curves evaluated at the same time can reuse them.
+     *
+     * @param clip The clip that queued the values.
+     * @param time The percent complete, start, end and loop blend time the clip was evaluated at.
+     * @param firstResult The index of the first result queued by the clip.
+     */
+    void addSharedPose(AnimationClip* clip, const float* time, unsigned int firstResult);
+
+    /**
+     * Determines whether two clips evaluate the same curves for the same channels.
+     */
+    static bool isSamePose(const AnimationClip* clip1, const AnimationClip* clip2);
+
     State _state;                                 // The current state of the AnimationController.
-    std::list<AnimationClip*> _runningClips;      // A list of running AnimationClips.
+    std::vector<AnimationClip*> _runningClips;    // The running AnimationClips, in the order they are updated.
+    bool _updating;                               // Whether the running clips are being updated.
+    std::vector<AnimationClip*> _updatedClips;    // The clips updated during the current update.
+    std::vector<AnimationClip*> _endedClips;      // The clips that ended during the current update.
+    std::vector<Node*> _visibleNodes;             // The visible nodes, sorted.
+    bool _visibilityCulling;                      // Whether clips are frozen when their visibility node is not visible.
+    std::vector<Result> _results;                 // The property values evaluated during the current update.
+    std::vector<float> _resultValues;             // The components of the evaluated property values.
+    std::vector<std::pair<size_t, size_t> > _resultRanges; // The ranges of the results of each target not applied yet.
+    std::vector<int> _rangePoses;                 // The pose of the target of each range of results, or -1 if it is not a transform.
+    std::vector<Transform*> _poseTransforms;      // The transforms whose values are blended into a pose during the current update.
+    std::vector<float> _poseValues;               // The poses of the transforms (scale, rotation and translation).
+    std::vector<char> _poseDirtyBits;             // The components of each pose blended during the current update.
+    std::vector<unsigned int> _blendedPoses;      // The poses blending a rotation in the current round.
+    std::vector<float> _blendedRotations;         // The current rotations of the blending poses (x, y, z, w).
+    std::vector<float> _blendedValues;            // The rotations blended into the poses.
+    std::vector<float> _blendedWeights;           // The blend weights of the rotations.
+    std::vector<float> _blendedVectors;           // The storage of the aligned arrays of scales and translations blended in the current round.
+    float* _blendedVectorData;                    // The start, end and blend weight arrays of the scales and translations, 16-byte aligned.
+    unsigned int _blendedVectorCapacity;          // The number of scales and translations the arrays hold.
+    std::vector<unsigned int> _blendedVectorOffsets; // The offsets in the poses of the scales and translations blended in the current round.
+    std::multimap<Curve*, SharedPose> _sharedPoses; // The shareable poses evaluated during the current update, by first curve.
+    unsigned int _updatePhase;                    // The phase given to the next clip whose update interval is set.
 };
 
 }
@@ -313,6 +313,11 @@ void AnimationTarget::destroyAnimation(const char* id)
     SAFE_DELETE(channel);
 }
 
+unsigned int AnimationTarget::getAnimationSkipLod() const
+{
+    return 0;
+}
+
 Animation* AnimationTarget::getAnimation(const char* id) const
 {
     if (_animationChannels)
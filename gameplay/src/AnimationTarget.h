@@ -19,6 +19,8 @@ class AnimationTarget
 {
     friend class Animation;
     friend class AnimationClip;
+    friend class AnimationController;
+    friend class SceneSnapshot;
 
 public:
 
@@ -145,6 +147,16 @@ public:
      */
     Animation* getAnimation(const char* id = NULL) const;
 
+    /**
+     * Gets the level of detail from which the channels targeting this target are skipped.
+     *
+     * Clips playing at this level of detail or a higher one (see AnimationClip::setLod) do not
+     * evaluate their channels targeting this target. Zero means the target is always animated.
+     *
+     * @return The level of detail from which the target is no longer animated.
+     */
+    virtual unsigned int getAnimationSkipLod() const;
+
 protected:
 
     /**
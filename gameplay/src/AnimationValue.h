@@ -11,7 +11,9 @@ namespace gameplay
  */
 class AnimationValue
 {
+    friend class Animation;
     friend class AnimationClip;
+    friend class AnimationController;
 
 public:
 
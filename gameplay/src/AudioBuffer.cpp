@@ -1,12 +1,18 @@
 #include "Base.h"
 #include "AudioBuffer.h"
 #include "FileSystem.h"
+#include "Game.h"
+#include "Thread.h"
+#include "MemoryTracker.h"
 
 namespace gameplay
 {
 
-// Audio buffer cache
+// Audio buffer cache, from the least to the most recently used buffer
 static std::vector<AudioBuffer*> __buffers;
+static size_t __cacheBudget = 0;
+static size_t __cacheSize = 0;
+static Mutex __buffersMutex;
 
 // Callbacks for loading an ogg file using Stream
 static size_t readStream(void *ptr, size_t size, size_t nmemb, void *datasource)
@@ -39,46 +45,85 @@ static long tellStream(void *datasource)
 }
 
 AudioBuffer::AudioBuffer(const char* path, ALuint buffer)
-    : _filePath(path), _alBuffer(buffer)
+    : _filePath(path), _alBuffer(buffer), _duration(0.0f), _size(0), _streamed(false), _stream(NULL), _format(0), _frequency(0),
+    _chunk(NULL), _chunkSize(0), _chunkLooped(false), _chunkPending(false)
 {
+    memset(_streamBuffers, 0, sizeof(_streamBuffers));
+}
+
+AudioBuffer::AudioBuffer(const char* path, Stream* stream)
+    : _filePath(path), _alBuffer(0), _duration(0.0f), _size(0), _streamed(true), _stream(stream), _format(0), _frequency(0),
+    _chunk(NULL), _chunkSize(0), _chunkLooped(false), _chunkPending(false)
+{
+    memset(_streamBuffers, 0, sizeof(_streamBuffers));
 }
 
 AudioBuffer::~AudioBuffer()
 {
     // Remove the buffer from the cache.
+    __buffersMutex.lock();
     unsigned int bufferCount = (unsigned int)__buffers.size();
     for (unsigned int i = 0; i < bufferCount; i++)
     {
         if (this == __buffers[i])
         {
             __buffers.erase(__buffers.begin() + i);
+            __cacheSize -= _size;
             break;
         }
     }
+    __buffersMutex.unlock();
+    MemoryTracker::untrack(MemoryTracker::AUDIO, (unsigned int)_size);
 
     if (_alBuffer)
     {
         AL_CHECK( alDeleteBuffers(1, &_alBuffer) );
         _alBuffer = 0;
     }
+
+    if (_streamed)
+    {
+        streamWait();
+        if (_stream)
+        {
+            // Closes the stream through the close callback.
+            ov_clear(&_oggFile);
+            SAFE_DELETE(_stream);
+        }
+        if (_streamBuffers[0])
+        {
+            AL_CHECK( alDeleteBuffers(STREAM_BUFFER_COUNT, _streamBuffers) );
+        }
+        SAFE_DELETE_ARRAY(_chunk);
+    }
 }
 
 AudioBuffer* AudioBuffer::create(const char* path)
 {
     GP_ASSERT(path);
 
-    // Search the cache for a stream from this file.
-    unsigned int bufferCount = (unsigned int)__buffers.size();
+    MemoryTracker::Scope scope(MemoryTracker::AUDIO);
+
+    // Search the cache for a stream from this file. The cache holds a reference to
+    // the buffers it contains, so they cannot be destroyed while the lock is held.
     AudioBuffer* buffer = NULL;
-    for (unsigned int i = 0; i < bufferCount; i++)
     {
-        buffer = __buffers[i];
-        GP_ASSERT(buffer);
-        if (buffer->_filePath.compare(path) == 0)
+        Mutex::Lock lock(__buffersMutex);
+        unsigned int bufferCount = (unsigned int)__buffers.size();
+        for (unsigned int i = 0; i < bufferCount; i++)
         {
-            buffer->addRef();
-            return buffer;
+            buffer = __buffers[i];
+            GP_ASSERT(buffer);
+            if (buffer->_filePath.compare(path) == 0)
+            {
+                // Move the buffer to the most recently used end of the cache.
+                __buffers.erase(__buffers.begin() + i);
+                __buffers.push_back(buffer);
+                buffer->addRef();
+                return buffer;
+            }
         }
+        buffer = NULL;
     }
 
     ALuint alBuffer;
@@ -133,8 +178,28 @@ AudioBuffer* AudioBuffer::create(const char* path)
 
     buffer = new AudioBuffer(path, alBuffer);
 
-    // Add the buffer to the cache.
+    // Compute the length of the sound, used to track sources that play without an OpenAL source.
+    {
+        ALint size = 0, bits = 0, channels = 0, frequency = 0;
+        AL_CHECK( alGetBufferi(alBuffer, AL_SIZE, &size) );
+        AL_CHECK( alGetBufferi(alBuffer, AL_BITS, &bits) );
+        AL_CHECK( alGetBufferi(alBuffer, AL_CHANNELS, &channels) );
+        AL_CHECK( alGetBufferi(alBuffer, AL_FREQUENCY, &frequency) );
+        if (bits > 0 && channels > 0 && frequency > 0)
+        {
+            buffer->_duration = (float)size / (float)(bits / 8 * channels * frequency);
+        }
+        buffer->_size = (size_t)size;
+        MemoryTracker::track(MemoryTracker::AUDIO, (unsigned int)size);
+    }
+
+    // Add the buffer to the cache, which holds a reference to it until it is trimmed.
+    buffer->addRef();
+    __buffersMutex.lock();
     __buffers.push_back(buffer);
+    __cacheSize += buffer->_size;
+    __buffersMutex.unlock();
+    trimCache();
 
     return buffer;
     
@@ -144,6 +209,69 @@ cleanup:
     return NULL;
 }
 
+AudioBuffer* AudioBuffer::create(const char* path, bool streamed)
+{
+    GP_ASSERT(path);
+
+    MemoryTracker::Scope scope(MemoryTracker::AUDIO);
+
+    if (!streamed)
+        return create(path);
+
+    Stream* stream = FileSystem::open(path);
+    if (stream == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to load audio file %s.", path);
+        SAFE_DELETE(stream);
+        return NULL;
+    }
+
+    // Only Ogg Vorbis files are streamed; other formats are small enough to load entirely.
+    char header[4];
+    if (stream->read(header, 1, 4) != 4 || memcmp(header, "OggS", 4) != 0)
+    {
+        SAFE_DELETE(stream);
+        GP_WARN("Only ogg files can be streamed; loading audio file %s entirely.", path);
+        return create(path);
+    }
+    stream->rewind();
+
+    AudioBuffer* buffer = new AudioBuffer(path, stream);
+
+    ov_callbacks callbacks;
+    callbacks.read_func = readStream;
+    callbacks.seek_func = seekStream;
+    callbacks.close_func = closeStream;
+    callbacks.tell_func = tellStream;
+
+    if (ov_open_callbacks(stream, &buffer->_oggFile, NULL, 0, callbacks) < 0)
+    {
+        GP_ERROR("Failed to open ogg file: %s", path);
+        SAFE_DELETE(buffer->_stream);
+        SAFE_RELEASE(buffer);
+        return NULL;
+    }
+
+    vorbis_info* info = ov_info(&buffer->_oggFile, -1);
+    GP_ASSERT(info);
+    buffer->_format = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    buffer->_frequency = info->rate;
+    buffer->_duration = (float)ov_time_total(&buffer->_oggFile, -1);
+
+    AL_CHECK( alGenBuffers(STREAM_BUFFER_COUNT, buffer->_streamBuffers) );
+    if (AL_LAST_ERROR())
+    {
+        GP_ERROR("Failed to create OpenAL buffers; alGenBuffers error: %d", AL_LAST_ERROR());
+        memset(buffer->_streamBuffers, 0, sizeof(buffer->_streamBuffers));
+        SAFE_RELEASE(buffer);
+        return NULL;
+    }
+
+    buffer->_chunk = new char[STREAM_CHUNK_SIZE];
+
+    return buffer;
+}
+
 bool AudioBuffer::loadWav(Stream* stream, ALuint buffer)
 {
     GP_ASSERT(stream);
@@ -400,4 +528,152 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer)
     return true;
 }
 
+void AudioBuffer::trimCache()
+{
+    // Buffers are removed under the lock and released after it, since their destructor takes it too.
+    std::vector<AudioBuffer*> buffers;
+    __buffersMutex.lock();
+    for (size_t i = 0; i < __buffers.size() && __cacheSize > __cacheBudget;)
+    {
+        // Only the cache references buffers with a single reference.
+        AudioBuffer* buffer = __buffers[i];
+        if (buffer->getRefCount() == 1)
+        {
+            __buffers.erase(__buffers.begin() + i);
+            __cacheSize -= buffer->_size;
+            buffers.push_back(buffer);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    __buffersMutex.unlock();
+    for (size_t i = 0, count = buffers.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(buffers[i]);
+    }
+}
+
+void AudioBuffer::clearCache()
+{
+    std::vector<AudioBuffer*> buffers;
+    __buffersMutex.lock();
+    buffers.swap(__buffers);
+    __cacheSize = 0;
+    __buffersMutex.unlock();
+    for (size_t i = 0, count = buffers.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(buffers[i]);
+    }
+}
+
+void AudioBuffer::setCacheBudget(size_t bytes)
+{
+    __cacheBudget = bytes;
+    trimCache();
+}
+
+size_t AudioBuffer::getCacheBudget()
+{
+    return __cacheBudget;
+}
+
+size_t AudioBuffer::getCacheSize()
+{
+    return __cacheSize;
+}
+
+bool AudioBuffer::isStreamed() const
+{
+    return _streamed;
+}
+
+float AudioBuffer::getDuration() const
+{
+    return _duration;
+}
+
+bool AudioBuffer::streamChunk(ALuint buffer, bool looped)
+{
+    GP_ASSERT(_streamed);
+
+    // Use the chunk decoded in the background, or decode one now after a rewind.
+    streamWait();
+    if (!_chunkPending)
+    {
+        _chunkLooped = looped;
+        decodeChunk(this);
+    }
+    _chunkPending = false;
+
+    if (_chunkSize == 0)
+        return false;
+
+    AL_CHECK( alBufferData(buffer, _format, _chunk, _chunkSize, _frequency) );
+
+    // Decode the next chunk while the queued ones play.
+    _chunkLooped = looped;
+    _chunkPending = true;
+    Game::getInstance()->getJobScheduler()->run(_decodeGroup, &AudioBuffer::decodeChunk, this);
+
+    return true;
+}
+
+void AudioBuffer::streamSeek(float seconds)
+{
+    GP_ASSERT(_streamed);
+
+    streamWait();
+    _chunkPending = false;
+    if (seconds > 0.0f)
+    {
+        ov_time_seek(&_oggFile, seconds);
+    }
+    else
+    {
+        ov_pcm_seek(&_oggFile, 0);
+    }
+}
+
+void AudioBuffer::streamWait()
+{
+    if (_chunkPending)
+    {
+        Game::getInstance()->getJobScheduler()->wait(_decodeGroup);
+    }
+}
+
+void AudioBuffer::decodeChunk(void* arg)
+{
+    AudioBuffer* buffer = (AudioBuffer*)arg;
+    GP_ASSERT(buffer);
+
+    int section;
+    bool rewound = false;
+    buffer->_chunkSize = 0;
+    while (buffer->_chunkSize < STREAM_CHUNK_SIZE)
+    {
+        long result = ov_read(&buffer->_oggFile, buffer->_chunk + buffer->_chunkSize, STREAM_CHUNK_SIZE - buffer->_chunkSize, 0, 2, 1, &section);
+        if (result > 0)
+        {
+            buffer->_chunkSize += result;
+        }
+        else if (result == 0 && buffer->_chunkLooped && !rewound)
+        {
+            // Continue from the beginning of a looped file (at most once per chunk, in case the file is empty).
+            ov_pcm_seek(&buffer->_oggFile, 0);
+            rewound = true;
+        }
+        else
+        {
+            if (result < 0)
+            {
+                GP_WARN("Failed to read ogg file; file is missing data: %s", buffer->_filePath.c_str());
+            }
+            break;
+        }
+    }
+}
+
 }
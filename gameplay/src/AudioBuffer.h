@@ -3,6 +3,7 @@
 
 #include "Ref.h"
 #include "Stream.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
@@ -13,18 +14,44 @@ class AudioSource;
  * Defines the actual audio buffer data.
  *
  * Currently only supports supported formats: .ogg, .wav, .au and .raw files.
+ *
+ * Ogg Vorbis files can also be streamed: instead of decoding the whole file into one
+ * OpenAL buffer, a streamed buffer keeps the file open and decodes it in chunks on a
+ * worker thread into a small ring of OpenAL buffers that its source queues in turn.
+ * Streamed buffers belong to a single source and are not shared.
+ *
+ * Loaded buffers are shared through a cache keyed by path. The cache keeps buffers that
+ * are no longer used by any source, so that sounds played again are not decoded again,
+ * until their total size exceeds the cache budget; the least recently used buffers are
+ * then freed first. With the default budget of zero, unused buffers are freed right away.
  */
 class AudioBuffer : public Ref
 {
     friend class AudioSource;
+    friend class AudioController;
 
 private:
-    
+
+    /**
+     * The number of OpenAL buffers queued by a streamed source.
+     */
+    static const unsigned int STREAM_BUFFER_COUNT = 4;
+
+    /**
+     * The size in bytes of a decoded chunk of a streamed source.
+     */
+    static const unsigned int STREAM_CHUNK_SIZE = 65536;
+
     /**
      * Constructor.
      */
     AudioBuffer(const char* path, ALuint buffer);
 
+    /**
+     * Constructor for a streamed buffer.
+     */
+    AudioBuffer(const char* path, Stream* stream);
+
     /**
      * Destructor.
      */
@@ -43,13 +70,101 @@ private:
      * @return The buffer from a file.
      */
     static AudioBuffer* create(const char* path);
-    
+
+    /**
+     * Creates an audio buffer from a file, streaming it if it is an Ogg Vorbis file and streamed is true.
+     *
+     * @param path The path to the audio buffer on the filesystem.
+     * @param streamed Whether to stream the file instead of loading it entirely.
+     *
+     * @return The buffer from a file.
+     */
+    static AudioBuffer* create(const char* path, bool streamed);
+
     static bool loadWav(Stream* stream, ALuint buffer);
     
     static bool loadOgg(Stream* stream, ALuint buffer);
 
+    /**
+     * Frees the least recently used buffers that no source uses until the cache fits in its budget.
+     */
+    static void trimCache();
+
+    /**
+     * Releases the cache's references to all the buffers.
+     */
+    static void clearCache();
+
+    /**
+     * Sets the total size in bytes of the buffers kept by the cache.
+     */
+    static void setCacheBudget(size_t bytes);
+
+    /**
+     * Returns the total size in bytes of the buffers kept by the cache.
+     */
+    static size_t getCacheBudget();
+
+    /**
+     * Returns the total size in bytes of the buffers in the cache, used or not.
+     */
+    static size_t getCacheSize();
+
+    /**
+     * Returns whether this buffer is streamed.
+     */
+    bool isStreamed() const;
+
+    /**
+     * Returns the length of the audio data in seconds.
+     */
+    float getDuration() const;
+
+    /**
+     * Fills an OpenAL buffer with the next decoded chunk of a streamed buffer.
+     *
+     * The chunk decoded in the background is uploaded, then decoding of the following
+     * chunk is started on a worker thread.
+     *
+     * @param buffer The OpenAL buffer to fill.
+     * @param looped Whether to continue from the beginning of the file once it ends.
+     *
+     * @return false if there is no more data to play.
+     */
+    bool streamChunk(ALuint buffer, bool looped);
+
+    /**
+     * Seeks a streamed buffer to the specified time.
+     *
+     * @param seconds The time to continue decoding from, in seconds from the beginning of the file.
+     */
+    void streamSeek(float seconds);
+
+    /**
+     * Waits for the chunk being decoded in the background.
+     */
+    void streamWait();
+
+    /**
+     * Decodes the next chunk of a streamed buffer (runs on a worker thread).
+     */
+    static void decodeChunk(void* arg);
+
     std::string _filePath;
     ALuint _alBuffer;
+    float _duration;
+    size_t _size;
+    bool _streamed;
+    ALuint _streamBuffers[STREAM_BUFFER_COUNT];
+    Stream* _stream;
+    OggVorbis_File _oggFile;
+    ALenum _format;
+    long _frequency;
+    char* _chunk;
+    unsigned int _chunkSize;
+    bool _chunkLooped;
+    bool _chunkPending;
+    JobScheduler::Group _decodeGroup;
 };
 
 }
@@ -4,11 +4,17 @@
 #include "AudioBuffer.h"
 #include "AudioSource.h"
 
+// The default maximum number of voices, which is below the source limit of most OpenAL implementations.
+#define AUDIO_DEFAULT_MAX_VOICES 32
+
+// Sources quieter than this at the listener do not get a voice.
+#define AUDIO_MIN_AUDIBLE_GAIN 0.001f
+
 namespace gameplay
 {
 
 AudioController::AudioController() 
-    : _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL)
+    : _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _maxVoices(AUDIO_DEFAULT_MAX_VOICES)
 {
 }
 
@@ -44,6 +50,22 @@ void AudioController::initialize()
 
 void AudioController::finalize()
 {
+    // Buffers must be freed while the context is still current.
+    AudioBuffer::clearCache();
+
+    // Take the voices back from the sources that are still playing.
+    for (std::set<AudioSource*>::iterator itr = _playingSources.begin(); itr != _playingSources.end(); ++itr)
+    {
+        GP_ASSERT(*itr);
+        (*itr)->releaseVoice();
+    }
+    if (!_voices.empty())
+    {
+        AL_CHECK( alDeleteSources((ALsizei)_voices.size(), &_voices[0]) );
+        _voices.clear();
+        _freeVoices.clear();
+    }
+
     alcMakeContextCurrent(NULL);
     if (_alcContext)
     {
@@ -101,6 +123,152 @@ void AudioController::update(float elapsedTime)
         AL_CHECK( alListenerfv(AL_VELOCITY, (ALfloat*)&listener->getVelocity()) );
         AL_CHECK( alListenerfv(AL_POSITION, (ALfloat*)&listener->getPosition()) );
     }
+
+    // Advance the playing sources and forget the ones that have finished.
+    _rankedSources.clear();
+    for (std::set<AudioSource*>::iterator itr = _playingSources.begin(); itr != _playingSources.end();)
+    {
+        AudioSource* source = *itr;
+        GP_ASSERT(source);
+        if (!source->updatePlayback(elapsedTime))
+        {
+            _playingSources.erase(itr++);
+            continue;
+        }
+        ++itr;
+        if (source->_state == AudioSource::PLAYING)
+        {
+            source->_audibility = source->getAudibility(listener ? listener->getPosition() : Vector3::zero());
+            _rankedSources.push_back(source);
+        }
+    }
+
+    // Give the voices to the highest ranked sources that can be heard, taking them from the others first.
+    std::sort(_rankedSources.begin(), _rankedSources.end(), compareVoices);
+    for (size_t i = 0, count = _rankedSources.size(); i < count; ++i)
+    {
+        AudioSource* source = _rankedSources[i];
+        if (i >= _maxVoices || source->_audibility < AUDIO_MIN_AUDIBLE_GAIN)
+        {
+            source->releaseVoice();
+        }
+    }
+    for (size_t i = 0, count = std::min(_rankedSources.size(), (size_t)_maxVoices); i < count; ++i)
+    {
+        AudioSource* source = _rankedSources[i];
+        if (source->_alSource == 0 && source->_audibility >= AUDIO_MIN_AUDIBLE_GAIN)
+        {
+            ALuint voice = acquireVoice();
+            if (voice == 0)
+                break;
+            source->bindVoice(voice);
+        }
+    }
+
+    // Send the positions of the sources that moved this frame, once each, and keep the queues of streamed sources filled.
+    // Virtual and inaudible sources have no voice, and get their position when they are given one.
+    for (size_t i = 0, count = _rankedSources.size(); i < count; ++i)
+    {
+        AudioSource* source = _rankedSources[i];
+        if (source->_alSource == 0)
+            continue;
+
+        if (source->_positionDirty)
+        {
+            source->updatePosition();
+        }
+        if (source->isStreamed())
+        {
+            source->updateStream();
+        }
+    }
+}
+
+unsigned int AudioController::getMaxVoices() const
+{
+    return _maxVoices;
+}
+
+void AudioController::setMaxVoices(unsigned int maxVoices)
+{
+    _maxVoices = maxVoices;
+}
+
+unsigned int AudioController::getVoiceCount() const
+{
+    return (unsigned int)(_voices.size() - _freeVoices.size());
+}
+
+unsigned int AudioController::getPlayingSourceCount() const
+{
+    return (unsigned int)_playingSources.size();
+}
+
+size_t AudioController::getBufferCacheBudget() const
+{
+    return AudioBuffer::getCacheBudget();
+}
+
+void AudioController::setBufferCacheBudget(size_t bytes)
+{
+    AudioBuffer::setCacheBudget(bytes);
+}
+
+size_t AudioController::getBufferCacheSize() const
+{
+    return AudioBuffer::getCacheSize();
+}
+
+bool AudioController::prewarm(const char* path)
+{
+    GP_ASSERT(path);
+
+    AudioBuffer* buffer = AudioBuffer::create(path);
+    if (buffer == NULL)
+        return false;
+
+    // The cache keeps its own reference if the buffer fits in the budget.
+    SAFE_RELEASE(buffer);
+    AudioBuffer::trimCache();
+    return true;
+}
+
+ALuint AudioController::acquireVoice()
+{
+    if (getVoiceCount() >= _maxVoices)
+        return 0;
+
+    if (!_freeVoices.empty())
+    {
+        ALuint voice = _freeVoices.back();
+        _freeVoices.pop_back();
+        return voice;
+    }
+
+    ALuint voice = 0;
+    AL_CHECK( alGenSources(1, &voice) );
+    if (AL_LAST_ERROR() || voice == 0)
+    {
+        // The OpenAL implementation is out of sources; never ask for more than it has.
+        GP_WARN("Failed to create OpenAL source; limiting the voice count to %u.", (unsigned int)_voices.size());
+        _maxVoices = (unsigned int)_voices.size();
+        return 0;
+    }
+    _voices.push_back(voice);
+    return voice;
+}
+
+void AudioController::releaseVoice(ALuint voice)
+{
+    GP_ASSERT(voice);
+    _freeVoices.push_back(voice);
+}
+
+bool AudioController::compareVoices(const AudioSource* a, const AudioSource* b)
+{
+    if (a->_priority != b->_priority)
+        return a->_priority > b->_priority;
+    return a->_audibility > b->_audibility;
 }
 
 }
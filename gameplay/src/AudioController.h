@@ -9,6 +9,13 @@ class AudioSource;
 
 /**
  * Defines a class for controlling game audio.
+ *
+ * The controller owns a pool of OpenAL sources (voices) shared by all the playing
+ * AudioSource objects. Each frame, the playing sources are ranked by priority and then
+ * by their estimated gain at the listener, and only the top ranked sources that can be
+ * heard get a voice, up to the maximum voice count. The maximum is set by the 'maxVoices'
+ * property in the 'audio' section of the game configuration file, and is lowered
+ * automatically if the OpenAL implementation runs out of sources.
  */
 class AudioController
 {
@@ -22,6 +29,78 @@ public:
      */
     virtual ~AudioController();
 
+    /**
+     * Returns the maximum number of sources that are heard at the same time.
+     *
+     * @return The maximum number of OpenAL voices.
+     */
+    unsigned int getMaxVoices() const;
+
+    /**
+     * Sets the maximum number of sources that are heard at the same time.
+     *
+     * The lowest ranked sources lose their voices on the next update if there are more
+     * playing sources than voices.
+     *
+     * @param maxVoices The maximum number of OpenAL voices.
+     */
+    void setMaxVoices(unsigned int maxVoices);
+
+    /**
+     * Returns the number of playing sources that currently have a voice.
+     *
+     * @return The number of voices in use.
+     */
+    unsigned int getVoiceCount() const;
+
+    /**
+     * Returns the number of sources that are playing or paused by the controller.
+     *
+     * @return The number of playing sources, including virtual ones.
+     */
+    unsigned int getPlayingSourceCount() const;
+
+    /**
+     * Returns the budget of the decoded audio buffer cache.
+     *
+     * @return The maximum size in bytes of the buffers kept when no source uses them.
+     */
+    size_t getBufferCacheBudget() const;
+
+    /**
+     * Sets the budget of the decoded audio buffer cache.
+     *
+     * Audio files that are not streamed are decoded into buffers shared by all the sources
+     * playing them. The cache keeps buffers that are no longer used, so that playing them
+     * again does not decode them again, as long as the total size of the cached buffers is
+     * within the budget; the least recently used buffers are freed first. The budget is set
+     * by the 'cacheBudget' property (in megabytes) in the 'audio' section of the game
+     * configuration file, and is zero by default, which frees buffers as soon as they are unused.
+     *
+     * @param bytes The maximum size in bytes of the cached buffers.
+     */
+    void setBufferCacheBudget(size_t bytes);
+
+    /**
+     * Returns the total size of the decoded audio buffers in the cache, including the ones in use.
+     *
+     * @return The size in bytes of the cached buffers.
+     */
+    size_t getBufferCacheSize() const;
+
+    /**
+     * Decodes an audio file into the buffer cache ahead of time, so that the first source
+     * playing it does not have to.
+     *
+     * The 'prewarm' property in the 'audio' section of the game configuration file can list
+     * files to load at startup, separated by commas. The buffer is kept only within the budget.
+     *
+     * @param path The path of the audio file.
+     *
+     * @return true if the file was loaded.
+     */
+    bool prewarm(const char* path);
+
 private:
     
     /**
@@ -54,11 +133,32 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Takes a voice from the pool, creating one if the pool is below the maximum.
+     *
+     * @return The OpenAL source, or 0 if all voices are in use.
+     */
+    ALuint acquireVoice();
+
+    /**
+     * Returns a voice to the pool.
+     */
+    void releaseVoice(ALuint voice);
+
+    /**
+     * Orders sources by decreasing priority, then by decreasing audibility.
+     */
+    static bool compareVoices(const AudioSource* a, const AudioSource* b);
+
 
     ALCdevice* _alcDevice;
     ALCcontext* _alcContext;
     std::set<AudioSource*> _playingSources;
     AudioSource* _pausingSource;
+    std::vector<ALuint> _voices;
+    std::vector<ALuint> _freeVoices;
+    std::vector<AudioSource*> _rankedSources;
+    unsigned int _maxVoices;
 };
 
 }
@@ -9,28 +9,29 @@
 namespace gameplay
 {
 
-AudioSource::AudioSource(AudioBuffer* buffer, ALuint source) 
-    : _alSource(source), _buffer(buffer), _looped(false), _gain(1.0f), _pitch(1.0f), _node(NULL)
+AudioSource::AudioSource(AudioBuffer* buffer)
+    : _alSource(0), _buffer(buffer), _state(INITIAL), _playTime(0.0f), _priority(0), _audibility(0.0f),
+    _looped(false), _gain(1.0f), _pitch(1.0f), _node(NULL), _positionDirty(false)
 {
     GP_ASSERT(buffer);
-    AL_CHECK( alSourcei(_alSource, AL_BUFFER, buffer->_alBuffer) );
-    AL_CHECK( alSourcei(_alSource, AL_LOOPING, _looped) );
-    AL_CHECK( alSourcef(_alSource, AL_PITCH, _pitch) );
-    AL_CHECK( alSourcef(_alSource, AL_GAIN, _gain) );
-    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (const ALfloat*)&_velocity) );
 }
 
 AudioSource::~AudioSource()
 {
-    if (_alSource)
+    releaseVoice();
+
+    AudioController* audioController = Game::getInstance()->getAudioController();
+    if (audioController)
     {
-        AL_CHECK( alDeleteSources(1, &_alSource) );
-        _alSource = 0;
+        audioController->_playingSources.erase(this);
     }
     SAFE_RELEASE(_buffer);
+
+    // Free the buffer now if it is unused and the cache is over its budget.
+    AudioBuffer::trimCache();
 }
 
-AudioSource* AudioSource::create(const char* url)
+AudioSource* AudioSource::create(const char* url, bool streamed)
 {
     // Load from a .audio file.
     std::string pathStr = url;
@@ -49,22 +50,12 @@ AudioSource* AudioSource::create(const char* url)
     }
 
     // Create an audio buffer from this URL.
-    AudioBuffer* buffer = AudioBuffer::create(url);
+    AudioBuffer* buffer = AudioBuffer::create(url, streamed);
     if (buffer == NULL)
         return NULL;
 
-    // Load the audio source.
-    ALuint alSource = 0;
-
-    AL_CHECK( alGenSources(1, &alSource) );
-    if (AL_LAST_ERROR())
-    {
-        SAFE_RELEASE(buffer);
-        GP_ERROR("Error generating audio source.");
-        return NULL;
-    }
-    
-    return new AudioSource(buffer, alSource);
+    // The OpenAL source is assigned from the audio controller's voice pool when the source plays.
+    return new AudioSource(buffer);
 }
 
 AudioSource* AudioSource::create(Properties* properties)
@@ -85,7 +76,7 @@ AudioSource* AudioSource::create(Properties* properties)
     }
 
     // Create the audio source.
-    AudioSource* audio = AudioSource::create(path.c_str());
+    AudioSource* audio = AudioSource::create(path.c_str(), properties->getBool("streamed"));
     if (audio == NULL)
     {
         GP_ERROR("Audio file '%s' failed to load properly.", path.c_str());
@@ -116,37 +107,57 @@ AudioSource* AudioSource::create(Properties* properties)
 
 AudioSource::State AudioSource::getState() const
 {
-    ALint state;
-    AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
-
-    switch (state)
+    // A voice that reached the end of its sound stops before the controller notices it.
+    if (_state == PLAYING && _alSource && !_buffer->isStreamed())
     {
-        case AL_PLAYING: 
-            return PLAYING;
-        case AL_PAUSED:  
-            return PAUSED;
-        case AL_STOPPED: 
+        ALint state;
+        AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
+        if (state == AL_STOPPED)
             return STOPPED;
-        default:         
-            return INITIAL;
     }
-    return INITIAL;
+    return _state;
 }
 
 void AudioSource::play()
 {
-    AL_CHECK( alSourcePlay(_alSource) );
+    // Playing a source that is not paused starts it from the beginning.
+    if (_state != PAUSED)
+    {
+        releaseVoice();
+        _playTime = 0.0f;
+        if (_buffer->isStreamed())
+        {
+            _buffer->streamSeek(0.0f);
+        }
+    }
+    _state = PLAYING;
 
     // Add the source to the controller's list of currently playing sources.
     AudioController* audioController = Game::getInstance()->getAudioController();
     GP_ASSERT(audioController);
     if (audioController->_playingSources.find(this) == audioController->_playingSources.end())
         audioController->_playingSources.insert(this);
+
+    // Start right away if a voice is free, otherwise the controller decides on its next update.
+    if (_alSource)
+    {
+        AL_CHECK( alSourcePlay(_alSource) );
+    }
+    else
+    {
+        ALuint voice = audioController->acquireVoice();
+        if (voice)
+        {
+            bindVoice(voice);
+        }
+    }
 }
 
 void AudioSource::pause()
 {
-    AL_CHECK( alSourcePause(_alSource) );
+    if (_state != PLAYING)
+        return;
+    _state = PAUSED;
 
     // Remove the source from the controller's set of currently playing sources
     // if the source is being paused by the user and not the controller itself.
@@ -154,10 +165,16 @@ void AudioSource::pause()
     GP_ASSERT(audioController);
     if (audioController->_pausingSource != this)
     {
+        // Paused sources do not hold on to their voice.
+        releaseVoice();
         std::set<AudioSource*>::iterator iter = audioController->_playingSources.find(this);
         if (iter != audioController->_playingSources.end())
             audioController->_playingSources.erase(iter);
     }
+    else if (_alSource)
+    {
+        AL_CHECK( alSourcePause(_alSource) );
+    }
 }
 
 void AudioSource::resume()
@@ -170,7 +187,15 @@ void AudioSource::resume()
 
 void AudioSource::stop()
 {
-    AL_CHECK( alSourceStop(_alSource) );
+    releaseVoice();
+    _state = STOPPED;
+    _playTime = 0.0f;
+
+    // Seek back, so playing again starts from the beginning of the stream.
+    if (_buffer->isStreamed())
+    {
+        _buffer->streamSeek(0.0f);
+    }
 
     // Remove the source from the controller's set of currently playing sources.
     AudioController* audioController = Game::getInstance()->getAudioController();
@@ -182,7 +207,8 @@ void AudioSource::stop()
 
 void AudioSource::rewind()
 {
-    AL_CHECK( alSourceRewind(_alSource) );
+    stop();
+    _state = INITIAL;
 }
 
 bool AudioSource::isLooped() const
@@ -192,10 +218,14 @@ bool AudioSource::isLooped() const
 
 void AudioSource::setLooped(bool looped)
 {
-    AL_CHECK( alSourcei(_alSource, AL_LOOPING, (looped) ? AL_TRUE : AL_FALSE) );
-    if (AL_LAST_ERROR())
+    // Streamed sources loop by decoding from the start of the file again, not by replaying their queue.
+    if (_alSource && !_buffer->isStreamed())
     {
-        GP_ERROR("Failed to set audio source's looped attribute with error: %d", AL_LAST_ERROR());
+        AL_CHECK( alSourcei(_alSource, AL_LOOPING, (looped) ? AL_TRUE : AL_FALSE) );
+        if (AL_LAST_ERROR())
+        {
+            GP_ERROR("Failed to set audio source's looped attribute with error: %d", AL_LAST_ERROR());
+        }
     }
     _looped = looped;
 }
@@ -207,7 +237,10 @@ float AudioSource::getGain() const
 
 void AudioSource::setGain(float gain)
 {
-    AL_CHECK( alSourcef(_alSource, AL_GAIN, gain) );
+    if (_alSource)
+    {
+        AL_CHECK( alSourcef(_alSource, AL_GAIN, gain) );
+    }
     _gain = gain;
 }
 
@@ -218,7 +251,10 @@ float AudioSource::getPitch() const
 
 void AudioSource::setPitch(float pitch)
 {
-    AL_CHECK( alSourcef(_alSource, AL_PITCH, pitch) );
+    if (_alSource)
+    {
+        AL_CHECK( alSourcef(_alSource, AL_PITCH, pitch) );
+    }
     _pitch = pitch;
 }
 
@@ -229,7 +265,10 @@ const Vector3& AudioSource::getVelocity() const
 
 void AudioSource::setVelocity(const Vector3& velocity)
 {
-    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&velocity) );
+    if (_alSource)
+    {
+        AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&velocity) );
+    }
     _velocity = velocity;
 }
 
@@ -243,6 +282,26 @@ Node* AudioSource::getNode() const
     return _node;
 }
 
+int AudioSource::getPriority() const
+{
+    return _priority;
+}
+
+void AudioSource::setPriority(int priority)
+{
+    _priority = priority;
+}
+
+bool AudioSource::isVirtual() const
+{
+    return _alSource == 0 && (_state == PLAYING || _state == PAUSED);
+}
+
+bool AudioSource::isStreamed() const
+{
+    return _buffer->isStreamed();
+}
+
 void AudioSource::setNode(Node* node)
 {
     if (_node != node)
@@ -267,10 +326,175 @@ void AudioSource::setNode(Node* node)
 
 void AudioSource::transformChanged(Transform* transform, long cookie)
 {
-    if (_node)
+    // The position is sent to OpenAL once per frame by the audio controller, however often the node moves.
+    _positionDirty = true;
+}
+
+void AudioSource::updatePosition()
+{
+    GP_ASSERT(_alSource);
+
+    Vector3 translation = _node ? _node->getTranslationWorld() : Vector3::zero();
+    AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&translation.x) );
+    _positionDirty = false;
+}
+
+void AudioSource::bindVoice(ALuint voice)
+{
+    GP_ASSERT(voice);
+    GP_ASSERT(_alSource == 0);
+
+    _alSource = voice;
+    AL_CHECK( alSourcei(_alSource, AL_LOOPING, (_looped && !_buffer->isStreamed()) ? AL_TRUE : AL_FALSE) );
+    AL_CHECK( alSourcef(_alSource, AL_PITCH, _pitch) );
+    AL_CHECK( alSourcef(_alSource, AL_GAIN, _gain) );
+    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (const ALfloat*)&_velocity) );
+    updatePosition();
+
+    // Continue from where the source got to while it was virtual.
+    if (_buffer->isStreamed())
+    {
+        _buffer->streamSeek(_playTime);
+        queueStreamBuffers();
+    }
+    else
+    {
+        AL_CHECK( alSourcei(_alSource, AL_BUFFER, _buffer->_alBuffer) );
+        AL_CHECK( alSourcef(_alSource, AL_SEC_OFFSET, _playTime) );
+    }
+
+    if (_state == PLAYING)
+    {
+        AL_CHECK( alSourcePlay(_alSource) );
+    }
+}
+
+void AudioSource::releaseVoice()
+{
+    if (_alSource == 0)
+        return;
+
+    // Streamed sources track their position themselves, since the voice only knows about its queue.
+    if (!_buffer->isStreamed())
+    {
+        ALfloat offset = 0.0f;
+        AL_CHECK( alGetSourcef(_alSource, AL_SEC_OFFSET, &offset) );
+        _playTime = offset;
+    }
+
+    AL_CHECK( alSourceStop(_alSource) );
+    AL_CHECK( alSourcei(_alSource, AL_BUFFER, 0) );
+
+    AudioController* audioController = Game::getInstance()->getAudioController();
+    GP_ASSERT(audioController);
+    audioController->releaseVoice(_alSource);
+    _alSource = 0;
+}
+
+bool AudioSource::updatePlayback(float elapsedTime)
+{
+    if (_state != PLAYING)
+        return true;
+
+    // A voice that stopped on its own has reached the end of its sound.
+    if (_alSource && !_buffer->isStreamed())
+    {
+        ALint state;
+        AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
+        if (state == AL_STOPPED)
+        {
+            releaseVoice();
+            _state = STOPPED;
+            _playTime = 0.0f;
+            return false;
+        }
+    }
+
+    // Track the position of virtual and streamed sources.
+    if (_alSource == 0 || _buffer->isStreamed())
     {
-        Vector3 translation = _node->getTranslationWorld();
-        AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&translation.x) );
+        float duration = _buffer->getDuration();
+        _playTime += elapsedTime * 0.001f * _pitch;
+        if (duration > 0.0f && _playTime >= duration)
+        {
+            if (_looped)
+            {
+                _playTime = fmod(_playTime, duration);
+            }
+            else if (_alSource == 0)
+            {
+                _state = STOPPED;
+                _playTime = 0.0f;
+                if (_buffer->isStreamed())
+                {
+                    _buffer->streamSeek(0.0f);
+                }
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+float AudioSource::getAudibility(const Vector3& listenerPosition) const
+{
+    // Sources without a node play at the listener.
+    if (_node == NULL)
+        return _gain;
+
+    // The default OpenAL distance model (inverse distance clamped, with a reference distance and rolloff factor of 1).
+    float distance = _node->getTranslationWorld().distance(listenerPosition);
+    return _gain / std::max(distance, 1.0f);
+}
+
+void AudioSource::queueStreamBuffers()
+{
+    ALint queued = 0;
+    AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queued) );
+    if (queued > 0)
+        return;
+
+    for (unsigned int i = 0; i < AudioBuffer::STREAM_BUFFER_COUNT; ++i)
+    {
+        if (!_buffer->streamChunk(_buffer->_streamBuffers[i], _looped))
+            break;
+        AL_CHECK( alSourceQueueBuffers(_alSource, 1, &_buffer->_streamBuffers[i]) );
+    }
+}
+
+void AudioSource::updateStream()
+{
+    GP_ASSERT(_buffer->isStreamed());
+
+    // Refill the buffers that have finished playing and queue them again behind the others.
+    ALint processed = 0;
+    AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_PROCESSED, &processed) );
+    for (ALint i = 0; i < processed; ++i)
+    {
+        ALuint buffer;
+        AL_CHECK( alSourceUnqueueBuffers(_alSource, 1, &buffer) );
+        if (_buffer->streamChunk(buffer, _looped))
+        {
+            AL_CHECK( alSourceQueueBuffers(_alSource, 1, &buffer) );
+        }
+    }
+
+    // A source that ran out of queued data before it was refilled stops; restart it.
+    ALint state;
+    ALint queued = 0;
+    AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
+    AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queued) );
+    if (state == AL_STOPPED && queued > 0)
+    {
+        AL_CHECK( alSourcePlay(_alSource) );
+    }
+    else if (queued == 0 && processed > 0)
+    {
+        // The stream has ended; seek back so that playing it again starts from the beginning.
+        releaseVoice();
+        _state = STOPPED;
+        _playTime = 0.0f;
+        _buffer->streamSeek(0.0f);
     }
 }
 
@@ -278,17 +502,22 @@ AudioSource* AudioSource::clone(NodeCloneContext &context) const
 {
     GP_ASSERT(_buffer);
 
-    ALuint alSource = 0;
-    AL_CHECK( alGenSources(1, &alSource) );
-    if (AL_LAST_ERROR())
+    // Streamed buffers belong to a single source, so the clone streams the file on its own.
+    AudioBuffer* buffer = _buffer;
+    if (_buffer->isStreamed())
     {
-        GP_ERROR("Error generating audio source.");
-        return NULL;
+        buffer = AudioBuffer::create(_buffer->_filePath.c_str(), true);
+        if (buffer == NULL)
+            return NULL;
+    }
+    else
+    {
+        buffer->addRef();
     }
-    AudioSource* audioClone = new AudioSource(_buffer, alSource);
 
-    _buffer->addRef();
+    AudioSource* audioClone = new AudioSource(buffer);
     audioClone->setLooped(isLooped());
+    audioClone->setPriority(getPriority());
     audioClone->setGain(getGain());
     audioClone->setPitch(getPitch());
     audioClone->setVelocity(getVelocity());
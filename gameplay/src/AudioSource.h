@@ -17,6 +17,14 @@ class NodeCloneContext;
  *
  * This can be attached to a Node for applying its 3D transformation.
  *
+ * Playing sources share a limited pool of OpenAL voices managed by the AudioController.
+ * When more sources play than there are voices, the sources with the highest priority and
+ * then the loudest ones at the listener get the voices. The others, along with sources too
+ * far away to be heard, play virtually: their playback position is tracked without an OpenAL
+ * source, so they continue from the right place if they get a voice again. The position
+ * of the node a source is attached to is sent to its voice once per frame, after the node
+ * moved, by the AudioController.
+ *
  * @see http://blackberry.github.io/GamePlay/docs/file-formats.html#wiki-Audio
  */
 class AudioSource : public Ref, public Transform::Listener
@@ -42,11 +50,17 @@ public:
      * Alternately, a URL specifying a Properties object that defines an audio source can be used (where the URL is of the format
      * "<file-path>.<extension>#<namespace-id>/<namespace-id>/.../<namespace-id>" and "#<namespace-id>/<namespace-id>/.../<namespace-id>" is optional).
      * 
+     * Long sounds such as music should be streamed: a streamed Ogg Vorbis source decodes its file
+     * in small chunks on a worker thread while it plays, instead of decoding it entirely into
+     * memory when it is created. Streamed sources do not share their audio data with other sources.
+     * A .audio file enables streaming with the 'streamed' property.
+     *
      * @param url The relative location on disk of the sound file or a URL specifying a Properties object defining an audio source.
+     * @param streamed Whether to stream the sound file while it plays (only supported for .ogg files).
      * @return The newly created audio source, or NULL if an audio source cannot be created.
      * @script{create}
      */
-    static AudioSource* create(const char* url);
+    static AudioSource* create(const char* url, bool streamed = false);
 
     /**
      * Create an audio source from the given properties object.
@@ -161,12 +175,44 @@ public:
      */
     Node* getNode() const;
 
+    /**
+     * Returns the priority of the audio source.
+     *
+     * @return The priority.
+     */
+    int getPriority() const;
+
+    /**
+     * Sets the priority of the audio source.
+     *
+     * When there are not enough voices for all the playing sources, sources with a higher
+     * priority get voices before sources with a lower one, regardless of their loudness.
+     * The default priority is 0.
+     *
+     * @param priority The priority of the source.
+     */
+    void setPriority(int priority);
+
+    /**
+     * Determines whether the audio source is playing virtually, without an OpenAL voice.
+     *
+     * @return true if the source is playing or paused but is not currently heard.
+     */
+    bool isVirtual() const;
+
+    /**
+     * Determines whether the audio source is streamed.
+     *
+     * @return true if the audio source is streamed, false if its audio data is loaded entirely.
+     */
+    bool isStreamed() const;
+
 private:
 
     /**
      * Constructor that takes an AudioBuffer.
      */
-    AudioSource(AudioBuffer* buffer, ALuint source);
+    AudioSource(AudioBuffer* buffer);
 
     /**
      * Destructor.
@@ -188,6 +234,43 @@ private:
      */
     void transformChanged(Transform* transform, long cookie);
 
+    /**
+     * Sends the world translation of the node to the OpenAL voice of the source.
+     */
+    void updatePosition();
+
+    /**
+     * Assigns an OpenAL voice to the source and starts playing it from its current position.
+     */
+    void bindVoice(ALuint voice);
+
+    /**
+     * Stops the OpenAL voice of the source and returns it to the pool, keeping the playback position.
+     */
+    void releaseVoice();
+
+    /**
+     * Advances the playback position and detects the end of the sound.
+     *
+     * @return false if the source has finished playing.
+     */
+    bool updatePlayback(float elapsedTime);
+
+    /**
+     * Returns the estimated gain of the source at the listener.
+     */
+    float getAudibility(const Vector3& listenerPosition) const;
+
+    /**
+     * Queues the stream buffers of a streamed source that are not queued yet.
+     */
+    void queueStreamBuffers();
+
+    /**
+     * Refills the stream buffers that a streamed source has finished playing.
+     */
+    void updateStream();
+
     /**
      * Clones the audio source and returns a new audio source.
      * 
@@ -199,11 +282,16 @@ private:
 
     ALuint _alSource;
     AudioBuffer* _buffer;
+    State _state;
+    float _playTime;
+    int _priority;
+    float _audibility;
     bool _looped;
     float _gain;
     float _pitch;
     Vector3 _velocity;
     Node* _node;
+    bool _positionDirty;
 };
 
 }
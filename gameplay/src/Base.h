@@ -11,6 +11,7 @@
 #include <cwctype>
 #include <cctype>
 #include <cmath>
+#include <cfloat>
 #include <cstdarg>
 #include <ctime>
 #include <iostream>
@@ -122,6 +123,7 @@ extern int strcmpnocase(const char* s1, const char* s2);
 // Bullet Physics
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <LinearMath/btHashMap.h>
 #define BV(v) (btVector3((v).x, (v).y, (v).z))
 #define BQ(q) (btQuaternion((q).x, (q).y, (q).z, (q).w))
 
@@ -204,7 +206,10 @@ using std::va_list;
 #define WINDOW_VSYNC        1
 
 // Graphics (OpenGL)
-#ifdef __QNX__
+#if defined(GP_HEADLESS)
+    // No graphics context: the engine calls the no-op implementation of NullGL.cpp.
+    #include "NullGL.h"
+#elif __QNX__
     #include <EGL/egl.h>
     #include <GLES2/gl2.h>
     #include <GLES2/gl2ext.h>
@@ -231,15 +236,59 @@ using std::va_list;
     #define GL_DEPTH24_STENCIL8 GL_DEPTH24_STENCIL8_OES
     #define glClearDepth glClearDepthf
     #define OPENGL_ES
+    #ifdef GL_EXT_disjoint_timer_query
+        extern PFNGLGENQUERIESEXTPROC glGenQueries;
+        extern PFNGLDELETEQUERIESEXTPROC glDeleteQueries;
+        extern PFNGLBEGINQUERYEXTPROC glBeginQuery;
+        extern PFNGLENDQUERYEXTPROC glEndQuery;
+        extern PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuiv;
+        extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v;
+        #define GL_TIME_ELAPSED GL_TIME_ELAPSED_EXT
+        #define GL_QUERY_RESULT GL_QUERY_RESULT_EXT
+        #define GL_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE_EXT
+        #define USE_TIMER_QUERY
+    #endif
+    #ifdef GL_OES_get_program_binary
+        extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary;
+        extern PFNGLPROGRAMBINARYOESPROC glProgramBinary;
+        #define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+        #define USE_PROGRAM_BINARY
+    #endif
 #elif WIN32
     #define WIN32_LEAN_AND_MEAN
     #define GLEW_STATIC
     #include <GL/glew.h>
     #define USE_VAO
+    #define USE_INSTANCING
+    #define USE_MAP_BUFFER_RANGE
+    #define USE_TIMER_QUERY
+    #define USE_PALETTE_TEXTURE
+    #define USE_PROGRAM_BINARY
+    #define USE_UNIFORM_BUFFER
+    #define USE_LIGHT_CLUSTERS
+    #define USE_PACKED_VERTEX_TYPES
+    #define USE_OCCLUSION_QUERY
+    #define USE_SAMPLER_OBJECTS
+    #define USE_DEBUG_OUTPUT
+    #define USE_TRANSFORM_FEEDBACK
+    #define USE_DEPTH_READBACK
 #elif __linux__
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define USE_VAO
+        #define USE_INSTANCING
+        #define USE_MAP_BUFFER_RANGE
+        #define USE_TIMER_QUERY
+        #define USE_PALETTE_TEXTURE
+        #define USE_PROGRAM_BINARY
+        #define USE_UNIFORM_BUFFER
+        #define USE_LIGHT_CLUSTERS
+        #define USE_PACKED_VERTEX_TYPES
+        #define USE_OCCLUSION_QUERY
+        #define USE_SAMPLER_OBJECTS
+        #define USE_DEBUG_OUTPUT
+        #define USE_TRANSFORM_FEEDBACK
+        #define USE_DEPTH_READBACK
 #elif __APPLE__
     #include "TargetConditionals.h"
     #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
@@ -269,6 +318,12 @@ using std::va_list;
     #endif
 #endif
 
+// SIMD
+#if !defined(USE_NEON) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+    #define USE_SSE
+    #include <xmmintrin.h>
+#endif
+
 // Graphics (GLSL)
 #define VERTEX_ATTRIBUTE_POSITION_NAME              "a_position"
 #define VERTEX_ATTRIBUTE_NORMAL_NAME                "a_normal"
@@ -278,6 +333,7 @@ using std::va_list;
 #define VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME          "a_blendWeights"
 #define VERTEX_ATTRIBUTE_BLENDINDICES_NAME          "a_blendIndices"
 #define VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME       "a_texCoord"
+#define VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME       "a_instanceMatrix"
 
 // Hardware buffer
 namespace gameplay
@@ -312,6 +368,10 @@ typedef GLuint RenderBufferHandle;
  * the specified GL code. This macro will do nothing in release
  * mode and is therefore safe to use for realtime/per-frame GL
  * function calls.
+ *
+ * In debug builds the error is only read after the call when GL errors are
+ * checked per call (see Game::setGLErrorCheck), since glGetError() stalls
+ * the pipeline of some drivers.
  */
 #ifdef NDEBUG
 #define GL_ASSERT( gl_code ) gl_code
@@ -319,8 +379,11 @@ typedef GLuint RenderBufferHandle;
 #define GL_ASSERT( gl_code ) do \
     { \
         gl_code; \
-        __gl_error_code = glGetError(); \
-        GP_ASSERT(__gl_error_code == GL_NO_ERROR); \
+        if (__gl_error_check_call) \
+        { \
+            __gl_error_code = glGetError(); \
+            GP_ASSERT(__gl_error_code == GL_NO_ERROR); \
+        } \
     } while(0)
 #endif
 
@@ -328,6 +391,10 @@ typedef GLuint RenderBufferHandle;
  * @script{ignore} */
 extern GLenum __gl_error_code;
 
+/** Global variable set when GL_ASSERT reads the GL error after every call
+ * @script{ignore} */
+extern bool __gl_error_check_call;
+
 /**
  * Executes the specified AL code and checks the AL error afterwards
  * to ensure it succeeded.
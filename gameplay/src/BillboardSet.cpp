@@ -0,0 +1,339 @@
+#include "Base.h"
+#include "BillboardSet.h"
+#include "Game.h"
+#include "Node.h"
+#include "Scene.h"
+#include "FrameBuffer.h"
+
+// Default number of billboards of a newly created set
+#define BILLBOARD_SET_DEFAULT_SIZE 256
+
+// The largest number of billboards in a set, whose vertices must be addressable by 16-bit indices.
+#define BILLBOARD_SET_MAX_SIZE 16384
+
+// Default billboard shaders
+#define BILLBOARD_VSH "res/shaders/billboard.vert"
+#define BILLBOARD_FSH "res/shaders/billboard.frag"
+
+namespace gameplay
+{
+
+static unsigned int __impostorCount = 0;
+
+BillboardSet::BillboardSet()
+    : _batch(NULL), _dirty(false), _upright(false), _camera(NULL), _viewCount(1), _impostorSize(0.0f)
+{
+}
+
+BillboardSet::~BillboardSet()
+{
+    SAFE_DELETE(_batch);
+}
+
+BillboardSet* BillboardSet::create(Texture* texture, unsigned int frameColumns, unsigned int frameRows, unsigned int initialCapacity)
+{
+    return createSet(texture, frameColumns, frameRows, 1, initialCapacity);
+}
+
+BillboardSet* BillboardSet::createImpostor(Node* node, unsigned int frameSize, unsigned int viewCount, unsigned int initialCapacity)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(frameSize > 0 && viewCount > 0);
+
+    BoundingSphere bounds;
+    Texture* texture = captureImpostor(node, frameSize, viewCount, &bounds);
+    if (texture == NULL)
+        return NULL;
+
+    BillboardSet* set = createSet(texture, viewCount, 1, viewCount, initialCapacity);
+    SAFE_RELEASE(texture);
+    if (set)
+    {
+        set->_upright = true;
+        set->_impostorOffset = bounds.center - node->getTranslationWorld();
+        set->_impostorSize = bounds.radius * 2.0f;
+    }
+    return set;
+}
+
+BillboardSet* BillboardSet::createSet(Texture* texture, unsigned int frameColumns, unsigned int frameRows, unsigned int viewCount, unsigned int initialCapacity)
+{
+    GP_ASSERT(texture);
+    GP_ASSERT(frameColumns > 0 && frameRows > 0);
+
+    Material* material = Material::create(BILLBOARD_VSH, BILLBOARD_FSH);
+    if (material == NULL)
+    {
+        GP_ERROR("Unable to load billboard effect.");
+        return NULL;
+    }
+
+    // Billboards are alpha tested, so they need no sorting.
+    material->getStateBlock()->setDepthTest(true);
+    material->getStateBlock()->setDepthWrite(true);
+    material->getStateBlock()->setCullFace(false);
+    material->getStateBlock()->setBlend(false);
+
+    Texture::Sampler* sampler = Texture::Sampler::create(texture); // +ref texture
+    sampler->setFilterMode(texture->isMipmapped() ? Texture::LINEAR_MIPMAP_LINEAR : Texture::LINEAR, Texture::LINEAR);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    material->getParameter("u_texture")->setValue(sampler);
+    SAFE_RELEASE(sampler);
+
+    // Define the vertex format of the batch, which holds the whole billboard in each of its vertices.
+    VertexFormat::Element vertexElements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
+        VertexFormat::Element(VertexFormat::TEXCOORD1, 2),
+        VertexFormat::Element(VertexFormat::TEXCOORD2, 1),
+        VertexFormat::Element(VertexFormat::COLOR, 4)
+    };
+    VertexFormat vertexFormat(vertexElements, 5);
+    unsigned int capacity = std::min(initialCapacity > 0 ? initialCapacity : BILLBOARD_SET_DEFAULT_SIZE, (unsigned int)BILLBOARD_SET_MAX_SIZE);
+    MeshBatch* meshBatch = MeshBatch::create(vertexFormat, Mesh::TRIANGLES, material, true, capacity * 4, capacity * 4);
+    material->release(); // don't call SAFE_RELEASE since material is used below
+
+    BillboardSet* set = new BillboardSet();
+    set->_batch = meshBatch;
+    set->_viewCount = viewCount;
+    set->_billboards.reserve(capacity);
+
+    material->getParameter("u_viewProjectionMatrix")->bindValue(set, &BillboardSet::getViewProjectionMatrix);
+    material->getParameter("u_cameraPosition")->bindValue(set, &BillboardSet::getCameraPosition);
+    material->getParameter("u_cameraRight")->bindValue(set, &BillboardSet::getCameraRight);
+    material->getParameter("u_cameraUp")->bindValue(set, &BillboardSet::getCameraUp);
+    material->getParameter("u_upright")->bindValue(set, &BillboardSet::getUpright);
+    material->getParameter("u_frameSize")->setValue(Vector2(1.0f / frameColumns, 1.0f / frameRows));
+    material->getParameter("u_frameColumns")->setValue((float)frameColumns);
+    material->getParameter("u_viewCount")->setValue((float)viewCount);
+    material->getParameter("u_alphaThreshold")->setValue(0.5f);
+
+    return set;
+}
+
+Texture* BillboardSet::captureImpostor(Node* node, unsigned int frameSize, unsigned int viewCount, BoundingSphere* bounds)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(bounds);
+
+    Model* model = node->getModel();
+    Scene* scene = node->getScene();
+    if (model == NULL || scene == NULL)
+    {
+        GP_WARN("Impostors can only be captured from the model of a node in a scene.");
+        return NULL;
+    }
+    *bounds = node->getBoundingSphere();
+    if (bounds->radius <= 0.0f)
+        return NULL;
+
+    unsigned int width = frameSize * viewCount;
+    char id[32];
+    sprintf(id, "__impostor%u", ++__impostorCount);
+    FrameBuffer* frameBuffer = FrameBuffer::create(id, width, frameSize);
+    if (frameBuffer == NULL || frameBuffer->getRenderTarget() == NULL)
+    {
+        GP_ERROR("Failed to create the frame buffer of an impostor.");
+        SAFE_RELEASE(frameBuffer);
+        return NULL;
+    }
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(id, DepthStencilTarget::DEPTH, width, frameSize);
+    frameBuffer->setDepthStencilTarget(depthTarget);
+    SAFE_RELEASE(depthTarget);
+
+    // Capture through an orthographic camera that orbits the bounds at twice their radius,
+    // standing in as the active camera of the scene so that the materials bind its matrices.
+    float radius = bounds->radius;
+    Camera* camera = Camera::createOrthographic(radius * 2.0f, radius * 2.0f, 1.0f, radius * 0.5f, radius * 3.5f);
+    Node* cameraNode = Node::create();
+    cameraNode->setCamera(camera);
+    Camera* previousCamera = scene->getActiveCamera();
+    if (previousCamera)
+        previousCamera->addRef();
+    scene->setActiveCamera(camera);
+
+    Game* game = Game::getInstance();
+    FrameBuffer* previousFrameBuffer = frameBuffer->bind();
+    Rectangle previousViewport = game->getViewport();
+    game->setViewport(Rectangle(0, 0, (float)width, (float)frameSize));
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+    for (unsigned int i = 0; i < viewCount; ++i)
+    {
+        // The camera looks down -Z, so turning it by the angle of its position faces it to the center.
+        float angle = MATH_PIX2 * i / viewCount;
+        cameraNode->setTranslation(bounds->center + Vector3(sin(angle), 0.0f, cos(angle)) * (radius * 2.0f));
+        cameraNode->setRotation(Vector3::unitY(), angle);
+        game->setViewport(Rectangle((float)(i * frameSize), 0, (float)frameSize, (float)frameSize));
+        model->draw();
+    }
+    game->setViewport(previousViewport);
+    previousFrameBuffer->bind();
+
+    scene->setActiveCamera(previousCamera);
+    SAFE_RELEASE(previousCamera);
+    SAFE_RELEASE(cameraNode);
+    SAFE_RELEASE(camera);
+
+    Texture* texture = frameBuffer->getRenderTarget()->getTexture();
+    texture->addRef();
+    SAFE_RELEASE(frameBuffer);
+    return texture;
+}
+
+unsigned int BillboardSet::add(const Vector3& position, float width, float height, const Vector4& color, unsigned int frame)
+{
+    if (_billboards.size() >= BILLBOARD_SET_MAX_SIZE)
+    {
+        GP_WARN("A billboard set holds at most %u billboards.", (unsigned int)BILLBOARD_SET_MAX_SIZE);
+        return (unsigned int)_billboards.size() - 1;
+    }
+
+    Billboard billboard;
+    billboard.position = position;
+    billboard.width = width;
+    billboard.height = height;
+    billboard.color = color;
+    billboard.frame = frame;
+    _billboards.push_back(billboard);
+
+    // The bounds hold the sphere around each billboard, which contains it whichever way it turns.
+    float radius = 0.5f * sqrt(width * width + height * height);
+    BoundingBox box(position.x - radius, position.y - radius, position.z - radius, position.x + radius, position.y + radius, position.z + radius);
+    if (_billboards.size() == 1)
+        _bounds = box;
+    else
+        _bounds.merge(box);
+
+    _dirty = true;
+    return (unsigned int)_billboards.size() - 1;
+}
+
+unsigned int BillboardSet::addImpostor(const Vector3& position, float scale, const Vector4& color)
+{
+    GP_ASSERT(_impostorSize > 0.0f);
+
+    return add(position + _impostorOffset * scale, _impostorSize * scale, _impostorSize * scale, color, 0);
+}
+
+void BillboardSet::clear()
+{
+    _billboards.clear();
+    _bounds.set(Vector3::zero(), Vector3::zero());
+    _dirty = true;
+}
+
+unsigned int BillboardSet::getCount() const
+{
+    return (unsigned int)_billboards.size();
+}
+
+const BoundingBox& BillboardSet::getBounds() const
+{
+    return _bounds;
+}
+
+void BillboardSet::setUpright(bool upright)
+{
+    // Impostors are captured around the vertical axis, so they can't face the camera plane.
+    _upright = upright || _viewCount > 1;
+}
+
+bool BillboardSet::isUpright() const
+{
+    return _upright;
+}
+
+void BillboardSet::setAlphaThreshold(float threshold)
+{
+    _batch->getMaterial()->getParameter("u_alphaThreshold")->setValue(threshold);
+}
+
+Material* BillboardSet::getMaterial() const
+{
+    return _batch->getMaterial();
+}
+
+void BillboardSet::rebuild()
+{
+    _dirty = false;
+
+    static const unsigned short indices[6] = { 0, 1, 2, 2, 1, 3 };
+    BillboardVertex vertices[4];
+    _batch->start();
+    for (size_t i = 0, count = _billboards.size(); i < count; ++i)
+    {
+        const Billboard& billboard = _billboards[i];
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            BillboardVertex& v = vertices[j];
+            v.x = billboard.position.x;
+            v.y = billboard.position.y;
+            v.z = billboard.position.z;
+            v.cornerX = (float)(j & 1);
+            v.cornerY = (float)(j >> 1);
+            v.width = billboard.width;
+            v.height = billboard.height;
+            v.frame = (float)billboard.frame;
+            v.r = billboard.color.x;
+            v.g = billboard.color.y;
+            v.b = billboard.color.z;
+            v.a = billboard.color.w;
+        }
+        _batch->add(vertices, 4, indices, 6);
+    }
+    _batch->finish();
+}
+
+unsigned int BillboardSet::draw(Camera* camera)
+{
+    GP_ASSERT(camera);
+
+    if (_billboards.empty() || !_bounds.intersects(camera->getFrustum()))
+        return 0;
+
+    if (_dirty)
+    {
+        rebuild();
+    }
+
+    _camera = camera;
+    _batch->draw();
+    _camera = NULL;
+
+    return (unsigned int)_billboards.size();
+}
+
+const Matrix& BillboardSet::getViewProjectionMatrix() const
+{
+    return _camera ? _camera->getViewProjectionMatrix() : Matrix::identity();
+}
+
+Vector3 BillboardSet::getCameraPosition() const
+{
+    Node* node = _camera ? _camera->getNode() : NULL;
+    return node ? node->getTranslationWorld() : Vector3::zero();
+}
+
+Vector3 BillboardSet::getCameraRight() const
+{
+    Node* node = _camera ? _camera->getNode() : NULL;
+    Vector3 right = node ? node->getRightVectorWorld() : Vector3::unitX();
+    right.normalize();
+    return right;
+}
+
+Vector3 BillboardSet::getCameraUp() const
+{
+    Node* node = _camera ? _camera->getNode() : NULL;
+    Vector3 up = node ? node->getUpVectorWorld() : Vector3::unitY();
+    up.normalize();
+    return up;
+}
+
+float BillboardSet::getUpright() const
+{
+    return _upright ? 1.0f : 0.0f;
+}
+
+}
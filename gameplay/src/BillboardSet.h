@@ -0,0 +1,246 @@
+#ifndef BILLBOARDSET_H_
+#define BILLBOARDSET_H_
+
+#include "Ref.h"
+#include "Texture.h"
+#include "Material.h"
+#include "MeshBatch.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Camera.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a set of camera-facing quads that are drawn in a single draw call.
+ *
+ * The billboards of a set are stored in one vertex buffer, holding the center, size,
+ * color and texture frame of each billboard, and the vertex shader turns every
+ * billboard towards the camera. This suits large numbers of small distant objects
+ * such as grass clumps, foliage and far trees, which would cost a node, a cull test
+ * and a draw call each when drawn as models. The set is culled as a whole against
+ * the view frustum, so scenes spread over a large area should use one set per region.
+ *
+ * The texture of a set can be split into a grid of frames, and each billboard picks
+ * the frame it shows. Billboards are alpha tested rather than blended, so they can be
+ * drawn in any order with depth writes enabled.
+ *
+ * An impostor set (see createImpostor) shows a model captured from several directions
+ * around the vertical axis, and each billboard shows the capture taken from the
+ * direction nearest to the one it is viewed from. This replaces the farthest level
+ * of detail of a model with one textured quad per instance.
+ *
+ * @script{ignore}
+ */
+class BillboardSet : public Ref
+{
+public:
+
+    /**
+     * Creates an empty set of billboards showing frames of a texture.
+     *
+     * The frames are laid out in a grid over the texture, numbered from the top left
+     * corner, row by row.
+     *
+     * @param texture The texture of the billboards.
+     * @param frameColumns The number of columns of frames in the texture.
+     * @param frameRows The number of rows of frames in the texture.
+     * @param initialCapacity The number of billboards to allocate room for.
+     *
+     * @return The new billboard set, or NULL if its effect could not be loaded.
+     */
+    static BillboardSet* create(Texture* texture, unsigned int frameColumns = 1, unsigned int frameRows = 1, unsigned int initialCapacity = 0);
+
+    /**
+     * Creates an empty set of impostors of the model of a node.
+     *
+     * The model is drawn from viewCount directions evenly spaced around the vertical axis of
+     * the world into a texture, using an orthographic camera that frames the bounding sphere
+     * of the node. The model is drawn with its current materials, lights and pose, as the active
+     * camera of the node's scene for the duration of the capture, so this must be called while
+     * the GL context is current and outside of any other frame buffer or camera changes.
+     *
+     * @param node The node whose model is captured. It must be in a scene.
+     * @param frameSize The width and height in pixels of the capture from each direction.
+     * @param viewCount The number of directions the model is captured from.
+     * @param initialCapacity The number of impostors to allocate room for.
+     *
+     * @return The new impostor set, or NULL if the model could not be captured.
+     */
+    static BillboardSet* createImpostor(Node* node, unsigned int frameSize = 128, unsigned int viewCount = 8, unsigned int initialCapacity = 0);
+
+    /**
+     * Adds a billboard to the set.
+     *
+     * @param position The world-space position of the center of the billboard.
+     * @param width The width of the billboard.
+     * @param height The height of the billboard.
+     * @param color The color to tint the billboard. Use white for no tint.
+     * @param frame The index of the frame of the texture that the billboard shows.
+     *
+     * @return The index of the billboard.
+     */
+    unsigned int add(const Vector3& position, float width, float height, const Vector4& color = Vector4::one(), unsigned int frame = 0);
+
+    /**
+     * Adds an impostor to an impostor set, standing in for a copy of the captured model.
+     *
+     * @param position The world-space position of the origin of the copy of the model.
+     * @param scale The uniform scale of the copy of the model.
+     * @param color The color to tint the impostor. Use white for no tint.
+     *
+     * @return The index of the impostor.
+     */
+    unsigned int addImpostor(const Vector3& position, float scale = 1.0f, const Vector4& color = Vector4::one());
+
+    /**
+     * Removes all the billboards from the set.
+     */
+    void clear();
+
+    /**
+     * Returns the number of billboards in the set.
+     *
+     * @return The number of billboards.
+     */
+    unsigned int getCount() const;
+
+    /**
+     * Returns the world-space bounds of the billboards of the set.
+     *
+     * @return The bounds of the set.
+     */
+    const BoundingBox& getBounds() const;
+
+    /**
+     * Sets whether the billboards only turn around the vertical axis of the world.
+     *
+     * Upright billboards suit objects that stand on the ground, such as trees and grass.
+     * Other billboards face the camera plane. Impostor sets are always upright.
+     *
+     * @param upright true to only turn the billboards around the vertical axis.
+     */
+    void setUpright(bool upright);
+
+    /**
+     * Determines if the billboards only turn around the vertical axis of the world.
+     *
+     * @return true if the billboards are upright.
+     */
+    bool isUpright() const;
+
+    /**
+     * Sets the alpha below which the pixels of the billboards are discarded.
+     *
+     * @param threshold The alpha threshold, 0.5 by default.
+     */
+    void setAlphaThreshold(float threshold);
+
+    /**
+     * Returns the material of the set, whose state block can be changed.
+     *
+     * @return The material.
+     */
+    Material* getMaterial() const;
+
+    /**
+     * Draws the billboards of the set, unless the set is outside of the view of a camera.
+     *
+     * @param camera The camera the billboards are drawn for and turned towards.
+     *
+     * @return The number of billboards drawn.
+     */
+    unsigned int draw(Camera* camera);
+
+private:
+
+    /**
+     * Defines a billboard of the set.
+     */
+    struct Billboard
+    {
+        Vector3 position;
+        float width;
+        float height;
+        Vector4 color;
+        unsigned int frame;
+    };
+
+    /**
+     * Defines a vertex of a billboard. Each of the four vertices of a billboard holds the whole billboard.
+     */
+    struct BillboardVertex
+    {
+        float x;
+        float y;
+        float z;
+        float cornerX;
+        float cornerY;
+        float width;
+        float height;
+        float frame;
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /**
+     * Constructor.
+     */
+    BillboardSet();
+
+    /**
+     * Destructor.
+     */
+    ~BillboardSet();
+
+    /**
+     * Hidden copy constructor.
+     */
+    BillboardSet(const BillboardSet& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    BillboardSet& operator=(const BillboardSet&);
+
+    /**
+     * Creates the set, drawing with a sampler of a texture.
+     */
+    static BillboardSet* createSet(Texture* texture, unsigned int frameColumns, unsigned int frameRows, unsigned int viewCount, unsigned int initialCapacity);
+
+    /**
+     * Draws the model of a node from viewCount directions into the columns of a new texture.
+     */
+    static Texture* captureImpostor(Node* node, unsigned int frameSize, unsigned int viewCount, BoundingSphere* bounds);
+
+    /**
+     * Refills the batch of the set from its billboards.
+     */
+    void rebuild();
+
+    // Material parameter handlers, which read the camera being drawn for.
+    const Matrix& getViewProjectionMatrix() const;
+    Vector3 getCameraPosition() const;
+    Vector3 getCameraRight() const;
+    Vector3 getCameraUp() const;
+    float getUpright() const;
+
+    MeshBatch* _batch;
+    std::vector<Billboard> _billboards;
+    BoundingBox _bounds;
+    bool _dirty;
+    bool _upright;
+    Camera* _camera;
+    unsigned int _viewCount;
+    Vector3 _impostorOffset;
+    float _impostorSize;
+};
+
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include "MeshPart.h"
 #include "Scene.h"
 #include "Joint.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include "Game.h"
 
 // Minimum version numbers supported
 #define BUNDLE_VERSION_MAJOR_REQUIRED   1 
@@ -22,6 +25,8 @@
 #define BUNDLE_TYPE_MESH                34
 #define BUNDLE_TYPE_MESHPART            35
 #define BUNDLE_TYPE_MESHSKIN            36
+#define BUNDLE_TYPE_NAVMESH             40
+#define BUNDLE_TYPE_VISIBILITYSET       41
 #define BUNDLE_TYPE_FONT                128
 
 // For sanity checking string reads
@@ -30,13 +35,62 @@
 #define BUNDLE_VERSION_MAJOR_FONT_FORMAT  1
 #define BUNDLE_VERSION_MINOR_FONT_FORMAT  4
 
+#define BUNDLE_VERSION_MAJOR_ANIMATION_FORMAT  1
+#define BUNDLE_VERSION_MINOR_ANIMATION_FORMAT  5
+
+#define BUNDLE_VERSION_MAJOR_LOD_FORMAT  1
+#define BUNDLE_VERSION_MINOR_LOD_FORMAT  6
+
+#define BUNDLE_VERSION_MAJOR_VERTEX_TYPE_FORMAT  1
+#define BUNDLE_VERSION_MINOR_VERTEX_TYPE_FORMAT  7
+
+#define BUNDLE_VERSION_MAJOR_MESH_ENCODING_FORMAT  1
+#define BUNDLE_VERSION_MINOR_MESH_ENCODING_FORMAT  8
+
+// Mesh encodings
+#define BUNDLE_MESH_ENCODING_RAW            0
+#define BUNDLE_MESH_ENCODING_COMPRESSED     1
+
+// Number of vertices and indices in the independently decoded blocks of compressed meshes
+#define BUNDLE_MESH_VERTEX_BLOCK_SIZE       4096
+#define BUNDLE_MESH_INDEX_BLOCK_SIZE        16384
+
+// Animation channel formats
+#define BUNDLE_ANIMATION_FORMAT_FLOAT       0
+#define BUNDLE_ANIMATION_FORMAT_QUANTIZED   1
+
+// Quaternion offset of quantized animation channels without a rotation
+#define BUNDLE_ANIMATION_NO_QUATERNION      0xFFFFFFFF
+
+// Default time (in milliseconds) spent per frame completing asynchronous loads
+#define BUNDLE_ASYNC_LOAD_BUDGET        4.0f
+
 namespace gameplay
 {
 
-static std::vector<Bundle*> __bundleCache;
+static std::multimap<unsigned int, Bundle*> __bundleCache;
+static Mutex __bundleCacheMutex;
+
+std::vector<Bundle::AsyncLoad*> Bundle::_asyncLoads;
+Mutex Bundle::_asyncMutex;
+float Bundle::_asyncLoadBudget = BUNDLE_ASYNC_LOAD_BUDGET;
+
+/**
+ * Returns the FNV-1a hash of a string, which matches the hash the encoder sorts the reference table by.
+ */
+static unsigned int hashString(const char* str)
+{
+    unsigned int hash = 2166136261u;
+    for (; *str; ++str)
+    {
+        hash = (hash ^ (unsigned char)*str) * 16777619u;
+    }
+    return hash;
+}
 
 Bundle::Bundle(const char* path) :
-    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL)
+    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL), _meshCache(NULL),
+    _loadFlags(LOAD_DEFAULT), _channelFilter(NULL), _channelFilterCookie(NULL)
 {
 }
 
@@ -45,11 +99,18 @@ Bundle::~Bundle()
     clearLoadSession();
 
     // Remove this Bundle from the cache.
-    std::vector<Bundle*>::iterator itr = std::find(__bundleCache.begin(), __bundleCache.end(), this);
-    if (itr != __bundleCache.end())
+    __bundleCacheMutex.lock();
+    std::pair<std::multimap<unsigned int, Bundle*>::iterator, std::multimap<unsigned int, Bundle*>::iterator> range =
+        __bundleCache.equal_range(hashString(_path.c_str()));
+    for (std::multimap<unsigned int, Bundle*>::iterator itr = range.first; itr != range.second; ++itr)
     {
-        __bundleCache.erase(itr);
+        if (itr->second == this)
+        {
+            __bundleCache.erase(itr);
+            break;
+        }
     }
+    __bundleCacheMutex.unlock();
 
     SAFE_DELETE_ARRAY(_references);
 
@@ -59,6 +120,27 @@ Bundle::~Bundle()
     }
 }
 
+void Bundle::setLoadFlags(unsigned int flags)
+{
+    _loadFlags = flags;
+}
+
+unsigned int Bundle::getLoadFlags() const
+{
+    return _loadFlags;
+}
+
+void Bundle::setAnimationChannelFilter(AnimationChannelFilter filter, void* cookie)
+{
+    _channelFilter = filter;
+    _channelFilterCookie = cookie;
+}
+
+bool Bundle::isChannelLoaded(const char* animationId, const char* targetId, unsigned int targetAttribute) const
+{
+    return _channelFilter == NULL || _channelFilter(animationId, targetId, targetAttribute, _channelFilterCookie);
+}
+
 unsigned int Bundle::getVersionMajor() const
 {
     return (unsigned int)_version[0];
@@ -168,25 +250,301 @@ static std::string readString(Stream* stream)
     return str;
 }
 
+/**
+ * Returns a pointer to the next bytes of a memory-mapped stream and skips over them.
+ *
+ * Returns NULL if the stream is not mapped into memory.
+ */
+static unsigned char* readMapped(Stream* stream, size_t byteCount)
+{
+    GP_ASSERT(stream);
+
+    const unsigned char* buffer = (const unsigned char*)stream->getBuffer();
+    if (buffer == NULL)
+        return NULL;
+
+    long position = stream->position();
+    if (position < 0 || (size_t)position + byteCount > stream->length() || stream->seek((long)byteCount, SEEK_CUR) == false)
+        return NULL;
+
+    // Mesh data is only ever read from, so it is safe to cast away the constness.
+    return const_cast<unsigned char*>(buffer + position);
+}
+
+/**
+ * Reads a byte count and that many bytes from a stream, in place if the stream is mapped into memory
+ * or into the given buffer otherwise.
+ *
+ * @return true if the bytes were read.
+ */
+static bool readBytes(Stream* stream, std::vector<unsigned char>& buffer, const unsigned char** data, unsigned int* byteCount)
+{
+    if (stream->read(byteCount, 4, 1) != 1)
+        return false;
+
+    *data = readMapped(stream, *byteCount);
+    if (*data == NULL && *byteCount > 0)
+    {
+        buffer.resize(*byteCount);
+        if (stream->read(&buffer[0], 1, *byteCount) != *byteCount)
+            return false;
+        *data = &buffer[0];
+    }
+    return true;
+}
+
+/**
+ * Skips over the given number of bytes of a stream, or over a run of bytes prefixed by its length.
+ */
+static bool skipBytes(Stream* stream, bool prefixed, unsigned int byteCount)
+{
+    if (prefixed && stream->read(&byteCount, 4, 1) != 1)
+        return false;
+    return byteCount == 0 || stream->seek(byteCount, SEEK_CUR);
+}
+
+/**
+ * Defines a block of a compressed vertex or index stream, which is decoded independently of the others.
+ */
+struct MeshBlock
+{
+    const unsigned char* data;
+    unsigned int size;
+    unsigned char* output;
+    unsigned int count;
+    unsigned int stride;
+    // The byte sizes of the components of a vertex, or NULL for indices.
+    const std::vector<unsigned char>* componentSizes;
+    bool decoded;
+};
+
+/**
+ * Decodes a byte plane of a vertex block: groups of 16 bytes packed in 0, 2, 4 or 8 bits each,
+ * with the sizes of four groups in a header byte before them.
+ *
+ * Returns the end of the plane, or NULL if the data is malformed.
+ */
+static const unsigned char* decodeBytePlane(const unsigned char* in, const unsigned char* end, unsigned char* out, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i += 64)
+    {
+        if (in >= end)
+            return NULL;
+        unsigned int header = *in++;
+        for (unsigned int group = i; group < count && group < i + 64; group += 16)
+        {
+            unsigned int n = std::min(count - group, 16u);
+            unsigned char* dst = out + group;
+            switch (header & 3)
+            {
+            case 0:
+                memset(dst, 0, n);
+                break;
+            case 1:
+                if (end - in < 4)
+                    return NULL;
+                for (unsigned int j = 0; j < n; ++j)
+                    dst[j] = (in[j >> 2] >> ((j & 3) * 2)) & 3;
+                in += 4;
+                break;
+            case 2:
+                if (end - in < 8)
+                    return NULL;
+                for (unsigned int j = 0; j < n; ++j)
+                    dst[j] = (in[j >> 1] >> ((j & 1) * 4)) & 15;
+                in += 8;
+                break;
+            default:
+                if (end - in < 16)
+                    return NULL;
+                memcpy(dst, in, n);
+                in += 16;
+                break;
+            }
+            header >>= 2;
+        }
+    }
+    return in;
+}
+
+/**
+ * Decodes a block of vertices.
+ *
+ * The block holds the byte planes of the differences between the components of consecutive
+ * vertices, zigzag encoded in the size of the component, one plane per byte of a vertex.
+ */
+static bool decodeVertexBlock(const MeshBlock& block)
+{
+    GP_ASSERT(block.componentSizes);
+
+    unsigned int count = block.count;
+    unsigned int vertexSize = block.stride;
+    std::vector<unsigned char> planes((size_t)vertexSize * count);
+    const unsigned char* in = block.data;
+    const unsigned char* end = block.data + block.size;
+    for (unsigned int i = 0; i < vertexSize; ++i)
+    {
+        in = decodeBytePlane(in, end, &planes[(size_t)i * count], count);
+        if (in == NULL)
+            return false;
+    }
+    if (in != end)
+        return false;
+
+    const std::vector<unsigned char>& componentSizes = *block.componentSizes;
+    unsigned int offset = 0;
+    for (size_t c = 0, componentCount = componentSizes.size(); c < componentCount; ++c)
+    {
+        unsigned int size = componentSizes[c];
+        unsigned int mask = size == 4 ? 0xFFFFFFFFu : (1u << (size * 8)) - 1;
+        const unsigned char* plane = &planes[(size_t)offset * count];
+        unsigned char* dst = block.output + offset;
+        unsigned int value = 0;
+        for (unsigned int v = 0; v < count; ++v, dst += vertexSize)
+        {
+            unsigned int zigzag = 0;
+            for (unsigned int b = 0; b < size; ++b)
+                zigzag |= (unsigned int)plane[b * count + v] << (b * 8);
+            value = (value + ((zigzag >> 1) ^ (0u - (zigzag & 1)))) & mask;
+            for (unsigned int b = 0; b < size; ++b)
+                dst[b] = (unsigned char)(value >> (b * 8));
+        }
+        offset += size;
+    }
+    return true;
+}
+
+/**
+ * Decodes a block of indices, stored as the zigzag encoded differences between consecutive indices in LEB128.
+ */
+static bool decodeIndexBlock(const MeshBlock& block)
+{
+    const unsigned char* in = block.data;
+    const unsigned char* end = block.data + block.size;
+    unsigned int index = 0;
+    for (unsigned int i = 0; i < block.count; ++i)
+    {
+        unsigned int zigzag = 0;
+        for (unsigned int shift = 0; ; shift += 7)
+        {
+            if (in >= end || shift > 28)
+                return false;
+            unsigned int byte = *in++;
+            zigzag |= (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        index += (zigzag >> 1) ^ (0u - (zigzag & 1));
+
+        switch (block.stride)
+        {
+        case 1:
+            block.output[i] = (unsigned char)index;
+            break;
+        case 2:
+            ((unsigned short*)block.output)[i] = (unsigned short)index;
+            break;
+        default:
+            ((unsigned int*)block.output)[i] = index;
+            break;
+        }
+    }
+    return in == end;
+}
+
+/**
+ * Decodes a range of mesh blocks. Runs on the worker threads for meshes of several blocks.
+ */
+static void decodeMeshBlocks(void* arg, unsigned int start, unsigned int end)
+{
+    MeshBlock* blocks = (MeshBlock*)arg;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        blocks[i].decoded = blocks[i].componentSizes ? decodeVertexBlock(blocks[i]) : decodeIndexBlock(blocks[i]);
+    }
+}
+
+/**
+ * Decodes a compressed vertex or index stream: its blocks, each preceded by its size, are decoded
+ * in parallel on the worker threads of the game when there are several.
+ *
+ * @param data The compressed stream.
+ * @param size The size of the compressed stream, in bytes.
+ * @param output The buffer to decode the stream to.
+ * @param count The number of vertices or indices in the stream.
+ * @param stride The size of a vertex or an index, in bytes.
+ * @param componentSizes The byte sizes of the components of a vertex, or NULL to decode indices.
+ *
+ * @return true if the stream was decoded, false if it is malformed.
+ */
+static bool decodeMeshStream(const unsigned char* data, unsigned int size, unsigned char* output, unsigned int count, unsigned int stride,
+                             const std::vector<unsigned char>* componentSizes)
+{
+    unsigned int blockSize = componentSizes ? BUNDLE_MESH_VERTEX_BLOCK_SIZE : BUNDLE_MESH_INDEX_BLOCK_SIZE;
+    std::vector<MeshBlock> blocks;
+    blocks.reserve((count + blockSize - 1) / blockSize);
+    const unsigned char* end = data + size;
+    for (unsigned int first = 0; first < count; first += blockSize)
+    {
+        MeshBlock block;
+        if (end - data < 4)
+            return false;
+        memcpy(&block.size, data, 4);
+        data += 4;
+        if (block.size > (size_t)(end - data))
+            return false;
+        block.data = data;
+        block.output = output + (size_t)first * stride;
+        block.count = std::min(count - first, blockSize);
+        block.stride = stride;
+        block.componentSizes = componentSizes;
+        block.decoded = false;
+        blocks.push_back(block);
+        data += block.size;
+    }
+    if (data != end)
+        return false;
+    if (blocks.empty())
+        return true;
+
+    JobScheduler* scheduler = Game::getInstance() ? Game::getInstance()->getJobScheduler() : NULL;
+    if (blocks.size() > 1 && scheduler && scheduler->getWorkerCount() > 0)
+        scheduler->parallelFor((unsigned int)blocks.size(), decodeMeshBlocks, &blocks[0]);
+    else
+        decodeMeshBlocks(&blocks[0], 0, (unsigned int)blocks.size());
+
+    for (size_t i = 0, blockCount = blocks.size(); i < blockCount; ++i)
+    {
+        if (!blocks[i].decoded)
+            return false;
+    }
+    return true;
+}
+
 Bundle* Bundle::create(const char* path)
 {
     GP_ASSERT(path);
 
-    // Search the cache for this bundle.
-    for (size_t i = 0, count = __bundleCache.size(); i < count; ++i)
+    // Search the cache for this bundle, skipping bundles that another thread is destroying.
+    unsigned int pathHash = hashString(path);
     {
-        Bundle* p = __bundleCache[i];
-        GP_ASSERT(p);
-        if (p->_path == path)
+        Mutex::Lock lock(__bundleCacheMutex);
+        std::pair<std::multimap<unsigned int, Bundle*>::iterator, std::multimap<unsigned int, Bundle*>::iterator> range =
+            __bundleCache.equal_range(pathHash);
+        for (std::multimap<unsigned int, Bundle*>::iterator itr = range.first; itr != range.second; ++itr)
         {
-            // Found a match
-            p->addRef();
-            return p;
+            Bundle* p = itr->second;
+            GP_ASSERT(p);
+            if (p->_path == path && p->tryAddRef())
+            {
+                // Found a match
+                return p;
+            }
         }
     }
 
-    // Open the bundle.
-    Stream* stream = FileSystem::open(path);
+    // Open the bundle, mapping it into memory where possible to avoid copying mesh data.
+    Stream* stream = FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED);
     if (!stream)
     {
         GP_WARN("Failed to open file '%s'.", path);
@@ -229,6 +587,7 @@ Bundle* Bundle::create(const char* path)
 
     // Read all refs.
     Reference* refs = new Reference[refCount];
+    bool sorted = true;
     for (unsigned int i = 0; i < refCount; ++i)
     {
         if ((refs[i].id = readString(stream)).empty() ||
@@ -240,6 +599,16 @@ Bundle* Bundle::create(const char* path)
             SAFE_DELETE_ARRAY(refs);
             return NULL;
         }
+        refs[i].hash = hashString(refs[i].id.c_str());
+        if (i > 0 && refs[i].hash < refs[i - 1].hash)
+            sorted = false;
+    }
+
+    // The encoder writes the ref table sorted by the hash of the IDs, so that it can be binary searched.
+    // Bundles written by older encoders are sorted by ID instead, and are sorted here once.
+    if (!sorted)
+    {
+        std::sort(refs, refs + refCount);
     }
 
     // Keep file open for faster reading later.
@@ -250,6 +619,18 @@ Bundle* Bundle::create(const char* path)
     bundle->_references = refs;
     bundle->_stream = stream;
 
+    // Index the refs by offset, since nodes are identified by their offset while they are read.
+    bundle->_referenceOffsets.resize(refCount);
+    for (unsigned int i = 0; i < refCount; ++i)
+    {
+        bundle->_referenceOffsets[i] = std::make_pair(refs[i].offset, i);
+    }
+    std::sort(bundle->_referenceOffsets.begin(), bundle->_referenceOffsets.end());
+
+    // Add to the cache.
+    Mutex::Lock lock(__bundleCacheMutex);
+    __bundleCache.insert(std::make_pair(pathHash, bundle));
+
     return bundle;
 }
 
@@ -258,13 +639,31 @@ Bundle::Reference* Bundle::find(const char* id) const
     GP_ASSERT(id);
     GP_ASSERT(_references);
 
-    // Search the ref table for the given id (case-sensitive).
-    for (unsigned int i = 0; i < _referenceCount; ++i)
+    // Binary search the ref table for the first ref with the hash of the id.
+    unsigned int hash = hashString(id);
+    unsigned int first = 0;
+    unsigned int count = _referenceCount;
+    while (count > 0)
+    {
+        unsigned int step = count / 2;
+        if (_references[first + step].hash < hash)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    // Compare the ids of the refs with the same hash (case-sensitive).
+    for (; first < _referenceCount && _references[first].hash == hash; ++first)
     {
-        if (_references[i].id == id)
+        if (_references[first].id == id)
         {
             // Found a match
-            return &_references[i];
+            return &_references[first];
         }
     }
 
@@ -292,11 +691,14 @@ const char* Bundle::getIdFromOffset(unsigned int offset) const
     if (offset > 0)
     {
         GP_ASSERT(_references);
-        for (unsigned int i = 0; i < _referenceCount; ++i)
+        std::vector<std::pair<unsigned int, unsigned int> >::const_iterator itr =
+            std::lower_bound(_referenceOffsets.begin(), _referenceOffsets.end(), std::make_pair(offset, 0u));
+        for (; itr != _referenceOffsets.end() && itr->first == offset; ++itr)
         {
-            if (_references[i].offset == offset && _references[i].id.length() > 0)
+            const Reference& ref = _references[itr->second];
+            if (ref.id.length() > 0)
             {
-                return _references[i].id.c_str();
+                return ref.id.c_str();
             }
         }
     }
@@ -391,6 +793,8 @@ bool Bundle::readMatrix(float* m)
 
 Scene* Bundle::loadScene(const char* id)
 {
+    GP_PROFILE_SCOPE("Bundle::loadScene");
+
     clearLoadSession();
 
     Reference* ref = NULL;
@@ -472,7 +876,7 @@ Scene* Bundle::loadScene(const char* id)
     // Parse animations.
     GP_ASSERT(_references);
     GP_ASSERT(_stream);
-    for (unsigned int i = 0; i < _referenceCount; ++i)
+    for (unsigned int i = 0; i < _referenceCount && (_loadFlags & LOAD_SKIP_ANIMATIONS) == 0; ++i)
     {
         Reference* ref = &_references[i];
         if (ref->type == BUNDLE_TYPE_ANIMATIONS)
@@ -502,6 +906,7 @@ Node* Bundle::loadNode(const char* id, Scene* sceneContext)
     GP_ASSERT(id);
     GP_ASSERT(_references);
     GP_ASSERT(_stream);
+    GP_PROFILE_SCOPE("Bundle::loadNode");
 
     clearLoadSession();
 
@@ -512,7 +917,7 @@ Node* Bundle::loadNode(const char* id, Scene* sceneContext)
         resolveJointReferences(sceneContext, node);
 
     // Load all animations targeting any nodes or mesh skins under this node's hierarchy.
-    for (unsigned int i = 0; i < _referenceCount; i++)
+    for (unsigned int i = 0; i < _referenceCount && (_loadFlags & LOAD_SKIP_ANIMATIONS) == 0; i++)
     {
         Reference* ref = &_references[i];
         if (ref->type == BUNDLE_TYPE_ANIMATIONS)
@@ -559,17 +964,18 @@ Node* Bundle::loadNode(const char* id, Scene* sceneContext)
                     }
 
                     // If the target is one of the loaded nodes/joints, then load the animation.
+                    // Read target attribute.
+                    unsigned int targetAttribute;
+                    if (!read(&targetAttribute))
+                    {
+                        GP_ERROR("Failed to read target attribute for animation '%s'.", id.c_str());
+                        SAFE_DELETE(_trackedNodes);
+                        return NULL;
+                    }
+
                     std::map<std::string, Node*>::iterator iter = _trackedNodes->find(targetId);
-                    if (iter != _trackedNodes->end())
+                    if (iter != _trackedNodes->end() && isChannelLoaded(id.c_str(), targetId.c_str(), targetAttribute))
                     {
-                        // Read target attribute.
-                        unsigned int targetAttribute;
-                        if (!read(&targetAttribute))
-                        {
-                            GP_ERROR("Failed to read target attribute for animation '%s'.", id.c_str());
-                            SAFE_DELETE(_trackedNodes);
-                            return NULL;
-                        }
 
                         AnimationTarget* target = iter->second;
                         if (!target)
@@ -583,18 +989,13 @@ Node* Bundle::loadNode(const char* id, Scene* sceneContext)
                     }
                     else
                     {
-                        // Skip over the target attribute.
-                        unsigned int data;
-                        if (!read(&data))
+                        // Skip the animation channel.
+                        unsigned long duration;
+                        if (!skipAnimationChannelData(id.c_str(), &duration))
                         {
-                            GP_ERROR("Failed to skip over target attribute for animation '%s'.", id.c_str());
                             SAFE_DELETE(_trackedNodes);
                             return NULL;
                         }
-
-                        // Skip the animation channel (passing a target attribute of
-                        // 0 causes the animation to not be created).
-                        readAnimationChannelData(NULL, id.c_str(), NULL, 0);
                     }
                 }
             }
@@ -1021,6 +1422,37 @@ Model* Bundle::readModel(const char* nodeId)
                     }
                 }
             }
+            // Read the levels of detail.
+            if (getVersionMajor() >= BUNDLE_VERSION_MAJOR_LOD_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_LOD_FORMAT)
+            {
+                unsigned int lodCount;
+                if (!read(&lodCount))
+                {
+                    GP_ERROR("Failed to load LOD count for model with mesh '%s' in bundle '%s'.", xref.c_str() + 1, _path.c_str());
+                    SAFE_RELEASE(model);
+                    return NULL;
+                }
+                for (unsigned int i = 0; i < lodCount; ++i)
+                {
+                    std::string lodXref = readString(_stream);
+                    float screenSize;
+                    if (!read(&screenSize))
+                    {
+                        GP_ERROR("Failed to load LOD screen size for model with mesh '%s' in bundle '%s'.", xref.c_str() + 1, _path.c_str());
+                        SAFE_RELEASE(model);
+                        return NULL;
+                    }
+                    if (lodXref.length() > 1 && lodXref[0] == '#')
+                    {
+                        Mesh* lodMesh = loadMesh(lodXref.c_str() + 1, nodeId);
+                        if (lodMesh)
+                        {
+                            model->addLod(lodMesh, screenSize);
+                            SAFE_RELEASE(lodMesh);
+                        }
+                    }
+                }
+            }
             return model;
         }
     }
@@ -1235,6 +1667,8 @@ void Bundle::readAnimation(Scene* scene)
 
 void Bundle::readAnimations(Scene* scene)
 {
+    MemoryTracker::Scope scope(MemoryTracker::ANIMATION);
+
     // Read the number of animations in this object.
     unsigned int animationCount;
     if (!read(&animationCount))
@@ -1253,6 +1687,8 @@ Animation* Bundle::readAnimationChannel(Scene* scene, Animation* animation, cons
 {
     GP_ASSERT(animationId);
 
+    MemoryTracker::Scope scope(MemoryTracker::ANIMATION);
+
     // Read target id.
     std::string targetId = readString(_stream);
     if (targetId.empty())
@@ -1269,6 +1705,13 @@ Animation* Bundle::readAnimationChannel(Scene* scene, Animation* animation, cons
         return NULL;
     }
 
+    // Skip the channels rejected by the filter.
+    if (!isChannelLoaded(animationId, targetId.c_str(), targetAttribute))
+    {
+        unsigned long duration;
+        return skipAnimationChannelData(animationId, &duration) ? animation : NULL;
+    }
+
     AnimationTarget* target = NULL;
 
     // Search for a node that matches the target.
@@ -1289,6 +1732,152 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
 {
     GP_ASSERT(id);
 
+    if (targetAttribute == 0)
+    {
+        unsigned long duration;
+        return skipAnimationChannelData(id, &duration) ? animation : NULL;
+    }
+    GP_ASSERT(target);
+
+    Curve* curve = NULL;
+    unsigned long duration;
+    long offset = -1L;
+    if (_loadFlags & LOAD_LAZY_ANIMATIONS)
+    {
+        // Read the duration only, and the keys when the animation is first played.
+        offset = _stream->position();
+        if (offset == -1L || !skipAnimationChannelData(id, &duration))
+            return NULL;
+    }
+    else
+    {
+        curve = readAnimationCurve(id, target, targetAttribute, &duration);
+        if (curve == NULL)
+            return NULL;
+    }
+
+    if (animation == NULL)
+    {
+        animation = new Animation(id, target, targetAttribute, curve, duration);
+    }
+    else
+    {
+        animation->createChannel(target, targetAttribute, curve, duration);
+    }
+    SAFE_RELEASE(curve);
+
+    if (offset != -1L)
+    {
+        animation->_channels.back()->_curveOffset = offset;
+        if (animation->_bundle == NULL)
+        {
+            animation->_bundle = this;
+            addRef();
+        }
+    }
+
+    return animation;
+}
+
+bool Bundle::skipAnimationChannelData(const char* id, unsigned long* duration)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(duration);
+
+    unsigned int format = BUNDLE_ANIMATION_FORMAT_FLOAT;
+    if (getVersionMajor() >= BUNDLE_VERSION_MAJOR_ANIMATION_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_ANIMATION_FORMAT)
+    {
+        if (!read(&format))
+        {
+            GP_ERROR("Failed to read the channel format for animation '%s'.", id);
+            return false;
+        }
+    }
+    if (format != BUNDLE_ANIMATION_FORMAT_FLOAT && format != BUNDLE_ANIMATION_FORMAT_QUANTIZED)
+    {
+        GP_ERROR("Unsupported channel format %u for animation '%s'.", format, id);
+        return false;
+    }
+
+    // Read the first and last key times for the duration.
+    unsigned int keyTimesCount;
+    unsigned int first = 0;
+    unsigned int last = 0;
+    if (!read(&keyTimesCount) || (keyTimesCount > 0 && !read(&first)) ||
+        (keyTimesCount > 2 && !_stream->seek((keyTimesCount - 2) * sizeof(unsigned int), SEEK_CUR)) || (keyTimesCount > 1 && !read(&last)))
+    {
+        GP_ERROR("Failed to read key times for animation '%s'.", id);
+        return false;
+    }
+    *duration = keyTimesCount > 1 ? last - first : 0L;
+
+    // Skip the key values, and the tangents and interpolations, or the layout and ranges.
+    unsigned int arrayCount = format == BUNDLE_ANIMATION_FORMAT_FLOAT ? 4 : 2;
+    if (format == BUNDLE_ANIMATION_FORMAT_QUANTIZED && !_stream->seek(2 * sizeof(unsigned int), SEEK_CUR))
+    {
+        GP_ERROR("Failed to skip the key data of animation '%s'.", id);
+        return false;
+    }
+    for (unsigned int i = 0; i < arrayCount; ++i)
+    {
+        unsigned int length;
+        size_t elementSize = (format == BUNDLE_ANIMATION_FORMAT_QUANTIZED && i == 1) ? sizeof(unsigned short) : sizeof(float);
+        if (!read(&length) || (length > 0 && !_stream->seek(length * elementSize, SEEK_CUR)))
+        {
+            GP_ERROR("Failed to skip the key data of animation '%s'.", id);
+            return false;
+        }
+    }
+    return true;
+}
+
+Curve* Bundle::loadAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, long offset)
+{
+    GP_ASSERT(_stream);
+    MemoryTracker::Scope scope(MemoryTracker::ANIMATION);
+
+    long position = _stream->position();
+    if (position == -1L || _stream->seek(offset, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to seek to the keys of animation '%s' in bundle '%s'.", id, _path.c_str());
+        return NULL;
+    }
+
+    unsigned long duration;
+    Curve* curve = readAnimationCurve(id, target, targetAttribute, &duration);
+
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading the keys of animation '%s'.", id);
+    }
+    return curve;
+}
+
+Curve* Bundle::readAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, unsigned long* duration)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(target);
+
+    // In bundle version 1.5 we added a format field for quantized channels
+    unsigned int format = BUNDLE_ANIMATION_FORMAT_FLOAT;
+    if (getVersionMajor() >= BUNDLE_VERSION_MAJOR_ANIMATION_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_ANIMATION_FORMAT)
+    {
+        if (!read(&format))
+        {
+            GP_ERROR("Failed to read the channel format for animation '%s'.", id);
+            return NULL;
+        }
+    }
+    if (format == BUNDLE_ANIMATION_FORMAT_QUANTIZED)
+    {
+        return readQuantizedAnimationCurve(id, target, targetAttribute, duration);
+    }
+    else if (format != BUNDLE_ANIMATION_FORMAT_FLOAT)
+    {
+        GP_ERROR("Unsupported channel format %u for animation '%s'.", format, id);
+        return NULL;
+    }
+
     std::vector<unsigned int> keyTimes;
     std::vector<float> values;
     std::vector<float> tangentsIn;
@@ -1337,33 +1926,104 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
         return NULL;
     }
 
-    if (targetAttribute > 0)
-    {
-        GP_ASSERT(target);
-        GP_ASSERT(keyTimes.size() > 0 && values.size() > 0);
-        if (animation == NULL)
-        {
-            // TODO: This code currently assumes LINEAR only.
-            animation = target->createAnimation(id, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR);
-        }
-        else
-        {
-            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR);
-        }
-    }
+    GP_ASSERT(keyTimes.size() > 0 && values.size() > 0);
 
-    return animation;
+    // TODO: This code currently assumes LINEAR only.
+    return Animation::createCurve(target, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR, duration);
 }
 
-Mesh* Bundle::loadMesh(const char* id)
+Curve* Bundle::readQuantizedAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, unsigned long* duration)
 {
-    return loadMesh(id, NULL);
+    GP_ASSERT(id);
+    GP_ASSERT(target);
+    GP_ASSERT(duration);
+
+    std::vector<unsigned int> keyTimes;
+    std::vector<float> ranges;
+    std::vector<unsigned short> values;
+    unsigned int keyTimesCount;
+    unsigned int componentCount;
+    unsigned int quaternionOffset;
+    unsigned int rangesCount;
+    unsigned int valuesCount;
+
+    // Read key times.
+    if (!readArray(&keyTimesCount, &keyTimes, sizeof(unsigned int)))
+    {
+        GP_ERROR("Failed to read key times for animation '%s'.", id);
+        return NULL;
+    }
+
+    // Read the layout of the key values.
+    if (!read(&componentCount) || !read(&quaternionOffset))
+    {
+        GP_ERROR("Failed to read the key value layout for animation '%s'.", id);
+        return NULL;
+    }
+
+    // Read the component ranges.
+    if (!readArray(&rangesCount, &ranges))
+    {
+        GP_ERROR("Failed to read the key value ranges for animation '%s'.", id);
+        return NULL;
+    }
+
+    // Read the quantized key values.
+    if (!readArray(&valuesCount, &values))
+    {
+        GP_ERROR("Failed to read key values for animation '%s'.", id);
+        return NULL;
+    }
+
+    // Each quaternion is stored in three values, and each other component in one value with a range.
+    bool hasQuaternion = quaternionOffset != BUNDLE_ANIMATION_NO_QUATERNION;
+    unsigned int scalarCount = hasQuaternion ? componentCount - 4 : componentCount;
+    if (keyTimesCount == 0 || componentCount != target->getAnimationPropertyComponentCount(targetAttribute) ||
+        (hasQuaternion && (componentCount < 4 || quaternionOffset > componentCount - 4)) ||
+        rangesCount != scalarCount * 2 || valuesCount != keyTimesCount * (hasQuaternion ? componentCount - 1 : componentCount))
+    {
+        GP_ERROR("Invalid quantized key values for animation '%s'.", id);
+        return NULL;
+    }
+
+    // Normalize the key times over the duration of the channel.
+    unsigned int lowest = keyTimes[0];
+    *duration = keyTimes[keyTimesCount - 1] - lowest;
+    std::vector<float> times(keyTimesCount, 0.0f);
+    for (unsigned int i = 1; i < keyTimesCount; i++)
+    {
+        times[i] = (i == keyTimesCount - 1) ? 1.0f : (float)(keyTimes[i] - lowest) / (float)*duration;
+    }
+
+    // TODO: This code currently assumes LINEAR only.
+    Curve* curve = Curve::createQuantized(keyTimesCount, componentCount, hasQuaternion ? (int)quaternionOffset : -1, Curve::LINEAR,
+                                          &times[0], ranges.empty() ? NULL : &ranges[0], &values[0]);
+    return curve;
+}
+
+Mesh* Bundle::loadMesh(const char* id)
+{
+    return loadMesh(id, NULL);
 }
 
 Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
 {
     GP_ASSERT(_stream);
     GP_ASSERT(id);
+    GP_PROFILE_SCOPE("Bundle::loadMesh");
+    MemoryTracker::Scope scope(MemoryTracker::MESH);
+
+    // Use the mesh uploaded by an asynchronous load, if there is one.
+    if (_meshCache)
+    {
+        std::multimap<std::string, Mesh*>::iterator itr = _meshCache->find(id);
+        if (itr != _meshCache->end())
+        {
+            Mesh* mesh = itr->second;
+            _meshCache->erase(itr);
+            return mesh;
+        }
+    }
 
     // Save the file position.
     long position = _stream->position();
@@ -1381,8 +2041,9 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
         return NULL;
     }
 
-    // Read mesh data.
-    MeshData* meshData = readMeshData();
+    // Read mesh data, uploading vertices and indices straight from the bundle's memory mapping.
+    // Deferred meshes read their data when they are first drawn.
+    MeshData* meshData = readMeshData(_stream, true, (_loadFlags & LOAD_DEFERRED_MESHES) != 0);
     if (meshData == NULL)
     {
         GP_ERROR("Failed to load mesh data for mesh '%s'.", id);
@@ -1390,11 +2051,29 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
     }
 
     // Create mesh.
+    Mesh* mesh = createMesh(id, meshData);
+    SAFE_DELETE(meshData);
+
+    // Restore file pointer.
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
+        SAFE_RELEASE(mesh);
+        return NULL;
+    }
+
+    return mesh;
+}
+
+Mesh* Bundle::createMesh(const char* id, MeshData* meshData)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(meshData);
+
     Mesh* mesh = Mesh::createMesh(meshData->vertexFormat, meshData->vertexCount, false);
     if (mesh == NULL)
     {
         GP_ERROR("Failed to create mesh '%s'.", id);
-        SAFE_DELETE_ARRAY(meshData);
         return NULL;
     }
 
@@ -1402,7 +2081,14 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
     mesh->_url += "#";
     mesh->_url += id;
 
-    mesh->setVertexData((float*)meshData->vertexData, 0, meshData->vertexCount);
+    if (meshData->vertexData)
+    {
+        mesh->setVertexData((float*)meshData->vertexData, 0, meshData->vertexCount);
+    }
+    else
+    {
+        mesh->_deferred = true;
+    }
 
     mesh->_boundingBox.set(meshData->boundingBox);
     mesh->_boundingSphere.set(meshData->boundingSphere);
@@ -1417,19 +2103,13 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
         if (part == NULL)
         {
             GP_ERROR("Failed to create mesh part (with index %d) for mesh '%s'.", i, id);
-            SAFE_DELETE(meshData);
+            SAFE_RELEASE(mesh);
             return NULL;
         }
-        part->setIndexData(partData->indexData, 0, partData->indexCount);
-    }
-
-    SAFE_DELETE(meshData);
-
-    // Restore file pointer.
-    if (_stream->seek(position, SEEK_SET) == false)
-    {
-        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
-        return NULL;
+        if (partData->indexData)
+        {
+            part->setIndexData(partData->indexData, 0, partData->indexCount);
+        }
     }
 
     return mesh;
@@ -1437,9 +2117,18 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
 
 Bundle::MeshData* Bundle::readMeshData()
 {
+    return readMeshData(_stream);
+}
+
+Bundle::MeshData* Bundle::readMeshData(Stream* stream, bool mapped, bool headerOnly) const
+{
+    GP_ASSERT(stream);
+
+    MemoryTracker::Scope scope(MemoryTracker::MESH);
+
     // Read vertex format/elements.
     unsigned int vertexElementCount;
-    if (_stream->read(&vertexElementCount, 4, 1) != 1)
+    if (stream->read(&vertexElementCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex element count.");
         return NULL;
@@ -1450,17 +2139,19 @@ Bundle::MeshData* Bundle::readMeshData()
         return NULL;
     }
 
+    bool elementTypes = getVersionMajor() >= BUNDLE_VERSION_MAJOR_VERTEX_TYPE_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_VERTEX_TYPE_FORMAT;
+    bool supported = true;
     VertexFormat::Element* vertexElements = new VertexFormat::Element[vertexElementCount];
     for (unsigned int i = 0; i < vertexElementCount; ++i)
     {
         unsigned int vUsage, vSize;
-        if (_stream->read(&vUsage, 4, 1) != 1)
+        if (stream->read(&vUsage, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex usage.");
             SAFE_DELETE_ARRAY(vertexElements);
             return NULL;
         }
-        if (_stream->read(&vSize, 4, 1) != 1)
+        if (stream->read(&vSize, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex size.");
             SAFE_DELETE_ARRAY(vertexElements);
@@ -1469,44 +2160,153 @@ Bundle::MeshData* Bundle::readMeshData()
 
         vertexElements[i].usage = (VertexFormat::Usage)vUsage;
         vertexElements[i].size = vSize;
+
+        if (elementTypes)
+        {
+            unsigned int vType;
+            unsigned char vNormalized;
+            if (stream->read(&vType, 4, 1) != 1 || stream->read(&vNormalized, 1, 1) != 1)
+            {
+                GP_ERROR("Failed to load vertex type.");
+                SAFE_DELETE_ARRAY(vertexElements);
+                return NULL;
+            }
+            vertexElements[i].type = (VertexFormat::Type)vType;
+            vertexElements[i].normalized = vNormalized != 0;
+            if (!VertexFormat::isTypeSupported(vertexElements[i].type))
+                supported = false;
+        }
     }
 
+    // Read the encoding of the vertex and index data.
+    unsigned int encoding = BUNDLE_MESH_ENCODING_RAW;
+    if (getVersionMajor() >= BUNDLE_VERSION_MAJOR_MESH_ENCODING_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_MESH_ENCODING_FORMAT)
+    {
+        if (stream->read(&encoding, 4, 1) != 1)
+        {
+            GP_ERROR("Failed to load mesh encoding.");
+            SAFE_DELETE_ARRAY(vertexElements);
+            return NULL;
+        }
+        if (encoding != BUNDLE_MESH_ENCODING_RAW && encoding != BUNDLE_MESH_ENCODING_COMPRESSED)
+        {
+            GP_ERROR("Unsupported mesh encoding %u.", encoding);
+            SAFE_DELETE_ARRAY(vertexElements);
+            return NULL;
+        }
+    }
+    bool compressed = encoding == BUNDLE_MESH_ENCODING_COMPRESSED;
+
     MeshData* meshData = new MeshData(VertexFormat(vertexElements, vertexElementCount));
-    SAFE_DELETE_ARRAY(vertexElements);
 
     // Read vertex data.
     unsigned int vertexByteCount;
-    if (_stream->read(&vertexByteCount, 4, 1) != 1)
+    if (stream->read(&vertexByteCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex byte count.");
+        SAFE_DELETE_ARRAY(vertexElements);
         SAFE_DELETE(meshData);
         return NULL;
     }
     if (vertexByteCount == 0)
     {
         GP_ERROR("Failed to load mesh data; invalid vertex byte count of 0.");
+        SAFE_DELETE_ARRAY(vertexElements);
         SAFE_DELETE(meshData);
         return NULL;
     }
 
     GP_ASSERT(meshData->vertexFormat.getVertexSize());
     meshData->vertexCount = vertexByteCount / meshData->vertexFormat.getVertexSize();
-    meshData->vertexData = new unsigned char[vertexByteCount];
-    if (_stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+    if (headerOnly)
     {
-        GP_ERROR("Failed to load vertex data.");
+        if (!skipBytes(stream, compressed, vertexByteCount))
+        {
+            GP_ERROR("Failed to skip vertex data.");
+            SAFE_DELETE_ARRAY(vertexElements);
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
+    }
+    else if (compressed)
+    {
+        // Decode the compressed vertices, splitting each vertex in components of 1, 2 or 4 bytes.
+        std::vector<unsigned char> componentSizes;
+        for (unsigned int i = 0; i < vertexElementCount; ++i)
+        {
+            unsigned int componentSize = vertexElements[i].type == VertexFormat::UNSIGNED_BYTE ? 1 : (vertexElements[i].type == VertexFormat::HALF_FLOAT ? 2 : 4);
+            componentSizes.insert(componentSizes.end(), vertexElements[i].getByteSize() / componentSize, (unsigned char)componentSize);
+        }
+
+        unsigned int encodedByteCount = 0;
+        std::vector<unsigned char> buffer;
+        const unsigned char* encoded = NULL;
+        meshData->vertexData = new unsigned char[vertexByteCount];
+        if (!readBytes(stream, buffer, &encoded, &encodedByteCount) || !decodeMeshStream(encoded, encodedByteCount, meshData->vertexData, meshData->vertexCount,
+            meshData->vertexFormat.getVertexSize(), &componentSizes))
+        {
+            GP_ERROR("Failed to decode compressed vertex data.");
+            SAFE_DELETE_ARRAY(vertexElements);
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
+    }
+    else if (mapped && (meshData->vertexData = readMapped(stream, vertexByteCount)) != NULL)
+    {
+        meshData->mapped = true;
+    }
+    else
+    {
+        meshData->vertexData = new unsigned char[vertexByteCount];
+        if (stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+        {
+            GP_ERROR("Failed to load vertex data.");
+            SAFE_DELETE_ARRAY(vertexElements);
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
+    }
+
+    // Expand packed vertex elements to floats if the graphics driver can't read them.
+    if (!supported)
+    {
+        VertexFormat::Element* floatElements = new VertexFormat::Element[vertexElementCount];
+        for (unsigned int i = 0; i < vertexElementCount; ++i)
+        {
+            floatElements[i] = VertexFormat::Element(vertexElements[i].usage, vertexElements[i].size);
+        }
+        MeshData* floatData = new MeshData(VertexFormat(floatElements, vertexElementCount));
+        SAFE_DELETE_ARRAY(floatElements);
+
+        unsigned int vertexSize = meshData->vertexFormat.getVertexSize();
+        unsigned int floatVertexSize = floatData->vertexFormat.getVertexSize();
+        floatData->vertexCount = meshData->vertexCount;
+        if (meshData->vertexData)
+            floatData->vertexData = new unsigned char[floatVertexSize * meshData->vertexCount];
+        for (unsigned int i = 0; i < meshData->vertexCount && meshData->vertexData; ++i)
+        {
+            const unsigned char* src = meshData->vertexData + i * vertexSize;
+            float* dst = (float*)(floatData->vertexData + i * floatVertexSize);
+            for (unsigned int j = 0; j < vertexElementCount; ++j)
+            {
+                VertexFormat::toFloat(vertexElements[j], src, dst);
+                src += vertexElements[j].getByteSize();
+                dst += vertexElements[j].size;
+            }
+        }
         SAFE_DELETE(meshData);
-        return NULL;
+        meshData = floatData;
     }
+    SAFE_DELETE_ARRAY(vertexElements);
 
     // Read mesh bounds (bounding box and bounding sphere).
-    if (_stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || _stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
+    if (stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
     {
         GP_ERROR("Failed to load mesh bounding box.");
         SAFE_DELETE(meshData);
         return NULL;
     }
-    if (_stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || _stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
+    if (stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh bounding sphere.");
         SAFE_DELETE(meshData);
@@ -1515,7 +2315,7 @@ Bundle::MeshData* Bundle::readMeshData()
 
     // Read mesh parts.
     unsigned int meshPartCount;
-    if (_stream->read(&meshPartCount, 4, 1) != 1)
+    if (stream->read(&meshPartCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh part count.");
         SAFE_DELETE(meshData);
@@ -1525,19 +2325,19 @@ Bundle::MeshData* Bundle::readMeshData()
     {
         // Read primitive type, index format and index count.
         unsigned int pType, iFormat, iByteCount;
-        if (_stream->read(&pType, 4, 1) != 1)
+        if (stream->read(&pType, 4, 1) != 1)
         {
             GP_ERROR("Failed to load primitive type for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iFormat, 4, 1) != 1)
+        if (stream->read(&iFormat, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index format for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iByteCount, 4, 1) != 1)
+        if (stream->read(&iByteCount, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index byte count for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
@@ -1570,12 +2370,41 @@ Bundle::MeshData* Bundle::readMeshData()
         GP_ASSERT(indexSize);
         partData->indexCount = iByteCount / indexSize;
 
-        partData->indexData = new unsigned char[iByteCount];
-        if (_stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+        if (headerOnly)
         {
-            GP_ERROR("Failed to read index data for mesh part with index %d.", i);
-            SAFE_DELETE(meshData);
-            return NULL;
+            if (!skipBytes(stream, compressed, iByteCount))
+            {
+                GP_ERROR("Failed to skip index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
+        }
+        else if (compressed)
+        {
+            unsigned int encodedByteCount = 0;
+            std::vector<unsigned char> buffer;
+            const unsigned char* encoded = NULL;
+            partData->indexData = new unsigned char[iByteCount];
+            if (!readBytes(stream, buffer, &encoded, &encodedByteCount) || !decodeMeshStream(encoded, encodedByteCount, partData->indexData, partData->indexCount, indexSize, NULL))
+            {
+                GP_ERROR("Failed to decode compressed index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
+        }
+        else if (mapped && (partData->indexData = readMapped(stream, iByteCount)) != NULL)
+        {
+            partData->mapped = true;
+        }
+        else
+        {
+            partData->indexData = new unsigned char[iByteCount];
+            if (stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+            {
+                GP_ERROR("Failed to read index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
         }
     }
 
@@ -1793,6 +2622,127 @@ Font* Bundle::loadFont(const char* id)
     return masterFont;
 }
 
+NavMesh* Bundle::loadNavMesh(const char* id)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(_stream);
+
+    // Seek to the specified navigation mesh.
+    Reference* ref = seekTo(id, BUNDLE_TYPE_NAVMESH);
+    if (ref == NULL)
+    {
+        GP_ERROR("Failed to load ref for navigation mesh '%s'.", id);
+        return NULL;
+    }
+
+    // Read the vertex positions.
+    unsigned int count;
+    std::vector<float> positions;
+    if (!readArray(&count, &positions) || count % 3 != 0)
+    {
+        GP_ERROR("Failed to read vertices for navigation mesh '%s'.", id);
+        return NULL;
+    }
+
+    NavMesh* navMesh = new NavMesh(id);
+    navMesh->_vertices.resize(count / 3);
+    for (unsigned int i = 0; i < count / 3; ++i)
+    {
+        navMesh->_vertices[i].set(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+    }
+
+    // Read the triangles and the triangles adjacent to each of their edges.
+    unsigned int neighborCount;
+    if (!readArray(&count, &navMesh->_indices) || count % 3 != 0 ||
+        !readArray(&neighborCount, &navMesh->_neighbors) || neighborCount != count)
+    {
+        GP_ERROR("Failed to read triangles for navigation mesh '%s'.", id);
+        SAFE_RELEASE(navMesh);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (navMesh->_indices[i] >= navMesh->_vertices.size() || navMesh->_neighbors[i] >= (int)(count / 3))
+        {
+            GP_ERROR("Invalid triangle data for navigation mesh '%s'.", id);
+            SAFE_RELEASE(navMesh);
+            return NULL;
+        }
+    }
+
+    navMesh->computeGrid();
+
+    return navMesh;
+}
+
+VisibilitySet* Bundle::loadVisibilitySet(const char* id, Scene* scene)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(scene);
+    GP_ASSERT(_stream);
+
+    // Seek to the specified visibility set.
+    Reference* ref = seekTo(id, BUNDLE_TYPE_VISIBILITYSET);
+    if (ref == NULL)
+    {
+        GP_ERROR("Failed to load ref for visibility set '%s'.", id);
+        return NULL;
+    }
+
+    // Read the grid.
+    float values[4];
+    unsigned int dimensions[3];
+    if (_stream->read(values, sizeof(float), 4) != 4 || !read(&dimensions[0]) || !read(&dimensions[1]) || !read(&dimensions[2]) ||
+        values[3] <= 0.0f)
+    {
+        GP_ERROR("Failed to read grid for visibility set '%s'.", id);
+        return NULL;
+    }
+
+    VisibilitySet* visibilitySet = new VisibilitySet(id);
+    visibilitySet->_origin.set(values[0], values[1], values[2]);
+    visibilitySet->_cellSize = values[3];
+    visibilitySet->_dimensions[0] = dimensions[0];
+    visibilitySet->_dimensions[1] = dimensions[1];
+    visibilitySet->_dimensions[2] = dimensions[2];
+
+    // Read the nodes, which are looked up in the scene.
+    unsigned int nodeCount;
+    if (!read(&nodeCount))
+    {
+        GP_ERROR("Failed to read nodes for visibility set '%s'.", id);
+        SAFE_RELEASE(visibilitySet);
+        return NULL;
+    }
+    visibilitySet->_nodes.resize(nodeCount, NULL);
+    for (unsigned int i = 0; i < nodeCount; ++i)
+    {
+        std::string nodeId = readString(_stream);
+        Node* node = scene->findNode(nodeId.c_str());
+        if (node)
+        {
+            node->addRef();
+            visibilitySet->_nodes[i] = node;
+        }
+        else
+        {
+            GP_WARN("Failed to find node '%s' of visibility set '%s'.", nodeId.c_str(), id);
+        }
+    }
+
+    // Read the visible nodes of each cell, one bit per node.
+    unsigned int count;
+    visibilitySet->_stride = (nodeCount + 7) / 8;
+    if (!readArray(&count, &visibilitySet->_bits) || count != visibilitySet->getCellCount() * visibilitySet->_stride)
+    {
+        GP_ERROR("Failed to read cells for visibility set '%s'.", id);
+        SAFE_RELEASE(visibilitySet);
+        return NULL;
+    }
+
+    return visibilitySet;
+}
+
 void Bundle::setTransform(const float* values, Transform* transform)
 {
     GP_ASSERT(transform);
@@ -1823,8 +2773,289 @@ const char* Bundle::getObjectId(unsigned int index) const
     return (index >= _referenceCount ? NULL : _references[index].id.c_str());
 }
 
+void Bundle::loadSceneAsync(const char* id, SceneLoadCallback callback, void* cookie)
+{
+    loadAsync(id, true, NULL, callback, cookie);
+}
+
+void Bundle::loadNodeAsync(const char* id, NodeLoadCallback callback, void* cookie)
+{
+    GP_ASSERT(id);
+    loadAsync(id, false, callback, NULL, cookie);
+}
+
+void Bundle::loadAsync(const char* id, bool scene, NodeLoadCallback nodeCallback, SceneLoadCallback sceneCallback, void* cookie)
+{
+    AsyncLoad* load = new AsyncLoad();
+    load->bundle = this;
+    addRef();
+    load->id = id ? id : "";
+    load->scene = scene;
+    load->nodeCallback = nodeCallback;
+    load->sceneCallback = sceneCallback;
+    load->cookie = cookie;
+    _asyncLoads.push_back(load);
+
+    load->thread = Thread::create(decodeAsyncLoad, load);
+    if (load->thread == NULL)
+    {
+        // Fall back to reading everything on the game thread.
+        GP_WARN("Failed to start loading thread for bundle '%s'.", _path.c_str());
+        Mutex::Lock lock(_asyncMutex);
+        load->decoded = true;
+    }
+}
+
+unsigned int Bundle::getAsyncLoadCount()
+{
+    return (unsigned int)_asyncLoads.size();
+}
+
+void Bundle::setAsyncLoadBudget(float milliseconds)
+{
+    _asyncLoadBudget = milliseconds;
+}
+
+int Bundle::decodeAsyncLoad(void* arg)
+{
+    AsyncLoad* load = (AsyncLoad*)arg;
+    GP_ASSERT(load);
+    GP_ASSERT(load->bundle);
+
+    // Use a separate stream so the game thread can keep reading from the bundle.
+    Bundle* bundle = load->bundle;
+    std::vector<std::pair<std::string, MeshData*> > meshData;
+    Stream* stream = FileSystem::open(bundle->_path.c_str());
+    if (stream)
+    {
+        std::vector<std::string> meshIds;
+        if (!bundle->scanMeshes(stream, load->id.empty() ? NULL : load->id.c_str(), load->scene, meshIds))
+        {
+            GP_WARN("Failed to find the meshes of '%s' in bundle '%s'.", load->id.c_str(), bundle->_path.c_str());
+        }
+        // Deferred meshes are created on the game thread without their data.
+        if (bundle->_loadFlags & LOAD_DEFERRED_MESHES)
+            meshIds.clear();
+        for (size_t i = 0, count = meshIds.size(); i < count; ++i)
+        {
+            Reference* ref = bundle->find(meshIds[i].c_str());
+            if (ref && ref->type == BUNDLE_TYPE_MESH && stream->seek(ref->offset, SEEK_SET))
+            {
+                meshData.push_back(std::make_pair(meshIds[i], bundle->readMeshData(stream)));
+            }
+        }
+        SAFE_DELETE(stream);
+    }
+
+    Mutex::Lock lock(_asyncMutex);
+    load->meshData.swap(meshData);
+    load->decoded = true;
+    return 0;
+}
+
+bool Bundle::scanMeshes(Stream* stream, const char* id, bool scene, std::vector<std::string>& meshIds) const
+{
+    GP_ASSERT(stream);
+
+    unsigned int type = scene ? BUNDLE_TYPE_SCENE : BUNDLE_TYPE_NODE;
+    Reference* ref = NULL;
+    if (id)
+    {
+        ref = find(id);
+        if (ref && ref->type != type)
+            ref = NULL;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < _referenceCount && ref == NULL; ++i)
+        {
+            if (_references[i].type == type)
+                ref = &_references[i];
+        }
+    }
+    if (ref == NULL || stream->seek(ref->offset, SEEK_SET) == false)
+        return false;
+
+    if (!scene)
+        return scanNodeMeshes(stream, meshIds);
+
+    unsigned int childrenCount;
+    if (stream->read(&childrenCount, 4, 1) != 1)
+        return false;
+    for (unsigned int i = 0; i < childrenCount; ++i)
+    {
+        if (!scanNodeMeshes(stream, meshIds))
+            return false;
+    }
+    return true;
+}
+
+bool Bundle::scanNodeMeshes(Stream* stream, std::vector<std::string>& meshIds) const
+{
+    GP_ASSERT(stream);
+
+    // Skip the node's type, transform and parent ID.
+    if (stream->seek(sizeof(unsigned int) + sizeof(float) * 16, SEEK_CUR) == false)
+        return false;
+    readString(stream);
+
+    unsigned int childrenCount;
+    if (stream->read(&childrenCount, 4, 1) != 1)
+        return false;
+    for (unsigned int i = 0; i < childrenCount; ++i)
+    {
+        if (!scanNodeMeshes(stream, meshIds))
+            return false;
+    }
+
+    // Skip the camera (aspect ratio, near and far plane, then field of view or zoom).
+    unsigned char type;
+    if (stream->read(&type, 1, 1) != 1)
+        return false;
+    if (type != 0 && stream->seek(sizeof(float) * (type == Camera::PERSPECTIVE ? 4 : 5), SEEK_CUR) == false)
+        return false;
+
+    // Skip the light (color, then range and cone angles).
+    if (stream->read(&type, 1, 1) != 1)
+        return false;
+    if (type != 0)
+    {
+        unsigned int floatCount = 3 + (type == Light::POINT ? 1 : (type == Light::SPOT ? 3 : 0));
+        if (stream->seek(sizeof(float) * floatCount, SEEK_CUR) == false)
+            return false;
+    }
+
+    // Read the model's mesh and skip its skin and materials, then read its LOD meshes.
+    std::string xref = readString(stream);
+    if (xref.length() > 1 && xref[0] == '#')
+    {
+        meshIds.push_back(xref.substr(1));
+
+        unsigned char hasSkin;
+        if (stream->read(&hasSkin, 1, 1) != 1)
+            return false;
+        if (hasSkin)
+        {
+            unsigned int jointCount;
+            if (stream->seek(sizeof(float) * 16, SEEK_CUR) == false || stream->read(&jointCount, 4, 1) != 1)
+                return false;
+            for (unsigned int i = 0; i < jointCount; ++i)
+            {
+                readString(stream);
+            }
+            unsigned int bindPoseCount;
+            if (stream->read(&bindPoseCount, 4, 1) != 1 || stream->seek(sizeof(float) * bindPoseCount, SEEK_CUR) == false)
+                return false;
+        }
+
+        unsigned int materialCount;
+        if (stream->read(&materialCount, 4, 1) != 1)
+            return false;
+        for (unsigned int i = 0; i < materialCount; ++i)
+        {
+            readString(stream);
+        }
+
+        if (getVersionMajor() >= BUNDLE_VERSION_MAJOR_LOD_FORMAT && getVersionMinor() >= BUNDLE_VERSION_MINOR_LOD_FORMAT)
+        {
+            unsigned int lodCount;
+            if (stream->read(&lodCount, 4, 1) != 1)
+                return false;
+            for (unsigned int i = 0; i < lodCount; ++i)
+            {
+                std::string lodXref = readString(stream);
+                if (lodXref.length() > 1 && lodXref[0] == '#')
+                    meshIds.push_back(lodXref.substr(1));
+                if (stream->seek(sizeof(float), SEEK_CUR) == false)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Bundle::updateAsyncLoads()
+{
+    double startTime = Game::getAbsoluteTime();
+    bool busy = false;
+    for (size_t i = 0; i < _asyncLoads.size();)
+    {
+        AsyncLoad* load = _asyncLoads[i];
+        bool decoded;
+        {
+            Mutex::Lock lock(_asyncMutex);
+            decoded = load->decoded;
+        }
+        if (!decoded)
+        {
+            ++i;
+            continue;
+        }
+        SAFE_DELETE(load->thread);
+
+        // Upload the decoded meshes one at a time until the budget is spent.
+        while (load->uploaded < load->meshData.size())
+        {
+            if (busy && Game::getAbsoluteTime() - startTime >= _asyncLoadBudget)
+                return;
+
+            std::pair<std::string, MeshData*>& entry = load->meshData[load->uploaded++];
+            if (entry.second)
+            {
+                Mesh* mesh = load->bundle->createMesh(entry.first.c_str(), entry.second);
+                if (mesh)
+                {
+                    load->meshes.insert(std::make_pair(entry.first, mesh));
+                }
+                SAFE_DELETE(entry.second);
+            }
+            busy = true;
+        }
+        if (busy && Game::getAbsoluteTime() - startTime >= _asyncLoadBudget)
+            return;
+
+        // Build the scene or node from the uploaded meshes. The load is removed first
+        // so the callback may start new loads.
+        _asyncLoads.erase(_asyncLoads.begin() + i);
+        Bundle* bundle = load->bundle;
+        const char* id = load->id.empty() ? NULL : load->id.c_str();
+        bundle->_meshCache = &load->meshes;
+        if (load->scene)
+        {
+            Scene* scene = bundle->loadScene(id);
+            bundle->_meshCache = NULL;
+            if (load->sceneCallback)
+            {
+                load->sceneCallback(bundle, scene, load->cookie);
+            }
+            SAFE_RELEASE(scene);
+        }
+        else
+        {
+            Node* node = bundle->loadNode(id);
+            bundle->_meshCache = NULL;
+            if (load->nodeCallback)
+            {
+                load->nodeCallback(bundle, node, load->cookie);
+            }
+            SAFE_RELEASE(node);
+        }
+        SAFE_DELETE(load);
+        busy = true;
+    }
+}
+
+void Bundle::cancelAsyncLoads()
+{
+    for (size_t i = 0, count = _asyncLoads.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_asyncLoads[i]);
+    }
+    _asyncLoads.clear();
+}
+
 Bundle::Reference::Reference()
-    : type(0), offset(0)
+    : type(0), offset(0), hash(0)
 {
 }
 
@@ -1832,24 +3063,37 @@ Bundle::Reference::~Reference()
 {
 }
 
+bool Bundle::Reference::operator<(const Reference& r) const
+{
+    if (hash != r.hash)
+        return hash < r.hash;
+    return id < r.id;
+}
+
 Bundle::MeshPartData::MeshPartData() :
-    indexCount(0), indexData(NULL)
+    indexCount(0), indexData(NULL), mapped(false)
 {
 }
 
 Bundle::MeshPartData::~MeshPartData()
 {
-    SAFE_DELETE_ARRAY(indexData);
+    if (!mapped)
+    {
+        SAFE_DELETE_ARRAY(indexData);
+    }
 }
 
 Bundle::MeshData::MeshData(const VertexFormat& vertexFormat)
-    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL)
+    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), mapped(false)
 {
 }
 
 Bundle::MeshData::~MeshData()
 {
-    SAFE_DELETE_ARRAY(vertexData);
+    if (!mapped)
+    {
+        SAFE_DELETE_ARRAY(vertexData);
+    }
 
     for (unsigned int i = 0; i < parts.size(); ++i)
     {
@@ -1857,4 +3101,25 @@ Bundle::MeshData::~MeshData()
     }
 }
 
+Bundle::AsyncLoad::AsyncLoad()
+    : bundle(NULL), scene(false), nodeCallback(NULL), sceneCallback(NULL), cookie(NULL), thread(NULL), decoded(false), uploaded(0)
+{
+}
+
+Bundle::AsyncLoad::~AsyncLoad()
+{
+    // Wait for the loading thread before freeing the data it writes.
+    SAFE_DELETE(thread);
+
+    for (size_t i = 0, count = meshData.size(); i < count; ++i)
+    {
+        SAFE_DELETE(meshData[i].second);
+    }
+    for (std::multimap<std::string, Mesh*>::iterator itr = meshes.begin(); itr != meshes.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    SAFE_RELEASE(bundle);
+}
+
 }
@@ -3,8 +3,11 @@
 
 #include "Mesh.h"
 #include "Font.h"
+#include "NavMesh.h"
+#include "VisibilitySet.h"
 #include "Node.h"
 #include "Game.h"
+#include "Thread.h"
 
 namespace gameplay
 {
@@ -15,11 +18,75 @@ namespace gameplay
  */
 class Bundle : public Ref
 {
+    friend class Game;
     friend class PhysicsController;
+    friend class Mesh;
     friend class SceneLoader;
+    friend class Animation;
+    friend class StaticGeometry;
 
 public:
 
+    /**
+     * Defines the flags that select what the scenes and nodes loaded from a bundle include.
+     */
+    enum LoadFlags
+    {
+        /**
+         * Loads everything.
+         */
+        LOAD_DEFAULT = 0,
+
+        /**
+         * Skips the animations, which saves their memory and load time when the game
+         * animates the nodes itself or does not play them.
+         */
+        LOAD_SKIP_ANIMATIONS = 1,
+
+        /**
+         * Creates the animation channels with their durations only, and reads the key data of the
+         * channels of an animation when one of its clips is first played (or the animation is cloned).
+         * The bundle is kept open while it has animations whose keys have not been read.
+         */
+        LOAD_LAZY_ANIMATIONS = 2,
+
+        /**
+         * Creates the meshes with their vertex formats, counts and bounds only, and reads their vertex
+         * and index data when they are first drawn. The meshes have no picking data until then.
+         */
+        LOAD_DEFERRED_MESHES = 4
+    };
+
+    /**
+     * Defines the filter that selects the animation channels loaded from a bundle.
+     *
+     * @param animationId The ID of the animation the channel belongs to.
+     * @param targetId The ID of the node the channel targets.
+     * @param targetAttribute The property of the node the channel targets.
+     * @param cookie The user data passed to Bundle::setAnimationChannelFilter.
+     *
+     * @return true to load the channel, false to skip it.
+     */
+    typedef bool (*AnimationChannelFilter)(const char* animationId, const char* targetId, unsigned int targetAttribute, void* cookie);
+
+    /**
+     * Defines the callback invoked when an asynchronous node load completes.
+     *
+     * @param bundle The bundle the node was loaded from.
+     * @param node The loaded node, or NULL if the node could not be loaded.
+     * @param cookie The user data passed to Bundle::loadNodeAsync.
+     */
+    typedef void (*NodeLoadCallback)(Bundle* bundle, Node* node, void* cookie);
+
+    /**
+     * Defines the callback invoked when an asynchronous scene load completes.
+     *
+     * @param bundle The bundle the scene was loaded from.
+     * @param scene The loaded scene, or NULL if the scene could not be loaded.
+     * @param cookie The user data passed to Bundle::loadSceneAsync.
+     */
+    typedef void (*SceneLoadCallback)(Bundle* bundle, Scene* scene, void* cookie);
+
     /**
      * Returns a Bundle for the given resource path.
      *
@@ -35,6 +102,30 @@ public:
      */
     static Bundle* create(const char* path);
 
+    /**
+     * Sets the flags that select what the scenes and nodes loaded from this bundle include.
+     *
+     * @param flags A combination of LoadFlags values (LOAD_DEFAULT by default).
+     */
+    void setLoadFlags(unsigned int flags);
+
+    /**
+     * Returns the flags that select what the scenes and nodes loaded from this bundle include.
+     *
+     * @return The combination of LoadFlags values.
+     */
+    unsigned int getLoadFlags() const;
+
+    /**
+     * Sets the filter that selects the animation channels loaded from this bundle, such as
+     * the channels of the joints a model actually uses.
+     *
+     * @param filter The filter, or NULL to load every channel.
+     * @param cookie The user data passed to the filter.
+     * @script{ignore}
+     */
+    void setAnimationChannelFilter(AnimationChannelFilter filter, void* cookie = NULL);
+
     /**
      * Loads the scene with the specified ID from the bundle.
      * If id is NULL then the first scene found is loaded.
@@ -76,6 +167,34 @@ public:
      */
     Font* loadFont(const char* id);
 
+    /**
+     * Loads a navigation mesh with the specified ID from the bundle.
+     *
+     * Navigation meshes are built by the encoder from the meshes of a scene (see
+     * the encoder's -nav option).
+     *
+     * @param id The ID of the navigation mesh to load.
+     *
+     * @return The loaded navigation mesh, or NULL if it could not be loaded.
+     * @script{ignore}
+     */
+    NavMesh* loadNavMesh(const char* id);
+
+    /**
+     * Loads a potentially visible set with the specified ID from the bundle.
+     *
+     * Visibility sets are built by the encoder from the static meshes of a scene (see
+     * the encoder's -pvs option). The nodes of the set are looked up by ID in the
+     * specified scene, which would normally have been loaded from this bundle.
+     *
+     * @param id The ID of the visibility set to load.
+     * @param scene The scene containing the nodes of the set.
+     *
+     * @return The loaded visibility set, or NULL if it could not be loaded.
+     * @script{ignore}
+     */
+    VisibilitySet* loadVisibilitySet(const char* id, Scene* scene);
+
     /**
      * Determines if this bundle contains a top-level object with the given ID.
      *
@@ -113,6 +232,58 @@ public:
      */
     unsigned int getVersionMinor() const;
 
+    /**
+     * Loads the scene with the specified ID from the bundle without blocking the game thread.
+     *
+     * The mesh data for the scene is read and decoded on a background thread. The meshes
+     * are then uploaded to the GPU and the scene is assembled on the game thread over one
+     * or more subsequent frames, limited by the time budget set with setAsyncLoadBudget().
+     * The callback is invoked on the game thread once the scene has been loaded. The scene
+     * is released after the callback returns, so the callback must call addRef() on the
+     * scene to keep it.
+     *
+     * The bundle is kept alive until the load completes.
+     *
+     * @param id The ID of the scene to load (NULL to load the first scene).
+     * @param callback The function to call when the scene has been loaded.
+     * @param cookie User data to pass to the callback.
+     * @script{ignore}
+     */
+    void loadSceneAsync(const char* id, SceneLoadCallback callback, void* cookie = NULL);
+
+    /**
+     * Loads a node with the specified ID from the bundle without blocking the game thread.
+     *
+     * This behaves like loadSceneAsync(), reading the meshes of the node and its children
+     * on a background thread. The node is released after the callback returns, so the
+     * callback must call addRef() on the node to keep it.
+     *
+     * @param id The ID of the node to load in the bundle.
+     * @param callback The function to call when the node has been loaded.
+     * @param cookie User data to pass to the callback.
+     * @script{ignore}
+     */
+    void loadNodeAsync(const char* id, NodeLoadCallback callback, void* cookie = NULL);
+
+    /**
+     * Returns the number of asynchronous loads that have not completed yet.
+     *
+     * @return The number of pending asynchronous loads across all bundles.
+     * @script{ignore}
+     */
+    static unsigned int getAsyncLoadCount();
+
+    /**
+     * Sets the time the game thread may spend each frame completing asynchronous loads.
+     *
+     * At least one mesh is uploaded per frame regardless of the budget so that loads
+     * always make progress. The default budget is 4 milliseconds.
+     *
+     * @param milliseconds The time budget per frame, in milliseconds.
+     * @script{ignore}
+     */
+    static void setAsyncLoadBudget(float milliseconds);
+
 private:
 
     class Reference
@@ -121,6 +292,7 @@ private:
         std::string id;
         unsigned int type;
         unsigned int offset;
+        unsigned int hash;
 
         /**
          * Constructor.
@@ -131,6 +303,11 @@ private:
          * Destructor.
          */
         ~Reference();
+
+        /**
+         * Orders references by the hash of their IDs, and then by their IDs.
+         */
+        bool operator<(const Reference& r) const;
     };
 
     struct MeshSkinData
@@ -149,6 +326,8 @@ private:
         Mesh::IndexFormat indexFormat;
         unsigned int indexCount;
         unsigned char* indexData;
+        // True if indexData points into the memory-mapped bundle rather than an owned buffer.
+        bool mapped;
     };
 
     struct MeshData
@@ -159,12 +338,37 @@ private:
         VertexFormat vertexFormat;
         unsigned int vertexCount;
         unsigned char* vertexData;
+        // True if vertexData points into the memory-mapped bundle rather than an owned buffer.
+        bool mapped;
         BoundingBox boundingBox;
         BoundingSphere boundingSphere;
         Mesh::PrimitiveType primitiveType;
         std::vector<MeshPartData*> parts;
     };
 
+    /**
+     * Defines an asynchronous scene or node load.
+     */
+    struct AsyncLoad
+    {
+        AsyncLoad();
+        ~AsyncLoad();
+
+        Bundle* bundle;
+        std::string id;
+        bool scene;
+        NodeLoadCallback nodeCallback;
+        SceneLoadCallback sceneCallback;
+        void* cookie;
+        Thread* thread;
+        // Written by the loading thread and read once 'decoded' is set (guarded by _asyncMutex).
+        std::vector<std::pair<std::string, MeshData*> > meshData;
+        bool decoded;
+        // Only accessed from the game thread.
+        size_t uploaded;
+        std::multimap<std::string, Mesh*> meshes;
+    };
+
     Bundle(const char* path);
 
     /**
@@ -178,7 +382,7 @@ private:
     Bundle& operator=(const Bundle&);
 
     /**
-     * Finds a reference by ID.
+     * Finds a reference by ID, by binary searching the reference table for the hash of the ID.
      */
     Reference* find(const char* id) const;
 
@@ -196,7 +400,7 @@ private:
     const char* getIdFromOffset() const;
 
     /**
-     * Returns the ID of the object at the given file offset by searching through the reference table.
+     * Returns the ID of the object at the given file offset by searching the offsets of the reference table.
      * Returns NULL if not found.
      *
      * @param offset The file offset.
@@ -254,6 +458,16 @@ private:
      */
     Mesh* loadMesh(const char* id, const char* nodeId);
 
+    /**
+     * Creates a mesh from decoded mesh data.
+     *
+     * @param id The ID of the mesh.
+     * @param meshData The mesh data to create the mesh from.
+     *
+     * @return The new mesh, or NULL if the mesh could not be created.
+     */
+    Mesh* createMesh(const char* id, MeshData* meshData);
+
     /**
      * Reads an unsigned int from the current file position.
      *
@@ -367,6 +581,21 @@ private:
      */
     MeshData* readMeshData();
 
+    /**
+     * Reads mesh data from the current position of the specified stream.
+     *
+     * This only reads the immutable version of the bundle, so it is safe to call from a loading thread.
+     *
+     * Vertex elements of types that the graphics driver doesn't support are converted to floats.
+     *
+     * @param stream The stream to read from.
+     * @param mapped True to point the vertex and index data directly into the stream's
+     *      memory mapping (if it has one) instead of copying it. The returned data is then
+     *      only valid while the stream is open.
+     * @param headerOnly True to skip over the vertex and index data, leaving it NULL, and read the rest only.
+     */
+    MeshData* readMeshData(Stream* stream, bool mapped = false, bool headerOnly = false) const;
+
     /**
      * Reads mesh data for the specified URL.
      *
@@ -427,6 +656,57 @@ private:
      */
     Animation* readAnimationChannelData(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute);
 
+    /**
+     * Reads the quantized key data of an animation channel at the current file position into a curve.
+     *
+     * @param id The ID of the animation that this channel is loaded into.
+     * @param target The animation target.
+     * @param targetAttribute The target attribute being animated.
+     * @param duration Set to the duration of the channel, in milliseconds.
+     *
+     * @return The curve, or NULL if there was an error.
+     */
+    Curve* readQuantizedAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, unsigned long* duration);
+
+    /**
+     * Reads the key data of an animation channel at the current file position into a curve.
+     *
+     * @param id The ID of the animation that this channel is loaded into.
+     * @param target The animation target.
+     * @param targetAttribute The target attribute being animated.
+     * @param duration Set to the duration of the channel, in milliseconds.
+     *
+     * @return The curve, or NULL if there was an error.
+     */
+    Curve* readAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, unsigned long* duration);
+
+    /**
+     * Skips over the key data of an animation channel at the current file position, reading its duration only.
+     *
+     * @param id The ID of the animation that this channel is loaded into.
+     * @param duration Set to the duration of the channel, in milliseconds.
+     *
+     * @return true if the channel was skipped, false if there was an error.
+     */
+    bool skipAnimationChannelData(const char* id, unsigned long* duration);
+
+    /**
+     * Reads the curve of a lazily loaded animation channel, restoring the file position.
+     *
+     * @param id The ID of the animation of the channel.
+     * @param target The animation target.
+     * @param targetAttribute The target attribute being animated.
+     * @param offset The offset of the key data of the channel.
+     *
+     * @return The curve, or NULL if there was an error.
+     */
+    Curve* loadAnimationCurve(const char* id, AnimationTarget* target, unsigned int targetAttribute, long offset);
+
+    /**
+     * Determines if an animation channel is loaded, as selected by the load flags and the channel filter.
+     */
+    bool isChannelLoaded(const char* animationId, const char* targetId, unsigned int targetAttribute) const;
+
     /**
      * Sets the transformation matrix.
      *
@@ -440,6 +720,44 @@ private:
      */
     void resolveJointReferences(Scene* sceneContext, Node* nodeContext);
 
+    /**
+     * Finds the IDs of the meshes used by the scene or node with the given ID, in the order they are loaded.
+     *
+     * This only reads the immutable reference table of the bundle, so it is safe to call from a loading thread.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    bool scanMeshes(Stream* stream, const char* id, bool scene, std::vector<std::string>& meshIds) const;
+
+    /**
+     * Finds the IDs of the meshes used by the node at the current stream position and its children.
+     */
+    bool scanNodeMeshes(Stream* stream, std::vector<std::string>& meshIds) const;
+
+    /**
+     * Entry point of the thread that reads and decodes the mesh data of an asynchronous load.
+     */
+    static int decodeAsyncLoad(void* arg);
+
+    /**
+     * Completes pending asynchronous loads within the per-frame time budget.
+     *
+     * Called by the game every frame.
+     */
+    static void updateAsyncLoads();
+
+    /**
+     * Waits for the loading threads and discards all pending asynchronous loads.
+     *
+     * Called by the game when it shuts down.
+     */
+    static void cancelAsyncLoads();
+
+    /**
+     * Starts an asynchronous load.
+     */
+    void loadAsync(const char* id, bool scene, NodeLoadCallback nodeCallback, SceneLoadCallback sceneCallback, void* cookie);
+
 private:
 
     /**
@@ -454,10 +772,19 @@ private:
     std::string _materialPath;
     unsigned int _referenceCount;
     Reference* _references;
+    std::vector<std::pair<unsigned int, unsigned int> > _referenceOffsets;
     Stream* _stream;
 
     std::vector<MeshSkinData*> _meshSkins;
     std::map<std::string, Node*>* _trackedNodes;
+    std::multimap<std::string, Mesh*>* _meshCache;
+    unsigned int _loadFlags;
+    AnimationChannelFilter _channelFilter;
+    void* _channelFilterCookie;
+
+    static std::vector<AsyncLoad*> _asyncLoads;
+    static Mutex _asyncMutex;
+    static float _asyncLoadBudget;
 };
 
 }
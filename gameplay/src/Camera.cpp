@@ -4,6 +4,7 @@
 #include "Node.h"
 #include "Game.h"
 #include "PhysicsController.h"
+#include "Thread.h"
 
 // Camera dirty bits
 #define CAMERA_DIRTY_VIEW 1
@@ -20,15 +21,21 @@
 namespace gameplay
 {
 
+// The last revision given to a camera. Revisions are unique across cameras, so that results cached
+// from a camera are out of date when the camera changes or another camera is used instead.
+static volatile unsigned int __revision = 0;
+
 Camera::Camera(float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
     : _type(PERSPECTIVE), _fieldOfView(fieldOfView), _aspectRatio(aspectRatio), _nearPlane(nearPlane), _farPlane(farPlane),
-    _bits(CAMERA_DIRTY_ALL), _node(NULL), _listeners(NULL)
+    _bits(CAMERA_DIRTY_ALL), _node(NULL), _listeners(NULL), _revision(Atomic::increment(&__revision)),
+    _captured(NULL), _listenersPending(false)
 {
 }
 
 Camera::Camera(float zoomX, float zoomY, float aspectRatio, float nearPlane, float farPlane)
     : _type(ORTHOGRAPHIC), _aspectRatio(aspectRatio), _nearPlane(nearPlane), _farPlane(farPlane),
-	_bits(CAMERA_DIRTY_ALL), _node(NULL), _listeners(NULL)
+	_bits(CAMERA_DIRTY_ALL), _node(NULL), _listeners(NULL), _revision(Atomic::increment(&__revision)),
+    _captured(NULL), _listenersPending(false)
 {
     // Orthographic camera.
     _zoom[0] = zoomX;
@@ -38,6 +45,7 @@ Camera::Camera(float zoomX, float zoomY, float aspectRatio, float nearPlane, flo
 Camera::~Camera()
 {
     SAFE_DELETE(_listeners);
+    SAFE_DELETE(_captured);
 }
 
 Camera* Camera::createPerspective(float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
@@ -236,6 +244,9 @@ void Camera::setNode(Node* node)
 
 const Matrix& Camera::getViewMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->view;
+
     if (_bits & CAMERA_DIRTY_VIEW)
     {
         if (_node)
@@ -256,6 +267,9 @@ const Matrix& Camera::getViewMatrix() const
 
 const Matrix& Camera::getInverseViewMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->inverseView;
+
     if (_bits & CAMERA_DIRTY_INV_VIEW)
     {
         getViewMatrix().invert(&_inverseView);
@@ -268,6 +282,9 @@ const Matrix& Camera::getInverseViewMatrix() const
 
 const Matrix& Camera::getProjectionMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->projection;
+
     if (!(_bits & CAMERA_CUSTOM_PROJECTION) && (_bits & CAMERA_DIRTY_PROJ))
     {
         if (_type == PERSPECTIVE)
@@ -308,6 +325,9 @@ void Camera::resetProjectionMatrix()
 
 const Matrix& Camera::getViewProjectionMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->viewProjection;
+
     if (_bits & CAMERA_DIRTY_VIEW_PROJ)
     {
         Matrix::multiply(getProjectionMatrix(), getViewMatrix(), &_viewProjection);
@@ -320,6 +340,9 @@ const Matrix& Camera::getViewProjectionMatrix() const
 
 const Matrix& Camera::getInverseViewProjectionMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->inverseViewProjection;
+
     if (_bits & CAMERA_DIRTY_INV_VIEW_PROJ)
     {
         getViewProjectionMatrix().invert(&_inverseViewProjection);
@@ -332,6 +355,9 @@ const Matrix& Camera::getInverseViewProjectionMatrix() const
 
 const Frustum& Camera::getFrustum() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->frustum;
+
     if (_bits & CAMERA_DIRTY_BOUNDS)
     {
         // Update our bounding frustum from our view projection matrix.
@@ -459,9 +485,26 @@ void Camera::transformChanged(Transform* transform, long cookie)
 
 void Camera::cameraChanged()
 {
+    _revision = Atomic::increment(&__revision);
+
+    // Changed while drawing a pipelined frame, so the captured matrices no longer apply.
+    if (_captured && Game::isRenderingCaptured())
+        _captured->current = false;
+
     if (_listeners == NULL)
         return;
 
+    if (Game::isSimulatingInParallel())
+    {
+        // The listeners (such as terrain patches) are drawing the previous frame, so they are called when the camera is captured.
+        _listenersPending = true;
+        return;
+    }
+    notifyListeners();
+}
+
+void Camera::notifyListeners()
+{
     for (std::list<Camera::Listener*>::iterator itr = _listeners->begin(); itr != _listeners->end(); ++itr)
     {
         Camera::Listener* listener = (*itr);
@@ -469,6 +512,48 @@ void Camera::cameraChanged()
     }
 }
 
+void Camera::capture()
+{
+    if (_listenersPending)
+    {
+        _listenersPending = false;
+        if (_listeners)
+            notifyListeners();
+    }
+
+    if (_captured == NULL)
+    {
+        _captured = new Captured();
+        _captured->revision = 0;
+    }
+    else if (_captured->revision == _revision)
+    {
+        _captured->current = true;
+        return;
+    }
+
+    _captured->current = false;
+    _captured->view = getViewMatrix();
+    _captured->projection = getProjectionMatrix();
+    _captured->viewProjection = getViewProjectionMatrix();
+    _captured->inverseView = getInverseViewMatrix();
+    _captured->inverseViewProjection = getInverseViewProjectionMatrix();
+    _captured->frustum = getFrustum();
+    _captured->revision = _revision;
+    _captured->current = true;
+}
+
+const Camera::Captured* Camera::getCaptured() const
+{
+    return _captured && _captured->current && Game::isRenderingCaptured() ? _captured : NULL;
+}
+
+unsigned int Camera::getRevision() const
+{
+    const Captured* captured = getCaptured();
+    return captured ? captured->revision : _revision;
+}
+
 void Camera::addListener(Camera::Listener* listener)
 {
     GP_ASSERT(listener);
@@ -19,6 +19,7 @@ class NodeCloneContext;
 class Camera : public Ref, public Transform::Listener
 {
     friend class Node;
+    friend class Scene;
 
 public:
 
@@ -363,6 +364,43 @@ private:
      */
     void cameraChanged();
 
+    /**
+     * Calls the listeners of the camera.
+     */
+    void notifyListeners();
+
+    /**
+     * Defines the matrices of a camera captured at the end of a pipelined frame, which are
+     * drawn while the next frame is simulated.
+     */
+    struct Captured
+    {
+        Matrix view;
+        Matrix projection;
+        Matrix viewProjection;
+        Matrix inverseView;
+        Matrix inverseViewProjection;
+        Frustum frustum;
+        unsigned int revision;
+        bool current;
+    };
+
+    /**
+     * Captures the matrices of the camera for the next pipelined frame, and calls the
+     * listeners that were held back while the frame was simulated. Called by Node and Scene.
+     */
+    void capture();
+
+    /**
+     * Returns the captured matrices if the calling thread draws them, or NULL otherwise.
+     */
+    const Captured* getCaptured() const;
+
+    /**
+     * Returns the revision of the matrices of the camera that the calling thread sees.
+     */
+    unsigned int getRevision() const;
+
     Camera::Type _type;
     float _fieldOfView;
     float _zoom[2];
@@ -378,6 +416,9 @@ private:
     mutable int _bits;
     Node* _node;
     std::list<Camera::Listener*>* _listeners;
+    unsigned int _revision;
+    Captured* _captured;
+    bool _listenersPending;
 };
 
 }
@@ -0,0 +1,433 @@
+#include "Base.h"
+#include "CommandBuffer.h"
+#include "Effect.h"
+#include "VertexAttributeBinding.h"
+#include "Game.h"
+#include "GLStateCache.h"
+#include "Model.h"
+#include "RenderQueue.h"
+
+namespace gameplay
+{
+
+static CommandBuffer* __recordingBuffer = NULL;
+static Thread::Id __recordingThread;
+static bool __executing = false;
+static Thread::Id __executingThread;
+
+CommandBuffer::CommandBuffer()
+    : _stateCount(0), _instanceBuffer(0)
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+    if (__recordingBuffer == this)
+    {
+        end();
+    }
+    reset();
+    for (size_t i = 0, count = _states.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_states[i]);
+    }
+    if (_instanceBuffer)
+    {
+        GL_ASSERT( glDeleteBuffers(1, &_instanceBuffer) );
+    }
+}
+
+void CommandBuffer::begin()
+{
+    GP_ASSERT(__recordingBuffer == NULL || __recordingBuffer == this);
+
+    reset();
+    __recordingThread = Thread::getCurrentId();
+    __recordingBuffer = this;
+}
+
+void CommandBuffer::end()
+{
+    GP_ASSERT(__recordingBuffer == this);
+
+    __recordingBuffer = NULL;
+}
+
+CommandBuffer* CommandBuffer::getRecording()
+{
+    return __recordingBuffer && Thread::isCurrent(__recordingThread) ? __recordingBuffer : NULL;
+}
+
+void CommandBuffer::call(Function function, void* arg)
+{
+    GP_ASSERT(function);
+
+    Command& command = add(CALL);
+    command.call.function = function;
+    command.call.arg = arg;
+}
+
+void* CommandBuffer::callWithData(Function function, size_t size)
+{
+    GP_ASSERT(function);
+
+    // The block is resolved when executing, since storing more data may move it.
+    unsigned int offset = (unsigned int)_data.size();
+    _data.resize(offset + ((size + 7) & ~(size_t)7));
+    Command& command = add(CALL_WITH_DATA);
+    command.callWithData.function = function;
+    command.callWithData.offset = offset;
+    return size > 0 ? &_data[offset] : NULL;
+}
+
+void CommandBuffer::retain(Ref* object)
+{
+    GP_ASSERT(object);
+
+    object->addRef();
+    _references.push_back(object);
+}
+
+void CommandBuffer::execute()
+{
+    GP_ASSERT(__recordingBuffer != this);
+
+    __executingThread = Thread::getCurrentId();
+    __executing = true;
+    for (size_t i = 0, count = _commands.size(); i < count; ++i)
+    {
+        const Command& command = _commands[i];
+        switch (command.type)
+        {
+        case BIND_EFFECT:
+            command.effect->bind();
+            break;
+
+        case SET_UNIFORM:
+        {
+            Uniform* uniform = command.uniform.uniform;
+            Effect* effect = uniform->getEffect();
+            const void* values = &_data[command.uniform.offset];
+            unsigned int valueCount = command.uniform.count;
+            switch (command.uniform.type)
+            {
+            case UNIFORM_FLOAT:
+                effect->setValue(uniform, (const float*)values, valueCount);
+                break;
+            case UNIFORM_INT:
+                effect->setValue(uniform, (const int*)values, valueCount);
+                break;
+            case UNIFORM_MATRIX:
+                effect->setValue(uniform, (const Matrix*)values, valueCount);
+                break;
+            case UNIFORM_VECTOR2:
+                effect->setValue(uniform, (const Vector2*)values, valueCount);
+                break;
+            case UNIFORM_VECTOR3:
+                effect->setValue(uniform, (const Vector3*)values, valueCount);
+                break;
+            case UNIFORM_VECTOR4:
+                effect->setValue(uniform, (const Vector4*)values, valueCount);
+                break;
+            }
+            break;
+        }
+
+        case SET_SAMPLERS:
+        {
+            Uniform* uniform = command.uniform.uniform;
+            const Texture::Sampler** samplers = (const Texture::Sampler**)&_data[command.uniform.offset];
+            if (command.uniform.count == 1)
+                uniform->getEffect()->setValue(uniform, samplers[0]);
+            else
+                uniform->getEffect()->setValue(uniform, samplers, command.uniform.count);
+            break;
+        }
+
+        case RESTORE_STATE:
+            RenderState::StateBlock::restore(command.stateBits);
+            break;
+
+        case BIND_STATE:
+            _states[command.stateIndex]->bindNoRestore();
+            break;
+
+        case BIND_VERTEX_ATTRIBUTES:
+            command.binding->bind();
+            break;
+
+        case UNBIND_VERTEX_ATTRIBUTES:
+            command.binding->unbind();
+            break;
+
+        case SET_VERTEX_ATTRIBUTE:
+            GL_ASSERT( glVertexAttrib4fv(command.attribute.index, (const GLfloat*)&_data[command.attribute.offset]) );
+            break;
+
+        case DRAW_ELEMENTS:
+            Game::countDrawCall(command.draw.mode, command.draw.count);
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, command.draw.indexBuffer);
+            if (!command.draw.wireframe || !Model::drawWireframe(command.draw.mode, command.draw.count, command.draw.indexFormat))
+            {
+                GL_ASSERT( glDrawElements(command.draw.mode, command.draw.count, command.draw.indexFormat, 0) );
+            }
+            break;
+
+        case DRAW_ARRAYS:
+            Game::countDrawCall(command.draw.mode, command.draw.count);
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            if (!command.draw.wireframe || !Model::drawWireframe(command.draw.mode, command.draw.count))
+            {
+                GL_ASSERT( glDrawArrays(command.draw.mode, 0, command.draw.count) );
+            }
+            break;
+
+        case DRAW_INSTANCED:
+            RenderQueue::drawInstancedGeometry(&_instanceBuffer, (const float*)&_data[command.instanced.offset], command.instanced.instanceCount,
+                command.instanced.attribute, command.instanced.mode, command.instanced.count, command.instanced.indexFormat, command.instanced.indexBuffer);
+            break;
+
+        case SET_FRAME_UNIFORMS:
+            RenderState::uploadFrameUniforms(*(const RenderState::FrameUniforms*)&_data[command.offset]);
+            break;
+
+        case SET_VIEWPORT:
+        {
+            // Game::_viewport was already set when this was recorded.
+            const float* values = (const float*)&_data[command.offset];
+            GL_ASSERT( glViewport((GLuint)values[0], (GLuint)values[1], (GLuint)values[2], (GLuint)values[3]) );
+            break;
+        }
+
+        case CLEAR:
+        {
+            const float* values = (const float*)&_data[command.clear.offset];
+            Game::getInstance()->clear((Game::ClearFlags)command.clear.flags, Vector4(values), values[4], command.clear.stencil);
+            break;
+        }
+
+        case CALL:
+            command.call.function(command.call.arg);
+            break;
+
+        case CALL_WITH_DATA:
+            command.callWithData.function(_data.empty() ? NULL : &_data[0] + command.callWithData.offset);
+            break;
+        }
+    }
+    __executing = false;
+}
+
+void CommandBuffer::reset()
+{
+    _commands.clear();
+    _data.clear();
+    for (size_t i = 0, count = _references.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_references[i]);
+    }
+    _references.clear();
+    _stateCount = 0;
+}
+
+unsigned int CommandBuffer::getCommandCount() const
+{
+    return (unsigned int)_commands.size();
+}
+
+bool CommandBuffer::isExecuting()
+{
+    return __executing && Thread::isCurrent(__executingThread);
+}
+
+CommandBuffer::Command& CommandBuffer::add(CommandType type)
+{
+    _commands.push_back(Command());
+    Command& command = _commands.back();
+    command.type = type;
+    return command;
+}
+
+unsigned int CommandBuffer::store(const void* data, size_t size)
+{
+    // Keep every value aligned for the widest type stored (pointers and floats).
+    unsigned int offset = (unsigned int)_data.size();
+    _data.resize(offset + ((size + 7) & ~(size_t)7));
+    memcpy(&_data[offset], data, size);
+    return offset;
+}
+
+void CommandBuffer::bindEffect(Effect* effect)
+{
+    GP_ASSERT(effect);
+
+    // The uniforms recorded after this command belong to the effect, which is kept alive here.
+    effect->addRef();
+    _references.push_back(effect);
+    add(BIND_EFFECT).effect = effect;
+}
+
+void CommandBuffer::setUniform(Uniform* uniform, UniformType type, const void* values, unsigned int count)
+{
+    GP_ASSERT(uniform);
+    GP_ASSERT(values);
+
+    size_t size;
+    switch (type)
+    {
+    case UNIFORM_INT:
+        size = sizeof(int);
+        break;
+    case UNIFORM_MATRIX:
+        size = sizeof(Matrix);
+        break;
+    case UNIFORM_VECTOR2:
+        size = sizeof(Vector2);
+        break;
+    case UNIFORM_VECTOR3:
+        size = sizeof(Vector3);
+        break;
+    case UNIFORM_VECTOR4:
+        size = sizeof(Vector4);
+        break;
+    default:
+        size = sizeof(float);
+        break;
+    }
+
+    unsigned int offset = store(values, size * count);
+    Command& command = add(SET_UNIFORM);
+    command.uniform.uniform = uniform;
+    command.uniform.type = type;
+    command.uniform.count = count;
+    command.uniform.offset = offset;
+}
+
+void CommandBuffer::setSamplers(Uniform* uniform, const Texture::Sampler* const* samplers, unsigned int count)
+{
+    GP_ASSERT(uniform);
+    GP_ASSERT(samplers);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        GP_ASSERT(samplers[i]);
+
+        // Streamed levels are requested now, while the screen size of the drawn model is known.
+        Texture* texture = samplers[i]->getTexture();
+        if (texture && texture->_streamed)
+        {
+            texture->requestStreamingLevel();
+        }
+        const_cast<Texture::Sampler*>(samplers[i])->addRef();
+        _references.push_back(const_cast<Texture::Sampler*>(samplers[i]));
+    }
+
+    unsigned int offset = store(samplers, sizeof(const Texture::Sampler*) * count);
+    Command& command = add(SET_SAMPLERS);
+    command.uniform.uniform = uniform;
+    command.uniform.count = count;
+    command.uniform.offset = offset;
+}
+
+void CommandBuffer::restoreState(long stateOverrideBits)
+{
+    add(RESTORE_STATE).stateBits = stateOverrideBits;
+}
+
+void CommandBuffer::bindState(RenderState::StateBlock* state)
+{
+    GP_ASSERT(state);
+
+    // Copy the state, since the block may change before the buffer is executed.
+    if (_stateCount == _states.size())
+    {
+        _states.push_back(RenderState::StateBlock::create());
+    }
+    state->cloneInto(_states[_stateCount]);
+    add(BIND_STATE).stateIndex = _stateCount++;
+}
+
+void CommandBuffer::bindVertexAttributes(VertexAttributeBinding* binding)
+{
+    GP_ASSERT(binding);
+
+    binding->addRef();
+    _references.push_back(binding);
+    add(BIND_VERTEX_ATTRIBUTES).binding = binding;
+}
+
+void CommandBuffer::unbindVertexAttributes(VertexAttributeBinding* binding)
+{
+    GP_ASSERT(binding);
+
+    // The binding is referenced by the bind command before it.
+    add(UNBIND_VERTEX_ATTRIBUTES).binding = binding;
+}
+
+void CommandBuffer::setVertexAttribute(GLuint index, const float* values)
+{
+    GP_ASSERT(values);
+
+    unsigned int offset = store(values, sizeof(float) * 4);
+    Command& command = add(SET_VERTEX_ATTRIBUTE);
+    command.attribute.index = index;
+    command.attribute.offset = offset;
+}
+
+void CommandBuffer::drawElements(GLenum mode, GLsizei count, GLenum indexFormat, IndexBufferHandle indexBuffer, bool wireframe)
+{
+    Command& command = add(DRAW_ELEMENTS);
+    command.draw.mode = mode;
+    command.draw.count = count;
+    command.draw.indexFormat = indexFormat;
+    command.draw.indexBuffer = indexBuffer;
+    command.draw.wireframe = wireframe;
+}
+
+void CommandBuffer::drawArrays(GLenum mode, GLsizei count, bool wireframe)
+{
+    Command& command = add(DRAW_ARRAYS);
+    command.draw.mode = mode;
+    command.draw.count = count;
+    command.draw.wireframe = wireframe;
+}
+
+void CommandBuffer::drawInstanced(GLenum mode, GLsizei count, GLenum indexFormat, IndexBufferHandle indexBuffer,
+                                  VertexAttribute attribute, const float* matrices, unsigned int instanceCount)
+{
+    GP_ASSERT(matrices);
+    GP_ASSERT(instanceCount > 0);
+
+    unsigned int offset = store(matrices, sizeof(float) * 16 * instanceCount);
+    Command& command = add(DRAW_INSTANCED);
+    command.instanced.mode = mode;
+    command.instanced.count = count;
+    command.instanced.indexFormat = indexFormat;
+    command.instanced.indexBuffer = indexBuffer;
+    command.instanced.attribute = attribute;
+    command.instanced.instanceCount = instanceCount;
+    command.instanced.offset = offset;
+}
+
+void CommandBuffer::setFrameUniforms(const RenderState::FrameUniforms& uniforms)
+{
+    add(SET_FRAME_UNIFORMS).offset = store(&uniforms, sizeof(RenderState::FrameUniforms));
+}
+
+void CommandBuffer::setViewport(const Rectangle& viewport)
+{
+    float values[4] = { viewport.x, viewport.y, viewport.width, viewport.height };
+    add(SET_VIEWPORT).offset = store(values, sizeof(values));
+}
+
+void CommandBuffer::clear(int flags, const Vector4& color, float depth, int stencil)
+{
+    float values[5] = { color.x, color.y, color.z, color.w, depth };
+    unsigned int offset = store(values, sizeof(values));
+    Command& command = add(CLEAR);
+    command.clear.flags = flags;
+    command.clear.offset = offset;
+    command.clear.stencil = stencil;
+}
+
+}
@@ -0,0 +1,305 @@
+#ifndef COMMANDBUFFER_H_
+#define COMMANDBUFFER_H_
+
+#include "RenderState.h"
+#include "Rectangle.h"
+#include "Vector4.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+class Effect;
+class Uniform;
+class VertexAttributeBinding;
+
+/**
+ * Defines a buffer of recorded drawing commands that can be executed later, on another thread.
+ *
+ * While a command buffer is recording, the drawing done by the engine on the recording thread
+ * (binding effects, setting uniforms, changing renderer state, binding vertex attributes,
+ * drawing models, mesh and sprite batches, fonts, forms, particles and debug lines, clearing
+ * and setting the viewport) is recorded into the buffer instead of being sent to OpenGL. The values of the uniforms, including those computed by auto bindings,
+ * are copied as they are recorded, so the scene can change as soon as recording ends.
+ * Executing the buffer then makes the recorded calls in the same order, on the thread that
+ * holds the graphics context.
+ *
+ * Recording makes no graphics calls at all, so only the drawing listed above can be recorded.
+ * Anything else that needs the context (updating shadow maps, creating or uploading resources...)
+ * must either happen while the buffer is not recording or be deferred with call(). Cached forms
+ * are recorded as uncached forms, since their frame buffer can't be bound by a recorded frame.
+ *
+ * A command buffer holds references to the effects, samplers and vertex attribute bindings
+ * it recorded until it is reset, so reset it (or record into it again) where the graphics
+ * context is current, since this may release the last reference to them. The same goes for
+ * destroying it, which also deletes the buffer it streams instance matrices through.
+ *
+ * @see Game::setRenderThreaded
+ *
+ * @script{ignore}
+ */
+class CommandBuffer
+{
+    friend class Effect;
+    friend class RenderState;
+    friend class VertexAttributeBinding;
+    friend class Model;
+    friend class MeshBatch;
+    friend class RenderQueue;
+    friend class Game;
+    friend class RenderThread;
+
+public:
+
+    /**
+     * Defines the signature of a function that can be called from a command buffer.
+     *
+     * @param arg The argument passed to call().
+     */
+    typedef void (*Function)(void* arg);
+
+    /**
+     * Constructor.
+     */
+    CommandBuffer();
+
+    /**
+     * Destructor.
+     */
+    ~CommandBuffer();
+
+    /**
+     * Resets the buffer and starts recording the drawing done by the calling thread.
+     *
+     * Only one command buffer can be recording at a time.
+     */
+    void begin();
+
+    /**
+     * Stops recording.
+     */
+    void end();
+
+    /**
+     * Returns the command buffer recording the drawing done by the calling thread.
+     *
+     * @return The command buffer, or NULL if the drawing of the calling thread is not recorded.
+     */
+    static CommandBuffer* getRecording();
+
+    /**
+     * Records a call to the specified function.
+     *
+     * The function is called when the buffer is executed, with the graphics context current,
+     * so it can draw anything. When the buffer is executed by the render thread, the game
+     * thread is meanwhile simulating the next frame, so the function must only read data
+     * that the game thread does not change, or copies of it taken while recording.
+     *
+     * @param function The function to call.
+     * @param arg The argument to pass to the function.
+     */
+    void call(Function function, void* arg);
+
+    /**
+     * Records a call to the specified function, with a block of data stored in the buffer.
+     *
+     * This is used to defer drawing that reads data the game thread changes: the data is
+     * copied into the returned block while recording, and the function is called with a
+     * pointer to the block when the buffer is executed.
+     *
+     * @param function The function to call.
+     * @param size The size of the block, in bytes.
+     *
+     * @return The block to fill, which is only valid until the next command is recorded.
+     */
+    void* callWithData(Function function, size_t size);
+
+    /**
+     * Keeps a reference to the specified object until the buffer is reset.
+     *
+     * This keeps alive the objects used by the functions recorded with call() or callWithData().
+     *
+     * @param object The object to keep.
+     */
+    void retain(Ref* object);
+
+    /**
+     * Executes the recorded commands.
+     *
+     * The graphics context must be current on the calling thread.
+     */
+    void execute();
+
+    /**
+     * Removes all the recorded commands and releases the objects they referenced.
+     */
+    void reset();
+
+    /**
+     * Returns the number of recorded commands.
+     *
+     * @return The number of commands.
+     */
+    unsigned int getCommandCount() const;
+
+    /**
+     * Determines if a command buffer is being executed by the calling thread.
+     *
+     * @return true while execute() runs on the calling thread.
+     */
+    static bool isExecuting();
+
+private:
+
+    /**
+     * Defines the types of recorded commands.
+     */
+    enum CommandType
+    {
+        BIND_EFFECT,
+        SET_UNIFORM,
+        SET_SAMPLERS,
+        RESTORE_STATE,
+        BIND_STATE,
+        BIND_VERTEX_ATTRIBUTES,
+        UNBIND_VERTEX_ATTRIBUTES,
+        SET_VERTEX_ATTRIBUTE,
+        DRAW_ELEMENTS,
+        DRAW_ARRAYS,
+        DRAW_INSTANCED,
+        SET_FRAME_UNIFORMS,
+        SET_VIEWPORT,
+        CLEAR,
+        CALL,
+        CALL_WITH_DATA
+    };
+
+    /**
+     * Defines the types of uniform values.
+     */
+    enum UniformType
+    {
+        UNIFORM_FLOAT,
+        UNIFORM_INT,
+        UNIFORM_MATRIX,
+        UNIFORM_VECTOR2,
+        UNIFORM_VECTOR3,
+        UNIFORM_VECTOR4
+    };
+
+    /**
+     * Defines a recorded command. Values that do not fit are stored in the data of the buffer.
+     */
+    struct Command
+    {
+        CommandType type;
+        union
+        {
+            Effect* effect;
+            VertexAttributeBinding* binding;
+            long stateBits;
+            unsigned int stateIndex;
+            struct
+            {
+                Uniform* uniform;
+                UniformType type;
+                unsigned int count;
+                unsigned int offset;
+            } uniform;
+            struct
+            {
+                GLuint index;
+                unsigned int offset;
+            } attribute;
+            struct
+            {
+                GLenum mode;
+                GLsizei count;
+                GLenum indexFormat;
+                IndexBufferHandle indexBuffer;
+                bool wireframe;
+            } draw;
+            struct
+            {
+                GLenum mode;
+                GLsizei count;
+                GLenum indexFormat;
+                IndexBufferHandle indexBuffer;
+                VertexAttribute attribute;
+                unsigned int instanceCount;
+                unsigned int offset;
+            } instanced;
+            struct
+            {
+                int flags;
+                unsigned int offset;
+                int stencil;
+            } clear;
+            struct
+            {
+                Function function;
+                void* arg;
+            } call;
+            struct
+            {
+                Function function;
+                unsigned int offset;
+            } callWithData;
+            unsigned int offset;
+        };
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    CommandBuffer(const CommandBuffer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    CommandBuffer& operator=(const CommandBuffer&);
+
+    Command& add(CommandType type);
+
+    unsigned int store(const void* data, size_t size);
+
+    void bindEffect(Effect* effect);
+
+    void setUniform(Uniform* uniform, UniformType type, const void* values, unsigned int count);
+
+    void setSamplers(Uniform* uniform, const Texture::Sampler* const* samplers, unsigned int count);
+
+    void restoreState(long stateOverrideBits);
+
+    void bindState(RenderState::StateBlock* state);
+
+    void bindVertexAttributes(VertexAttributeBinding* binding);
+
+    void unbindVertexAttributes(VertexAttributeBinding* binding);
+
+    void setVertexAttribute(GLuint index, const float* values);
+
+    void drawElements(GLenum mode, GLsizei count, GLenum indexFormat, IndexBufferHandle indexBuffer, bool wireframe = false);
+
+    void drawArrays(GLenum mode, GLsizei count, bool wireframe = false);
+
+    void drawInstanced(GLenum mode, GLsizei count, GLenum indexFormat, IndexBufferHandle indexBuffer,
+                       VertexAttribute attribute, const float* matrices, unsigned int instanceCount);
+
+    void setFrameUniforms(const RenderState::FrameUniforms& uniforms);
+
+    void setViewport(const Rectangle& viewport);
+
+    void clear(int flags, const Vector4& color, float depth, int stencil);
+
+    std::vector<Command> _commands;
+    std::vector<unsigned char> _data;
+    std::vector<Ref*> _references;
+    std::vector<RenderState::StateBlock*> _states;
+    unsigned int _stateCount;
+    VertexBufferHandle _instanceBuffer;
+};
+
+}
+
+#endif
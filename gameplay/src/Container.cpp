@@ -238,6 +238,8 @@ unsigned int Container::addControl(Control* control)
 	}
 
 	control->_parent = this;
+	control->setDirty(DIRTY_BOUNDS);
+	invalidateFormHitGrid();
 
 	sortControls();
 
@@ -259,6 +261,8 @@ void Container::insertControl(Control* control, unsigned int index)
         _controls.insert(it, control);
         control->addRef();
         control->_parent = this;
+        control->setDirty(DIRTY_BOUNDS);
+        invalidateFormHitGrid();
     }
 }
 
@@ -268,6 +272,7 @@ void Container::removeControl(unsigned int index)
 
     std::vector<Control*>::iterator it = _controls.begin() + index;
     Control* control = *it;
+    invalidateFormHitGrid();
     _controls.erase(it);
     control->_parent = NULL;
 
@@ -513,7 +518,12 @@ void Container::update(float elapsedTime)
     Control::update(elapsedTime);
 
     for (size_t i = 0, count = _controls.size(); i < count; ++i)
-        _controls[i]->update(elapsedTime);
+    {
+        // Children that are clipped out of view are not updated until they come back into view.
+        Control* ctrl = _controls[i];
+        if (!ctrl->_absoluteClipBounds.isEmpty() || ctrl->isDirty(DIRTY_STATE))
+            ctrl->update(elapsedTime);
+    }
 }
 
 void Container::updateState(State state)
@@ -619,10 +629,24 @@ bool Container::updateChildBounds()
         Control* ctrl = _controls[i];
         GP_ASSERT(ctrl);
 
-        if (ctrl->isVisible())
+        if (ctrl->isVisible() && (ctrl->_dirtyBits & (DIRTY_BOUNDS | DIRTY_CHILD_BOUNDS)))
         {
+            // Children that lie outside of our viewport are only laid out as the form layout budget
+            // allows; until then they are treated as clipped out and keep their dirty bits.
+            if (isOutsideViewport(ctrl) && !Form::consumeLayoutBudget())
+            {
+                ctrl->_absoluteClipBounds.set(0, 0, 0, 0);
+                setChildBoundsDirty();
+                continue;
+            }
+
+            bool clipped = ctrl->_absoluteClipBounds.isEmpty();
             bool changed = ctrl->updateBoundsInternal(_scrollPosition);
 
+            // Bring children that were clipped out of view (and so skipped by update) up to date.
+            if (clipped && !ctrl->_absoluteClipBounds.isEmpty())
+                ctrl->update(0.0f);
+
             // If the child bounds have changed, dirty our bounds and all of our
             // parent bounds so that our layout and/or bounds are recomputed.
             if (changed)
@@ -642,6 +666,22 @@ bool Container::updateChildBounds()
     return result;
 }
 
+bool Container::isOutsideViewport(Control* control) const
+{
+    // Predict where the child will be from its last computed size and its current position.
+    float x = control->_bounds.x;
+    float y = control->_bounds.y;
+    if (control->_alignment == ALIGN_TOP_LEFT)
+    {
+        if (!control->isXPercentage())
+            x = control->_relativeBounds.x;
+        if (!control->isYPercentage())
+            y = control->_relativeBounds.y;
+    }
+    Rectangle bounds(_viewportBounds.x + _scrollPosition.x + x, _viewportBounds.y + _scrollPosition.y + y, control->_bounds.width, control->_bounds.height);
+    return !bounds.intersects(_viewportClipBounds);
+}
+
 unsigned int Container::draw(Form* form, const Rectangle& clip)
 {
     if (!_visible)
@@ -654,7 +694,7 @@ unsigned int Container::draw(Form* form, const Rectangle& clip)
     for (size_t i = 0, count = _controls.size(); i < count; ++i)
     {
         Control* control = _controls[i];
-        if (control && control->_absoluteClipBounds.intersects(_absoluteClipBounds))
+        if (control && !control->_absoluteClipBounds.isEmpty() && control->_absoluteClipBounds.intersects(_absoluteClipBounds))
         {
             drawCalls += control->draw(form, _viewportClipBounds);
         }
@@ -1072,27 +1112,7 @@ void Container::updateScroll()
     const Theme::Padding& containerPadding = getPadding();
 
     // Calculate total width and height.
-    _totalWidth = _totalHeight = 0.0f;
-    std::vector<Control*> controls = getControls();
-    for (size_t i = 0, count = controls.size(); i < count; ++i)
-    {
-        Control* control = _controls[i];
-
-        const Rectangle& bounds = control->getBounds();
-        const Theme::Margin& margin = control->getMargin();
-
-        float newWidth = bounds.x + bounds.width + margin.right;
-        if (newWidth > _totalWidth)
-        {
-            _totalWidth = newWidth;
-        }
-
-        float newHeight = bounds.y + bounds.height + margin.bottom;
-        if (newHeight > _totalHeight)
-        {
-            _totalHeight = newHeight;
-        }
-    }
+    getContentSize(&_totalWidth, &_totalHeight);
 
     float vWidth = getImageRegion("verticalScrollBar", state).width;
     float hHeight = getImageRegion("horizontalScrollBar", state).height;
@@ -1188,14 +1208,48 @@ void Container::updateScroll()
     }
 }
 
+void Container::getContentSize(float* width, float* height) const
+{
+    GP_ASSERT(width && height);
+
+    *width = *height = 0.0f;
+    for (size_t i = 0, count = _controls.size(); i < count; ++i)
+    {
+        Control* control = _controls[i];
+
+        const Rectangle& bounds = control->getBounds();
+        const Theme::Margin& margin = control->getMargin();
+
+        float newWidth = bounds.x + bounds.width + margin.right;
+        if (newWidth > *width)
+        {
+            *width = newWidth;
+        }
+
+        float newHeight = bounds.y + bounds.height + margin.bottom;
+        if (newHeight > *height)
+        {
+            *height = newHeight;
+        }
+    }
+}
+
 void Container::sortControls()
 {
     if (_layout->getType() == Layout::LAYOUT_ABSOLUTE)
     {
         std::sort(_controls.begin(), _controls.end(), &sortControlsByZOrder);
+        invalidateFormHitGrid();
     }
 }
 
+void Container::invalidateFormHitGrid()
+{
+    Form* form = getTopLevelForm();
+    if (form)
+        form->invalidateHitGrid();
+}
+
 bool Container::touchEventScroll(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
 {
     switch (evt)
@@ -1553,6 +1607,7 @@ void Container::setAnimationPropertyValue(int propertyId, AnimationValue* value,
     {
     case ANIMATE_SCROLLBAR_OPACITY:
         _scrollBarOpacity = Curve::lerp(blendWeight, _opacity, value->getFloat(0));
+        invalidate();
         break;
     default:
         Control::setAnimationPropertyValue(propertyId, value, blendWeight);
@@ -329,6 +329,15 @@ protected:
      */
     bool updateChildBounds();
 
+    /**
+     * Determines if a child control lies entirely outside the viewport of this container.
+     *
+     * @param control The child control.
+     *
+     * @return True if the child cannot be seen, false otherwise.
+     */
+    bool isOutsideViewport(Control* control) const;
+
     /**
      * Sets the specified dirty bits for all children within this container.
      *
@@ -370,6 +379,16 @@ protected:
      */
     void updateScroll();
 
+    /**
+     * Computes the size of the scrollable content of this container.
+     *
+     * By default the content extends to the far edges of the child controls, including their margins.
+     *
+     * @param width Populated with the content width.
+     * @param height Populated with the content height.
+     */
+    virtual void getContentSize(float* width, float* height) const;
+
     /**
      * Sorts controls by Z-Order (for absolute layouts only).
      * This method is used by controls to notify their parent container when
@@ -377,6 +396,11 @@ protected:
      */
     void sortControls();
 
+    /**
+     * Makes the form of this container rebuild its hit-testing grid, after the order of the controls changed.
+     */
+    void invalidateFormHitGrid();
+
     /**
      * Applies touch events to scroll state.
      *
@@ -3,15 +3,24 @@
 #include "Control.h"
 #include "Form.h"
 #include "Theme.h"
+#include "FramePacer.h"
 
 #define BOUNDS_X_PERCENTAGE_BIT 1
 #define BOUNDS_Y_PERCENTAGE_BIT 2
 #define BOUNDS_WIDTH_PERCENTAGE_BIT 4
 #define BOUNDS_HEIGHT_PERCENTAGE_BIT 8
 
+// The script events of controls.
+#define CONTROL_EVENT_CONTROL 0
+
 namespace gameplay
 {
 
+static const ScriptTarget::Event __controlEvents[] =
+{
+    { "controlEvent", "<Control>[Control::Listener::EventType]" }
+};
+
 static std::string toString(float v)
 {
     std::ostringstream s;
@@ -50,7 +59,7 @@ Control::Control()
     _autoSize(AUTO_SIZE_BOTH), _style(NULL), _listeners(NULL), _visible(true), _zIndex(-1),
     _contactIndex(INVALID_CONTACT_INDEX), _focusIndex(-1), _canFocus(false), _state(NORMAL), _parent(NULL), _styleOverridden(false), _skin(NULL)
 {
-    addScriptEvent("controlEvent", "<Control>[Control::Listener::EventType]");
+    setScriptEvents(__controlEvents, 1);
 }
 
 Control::~Control()
@@ -1093,7 +1102,7 @@ void Control::notifyListeners(Control::Listener::EventType eventType)
         }
     }
 
-    fireScriptEvent<void>("controlEvent", this, eventType);
+    fireScriptEvent<void>(CONTROL_EVENT_CONTROL, this, eventType);
 
     release();
 }
@@ -1105,6 +1114,18 @@ void Control::controlEvent(Control::Listener::EventType evt)
 void Control::setDirty(int bits)
 {
     _dirtyBits |= bits;
+
+    // Flag our ancestors so that bounds updates only visit the branches that need them.
+    if ((bits & DIRTY_BOUNDS) && _parent)
+        _parent->setChildBoundsDirty();
+
+    invalidate();
+}
+
+void Control::setChildBoundsDirty()
+{
+    for (Control* control = this; control && (control->_dirtyBits & DIRTY_CHILD_BOUNDS) == 0; control = control->_parent)
+        control->_dirtyBits |= DIRTY_CHILD_BOUNDS;
 }
 
 bool Control::isDirty(int bit) const
@@ -1112,6 +1133,16 @@ bool Control::isDirty(int bit) const
     return (_dirtyBits & bit) == bit;
 }
 
+void Control::invalidate()
+{
+    // The control is drawn differently, so the game can't stay idle.
+    FramePacer::wake();
+
+    Form* form = getTopLevelForm();
+    if (form && form->_cached)
+        form->addDirtyRegion(_absoluteBounds);
+}
+
 void Control::update(float elapsedTime)
 {
     State state = getState();
@@ -1122,9 +1153,12 @@ void Control::update(float elapsedTime)
 
     // Since opacity is pre-multiplied, we compute it every frame so that we don't need to
     // dirty the entire hierarchy any time a state changes (which could affect opacity).
+    float opacity = _opacity;
     _opacity = getOpacity(state);
     if (_parent)
         _opacity *= _parent->_opacity;
+    if (_opacity != opacity)
+        invalidate();
 }
 
 void Control::updateState(State state)
@@ -1147,13 +1181,14 @@ bool Control::updateBoundsInternal(const Vector2& offset)
         _dirtyBits &= ~DIRTY_STATE;
     }
 
-    // Clear our dirty bounds bit
+    // Clear our dirty bounds bits
     bool dirtyBounds = (_dirtyBits & DIRTY_BOUNDS) != 0;
-    _dirtyBits &= ~DIRTY_BOUNDS;
+    bool dirtyChildBounds = (_dirtyBits & DIRTY_CHILD_BOUNDS) != 0;
+    _dirtyBits &= ~(DIRTY_BOUNDS | DIRTY_CHILD_BOUNDS);
 
-    // If we are a container, always update child bounds first
+    // If we are a container, update the child bounds that are dirty first
     bool changed = false;
-    if (isContainer())
+    if (dirtyChildBounds && isContainer())
         changed = static_cast<Container*>(this)->updateChildBounds();
 
     if (dirtyBounds)
@@ -1174,6 +1209,7 @@ bool Control::updateBoundsInternal(const Vector2& offset)
         {
             if (isContainer())
                 static_cast<Container*>(this)->setChildrenDirty(DIRTY_BOUNDS, true);
+            invalidate();
             changed = true;
         }
     }
@@ -1294,11 +1330,16 @@ void Control::updateAbsoluteBounds(const Vector2& offset)
 
     // Calculate the absolute clipped viewport bounds
     Rectangle::intersect(_viewportBounds, parentAbsoluteClip, &_viewportClipBounds);
+
+    // Move the control in the hit-testing grid of its form.
+    Form* form = getTopLevelForm();
+    if (form)
+        form->updateHitGrid(this);
 }
 
 void Control::startBatch(Form* form, SpriteBatch* batch)
 {
-    form->startBatch(batch);
+    form->startBatch(batch, _absoluteClipBounds);
 }
 
 void Control::finishBatch(Form* form, SpriteBatch* batch)
@@ -1324,6 +1365,24 @@ unsigned int Control::drawBorder(Form* form, const Rectangle& clip)
 
     unsigned int drawCalls = 0;
 
+    // Draw the whole skin as a single nine-slice quad when the theme supports it.
+    SpriteBatch* nineSliceBatch = _style->getTheme()->_nineSliceBatch;
+    if (nineSliceBatch)
+    {
+        const Theme::UVs& topLeft = _skin->getUVs(Theme::Skin::TOP_LEFT);
+        const Theme::UVs& center = _skin->getUVs(Theme::Skin::CENTER);
+        const Theme::UVs& bottomRight = _skin->getUVs(Theme::Skin::BOTTOM_RIGHT);
+        const Theme::Border& border = getBorder(getState());
+        Vector4 skinColor = _skin->getColor();
+        skinColor.w *= _opacity;
+
+        startBatch(form, nineSliceBatch);
+        nineSliceBatch->drawNineSlice(_absoluteBounds, Vector4(border.left, border.top, border.right, border.bottom),
+            Vector4(topLeft.u1, topLeft.v1, bottomRight.u2, bottomRight.v2), Vector4(center.u1, center.v1, center.u2, center.v2), skinColor, clip);
+        finishBatch(form, nineSliceBatch);
+        return 1;
+    }
+
     SpriteBatch* batch = _style->getTheme()->getSpriteBatch();
     startBatch(form, batch);
 
@@ -1677,6 +1736,9 @@ Theme::Style::Overlay* Control::getOverlay(State state) const
 
 void Control::overrideStyle()
 {
+    // Style overrides are about to change how the control looks.
+    invalidate();
+
     if (_styleOverridden)
     {
         return;
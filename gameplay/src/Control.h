@@ -27,6 +27,7 @@ class Control : public Ref, public AnimationTarget, public ScriptTarget
 {
     friend class Form;
     friend class Container;
+    friend class Gamepad;
 
 public:
 
@@ -985,6 +986,11 @@ protected:
      */
     static const int DIRTY_STATE = 2;
 
+    /**
+     * Indicates that the bounds of a descendant of the control are dirty.
+     */
+    static const int DIRTY_CHILD_BOUNDS = 4;
+
     /**
      * Constructor.
      */
@@ -1278,6 +1284,17 @@ protected:
      */
     bool isDirty(int bit) const;
 
+    /**
+     * Marks the area covered by this control as needing to be redrawn.
+     *
+     * This only has an effect when the control belongs to a form that caches its rendered
+     * output, and is called automatically whenever dirty bits are set or the style changes.
+     * Controls that change their appearance in other ways must call it themselves.
+     *
+     * @see Form::setCachingEnabled
+     */
+    void invalidate();
+
     /**
      * Gets the Alignment by string.
      *
@@ -1410,6 +1427,8 @@ private:
 
     bool updateBoundsInternal(const Vector2& offset);
 
+    void setChildBoundsDirty();
+
     AutoSize parseAutoSize(const char* str);
 
     Theme::Style::Overlay** getOverlays(unsigned char overlayTypes, Theme::Style::Overlay** overlays);
@@ -8,6 +8,7 @@
 #include "Slider.h"
 #include "TextBox.h"
 #include "JoystickControl.h"
+#include "ListView.h"
 #include "ImageControl.h"
 
 namespace gameplay
@@ -87,6 +88,7 @@ void ControlFactory::registerStandardControls()
     registerCustomControl("TEXTBOX", &TextBox::create);
     registerCustomControl("JOYSTICK", &JoystickControl::create);
     registerCustomControl("IMAGE", &ImageControl::create);
+    registerCustomControl("LISTVIEW", &ListView::create);
 }
 
 }
@@ -18,6 +18,19 @@ using std::strcmp;
 #define NULL 0
 #endif
 
+// Base.h is not included, so detect the SIMD instruction sets it would enable.
+#if !defined(USE_NEON) && defined(__arm__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define USE_NEON
+#endif
+#if !defined(USE_NEON) && !defined(USE_SSE) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define USE_SSE
+#endif
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#elif defined(USE_SSE)
+#include <xmmintrin.h>
+#endif
+
 #ifndef MATH_PI
 #define MATH_PI 3.14159265358979323846f
 #endif
@@ -80,16 +93,114 @@ static inline float lerpInl(float s, float from, float to)
     return from + (to - from) * s;
 }
 
+// The coefficients of each group of four components of a baked segment: the four cubic terms,
+// then the four quadratic terms, the four linear terms and the four constant terms.
+#define BAKED_GROUP_SIZE 16
+
+// Sets the coefficients of the cubic polynomial, from the cubic term down, of a bezier segment.
+static inline void bezierCubic(float from, float out, float to, float in, float* cubic)
+{
+    cubic[0] = -from + 3 * out - 3 * in + to;
+    cubic[1] = 3 * from - 6 * out + 3 * in;
+    cubic[2] = -3 * from + 3 * out;
+    cubic[3] = from;
+}
+
+// Sets the coefficients of the cubic polynomial, from the cubic term down, of a bspline segment.
+static inline void bsplineCubic(float c0, float c1, float c2, float c3, float* cubic)
+{
+    cubic[0] = (-c0 + 3 * c1 - 3 * c2 + c3) / 6.0f;
+    cubic[1] = (3 * c0 - 6 * c1 + 3 * c2) / 6.0f;
+    cubic[2] = (-3 * c0 + 3 * c2) / 6.0f;
+    cubic[3] = (c0 + 4 * c1 + c2) / 6.0f;
+}
+
+// Sets the coefficients of the cubic polynomial, from the cubic term down, of a hermite segment.
+static inline void hermiteCubic(float from, float out, float to, float in, float* cubic)
+{
+    cubic[0] = 2 * from - 2 * to + out + in;
+    cubic[1] = -3 * from + 3 * to - 2 * out - in;
+    cubic[2] = out;
+    cubic[3] = from;
+}
+
+// The largest value of the three smallest components of a unit quaternion (1 / sqrt(2)).
+#define QUANTIZED_QUATERNION_RANGE 0.707106781186547524401f
+
+// The largest number of components of a quantized curve.
+#define QUANTIZED_MAX_COMPONENTS 16
+
+// Decodes a unit quaternion stored as its three smallest components, in 15 bits each, with the
+// index of the largest component in the high bits of the first two values.
+static inline void decodeQuaternion(const unsigned short* src, float* dst)
+{
+    unsigned int largest = (src[0] >> 15) | ((src[1] >> 15) << 1);
+    float sum = 0.0f;
+    for (unsigned int i = 0, j = 0; i < 4; i++)
+    {
+        if (i == largest)
+            continue;
+        float value = ((float)(src[j++] & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * QUANTIZED_QUATERNION_RANGE;
+        dst[i] = value;
+        sum += value * value;
+    }
+    dst[largest] = sum < 1.0f ? sqrt(1.0f - sum) : 0.0f;
+}
+
 namespace gameplay
 {
 
+static Curve::RotationInterpolation __rotationInterpolation = Curve::ROTATION_SLERP;
+
 Curve* Curve::create(unsigned int pointCount, unsigned int componentCount)
 {
     return new Curve(pointCount, componentCount);
 }
 
+Curve* Curve::createQuantized(unsigned int pointCount, unsigned int componentCount, int quaternionOffset, InterpolationType type,
+                              const float* times, const float* ranges, const unsigned short* values)
+{
+    assert(pointCount > 0 && componentCount > 0 && componentCount <= QUANTIZED_MAX_COMPONENTS && times && values);
+    assert(quaternionOffset < 0 || (unsigned int)quaternionOffset + 4 <= componentCount);
+    assert(type == LINEAR || type == STEP);
+
+    Curve* curve = new Curve();
+    curve->_pointCount = pointCount;
+    curve->_componentCount = componentCount;
+    curve->_componentSize = sizeof(float) * componentCount;
+    if (quaternionOffset >= 0)
+        curve->setQuaternionOffset((unsigned int)quaternionOffset);
+    curve->_quantizedType = type;
+
+    // Each quaternion is stored in three values, and each other component in one value with a range.
+    unsigned int rangeCount = quaternionOffset >= 0 ? componentCount - 4 : componentCount;
+    curve->_quantizedKeySize = quaternionOffset >= 0 ? componentCount - 1 : componentCount;
+
+    curve->_times = new float[pointCount];
+    memcpy(curve->_times, times, sizeof(float) * pointCount);
+    if (rangeCount > 0)
+    {
+        assert(ranges);
+        curve->_quantizedRanges = new float[rangeCount * 2];
+        memcpy(curve->_quantizedRanges, ranges, sizeof(float) * rangeCount * 2);
+    }
+    curve->_quantizedValues = new unsigned short[pointCount * curve->_quantizedKeySize];
+    memcpy(curve->_quantizedValues, values, sizeof(unsigned short) * pointCount * curve->_quantizedKeySize);
+
+    return curve;
+}
+
+Curve::Curve()
+    : _pointCount(0), _componentCount(0), _componentSize(0), _quaternionOffset(NULL), _points(NULL),
+      _times(NULL), _quantizedRanges(NULL), _quantizedValues(NULL), _quantizedKeySize(0), _quantizedType(LINEAR),
+      _coefficients(NULL), _coefficientStride(0), _baked(false)
+{
+}
+
 Curve::Curve(unsigned int pointCount, unsigned int componentCount)
-    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL)
+    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL),
+      _times(NULL), _quantizedRanges(NULL), _quantizedValues(NULL), _quantizedKeySize(0), _quantizedType(LINEAR),
+      _coefficients(NULL), _coefficientStride(((componentCount + 3) / 4) * BAKED_GROUP_SIZE), _baked(true)
 {
     _points = new Point[_pointCount];
     for (unsigned int i = 0; i < _pointCount; i++)
@@ -107,6 +218,10 @@ Curve::~Curve()
 {
     SAFE_DELETE_ARRAY(_points);
     SAFE_DELETE_ARRAY(_quaternionOffset);
+    SAFE_DELETE_ARRAY(_times);
+    SAFE_DELETE_ARRAY(_quantizedRanges);
+    SAFE_DELETE_ARRAY(_quantizedValues);
+    SAFE_DELETE_ARRAY(_coefficients);
 }
 
 Curve::Point::Point()
@@ -133,12 +248,17 @@ unsigned int Curve::getComponentCount() const
 
 float Curve::getStartTime() const
 {
-    return _points[0].time;
+    return getTime(0);
 }
 
 float Curve::getEndTime() const
 {
-    return _points[_pointCount-1].time;
+    return getTime(_pointCount - 1);
+}
+
+bool Curve::isQuantized() const
+{
+    return _quantizedValues != NULL;
 }
 
 void Curve::setPoint(unsigned int index, float time, float* value, InterpolationType type)
@@ -148,7 +268,7 @@ void Curve::setPoint(unsigned int index, float time, float* value, Interpolation
 
 void Curve::setPoint(unsigned int index, float time, float* value, InterpolationType type, float* inValue, float* outValue)
 {
-    assert(index < _pointCount && time >= 0.0f && time <= 1.0f && !(_pointCount > 1 && index == 0 && time != 0.0f) && !(_pointCount != 1 && index == _pointCount - 1 && time != 1.0f));
+    assert(_points && index < _pointCount && time >= 0.0f && time <= 1.0f && !(_pointCount > 1 && index == 0 && time != 0.0f) && !(_pointCount != 1 && index == _pointCount - 1 && time != 1.0f));
 
     _points[index].time = time;
     _points[index].type = type;
@@ -161,11 +281,13 @@ void Curve::setPoint(unsigned int index, float time, float* value, Interpolation
 
     if (outValue)
         memcpy(_points[index].outValue, outValue, _componentSize);
+
+    bakePoint(index);
 }
 
 void Curve::setTangent(unsigned int index, InterpolationType type, float* inValue, float* outValue)
 {
-    assert(index < _pointCount);
+    assert(_points && index < _pointCount);
 
     _points[index].type = type;
 
@@ -174,6 +296,30 @@ void Curve::setTangent(unsigned int index, InterpolationType type, float* inValu
 
     if (outValue)
         memcpy(_points[index].outValue, outValue, _componentSize);
+
+    bakePoint(index);
+}
+
+void Curve::setBaked(bool baked)
+{
+    if (!_points)
+        return;
+
+    _baked = baked;
+    if (baked)
+    {
+        if (_pointCount > 1)
+            bakeSegments(0, _pointCount - 2);
+    }
+    else
+    {
+        SAFE_DELETE_ARRAY(_coefficients);
+    }
+}
+
+bool Curve::isBaked() const
+{
+    return _baked;
 }
 
 void Curve::evaluate(float time, float* dst) const
@@ -185,85 +331,46 @@ void Curve::evaluate(float time, float* dst) const
 
 void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const
 {
-    assert(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
-
-    // If there's only one point on the curve, return its value.
-    if (_pointCount == 1)
-    {
-        memcpy(dst, _points[0].value, _componentSize);
-        return;
-    }
-
-    unsigned int min = 0;
-    unsigned int max = _pointCount - 1;
-    float localTime = time;
-    if (startTime > 0.0f || endTime < 1.0f)
-    {
-        // Evaluating a sub section of the curve
-        min = determineIndex(startTime, 0, max);
-        max = determineIndex(endTime, min, max);
-
-        // Convert time to fall within the subregion
-        localTime = _points[min].time + (_points[max].time - _points[min].time) * time;
-    }
+    evaluate(time, startTime, endTime, loopBlendTime, dst, NULL);
+}
 
-    if (loopBlendTime == 0.0f)
-    {
-        // If no loop blend time is specified, clamp time to end points
-        if (localTime < _points[min].time)
-            localTime = _points[min].time;
-        else if (localTime > _points[max].time)
-            localTime = _points[max].time;
-    }
+void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* cursor) const
+{
+    assert(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
 
-    // If an exact endpoint was specified, skip interpolation and return the value directly
-    if (localTime == _points[min].time)
-    {
-        memcpy(dst, _points[min].value, _componentSize);
-        return;
-    }
-    if (localTime == _points[max].time)
+    if (_quantizedValues)
     {
-        memcpy(dst, _points[max].value, _componentSize);
+        evaluateQuantized(time, startTime, endTime, loopBlendTime, dst, cursor);
         return;
     }
 
-    Point* from;
-    Point* to;
-    float scale;
-    float t;
     unsigned int index;
-
-    if (localTime > _points[max].time)
+    unsigned int toIndex;
+    float t;
+    if (!locate(time, startTime, endTime, loopBlendTime, cursor, &index, &toIndex, &t))
     {
-        // Looping forward
-        index = max;
-        from = &_points[max];
-        to = &_points[min];
-
-        // Calculate the fractional time between the two points.
-        t = (localTime - from->time) / loopBlendTime;
+        // The time is exactly on a point, so return its value directly.
+        memcpy(dst, _points[index].value, _componentSize);
+        return;
     }
-    else if (localTime < _points[min].time)
-    {
-        // Looping in reverse
-        index = min;
-        from = &_points[min];
-        to = &_points[max];
+    Point* from = &_points[index];
+    Point* to = &_points[toIndex];
 
-        // Calculate the fractional time between the two points.
-        t = (from->time - localTime) / loopBlendTime;
-    }
-    else
+    // Baked segments only hold the polynomials towards the next point, not those of loop blends.
+    if (_coefficients && toIndex == index + 1)
     {
-        // Locate the points we are interpolating between using a binary search.
-        index = determineIndex(localTime, min, max);
-        from = &_points[index];
-        to = &_points[index == max ? index : index+1];
-
-        // Calculate the fractional time between the two points.
-        scale = (to->time - from->time);
-        t = (localTime - from->time) / scale;
+        switch (from->type)
+        {
+            case BEZIER:
+            case BSPLINE:
+            case FLAT:
+            case HERMITE:
+            case SMOOTH:
+                evaluateBaked(t, index, dst);
+                return;
+            default:
+                break;
+        }
     }
 
     // Calculate the value of the curve discretely if appropriate.
@@ -801,11 +908,148 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     interpolateLinear(t, from, to, dst);
 }
 
+void Curve::evaluateQuantized(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* cursor) const
+{
+    unsigned int index;
+    unsigned int toIndex;
+    float t;
+    if (!locate(time, startTime, endTime, loopBlendTime, cursor, &index, &toIndex, &t))
+    {
+        decodeQuantizedKey(index, dst);
+        return;
+    }
+    if (_quantizedType == STEP)
+    {
+        decodeQuantizedKey(index, dst);
+        return;
+    }
+
+    float fromValue[QUANTIZED_MAX_COMPONENTS];
+    float toValue[QUANTIZED_MAX_COMPONENTS];
+    decodeQuantizedKey(index, fromValue);
+    decodeQuantizedKey(toIndex, toValue);
+    interpolateLinear(t, fromValue, toValue, dst);
+}
+
+bool Curve::locate(float time, float startTime, float endTime, float loopBlendTime, unsigned int* cursor,
+                   unsigned int* fromIndex, unsigned int* toIndex, float* t) const
+{
+    // If there's only one point on the curve, return its value.
+    if (_pointCount == 1)
+    {
+        *fromIndex = 0;
+        return false;
+    }
+
+    unsigned int min = 0;
+    unsigned int max = _pointCount - 1;
+    float localTime = time;
+    if (startTime > 0.0f || endTime < 1.0f)
+    {
+        // Evaluating a sub section of the curve
+        min = determineIndex(startTime, 0, max);
+        max = determineIndex(endTime, min, max);
+
+        // Convert time to fall within the subregion
+        localTime = getTime(min) + (getTime(max) - getTime(min)) * time;
+    }
+
+    if (loopBlendTime == 0.0f)
+    {
+        // If no loop blend time is specified, clamp time to end points
+        if (localTime < getTime(min))
+            localTime = getTime(min);
+        else if (localTime > getTime(max))
+            localTime = getTime(max);
+    }
+
+    // If an exact endpoint was specified, skip interpolation and return the value directly
+    if (localTime == getTime(min))
+    {
+        *fromIndex = min;
+        return false;
+    }
+    if (localTime == getTime(max))
+    {
+        *fromIndex = max;
+        return false;
+    }
+
+    if (localTime > getTime(max))
+    {
+        // Looping forward
+        *fromIndex = max;
+        *toIndex = min;
+
+        // Calculate the fractional time between the two points.
+        *t = (localTime - getTime(max)) / loopBlendTime;
+    }
+    else if (localTime < getTime(min))
+    {
+        // Looping in reverse
+        *fromIndex = min;
+        *toIndex = max;
+
+        // Calculate the fractional time between the two points.
+        *t = (getTime(min) - localTime) / loopBlendTime;
+    }
+    else
+    {
+        // Locate the points we are interpolating between.
+        unsigned int index = determineIndex(localTime, min, max, cursor);
+        *fromIndex = index;
+        *toIndex = index == max ? index : index + 1;
+
+        // Calculate the fractional time between the two points.
+        *t = (localTime - getTime(index)) / (getTime(*toIndex) - getTime(index));
+    }
+    return true;
+}
+
+void Curve::decodeQuantizedKey(unsigned int index, float* dst) const
+{
+    const unsigned short* key = _quantizedValues + index * _quantizedKeySize;
+    const float* range = _quantizedRanges;
+    unsigned int quaternionOffset = _quaternionOffset ? *_quaternionOffset : _componentCount;
+    for (unsigned int i = 0; i < _componentCount;)
+    {
+        if (i == quaternionOffset)
+        {
+            decodeQuaternion(key, dst + i);
+            key += 3;
+            i += 4;
+        }
+        else
+        {
+            // The range holds the minimum value and the extent of the component.
+            dst[i] = range[0] + range[1] * ((float)*key * (1.0f / 65535.0f));
+            range += 2;
+            key++;
+            i++;
+        }
+    }
+}
+
+float Curve::getTime(unsigned int index) const
+{
+    return _points ? _points[index].time : _times[index];
+}
+
 float Curve::lerp(float t, float from, float to)
 {
     return lerpInl(t, from, to);
 }
 
+void Curve::setRotationInterpolation(RotationInterpolation interpolation)
+{
+    __rotationInterpolation = interpolation;
+}
+
+Curve::RotationInterpolation Curve::getRotationInterpolation()
+{
+    return __rotationInterpolation;
+}
+
 void Curve::setQuaternionOffset(unsigned int offset)
 {
     assert(offset <= (_componentCount - 4));
@@ -814,6 +1058,177 @@ void Curve::setQuaternionOffset(unsigned int offset)
         _quaternionOffset = new unsigned int[1];
     
     *_quaternionOffset = offset;
+
+    // Baked segments store the polynomial of the quaternion's interpolation time after their components.
+    if (_points)
+    {
+        _coefficientStride = ((_componentCount + 3) / 4) * BAKED_GROUP_SIZE + 4;
+        SAFE_DELETE_ARRAY(_coefficients);
+        if (_pointCount > 1)
+            bakeSegments(0, _pointCount - 2);
+    }
+}
+
+void Curve::evaluateBaked(float s, unsigned int index, float* dst) const
+{
+    const float* coefficients = _coefficients + index * _coefficientStride;
+    unsigned int i = 0;
+#if defined(USE_SSE)
+    __m128 s4 = _mm_set1_ps(s);
+    for (; i + 4 <= _componentCount; i += 4)
+    {
+        const float* group = coefficients + i * 4;
+        __m128 value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(group), s4), _mm_loadu_ps(group + 4));
+        value = _mm_add_ps(_mm_mul_ps(value, s4), _mm_loadu_ps(group + 8));
+        value = _mm_add_ps(_mm_mul_ps(value, s4), _mm_loadu_ps(group + 12));
+        _mm_storeu_ps(dst + i, value);
+    }
+#elif defined(USE_NEON)
+    float32x4_t s4 = vdupq_n_f32(s);
+    for (; i + 4 <= _componentCount; i += 4)
+    {
+        const float* group = coefficients + i * 4;
+        float32x4_t value = vmlaq_f32(vld1q_f32(group + 4), vld1q_f32(group), s4);
+        value = vmlaq_f32(vld1q_f32(group + 8), value, s4);
+        value = vmlaq_f32(vld1q_f32(group + 12), value, s4);
+        vst1q_f32(dst + i, value);
+    }
+#endif
+    for (; i < _componentCount; i++)
+    {
+        const float* cubic = coefficients + (i / 4) * BAKED_GROUP_SIZE + (i % 4);
+        dst[i] = ((cubic[0] * s + cubic[4]) * s + cubic[8]) * s + cubic[12];
+    }
+
+    if (_quaternionOffset)
+    {
+        // The quaternion components were evaluated as zeros, so interpolate them over the baked time.
+        const float* cubic = coefficients + _coefficientStride - 4;
+        float interpTime = ((cubic[0] * s + cubic[1]) * s + cubic[2]) * s + cubic[3];
+        unsigned int offset = *_quaternionOffset;
+        interpolateQuaternion(interpTime, _points[index].value + offset, _points[index + 1].value + offset, dst + offset);
+    }
+}
+
+void Curve::bakePoint(unsigned int index)
+{
+    if (!_baked || _pointCount < 2)
+        return;
+
+    // Smooth and bspline segments depend on the points before and after them.
+    unsigned int last = _pointCount - 2;
+    bakeSegments(index > 2 ? index - 2 : 0, index + 1 < last ? index + 1 : last);
+}
+
+void Curve::bakeSegments(unsigned int first, unsigned int last)
+{
+    if (!_baked)
+        return;
+
+    if (_coefficients == NULL)
+    {
+        bool cubic = false;
+        for (unsigned int i = first; i <= last && !cubic; i++)
+        {
+            InterpolationType type = _points[i].type;
+            cubic = type == BEZIER || type == BSPLINE || type == FLAT || type == HERMITE || type == SMOOTH;
+        }
+        if (!cubic)
+            return;
+
+        // The other segments were not baked while the curve had no cubic segment.
+        _coefficients = new float[(_pointCount - 1) * _coefficientStride];
+        first = 0;
+        last = _pointCount - 2;
+    }
+
+    for (unsigned int i = first; i <= last; i++)
+    {
+        bakeSegment(i);
+    }
+}
+
+void Curve::bakeSegment(unsigned int index)
+{
+    Point* from = &_points[index];
+    Point* to = &_points[index + 1];
+    float* coefficients = _coefficients + index * _coefficientStride;
+    float cubic[4];
+
+    // Bspline and smooth segments at the ends of the curve use their end points as the missing neighbours.
+    Point* previous = index == 0 ? from : from - 1;
+    Point* next = index == _pointCount - 2 ? to : to + 1;
+    float outScale = index == 0 ? 1.0f : (from->time - previous->time) / (to->time - previous->time);
+    float inScale = index == _pointCount - 2 ? 1.0f : (to->time - from->time) / (next->time - from->time);
+
+    unsigned int quaternionOffset = _quaternionOffset ? *_quaternionOffset : _componentCount;
+    for (unsigned int i = 0; i < _componentCount; i++)
+    {
+        float fromValue = from->value[i];
+        float toValue = to->value[i];
+        if (fromValue == toValue || (i >= quaternionOffset && i < quaternionOffset + 4))
+        {
+            cubic[0] = cubic[1] = cubic[2] = 0.0f;
+            cubic[3] = fromValue;
+        }
+        else
+        {
+            switch (from->type)
+            {
+                case BEZIER:
+                    bezierCubic(fromValue, from->outValue[i], toValue, to->inValue[i], cubic);
+                    break;
+                case BSPLINE:
+                    bsplineCubic(previous->value[i], fromValue, toValue, next->value[i], cubic);
+                    break;
+                case FLAT:
+                    hermiteCubic(fromValue, 0.0f, toValue, 0.0f, cubic);
+                    break;
+                case HERMITE:
+                    hermiteCubic(fromValue, from->outValue[i], toValue, to->inValue[i], cubic);
+                    break;
+                case SMOOTH:
+                    hermiteCubic(fromValue, (toValue - previous->value[i]) * outScale, toValue, (next->value[i] - fromValue) * inScale, cubic);
+                    break;
+                default:
+                    return;
+            }
+        }
+
+        float* group = coefficients + (i / 4) * BAKED_GROUP_SIZE + (i % 4);
+        group[0] = cubic[0];
+        group[4] = cubic[1];
+        group[8] = cubic[2];
+        group[12] = cubic[3];
+    }
+
+    if (_quaternionOffset)
+    {
+        // The quaternion is interpolated over the same time as its unbaked interpolation.
+        float* time = coefficients + _coefficientStride - 4;
+        unsigned int i = quaternionOffset;
+        switch (from->type)
+        {
+            case BEZIER:
+                bezierCubic(from->time, from->outValue[i], to->time, to->inValue[i], time);
+                break;
+            case BSPLINE:
+                time[0] = time[1] = time[3] = 0.0f;
+                time[2] = 1.0f;
+                break;
+            case FLAT:
+                hermiteCubic(from->time, 0.0f, to->time, 0.0f, time);
+                break;
+            case HERMITE:
+                hermiteCubic(from->time, from->outValue[i], to->time, to->inValue[i], time);
+                break;
+            case SMOOTH:
+                hermiteCubic(from->time, (to->time - previous->time) * outScale, to->time, (next->time - from->time) * inScale, time);
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 void Curve::interpolateBezier(float s, Point* from, Point* to, float* dst) const
@@ -1171,9 +1586,11 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
 
 void Curve::interpolateLinear(float s, Point* from, Point* to, float* dst) const
 {
-    float* fromValue = from->value;
-    float* toValue = to->value;
+    interpolateLinear(s, from->value, to->value, dst);
+}
 
+void Curve::interpolateLinear(float s, const float* fromValue, const float* toValue, float* dst) const
+{
     if (!_quaternionOffset)
     {
         for (unsigned int i = 0; i < _componentCount; i++)
@@ -1211,8 +1628,17 @@ void Curve::interpolateLinear(float s, Point* from, Point* to, float* dst) const
     }
 }
 
-void Curve::interpolateQuaternion(float s, float* from, float* to, float* dst) const
+void Curve::interpolateQuaternion(float s, const float* from, const float* to, float* dst) const
 {
+    if (__rotationInterpolation == ROTATION_NLERP)
+    {
+        if (s >= 0)
+            Quaternion::nlerp(from[0], from[1], from[2], from[3], to[0], to[1], to[2], to[3], s, dst, dst + 1, dst + 2, dst + 3);
+        else
+            Quaternion::nlerp(to[0], to[1], to[2], to[3], from[0], from[1], from[2], from[3], s, dst, dst + 1, dst + 2, dst + 3);
+        return;
+    }
+
     // Evaluate.
     if (s >= 0)
         Quaternion::slerp(from[0], from[1], from[2], from[3], to[0], to[1], to[2], to[3], s, dst, dst + 1, dst + 2, dst + 3);
@@ -1220,6 +1646,37 @@ void Curve::interpolateQuaternion(float s, float* from, float* to, float* dst) c
         Quaternion::slerp(to[0], to[1], to[2], to[3], from[0], from[1], from[2], from[3], s, dst, dst + 1, dst + 2, dst + 3);
 }
 
+int Curve::determineIndex(float time, unsigned int min, unsigned int max, unsigned int* cursor) const
+{
+    if (cursor == NULL)
+        return determineIndex(time, min, max);
+
+    // Playback time is usually monotonic, so check the last keyframe and its neighbours before searching.
+    unsigned int index = *cursor;
+    if (index >= min && index < max)
+    {
+        if (time >= getTime(index))
+        {
+            if (time < getTime(index + 1))
+                return index;
+            if (index + 1 < max && time < getTime(index + 2))
+            {
+                *cursor = index + 1;
+                return index + 1;
+            }
+        }
+        else if (index > min && time >= getTime(index - 1))
+        {
+            *cursor = index - 1;
+            return index - 1;
+        }
+    }
+
+    index = determineIndex(time, min, max);
+    *cursor = index;
+    return index;
+}
+
 int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
 {
     unsigned int mid;
@@ -1229,9 +1686,9 @@ int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
     {
         mid = (min + max) >> 1;
 
-        if (time >= _points[mid].time && time < _points[mid + 1].time)
+        if (time >= getTime(mid) && time < getTime(mid + 1))
             return mid;
-        else if (time < _points[mid].time)
+        else if (time < getTime(mid))
             max = mid - 1;
         else
             min = mid + 1;
@@ -275,6 +275,26 @@ public:
         BOUNCE_OUT_IN
     };
 
+    /**
+     * Methods of interpolating the rotations of quaternion curves and of blending animated rotations.
+     *
+     * @script{ignore}
+     */
+    enum RotationInterpolation
+    {
+        /**
+         * Spherical linear interpolation, which rotates at a constant rate.
+         */
+        ROTATION_SLERP,
+
+        /**
+         * Normalized linear interpolation, which is much cheaper and cannot be told apart from
+         * slerp between densely sampled keyframes or when blending animations. Blended
+         * rotations of transforms are then interpolated in batches over all the animated joints.
+         */
+        ROTATION_NLERP
+    };
+
     /**
      * Creates a new curve.
      *
@@ -284,6 +304,29 @@ public:
      */
     static Curve* create(unsigned int pointCount, unsigned int componentCount);
 
+    /**
+     * Creates a new curve from quantized key values.
+     *
+     * Quantized curves use a fraction of the memory of other curves and are decoded as they are evaluated.
+     * A quaternion within the key values is stored as its three smallest components, in 15 bits each,
+     * with the index of the largest component in the high bits of the first two values. Every other
+     * component is stored as a 16 bit fraction of the range of that component over the curve.
+     * The points of a quantized curve cannot be changed.
+     *
+     * @param pointCount The number of points in the curve.
+     * @param componentCount The number of float component values per key value.
+     * @param quaternionOffset The offset of the quaternion within the key values, or -1 if there is none.
+     * @param type The interpolation type of the curve, either LINEAR or STEP.
+     * @param times The times of the points, between 0.0 and 1.0.
+     * @param ranges The minimum value and the extent of each component that is not part of the quaternion.
+     * @param values The quantized values of the points.
+     *
+     * @return The new curve.
+     * @script{ignore}
+     */
+    static Curve* createQuantized(unsigned int pointCount, unsigned int componentCount, int quaternionOffset, InterpolationType type,
+                                  const float* times, const float* ranges, const unsigned short* values);
+
     /**
      * Gets the number of points in the curve.
      *
@@ -312,6 +355,13 @@ public:
      */
     float getEndTime() const;
 
+    /**
+     * Determines whether the curve stores quantized key values.
+     *
+     * @return true if the curve was created with createQuantized(), false otherwise.
+     */
+    bool isQuantized() const;
+
     /**
      * Sets the given point values on the curve the curve.
      *
@@ -344,6 +394,31 @@ public:
      */
     void setTangent(unsigned int index, InterpolationType type, float* inValue, float* outValue);
 
+    /**
+     * Sets whether the BEZIER, BSPLINE, FLAT, HERMITE and SMOOTH segments of the curve are baked.
+     *
+     * A baked segment stores the coefficients of the cubic polynomial of each component, which
+     * are computed when its points are set. Evaluating it then costs a few multiply-adds per
+     * component (four components at a time where SIMD is available) instead of computing the
+     * basis functions and tangents from the points. The coefficients take four floats per
+     * component for each segment, and are only allocated once the curve has such a segment.
+     *
+     * Curves are baked by default. Quantized curves only use linear and step interpolation,
+     * so they are never baked.
+     *
+     * @param baked true to bake the curve, false to evaluate it from its points.
+     * @script{ignore}
+     */
+    void setBaked(bool baked);
+
+    /**
+     * Determines whether the cubic segments of the curve are baked.
+     *
+     * @return true if the curve is baked.
+     * @script{ignore}
+     */
+    bool isBaked() const;
+
     /**
      * Evaluates the curve at the given position value.
      *
@@ -384,11 +459,57 @@ public:
      */
     void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const;
 
+    /**
+     * Evaluates the curve at the given position value within the specified subregion of the curve,
+     * starting the search for the keyframe to interpolate from at the given cursor.
+     *
+     * The cursor holds the index of the keyframe found by the previous evaluation and is updated
+     * with the keyframe found by this one. Since playback time usually moves forward a little each
+     * frame, the keyframe is then found in constant time, falling back to a binary search when the
+     * time jumps. Each caller that evaluates the curve over time should keep its own cursor,
+     * initialized to zero.
+     *
+     * @param time The position within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curve
+     *      for looping purposes when time is outside the range 0-1. A value of zero here
+     *      disables curve looping.
+     * @param dst The evaluated value of the curve at the given time.
+     * @param cursor The keyframe cursor of the caller.
+     * @script{ignore}
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* cursor) const;
+
     /**
      * Linear interpolation function.
      */
     static float lerp(float t, float from, float to);
 
+    /**
+     * Sets how the rotations of quaternion curves are interpolated and animated rotations are blended.
+     *
+     * The default is ROTATION_SLERP. It can also be set by the "animation" section of game.config:
+     * @code
+       animation
+       {
+           rotationInterpolation = NLERP
+       }
+     * @endcode
+     *
+     * @param interpolation The rotation interpolation method.
+     * @script{ignore}
+     */
+    static void setRotationInterpolation(RotationInterpolation interpolation);
+
+    /**
+     * Returns how the rotations of quaternion curves are interpolated and animated rotations are blended.
+     *
+     * @return The rotation interpolation method.
+     * @script{ignore}
+     */
+    static RotationInterpolation getRotationInterpolation();
+
 private:
 
     /**
@@ -483,16 +604,71 @@ private:
      */
     void interpolateLinear(float s, Point* from, Point* to, float* dst) const;
 
+    /**
+     * Linear interpolation function.
+     */
+    void interpolateLinear(float s, const float* fromValue, const float* toValue, float* dst) const;
+
     /**
      * Quaternion interpolation function.
      */
-    void interpolateQuaternion(float s, float* from, float* to, float* dst) const;
+    void interpolateQuaternion(float s, const float* from, const float* to, float* dst) const;
+
+    /**
+     * Evaluates a baked segment of the curve.
+     */
+    void evaluateBaked(float s, unsigned int index, float* dst) const;
+
+    /**
+     * Computes the coefficients of the segments in the range [first, last] that have a cubic
+     * interpolation type, allocating the coefficients of the curve for its first cubic segment.
+     */
+    void bakeSegments(unsigned int first, unsigned int last);
+
+    /**
+     * Computes the coefficients of the segment starting at the specified point.
+     */
+    void bakeSegment(unsigned int index);
+
+    /**
+     * Computes the coefficients of the segments that depend on the specified point.
+     */
+    void bakePoint(unsigned int index);
+
+    /**
+     * Evaluates a quantized curve.
+     */
+    void evaluateQuantized(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* cursor) const;
+
+    /**
+     * Determines the points to interpolate between at the given time.
+     *
+     * @return false if the time is exactly on the point at fromIndex, true otherwise.
+     */
+    bool locate(float time, float startTime, float endTime, float loopBlendTime, unsigned int* cursor,
+                unsigned int* fromIndex, unsigned int* toIndex, float* t) const;
+
+    /**
+     * Decodes the value of a point of a quantized curve.
+     */
+    void decodeQuantizedKey(unsigned int index, float* dst) const;
+
+    /**
+     * Gets the time of a point.
+     */
+    float getTime(unsigned int index) const;
 
     /**
      * Determines the current keyframe to interpolate from based on the specified time.
      */
     int determineIndex(float time, unsigned int min, unsigned int max) const;
 
+    /**
+     * Determines the current keyframe to interpolate from based on the specified time, first checking
+     * the keyframe at the cursor and its neighbours.
+     */
+    int determineIndex(float time, unsigned int min, unsigned int max, unsigned int* cursor) const;
+
     /**
      * Sets the offset for the beginning of a Quaternion piece of data within the curve's value span at the specified
      * index. The next four components of data starting at the given index will be interpolated as a Quaternion.
@@ -516,6 +692,14 @@ private:
     unsigned int _componentSize;        // The component size (in bytes).
     unsigned int* _quaternionOffset;    // Offset for the rotation component.
     Point* _points;                     // The points on the curve.
+    float* _times;                      // The times of the points of a quantized curve.
+    float* _quantizedRanges;            // The minimum value and extent of each scalar component of a quantized curve.
+    unsigned short* _quantizedValues;   // The quantized values of the points.
+    unsigned int _quantizedKeySize;     // The number of quantized values per point.
+    InterpolationType _quantizedType;   // The interpolation type of a quantized curve.
+    float* _coefficients;               // The coefficients of the cubic polynomials of the baked segments.
+    unsigned int _coefficientStride;    // The number of coefficients per segment.
+    bool _baked;                        // Whether the cubic segments are baked.
 };
 
 }
@@ -0,0 +1,481 @@
+#include "Base.h"
+#include "DebugDraw.h"
+#include "Effect.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Font.h"
+#include "Game.h"
+#include "GLStateCache.h"
+#include "CommandBuffer.h"
+
+// The number of vertices of the streaming vertex buffer (an even number, since it holds lines).
+#define DEBUGDRAW_BUFFER_VERTICES 65536
+
+// The number of segments of each circle of a sphere.
+#define DEBUGDRAW_SPHERE_SEGMENTS 24
+
+namespace gameplay
+{
+
+/**
+ * A vertex of the debug geometry, with a normalized byte color to keep it to 16 bytes.
+ */
+struct DebugDrawVertex
+{
+    float x, y, z;
+    unsigned char r, g, b, a;
+};
+
+/**
+ * A line of text queued at a position in the world.
+ */
+struct DebugDrawText
+{
+    Vector3 position;
+    std::string text;
+    Vector4 color;
+    unsigned int category;
+};
+
+/**
+ * The header of the vertices copied into a command buffer by DebugDraw::drawVertices(), followed by the vertices.
+ */
+struct DebugDrawRecordedVertices
+{
+    VertexBufferHandle vertexBuffer;
+    unsigned int count;
+};
+
+static std::vector<DebugDrawVertex> __vertices[DebugDraw::CATEGORY_COUNT][2];
+static std::vector<DebugDrawText> __texts;
+static bool __categoryEnabled[DebugDraw::CATEGORY_COUNT] = { true, true, true, true };
+static Font* __font = NULL;
+static Mesh* __mesh = NULL;
+static Material* __materials[2] = { NULL, NULL };
+static unsigned int __bufferOffset = 0;
+static unsigned int __lineCount = 0;
+static bool __resourcesRequested = false;
+
+// Vertex shader for drawing colored lines.
+static const char* DEBUGDRAW_VSH =
+    "uniform mat4 u_viewProjectionMatrix;\n"
+    "attribute vec4 a_position;\n"
+    "attribute vec4 a_color;\n"
+    "varying vec4 v_color;\n"
+    "void main(void) {\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = u_viewProjectionMatrix * a_position;\n"
+    "}";
+
+// Fragment shader for drawing colored lines.
+static const char* DEBUGDRAW_FSH =
+    "#ifdef OPENGL_ES\n"
+    "precision highp float;\n"
+    "#endif\n"
+    "varying vec4 v_color;\n"
+    "void main(void) {\n"
+    "   gl_FragColor = v_color;\n"
+    "}";
+
+static inline unsigned char toByte(float value)
+{
+    return (unsigned char)(MATH_CLAMP(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static inline void addVertex(std::vector<DebugDrawVertex>& vertices, const Vector3& position, const Vector4& color)
+{
+    DebugDrawVertex vertex = { position.x, position.y, position.z, toByte(color.x), toByte(color.y), toByte(color.z), toByte(color.w) };
+    vertices.push_back(vertex);
+}
+
+// Adds the edges of a box or frustum, given with the corner order of BoundingBox::getCorners().
+static void addBoxEdges(std::vector<DebugDrawVertex>& vertices, const Vector3* corners, const Vector4& color)
+{
+    static const unsigned char EDGES[24] = { 0, 1, 1, 2, 2, 3, 3, 0, 4, 5, 5, 6, 6, 7, 7, 4, 0, 7, 1, 6, 2, 5, 3, 4 };
+
+    for (unsigned int i = 0; i < 24; ++i)
+    {
+        addVertex(vertices, corners[EDGES[i]], color);
+    }
+}
+
+// Creates the vertex buffer and the materials drawing it (with and without depth test).
+static bool createResources()
+{
+    if (__mesh)
+        return true;
+
+    // A recorded frame has no graphics context, so the resources are created between frames.
+    if (CommandBuffer::getRecording())
+    {
+        __resourcesRequested = true;
+        return false;
+    }
+
+    Effect* effect = Effect::createFromSource(DEBUGDRAW_VSH, DEBUGDRAW_FSH);
+    if (effect == NULL)
+    {
+        GP_ERROR("Failed to create the effect for debug drawing.");
+        return false;
+    }
+
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::COLOR, 4, VertexFormat::UNSIGNED_BYTE, true),
+    };
+    __mesh = Mesh::createMesh(VertexFormat(elements, 2), DEBUGDRAW_BUFFER_VERTICES, true);
+    __mesh->setPrimitiveType(Mesh::LINES);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        Material* material = Material::create(effect);
+        GP_ASSERT(material && material->getStateBlock());
+        material->getStateBlock()->setDepthTest(i == 0);
+        material->getStateBlock()->setDepthFunction(RenderState::DEPTH_LEQUAL);
+        material->getStateBlock()->setBlend(true);
+        material->getStateBlock()->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
+        material->getStateBlock()->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
+
+        Pass* pass = material->getTechnique()->getPassByIndex(0);
+        VertexAttributeBinding* binding = VertexAttributeBinding::create(__mesh, pass->getEffect());
+        pass->setVertexAttributeBinding(binding);
+        SAFE_RELEASE(binding);
+        __materials[i] = material;
+    }
+    SAFE_RELEASE(effect);
+    __bufferOffset = 0;
+    return true;
+}
+
+DebugDraw::DebugDraw()
+{
+}
+
+void DebugDraw::setCategoryEnabled(Category category, bool enabled)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    __categoryEnabled[category] = enabled;
+    if (!enabled)
+    {
+        __vertices[category][0].clear();
+        __vertices[category][1].clear();
+    }
+}
+
+bool DebugDraw::isCategoryEnabled(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    return __categoryEnabled[category];
+}
+
+void DebugDraw::drawLine(const Vector3& from, const Vector3& to, const Vector4& color, Category category, bool depthTest)
+{
+    drawLine(from, to, color, color, category, depthTest);
+}
+
+void DebugDraw::drawLine(const Vector3& from, const Vector3& to, const Vector4& fromColor, const Vector4& toColor, Category category, bool depthTest)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    if (!__categoryEnabled[category])
+        return;
+
+    std::vector<DebugDrawVertex>& vertices = __vertices[category][depthTest ? 0 : 1];
+    addVertex(vertices, from, fromColor);
+    addVertex(vertices, to, toColor);
+}
+
+void DebugDraw::drawBox(const BoundingBox& box, const Vector4& color, Category category, bool depthTest)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    if (!__categoryEnabled[category])
+        return;
+
+    Vector3 corners[8];
+    box.getCorners(corners);
+    addBoxEdges(__vertices[category][depthTest ? 0 : 1], corners, color);
+}
+
+void DebugDraw::drawBox(const BoundingBox& box, const Matrix& transform, const Vector4& color, Category category, bool depthTest)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    if (!__categoryEnabled[category])
+        return;
+
+    Vector3 corners[8];
+    box.getCorners(corners);
+    transform.transformPoints(corners, 8, corners);
+    addBoxEdges(__vertices[category][depthTest ? 0 : 1], corners, color);
+}
+
+void DebugDraw::drawSphere(const BoundingSphere& sphere, const Vector4& color, Category category, bool depthTest)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    if (!__categoryEnabled[category])
+        return;
+
+    std::vector<DebugDrawVertex>& vertices = __vertices[category][depthTest ? 0 : 1];
+    const Vector3& c = sphere.center;
+    float r = sphere.radius;
+    float previousCos = 1.0f;
+    float previousSin = 0.0f;
+    for (unsigned int i = 1; i <= DEBUGDRAW_SPHERE_SEGMENTS; ++i)
+    {
+        float angle = MATH_PIX2 * i / DEBUGDRAW_SPHERE_SEGMENTS;
+        float cosine = cos(angle);
+        float sine = sin(angle);
+        addVertex(vertices, Vector3(c.x + r * previousCos, c.y + r * previousSin, c.z), color);
+        addVertex(vertices, Vector3(c.x + r * cosine, c.y + r * sine, c.z), color);
+        addVertex(vertices, Vector3(c.x, c.y + r * previousCos, c.z + r * previousSin), color);
+        addVertex(vertices, Vector3(c.x, c.y + r * cosine, c.z + r * sine), color);
+        addVertex(vertices, Vector3(c.x + r * previousSin, c.y, c.z + r * previousCos), color);
+        addVertex(vertices, Vector3(c.x + r * sine, c.y, c.z + r * cosine), color);
+        previousCos = cosine;
+        previousSin = sine;
+    }
+}
+
+void DebugDraw::drawFrustum(const Frustum& frustum, const Vector4& color, Category category, bool depthTest)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    if (!__categoryEnabled[category])
+        return;
+
+    Vector3 corners[8];
+    frustum.getCorners(corners);
+    addBoxEdges(__vertices[category][depthTest ? 0 : 1], corners, color);
+}
+
+void DebugDraw::drawText(const Vector3& position, const char* text, const Vector4& color, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    GP_ASSERT(text);
+
+    if (!__categoryEnabled[category] || __font == NULL)
+        return;
+
+    DebugDrawText entry;
+    entry.position = position;
+    entry.text = text;
+    entry.color = color;
+    entry.category = category;
+    __texts.push_back(entry);
+}
+
+void DebugDraw::setFont(Font* font)
+{
+    if (font == __font)
+        return;
+
+    SAFE_RELEASE(__font);
+    __font = font;
+    if (__font)
+    {
+        __font->addRef();
+    }
+    else
+    {
+        __texts.clear();
+    }
+}
+
+void DebugDraw::draw(const Matrix& viewProjection)
+{
+    drawCategories(viewProjection, 0, CATEGORY_COUNT - 1);
+}
+
+void DebugDraw::draw(const Matrix& viewProjection, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    drawCategories(viewProjection, category, category);
+}
+
+void DebugDraw::clear()
+{
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        __vertices[i][0].clear();
+        __vertices[i][1].clear();
+    }
+    __texts.clear();
+}
+
+unsigned int DebugDraw::getLineCount()
+{
+    return __lineCount;
+}
+
+void DebugDraw::drawCategories(const Matrix& viewProjection, unsigned int firstCategory, unsigned int lastCategory)
+{
+    __lineCount = 0;
+
+    // Depth tested geometry first, then the geometry drawn over the scene.
+    for (unsigned int depth = 0; depth < 2; ++depth)
+    {
+        for (unsigned int i = firstCategory; i <= lastCategory; ++i)
+        {
+            std::vector<DebugDrawVertex>& vertices = __vertices[i][depth];
+            if (vertices.empty())
+                continue;
+
+            if (createResources())
+            {
+                drawVertices(i, depth, viewProjection);
+            }
+
+            // Clearing keeps the capacity, so queueing allocates nothing once the first frames were drawn.
+            vertices.clear();
+        }
+    }
+
+    if (__texts.empty() || __font == NULL)
+        return;
+
+    // Project the text to the viewport and draw it over everything.
+    const Rectangle& viewport = Game::getInstance()->getViewport();
+    bool started = false;
+    for (size_t i = 0; i < __texts.size();)
+    {
+        DebugDrawText& entry = __texts[i];
+        if (entry.category < firstCategory || entry.category > lastCategory)
+        {
+            ++i;
+            continue;
+        }
+
+        Vector4 clip;
+        viewProjection.transformVector(Vector4(entry.position.x, entry.position.y, entry.position.z, 1.0f), &clip);
+        if (clip.w > 0.0f)
+        {
+            float x = (clip.x / clip.w * 0.5f + 0.5f) * viewport.width;
+            float y = (0.5f - clip.y / clip.w * 0.5f) * viewport.height;
+            if (!started)
+            {
+                __font->start();
+                started = true;
+            }
+            __font->drawText(entry.text.c_str(), (int)x, (int)y, entry.color);
+        }
+
+        entry = __texts.back();
+        __texts.pop_back();
+    }
+    if (started)
+    {
+        __font->finish();
+    }
+}
+
+void DebugDraw::streamVertices(VertexBufferHandle vertexBuffer, const void* vertices, unsigned int count)
+{
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    const unsigned int vertexSize = sizeof(DebugDrawVertex);
+    unsigned int first = 0;
+    while (first < count)
+    {
+        // Keep appending behind the vertices drawn earlier, and only orphan the buffer once
+        // it is full, so that the driver never waits for the previous draws to complete.
+        unsigned int chunk = std::min(count - first, (unsigned int)DEBUGDRAW_BUFFER_VERTICES);
+        if (__bufferOffset + chunk > DEBUGDRAW_BUFFER_VERTICES)
+        {
+            GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, DEBUGDRAW_BUFFER_VERTICES * vertexSize, NULL, GL_STREAM_DRAW) );
+            __bufferOffset = 0;
+        }
+
+        const void* data = (const DebugDrawVertex*)vertices + first;
+        bool written = false;
+#ifdef USE_MAP_BUFFER_RANGE
+        if (glMapBufferRange)
+        {
+            void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, __bufferOffset * vertexSize, chunk * vertexSize,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (ptr)
+            {
+                memcpy(ptr, data, chunk * vertexSize);
+                written = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+            }
+        }
+#endif
+        if (!written)
+        {
+            GL_ASSERT( glBufferSubData(GL_ARRAY_BUFFER, __bufferOffset * vertexSize, chunk * vertexSize, data) );
+        }
+        Game::countBufferUpload(chunk * vertexSize);
+
+        GL_ASSERT( glDrawArrays(GL_LINES, __bufferOffset, chunk) );
+        Game::countDrawCall(GL_LINES, chunk);
+
+        __bufferOffset += chunk;
+        first += chunk;
+    }
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DebugDraw::streamRecordedVertices(void* arg)
+{
+    DebugDrawRecordedVertices* recorded = (DebugDrawRecordedVertices*)arg;
+    GP_ASSERT(recorded);
+    streamVertices(recorded->vertexBuffer, recorded + 1, recorded->count);
+}
+
+void DebugDraw::drawVertices(unsigned int category, unsigned int depth, const Matrix& viewProjection)
+{
+    const std::vector<DebugDrawVertex>& vertices = __vertices[category][depth];
+    Material* material = __materials[depth];
+    GP_ASSERT(material);
+
+    material->getParameter("u_viewProjectionMatrix")->setValue(viewProjection);
+    Pass* pass = material->getTechnique()->getPassByIndex(0);
+    pass->bind();
+
+    // The queued vertices are cleared once drawn, so a recorded frame draws a copy of them.
+    unsigned int count = (unsigned int)vertices.size();
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->retain(__mesh);
+        DebugDrawRecordedVertices* recorded = (DebugDrawRecordedVertices*)buffer->callWithData(&DebugDraw::streamRecordedVertices,
+            sizeof(DebugDrawRecordedVertices) + sizeof(DebugDrawVertex) * count);
+        recorded->vertexBuffer = __mesh->getVertexBuffer();
+        recorded->count = count;
+        memcpy(recorded + 1, &vertices[0], sizeof(DebugDrawVertex) * count);
+    }
+    else
+    {
+        streamVertices(__mesh->getVertexBuffer(), &vertices[0], count);
+    }
+    __lineCount += count / 2;
+
+    pass->unbind();
+}
+
+void DebugDraw::updateResources()
+{
+    if (__resourcesRequested)
+    {
+        __resourcesRequested = false;
+        createResources();
+    }
+}
+
+void DebugDraw::finalize()
+{
+    clear();
+    SAFE_RELEASE(__font);
+    SAFE_RELEASE(__materials[0]);
+    SAFE_RELEASE(__materials[1]);
+    SAFE_RELEASE(__mesh);
+    __bufferOffset = 0;
+    __lineCount = 0;
+}
+
+}
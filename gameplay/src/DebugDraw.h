@@ -0,0 +1,228 @@
+#ifndef DEBUGDRAW_H_
+#define DEBUGDRAW_H_
+
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Frustum.h"
+
+namespace gameplay
+{
+
+class Font;
+
+/**
+ * Defines a batched renderer for debug geometry (lines, boxes, spheres, frustums and text).
+ *
+ * Debug geometry is queued from anywhere during the frame and drawn at once by draw(),
+ * which streams the queued vertices into a single vertex buffer that persists between
+ * frames. The buffer is written front to back and only orphaned once it is full, so
+ * each draw() uploads its vertices with a handful of calls and issues one draw call per
+ * category and depth mode, however many lines were queued.
+ *
+ * Each primitive belongs to a category, which can be toggled on and off at runtime.
+ * Primitives queued for a disabled category are dropped right away, and systems that
+ * generate a lot of debug geometry (such as the physics controller) check
+ * isCategoryEnabled() to skip generating it at all.
+ *
+ * Primitives are either depth tested against the scene, or drawn over it.
+ *
+ * @code
+   DebugDraw::drawSphere(node->getBoundingSphere(), Vector4(1, 1, 0, 1), DebugDraw::CULLING);
+   DebugDraw::drawText(agentNode->getTranslationWorld(), "patrol", Vector4::one(), DebugDraw::AI);
+   ...
+   DebugDraw::draw(camera->getViewProjectionMatrix());
+ * @endcode
+ *
+ * Like sprite batches, debug geometry is drawn directly and is not recorded by command buffers.
+ *
+ * @script{ignore}
+ */
+class DebugDraw
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the categories of debug geometry.
+     */
+    enum Category
+    {
+        PHYSICS,
+        AI,
+        CULLING,
+        USER,
+        CATEGORY_COUNT
+    };
+
+    /**
+     * Enables or disables the drawing of a category (all categories are enabled by default).
+     *
+     * @param category The category.
+     * @param enabled true to draw the category, false to drop its geometry.
+     */
+    static void setCategoryEnabled(Category category, bool enabled);
+
+    /**
+     * Returns whether a category is drawn.
+     *
+     * @param category The category.
+     *
+     * @return true if the geometry of the category is drawn.
+     */
+    static bool isCategoryEnabled(Category category);
+
+    /**
+     * Queues a line.
+     *
+     * @param from The start of the line.
+     * @param to The end of the line.
+     * @param color The color of the line.
+     * @param category The category of the line.
+     * @param depthTest true to test the line against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawLine(const Vector3& from, const Vector3& to, const Vector4& color, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues a line with a color at each end.
+     *
+     * @param from The start of the line.
+     * @param to The end of the line.
+     * @param fromColor The color of the start of the line.
+     * @param toColor The color of the end of the line.
+     * @param category The category of the line.
+     * @param depthTest true to test the line against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawLine(const Vector3& from, const Vector3& to, const Vector4& fromColor, const Vector4& toColor, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues the edges of a box.
+     *
+     * @param box The box.
+     * @param color The color of the edges.
+     * @param category The category of the box.
+     * @param depthTest true to test the box against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawBox(const BoundingBox& box, const Vector4& color, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues the edges of a transformed box.
+     *
+     * @param box The box, in local space.
+     * @param transform The transform from the local space of the box to world space.
+     * @param color The color of the edges.
+     * @param category The category of the box.
+     * @param depthTest true to test the box against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawBox(const BoundingBox& box, const Matrix& transform, const Vector4& color, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues a sphere, drawn as three circles around its axes.
+     *
+     * @param sphere The sphere.
+     * @param color The color of the sphere.
+     * @param category The category of the sphere.
+     * @param depthTest true to test the sphere against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawSphere(const BoundingSphere& sphere, const Vector4& color, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues the edges of a frustum.
+     *
+     * @param frustum The frustum.
+     * @param color The color of the edges.
+     * @param category The category of the frustum.
+     * @param depthTest true to test the frustum against the depth of the scene, false to draw it over the scene.
+     */
+    static void drawFrustum(const Frustum& frustum, const Vector4& color, Category category = USER, bool depthTest = true);
+
+    /**
+     * Queues a line of text at a position in the world.
+     *
+     * Text is drawn over the scene with the font set by setFont(), and dropped if no font is set.
+     *
+     * @param position The position of the top left corner of the text, in world space.
+     * @param text The text.
+     * @param color The color of the text.
+     * @param category The category of the text.
+     */
+    static void drawText(const Vector3& position, const char* text, const Vector4& color, Category category = USER);
+
+    /**
+     * Sets the font of the text.
+     *
+     * @param font The font, or NULL to drop the text.
+     */
+    static void setFont(Font* font);
+
+    /**
+     * Draws the queued geometry of all the categories into the current viewport and clears it.
+     *
+     * @param viewProjection The view projection matrix the geometry was queued for.
+     */
+    static void draw(const Matrix& viewProjection);
+
+    /**
+     * Draws the queued geometry of a category into the current viewport and clears it.
+     *
+     * @param viewProjection The view projection matrix the geometry was queued for.
+     * @param category The category to draw.
+     */
+    static void draw(const Matrix& viewProjection, Category category);
+
+    /**
+     * Drops the queued geometry of all the categories.
+     */
+    static void clear();
+
+    /**
+     * Returns the number of lines drawn by the last call to draw().
+     *
+     * @return The number of lines drawn.
+     */
+    static unsigned int getLineCount();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    DebugDraw();
+
+    /**
+     * Draws the queued geometry of the specified range of categories.
+     */
+    static void drawCategories(const Matrix& viewProjection, unsigned int firstCategory, unsigned int lastCategory);
+
+    /**
+     * Streams the queued vertices of a category and depth mode into the vertex buffer and draws them.
+     */
+    static void drawVertices(unsigned int category, unsigned int depth, const Matrix& viewProjection);
+
+    /**
+     * Streams vertices into the vertex buffer of the debug geometry and draws them as lines, with the pass bound.
+     */
+    static void streamVertices(VertexBufferHandle vertexBuffer, const void* vertices, unsigned int count);
+
+    /**
+     * Streams the vertices copied into a command buffer by drawVertices(), when it is executed.
+     */
+    static void streamRecordedVertices(void* arg);
+
+    /**
+     * Creates the graphics resources requested while recording a frame. Called by Game between frames.
+     */
+    static void updateResources();
+
+    /**
+     * Releases the graphics resources and the queued geometry.
+     */
+    static void finalize();
+};
+
+}
+
+#endif
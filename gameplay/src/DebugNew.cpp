@@ -20,6 +20,7 @@ struct MemoryAllocationRecord
     unsigned int size;              // size of the allocation request
     const char* file;               // source file of allocation request
     int line;                       // source line of the allocation request
+    unsigned int category;          // memory tracker category of the allocation
     MemoryAllocationRecord* next;
     MemoryAllocationRecord* prev;
 #ifdef WIN32
@@ -94,6 +95,7 @@ void operator delete[] (void* p, const char* file, int line) throw()
 
 // Include Base.h (needed for logging macros) AFTER new operator impls
 #include "Base.h"
+#include "MemoryTracker.h"
 
 void* debugAlloc(std::size_t size, const char* file, int line)
 {
@@ -109,6 +111,7 @@ void* debugAlloc(std::size_t size, const char* file, int line)
     rec->size = (unsigned int)size;
     rec->file = file;
     rec->line = line;
+    rec->category = gameplay::MemoryTracker::getCurrentCategory();
     rec->next = __memoryAllocations;
     rec->prev = 0;
 
@@ -164,6 +167,7 @@ void* debugAlloc(std::size_t size, const char* file, int line)
         __memoryAllocations->prev = rec;
     __memoryAllocations = rec;
     ++__memoryAllocationCount;
+    gameplay::MemoryTracker::trackAllocation((gameplay::MemoryTracker::Category)rec->category, rec->size);
 
     return mem;
 }
@@ -193,6 +197,7 @@ void debugFree(void* p)
     if (rec->next)
         rec->next->prev = rec->prev;
     --__memoryAllocationCount;
+    gameplay::MemoryTracker::untrackAllocation((gameplay::MemoryTracker::Category)rec->category, rec->size);
 
     // Free the address from the original alloc location (before mem allocation record)
     free(mem);
@@ -303,4 +308,98 @@ void toggleTrackStackTrace()
 }
 #endif
 
+#elif defined(GP_USE_MEM_TRACKING)
+
+#include <new>
+#include <exception>
+#include <cstdlib>
+
+// The size of the header of tracked allocations, which keeps the allocations aligned for any type.
+#define MEMORY_TRACKING_HEADER_SIZE 16
+
+// The header of tracked allocations.
+struct TrackedHeader
+{
+    std::size_t size;
+    unsigned int category;
+};
+
+void* trackedAlloc(std::size_t size);
+void trackedFree(void* p);
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4290 )
+#endif
+
+void* operator new (std::size_t size) throw(std::bad_alloc)
+{
+    void* p = trackedAlloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[] (std::size_t size) throw(std::bad_alloc)
+{
+    void* p = trackedAlloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) throw()
+{
+    return trackedAlloc(size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) throw()
+{
+    return trackedAlloc(size);
+}
+
+void operator delete (void* p) throw()
+{
+    trackedFree(p);
+}
+
+void operator delete[] (void* p) throw()
+{
+    trackedFree(p);
+}
+
+#ifdef _MSC_VER
+#pragma warning( default : 4290 )
+#endif
+
+#include "Base.h"
+#include "MemoryTracker.h"
+
+void* trackedAlloc(std::size_t size)
+{
+    // The header only records the size and category of the allocation, to count them out when it is freed.
+    if (size > (std::size_t)-1 - MEMORY_TRACKING_HEADER_SIZE)
+        return NULL;
+    unsigned char* mem = (unsigned char*)malloc(size + MEMORY_TRACKING_HEADER_SIZE);
+    if (mem == NULL)
+        return NULL;
+
+    TrackedHeader* header = (TrackedHeader*)mem;
+    header->size = size;
+    header->category = gameplay::MemoryTracker::getCurrentCategory();
+    gameplay::MemoryTracker::trackAllocation((gameplay::MemoryTracker::Category)header->category, (unsigned int)header->size);
+
+    return mem + MEMORY_TRACKING_HEADER_SIZE;
+}
+
+void trackedFree(void* p)
+{
+    if (p == 0)
+        return;
+
+    unsigned char* mem = ((unsigned char*)p) - MEMORY_TRACKING_HEADER_SIZE;
+    TrackedHeader* header = (TrackedHeader*)mem;
+    gameplay::MemoryTracker::untrackAllocation((gameplay::MemoryTracker::Category)header->category, (unsigned int)header->size);
+    free(mem);
+}
+
 #endif
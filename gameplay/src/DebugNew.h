@@ -5,6 +5,10 @@
  * Global overrides of the new and delete operators for memory tracking.
  * This file is only included when memory leak detection is explicitly
  * request via the pre-processor definition GP_USE_MEM_LEAK_DETECTION.
+ *
+ * When GP_USE_MEM_TRACKING is defined instead, DebugNew.cpp replaces the
+ * global new and delete operators with lighter versions that only count
+ * allocations against the categories of the MemoryTracker.
  */
 #ifdef GP_USE_MEM_LEAK_DETECTION
 
@@ -0,0 +1,280 @@
+#include "Base.h"
+#include "DepthPyramid.h"
+#include "Camera.h"
+#include "Game.h"
+
+// Bounds whose corners are this close to the plane of the eye are treated as crossing the near plane.
+#define DEPTH_PYRAMID_W_EPSILON 0.0001f
+
+namespace gameplay
+{
+
+// Reduces a grid of depths to a smaller grid, keeping the farthest depth each texel covers.
+static void reduceDepths(const float* src, unsigned int srcWidth, unsigned int srcHeight,
+                         float* dst, unsigned int dstWidth, unsigned int dstHeight)
+{
+    for (unsigned int y = 0; y < dstHeight; ++y)
+    {
+        unsigned int y0 = y * srcHeight / dstHeight;
+        unsigned int y1 = std::max(((y + 1) * srcHeight + dstHeight - 1) / dstHeight, y0 + 1);
+        for (unsigned int x = 0; x < dstWidth; ++x)
+        {
+            unsigned int x0 = x * srcWidth / dstWidth;
+            unsigned int x1 = std::max(((x + 1) * srcWidth + dstWidth - 1) / dstWidth, x0 + 1);
+            float farthest = 0.0f;
+            for (unsigned int sy = y0; sy < y1 && sy < srcHeight; ++sy)
+            {
+                const float* row = &src[sy * srcWidth];
+                for (unsigned int sx = x0; sx < x1 && sx < srcWidth; ++sx)
+                    farthest = std::max(farthest, row[sx]);
+            }
+            dst[y * dstWidth + x] = farthest;
+        }
+    }
+}
+
+DepthPyramid::DepthPyramid(unsigned int width, unsigned int height)
+    : _valid(false), _occludedCount(0), _buffer(0), _bufferSize(0), _pendingWidth(0), _pendingHeight(0), _pending(false)
+{
+    GP_ASSERT(width > 0 && height > 0);
+
+    // Each level is half the size of the one below it, rounded up, down to a single texel.
+    unsigned int offset = 0;
+    while (true)
+    {
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.offset = offset;
+        _levels.push_back(level);
+        offset += width * height;
+        if (width == 1 && height == 1)
+            break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    _depths.resize(offset, 1.0f);
+}
+
+DepthPyramid::~DepthPyramid()
+{
+#ifdef USE_DEPTH_READBACK
+    if (_buffer)
+    {
+        GL_ASSERT( glDeleteBuffers(1, &_buffer) );
+    }
+#endif
+}
+
+DepthPyramid* DepthPyramid::create(unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0)
+    {
+        GP_WARN("Invalid depth pyramid size: %u x %u.", width, height);
+        return NULL;
+    }
+    return new DepthPyramid(width, height);
+}
+
+bool DepthPyramid::isCaptureSupported()
+{
+#ifdef USE_DEPTH_READBACK
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DepthPyramid::capture(Camera* camera)
+{
+    GP_ASSERT(camera);
+
+#ifdef USE_DEPTH_READBACK
+    const Rectangle& viewport = Game::getInstance()->getViewport();
+    unsigned int width = (unsigned int)viewport.width;
+    unsigned int height = (unsigned int)viewport.height;
+    if (width == 0 || height == 0)
+        return false;
+
+    // The depths are copied into a pixel buffer, so the read does not wait for the frame to finish.
+    unsigned int size = width * height * sizeof(float);
+    if (_buffer == 0)
+    {
+        GL_ASSERT( glGenBuffers(1, &_buffer) );
+    }
+    GL_ASSERT( glBindBuffer(GL_PIXEL_PACK_BUFFER, _buffer) );
+    if (size != _bufferSize)
+    {
+        GL_ASSERT( glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ) );
+        _bufferSize = size;
+    }
+    GL_ASSERT( glReadPixels((GLint)viewport.x, (GLint)viewport.y, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, 0) );
+    GL_ASSERT( glBindBuffer(GL_PIXEL_PACK_BUFFER, 0) );
+
+    _pendingWidth = width;
+    _pendingHeight = height;
+    _pendingViewProjection = camera->getViewProjectionMatrix();
+    _pending = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DepthPyramid::resolve()
+{
+#ifdef USE_DEPTH_READBACK
+    if (!_pending)
+        return;
+    _pending = false;
+
+    GL_ASSERT( glBindBuffer(GL_PIXEL_PACK_BUFFER, _buffer) );
+    const float* depths = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, _pendingWidth * _pendingHeight * sizeof(float), GL_MAP_READ_BIT);
+    if (depths)
+    {
+        setDepth(depths, _pendingWidth, _pendingHeight, _pendingViewProjection);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    GL_ASSERT( glBindBuffer(GL_PIXEL_PACK_BUFFER, 0) );
+#endif
+}
+
+void DepthPyramid::setDepth(const float* depths, unsigned int width, unsigned int height, const Matrix& viewProjection)
+{
+    GP_ASSERT(depths);
+
+    if (width == 0 || height == 0)
+    {
+        invalidate();
+        return;
+    }
+
+    const Level& finest = _levels[0];
+    reduceDepths(depths, width, height, &_depths[finest.offset], finest.width, finest.height);
+    buildLevels();
+    _viewProjection = viewProjection;
+    _valid = true;
+    _occludedCount = 0;
+}
+
+void DepthPyramid::buildLevels()
+{
+    // Each texel covers exactly the 2x2 texels below it (fewer at odd edges), so a texel of
+    // level L covers the texels of the finest level from 2^L times its coordinates.
+    for (size_t i = 1, count = _levels.size(); i < count; ++i)
+    {
+        const Level& below = _levels[i - 1];
+        const Level& level = _levels[i];
+        const float* src = &_depths[below.offset];
+        float* dst = &_depths[level.offset];
+        for (unsigned int y = 0; y < level.height; ++y)
+        {
+            unsigned int y0 = y * 2;
+            unsigned int y1 = std::min(y0 + 1, below.height - 1);
+            for (unsigned int x = 0; x < level.width; ++x)
+            {
+                unsigned int x0 = x * 2;
+                unsigned int x1 = std::min(x0 + 1, below.width - 1);
+                dst[y * level.width + x] = std::max(std::max(src[y0 * below.width + x0], src[y0 * below.width + x1]),
+                                                    std::max(src[y1 * below.width + x0], src[y1 * below.width + x1]));
+            }
+        }
+    }
+}
+
+void DepthPyramid::invalidate()
+{
+    _valid = false;
+    _pending = false;
+}
+
+bool DepthPyramid::isValid() const
+{
+    return _valid;
+}
+
+unsigned int DepthPyramid::getLevelCount() const
+{
+    return (unsigned int)_levels.size();
+}
+
+unsigned int DepthPyramid::getOccludedCount() const
+{
+    return _occludedCount;
+}
+
+bool DepthPyramid::isOccluded(const BoundingBox& box) const
+{
+    if (!_valid || box.isEmpty())
+        return false;
+
+    Vector3 corners[8];
+    box.getCorners(corners);
+    Vector4 points[8];
+    for (unsigned int i = 0; i < 8; ++i)
+        points[i].set(corners[i].x, corners[i].y, corners[i].z, 1.0f);
+    _viewProjection.transformVectors(points, 8, points);
+
+    // Project the box into the captured view. Boxes that cross its near plane or its edges may be visible.
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f, nearest = 1.0f;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        const Vector4& p = points[i];
+        if (p.w < DEPTH_PYRAMID_W_EPSILON)
+            return false;
+        float invW = 1.0f / p.w;
+        float x = p.x * invW;
+        float y = p.y * invW;
+        if (x < -1.0f || x > 1.0f || y < -1.0f || y > 1.0f)
+            return false;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, p.z * invW);
+    }
+    nearest = nearest * 0.5f + 0.5f;
+    if (nearest <= 0.0f)
+        return false;
+
+    // Pick the level where the rectangle spans at most two texels (three where it straddles them).
+    const Level& finest = _levels[0];
+    float x0 = (minX * 0.5f + 0.5f) * finest.width;
+    float x1 = (maxX * 0.5f + 0.5f) * finest.width;
+    float y0 = (minY * 0.5f + 0.5f) * finest.height;
+    float y1 = (maxY * 0.5f + 0.5f) * finest.height;
+    float extent = std::max(x1 - x0, y1 - y0);
+    unsigned int index = 0;
+    while ((float)(1u << index) < extent && index + 1 < _levels.size())
+        ++index;
+
+    const Level& level = _levels[index];
+    float scale = 1.0f / (float)(1u << index);
+    unsigned int tx0 = std::min((unsigned int)(x0 * scale), level.width - 1);
+    unsigned int tx1 = std::min((unsigned int)(x1 * scale), level.width - 1);
+    unsigned int ty0 = std::min((unsigned int)(y0 * scale), level.height - 1);
+    unsigned int ty1 = std::min((unsigned int)(y1 * scale), level.height - 1);
+    const float* depths = &_depths[level.offset];
+    for (unsigned int y = ty0; y <= ty1; ++y)
+    {
+        for (unsigned int x = tx0; x <= tx1; ++x)
+        {
+            if (depths[y * level.width + x] >= nearest)
+                return false;
+        }
+    }
+
+    ++_occludedCount;
+    return true;
+}
+
+bool DepthPyramid::isOccluded(const BoundingSphere& sphere) const
+{
+    if (!_valid || sphere.isEmpty())
+        return false;
+
+    Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+    return isOccluded(BoundingBox(sphere.center - extent, sphere.center + extent));
+}
+
+}
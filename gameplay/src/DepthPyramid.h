@@ -0,0 +1,203 @@
+#ifndef DEPTHPYRAMID_H_
+#define DEPTHPYRAMID_H_
+
+#include "Ref.h"
+#include "Matrix.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+
+namespace gameplay
+{
+
+class Camera;
+
+/**
+ * Defines a hierarchical depth buffer (Hi-Z) of a previous frame, that culling tests bounds against on the CPU.
+ *
+ * The pyramid keeps the depth buffer of a frame as a chain of levels, each half the size of the
+ * one below it, where each texel holds the farthest depth of the four texels it covers. Bounds
+ * are projected with the view projection of the frame the depth was captured from, and are hidden
+ * if the nearest depth of their corners is behind the farthest depth of the texels their screen
+ * rectangle covers, at the level where that rectangle spans two texels. A test costs the
+ * projection of eight corners and at most nine texel reads, whatever the size of the bounds, so
+ * that the quadtree of a terrain can reject whole regions behind hills without occlusion queries
+ * and the latency of reading their results.
+ *
+ * Once a pyramid is given to a Scene with Scene::setDepthPyramid(), Scene::cull() skips the cells
+ * of its spatial index and the nodes whose bounds are hidden, and terrains in the scene skip the
+ * regions of their quadtree that are hidden. The depth is captured at the end of a frame and
+ * tested against on the next one:
+ *
+ * @code
+   DepthPyramid* pyramid = DepthPyramid::create();
+   scene->setDepthPyramid(pyramid);
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+       _scene->visit(this, &MyGame::drawScene);
+       _pyramid->capture(_scene->getActiveCamera());
+   }
+ * @endcode
+ *
+ * The test is conservative for the geometry that was in the depth buffer: bounds are only hidden
+ * behind depth that was captured, and are visible at any part of their screen rectangle outside
+ * the captured view, or when they cross the near plane of that view. Since the depth is from a
+ * previous frame, geometry that moves out of the way of hidden bounds reveals them a frame late.
+ *
+ * On the platforms that can read the depth buffer back (see isCaptureSupported()), capture()
+ * copies it into a pixel buffer without waiting, and the copy is read when the pyramid is next
+ * used. Elsewhere, the depth can be supplied with setDepth(), for example from a software raster
+ * of the occluders.
+ *
+ * @script{ignore}
+ */
+class DepthPyramid : public Ref
+{
+public:
+
+    /**
+     * Creates a depth pyramid.
+     *
+     * @param width The width of the finest level of the pyramid.
+     * @param height The height of the finest level of the pyramid.
+     *
+     * @return The new depth pyramid.
+     */
+    static DepthPyramid* create(unsigned int width = 256, unsigned int height = 128);
+
+    /**
+     * Returns whether capture() can read the depth buffer back on this platform.
+     *
+     * @return True if the depth buffer can be captured.
+     */
+    static bool isCaptureSupported();
+
+    /**
+     * Starts copying the depth buffer of the viewport of the bound frame buffer, as it was drawn by a camera.
+     *
+     * This must be called once the scene is drawn, before the frame buffer is cleared. The copy
+     * replaces the depth of the pyramid when the pyramid is next used.
+     *
+     * @param camera The camera the depth buffer was drawn with.
+     *
+     * @return True if the copy was started, false if the depth buffer cannot be captured.
+     */
+    bool capture(Camera* camera);
+
+    /**
+     * Replaces the depth of the pyramid.
+     *
+     * @param depths The window depths (between 0 and 1), by rows from the bottom of the view.
+     * @param width The number of depths in each row.
+     * @param height The number of rows.
+     * @param viewProjection The view projection matrix the depths were computed with.
+     */
+    void setDepth(const float* depths, unsigned int width, unsigned int height, const Matrix& viewProjection);
+
+    /**
+     * Builds the pyramid from the last depth buffer captured, if its copy is waiting to be read.
+     *
+     * The scene and terrains call this before they cull.
+     */
+    void resolve();
+
+    /**
+     * Discards the depth of the pyramid, so that nothing is hidden until depth is captured again.
+     *
+     * This should be called when the view changes abruptly, such as on a camera cut.
+     */
+    void invalidate();
+
+    /**
+     * Returns whether the pyramid holds depth to test against.
+     *
+     * @return True if the pyramid has depth.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns the number of levels of the pyramid.
+     *
+     * @return The number of levels.
+     */
+    unsigned int getLevelCount() const;
+
+    /**
+     * Determines if a box is hidden behind the depth of the pyramid.
+     *
+     * @param box The box, in world space.
+     *
+     * @return True if the box is hidden, false if it may be visible.
+     */
+    bool isOccluded(const BoundingBox& box) const;
+
+    /**
+     * Determines if a sphere is hidden behind the depth of the pyramid.
+     *
+     * @param sphere The sphere, in world space.
+     *
+     * @return True if the sphere is hidden, false if it may be visible.
+     */
+    bool isOccluded(const BoundingSphere& sphere) const;
+
+    /**
+     * Returns the number of bounds found hidden since the depth of the pyramid was last replaced.
+     *
+     * @return The number of hidden bounds.
+     */
+    unsigned int getOccludedCount() const;
+
+private:
+
+    /**
+     * Defines a level of the pyramid.
+     */
+    struct Level
+    {
+        unsigned int width;
+        unsigned int height;
+        unsigned int offset;
+    };
+
+    /**
+     * Constructor.
+     */
+    DepthPyramid(unsigned int width, unsigned int height);
+
+    /**
+     * Destructor.
+     */
+    ~DepthPyramid();
+
+    /**
+     * Hidden copy constructor.
+     */
+    DepthPyramid(const DepthPyramid& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    DepthPyramid& operator=(const DepthPyramid&);
+
+    /**
+     * Reduces the levels above the finest one.
+     */
+    void buildLevels();
+
+    std::vector<Level> _levels;
+    std::vector<float> _depths;
+    Matrix _viewProjection;
+    bool _valid;
+    mutable unsigned int _occludedCount;
+    unsigned int _buffer;
+    unsigned int _bufferSize;
+    unsigned int _pendingWidth;
+    unsigned int _pendingHeight;
+    Matrix _pendingViewProjection;
+    bool _pending;
+};
+
+}
+
+#endif
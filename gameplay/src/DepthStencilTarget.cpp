@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "DepthStencilTarget.h"
+#include "GraphicsMemory.h"
 
 #ifndef GL_DEPTH24_STENCIL8_OES
 #define GL_DEPTH24_STENCIL8_OES 0x88F0
@@ -14,12 +15,14 @@ namespace gameplay
 static std::vector<DepthStencilTarget*> __depthStencilTargets;
 
 DepthStencilTarget::DepthStencilTarget(const char* id, Format format, unsigned int width, unsigned int height)
-    : _id(id ? id : ""), _format(format), _depthBuffer(0), _stencilBuffer(0), _width(width), _height(height), _packed(false)
+    : GraphicsResource(RESTORE_RENDER_BUFFERS), _id(id ? id : ""), _format(format), _depthBuffer(0), _stencilBuffer(0), _width(width), _height(height), _packed(false), _memorySize(0)
 {
 }
 
 DepthStencilTarget::~DepthStencilTarget()
 {
+    GraphicsMemory::untrack(GraphicsMemory::DEPTH_STENCIL, _memorySize);
+
     // Destroy GL resources.
     if (_depthBuffer)
         GL_ASSERT( glDeleteRenderbuffers(1, &_depthBuffer) );
@@ -39,12 +42,23 @@ DepthStencilTarget* DepthStencilTarget::create(const char* id, Format format, un
     // Create the depth stencil target.
     DepthStencilTarget* depthStencilTarget = new DepthStencilTarget(id, format, width, height);
 
+    depthStencilTarget->createRenderBuffers();
+
+    // Add it to the cache.
+    __depthStencilTargets.push_back(depthStencilTarget);
+
+    return depthStencilTarget;
+}
+
+void DepthStencilTarget::createRenderBuffers()
+{
     // Create a render buffer for this new depth+stencil target
-    GL_ASSERT( glGenRenderbuffers(1, &depthStencilTarget->_depthBuffer) );
-    GL_ASSERT( glBindRenderbuffer(GL_RENDERBUFFER, depthStencilTarget->_depthBuffer) );
+    GL_ASSERT( glGenRenderbuffers(1, &_depthBuffer) );
+    GL_ASSERT( glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer) );
 
     // First try to add storage for the most common standard GL_DEPTH24_STENCIL8 
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
+    unsigned int bytesPerPixel = 4;
 
     // Fall back to less common GLES2 extension combination for seperate depth24 + stencil8 or depth16 + stencil8
     __gl_error_code = glGetError();
@@ -54,37 +68,51 @@ DepthStencilTarget* DepthStencilTarget::create(const char* id, Format format, un
 
         if (strstr(extString, "GL_OES_packed_depth_stencil") != 0)
         {
-            GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, width, height) );
-            depthStencilTarget->_packed = true;
+            GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _width, _height) );
+            _packed = true;
         }
         else
         {
             if (strstr(extString, "GL_OES_depth24") != 0)
             {
-                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height) );
+                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height) );
             }
             else
             {
-                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height) );
+                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, _width, _height) );
+                bytesPerPixel = 2;
             }
-            if (format == DepthStencilTarget::DEPTH_STENCIL)
+            if (_format == DepthStencilTarget::DEPTH_STENCIL)
             {
-                GL_ASSERT( glGenRenderbuffers(1, &depthStencilTarget->_stencilBuffer) );
-                GL_ASSERT( glBindRenderbuffer(GL_RENDERBUFFER, depthStencilTarget->_stencilBuffer) );
-                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height) );
+                GL_ASSERT( glGenRenderbuffers(1, &_stencilBuffer) );
+                GL_ASSERT( glBindRenderbuffer(GL_RENDERBUFFER, _stencilBuffer) );
+                GL_ASSERT( glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, _width, _height) );
+                bytesPerPixel += 1;
             }
         }
     }
     else
     {
         // Packed format GL_DEPTH24_STENCIL8 is used mark format as packed.
-        depthStencilTarget->_packed = true;
+        _packed = true;
     }
 
-    // Add it to the cache.
-    __depthStencilTargets.push_back(depthStencilTarget);
+    // Depth24 is stored in 32 bits, like the packed formats.
+    GraphicsMemory::untrack(GraphicsMemory::DEPTH_STENCIL, _memorySize);
+    _memorySize = _width * _height * bytesPerPixel;
+    GraphicsMemory::track(GraphicsMemory::DEPTH_STENCIL, _memorySize);
+}
 
-    return depthStencilTarget;
+void DepthStencilTarget::discardGraphics()
+{
+    _depthBuffer = 0;
+    _stencilBuffer = 0;
+}
+
+void DepthStencilTarget::restoreGraphics()
+{
+    _packed = false;
+    createRenderBuffers();
 }
 
 DepthStencilTarget* DepthStencilTarget::getDepthStencilTarget(const char* id)
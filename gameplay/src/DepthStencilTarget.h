@@ -3,6 +3,7 @@
 
 #include "Base.h"
 #include "Texture.h"
+#include "GraphicsResource.h"
 
 namespace gameplay
 {
@@ -10,7 +11,7 @@ namespace gameplay
 /**
  * Defines a container for depth and stencil targets in a frame buffer object.
  */
-class DepthStencilTarget : public Ref
+class DepthStencilTarget : public Ref, private GraphicsResource
 {
     friend class FrameBuffer;
 
@@ -106,6 +107,21 @@ private:
      */
     DepthStencilTarget& operator=(const DepthStencilTarget&);
 
+    /**
+     * Creates the render buffers of the target, falling back to the formats supported by the device.
+     */
+    void createRenderBuffers();
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     */
+    void restoreGraphics();
+
     std::string _id;
     Format _format;
     RenderBufferHandle _depthBuffer;
@@ -113,6 +129,7 @@ private:
     unsigned int _width;
     unsigned int _height;
     bool _packed;
+    unsigned int _memorySize;
 };
 
 }
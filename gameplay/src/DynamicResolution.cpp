@@ -0,0 +1,193 @@
+#include "Base.h"
+#include "DynamicResolution.h"
+#include "Game.h"
+#include "FrameBuffer.h"
+#include "DepthStencilTarget.h"
+#include "SpriteBatch.h"
+
+// The frames between two adjustments of the scale, which leaves time for the timer results of the new scale to arrive.
+#define DYNAMIC_RESOLUTION_ADJUST_FRAMES 4
+// The largest change of the scale in one adjustment.
+#define DYNAMIC_RESOLUTION_MAX_STEP 0.05f
+// The share of the target GPU time below which the scale goes back up.
+#define DYNAMIC_RESOLUTION_RAISE_LOAD 0.8f
+
+namespace gameplay
+{
+
+static unsigned int __dynamicResolutionCount = 0;
+
+DynamicResolution::DynamicResolution(float targetGpuTime, float minScale, float maxScale)
+    : _targetGpuTime(targetGpuTime), _minScale(minScale), _maxScale(maxScale), _scale(maxScale), _adaptive(true),
+      _framesSinceAdjust(0), _width(0), _height(0), _frameBuffer(NULL), _previous(NULL), _batch(NULL)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    SAFE_DELETE(_batch);
+    SAFE_RELEASE(_frameBuffer);
+}
+
+DynamicResolution* DynamicResolution::create(float targetGpuTime, float minScale, float maxScale)
+{
+    GP_ASSERT(targetGpuTime > 0.0f);
+    GP_ASSERT(minScale > 0.0f && minScale <= maxScale);
+
+    return new DynamicResolution(targetGpuTime, minScale, maxScale);
+}
+
+void DynamicResolution::setTargetGpuTime(float targetGpuTime)
+{
+    GP_ASSERT(targetGpuTime > 0.0f);
+    _targetGpuTime = targetGpuTime;
+}
+
+float DynamicResolution::getTargetGpuTime() const
+{
+    return _targetGpuTime;
+}
+
+void DynamicResolution::setScaleRange(float minScale, float maxScale)
+{
+    GP_ASSERT(minScale > 0.0f && minScale <= maxScale);
+    _minScale = minScale;
+    _maxScale = maxScale;
+    _scale = std::min(std::max(_scale, _minScale), _maxScale);
+}
+
+float DynamicResolution::getMinScale() const
+{
+    return _minScale;
+}
+
+float DynamicResolution::getMaxScale() const
+{
+    return _maxScale;
+}
+
+void DynamicResolution::setScale(float scale)
+{
+    _scale = std::min(std::max(scale, _minScale), _maxScale);
+    _framesSinceAdjust = 0;
+}
+
+float DynamicResolution::getScale() const
+{
+    return _scale;
+}
+
+void DynamicResolution::setAdaptive(bool adaptive)
+{
+    _adaptive = adaptive;
+}
+
+bool DynamicResolution::isAdaptive() const
+{
+    return _adaptive;
+}
+
+unsigned int DynamicResolution::getWidth() const
+{
+    return _width;
+}
+
+unsigned int DynamicResolution::getHeight() const
+{
+    return _height;
+}
+
+FrameBuffer* DynamicResolution::getFrameBuffer() const
+{
+    return _frameBuffer;
+}
+
+void DynamicResolution::bind()
+{
+    Game* game = Game::getInstance();
+    _viewport = game->getViewport();
+
+    if (!updateFrameBuffer((unsigned int)ceilf(_viewport.width * _maxScale), (unsigned int)ceilf(_viewport.height * _maxScale)))
+        return;
+
+    if (_adaptive)
+    {
+        adjustScale();
+    }
+
+    _width = std::max((unsigned int)(_viewport.width * _scale), 1u);
+    _height = std::max((unsigned int)(_viewport.height * _scale), 1u);
+
+    _previous = _frameBuffer->bind();
+    game->setViewport(Rectangle(0, 0, (float)_width, (float)_height));
+}
+
+void DynamicResolution::draw()
+{
+    if (_previous == NULL)
+        return;
+
+    Game* game = Game::getInstance();
+    _previous->bind();
+    _previous = NULL;
+    game->setViewport(_viewport);
+
+    // Stretch the rendered region of the frame buffer, whose rows start at the bottom, over the viewport.
+    Matrix projection;
+    Matrix::createOrthographicOffCenter(0, _viewport.width, _viewport.height, 0, 0, 1, &projection);
+    _batch->setProjectionMatrix(projection);
+    float u = (float)_width / _frameBuffer->getWidth();
+    float v = (float)_height / _frameBuffer->getHeight();
+    _batch->start();
+    _batch->draw(0, 0, _viewport.width, _viewport.height, 0, v, u, 0, Vector4::one());
+    _batch->finish();
+}
+
+void DynamicResolution::adjustScale()
+{
+    float gpuTime = Game::getInstance()->getRenderStats().gpuTime;
+    if (gpuTime <= 0.0f || ++_framesSinceAdjust < DYNAMIC_RESOLUTION_ADJUST_FRAMES)
+        return;
+
+    if (gpuTime > _targetGpuTime || gpuTime < _targetGpuTime * DYNAMIC_RESOLUTION_RAISE_LOAD)
+    {
+        // The fill cost follows the pixel count, which is the square of the scale.
+        float scale = _scale * sqrtf(_targetGpuTime * (gpuTime > _targetGpuTime ? 1.0f : DYNAMIC_RESOLUTION_RAISE_LOAD) / gpuTime);
+        scale = std::min(std::max(scale, _scale - DYNAMIC_RESOLUTION_MAX_STEP), _scale + DYNAMIC_RESOLUTION_MAX_STEP);
+        _scale = std::min(std::max(scale, _minScale), _maxScale);
+    }
+    _framesSinceAdjust = 0;
+}
+
+bool DynamicResolution::updateFrameBuffer(unsigned int width, unsigned int height)
+{
+    width = std::max(width, 1u);
+    height = std::max(height, 1u);
+    if (_frameBuffer && _frameBuffer->getWidth() == width && _frameBuffer->getHeight() == height)
+        return true;
+
+    SAFE_DELETE(_batch);
+    SAFE_RELEASE(_frameBuffer);
+
+    char id[32];
+    sprintf(id, "__dynamicResolution%u", ++__dynamicResolutionCount);
+    _frameBuffer = FrameBuffer::create(id, width, height);
+    if (_frameBuffer == NULL || _frameBuffer->getRenderTarget() == NULL)
+    {
+        GP_ERROR("Failed to create the frame buffer of a dynamic resolution scaler.");
+        SAFE_RELEASE(_frameBuffer);
+        return false;
+    }
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(id, DepthStencilTarget::DEPTH_STENCIL, width, height);
+    _frameBuffer->setDepthStencilTarget(depthTarget);
+    SAFE_RELEASE(depthTarget);
+
+    _batch = SpriteBatch::create(_frameBuffer->getRenderTarget()->getTexture());
+    _batch->getSampler()->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    _batch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    _batch->getStateBlock()->setBlend(false);
+    _batch->getStateBlock()->setDepthTest(false);
+    return true;
+}
+
+}
@@ -0,0 +1,205 @@
+#ifndef DYNAMICRESOLUTION_H_
+#define DYNAMICRESOLUTION_H_
+
+#include "Ref.h"
+#include "Rectangle.h"
+
+namespace gameplay
+{
+
+class FrameBuffer;
+class SpriteBatch;
+
+/**
+ * Defines a scaler that renders the scene at a resolution chosen to hold a GPU frame time.
+ *
+ * Between bind() and draw(), the scene renders into an internal frame buffer, over a viewport
+ * that is the viewport of the game scaled by getScale(). draw() then upscales that region over
+ * the viewport of the game, so everything drawn afterwards, such as forms, is drawn at the native
+ * resolution.
+ *
+ * Each time bind() is called, the scale is adjusted from the GPU time measured by the timer
+ * queries of the game (see Game::RenderStats): it goes down while frames take longer than the
+ * target GPU time and back up once they leave enough room. Timer results arrive a few frames
+ * late, so the scale only moves by small steps every few frames. Without timer query support
+ * the scale stays where setScale() put it.
+ *
+ * The frame buffer is allocated at the maximum scale, so changing the scale never allocates.
+ * Only the lower-left region of its texture, of size getWidth() by getHeight(), holds the scene.
+ *
+ * @code
+   _resolution = DynamicResolution::create(12.0f, 0.5f);
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       _resolution->bind();
+       clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+       _scene->visit(this, &MyGame::drawScene);
+       _resolution->draw();
+
+       _hud->draw();
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class DynamicResolution : public Ref
+{
+public:
+
+    /**
+     * Creates a dynamic resolution scaler.
+     *
+     * @param targetGpuTime The GPU time to hold, in milliseconds.
+     * @param minScale The lowest scale of the scene resolution.
+     * @param maxScale The highest scale of the scene resolution.
+     *
+     * @return The new scaler.
+     */
+    static DynamicResolution* create(float targetGpuTime, float minScale = 0.5f, float maxScale = 1.0f);
+
+    /**
+     * Sets the GPU time the scale is adjusted to hold.
+     *
+     * @param targetGpuTime The GPU time, in milliseconds.
+     */
+    void setTargetGpuTime(float targetGpuTime);
+
+    /**
+     * Returns the GPU time the scale is adjusted to hold.
+     *
+     * @return The GPU time, in milliseconds.
+     */
+    float getTargetGpuTime() const;
+
+    /**
+     * Sets the range of the scale.
+     *
+     * @param minScale The lowest scale.
+     * @param maxScale The highest scale, which sets the size of the frame buffer.
+     */
+    void setScaleRange(float minScale, float maxScale);
+
+    /**
+     * Returns the lowest scale.
+     *
+     * @return The lowest scale.
+     */
+    float getMinScale() const;
+
+    /**
+     * Returns the highest scale.
+     *
+     * @return The highest scale.
+     */
+    float getMaxScale() const;
+
+    /**
+     * Sets the scale of the scene resolution, clamped to the range of the scale.
+     *
+     * @param scale The scale.
+     */
+    void setScale(float scale);
+
+    /**
+     * Returns the scale the scene is rendered at.
+     *
+     * @return The scale.
+     */
+    float getScale() const;
+
+    /**
+     * Sets whether the scale is adjusted from the GPU time.
+     *
+     * @param adaptive true to adjust the scale, false to keep the scale set with setScale().
+     */
+    void setAdaptive(bool adaptive);
+
+    /**
+     * Determines if the scale is adjusted from the GPU time.
+     *
+     * @return true if the scale is adjusted.
+     */
+    bool isAdaptive() const;
+
+    /**
+     * Returns the width of the scene viewport set by the last bind().
+     *
+     * @return The width, in pixels.
+     */
+    unsigned int getWidth() const;
+
+    /**
+     * Returns the height of the scene viewport set by the last bind().
+     *
+     * @return The height, in pixels.
+     */
+    unsigned int getHeight() const;
+
+    /**
+     * Returns the frame buffer the scene is rendered into.
+     *
+     * @return The frame buffer, or NULL before the first bind().
+     */
+    FrameBuffer* getFrameBuffer() const;
+
+    /**
+     * Adjusts the scale, then binds the frame buffer and sets the scaled viewport.
+     */
+    void bind();
+
+    /**
+     * Binds the frame buffer that was bound before bind(), restores the viewport of the
+     * game and upscales the scene over it.
+     */
+    void draw();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    DynamicResolution(float targetGpuTime, float minScale, float maxScale);
+
+    /**
+     * Destructor.
+     */
+    ~DynamicResolution();
+
+    /**
+     * Hidden copy constructor.
+     */
+    DynamicResolution(const DynamicResolution& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    DynamicResolution& operator=(const DynamicResolution&);
+
+    /**
+     * Moves the scale towards the target GPU time.
+     */
+    void adjustScale();
+
+    /**
+     * Creates the frame buffer if it does not exist or no longer fits the viewport.
+     */
+    bool updateFrameBuffer(unsigned int width, unsigned int height);
+
+    float _targetGpuTime;
+    float _minScale;
+    float _maxScale;
+    float _scale;
+    bool _adaptive;
+    unsigned int _framesSinceAdjust;
+    unsigned int _width;
+    unsigned int _height;
+    Rectangle _viewport;
+    FrameBuffer* _frameBuffer;
+    FrameBuffer* _previous;
+    SpriteBatch* _batch;
+};
+
+}
+
+#endif
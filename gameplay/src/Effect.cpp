@@ -2,6 +2,9 @@
 #include "Effect.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "RenderState.h"
+#include "CommandBuffer.h"
+#include "GLStateCache.h"
 
 #define OPENGL_ES_DEFINE  "OPENGL_ES"
 
@@ -10,16 +13,85 @@ namespace gameplay
 
 // Cache of unique effects.
 static std::map<std::string, Effect*> __effectCache;
+static Mutex __effectCacheMutex;
 static Effect* __currentEffect = NULL;
+static unsigned int __uniformUploadCount = 0;
+static unsigned int __uniformSkipCount = 0;
 
-Effect::Effect() : _program(0)
+// Directory of the cached program binaries, or empty when caching is disabled.
+static std::string __programCachePath;
+
+// Shader files with their #include directives expanded, and the #define lines shared by every effect.
+static std::map<std::string, std::string> __expandedSources;
+static std::string __globalDefines;
+static bool __globalDefinesLoaded = false;
+static Mutex __expandedSourcesMutex;
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Default time, in milliseconds, spent per frame finishing warmed up effects.
+#define EFFECT_WARM_UP_BUDGET 4.0f
+
+struct Effect::WarmUp
+{
+    std::string id;
+    std::string vshPath;
+    std::string fshPath;
+    std::string defines;
+    std::string vshSource;
+    std::string fshSource;
+    GLuint program;
+    GLuint vertexShader;
+    GLuint fragmentShader;
+    bool linked;
+    bool retrievable;
+    std::string cacheFile;
+    unsigned int checkHash;
+};
+
+static std::vector<Effect*> __warmedEffects;
+static unsigned int __warmUpTotal = 0;
+static float __warmUpBudget = EFFECT_WARM_UP_BUDGET;
+static int __parallelCompile = -1;
+
+/**
+ * Returns whether the driver compiles shaders in the background (KHR_parallel_shader_compile).
+ */
+static bool isParallelCompileSupported()
+{
+    if (__parallelCompile == -1)
+    {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        __parallelCompile = (extensions && (strstr(extensions, "GL_KHR_parallel_shader_compile") || strstr(extensions, "GL_ARB_parallel_shader_compile"))) ? 1 : 0;
+    }
+    return __parallelCompile == 1;
+}
+
+std::vector<Effect::WarmUp*> Effect::_warmUps;
+
+Effect::Effect() : GraphicsResource(RESTORE_PROGRAMS), _program(0), _instanceMatrixAttribute(-1), _frameUniforms(false)
 {
 }
 
 Effect::~Effect()
 {
     // Remove this effect from the cache.
-    __effectCache.erase(_id);
+    if (!_id.empty())
+    {
+        Mutex::Lock lock(__effectCacheMutex);
+        std::map<std::string, Effect*>::iterator itr = __effectCache.find(_id);
+        if (itr != __effectCache.end() && itr->second == this)
+        {
+            __effectCache.erase(itr);
+        }
+    }
+
+    if (!_vshSource.empty())
+    {
+        releaseMemory((unsigned int)(_defines.size() + _vshSource.size() + _fshSource.size()));
+    }
 
     // Free uniforms.
     for (std::map<std::string, Uniform*>::iterator itr = _uniforms.begin(); itr != _uniforms.end(); ++itr)
@@ -32,21 +104,19 @@ Effect::~Effect()
         // If our program object is currently bound, unbind it before we're destroyed.
         if (__currentEffect == this)
         {
-            GL_ASSERT( glUseProgram(0) );
             __currentEffect = NULL;
         }
 
-        GL_ASSERT( glDeleteProgram(_program) );
+        GLStateCache::deleteProgram(_program);
         _program = 0;
     }
 }
 
-Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const char* defines)
+/**
+ * Returns the id of an effect loaded from files, which is its key in the effect cache.
+ */
+static std::string getEffectId(const char* vshPath, const char* fshPath, const char* defines)
 {
-    GP_ASSERT(vshPath);
-    GP_ASSERT(fshPath);
-
-    // Search the effect cache for an identical effect that is already loaded.
     std::string uniqueId = vshPath;
     uniqueId += ';';
     uniqueId += fshPath;
@@ -55,34 +125,46 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
     {
         uniqueId += defines;
     }
-    std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(uniqueId);
-    if (itr != __effectCache.end())
+    return uniqueId;
+}
+
+static bool getExpandedSource(const char* path, std::string* out);
+
+Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    // Search the effect cache for an identical effect that is already loaded.
+    std::string uniqueId = getEffectId(vshPath, fshPath, defines);
     {
-        // Found an exiting effect with this id, so increase its ref count and return it.
-        GP_ASSERT(itr->second);
-        itr->second->addRef();
-        return itr->second;
+        Mutex::Lock lock(__effectCacheMutex);
+        std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(uniqueId);
+        if (itr != __effectCache.end())
+        {
+            // Found an exiting effect with this id, so increase its ref count and return it,
+            // unless another thread released it and is destroying it.
+            GP_ASSERT(itr->second);
+            if (itr->second->tryAddRef())
+                return itr->second;
+        }
     }
 
-    // Read source from file.
-    char* vshSource = FileSystem::readAll(vshPath);
-    if (vshSource == NULL)
+    // Read the sources from the files, unless another permutation of them was loaded.
+    std::string vshSource;
+    if (!getExpandedSource(vshPath, &vshSource))
     {
         GP_ERROR("Failed to read vertex shader from file '%s'.", vshPath);
         return NULL;
     }
-    char* fshSource = FileSystem::readAll(fshPath);
-    if (fshSource == NULL)
+    std::string fshSource;
+    if (!getExpandedSource(fshPath, &fshSource))
     {
         GP_ERROR("Failed to read fragment shader from file '%s'.", fshPath);
-        SAFE_DELETE_ARRAY(vshSource);
         return NULL;
     }
 
-    Effect* effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
-    
-    SAFE_DELETE_ARRAY(vshSource);
-    SAFE_DELETE_ARRAY(fshSource);
+    Effect* effect = createFromSource(vshPath, vshSource.c_str(), fshPath, fshSource.c_str(), defines);
 
     if (effect == NULL)
     {
@@ -92,6 +174,7 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
     {
         // Store this effect in the cache.
         effect->_id = uniqueId;
+        Mutex::Lock lock(__effectCacheMutex);
         __effectCache[uniqueId] = effect;
     }
 
@@ -103,41 +186,68 @@ Effect* Effect::createFromSource(const char* vshSource, const char* fshSource, c
     return createFromSource(NULL, vshSource, NULL, fshSource, defines);
 }
 
-static void replaceDefines(const char* defines, std::string& out)
+const char* Effect::getProgramCachePath()
 {
-    Properties* graphicsConfig = Game::getInstance()->getConfig()->getNamespace("graphics", true);
-    const char* globalDefines = graphicsConfig ? graphicsConfig->getString("shaderDefines") : NULL;
+    return __programCachePath.empty() ? NULL : __programCachePath.c_str();
+}
 
-    // Build full semicolon delimited list of defines
-#ifdef OPENGL_ES
-    out = OPENGL_ES_DEFINE;
-#else
-    out = "";
-#endif
-    if (globalDefines && strlen(globalDefines) > 0)
-    {
-        if (out.length() > 0)
-            out += ';';
-        out += globalDefines;
-    }
-    if (defines && strlen(defines) > 0)
+void Effect::setProgramCachePath(const char* path)
+{
+    __programCachePath = path ? path : "";
+}
+
+void Effect::clearSourceCache()
+{
+    Mutex::Lock lock(__expandedSourcesMutex);
+    std::map<std::string, std::string>().swap(__expandedSources);
+    __globalDefines.clear();
+    __globalDefinesLoaded = false;
+}
+
+/**
+ * Appends a #define line for each definition of a semicolon delimited list.
+ */
+static void appendDefines(const char* defines, std::string& out)
+{
+    if (defines == NULL || *defines == '\0')
+        return;
+
+    out += "#define ";
+    for (const char* c = defines; *c; ++c)
     {
-        if (out.length() > 0)
-            out += ';';
-        out += defines;
+        if (*c == ';')
+            out += "\n#define ";
+        else
+            out += *c;
     }
+    out += '\n';
+}
 
-    // Replace semicolons
-    if (out.length() > 0)
+static void replaceDefines(const char* defines, std::string& out)
+{
+    // The definitions shared by every effect only depend on the platform and the config, so they are built once.
     {
-        size_t pos;
-        out.insert(0, "#define ");
-        while ((pos = out.find(';')) != std::string::npos)
+        Mutex::Lock lock(__expandedSourcesMutex);
+        if (!__globalDefinesLoaded)
         {
-            out.replace(pos, 1, "\n#define ");
+            Properties* graphicsConfig = Game::getInstance()->getConfig()->getNamespace("graphics", true);
+#ifdef USE_UNIFORM_BUFFER
+            // Shaders can declare the FrameUniforms block to read the camera from the shared buffer.
+            if (RenderState::isFrameUniformBufferSupported())
+            {
+                __globalDefines = "#extension GL_ARB_uniform_buffer_object : enable\n#define FRAME_UNIFORMS\n";
+            }
+#endif
+#ifdef OPENGL_ES
+            appendDefines(OPENGL_ES_DEFINE, __globalDefines);
+#endif
+            appendDefines(graphicsConfig ? graphicsConfig->getString("shaderDefines") : NULL, __globalDefines);
+            __globalDefinesLoaded = true;
         }
-        out += "\n";
+        out = __globalDefines;
     }
+
+    appendDefines(defines, out);
 }
 
 static void replaceIncludes(const char* filepath, const char* source, std::string& out)
@@ -226,180 +336,433 @@ static void writeShaderToErrorFile(const char* filePath, const char* source)
     }
 }
 
-Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
-{
-    GP_ASSERT(vshSource);
-    GP_ASSERT(fshSource);
+#ifdef USE_PROGRAM_BINARY
 
-    const unsigned int SHADER_SOURCE_LENGTH = 3;
-    const GLchar* shaderSource[SHADER_SOURCE_LENGTH];
-    char* infoLog = NULL;
-    GLuint vertexShader;
-    GLuint fragmentShader;
-    GLuint program;
-    GLint length;
-    GLint success;
+// Identifies a program binary file.
+static const char PROGRAM_BINARY_IDENTIFIER[] = { 'G', 'P', 'P', 'B' };
 
-    // Replace all comma separated definitions with #define prefix and \n suffix
-    std::string definesStr = "";
-    replaceDefines(defines, definesStr);
-    
-    shaderSource[0] = definesStr.c_str();
-    shaderSource[1] = "\n";
-    std::string vshSourceStr = "";
-    if (vshPath)
-    {
-        // Replace the #include "xxxxx.xxx" with the sources that come from file paths
-        replaceIncludes(vshPath, vshSource, vshSourceStr);
-        if (vshSource && strlen(vshSource) != 0)
-            vshSourceStr += "\n";
-    }
-    shaderSource[2] = vshPath ? vshSourceStr.c_str() :  vshSource;
-    GL_ASSERT( vertexShader = glCreateShader(GL_VERTEX_SHADER) );
-    GL_ASSERT( glShaderSource(vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
-    GL_ASSERT( glCompileShader(vertexShader) );
-    GL_ASSERT( glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success) );
-    if (success != GL_TRUE)
+/**
+ * Returns the FNV-1a hash of a string, continuing from the specified hash.
+ */
+static unsigned int hashString(const char* str, unsigned int hash)
+{
+    if (str)
     {
-        GL_ASSERT( glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &length) );
-        if (length == 0)
-        {
-            length = 4096;
-        }
-        if (length > 0)
+        for (; *str; ++str)
         {
-            infoLog = new char[length];
-            GL_ASSERT( glGetShaderInfoLog(vertexShader, length, NULL, infoLog) );
-            infoLog[length-1] = '\0';
+            hash ^= (unsigned char)*str;
+            hash *= 16777619u;
         }
+    }
+    // Separate consecutive strings.
+    hash ^= 0xFFu;
+    hash *= 16777619u;
+    return hash;
+}
 
-        // Write out the expanded shader file.
-        if (vshPath)
-            writeShaderToErrorFile(vshPath, shaderSource[2]);
+/**
+ * Returns the hash of everything a linked program depends on: the expanded shader
+ * sources and the driver that linked it.
+ */
+static unsigned int hashProgram(const char* defines, const char* vshSource, const char* fshSource, unsigned int hash)
+{
+    hash = hashString(defines, hash);
+    hash = hashString(vshSource, hash);
+    hash = hashString(fshSource, hash);
+    hash = hashString((const char*)glGetString(GL_VENDOR), hash);
+    hash = hashString((const char*)glGetString(GL_RENDERER), hash);
+    hash = hashString((const char*)glGetString(GL_VERSION), hash);
+    return hash;
+}
 
-        GP_ERROR("Compile failed for vertex shader '%s' with error '%s'.", vshPath == NULL ? vshSource : vshPath, infoLog == NULL ? "" : infoLog);
-        SAFE_DELETE_ARRAY(infoLog);
+/**
+ * Returns the path of the cached binary of a program, and a second hash of the program
+ * that is stored in the file to tell apart programs whose file names collide.
+ */
+static std::string getProgramCacheFile(const char* defines, const char* vshSource, const char* fshSource, unsigned int* checkHash)
+{
+    char name[16];
+    sprintf(name, "%08x.bin", hashProgram(defines, vshSource, fshSource, 2166136261u));
+    *checkHash = hashProgram(defines, vshSource, fshSource, 0x5BD1E995u);
+    return __programCachePath + "/" + name;
+}
 
-        // Clean up.
-        GL_ASSERT( glDeleteShader(vertexShader) );
+/**
+ * Loads a cached program binary.
+ *
+ * @return The program, or 0 if there is no usable binary for the program.
+ */
+static GLuint loadProgramBinary(const char* path, unsigned int checkHash)
+{
+    if (!FileSystem::fileExists(path))
+        return 0;
+
+    int size = 0;
+    char* data = FileSystem::readAll(path, &size);
+    if (data == NULL)
+        return 0;
+
+    // Header: identifier, check hash, binary format and binary length.
+    GLuint program = 0;
+    const int headerSize = sizeof(PROGRAM_BINARY_IDENTIFIER) + sizeof(unsigned int) * 3;
+    unsigned int header[3];
+    if (size >= headerSize && memcmp(data, PROGRAM_BINARY_IDENTIFIER, sizeof(PROGRAM_BINARY_IDENTIFIER)) == 0)
+    {
+        memcpy(header, data + sizeof(PROGRAM_BINARY_IDENTIFIER), sizeof(header));
+        if (header[0] == checkHash && header[2] == (unsigned int)(size - headerSize))
+        {
+            // Drivers reject binaries from other driver versions with an error or a failed
+            // link status, which is not a failure here; the program is compiled instead.
+            GL_ASSERT( program = glCreateProgram() );
+            glProgramBinary(program, (GLenum)header[1], data + headerSize, (GLsizei)header[2]);
+            GLint success = GL_FALSE;
+            if (glGetError() == GL_NO_ERROR)
+            {
+                GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
+            }
+            if (success != GL_TRUE)
+            {
+                GL_ASSERT( glDeleteProgram(program) );
+                program = 0;
+            }
+        }
+    }
+    SAFE_DELETE_ARRAY(data);
+    return program;
+}
 
-        return NULL;
+/**
+ * Writes the binary of a linked program to the program cache.
+ */
+static void saveProgramBinary(GLuint program, const char* path, unsigned int checkHash)
+{
+    GLint length = 0;
+    GL_ASSERT( glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length) );
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GL_ASSERT( glGetProgramBinary(program, length, &written, &format, &binary[0]) );
+    if (written <= 0)
+        return;
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+    unsigned int header[3] = { checkHash, (unsigned int)format, (unsigned int)written };
+    if (stream.get() == NULL ||
+        stream->write(PROGRAM_BINARY_IDENTIFIER, 1, sizeof(PROGRAM_BINARY_IDENTIFIER)) != sizeof(PROGRAM_BINARY_IDENTIFIER) ||
+        stream->write(header, sizeof(unsigned int), 3) != 3 ||
+        stream->write(&binary[0], 1, written) != (size_t)written)
+    {
+        GP_WARN("Failed to write program binary '%s'.", path);
     }
+}
 
-    // Compile the fragment shader.
-    std::string fshSourceStr;
-    if (fshPath)
-    {
-        // Replace the #include "xxxxx.xxx" with the sources that come from file paths
-        replaceIncludes(fshPath, fshSource, fshSourceStr);
-        if (fshSource && strlen(fshSource) != 0)
-            fshSourceStr += "\n";
-    }
-    shaderSource[2] = fshPath ? fshSourceStr.c_str() : fshSource;
-    GL_ASSERT( fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
-    GL_ASSERT( glShaderSource(fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
-    GL_ASSERT( glCompileShader(fragmentShader) );
-    GL_ASSERT( glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success) );
-    if (success != GL_TRUE)
+#endif
+
+/**
+ * Returns the info log of a shader or program, which the caller must delete.
+ */
+static char* getInfoLog(GLuint object, bool program)
+{
+    GLint length;
+    if (program)
+    {
+        GL_ASSERT( glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length) );
+    }
+    else
+    {
+        GL_ASSERT( glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length) );
+    }
+    if (length == 0)
+    {
+        length = 4096;
+    }
+    char* infoLog = NULL;
+    if (length > 0)
     {
-        GL_ASSERT( glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &length) );
-        if (length == 0)
+        infoLog = new char[length];
+        if (program)
         {
-            length = 4096;
+            GL_ASSERT( glGetProgramInfoLog(object, length, NULL, infoLog) );
         }
-        if (length > 0)
+        else
         {
-            infoLog = new char[length];
-            GL_ASSERT( glGetShaderInfoLog(fragmentShader, length, NULL, infoLog) );
-            infoLog[length-1] = '\0';
+            GL_ASSERT( glGetShaderInfoLog(object, length, NULL, infoLog) );
         }
-        
-        // Write out the expanded shader file.
-        if (fshPath)
-            writeShaderToErrorFile(fshPath, shaderSource[2]);
-
-        GP_ERROR("Compile failed for fragment shader (%s): %s", fshPath == NULL ? fshSource : fshPath, infoLog == NULL ? "" : infoLog);
-        SAFE_DELETE_ARRAY(infoLog);
+        infoLog[length-1] = '\0';
+    }
+    return infoLog;
+}
 
-        // Clean up.
-        GL_ASSERT( glDeleteShader(vertexShader) );
-        GL_ASSERT( glDeleteShader(fragmentShader) );
+#ifdef USE_TRANSFORM_FEEDBACK
+/**
+ * Names the vertex shader outputs captured by transform feedback, which must be done before linking.
+ *
+ * Effects list the outputs in the TRANSFORM_FEEDBACK_VARYINGS define, separated by spaces, so that
+ * they are captured again whenever the program is linked (such as when the context is restored).
+ */
+static void setTransformFeedbackVaryings(GLuint program, const char* definesStr)
+{
+    static const char* VARYINGS_DEFINE = "#define TRANSFORM_FEEDBACK_VARYINGS ";
+    const char* varyings = strstr(definesStr, VARYINGS_DEFINE);
+    if (varyings == NULL || !GLEW_VERSION_3_0)
+        return;
+    varyings += strlen(VARYINGS_DEFINE);
+
+    std::vector<std::string> names;
+    const char* end = varyings;
+    while (*end && *end != '\n')
+        ++end;
+    std::string line(varyings, end);
+    size_t start = 0;
+    while (start < line.size())
+    {
+        size_t space = line.find(' ', start);
+        if (space == std::string::npos)
+            space = line.size();
+        if (space > start)
+            names.push_back(line.substr(start, space - start));
+        start = space + 1;
+    }
+    if (names.empty())
+        return;
 
-        return NULL;
+    std::vector<const GLchar*> pointers(names.size());
+    for (size_t i = 0, count = names.size(); i < count; ++i)
+    {
+        pointers[i] = names[i].c_str();
     }
+    GL_ASSERT( glTransformFeedbackVaryings(program, (GLsizei)pointers.size(), &pointers[0], GL_INTERLEAVED_ATTRIBS) );
+}
+#endif
+
+/**
+ * Compiles the expanded shader sources and starts linking them into a program.
+ *
+ * With KHR_parallel_shader_compile, the driver compiles and links in the background and
+ * finishProgram() only blocks if the program is not ready yet.
+ *
+ * @return The program being linked.
+ */
+static GLuint startProgram(const char* definesStr, const char* vshFinal, const char* fshFinal, bool retrievable,
+                           GLuint* vertexShader, GLuint* fragmentShader)
+{
+    const unsigned int SHADER_SOURCE_LENGTH = 3;
+    const GLchar* shaderSource[SHADER_SOURCE_LENGTH];
+    GLuint program;
+
+    shaderSource[0] = definesStr;
+    shaderSource[1] = "\n";
+    shaderSource[2] = vshFinal;
+    GL_ASSERT( *vertexShader = glCreateShader(GL_VERTEX_SHADER) );
+    GL_ASSERT( glShaderSource(*vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
+    GL_ASSERT( glCompileShader(*vertexShader) );
+
+    // Compile the fragment shader.
+    shaderSource[2] = fshFinal;
+    GL_ASSERT( *fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
+    GL_ASSERT( glShaderSource(*fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
+    GL_ASSERT( glCompileShader(*fragmentShader) );
 
     // Link program.
     GL_ASSERT( program = glCreateProgram() );
-    GL_ASSERT( glAttachShader(program, vertexShader) );
-    GL_ASSERT( glAttachShader(program, fragmentShader) );
+    GL_ASSERT( glAttachShader(program, *vertexShader) );
+    GL_ASSERT( glAttachShader(program, *fragmentShader) );
+#if defined(USE_PROGRAM_BINARY) && !defined(OPENGL_ES)
+    if (retrievable && glProgramParameteri)
+    {
+        GL_ASSERT( glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE) );
+    }
+#endif
+#ifdef USE_TRANSFORM_FEEDBACK
+    setTransformFeedbackVaryings(program, definesStr);
+#endif
     GL_ASSERT( glLinkProgram(program) );
-    GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
 
-    // Delete shaders after linking.
-    GL_ASSERT( glDeleteShader(vertexShader) );
-    GL_ASSERT( glDeleteShader(fragmentShader) );
+    return program;
+}
 
-    // Check link status.
+/**
+ * Checks the results of compiling and linking a program started by startProgram().
+ *
+ * Errors are logged, and the expanded source of a shader that failed to compile is
+ * written next to its file.
+ *
+ * @return The linked program, or 0 if compiling or linking failed.
+ */
+static GLuint finishProgram(GLuint program, GLuint vertexShader, GLuint fragmentShader, const char* vshPath, const char* vshSource,
+                            const char* fshPath, const char* fshSource, const char* vshFinal, const char* fshFinal)
+{
+    char* infoLog = NULL;
+    GLint success;
+
+    GL_ASSERT( glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success) );
     if (success != GL_TRUE)
     {
-        GL_ASSERT( glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length) );
-        if (length == 0)
+        infoLog = getInfoLog(vertexShader, false);
+
+        // Write out the expanded shader file.
+        if (vshPath)
+            writeShaderToErrorFile(vshPath, vshFinal);
+
+        GP_ERROR("Compile failed for vertex shader '%s' with error '%s'.", vshPath == NULL ? vshSource : vshPath, infoLog == NULL ? "" : infoLog);
+        SAFE_DELETE_ARRAY(infoLog);
+    }
+    else
+    {
+        GL_ASSERT( glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success) );
+        if (success != GL_TRUE)
         {
-            length = 4096;
+            infoLog = getInfoLog(fragmentShader, false);
+
+            // Write out the expanded shader file.
+            if (fshPath)
+                writeShaderToErrorFile(fshPath, fshFinal);
+
+            GP_ERROR("Compile failed for fragment shader (%s): %s", fshPath == NULL ? fshSource : fshPath, infoLog == NULL ? "" : infoLog);
+            SAFE_DELETE_ARRAY(infoLog);
         }
-        if (length > 0)
+        else
         {
-            infoLog = new char[length];
-            GL_ASSERT( glGetProgramInfoLog(program, length, NULL, infoLog) );
-            infoLog[length-1] = '\0';
+            // Check link status.
+            GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
+            if (success != GL_TRUE)
+            {
+                infoLog = getInfoLog(program, true);
+                GP_ERROR("Linking program failed (%s,%s): %s", vshPath == NULL ? "NULL" : vshPath, fshPath == NULL ? "NULL" : fshPath, infoLog == NULL ? "" : infoLog);
+                SAFE_DELETE_ARRAY(infoLog);
+            }
         }
-        GP_ERROR("Linking program failed (%s,%s): %s", vshPath == NULL ? "NULL" : vshPath, fshPath == NULL ? "NULL" : fshPath, infoLog == NULL ? "" : infoLog);
-        SAFE_DELETE_ARRAY(infoLog);
+    }
 
+    // Delete shaders after linking.
+    GL_ASSERT( glDeleteShader(vertexShader) );
+    GL_ASSERT( glDeleteShader(fragmentShader) );
+
+    if (success != GL_TRUE)
+    {
         // Clean up.
         GL_ASSERT( glDeleteProgram(program) );
-
-        return NULL;
+        return 0;
     }
 
-    // Create and return the new Effect.
-    Effect* effect = new Effect();
-    effect->_program = program;
+    return program;
+}
 
-    // Query and store vertex attribute meta-data from the program.
-    // NOTE: Rather than using glBindAttribLocation to explicitly specify our own
-    // preferred attribute locations, we're going to query the locations that were
-    // automatically bound by the GPU. While it can sometimes be convenient to use
-    // glBindAttribLocation, some vendors actually reserve certain attribute indices
-    // and therefore using this function can create compatibility issues between
-    // different hardware vendors.
-    GLint activeAttributes;
-    GL_ASSERT( glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &activeAttributes) );
-    if (activeAttributes > 0)
+/**
+ * Links a program from the expanded shader sources, or loads the binary cached by an earlier run.
+ *
+ * @return The linked program, or 0 if compiling or linking failed.
+ */
+static GLuint createProgram(const char* definesStr, const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource,
+                            const char* vshFinal, const char* fshFinal)
+{
+    GLuint program = 0;
+    bool retrievable = false;
+#ifdef USE_PROGRAM_BINARY
+    // Load the program linked by an earlier run, if the driver still accepts it.
+    std::string cacheFile;
+    unsigned int checkHash = 0;
+    if (!__programCachePath.empty() && glGetProgramBinary && glProgramBinary)
     {
-        GL_ASSERT( glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &length) );
-        if (length > 0)
+        retrievable = true;
+        cacheFile = getProgramCacheFile(definesStr, vshFinal, fshFinal, &checkHash);
+        program = loadProgramBinary(cacheFile.c_str(), checkHash);
+    }
+#endif
+
+    if (program == 0)
+    {
+        GLuint vertexShader, fragmentShader;
+        program = startProgram(definesStr, vshFinal, fshFinal, retrievable, &vertexShader, &fragmentShader);
+        program = finishProgram(program, vertexShader, fragmentShader, vshPath, vshSource, fshPath, fshSource, vshFinal, fshFinal);
+        if (program == 0)
+            return 0;
+
+#ifdef USE_PROGRAM_BINARY
+        if (!cacheFile.empty())
         {
-            GLchar* attribName = new GLchar[length + 1];
-            GLint attribSize;
-            GLenum attribType;
-            GLint attribLocation;
-            for (int i = 0; i < activeAttributes; ++i)
-            {
-                // Query attribute info.
-                GL_ASSERT( glGetActiveAttrib(program, i, length, NULL, &attribSize, &attribType, attribName) );
-                attribName[length] = '\0';
+            saveProgramBinary(program, cacheFile.c_str(), checkHash);
+        }
+#endif
+    }
 
-                // Query the pre-assigned attribute location.
-                GL_ASSERT( attribLocation = glGetAttribLocation(program, attribName) );
+    return program;
+}
 
-                // Assign the vertex attribute mapping for the effect.
-                effect->_vertexAttributes[attribName] = attribLocation;
-            }
-            SAFE_DELETE_ARRAY(attribName);
+/**
+ * Expands the #include directives of a shader loaded from a file.
+ */
+static void expandSource(const char* path, const char* source, std::string* out)
+{
+    // Replace the #include "xxxxx.xxx" with the sources that come from file paths
+    replaceIncludes(path, source, *out);
+    if (source && strlen(source) != 0)
+        *out += "\n";
+}
+
+/**
+ * Returns the source of a shader file with its #include directives expanded.
+ *
+ * Each file is read and expanded once, and kept for the other permutations loaded from it.
+ *
+ * @return false if the file could not be read.
+ */
+static bool getExpandedSource(const char* path, std::string* out)
+{
+    {
+        Mutex::Lock lock(__expandedSourcesMutex);
+        std::map<std::string, std::string>::const_iterator itr = __expandedSources.find(path);
+        if (itr != __expandedSources.end())
+        {
+            *out = itr->second;
+            return true;
         }
     }
 
+    char* source = FileSystem::readAll(path);
+    if (source == NULL)
+        return false;
+    out->clear();
+    expandSource(path, source, out);
+    SAFE_DELETE_ARRAY(source);
+
+    Mutex::Lock lock(__expandedSourcesMutex);
+    __expandedSources[path] = *out;
+    return true;
+}
+
+Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
+{
+    GP_ASSERT(vshSource);
+    GP_ASSERT(fshSource);
+
+    // Replace all comma separated definitions with #define prefix and \n suffix
+    std::string definesStr = "";
+    replaceDefines(defines, definesStr);
+
+    GLuint program = createProgram(definesStr.c_str(), vshPath, vshSource, fshPath, fshSource, vshSource, fshSource);
+    if (program == 0)
+        return NULL;
+
+    Effect* effect = createFromProgram(program);
+    effect->retainSources(definesStr.c_str(), vshSource, fshSource);
+    return effect;
+}
+
+Effect* Effect::createFromProgram(GLuint program)
+{
+    GP_ASSERT(program);
+
+    // Create and return the new Effect.
+    GLint length;
+    Effect* effect = new Effect();
+    effect->_program = program;
+    effect->queryVertexAttributes();
+    effect->bindFrameUniformBlock();
+
     // Query and store uniforms from the program.
     GLint activeUniforms;
     GL_ASSERT( glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms) );
@@ -434,12 +797,18 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
                 // Query the pre-assigned uniform location.
                 GL_ASSERT( uniformLocation = glGetUniformLocation(program, uniformName) );
 
+                // Members of the frame uniform block have no location and are set through its buffer.
+                if (uniformLocation == -1 && effect->_frameUniforms)
+                {
+                    continue;
+                }
+
                 Uniform* uniform = new Uniform();
                 uniform->_effect = effect;
                 uniform->_name = uniformName;
                 uniform->_location = uniformLocation;
                 uniform->_type = uniformType;
-                if (uniformType == GL_SAMPLER_2D)
+                if (uniformType == GL_SAMPLER_2D || uniformType == GL_SAMPLER_CUBE)
                 {
                     uniform->_index = samplerIndex;
                     samplerIndex += uniformSize;
@@ -458,6 +827,346 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
     return effect;
 }
 
+void Effect::queryVertexAttributes()
+{
+    // Query and store vertex attribute meta-data from the program.
+    // NOTE: Rather than using glBindAttribLocation to explicitly specify our own
+    // preferred attribute locations, we're going to query the locations that were
+    // automatically bound by the GPU. While it can sometimes be convenient to use
+    // glBindAttribLocation, some vendors actually reserve certain attribute indices
+    // and therefore using this function can create compatibility issues between
+    // different hardware vendors.
+    _vertexAttributes.clear();
+    GLint activeAttributes;
+    GLint length;
+    GL_ASSERT( glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTES, &activeAttributes) );
+    if (activeAttributes > 0)
+    {
+        GL_ASSERT( glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &length) );
+        if (length > 0)
+        {
+            GLchar* attribName = new GLchar[length + 1];
+            GLint attribSize;
+            GLenum attribType;
+            GLint attribLocation;
+            for (int i = 0; i < activeAttributes; ++i)
+            {
+                // Query attribute info.
+                GL_ASSERT( glGetActiveAttrib(_program, i, length, NULL, &attribSize, &attribType, attribName) );
+                attribName[length] = '\0';
+
+                // Query the pre-assigned attribute location.
+                GL_ASSERT( attribLocation = glGetAttribLocation(_program, attribName) );
+
+                // Assign the vertex attribute mapping for the effect.
+                _vertexAttributes[attribName] = attribLocation;
+            }
+            SAFE_DELETE_ARRAY(attribName);
+        }
+    }
+    _instanceMatrixAttribute = getVertexAttribute(VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME);
+}
+
+void Effect::bindFrameUniformBlock()
+{
+#ifdef USE_UNIFORM_BUFFER
+    // Bind the frame uniform block to the binding point of the shared buffer.
+    if (RenderState::isFrameUniformBufferSupported())
+    {
+        GLuint blockIndex;
+        GL_ASSERT( blockIndex = glGetUniformBlockIndex(_program, "FrameUniforms") );
+        if (blockIndex != GL_INVALID_INDEX)
+        {
+            GL_ASSERT( glUniformBlockBinding(_program, blockIndex, FRAME_UNIFORMS_BINDING) );
+            _frameUniforms = true;
+        }
+    }
+#endif
+}
+
+void Effect::retainSources(const char* defines, const char* vshSource, const char* fshSource)
+{
+    GP_ASSERT(defines);
+    GP_ASSERT(vshSource);
+    GP_ASSERT(fshSource);
+
+    // The expanded sources are kept, so restoring needs no files.
+    if (retainMemory((unsigned int)(strlen(defines) + strlen(vshSource) + strlen(fshSource))))
+    {
+        _defines = defines;
+        _vshSource = vshSource;
+        _fshSource = fshSource;
+    }
+}
+
+void Effect::discardGraphics()
+{
+    if (__currentEffect == this)
+    {
+        __currentEffect = NULL;
+    }
+    _program = 0;
+}
+
+void Effect::restoreGraphics()
+{
+    if (_vshSource.empty())
+    {
+        GP_WARN("Cannot restore effect '%s', whose shader sources were not retained.", _id.c_str());
+        return;
+    }
+
+    // The program binary cache usually holds the program, so it needs no compiling.
+    _program = createProgram(_defines.c_str(), NULL, _vshSource.c_str(), NULL, _fshSource.c_str(), _vshSource.c_str(), _fshSource.c_str());
+    if (_program == 0)
+    {
+        GP_WARN("Failed to restore effect '%s'; the materials using it will not be drawn.", _id.c_str());
+        return;
+    }
+    queryVertexAttributes();
+    bindFrameUniformBlock();
+
+    // Keep the uniforms that materials refer to, at their locations in the new program,
+    // whose values are all uploaded again.
+    for (std::map<std::string, Uniform*>::iterator itr = _uniforms.begin(); itr != _uniforms.end(); ++itr)
+    {
+        Uniform* uniform = itr->second;
+        GL_ASSERT( uniform->_location = glGetUniformLocation(_program, uniform->_name.c_str()) );
+        SAFE_DELETE_ARRAY(uniform->_cache);
+        uniform->_cacheSize = 0;
+    }
+}
+
+bool Effect::warmUp(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    // Skip permutations that are already loaded or queued.
+    std::string uniqueId = getEffectId(vshPath, fshPath, defines);
+    {
+        Mutex::Lock lock(__effectCacheMutex);
+        if (__effectCache.find(uniqueId) != __effectCache.end())
+            return true;
+    }
+    for (size_t i = 0, count = _warmUps.size(); i < count; ++i)
+    {
+        if (_warmUps[i]->id == uniqueId)
+            return true;
+    }
+
+    WarmUp* warmUp = new WarmUp();
+    if (!getExpandedSource(vshPath, &warmUp->vshSource))
+    {
+        GP_ERROR("Failed to read vertex shader from file '%s'.", vshPath);
+        SAFE_DELETE(warmUp);
+        return false;
+    }
+    if (!getExpandedSource(fshPath, &warmUp->fshSource))
+    {
+        GP_ERROR("Failed to read fragment shader from file '%s'.", fshPath);
+        SAFE_DELETE(warmUp);
+        return false;
+    }
+    warmUp->id = uniqueId;
+    warmUp->vshPath = vshPath;
+    warmUp->fshPath = fshPath;
+    replaceDefines(defines, warmUp->defines);
+    warmUp->program = 0;
+    warmUp->vertexShader = 0;
+    warmUp->fragmentShader = 0;
+    warmUp->linked = false;
+    warmUp->retrievable = false;
+    warmUp->checkHash = 0;
+
+#ifdef USE_PROGRAM_BINARY
+    // A cached binary needs no compiling.
+    if (!__programCachePath.empty() && glGetProgramBinary && glProgramBinary)
+    {
+        warmUp->retrievable = true;
+        warmUp->cacheFile = getProgramCacheFile(warmUp->defines.c_str(), warmUp->vshSource.c_str(), warmUp->fshSource.c_str(), &warmUp->checkHash);
+        warmUp->program = loadProgramBinary(warmUp->cacheFile.c_str(), warmUp->checkHash);
+        warmUp->linked = warmUp->program != 0;
+    }
+#endif
+
+    // With parallel compiling, the driver works on all queued programs in the background.
+    if (warmUp->program == 0 && isParallelCompileSupported())
+    {
+        warmUp->program = startProgram(warmUp->defines.c_str(), warmUp->vshSource.c_str(), warmUp->fshSource.c_str(),
+                                       warmUp->retrievable, &warmUp->vertexShader, &warmUp->fragmentShader);
+    }
+
+    _warmUps.push_back(warmUp);
+    ++__warmUpTotal;
+    return true;
+}
+
+unsigned int Effect::warmUpFromFile(const char* path)
+{
+    GP_ASSERT(path);
+
+    Properties* properties = Properties::create(path);
+    if (properties == NULL)
+    {
+        GP_ERROR("Failed to load effect warm-up manifest '%s'.", path);
+        return 0;
+    }
+    Properties* effects = (strlen(properties->getNamespace()) > 0) ? properties : properties->getNextNamespace();
+    if (effects == NULL || strcmp(effects->getNamespace(), "effects") != 0)
+    {
+        GP_ERROR("Effect warm-up manifest '%s' must have the namespace 'effects'.", path);
+        SAFE_DELETE(properties);
+        return 0;
+    }
+
+    unsigned int count = 0;
+    Properties* effect;
+    while ((effect = effects->getNextNamespace()) != NULL)
+    {
+        if (strcmp(effect->getNamespace(), "effect") != 0)
+        {
+            GP_WARN("Ignoring namespace '%s' in effect warm-up manifest '%s'.", effect->getNamespace(), path);
+            continue;
+        }
+        const char* vshPath = effect->getString("vertexShader");
+        const char* fshPath = effect->getString("fragmentShader");
+        if (vshPath == NULL || fshPath == NULL)
+        {
+            GP_ERROR("Effect in warm-up manifest '%s' is missing a 'vertexShader' or 'fragmentShader' property.", path);
+            continue;
+        }
+        if (warmUp(vshPath, fshPath, effect->getString("defines")))
+            ++count;
+    }
+
+    SAFE_DELETE(properties);
+    return count;
+}
+
+unsigned int Effect::getWarmUpCount()
+{
+    return (unsigned int)_warmUps.size();
+}
+
+float Effect::getWarmUpProgress()
+{
+    return __warmUpTotal == 0 ? 1.0f : (float)(__warmUpTotal - _warmUps.size()) / (float)__warmUpTotal;
+}
+
+void Effect::setWarmUpBudget(float milliseconds)
+{
+    __warmUpBudget = milliseconds;
+}
+
+void Effect::releaseWarmedEffects()
+{
+    for (size_t i = 0, count = __warmedEffects.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(__warmedEffects[i]);
+    }
+    __warmedEffects.clear();
+}
+
+void Effect::updateWarmUp()
+{
+    if (_warmUps.empty())
+        return;
+
+    double startTime = Game::getAbsoluteTime();
+    bool busy = false;
+    for (size_t i = 0; i < _warmUps.size();)
+    {
+        if (busy && Game::getAbsoluteTime() - startTime >= __warmUpBudget)
+            return;
+
+        // Leave programs that the driver is still compiling for a later frame.
+        WarmUp* warmUp = _warmUps[i];
+        if (warmUp->program && !warmUp->linked)
+        {
+            GLint completed = GL_TRUE;
+            GL_ASSERT( glGetProgramiv(warmUp->program, GL_COMPLETION_STATUS_KHR, &completed) );
+            if (completed != GL_TRUE)
+            {
+                ++i;
+                continue;
+            }
+        }
+
+        _warmUps.erase(_warmUps.begin() + i);
+        finishWarmUp(warmUp);
+        SAFE_DELETE(warmUp);
+        busy = true;
+    }
+
+    // Start counting again for the next batch of warm-ups.
+    __warmUpTotal = 0;
+}
+
+void Effect::finishWarmUp(WarmUp* warmUp)
+{
+    GP_ASSERT(warmUp);
+
+    const char* vshSource = warmUp->vshSource.c_str();
+    const char* fshSource = warmUp->fshSource.c_str();
+    GLuint program = warmUp->program;
+    if (!warmUp->linked)
+    {
+        if (program == 0)
+        {
+            program = startProgram(warmUp->defines.c_str(), vshSource, fshSource, warmUp->retrievable, &warmUp->vertexShader, &warmUp->fragmentShader);
+        }
+        program = finishProgram(program, warmUp->vertexShader, warmUp->fragmentShader, warmUp->vshPath.c_str(), vshSource,
+                                warmUp->fshPath.c_str(), fshSource, vshSource, fshSource);
+        if (program == 0)
+        {
+            GP_ERROR("Failed to create effect from shaders '%s', '%s'.", warmUp->vshPath.c_str(), warmUp->fshPath.c_str());
+            return;
+        }
+#ifdef USE_PROGRAM_BINARY
+        if (!warmUp->cacheFile.empty())
+        {
+            saveProgramBinary(program, warmUp->cacheFile.c_str(), warmUp->checkHash);
+        }
+#endif
+    }
+
+    // The effect may have been loaded while it was warming up.
+    Mutex::Lock lock(__effectCacheMutex);
+    if (__effectCache.find(warmUp->id) != __effectCache.end())
+    {
+        GL_ASSERT( glDeleteProgram(program) );
+        return;
+    }
+
+    Effect* effect = createFromProgram(program);
+    effect->retainSources(warmUp->defines.c_str(), vshSource, fshSource);
+    effect->_id = warmUp->id;
+    __effectCache[warmUp->id] = effect;
+    __warmedEffects.push_back(effect);
+}
+
+void Effect::cancelWarmUp()
+{
+    for (size_t i = 0, count = _warmUps.size(); i < count; ++i)
+    {
+        WarmUp* warmUp = _warmUps[i];
+        if (warmUp->vertexShader)
+        {
+            GL_ASSERT( glDeleteShader(warmUp->vertexShader) );
+            GL_ASSERT( glDeleteShader(warmUp->fragmentShader) );
+        }
+        if (warmUp->program)
+        {
+            GL_ASSERT( glDeleteProgram(warmUp->program) );
+        }
+        SAFE_DELETE(warmUp);
+    }
+    _warmUps.clear();
+    __warmUpTotal = 0;
+    releaseWarmedEffects();
+}
+
 const char* Effect::getId() const
 {
     return _id.c_str();
@@ -469,6 +1178,16 @@ VertexAttribute Effect::getVertexAttribute(const char* name) const
     return (itr == _vertexAttributes.end() ? -1 : itr->second);
 }
 
+VertexAttribute Effect::getInstanceMatrixAttribute() const
+{
+    return _instanceMatrixAttribute;
+}
+
+bool Effect::hasFrameUniforms() const
+{
+    return _frameUniforms;
+}
+
 Uniform* Effect::getUniform(const char* name) const
 {
     std::map<std::string, Uniform*>::const_iterator itr = _uniforms.find(name);
@@ -498,6 +1217,12 @@ Uniform* Effect::getUniform(const char* name) const
 				uniform->_type = puniform->getType();
 				_uniforms[name] = uniform;
 
+				// Element uniforms alias their parent array, so neither can cache values.
+				uniform->_cacheValues = false;
+				puniform->_cacheValues = false;
+				SAFE_DELETE_ARRAY(puniform->_cache);
+				puniform->_cacheSize = 0;
+
 				delete parentname;
 				return uniform;
 			}
@@ -530,106 +1255,171 @@ unsigned int Effect::getUniformCount() const
 void Effect::setValue(Uniform* uniform, float value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1f(uniform->_location, value) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_FLOAT, &value, 1);
+    else if (uniform->updateCache(&value, sizeof(float)))
+        GL_ASSERT( glUniform1f(uniform->_location, value) );
 }
 
 void Effect::setValue(Uniform* uniform, const float* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1fv(uniform->_location, count, values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_FLOAT, values, count);
+    else if (uniform->updateCache(values, sizeof(float) * count))
+        GL_ASSERT( glUniform1fv(uniform->_location, count, values) );
 }
 
 void Effect::setValue(Uniform* uniform, int value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1i(uniform->_location, value) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_INT, &value, 1);
+    else if (uniform->updateCache(&value, sizeof(int)))
+        GL_ASSERT( glUniform1i(uniform->_location, value) );
 }
 
 void Effect::setValue(Uniform* uniform, const int* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1iv(uniform->_location, count, values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_INT, values, count);
+    else if (uniform->updateCache(values, sizeof(int) * count))
+        GL_ASSERT( glUniform1iv(uniform->_location, count, values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, value.m) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_MATRIX, &value, 1);
+    else if (uniform->updateCache(value.m, sizeof(float) * 16))
+        GL_ASSERT( glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, value.m) );
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, count, GL_FALSE, (GLfloat*)values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_MATRIX, values, count);
+    else if (uniform->updateCache(values, sizeof(Matrix) * count))
+        GL_ASSERT( glUniformMatrix4fv(uniform->_location, count, GL_FALSE, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform2f(uniform->_location, value.x, value.y) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR2, &value, 1);
+    else if (uniform->updateCache(&value, sizeof(Vector2)))
+        GL_ASSERT( glUniform2f(uniform->_location, value.x, value.y) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform2fv(uniform->_location, count, (GLfloat*)values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR2, values, count);
+    else if (uniform->updateCache(values, sizeof(Vector2) * count))
+        GL_ASSERT( glUniform2fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform3f(uniform->_location, value.x, value.y, value.z) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR3, &value, 1);
+    else if (uniform->updateCache(&value, sizeof(Vector3)))
+        GL_ASSERT( glUniform3f(uniform->_location, value.x, value.y, value.z) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform3fv(uniform->_location, count, (GLfloat*)values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR3, values, count);
+    else if (uniform->updateCache(values, sizeof(Vector3) * count))
+        GL_ASSERT( glUniform3fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform4f(uniform->_location, value.x, value.y, value.z, value.w) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR4, &value, 1);
+    else if (uniform->updateCache(&value, sizeof(Vector4)))
+        GL_ASSERT( glUniform4f(uniform->_location, value.x, value.y, value.z, value.w) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform4fv(uniform->_location, count, (GLfloat*)values) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setUniform(uniform, CommandBuffer::UNIFORM_VECTOR4, values, count);
+    else if (uniform->updateCache(values, sizeof(Vector4) * count))
+        GL_ASSERT( glUniform4fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler* sampler)
 {
     GP_ASSERT(uniform);
-    GP_ASSERT(uniform->_type == GL_SAMPLER_2D);
+    GP_ASSERT(uniform->_type == GL_SAMPLER_2D || uniform->_type == GL_SAMPLER_CUBE);
     GP_ASSERT(sampler);
 
-    GL_ASSERT( glActiveTexture(GL_TEXTURE0 + uniform->_index) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->setSamplers(uniform, &sampler, 1);
+        return;
+    }
+
+    GLStateCache::activeTexture(uniform->_index);
 
     // Bind the sampler - this binds the texture and applies sampler state
     const_cast<Texture::Sampler*>(sampler)->bind();
 
-    GL_ASSERT( glUniform1i(uniform->_location, uniform->_index) );
+    // The texture unit of a sampler uniform never changes, so it only needs to be uploaded once.
+    GLint unit = (GLint)uniform->_index;
+    if (uniform->updateCache(&unit, sizeof(GLint)))
+        GL_ASSERT( glUniform1i(uniform->_location, unit) );
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigned int count)
 {
     GP_ASSERT(uniform);
-    GP_ASSERT(uniform->_type == GL_SAMPLER_2D);
+    GP_ASSERT(uniform->_type == GL_SAMPLER_2D || uniform->_type == GL_SAMPLER_CUBE);
     GP_ASSERT(values);
 
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->setSamplers(uniform, values, count);
+        return;
+    }
+
     // Set samplers as active and load texture unit array
     GLint units[32];
     for (unsigned int i = 0; i < count; ++i)
     {
-        GL_ASSERT( glActiveTexture(GL_TEXTURE0 + uniform->_index + i) );
+        GLStateCache::activeTexture(uniform->_index + i);
 
         // Bind the sampler - this binds the texture and applies sampler state
         const_cast<Texture::Sampler*>(values[i])->bind();
@@ -638,14 +1428,26 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigne
     }
 
     // Pass texture unit array to GL
-    GL_ASSERT( glUniform1iv(uniform->_location, count, units) );
+    if (uniform->updateCache(units, sizeof(GLint) * count))
+        GL_ASSERT( glUniform1iv(uniform->_location, count, units) );
 }
 
 void Effect::bind()
 {
-   GL_ASSERT( glUseProgram(_program) );
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->bindEffect(this);
+        return;
+    }
 
-    __currentEffect = this;
+    // Skip redundant program changes when drawing items that share an effect.
+    if (__currentEffect != this)
+    {
+        if (GLStateCache::useProgram(_program))
+            ++Game::_renderStats.programBinds;
+        __currentEffect = this;
+    }
 }
 
 Effect* Effect::getCurrentEffect()
@@ -653,14 +1455,30 @@ Effect* Effect::getCurrentEffect()
     return __currentEffect;
 }
 
+unsigned int Effect::getUniformUploadCount()
+{
+    return __uniformUploadCount;
+}
+
+unsigned int Effect::getUniformSkipCount()
+{
+    return __uniformSkipCount;
+}
+
+void Effect::resetUniformCounters()
+{
+    __uniformUploadCount = 0;
+    __uniformSkipCount = 0;
+}
+
 Uniform::Uniform() :
-    _location(-1), _type(0), _index(0)
+    _location(-1), _type(0), _index(0), _effect(NULL), _cache(NULL), _cacheSize(0), _cacheValues(true)
 {
 }
 
 Uniform::~Uniform()
 {
-    // hidden
+    SAFE_DELETE_ARRAY(_cache);
 }
 
 Effect* Uniform::getEffect() const
@@ -678,4 +1496,25 @@ const GLenum Uniform::getType() const
     return _type;
 }
 
+bool Uniform::updateCache(const void* value, unsigned int size)
+{
+    if (_cacheValues)
+    {
+        if (_cacheSize == size && memcmp(_cache, value, size) == 0)
+        {
+            ++__uniformSkipCount;
+            return false;
+        }
+        if (_cacheSize != size)
+        {
+            SAFE_DELETE_ARRAY(_cache);
+            _cache = new unsigned char[size];
+            _cacheSize = size;
+        }
+        memcpy(_cache, value, size);
+    }
+    ++__uniformUploadCount;
+    return true;
+}
+
 }
@@ -7,6 +7,7 @@
 #include "Vector4.h"
 #include "Matrix.h"
 #include "Texture.h"
+#include "GraphicsResource.h"
 
 namespace gameplay
 {
@@ -23,13 +24,19 @@ class Uniform;
  * typical effect systems support, such as GPU render state management,
  * techniques and passes.
  */
-class Effect: public Ref
+class Effect: public Ref, private GraphicsResource
 {
+    friend class Game;
+    friend class RenderState;
+
 public:
 
     /**
      * Creates an effect using the specified vertex and fragment shader.
      *
+     * On OpenGL 3 and later, the vertex shader outputs named in the TRANSFORM_FEEDBACK_VARYINGS
+     * define (separated by spaces) are captured by transform feedback, interleaved in that order.
+     *
      * @param vshPath The path to the vertex shader file.
      * @param fshPath The path to the fragment shader file.
      * @param defines A new-line delimited list of preprocessor defines. May be NULL.
@@ -49,6 +56,126 @@ public:
      */
     static Effect* createFromSource(const char* vshSource, const char* fshSource, const char* defines = NULL);
 
+    /**
+     * Returns the directory where linked program binaries are cached.
+     *
+     * @return The cache directory, or NULL if caching is disabled.
+     * @script{ignore}
+     */
+    static const char* getProgramCachePath();
+
+    /**
+     * Sets the directory where linked program binaries are cached across runs.
+     *
+     * When set and the driver supports program binaries (GL_OES_get_program_binary on
+     * OpenGL ES, GL_ARB_get_program_binary on desktop OpenGL), each program is saved after
+     * it is linked and loaded from its binary on later runs instead of being compiled.
+     * Binaries are keyed by the expanded shader sources, including their defines, and by
+     * the vendor, renderer and version of the driver, so changed shaders and driver updates
+     * compile the program again. The directory must exist and be writable. Caching can
+     * also be enabled by the 'programCachePath' property in the 'graphics' section of the
+     * game configuration file.
+     *
+     * @param path The cache directory, or NULL to disable caching.
+     * @script{ignore}
+     */
+    static void setProgramCachePath(const char* path);
+
+    /**
+     * Queues an effect to be compiled ahead of its first use.
+     *
+     * Shader permutations that are compiled the first time they are drawn cause stalls
+     * during gameplay. Queued effects are compiled and linked over the next frames while
+     * the game is loading or running, limited by the time budget set with
+     * setWarmUpBudget(), and are then kept in the effect cache so that createFromFile()
+     * returns them right away. When the driver supports KHR_parallel_shader_compile, all
+     * queued programs are handed to the driver at once and compiled in the background;
+     * otherwise they are compiled one or more per frame on the game thread. Programs from
+     * the program binary cache (see setProgramCachePath()) need no compiling at all.
+     *
+     * @param vshPath The path to the vertex shader file.
+     * @param fshPath The path to the fragment shader file.
+     * @param defines A new-line delimited list of preprocessor defines. May be NULL.
+     *
+     * @return True if the effect is queued or already loaded, false if a shader could not be read.
+     * @script{ignore}
+     */
+    static bool warmUp(const char* vshPath, const char* fshPath, const char* defines = NULL);
+
+    /**
+     * Queues the effects listed in a warm-up manifest to be compiled ahead of their first use.
+     *
+     * The manifest is a properties file listing the shader permutations used by the game:
+     *
+     * @verbatim
+       effects
+       {
+           effect
+           {
+               vertexShader = res/shaders/textured.vert
+               fragmentShader = res/shaders/textured.frag
+               defines = SKINNING;SKINNING_JOINT_COUNT 32
+           }
+       }
+     @endverbatim
+     *
+     * @param path The path to the manifest file.
+     *
+     * @return The number of effects that were queued or already loaded.
+     * @script{ignore}
+     */
+    static unsigned int warmUpFromFile(const char* path);
+
+    /**
+     * Returns the number of queued effects that are not compiled yet.
+     *
+     * @return The number of pending warm-ups.
+     * @script{ignore}
+     */
+    static unsigned int getWarmUpCount();
+
+    /**
+     * Returns the progress of the effects queued since the last warm-up finished.
+     *
+     * This can be used to draw a progress bar on a loading screen.
+     *
+     * @return The fraction of queued effects that are compiled, between 0 and 1.
+     * @script{ignore}
+     */
+    static float getWarmUpProgress();
+
+    /**
+     * Sets the time spent per frame finishing queued effects.
+     *
+     * At least one effect is finished per frame, regardless of the budget.
+     *
+     * @param milliseconds The time budget, in milliseconds (4 by default).
+     * @script{ignore}
+     */
+    static void setWarmUpBudget(float milliseconds);
+
+    /**
+     * Releases the references held on warmed up effects.
+     *
+     * Warmed up effects stay loaded until this is called, even when nothing uses them.
+     * Effects that are used by materials stay loaded after this call.
+     *
+     * @script{ignore}
+     */
+    static void releaseWarmedEffects();
+
+    /**
+     * Releases the shader files kept to load more permutations of the effects.
+     *
+     * Each shader file is read and its #include directives are expanded once, the first
+     * time an effect is loaded from it, and the other permutations are created by only
+     * prefixing their defines. This should be called after editing shader files while
+     * the game is running, or to free the sources once the game loaded all its effects.
+     *
+     * @script{ignore}
+     */
+    static void clearSourceCache();
+
     /**
      * Returns the unique string identifier for the effect, which is a concatenation of
      * the shader paths it was loaded from.
@@ -64,6 +191,32 @@ public:
      */
     VertexAttribute getVertexAttribute(const char* name) const;
 
+    /**
+     * Returns the location of the per-instance world matrix attribute ("a_instanceMatrix").
+     *
+     * Effects compiled with the INSTANCED define read their world matrix from this
+     * attribute rather than from a uniform, which allows many instances of the same
+     * mesh to be drawn with a single pass bind. The matrix occupies four consecutive
+     * attribute locations, one per column.
+     *
+     * @return The attribute location, or -1 if the effect is not instanced.
+     */
+    VertexAttribute getInstanceMatrixAttribute() const;
+
+    /**
+     * Returns whether this effect reads the camera parameters from the shared frame
+     * uniform buffer.
+     *
+     * Effects declare the "FrameUniforms" uniform block (see res/shaders/frame-uniforms.vert)
+     * to read the view and projection matrices and the camera position from a single
+     * buffer that is only updated when the camera changes, instead of from uniforms set
+     * for each pass. Auto-bound material parameters for these values are skipped for such
+     * effects. This requires uniform buffer support (see RenderState::isFrameUniformBufferSupported()).
+     *
+     * @return True if the effect uses the frame uniform block.
+     */
+    bool hasFrameUniforms() const;
+
     /**
      * Returns the uniform handle for the uniform with the specified name.
      *
@@ -212,6 +365,8 @@ public:
 
     /**
      * Binds this effect to make it the currently active effect for the rendering system.
+     *
+     * If this effect is already the current effect, no GL calls are made.
      */
     void bind();
 
@@ -222,8 +377,33 @@ public:
      */
     static Effect* getCurrentEffect();
 
+    /**
+     * Returns the number of uniform values uploaded to GL since the counters were last reset.
+     *
+     * @return The number of uniform uploads.
+     */
+    static unsigned int getUniformUploadCount();
+
+    /**
+     * Returns the number of uniform uploads that were skipped since the counters were
+     * last reset, because the value was unchanged since the last upload to the same program.
+     *
+     * @return The number of skipped uniform uploads.
+     */
+    static unsigned int getUniformSkipCount();
+
+    /**
+     * Resets the uniform upload and skip counters to zero.
+     */
+    static void resetUniformCounters();
+
 private:
 
+    /**
+     * Defines an effect queued by warmUp().
+     */
+    struct WarmUp;
+
     /**
      * Hidden constructor (use createEffect instead).
      */
@@ -239,13 +419,70 @@ private:
      */
     Effect& operator=(const Effect&);
 
+    /**
+     * Creates an effect from expanded shader sources.
+     *
+     * The paths of shaders loaded from files are only used to report errors.
+     */
     static Effect* createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines = NULL);
 
+    /**
+     * Creates an effect from a linked program.
+     */
+    static Effect* createFromProgram(GLuint program);
+
+    /**
+     * Queries the locations of the vertex attributes of the program.
+     */
+    void queryVertexAttributes();
+
+    /**
+     * Binds the frame uniform block of the program, if it has one, to the shared frame uniform buffer.
+     */
+    void bindFrameUniformBlock();
+
+    /**
+     * Keeps the expanded shader sources of the program, if they fit in the retain budget.
+     */
+    void retainSources(const char* defines, const char* vshSource, const char* fshSource);
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     */
+    void restoreGraphics();
+
+    /**
+     * Finishes the queued effects within the time budget (called by Game every frame).
+     */
+    static void updateWarmUp();
+
+    /**
+     * Links a queued effect and adds it to the effect cache.
+     */
+    static void finishWarmUp(WarmUp* warmUp);
+
+    /**
+     * Discards the queued effects and releases the warmed up effects (called by Game on shutdown).
+     */
+    static void cancelWarmUp();
+
     GLuint _program;
     std::string _id;
     std::map<std::string, VertexAttribute> _vertexAttributes;
+    VertexAttribute _instanceMatrixAttribute;
+    bool _frameUniforms;
     mutable std::map<std::string, Uniform*> _uniforms;
+    std::string _defines;
+    std::string _vshSource;
+    std::string _fshSource;
     static Uniform _emptyUniform;
+    static const GLuint FRAME_UNIFORMS_BINDING = 0;
+    static std::vector<WarmUp*> _warmUps;
 };
 
 /**
@@ -300,11 +537,21 @@ private:
      */
     Uniform& operator=(const Uniform&);
 
+    /**
+     * Updates the shadow copy of this uniform's value.
+     *
+     * @return true if the value differs from the last value uploaded and must be sent to GL.
+     */
+    bool updateCache(const void* value, unsigned int size);
+
     std::string _name;
     GLint _location;
     GLenum _type;
     unsigned int _index;
     Effect* _effect;
+    unsigned char* _cache;
+    unsigned int _cacheSize;
+    bool _cacheValues;
 };
 
 }
@@ -18,6 +18,9 @@
     #define __EXT_POSIX2
     #include <libgen.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
     #define gp_stat stat
     #define gp_stat_struct struct stat
 #endif
@@ -83,12 +86,198 @@ static bool androidFileExists(const char* filePath)
     return false;
 }
 
+static int readAsset(void* cookie, char* buffer, int size)
+{
+    return AAsset_read((AAsset*)cookie, buffer, size);
+}
+
+static fpos_t seekAsset(void* cookie, fpos_t offset, int whence)
+{
+    return AAsset_seek((AAsset*)cookie, offset, whence);
+}
+
+static int closeAsset(void* cookie)
+{
+    AAsset_close((AAsset*)cookie);
+    return 0;
+}
+
+/**
+ * Opens an asset of the android read-only asset directory as a read-only FILE, which reads it in place from the package.
+ */
+static FILE* openAsset(const char* filePath)
+{
+    AAsset* asset = AAssetManager_open(__assetManager, filePath, AASSET_MODE_RANDOM);
+    if (asset == NULL)
+        return NULL;
+    FILE* file = funopen(asset, readAsset, NULL, seekAsset, closeAsset);
+    if (file == NULL)
+        AAsset_close(asset);
+    return file;
+}
+
 #endif
 
 /** @script{ignore} */
 static std::string __resourcePath("./");
 static std::map<std::string, std::string> __aliases;
 
+// The identifier and version of archive files.
+static const char ARCHIVE_IDENTIFIER[4] = { 'G', 'P', 'A', 'K' };
+static const unsigned int ARCHIVE_VERSION = 1;
+
+// The flag of the archive entries that are compressed with LZ4.
+#define ARCHIVE_ENTRY_LZ4 1
+
+/**
+ * Defines an entry in the index of an archive, as stored in the file.
+ */
+struct ArchiveEntry
+{
+    unsigned int hash;
+    unsigned int nameOffset;
+    unsigned int nameLength;
+    unsigned int flags;
+    unsigned int offset;
+    unsigned int size;
+    unsigned int originalSize;
+
+    bool operator<(const ArchiveEntry& entry) const
+    {
+        return hash < entry.hash;
+    }
+};
+
+/**
+ * Defines a mounted archive: its contents, in memory, and its index sorted by hash.
+ */
+struct Archive
+{
+    Stream* stream;
+    unsigned char* buffer;
+    const unsigned char* data;
+    size_t length;
+    std::vector<ArchiveEntry> entries;
+};
+
+static std::vector<Archive*> __archives;
+
+/**
+ * Returns the FNV-1a hash of a path in an archive.
+ */
+static unsigned int hashArchivePath(const char* path, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Returns the entry of the mounted archives matching the specified path.
+ *
+ * @param path The resolved path, relative to the resource path.
+ * @param archive The archive holding the entry. (out param)
+ *
+ * @return The entry, or NULL if no archive holds the path.
+ */
+static const ArchiveEntry* findArchiveEntry(const char* path, const Archive** archive)
+{
+    if (__archives.empty())
+        return NULL;
+
+    // Entries are stored without a leading "./".
+    while (path[0] == '.' && path[1] == '/')
+        path += 2;
+    size_t length = strlen(path);
+    ArchiveEntry key;
+    key.hash = hashArchivePath(path, length);
+
+    for (size_t i = __archives.size(); i-- > 0;)
+    {
+        const Archive* a = __archives[i];
+        std::vector<ArchiveEntry>::const_iterator itr = std::lower_bound(a->entries.begin(), a->entries.end(), key);
+        for (; itr != a->entries.end() && itr->hash == key.hash; ++itr)
+        {
+            if (itr->nameLength == length && memcmp(a->data + itr->nameOffset, path, length) == 0)
+            {
+                *archive = a;
+                return &(*itr);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Decompresses a block compressed in the LZ4 block format.
+ *
+ * @return true if the block decompressed to exactly the size of the destination.
+ */
+static bool decompressLZ4(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+{
+    const unsigned char* in = source;
+    const unsigned char* inEnd = source + sourceSize;
+    unsigned char* out = destination;
+    unsigned char* outEnd = destination + destinationSize;
+    while (in < inEnd)
+    {
+        // Each sequence is a run of literals followed by a match, except the last one, which only has literals.
+        unsigned int token = *in++;
+        size_t length = token >> 4;
+        if (length == 15)
+        {
+            unsigned char byte;
+            do
+            {
+                if (in >= inEnd)
+                    return false;
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+        }
+        if (length > (size_t)(inEnd - in) || length > (size_t)(outEnd - out))
+            return false;
+        memcpy(out, in, length);
+        in += length;
+        out += length;
+        if (in >= inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (size_t)(out - destination))
+            return false;
+        length = token & 15;
+        if (length == 15)
+        {
+            unsigned char byte;
+            do
+            {
+                if (in >= inEnd)
+                    return false;
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+        }
+        length += 4;
+        if (length > (size_t)(outEnd - out))
+            return false;
+
+        // Matches can overlap the bytes they produce, so they are copied one byte at a time.
+        const unsigned char* match = out - offset;
+        while (length-- > 0)
+        {
+            *out++ = *match++;
+        }
+    }
+    return out == outEnd;
+}
+
 /**
  * Gets the fully resolved path.
  * If the path is relative then it will be prefixed with the resource path.
@@ -144,6 +333,45 @@ private:
     bool _canWrite;
 };
 
+/**
+ * Defines a read-only stream over a file that is mapped into memory, or over
+ * an entry of a mounted archive.
+ * 
+ * @script{ignore}
+ */
+class MappedFileStream : public Stream
+{
+public:
+    friend class FileSystem;
+    
+    ~MappedFileStream();
+    virtual bool canRead();
+    virtual bool canWrite();
+    virtual bool canSeek();
+    virtual void close();
+    virtual size_t read(void* ptr, size_t size, size_t count);
+    virtual char* readLine(char* str, int num);
+    virtual size_t write(const void* ptr, size_t size, size_t count);
+    virtual bool eof();
+    virtual size_t length();
+    virtual long int position();
+    virtual bool seek(long int offset, int origin);
+    virtual bool rewind();
+    virtual const void* getBuffer();
+
+    static MappedFileStream* create(const char* filePath);
+
+private:
+    MappedFileStream(const unsigned char* data, size_t length, bool mapped = true, bool owned = false);
+
+private:
+    const unsigned char* _data;
+    size_t _length;
+    size_t _position;
+    bool _mapped;
+    bool _owned;
+};
+
 #ifdef __ANDROID__
 
 /**
@@ -169,13 +397,16 @@ public:
     virtual bool seek(long int offset, int origin);
     virtual bool rewind();
 
-    static FileStreamAndroid* create(const char* filePath, const char* mode);
+    virtual const void* getBuffer();
+
+    static FileStreamAndroid* create(const char* filePath, const char* mode, bool mapped = false);
 
 private:
-    FileStreamAndroid(AAsset* asset);
+    FileStreamAndroid(AAsset* asset, bool mapped);
 
 private:
     AAsset* _asset;
+    bool _mapped;
 };
 
 #endif
@@ -225,6 +456,86 @@ void FileSystem::loadResourceAliases(Properties* properties)
     }
 }
 
+bool FileSystem::mountArchive(const char* archivePath)
+{
+    GP_ASSERT(archivePath);
+
+    Stream* stream = open(archivePath, MAPPED);
+    if (stream == NULL)
+    {
+        GP_ERROR("Failed to open archive '%s'.", archivePath);
+        return false;
+    }
+
+    // Read the archive into memory if it could not be mapped.
+    Archive* archive = new Archive();
+    archive->stream = stream;
+    archive->buffer = NULL;
+    archive->length = stream->length();
+    archive->data = (const unsigned char*)stream->getBuffer();
+    if (archive->data == NULL)
+    {
+        archive->buffer = new unsigned char[archive->length];
+        if (stream->read(archive->buffer, 1, archive->length) != archive->length)
+        {
+            GP_ERROR("Failed to read archive '%s'.", archivePath);
+            SAFE_DELETE_ARRAY(archive->buffer);
+            SAFE_DELETE(archive->stream);
+            SAFE_DELETE(archive);
+            return false;
+        }
+        archive->data = archive->buffer;
+    }
+
+    // Validate the header and the index before trusting any offset of the archive.
+    unsigned int header[3];
+    bool valid = archive->length >= 4 + sizeof(header) && memcmp(archive->data, ARCHIVE_IDENTIFIER, 4) == 0;
+    if (valid)
+    {
+        memcpy(header, archive->data + 4, sizeof(header));
+        valid = header[0] == ARCHIVE_VERSION && (archive->length - 4 - sizeof(header)) / sizeof(ArchiveEntry) >= header[1];
+    }
+    if (valid)
+    {
+        archive->entries.resize(header[1]);
+        if (header[1] > 0)
+        {
+            memcpy(&archive->entries[0], archive->data + 4 + sizeof(header), header[1] * sizeof(ArchiveEntry));
+        }
+        for (unsigned int i = 0; i < header[1] && valid; ++i)
+        {
+            const ArchiveEntry& entry = archive->entries[i];
+            valid = (size_t)entry.nameOffset + entry.nameLength <= archive->length && (size_t)entry.offset + entry.size <= archive->length &&
+                ((entry.flags & ARCHIVE_ENTRY_LZ4) != 0 || entry.size == entry.originalSize);
+        }
+    }
+    if (!valid)
+    {
+        GP_ERROR("Invalid archive '%s'.", archivePath);
+        SAFE_DELETE_ARRAY(archive->buffer);
+        SAFE_DELETE(archive->stream);
+        SAFE_DELETE(archive);
+        return false;
+    }
+
+    // The encoder sorts the index, but sorting again keeps lookups correct for any writer.
+    std::sort(archive->entries.begin(), archive->entries.end());
+    __archives.push_back(archive);
+    return true;
+}
+
+void FileSystem::unmountArchives()
+{
+    for (size_t i = 0, count = __archives.size(); i < count; ++i)
+    {
+        Archive* archive = __archives[i];
+        SAFE_DELETE_ARRAY(archive->buffer);
+        SAFE_DELETE(archive->stream);
+        SAFE_DELETE(archive);
+    }
+    __archives.clear();
+}
+
 std::string FileSystem::displayFileDialog(size_t dialogMode, const char* title, const char* filterDescription, const char* filterExtensions, const char* initialDirectory)
 {
     return Platform::displayFileDialog(dialogMode, title, filterDescription, filterExtensions, initialDirectory);
@@ -247,6 +558,42 @@ const char* FileSystem::resolvePath(const char* path)
     return path;
 }
 
+/**
+ * Adds the names of the archive entries in the specified directory to the list.
+ *
+ * @return true if any archive holds files in the directory.
+ */
+static bool listArchiveFiles(const char* dirPath, std::vector<std::string>& files)
+{
+    std::string prefix(dirPath ? dirPath : "");
+    while (prefix.compare(0, 2, "./") == 0)
+        prefix.erase(0, 2);
+    if (!prefix.empty() && prefix[prefix.size() - 1] != '/')
+        prefix += '/';
+
+    bool result = false;
+    for (size_t i = 0, count = __archives.size(); i < count; ++i)
+    {
+        const Archive* archive = __archives[i];
+        for (size_t j = 0, entryCount = archive->entries.size(); j < entryCount; ++j)
+        {
+            const ArchiveEntry& entry = archive->entries[j];
+            const char* name = (const char*)archive->data + entry.nameOffset;
+            if (entry.nameLength <= prefix.size() || prefix.compare(0, prefix.size(), name, prefix.size()) != 0)
+                continue;
+
+            // Only the files directly in the directory are listed.
+            std::string filename(name + prefix.size(), entry.nameLength - prefix.size());
+            if (filename.find('/') == std::string::npos && std::find(files.begin(), files.end(), filename) == files.end())
+            {
+                files.push_back(filename);
+            }
+            result = true;
+        }
+    }
+    return result;
+}
+
 bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
 {
 #ifdef WIN32
@@ -264,7 +611,7 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     HANDLE hFind = FindFirstFile(wPath.c_str(), &FindFileData);
     if (hFind == INVALID_HANDLE_VALUE) 
     {
-        return false;
+        return listArchiveFiles(dirPath, files);
     }
     do
     {
@@ -280,6 +627,7 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     } while (FindNextFile(hFind, &FindFileData) != 0);
 
     FindClose(hFind);
+    listArchiveFiles(dirPath, files);
     return true;
 #else
     std::string path(FileSystem::getResourcePath());
@@ -335,6 +683,10 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     }
 #endif
 
+    if (listArchiveFiles(dirPath, files))
+    {
+        result = true;
+    }
     return result;
 #endif
 }
@@ -343,6 +695,12 @@ bool FileSystem::fileExists(const char* filePath)
 {
     GP_ASSERT(filePath);
 
+    const Archive* archive;
+    if (!isAbsolutePath(filePath) && findArchiveEntry(resolvePath(filePath), &archive))
+    {
+        return true;
+    }
+
 #ifdef __ANDROID__
     if (androidFileExists(resolvePath(filePath)))
     {
@@ -363,6 +721,26 @@ Stream* FileSystem::open(const char* path, size_t streamMode)
     char modeStr[] = "rb";
     if ((streamMode & WRITE) != 0)
         modeStr[0] = 'w';
+
+    // Read the entries of mounted archives in place.
+    const Archive* archive;
+    const ArchiveEntry* entry = (streamMode & WRITE) == 0 && !isAbsolutePath(path) ? findArchiveEntry(resolvePath(path), &archive) : NULL;
+    if (entry)
+    {
+        if ((entry->flags & ARCHIVE_ENTRY_LZ4) == 0)
+        {
+            return new MappedFileStream(archive->data + entry->offset, entry->size, false);
+        }
+
+        unsigned char* buffer = new unsigned char[entry->originalSize > 0 ? entry->originalSize : 1];
+        if (!decompressLZ4(archive->data + entry->offset, entry->size, buffer, entry->originalSize))
+        {
+            GP_ERROR("Failed to decompress '%s' from its archive.", path);
+            SAFE_DELETE_ARRAY(buffer);
+            return NULL;
+        }
+        return new MappedFileStream(buffer, entry->originalSize, false, true);
+    }
 #ifdef __ANDROID__
     if ((streamMode & WRITE) != 0)
     {
@@ -383,11 +761,17 @@ Stream* FileSystem::open(const char* path, size_t streamMode)
     else
     {
         // Open a file in the read-only asset directory
-        return FileStreamAndroid::create(resolvePath(path), modeStr);
+        return FileStreamAndroid::create(resolvePath(path), modeStr, (streamMode & MAPPED) != 0);
     }
 #else
     std::string fullPath;
     getFullPath(path, fullPath);
+    if ((streamMode & MAPPED) != 0 && (streamMode & WRITE) == 0)
+    {
+        MappedFileStream* stream = MappedFileStream::create(fullPath.c_str());
+        if (stream)
+            return stream;
+    }
     FileStream* stream = FileStream::create(fullPath.c_str(), modeStr);
     return stream;
 #endif
@@ -401,8 +785,29 @@ FILE* FileSystem::openFile(const char* filePath, const char* mode)
     std::string fullPath;
     getFullPath(filePath, fullPath);
 
-    createFileFromAsset(filePath);
-    
+#ifdef __ANDROID__
+    // Assets are read in place rather than copied out of the package first.
+    // Only files opened for update need a writable copy of their asset.
+    bool update = strchr(mode, '+') != NULL || strchr(mode, 'a') != NULL;
+    if (strchr(mode, 'r') && !update && !isAbsolutePath(filePath))
+    {
+        FILE* fp = openAsset(resolvePath(filePath));
+        if (fp)
+            return fp;
+    }
+    else if (update)
+    {
+        createFileFromAsset(filePath);
+    }
+    else if (strchr(mode, 'w'))
+    {
+        std::string directoryPath = fullPath.substr(0, fullPath.rfind('/'));
+        struct stat s;
+        if (stat(directoryPath.c_str(), &s) != 0)
+            makepath(directoryPath, 0777);
+    }
+#endif
+
     FILE* fp = fopen(fullPath.c_str(), mode);
     return fp;
 }
@@ -691,10 +1096,194 @@ bool FileStream::rewind()
 
 ////////////////////////////////
 
+MappedFileStream::MappedFileStream(const unsigned char* data, size_t length, bool mapped, bool owned)
+    : _data(data), _length(length), _position(0), _mapped(mapped), _owned(owned)
+{
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    if (_data)
+    {
+        close();
+    }
+}
+
+MappedFileStream* MappedFileStream::create(const char* filePath)
+{
+    GP_ASSERT(filePath);
+
+    // The file and mapping handles can be closed once the view is mapped; the view keeps the file open.
+#ifdef WIN32
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER size;
+    void* data = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.HighPart == 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (data == NULL)
+        return NULL;
+
+    return new MappedFileStream((const unsigned char*)data, (size_t)size.LowPart);
+#else
+    int file = ::open(filePath, O_RDONLY);
+    if (file == -1)
+        return NULL;
+
+    struct stat s;
+    void* data = MAP_FAILED;
+    if (fstat(file, &s) == 0 && s.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    ::close(file);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    return new MappedFileStream((const unsigned char*)data, (size_t)s.st_size);
+#endif
+}
+
+bool MappedFileStream::canRead()
+{
+    return _data != NULL;
+}
+
+bool MappedFileStream::canWrite()
+{
+    return false;
+}
+
+bool MappedFileStream::canSeek()
+{
+    return _data != NULL;
+}
+
+void MappedFileStream::close()
+{
+    if (_data && _owned)
+    {
+        delete[] _data;
+    }
+    else if (_data && _mapped)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap((void*)_data, _length);
+#endif
+    }
+    _data = NULL;
+    _length = 0;
+    _position = 0;
+}
+
+size_t MappedFileStream::read(void* ptr, size_t size, size_t count)
+{
+    if (!_data || size == 0)
+        return 0;
+
+    size_t available = (_length - _position) / size;
+    if (count > available)
+        count = available;
+    memcpy(ptr, _data + _position, size * count);
+    _position += size * count;
+    return count;
+}
+
+char* MappedFileStream::readLine(char* str, int num)
+{
+    if (!_data || num <= 0 || _position >= _length)
+        return NULL;
+
+    // Copy up to and including the next newline, like fgets.
+    size_t i = 0;
+    while (i < (size_t)num - 1 && _position < _length)
+    {
+        char c = (char)_data[_position++];
+        str[i++] = c;
+        if (c == '\n')
+            break;
+    }
+    str[i] = '\0';
+    return str;
+}
+
+size_t MappedFileStream::write(const void* ptr, size_t size, size_t count)
+{
+    return 0;
+}
+
+bool MappedFileStream::eof()
+{
+    return _position >= _length;
+}
+
+size_t MappedFileStream::length()
+{
+    return _length;
+}
+
+long int MappedFileStream::position()
+{
+    if (!_data)
+        return -1;
+    return (long int)_position;
+}
+
+bool MappedFileStream::seek(long int offset, int origin)
+{
+    if (!_data)
+        return false;
+
+    long int base;
+    switch (origin)
+    {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = (long int)_position;
+        break;
+    case SEEK_END:
+        base = (long int)_length;
+        break;
+    default:
+        return false;
+    }
+    if (base + offset < 0 || (size_t)(base + offset) > _length)
+        return false;
+    _position = (size_t)(base + offset);
+    return true;
+}
+
+bool MappedFileStream::rewind()
+{
+    _position = 0;
+    return _data != NULL;
+}
+
+const void* MappedFileStream::getBuffer()
+{
+    return _data;
+}
+
+////////////////////////////////
+
 #ifdef __ANDROID__
 
-FileStreamAndroid::FileStreamAndroid(AAsset* asset)
-    : _asset(asset)
+FileStreamAndroid::FileStreamAndroid(AAsset* asset, bool mapped)
+    : _asset(asset), _mapped(mapped)
 {
 }
 
@@ -704,12 +1293,13 @@ FileStreamAndroid::~FileStreamAndroid()
         close();
 }
 
-FileStreamAndroid* FileStreamAndroid::create(const char* filePath, const char* mode)
+FileStreamAndroid* FileStreamAndroid::create(const char* filePath, const char* mode, bool mapped)
 {
-    AAsset* asset = AAssetManager_open(__assetManager, filePath, AASSET_MODE_RANDOM);
+    // Uncompressed assets opened in buffer mode are mapped directly from the package.
+    AAsset* asset = AAssetManager_open(__assetManager, filePath, mapped ? AASSET_MODE_BUFFER : AASSET_MODE_RANDOM);
     if (asset)
     {
-        FileStreamAndroid* stream = new FileStreamAndroid(asset);
+        FileStreamAndroid* stream = new FileStreamAndroid(asset, mapped);
         return stream;
     }
     return NULL;
@@ -836,6 +1426,11 @@ bool FileStreamAndroid::rewind()
     return false;
 }
 
+const void* FileStreamAndroid::getBuffer()
+{
+    return (_asset && _mapped) ? AAsset_getBuffer(_asset) : NULL;
+}
+
 #endif
 
 }
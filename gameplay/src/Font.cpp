@@ -3,6 +3,7 @@
 #include "Game.h"
 #include "FileSystem.h"
 #include "Bundle.h"
+#include "GlyphCache.h"
 
 // Default font shaders
 #define FONT_VSH "res/shaders/font.vert"
@@ -16,7 +17,7 @@ static std::vector<Font*> __fontCache;
 static Effect* __fontEffect = NULL;
 
 Font::Font() :
-    _format(BITMAP), _style(PLAIN), _size(0), _spacing(0.125f), _glyphs(NULL), _glyphCount(0), _texture(NULL), _batch(NULL), _cutoffParam(NULL)
+    _format(BITMAP), _style(PLAIN), _size(0), _spacing(0.125f), _glyphs(NULL), _glyphCount(0), _glyphCodeBase(0), _texture(NULL), _glyphCache(NULL), _batch(NULL), _cutoffParam(NULL)
 {
 }
 
@@ -32,6 +33,7 @@ Font::~Font()
     SAFE_DELETE(_batch);
     SAFE_DELETE_ARRAY(_glyphs);
     SAFE_RELEASE(_texture);
+    SAFE_DELETE(_glyphCache);
 
     // Free child fonts
     for (size_t i = 0, count = _sizes.size(); i < count; ++i)
@@ -96,10 +98,33 @@ Font* Font::create(const char* path, const char* id)
     return font;
 }
 
+Font* Font::createDynamic(const char* path, unsigned int size, unsigned int textureSize)
+{
+    GP_ASSERT(path);
+
+    GlyphCache* cache = GlyphCache::create(path, size, textureSize);
+    if (cache == NULL)
+        return NULL;
+
+    // The glyphs are added to the cache as they are drawn.
+    Font* font = create(path, PLAIN, size, NULL, 0, cache->getTexture(), BITMAP);
+    if (font == NULL)
+    {
+        SAFE_DELETE(cache);
+        return NULL;
+    }
+    font->_path = path;
+    font->_glyphCache = cache;
+
+    // The cache texture has no mipmaps.
+    font->_batch->getSampler()->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    return font;
+}
+
 Font* Font::create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture, Font::Format format)
 {
     GP_ASSERT(family);
-    GP_ASSERT(glyphs);
+    GP_ASSERT(glyphs || glyphCount == 0);
     GP_ASSERT(texture);
 
     // Create the effect for the font's sprite batch.
@@ -154,6 +179,24 @@ Font* Font::create(const char* family, Style style, unsigned int size, Glyph* gl
     memcpy(font->_glyphs, glyphs, sizeof(Glyph) * glyphCount);
     font->_glyphCount = glyphCount;
 
+    // Build the table mapping character codes to glyphs.
+    if (glyphCount > 0)
+    {
+        unsigned int minCode = glyphs[0].code;
+        unsigned int maxCode = glyphs[0].code;
+        for (int i = 1; i < glyphCount; ++i)
+        {
+            minCode = std::min(minCode, glyphs[i].code);
+            maxCode = std::max(maxCode, glyphs[i].code);
+        }
+        font->_glyphCodeBase = minCode;
+        font->_glyphIndices.resize(maxCode - minCode + 1, -1);
+        for (int i = 0; i < glyphCount; ++i)
+        {
+            font->_glyphIndices[glyphs[i].code - minCode] = i;
+        }
+    }
+
     return font;
 }
 
@@ -177,9 +220,57 @@ Font::Format Font::getFormat()
 
 bool Font::isCharacterSupported(int character) const
 {
-    // TODO: Update this once we support unicode fonts
-    int glyphIndex = character - 32; // HACK for ASCII
-    return (glyphIndex >= 0 && glyphIndex < (int)_glyphCount);
+    if (character < 0)
+        return false;
+    if (_glyphCache)
+        return _glyphCache->getGlyph((unsigned int)character) != NULL;
+    return getGlyphIndex((unsigned int)character) >= 0;
+}
+
+int Font::getGlyphIndex(unsigned int code) const
+{
+    unsigned int offset = code - _glyphCodeBase;
+    return offset < _glyphIndices.size() ? _glyphIndices[offset] : -1;
+}
+
+/**
+ * Decodes the UTF-8 character starting at the given byte, returning false if the byte continues a character.
+ * Malformed sequences decode to their first byte.
+ */
+static bool decodeCharacter(const char* text, unsigned int* code)
+{
+    const unsigned char* bytes = (const unsigned char*)text;
+    unsigned char lead = bytes[0];
+    *code = lead;
+    if (lead < 0x80)
+        return true;
+    if ((lead & 0xC0) == 0x80)
+        return false;
+
+    unsigned int length = (lead & 0xE0) == 0xC0 ? 1 : ((lead & 0xF0) == 0xE0 ? 2 : ((lead & 0xF8) == 0xF0 ? 3 : 0));
+    unsigned int value = lead & (0x3F >> length);
+    for (unsigned int i = 1; i <= length; ++i)
+    {
+        if ((bytes[i] & 0xC0) != 0x80)
+            return true;
+        value = (value << 6) | (bytes[i] & 0x3F);
+    }
+    if (length > 0)
+        *code = value;
+    return true;
+}
+
+const Font::Glyph* Font::getGlyph(const char* text) const
+{
+    GP_ASSERT(text);
+
+    unsigned int code;
+    if (!decodeCharacter(text, &code))
+        return NULL;
+    if (_glyphCache)
+        return _glyphCache->getGlyph(code);
+    int index = getGlyphIndex(code);
+    return index >= 0 ? &_glyphs[index] : NULL;
 }
 
 void Font::start()
@@ -202,6 +293,10 @@ void Font::lazyStart()
         _batch->setProjectionMatrix(projectionMatrix);
     }
 
+    // Copy the glyphs rasterized since the last batch into the texture.
+    if (_glyphCache)
+        _glyphCache->update();
+
     _batch->start();
 }
 
@@ -223,7 +318,7 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
     bool wrap, bool rightToLeft, const Rectangle* clip)
 {
     GP_ASSERT(text);
-    GP_ASSERT(_glyphs);
+    GP_ASSERT(_glyphs || _glyphCache);
     GP_ASSERT(_batch);
     GP_ASSERT(_size);
 
@@ -245,20 +340,33 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
     int spacing = (int)(size * _spacing);
     int yPos = area.y;
     const float areaHeight = area.height - size;
-    std::vector<int> xPositions;
-    std::vector<unsigned int> lineLengths;
+    ScratchMemory::Scope scratch;
+    ScratchVector<int>::type xPositions;
+    ScratchVector<unsigned int>::type lineLengths;
 
     getMeasurementInfo(text, area, size, justify, wrap, rightToLeft, &xPositions, &yPos, &lineLengths);
 
     Text* batch = new Text(text);
     batch->_font = this;
     batch->_font->addRef();
+    batch->_color = color;
+    batch->_area = area;
+    batch->_size = size;
+    batch->_justify = justify;
+    batch->_wrap = wrap;
+    batch->_rightToLeft = rightToLeft;
+    batch->_clipped = clip != NULL;
+    batch->_generation = _glyphCache ? _glyphCache->getGeneration() : 0;
+    if (clip)
+    {
+        batch->_clip = *clip;
+    }
 
     GP_ASSERT(batch->_vertices);
     GP_ASSERT(batch->_indices);
 
     int xPos = area.x;
-    std::vector<int>::const_iterator xPositionsIt = xPositions.begin();
+    ScratchVector<int>::type::const_iterator xPositionsIt = xPositions.begin();
     if (xPositionsIt != xPositions.end())
     {
         xPos = *xPositionsIt++;
@@ -269,7 +377,7 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
     unsigned int lineLength;
     unsigned int currentLineLength = 0;
     const char* lineStart;
-    std::vector<unsigned int>::const_iterator lineLengthsIt;
+    ScratchVector<unsigned int>::type::const_iterator lineLengthsIt;
     if (rightToLeft)
     {
         lineStart = token;
@@ -338,12 +446,10 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
 
         for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
         {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(&token[i]);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
+                const Glyph& g = *glyph;
 
                 if (xPos + (int)(g.width*scale) > area.x + area.width)
                 {
@@ -502,10 +608,61 @@ void Font::drawText(Text* text)
     GP_ASSERT(text->_vertices);
     GP_ASSERT(text->_indices);
 
+    // Lay out the text again once the glyphs it was laid out with have changed in the glyph cache.
     lazyStart();
+    if (_glyphCache && text->_generation != _glyphCache->getGeneration())
+    {
+        Text* layout = createText(text->_text.c_str(), text->_area, text->_color, text->_size, text->_justify, text->_wrap, text->_rightToLeft,
+            text->_clipped ? &text->_clip : NULL);
+        if (layout)
+        {
+            std::swap(text->_vertices, layout->_vertices);
+            std::swap(text->_indices, layout->_indices);
+            text->_vertexCount = layout->_vertexCount;
+            text->_indexCount = layout->_indexCount;
+            text->_generation = layout->_generation;
+            SAFE_DELETE(layout);
+        }
+    }
+
+    if (text->_indexCount == 0)
+        return;
+
+    if (getFormat() == DISTANCE_FIELD)
+    {
+        if (_cutoffParam == NULL)
+            _cutoffParam = _batch->getMaterial()->getParameter("u_cutoff");
+        _cutoffParam->setVector2(Vector2(1.0, 1.0));
+    }
+
     _batch->draw(text->_vertices, text->_vertexCount, text->_indices, text->_indexCount);
 }
 
+static bool isSameRectangle(const Rectangle& a, const Rectangle& b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+Font::Text* Font::updateText(Text* text, const char* str, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
+    bool wrap, bool rightToLeft, const Rectangle* clip)
+{
+    GP_ASSERT(str);
+
+    if (text)
+    {
+        Font* font = size == 0 ? this : findClosestSize(size);
+        if (text->_font == font && text->_size == (size == 0 ? _size : size) && text->_justify == justify &&
+            text->_wrap == wrap && text->_rightToLeft == rightToLeft && text->_clipped == (clip != NULL) &&
+            (clip == NULL || isSameRectangle(text->_clip, *clip)) && isSameRectangle(text->_area, area) && text->_color == color && text->_text == str)
+        {
+            return text;
+        }
+        SAFE_DELETE(text);
+    }
+
+    return createText(str, area, color, size, justify, wrap, rightToLeft, clip);
+}
+
 void Font::drawText(const char* text, int x, int y, const Vector4& color, unsigned int size, bool rightToLeft)
 {
     GP_ASSERT(_size);
@@ -591,7 +748,7 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
             iteration = 1;
         }
 
-        GP_ASSERT(_glyphs);
+        GP_ASSERT(_glyphs || _glyphCache);
         GP_ASSERT(_batch);
         for (size_t i = startIndex; i < length; i += (size_t)iteration)
         {
@@ -620,10 +777,10 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
                 xPos += (size >> 1)*4;
                 break;
             default:
-                int index = c - 32; // HACK for ASCII
-                if (index >= 0 && index < (int)_glyphCount)
+                const Glyph* glyph = getGlyph(rightToLeft ? &cursor[i] : &text[i]);
+                if (glyph)
                 {
-                    Glyph& g = _glyphs[index];
+                    const Glyph& g = *glyph;
 
                     if (getFormat() == DISTANCE_FIELD )
                     {
@@ -682,14 +839,15 @@ void Font::drawText(const char* text, const Rectangle& area, const Vector4& colo
     int spacing = (int)(size * _spacing);
     int yPos = area.y;
     const float areaHeight = area.height - size;
-    std::vector<int> xPositions;
-    std::vector<unsigned int> lineLengths;
+    ScratchMemory::Scope scratch;
+    ScratchVector<int>::type xPositions;
+    ScratchVector<unsigned int>::type lineLengths;
 
     getMeasurementInfo(text, area, size, justify, wrap, rightToLeft, &xPositions, &yPos, &lineLengths);
 
     // Now we have the info we need in order to render.
     int xPos = area.x;
-    std::vector<int>::const_iterator xPositionsIt = xPositions.begin();
+    ScratchVector<int>::type::const_iterator xPositionsIt = xPositions.begin();
     if (xPositionsIt != xPositions.end())
     {
         xPos = *xPositionsIt++;
@@ -700,7 +858,7 @@ void Font::drawText(const char* text, const Rectangle& area, const Vector4& colo
     unsigned int lineLength;
     unsigned int currentLineLength = 0;
     const char* lineStart;
-    std::vector<unsigned int>::const_iterator lineLengthsIt;
+    ScratchVector<unsigned int>::type::const_iterator lineLengthsIt;
     if (rightToLeft)
     {
         lineStart = token;
@@ -767,16 +925,14 @@ void Font::drawText(const char* text, const Rectangle& area, const Vector4& colo
             break;
         }
 
-        GP_ASSERT(_glyphs);
+        GP_ASSERT(_glyphs || _glyphCache);
         GP_ASSERT(_batch);
         for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
         {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(&token[i]);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
+                const Glyph& g = *glyph;
 
                 if (xPos + (int)(g.width*scale) > area.x + area.width)
                 {
@@ -971,8 +1127,9 @@ void Font::measureText(const char* text, const Rectangle& clip, unsigned int siz
     }
 
     const char* token = text;
-    std::vector<bool> emptyLines;
-    std::vector<Vector2> lines;
+    ScratchMemory::Scope scratch;
+    ScratchVector<bool>::type emptyLines;
+    ScratchVector<Vector2>::type lines;
 
     unsigned int lineWidth = 0;
     int yPos = clip.y + size;
@@ -1277,7 +1434,7 @@ void Font::measureText(const char* text, const Rectangle& clip, unsigned int siz
 }
 
 void Font::getMeasurementInfo(const char* text, const Rectangle& area, unsigned int size, Justify justify, bool wrap, bool rightToLeft,
-        std::vector<int>* xPositions, int* yPosition, std::vector<unsigned int>* lineLengths)
+        ScratchVector<int>::type* xPositions, int* yPosition, ScratchVector<unsigned int>::type* lineLengths)
 {
     GP_ASSERT(_size);
     GP_ASSERT(text);
@@ -1513,13 +1670,14 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
     int spacing = (int)(size * _spacing);
     int yPos = area.y;
     const float areaHeight = area.height - size;
-    std::vector<int> xPositions;
-    std::vector<unsigned int> lineLengths;
+    ScratchMemory::Scope scratch;
+    ScratchVector<int>::type xPositions;
+    ScratchVector<unsigned int>::type lineLengths;
 
     getMeasurementInfo(text, area, size, justify, wrap, rightToLeft, &xPositions, &yPos, &lineLengths);
 
     int xPos = area.x;
-    std::vector<int>::const_iterator xPositionsIt = xPositions.begin();
+    ScratchVector<int>::type::const_iterator xPositionsIt = xPositions.begin();
     if (xPositionsIt != xPositions.end())
     {
         xPos = *xPositionsIt++;
@@ -1531,7 +1689,7 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
     unsigned int lineLength;
     unsigned int currentLineLength = 0;
     const char* lineStart;
-    std::vector<unsigned int>::const_iterator lineLengthsIt;
+    ScratchVector<unsigned int>::type::const_iterator lineLengthsIt;
     if (rightToLeft)
     {
         lineStart = token;
@@ -1617,15 +1775,13 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
             break;
         }
 
-        GP_ASSERT(_glyphs);
+        GP_ASSERT(_glyphs || _glyphCache);
         for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
         {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(&token[i]);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
+                const Glyph& g = *glyph;
 
                 if (xPos + (int)(g.width*scale) > area.x + area.width)
                 {
@@ -1733,7 +1889,7 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
 unsigned int Font::getTokenWidth(const char* token, unsigned int length, unsigned int size, float scale)
 {
     GP_ASSERT(token);
-    GP_ASSERT(_glyphs);
+    GP_ASSERT(_glyphs || _glyphCache);
 
     if (size == 0)
         size = _size;
@@ -1754,11 +1910,10 @@ unsigned int Font::getTokenWidth(const char* token, unsigned int length, unsigne
             tokenWidth += (size >> 1)*4;
             break;
         default:
-            int glyphIndex = c - 32;
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(&token[i]);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
-                tokenWidth += floor(g.width * scale + spacing);
+                tokenWidth += floor(glyph->width * scale + spacing);
             }
             break;
         }
@@ -1792,7 +1947,7 @@ unsigned int Font::getReversedTokenLength(const char* token, const char* bufStar
 }
 
 int Font::handleDelimiters(const char** token, const unsigned int size, const int iteration, const int areaX, int* xPos, int* yPos, unsigned int* lineLength,
-                          std::vector<int>::const_iterator* xPositionsIt, std::vector<int>::const_iterator xPositionsEnd, unsigned int* charIndex,
+                          ScratchVector<int>::type::const_iterator* xPositionsIt, ScratchVector<int>::type::const_iterator xPositionsEnd, unsigned int* charIndex,
                           const Vector2* stopAtPosition, const int currentIndex, const int destIndex)
 {
     GP_ASSERT(token);
@@ -1875,7 +2030,7 @@ int Font::handleDelimiters(const char** token, const unsigned int size, const in
 }
 
 void Font::addLineInfo(const Rectangle& area, int lineWidth, int lineLength, Justify hAlign,
-                       std::vector<int>* xPositions, std::vector<unsigned int>* lineLengths, bool rightToLeft)
+                       ScratchVector<int>::type* xPositions, ScratchVector<unsigned int>::type* lineLengths, bool rightToLeft)
 {
     int hWhitespace = area.width - lineWidth;
     if (hAlign == ALIGN_HCENTER)
@@ -1981,9 +2136,10 @@ Font::Justify Font::getJustify(const char* justify)
     return Font::ALIGN_TOP_LEFT;
 }
 
-Font::Text::Text(const char* text) : _text(text ? text : ""), _vertexCount(0), _vertices(NULL), _indexCount(0), _indices(NULL), _font(NULL)
+Font::Text::Text(const char* text) : _text(text ? text : ""), _vertexCount(0), _vertices(NULL), _indexCount(0), _indices(NULL), _font(NULL),
+    _size(0), _justify(ALIGN_TOP_LEFT), _wrap(true), _rightToLeft(false), _clipped(false), _generation(0)
 {
-    const size_t length = strlen(text);
+    const size_t length = std::max(_text.length(), (size_t)1);
     _vertices = new SpriteBatch::SpriteVertex[length * 4];
     _indices = new unsigned short[((length - 1) * 6) + 4];
 }
@@ -2,17 +2,25 @@
 #define FONT_H_
 
 #include "SpriteBatch.h"
+#include "ScratchMemory.h"
 
 namespace gameplay
 {
 
+class GlyphCache;
+
 /**
  * Defines a font for text rendering.
+ *
+ * Text is encoded in UTF-8. Fonts loaded from bundles hold the glyphs baked by the encoder,
+ * while fonts created with createDynamic() rasterize the glyphs of a font file as they are
+ * first drawn, for character sets too large to bake.
  */
 class Font : public Ref
 {
     friend class Bundle;
     friend class TextBox;
+    friend class GlyphCache;
 
 public:
 
@@ -102,6 +110,14 @@ public:
         unsigned short* _indices;
         Vector4 _color;
         Font* _font;
+        Rectangle _area;
+        unsigned int _size;
+        Justify _justify;
+        bool _wrap;
+        bool _rightToLeft;
+        bool _clipped;
+        Rectangle _clip;
+        unsigned int _generation;
     };
 
     /**
@@ -122,6 +138,27 @@ public:
      */
     static Font* create(const char* path, const char* id = NULL);
 
+    /**
+     * Creates a font that rasterizes the glyphs of a TrueType or OpenType font file at runtime.
+     *
+     * Only the glyphs that are drawn are rasterized, on a worker thread, into a texture that
+     * reuses the cells of the glyphs drawn least recently when it is full. This suits character
+     * sets too large to bake into a bundle, such as CJK. A glyph appears once it is rasterized,
+     * usually on the frame after it is first drawn. The texture should be large enough to hold
+     * the glyphs drawn between two calls to finish(); the glyphs that do not fit are left out.
+     *
+     * This requires the engine to be built with USE_FREETYPE defined and linked with FreeType;
+     * otherwise NULL is returned.
+     *
+     * @param path The path of the font file.
+     * @param size The size of the glyphs, in pixels.
+     * @param textureSize The width and height of the glyph texture.
+     *
+     * @return The new Font or NULL if there was an error.
+     * @script{create}
+     */
+    static Font* createDynamic(const char* path, unsigned int size, unsigned int textureSize = 1024);
+
     /**
      * Gets the font size (max height of glyphs) in pixels, at the specified index.
      *
@@ -226,6 +263,30 @@ public:
     Text* createText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size = 0,
                      Justify justify = ALIGN_TOP_LEFT, bool wrap = true, bool rightToLeft = false, const Rectangle* clip = NULL);
 
+    /**
+     * Returns a Text object for the given string and layout, reusing an existing one if possible.
+     *
+     * If 'text' was created for the same string, color and layout parameters it is returned
+     * unchanged. Otherwise it is deleted and a new Text object is created. This lets callers
+     * that draw the same string every frame keep the computed vertices between frames and only
+     * lay the text out again when it changes.
+     *
+     * @param text The Text object from a previous call, or NULL.
+     * @param str The text to draw.
+     * @param area The viewport area to draw within.  Text will be clipped outside this rectangle.
+     * @param color The color of text.
+     * @param size The size to draw text (0 for default size).
+     * @param justify Justification of text within the viewport.
+     * @param wrap Wraps text to fit within the width of the viewport if true.
+     * @param rightToLeft Whether to draw text from right to left.
+     * @param clip A region to clip text within after applying justification to the viewport area.
+     *
+     * @return A Text object for the string, owned by the caller.
+     * @script{ignore}
+     */
+    Text* updateText(Text* text, const char* str, const Rectangle& area, const Vector4& color, unsigned int size = 0,
+                     Justify justify = ALIGN_TOP_LEFT, bool wrap = true, bool rightToLeft = false, const Rectangle* clip = NULL);
+
     /**
      * Finishes text batching for this font and renders all drawn text.
      */
@@ -372,7 +433,7 @@ private:
     static Font* create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture, Font::Format format);
 
     void getMeasurementInfo(const char* text, const Rectangle& area, unsigned int size, Justify justify, bool wrap, bool rightToLeft,
-                            std::vector<int>* xPositions, int* yPosition, std::vector<unsigned int>* lineLengths);
+                            ScratchVector<int>::type* xPositions, int* yPosition, ScratchVector<unsigned int>::type* lineLengths);
 
     int getIndexOrLocation(const char* text, const Rectangle& clip, unsigned int size, const Vector2& inLocation, Vector2* outLocation,
                            const int destIndex = -1, Justify justify = ALIGN_TOP_LEFT, bool wrap = true, bool rightToLeft = false);
@@ -382,14 +443,25 @@ private:
     unsigned int getReversedTokenLength(const char* token, const char* bufStart);
 
     int handleDelimiters(const char** token, const unsigned int size, const int iteration, const int areaX, int* xPos, int* yPos, unsigned int* lineLength,
-                         std::vector<int>::const_iterator* xPositionsIt, std::vector<int>::const_iterator xPositionsEnd, unsigned int* charIndex = NULL,
+                         ScratchVector<int>::type::const_iterator* xPositionsIt, ScratchVector<int>::type::const_iterator xPositionsEnd, unsigned int* charIndex = NULL,
                          const Vector2* stopAtPosition = NULL, const int currentIndex = -1, const int destIndex = -1);
 
     void addLineInfo(const Rectangle& area, int lineWidth, int lineLength, Justify hAlign,
-                     std::vector<int>* xPositions, std::vector<unsigned int>* lineLengths, bool rightToLeft);
+                     ScratchVector<int>::type* xPositions, ScratchVector<unsigned int>::type* lineLengths, bool rightToLeft);
 
     Font* findClosestSize(int size);
 
+    /**
+     * Returns the index of the glyph for the given character code, or -1 if the font has no such glyph.
+     */
+    int getGlyphIndex(unsigned int code) const;
+
+    /**
+     * Returns the glyph of the UTF-8 character starting at the given byte, or NULL if the font has no
+     * such glyph or the byte continues a character.
+     */
+    const Glyph* getGlyph(const char* text) const;
+
     void lazyStart();
 
     Format _format;
@@ -402,7 +474,10 @@ private:
     float _spacing;
     Glyph* _glyphs;
     unsigned int _glyphCount;
+    unsigned int _glyphCodeBase;
+    std::vector<int> _glyphIndices; // glyph index of each character code from _glyphCodeBase, or -1
     Texture* _texture;
+    GlyphCache* _glyphCache;
     SpriteBatch* _batch;
     Rectangle _viewport;
     MaterialParameter* _cutoffParam;
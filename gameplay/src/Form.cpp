@@ -9,6 +9,9 @@
 #include "Button.h"
 #include "CheckBox.h"
 #include "Scene.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include "CommandBuffer.h"
 
 // Scroll speed when using a DPad -- max scroll speed when using a joystick.
 static const float GAMEPAD_SCROLL_SPEED = 500.0f;
@@ -16,6 +19,11 @@ static const float GAMEPAD_SCROLL_SPEED = 500.0f;
 static const float JOYSTICK_THRESHOLD = 0.75f;
 // If the DPad or joystick is held down, this is the initial delay in milliseconds between focus changes.
 static const float GAMEPAD_FOCUS_REPEAT_DELAY = 300.0f;
+// Default number of controls outside of the visible area of their container laid out each frame.
+static const unsigned int LAYOUT_BUDGET = 64;
+// Size of the cells of the grid used to find the control under a pointer, and the most cells along each side.
+static const float HIT_GRID_CELL_SIZE = 64.0f;
+static const unsigned int HIT_GRID_MAX_CELLS = 64;
 
 // Shaders used for drawing offscreen quad when form is attached to a node
 #define FORM_VSH "res/shaders/sprite.vert"
@@ -28,6 +36,8 @@ static std::vector<Form*> __forms;
 static Control* __focusControl = NULL;
 static Control* __activeControl[Touch::MAX_TOUCH_POINTS];
 static bool __shiftKeyDown = false;
+static unsigned int __layoutBudget = LAYOUT_BUDGET;
+static unsigned int __layoutBudgetRemaining = LAYOUT_BUDGET;
 
 /**
  * Static initializer for forms.
@@ -42,7 +52,8 @@ struct FormInit
 };
 static FormInit __init;
 
-Form::Form() : _node(NULL), _batched(true)
+Form::Form() : _node(NULL), _batchDrawCalls(0), _batched(true), _cached(false), _cacheBuffer(NULL), _cacheBatch(NULL),
+    _hitColumns(1), _hitRows(1), _hitGridDirty(true)
 {
 }
 
@@ -54,10 +65,14 @@ Form::~Form()
     {
         __forms.erase(it);
     }
+
+    SAFE_DELETE(_cacheBatch);
+    SAFE_RELEASE(_cacheBuffer);
 }
 
 Form* Form::create(const char* url)
 {
+    MemoryTracker::Scope scope(MemoryTracker::UI);
     Form* form = new Form();
 
     // Load Form from .form file.
@@ -102,6 +117,7 @@ Form* Form::create(const char* url)
     }
 
     form->_batched = formProperties->getBool("batchingEnabled", true);
+    form->_cached = formProperties->getBool("cachingEnabled", false);
 
     // Initialize the form and all of its child controls
     form->initialize("Form", style, formProperties);
@@ -210,17 +226,67 @@ void Form::update(float elapsedTime)
         updateBoundsInternal(Vector2::zero());
 }
 
-void Form::startBatch(SpriteBatch* batch)
+// Determines if two rectangles share any area (touching edges do not count).
+static bool overlaps(const Rectangle& a, const Rectangle& b)
 {
-    // TODO (note: might want to pass a level number/depth here so that batch draw calls can be sorted correctly, such as all text on top)
-    if (!batch->isStarted())
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+void Form::startBatch(SpriteBatch* batch, const Rectangle& bounds)
+{
+    if (!_batched)
     {
-        batch->setProjectionMatrix(_projectionMatrix);
-        batch->start();
+        if (!batch->isStarted())
+        {
+            batch->setProjectionMatrix(_projectionMatrix);
+            batch->start();
+        }
+        return;
+    }
 
-        if (_batched)
-            _batches.push_back(batch);
+    // Sprites are drawn when their batch is flushed, so they can only join a batch that was
+    // queued earlier if no batch queued after it has drawn where they go.
+    std::vector<SpriteBatch*>::iterator itr = std::find(_batches.begin(), _batches.end(), batch);
+    if (itr != _batches.end())
+    {
+        unsigned int index = (unsigned int)(itr - _batches.begin());
+        for (size_t i = 0, count = _batchRegions.size(); i < count; ++i)
+        {
+            if (_batchRegions[i].first > index && overlaps(_batchRegions[i].second, bounds))
+            {
+                _batchDrawCalls += flushBatches();
+                itr = _batches.end();
+                break;
+            }
+        }
     }
+
+    unsigned int index;
+    if (itr == _batches.end())
+    {
+        if (!batch->isStarted())
+        {
+            batch->setProjectionMatrix(_projectionMatrix);
+            batch->start();
+        }
+        index = (unsigned int)_batches.size();
+        _batches.push_back(batch);
+    }
+    else
+    {
+        index = (unsigned int)(itr - _batches.begin());
+    }
+    _batchRegions.push_back(std::make_pair(index, bounds));
+}
+
+unsigned int Form::flushBatches()
+{
+    unsigned int batchCount = (unsigned int)_batches.size();
+    for (unsigned int i = 0; i < batchCount; ++i)
+        _batches[i]->finish();
+    _batches.clear();
+    _batchRegions.clear();
+    return batchCount;
 }
 
 void Form::finishBatch(SpriteBatch* batch)
@@ -238,6 +304,8 @@ const Matrix& Form::getProjectionMatrix() const
 
 unsigned int Form::draw()
 {
+    GP_PROFILE_SCOPE("Form::draw");
+
     if (!_visible || _absoluteClipBounds.width == 0 || _absoluteClipBounds.height == 0)
         return 0;
 
@@ -264,22 +332,109 @@ unsigned int Form::draw()
         Matrix::createOrthographicOffCenter(0, viewport.width, viewport.height, 0, 0, 1, &_projectionMatrix);
     }
 
-    // Draw the form
+    // Draw the form. The frame buffer of the cache can't be bound by a recorded frame, so recorded forms draw
+    // their controls directly, and their cache is drawn again in full the next time it is used.
+    if (_cached && !_node)
+    {
+        if (!CommandBuffer::getRecording())
+            return drawCached();
+        addDirtyRegion(_absoluteClipBounds);
+    }
+    return drawControls();
+}
+
+unsigned int Form::drawControls()
+{
+    _batchDrawCalls = 0;
     unsigned int drawCalls = Container::draw(this, _absoluteClipBounds);
 
     // Flush all batches that were queued during drawing and then empty the batch list
     if (_batched)
     {
-        unsigned int batchCount = _batches.size();
-        for (unsigned int i = 0; i < batchCount; ++i)
-            _batches[i]->finish();
-        _batches.clear();
-        drawCalls = batchCount;
+        drawCalls = _batchDrawCalls + flushBatches();
     }
 
     return drawCalls;
 }
 
+unsigned int Form::drawCached()
+{
+    Game* game = Game::getInstance();
+    const Rectangle& bounds = _absoluteClipBounds;
+    unsigned int width = nextPowerOfTwo((unsigned int)ceil(bounds.width));
+    unsigned int height = nextPowerOfTwo((unsigned int)ceil(bounds.height));
+
+    // (Re)create the frame buffer when the form changes size.
+    if (_cacheBuffer == NULL || _cacheBuffer->getWidth() != width || _cacheBuffer->getHeight() != height)
+    {
+        SAFE_DELETE(_cacheBatch);
+        SAFE_RELEASE(_cacheBuffer);
+        _cacheBuffer = FrameBuffer::create(_id.c_str(), width, height);
+        if (_cacheBuffer == NULL)
+        {
+            GP_WARN("Failed to create frame buffer for form '%s'; drawing it uncached.", _id.c_str());
+            _cached = false;
+            return drawControls();
+        }
+        _cacheBatch = SpriteBatch::create(_cacheBuffer->getRenderTarget()->getTexture());
+        GP_ASSERT(_cacheBatch && _cacheBatch->getStateBlock());
+
+        // The frame buffer colors are already multiplied by their alpha.
+        _cacheBatch->getStateBlock()->setBlendSrc(RenderState::BLEND_ONE);
+        _cacheBatch->getStateBlock()->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
+        _dirtyRegion = bounds;
+    }
+
+    unsigned int drawCalls = 0;
+    Rectangle region;
+    if (!_dirtyRegion.isEmpty() && Rectangle::intersect(_dirtyRegion, bounds, &region))
+    {
+        GP_PROFILE_SCOPE("Form::drawCached");
+
+        Rectangle viewport(game->getViewport());
+        FrameBuffer* previousBuffer = _cacheBuffer->bind();
+        game->setViewport(Rectangle(0, 0, width, height));
+
+        // Map the form bounds to the top left of the frame buffer, and only touch the pixels of the dirty region.
+        Matrix::createOrthographicOffCenter(bounds.x, bounds.x + width, bounds.y + height, bounds.y, 0, 1, &_projectionMatrix);
+        float left = floor(region.x - bounds.x);
+        float top = floor(region.y - bounds.y);
+        float right = ceil(region.right() - bounds.x);
+        float bottom = ceil(region.bottom() - bounds.y);
+        GL_ASSERT( glEnable(GL_SCISSOR_TEST) );
+        GL_ASSERT( glScissor((GLint)left, (GLint)(height - bottom), (GLsizei)(right - left), (GLsizei)(bottom - top)) );
+        game->clear(Game::CLEAR_COLOR, Vector4::zero(), 1, 0);
+
+        drawCalls = drawControls();
+
+        GL_ASSERT( glDisable(GL_SCISSOR_TEST) );
+        previousBuffer->bind();
+        game->setViewport(viewport);
+    }
+    _dirtyRegion.set(0, 0, 0, 0);
+
+    // Draw the cached form as a single quad.
+    const Rectangle& viewport = game->getViewport();
+    Matrix::createOrthographicOffCenter(0, viewport.width, viewport.height, 0, 0, 1, &_projectionMatrix);
+    _cacheBatch->setProjectionMatrix(_projectionMatrix);
+    _cacheBatch->start();
+    _cacheBatch->draw(bounds.x, bounds.y, bounds.width, bounds.height, 0.0f, 1.0f, bounds.width / width, 1.0f - bounds.height / height, Vector4::one());
+    _cacheBatch->finish();
+
+    return drawCalls + 1;
+}
+
+void Form::addDirtyRegion(const Rectangle& region)
+{
+    if (region.width <= 0 || region.height <= 0)
+        return;
+
+    if (_dirtyRegion.isEmpty())
+        _dirtyRegion = region;
+    else
+        Rectangle::combine(_dirtyRegion, region, &_dirtyRegion);
+}
+
 const char* Form::getType() const
 {
     return "form";
@@ -296,10 +451,49 @@ void Form::setBatchingEnabled(bool enabled)
     _batched = enabled;
 }
 
+unsigned int Form::getLayoutBudget()
+{
+    return __layoutBudget;
+}
+
+void Form::setLayoutBudget(unsigned int budget)
+{
+    __layoutBudget = budget;
+}
+
+bool Form::consumeLayoutBudget()
+{
+    if (__layoutBudgetRemaining == 0)
+        return false;
+    --__layoutBudgetRemaining;
+    return true;
+}
+
+bool Form::isCachingEnabled() const
+{
+    return _cached;
+}
+
+void Form::setCachingEnabled(bool enabled)
+{
+    if (_cached != enabled)
+    {
+        _cached = enabled;
+        if (!_cached)
+        {
+            SAFE_DELETE(_cacheBatch);
+            SAFE_RELEASE(_cacheBuffer);
+        }
+        _dirtyRegion = _absoluteClipBounds;
+    }
+}
+
 void Form::updateInternal(float elapsedTime)
 {
     pollGamepads();
 
+    __layoutBudgetRemaining = __layoutBudget;
+
     for (size_t i = 0, size = __forms.size(); i < size; ++i)
     {
         Form* form = __forms[i];
@@ -353,7 +547,7 @@ Control* Form::findInputControl(int* x, int* y, bool focus, unsigned int contact
             continue;
 
         // Search for an input control within this form
-        Control* ctrl = findInputControl(form, formX, formY, focus, contactIndex);
+        Control* ctrl = form->findHitControl(formX, formY, focus);
         if (ctrl)
         {
             *x = formX;
@@ -370,35 +564,161 @@ Control* Form::findInputControl(int* x, int* y, bool focus, unsigned int contact
     return NULL;
 }
 
-Control* Form::findInputControl(Control* control, int x, int y, bool focus, unsigned int contactIndex)
+Control* Form::findHitControl(int x, int y, bool focus)
 {
-    if (!(control->_visible && control->isEnabled()))
-        return NULL;
+    if (_hitGridDirty)
+        buildHitGrid();
 
-    Control* result = NULL;
+    unsigned int column, row, lastColumn, lastRow;
+    getHitCells(Rectangle((float)x, (float)y, 0, 0), &column, &row, &lastColumn, &lastRow);
+    const std::vector<Control*>& cell = _hitCells[row * _hitColumns + column];
 
-    // Does the passed in control's bounds intersect the specified coordinates - and 
-    // does the control support the specified input state?
-    if (control->_consumeInputEvents && (!focus || control->canFocus()))
+    // The controls of the cell are in drawing order, so the first match from the end is the topmost.
+    for (size_t i = cell.size(); i > 0; --i)
     {
-        if (control->_absoluteClipBounds.contains(x, y))
-            result = control;
+        Control* control = cell[i - 1];
+        if (!control->_consumeInputEvents || (focus && !control->canFocus()) || !control->_absoluteClipBounds.contains(x, y))
+            continue;
+
+        Control* parent = control;
+        while (parent && parent->_visible && parent->isEnabled())
+        {
+            parent = parent->_parent;
+        }
+        if (parent == NULL)
+            return control;
+    }
+
+    return NULL;
+}
+
+void Form::buildHitGrid()
+{
+    _hitBounds = _absoluteBounds;
+    _hitColumns = std::min(std::max((unsigned int)ceilf(_hitBounds.width / HIT_GRID_CELL_SIZE), 1u), HIT_GRID_MAX_CELLS);
+    _hitRows = std::min(std::max((unsigned int)ceilf(_hitBounds.height / HIT_GRID_CELL_SIZE), 1u), HIT_GRID_MAX_CELLS);
+
+    _hitCells.clear();
+    _hitCells.resize(_hitColumns * _hitRows);
+    _hitEntries.clear();
+
+    unsigned int order = 0;
+    addToHitGrid(this, order);
+    _hitGridDirty = false;
+}
+
+void Form::addToHitGrid(Control* control, unsigned int& order)
+{
+    HitEntry& entry = _hitEntries[control];
+    entry.order = order++;
+    entry.placed = !control->_absoluteClipBounds.isEmpty();
+    if (entry.placed)
+    {
+        // Controls are added in drawing order, so the cells stay sorted.
+        getHitCells(control->_absoluteClipBounds, &entry.x0, &entry.y0, &entry.x1, &entry.y1);
+        for (unsigned int y = entry.y0; y <= entry.y1; ++y)
+        {
+            for (unsigned int x = entry.x0; x <= entry.x1; ++x)
+            {
+                _hitCells[y * _hitColumns + x].push_back(control);
+            }
+        }
     }
 
-    // If the control has children, search for an input control inside it that also
-    // supports the above conditions.
     if (control->isContainer())
     {
         Container* container = static_cast<Container*>(control);
-        for (unsigned int i = 0, childCount = container->getControlCount(); i < childCount; ++i)
+        for (unsigned int i = 0, count = container->getControlCount(); i < count; ++i)
         {
-            Control* ctrl = findInputControl(container->getControl(i), x, y, focus, contactIndex);
-            if (ctrl)
-                result = ctrl;
+            addToHitGrid(container->getControl(i), order);
         }
     }
+}
+
+void Form::updateHitGrid(Control* control)
+{
+    if (_hitGridDirty)
+        return;
+
+    // The grid covers the bounds of the form, and new controls have no place in the drawing order yet.
+    std::map<Control*, HitEntry>::iterator itr = _hitEntries.find(control);
+    if (control == this || itr == _hitEntries.end())
+    {
+        invalidateHitGrid();
+        return;
+    }
 
-    return result;
+    HitEntry& entry = itr->second;
+    bool placed = !control->_absoluteClipBounds.isEmpty();
+    unsigned int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (placed)
+    {
+        getHitCells(control->_absoluteClipBounds, &x0, &y0, &x1, &y1);
+        if (entry.placed && x0 == entry.x0 && y0 == entry.y0 && x1 == entry.x1 && y1 == entry.y1)
+            return;
+    }
+    else if (!entry.placed)
+    {
+        return;
+    }
+
+    if (entry.placed)
+    {
+        for (unsigned int y = entry.y0; y <= entry.y1; ++y)
+        {
+            for (unsigned int x = entry.x0; x <= entry.x1; ++x)
+            {
+                std::vector<Control*>& cell = _hitCells[y * _hitColumns + x];
+                cell.erase(std::find(cell.begin(), cell.end(), control));
+            }
+        }
+    }
+
+    entry.placed = placed;
+    if (placed)
+    {
+        entry.x0 = x0;
+        entry.y0 = y0;
+        entry.x1 = x1;
+        entry.y1 = y1;
+        for (unsigned int y = y0; y <= y1; ++y)
+        {
+            for (unsigned int x = x0; x <= x1; ++x)
+            {
+                // Insert the control after the controls drawn before it.
+                std::vector<Control*>& cell = _hitCells[y * _hitColumns + x];
+                std::vector<Control*>::iterator position = cell.begin();
+                while (position != cell.end() && _hitEntries[*position].order < entry.order)
+                {
+                    ++position;
+                }
+                cell.insert(position, control);
+            }
+        }
+    }
+}
+
+void Form::invalidateHitGrid()
+{
+    if (!_hitGridDirty)
+    {
+        _hitGridDirty = true;
+        _hitCells.clear();
+        _hitEntries.clear();
+    }
+}
+
+void Form::getHitCells(const Rectangle& bounds, unsigned int* x0, unsigned int* y0, unsigned int* x1, unsigned int* y1) const
+{
+    // Bounds outside the grid are clamped to its edge cells, which the exact bounds test of the hit test sorts out.
+    float columnWidth = std::max(_hitBounds.width / _hitColumns, 1.0f);
+    float rowHeight = std::max(_hitBounds.height / _hitRows, 1.0f);
+    int maxColumn = (int)_hitColumns - 1;
+    int maxRow = (int)_hitRows - 1;
+    *x0 = (unsigned int)std::min(std::max((int)floorf((bounds.x - _hitBounds.x) / columnWidth), 0), maxColumn);
+    *y0 = (unsigned int)std::min(std::max((int)floorf((bounds.y - _hitBounds.y) / rowHeight), 0), maxRow);
+    *x1 = (unsigned int)std::min(std::max((int)floorf((bounds.right() - _hitBounds.x) / columnWidth), 0), maxColumn);
+    *y1 = (unsigned int)std::min(std::max((int)floorf((bounds.bottom() - _hitBounds.y) / rowHeight), 0), maxRow);
 }
 
 Control* Form::handlePointerPressRelease(int* x, int* y, bool pressed, unsigned int contactIndex)
@@ -645,29 +965,44 @@ bool Form::pointerEventInternal(bool mouse, int evt, int x, int y, int param)
             if (mouse)
             {
                 if (ctrl->mouseEvent((Mouse::MouseEvent)evt, localX, localY, param))
+                {
+                    ctrl->invalidate();
                     return true;
+                }
 
                 // Forward to touch event hanlder if unhandled by mouse handler
                 switch (evt)
                 {
                 case Mouse::MOUSE_PRESS_LEFT_BUTTON:
                     if (ctrl->touchEvent(Touch::TOUCH_PRESS, localX, localY, 0))
+                    {
+                        ctrl->invalidate();
                         return true;
+                    }
                     break;
                 case Mouse::MOUSE_RELEASE_LEFT_BUTTON:
                     if (ctrl->touchEvent(Touch::TOUCH_RELEASE, localX, localY, 0))
+                    {
+                        ctrl->invalidate();
                         return true;
+                    }
                     break;
                 case Mouse::MOUSE_MOVE:
                     if (ctrl->touchEvent(Touch::TOUCH_MOVE, localX, localY, 0))
+                    {
+                        ctrl->invalidate();
                         return true;
+                    }
                     break;
                 }
             }
             else
             {
                 if (ctrl->touchEvent((Touch::TouchEvent)evt, localX, localY, contactIndex))
+                {
+                    ctrl->invalidate();
                     return true;
+                }
             }
 
             // Handle container scrolling
@@ -768,7 +1103,10 @@ bool Form::keyEventInternal(Keyboard::KeyEvent evt, int key)
         if (ctrl->isEnabled() && ctrl->isVisible())
         {
             if (ctrl->keyEvent(evt, key))
+            {
+                ctrl->invalidate();
                 return true;
+            }
         }
 
         ctrl = ctrl->getParent();
@@ -954,7 +1292,10 @@ bool Form::gamepadEventInternal(Gamepad::GamepadEvent evt, Gamepad* gamepad, uns
         if (ctrl->isEnabled() && ctrl->isVisible())
         {
             if (ctrl->gamepadEvent(evt, gamepad, analogIndex))
+            {
+                ctrl->invalidate();
                 return true;
+            }
         }
 
         ctrl = ctrl->getParent();
@@ -30,6 +30,7 @@ class Form : public Container
     friend class Gamepad;
     friend class Control;
     friend class Container;
+    friend class Container;
 
 public:
 
@@ -143,6 +144,48 @@ public:
      */
     void setBatchingEnabled(bool enabled);
 
+    /**
+     * Determines whether this form caches its rendered output.
+     *
+     * @return True if caching is enabled for this form, false otherwise.
+     */
+    bool isCachingEnabled() const;
+
+    /**
+     * Turns caching of the rendered output of this form on or off.
+     *
+     * A cached form is rendered into an offscreen frame buffer that is drawn to the screen
+     * as a single quad. Only the areas of the controls that changed since the last frame
+     * (see Control::invalidate) are redrawn into the frame buffer, which makes caching a
+     * good fit for menus and HUD panels that rarely change. Caching only applies to forms
+     * that are not attached to a node.
+     *
+     * Translucent areas of a cached form may blend slightly differently than when drawn
+     * directly, since the frame buffer stores the blended alpha of overlapping controls.
+     *
+     * @param enabled True to enable caching, false otherwise (default).
+     */
+    void setCachingEnabled(bool enabled);
+
+    /**
+     * Returns the number of controls outside of the visible area of their container that can be laid out each frame.
+     *
+     * @return The layout budget.
+     */
+    static unsigned int getLayoutBudget();
+
+    /**
+     * Sets the number of controls outside of the visible area of their container that can be laid out each frame.
+     *
+     * Only controls with dirty bounds and their ancestors are laid out. Of those, controls that
+     * are scrolled or clipped out of view are laid out progressively, at most this many per frame
+     * across all forms, so that large scrolling lists do not stall a frame. Visible controls are
+     * always laid out immediately.
+     *
+     * @param budget The layout budget (default is 64).
+     */
+    static void setLayoutBudget(unsigned int budget);
+
 private:
     
     /**
@@ -217,8 +260,50 @@ private:
 
     /**
      * Called during drawing to prepare a sprite batch for being drawn into for this form.
+     *
+     * When batching is enabled, the sprites of each batch are accumulated and drawn together
+     * at the end of the form. The batches queued so far are flushed first if the new sprites
+     * would end up under sprites of a batch queued later that they overlap.
+     *
+     * @param batch The sprite batch to be drawn into.
+     * @param bounds The area the sprites will be drawn within.
+     */
+    void startBatch(SpriteBatch* batch, const Rectangle& bounds);
+
+    /**
+     * Draws the queued batches in the order they were started.
+     *
+     * @return The number of batches drawn.
+     */
+    unsigned int flushBatches();
+
+    /**
+     * Draws the controls of this form using the current projection matrix.
+     *
+     * @return The number of draw calls issued.
+     */
+    unsigned int drawControls();
+
+    /**
+     * Takes one control from the layout budget of the current frame.
+     *
+     * @return True if the control can be laid out, false if the budget is spent.
+     */
+    static bool consumeLayoutBudget();
+
+    /**
+     * Redraws the dirty region of this form into its frame buffer and draws the frame buffer to the screen.
+     *
+     * @return The number of draw calls issued.
+     */
+    unsigned int drawCached();
+
+    /**
+     * Adds an area, in viewport coordinates, that must be redrawn into the frame buffer of a cached form.
+     *
+     * @param region The area to redraw.
      */
-    void startBatch(SpriteBatch* batch);
+    void addDirtyRegion(const Rectangle& region);
 
     /**
      * Called during drawing to signal completion of drawing into a batch.
@@ -242,7 +327,41 @@ private:
 
     static Control* findInputControl(int* x, int* y, bool focus, unsigned int contactIndex);
 
-    static Control* findInputControl(Control* control, int x, int y, bool focus, unsigned int contactIndex);
+    /**
+     * Finds the control of this form that receives input at a point, using the hit-testing grid.
+     *
+     * This is the last control in drawing order whose clipped bounds contain the point, that
+     * consumes input events (and can take focus if focus is true), and that is visible and
+     * enabled along with all of its ancestors.
+     */
+    Control* findHitControl(int x, int y, bool focus);
+
+    /**
+     * Places each control of this form in the cells of the hit-testing grid that its clipped bounds overlap.
+     */
+    void buildHitGrid();
+
+    /**
+     * Adds a control and its descendants to the hit-testing grid, in drawing order.
+     */
+    void addToHitGrid(Control* control, unsigned int& order);
+
+    /**
+     * Moves a control to the cells of the hit-testing grid overlapped by its new bounds.
+     *
+     * Called when the absolute bounds of a control of this form have been updated.
+     */
+    void updateHitGrid(Control* control);
+
+    /**
+     * Rebuilds the hit-testing grid before the next hit test. Called when controls are added, removed or reordered.
+     */
+    void invalidateHitGrid();
+
+    /**
+     * Returns the range of cells of the hit-testing grid overlapped by a rectangle, clamped to the grid.
+     */
+    void getHitCells(const Rectangle& bounds, unsigned int* x0, unsigned int* y0, unsigned int* x1, unsigned int* y1) const;
 
     static Control* handlePointerPressRelease(int* x, int* y, bool pressed, unsigned int contactIndex);
 
@@ -263,7 +382,30 @@ private:
     Node* _node;                        // Node for transforming this Form in world-space.
     Matrix _projectionMatrix;           // Projection matrix to be set on SpriteBatch objects when rendering the form
     std::vector<SpriteBatch*> _batches;
+    std::vector<std::pair<unsigned int, Rectangle> > _batchRegions; // Areas drawn into each queued batch, in drawing order
+    unsigned int _batchDrawCalls;
     bool _batched;
+    bool _cached;
+    FrameBuffer* _cacheBuffer;
+    SpriteBatch* _cacheBatch;
+    Rectangle _dirtyRegion;
+
+    /**
+     * Defines the place of a control in the hit-testing grid.
+     */
+    struct HitEntry
+    {
+        unsigned int order;             // Index of the control in drawing order.
+        bool placed;                    // If the control has non-empty bounds and is in the cells below.
+        unsigned int x0, y0, x1, y1;    // Range of cells the control is in.
+    };
+
+    std::vector<std::vector<Control*> > _hitCells;  // Controls overlapping each cell, in drawing order.
+    std::map<Control*, HitEntry> _hitEntries;
+    Rectangle _hitBounds;               // Area covered by the grid (the absolute bounds of the form).
+    unsigned int _hitColumns;
+    unsigned int _hitRows;
+    bool _hitGridDirty;
 };
 
 }
@@ -13,7 +13,7 @@ FrameBuffer* FrameBuffer::_defaultFrameBuffer = NULL;
 FrameBuffer* FrameBuffer::_currentFrameBuffer = NULL;
 
 FrameBuffer::FrameBuffer(const char* id, unsigned int width, unsigned int height, FrameBufferHandle handle) 
-    : _id(id ? id : ""), _handle(handle), _renderTargets(NULL), _renderTargetCount(0), _depthStencilTarget(NULL)
+    : GraphicsResource(RESTORE_ATTACHMENTS), _id(id ? id : ""), _handle(handle), _renderTargets(NULL), _renderTargetCount(0), _depthStencilTarget(NULL)
 {
 }
 
@@ -181,18 +181,25 @@ void FrameBuffer::setRenderTarget(RenderTarget* target, unsigned int index)
         target->addRef();
 
         // Now set this target as the color attachment corresponding to index.
-        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _handle) );
-        GLenum attachment = GL_COLOR_ATTACHMENT0 + index;
-        GL_ASSERT( glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, _renderTargets[index]->getTexture()->getHandle(), 0) );
-        GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
-        {
-            GP_ERROR("Framebuffer status incomplete: 0x%x", fboStatus);
-        }
+        attachRenderTarget(index);
+    }
+}
 
-        // Restore the FBO binding
-        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _currentFrameBuffer->_handle) );
+void FrameBuffer::attachRenderTarget(unsigned int index)
+{
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _handle) );
+    GLenum attachment = GL_COLOR_ATTACHMENT0 + index;
+    RenderTarget* target = _renderTargets[index];
+    GLenum textarget = target->getTexture()->getType() == Texture::TEXTURE_CUBE ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + target->getFace() : GL_TEXTURE_2D;
+    GL_ASSERT( glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, textarget, target->getTexture()->getHandle(), 0) );
+    GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
+    {
+        GP_ERROR("Framebuffer status incomplete: 0x%x", fboStatus);
     }
+
+    // Restore the FBO binding
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _currentFrameBuffer->_handle) );
 }
 
 RenderTarget* FrameBuffer::getRenderTarget(unsigned int index) const
@@ -225,29 +232,70 @@ void FrameBuffer::setDepthStencilTarget(DepthStencilTarget* target)
         // The FrameBuffer now owns this DepthStencilTarget.
         target->addRef();
 
-        // Now set this target as the color attachment corresponding to index.
-        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _handle) );
+        // Attach the render buffers of the target to the framebuffer.
+        attachDepthStencilTarget();
+    }
+}
 
-        // Attach the render buffer to the framebuffer
-        GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_depthBuffer) );
-        if (target->isPacked())
-        {
-            GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_depthBuffer) );
-        }
-        else if (target->getFormat() == DepthStencilTarget::DEPTH_STENCIL)
-        {
-            GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_stencilBuffer) );
-        }
+void FrameBuffer::attachDepthStencilTarget()
+{
+    GP_ASSERT(_depthStencilTarget);
 
-        // Check the framebuffer is good to go.
-        GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _handle) );
+
+    // Attach the render buffer to the framebuffer
+    GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_depthBuffer) );
+    if (_depthStencilTarget->isPacked())
+    {
+        GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_depthBuffer) );
+    }
+    else if (_depthStencilTarget->getFormat() == DepthStencilTarget::DEPTH_STENCIL)
+    {
+        GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthStencilTarget->_stencilBuffer) );
+    }
+
+    // Check the framebuffer is good to go.
+    GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
+    {
+        GP_ERROR("Framebuffer status incomplete: 0x%x", fboStatus);
+    }
+
+    // Restore the FBO binding
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _currentFrameBuffer->_handle) );
+}
+
+void FrameBuffer::discardGraphics()
+{
+    _handle = 0;
+}
+
+void FrameBuffer::restoreGraphics()
+{
+    if (isDefault())
+    {
+        // The new context may have a different default frame buffer, which is bound when it is made current.
+        GLint fbo;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+        _handle = (FrameBufferHandle)fbo;
+        _currentFrameBuffer = this;
+        return;
+    }
+
+    GL_ASSERT( glGenFramebuffers(1, &_handle) );
+
+    // Reattach the restored render targets and depth stencil target.
+    GP_ASSERT(_renderTargets);
+    for (unsigned int i = 0; i < _maxRenderTargets; ++i)
+    {
+        if (_renderTargets[i])
         {
-            GP_ERROR("Framebuffer status incomplete: 0x%x", fboStatus);
+            attachRenderTarget(i);
         }
-
-        // Restore the FBO binding
-        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _currentFrameBuffer->_handle) );
+    }
+    if (_depthStencilTarget)
+    {
+        attachDepthStencilTarget();
     }
 }
 
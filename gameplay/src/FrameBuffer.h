@@ -5,6 +5,7 @@
 #include "RenderTarget.h"
 #include "DepthStencilTarget.h"
 #include "Image.h"
+#include "GraphicsResource.h"
 
 namespace gameplay
 {
@@ -22,7 +23,7 @@ namespace gameplay
  *
  * To bind the default frame buffer, call FrameBuffer::bindDefault.
  */
-class FrameBuffer : public Ref
+class FrameBuffer : public Ref, private GraphicsResource
 {
     friend class Game;
 
@@ -206,6 +207,26 @@ private:
 
     static bool isPowerOfTwo(unsigned int value);
 
+    /**
+     * Attaches the texture of the render target at the given index to the frame buffer.
+     */
+    void attachRenderTarget(unsigned int index);
+
+    /**
+     * Attaches the render buffers of the depth stencil target to the frame buffer.
+     */
+    void attachDepthStencilTarget();
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     */
+    void restoreGraphics();
+
     std::string _id;
     FrameBufferHandle _handle;
     RenderTarget** _renderTargets;
@@ -0,0 +1,279 @@
+#include "Base.h"
+#include "FramePacer.h"
+#include "Game.h"
+#include "Thread.h"
+
+// The most frames the elapsed time can be averaged over.
+#define FRAME_PACER_MAX_SMOOTHING 16
+// The time before a deadline at which the pacer stops sleeping and yields instead, in milliseconds.
+#define FRAME_PACER_SPIN_TIME 1.5
+// The frames a frame must miss in a row before adaptive mode halves the frame rate.
+#define FRAME_PACER_DROP_FRAMES 15
+// The frames that must fit in the target interval in a row before adaptive mode restores the target rate.
+#define FRAME_PACER_RAISE_FRAMES 120
+// The share of the interval above which a frame counts as missing it.
+#define FRAME_PACER_DROP_LOAD 0.95f
+// The share of the target interval below which a frame counts as fitting in it.
+#define FRAME_PACER_RAISE_LOAD 0.7f
+// The frame rate while idle, by default.
+#define FRAME_PACER_IDLE_RATE 10
+// The time nothing must change for before going idle by default, in milliseconds.
+#define FRAME_PACER_IDLE_DELAY 500.0f
+
+namespace gameplay
+{
+
+static unsigned int __targetRate = 0;
+static unsigned int __pacedRate = 0;
+static bool __adaptive = false;
+static unsigned int __smoothing = 1;
+static float __intervals[FRAME_PACER_MAX_SMOOTHING];
+static unsigned int __intervalIndex = 0;
+static unsigned int __intervalCount = 0;
+static double __smoothingDebt = 0.0;
+static double __frameStart = 0.0;
+static double __deadline = 0.0;
+static double __sleepError = 0.0;
+static float __cpuTime = 0.0f;
+static float __frameInterval = 0.0f;
+static unsigned int __missedFrames = 0;
+static unsigned int __fittingFrames = 0;
+static bool __idleEnabled = false;
+static unsigned int __idleRate = FRAME_PACER_IDLE_RATE;
+static float __idleDelay = FRAME_PACER_IDLE_DELAY;
+static bool __idle = false;
+// Set by wake(), which transforms call from whichever thread moves them.
+static volatile bool __woken = true;
+static double __lastChange = 0.0;
+
+void FramePacer::setTargetFrameRate(unsigned int rate)
+{
+    __targetRate = rate;
+    __pacedRate = rate;
+    __missedFrames = 0;
+    __fittingFrames = 0;
+    __deadline = 0.0;
+}
+
+unsigned int FramePacer::getTargetFrameRate()
+{
+    return __targetRate;
+}
+
+unsigned int FramePacer::getPacedFrameRate()
+{
+    return __pacedRate;
+}
+
+void FramePacer::setAdaptive(bool adaptive)
+{
+    __adaptive = adaptive;
+    if (!adaptive)
+    {
+        __pacedRate = __targetRate;
+    }
+}
+
+bool FramePacer::isAdaptive()
+{
+    return __adaptive;
+}
+
+void FramePacer::setSmoothing(unsigned int frames)
+{
+    __smoothing = std::min(std::max(frames, 1u), (unsigned int)FRAME_PACER_MAX_SMOOTHING);
+    __intervalIndex = 0;
+    __intervalCount = 0;
+    __smoothingDebt = 0.0;
+}
+
+unsigned int FramePacer::getSmoothing()
+{
+    return __smoothing;
+}
+
+float FramePacer::getCpuTime()
+{
+    return __cpuTime;
+}
+
+float FramePacer::getGpuTime()
+{
+    return Game::getInstance()->getRenderStats().gpuTime;
+}
+
+float FramePacer::getFrameInterval()
+{
+    return __frameInterval;
+}
+
+void FramePacer::setIdleEnabled(bool enabled)
+{
+    __idleEnabled = enabled;
+    __idle = false;
+    __woken = true;
+}
+
+bool FramePacer::isIdleEnabled()
+{
+    return __idleEnabled;
+}
+
+void FramePacer::setIdleFrameRate(unsigned int rate)
+{
+    GP_ASSERT(rate > 0);
+    __idleRate = std::max(rate, 1u);
+}
+
+unsigned int FramePacer::getIdleFrameRate()
+{
+    return __idleRate;
+}
+
+void FramePacer::setIdleDelay(float delay)
+{
+    __idleDelay = std::max(delay, 0.0f);
+}
+
+float FramePacer::getIdleDelay()
+{
+    return __idleDelay;
+}
+
+bool FramePacer::isIdle()
+{
+    return __idle;
+}
+
+void FramePacer::wake()
+{
+    __woken = true;
+}
+
+bool FramePacer::updateIdle()
+{
+    if (!__idleEnabled)
+        return false;
+
+    double now = Game::getAbsoluteTime();
+    if (__woken)
+    {
+        __woken = false;
+        __lastChange = now;
+    }
+
+    // Keep drawing for a while after the last change, so that short pauses between changes don't stutter.
+    __idle = now - __lastChange >= __idleDelay;
+    return __idle;
+}
+
+void FramePacer::beginFrame()
+{
+    double time = Game::getAbsoluteTime();
+    if (__frameStart > 0.0)
+    {
+        __frameInterval = (float)(time - __frameStart);
+    }
+    __frameStart = time;
+}
+
+float FramePacer::smoothElapsedTime(float elapsedTime)
+{
+    if (__smoothing <= 1)
+        return elapsedTime;
+
+    __intervals[__intervalIndex] = elapsedTime;
+    __intervalIndex = (__intervalIndex + 1) % __smoothing;
+    __intervalCount = std::min(__intervalCount + 1, __smoothing);
+
+    float average = 0.0f;
+    for (unsigned int i = 0; i < __intervalCount; ++i)
+    {
+        average += __intervals[i];
+    }
+    average /= __intervalCount;
+
+    // Hand the time the average gained or lost out over the next frames, so game time keeps up with real time.
+    __smoothingDebt += elapsedTime - average;
+    float correction = (float)(__smoothingDebt / __smoothing);
+    __smoothingDebt -= correction;
+
+    return std::max(average + correction, 0.0f);
+}
+
+void FramePacer::endFrame()
+{
+    __cpuTime = (float)(Game::getAbsoluteTime() - __frameStart);
+
+    if (!__adaptive || __targetRate == 0)
+        return;
+
+    // The frame is bound by whichever of the processors took longer.
+    float work = std::max(__cpuTime, getGpuTime());
+    if (__pacedRate == __targetRate)
+    {
+        __missedFrames = work > FRAME_PACER_DROP_LOAD * 1000.0f / __pacedRate ? __missedFrames + 1 : 0;
+        if (__missedFrames >= FRAME_PACER_DROP_FRAMES && __targetRate > 1)
+        {
+            __pacedRate = __targetRate / 2;
+            __missedFrames = 0;
+            __fittingFrames = 0;
+        }
+    }
+    else
+    {
+        __fittingFrames = work < FRAME_PACER_RAISE_LOAD * 1000.0f / __targetRate ? __fittingFrames + 1 : 0;
+        if (__fittingFrames >= FRAME_PACER_RAISE_FRAMES)
+        {
+            __pacedRate = __targetRate;
+            __missedFrames = 0;
+            __fittingFrames = 0;
+        }
+    }
+}
+
+void FramePacer::wait()
+{
+    unsigned int rate = __pacedRate;
+    if (__idle)
+    {
+        rate = rate > 0 ? std::min(rate, __idleRate) : __idleRate;
+    }
+    if (rate == 0)
+    {
+        __deadline = 0.0;
+        return;
+    }
+
+    double now = Game::getAbsoluteTime();
+    double interval = 1000.0 / rate;
+    __deadline = __deadline > 0.0 ? __deadline + interval : now + interval;
+    if (__deadline <= now)
+    {
+        // The frame ran late, so start the next one right away without trying to catch up.
+        __deadline = now;
+        return;
+    }
+
+    // Sleep through most of the wait, keeping a margin for the time the system oversleeps.
+    double margin = std::max(FRAME_PACER_SPIN_TIME, __sleepError);
+    double remaining = __deadline - now;
+    if (remaining > margin)
+    {
+        unsigned int ms = (unsigned int)(remaining - margin);
+        if (ms > 0)
+        {
+            Thread::sleep(ms);
+            double oversleep = Game::getAbsoluteTime() - now - ms;
+            __sleepError = std::max(oversleep, __sleepError * 0.95);
+        }
+    }
+
+    // Yield through the rest, which the sleep granularity can't reach accurately.
+    while (Game::getAbsoluteTime() < __deadline)
+    {
+        Thread::sleep(0);
+    }
+}
+
+}
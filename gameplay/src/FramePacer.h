@@ -0,0 +1,221 @@
+#ifndef FRAMEPACER_H_
+#define FRAMEPACER_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines the pacing of the frames run by the platform loop.
+ *
+ * By default the platform runs frames as fast as it can (or as fast as vsync lets it).
+ * With a target frame rate, the platform sleeps after presenting each frame until the
+ * next frame is due, so frames start at even intervals and the processors idle while
+ * the game is ahead, which saves power on battery. A target that divides the refresh
+ * rate of the display (such as 30 on a 60 Hz display) suits vsync best.
+ *
+ * In adaptive mode, the pacer halves the frame rate when the CPU or GPU time of the
+ * frames keeps going over the frame interval, and returns to the target rate once the
+ * frames again fit in its interval with room to spare. Running at a stable 30 frames
+ * per second judders less than missing every other 60 Hz deadline.
+ *
+ * The elapsed time passed to update() can also be averaged over the last few frames
+ * to hide the jitter of the measured frame intervals. The time lost or gained by the
+ * averaging is handed back over the following frames, so game time does not drift.
+ *
+ * In idle mode, the game stops drawing once nothing has changed for a while, such as
+ * in a menu or a paused game, and the frames run at the idle frame rate to save power.
+ * The display keeps showing the last frame drawn. Input events, running animations,
+ * active particle emitters, moving nodes and changes to the controls of forms wake the
+ * pacer, and the frame during which it is woken is drawn. Games that change what is
+ * drawn another way (such as by setting material parameters each frame) must call
+ * wake() when they do. Input events are handled at the idle frame rate until the
+ * first one wakes the pacer.
+ *
+ * The pacing can be set in the "pacing" section of game.config:
+ * @code
+   pacing
+   {
+       targetRate = 30
+       adaptive = true
+       smoothing = 4
+       idle = true
+       idleRate = 10
+       idleDelay = 500
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class FramePacer
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Sets the number of frames per second the platform runs.
+     *
+     * @param rate The target frame rate, or 0 to run frames as soon as possible (the default).
+     */
+    static void setTargetFrameRate(unsigned int rate);
+
+    /**
+     * Returns the number of frames per second the platform runs.
+     *
+     * @return The target frame rate, or 0 if the frame rate is variable.
+     */
+    static unsigned int getTargetFrameRate();
+
+    /**
+     * Returns the frame rate currently paced, which is lower than the target
+     * rate while adaptive mode has dropped it.
+     *
+     * @return The paced frame rate, or 0 if the frame rate is variable.
+     */
+    static unsigned int getPacedFrameRate();
+
+    /**
+     * Sets whether the paced frame rate drops to half the target rate while the frames do not fit in its interval.
+     *
+     * @param adaptive true to adapt the frame rate to the load, false to always pace at the target rate.
+     */
+    static void setAdaptive(bool adaptive);
+
+    /**
+     * Determines if the paced frame rate adapts to the load.
+     *
+     * @return true if adaptive mode is enabled, false otherwise.
+     */
+    static bool isAdaptive();
+
+    /**
+     * Sets the number of frames the elapsed time passed to the game is averaged over.
+     *
+     * @param frames The number of frames, or 1 to pass the measured elapsed time (the default).
+     */
+    static void setSmoothing(unsigned int frames);
+
+    /**
+     * Returns the number of frames the elapsed time passed to the game is averaged over.
+     *
+     * @return The number of frames.
+     */
+    static unsigned int getSmoothing();
+
+    /**
+     * Returns the time the last frame spent in Game::frame, excluding the buffer swap and the pacing sleep.
+     *
+     * @return The CPU time of the frame, in milliseconds.
+     */
+    static float getCpuTime();
+
+    /**
+     * Returns the GPU time of the most recent frame with a timer result.
+     *
+     * @return The GPU time, in milliseconds, or -1 if GPU timer queries are not supported.
+     */
+    static float getGpuTime();
+
+    /**
+     * Returns the measured time between the start of the last two frames.
+     *
+     * @return The frame interval, in milliseconds.
+     */
+    static float getFrameInterval();
+
+    /**
+     * Sets whether the game stops drawing, and runs at the idle frame rate, while nothing changes.
+     *
+     * @param enabled true to enable idle mode, false to draw every frame (the default).
+     */
+    static void setIdleEnabled(bool enabled);
+
+    /**
+     * Determines if idle mode is enabled.
+     *
+     * @return true if idle mode is enabled, false otherwise.
+     */
+    static bool isIdleEnabled();
+
+    /**
+     * Sets the number of frames per second run while idle.
+     *
+     * The idle rate is only used when it is lower than the paced frame rate.
+     *
+     * @param rate The idle frame rate (10 by default).
+     */
+    static void setIdleFrameRate(unsigned int rate);
+
+    /**
+     * Returns the number of frames per second run while idle.
+     *
+     * @return The idle frame rate.
+     */
+    static unsigned int getIdleFrameRate();
+
+    /**
+     * Sets the time nothing must change for before the game goes idle.
+     *
+     * @param delay The delay, in milliseconds (500 by default).
+     */
+    static void setIdleDelay(float delay);
+
+    /**
+     * Returns the time nothing must change for before the game goes idle.
+     *
+     * @return The delay, in milliseconds.
+     */
+    static float getIdleDelay();
+
+    /**
+     * Determines if the game is idle, so that the current frame is not drawn.
+     *
+     * @return true if the game is idle, false otherwise.
+     */
+    static bool isIdle();
+
+    /**
+     * Records that what is drawn changed during the current frame, so that it is drawn
+     * and the game leaves idle mode.
+     */
+    static void wake();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    FramePacer();
+
+    /**
+     * Records the start of a frame. Called by Game::frame.
+     */
+    static void beginFrame();
+
+    /**
+     * Returns the elapsed time to pass to the game for a measured elapsed time.
+     */
+    static float smoothElapsedTime(float elapsedTime);
+
+    /**
+     * Decides if the frame is drawn, from the changes recorded since the last frame. Called by the game before drawing.
+     *
+     * @return true if the game is idle and the frame must not be drawn.
+     */
+    static bool updateIdle();
+
+    /**
+     * Records the CPU time of the frame and adapts the paced frame rate. Called by Game::frame.
+     */
+    static void endFrame();
+
+    /**
+     * Sleeps until the next frame is due. Called by the platform loop once the frame is presented.
+     */
+    static void wait();
+};
+
+}
+
+#endif
@@ -3,6 +3,13 @@
 #include "BoundingSphere.h"
 #include "BoundingBox.h"
 
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#endif
+
+// The number of floats per plane passed to the batched tests (normal and distance).
+#define FRUSTUM_PLANE_SIZE 4
+
 namespace gameplay
 {
 
@@ -120,6 +127,240 @@ bool Frustum::intersects(const BoundingBox& box) const
     return box.intersects(*this);
 }
 
+unsigned int Frustum::intersectsSpheres(const BoundingSphere* spheres, unsigned int count, unsigned char* visible) const
+{
+    GP_ASSERT(spheres || count == 0);
+    GP_ASSERT(visible || count == 0);
+    GP_ASSERT(sizeof(BoundingSphere) == 4 * sizeof(float));
+
+    float planes[6 * FRUSTUM_PLANE_SIZE];
+    getPlanes(planes);
+
+    unsigned int visibleCount = 0;
+    unsigned int i = 0;
+#if defined(USE_SSE) || defined(USE_NEON)
+    // Each sphere is its center followed by its radius, so four spheres transpose into four registers.
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* data = &spheres[i].center.x;
+#if defined(USE_SSE)
+        __m128 x = _mm_loadu_ps(data);
+        __m128 y = _mm_loadu_ps(data + 4);
+        __m128 z = _mm_loadu_ps(data + 8);
+        __m128 r = _mm_loadu_ps(data + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128 inside = _mm_cmpeq_ps(x, x);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+                                             _mm_mul_ps(z, _mm_set1_ps(plane[2]))), _mm_set1_ps(plane[3]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+#else
+        float32x4x4_t s = vld4q_f32(data);
+        float32x4_t negativeRadius = vnegq_f32(s.val[3]);
+        uint32x4_t inside = vdupq_n_u32(0xffffffff);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            float32x4_t d = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane[3]), s.val[0], plane[0]), s.val[1], plane[1]), s.val[2], plane[2]);
+            inside = vandq_u32(inside, vcgeq_f32(d, negativeRadius));
+        }
+        int mask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                   (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+#endif
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1;
+            visibleCount += visible[i + j];
+        }
+    }
+#endif
+
+    // Remaining spheres.
+    for (; i < count; ++i)
+    {
+        const BoundingSphere& sphere = spheres[i];
+        visible[i] = intersectsSphere(planes, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+unsigned int Frustum::intersectsSpheres(const float* x, const float* y, const float* z, const float* radius, unsigned int count, unsigned char* visible) const
+{
+    GP_ASSERT((x && y && z && radius) || count == 0);
+    GP_ASSERT(visible || count == 0);
+
+    float planes[6 * FRUSTUM_PLANE_SIZE];
+    getPlanes(planes);
+
+    unsigned int visibleCount = 0;
+    unsigned int i = 0;
+#if defined(USE_SSE) || defined(USE_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+#if defined(USE_SSE)
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_cmpeq_ps(cx, cx);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane[0])), _mm_mul_ps(cy, _mm_set1_ps(plane[1]))),
+                                             _mm_mul_ps(cz, _mm_set1_ps(plane[2]))), _mm_set1_ps(plane[3]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+#else
+        float32x4_t cx = vld1q_f32(x + i);
+        float32x4_t cy = vld1q_f32(y + i);
+        float32x4_t cz = vld1q_f32(z + i);
+        float32x4_t negativeRadius = vnegq_f32(vld1q_f32(radius + i));
+        uint32x4_t inside = vdupq_n_u32(0xffffffff);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            float32x4_t d = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane[3]), cx, plane[0]), cy, plane[1]), cz, plane[2]);
+            inside = vandq_u32(inside, vcgeq_f32(d, negativeRadius));
+        }
+        int mask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                   (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+#endif
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1;
+            visibleCount += visible[i + j];
+        }
+    }
+#endif
+
+    // Remaining spheres.
+    for (; i < count; ++i)
+    {
+        visible[i] = intersectsSphere(planes, x[i], y[i], z[i], radius[i]) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+unsigned int Frustum::intersectsBoxes(const float* minX, const float* minY, const float* minZ,
+                                      const float* maxX, const float* maxY, const float* maxZ,
+                                      unsigned int count, unsigned char* visible) const
+{
+    GP_ASSERT((minX && minY && minZ && maxX && maxY && maxZ) || count == 0);
+    GP_ASSERT(visible || count == 0);
+
+    float planes[6 * FRUSTUM_PLANE_SIZE];
+    getPlanes(planes);
+
+    // A box is behind a plane when its center is further behind it than its extents projected on the normal.
+    unsigned int visibleCount = 0;
+    unsigned int i = 0;
+#if defined(USE_SSE)
+    __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x0 = _mm_loadu_ps(minX + i), x1 = _mm_loadu_ps(maxX + i);
+        __m128 y0 = _mm_loadu_ps(minY + i), y1 = _mm_loadu_ps(maxY + i);
+        __m128 z0 = _mm_loadu_ps(minZ + i), z1 = _mm_loadu_ps(maxZ + i);
+        __m128 cx = _mm_mul_ps(_mm_add_ps(x0, x1), half), ex = _mm_mul_ps(_mm_sub_ps(x1, x0), half);
+        __m128 cy = _mm_mul_ps(_mm_add_ps(y0, y1), half), ey = _mm_mul_ps(_mm_sub_ps(y1, y0), half);
+        __m128 cz = _mm_mul_ps(_mm_add_ps(z0, z1), half), ez = _mm_mul_ps(_mm_sub_ps(z1, z0), half);
+        __m128 inside = _mm_cmpeq_ps(cx, cx);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane[0])), _mm_mul_ps(cy, _mm_set1_ps(plane[1]))),
+                                             _mm_mul_ps(cz, _mm_set1_ps(plane[2]))), _mm_set1_ps(plane[3]));
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(fabsf(plane[0]))), _mm_mul_ps(ey, _mm_set1_ps(fabsf(plane[1])))),
+                                  _mm_mul_ps(ez, _mm_set1_ps(fabsf(plane[2]))));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_sub_ps(_mm_setzero_ps(), e)));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1;
+            visibleCount += visible[i + j];
+        }
+    }
+#elif defined(USE_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t x0 = vld1q_f32(minX + i), x1 = vld1q_f32(maxX + i);
+        float32x4_t y0 = vld1q_f32(minY + i), y1 = vld1q_f32(maxY + i);
+        float32x4_t z0 = vld1q_f32(minZ + i), z1 = vld1q_f32(maxZ + i);
+        float32x4_t cx = vmulq_n_f32(vaddq_f32(x0, x1), 0.5f), ex = vmulq_n_f32(vsubq_f32(x1, x0), 0.5f);
+        float32x4_t cy = vmulq_n_f32(vaddq_f32(y0, y1), 0.5f), ey = vmulq_n_f32(vsubq_f32(y1, y0), 0.5f);
+        float32x4_t cz = vmulq_n_f32(vaddq_f32(z0, z1), 0.5f), ez = vmulq_n_f32(vsubq_f32(z1, z0), 0.5f);
+        uint32x4_t inside = vdupq_n_u32(0xffffffff);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            float32x4_t d = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane[3]), cx, plane[0]), cy, plane[1]), cz, plane[2]);
+            float32x4_t e = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(ex, fabsf(plane[0])), ey, fabsf(plane[1])), ez, fabsf(plane[2]));
+            inside = vandq_u32(inside, vcgeq_f32(d, vnegq_f32(e)));
+        }
+        int mask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                   (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1;
+            visibleCount += visible[i + j];
+        }
+    }
+#endif
+
+    // Remaining boxes.
+    for (; i < count; ++i)
+    {
+        float cx = (minX[i] + maxX[i]) * 0.5f, ex = (maxX[i] - minX[i]) * 0.5f;
+        float cy = (minY[i] + maxY[i]) * 0.5f, ey = (maxY[i] - minY[i]) * 0.5f;
+        float cz = (minZ[i] + maxZ[i]) * 0.5f, ez = (maxZ[i] - minZ[i]) * 0.5f;
+        bool inside = true;
+        for (unsigned int p = 0; p < 6 && inside; ++p)
+        {
+            const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+            float d = cx * plane[0] + cy * plane[1] + cz * plane[2] + plane[3];
+            float e = ex * fabsf(plane[0]) + ey * fabsf(plane[1]) + ez * fabsf(plane[2]);
+            inside = d >= -e;
+        }
+        visible[i] = inside ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+bool Frustum::intersectsSphere(const float* planes, float x, float y, float z, float radius)
+{
+    for (unsigned int p = 0; p < 6; ++p)
+    {
+        const float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+        if (x * plane[0] + y * plane[1] + z * plane[2] + plane[3] < -radius)
+            return false;
+    }
+    return true;
+}
+
+void Frustum::getPlanes(float* planes) const
+{
+    const Plane* source[6] = { &_near, &_far, &_left, &_right, &_bottom, &_top };
+    for (unsigned int p = 0; p < 6; ++p)
+    {
+        const Vector3& normal = source[p]->getNormal();
+        float* plane = planes + p * FRUSTUM_PLANE_SIZE;
+        plane[0] = normal.x;
+        plane[1] = normal.y;
+        plane[2] = normal.z;
+        plane[3] = source[p]->getDistance();
+    }
+}
+
 float Frustum::intersects(const Plane& plane) const
 {
     return plane.intersects(*this);
@@ -171,6 +171,57 @@ public:
      */
     bool intersects(const BoundingBox& box) const;
 
+    /**
+     * Tests an array of bounding spheres against this frustum, four at a time with SSE or NEON.
+     *
+     * Each sphere is tested as by intersects(const BoundingSphere&).
+     *
+     * @param spheres The bounding spheres to test.
+     * @param count The number of spheres.
+     * @param visible The array of count entries set to 1 for each sphere that intersects this frustum, and 0 for the others.
+     *
+     * @return The number of spheres that intersect this frustum.
+     */
+    unsigned int intersectsSpheres(const BoundingSphere* spheres, unsigned int count, unsigned char* visible) const;
+
+    /**
+     * Tests an array of bounding spheres stored as separate arrays of coordinates against this frustum,
+     * four at a time with SSE or NEON.
+     *
+     * Each sphere is tested as by intersects(const BoundingSphere&).
+     *
+     * @param x The x coordinates of the centers of the spheres.
+     * @param y The y coordinates of the centers of the spheres.
+     * @param z The z coordinates of the centers of the spheres.
+     * @param radius The radii of the spheres.
+     * @param count The number of spheres.
+     * @param visible The array of count entries set to 1 for each sphere that intersects this frustum, and 0 for the others.
+     *
+     * @return The number of spheres that intersect this frustum.
+     */
+    unsigned int intersectsSpheres(const float* x, const float* y, const float* z, const float* radius, unsigned int count, unsigned char* visible) const;
+
+    /**
+     * Tests an array of bounding boxes stored as separate arrays of coordinates against this frustum,
+     * four at a time with SSE or NEON.
+     *
+     * Each box is tested as by intersects(const BoundingBox&).
+     *
+     * @param minX The minimum x coordinates of the boxes.
+     * @param minY The minimum y coordinates of the boxes.
+     * @param minZ The minimum z coordinates of the boxes.
+     * @param maxX The maximum x coordinates of the boxes.
+     * @param maxY The maximum y coordinates of the boxes.
+     * @param maxZ The maximum z coordinates of the boxes.
+     * @param count The number of boxes.
+     * @param visible The array of count entries set to 1 for each box that intersects this frustum, and 0 for the others.
+     *
+     * @return The number of boxes that intersect this frustum.
+     */
+    unsigned int intersectsBoxes(const float* minX, const float* minY, const float* minZ,
+                                 const float* maxX, const float* maxY, const float* maxZ,
+                                 unsigned int count, unsigned char* visible) const;
+
     /**
      * Tests whether this frustum intersects the specified plane.
      *
@@ -214,6 +265,16 @@ private:
      */
     void updatePlanes();
 
+    /**
+     * Tests a single sphere against the planes stored by getPlanes.
+     */
+    static bool intersectsSphere(const float* planes, float x, float y, float z, float radius);
+
+    /**
+     * Stores the normal and distance of each plane in order, for the batched tests.
+     */
+    void getPlanes(float* planes) const;
+
     Plane _near;
     Plane _far;
     Plane _bottom;
@@ -0,0 +1,260 @@
+#include "Base.h"
+#include "GLStateCache.h"
+#include "Game.h"
+
+// The number of texture units whose bindings are cached. Binds to higher units are always issued.
+#define GL_STATE_CACHE_TEXTURE_UNITS 32
+
+// The value of a binding that is not known, which never matches a handle.
+#define GL_STATE_UNKNOWN ((GLuint)-1)
+
+namespace gameplay
+{
+
+static bool __enabled = true;
+static GLuint __program = GL_STATE_UNKNOWN;
+static GLuint __activeUnit = GL_STATE_UNKNOWN;
+static GLuint __textures[GL_STATE_CACHE_TEXTURE_UNITS][2];
+static GLuint __samplers[GL_STATE_CACHE_TEXTURE_UNITS];
+static GLuint __arrayBuffer = GL_STATE_UNKNOWN;
+static GLuint __elementArrayBuffer = GL_STATE_UNKNOWN;
+static GLuint __vertexArray = GL_STATE_UNKNOWN;
+static bool __texturesKnown = false;
+
+// Returns the cached binding of a texture target of the active unit, or NULL if it isn't cached.
+static GLuint* getTextureBinding(GLenum target)
+{
+    if (!__texturesKnown)
+    {
+        for (unsigned int i = 0; i < GL_STATE_CACHE_TEXTURE_UNITS; ++i)
+        {
+            __textures[i][0] = __textures[i][1] = GL_STATE_UNKNOWN;
+            __samplers[i] = GL_STATE_UNKNOWN;
+        }
+        __texturesKnown = true;
+    }
+
+    if (__activeUnit >= GL_STATE_CACHE_TEXTURE_UNITS)
+        return NULL;
+
+    switch (target)
+    {
+    case GL_TEXTURE_2D:
+        return &__textures[__activeUnit][0];
+    case GL_TEXTURE_CUBE_MAP:
+        return &__textures[__activeUnit][1];
+    default:
+        return NULL;
+    }
+}
+
+bool GLStateCache::useProgram(GLuint program)
+{
+    if (__enabled && __program == program)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return false;
+    }
+
+    GL_ASSERT( glUseProgram(program) );
+    __program = program;
+    return true;
+}
+
+void GLStateCache::activeTexture(unsigned int unit)
+{
+    if (__enabled && __activeUnit == unit)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return;
+    }
+
+    GL_ASSERT( glActiveTexture(GL_TEXTURE0 + unit) );
+    __activeUnit = unit;
+}
+
+bool GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    GLuint* binding = getTextureBinding(target);
+    if (__enabled && binding && *binding == texture)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return false;
+    }
+
+    GL_ASSERT( glBindTexture(target, texture) );
+    if (binding)
+        *binding = texture;
+    return true;
+}
+
+GLuint GLStateCache::getTexture(GLenum target)
+{
+    GLuint* binding = getTextureBinding(target);
+    if (binding && *binding != GL_STATE_UNKNOWN)
+        return *binding;
+
+    // Ask GL when the binding isn't known yet.
+    GLint texture = 0;
+    GL_ASSERT( glGetIntegerv(target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D, &texture) );
+    if (binding)
+        *binding = (GLuint)texture;
+    return (GLuint)texture;
+}
+
+void GLStateCache::bindSampler(GLuint sampler)
+{
+#ifdef USE_SAMPLER_OBJECTS
+    // Make sure the bindings of the units are known.
+    getTextureBinding(GL_TEXTURE_2D);
+
+    GLuint* binding = __activeUnit < GL_STATE_CACHE_TEXTURE_UNITS ? &__samplers[__activeUnit] : NULL;
+    if (__enabled && binding && *binding == sampler)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return;
+    }
+
+    GP_ASSERT(__activeUnit != GL_STATE_UNKNOWN);
+    GL_ASSERT( glBindSampler(__activeUnit, sampler) );
+    if (binding)
+        *binding = sampler;
+#endif
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* binding = NULL;
+    if (target == GL_ARRAY_BUFFER)
+        binding = &__arrayBuffer;
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+        binding = &__elementArrayBuffer;
+
+    if (__enabled && binding && *binding == buffer)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return;
+    }
+
+    GL_ASSERT( glBindBuffer(target, buffer) );
+    if (binding)
+        *binding = buffer;
+}
+
+void GLStateCache::bindVertexArray(GLuint array)
+{
+#ifdef USE_VAO
+    // Platforms that load vertex array objects from an extension may not support them.
+    if (!glBindVertexArray)
+        return;
+
+    if (__enabled && __vertexArray == array)
+    {
+        ++Game::_renderStats.redundantBinds;
+        return;
+    }
+
+    GL_ASSERT( glBindVertexArray(array) );
+    __vertexArray = array;
+
+    // The index buffer binding is state of the vertex array object.
+    __elementArrayBuffer = GL_STATE_UNKNOWN;
+#endif
+}
+
+GLuint GLStateCache::getVertexArray()
+{
+    return __vertexArray == GL_STATE_UNKNOWN ? 0 : __vertexArray;
+}
+
+void GLStateCache::deleteTexture(GLuint texture)
+{
+    GL_ASSERT( glDeleteTextures(1, &texture) );
+
+    // GL binds 0 in place of a deleted texture.
+    if (__texturesKnown)
+    {
+        for (unsigned int i = 0; i < GL_STATE_CACHE_TEXTURE_UNITS; ++i)
+        {
+            for (unsigned int j = 0; j < 2; ++j)
+            {
+                if (__textures[i][j] == texture)
+                    __textures[i][j] = 0;
+            }
+        }
+    }
+}
+
+void GLStateCache::deleteSampler(GLuint sampler)
+{
+#ifdef USE_SAMPLER_OBJECTS
+    GL_ASSERT( glDeleteSamplers(1, &sampler) );
+
+    // GL binds 0 in place of a deleted sampler object.
+    if (__texturesKnown)
+    {
+        for (unsigned int i = 0; i < GL_STATE_CACHE_TEXTURE_UNITS; ++i)
+        {
+            if (__samplers[i] == sampler)
+                __samplers[i] = 0;
+        }
+    }
+#endif
+}
+
+void GLStateCache::deleteBuffer(GLuint buffer)
+{
+    GL_ASSERT( glDeleteBuffers(1, &buffer) );
+
+    if (__arrayBuffer == buffer)
+        __arrayBuffer = 0;
+
+    // Vertex array objects that are not bound keep the deleted buffer as their index buffer.
+    if (__elementArrayBuffer == buffer)
+        __elementArrayBuffer = 0;
+}
+
+void GLStateCache::deleteProgram(GLuint program)
+{
+    // A program that is in use is only deleted once it is no longer in use.
+    if (__program == program)
+    {
+        GL_ASSERT( glUseProgram(0) );
+        __program = 0;
+    }
+    GL_ASSERT( glDeleteProgram(program) );
+}
+
+void GLStateCache::deleteVertexArray(GLuint array)
+{
+#ifdef USE_VAO
+    GL_ASSERT( glDeleteVertexArrays(1, &array) );
+    if (__vertexArray == array)
+    {
+        __vertexArray = 0;
+        __elementArrayBuffer = GL_STATE_UNKNOWN;
+    }
+#endif
+}
+
+void GLStateCache::invalidate()
+{
+    __program = GL_STATE_UNKNOWN;
+    __activeUnit = GL_STATE_UNKNOWN;
+    __texturesKnown = false;
+    __arrayBuffer = GL_STATE_UNKNOWN;
+    __elementArrayBuffer = GL_STATE_UNKNOWN;
+    __vertexArray = GL_STATE_UNKNOWN;
+}
+
+void GLStateCache::setEnabled(bool enabled)
+{
+    __enabled = enabled;
+}
+
+bool GLStateCache::isEnabled()
+{
+    return __enabled;
+}
+
+}
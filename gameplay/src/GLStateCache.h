@@ -0,0 +1,169 @@
+#ifndef GLSTATECACHE_H_
+#define GLSTATECACHE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a shadow of the GL binding state that the engine's GL wrappers go through,
+ * so that binds of the state that is already bound are skipped.
+ *
+ * Draws of items that share a shader program, texture, vertex array or index buffer
+ * would otherwise bind them again for every item. Drivers validate every bind whether
+ * or not it changes anything, which is expensive on tiled mobile GPUs. The cache tracks
+ * the bound program, the active texture unit, the 2D and cube map textures and the
+ * sampler object of each unit, the vertex and index buffers and the vertex array object.
+ *
+ * The state of the cache is unknown until the first bind of each binding, so the first
+ * bind always reaches GL. Code that changes these bindings with GL directly (such as
+ * third party libraries) must call invalidate() afterwards, or disable the cache.
+ *
+ * @script{ignore}
+ */
+class GLStateCache
+{
+public:
+
+    /**
+     * Binds a shader program, unless it is bound already.
+     *
+     * @param program The handle of the program, or 0 to unbind the current one.
+     *
+     * @return true if the program was bound, false if the bind was skipped.
+     */
+    static bool useProgram(GLuint program);
+
+    /**
+     * Selects the active texture unit, unless it is active already.
+     *
+     * @param unit The index of the unit, starting at 0 (for GL_TEXTURE0).
+     */
+    static void activeTexture(unsigned int unit);
+
+    /**
+     * Binds a texture to the active texture unit, unless it is bound already.
+     *
+     * @param target The texture target, such as GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+     * @param texture The handle of the texture, or 0.
+     *
+     * @return true if the texture was bound, false if the bind was skipped.
+     */
+    static bool bindTexture(GLenum target, GLuint texture);
+
+    /**
+     * Returns the texture bound to a target of the active texture unit.
+     *
+     * Unlike glGetIntegerv, this does not stall the GL pipeline, so it suits code that
+     * must restore the texture binding it changes.
+     *
+     * @param target The texture target, such as GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+     *
+     * @return The handle of the bound texture.
+     */
+    static GLuint getTexture(GLenum target);
+
+    /**
+     * Binds a sampler object to the active texture unit, unless it is bound already.
+     *
+     * @param sampler The handle of the sampler object, or 0 to sample with the parameters of the texture.
+     */
+    static void bindSampler(GLuint sampler);
+
+    /**
+     * Binds a buffer, unless it is bound already.
+     *
+     * Vertex (GL_ARRAY_BUFFER) and index (GL_ELEMENT_ARRAY_BUFFER) buffers are cached, and
+     * binds of other targets are always issued. The index buffer binding belongs to the bound
+     * vertex array object, so it is forgotten when a different vertex array object is bound.
+     *
+     * @param target The buffer target.
+     * @param buffer The handle of the buffer, or 0.
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Binds a vertex array object, unless it is bound already.
+     *
+     * @param array The handle of the vertex array object, or 0 for the default one.
+     */
+    static void bindVertexArray(GLuint array);
+
+    /**
+     * Returns the bound vertex array object.
+     *
+     * @return The handle of the vertex array object, or 0 if the default one is bound or the binding is unknown.
+     */
+    static GLuint getVertexArray();
+
+    /**
+     * Deletes a texture and forgets it in the texture units it is bound to.
+     *
+     * GL unbinds deleted textures, and may reuse their handles for new ones.
+     *
+     * @param texture The handle of the texture.
+     */
+    static void deleteTexture(GLuint texture);
+
+    /**
+     * Deletes a sampler object and forgets it in the texture units it is bound to.
+     *
+     * @param sampler The handle of the sampler object.
+     */
+    static void deleteSampler(GLuint sampler);
+
+    /**
+     * Deletes a buffer and forgets its bindings.
+     *
+     * @param buffer The handle of the buffer.
+     */
+    static void deleteBuffer(GLuint buffer);
+
+    /**
+     * Deletes a shader program, unbinding it first if it is bound.
+     *
+     * @param program The handle of the program.
+     */
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Deletes a vertex array object, which binds the default one if it is bound.
+     *
+     * @param array The handle of the vertex array object.
+     */
+    static void deleteVertexArray(GLuint array);
+
+    /**
+     * Forgets the cached state, so that the next bind of each binding reaches GL.
+     *
+     * Call this after changing the cached bindings with GL directly, or after the GL context was recreated.
+     */
+    static void invalidate();
+
+    /**
+     * Sets whether redundant binds are skipped.
+     *
+     * While the cache is disabled every bind reaches GL, which helps to find GL code that
+     * bypasses the cache.
+     *
+     * @param enabled true to skip redundant binds (the default), false to issue every bind.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Determines if redundant binds are skipped.
+     *
+     * @return true if the cache is enabled.
+     */
+    static bool isEnabled();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    GLStateCache();
+};
+
+}
+
+#endif
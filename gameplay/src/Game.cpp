@@ -4,33 +4,78 @@
 #include "RenderState.h"
 #include "FileSystem.h"
 #include "FrameBuffer.h"
+#include "RenderTargetPool.h"
+#include "DebugDraw.h"
+#include "CommandBuffer.h"
+#include "RenderThread.h"
 #include "SceneLoader.h"
 #include "ControlFactory.h"
 #include "Theme.h"
+#include "Bundle.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include "GraphicsMemory.h"
+#include "FramePacer.h"
+#include "ScratchMemory.h"
+#include "StartupTrace.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+#include "Telemetry.h"
+#include "GraphicsResource.h"
+#include "GLStateCache.h"
+#include "RenderQueue.h"
+#include "TimerWheel.h"
+
+#ifdef _MSC_VER
+#define GAME_THREAD_LOCAL __declspec(thread)
+#else
+#define GAME_THREAD_LOCAL __thread
+#endif
+
+// The maximum number of job worker threads started by default
+#define GAME_MAX_JOB_WORKERS 7
+
+// The default maximum number of fixed time steps simulated in one frame
+#define GAME_MAX_FIXED_STEPS 4
 
 /** @script{ignore} */
 GLenum __gl_error_code = GL_NO_ERROR;
 /** @script{ignore} */
+bool __gl_error_check_call = true;
+/** @script{ignore} */
 ALenum __al_error_code = AL_NO_ERROR;
 
 namespace gameplay
 {
 
 static Game* __gameInstance = NULL;
+static Game::ErrorCheck __glErrorCheck = Game::ERROR_CHECK_CALL;
 double Game::_pausedTimeLast = 0.0;
 double Game::_pausedTimeTotal = 0.0;
+Game::RenderStats Game::_renderStats;
+
+// Set while a pipelined frame is simulated, and on the game thread while it draws the previous frame.
+static volatile bool __pipelineSimulating = false;
+static GAME_THREAD_LOCAL bool __renderingCaptured = false;
 
 Game::Game()
     : _initialized(false), _state(UNINITIALIZED), _pausedCount(0),
-      _frameLastFPS(0), _frameCount(0), _frameRate(0), _width(0), _height(0),
+      _frameLastFPS(0), _frameCount(0), _frameRate(0), _timerQueriesIssued(0), _timerQueriesRead(0), _timerQueryActive(false), _gpuTime(-1.0f),
+      _width(0), _height(0),
       _clearDepth(1.0f), _clearStencil(0), _properties(NULL),
       _animationController(NULL), _audioController(NULL),
-      _physicsController(NULL), _aiController(NULL), _audioListener(NULL),
-      _timeEvents(NULL), _scriptController(NULL), _scriptListeners(NULL)
+      _physicsController(NULL), _aiController(NULL), _jobScheduler(NULL),
+      _pipelined(false), _pipelineCaptured(false), _renderThreaded(false), _renderThread(NULL), _simulationTime(0.0f), _simulationSteps(1),
+      _fixedTimeStep(0.0f), _maxFixedSteps(GAME_MAX_FIXED_STEPS), _fixedTimeAccumulator(0.0f), _interpolationFactor(1.0f), _audioListener(NULL),
+      _timeEvents(NULL), _scriptController(NULL)
 {
     GP_ASSERT(__gameInstance == NULL);
     __gameInstance = this;
-    _timeEvents = new std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >();
+    _timeEvents = new TimerWheel(0.0);
+    memset(&_renderStats, 0, sizeof(_renderStats));
+    memset(&_lastRenderStats, 0, sizeof(_lastRenderStats));
+    _lastRenderStats.gpuTime = -1.0f;
+    memset(_timerQueries, 0, sizeof(_timerQueries));
 }
 
 Game::~Game()
@@ -59,9 +104,70 @@ double Game::getAbsoluteTime()
 
 double Game::getGameTime()
 {
+    // A replayed session advances the game time by a fixed step per frame.
+    if (InputRecorder::_replaying)
+        return InputRecorder::getReplayTime();
     return Platform::getAbsoluteTime() - _pausedTimeTotal;
 }
 
+#ifdef USE_DEBUG_OUTPUT
+static void GLAPIENTRY logDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+    if (type == GL_DEBUG_TYPE_ERROR)
+        GP_WARN("GL error: %s", message);
+    else
+        GP_WARN("GL debug message (type 0x%x, severity 0x%x): %s", type, severity, message);
+
+    // Errors assert like GL_ASSERT does, in the stack of the call that raised them.
+    GP_ASSERT(type != GL_DEBUG_TYPE_ERROR);
+}
+#endif
+
+void Game::setGLErrorCheck(ErrorCheck check)
+{
+    bool debugOutput = false;
+#ifdef USE_DEBUG_OUTPUT
+    if (glDebugMessageCallback && glDebugMessageControl)
+    {
+        debugOutput = check == ERROR_CHECK_DEBUG_OUTPUT;
+        if (debugOutput)
+        {
+            // Notifications (such as buffer placement hints) are not worth logging.
+            GL_ASSERT( glDebugMessageCallback(logDebugOutput, NULL) );
+            GL_ASSERT( glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE) );
+            GL_ASSERT( glEnable(GL_DEBUG_OUTPUT) );
+            GL_ASSERT( glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS) );
+        }
+        else if (__glErrorCheck == ERROR_CHECK_DEBUG_OUTPUT)
+        {
+            GL_ASSERT( glDisable(GL_DEBUG_OUTPUT) );
+        }
+    }
+#endif
+    if (check == ERROR_CHECK_DEBUG_OUTPUT && !debugOutput)
+    {
+        check = ERROR_CHECK_CALL;
+    }
+#ifdef NDEBUG
+    // GL_ASSERT does not check calls in release builds.
+    if (check == ERROR_CHECK_CALL)
+    {
+        check = ERROR_CHECK_FRAME;
+    }
+#endif
+
+    // Drop the errors left unread by the previous mode, so that they are not reported by the new one.
+    while (glGetError() != GL_NO_ERROR) ;
+
+    __glErrorCheck = check;
+    __gl_error_check_call = check == ERROR_CHECK_CALL;
+}
+
+Game::ErrorCheck Game::getGLErrorCheck()
+{
+    return __glErrorCheck;
+}
+
 void Game::setVsync(bool enable)
 {
     Platform::setVsync(enable);
@@ -77,13 +183,18 @@ int Game::run()
     if (_state != UNINITIALIZED)
         return -1;
 
+    StartupTrace::begin("Game::loadConfig");
     loadConfig();
+    StartupTrace::end();
 
     _width = Platform::getDisplayWidth();
     _height = Platform::getDisplayHeight();
 
     // Start up game systems.
-    if (!startup())
+    StartupTrace::begin("Game::startup");
+    bool started = startup();
+    StartupTrace::end();
+    if (!started)
     {
         shutdown();
         return -2;
@@ -97,27 +208,311 @@ bool Game::startup()
     if (_state != UNINITIALIZED)
         return false;
 
+    // Print log messages from a background thread and rate limit them, if configured.
+    if (_properties)
+    {
+        Properties* logger = _properties->getNamespace("logger", true);
+        if (logger)
+        {
+            Logger::setRateLimit(Logger::LEVEL_INFO, (unsigned int)std::max(logger->getInt("infoRateLimit"), 0));
+            Logger::setRateLimit(Logger::LEVEL_WARN, (unsigned int)std::max(logger->getInt("warnRateLimit"), 0));
+            Logger::setRateLimit(Logger::LEVEL_ERROR, (unsigned int)std::max(logger->getInt("errorRateLimit"), 0));
+            Logger::setAsync(logger->getBool("async"));
+        }
+    }
+
+    // Prefer the debug output of the driver for GL errors in debug builds, unless configured otherwise.
+#ifdef NDEBUG
+    ErrorCheck errorCheck = ERROR_CHECK_OFF;
+#else
+    ErrorCheck errorCheck = ERROR_CHECK_DEBUG_OUTPUT;
+#endif
+    Properties* graphicsConfig = _properties ? _properties->getNamespace("graphics", true) : NULL;
+    const char* errorCheckName = graphicsConfig ? graphicsConfig->getString("errorCheck") : NULL;
+    if (errorCheckName)
+    {
+        if (strcmp(errorCheckName, "OFF") == 0)
+            errorCheck = ERROR_CHECK_OFF;
+        else if (strcmp(errorCheckName, "FRAME") == 0)
+            errorCheck = ERROR_CHECK_FRAME;
+        else if (strcmp(errorCheckName, "CALL") == 0)
+            errorCheck = ERROR_CHECK_CALL;
+        else if (strcmp(errorCheckName, "DEBUG_OUTPUT") == 0)
+            errorCheck = ERROR_CHECK_DEBUG_OUTPUT;
+        else
+            GP_WARN("Unsupported GL error check '%s'.", errorCheckName);
+    }
+    setGLErrorCheck(errorCheck);
+
     setViewport(Rectangle(0.0f, 0.0f, (float)_width, (float)_height));
+    StartupTrace::begin("RenderState::initialize");
     RenderState::initialize();
     FrameBuffer::initialize();
+    StartupTrace::end();
+
+    // Cache text properties files in the binary format, if configured.
+    if (_properties)
+    {
+        Properties* properties = _properties->getNamespace("properties", true);
+        if (properties && properties->exists("cachePath"))
+        {
+            Properties::setCachePath(properties->getString("cachePath"));
+        }
+    }
+
+    // Cache linked shader programs across runs, if configured.
+    if (_properties)
+    {
+        Properties* graphics = _properties->getNamespace("graphics", true);
+        if (graphics && graphics->exists("programCachePath"))
+        {
+            Effect::setProgramCachePath(graphics->getString("programCachePath"));
+        }
+        if (graphics && graphics->exists("quality"))
+        {
+            Material::setQualityLevel((unsigned int)std::max(graphics->getInt("quality"), 0));
+        }
+        if (graphics)
+        {
+            Material::setAdaptiveQuality(graphics->getBool("adaptiveQuality"));
+            RenderQueue::setDepthPrePass(graphics->getBool("depthPrePass"));
+        }
+        if (graphics && graphics->exists("retainBudget"))
+        {
+            // Set in megabytes.
+            GraphicsResource::setRetainBudget((unsigned int)graphics->getInt("retainBudget") * 1024 * 1024);
+        }
+        if (graphics && graphics->getInt("memoryBudget") > 0)
+        {
+            // Set in megabytes.
+            GraphicsMemory::setBudget((unsigned int)graphics->getInt("memoryBudget") * 1024 * 1024);
+        }
+        if (graphics && graphics->exists("evictMipmaps"))
+        {
+            GraphicsMemory::setMipmapEviction(graphics->getBool("evictMipmaps"));
+        }
+        if (graphics)
+        {
+            _renderThreaded = graphics->getBool("renderThread");
+        }
+    }
+
+    // Start one worker thread per additional processor unless configured otherwise.
+    int workerCount = (int)std::min(Thread::getProcessorCount(), (unsigned int)GAME_MAX_JOB_WORKERS + 1) - 1;
+    if (_properties)
+    {
+        Properties* jobs = _properties->getNamespace("jobs", true);
+        if (jobs && jobs->exists("workerCount"))
+        {
+            workerCount = std::max(jobs->getInt("workerCount"), 0);
+        }
+        if (jobs)
+        {
+            _pipelined = jobs->getBool("pipelined");
+        }
+    }
+    StartupTrace::begin("JobScheduler::initialize");
+    _jobScheduler = new JobScheduler();
+    _jobScheduler->initialize((unsigned int)workerCount);
+    StartupTrace::end();
 
+    if (_properties)
+    {
+        Properties* textures = _properties->getNamespace("textures", true);
+        if (textures && textures->getInt("streamingBudget") > 0)
+        {
+            Texture::setStreamingBudget((unsigned int)textures->getInt("streamingBudget") * 1024 * 1024);
+        }
+
+        // Memory budgets are set in megabytes for each category, by name.
+        Properties* memory = _properties->getNamespace("memory", true);
+        for (unsigned int i = 0; memory && i < MemoryTracker::CATEGORY_COUNT; ++i)
+        {
+            const char* name = MemoryTracker::getCategoryName((MemoryTracker::Category)i);
+            if (memory->getInt(name) > 0)
+            {
+                MemoryTracker::setBudget((MemoryTracker::Category)i, (unsigned int)memory->getInt(name) * 1024 * 1024);
+            }
+        }
+    }
+
+    StartupTrace::begin("AnimationController::initialize");
     _animationController = new AnimationController();
     _animationController->initialize();
+    if (_properties)
+    {
+        Properties* animation = _properties->getNamespace("animation", true);
+        const char* rotationInterpolation = animation ? animation->getString("rotationInterpolation") : NULL;
+        if (rotationInterpolation && strcmp(rotationInterpolation, "NLERP") == 0)
+        {
+            Curve::setRotationInterpolation(Curve::ROTATION_NLERP);
+        }
+    }
+    StartupTrace::end();
 
+    StartupTrace::begin("AudioController::initialize");
     _audioController = new AudioController();
     _audioController->initialize();
+    if (_properties)
+    {
+        Properties* audio = _properties->getNamespace("audio", true);
+        if (audio && audio->exists("maxVoices"))
+        {
+            _audioController->setMaxVoices((unsigned int)std::max(audio->getInt("maxVoices"), 0));
+        }
+        if (audio && audio->getFloat("cacheBudget") > 0.0f)
+        {
+            _audioController->setBufferCacheBudget((size_t)(audio->getFloat("cacheBudget") * 1024.0f * 1024.0f));
+        }
 
+        // Decode the listed sounds into the buffer cache.
+        const char* prewarm = audio ? audio->getString("prewarm") : NULL;
+        if (prewarm)
+        {
+            std::string list = prewarm;
+            for (size_t start = 0; start < list.size();)
+            {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos)
+                    end = list.size();
+                std::string path = list.substr(start, end - start);
+                path.erase(0, path.find_first_not_of(" \t"));
+                path.erase(path.find_last_not_of(" \t") + 1);
+                if (!path.empty() && !_audioController->prewarm(path.c_str()))
+                {
+                    GP_WARN("Failed to prewarm audio file '%s'.", path.c_str());
+                }
+                start = end + 1;
+            }
+        }
+    }
+    StartupTrace::end();
+
+    StartupTrace::begin("PhysicsController::initialize");
     _physicsController = new PhysicsController();
-    _physicsController->initialize();
+    {
+        // The multithreaded world is chosen when the world is created, and runs on the job scheduler created above.
+        Properties* physics = _properties ? _properties->getNamespace("physics", true) : NULL;
+        _physicsController->initialize(physics && physics->getBool("multithreaded"));
+    }
+    StartupTrace::end();
+    if (_properties)
+    {
+        // Run the simulation at a fixed rate if one is configured.
+        Properties* timestep = _properties->getNamespace("timestep", true);
+        if (timestep && timestep->getFloat("rate") > 0.0f)
+        {
+            int maxSteps = timestep->exists("maxSteps") ? timestep->getInt("maxSteps") : GAME_MAX_FIXED_STEPS;
+            setFixedTimeStep(1000.0f / timestep->getFloat("rate"), (unsigned int)std::max(maxSteps, 1));
+        }
+    }
+    if (_properties)
+    {
+        // Buffer the input events until the next frame if configured.
+        Properties* input = _properties->getNamespace("input", true);
+        if (input)
+        {
+            InputQueue::setEnabled(input->getBool("buffered"));
+        }
+
+        // Record or replay the input events of the session if configured.
+        InputRecorder::configure(_properties);
+
+        // Stream the performance counters to a viewer if configured.
+        Telemetry::configure(_properties);
+
+        // Pace the frames if a target frame rate is configured.
+        Properties* pacing = _properties->getNamespace("pacing", true);
+        if (pacing)
+        {
+            FramePacer::setTargetFrameRate((unsigned int)std::max(pacing->getInt("targetRate"), 0));
+            FramePacer::setAdaptive(pacing->getBool("adaptive"));
+            if (pacing->exists("smoothing"))
+                FramePacer::setSmoothing((unsigned int)std::max(pacing->getInt("smoothing"), 1));
+            FramePacer::setIdleEnabled(pacing->getBool("idle"));
+            if (pacing->exists("idleRate"))
+                FramePacer::setIdleFrameRate((unsigned int)std::max(pacing->getInt("idleRate"), 1));
+            if (pacing->exists("idleDelay"))
+                FramePacer::setIdleDelay(pacing->getFloat("idleDelay"));
+        }
+    }
+    if (_properties)
+    {
+        Properties* physics = _properties->getNamespace("physics", true);
+        if (physics && physics->getBool("threaded"))
+        {
+            _physicsController->setThreaded(true);
+        }
+        if (physics && physics->exists("shapeCachePath"))
+        {
+            _physicsController->setShapeCachePath(physics->getString("shapeCachePath"));
+        }
+        if (physics && physics->exists("solverIterations"))
+        {
+            _physicsController->setSolverIterations(physics->getInt("solverIterations"));
+        }
+        if (physics && physics->exists("sleeping"))
+        {
+            _physicsController->setSleepingEnabled(physics->getBool("sleeping"));
+        }
+        if (physics && physics->exists("deactivationTime"))
+        {
+            _physicsController->setDeactivationTime(physics->getFloat("deactivationTime"));
+        }
+        if (physics && physics->exists("lodDistance"))
+        {
+            _physicsController->setLodDistance(physics->getFloat("lodDistance"));
+        }
+        if (physics && (physics->exists("lodLinearSleepingThreshold") || physics->exists("lodAngularSleepingThreshold")))
+        {
+            _physicsController->setLodSleepingThresholds(
+                physics->exists("lodLinearSleepingThreshold") ? physics->getFloat("lodLinearSleepingThreshold") : _physicsController->getLodLinearSleepingThreshold(),
+                physics->exists("lodAngularSleepingThreshold") ? physics->getFloat("lodAngularSleepingThreshold") : _physicsController->getLodAngularSleepingThreshold());
+        }
+        if (physics && physics->exists("lodSolverIterations"))
+        {
+            _physicsController->setLodSolverIterations(physics->getInt("lodSolverIterations"));
+        }
+    }
 
+    StartupTrace::begin("AIController::initialize");
     _aiController = new AIController();
     _aiController->initialize();
+    StartupTrace::end();
+    if (_properties)
+    {
+        Properties* ai = _properties->getNamespace("ai", true);
+        if (ai && ai->exists("updateBudget"))
+        {
+            _aiController->setUpdateBudget(ai->getFloat("updateBudget"));
+        }
+        if (ai && ai->getBool("parallel"))
+        {
+            _aiController->setParallelUpdate(true);
+        }
+        if (ai && ai->exists("pathBudget"))
+        {
+            _aiController->setPathBudget(ai->getFloat("pathBudget"));
+        }
+    }
 
+    StartupTrace::begin("ScriptController::initialize");
     _scriptController = new ScriptController();
     _scriptController->initialize();
+    StartupTrace::end();
+    if (_properties)
+    {
+        Properties* lua = _properties->getNamespace("lua", true);
+        if (lua && lua->getFloat("gcBudget") > 0.0f)
+        {
+            _scriptController->setGarbageCollectionBudget(lua->getFloat("gcBudget"));
+        }
+    }
 
     // Load any gamepads, ui or physical.
+    StartupTrace::begin("Game::loadGamepads");
     loadGamepads();
+    StartupTrace::end();
 
     // Set the script callback functions.
     if (_properties)
@@ -125,6 +520,7 @@ bool Game::startup()
         Properties* scripts = _properties->getNamespace("scripts", true);
         if (scripts)
         {
+            StartupTrace::Scope scope("Game::loadScripts");
             const char* callback;
             while ((callback = scripts->getNextProperty()) != NULL)
             {
@@ -161,21 +557,39 @@ void Game::shutdown()
         GP_ASSERT(_physicsController);
         GP_ASSERT(_aiController);
 
+        // Take the graphics context back from the render thread.
+        SAFE_DELETE(_renderThread);
+        _renderThreaded = false;
+
         Platform::signalShutdown();
 
+        // Write the input recording of the session.
+        InputRecorder::finish();
+        Telemetry::stop();
+
 		// Call user finalize
         finalize();
 
+        // Discard any asynchronous loads that have not completed.
+        Bundle::cancelAsyncLoads();
+        Texture::cancelAsyncLoads();
+        Texture::releaseSamplerObjects();
+        Effect::cancelWarmUp();
+        Effect::clearSourceCache();
+
+#ifdef USE_TIMER_QUERY
+        if (_timerQueries[0])
+        {
+            GL_ASSERT( glDeleteQueries(4, _timerQueries) );
+            memset(_timerQueries, 0, sizeof(_timerQueries));
+        }
+#endif
+
 		// Shutdown scripting system first so that any objects allocated in script are released before our subsystems are released
 		_scriptController->finalizeGame();
-		if (_scriptListeners)
-		{
-			for (size_t i = 0; i < _scriptListeners->size(); i++)
-			{
-				SAFE_DELETE((*_scriptListeners)[i]);
-			}
-			SAFE_DELETE(_scriptListeners);
-		}
+
+		// Delete the script listeners of the pending time events while their functions can be released.
+		_timeEvents->clear();
 		_scriptController->finalize();
 
         unsigned int gamepadCount = Gamepad::getGamepadCount();
@@ -195,6 +609,9 @@ void Game::shutdown()
         SAFE_DELETE(_physicsController);
         _aiController->finalize();
         SAFE_DELETE(_aiController);
+
+        _jobScheduler->finalize();
+        SAFE_DELETE(_jobScheduler);
         
         ControlFactory::finalize();
 
@@ -205,11 +622,17 @@ void Game::shutdown()
 
         SAFE_DELETE(_audioListener);
 
+        DebugDraw::finalize();
+        RenderTargetPool::finalize();
         FrameBuffer::finalize();
         RenderState::finalize();
 
         SAFE_DELETE(_properties);
 
+        FileSystem::unmountArchives();
+
+        Logger::finalize();
+
 		_state = UNINITIALIZED;
     }
 }
@@ -224,6 +647,7 @@ void Game::pause()
         GP_ASSERT(_aiController);
         _state = PAUSED;
         _pausedTimeLast = Platform::getAbsoluteTime();
+        FramePacer::wake();
         _animationController->pause();
         _audioController->pause();
         _physicsController->pause();
@@ -247,6 +671,7 @@ void Game::resume()
             GP_ASSERT(_aiController);
             _state = RUNNING;
             _pausedTimeTotal += Platform::getAbsoluteTime() - _pausedTimeLast;
+            FramePacer::wake();
             _animationController->resume();
             _audioController->resume();
             _physicsController->resume();
@@ -280,25 +705,93 @@ void Game::exit()
 }
 
 
+void Game::restoreGraphicsContext()
+{
+    double startTime = getAbsoluteTime();
+
+    // Nothing of the cached state survived the lost context.
+    GLStateCache::invalidate();
+    RenderState::finalize();
+    RenderState::initialize();
+
+#ifdef USE_TIMER_QUERY
+    memset(_timerQueries, 0, sizeof(_timerQueries));
+    _timerQueriesIssued = 0;
+    _timerQueriesRead = 0;
+    _timerQueryActive = false;
+#endif
+
+    Texture::restoreSamplerObjects();
+    GraphicsResource::restoreContext();
+
+    Logger::log(Logger::LEVEL_INFO, "Restored the lost graphics context in %.2f ms.\n", getAbsoluteTime() - startTime);
+}
+
 void Game::frame()
 {
     if (!_initialized)
     {
         // Perform lazy first time initialization
+        StartupTrace::begin("Game::initialize");
         initialize();
+        StartupTrace::end();
+        StartupTrace::begin("ScriptController::initializeGame");
         _scriptController->initializeGame();
+        StartupTrace::end();
         _initialized = true;
 
         // Fire first game resize event
         Platform::resizeEventInternal(_width, _height);
+
+        // Time the rest of the first frame, which ends the startup trace.
+        StartupTrace::begin("First frame");
     }
 
+    FramePacer::beginFrame();
+
+    // Advance the replay clock and deliver the replayed input events of the frame.
+    InputRecorder::beginFrame();
+
 	static double lastFrameTime = Game::getGameTime();
 	double frameTime = getGameTime();
 
     // Fire time events to scheduled TimeListeners
     fireTimeEvents(frameTime);
 
+    // Deliver the input events buffered since the last frame.
+    InputQueue::dispatch();
+
+    // Warn about the memory categories that went over their budget.
+    MemoryTracker::update();
+    GraphicsMemory::update();
+
+    // Start or stop the render thread between frames, while the game thread holds the context.
+    if (_renderThreaded != (_renderThread != NULL))
+    {
+        if (_renderThreaded)
+        {
+            _renderThread = RenderThread::create();
+            _renderThreaded = _renderThread != NULL;
+        }
+        else
+        {
+            SAFE_DELETE(_renderThread);
+        }
+    }
+
+#ifdef GP_USE_PROFILER
+    Profiler::beginFrame();
+#endif
+    if (_renderThread)
+    {
+        // The render thread counts the statistics of the frames it draws.
+        _renderThread->beginFrame();
+    }
+    else
+    {
+        beginRenderStats();
+    }
+
     if (_state == Game::RUNNING)
     {
         GP_ASSERT(_animationController);
@@ -307,38 +800,89 @@ void Game::frame()
         GP_ASSERT(_aiController);
 
         // Update Time.
-        float elapsedTime = (frameTime - lastFrameTime);
+        float elapsedTime = FramePacer::smoothElapsedTime(frameTime - lastFrameTime);
         lastFrameTime = frameTime;
 
-        // Update the scheduled and running animations.
-        _animationController->update(elapsedTime);
-
-        // Update the physics.
-        _physicsController->update(elapsedTime);
-
-        // Update AI.
-        _aiController->update(elapsedTime);
-
-        // Update gamepads.
-        Gamepad::updateInternal(elapsedTime);
-
-        // Application Update.
-        update(elapsedTime);
-
-        // Update forms.
-        Form::updateInternal(elapsedTime);
-
-        // Run script update.
-        _scriptController->update(elapsedTime);
+        // Complete pending asynchronous bundle and texture loads and effect warm-ups.
+        if (_renderThread == NULL)
+        {
+            updateLoading();
+        }
 
-        // Audio Rendering.
-        _audioController->update(elapsedTime);
+        if (_pipelined)
+        {
+            framePipelined(elapsedTime);
+        }
+        else if (_fixedTimeStep > 0.0f)
+        {
+            frameFixed(elapsedTime);
+        }
+        else
+        {
+            // Update the scheduled and running animations.
+            GP_PROFILE_BEGIN("Animation");
+            _animationController->update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Update the physics.
+            GP_PROFILE_BEGIN("Physics");
+            _physicsController->update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Update AI.
+            GP_PROFILE_BEGIN("AI");
+            _aiController->update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Update gamepads.
+            GP_PROFILE_BEGIN("Gamepad");
+            Gamepad::updateInternal(elapsedTime);
+            GP_PROFILE_END();
+
+            // Application Update.
+            GP_PROFILE_BEGIN("Update");
+            update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Update forms.
+            GP_PROFILE_BEGIN("Forms");
+            Form::updateInternal(elapsedTime);
+            GP_PROFILE_END();
+
+            // Run script update.
+            GP_PROFILE_BEGIN("Script");
+            _scriptController->update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Resolve the world matrices changed by the update, parents before children.
+            GP_PROFILE_BEGIN("Transforms");
+            Scene::updateAllWorldMatrices();
+            GP_PROFILE_END();
+
+            // Audio Rendering.
+            GP_PROFILE_BEGIN("Audio");
+            _audioController->update(elapsedTime);
+            GP_PROFILE_END();
+
+            // Step the physics on its own thread while rendering, if threaded.
+            _physicsController->beginStep();
+
+            // Graphics Rendering.
+            renderFrame(elapsedTime);
+        }
 
-        // Graphics Rendering.
-        render(elapsedTime);
+        // Collect script garbage once per frame within its budget.
+        GP_PROFILE_BEGIN("Script GC");
+        _scriptController->collectGarbage();
+        GP_PROFILE_END();
 
-        // Run script render.
-        _scriptController->render(elapsedTime);
+        // Load and evict streamed texture levels based on what was drawn.
+        if (_renderThread == NULL)
+        {
+            GP_PROFILE_BEGIN("Texture Streaming");
+            Texture::updateStreaming();
+            GP_PROFILE_END();
+        }
 
         // Update FPS.
         ++_frameCount;
@@ -364,11 +908,364 @@ void Game::frame()
         _scriptController->update(0);
 
         // Graphics Rendering.
-        render(0);
+        renderFrame(0);
+    }
+
+    if (_renderThread)
+    {
+        // Do the work that needs the graphics context while the render thread is idle, then
+        // have it draw the recorded frame while the next one runs.
+        GP_PROFILE_BEGIN("Render Thread Wait");
+        _renderThread->endFrame();
+        GP_PROFILE_END();
+
+        if (_state == Game::RUNNING)
+        {
+            updateLoading();
+
+            GP_PROFILE_BEGIN("Texture Streaming");
+            Texture::updateStreaming();
+            GP_PROFILE_END();
+        }
+        _renderThread->submitFrame(!FramePacer::isIdle());
+    }
+    else
+    {
+        endRenderStats();
+    }
+    FramePacer::endFrame();
+    Material::updateQuality();
+#ifdef GP_USE_PROFILER
+    Profiler::endFrame();
+#endif
+    Telemetry::endFrame();
+
+    // Free the transient data of the frame all at once.
+    ScratchMemory::endFrame();
+
+    if (StartupTrace::isRecording())
+    {
+        StartupTrace::finish();
+    }
+}
+
+void Game::renderFrame(float elapsedTime)
+{
+    // Nothing changed for a while, so keep the last frame drawn on display.
+    if (FramePacer::updateIdle())
+        return;
+
+#ifndef GP_HEADLESS
+    GP_PROFILE_BEGIN("Render");
+    render(elapsedTime);
+    GP_PROFILE_END();
+
+    GP_PROFILE_BEGIN("Script Render");
+    _scriptController->render(elapsedTime);
+    GP_PROFILE_END();
+#endif
+}
+
+void Game::updateLoading()
+{
+    GP_PROFILE_BEGIN("Loading");
+    Bundle::updateAsyncLoads();
+    Texture::updateAsyncLoads();
+    Effect::updateWarmUp();
+    ParticleEmitter::updateGPUModels();
+    DebugDraw::updateResources();
+    GP_PROFILE_END();
+}
+
+void Game::frameFixed(float elapsedTime)
+{
+    GP_PROFILE_BEGIN("Gamepad");
+    Gamepad::updateInternal(elapsedTime);
+    GP_PROFILE_END();
+
+    // Run as many fixed steps of the simulation as fit in the elapsed time.
+    unsigned int steps = advanceFixedTime(elapsedTime);
+    for (unsigned int i = 0; i < steps; ++i)
+    {
+        Transform::storeInterpolationStates();
+
+        GP_PROFILE_BEGIN("Animation");
+        _animationController->update(_fixedTimeStep);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("Physics");
+        _physicsController->update(_fixedTimeStep);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("AI");
+        _aiController->update(_fixedTimeStep);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("Update");
+        update(_fixedTimeStep);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("Script");
+        _scriptController->update(_fixedTimeStep);
+        GP_PROFILE_END();
+    }
+
+    GP_PROFILE_BEGIN("Forms");
+    Form::updateInternal(elapsedTime);
+    GP_PROFILE_END();
+
+    GP_PROFILE_BEGIN("Transforms");
+    Scene::updateAllWorldMatrices();
+    GP_PROFILE_END();
+
+    GP_PROFILE_BEGIN("Audio");
+    _audioController->update(elapsedTime);
+    GP_PROFILE_END();
+
+    _physicsController->beginStep();
 
-        // Script render.
-        _scriptController->render(0);
+    renderFrame(elapsedTime);
+}
+
+unsigned int Game::advanceFixedTime(float elapsedTime)
+{
+    GP_ASSERT(_fixedTimeStep > 0.0f);
+
+    _fixedTimeAccumulator += elapsedTime;
+    unsigned int steps = (unsigned int)(_fixedTimeAccumulator / _fixedTimeStep);
+    if (steps > _maxFixedSteps)
+    {
+        // Drop the time that cannot be simulated rather than falling further behind each frame.
+        steps = _maxFixedSteps;
+        _fixedTimeAccumulator = fmod(_fixedTimeAccumulator, _fixedTimeStep);
+    }
+    else
+    {
+        _fixedTimeAccumulator -= steps * _fixedTimeStep;
     }
+    _interpolationFactor = std::min(_fixedTimeAccumulator / _fixedTimeStep, 1.0f);
+    return steps;
+}
+
+void Game::setFixedTimeStep(float stepTime, unsigned int maxSteps)
+{
+    GP_ASSERT(stepTime >= 0.0f);
+    GP_ASSERT(maxSteps > 0);
+
+    _fixedTimeStep = stepTime;
+    _maxFixedSteps = maxSteps;
+    _fixedTimeAccumulator = 0.0f;
+    _interpolationFactor = 1.0f;
+}
+
+void Game::framePipelined(float elapsedTime)
+{
+    // Update the systems that must run on the game thread.
+    GP_PROFILE_BEGIN("Gamepad");
+    Gamepad::updateInternal(elapsedTime);
+    GP_PROFILE_END();
+
+    GP_PROFILE_BEGIN("Forms");
+    Form::updateInternal(elapsedTime);
+    GP_PROFILE_END();
+
+    GP_PROFILE_BEGIN("Script");
+    _scriptController->update(elapsedTime);
+    GP_PROFILE_END();
+
+    // The first pipelined frame has nothing captured to render yet.
+    if (!_pipelineCaptured)
+    {
+        captureFrame(elapsedTime);
+        _pipelineCaptured = true;
+    }
+
+    // Run update() for the next frame on a worker thread while this one is rendered from the captured state.
+    // The AI messages and state changes it sends are posted, and delivered by the AI update below.
+    GP_ASSERT(_jobScheduler);
+    JobScheduler::Group group;
+    _simulationTime = _fixedTimeStep > 0.0f ? _fixedTimeStep : elapsedTime;
+    _simulationSteps = _fixedTimeStep > 0.0f ? advanceFixedTime(elapsedTime) : 1;
+    _aiController->_updatingInParallel = true;
+    __renderingCaptured = true;
+    __pipelineSimulating = true;
+    _jobScheduler->run(group, &Game::simulate, this);
+
+    renderFrame(elapsedTime);
+
+    GP_PROFILE_BEGIN("Simulation Wait");
+    _jobScheduler->wait(group);
+    GP_PROFILE_END();
+    __pipelineSimulating = false;
+    __renderingCaptured = false;
+    _aiController->_updatingInParallel = false;
+
+    // The controllers call back into scripts, so they run here rather than on the worker.
+    Transform::fireDeferredScriptEvents();
+    for (unsigned int i = 0; i < _simulationSteps; ++i)
+    {
+        GP_PROFILE_BEGIN("Animation");
+        _animationController->update(_simulationTime);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("Physics");
+        _physicsController->update(_simulationTime);
+        GP_PROFILE_END();
+
+        GP_PROFILE_BEGIN("AI");
+        _aiController->update(_simulationTime);
+        GP_PROFILE_END();
+    }
+
+    GP_PROFILE_BEGIN("Audio");
+    _audioController->update(elapsedTime);
+    GP_PROFILE_END();
+
+    // Capture the simulated state for the next frame to render.
+    GP_PROFILE_BEGIN("Capture");
+    captureFrame(elapsedTime);
+    GP_PROFILE_END();
+}
+
+void Game::simulate(void* arg)
+{
+    // The profiler is not used here since it is only safe on the game thread.
+    Game* game = (Game*)arg;
+    GP_ASSERT(game);
+    for (unsigned int i = 0; i < game->_simulationSteps; ++i)
+    {
+        game->update(game->_simulationTime);
+    }
+}
+
+void Game::captureFrame(float elapsedTime)
+{
+    // The changes made by capture() are captured with the rest of the scenes.
+    capture(elapsedTime);
+    Scene::updateAllWorldMatrices();
+    Scene::captureAll();
+}
+
+bool Game::isRenderingCaptured()
+{
+    return __renderingCaptured;
+}
+
+bool Game::isSimulatingInParallel()
+{
+    return __pipelineSimulating && !__renderingCaptured;
+}
+
+void Game::setPipelined(bool pipelined)
+{
+    if (_pipelined != pipelined)
+    {
+        _pipelined = pipelined;
+        _pipelineCaptured = false;
+    }
+}
+
+void Game::setRenderThreaded(bool threaded)
+{
+    _renderThreaded = threaded;
+}
+
+void Game::capture(float elapsedTime)
+{
+}
+
+void Game::beginRenderStats()
+{
+    memset(&_renderStats, 0, sizeof(_renderStats));
+
+#ifdef USE_TIMER_QUERY
+    if (_timerQueries[0] == 0 && glGenQueries && glGetQueryObjectui64v)
+    {
+        GL_ASSERT( glGenQueries(4, _timerQueries) );
+    }
+
+    // Skip timing this frame if every query is still waiting for its result.
+    _timerQueryActive = _timerQueries[0] && _timerQueriesIssued - _timerQueriesRead < 4;
+    if (_timerQueryActive)
+    {
+        GL_ASSERT( glBeginQuery(GL_TIME_ELAPSED, _timerQueries[_timerQueriesIssued % 4]) );
+        ++_timerQueriesIssued;
+    }
+#endif
+}
+
+void Game::endRenderStats()
+{
+#ifdef USE_TIMER_QUERY
+    if (_timerQueries[0])
+    {
+        if (_timerQueryActive)
+        {
+            GL_ASSERT( glEndQuery(GL_TIME_ELAPSED) );
+            _timerQueryActive = false;
+        }
+
+        // Read back finished queries, oldest first, without stalling on pending ones.
+        while (_timerQueriesRead < _timerQueriesIssued)
+        {
+            GLuint query = _timerQueries[_timerQueriesRead % 4];
+            GLuint available = 0;
+            GL_ASSERT( glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available) );
+            if (!available)
+                break;
+
+            GLuint64 elapsed = 0;
+            GL_ASSERT( glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed) );
+            _gpuTime = (float)(elapsed / 1000000.0);
+            ++_timerQueriesRead;
+        }
+#ifdef GL_GPU_DISJOINT_EXT
+        // Results are meaningless if the GPU was interrupted (e.g. by a frequency change).
+        GLint disjoint = 0;
+        GL_ASSERT( glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint) );
+        if (disjoint)
+        {
+            _gpuTime = -1.0f;
+        }
+#endif
+    }
+#endif
+
+    if (__glErrorCheck == ERROR_CHECK_FRAME)
+    {
+        // Each error flag is read once, and a lost context reports itself once, so this ends.
+        for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError())
+        {
+            GP_WARN("GL error 0x%x raised during the frame.", error);
+        }
+    }
+
+    _lastRenderStats = _renderStats;
+    _lastRenderStats.gpuTime = _gpuTime;
+}
+
+void Game::countDrawCall(GLenum primitiveType, unsigned int vertexCount, unsigned int instanceCount)
+{
+    ++_renderStats.drawCalls;
+    switch (primitiveType)
+    {
+    case GL_TRIANGLES:
+        _renderStats.triangles += (vertexCount / 3) * instanceCount;
+        break;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+        if (vertexCount > 2)
+            _renderStats.triangles += (vertexCount - 2) * instanceCount;
+        break;
+    default:
+        break;
+    }
+}
+
+void Game::countBufferUpload(unsigned int size)
+{
+    ++_renderStats.bufferUploads;
+    _renderStats.bufferUploadSize += size;
 }
 
 void Game::renderOnce(const char* function)
@@ -400,12 +1297,30 @@ void Game::updateOnce()
 
 void Game::setViewport(const Rectangle& viewport)
 {
-    _viewport = viewport;
-    glViewport((GLuint)viewport.x, (GLuint)viewport.y, (GLuint)viewport.width, (GLuint)viewport.height);
+    // Viewports set by recorded calls must not change the viewport of the game thread.
+    bool executing = CommandBuffer::isExecuting();
+    if (!executing)
+    {
+        _viewport = viewport;
+    }
+
+    // While rendering on the render thread, the viewport is also recorded at the start of each frame.
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setViewport(viewport);
+    else if (_renderThread == NULL || executing)
+        glViewport((GLuint)viewport.x, (GLuint)viewport.y, (GLuint)viewport.width, (GLuint)viewport.height);
 }
 
 void Game::clear(ClearFlags flags, const Vector4& clearColor, float clearDepth, int clearStencil)
 {
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->clear(flags, clearColor, clearDepth, clearStencil);
+        return;
+    }
+
     GLbitfield bits = 0;
     if (flags & CLEAR_COLOR)
     {
@@ -531,59 +1446,45 @@ void Game::getArguments(int* argc, char*** argv) const
     Platform::getArguments(argc, argv);
 }
 
-void Game::schedule(float timeOffset, TimeListener* timeListener, void* cookie)
+unsigned int Game::schedule(float timeOffset, TimeListener* timeListener, void* cookie)
 {
     GP_ASSERT(_timeEvents);
-    TimeEvent timeEvent(getGameTime() + timeOffset, timeListener, cookie);
-    _timeEvents->push(timeEvent);
+    return _timeEvents->schedule(getGameTime() + timeOffset, timeListener, cookie, false);
 }
 
-void Game::schedule(float timeOffset, const char* function)
+unsigned int Game::schedule(float timeOffset, const char* function)
 {
-    if (!_scriptListeners)
-        _scriptListeners = new std::vector<ScriptListener*>();
-
-    ScriptListener* listener = new ScriptListener(function);
-    _scriptListeners->push_back(listener);
-    schedule(timeOffset, listener, NULL);
+    // The event owns its listener, which is deleted once it has been fired or cancelled.
+    GP_ASSERT(_timeEvents);
+    return _timeEvents->schedule(getGameTime() + timeOffset, new ScriptListener(function), NULL, true);
 }
 
-void Game::fireTimeEvents(double frameTime)
+bool Game::cancelTimeEvent(unsigned int handle)
 {
-    while (_timeEvents->size() > 0)
-    {
-        const TimeEvent* timeEvent = &_timeEvents->top();
-        if (timeEvent->time > frameTime)
-        {
-            break;
-        }
-        if (timeEvent->listener)
-        {
-            timeEvent->listener->timeEvent(frameTime - timeEvent->time, timeEvent->cookie);
-        }
-        _timeEvents->pop();
-    }
+    GP_ASSERT(_timeEvents);
+    return _timeEvents->cancel(handle);
 }
 
-Game::ScriptListener::ScriptListener(const char* url)
+unsigned int Game::cancelTimeEvents(TimeListener* timeListener)
 {
-    function = Game::getInstance()->getScriptController()->loadUrl(url);
+    GP_ASSERT(_timeEvents);
+    return _timeEvents->cancel(timeListener);
 }
 
-void Game::ScriptListener::timeEvent(long timeDiff, void* cookie)
+void Game::fireTimeEvents(double frameTime)
 {
-    Game::getInstance()->getScriptController()->executeFunction<void>(function.c_str(), "l", timeDiff);
+    GP_ASSERT(_timeEvents);
+    _timeEvents->fire(frameTime);
 }
 
-Game::TimeEvent::TimeEvent(double time, TimeListener* timeListener, void* cookie)
-    : time(time), listener(timeListener), cookie(cookie)
+Game::ScriptListener::ScriptListener(const char* url)
+    : function(Game::getInstance()->getScriptController()->loadUrl(url).c_str())
 {
 }
 
-bool Game::TimeEvent::operator<(const TimeEvent& v) const
+void Game::ScriptListener::timeEvent(long timeDiff, void* cookie)
 {
-    // The first element of std::priority_queue is the greatest.
-    return time > v.time;
+    function.call<void>(timeDiff);
 }
 
 Properties* Game::getConfig() const
@@ -638,7 +1539,7 @@ void Game::loadGamepads()
                 {
                     const char* gamepadFormPath = inner->getString("form");
                     GP_ASSERT(gamepadFormPath);
-                    Gamepad* gamepad = Gamepad::add(gamepadFormPath);
+                    Gamepad* gamepad = Gamepad::add(gamepadFormPath, inner->getBool("lightweight"));
                     GP_ASSERT(gamepad);
                 }
             }
@@ -10,15 +10,19 @@
 #include "AnimationController.h"
 #include "PhysicsController.h"
 #include "AIController.h"
+#include "JobScheduler.h"
 #include "AudioListener.h"
 #include "Rectangle.h"
 #include "Vector4.h"
 #include "TimeListener.h"
+#include "ScriptFunction.h"
 
 namespace gameplay
 {
 
+class RenderThread;
 class ScriptController;
+class TimerWheel;
 
 /**
  * Defines the base class your game will extend for game initialization, logic and platform delegates.
@@ -31,7 +35,29 @@ class ScriptController;
 class Game
 {
     friend class Platform;
+    friend class InputRecorder;
     friend class ShutdownListener;
+    friend class Camera;
+    friend class CommandBuffer;
+    friend class DebugDraw;
+    friend class Effect;
+    friend class GLStateCache;
+    friend class LightClusters;
+    friend class Mesh;
+    friend class MeshBatch;
+    friend class MeshPart;
+    friend class MeshSkin;
+    friend class Model;
+    friend class Node;
+    friend class OcclusionCuller;
+    friend class Octree;
+    friend class RenderQueue;
+    friend class RenderState;
+    friend class RenderThread;
+    friend class Scene;
+    friend class ShadowMap;
+    friend class Texture;
+    friend class Transform;
 
 public:
     
@@ -59,6 +85,71 @@ public:
         CLEAR_COLOR_DEPTH_STENCIL = CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL
     };
 
+    /**
+     * Defines how GL errors are detected.
+     *
+     * @script{ignore}
+     */
+    enum ErrorCheck
+    {
+        /**
+         * GL errors are not checked.
+         */
+        ERROR_CHECK_OFF,
+
+        /**
+         * The GL errors raised during a frame are read and logged once at the end of the frame,
+         * without locating the calls that raised them.
+         */
+        ERROR_CHECK_FRAME,
+
+        /**
+         * GL_ASSERT reads the GL error after every call and asserts that it succeeded. This is
+         * only available in debug builds, and stalls the pipeline of some drivers.
+         */
+        ERROR_CHECK_CALL,
+
+        /**
+         * The driver reports errors and warnings through the debug output of KHR_debug (or GL 4.3)
+         * as they happen, without reading the GL error. The output is synchronous, so errors assert
+         * in the stack of the call that raised them. Drivers may only report messages for debug contexts.
+         */
+        ERROR_CHECK_DEBUG_OUTPUT
+    };
+
+    /**
+     * Defines the rendering statistics of a frame.
+     *
+     * Draw calls are counted where the engine issues them (models, terrain patches,
+     * mesh batches, sprites, fonts and forms), so raw GL calls made by the game are
+     * not included.
+     *
+     * @script{ignore}
+     */
+    struct RenderStats
+    {
+        /** The number of draw calls issued. An instanced draw counts as one. */
+        unsigned int drawCalls;
+        /** The number of triangles drawn. */
+        unsigned int triangles;
+        /** The number of times a different shader program was bound. */
+        unsigned int programBinds;
+        /** The number of times a texture was bound. */
+        unsigned int textureBinds;
+        /** The number of program, texture unit, texture, buffer and vertex array binds skipped because the state was bound already. */
+        unsigned int redundantBinds;
+        /** The number of vertex and index buffer uploads. */
+        unsigned int bufferUploads;
+        /** The number of bytes uploaded to vertex and index buffers. */
+        unsigned int bufferUploadSize;
+        /**
+         * The GPU time spent on the frame in milliseconds, or -1 if GPU timer queries
+         * are not supported. Timer results arrive a few frames late, so this holds the
+         * most recent result available when the frame ended.
+         */
+        float gpuTime;
+    };
+
     /**
      * Destructor.
      */
@@ -85,6 +176,30 @@ public:
      */
     static void setVsync(bool enable);
 
+    /**
+     * Sets how GL errors are detected.
+     *
+     * Debug builds default to ERROR_CHECK_DEBUG_OUTPUT, and release builds to ERROR_CHECK_OFF.
+     * The default can be configured in the game config (graphics { errorCheck = FRAME } for example),
+     * which lets profiling builds keep their assertions without paying for glGetError() on every call.
+     * Debug output falls back to ERROR_CHECK_CALL in debug builds and to ERROR_CHECK_FRAME in release
+     * builds when it is not supported, and so does ERROR_CHECK_CALL to ERROR_CHECK_FRAME in release builds.
+     *
+     * This must be called while the GL context is current, such as from initialize() or render().
+     *
+     * @param check The error checking mode.
+     * @script{ignore}
+     */
+    static void setGLErrorCheck(ErrorCheck check);
+
+    /**
+     * Gets how GL errors are detected.
+     *
+     * @return The error checking mode in use, after any fallback.
+     * @script{ignore}
+     */
+    static ErrorCheck getGLErrorCheck();
+
     /**
      * Gets the total absolute running time (in milliseconds) since Game::run().
      * 
@@ -163,6 +278,17 @@ public:
      */
     inline unsigned int getFrameRate() const;
 
+    /**
+     * Gets the rendering statistics of the last completed frame.
+     *
+     * Comparing the GPU time against the CPU frame time shows whether the game is
+     * limited by the GPU or the CPU.
+     *
+     * @return The rendering statistics of the last frame.
+     * @script{ignore}
+     */
+    inline const RenderStats& getRenderStats() const;
+
     /**
      * Gets the game window width.
      * 
@@ -255,6 +381,124 @@ public:
      */
     inline AIController* getAIController() const;
 
+    /**
+     * Gets the job scheduler used to run work in parallel on the worker threads.
+     *
+     * @return The job scheduler for this game.
+     * @script{ignore}
+     */
+    inline JobScheduler* getJobScheduler() const;
+
+    /**
+     * Enables or disables the pipelined frame mode.
+     *
+     * In pipelined mode update() runs on a job worker thread while the game thread renders
+     * the previous frame, so the displayed frame lags the simulation by one frame. The
+     * animation, physics, AI, gamepad, form, script and audio updates still run on the game
+     * thread, after update() has returned, since they call back into scripts.
+     *
+     * At the end of each frame the engine captures the world matrices and bounding spheres
+     * of the nodes in the scenes, the matrices of their cameras and the active camera of each
+     * scene, and the models drawn by render() use the captured state. Their skin matrix
+     * palettes, light influences and spatial indices are also resolved at the end of the
+     * frame. Nodes and cameras changed by render() itself draw their current state, and a
+     * camera made active by render() is only active for the frame it draws.
+     *
+     * While pipelined, update() must not make graphics calls or call into scripts, and must
+     * not add, remove or delete nodes, change the components attached to them (models,
+     * lights, particle emitters, terrains and forms) or change the materials and meshes that
+     * render() draws. Changes of that kind go in capture(), which runs on the game thread,
+     * as does everything else render() reads (such as the state of particle emitters, which
+     * capture() should update). Script callbacks of transforms moved by update() and AI
+     * messages sent by update() are delivered on the game thread once update() returns.
+     * Spatial queries of a scene made by update() see the nodes as they were at the end of
+     * the previous frame. With a fixed time step, update() runs each step before the game
+     * thread updates the animation, physics and AI for each step, and the rendered frames
+     * are not interpolated. Input events are delivered between frames, when no simulation
+     * is running.
+     *
+     * The mode can also be enabled with the 'pipelined' property in the 'jobs' section of
+     * the game configuration file.
+     *
+     * @param pipelined true to pipeline simulation and rendering, false to run them in sequence.
+     * @script{ignore}
+     */
+    void setPipelined(bool pipelined);
+
+    /**
+     * Determines if the pipelined frame mode is enabled.
+     *
+     * @return true if simulation and rendering are pipelined, false otherwise.
+     * @script{ignore}
+     */
+    inline bool isPipelined() const;
+
+    /**
+     * Sets whether the rendering of each frame is executed by a dedicated render thread.
+     *
+     * When enabled, render() is recorded into a command buffer on the game thread instead
+     * of being sent to OpenGL (see CommandBuffer), and a render thread executes it and swaps
+     * the buffers while the game thread runs the next frame, so the game logic and the
+     * driver work on separate processors. The displayed frame lags the game by one frame.
+     * The graphics context is owned by the render thread during each frame, so update()
+     * and render() must not make graphics calls other than the drawing that can be recorded;
+     * loading resources is done with the asynchronous loaders, which the game thread completes
+     * between frames.
+     *
+     * The mode takes effect at the start of the next frame and needs platform support for
+     * moving the graphics context between threads: it is ignored, with a warning, on the
+     * platforms that lack it.
+     *
+     * The mode can also be enabled with the 'renderThread' property in the 'graphics' section
+     * of the game configuration file.
+     *
+     * @param threaded true to render on a dedicated thread, false to render on the game thread.
+     * @script{ignore}
+     */
+    void setRenderThreaded(bool threaded);
+
+    /**
+     * Determines if the rendering is executed by a dedicated render thread.
+     *
+     * @return true if a render thread executes the recorded frames, false otherwise.
+     * @script{ignore}
+     */
+    inline bool isRenderThreaded() const;
+
+    /**
+     * Sets the fixed time step of the simulation.
+     *
+     * With a fixed time step, the animation, physics, AI, update() and script update
+     * phases run zero or more times per frame, each time with exactly the step time,
+     * while forms, audio and rendering still run once per frame with the elapsed time.
+     * Rendering can draw transforms part way between the last two steps using
+     * Transform::setInterpolated() and getInterpolationFactor().
+     *
+     * The rate can also be set with the 'rate' (in steps per second) and 'maxSteps'
+     * properties in the 'timestep' section of the game configuration file.
+     *
+     * @param stepTime The time of each step in milliseconds, or 0 to simulate with the time elapsed each frame.
+     * @param maxSteps The maximum number of steps simulated per frame. Time beyond that is dropped.
+     * @script{ignore}
+     */
+    void setFixedTimeStep(float stepTime, unsigned int maxSteps = 4);
+
+    /**
+     * Gets the fixed time step of the simulation.
+     *
+     * @return The time of each step in milliseconds, or 0 if the simulation uses the time elapsed each frame.
+     * @script{ignore}
+     */
+    inline float getFixedTimeStep() const;
+
+    /**
+     * Gets how far the frame being rendered is between the last two fixed time steps.
+     *
+     * @return The interpolation factor between the previous (0) and the last (1) step, or 1 without a fixed time step.
+     * @script{ignore}
+     */
+    inline float getInterpolationFactor() const;
+
     /**
      * Gets the script controller for managing control of Lua scripts
      * associated with the game.
@@ -578,13 +822,18 @@ public:
     /**
      * Schedules a time event to be sent to the given TimeListener a given number of game milliseconds from now.
      * Game time stops while the game is paused. A time offset of zero will fire the time event in the next frame.
+     *
+     * Events are fired with a resolution of one millisecond, in the order of their milliseconds.
+     * Scheduling and cancelling events takes constant time, whatever the number of pending events.
      * 
      * @param timeOffset The number of game milliseconds in the future to schedule the event to be fired.
      * @param timeListener The TimeListener that will receive the event.
      * @param cookie The cookie data that the time event will contain.
+     *
+     * @return The handle of the event, which can be passed to cancelTimeEvent. Handles are never zero.
      * @script{ignore}
      */
-    void schedule(float timeOffset, TimeListener* timeListener, void* cookie = 0);
+    unsigned int schedule(float timeOffset, TimeListener* timeListener, void* cookie = 0);
 
     /**
      * Schedules a time event to be sent to the given TimeListener a given number of game milliseconds from now.
@@ -595,8 +844,31 @@ public:
      * 
      * @param timeOffset The number of game milliseconds in the future to schedule the event to be fired.
      * @param function The Lua script function that will receive the event.
+     *
+     * @return The handle of the event, which can be passed to cancelTimeEvent. Handles are never zero.
+     */
+    unsigned int schedule(float timeOffset, const char* function);
+
+    /**
+     * Cancels a time event scheduled by schedule(), so that it is never fired.
+     *
+     * @param handle The handle returned when the event was scheduled.
+     *
+     * @return true if the event was cancelled, false if it has already been fired or cancelled.
+     */
+    bool cancelTimeEvent(unsigned int handle);
+
+    /**
+     * Cancels every time event scheduled for the given TimeListener, such as a listener about to be deleted.
+     *
+     * This visits every pending event, so events should rather be cancelled by handle when there are many.
+     *
+     * @param timeListener The TimeListener to cancel the events of.
+     *
+     * @return The number of events cancelled.
+     * @script{ignore}
      */
-    void schedule(float timeOffset, const char* function);
+    unsigned int cancelTimeEvents(TimeListener* timeListener);
 
     /**
      * Opens an URL in an external browser, if available.
@@ -644,6 +916,20 @@ protected:
      */
     virtual void render(float elapsedTime) = 0;
 
+    /**
+     * Capture callback for copying the state needed to render a frame in pipelined mode.
+     *
+     * Called on the game thread once the simulation of a frame has completed, before the
+     * engine captures the state of the scenes and the next simulation starts, and once
+     * before the first pipelined frame. Copy the state of the game that render() reads here,
+     * and make the changes to the scenes that update() is not allowed to make.
+     *
+     * @param elapsedTime The elapsed game time.
+     * @see setPipelined
+     * @script{ignore}
+     */
+    virtual void capture(float elapsedTime);
+
     /**
      * Renders a single frame once and then swaps it to the display.
      *
@@ -686,8 +972,8 @@ private:
          */
         void timeEvent(long timeDiff, void* cookie);
 
-        /** Holds the name of the Lua script function to call back. */
-        std::string function;
+        /** The Lua script function to call back. */
+        ScriptFunction function;
     };
 
     struct ShutdownListener : public TimeListener
@@ -695,20 +981,6 @@ private:
         void timeEvent(long timeDiff, void* cookie);
     };
 
-    /**
-     * TimeEvent represents the event that is sent to TimeListeners as a result of calling Game::schedule().
-     */
-    class TimeEvent
-    {
-    public:
-
-        TimeEvent(double time, TimeListener* timeListener, void* cookie);
-        bool operator<(const TimeEvent& v) const;
-        double time;
-        TimeListener* listener;
-        void* cookie;
-    };
-
     /**
      * Constructor.
      *
@@ -743,6 +1015,84 @@ private:
      */
     void loadGamepads();
 
+    /**
+     * Recreates the GL objects of the game after the platform replaced a lost context with a new one.
+     *
+     * Called by the platform on the thread that owns the new context, before the next frame.
+     */
+    void restoreGraphicsContext();
+
+    /**
+     * Resets the rendering statistics and starts the GPU timer for a new frame.
+     */
+    void beginRenderStats();
+
+    /**
+     * Stops the GPU timer, collects finished timer results and publishes the rendering statistics of the frame.
+     */
+    void endRenderStats();
+
+    /**
+     * Counts a draw call in the rendering statistics of the current frame.
+     *
+     * @param primitiveType The GL primitive type drawn.
+     * @param vertexCount The number of vertices (or indices) drawn per instance.
+     * @param instanceCount The number of instances drawn.
+     */
+    static void countDrawCall(GLenum primitiveType, unsigned int vertexCount, unsigned int instanceCount = 1);
+
+    /**
+     * Counts a vertex or index buffer upload in the rendering statistics of the current frame.
+     *
+     * @param size The number of bytes uploaded.
+     */
+    static void countBufferUpload(unsigned int size);
+
+    /**
+     * Completes the pending asynchronous loads and effect warm-ups, with the graphics context current.
+     */
+    void updateLoading();
+
+    /**
+     * Renders the frame and runs the script render callbacks. Does nothing in headless builds.
+     */
+    void renderFrame(float elapsedTime);
+
+    /**
+     * Runs a frame in pipelined mode: the simulation runs on a worker while the captured state renders.
+     */
+    void framePipelined(float elapsedTime);
+
+    /**
+     * Runs a frame with a fixed time step.
+     */
+    void frameFixed(float elapsedTime);
+
+    /**
+     * Adds the elapsed time to the fixed time step accumulator and returns the number of steps to simulate.
+     */
+    unsigned int advanceFixedTime(float elapsedTime);
+
+    /**
+     * Runs the update() steps of a frame on a job worker thread in pipelined mode.
+     */
+    static void simulate(void* arg);
+
+    /**
+     * Calls capture(), then captures the state of the scenes for the next pipelined frame to render.
+     */
+    void captureFrame(float elapsedTime);
+
+    /**
+     * Determines if the calling thread is drawing a pipelined frame from the captured state of the scenes.
+     */
+    static bool isRenderingCaptured();
+
+    /**
+     * Determines if the calling thread is simulating a pipelined frame while the game thread draws the previous one.
+     */
+    static bool isSimulatingInParallel();
+
     bool _initialized;                          // If game has initialized yet.
     State _state;                               // The game state.
     unsigned int _pausedCount;                  // Number of times pause() has been called.
@@ -751,6 +1101,13 @@ private:
     double _frameLastFPS;                       // The last time the frame count was updated.
     unsigned int _frameCount;                   // The current frame count.
     unsigned int _frameRate;                    // The current frame rate.
+    static RenderStats _renderStats;            // The rendering statistics of the current frame.
+    RenderStats _lastRenderStats;               // The rendering statistics of the last completed frame.
+    GLuint _timerQueries[4];                    // Ring of GPU timer queries (0 if timer queries are unsupported).
+    unsigned int _timerQueriesIssued;           // The number of timer queries started.
+    unsigned int _timerQueriesRead;             // The number of timer query results read.
+    bool _timerQueryActive;                     // If a timer query was started for the current frame.
+    float _gpuTime;                             // The most recent GPU frame time, in milliseconds.
     unsigned int _width;                        // The game's display width.
     unsigned int _height;                       // The game's display height.
     Rectangle _viewport;                        // the games's current viewport.
@@ -762,10 +1119,20 @@ private:
     AudioController* _audioController;          // Controls audio sources that are playing in the game.
     PhysicsController* _physicsController;      // Controls the simulation of a physics scene and entities.
     AIController* _aiController;                // Controls AI simulation.
+    JobScheduler* _jobScheduler;                // Runs jobs on the worker threads.
+    bool _pipelined;                            // If simulation and rendering are pipelined.
+    bool _pipelineCaptured;                     // If capture() has been called since pipelining was enabled.
+    bool _renderThreaded;                       // If a render thread was requested.
+    RenderThread* _renderThread;                // The thread executing the recorded frames (NULL when rendering on the game thread).
+    float _simulationTime;                      // The elapsed time of each simulation step of the frame being simulated.
+    unsigned int _simulationSteps;              // The number of simulation steps of the frame being simulated.
+    float _fixedTimeStep;                       // The fixed time step of the simulation (0 if not fixed).
+    unsigned int _maxFixedSteps;                // The maximum number of fixed steps per frame.
+    float _fixedTimeAccumulator;                // The elapsed time not yet simulated in fixed steps.
+    float _interpolationFactor;                 // How far rendering is between the last two fixed steps.
     AudioListener* _audioListener;              // The audio listener in 3D space.
-    std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >* _timeEvents;     // Contains the scheduled time events.
-    ScriptController* _scriptController;            // Controls the scripting engine.
-    std::vector<ScriptListener*>* _scriptListeners; // Lua script listeners.
+    TimerWheel* _timeEvents;                    // Contains the scheduled time events.
+    ScriptController* _scriptController;        // Controls the scripting engine.
 
     // Note: Do not add STL object member variables on the stack; this will cause false memory leaks to be reported.
 
@@ -19,6 +19,11 @@ inline unsigned int Game::getFrameRate() const
     return _frameRate;
 }
 
+inline const Game::RenderStats& Game::getRenderStats() const
+{
+    return _lastRenderStats;
+}
+
 inline unsigned int Game::getWidth() const
 {
     return _width;
@@ -63,6 +68,31 @@ inline AIController* Game::getAIController() const
     return _aiController;
 }
 
+inline JobScheduler* Game::getJobScheduler() const
+{
+    return _jobScheduler;
+}
+
+inline bool Game::isPipelined() const
+{
+    return _pipelined;
+}
+
+inline bool Game::isRenderThreaded() const
+{
+    return _renderThread != NULL;
+}
+
+inline float Game::getFixedTimeStep() const
+{
+    return _fixedTimeStep;
+}
+
+inline float Game::getInterpolationFactor() const
+{
+    return _interpolationFactor;
+}
+
 template <class T>
 void Game::renderOnce(T* instance, void (T::*method)(void*), void* cookie)
 {
@@ -5,20 +5,19 @@
 #include "Platform.h"
 #include "Form.h"
 #include "JoystickControl.h"
+#include "Theme.h"
+#include "FramePacer.h"
 
 namespace gameplay
 {
 
 static std::vector<Gamepad*> __gamepads;
 
-Gamepad::Gamepad(const char* formPath)
+Gamepad::Gamepad(const char* formPath, bool lightweight)
     : _handle((GamepadHandle)INT_MAX), _buttonCount(0), _joystickCount(0), _triggerCount(0), _vendorId(0), _productId(0),
-      _form(NULL), _buttons(0)
+      _form(NULL), _buttons(0), _formPath(formPath ? formPath : ""), _lightweight(lightweight), _touchTheme(NULL)
 {
     GP_ASSERT(formPath);
-    _form = Form::create(formPath);
-    GP_ASSERT(_form);
-    _form->setConsumeInputEvents(false);
     _vendorString = "None";
     _productString = "Virtual";
 
@@ -33,13 +32,23 @@ Gamepad::Gamepad(const char* formPath)
         _uiButtons[i] = NULL;
     }
 
+    if (_lightweight)
+    {
+        loadTouchControls();
+        return;
+    }
+
+    _form = Form::create(formPath);
+    GP_ASSERT(_form);
+    _form->setConsumeInputEvents(false);
+
     bindGamepadControls(_form);
 }
 
 Gamepad::Gamepad(GamepadHandle handle, unsigned int buttonCount, unsigned int joystickCount, unsigned int triggerCount,
                  unsigned int vendorId, unsigned int productId, const char* vendorString, const char* productString)
     : _handle(handle), _buttonCount(buttonCount), _joystickCount(joystickCount), _triggerCount(triggerCount),
-      _vendorId(vendorId), _productId(productId), _form(NULL), _buttons(0)
+      _vendorId(vendorId), _productId(productId), _form(NULL), _buttons(0), _lightweight(false), _touchTheme(NULL)
 {
     if (vendorString)
     {
@@ -63,6 +72,7 @@ Gamepad::~Gamepad()
     {
         SAFE_RELEASE(_form);
     }
+    SAFE_RELEASE(_touchTheme);
 }
 
 Gamepad* Gamepad::add(GamepadHandle handle, unsigned int buttonCount, unsigned int joystickCount, unsigned int triggerCount,
@@ -76,9 +86,9 @@ Gamepad* Gamepad::add(GamepadHandle handle, unsigned int buttonCount, unsigned i
     return gamepad;
 }
 
-Gamepad* Gamepad::add(const char* formPath)
+Gamepad* Gamepad::add(const char* formPath, bool lightweight)
 {
-    Gamepad* gamepad = new Gamepad(formPath);
+    Gamepad* gamepad = new Gamepad(formPath, lightweight);
 
     __gamepads.push_back(gamepad);
     Game::getInstance()->gamepadEvent(CONNECTED_EVENT, gamepad);
@@ -155,6 +165,320 @@ void Gamepad::bindGamepadControls(Container* container)
     }
 }
 
+void Gamepad::loadTouchControls()
+{
+    _touchJoysticks.clear();
+    _touchButtons.clear();
+    _buttonCount = 0;
+    _joystickCount = 0;
+    SAFE_RELEASE(_touchTheme);
+
+    // The form is only loaded to lay the controls out. It is released once their bounds
+    // and images are kept, so it is not updated or drawn with the other forms.
+    Form* form = Form::create(_formPath.c_str());
+    if (form == NULL)
+    {
+        GP_WARN("Failed to load the form of the virtual gamepad '%s'.", _formPath.c_str());
+        return;
+    }
+    _touchTheme = form->getTheme();
+    if (_touchTheme)
+        _touchTheme->addRef();
+    gatherTouchControls(form);
+    SAFE_RELEASE(form);
+}
+
+void Gamepad::gatherTouchControls(Container* container)
+{
+    std::vector<Control*> controls = container->getControls();
+    std::vector<Control*>::iterator itr = controls.begin();
+
+    for (; itr != controls.end(); itr++)
+    {
+        Control* control = *itr;
+        GP_ASSERT(control);
+
+        if (!control->isVisible())
+        {
+            continue;
+        }
+        else if (control->isContainer())
+        {
+            gatherTouchControls((Container*) control);
+        }
+        else if (std::strcmp("joystick", control->getType()) == 0)
+        {
+            JoystickControl* joystickControl = (JoystickControl*)control;
+            if (joystickControl->getIndex() >= 2)
+                continue;
+
+            TouchJoystick joystick;
+            joystick.bounds = joystickControl->getAbsoluteBounds();
+            joystick.outerSize.set(joystickControl->_screenRegion.width, joystickControl->_screenRegion.height);
+            if (joystickControl->_innerSize)
+                joystick.innerSize.set(*joystickControl->_innerSize);
+            joystick.radius = joystickControl->_radius;
+            joystick.relative = joystickControl->_relative;
+            joystick.index = joystickControl->getIndex();
+            joystick.contactIndex = -1;
+            joystick.center.set(joystick.bounds.x + joystick.bounds.width * 0.5f, joystick.bounds.y + joystick.bounds.height * 0.5f);
+
+            // Images the control does not have are kept with a zero color, and not drawn.
+            for (int i = 0; i < 2; ++i)
+            {
+                Control::State state = i ? Control::ACTIVE : Control::NORMAL;
+                Theme::ThemeImage* outer = joystickControl->getImage("outer", state);
+                Theme::ThemeImage* inner = joystickControl->getImage("inner", state);
+                if (outer)
+                {
+                    const Theme::UVs& uvs = outer->getUVs();
+                    joystick.outerUVs[i].set(uvs.u1, uvs.v1, uvs.u2, uvs.v2);
+                    joystick.outerColors[i] = outer->getColor();
+                }
+                if (inner)
+                {
+                    const Theme::UVs& uvs = inner->getUVs();
+                    joystick.innerUVs[i].set(uvs.u1, uvs.v1, uvs.u2, uvs.v2);
+                    joystick.innerColors[i] = inner->getColor();
+                }
+            }
+
+            _touchJoysticks.push_back(joystick);
+            _joystickCount = std::max(_joystickCount, joystick.index + 1);
+        }
+        else if (std::strcmp("button", control->getType()) == 0)
+        {
+            Button* buttonControl = (Button*)control;
+            if (buttonControl->getDataBinding() >= 20)
+                continue;
+
+            TouchButton button;
+            button.bounds = buttonControl->getAbsoluteBounds();
+            button.mapping = buttonControl->getDataBinding();
+            button.contactIndex = -1;
+            for (int i = 0; i < 2; ++i)
+            {
+                Theme::Skin* skin = buttonControl->getSkin(i ? Control::ACTIVE : Control::NORMAL);
+                if (skin)
+                {
+                    const Theme::Border& border = skin->getBorder();
+                    button.borders[i].set(border.left, border.top, border.right, border.bottom);
+                    for (int area = 0; area < 9; ++area)
+                    {
+                        const Theme::UVs& uvs = skin->getUVs((Theme::Skin::SkinArea)area);
+                        button.uvs[i][area].set(uvs.u1, uvs.v1, uvs.u2, uvs.v2);
+                    }
+                    button.colors[i] = skin->getColor();
+                }
+            }
+
+            _touchButtons.push_back(button);
+            _buttonCount++;
+        }
+    }
+}
+
+bool Gamepad::touchEventInternal(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
+{
+    bool consumed = false;
+    for (size_t i = 0, count = __gamepads.size(); i < count; ++i)
+    {
+        Gamepad* gamepad = __gamepads[i];
+        if (gamepad->_lightweight && gamepad->touchEvent(evt, x, y, contactIndex))
+            consumed = true;
+    }
+    return consumed;
+}
+
+void Gamepad::resizeEventInternal(unsigned int width, unsigned int height)
+{
+    for (size_t i = 0, count = __gamepads.size(); i < count; ++i)
+    {
+        Gamepad* gamepad = __gamepads[i];
+        if (gamepad->_lightweight)
+        {
+            // Release what is held down, since the controls may move.
+            for (size_t j = 0; j < gamepad->_touchJoysticks.size(); ++j)
+                gamepad->setJoystickValue(gamepad->_touchJoysticks[j].index, 0.0f, 0.0f);
+            gamepad->setButtons(0);
+            gamepad->loadTouchControls();
+        }
+    }
+}
+
+bool Gamepad::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
+{
+    switch (evt)
+    {
+    case Touch::TOUCH_PRESS:
+        for (size_t i = 0, count = _touchJoysticks.size(); i < count; ++i)
+        {
+            TouchJoystick& joystick = _touchJoysticks[i];
+            if (joystick.contactIndex < 0 && joystick.bounds.contains((float)x, (float)y))
+            {
+                joystick.contactIndex = (int)contactIndex;
+                if (joystick.relative)
+                    joystick.center.set((float)x, (float)y);
+                moveTouchJoystick(joystick, x, y);
+                return true;
+            }
+        }
+        for (size_t i = 0, count = _touchButtons.size(); i < count; ++i)
+        {
+            TouchButton& button = _touchButtons[i];
+            if (button.contactIndex < 0 && button.bounds.contains((float)x, (float)y))
+            {
+                button.contactIndex = (int)contactIndex;
+                setButtons(_buttons | (1 << button.mapping));
+                return true;
+            }
+        }
+        break;
+
+    case Touch::TOUCH_MOVE:
+        for (size_t i = 0, count = _touchJoysticks.size(); i < count; ++i)
+        {
+            TouchJoystick& joystick = _touchJoysticks[i];
+            if (joystick.contactIndex == (int)contactIndex)
+            {
+                moveTouchJoystick(joystick, x, y);
+                return true;
+            }
+        }
+        for (size_t i = 0, count = _touchButtons.size(); i < count; ++i)
+        {
+            if (_touchButtons[i].contactIndex == (int)contactIndex)
+                return true;
+        }
+        break;
+
+    case Touch::TOUCH_RELEASE:
+        for (size_t i = 0, count = _touchJoysticks.size(); i < count; ++i)
+        {
+            TouchJoystick& joystick = _touchJoysticks[i];
+            if (joystick.contactIndex == (int)contactIndex)
+            {
+                joystick.contactIndex = -1;
+                joystick.displacement.set(0.0f, 0.0f);
+                setJoystickValue(joystick.index, 0.0f, 0.0f);
+                return true;
+            }
+        }
+        for (size_t i = 0, count = _touchButtons.size(); i < count; ++i)
+        {
+            TouchButton& button = _touchButtons[i];
+            if (button.contactIndex == (int)contactIndex)
+            {
+                button.contactIndex = -1;
+                setButtons(_buttons & ~(1 << button.mapping));
+                return true;
+            }
+        }
+        break;
+    }
+
+    return false;
+}
+
+void Gamepad::moveTouchJoystick(TouchJoystick& joystick, int x, int y)
+{
+    // The displacement is capped to the radius like JoystickControl.
+    joystick.displacement.set(x - joystick.center.x, joystick.center.y - y);
+
+    Vector2 value;
+    if ((fabs(joystick.displacement.x) > joystick.radius) || (fabs(joystick.displacement.y) > joystick.radius))
+    {
+        joystick.displacement.normalize();
+        value.set(joystick.displacement);
+        joystick.displacement.scale(joystick.radius);
+    }
+    else
+    {
+        value.set(joystick.displacement);
+        GP_ASSERT(joystick.radius);
+        value.scale(1.0f / joystick.radius);
+    }
+
+    setJoystickValue(joystick.index, value.x, value.y);
+}
+
+void Gamepad::drawTouchControls()
+{
+    if (!_touchTheme || (_touchJoysticks.empty() && _touchButtons.empty()))
+        return;
+
+    SpriteBatch* batch = _touchTheme->getSpriteBatch();
+    GP_ASSERT(batch);
+
+    const Rectangle& viewport = Game::getInstance()->getViewport();
+    Matrix projection;
+    Matrix::createOrthographicOffCenter(0, viewport.width, viewport.height, 0, 0, 1, &projection);
+    batch->setProjectionMatrix(projection);
+    batch->start();
+
+    for (size_t i = 0, count = _touchButtons.size(); i < count; ++i)
+    {
+        const TouchButton& button = _touchButtons[i];
+        int state = button.contactIndex >= 0 ? 1 : 0;
+        const Vector4& color = button.colors[state];
+        if (color.w <= 0.0f)
+            continue;
+
+        const Rectangle& bounds = button.bounds;
+        const Vector4& border = button.borders[state];
+        const Vector4* uvs = button.uvs[state];
+        if (border.x == 0.0f && border.y == 0.0f && border.z == 0.0f && border.w == 0.0f)
+        {
+            const Vector4& center = uvs[Theme::Skin::CENTER];
+            batch->draw(bounds.x, bounds.y, bounds.width, bounds.height, center.x, center.y, center.z, center.w, color);
+            continue;
+        }
+
+        // Draw the nine areas of the skin, as Control::drawBorder does.
+        float xs[3] = { bounds.x, bounds.x + border.x, bounds.x + bounds.width - border.z };
+        float ys[3] = { bounds.y, bounds.y + border.y, bounds.y + bounds.height - border.w };
+        float widths[3] = { border.x, bounds.width - border.x - border.z, border.z };
+        float heights[3] = { border.y, bounds.height - border.y - border.w, border.w };
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                if (widths[column] <= 0.0f || heights[row] <= 0.0f)
+                    continue;
+                const Vector4& area = uvs[row * 3 + column];
+                batch->draw(xs[column], ys[row], widths[column], heights[row], area.x, area.y, area.z, area.w, color);
+            }
+        }
+    }
+
+    for (size_t i = 0, count = _touchJoysticks.size(); i < count; ++i)
+    {
+        const TouchJoystick& joystick = _touchJoysticks[i];
+        int state = joystick.contactIndex >= 0 ? 1 : 0;
+
+        // A relative joystick is only drawn while it is held, where it was touched.
+        if (joystick.relative && !state)
+            continue;
+
+        float x = joystick.center.x - joystick.outerSize.x * 0.5f;
+        float y = joystick.center.y - joystick.outerSize.y * 0.5f;
+        const Vector4& outerUVs = joystick.outerUVs[state];
+        const Vector4& innerUVs = joystick.innerUVs[state];
+        if (joystick.outerColors[state].w > 0.0f)
+        {
+            batch->draw(x, y, joystick.outerSize.x, joystick.outerSize.y,
+                outerUVs.x, outerUVs.y, outerUVs.z, outerUVs.w, joystick.outerColors[state]);
+        }
+        if (joystick.innerColors[state].w > 0.0f)
+        {
+            batch->draw(x + joystick.displacement.x, y - joystick.displacement.y, joystick.innerSize.x, joystick.innerSize.y,
+                innerUVs.x, innerUVs.y, innerUVs.z, innerUVs.w, joystick.innerColors[state]);
+        }
+    }
+
+    batch->finish();
+}
+
 unsigned int Gamepad::getGamepadCount()
 {
     return __gamepads.size();
@@ -274,9 +598,20 @@ const char* Gamepad::getProductString() const
 
 void Gamepad::update(float elapsedTime)
 {
-    if (!_form)
+    if (!_form && !_lightweight)
     {
+        unsigned int buttons = _buttons;
+        Vector2 joysticks[2] = { _joysticks[0], _joysticks[1] };
+        float triggers[2] = { _triggers[0], _triggers[1] };
+
         Platform::pollGamepadState(this);
+
+        // Polled controls don't send events, so wake the game from idle mode when they move.
+        if (_buttons != buttons || _joysticks[0] != joysticks[0] || _joysticks[1] != joysticks[1] ||
+            _triggers[0] != triggers[0] || _triggers[1] != triggers[1])
+        {
+            FramePacer::wake();
+        }
     }
 }
 
@@ -295,6 +630,10 @@ void Gamepad::draw()
     {
         _form->draw();
     }
+    else if (_lightweight)
+    {
+        drawTouchControls();
+    }
 }
 
 unsigned int Gamepad::getButtonCount() const
@@ -376,7 +715,7 @@ float Gamepad::getTriggerValue(unsigned int triggerId) const
 
 bool Gamepad::isVirtual() const
 {
-    return _form;
+    return _form || _lightweight;
 }
 
 Form* Gamepad::getForm() const
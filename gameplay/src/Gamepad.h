@@ -2,6 +2,9 @@
 #define GAMEPAD_H_
 
 #include "Vector2.h"
+#include "Vector4.h"
+#include "Rectangle.h"
+#include "Touch.h"
 
 namespace gameplay
 {
@@ -11,12 +14,30 @@ class Container;
 class Form;
 class JoystickControl;
 class Platform;
+class Theme;
 
 /**
  * Defines a gamepad interface for handling input from joysticks and buttons.
  *
  * A gamepad can be either physical or virtual. Most platform support up to 4
  * gamepad controllers connected simulataneously.
+ *
+ * A virtual gamepad is defined by a .form file with joystick and button controls, and is
+ * by default a Form which is updated, laid out and drawn like any other. It can instead be made
+ * lightweight in the "gamepad" section of game.config:
+ * @code
+   gamepad
+   {
+       form = res/common/gamepad.form
+       lightweight = true
+   }
+ * @endcode
+ * A lightweight gamepad only loads the form to lay out its controls, keeps their screen bounds
+ * and theme images, and releases it. Touches are then mapped directly to the buttons and
+ * joysticks of the gamepad before forms see them, the gamepad is not updated each frame, and
+ * draw() draws all of its controls in a single sprite batch. Its state is read like the state
+ * of a physical gamepad, and changes to it are reported with gamepad events. It has no Form,
+ * and the form is loaded again to lay the controls out when the game is resized.
  */
 class Gamepad
 {
@@ -142,17 +163,16 @@ public:
     const char* getProductString() const;
 
     /**
-     * Returns whether the gamepad is currently represented with a UI form or not.
+     * Returns whether the gamepad is a virtual gamepad, represented with a UI form or lightweight controls.
      *
-     * @return true if the gamepad is currently represented by a UI form; false if the gamepad is
-     *         not represented by a UI form.
+     * @return true if the gamepad is virtual; false if the gamepad is physical.
      */
     bool isVirtual() const;
 
     /**
      * Gets the Form used to represent this gamepad.
      *
-     * @return the Form used to represent this gamepad. NULL if the gamepad is not represented with a Form.
+     * @return the Form used to represent this gamepad. NULL if the gamepad is physical or lightweight.
      */
     Form* getForm() const;
 
@@ -167,18 +187,52 @@ public:
     void update(float elapsedTime);
 
     /**
-     * Draws the gamepad if it is based on a form and if the form is enabled.
+     * Draws the gamepad if it is based on a form and if the form is enabled, or if it is lightweight.
      */
     void draw();
 
 private:
 
+    /**
+     * Defines a joystick of a lightweight virtual gamepad.
+     */
+    struct TouchJoystick
+    {
+        Rectangle bounds;
+        Vector2 outerSize;
+        Vector2 innerSize;
+        float radius;
+        bool relative;
+        unsigned int index;
+        int contactIndex;
+        Vector2 center;
+        Vector2 displacement;
+        Vector4 outerUVs[2];        // The UVs of the outer image, in the normal and active states.
+        Vector4 outerColors[2];
+        Vector4 innerUVs[2];
+        Vector4 innerColors[2];
+    };
+
+    /**
+     * Defines a button of a lightweight virtual gamepad.
+     */
+    struct TouchButton
+    {
+        Rectangle bounds;
+        unsigned int mapping;
+        int contactIndex;
+        Vector4 borders[2];         // The border of the skin (left, top, right, bottom), in the normal and active states.
+        Vector4 uvs[2][9];          // The UVs of the areas of the skin.
+        Vector4 colors[2];
+    };
+
     /**
      * Constructs a gamepad from the specified .form file.
      *
      * @param formPath The path the the .form file.
+     * @param lightweight true to keep the controls of the form and release it, false to keep the form.
      */ 
-    Gamepad(const char* formPath);
+    Gamepad(const char* formPath, bool lightweight = false);
 
     /**
      * Constructs a physical gamepad.
@@ -212,7 +266,19 @@ private:
                         unsigned int buttonCount, unsigned int joystickCount, unsigned int triggerCount,
                         unsigned int vendorId, unsigned int productId, const char* vendorString, const char* productString);
 
-    static Gamepad* add(const char* formPath);
+    static Gamepad* add(const char* formPath, bool lightweight = false);
+
+    /**
+     * Maps a touch to the controls of the lightweight virtual gamepads.
+     *
+     * @return true if the touch was consumed by a control.
+     */
+    static bool touchEventInternal(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex);
+
+    /**
+     * Lays the controls of the lightweight virtual gamepads out again for the new size of the game.
+     */
+    static void resizeEventInternal(unsigned int width, unsigned int height);
 
     static void remove(GamepadHandle handle);
 
@@ -234,6 +300,31 @@ private:
     
     void bindGamepadControls(Container* container);
 
+    /**
+     * Loads the form of a lightweight virtual gamepad, keeps its controls and releases it.
+     */
+    void loadTouchControls();
+
+    /**
+     * Keeps the bounds and images of the joysticks and buttons of a container of the form of a lightweight gamepad.
+     */
+    void gatherTouchControls(Container* container);
+
+    /**
+     * Maps a touch to the controls of this lightweight gamepad.
+     */
+    bool touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex);
+
+    /**
+     * Moves a joystick of this lightweight gamepad to the position of its touch.
+     */
+    void moveTouchJoystick(TouchJoystick& joystick, int x, int y);
+
+    /**
+     * Draws the controls of this lightweight gamepad.
+     */
+    void drawTouchControls();
+
     GamepadHandle _handle;        // The handle of the Gamepad.
     unsigned int _buttonCount;    // Number of buttons.
     unsigned int _joystickCount;  // Number of joysticks.
@@ -248,6 +339,11 @@ private:
     unsigned int _buttons;
     Vector2 _joysticks[2];
     float _triggers[2];
+    std::string _formPath;
+    bool _lightweight;
+    Theme* _touchTheme;
+    std::vector<TouchJoystick> _touchJoysticks;
+    std::vector<TouchButton> _touchButtons;
 };
 
 }
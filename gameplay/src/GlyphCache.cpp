@@ -0,0 +1,367 @@
+#include "Base.h"
+#include "GlyphCache.h"
+#include "FileSystem.h"
+#include "GLStateCache.h"
+#include "CommandBuffer.h"
+
+#ifdef USE_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_ADVANCES_H
+#endif
+
+// Number of pixels left empty between the cells, so filtering does not bleed in neighbouring glyphs
+#define GLYPH_CACHE_CELL_PADDING 1
+
+namespace gameplay
+{
+
+GlyphCache::GlyphCache()
+    : _library(NULL), _face(NULL), _fontData(NULL), _size(0), _baseline(0), _cellWidth(0), _cellHeight(0), _columns(0), _textureSize(0),
+      _texture(NULL), _usedCells(0), _batchCount(0), _generation(0), _thread(NULL), _quit(false)
+{
+}
+
+GlyphCache::~GlyphCache()
+{
+    if (_thread)
+    {
+        _queueMutex.lock();
+        _quit = true;
+        _queueCondition.signal();
+        _queueMutex.unlock();
+        SAFE_DELETE(_thread);
+    }
+    for (size_t i = 0, count = _bitmaps.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_bitmaps[i]);
+    }
+
+#ifdef USE_FREETYPE
+    if (_face)
+        FT_Done_Face(_face);
+    if (_library)
+        FT_Done_FreeType(_library);
+#endif
+    SAFE_DELETE_ARRAY(_fontData);
+    SAFE_RELEASE(_texture);
+}
+
+GlyphCache* GlyphCache::create(const char* path, unsigned int size, unsigned int textureSize)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(size > 0);
+
+#ifdef USE_FREETYPE
+    unsigned int cellSize = size + GLYPH_CACHE_CELL_PADDING;
+    if (textureSize < cellSize * 2)
+    {
+        GP_ERROR("Glyph cache texture of size %u is too small for glyphs of size %u.", textureSize, size);
+        return NULL;
+    }
+
+    int fileSize = 0;
+    char* fontData = FileSystem::readAll(path, &fileSize);
+    if (fontData == NULL)
+    {
+        GP_ERROR("Failed to read font file '%s'.", path);
+        return NULL;
+    }
+
+    GlyphCache* cache = new GlyphCache();
+    cache->_fontData = fontData;
+    if (FT_Init_FreeType(&cache->_library) != 0 ||
+        FT_New_Memory_Face(cache->_library, (const FT_Byte*)fontData, fileSize, 0, &cache->_face) != 0 ||
+        FT_Set_Pixel_Sizes(cache->_face, 0, size) != 0)
+    {
+        GP_ERROR("Failed to load font file '%s'.", path);
+        SAFE_DELETE(cache);
+        return NULL;
+    }
+    FT_Select_Charmap(cache->_face, FT_ENCODING_UNICODE);
+
+    // Place the baseline so that the ascender and the descender of the face fit in a cell.
+    FT_Face face = cache->_face;
+    int height = face->ascender - face->descender;
+    cache->_size = size;
+    cache->_baseline = height > 0 ? (unsigned int)(size * face->ascender / height) : size * 4 / 5;
+    cache->_cellWidth = size;
+    cache->_cellHeight = size;
+    cache->_columns = textureSize / cellSize;
+    cache->_textureSize = textureSize;
+
+    // Cell 0 stays empty, and is drawn for the glyphs that are not in the texture yet.
+    unsigned int rows = textureSize / cellSize;
+    Cell cell = { 0, 0 };
+    cache->_cells.resize(cache->_columns * rows, cell);
+    cache->_usedCells = 1;
+
+    std::vector<unsigned char> clear(textureSize * textureSize, 0);
+    cache->_texture = Texture::create(Texture::ALPHA, textureSize, textureSize, &clear[0], false);
+    if (cache->_texture == NULL)
+    {
+        GP_ERROR("Failed to create the glyph cache texture for font '%s'.", path);
+        SAFE_DELETE(cache);
+        return NULL;
+    }
+
+    cache->_thread = Thread::create(workerMain, cache);
+    if (cache->_thread == NULL)
+    {
+        GP_WARN("Failed to start the glyph cache thread for font '%s'.", path);
+        SAFE_DELETE(cache);
+        return NULL;
+    }
+    return cache;
+#else
+    GP_ERROR("Failed to load font file '%s'; rasterizing fonts requires building with USE_FREETYPE.", path);
+    return NULL;
+#endif
+}
+
+Texture* GlyphCache::getTexture() const
+{
+    return _texture;
+}
+
+unsigned int GlyphCache::getCellCount() const
+{
+    return (unsigned int)_cells.size() - 1;
+}
+
+unsigned int GlyphCache::getResidentCount() const
+{
+    return _usedCells - 1;
+}
+
+unsigned int GlyphCache::getGeneration() const
+{
+    return _generation;
+}
+
+const Font::Glyph* GlyphCache::getGlyph(unsigned int code)
+{
+    std::map<unsigned int, Entry>::iterator itr = _entries.find(code);
+    if (itr == _entries.end())
+    {
+        Entry entry;
+        entry.glyph.code = code;
+        entry.glyph.width = 0;
+        entry.cell = 0;
+        entry.supported = measure(code, &entry.glyph.width);
+        entry.requested = false;
+        setCell(&entry.glyph, 0);
+        itr = _entries.insert(std::make_pair(code, entry)).first;
+    }
+
+    Entry& entry = itr->second;
+    if (!entry.supported)
+        return NULL;
+
+    if (entry.cell > 0)
+    {
+        _cells[entry.cell].lastUsed = _batchCount;
+    }
+    else if (!entry.requested)
+    {
+        entry.requested = true;
+        Mutex::Lock lock(_queueMutex);
+        _requests.push_back(code);
+        _queueCondition.signal();
+    }
+    return &entry.glyph;
+}
+
+void GlyphCache::update()
+{
+    ++_batchCount;
+
+    std::vector<Bitmap*> bitmaps;
+    {
+        Mutex::Lock lock(_queueMutex);
+        if (_bitmaps.empty())
+            return;
+        bitmaps.swap(_bitmaps);
+    }
+
+    // While recording, the pixels are copied into the command buffer and copied into the texture when it is executed.
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->retain(_texture);
+    }
+    else
+    {
+        GLStateCache::bindTexture(GL_TEXTURE_2D, _texture->getHandle());
+        GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    }
+    for (size_t i = 0, count = bitmaps.size(); i < count; ++i)
+    {
+        Bitmap* bitmap = bitmaps[i];
+        std::map<unsigned int, Entry>::iterator itr = _entries.find(bitmap->code);
+        GP_ASSERT(itr != _entries.end());
+        Entry& entry = itr->second;
+
+        unsigned int cell = allocateCell();
+        if (cell == 0)
+        {
+            // Every cell holds a glyph drawn by the current batch, so request the glyph again later.
+            entry.requested = false;
+            SAFE_DELETE(bitmap);
+            continue;
+        }
+
+        unsigned int cellSize = _size + GLYPH_CACHE_CELL_PADDING;
+        if (buffer)
+        {
+            size_t pixelCount = _cellWidth * _cellHeight;
+            RecordedUpload* upload = (RecordedUpload*)buffer->callWithData(&GlyphCache::uploadRecorded, sizeof(RecordedUpload) + pixelCount);
+            upload->texture = _texture->getHandle();
+            upload->x = (cell % _columns) * cellSize;
+            upload->y = (cell / _columns) * cellSize;
+            upload->width = _cellWidth;
+            upload->height = _cellHeight;
+            memcpy(upload + 1, &bitmap->pixels[0], pixelCount);
+        }
+        else
+        {
+            GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, (cell % _columns) * cellSize, (cell / _columns) * cellSize, _cellWidth, _cellHeight,
+                GL_ALPHA, GL_UNSIGNED_BYTE, &bitmap->pixels[0]) );
+        }
+
+        _cells[cell].code = bitmap->code;
+        _cells[cell].lastUsed = _batchCount;
+        entry.cell = (int)cell;
+        entry.requested = false;
+        setCell(&entry.glyph, cell);
+        ++_generation;
+        SAFE_DELETE(bitmap);
+    }
+}
+
+void GlyphCache::uploadRecorded(void* arg)
+{
+    RecordedUpload* upload = (RecordedUpload*)arg;
+    GP_ASSERT(upload);
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, upload->texture);
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, upload->x, upload->y, upload->width, upload->height, GL_ALPHA, GL_UNSIGNED_BYTE, upload + 1) );
+}
+
+unsigned int GlyphCache::allocateCell()
+{
+    if (_usedCells < _cells.size())
+        return _usedCells++;
+
+    // Reuse the cell of the glyph drawn least recently, unless it is drawn by the current batch.
+    unsigned int oldest = 0;
+    for (unsigned int i = 1, count = (unsigned int)_cells.size(); i < count; ++i)
+    {
+        if (oldest == 0 || _cells[i].lastUsed < _cells[oldest].lastUsed)
+            oldest = i;
+    }
+    if (oldest == 0 || _cells[oldest].lastUsed >= _batchCount)
+        return 0;
+
+    std::map<unsigned int, Entry>::iterator itr = _entries.find(_cells[oldest].code);
+    GP_ASSERT(itr != _entries.end());
+    itr->second.cell = 0;
+    setCell(&itr->second.glyph, 0);
+    return oldest;
+}
+
+void GlyphCache::setCell(Font::Glyph* glyph, unsigned int cell) const
+{
+    GP_ASSERT(glyph);
+
+    unsigned int cellSize = _size + GLYPH_CACHE_CELL_PADDING;
+    float x = (float)((cell % _columns) * cellSize);
+    float y = (float)((cell / _columns) * cellSize);
+    glyph->uvs[0] = x / _textureSize;
+    glyph->uvs[1] = y / _textureSize;
+    glyph->uvs[2] = (x + glyph->width) / _textureSize;
+    glyph->uvs[3] = (y + _cellHeight) / _textureSize;
+}
+
+bool GlyphCache::measure(unsigned int code, unsigned int* advance)
+{
+    GP_ASSERT(advance);
+
+#ifdef USE_FREETYPE
+    Mutex::Lock lock(_faceMutex);
+    FT_UInt index = FT_Get_Char_Index(_face, code);
+    FT_Fixed value;
+    if (index == 0 || FT_Get_Advance(_face, index, FT_LOAD_DEFAULT, &value) != 0)
+        return false;
+
+    // The advance is in 16.16 fixed point pixels.
+    *advance = std::min((unsigned int)((value + 0x8000) >> 16), _cellWidth);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GlyphCache::rasterize(unsigned int code, unsigned char* pixels)
+{
+    GP_ASSERT(pixels);
+
+#ifdef USE_FREETYPE
+    Mutex::Lock lock(_faceMutex);
+    if (FT_Load_Char(_face, code, FT_LOAD_RENDER) != 0)
+        return;
+
+    // Copy the coverage of the glyph on the baseline of the cell, clipped to the cell.
+    FT_GlyphSlot slot = _face->glyph;
+    const FT_Bitmap& bitmap = slot->bitmap;
+    int left = slot->bitmap_left;
+    int top = (int)_baseline - slot->bitmap_top;
+    for (int row = 0; row < (int)bitmap.rows; ++row)
+    {
+        int y = top + row;
+        if (y < 0 || y >= (int)_cellHeight)
+            continue;
+        const unsigned char* src = bitmap.buffer + row * bitmap.pitch;
+        for (int column = 0; column < (int)bitmap.width; ++column)
+        {
+            int x = left + column;
+            if (x >= 0 && x < (int)_cellWidth)
+                pixels[y * _cellWidth + x] = src[column];
+        }
+    }
+#endif
+}
+
+int GlyphCache::workerMain(void* arg)
+{
+    GlyphCache* cache = (GlyphCache*)arg;
+    GP_ASSERT(cache);
+
+    while (true)
+    {
+        unsigned int code;
+        {
+            Mutex::Lock lock(cache->_queueMutex);
+            while (cache->_requests.empty() && !cache->_quit)
+            {
+                cache->_queueCondition.wait(cache->_queueMutex);
+            }
+            if (cache->_quit)
+                break;
+            code = cache->_requests.front();
+            cache->_requests.pop_front();
+        }
+
+        Bitmap* bitmap = new Bitmap();
+        bitmap->code = code;
+        bitmap->pixels.resize(cache->_cellWidth * cache->_cellHeight, 0);
+        cache->rasterize(code, &bitmap->pixels[0]);
+
+        Mutex::Lock lock(cache->_queueMutex);
+        cache->_bitmaps.push_back(bitmap);
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,205 @@
+#ifndef GLYPHCACHE_H_
+#define GLYPHCACHE_H_
+
+#include "Font.h"
+#include "Thread.h"
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+namespace gameplay
+{
+
+/**
+ * Defines a cache of the glyphs of a font that are rasterized at runtime, as they are first drawn.
+ *
+ * The glyphs are rasterized from a TrueType or OpenType file by FreeType on a worker thread, and
+ * copied into the cells of the cache texture with partial texture updates when they are ready.
+ * When every cell is in use, the cells of the glyphs that were drawn least recently are reused,
+ * so a font with tens of thousands of glyphs (such as a CJK font) only keeps the glyphs that are
+ * on screen in its texture.
+ *
+ * The advances of the glyphs are read when they are first laid out, so text is laid out at once.
+ * Glyphs that are not in the texture yet are drawn from an empty cell, and appear once they are
+ * rasterized, usually on the next frame.
+ *
+ * Rasterizing requires the engine to be built with USE_FREETYPE defined and linked with FreeType.
+ *
+ * @script{ignore}
+ */
+class GlyphCache
+{
+    friend class Font;
+
+public:
+
+    /**
+     * Creates a glyph cache for the given font file.
+     *
+     * @param path The path of the TrueType or OpenType font file.
+     * @param size The size of the glyphs, in pixels.
+     * @param textureSize The width and height of the cache texture.
+     *
+     * @return The new cache, or NULL if the font could not be loaded.
+     */
+    static GlyphCache* create(const char* path, unsigned int size, unsigned int textureSize);
+
+    /**
+     * Destructor. Waits for the worker thread to finish.
+     */
+    ~GlyphCache();
+
+    /**
+     * Returns the texture the glyphs are rasterized into.
+     *
+     * @return The cache texture.
+     */
+    Texture* getTexture() const;
+
+    /**
+     * Returns the number of cells of the cache texture, which is the largest number of glyphs resident at once.
+     *
+     * @return The number of cells.
+     */
+    unsigned int getCellCount() const;
+
+    /**
+     * Returns the number of glyphs in the cache texture.
+     *
+     * @return The number of resident glyphs.
+     */
+    unsigned int getResidentCount() const;
+
+private:
+
+    /**
+     * Defines a glyph laid out by the font.
+     */
+    struct Entry
+    {
+        Font::Glyph glyph;
+        int cell;
+        bool supported;
+        bool requested;
+    };
+
+    /**
+     * Defines a cell of the cache texture.
+     */
+    struct Cell
+    {
+        unsigned int code;
+        unsigned int lastUsed;
+    };
+
+    /**
+     * Defines a glyph rasterized by the worker thread.
+     */
+    struct Bitmap
+    {
+        unsigned int code;
+        std::vector<unsigned char> pixels;
+    };
+
+    /**
+     * Constructor.
+     */
+    GlyphCache();
+
+    /**
+     * Hidden copy constructor.
+     */
+    GlyphCache(const GlyphCache& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    GlyphCache& operator=(const GlyphCache&);
+
+    /**
+     * Returns the glyph of a character code, queueing it for rasterization if it is not in the texture.
+     *
+     * @return The glyph, or NULL if the font has no glyph for the code.
+     */
+    const Font::Glyph* getGlyph(unsigned int code);
+
+    /**
+     * Copies the glyphs rasterized since the last call into the texture. Called by the font before its
+     * sprite batch starts, so the cells of the glyphs drawn by the batch are not reused before it draws.
+     */
+    void update();
+
+    /**
+     * The header of the pixels of a glyph copied into a command buffer by update(), followed by the pixels.
+     */
+    struct RecordedUpload
+    {
+        TextureHandle texture;
+        GLint x;
+        GLint y;
+        GLsizei width;
+        GLsizei height;
+    };
+
+    /**
+     * Copies the pixels of a glyph recorded by update() into the texture, when the command buffer is executed.
+     */
+    static void uploadRecorded(void* arg);
+
+    /**
+     * Returns the number of changes to the glyphs in the texture, so that text laid out before can be laid out again.
+     */
+    unsigned int getGeneration() const;
+
+    /**
+     * Reads the advance of a glyph, returning false if the font has no glyph for the code.
+     */
+    bool measure(unsigned int code, unsigned int* advance);
+
+    /**
+     * Rasterizes a glyph into a cell sized block of pixels.
+     */
+    void rasterize(unsigned int code, unsigned char* pixels);
+
+    /**
+     * Sets the texture coordinates of a glyph to those of a cell.
+     */
+    void setCell(Font::Glyph* glyph, unsigned int cell) const;
+
+    /**
+     * Returns a cell to copy a glyph into, or 0 if all the cells are in use by the current batch.
+     */
+    unsigned int allocateCell();
+
+    /**
+     * The function run by the worker thread.
+     */
+    static int workerMain(void* arg);
+
+    FT_LibraryRec_* _library;
+    FT_FaceRec_* _face;
+    char* _fontData;
+    unsigned int _size;
+    unsigned int _baseline;
+    unsigned int _cellWidth;
+    unsigned int _cellHeight;
+    unsigned int _columns;
+    unsigned int _textureSize;
+    Texture* _texture;
+    std::map<unsigned int, Entry> _entries;
+    std::vector<Cell> _cells;
+    unsigned int _usedCells;
+    unsigned int _batchCount;
+    unsigned int _generation;
+    Thread* _thread;
+    Mutex _faceMutex;
+    Mutex _queueMutex;
+    Condition _queueCondition;
+    std::deque<unsigned int> _requests;
+    std::vector<Bitmap*> _bitmaps;
+    bool _quit;
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "Base.h"
+#include "GraphicsMemory.h"
+#include "MemoryTracker.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+static volatile unsigned int __usage[GraphicsMemory::CATEGORY_COUNT];
+static volatile unsigned int __totalUsage = 0;
+static volatile unsigned int __highWaterMark = 0;
+static unsigned int __budget = 0;
+static bool __overBudget = false;
+static bool __mipmapEviction = true;
+static std::vector<GraphicsMemory::Listener*> __listeners;
+
+static const char* __categoryNames[GraphicsMemory::CATEGORY_COUNT] = { "texture", "renderTarget", "depthStencil", "vertexBuffer", "indexBuffer" };
+
+// The category of the MemoryTracker the memory of each category is also counted against.
+static const MemoryTracker::Category __trackerCategories[GraphicsMemory::CATEGORY_COUNT] =
+{
+    MemoryTracker::TEXTURE, MemoryTracker::TEXTURE, MemoryTracker::TEXTURE, MemoryTracker::MESH, MemoryTracker::MESH
+};
+
+const char* GraphicsMemory::getCategoryName(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __categoryNames[category];
+}
+
+unsigned int GraphicsMemory::getUsage(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __usage[category];
+}
+
+unsigned int GraphicsMemory::getTotalUsage()
+{
+    return __totalUsage;
+}
+
+unsigned int GraphicsMemory::getHighWaterMark()
+{
+    return __highWaterMark;
+}
+
+void GraphicsMemory::resetHighWaterMark()
+{
+    __highWaterMark = __totalUsage;
+}
+
+void GraphicsMemory::setBudget(unsigned int bytes)
+{
+    __budget = bytes;
+    __overBudget = false;
+}
+
+unsigned int GraphicsMemory::getBudget()
+{
+    return __budget;
+}
+
+bool GraphicsMemory::isOverBudget()
+{
+    return __budget > 0 && __totalUsage > __budget;
+}
+
+void GraphicsMemory::setMipmapEviction(bool enabled)
+{
+    __mipmapEviction = enabled;
+}
+
+bool GraphicsMemory::isMipmapEviction()
+{
+    return __mipmapEviction;
+}
+
+void GraphicsMemory::addListener(Listener* listener)
+{
+    GP_ASSERT(listener);
+    __listeners.push_back(listener);
+}
+
+void GraphicsMemory::removeListener(Listener* listener)
+{
+    std::vector<Listener*>::iterator itr = std::find(__listeners.begin(), __listeners.end(), listener);
+    if (itr != __listeners.end())
+        __listeners.erase(itr);
+}
+
+void GraphicsMemory::track(Category category, unsigned int bytes)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    if (bytes == 0)
+        return;
+
+    Atomic::add(&__usage[category], bytes);
+    MemoryTracker::track(__trackerCategories[category], bytes);
+
+    // Raise the high-water mark, unless another thread raised it higher in the meantime.
+    unsigned int total = Atomic::add(&__totalUsage, bytes);
+    unsigned int mark = __highWaterMark;
+    while (total > mark)
+    {
+        unsigned int previous = Atomic::compareExchange(&__highWaterMark, mark, total);
+        if (previous == mark)
+            break;
+        mark = previous;
+    }
+}
+
+void GraphicsMemory::untrack(Category category, unsigned int bytes)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    if (bytes == 0)
+        return;
+
+    Atomic::subtract(&__usage[category], bytes);
+    Atomic::subtract(&__totalUsage, bytes);
+    MemoryTracker::untrack(__trackerCategories[category], bytes);
+}
+
+void GraphicsMemory::print()
+{
+    gameplay::print("[graphics memory] %-14s %12s\n", "category", "usage");
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        gameplay::print("[graphics memory] %-14s %12u\n", __categoryNames[i], __usage[i]);
+    }
+    gameplay::print("[graphics memory] %-14s %12u (high-water %u, budget %u)\n", "total", __totalUsage, __highWaterMark, __budget);
+}
+
+unsigned int GraphicsMemory::getStreamingLimit(unsigned int streamingMemory)
+{
+    if (__budget == 0 || !__mipmapEviction)
+        return UINT_MAX;
+
+    // The streamed textures get whatever the other objects leave of the budget.
+    unsigned int total = __totalUsage;
+    unsigned int others = total > streamingMemory ? total - streamingMemory : 0;
+    return others < __budget ? __budget - others : 0;
+}
+
+void GraphicsMemory::update()
+{
+    bool overBudget = isOverBudget();
+    if (overBudget && !__overBudget)
+    {
+        unsigned int usage = __totalUsage;
+        GP_WARN("The estimated GPU memory (%u bytes) is over its budget of %u bytes.", usage, __budget);
+
+        // Copy the listeners, since they may remove themselves while they are notified.
+        std::vector<Listener*> listeners(__listeners);
+        for (size_t i = 0, count = listeners.size(); i < count; ++i)
+        {
+            listeners[i]->graphicsMemoryOverBudget(usage, __budget);
+        }
+    }
+    __overBudget = overBudget;
+}
+
+}
@@ -0,0 +1,210 @@
+#ifndef GRAPHICSMEMORY_H_
+#define GRAPHICSMEMORY_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines an estimate of the GPU memory used by the GL objects of the engine, with an optional budget.
+ *
+ * Memory is counted for each kind of GL object when its storage is allocated, from its size and
+ * format: the levels of compressed textures by their compressed sizes, generated mipmap chains
+ * as a third of their base level, the textures of render targets and the render buffers of depth
+ * stencil targets (which frame buffers attach), and the vertex and index buffers of meshes. The
+ * estimates do not include the padding and alignment the driver may add.
+ *
+ * The memory is also counted against the TEXTURE and MESH categories of the MemoryTracker, which
+ * add the heap memory used while loading those resources. The counts here only hold GPU memory.
+ *
+ * When the estimate goes over the budget, a warning is logged and the listeners are notified,
+ * so that the game can release resources it does not need. Streamed textures are also limited to
+ * the part of the budget the other objects leave, so that the least recently drawn textures drop
+ * back to smaller mipmap levels until the estimate fits (see Texture::setStreamingBudget, which
+ * must be enabled for textures to be streamed). The budget can be set in the "graphics" section
+ * of game.config:
+ * @code
+   graphics
+   {
+       memoryBudget = 192
+       evictMipmaps = true
+   }
+ * @endcode
+ * The budget is set in megabytes, and there is no budget by default.
+ *
+ * @script{ignore}
+ */
+class GraphicsMemory
+{
+    friend class Game;
+    friend class Texture;
+
+public:
+
+    /**
+     * Defines the kinds of GL objects memory is counted for.
+     */
+    enum Category
+    {
+        TEXTURE,
+        RENDER_TARGET,
+        DEPTH_STENCIL,
+        VERTEX_BUFFER,
+        INDEX_BUFFER,
+        CATEGORY_COUNT
+    };
+
+    /**
+     * Defines a listener notified when the estimated GPU memory goes over the budget.
+     */
+    class Listener
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~Listener() { }
+
+        /**
+         * Called at the start of the frame after the estimate went over the budget.
+         *
+         * It is called again only after the estimate fell back within the budget.
+         *
+         * @param usage The estimated GPU memory, in bytes.
+         * @param budget The budget, in bytes.
+         */
+        virtual void graphicsMemoryOverBudget(unsigned int usage, unsigned int budget) = 0;
+    };
+
+    /**
+     * Returns the name of a category.
+     *
+     * @param category The category.
+     *
+     * @return The name of the category.
+     */
+    static const char* getCategoryName(Category category);
+
+    /**
+     * Returns the estimated GPU memory used by the objects of a category.
+     *
+     * @param category The category.
+     *
+     * @return The memory, in bytes.
+     */
+    static unsigned int getUsage(Category category);
+
+    /**
+     * Returns the estimated GPU memory used by the objects of all the categories.
+     *
+     * @return The memory, in bytes.
+     */
+    static unsigned int getTotalUsage();
+
+    /**
+     * Returns the most GPU memory used at once, since the start or since resetHighWaterMark() was called.
+     *
+     * @return The high-water mark of the total usage, in bytes.
+     */
+    static unsigned int getHighWaterMark();
+
+    /**
+     * Resets the high-water mark to the total usage.
+     */
+    static void resetHighWaterMark();
+
+    /**
+     * Sets the GPU memory budget.
+     *
+     * @param bytes The budget, in bytes, or 0 for no budget (the default).
+     */
+    static void setBudget(unsigned int bytes);
+
+    /**
+     * Returns the GPU memory budget.
+     *
+     * @return The budget, in bytes, or 0 if there is no budget.
+     */
+    static unsigned int getBudget();
+
+    /**
+     * Determines if the estimated GPU memory exceeds the budget.
+     *
+     * @return true if there is a budget and the total usage exceeds it.
+     */
+    static bool isOverBudget();
+
+    /**
+     * Sets whether streamed textures drop back to smaller mipmap levels to keep within the budget.
+     *
+     * @param enabled true to limit the streamed textures to the budget (the default).
+     */
+    static void setMipmapEviction(bool enabled);
+
+    /**
+     * Determines if streamed textures drop back to smaller mipmap levels to keep within the budget.
+     *
+     * @return true if the streamed textures are limited to the budget.
+     */
+    static bool isMipmapEviction();
+
+    /**
+     * Adds a listener notified when the estimated GPU memory goes over the budget.
+     *
+     * @param listener The listener, which must be removed before it is deleted.
+     */
+    static void addListener(Listener* listener);
+
+    /**
+     * Removes a listener added by addListener().
+     *
+     * @param listener The listener.
+     */
+    static void removeListener(Listener* listener);
+
+    /**
+     * Counts GPU memory allocated for an object of a category.
+     *
+     * @param category The category.
+     * @param bytes The size of the memory, in bytes.
+     */
+    static void track(Category category, unsigned int bytes);
+
+    /**
+     * Stops counting memory counted by track() for a category.
+     *
+     * @param category The category.
+     * @param bytes The size of the memory, in bytes.
+     */
+    static void untrack(Category category, unsigned int bytes);
+
+    /**
+     * Prints the estimated GPU memory of each category, the high-water mark and the budget.
+     */
+    static void print();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    GraphicsMemory();
+
+    /**
+     * Returns the memory the streamed textures may use within the budget, given the memory they use now.
+     *
+     * @return The memory left for the streamed textures, or UINT_MAX if they are not limited.
+     */
+    static unsigned int getStreamingLimit(unsigned int streamingMemory);
+
+    /**
+     * Warns and notifies the listeners if the estimate went over the budget since the last frame.
+     *
+     * Called by the game at the start of each frame.
+     */
+    static void update();
+};
+
+}
+
+#endif
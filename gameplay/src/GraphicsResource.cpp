@@ -0,0 +1,96 @@
+#include "Base.h"
+#include "GraphicsResource.h"
+#include "Game.h"
+#include "Thread.h"
+
+// Default memory, in bytes, for the copies of data retained to restore GL objects.
+// Only Android loses its contexts, while the game is in the background.
+#ifdef __ANDROID__
+#define GRAPHICS_RESOURCE_RETAIN_BUDGET (16 * 1024 * 1024)
+#else
+#define GRAPHICS_RESOURCE_RETAIN_BUDGET 0
+#endif
+
+namespace gameplay
+{
+
+std::list<GraphicsResource*> GraphicsResource::_resources[RESTORE_STAGE_COUNT];
+static Mutex __resourcesMutex;
+static unsigned int __retainBudget = GRAPHICS_RESOURCE_RETAIN_BUDGET;
+static unsigned int __retainedMemory = 0;
+static unsigned int __restoreCount = 0;
+
+GraphicsResource::GraphicsResource(RestoreStage stage) : _restoreStage(stage)
+{
+    GP_ASSERT(stage < RESTORE_STAGE_COUNT);
+
+    Mutex::Lock lock(__resourcesMutex);
+    _registryEntry = _resources[stage].insert(_resources[stage].end(), this);
+}
+
+GraphicsResource::~GraphicsResource()
+{
+    Mutex::Lock lock(__resourcesMutex);
+    _resources[_restoreStage].erase(_registryEntry);
+}
+
+void GraphicsResource::setRetainBudget(unsigned int bytes)
+{
+    __retainBudget = bytes;
+}
+
+unsigned int GraphicsResource::getRetainBudget()
+{
+    return __retainBudget;
+}
+
+unsigned int GraphicsResource::getRetainedMemory()
+{
+    return __retainedMemory;
+}
+
+unsigned int GraphicsResource::getRestoreCount()
+{
+    return __restoreCount;
+}
+
+bool GraphicsResource::retainMemory(unsigned int size)
+{
+    Mutex::Lock lock(__resourcesMutex);
+    if (size > __retainBudget || __retainedMemory > __retainBudget - size)
+        return false;
+
+    __retainedMemory += size;
+    return true;
+}
+
+void GraphicsResource::releaseMemory(unsigned int size)
+{
+    Mutex::Lock lock(__resourcesMutex);
+    GP_ASSERT(size <= __retainedMemory);
+    __retainedMemory -= size;
+}
+
+void GraphicsResource::restoreContext()
+{
+    // Forget every handle before creating the first new object, since the new context reuses the handles.
+    for (unsigned int i = 0; i < RESTORE_STAGE_COUNT; ++i)
+    {
+        for (std::list<GraphicsResource*>::iterator itr = _resources[i].begin(); itr != _resources[i].end(); ++itr)
+        {
+            (*itr)->discardGraphics();
+        }
+    }
+
+    for (unsigned int i = 0; i < RESTORE_STAGE_COUNT; ++i)
+    {
+        for (std::list<GraphicsResource*>::iterator itr = _resources[i].begin(); itr != _resources[i].end(); ++itr)
+        {
+            (*itr)->restoreGraphics();
+        }
+    }
+
+    ++__restoreCount;
+}
+
+}
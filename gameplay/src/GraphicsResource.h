@@ -0,0 +1,161 @@
+#ifndef GRAPHICSRESOURCE_H_
+#define GRAPHICSRESOURCE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines an object that owns GL objects, which it can recreate after the GL context is lost.
+ *
+ * Some platforms (such as Android) can lose the GL context while the game is in the
+ * background, which deletes every GL object of the game. Every texture, effect, mesh,
+ * vertex attribute binding, frame buffer and depth stencil target is registered here,
+ * and when the platform replaces a lost context they are all recreated in the new one
+ * without reloading the scenes that use them:
+ *
+ * - Effects relink their retained shader sources, which is fast when the program
+ *   binary cache is enabled (see Effect::setProgramCachePath).
+ * - Meshes loaded from bundles read their vertices and indices from the bundle again,
+ *   and other static meshes upload the copy of their data they retained.
+ * - Textures loaded from files are reloaded through the asynchronous texture loads,
+ *   which decode images on the worker threads and upload a few textures per frame.
+ *   Other textures upload their retained pixels, or get storage with undefined
+ *   contents (such as render targets, which are redrawn).
+ * - Frame buffers, depth stencil targets and vertex array objects are rebuilt from
+ *   the objects they refer to.
+ *
+ * The copies of the data that cannot be reloaded from files are only retained while
+ * they fit in the retain budget, which can be set in the "graphics" section of game.config:
+ * @code
+   graphics
+   {
+       retainBudget = 16
+   }
+ * @endcode
+ * The budget is set in megabytes, and is 0 on the platforms that never lose the
+ * context. Dynamic meshes are never retained, so their owners must refill them.
+ *
+ * @script{ignore}
+ */
+class GraphicsResource
+{
+    friend class Game;
+    friend class MeshPart;
+
+public:
+
+    /**
+     * Sets the memory available for the copies of data retained to restore GL objects.
+     *
+     * The budget only applies to the objects created after it is set.
+     *
+     * @param bytes The budget in bytes, or 0 to retain no copies.
+     */
+    static void setRetainBudget(unsigned int bytes);
+
+    /**
+     * Returns the memory available for the copies of data retained to restore GL objects.
+     *
+     * @return The budget in bytes.
+     */
+    static unsigned int getRetainBudget();
+
+    /**
+     * Returns the memory used by the copies of data retained to restore GL objects.
+     *
+     * @return The retained memory in bytes.
+     */
+    static unsigned int getRetainedMemory();
+
+    /**
+     * Returns the number of times the GL context was lost and its objects were restored.
+     *
+     * @return The number of restored contexts.
+     */
+    static unsigned int getRestoreCount();
+
+protected:
+
+    /**
+     * The stages of restoring a context, in order. Objects are restored after the
+     * objects of the earlier stages, which they may refer to.
+     */
+    enum RestoreStage
+    {
+        RESTORE_PROGRAMS,
+        RESTORE_BUFFERS,
+        RESTORE_TEXTURES,
+        RESTORE_RENDER_BUFFERS,
+        RESTORE_ATTACHMENTS,
+        RESTORE_STAGE_COUNT
+    };
+
+    /**
+     * Constructor. Registers the object to be restored.
+     *
+     * @param stage The stage the object is restored in.
+     */
+    GraphicsResource(RestoreStage stage);
+
+    /**
+     * Destructor. Unregisters the object.
+     */
+    virtual ~GraphicsResource();
+
+    /**
+     * Forgets the GL objects of this object, which were deleted with the lost context.
+     *
+     * The handles must be cleared without deleting them, since the new context may
+     * reuse them for other objects.
+     */
+    virtual void discardGraphics() = 0;
+
+    /**
+     * Recreates the GL objects of this object in the new context.
+     */
+    virtual void restoreGraphics() = 0;
+
+    /**
+     * Reserves memory for a copy of data retained to restore GL objects.
+     *
+     * @param size The size of the copy in bytes.
+     *
+     * @return true if the copy fits in the retain budget and should be kept.
+     */
+    static bool retainMemory(unsigned int size);
+
+    /**
+     * Returns the memory reserved by retainMemory() for a copy that was deleted.
+     *
+     * @param size The size of the copy in bytes.
+     */
+    static void releaseMemory(unsigned int size);
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    GraphicsResource(const GraphicsResource& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    GraphicsResource& operator=(const GraphicsResource&);
+
+    /**
+     * Forgets the GL objects of every registered object, then recreates them stage by stage.
+     *
+     * Called by the game after the platform replaced a lost context with a new one.
+     */
+    static void restoreContext();
+
+    RestoreStage _restoreStage;
+    std::list<GraphicsResource*>::iterator _registryEntry;
+
+    static std::list<GraphicsResource*> _resources[RESTORE_STAGE_COUNT];
+};
+
+}
+
+#endif
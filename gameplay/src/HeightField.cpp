@@ -3,11 +3,15 @@
 #include "Image.h"
 #include "FileSystem.h"
 
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace gameplay
 {
 
 HeightField::HeightField(unsigned int columns, unsigned int rows)
-    : _array(NULL), _cols(columns), _rows(rows)
+    : _array(NULL), _quantized(NULL), _scale(1.0f), _offset(0.0f), _cols(columns), _rows(rows)
 {
     _array = new float[columns * rows];
 }
@@ -15,6 +19,7 @@ HeightField::HeightField(unsigned int columns, unsigned int rows)
 HeightField::~HeightField()
 {
     SAFE_DELETE_ARRAY(_array);
+    SAFE_DELETE_ARRAY(_quantized);
 }
 
 HeightField* HeightField::create(unsigned int columns, unsigned int rows)
@@ -164,6 +169,61 @@ float* HeightField::getArray() const
     return _array;
 }
 
+void HeightField::quantize()
+{
+    if (_quantized)
+        return;
+
+    GP_ASSERT(_array);
+    unsigned int count = _cols * _rows;
+    float minHeight = FLT_MAX, maxHeight = -FLT_MAX;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        minHeight = std::min(minHeight, _array[i]);
+        maxHeight = std::max(maxHeight, _array[i]);
+    }
+
+    // Map the height range symmetrically onto [-32767, 32767].
+    _offset = (minHeight + maxHeight) * 0.5f;
+    _scale = (maxHeight - minHeight) / 65534.0f;
+    if (_scale <= 0.0f)
+        _scale = 1.0f;
+
+    float invScale = 1.0f / _scale;
+    _quantized = new short[count];
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float value = floor((_array[i] - _offset) * invScale + 0.5f);
+        _quantized[i] = (short)std::max(-32767.0f, std::min(32767.0f, value));
+    }
+    SAFE_DELETE_ARRAY(_array);
+}
+
+bool HeightField::isQuantized() const
+{
+    return _quantized != NULL;
+}
+
+short* HeightField::getQuantizedArray() const
+{
+    return _quantized;
+}
+
+float HeightField::getQuantizationScale() const
+{
+    return _scale;
+}
+
+float HeightField::getQuantizationOffset() const
+{
+    return _offset;
+}
+
+float HeightField::getSample(unsigned int index) const
+{
+    return _quantized ? _offset + _quantized[index] * _scale : _array[index];
+}
+
 float HeightField::getHeight(float column, float row) const
 {
     // Clamp to heightfield boundaries
@@ -182,15 +242,15 @@ float HeightField::getHeight(float column, float row) const
 
     if (x2 >= _cols && y2 >= _rows)
     {
-        return _array[x1 + y1 * _cols];
+        return getSample(x1 + y1 * _cols);
     }
     else if (x2 >= _cols)
     {
-        return _array[x1 + y1 * _cols] * yFactorI + _array[x1 + y2 * _cols] * yFactor;
+        return getSample(x1 + y1 * _cols) * yFactorI + getSample(x1 + y2 * _cols) * yFactor;
     }
     else if (y2 >= _rows)
     {
-        return _array[x1 + y1 * _cols] * xFactorI + _array[x2 + y1 * _cols] * xFactor;
+        return getSample(x1 + y1 * _cols) * xFactorI + getSample(x2 + y1 * _cols) * xFactor;
     }
     else
     {
@@ -198,8 +258,95 @@ float HeightField::getHeight(float column, float row) const
         float b = xFactorI * yFactor;
         float c = xFactor * yFactor;
         float d = xFactor * yFactorI;
-        return _array[x1 + y1 * _cols] * a + _array[x1 + y2 * _cols] * b +
-            _array[x2 + y2 * _cols] * c + _array[x2 + y1 * _cols] * d;
+        return getSample(x1 + y1 * _cols) * a + getSample(x1 + y2 * _cols) * b +
+            getSample(x2 + y2 * _cols) * c + getSample(x2 + y1 * _cols) * d;
+    }
+}
+
+void HeightField::getHeights(const Vector2* points, float* heights, unsigned int count) const
+{
+    GP_ASSERT(points);
+    GP_ASSERT(heights);
+
+    unsigned int i = 0;
+    if (_cols >= 2 && _rows >= 2)
+    {
+        // Process the points 4 at a time. The sample indices are computed per point, since
+        // the corner heights have to be gathered from the array one by one anyway, while the
+        // clamping and the interpolation run on all 4 points at once. Clamping the lower
+        // corner to one before the last sample lets the edges use the same interpolation.
+        float maxColumn = (float)(_cols - 1);
+        float maxRow = (float)(_rows - 1);
+        float columns[4];
+        float rows[4];
+        float h11[4];
+        float h12[4];
+        float h21[4];
+        float h22[4];
+        for (; i + 4 <= count; i += 4)
+        {
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                float column = std::max(0.0f, std::min(maxColumn, points[i + j].x));
+                float row = std::max(0.0f, std::min(maxRow, points[i + j].y));
+                unsigned int x1 = std::min((unsigned int)column, _cols - 2);
+                unsigned int y1 = std::min((unsigned int)row, _rows - 2);
+                unsigned int index = x1 + y1 * _cols;
+                columns[j] = column - x1;
+                rows[j] = row - y1;
+                if (_quantized)
+                {
+                    h11[j] = _quantized[index];
+                    h21[j] = _quantized[index + 1];
+                    h12[j] = _quantized[index + _cols];
+                    h22[j] = _quantized[index + _cols + 1];
+                }
+                else
+                {
+                    h11[j] = _array[index];
+                    h21[j] = _array[index + 1];
+                    h12[j] = _array[index + _cols];
+                    h22[j] = _array[index + _cols + 1];
+                }
+            }
+
+            // Interpolate along the columns, then along the rows. Quantized heights are
+            // interpolated before they are scaled, since the mapping is linear.
+#if defined(USE_SSE)
+            __m128 xFactor = _mm_loadu_ps(columns);
+            __m128 yFactor = _mm_loadu_ps(rows);
+            __m128 top = _mm_loadu_ps(h11);
+            __m128 bottom = _mm_loadu_ps(h12);
+            top = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(h21), top), xFactor));
+            bottom = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(h22), bottom), xFactor));
+            __m128 result = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), yFactor));
+            result = _mm_add_ps(_mm_mul_ps(result, _mm_set1_ps(_scale)), _mm_set1_ps(_offset));
+            _mm_storeu_ps(heights + i, result);
+#elif defined(USE_NEON)
+            float32x4_t xFactor = vld1q_f32(columns);
+            float32x4_t yFactor = vld1q_f32(rows);
+            float32x4_t top = vld1q_f32(h11);
+            float32x4_t bottom = vld1q_f32(h12);
+            top = vmlaq_f32(top, vsubq_f32(vld1q_f32(h21), top), xFactor);
+            bottom = vmlaq_f32(bottom, vsubq_f32(vld1q_f32(h22), bottom), xFactor);
+            float32x4_t result = vmlaq_f32(top, vsubq_f32(bottom, top), yFactor);
+            result = vmlaq_f32(vdupq_n_f32(_offset), result, vdupq_n_f32(_scale));
+            vst1q_f32(heights + i, result);
+#else
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                float top = h11[j] + (h21[j] - h11[j]) * columns[j];
+                float bottom = h12[j] + (h22[j] - h12[j]) * columns[j];
+                heights[i + j] = _offset + (top + (bottom - top) * rows[j]) * _scale;
+            }
+#endif
+        }
+    }
+
+    // Remaining points.
+    for (; i < count; ++i)
+    {
+        heights[i] = getHeight(points[i].x, points[i].y);
     }
 }
 
@@ -2,6 +2,7 @@
 #define HEIGHTFIELD_H_
 
 #include "Ref.h"
+#include "Vector2.h"
 
 namespace gameplay
 {
@@ -12,6 +13,9 @@ namespace gameplay
      * Heightfields can be used to construct both Terrain objects as well as PhysicsCollisionShape
      * heightfield defintions, which are used in heightfield rigid body creation. Heightfields can
      * be populated manually, or loaded from images and RAW files.
+     *
+     * Heights are stored as floats until quantize() is called, which converts them to 16-bit
+     * values with a scale and offset to halve the memory used by the heightfield.
      */
     class HeightField : public Ref
     {
@@ -78,10 +82,55 @@ namespace gameplay
          * The array is packed in row major order, meaning that the data is aligned in rows,
          * from top left to bottom right.
          *
-         * @return The underlying height array.
+         * @return The underlying height array, or NULL if the heightfield has been quantized.
          */
         float* getArray() const;
 
+        /**
+         * Converts the heights to 16-bit values to halve the memory used by the heightfield.
+         *
+         * Each height is stored as a signed 16-bit value v, where the height is
+         * offset + v * scale and the scale and offset are computed from the range of
+         * the heights. The float array is freed, so getArray() returns NULL afterwards.
+         * The precision lost is at most half of the scale.
+         *
+         * This should be done after the heightfield has been used to create a Terrain,
+         * whose patches are built from the float array, but before it is used for a physics
+         * heightfield shape, which references the height array directly.
+         */
+        void quantize();
+
+        /**
+         * Returns whether the heights are stored as quantized 16-bit values.
+         *
+         * @return True if quantize() has been called on the heightfield.
+         */
+        bool isQuantized() const;
+
+        /**
+         * Returns a pointer to the underlying quantized height array.
+         *
+         * The array is packed in the same order as the float height array.
+         *
+         * @return The quantized height array, or NULL if the heightfield is not quantized.
+         * @script{ignore}
+         */
+        short* getQuantizedArray() const;
+
+        /**
+         * Returns the scale applied to quantized height values.
+         *
+         * @return The quantization scale, or 1 if the heightfield is not quantized.
+         */
+        float getQuantizationScale() const;
+
+        /**
+         * Returns the offset added to scaled quantized height values.
+         *
+         * @return The quantization offset, or 0 if the heightfield is not quantized.
+         */
+        float getQuantizationOffset() const;
+
         /**
          * Returns the height at the specified row and column.
          *
@@ -99,6 +148,20 @@ namespace gameplay
          */
         float getHeight(float column, float row) const;
 
+        /**
+         * Returns the heights at a batch of positions.
+         *
+         * This is equivalent to calling getHeight() for each position, but processes several
+         * positions at a time using SIMD instructions when they are available. Use it when
+         * querying many heights per frame.
+         *
+         * @param points The column (x) and row (y) of each position to query.
+         * @param heights The array that receives the height value at each position.
+         * @param count The number of positions.
+         * @script{ignore}
+         */
+        void getHeights(const Vector2* points, float* heights, unsigned int count) const;
+
         /**
          * Returns the number of rows in the heightfield.
          *
@@ -130,7 +193,15 @@ namespace gameplay
          */
         static HeightField* create(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax);
 
+        /**
+         * Returns the height of the sample at the specified index.
+         */
+        float getSample(unsigned int index) const;
+
         float* _array;
+        short* _quantized;
+        float _scale;
+        float _offset;
         unsigned int _cols;
         unsigned int _rows;
     };
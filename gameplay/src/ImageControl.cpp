@@ -6,13 +6,20 @@ namespace gameplay
 
 ImageControl::ImageControl() :
     _srcRegion(Rectangle::empty()), _dstRegion(Rectangle::empty()), _batch(NULL),
-    _tw(0.0f), _th(0.0f), _uvs(Theme::UVs::full())
+    _atlas(NULL), _tw(0.0f), _th(0.0f), _uvs(Theme::UVs::full())
 {
 }
 
 ImageControl::~ImageControl()
 {
-    SAFE_DELETE(_batch);
+    if (_atlas)
+    {
+        SAFE_RELEASE(_atlas);
+    }
+    else
+    {
+        SAFE_DELETE(_batch);
+    }
 }
 
 ImageControl* ImageControl::create(const char* id, Theme::Style* style)
@@ -60,12 +67,33 @@ void ImageControl::initialize(const char* typeName, Theme::Style* style, Propert
 
 void ImageControl::setImage(const char* path)
 {
-    SAFE_DELETE(_batch);
-    Texture* texture = Texture::create(path);
-    _batch = SpriteBatch::create(texture);
-    _tw = 1.0f / texture->getWidth();
-    _th = 1.0f / texture->getHeight();
-    texture->release();
+    if (_atlas)
+    {
+        SAFE_RELEASE(_atlas);
+    }
+    else
+    {
+        SAFE_DELETE(_batch);
+    }
+
+    // Small images are packed into shared atlases so that forms draw them in a single batch.
+    _atlas = TextureAtlas::addShared(path, &_imageRegion);
+    if (_atlas)
+    {
+        _batch = _atlas->getSpriteBatch();
+        _tw = 1.0f / _atlas->getTexture()->getWidth();
+        _th = 1.0f / _atlas->getTexture()->getHeight();
+    }
+    else
+    {
+        Texture* texture = Texture::create(path);
+        _batch = SpriteBatch::create(texture);
+        _imageRegion.set(0, 0, texture->getWidth(), texture->getHeight());
+        _tw = 1.0f / texture->getWidth();
+        _th = 1.0f / texture->getHeight();
+        texture->release();
+    }
+    updateUVs();
 
     if (_autoSize != AUTO_SIZE_NONE)
         setDirty(DIRTY_BOUNDS);
@@ -74,11 +102,7 @@ void ImageControl::setImage(const char* path)
 void ImageControl::setRegionSrc(float x, float y, float width, float height)
 {
     _srcRegion.set(x, y, width, height);
-
-    _uvs.u1 = x * _tw;
-    _uvs.u2 = (x + width) * _tw;
-    _uvs.v1 = 1.0f - (y * _th);
-    _uvs.v2 = 1.0f - ((y + height) * _th);
+    updateUVs();
 }
 
 void ImageControl::setRegionSrc(const Rectangle& region)
@@ -106,6 +130,17 @@ const Rectangle& ImageControl::getRegionDst() const
     return _dstRegion;
 }
 
+void ImageControl::updateUVs()
+{
+    // Source regions are measured from the top left of the image, while the image region is in GL texture coordinates.
+    Rectangle src = _srcRegion.isEmpty() ? Rectangle(_imageRegion.width, _imageRegion.height) : _srcRegion;
+    float top = _imageRegion.y + _imageRegion.height;
+    _uvs.u1 = (_imageRegion.x + src.x) * _tw;
+    _uvs.u2 = (_imageRegion.x + src.x + src.width) * _tw;
+    _uvs.v1 = (top - src.y) * _th;
+    _uvs.v2 = (top - src.y - src.height) * _th;
+}
+
 const char* ImageControl::getType() const
 {
     return "image";
@@ -144,12 +179,12 @@ void ImageControl::updateBounds()
     {
         if (_autoSize & AUTO_SIZE_WIDTH)
         {
-            setWidthInternal(_batch->getSampler()->getTexture()->getWidth());
+            setWidthInternal(_imageRegion.width);
         }
 
         if (_autoSize & AUTO_SIZE_HEIGHT)
         {
-            setHeightInternal(_batch->getSampler()->getTexture()->getWidth());
+            setHeightInternal(_imageRegion.height);
         }
     }
 
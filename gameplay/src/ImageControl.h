@@ -5,6 +5,7 @@
 #include "Theme.h"
 #include "Image.h"
 #include "SpriteBatch.h"
+#include "TextureAtlas.h"
 #include "Rectangle.h"
 
 namespace gameplay
@@ -130,11 +131,20 @@ private:
 
     ImageControl(const ImageControl& copy);
 
+    /**
+     * Computes the UVs of the source region within the image.
+     */
+    void updateUVs();
+
     // Source region.
     Rectangle _srcRegion;
     // Destination region.
     Rectangle _dstRegion;
     SpriteBatch* _batch;
+    // Shared atlas holding the image, if it is small enough to be packed with other images.
+    TextureAtlas* _atlas;
+    // Region of the image in the texture.
+    Rectangle _imageRegion;
 
     // One over texture width and height, for use when calculating UVs from a new source region.
     float _tw;
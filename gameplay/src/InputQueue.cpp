@@ -0,0 +1,216 @@
+#include "Base.h"
+#include "InputQueue.h"
+#include "Platform.h"
+#include "Game.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a queued input event.
+ */
+struct QueuedInputEvent
+{
+    enum Type
+    {
+        TOUCH,
+        MOUSE,
+        KEY
+    };
+
+    Type type;
+    int evt;
+    int x;
+    int y;
+    int value;              // The contact index, wheel delta or key.
+    bool actuallyMouse;
+    double time;
+};
+
+static bool __enabled = false;
+static Mutex __mutex;
+static std::vector<QueuedInputEvent> __events;
+static std::vector<QueuedInputEvent> __dispatchEvents;
+static double __eventTime = -1.0;
+static unsigned int __coalescedCount = 0;
+static bool __leftButtonDown = false;
+
+// Returns the queued move that a new move of the same kind can be merged into, or NULL.
+static QueuedInputEvent* findMove(QueuedInputEvent::Type type, int evt, int contactIndex)
+{
+    for (size_t i = __events.size(); i > 0; --i)
+    {
+        QueuedInputEvent& event = __events[i - 1];
+        bool isMove = (event.type == QueuedInputEvent::TOUCH && event.evt == Touch::TOUCH_MOVE) ||
+                      (event.type == QueuedInputEvent::MOUSE && event.evt == Mouse::MOUSE_MOVE);
+        if (!isMove)
+        {
+            // Moves are never merged across presses, releases or keys.
+            break;
+        }
+        if (event.type == type && event.evt == evt && event.value == contactIndex)
+        {
+            return &event;
+        }
+    }
+    return NULL;
+}
+
+static void queueEvent(QueuedInputEvent::Type type, int evt, int x, int y, int value, bool actuallyMouse)
+{
+    QueuedInputEvent event;
+    event.type = type;
+    event.evt = evt;
+    event.x = x;
+    event.y = y;
+    event.value = value;
+    event.actuallyMouse = actuallyMouse;
+    event.time = Game::getGameTime();
+    __events.push_back(event);
+}
+
+void InputQueue::setEnabled(bool enabled)
+{
+    if (__enabled && !enabled)
+    {
+        dispatch();
+    }
+    __enabled = enabled;
+}
+
+bool InputQueue::isEnabled()
+{
+    return __enabled;
+}
+
+double InputQueue::getEventTime()
+{
+    return __eventTime >= 0.0 ? __eventTime : Game::getGameTime();
+}
+
+unsigned int InputQueue::getCoalescedCount()
+{
+    return __coalescedCount;
+}
+
+bool InputQueue::isQueueing()
+{
+    return __enabled;
+}
+
+void InputQueue::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
+{
+    Mutex::Lock lock(__mutex);
+    if (evt == Touch::TOUCH_MOVE)
+    {
+        QueuedInputEvent* move = findMove(QueuedInputEvent::TOUCH, evt, (int)contactIndex);
+        if (move && move->actuallyMouse == actuallyMouse)
+        {
+            move->x = x;
+            move->y = y;
+            move->time = Game::getGameTime();
+            ++__coalescedCount;
+            return;
+        }
+    }
+    queueEvent(QueuedInputEvent::TOUCH, evt, x, y, (int)contactIndex, actuallyMouse);
+}
+
+void InputQueue::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
+{
+    Mutex::Lock lock(__mutex);
+    if (evt == Mouse::MOUSE_MOVE)
+    {
+        QueuedInputEvent* move = findMove(QueuedInputEvent::MOUSE, evt, 0);
+        if (move)
+        {
+            // Captured moves are relative to the previous position, so they add up.
+            if (Game::getInstance()->isMouseCaptured())
+            {
+                move->x += x;
+                move->y += y;
+            }
+            else
+            {
+                move->x = x;
+                move->y = y;
+            }
+            move->time = Game::getGameTime();
+            ++__coalescedCount;
+            return;
+        }
+    }
+    else if (evt == Mouse::MOUSE_WHEEL && !__events.empty())
+    {
+        QueuedInputEvent& last = __events.back();
+        if (last.type == QueuedInputEvent::MOUSE && last.evt == Mouse::MOUSE_WHEEL)
+        {
+            last.x = x;
+            last.y = y;
+            last.value += wheelDelta;
+            last.time = Game::getGameTime();
+            ++__coalescedCount;
+            return;
+        }
+    }
+    queueEvent(QueuedInputEvent::MOUSE, evt, x, y, evt == Mouse::MOUSE_WHEEL ? wheelDelta : 0, false);
+}
+
+void InputQueue::keyEvent(Keyboard::KeyEvent evt, int key)
+{
+    Mutex::Lock lock(__mutex);
+    queueEvent(QueuedInputEvent::KEY, evt, 0, 0, key, false);
+}
+
+void InputQueue::dispatch()
+{
+    {
+        // Take the events out of the queue so that the platform can queue new ones while they are delivered.
+        Mutex::Lock lock(__mutex);
+        if (__events.empty() || !__dispatchEvents.empty())
+            return;
+        __dispatchEvents.swap(__events);
+    }
+
+    for (size_t i = 0, count = __dispatchEvents.size(); i < count; ++i)
+    {
+        const QueuedInputEvent& event = __dispatchEvents[i];
+        __eventTime = event.time;
+        switch (event.type)
+        {
+        case QueuedInputEvent::TOUCH:
+            Platform::deliverTouchEvent((Touch::TouchEvent)event.evt, event.x, event.y, (unsigned int)event.value, event.actuallyMouse);
+            break;
+
+        case QueuedInputEvent::KEY:
+            Platform::deliverKeyEvent((Keyboard::KeyEvent)event.evt, event.value);
+            break;
+
+        case QueuedInputEvent::MOUSE:
+            {
+                Mouse::MouseEvent evt = (Mouse::MouseEvent)event.evt;
+                if (evt == Mouse::MOUSE_PRESS_LEFT_BUTTON)
+                    __leftButtonDown = true;
+                else if (evt == Mouse::MOUSE_RELEASE_LEFT_BUTTON)
+                    __leftButtonDown = false;
+
+                // Turn the left button events nobody handled into touch events, as the platforms do.
+                if (!Platform::deliverMouseEvent(evt, event.x, event.y, event.value))
+                {
+                    if (evt == Mouse::MOUSE_PRESS_LEFT_BUTTON)
+                        Platform::deliverTouchEvent(Touch::TOUCH_PRESS, event.x, event.y, 0, true);
+                    else if (evt == Mouse::MOUSE_RELEASE_LEFT_BUTTON)
+                        Platform::deliverTouchEvent(Touch::TOUCH_RELEASE, event.x, event.y, 0, true);
+                    else if (evt == Mouse::MOUSE_MOVE && __leftButtonDown)
+                        Platform::deliverTouchEvent(Touch::TOUCH_MOVE, event.x, event.y, 0, true);
+                }
+            }
+            break;
+        }
+    }
+    __eventTime = -1.0;
+    __dispatchEvents.clear();
+}
+
+}
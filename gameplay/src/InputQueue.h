@@ -0,0 +1,114 @@
+#ifndef INPUTQUEUE_H_
+#define INPUTQUEUE_H_
+
+#include "Touch.h"
+#include "Mouse.h"
+#include "Keyboard.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a queue that buffers the touch, mouse and key events of the platform until the next frame.
+ *
+ * By default the platform delivers each input event to the forms, the game and the scripts as
+ * soon as it arrives, so a touchscreen that reports moves at 240 Hz runs several hit tests and
+ * script calls per frame. When the queue is enabled, the events are recorded with the time they
+ * arrived and delivered together at the start of Game::frame, before the game updates, in the
+ * order they arrived.
+ *
+ * Moves are coalesced while they are queued: a touch move replaces the previous move of the same
+ * contact, and a mouse move replaces the previous mouse move (or adds to it while the mouse is
+ * captured, since captured moves are relative). Consecutive wheel events are added up. Presses,
+ * releases and key events are never coalesced, and moves are never merged across them.
+ *
+ * Buffered mouse events are reported as handled to the platform. When the forms, the game and the
+ * scripts do not handle them at delivery, the queue turns the left button events and the moves made
+ * while it is held into touch events, as the desktop platforms do for unbuffered events.
+ *
+ * The queue is enabled from the "input" section of game.config:
+ * @code
+   input
+   {
+       buffered = true
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class InputQueue
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Sets whether input events are buffered until the next frame.
+     *
+     * Events already queued are delivered right away when the queue is disabled.
+     *
+     * @param enabled true to buffer input events, false to deliver them as they arrive (the default).
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Determines if input events are buffered until the next frame.
+     *
+     * @return true if input events are buffered.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the time the event being delivered arrived at.
+     *
+     * Handlers can use this to tell apart events that were delivered in the same frame.
+     *
+     * @return The game time the event arrived at, in milliseconds, or the current game time
+     *      when no buffered event is being delivered.
+     */
+    static double getEventTime();
+
+    /**
+     * Returns the number of events coalesced into other events since the start.
+     *
+     * @return The number of events that were not delivered on their own.
+     */
+    static unsigned int getCoalescedCount();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    InputQueue();
+
+    /**
+     * Determines if the platform must queue an event instead of delivering it.
+     */
+    static bool isQueueing();
+
+    /**
+     * Queues a touch event.
+     */
+    static void touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse);
+
+    /**
+     * Queues a mouse event.
+     */
+    static void mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
+
+    /**
+     * Queues a key event.
+     */
+    static void keyEvent(Keyboard::KeyEvent evt, int key);
+
+    /**
+     * Delivers the queued events. Called by Game::frame.
+     */
+    static void dispatch();
+};
+
+}
+
+#endif
@@ -0,0 +1,414 @@
+#include "Base.h"
+#include "InputRecorder.h"
+#include "Platform.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "Properties.h"
+#include "Stream.h"
+#include "Thread.h"
+
+// The version of the recording files, which must change with their layout.
+#define INPUT_RECORDING_VERSION 1
+
+namespace gameplay
+{
+
+/**
+ * Defines a recorded input event.
+ */
+struct RecordedInputEvent
+{
+    enum Type
+    {
+        TOUCH,
+        TOUCH_FROM_MOUSE,
+        MOUSE,
+        KEY,
+        GESTURE,
+        GAMEPAD
+    };
+
+    unsigned int frame;
+    int type;
+    int evt;
+    int x;                  // The x coordinate, or the index of the gamepad.
+    int y;
+    int value;              // The contact index, wheel delta, key, swipe direction or analog index.
+    float scale;            // The pinch scale or long tap duration.
+};
+
+// The identifier of the recording files.
+static const char INPUT_RECORDING_IDENTIFIER[] = { 'G', 'P', 'I', 'R' };
+
+bool InputRecorder::_active = false;
+bool InputRecorder::_replaying = false;
+static bool __recording = false;
+static bool __injecting = false;
+static Mutex __mutex;
+static std::vector<RecordedInputEvent> __events;
+static size_t __nextEvent = 0;
+static unsigned int __frame = 0;
+static unsigned int __frameCount = 0;
+static double __replayTime = 0.0;
+static float __timeStep = 0.0f;
+static double __frameStart = -1.0;
+static std::vector<float> __frameTimes;
+static std::string __recordPath;
+static std::string __frameTimesPath;
+static bool __exitOnEnd = false;
+
+/**
+ * Records an event arriving in the current frame.
+ */
+static void recordEvent(int type, int evt, int x, int y, int value, float scale)
+{
+    RecordedInputEvent event;
+    event.frame = __frame;
+    event.type = type;
+    event.evt = evt;
+    event.x = x;
+    event.y = y;
+    event.value = value;
+    event.scale = scale;
+
+    Mutex::Lock lock(__mutex);
+    __events.push_back(event);
+}
+
+void InputRecorder::startRecording()
+{
+    if (_replaying)
+        stopReplay();
+
+    Mutex::Lock lock(__mutex);
+    __events.clear();
+    __frame = 0;
+    __frameCount = 0;
+    __recording = true;
+    _active = true;
+}
+
+void InputRecorder::stopRecording()
+{
+    if (!__recording)
+        return;
+
+    __recording = false;
+    __frameCount = __frame + 1;
+    _active = _replaying;
+}
+
+bool InputRecorder::isRecording()
+{
+    return __recording;
+}
+
+bool InputRecorder::save(const char* path)
+{
+    GP_ASSERT(path);
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open file '%s' to write the input recording.", path);
+        return false;
+    }
+
+    Mutex::Lock lock(__mutex);
+    unsigned int version = INPUT_RECORDING_VERSION;
+    unsigned int frameCount = __recording ? __frame + 1 : __frameCount;
+    unsigned int eventCount = (unsigned int)__events.size();
+    bool written = stream->write(INPUT_RECORDING_IDENTIFIER, 1, sizeof(INPUT_RECORDING_IDENTIFIER)) == sizeof(INPUT_RECORDING_IDENTIFIER) &&
+        stream->write(&version, sizeof(version), 1) == 1 && stream->write(&frameCount, sizeof(frameCount), 1) == 1 &&
+        stream->write(&eventCount, sizeof(eventCount), 1) == 1 &&
+        (eventCount == 0 || stream->write(&__events[0], sizeof(RecordedInputEvent), eventCount) == eventCount);
+    stream->close();
+    if (!written)
+        GP_WARN("Failed to write the input recording to file '%s'.", path);
+    return written;
+}
+
+bool InputRecorder::startReplay(const char* path, float timeStep)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(timeStep > 0.0f);
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open input recording '%s'.", path);
+        return false;
+    }
+
+    char identifier[sizeof(INPUT_RECORDING_IDENTIFIER)];
+    unsigned int version, frameCount, eventCount;
+    if (stream->read(identifier, 1, sizeof(identifier)) != sizeof(identifier) || memcmp(identifier, INPUT_RECORDING_IDENTIFIER, sizeof(identifier)) != 0 ||
+        stream->read(&version, sizeof(version), 1) != 1 || version != INPUT_RECORDING_VERSION ||
+        stream->read(&frameCount, sizeof(frameCount), 1) != 1 || stream->read(&eventCount, sizeof(eventCount), 1) != 1 ||
+        stream->length() < (size_t)stream->position() + (size_t)eventCount * sizeof(RecordedInputEvent))
+    {
+        GP_WARN("Failed to read input recording '%s': the file is not a recording of this version.", path);
+        return false;
+    }
+
+    std::vector<RecordedInputEvent> events(eventCount);
+    if (eventCount > 0 && stream->read(&events[0], sizeof(RecordedInputEvent), eventCount) != eventCount)
+    {
+        GP_WARN("Failed to read input recording '%s': the file ended early.", path);
+        return false;
+    }
+
+    stopRecording();
+    Mutex::Lock lock(__mutex);
+    __events.swap(events);
+    __nextEvent = 0;
+    __frame = 0;
+    __frameCount = frameCount;
+    __timeStep = timeStep;
+    __frameStart = -1.0;
+    __frameTimes.clear();
+
+    // The replay clock starts from the current game time, and only advances between frames.
+    __replayTime = Game::getGameTime();
+    _replaying = true;
+    _active = true;
+    return true;
+}
+
+void InputRecorder::stopReplay()
+{
+    if (!_replaying)
+        return;
+
+    // The game clock continues from the replay clock.
+    double replayTime = __replayTime;
+    _replaying = false;
+    _active = __recording;
+    Game::_pausedTimeTotal = Platform::getAbsoluteTime() - replayTime;
+
+    if (!__frameTimes.empty())
+    {
+        std::vector<float> sorted(__frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (size_t i = 0, count = sorted.size(); i < count; ++i)
+            total += sorted[i];
+        size_t last = sorted.size() - 1;
+        Logger::log(Logger::LEVEL_INFO, "Input replay: %u frames in %.1f ms, frame times average %.3f ms, median %.3f ms, 95%% %.3f ms, 99%% %.3f ms, maximum %.3f ms.\n",
+            (unsigned int)sorted.size(), total, total / sorted.size(), sorted[last / 2], sorted[last * 95 / 100], sorted[last * 99 / 100], sorted[last]);
+
+        if (!__frameTimesPath.empty())
+        {
+            std::auto_ptr<Stream> stream(FileSystem::open(__frameTimesPath.c_str(), FileSystem::WRITE));
+            if (stream.get() == NULL)
+            {
+                GP_WARN("Failed to open file '%s' to write the replayed frame times.", __frameTimesPath.c_str());
+            }
+            else
+            {
+                char line[32];
+                for (size_t i = 0, count = __frameTimes.size(); i < count; ++i)
+                {
+                    int length = sprintf(line, "%.3f\n", __frameTimes[i]);
+                    stream->write(line, 1, length);
+                }
+                stream->close();
+            }
+        }
+    }
+
+    if (__exitOnEnd)
+        Game::getInstance()->exit();
+}
+
+bool InputRecorder::isReplaying()
+{
+    return _replaying;
+}
+
+unsigned int InputRecorder::getFrame()
+{
+    return __frame;
+}
+
+const std::vector<float>& InputRecorder::getFrameTimes()
+{
+    return __frameTimes;
+}
+
+bool InputRecorder::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
+{
+    if (_replaying)
+        return __injecting;
+
+    recordEvent(actuallyMouse ? RecordedInputEvent::TOUCH_FROM_MOUSE : RecordedInputEvent::TOUCH, evt, x, y, (int)contactIndex, 0.0f);
+    return true;
+}
+
+bool InputRecorder::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
+{
+    if (_replaying)
+        return __injecting;
+
+    recordEvent(RecordedInputEvent::MOUSE, evt, x, y, wheelDelta, 0.0f);
+    return true;
+}
+
+bool InputRecorder::keyEvent(Keyboard::KeyEvent evt, int key)
+{
+    if (_replaying)
+        return __injecting;
+
+    recordEvent(RecordedInputEvent::KEY, evt, 0, 0, key, 0.0f);
+    return true;
+}
+
+bool InputRecorder::gestureEvent(Gesture::GestureEvent evt, int x, int y, int value, float scale)
+{
+    if (_replaying)
+        return __injecting;
+
+    recordEvent(RecordedInputEvent::GESTURE, evt, x, y, value, scale);
+    return true;
+}
+
+bool InputRecorder::gamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
+{
+    // Virtual gamepads follow the touch events, so they are replayed by replaying the touches.
+    if (gamepad->isVirtual())
+        return true;
+    if (_replaying)
+        return __injecting;
+
+    Game* game = Game::getInstance();
+    for (unsigned int i = 0, count = game->getGamepadCount(); i < count; ++i)
+    {
+        if (game->getGamepad(i, false) == gamepad)
+        {
+            recordEvent(RecordedInputEvent::GAMEPAD, evt, (int)i, 0, (int)analogIndex, 0.0f);
+            break;
+        }
+    }
+    return true;
+}
+
+void InputRecorder::beginFrame()
+{
+    if (!_active)
+        return;
+
+    if (!_replaying)
+    {
+        ++__frame;
+        return;
+    }
+
+    // Time the previous frame, and advance the game time by the fixed step.
+    double now = Game::getAbsoluteTime();
+    if (__frameStart >= 0.0)
+    {
+        __frameTimes.push_back((float)(now - __frameStart));
+        __replayTime += __timeStep;
+    }
+    __frameStart = now;
+
+    // Deliver the events that arrived during the previous frame through the platform, as they were delivered when recorded.
+    ++__frame;
+    __injecting = true;
+    while (__nextEvent < __events.size() && __events[__nextEvent].frame < __frame)
+    {
+        const RecordedInputEvent event = __events[__nextEvent++];
+        switch (event.type)
+        {
+        case RecordedInputEvent::TOUCH:
+        case RecordedInputEvent::TOUCH_FROM_MOUSE:
+            Platform::touchEventInternal((Touch::TouchEvent)event.evt, event.x, event.y, (unsigned int)event.value,
+                event.type == RecordedInputEvent::TOUCH_FROM_MOUSE);
+            break;
+        case RecordedInputEvent::MOUSE:
+            Platform::mouseEventInternal((Mouse::MouseEvent)event.evt, event.x, event.y, event.value);
+            break;
+        case RecordedInputEvent::KEY:
+            Platform::keyEventInternal((Keyboard::KeyEvent)event.evt, event.value);
+            break;
+        case RecordedInputEvent::GESTURE:
+            switch (event.evt)
+            {
+            case Gesture::GESTURE_SWIPE:
+                Platform::gestureSwipeEventInternal(event.x, event.y, event.value);
+                break;
+            case Gesture::GESTURE_PINCH:
+                Platform::gesturePinchEventInternal(event.x, event.y, event.scale);
+                break;
+            case Gesture::GESTURE_TAP:
+                Platform::gestureTapEventInternal(event.x, event.y);
+                break;
+            case Gesture::GESTURE_LONG_TAP:
+                Platform::gestureLongTapEventInternal(event.x, event.y, event.scale);
+                break;
+            case Gesture::GESTURE_DRAG:
+                Platform::gestureDragEventInternal(event.x, event.y);
+                break;
+            case Gesture::GESTURE_DROP:
+                Platform::gestureDropEventInternal(event.x, event.y);
+                break;
+            }
+            break;
+        case RecordedInputEvent::GAMEPAD:
+            {
+                Game* game = Game::getInstance();
+                Gamepad* gamepad = (unsigned int)event.x < game->getGamepadCount() ? game->getGamepad((unsigned int)event.x, false) : NULL;
+                if (gamepad && !gamepad->isVirtual())
+                    Platform::gamepadEventInternal((Gamepad::GamepadEvent)event.evt, gamepad, (unsigned int)event.value);
+            }
+            break;
+        }
+    }
+    __injecting = false;
+
+    // The replay ends once the frames of the recording have all run.
+    if (__frame > __frameCount)
+        stopReplay();
+}
+
+double InputRecorder::getReplayTime()
+{
+    return __replayTime;
+}
+
+void InputRecorder::configure(Properties* properties)
+{
+    Properties* recorder = properties ? properties->getNamespace("inputRecorder", true) : NULL;
+    if (!recorder)
+        return;
+
+    const char* replay = recorder->getString("replay");
+    const char* frameTimes = recorder->getString("frameTimes");
+    const char* record = recorder->getString("record");
+    __frameTimesPath = frameTimes ? frameTimes : "";
+    __exitOnEnd = recorder->getBool("exitOnEnd");
+    if (replay)
+    {
+        float timeStep = recorder->exists("timeStep") ? recorder->getFloat("timeStep") : 1000.0f / 60.0f;
+        startReplay(replay, std::max(timeStep, 0.001f));
+    }
+    else if (record)
+    {
+        __recordPath = record;
+        startRecording();
+    }
+}
+
+void InputRecorder::finish()
+{
+    if (__recording)
+    {
+        stopRecording();
+        if (!__recordPath.empty())
+            save(__recordPath.c_str());
+    }
+    __exitOnEnd = false;
+    stopReplay();
+}
+
+}
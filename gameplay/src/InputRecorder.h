@@ -0,0 +1,185 @@
+#ifndef INPUTRECORDER_H_
+#define INPUTRECORDER_H_
+
+#include "Touch.h"
+#include "Mouse.h"
+#include "Keyboard.h"
+#include "Gamepad.h"
+#include "Gesture.h"
+
+namespace gameplay
+{
+
+class Properties;
+
+/**
+ * Defines a recorder of the input events of a session, which replays them to run the session again.
+ *
+ * While recording, every touch, mouse, key, gesture and gamepad event the platform delivers is
+ * recorded with the index of the frame it arrived before. While replaying, the input of the
+ * platform is ignored and the recorded events are delivered at the start of the frames they
+ * arrived before, in their order. The game time then advances by a fixed step each frame
+ * instead of following the clock, so the replayed session updates exactly as the recorded one
+ * (as long as the game does not depend on anything else that changes between runs, such as
+ * unseeded random numbers or the clock). This turns a recorded session into a benchmark that
+ * can be compared across builds: the time each replayed frame took is measured, and reported
+ * when the replay ends. Gamepad events are replayed to the gamepad with the same index, but the
+ * values the game polls from the gamepads are not recorded.
+ *
+ * Sessions are recorded and replayed from the start of the game by the "inputRecorder"
+ * section of game.config:
+ * @code
+   inputRecorder
+   {
+       record = session.input
+       replay = session.input
+       timeStep = 16.667
+       frameTimes = frames.csv
+       exitOnEnd = true
+   }
+ * @endcode
+ * The recording is written to the file set by record when the game exits. When replay is set,
+ * the session is replayed with the time step in milliseconds (60 frames per second by default).
+ * When the replay ends, the frame times are logged, written to the frameTimes file (one time
+ * in milliseconds per line), and the game exits if exitOnEnd is true.
+ *
+ * @script{ignore}
+ */
+class InputRecorder
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Starts recording the input events, discarding the events recorded before.
+     */
+    static void startRecording();
+
+    /**
+     * Stops recording the input events.
+     */
+    static void stopRecording();
+
+    /**
+     * Determines if the input events are being recorded.
+     *
+     * @return true if the input events are being recorded.
+     */
+    static bool isRecording();
+
+    /**
+     * Writes the recorded events to a file.
+     *
+     * @param path The path of the file.
+     *
+     * @return true if the file was written.
+     */
+    static bool save(const char* path);
+
+    /**
+     * Starts replaying the events recorded to a file, from the next frame.
+     *
+     * @param path The path of the recording.
+     * @param timeStep The game time each frame advances by, in milliseconds.
+     *
+     * @return true if the replay started, false if the file could not be read.
+     */
+    static bool startReplay(const char* path, float timeStep = 1000.0f / 60.0f);
+
+    /**
+     * Stops replaying and reports the frame times, returning the game to its clock.
+     */
+    static void stopReplay();
+
+    /**
+     * Determines if a recording is being replayed.
+     *
+     * @return true if a recording is being replayed.
+     */
+    static bool isReplaying();
+
+    /**
+     * Returns the number of frames since the recording or the replay started.
+     *
+     * @return The index of the current frame.
+     */
+    static unsigned int getFrame();
+
+    /**
+     * Returns the time each frame of the replay took.
+     *
+     * @return The times of the frames replayed so far, in milliseconds.
+     */
+    static const std::vector<float>& getFrameTimes();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    InputRecorder();
+
+    /**
+     * Determines if the platform must pass its events to the recorder.
+     */
+    inline static bool isActive();
+
+    /**
+     * Records a touch event, or returns false if it must be ignored because a recording is replayed.
+     */
+    static bool touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse);
+
+    /**
+     * Records a mouse event, or returns false if it must be ignored.
+     */
+    static bool mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
+
+    /**
+     * Records a key event, or returns false if it must be ignored.
+     */
+    static bool keyEvent(Keyboard::KeyEvent evt, int key);
+
+    /**
+     * Records a gesture event, or returns false if it must be ignored.
+     */
+    static bool gestureEvent(Gesture::GestureEvent evt, int x, int y, int value, float scale);
+
+    /**
+     * Records a gamepad event, or returns false if it must be ignored.
+     */
+    static bool gamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex);
+
+    /**
+     * Starts a frame: advances the replay clock and delivers the events replayed in the frame. Called by Game::frame.
+     */
+    static void beginFrame();
+
+    /**
+     * Returns the game time of the replay.
+     */
+    static double getReplayTime();
+
+    /**
+     * Starts recording or replaying as configured by game.config. Called by the game at startup.
+     */
+    static void configure(Properties* properties);
+
+    /**
+     * Writes the recording configured by game.config and stops. Called by the game at shutdown.
+     */
+    static void finish();
+
+    static bool _active;
+    static bool _replaying;
+};
+
+inline bool InputRecorder::isActive()
+{
+    return _active;
+}
+
+}
+
+#endif
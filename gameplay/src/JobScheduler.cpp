@@ -0,0 +1,261 @@
+#include "Base.h"
+#include "JobScheduler.h"
+#include "ScratchMemory.h"
+
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL __thread
+#endif
+
+namespace gameplay
+{
+
+// The queue used by the current thread (0 for the game thread and any thread that is not a worker).
+static JOB_THREAD_LOCAL unsigned int __queueIndex = 0;
+
+JobScheduler::Group::Group()
+    : _pending(0)
+{
+}
+
+JobScheduler::Group::~Group()
+{
+    GP_ASSERT(_pending == 0);
+}
+
+JobScheduler::JobScheduler()
+    : _jobCount(0), _running(false)
+{
+}
+
+JobScheduler::~JobScheduler()
+{
+    finalize();
+}
+
+void JobScheduler::initialize(unsigned int workerCount)
+{
+    GP_ASSERT(_queues.empty());
+
+    _running = true;
+    for (unsigned int i = 0; i <= workerCount; ++i)
+    {
+        _queues.push_back(new Queue());
+    }
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        Worker* worker = new Worker();
+        worker->scheduler = this;
+        worker->queueIndex = i + 1;
+        worker->thread = Thread::create(&JobScheduler::workerMain, worker);
+        if (worker->thread == NULL)
+        {
+            SAFE_DELETE(worker);
+            break;
+        }
+        _workers.push_back(worker);
+    }
+}
+
+void JobScheduler::finalize()
+{
+    {
+        Mutex::Lock lock(_mutex);
+        _running = false;
+        _condition.broadcast();
+    }
+    for (size_t i = 0, count = _workers.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_workers[i]->thread);
+        SAFE_DELETE(_workers[i]);
+    }
+    _workers.clear();
+    for (size_t i = 0, count = _queues.size(); i < count; ++i)
+    {
+        GP_ASSERT(_queues[i]->jobs.empty());
+        SAFE_DELETE(_queues[i]);
+    }
+    _queues.clear();
+}
+
+void JobScheduler::run(Group& group, Function function, void* arg)
+{
+    GP_ASSERT(function);
+    GP_ASSERT(!_queues.empty());
+
+    Job job;
+    job.function = function;
+    job.arg = arg;
+    job.group = &group;
+
+    {
+        Mutex::Lock lock(_mutex);
+        ++group._pending;
+    }
+    {
+        Queue* queue = _queues[__queueIndex < _queues.size() ? __queueIndex : 0];
+        Mutex::Lock lock(queue->mutex);
+        queue->jobs.push_back(job);
+    }
+    Mutex::Lock lock(_mutex);
+    ++_jobCount;
+    _condition.signal();
+}
+
+void JobScheduler::wait(Group& group)
+{
+    unsigned int queueIndex = __queueIndex < _queues.size() ? __queueIndex : 0;
+    while (true)
+    {
+        Job job;
+        if (popJob(queueIndex, &job))
+        {
+            execute(job);
+            continue;
+        }
+
+        // Sleep until the group completes or more work is queued.
+        Mutex::Lock lock(_mutex);
+        while (group._pending > 0 && _jobCount <= 0)
+        {
+            _condition.wait(_mutex);
+        }
+        if (group._pending == 0)
+            return;
+    }
+}
+
+bool JobScheduler::isDone(const Group& group)
+{
+    Mutex::Lock lock(_mutex);
+    return group._pending == 0;
+}
+
+void JobScheduler::parallelFor(unsigned int count, RangeFunction function, void* arg, unsigned int grainSize)
+{
+    GP_ASSERT(function);
+
+    if (count == 0)
+        return;
+    if (grainSize == 0)
+        grainSize = 1;
+
+    // Split the range into about one chunk per thread.
+    unsigned int threadCount = (unsigned int)_workers.size() + 1;
+    unsigned int chunkSize = (count + threadCount - 1) / threadCount;
+    chunkSize = ((chunkSize + grainSize - 1) / grainSize) * grainSize;
+    if (chunkSize >= count)
+    {
+        function(arg, 0, count);
+        return;
+    }
+
+    // The workers only read the ranges, so they can live in the scratch memory of this thread.
+    ScratchMemory::Scope scratch;
+    ScratchVector<Range>::type ranges;
+    ranges.reserve(threadCount);
+    for (unsigned int start = 0; start < count; start += chunkSize)
+    {
+        Range range;
+        range.function = function;
+        range.arg = arg;
+        range.start = start;
+        range.end = std::min(start + chunkSize, count);
+        ranges.push_back(range);
+    }
+
+    // Queue all but the first chunk and run that one on this thread.
+    Group group;
+    for (size_t i = 1, rangeCount = ranges.size(); i < rangeCount; ++i)
+    {
+        run(group, &JobScheduler::runRange, &ranges[i]);
+    }
+    function(arg, ranges[0].start, ranges[0].end);
+    wait(group);
+}
+
+unsigned int JobScheduler::getWorkerCount() const
+{
+    return (unsigned int)_workers.size();
+}
+
+bool JobScheduler::popJob(unsigned int queueIndex, Job* job)
+{
+    GP_ASSERT(job);
+
+    // Take the newest job from our own queue, then steal the oldest job from the others.
+    size_t queueCount = _queues.size();
+    for (size_t i = 0; i < queueCount; ++i)
+    {
+        Queue* queue = _queues[(queueIndex + i) % queueCount];
+        Mutex::Lock lock(queue->mutex);
+        if (!queue->jobs.empty())
+        {
+            if (i == 0)
+            {
+                *job = queue->jobs.back();
+                queue->jobs.pop_back();
+            }
+            else
+            {
+                *job = queue->jobs.front();
+                queue->jobs.pop_front();
+            }
+            break;
+        }
+        if (i == queueCount - 1)
+            return false;
+    }
+
+    Mutex::Lock lock(_mutex);
+    --_jobCount;
+    return true;
+}
+
+void JobScheduler::execute(const Job& job)
+{
+    job.function(job.arg);
+
+    Mutex::Lock lock(_mutex);
+    if (--job.group->_pending == 0)
+    {
+        _condition.broadcast();
+    }
+}
+
+int JobScheduler::workerMain(void* arg)
+{
+    Worker* worker = (Worker*)arg;
+    GP_ASSERT(worker);
+    JobScheduler* scheduler = worker->scheduler;
+    __queueIndex = worker->queueIndex;
+
+    while (true)
+    {
+        Job job;
+        if (scheduler->popJob(__queueIndex, &job))
+        {
+            scheduler->execute(job);
+            continue;
+        }
+
+        Mutex::Lock lock(scheduler->_mutex);
+        while (scheduler->_running && scheduler->_jobCount <= 0)
+        {
+            scheduler->_condition.wait(scheduler->_mutex);
+        }
+        if (!scheduler->_running)
+            break;
+    }
+    return 0;
+}
+
+void JobScheduler::runRange(void* arg)
+{
+    Range* range = (Range*)arg;
+    GP_ASSERT(range);
+    range->function(range->arg, range->start, range->end);
+}
+
+}
@@ -0,0 +1,221 @@
+#ifndef JOBSCHEDULER_H_
+#define JOBSCHEDULER_H_
+
+#include "Thread.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a work-stealing scheduler that runs jobs on a pool of worker threads.
+ *
+ * Jobs are forked into a Group with run() and joined with wait(). Each worker thread
+ * keeps its own queue of jobs, taking the most recently added job from its own queue
+ * and stealing the oldest jobs from other queues when it runs out. The thread calling
+ * wait() helps by running queued jobs until the group completes, so jobs may fork and
+ * join their own groups.
+ *
+ * The scheduler is owned by the game, which creates the number of worker threads set
+ * by the 'workerCount' property in the 'jobs' section of the game configuration file
+ * (by default, one less than the number of processors). With no worker threads, all
+ * jobs run on the thread that waits for them.
+ *
+ * Jobs must not make graphics calls, which are only allowed on the game thread, and
+ * must not touch engine objects that other jobs or the game thread use at the same time.
+ *
+ * @script{ignore}
+ */
+class JobScheduler
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the signature of a job function.
+     *
+     * @param arg The argument passed to run().
+     */
+    typedef void (*Function)(void* arg);
+
+    /**
+     * Defines the signature of a function run over a range of indices by parallelFor().
+     *
+     * @param arg The argument passed to parallelFor().
+     * @param start The first index of the range.
+     * @param end One past the last index of the range.
+     */
+    typedef void (*RangeFunction)(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Defines a group of jobs that can be waited on together.
+     */
+    class Group
+    {
+        friend class JobScheduler;
+
+    public:
+
+        /**
+         * Constructor.
+         */
+        Group();
+
+        /**
+         * Destructor. All jobs in the group must have been waited on.
+         */
+        ~Group();
+
+    private:
+
+        Group(const Group& copy);
+
+        Group& operator=(const Group&);
+
+        int _pending;
+    };
+
+    /**
+     * Queues a job to run as part of the specified group.
+     *
+     * @param group The group to add the job to.
+     * @param function The job function.
+     * @param arg The argument to pass to the job function.
+     */
+    void run(Group& group, Function function, void* arg);
+
+    /**
+     * Waits until all the jobs in the specified group have completed, running queued jobs in the meantime.
+     *
+     * @param group The group to wait for.
+     */
+    void wait(Group& group);
+
+    /**
+     * Returns whether all the jobs in the specified group have completed, without waiting.
+     *
+     * This allows the game thread to poll for background work from one frame to the next.
+     *
+     * @param group The group to check.
+     *
+     * @return True if the group has no pending jobs.
+     */
+    bool isDone(const Group& group);
+
+    /**
+     * Runs a function over the range [0, count) split into chunks that run in parallel,
+     * and waits for all of them to complete.
+     *
+     * Every chunk except the last one contains a multiple of grainSize indices.
+     *
+     * @param count The number of indices.
+     * @param function The function to run over each chunk.
+     * @param arg The argument to pass to the function.
+     * @param grainSize The minimum number of indices in a chunk.
+     */
+    void parallelFor(unsigned int count, RangeFunction function, void* arg, unsigned int grainSize = 1);
+
+    /**
+     * Returns the number of worker threads.
+     *
+     * @return The number of worker threads, not including the game thread.
+     */
+    unsigned int getWorkerCount() const;
+
+private:
+
+    /**
+     * Defines a queued job.
+     */
+    struct Job
+    {
+        Function function;
+        void* arg;
+        Group* group;
+    };
+
+    /**
+     * Defines the job queue of a thread.
+     */
+    struct Queue
+    {
+        Mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    /**
+     * Defines a worker thread.
+     */
+    struct Worker
+    {
+        JobScheduler* scheduler;
+        unsigned int queueIndex;
+        Thread* thread;
+    };
+
+    /**
+     * Defines a chunk of a parallelFor() range.
+     */
+    struct Range
+    {
+        RangeFunction function;
+        void* arg;
+        unsigned int start;
+        unsigned int end;
+    };
+
+    /**
+     * Constructor.
+     */
+    JobScheduler();
+
+    /**
+     * Destructor.
+     */
+    ~JobScheduler();
+
+    /**
+     * Hidden copy constructor.
+     */
+    JobScheduler(const JobScheduler& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    JobScheduler& operator=(const JobScheduler&);
+
+    /**
+     * Starts the worker threads.
+     */
+    void initialize(unsigned int workerCount);
+
+    /**
+     * Stops and joins the worker threads.
+     */
+    void finalize();
+
+    /**
+     * Takes a job from the queue of the calling thread, or steals one from another queue.
+     */
+    bool popJob(unsigned int queueIndex, Job* job);
+
+    /**
+     * Runs a job and marks it as completed.
+     */
+    void execute(const Job& job);
+
+    static int workerMain(void* arg);
+
+    static void runRange(void* arg);
+
+    std::vector<Queue*> _queues;
+    std::vector<Worker*> _workers;
+    Mutex _mutex;
+    Condition _condition;
+    int _jobCount;
+    bool _running;
+};
+
+}
+
+#endif
@@ -6,7 +6,7 @@ namespace gameplay
 {
 
 Joint::Joint(const char* id)
-    : Node(id), _jointMatrixDirty(true)
+    : Node(id), _skeletonChanged(false)
 {
 }
 
@@ -19,6 +19,17 @@ Joint* Joint::create(const char* id)
     return new Joint(id);
 }
 
+unsigned int Joint::getAnimationSkipLod() const
+{
+    unsigned int lod = 1;
+    for (Node* child = getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        if (child->getType() == Node::JOINT)
+            lod = std::max(lod, static_cast<Joint*>(child)->getAnimationSkipLod() + 1);
+    }
+    return lod;
+}
+
 Node* Joint::cloneSingleNode(NodeCloneContext &context) const
 {
     Joint* copy = Joint::create(getId());
@@ -57,40 +68,58 @@ Scene* Joint::getScene() const
 
 void Joint::transformChanged()
 {
+    // During a batched update of the skeleton, the change is only recorded. MeshSkin::endJointUpdate()
+    // then propagates it to the joints and the nodes attached below, once.
+    if (isSkeletonUpdating())
+    {
+        setTransformDirty();
+        _skeletonChanged = true;
+        return;
+    }
+
     Node::transformChanged();
-    _jointMatrixDirty = true;
+    setSkinsDirty(false);
 }
 
-void Joint::updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette)
+const Matrix& Joint::getInverseBindPose() const
 {
-    // Note: If more than one MeshSkin influences this Joint, we need to skip
-    // the _jointMatrixDirty optimization since updateJointMatrix() may be
-    // called multiple times a frame with different bindShape matrices (and
-    // different matrixPallete pointers).
-    if (_skin.next || _jointMatrixDirty)
-    {
-        _jointMatrixDirty = false;
+    return _bindPose;
+}
 
-        static Matrix t;
-        Matrix::multiply(Node::getWorldMatrix(), getInverseBindPose(), &t);
-        Matrix::multiply(t, bindShape, &t);
+void Joint::setInverseBindPose(const Matrix& m)
+{
+    _bindPose = m;
+    setSkinsDirty(true);
+}
 
-        GP_ASSERT(matrixPalette);
-        matrixPalette[0].set(t.m[0], t.m[4], t.m[8], t.m[12]);
-        matrixPalette[1].set(t.m[1], t.m[5], t.m[9], t.m[13]);
-        matrixPalette[2].set(t.m[2], t.m[6], t.m[10], t.m[14]);
+void Joint::setSkinsDirty(bool bindPoseChanged)
+{
+    for (SkinReference* itr = &_skin; itr && itr->skin; itr = itr->next)
+    {
+        itr->skin->_matrixPaletteDirty = true;
+        itr->skin->setJointBoundsDirty();
+        if (bindPoseChanged)
+            itr->skin->_bindMatricesDirty = true;
     }
 }
 
-const Matrix& Joint::getInverseBindPose() const
+bool Joint::isSkeletonUpdating() const
 {
-    return _bindPose;
+    for (const SkinReference* itr = &_skin; itr && itr->skin; itr = itr->next)
+    {
+        if (itr->skin->_updatingJoints)
+            return true;
+    }
+    return false;
 }
 
-void Joint::setInverseBindPose(const Matrix& m)
+void Joint::skeletonChanged()
 {
-    _bindPose = m;
-    _jointMatrixDirty = true;
+    _skeletonChanged = false;
+    setTransformDirty();
+    getWorldMatrix();
+    Transform::transformChanged();
+    setSkinsDirty(false);
 }
 
 void Joint::addSkin(MeshSkin* skin)
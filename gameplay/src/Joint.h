@@ -41,6 +41,16 @@ public:
      */
     const Matrix& getInverseBindPose() const;
 
+    /**
+     * Gets the level of detail from which the channels targeting this joint are skipped.
+     *
+     * Leaf joints are skipped from level 1, the joints above them from level 2, and so on
+     * up the joint hierarchy.
+     *
+     * @see AnimationTarget::getAnimationSkipLod()
+     */
+    unsigned int getAnimationSkipLod() const;
+
 protected:
 
     /**
@@ -79,14 +89,6 @@ protected:
      */
     void setInverseBindPose(const Matrix& m);
 
-    /**
-     * Updates the joint matrix.
-     * 
-     * @param bindShape The bind shape matrix.
-     * @param matrixPalette The matrix palette to update.
-     */
-    void updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette);
-
     /**
      * Called when this Joint's transform changes.
      */
@@ -120,20 +122,38 @@ private:
 
     void removeSkin(MeshSkin* skin);
 
+    /**
+     * Marks the matrix palettes of the skins influenced by this joint as needing an update.
+     *
+     * @param bindPoseChanged true if the inverse bind pose of this joint has changed.
+     */
+    void setSkinsDirty(bool bindPoseChanged);
+
+    /**
+     * Determines if a skin of this joint is between MeshSkin::beginJointUpdate() and MeshSkin::endJointUpdate().
+     */
+    bool isSkeletonUpdating() const;
+
+    /**
+     * Brings the world matrix of this joint up to date at the end of a batched update of its skeleton,
+     * and notifies the listeners of this joint and the skins it influences once.
+     */
+    void skeletonChanged();
+
     /** 
      * The Matrix representation of the Joint's bind pose.
      */
     Matrix _bindPose;
 
     /**
-     * Flag used to mark if the Joint's matrix is dirty.
+     * Linked list of mesh skins that are referenced by this joint.
      */
-    bool _jointMatrixDirty;
+    SkinReference _skin;
 
     /**
-     * Linked list of mesh skins that are referenced by this joint.
+     * Whether the transform of this joint changed during a batched update of its skeleton.
      */
-    SkinReference _skin;
+    bool _skeletonChanged;
 };
 
 }
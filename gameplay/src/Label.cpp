@@ -4,12 +4,13 @@
 namespace gameplay
 {
 
-Label::Label() : _text(""), _font(NULL)
+Label::Label() : _text(""), _font(NULL), _cachedText(NULL)
 {
 }
 
 Label::~Label()
 {
+    SAFE_DELETE(_cachedText);
 }
 
 Label* Label::create(const char* id, Theme::Style* style)
@@ -125,7 +126,8 @@ unsigned int Label::drawText(Form* form, const Rectangle& clip)
 
         SpriteBatch* batch = _font->getSpriteBatch(fontSize);
         startBatch(form, batch);
-        _font->drawText(_text.c_str(), _textBounds, _textColor, fontSize, getTextAlignment(state), true, getTextRightToLeft(state), &_viewportClipBounds);
+        _cachedText = _font->updateText(_cachedText, _text.c_str(), _textBounds, _textColor, fontSize, getTextAlignment(state), true, getTextRightToLeft(state), &_viewportClipBounds);
+        _font->drawText(_cachedText);
         finishBatch(form, batch);
 
         return 1;
@@ -136,6 +136,11 @@ protected:
      */
     Rectangle _textBounds;
 
+    /**
+     * The laid out text from the last draw, reused while the text and its layout do not change.
+     */
+    Font::Text* _cachedText;
+
 private:
 
     /**
@@ -0,0 +1,287 @@
+#include "Base.h"
+#include "LightClusters.h"
+#include "Light.h"
+#include "Node.h"
+#include "Scene.h"
+#include "RenderState.h"
+#include "Game.h"
+#include "GLStateCache.h"
+
+// Width of the cluster texture, in texels.
+#define CLUSTER_TEXTURE_WIDTH 1024
+
+// Number of texels of a light: view-space position and range inverse, then color.
+#define CLUSTER_LIGHT_TEXELS 2
+
+namespace gameplay
+{
+
+LightClusters::LightClusters(unsigned int columns, unsigned int rows, unsigned int slices, unsigned int maxLights)
+    : _columns(columns), _rows(rows), _slices(slices), _maxLights(maxLights), _headerBase(0), _indexBase(0),
+    _width(0), _height(0), _referenceCount(0), _sampler(NULL)
+{
+}
+
+LightClusters::~LightClusters()
+{
+    SAFE_RELEASE(_sampler);
+}
+
+LightClusters* LightClusters::create(unsigned int columns, unsigned int rows, unsigned int slices, unsigned int maxLights)
+{
+    GP_ASSERT(columns > 0 && rows > 0 && slices > 0 && maxLights > 0);
+
+    if (!isSupported())
+    {
+        GP_WARN("Clustered lighting is not supported by the graphics driver.");
+        return NULL;
+    }
+
+#ifdef USE_LIGHT_CLUSTERS
+    LightClusters* clusters = new LightClusters(columns, rows, slices, maxLights);
+
+    // The texture holds the lights, then the header (offset and count) of each cluster,
+    // then the light lists of the clusters with four light indices per texel.
+    unsigned int clusterCount = columns * rows * slices;
+    clusters->_headerBase = maxLights * CLUSTER_LIGHT_TEXELS;
+    clusters->_indexBase = clusters->_headerBase + clusterCount;
+    unsigned int texelCount = clusters->_indexBase + (clusterCount * MAX_CLUSTER_LIGHTS + 3) / 4;
+    clusters->_width = std::min(texelCount, (unsigned int)CLUSTER_TEXTURE_WIDTH);
+    clusters->_height = (texelCount + clusters->_width - 1) / clusters->_width;
+    clusters->_texelSize.set(1.0f / clusters->_width, 1.0f / clusters->_height);
+    clusters->_counts.resize(clusterCount);
+    clusters->_data.resize(clusters->_width * clusters->_height * 4, 0.0f);
+
+    // Don't disturb the texture bound by the pass being bound.
+    GLuint boundTexture = GLStateCache::getTexture(GL_TEXTURE_2D);
+
+    GLuint handle;
+    GL_ASSERT( glGenTextures(1, &handle) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, handle);
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, clusters->_width, clusters->_height, 0, GL_RGBA, GL_FLOAT, &clusters->_data[0]) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, boundTexture);
+
+    Texture* texture = Texture::create(handle, clusters->_width, clusters->_height);
+    clusters->_sampler = Texture::Sampler::create(texture);
+    clusters->_sampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    clusters->_sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    SAFE_RELEASE(texture);
+
+    return clusters;
+#else
+    return NULL;
+#endif
+}
+
+bool LightClusters::isSupported()
+{
+#ifdef USE_LIGHT_CLUSTERS
+    static int supported = -1;
+    if (supported < 0)
+    {
+        supported = (GLEW_VERSION_3_0 || GLEW_ARB_texture_float) ? 1 : 0;
+    }
+    return supported == 1;
+#else
+    return false;
+#endif
+}
+
+bool LightClusters::collectLight(Node* node)
+{
+    Light* light = node->getLight();
+    if (light && light->getLightType() == Light::POINT && _lights.size() < _maxLights)
+    {
+        ClusterLight clusterLight;
+        clusterLight.position = node->getTranslationWorld();
+        clusterLight.range = light->getRange();
+        clusterLight.color = light->getColor();
+        _lights.push_back(clusterLight);
+    }
+    return true;
+}
+
+int LightClusters::getSlice(float depth) const
+{
+    int slice = (int)floor(log(depth) * _depthScaleBias.x + _depthScaleBias.y);
+    return std::max(0, std::min(slice, (int)_slices - 1));
+}
+
+void LightClusters::update(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    _lights.clear();
+    _referenceCount = 0;
+    std::fill(_counts.begin(), _counts.end(), 0);
+
+    Camera* camera = scene->getActiveCamera();
+    if (camera)
+    {
+        scene->visit(this, &LightClusters::collectLight);
+
+        // Depth slices are spaced exponentially between the near and far planes.
+        float nearPlane = camera->getNearPlane();
+        float farPlane = camera->getFarPlane();
+        _depthScaleBias.x = _slices / log(farPlane / nearPlane);
+        _depthScaleBias.y = -log(nearPlane) * _depthScaleBias.x;
+
+        const Rectangle& viewport = Game::getInstance()->getViewport();
+        _viewport.set(viewport.x, viewport.y, 1.0f / viewport.width, 1.0f / viewport.height);
+    }
+
+    const Matrix& view = camera ? camera->getViewMatrix() : Matrix::identity();
+    const Matrix& projection = camera ? camera->getProjectionMatrix() : Matrix::identity();
+    float nearPlane = camera ? camera->getNearPlane() : 0.0f;
+    float farPlane = camera ? camera->getFarPlane() : 0.0f;
+
+    // Write the lights in view space and find the range of clusters each one overlaps.
+    std::vector<int> bounds;
+    bounds.reserve(_lights.size() * 6);
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        ClusterLight& light = _lights[i];
+        Vector3 center;
+        view.transformPoint(light.position, &center);
+
+        float* texel = &_data[i * CLUSTER_LIGHT_TEXELS * 4];
+        texel[0] = center.x;
+        texel[1] = center.y;
+        texel[2] = center.z;
+        texel[3] = light.range > 0.0f ? 1.0f / light.range : 0.0f;
+        texel[4] = light.color.x;
+        texel[5] = light.color.y;
+        texel[6] = light.color.z;
+        texel[7] = 0.0f;
+
+        float minDepth = std::max(-center.z - light.range, nearPlane);
+        float maxDepth = std::min(-center.z + light.range, farPlane);
+        if (minDepth > maxDepth)
+        {
+            bounds.insert(bounds.end(), 6, -1);
+            continue;
+        }
+
+        // Project the corners of the light's bounding box, clipped to the depth range.
+        float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Vector4 point(center.x + ((corner & 1) ? light.range : -light.range),
+                          center.y + ((corner & 2) ? light.range : -light.range),
+                          (corner & 4) ? -maxDepth : -minDepth, 1.0f);
+            Vector4 clip;
+            projection.transformVector(point, &clip);
+            float x = clip.x / clip.w;
+            float y = clip.y / clip.w;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+        {
+            bounds.insert(bounds.end(), 6, -1);
+            continue;
+        }
+
+        bounds.push_back(std::max(0, (int)floor((minX * 0.5f + 0.5f) * _columns)));
+        bounds.push_back(std::min((int)_columns - 1, (int)floor((maxX * 0.5f + 0.5f) * _columns)));
+        bounds.push_back(std::max(0, (int)floor((minY * 0.5f + 0.5f) * _rows)));
+        bounds.push_back(std::min((int)_rows - 1, (int)floor((maxY * 0.5f + 0.5f) * _rows)));
+        bounds.push_back(getSlice(minDepth));
+        bounds.push_back(getSlice(maxDepth));
+    }
+
+    // Count the lights of each cluster, then lay out the light lists one after another.
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        const int* b = &bounds[i * 6];
+        for (int z = b[4]; z >= 0 && z <= b[5]; ++z)
+        {
+            for (int y = b[2]; y <= b[3]; ++y)
+            {
+                for (int x = b[0]; x <= b[1]; ++x)
+                {
+                    unsigned int& clusterCount = _counts[x + (y + z * _rows) * _columns];
+                    if (clusterCount < MAX_CLUSTER_LIGHTS)
+                        ++clusterCount;
+                }
+            }
+        }
+    }
+    for (size_t i = 0, count = _counts.size(); i < count; ++i)
+    {
+        float* header = &_data[(_headerBase + i) * 4];
+        header[0] = (float)_referenceCount;
+        header[1] = 0.0f;
+        _referenceCount += _counts[i];
+    }
+
+    // Fill the light lists, using the header counts as the insertion cursors.
+    float* indices = &_data[_indexBase * 4];
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        const int* b = &bounds[i * 6];
+        for (int z = b[4]; z >= 0 && z <= b[5]; ++z)
+        {
+            for (int y = b[2]; y <= b[3]; ++y)
+            {
+                for (int x = b[0]; x <= b[1]; ++x)
+                {
+                    unsigned int cluster = x + (y + z * _rows) * _columns;
+                    float* header = &_data[(_headerBase + cluster) * 4];
+                    if (header[1] < (float)_counts[cluster])
+                    {
+                        indices[(unsigned int)(header[0] + header[1])] = (float)i;
+                        header[1] += 1.0f;
+                    }
+                }
+            }
+        }
+    }
+
+#ifdef USE_LIGHT_CLUSTERS
+    // Upload the rows that contain the lights, headers and light lists of this frame.
+    unsigned int texelCount = _indexBase + (_referenceCount + 3) / 4;
+    unsigned int rows = (texelCount + _width - 1) / _width;
+    GLuint boundTexture = GLStateCache::getTexture(GL_TEXTURE_2D);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _sampler->getTexture()->getHandle());
+    GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, rows, GL_RGBA, GL_FLOAT, &_data[0]) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, boundTexture);
+    Game::countBufferUpload(sizeof(float) * 4 * _width * rows);
+#endif
+}
+
+void LightClusters::bind(RenderState* renderState)
+{
+    GP_ASSERT(renderState);
+
+    renderState->getParameter("u_lightClusterTexture")->setValue(_sampler);
+    renderState->getParameter("u_lightClusterTexelSize")->setValue(_texelSize);
+    renderState->getParameter("u_lightClusterGrid")->setValue(Vector3((float)_columns, (float)_rows, (float)_slices));
+    renderState->getParameter("u_lightClusterLayout")->setValue(Vector3((float)_headerBase, (float)_indexBase, (float)_width));
+    renderState->getParameter("u_lightClusterDepth")->bindValue(this, &LightClusters::getDepthScaleBias);
+    renderState->getParameter("u_lightClusterViewport")->bindValue(this, &LightClusters::getViewport);
+}
+
+unsigned int LightClusters::getLightCount() const
+{
+    return (unsigned int)_lights.size();
+}
+
+unsigned int LightClusters::getLightReferenceCount() const
+{
+    return _referenceCount;
+}
+
+const Vector2& LightClusters::getDepthScaleBias() const
+{
+    return _depthScaleBias;
+}
+
+const Vector4& LightClusters::getViewport() const
+{
+    return _viewport;
+}
+
+}
@@ -0,0 +1,191 @@
+#ifndef LIGHTCLUSTERS_H_
+#define LIGHTCLUSTERS_H_
+
+#include "Ref.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+class Light;
+class RenderState;
+
+/**
+ * Defines a clustered forward lighting grid for the point lights of a scene.
+ *
+ * The view frustum of the active camera is divided into a grid of clusters: columns and
+ * rows of screen tiles, each split into depth slices that grow exponentially with the
+ * distance from the camera. Every frame, update() collects the point lights of the scene,
+ * finds the clusters that each light's range overlaps and uploads the lights and the
+ * per-cluster light lists to a floating-point texture. Effects compiled with the
+ * CLUSTERED_LIGHTING define (textured and colored shaders) then look up the cluster of
+ * each pixel and only shade the lights that affect it.
+ *
+ * This lets a single shader permutation handle any number of dynamic point lights, instead
+ * of compiling an effect per light count and binding each light through material parameters.
+ * Directional and spot lights still use the per-material lighting defines, and can be
+ * combined with clustered lighting in the same effect. Clustered lighting is not supported
+ * together with the BUMPED define.
+ *
+ * To use clustered lighting, create the clusters once, call bind() for each material pass
+ * that uses a CLUSTERED_LIGHTING effect and call update() every frame before drawing:
+ *
+ * @code
+   LightClusters* clusters = LightClusters::create();
+   clusters->bind(material);
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       clusters->update(scene);
+       ...
+   }
+ * @endcode
+ *
+ * At most MAX_CLUSTER_LIGHTS lights are shaded per cluster, matching the shader loop.
+ *
+ * @script{ignore}
+ */
+class LightClusters : public Ref
+{
+public:
+
+    /**
+     * The maximum number of lights shaded per cluster.
+     */
+    static const unsigned int MAX_CLUSTER_LIGHTS = 32;
+
+    /**
+     * Creates a light cluster grid.
+     *
+     * @param columns The number of screen tiles along the width of the viewport.
+     * @param rows The number of screen tiles along the height of the viewport.
+     * @param slices The number of depth slices between the near and far planes.
+     * @param maxLights The maximum number of point lights per frame.
+     *
+     * @return The new light clusters, or NULL if clustered lighting is not supported.
+     */
+    static LightClusters* create(unsigned int columns = 16, unsigned int rows = 8, unsigned int slices = 16, unsigned int maxLights = 256);
+
+    /**
+     * Returns whether clustered lighting is supported by the graphics driver.
+     *
+     * Clustered lighting requires floating-point textures.
+     *
+     * @return True if clustered lighting is supported.
+     */
+    static bool isSupported();
+
+    /**
+     * Bins the point lights of the specified scene into clusters and uploads them.
+     *
+     * The clusters are built for the active camera of the scene and the current
+     * viewport of the game.
+     *
+     * @param scene The scene to collect the point lights of.
+     */
+    void update(Scene* scene);
+
+    /**
+     * Binds the cluster uniforms of the specified render state to these clusters.
+     *
+     * The render state keeps pointers to these clusters, which must be kept alive for
+     * as long as the render state is used.
+     *
+     * @param renderState The render state (typically a Material) to bind.
+     */
+    void bind(RenderState* renderState);
+
+    /**
+     * Returns the number of point lights binned by the last update.
+     *
+     * @return The number of lights.
+     */
+    unsigned int getLightCount() const;
+
+    /**
+     * Returns the number of light indices stored in the cluster lists by the last update.
+     *
+     * This is the sum of the light counts of all clusters.
+     *
+     * @return The number of light references.
+     */
+    unsigned int getLightReferenceCount() const;
+
+private:
+
+    /**
+     * Defines a point light collected for the current frame.
+     */
+    struct ClusterLight
+    {
+        Vector3 position;
+        float range;
+        Vector3 color;
+    };
+
+    /**
+     * Constructor.
+     */
+    LightClusters(unsigned int columns, unsigned int rows, unsigned int slices, unsigned int maxLights);
+
+    /**
+     * Destructor.
+     */
+    ~LightClusters();
+
+    /**
+     * Hidden copy constructor.
+     */
+    LightClusters(const LightClusters& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    LightClusters& operator=(const LightClusters&);
+
+    /**
+     * Adds the point light of a node to the lights of the current frame (scene visitor).
+     */
+    bool collectLight(Node* node);
+
+    /**
+     * Returns the depth slice of a view-space distance from the camera.
+     */
+    int getSlice(float depth) const;
+
+    /**
+     * Returns the scale and bias that convert the log of a view-space depth to a slice.
+     */
+    const Vector2& getDepthScaleBias() const;
+
+    /**
+     * Returns the viewport origin and inverse size used to find the tile of a pixel.
+     */
+    const Vector4& getViewport() const;
+
+    unsigned int _columns;
+    unsigned int _rows;
+    unsigned int _slices;
+    unsigned int _maxLights;
+    unsigned int _headerBase;
+    unsigned int _indexBase;
+    unsigned int _width;
+    unsigned int _height;
+    unsigned int _referenceCount;
+    Texture::Sampler* _sampler;
+    Vector2 _texelSize;
+    Vector2 _depthScaleBias;
+    Vector4 _viewport;
+    std::vector<ClusterLight> _lights;
+    std::vector<unsigned int> _counts;
+    std::vector<float> _data;
+};
+
+}
+
+#endif
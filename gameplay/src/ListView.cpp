@@ -0,0 +1,191 @@
+#include "Base.h"
+#include "ListView.h"
+
+namespace gameplay
+{
+
+// Height of the items of a list view that does not specify one.
+static const float DEFAULT_ITEM_HEIGHT = 32.0f;
+
+ListView::ListView()
+    : _dataSource(NULL), _itemHeight(DEFAULT_ITEM_HEIGHT), _reload(true)
+{
+}
+
+ListView::~ListView()
+{
+}
+
+ListView* ListView::create(const char* id, Theme::Style* style)
+{
+    ListView* list = new ListView();
+    list->_id = id ? id : "";
+    list->_layout = createLayout(Layout::LAYOUT_ABSOLUTE);
+    list->initialize("ListView", style, NULL);
+    return list;
+}
+
+Control* ListView::create(Theme::Style* style, Properties* properties)
+{
+    ListView* list = new ListView();
+    list->initialize("ListView", style, properties);
+    return list;
+}
+
+void ListView::initialize(const char* typeName, Theme::Style* style, Properties* properties)
+{
+    Container::initialize(typeName, style, properties);
+
+    if (properties && properties->exists("itemHeight"))
+        _itemHeight = properties->getFloat("itemHeight");
+
+    // Items are positioned by the list itself.
+    if (_layout == NULL || _layout->getType() != Layout::LAYOUT_ABSOLUTE)
+    {
+        SAFE_RELEASE(_layout);
+        _layout = createLayout(Layout::LAYOUT_ABSOLUTE);
+    }
+    if (_scroll == SCROLL_NONE)
+        setScroll(SCROLL_VERTICAL);
+}
+
+const char* ListView::getType() const
+{
+    return "listView";
+}
+
+void ListView::setDataSource(DataSource* dataSource)
+{
+    if (_dataSource != dataSource)
+    {
+        clearItems();
+        _dataSource = dataSource;
+        reloadData();
+    }
+}
+
+ListView::DataSource* ListView::getDataSource() const
+{
+    return _dataSource;
+}
+
+void ListView::setItemHeight(float height)
+{
+    if (_itemHeight != height)
+    {
+        _itemHeight = height;
+        reloadData();
+    }
+}
+
+float ListView::getItemHeight() const
+{
+    return _itemHeight;
+}
+
+void ListView::reloadData()
+{
+    _reload = true;
+    setDirty(DIRTY_BOUNDS);
+}
+
+int ListView::getItemIndex(Control* item) const
+{
+    for (size_t i = 0, count = _items.size(); i < count; ++i)
+    {
+        if (_items[i] == item)
+            return _itemIndices[i];
+    }
+    return -1;
+}
+
+void ListView::updateAbsoluteBounds(const Vector2& offset)
+{
+    // Update the scroll position first, since it determines which items are visible.
+    Container::updateAbsoluteBounds(offset);
+
+    updateItems();
+}
+
+void ListView::getContentSize(float* width, float* height) const
+{
+    GP_ASSERT(width && height);
+
+    *width = _viewportBounds.width;
+    *height = _dataSource ? _dataSource->getItemCount(const_cast<ListView*>(this)) * _itemHeight : 0.0f;
+}
+
+void ListView::updateItems()
+{
+    unsigned int itemCount = _dataSource ? _dataSource->getItemCount(this) : 0;
+    if (_itemHeight <= 0.0f || itemCount == 0)
+    {
+        for (size_t i = 0, count = _items.size(); i < count; ++i)
+        {
+            _items[i]->setVisible(false);
+            _itemIndices[i] = -1;
+        }
+        _reload = false;
+        return;
+    }
+
+    // Find the range of items that overlap the viewport.
+    unsigned int first = (unsigned int)std::max(0.0f, floorf(-_scrollPosition.y / _itemHeight));
+    if (first >= itemCount)
+        first = itemCount - 1;
+    unsigned int visibleCount = std::min((unsigned int)ceilf(_viewportBounds.height / _itemHeight) + 1, itemCount - first);
+
+    // Create enough item controls to cover the viewport.
+    while (_items.size() < visibleCount)
+    {
+        Control* item = _dataSource->createItem(this);
+        if (item == NULL)
+        {
+            GP_WARN("List view '%s' failed to create an item control.", _id.c_str());
+            break;
+        }
+        addControl(item);
+        item->release();
+        _items.push_back(item);
+        _itemIndices.push_back(-1);
+    }
+    size_t poolSize = _items.size();
+    if (poolSize == 0)
+        return;
+
+    // Item i is always shown by control i % poolSize, so scrolling by one item only rebinds one control.
+    for (size_t slot = 0; slot < poolSize; ++slot)
+    {
+        unsigned int index = first + (unsigned int)((slot + poolSize - first % poolSize) % poolSize);
+        Control* item = _items[slot];
+        if (index < first + visibleCount)
+        {
+            if (_reload || _itemIndices[slot] != (int)index)
+            {
+                _itemIndices[slot] = (int)index;
+                _dataSource->bindItem(this, item, index);
+            }
+            item->setPosition(0, index * _itemHeight);
+            item->setSize(_viewportBounds.width, _itemHeight);
+            item->setVisible(true);
+        }
+        else
+        {
+            item->setVisible(false);
+            _itemIndices[slot] = -1;
+        }
+    }
+    _reload = false;
+}
+
+void ListView::clearItems()
+{
+    for (size_t i = 0, count = _items.size(); i < count; ++i)
+    {
+        removeControl(_items[i]);
+    }
+    _items.clear();
+    _itemIndices.clear();
+}
+
+}
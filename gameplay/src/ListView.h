@@ -0,0 +1,192 @@
+#ifndef LISTVIEW_H_
+#define LISTVIEW_H_
+
+#include "Container.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a scrolling list of items that are provided by a data source.
+ *
+ * Only the items that fit in the visible area of the list are backed by controls. The
+ * list asks its data source to create just enough item controls to fill its viewport and
+ * reuses them as the list scrolls, binding each one to the item index it now shows. This
+ * keeps the memory and frame time of the list independent of the number of items.
+ *
+ * All items have the same height and fill the width of the list. The list always scrolls
+ * vertically and lays out its items itself.
+ *
+ * @script{ignore}
+ */
+class ListView : public Container
+{
+    friend class Container;
+    friend class ControlFactory;
+
+public:
+
+    /**
+     * Defines the interface that provides the items of a list view.
+     */
+    class DataSource
+    {
+    public:
+
+        virtual ~DataSource() { }
+
+        /**
+         * Returns the number of items in the list.
+         *
+         * @param list The list view requesting the count.
+         *
+         * @return The number of items.
+         */
+        virtual unsigned int getItemCount(ListView* list) = 0;
+
+        /**
+         * Creates a new control that can display any item of the list.
+         *
+         * The list takes ownership of the returned control.
+         *
+         * @param list The list view requesting the control.
+         *
+         * @return The new control.
+         */
+        virtual Control* createItem(ListView* list) = 0;
+
+        /**
+         * Updates an item control to show the item at the specified index.
+         *
+         * @param list The list view the control belongs to.
+         * @param item The item control, created by createItem().
+         * @param index The index of the item to show.
+         */
+        virtual void bindItem(ListView* list, Control* item, unsigned int index) = 0;
+    };
+
+    /**
+     * Creates a new list view.
+     *
+     * @param id The list view ID.
+     * @param style The list view style (optional).
+     *
+     * @return The new list view.
+     */
+    static ListView* create(const char* id, Theme::Style* style = NULL);
+
+    /**
+     * Sets the data source that provides the items of this list.
+     *
+     * Item controls created by a previous data source are removed from the list.
+     *
+     * @param dataSource The data source, which must outlive the list (may be NULL).
+     */
+    void setDataSource(DataSource* dataSource);
+
+    /**
+     * Returns the data source that provides the items of this list.
+     *
+     * @return The data source, or NULL if none is set.
+     */
+    DataSource* getDataSource() const;
+
+    /**
+     * Sets the height of each item.
+     *
+     * @param height The item height, in pixels.
+     */
+    void setItemHeight(float height);
+
+    /**
+     * Returns the height of each item.
+     *
+     * @return The item height, in pixels.
+     */
+    float getItemHeight() const;
+
+    /**
+     * Rebinds all visible items. Call this when the items or the item count of the data source change.
+     */
+    void reloadData();
+
+    /**
+     * Returns the index of the item currently shown by an item control.
+     *
+     * @param item The item control.
+     *
+     * @return The item index, or -1 if the control does not currently show an item.
+     */
+    int getItemIndex(Control* item) const;
+
+    /**
+     * Extends Control::getType() to return this class's type name.
+     *
+     * @return "listView"
+     */
+    const char* getType() const;
+
+protected:
+
+    /**
+     * Constructor.
+     */
+    ListView();
+
+    /**
+     * Destructor.
+     */
+    ~ListView();
+
+    /**
+     * Creates a list view with a given style and properties.
+     *
+     * @param style The style to apply to this list view.
+     * @param properties A properties object containing a definition of the list view (optional).
+     *
+     * @return The new list view.
+     */
+    static Control* create(Theme::Style* style, Properties* properties = NULL);
+
+    /**
+     * @see Control::initialize
+     */
+    void initialize(const char* typeName, Theme::Style* style, Properties* properties);
+
+    /**
+     * @see Control::updateAbsoluteBounds
+     */
+    void updateAbsoluteBounds(const Vector2& offset);
+
+    /**
+     * @see Container::getContentSize
+     */
+    void getContentSize(float* width, float* height) const;
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    ListView(const ListView& copy);
+
+    /**
+     * Creates, binds and positions the item controls for the visible range of items.
+     */
+    void updateItems();
+
+    /**
+     * Removes all item controls from the list.
+     */
+    void clearItems();
+
+    DataSource* _dataSource;
+    float _itemHeight;
+    std::vector<Control*> _items;
+    std::vector<int> _itemIndices;
+    bool _reload;
+};
+
+}
+
+#endif
@@ -2,13 +2,74 @@
 #include "Base.h"
 #include "Game.h"
 #include "ScriptController.h"
+#include "Thread.h"
+
+// The number of records of the ring buffer of asynchronous logging (a power of two).
+#define LOGGER_RECORD_COUNT 512
+
+// The size of the text of a record; longer messages are split over several records.
+#define LOGGER_RECORD_SIZE 248
+
+// The time (in milliseconds) the background thread sleeps between two flushes.
+#define LOGGER_FLUSH_INTERVAL 5
+
+#ifdef _MSC_VER
+#define LOGGER_THREAD_LOCAL __declspec(thread)
+#else
+#define LOGGER_THREAD_LOCAL __thread
+#endif
+
+// The states of the line being logged by a thread at a level.
+#define LOGGER_LINE_NONE 0
+#define LOGGER_LINE_ACCEPTED 1
+#define LOGGER_LINE_DROPPED 2
 
 namespace gameplay
 {
 
+/**
+ * A record of the ring buffer. Its sequence tells whether it is free for the
+ * enqueue position it is written at, or holds a message for the dequeue position
+ * it is read at.
+ */
+struct LogRecord
+{
+    volatile unsigned int sequence;
+    unsigned int level;
+    char text[LOGGER_RECORD_SIZE];
+};
+
+static LogRecord __records[LOGGER_RECORD_COUNT];
+static volatile unsigned int __enqueuePosition = 0;
+static unsigned int __dequeuePosition = 0;
+static volatile unsigned int __droppedCount = 0;
+static unsigned int __reportedDroppedCount = 0;
+static Mutex __drainMutex;
+static Thread* __flushThread = NULL;
+static volatile bool __async = false;
+static volatile bool __flushing = false;
+
+// The state of the line being logged by the current thread at each level.
+static LOGGER_THREAD_LOCAL unsigned char __lineStates[3];
+
+/**
+ * Sets a value to 0 and returns the value it held.
+ */
+static unsigned int exchangeZero(volatile unsigned int* value)
+{
+    unsigned int previous = *value;
+    for (;;)
+    {
+        unsigned int current = Atomic::compareExchange(value, previous, 0);
+        if (current == previous)
+            return previous;
+        previous = current;
+    }
+}
+
 Logger::State Logger::_state[3];
 
-Logger::State::State() : logFunctionC(NULL), logFunctionLua(NULL), enabled(true)
+Logger::State::State() : logFunctionC(NULL), logFunctionLua(NULL), enabled(true), rateLimit(0), rateSecond(0), rateCount(0), rateDropped(0)
 {
 }
 
@@ -26,6 +87,10 @@ void Logger::log(Level level, const char* message, ...)
     if (!state.enabled)
         return;
 
+    // Dropped lines are not even formatted.
+    if (!acceptLine(level, message))
+        return;
+
     va_list args;
     va_start(args, message);
 
@@ -54,23 +119,233 @@ void Logger::log(Level level, const char* message, ...)
         str = &dynamicBuffer[0];
     }
 
+    output(level, str);
+
+    va_end(args);
+}
+
+void Logger::output(Level level, const char* message)
+{
+    State& state = _state[level];
+    if (state.logFunctionLua)
+    {
+        // Pass call to registered Lua log function, on the calling thread
+        flush();
+        Game::getInstance()->getScriptController()->executeFunction<void>(state.logFunctionLua, "[Logger::Level]s", level, message);
+    }
+    else if (__async && level != LEVEL_ERROR)
+    {
+        enqueue(level, message);
+    }
+    else
+    {
+        // Errors usually end the program, so they are printed right away, after the messages before them.
+        flush();
+        print(level, message);
+    }
+}
+
+void Logger::print(Level level, const char* message)
+{
+    State& state = _state[level];
     if (state.logFunctionC)
     {
         // Pass call to registered C log function
-        (*state.logFunctionC)(level, str);
+        (*state.logFunctionC)(level, message);
+    }
+    else
+    {
+        // Log to the default output
+        gameplay::print("%s", message);
+    }
+}
+
+bool Logger::acceptLine(Level level, const char* message)
+{
+    State& state = _state[level];
+    unsigned char& line = __lineStates[level];
+    if (line == LOGGER_LINE_NONE)
+    {
+        bool accepted = true;
+        if (state.rateLimit > 0)
+        {
+            // The first line of each second reports the lines dropped during the last one.
+            unsigned int second = (unsigned int)(Game::getAbsoluteTime() / 1000.0);
+            unsigned int previous = state.rateSecond;
+            if (second != previous && Atomic::compareExchange(&state.rateSecond, previous, second) == previous)
+            {
+                exchangeZero(&state.rateCount);
+                unsigned int dropped = exchangeZero(&state.rateDropped);
+                if (dropped > 0)
+                {
+                    char report[128];
+                    sprintf(report, "[logger] %u lines were dropped by the rate limit of their level.\n", dropped);
+                    output(level, report);
+                }
+            }
+            accepted = Atomic::increment(&state.rateCount) <= state.rateLimit;
+            if (!accepted)
+            {
+                Atomic::increment(&state.rateDropped);
+            }
+        }
+        line = accepted ? LOGGER_LINE_ACCEPTED : LOGGER_LINE_DROPPED;
+    }
+
+    bool accepted = line == LOGGER_LINE_ACCEPTED;
+    size_t length = strlen(message);
+    if (length > 0 && message[length - 1] == '\n')
+    {
+        line = LOGGER_LINE_NONE;
+    }
+    return accepted;
+}
+
+void Logger::enqueue(Level level, const char* message)
+{
+    size_t length = strlen(message);
+    do
+    {
+        // Claim the record at the enqueue position, unless the ring buffer is full.
+        unsigned int position = __enqueuePosition;
+        LogRecord* record;
+        for (;;)
+        {
+            record = &__records[position & (LOGGER_RECORD_COUNT - 1)];
+            int difference = (int)(record->sequence - position);
+            if (difference == 0)
+            {
+                unsigned int previous = Atomic::compareExchange(&__enqueuePosition, position, position + 1);
+                if (previous == position)
+                    break;
+                position = previous;
+            }
+            else if (difference < 0)
+            {
+                Atomic::increment(&__droppedCount);
+                return;
+            }
+            else
+            {
+                position = __enqueuePosition;
+            }
+        }
+
+        size_t count = std::min(length, (size_t)LOGGER_RECORD_SIZE - 1);
+        record->level = level;
+        memcpy(record->text, message, count);
+        record->text[count] = '\0';
+        message += count;
+        length -= count;
+
+        // Publish the record. The increment is a full barrier, so the text is visible before the sequence.
+        Atomic::increment(&record->sequence);
+    }
+    while (length > 0);
+}
+
+void Logger::drain()
+{
+    Mutex::Lock lock(__drainMutex);
+    for (;;)
+    {
+        LogRecord& record = __records[__dequeuePosition & (LOGGER_RECORD_COUNT - 1)];
+        if (Atomic::add(&record.sequence, 0) != __dequeuePosition + 1)
+            break;
+
+        print((Level)record.level, record.text);
+
+        // Free the record for the enqueue position one turn of the ring buffer later.
+        Atomic::add(&record.sequence, LOGGER_RECORD_COUNT - 1);
+        ++__dequeuePosition;
     }
-    else if (state.logFunctionLua)
+
+    unsigned int droppedCount = __droppedCount;
+    if (droppedCount != __reportedDroppedCount)
+    {
+        char report[128];
+        sprintf(report, "[logger] %u messages were dropped because the log buffer was full.\n", droppedCount - __reportedDroppedCount);
+        print(LEVEL_WARN, report);
+        __reportedDroppedCount = droppedCount;
+    }
+}
+
+int Logger::flushThread(void* arg)
+{
+    while (__flushing)
+    {
+        drain();
+        Thread::sleep(LOGGER_FLUSH_INTERVAL);
+    }
+    drain();
+    return 0;
+}
+
+void Logger::setAsync(bool async)
+{
+    if (async == (__flushThread != NULL))
+        return;
+
+    if (async)
     {
-        // Pass call to registered Lua log function
-        Game::getInstance()->getScriptController()->executeFunction<void>(state.logFunctionLua, "[Logger::Level]s", level, str);
+        // Reset the ring buffer while no thread writes to it.
+        for (unsigned int i = 0; i < LOGGER_RECORD_COUNT; ++i)
+        {
+            __records[i].sequence = i;
+        }
+        __enqueuePosition = 0;
+        __dequeuePosition = 0;
+
+        __flushing = true;
+        __flushThread = Thread::create(flushThread, NULL);
+        if (__flushThread == NULL)
+        {
+            __flushing = false;
+            gameplay::print("[logger] Failed to start the thread of asynchronous logging.\n");
+            return;
+        }
+        __async = true;
     }
     else
     {
-        // Log to the default output
-        gameplay::print("%s", str);
+        __async = false;
+        __flushing = false;
+        __flushThread->join();
+        SAFE_DELETE(__flushThread);
     }
+}
 
-    va_end(args);
+bool Logger::isAsync()
+{
+    return __async;
+}
+
+void Logger::flush()
+{
+    if (__async)
+    {
+        drain();
+    }
+}
+
+void Logger::setRateLimit(Level level, unsigned int linesPerSecond)
+{
+    _state[level].rateLimit = linesPerSecond;
+}
+
+unsigned int Logger::getRateLimit(Level level)
+{
+    return _state[level].rateLimit;
+}
+
+unsigned int Logger::getDroppedCount()
+{
+    return __droppedCount;
+}
+
+void Logger::finalize()
+{
+    setAsync(false);
 }
 
 bool Logger::isEnabled(Level level)
@@ -13,9 +13,22 @@ namespace gameplay
  * can be modified for a specific log level by passing a custom C or Lua logging
  * function to the Logger::set method. Logging can also be toggled using the
  * setEnabled method.
+ *
+ * Logging can be made asynchronous with setAsync, so that logging a message no
+ * longer waits for it to be printed. Messages are still formatted by the calling
+ * thread, into a lock-free ring buffer of records, and a background thread prints
+ * them and passes them to the C logging functions. Levels handled by a Lua function
+ * and errors, which usually end the program, are still logged synchronously, after
+ * the pending records are flushed. Records logged while the ring buffer is full
+ * are dropped and counted.
+ *
+ * Each level can also be rate limited with setRateLimit, which drops the lines
+ * logged at that level beyond a number per second and reports how many were dropped.
  */
 class Logger
 {
+    friend class Game;
+
 public:
 
     /** 
@@ -85,6 +98,63 @@ public:
      */
     static void set(Level level, const char* logFunction);
 
+    /**
+     * Sets whether messages are printed by a background thread.
+     *
+     * When logging is asynchronous, the C logging functions are called from the background thread.
+     *
+     * This can also be set by the 'async' property in the 'logger' section of the game configuration file.
+     *
+     * @param async true to print messages from a background thread, false to print them when they are logged.
+     * @script{ignore}
+     */
+    static void setAsync(bool async);
+
+    /**
+     * Determines if messages are printed by a background thread.
+     *
+     * @return true if logging is asynchronous.
+     */
+    static bool isAsync();
+
+    /**
+     * Prints the messages that are waiting for the background thread.
+     *
+     * This does nothing when logging is synchronous.
+     */
+    static void flush();
+
+    /**
+     * Sets the maximum number of lines logged per second at a level.
+     *
+     * A line is made of all the messages logged by a thread up to a message ending with
+     * a new line, so the three messages logged by GP_WARN count as a single line.
+     * The number of lines dropped in each second is reported once the second is over.
+     *
+     * This can also be set by the 'infoRateLimit', 'warnRateLimit' and 'errorRateLimit'
+     * properties in the 'logger' section of the game configuration file.
+     *
+     * @param level Log level.
+     * @param linesPerSecond The maximum number of lines per second, or 0 for no limit (the default).
+     */
+    static void setRateLimit(Level level, unsigned int linesPerSecond);
+
+    /**
+     * Returns the maximum number of lines logged per second at a level.
+     *
+     * @param level Log level.
+     *
+     * @return The maximum number of lines per second, or 0 if there is no limit.
+     */
+    static unsigned int getRateLimit(Level level);
+
+    /**
+     * Returns the number of records dropped because the ring buffer of asynchronous logging was full.
+     *
+     * @return The number of dropped records.
+     */
+    static unsigned int getDroppedCount();
+
 private:
 
     struct State
@@ -93,6 +163,10 @@ private:
         void (*logFunctionC) (Level, const char*);
         const char* logFunctionLua;
         bool enabled;
+        unsigned int rateLimit;
+        volatile unsigned int rateSecond;
+        volatile unsigned int rateCount;
+        volatile unsigned int rateDropped;
     };
 
     /**
@@ -115,6 +189,41 @@ private:
      */
     Logger& operator=(const Logger&);
 
+    /**
+     * Passes a message to the Lua logging function of its level, the background thread or print().
+     */
+    static void output(Level level, const char* message);
+
+    /**
+     * Prints a message with the C logging function of its level, or the default output.
+     */
+    static void print(Level level, const char* message);
+
+    /**
+     * Determines if the current line of the calling thread is within the rate limit of a level.
+     */
+    static bool acceptLine(Level level, const char* message);
+
+    /**
+     * Queues a message for the background thread, splitting it over several records if needed.
+     */
+    static void enqueue(Level level, const char* message);
+
+    /**
+     * Prints the queued records. Only one thread drains the records at a time.
+     */
+    static void drain();
+
+    /**
+     * The entry point of the background thread.
+     */
+    static int flushThread(void* arg);
+
+    /**
+     * Stops the background thread and prints the remaining records.
+     */
+    static void finalize();
+
     static State _state[3];
 
 };
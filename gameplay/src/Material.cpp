@@ -6,17 +6,43 @@
 #include "Pass.h"
 #include "Properties.h"
 #include "Node.h"
+#include "FramePacer.h"
+
+// The frame rate that adaptive quality aims for when the frame rate is not paced.
+#define MATERIAL_QUALITY_FRAME_RATE 60
+// The number of frames in a row over the frame time that lower the quality level.
+#define MATERIAL_QUALITY_DROP_FRAMES 30
+// The number of frames in a row under MATERIAL_QUALITY_RAISE_LOAD of the frame time that raise it again.
+#define MATERIAL_QUALITY_RAISE_FRAMES 300
+#define MATERIAL_QUALITY_RAISE_LOAD 0.6f
 
 namespace gameplay
 {
 
+static std::vector<Material*> __qualityTieredMaterials;
+static unsigned int __qualityLevel = UINT_MAX;
+static unsigned int __qualityLevelSet = UINT_MAX;
+static unsigned int __highestQualityTier = 0;
+static bool __adaptiveQuality = false;
+static unsigned int __slowFrames = 0;
+static unsigned int __fastFrames = 0;
+
 Material::Material() :
-    _currentTechnique(NULL)
+    _currentTechnique(NULL), _qualityTiered(false), _depthPrePass(true)
 {
 }
 
 Material::~Material()
 {
+    if (_qualityTiered)
+    {
+        std::vector<Material*>::iterator itr = std::find(__qualityTieredMaterials.begin(), __qualityTieredMaterials.end(), this);
+        if (itr != __qualityTieredMaterials.end())
+        {
+            __qualityTieredMaterials.erase(itr);
+        }
+    }
+
     // Destroy all the techniques.
     for (size_t i = 0, count = _techniques.size(); i < count; ++i)
     {
@@ -65,6 +91,10 @@ Material* Material::create(Properties* materialProperties, PassCallback callback
 
     // Load uniform value parameters for this material.
     loadRenderState(material, materialProperties);
+    if (materialProperties->exists("depthPrePass"))
+    {
+        material->_depthPrePass = materialProperties->getBool("depthPrePass");
+    }
 
     // Go through all the material properties and create techniques under this material.
     Properties* techniqueProperties = NULL;
@@ -90,6 +120,12 @@ Material* Material::create(Properties* materialProperties, PassCallback callback
             material->_currentTechnique = t;
         }
     }
+
+    // Let the quality level select the technique if the techniques declared their quality tiers.
+    if (material->_qualityTiered)
+    {
+        material->registerQualityTiers();
+    }
     return material;
 }
 
@@ -206,9 +242,138 @@ Material* Material::clone(NodeCloneContext &context) const
             material->_currentTechnique = techniqueClone;
         }
     }
+
+    if (_qualityTiered)
+    {
+        material->_qualityTiered = true;
+        __qualityTieredMaterials.push_back(material);
+    }
+    material->_depthPrePass = _depthPrePass;
     return material;
 }
 
+void Material::registerQualityTiers()
+{
+    GP_ASSERT(_qualityTiered);
+
+    for (size_t i = 0, count = _techniques.size(); i < count; ++i)
+    {
+        __highestQualityTier = std::max(__highestQualityTier, _techniques[i]->_quality);
+    }
+    __qualityTieredMaterials.push_back(this);
+    selectTechnique();
+}
+
+void Material::selectTechnique()
+{
+    // Use the most expensive technique within the quality level, or the cheapest one if none is.
+    Technique* selected = NULL;
+    Technique* cheapest = NULL;
+    for (size_t i = 0, count = _techniques.size(); i < count; ++i)
+    {
+        Technique* t = _techniques[i];
+        if (cheapest == NULL || t->_quality < cheapest->_quality)
+        {
+            cheapest = t;
+        }
+        if (t->_quality <= __qualityLevel && (selected == NULL || t->_quality > selected->_quality))
+        {
+            selected = t;
+        }
+    }
+    if (selected || cheapest)
+    {
+        _currentTechnique = selected ? selected : cheapest;
+    }
+}
+
+void Material::setQualityLevel(unsigned int level)
+{
+    __qualityLevelSet = level;
+    __slowFrames = 0;
+    __fastFrames = 0;
+    applyQualityLevel(level);
+}
+
+unsigned int Material::getQualityLevel()
+{
+    return __qualityLevel;
+}
+
+void Material::setAdaptiveQuality(bool adaptive)
+{
+    __adaptiveQuality = adaptive;
+    if (!adaptive)
+    {
+        // Return to the quality level that was set.
+        applyQualityLevel(__qualityLevelSet);
+    }
+}
+
+bool Material::isAdaptiveQuality()
+{
+    return __adaptiveQuality;
+}
+
+void Material::setDepthPrePass(bool enabled)
+{
+    _depthPrePass = enabled;
+}
+
+bool Material::isDepthPrePass() const
+{
+    return _depthPrePass;
+}
+
+void Material::applyQualityLevel(unsigned int level)
+{
+    if (level == __qualityLevel)
+        return;
+
+    __qualityLevel = level;
+    for (size_t i = 0, count = __qualityTieredMaterials.size(); i < count; ++i)
+    {
+        __qualityTieredMaterials[i]->selectTechnique();
+    }
+}
+
+void Material::updateQuality()
+{
+    if (!__adaptiveQuality || __qualityTieredMaterials.empty())
+        return;
+
+    unsigned int rate = FramePacer::getTargetFrameRate();
+    float frameTime = 1000.0f / (rate > 0 ? rate : MATERIAL_QUALITY_FRAME_RATE);
+    float work = std::max(FramePacer::getCpuTime(), FramePacer::getGpuTime());
+
+    // Only the levels up to the highest tier of any material select different techniques.
+    unsigned int level = std::min(__qualityLevel, __highestQualityTier);
+    unsigned int highest = std::min(__qualityLevelSet, __highestQualityTier);
+    if (work > frameTime)
+    {
+        __fastFrames = 0;
+        if (++__slowFrames >= MATERIAL_QUALITY_DROP_FRAMES && level > 0)
+        {
+            __slowFrames = 0;
+            applyQualityLevel(level - 1);
+        }
+    }
+    else if (work < MATERIAL_QUALITY_RAISE_LOAD * frameTime)
+    {
+        __slowFrames = 0;
+        if (++__fastFrames >= MATERIAL_QUALITY_RAISE_FRAMES && level < highest)
+        {
+            __fastFrames = 0;
+            applyQualityLevel(level + 1);
+        }
+    }
+    else
+    {
+        __slowFrames = 0;
+        __fastFrames = 0;
+    }
+}
+
 bool Material::loadTechnique(Material* material, Properties* techniqueProperties, PassCallback callback, void* cookie)
 {
     GP_ASSERT(material);
@@ -216,6 +381,11 @@ bool Material::loadTechnique(Material* material, Properties* techniqueProperties
 
     // Create a new technique.
     Technique* technique = new Technique(techniqueProperties->getId(), material);
+    if (techniqueProperties->exists("quality"))
+    {
+        technique->_quality = (unsigned int)std::max(techniqueProperties->getInt("quality"), 0);
+        material->_qualityTiered = true;
+    }
 
     // Load uniform value parameters for this technique.
     loadRenderState(technique, techniqueProperties);
@@ -292,12 +462,14 @@ static bool isMaterialKeyword(const char* str)
 {
     GP_ASSERT(str);
 
-    #define MATERIAL_KEYWORD_COUNT 3
+    #define MATERIAL_KEYWORD_COUNT 5
     static const char* reservedKeywords[MATERIAL_KEYWORD_COUNT] =
     {
         "vertexShader",
         "fragmentShader",
-        "defines"
+        "defines",
+        "quality",
+        "depthPrePass"
     };
     for (unsigned int i = 0; i < MATERIAL_KEYWORD_COUNT; ++i)
     {
@@ -18,15 +18,46 @@ class NodeCloneContext;
  * material files (.material). When multiple techniques are loaded using a material file,
  * the current technique for an object can be set at runtime.
  *
+ * The techniques of a material file can instead be selected by the global quality level,
+ * when they declare their cost with a quality tier:
+ * @code
+   material ground
+   {
+       technique simple
+       {
+           quality = 0
+           ...
+       }
+       technique parallax
+       {
+           quality = 2
+           ...
+       }
+   }
+ * @endcode
+ * Each such material uses its most expensive technique whose tier does not exceed the
+ * quality level, or its cheapest technique if every tier exceeds it. The quality level
+ * can be set in the "graphics" section of game.config, and lowered automatically while
+ * the frames take longer than the target frame time (see FramePacer):
+ * @code
+   graphics
+   {
+       quality = 2
+       adaptiveQuality = true
+   }
+ * @endcode
+ *
  * @see http://blackberry.github.io/GamePlay/docs/file-formats.html#wiki-Materials
  */
 class Material : public RenderState
 {
+    friend class Game;
     friend class Technique;
     friend class Pass;
     friend class RenderState;
     friend class Node;
     friend class Model;
+    friend class StaticGeometry;
 
 public:
 
@@ -139,10 +170,70 @@ public:
     /**
      * Sets the current material technique. 
      *
+     * For a material whose techniques have quality tiers, this overrides the technique
+     * selected by the quality level until the quality level changes.
+     *
      * @param id ID of the technique to set.
      */
     void setTechnique(const char* id);
 
+    /**
+     * Sets the quality level that selects the techniques of the materials with quality tiers.
+     *
+     * The level is the most expensive tier to use. By default it is unlimited, so these
+     * materials use their most expensive techniques. With adaptive quality, the level is
+     * lowered from this level and raised back up to it as the frame time changes.
+     *
+     * @param level The quality level.
+     *
+     * @see Technique::getQuality
+     */
+    static void setQualityLevel(unsigned int level);
+
+    /**
+     * Gets the quality level that currently selects the techniques of the materials with quality tiers.
+     *
+     * @return The quality level, which adaptive quality may have lowered from the level that was set.
+     */
+    static unsigned int getQualityLevel();
+
+    /**
+     * Sets whether the quality level is lowered while the frames take longer than the target
+     * frame time, and raised again once they fit in it with room to spare.
+     *
+     * @param adaptive true to adapt the quality level to the frame time.
+     */
+    static void setAdaptiveQuality(bool adaptive);
+
+    /**
+     * Determines whether the quality level adapts to the frame time.
+     *
+     * @return true if the quality level is adaptive.
+     */
+    static bool isAdaptiveQuality();
+
+    /**
+     * Sets whether the opaque passes of this material are drawn in the depth pre-pass of
+     * the render queues that use one.
+     *
+     * This is enabled by default, and can be set in the material file with
+     * depthPrePass = false. It should be disabled for materials whose fragment shaders
+     * discard fragments (such as alpha tested foliage) or change their depth, since the
+     * depth pre-pass only draws their vertex shaders.
+     *
+     * @param enabled true to draw the material in the depth pre-pass.
+     *
+     * @see RenderQueue::setDepthPrePass
+     */
+    void setDepthPrePass(bool enabled);
+
+    /**
+     * Determines whether the opaque passes of this material are drawn in the depth pre-pass.
+     *
+     * @return true if the material is drawn in the depth pre-pass.
+     */
+    bool isDepthPrePass() const;
+
     /**
      * @see RenderState::setNodeBinding
      */
@@ -195,8 +286,30 @@ private:
      */
     static void loadRenderState(RenderState* renderState, Properties* properties);
 
+    /**
+     * Registers a material whose techniques have quality tiers, and selects its technique.
+     */
+    void registerQualityTiers();
+
+    /**
+     * Selects the technique of this material for the current quality level.
+     */
+    void selectTechnique();
+
+    /**
+     * Changes the quality level and selects the techniques of the materials with quality tiers.
+     */
+    static void applyQualityLevel(unsigned int level);
+
+    /**
+     * Adapts the quality level to the time of the last frame. Called by Game::frame.
+     */
+    static void updateQuality();
+
     Technique* _currentTechnique;
     std::vector<Technique*> _techniques;
+    bool _qualityTiered;
+    bool _depthPrePass;
 };
 
 }
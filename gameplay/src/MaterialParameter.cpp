@@ -454,19 +454,38 @@ void MaterialParameter::bind(Effect* effect)
     // we need to update our uniform to point to the new effect's uniform.
     if (!_uniform || _uniform->getEffect() != effect)
     {
-        _uniform = effect->getUniform(_name.c_str());
-
+        _uniform = findUniform(effect);
         if (!_uniform)
-        {
-            if ((_loggerDirtyBits & UNIFORM_NOT_FOUND) == 0)
-            {
-                // This parameter was not found in the specified effect, so do nothing.
-                GP_WARN("Material parameter for uniform '%s' not found in effect: '%s'.", _name.c_str(), effect->getId());
-                _loggerDirtyBits |= UNIFORM_NOT_FOUND;
-            }
             return;
+    }
+
+    applyValue(effect);
+}
+
+Uniform* MaterialParameter::findUniform(Effect* effect)
+{
+    GP_ASSERT(effect);
+
+    Uniform* uniform = effect->getUniform(_name.c_str());
+    if (!uniform)
+    {
+        // Auto-bound camera parameters may be read from the frame uniform buffer instead.
+        if (_type == MaterialParameter::METHOD && _value.method && _value.method->_autoBinding && effect->hasFrameUniforms())
+            return NULL;
+
+        if ((_loggerDirtyBits & UNIFORM_NOT_FOUND) == 0)
+        {
+            // This parameter was not found in the specified effect, so do nothing.
+            GP_WARN("Material parameter for uniform '%s' not found in effect: '%s'.", _name.c_str(), effect->getId());
+            _loggerDirtyBits |= UNIFORM_NOT_FOUND;
         }
     }
+    return uniform;
+}
+
+void MaterialParameter::applyValue(Effect* effect)
+{
+    GP_ASSERT(_uniform && _uniform->getEffect() == effect);
 
     switch (_type)
     {
@@ -37,6 +37,7 @@ namespace gameplay
 class MaterialParameter : public AnimationTarget, public Ref
 {
     friend class RenderState;
+    friend class Pass;
 
 public:
 
@@ -368,6 +369,7 @@ private:
      */
     class MethodBinding : public Ref
     {
+        friend class MaterialParameter;
         friend class RenderState;
 
     public:
@@ -432,6 +434,16 @@ private:
 
     void bind(Effect* effect);
 
+    /**
+     * Returns the uniform of the effect set by this parameter, warning once if the effect has none.
+     */
+    Uniform* findUniform(Effect* effect);
+
+    /**
+     * Sets the value of this parameter to its cached uniform, which must belong to the effect.
+     */
+    void applyValue(Effect* effect);
+
     void applyAnimationValue(AnimationValue* value, float blendWeight, int components);
 
     void cloneInto(MaterialParameter* materialParameter) const;
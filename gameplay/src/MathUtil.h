@@ -12,6 +12,9 @@ class MathUtil
 {
     friend class Matrix;
     friend class Vector3;
+    friend class ParticleEmitter;
+    friend class MeshSkin;
+    friend class AnimationController;
 
 public:
 
@@ -66,6 +69,41 @@ private:
 
     inline static void crossVector3(const float* v1, const float* v2, float* dst);
 
+    /**
+     * Transforms an array of count 3-component vectors (3 floats each) by the matrix m,
+     * using w as the fourth coordinate of every vector.
+     *
+     * v and dst may be the same array.
+     */
+    inline static void transformVector3Array(const float* m, const float* v, float w, float* dst, unsigned int count);
+
+    /**
+     * Transforms an array of count 4-component vectors (4 floats each) by the matrix m.
+     *
+     * v and dst may be the same array.
+     */
+    inline static void transformVector4Array(const float* m, const float* v, float* dst, unsigned int count);
+
+    /**
+     * Multiplies count pairs of matrices from the arrays m1 and m2 (16 floats each) and stores
+     * the first three rows of each product in dst (12 floats each, row by row).
+     */
+    inline static void multiplyMatrix4x3Array(const float* m1, const float* m2, float* dst, unsigned int count);
+
+    /**
+     * Computes dst[i] += src[i] * scalar over an array of floats.
+     *
+     * The arrays must be 16-byte aligned and count must be a multiple of 4.
+     */
+    inline static void addScaledArray(const float* src, float scalar, float* dst, unsigned int count);
+
+    /**
+     * Computes dst[i] = start[i] + (end[i] - start[i]) * t[i] over an array of floats.
+     *
+     * The arrays must be 16-byte aligned and count must be a multiple of 4.
+     */
+    inline static void lerpArray(const float* start, const float* end, const float* t, float* dst, unsigned int count);
+
     MathUtil();
 };
 
@@ -73,8 +111,10 @@ private:
 
 #define MATRIX_SIZE ( sizeof(float) * 16)
 
-#ifdef USE_NEON
+#if defined(USE_NEON)
 #include "MathUtilNeon.inl"
+#elif defined(USE_SSE)
+#include "MathUtilSSE.inl"
 #else
 #include "MathUtil.inl"
 #endif
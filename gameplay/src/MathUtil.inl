@@ -172,6 +172,67 @@ inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
     dst[2] = z;
 }
 
+inline void MathUtil::transformVector3Array(const float* m, const float* v, float w, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, v += 3, dst += 3)
+    {
+        // Handle case where v == dst.
+        float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + w * m[12];
+        float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + w * m[13];
+        float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + w * m[14];
+
+        dst[0] = x;
+        dst[1] = y;
+        dst[2] = z;
+    }
 }
 
+inline void MathUtil::transformVector4Array(const float* m, const float* v, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, v += 4, dst += 4)
+    {
+        transformVector4(m, v, dst);
+    }
+}
 
+inline void MathUtil::multiplyMatrix4x3Array(const float* m1, const float* m2, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, m1 += 16, m2 += 16, dst += 12)
+    {
+        for (unsigned int r = 0; r < 3; ++r)
+        {
+            dst[r * 4]     = m1[r] * m2[0]  + m1[r + 4] * m2[1]  + m1[r + 8] * m2[2]  + m1[r + 12] * m2[3];
+            dst[r * 4 + 1] = m1[r] * m2[4]  + m1[r + 4] * m2[5]  + m1[r + 8] * m2[6]  + m1[r + 12] * m2[7];
+            dst[r * 4 + 2] = m1[r] * m2[8]  + m1[r + 4] * m2[9]  + m1[r + 8] * m2[10] + m1[r + 12] * m2[11];
+            dst[r * 4 + 3] = m1[r] * m2[12] + m1[r + 4] * m2[13] + m1[r + 8] * m2[14] + m1[r + 12] * m2[15];
+        }
+    }
+}
+
+inline void MathUtil::addScaledArray(const float* src, float scalar, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        dst[i]     += src[i]     * scalar;
+        dst[i + 1] += src[i + 1] * scalar;
+        dst[i + 2] += src[i + 2] * scalar;
+        dst[i + 3] += src[i + 3] * scalar;
+    }
+}
+
+inline void MathUtil::lerpArray(const float* start, const float* end, const float* t, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        dst[i]     = start[i]     + (end[i]     - start[i])     * t[i];
+        dst[i + 1] = start[i + 1] + (end[i + 1] - start[i + 1]) * t[i + 1];
+        dst[i + 2] = start[i + 2] + (end[i + 2] - start[i + 2]) * t[i + 2];
+        dst[i + 3] = start[i + 3] + (end[i + 3] - start[i + 3]) * t[i + 3];
+    }
+}
+
+}
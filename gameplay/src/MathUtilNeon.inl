@@ -226,4 +226,74 @@ inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
     );
 }
 
+inline void MathUtil::transformVector3Array(const float* m, const float* v, float w, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, v += 3, dst += 3)
+    {
+        transformVector4(m, v[0], v[1], v[2], w, dst);
+    }
+}
+
+inline void MathUtil::transformVector4Array(const float* m, const float* v, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, v += 4, dst += 4)
+    {
+        transformVector4(m, v, dst);
+    }
+}
+
+inline void MathUtil::multiplyMatrix4x3Array(const float* m1, const float* m2, float* dst, unsigned int count)
+{
+    float product[16];
+    for (unsigned int i = 0; i < count; ++i, m1 += 16, m2 += 16, dst += 12)
+    {
+        multiplyMatrix(m1, m2, product);
+        transposeMatrix(product, product);
+        memcpy(dst, product, sizeof(float) * 12);
+    }
+}
+
+inline void MathUtil::addScaledArray(const float* src, float scalar, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+    if (count == 0)
+        return;
+
+    asm volatile(
+        "vld1.32 {d0[], d1[]}, [%3]   \n\t" // q0 = (s, s, s, s)
+        "1:                          \n\t"
+        "vld1.32 {q1}, [%0]!         \n\t" // SRC[i..i+3]
+        "vld1.32 {q2}, [%1]          \n\t" // DST[i..i+3]
+        "vmla.f32 q2, q1, q0         \n\t" // DST[i..i+3] += SRC[i..i+3] * s
+        "vst1.32 {q2}, [%1]!         \n\t" // DST[i..i+3]
+        "subs %2, %2, #4             \n\t" // count -= 4
+        "bgt 1b                      \n\t"
+        : "+r"(src), "+r"(dst), "+r"(count)
+        : "r"(&scalar)
+        : "q0", "q1", "q2", "memory", "cc"
+    );
+}
+
+inline void MathUtil::lerpArray(const float* start, const float* end, const float* t, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+    if (count == 0)
+        return;
+
+    asm volatile(
+        "1:                          \n\t"
+        "vld1.32 {q0}, [%0]!         \n\t" // START[i..i+3]
+        "vld1.32 {q1}, [%1]!         \n\t" // END[i..i+3]
+        "vld1.32 {q2}, [%2]!         \n\t" // T[i..i+3]
+        "vsub.f32 q1, q1, q0         \n\t" // END - START
+        "vmla.f32 q0, q1, q2         \n\t" // START + (END - START) * T
+        "vst1.32 {q0}, [%3]!         \n\t" // DST[i..i+3]
+        "subs %4, %4, #4             \n\t" // count -= 4
+        "bgt 1b                      \n\t"
+        : "+r"(start), "+r"(end), "+r"(t), "+r"(dst), "+r"(count)
+        :
+        : "q0", "q1", "q2", "memory", "cc"
+    );
+}
+
 }
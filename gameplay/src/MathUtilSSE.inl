@@ -0,0 +1,211 @@
+namespace gameplay
+{
+
+inline void MathUtil::addMatrix(const float* m, float scalar, float* dst)
+{
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(dst,      _mm_add_ps(_mm_loadu_ps(m),      s));
+    _mm_storeu_ps(dst + 4,  _mm_add_ps(_mm_loadu_ps(m + 4),  s));
+    _mm_storeu_ps(dst + 8,  _mm_add_ps(_mm_loadu_ps(m + 8),  s));
+    _mm_storeu_ps(dst + 12, _mm_add_ps(_mm_loadu_ps(m + 12), s));
+}
+
+inline void MathUtil::addMatrix(const float* m1, const float* m2, float* dst)
+{
+    _mm_storeu_ps(dst,      _mm_add_ps(_mm_loadu_ps(m1),      _mm_loadu_ps(m2)));
+    _mm_storeu_ps(dst + 4,  _mm_add_ps(_mm_loadu_ps(m1 + 4),  _mm_loadu_ps(m2 + 4)));
+    _mm_storeu_ps(dst + 8,  _mm_add_ps(_mm_loadu_ps(m1 + 8),  _mm_loadu_ps(m2 + 8)));
+    _mm_storeu_ps(dst + 12, _mm_add_ps(_mm_loadu_ps(m1 + 12), _mm_loadu_ps(m2 + 12)));
+}
+
+inline void MathUtil::subtractMatrix(const float* m1, const float* m2, float* dst)
+{
+    _mm_storeu_ps(dst,      _mm_sub_ps(_mm_loadu_ps(m1),      _mm_loadu_ps(m2)));
+    _mm_storeu_ps(dst + 4,  _mm_sub_ps(_mm_loadu_ps(m1 + 4),  _mm_loadu_ps(m2 + 4)));
+    _mm_storeu_ps(dst + 8,  _mm_sub_ps(_mm_loadu_ps(m1 + 8),  _mm_loadu_ps(m2 + 8)));
+    _mm_storeu_ps(dst + 12, _mm_sub_ps(_mm_loadu_ps(m1 + 12), _mm_loadu_ps(m2 + 12)));
+}
+
+inline void MathUtil::multiplyMatrix(const float* m, float scalar, float* dst)
+{
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(dst,      _mm_mul_ps(_mm_loadu_ps(m),      s));
+    _mm_storeu_ps(dst + 4,  _mm_mul_ps(_mm_loadu_ps(m + 4),  s));
+    _mm_storeu_ps(dst + 8,  _mm_mul_ps(_mm_loadu_ps(m + 8),  s));
+    _mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_loadu_ps(m + 12), s));
+}
+
+inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* dst)
+{
+    __m128 c0 = _mm_loadu_ps(m1);
+    __m128 c1 = _mm_loadu_ps(m1 + 4);
+    __m128 c2 = _mm_loadu_ps(m1 + 8);
+    __m128 c3 = _mm_loadu_ps(m1 + 12);
+
+    // Each column of the product is the columns of m1 weighted by a column of m2.
+    // Compute all four before storing to support the case where m1 or m2 is the same array as dst.
+    __m128 product[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const float* column = m2 + i * 4;
+        product[i] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(column[0])), _mm_mul_ps(c1, _mm_set1_ps(column[1]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(column[2])), _mm_mul_ps(c3, _mm_set1_ps(column[3]))));
+    }
+
+    _mm_storeu_ps(dst,      product[0]);
+    _mm_storeu_ps(dst + 4,  product[1]);
+    _mm_storeu_ps(dst + 8,  product[2]);
+    _mm_storeu_ps(dst + 12, product[3]);
+}
+
+inline void MathUtil::negateMatrix(const float* m, float* dst)
+{
+    __m128 zero = _mm_setzero_ps();
+    _mm_storeu_ps(dst,      _mm_sub_ps(zero, _mm_loadu_ps(m)));
+    _mm_storeu_ps(dst + 4,  _mm_sub_ps(zero, _mm_loadu_ps(m + 4)));
+    _mm_storeu_ps(dst + 8,  _mm_sub_ps(zero, _mm_loadu_ps(m + 8)));
+    _mm_storeu_ps(dst + 12, _mm_sub_ps(zero, _mm_loadu_ps(m + 12)));
+}
+
+inline void MathUtil::transposeMatrix(const float* m, float* dst)
+{
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    _mm_storeu_ps(dst,      c0);
+    _mm_storeu_ps(dst + 4,  c1);
+    _mm_storeu_ps(dst + 8,  c2);
+    _mm_storeu_ps(dst + 12, c3);
+}
+
+inline void MathUtil::transformVector4(const float* m, float x, float y, float z, float w, float* dst)
+{
+    __m128 v = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m),     _mm_set1_ps(x)), _mm_mul_ps(_mm_loadu_ps(m + 4),  _mm_set1_ps(y))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(z)), _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(w))));
+
+    // Only store x, y and z since dst may be a Vector3.
+    _mm_storel_pi((__m64*)dst, v);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+}
+
+inline void MathUtil::transformVector4(const float* m, const float* v, float* dst)
+{
+    // All of v is read before dst is written, which handles the case where v == dst.
+    __m128 r = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m),     _mm_set1_ps(v[0])), _mm_mul_ps(_mm_loadu_ps(m + 4),  _mm_set1_ps(v[1]))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])), _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3]))));
+
+    _mm_storeu_ps(dst, r);
+}
+
+inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
+{
+    // Load three floats at a time so nothing is read past the end of a Vector3.
+    __m128 a = _mm_setr_ps(v1[0], v1[1], v1[2], 0.0f);
+    __m128 b = _mm_setr_ps(v2[0], v2[1], v2[2], 0.0f);
+
+    // (a.yzx * b.zxy) - (a.zxy * b.yzx)
+    __m128 r = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))));
+
+    _mm_storel_pi((__m64*)dst, r);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(r, r));
+}
+
+inline void MathUtil::transformVector3Array(const float* m, const float* v, float w, float* dst, unsigned int count)
+{
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(w));
+
+    for (unsigned int i = 0; i < count; ++i, v += 3, dst += 3)
+    {
+        __m128 r = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v[0])), _mm_mul_ps(c1, _mm_set1_ps(v[1]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(v[2])), c3));
+
+        _mm_storel_pi((__m64*)dst, r);
+        _mm_store_ss(dst + 2, _mm_movehl_ps(r, r));
+    }
+}
+
+inline void MathUtil::transformVector4Array(const float* m, const float* v, float* dst, unsigned int count)
+{
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+
+    for (unsigned int i = 0; i < count; ++i, v += 4, dst += 4)
+    {
+        __m128 r = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v[0])), _mm_mul_ps(c1, _mm_set1_ps(v[1]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(v[2])), _mm_mul_ps(c3, _mm_set1_ps(v[3]))));
+
+        _mm_storeu_ps(dst, r);
+    }
+}
+
+inline void MathUtil::multiplyMatrix4x3Array(const float* m1, const float* m2, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i, m1 += 16, m2 += 16, dst += 12)
+    {
+        __m128 c0 = _mm_loadu_ps(m1);
+        __m128 c1 = _mm_loadu_ps(m1 + 4);
+        __m128 c2 = _mm_loadu_ps(m1 + 8);
+        __m128 c3 = _mm_loadu_ps(m1 + 12);
+
+        __m128 p0 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(m2[0])),  _mm_mul_ps(c1, _mm_set1_ps(m2[1]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(m2[2])),  _mm_mul_ps(c3, _mm_set1_ps(m2[3]))));
+        __m128 p1 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(m2[4])),  _mm_mul_ps(c1, _mm_set1_ps(m2[5]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(m2[6])),  _mm_mul_ps(c3, _mm_set1_ps(m2[7]))));
+        __m128 p2 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(m2[8])),  _mm_mul_ps(c1, _mm_set1_ps(m2[9]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(m2[10])), _mm_mul_ps(c3, _mm_set1_ps(m2[11]))));
+        __m128 p3 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(m2[12])), _mm_mul_ps(c1, _mm_set1_ps(m2[13]))),
+            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(m2[14])), _mm_mul_ps(c3, _mm_set1_ps(m2[15]))));
+
+        // The product is column-major, so transpose it to get its rows.
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+        _mm_storeu_ps(dst,     p0);
+        _mm_storeu_ps(dst + 4, p1);
+        _mm_storeu_ps(dst + 8, p2);
+    }
+}
+
+inline void MathUtil::addScaledArray(const float* src, float scalar, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+
+    __m128 s = _mm_set1_ps(scalar);
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        _mm_store_ps(dst + i, _mm_add_ps(_mm_load_ps(dst + i), _mm_mul_ps(_mm_load_ps(src + i), s)));
+    }
+}
+
+inline void MathUtil::lerpArray(const float* start, const float* end, const float* t, float* dst, unsigned int count)
+{
+    GP_ASSERT((count & 3) == 0);
+
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        __m128 a = _mm_load_ps(start + i);
+        __m128 b = _mm_load_ps(end + i);
+        _mm_store_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_load_ps(t + i))));
+    }
+}
+
+}
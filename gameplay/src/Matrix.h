@@ -798,6 +798,42 @@ public:
      */
     void transformVector(const Vector4& vector, Vector4* dst) const;
 
+    /**
+     * Transforms an array of points by this matrix, and stores
+     * the results in dst.
+     *
+     * This is faster than transforming each point separately.
+     *
+     * @param points The points to transform.
+     * @param count The number of points.
+     * @param dst An array of count vectors to store the transformed points in (may be the same array as points).
+     */
+    void transformPoints(const Vector3* points, unsigned int count, Vector3* dst) const;
+
+    /**
+     * Transforms an array of vectors by this matrix by treating the
+     * fourth (w) coordinate as zero, and stores the results in dst.
+     *
+     * This is faster than transforming each vector separately.
+     *
+     * @param vectors The vectors to transform.
+     * @param count The number of vectors.
+     * @param dst An array of count vectors to store the transformed vectors in (may be the same array as vectors).
+     */
+    void transformVectors(const Vector3* vectors, unsigned int count, Vector3* dst) const;
+
+    /**
+     * Transforms an array of vectors by this matrix, and stores
+     * the results in dst.
+     *
+     * This is faster than transforming each vector separately.
+     *
+     * @param vectors The vectors to transform.
+     * @param count The number of vectors.
+     * @param dst An array of count vectors to store the transformed vectors in (may be the same array as vectors).
+     */
+    void transformVectors(const Vector4* vectors, unsigned int count, Vector4* dst) const;
+
     /**
      * Post-multiplies this matrix by the matrix corresponding to the
      * specified translation.
@@ -0,0 +1,233 @@
+#include "Base.h"
+#include "MemoryPool.h"
+
+// The size of the chunks the blocks of the size classes are carved from.
+#define MEMORYPOOL_CHUNK_SIZE 65536
+
+// The number of size classes.
+#define MEMORYPOOL_SIZE_CLASS_COUNT 12
+
+namespace gameplay
+{
+
+// The largest allocation of each size class, growing by half each time.
+static const size_t __sizeClasses[MEMORYPOOL_SIZE_CLASS_COUNT] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+
+static MemoryPool* __defaultPool = NULL;
+static MemoryPool* __currentPool = NULL;
+
+struct MemoryPool::Chunk
+{
+    MemoryPool* pool;
+    Chunk* next;
+    unsigned int sizeClass;
+    unsigned int used;
+};
+
+MemoryPool::MemoryPool()
+    : _chunks(NULL), _allocationCount(0), _memorySize(0)
+{
+    GP_ASSERT(sizeof(_freeBlocks) / sizeof(_freeBlocks[0]) == MEMORYPOOL_SIZE_CLASS_COUNT);
+    memset(_freeBlocks, 0, sizeof(_freeBlocks));
+}
+
+MemoryPool::~MemoryPool()
+{
+    if (__currentPool == this)
+    {
+        __currentPool = NULL;
+    }
+
+    if (_allocationCount > 0)
+    {
+        // Hand the chunks over to the default pool, which frees the remaining allocations when they are destroyed.
+        GP_WARN("Destroying a memory pool with %u allocations that have not been freed.", _allocationCount);
+        MemoryPool* pool = getDefault();
+        GP_ASSERT(pool != this);
+        Mutex::Lock lock(pool->_mutex);
+        while (_chunks)
+        {
+            Chunk* chunk = _chunks;
+            _chunks = chunk->next;
+            chunk->pool = pool;
+            chunk->next = pool->_chunks;
+            pool->_chunks = chunk;
+        }
+        for (unsigned int i = 0; i < MEMORYPOOL_SIZE_CLASS_COUNT; ++i)
+        {
+            while (_freeBlocks[i])
+            {
+                Block* block = _freeBlocks[i];
+                _freeBlocks[i] = block->next;
+                block->next = pool->_freeBlocks[i];
+                pool->_freeBlocks[i] = block;
+            }
+        }
+        pool->_allocationCount += _allocationCount;
+        pool->_memorySize += _memorySize;
+        return;
+    }
+
+    while (_chunks)
+    {
+        Chunk* chunk = _chunks;
+        _chunks = chunk->next;
+        free(chunk);
+    }
+}
+
+void MemoryPool::setCurrent(MemoryPool* pool)
+{
+    __currentPool = pool;
+}
+
+MemoryPool* MemoryPool::getCurrent()
+{
+    return __currentPool ? __currentPool : getDefault();
+}
+
+MemoryPool* MemoryPool::getDefault()
+{
+    // The default pool is never deleted, since objects may outlive any static destructor.
+    if (__defaultPool == NULL)
+    {
+        __defaultPool = new MemoryPool();
+    }
+    return __defaultPool;
+}
+
+void* MemoryPool::allocate(size_t size)
+{
+    unsigned int sizeClass = 0;
+    while (sizeClass < MEMORYPOOL_SIZE_CLASS_COUNT && size > __sizeClasses[sizeClass])
+    {
+        ++sizeClass;
+    }
+
+    Block* block;
+    if (sizeClass < MEMORYPOOL_SIZE_CLASS_COUNT)
+    {
+        block = getCurrent()->allocateBlock(sizeClass);
+    }
+    else
+    {
+        block = (Block*)malloc(sizeof(Block) + size);
+        GP_ASSERT(block);
+        block->chunk = NULL;
+    }
+    block->next = NULL;
+    return block + 1;
+}
+
+void MemoryPool::deallocate(void* pointer)
+{
+    if (pointer == NULL)
+        return;
+
+    Block* block = (Block*)pointer - 1;
+    if (block->chunk)
+    {
+        block->chunk->pool->deallocateBlock(block);
+    }
+    else
+    {
+        free(block);
+    }
+}
+
+unsigned int MemoryPool::getAllocationCount() const
+{
+    return _allocationCount;
+}
+
+size_t MemoryPool::getMemorySize() const
+{
+    return _memorySize;
+}
+
+void MemoryPool::trim()
+{
+    Mutex::Lock lock(_mutex);
+
+    // Drop the blocks of the unused chunks from the free lists first.
+    for (unsigned int i = 0; i < MEMORYPOOL_SIZE_CLASS_COUNT; ++i)
+    {
+        Block** link = &_freeBlocks[i];
+        while (*link)
+        {
+            if ((*link)->chunk->used == 0)
+                *link = (*link)->next;
+            else
+                link = &(*link)->next;
+        }
+    }
+
+    Chunk** link = &_chunks;
+    while (*link)
+    {
+        Chunk* chunk = *link;
+        if (chunk->used == 0)
+        {
+            *link = chunk->next;
+            _memorySize -= MEMORYPOOL_CHUNK_SIZE;
+            free(chunk);
+        }
+        else
+        {
+            link = &chunk->next;
+        }
+    }
+}
+
+MemoryPool::Block* MemoryPool::allocateBlock(unsigned int sizeClass)
+{
+    GP_ASSERT(sizeClass < MEMORYPOOL_SIZE_CLASS_COUNT);
+
+    Mutex::Lock lock(_mutex);
+    if (_freeBlocks[sizeClass] == NULL)
+    {
+        // Carve a new chunk into free blocks of the size class.
+        Chunk* chunk = (Chunk*)malloc(MEMORYPOOL_CHUNK_SIZE);
+        GP_ASSERT(chunk);
+        chunk->pool = this;
+        chunk->next = _chunks;
+        chunk->sizeClass = sizeClass;
+        chunk->used = 0;
+        _chunks = chunk;
+        _memorySize += MEMORYPOOL_CHUNK_SIZE;
+
+        // The blocks start after the header of the chunk, aligned for any type.
+        size_t headerSize = (sizeof(Chunk) + 15) & ~(size_t)15;
+        size_t blockSize = sizeof(Block) + __sizeClasses[sizeClass];
+        unsigned char* data = (unsigned char*)chunk + headerSize;
+        unsigned int blockCount = (unsigned int)((MEMORYPOOL_CHUNK_SIZE - headerSize) / blockSize);
+        for (unsigned int i = blockCount; i > 0; --i)
+        {
+            Block* block = (Block*)(data + (i - 1) * blockSize);
+            block->chunk = chunk;
+            block->next = _freeBlocks[sizeClass];
+            _freeBlocks[sizeClass] = block;
+        }
+    }
+
+    Block* block = _freeBlocks[sizeClass];
+    _freeBlocks[sizeClass] = block->next;
+    ++block->chunk->used;
+    ++_allocationCount;
+    return block;
+}
+
+void MemoryPool::deallocateBlock(Block* block)
+{
+    GP_ASSERT(block && block->chunk && block->chunk->pool == this);
+
+    Mutex::Lock lock(_mutex);
+    unsigned int sizeClass = block->chunk->sizeClass;
+    block->next = _freeBlocks[sizeClass];
+    _freeBlocks[sizeClass] = block;
+    --block->chunk->used;
+    GP_ASSERT(_allocationCount > 0);
+    --_allocationCount;
+}
+
+}
@@ -0,0 +1,157 @@
+#ifndef MEMORYPOOL_H_
+#define MEMORYPOOL_H_
+
+#include "Thread.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool allocator for the small engine objects that are created and destroyed often.
+ *
+ * Allocations are rounded up to a size class and carved out of large chunks of memory,
+ * so allocating and freeing an object only pops or pushes a free list of its size class
+ * instead of going through the heap. Allocations larger than the largest size class
+ * go to the heap.
+ *
+ * Nodes (and joints), models and animation clips are allocated from the current pool,
+ * which is the default pool unless another one is made current. A level can allocate
+ * its objects from its own pool by making it current while the level loads. Once the
+ * level is unloaded, deleting the pool frees all its chunks at once.
+ *
+ * @code
+   MemoryPool* levelPool = new MemoryPool();
+   MemoryPool::setCurrent(levelPool);
+   Scene* scene = Scene::load("res/level1.scene");
+   MemoryPool::setCurrent(NULL);
+   ...
+   SAFE_RELEASE(scene);
+   SAFE_DELETE(levelPool);
+ * @endcode
+ *
+ * Objects always return their memory to the pool they were allocated from, whichever pool
+ * is current when they are destroyed. The current pool is shared by all the threads.
+ *
+ * Objects are allocated from the heap when GP_USE_MEM_LEAK_DETECTION is defined, so that
+ * their leaks are still reported.
+ *
+ * @script{ignore}
+ */
+class MemoryPool
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    MemoryPool();
+
+    /**
+     * Destructor. Frees all the chunks of the pool.
+     *
+     * The objects allocated from the pool must have been destroyed. If some have not,
+     * a warning is logged and the chunks are kept alive for them.
+     */
+    ~MemoryPool();
+
+    /**
+     * Sets the pool the engine objects are allocated from.
+     *
+     * @param pool The pool, or NULL to use the default pool.
+     */
+    static void setCurrent(MemoryPool* pool);
+
+    /**
+     * Returns the pool the engine objects are allocated from.
+     *
+     * @return The current pool.
+     */
+    static MemoryPool* getCurrent();
+
+    /**
+     * Returns the default pool, which is used when no other pool is current.
+     *
+     * @return The default pool.
+     */
+    static MemoryPool* getDefault();
+
+    /**
+     * Allocates memory from the current pool.
+     *
+     * @param size The size of the memory to allocate, in bytes.
+     *
+     * @return The allocated memory, aligned for any type.
+     */
+    static void* allocate(size_t size);
+
+    /**
+     * Frees memory allocated by allocate(), returning it to the pool it was allocated from.
+     *
+     * @param pointer The memory to free, or NULL.
+     */
+    static void deallocate(void* pointer);
+
+    /**
+     * Returns the number of allocations of this pool that have not been freed.
+     *
+     * @return The number of live allocations.
+     */
+    unsigned int getAllocationCount() const;
+
+    /**
+     * Returns the memory held by the chunks of this pool.
+     *
+     * @return The size of the chunks, in bytes.
+     */
+    size_t getMemorySize() const;
+
+    /**
+     * Frees the chunks of this pool that no longer hold any allocation.
+     */
+    void trim();
+
+private:
+
+    struct Chunk;
+
+    /**
+     * Defines the header that precedes each allocation.
+     */
+    struct Block
+    {
+        // The chunk of the block, or NULL for allocations from the heap.
+        Chunk* chunk;
+        // The next free block of the size class, while the block is free.
+        Block* next;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    MemoryPool(const MemoryPool& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    MemoryPool& operator=(const MemoryPool&);
+
+    /**
+     * Pops a free block of a size class, allocating a chunk for it if needed.
+     */
+    Block* allocateBlock(unsigned int sizeClass);
+
+    /**
+     * Pushes a block back on the free list of its size class.
+     */
+    void deallocateBlock(Block* block);
+
+    Chunk* _chunks;
+    Block* _freeBlocks[12];
+    unsigned int _allocationCount;
+    size_t _memorySize;
+    Mutex _mutex;
+};
+
+}
+
+#endif
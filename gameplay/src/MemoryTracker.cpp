@@ -0,0 +1,167 @@
+#include "Base.h"
+#include "MemoryTracker.h"
+#include "Thread.h"
+
+#ifdef _MSC_VER
+#define MEMORY_THREAD_LOCAL __declspec(thread)
+#else
+#define MEMORY_THREAD_LOCAL __thread
+#endif
+
+namespace gameplay
+{
+
+// The counters are plain statics so that they are usable by allocations made before any constructor runs.
+static volatile unsigned int __liveBytes[MemoryTracker::CATEGORY_COUNT];
+static volatile unsigned int __highWaterMarks[MemoryTracker::CATEGORY_COUNT];
+static volatile unsigned int __allocationCounts[MemoryTracker::CATEGORY_COUNT];
+static unsigned int __budgets[MemoryTracker::CATEGORY_COUNT];
+static bool __overBudget[MemoryTracker::CATEGORY_COUNT];
+
+// The category of the innermost scope of the current thread.
+static MEMORY_THREAD_LOCAL unsigned int __currentCategory = MemoryTracker::GENERAL;
+
+static const char* __categoryNames[MemoryTracker::CATEGORY_COUNT] = { "general", "texture", "mesh", "animation", "script", "ui", "audio" };
+
+MemoryTracker::Scope::Scope(Category category)
+    : _previous((Category)__currentCategory)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    __currentCategory = category;
+}
+
+MemoryTracker::Scope::~Scope()
+{
+    __currentCategory = _previous;
+}
+
+bool MemoryTracker::isHeapTracked()
+{
+#if defined(GP_USE_MEM_TRACKING) || defined(GP_USE_MEM_LEAK_DETECTION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+MemoryTracker::Category MemoryTracker::getCurrentCategory()
+{
+    return (Category)__currentCategory;
+}
+
+const char* MemoryTracker::getCategoryName(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __categoryNames[category];
+}
+
+unsigned int MemoryTracker::getLiveBytes(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __liveBytes[category];
+}
+
+unsigned int MemoryTracker::getTotalLiveBytes()
+{
+    unsigned int bytes = 0;
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        bytes += __liveBytes[i];
+    }
+    return bytes;
+}
+
+unsigned int MemoryTracker::getHighWaterMark(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __highWaterMarks[category];
+}
+
+void MemoryTracker::resetHighWaterMark(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    __highWaterMarks[category] = __liveBytes[category];
+}
+
+unsigned int MemoryTracker::getAllocationCount(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __allocationCounts[category];
+}
+
+void MemoryTracker::setBudget(Category category, unsigned int bytes)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    __budgets[category] = bytes;
+    __overBudget[category] = false;
+}
+
+unsigned int MemoryTracker::getBudget(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __budgets[category];
+}
+
+bool MemoryTracker::isOverBudget(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __budgets[category] > 0 && __liveBytes[category] > __budgets[category];
+}
+
+void MemoryTracker::track(Category category, unsigned int bytes)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    // Raise the high-water mark, unless another thread raised it higher in the meantime.
+    unsigned int live = Atomic::add(&__liveBytes[category], bytes);
+    unsigned int mark = __highWaterMarks[category];
+    while (live > mark)
+    {
+        unsigned int previous = Atomic::compareExchange(&__highWaterMarks[category], mark, live);
+        if (previous == mark)
+            break;
+        mark = previous;
+    }
+}
+
+void MemoryTracker::untrack(Category category, unsigned int bytes)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    Atomic::subtract(&__liveBytes[category], bytes);
+}
+
+void MemoryTracker::trackAllocation(Category category, unsigned int bytes)
+{
+    track(category, bytes);
+    Atomic::increment(&__allocationCounts[category]);
+}
+
+void MemoryTracker::untrackAllocation(Category category, unsigned int bytes)
+{
+    untrack(category, bytes);
+    Atomic::decrement(&__allocationCounts[category]);
+}
+
+void MemoryTracker::print()
+{
+    gameplay::print("[memory] %-10s %12s %12s %12s %10s\n", "category", "live", "high-water", "budget", "allocs");
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        gameplay::print("[memory] %-10s %12u %12u %12u %10u\n", __categoryNames[i], __liveBytes[i], __highWaterMarks[i], __budgets[i], __allocationCounts[i]);
+    }
+}
+
+void MemoryTracker::update()
+{
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        bool overBudget = isOverBudget((Category)i);
+        if (overBudget && !__overBudget[i])
+        {
+            GP_WARN("The %s memory (%u bytes) is over its budget of %u bytes.", __categoryNames[i], __liveBytes[i], __budgets[i]);
+        }
+        __overBudget[i] = overBudget;
+    }
+}
+
+}
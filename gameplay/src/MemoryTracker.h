@@ -0,0 +1,236 @@
+#ifndef MEMORYTRACKER_H_
+#define MEMORYTRACKER_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a tracker of the memory used by each subsystem of the engine, with optional budgets.
+ *
+ * Memory is counted against categories. The graphics memory of textures and meshes, the
+ * decoded audio of audio buffers and the memory of the Lua state are always counted against
+ * their category. When heap tracking is compiled in, every allocation made with new is also
+ * counted, against the category of the innermost Scope of the allocating thread (or GENERAL).
+ * The engine opens scopes while it loads textures, meshes, animations, forms and sounds.
+ *
+ * Heap tracking is compiled in when either GP_USE_MEM_TRACKING or GP_USE_MEM_LEAK_DETECTION
+ * is defined. GP_USE_MEM_TRACKING only adds a small header and two atomic additions to each
+ * allocation, so it can be enabled in release builds (with the GP_USE_MEM_TRACKING option of the
+ * CMake build, off by default), while GP_USE_MEM_LEAK_DETECTION also records the source of
+ * each allocation to report leaks at exit.
+ *
+ * A budget can be set for each category. The tracker logs a warning when a category goes over
+ * its budget, and isOverBudget() lets the game react, for instance by lowering the texture
+ * streaming budget or unloading levels.
+ *
+ * @code
+   MemoryTracker::setBudget(MemoryTracker::TEXTURE, 256 * 1024 * 1024);
+   ...
+   {
+       MemoryTracker::Scope scope(MemoryTracker::UI);
+       _hud = Form::create("res/hud.form");
+   }
+   ...
+   if (MemoryTracker::isOverBudget(MemoryTracker::TEXTURE))
+       Texture::setStreamingBudget(Texture::getStreamingBudget() / 2);
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class MemoryTracker
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the categories memory is counted against.
+     */
+    enum Category
+    {
+        GENERAL,
+        TEXTURE,
+        MESH,
+        ANIMATION,
+        SCRIPT,
+        UI,
+        AUDIO,
+        CATEGORY_COUNT
+    };
+
+    /**
+     * Counts the heap allocations of the calling thread against a category while it is in scope.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Constructor. Makes the category current on the calling thread.
+         *
+         * @param category The category to count allocations against.
+         */
+        Scope(Category category);
+
+        /**
+         * Destructor. Restores the category that was current before.
+         */
+        ~Scope();
+
+    private:
+
+        Scope(const Scope& copy);
+
+        Scope& operator=(const Scope&);
+
+        Category _previous;
+    };
+
+    /**
+     * Determines if heap allocations are tracked.
+     *
+     * @return true if GP_USE_MEM_TRACKING or GP_USE_MEM_LEAK_DETECTION is defined.
+     */
+    static bool isHeapTracked();
+
+    /**
+     * Returns the category heap allocations of the calling thread are counted against.
+     *
+     * @return The current category.
+     */
+    static Category getCurrentCategory();
+
+    /**
+     * Returns the name of a category.
+     *
+     * @param category The category.
+     *
+     * @return The name of the category.
+     */
+    static const char* getCategoryName(Category category);
+
+    /**
+     * Returns the memory currently counted against a category.
+     *
+     * @param category The category.
+     *
+     * @return The live memory, in bytes.
+     */
+    static unsigned int getLiveBytes(Category category);
+
+    /**
+     * Returns the memory currently counted against all the categories.
+     *
+     * @return The live memory, in bytes.
+     */
+    static unsigned int getTotalLiveBytes();
+
+    /**
+     * Returns the most memory counted against a category at once, since the start
+     * or since resetHighWaterMark() was called.
+     *
+     * @param category The category.
+     *
+     * @return The high-water mark, in bytes.
+     */
+    static unsigned int getHighWaterMark(Category category);
+
+    /**
+     * Resets the high-water mark of a category to its live memory.
+     *
+     * @param category The category.
+     */
+    static void resetHighWaterMark(Category category);
+
+    /**
+     * Returns the number of live heap allocations counted against a category.
+     *
+     * @param category The category.
+     *
+     * @return The number of allocations, which is always 0 when heap allocations are not tracked.
+     */
+    static unsigned int getAllocationCount(Category category);
+
+    /**
+     * Sets the memory budget of a category.
+     *
+     * @param category The category.
+     * @param bytes The budget, in bytes, or 0 for no budget (the default).
+     */
+    static void setBudget(Category category, unsigned int bytes);
+
+    /**
+     * Returns the memory budget of a category.
+     *
+     * @param category The category.
+     *
+     * @return The budget, in bytes, or 0 if the category has no budget.
+     */
+    static unsigned int getBudget(Category category);
+
+    /**
+     * Determines if a category uses more memory than its budget.
+     *
+     * @param category The category.
+     *
+     * @return true if the category has a budget and its live memory exceeds it.
+     */
+    static bool isOverBudget(Category category);
+
+    /**
+     * Counts memory that is not allocated with new against a category.
+     *
+     * @param category The category.
+     * @param bytes The size of the memory, in bytes.
+     */
+    static void track(Category category, unsigned int bytes);
+
+    /**
+     * Stops counting memory counted by track() against a category.
+     *
+     * @param category The category.
+     * @param bytes The size of the memory, in bytes.
+     */
+    static void untrack(Category category, unsigned int bytes);
+
+    /**
+     * Counts a heap allocation against a category.
+     *
+     * This is called by the global new operator when heap tracking is compiled in.
+     *
+     * @param category The category.
+     * @param bytes The size of the allocation, in bytes.
+     */
+    static void trackAllocation(Category category, unsigned int bytes);
+
+    /**
+     * Stops counting a heap allocation counted by trackAllocation() against a category.
+     *
+     * This is called by the global delete operator when heap tracking is compiled in.
+     *
+     * @param category The category.
+     * @param bytes The size of the allocation, in bytes.
+     */
+    static void untrackAllocation(Category category, unsigned int bytes);
+
+    /**
+     * Prints the live memory, high-water mark and budget of each category.
+     */
+    static void print();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    MemoryTracker();
+
+    /**
+     * Logs a warning for the categories that went over their budget since the last frame.
+     */
+    static void update();
+};
+
+}
+
+#endif
@@ -1,21 +1,30 @@
 #include "Base.h"
 #include "Mesh.h"
 #include "MeshPart.h"
+#include "MeshBVH.h"
+#include "Bundle.h"
 #include "Effect.h"
 #include "Model.h"
 #include "Material.h"
+#include "Game.h"
+#include "GraphicsMemory.h"
+#include "GLStateCache.h"
 
 namespace gameplay
 {
 
+static bool __pickingDataRetained = false;
+
 Mesh::Mesh(const VertexFormat& vertexFormat) 
-    : _vertexFormat(vertexFormat), _vertexCount(0), _vertexBuffer(0), _primitiveType(TRIANGLES), 
-      _partCount(0), _parts(NULL), _dynamic(false)
+    : GraphicsResource(RESTORE_BUFFERS), _vertexFormat(vertexFormat), _vertexCount(0), _vertexBuffer(0), _primitiveType(TRIANGLES),
+      _partCount(0), _parts(NULL), _dynamic(false), _deferred(false), _bvh(NULL), _retainedData(NULL)
 {
 }
 
 Mesh::~Mesh()
 {
+    SAFE_DELETE(_bvh);
+
     if (_parts)
     {
         for (unsigned int i = 0; i < _partCount; ++i)
@@ -27,22 +36,34 @@ Mesh::~Mesh()
 
     if (_vertexBuffer)
     {
-        glDeleteBuffers(1, &_vertexBuffer);
+        GraphicsMemory::untrack(GraphicsMemory::VERTEX_BUFFER, _vertexFormat.getVertexSize() * _vertexCount);
+        GLStateCache::deleteBuffer(_vertexBuffer);
         _vertexBuffer = 0;
     }
+
+    if (_retainedData)
+    {
+        releaseMemory(_vertexFormat.getVertexSize() * _vertexCount);
+        SAFE_DELETE_ARRAY(_retainedData);
+    }
 }
 
 Mesh* Mesh::createMesh(const VertexFormat& vertexFormat, unsigned int vertexCount, bool dynamic)
 {
     GLuint vbo;
     GL_ASSERT( glGenBuffers(1, &vbo) );
-    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, vbo) );
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vbo);
     GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, vertexFormat.getVertexSize() * vertexCount, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+    GraphicsMemory::track(GraphicsMemory::VERTEX_BUFFER, vertexFormat.getVertexSize() * vertexCount);
 
     Mesh* mesh = new Mesh(vertexFormat);
     mesh->_vertexCount = vertexCount;
     mesh->_vertexBuffer = vbo;
     mesh->_dynamic = dynamic;
+    if (__pickingDataRetained)
+    {
+        mesh->_pickPositions.resize(vertexCount * 3, 0.0f);
+    }
 
     return mesh;
 }
@@ -264,11 +285,12 @@ void Mesh::setPrimitiveType(PrimitiveType type)
 
 void Mesh::setVertexData(const float* vertexData, unsigned int vertexStart, unsigned int vertexCount)
 {
-    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer) );
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
 
     if (vertexStart == 0 && vertexCount == 0)
     {
         GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _vertexFormat.getVertexSize() * _vertexCount, vertexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+        Game::countBufferUpload(_vertexFormat.getVertexSize() * _vertexCount);
     }
     else
     {
@@ -278,6 +300,52 @@ void Mesh::setVertexData(const float* vertexData, unsigned int vertexStart, unsi
         }
 
         GL_ASSERT( glBufferSubData(GL_ARRAY_BUFFER, vertexStart * _vertexFormat.getVertexSize(), vertexCount * _vertexFormat.getVertexSize(), vertexData) );
+        Game::countBufferUpload(vertexCount * _vertexFormat.getVertexSize());
+    }
+
+    // Keep a copy of the vertices of static meshes that cannot be read from a bundle, to restore them.
+    unsigned int size = _vertexFormat.getVertexSize() * _vertexCount;
+    if (vertexData && !_dynamic && _url.empty() && (_retainedData || retainMemory(size)))
+    {
+        if (_retainedData == NULL)
+        {
+            _retainedData = new unsigned char[size];
+            memset(_retainedData, 0, size);
+        }
+        unsigned int count = (vertexStart == 0 && vertexCount == 0) ? _vertexCount : vertexCount;
+        memcpy(_retainedData + vertexStart * _vertexFormat.getVertexSize(), vertexData, count * _vertexFormat.getVertexSize());
+    }
+
+    if (!_pickPositions.empty() && vertexData)
+    {
+        if (vertexStart == 0 && vertexCount == 0)
+        {
+            vertexCount = _vertexCount;
+        }
+
+        // Find the position element, which may be packed and hold two or three values.
+        unsigned int offset = 0;
+        const VertexFormat::Element* position = NULL;
+        for (unsigned int i = 0, count = _vertexFormat.getElementCount(); i < count; ++i)
+        {
+            const VertexFormat::Element& element = _vertexFormat.getElement(i);
+            if (element.usage == VertexFormat::POSITION)
+            {
+                position = &element;
+                break;
+            }
+            offset += element.getByteSize();
+        }
+
+        unsigned int vertexSize = _vertexFormat.getVertexSize();
+        const unsigned char* source = (const unsigned char*)vertexData + offset;
+        for (unsigned int i = 0; i < vertexCount && position; ++i, source += vertexSize)
+        {
+            float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            VertexFormat::toFloat(*position, source, values);
+            memcpy(&_pickPositions[(vertexStart + i) * 3], values, 3 * sizeof(float));
+        }
+        SAFE_DELETE(_bvh);
     }
 }
 
@@ -286,22 +354,150 @@ MeshPart* Mesh::addPart(PrimitiveType primitiveType, IndexFormat indexFormat, un
     MeshPart* part = MeshPart::create(this, _partCount, primitiveType, indexFormat, indexCount, dynamic);
     if (part)
     {
-        // Increase size of part array and copy old subets into it.
-        MeshPart** oldParts = _parts;
-        _parts = new MeshPart*[_partCount + 1];
+        appendPart(part);
+    }
+
+    return part;
+}
+
+MeshPart* Mesh::addPart(const MeshPart* sharedPart)
+{
+    GP_ASSERT(sharedPart);
+
+    MeshPart* part = MeshPart::create(this, _partCount, sharedPart);
+    appendPart(part);
+    return part;
+}
+
+void Mesh::appendPart(MeshPart* part)
+{
+    // Increase size of part array and copy old subets into it.
+    MeshPart** oldParts = _parts;
+    _parts = new MeshPart*[_partCount + 1];
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        _parts[i] = oldParts[i];
+    }
+
+    // Add new part to array.
+    _parts[_partCount++] = part;
+
+    // Delete old part array.
+    SAFE_DELETE_ARRAY(oldParts);
+}
+
+void Mesh::discardGraphics()
+{
+    _vertexBuffer = 0;
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        _parts[i]->_indexBuffer = 0;
+    }
+}
+
+void Mesh::loadDeferredData()
+{
+    if (!_deferred)
+        return;
+    _deferred = false;
+
+    // Parts sharing the index buffer of another mesh are filled by that mesh.
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        if (_parts[i]->_sharedPart)
+            _parts[i]->_sharedPart->_mesh->loadDeferredData();
+    }
+
+    Bundle::MeshData* meshData = Bundle::readMeshData(_url.c_str());
+    if (meshData == NULL || meshData->vertexCount != _vertexCount || meshData->vertexFormat.getVertexSize() != _vertexFormat.getVertexSize() ||
+        meshData->parts.size() != _partCount)
+    {
+        GP_ERROR("Failed to read the deferred data of mesh '%s'.", _url.c_str());
+        SAFE_DELETE(meshData);
+        return;
+    }
+
+    setVertexData((const float*)meshData->vertexData, 0, _vertexCount);
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        if (!_parts[i]->_sharedPart)
+            _parts[i]->setIndexData(meshData->parts[i]->indexData, 0, _parts[i]->getIndexCount());
+    }
+    SAFE_DELETE(meshData);
+}
+
+void Mesh::restoreGraphics()
+{
+    // Restoring reads the data of deferred meshes from the bundle.
+    _deferred = false;
+
+    Bundle::MeshData* meshData = NULL;
+    if (!_url.empty())
+    {
+        meshData = Bundle::readMeshData(_url.c_str());
+        if (meshData && (meshData->vertexCount != _vertexCount || meshData->vertexFormat.getVertexSize() != _vertexFormat.getVertexSize() ||
+            meshData->parts.size() != _partCount))
+        {
+            SAFE_DELETE(meshData);
+        }
+    }
+    else if (_retainedData == NULL && !_dynamic)
+    {
+        GP_WARN("Restored a mesh of %u vertices without its data, which was not retained.", _vertexCount);
+    }
+
+    // A mesh whose bundle can't be read again is restored empty: its buffers are cleared,
+    // so all its triangles are degenerate and it draws nothing.
+    std::vector<unsigned char> empty;
+    if (!_url.empty() && meshData == NULL)
+    {
+        GP_WARN("Failed to read mesh '%s' again to restore it; it will be drawn empty.", _url.c_str());
+        size_t size = (size_t)_vertexFormat.getVertexSize() * _vertexCount;
         for (unsigned int i = 0; i < _partCount; ++i)
         {
-            _parts[i] = oldParts[i];
+            Mesh::IndexFormat format = _parts[i]->getIndexFormat();
+            size_t indexSize = format == INDEX32 ? 4 : (format == INDEX16 ? 2 : 1);
+            size = std::max(size, indexSize * _parts[i]->getIndexCount());
         }
+        empty.resize(std::max(size, (size_t)1), 0);
+    }
 
-        // Add new part to array.
-        _parts[_partCount++] = part;
+    // Dynamic meshes are refilled by their owners.
+    GL_ASSERT( glGenBuffers(1, &_vertexBuffer) );
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _vertexFormat.getVertexSize() * _vertexCount,
+        meshData ? meshData->vertexData : (empty.empty() ? _retainedData : &empty[0]),
+        _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
 
-        // Delete old part array.
-        SAFE_DELETE_ARRAY(oldParts);
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        _parts[i]->restoreIndexBuffer(meshData ? meshData->parts[i]->indexData : (empty.empty() ? NULL : &empty[0]));
     }
+    SAFE_DELETE(meshData);
+}
 
-    return part;
+void Mesh::setPickingDataRetained(bool retained)
+{
+    __pickingDataRetained = retained;
+}
+
+bool Mesh::isPickingDataRetained()
+{
+    return __pickingDataRetained;
+}
+
+bool Mesh::hasPickingData() const
+{
+    return !_pickPositions.empty();
+}
+
+const MeshBVH* Mesh::getBVH()
+{
+    if (_bvh == NULL && !_pickPositions.empty())
+    {
+        _bvh = MeshBVH::create(this);
+    }
+    return _bvh;
 }
 
 unsigned int Mesh::getPartCount() const
@@ -6,11 +6,13 @@
 #include "Vector3.h"
 #include "BoundingBox.h"
 #include "BoundingSphere.h"
+#include "GraphicsResource.h"
 
 namespace gameplay
 {
 
 class MeshPart;
+class MeshBVH;
 class Material;
 class Model;
 
@@ -18,10 +20,12 @@ class Model;
  * Defines a mesh supporting various vertex formats and 1 or more
  * MeshPart(s) to define how the vertices are connected.
  */
-class Mesh : public Ref
+class Mesh : public Ref, private GraphicsResource
 {
     friend class Model;
     friend class Bundle;
+    friend class MeshPart;
+    friend class MeshBVH;
 
 public:
 
@@ -221,6 +225,20 @@ public:
      */
     MeshPart* addPart(PrimitiveType primitiveType, Mesh::IndexFormat indexFormat, unsigned int indexCount, bool dynamic = false);
 
+    /**
+     * Adds a new part that draws the vertices of this mesh with the index buffer of an existing part.
+     *
+     * Meshes with the same vertex layout can share their index data this way instead of each
+     * holding a copy. The shared part owns the index buffer, so it must outlive the new part,
+     * and setting the index data of either part changes both.
+     *
+     * @param sharedPart The part whose index buffer to share, which can belong to another mesh.
+     *
+     * @return The newly created/added mesh part.
+     * @script{ignore}
+     */
+    MeshPart* addPart(const MeshPart* sharedPart);
+
     /**
      * Gets the number of mesh parts contained within the mesh.
      *
@@ -295,6 +313,48 @@ public:
      */
     void setBoundingSphere(const BoundingSphere& sphere);
 
+    /**
+     * Sets whether the meshes created from now on keep a copy of their vertex positions and indices.
+     *
+     * The vertex and index data of a mesh only live in GPU buffers, so ray picking against the
+     * triangles of a mesh needs a copy of its positions and triangle indices in memory (12 bytes
+     * per vertex and 4 per index). Meshes created while this is disabled (the default) are only
+     * picked against their bounds.
+     *
+     * @param retained true to keep the picking data of new meshes.
+     *
+     * @see getBVH()
+     * @script{ignore}
+     */
+    static void setPickingDataRetained(bool retained);
+
+    /**
+     * Determines if the meshes created from now on keep a copy of their vertex positions and indices.
+     *
+     * @return true if new meshes keep their picking data.
+     * @script{ignore}
+     */
+    static bool isPickingDataRetained();
+
+    /**
+     * Determines if this mesh kept a copy of its vertex positions and indices for picking.
+     *
+     * @return true if the mesh has picking data.
+     * @script{ignore}
+     */
+    bool hasPickingData() const;
+
+    /**
+     * Returns the bounding volume hierarchy of the triangles of this mesh, used to intersect rays with them.
+     *
+     * The hierarchy is built from the picking data of the mesh on the first call, and again on
+     * the first call after the vertex or index data of the mesh change.
+     *
+     * @return The hierarchy, or NULL if the mesh has no picking data.
+     * @script{ignore}
+     */
+    const MeshBVH* getBVH();
+
     /**
      * Destructor.
      */
@@ -317,6 +377,30 @@ private:
      */
     Mesh& operator=(const Mesh&);
 
+    /**
+     * Appends a part to the array of parts.
+     */
+    void appendPart(MeshPart* part);
+
+    /**
+     * Reads the vertex and index data of a mesh loaded from a bundle with Bundle::LOAD_DEFERRED_MESHES.
+     * Called by the model before the mesh is drawn.
+     */
+    void loadDeferredData();
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     *
+     * Meshes loaded from bundles read their data from the bundle again. The parts that share
+     * the index buffer of another mesh are restored after that mesh, which was created first.
+     */
+    void restoreGraphics();
+
     std::string _url;
     const VertexFormat _vertexFormat;
     unsigned int _vertexCount;
@@ -325,8 +409,12 @@ private:
     unsigned int _partCount;
     MeshPart** _parts;
     bool _dynamic;
+    bool _deferred;
     BoundingBox _boundingBox;
     BoundingSphere _boundingSphere;
+    std::vector<float> _pickPositions;
+    MeshBVH* _bvh;
+    unsigned char* _retainedData;
 };
 
 }
@@ -0,0 +1,265 @@
+#include "Base.h"
+#include "MeshBVH.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+
+// The largest number of triangles in a leaf of the hierarchy.
+#define MESH_BVH_LEAF_SIZE 4
+
+// The depth of the traversal stack, which a hierarchy split at the median never exceeds.
+#define MESH_BVH_STACK_SIZE 64
+
+namespace gameplay
+{
+
+/**
+ * Orders triangles by the coordinate of their centroid along an axis.
+ */
+struct MeshBVHCentroidLess
+{
+    MeshBVHCentroidLess(const std::vector<Vector3>& centroids, unsigned int axis) : centroids(centroids), axis(axis)
+    {
+    }
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        const float* ca = &centroids[a].x;
+        const float* cb = &centroids[b].x;
+        return ca[axis] < cb[axis];
+    }
+
+    const std::vector<Vector3>& centroids;
+    unsigned int axis;
+};
+
+MeshBVH::MeshBVH()
+{
+}
+
+MeshBVH::~MeshBVH()
+{
+}
+
+MeshBVH* MeshBVH::create(const Mesh* mesh)
+{
+    GP_ASSERT(mesh);
+
+    if (mesh->_pickPositions.empty())
+        return NULL;
+
+    MeshBVH* bvh = new MeshBVH();
+    if (mesh->_partCount == 0)
+    {
+        if (mesh->_primitiveType == Mesh::TRIANGLES || mesh->_primitiveType == Mesh::TRIANGLE_STRIP)
+            bvh->addTriangles(mesh->_pickPositions, NULL, mesh->_vertexCount, mesh->_primitiveType == Mesh::TRIANGLE_STRIP);
+    }
+    for (unsigned int i = 0; i < mesh->_partCount; ++i)
+    {
+        const MeshPart* part = mesh->_parts[i];
+        if (!part->_pickIndices.empty() && (part->_primitiveType == Mesh::TRIANGLES || part->_primitiveType == Mesh::TRIANGLE_STRIP))
+            bvh->addTriangles(mesh->_pickPositions, &part->_pickIndices[0], (unsigned int)part->_pickIndices.size(), part->_primitiveType == Mesh::TRIANGLE_STRIP);
+    }
+
+    unsigned int triangleCount = (unsigned int)bvh->_triangles.size();
+    if (triangleCount > 0)
+    {
+        std::vector<Vector3> centroids(triangleCount);
+        for (unsigned int i = 0; i < triangleCount; ++i)
+        {
+            centroids[i] = (bvh->_vertices[i * 3] + bvh->_vertices[i * 3 + 1] + bvh->_vertices[i * 3 + 2]) * (1.0f / 3.0f);
+        }
+
+        std::vector<unsigned int> order(triangleCount);
+        for (unsigned int i = 0; i < triangleCount; ++i)
+        {
+            order[i] = i;
+        }
+        bvh->_nodes.reserve(2 * (triangleCount / MESH_BVH_LEAF_SIZE) + 1);
+        bvh->build(order, 0, triangleCount, centroids);
+
+        // Store the triangles in the order of the leaves, so that each leaf reads a contiguous range.
+        std::vector<Vector3> vertices(bvh->_vertices.size());
+        for (unsigned int i = 0; i < triangleCount; ++i)
+        {
+            vertices[i * 3] = bvh->_vertices[order[i] * 3];
+            vertices[i * 3 + 1] = bvh->_vertices[order[i] * 3 + 1];
+            vertices[i * 3 + 2] = bvh->_vertices[order[i] * 3 + 2];
+            order[i] = bvh->_triangles[order[i]];
+        }
+        bvh->_vertices.swap(vertices);
+        bvh->_triangles.swap(order);
+    }
+
+    return bvh;
+}
+
+void MeshBVH::addTriangles(const std::vector<float>& positions, const unsigned int* indices, unsigned int indexCount, bool strip)
+{
+    unsigned int vertexCount = (unsigned int)positions.size() / 3;
+    unsigned int triangleCount = strip ? (indexCount >= 3 ? indexCount - 2 : 0) : indexCount / 3;
+    unsigned int first = (unsigned int)_triangles.size();
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        unsigned int start = strip ? i : i * 3;
+        unsigned int a = indices ? indices[start] : start;
+        unsigned int b = indices ? indices[start + 1] : start + 1;
+        unsigned int c = indices ? indices[start + 2] : start + 2;
+
+        // Skip the degenerate triangles that join strips, and indices past the end of the vertices.
+        if (a == b || b == c || a == c || a >= vertexCount || b >= vertexCount || c >= vertexCount)
+            continue;
+
+        _vertices.push_back(Vector3(&positions[a * 3]));
+        _vertices.push_back(Vector3(&positions[b * 3]));
+        _vertices.push_back(Vector3(&positions[c * 3]));
+        _triangles.push_back(first + i);
+    }
+}
+
+unsigned int MeshBVH::build(std::vector<unsigned int>& order, unsigned int start, unsigned int end, const std::vector<Vector3>& centroids)
+{
+    unsigned int index = (unsigned int)_nodes.size();
+    _nodes.push_back(Node());
+
+    // Bound the triangles of the node, and their centroids to pick the split axis.
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    Vector3 centroidMin = min;
+    Vector3 centroidMax = max;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        unsigned int triangle = order[i];
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            const Vector3& v = _vertices[triangle * 3 + j];
+            min.set(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
+            max.set(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+        }
+        const Vector3& c = centroids[triangle];
+        centroidMin.set(std::min(centroidMin.x, c.x), std::min(centroidMin.y, c.y), std::min(centroidMin.z, c.z));
+        centroidMax.set(std::max(centroidMax.x, c.x), std::max(centroidMax.y, c.y), std::max(centroidMax.z, c.z));
+    }
+    _nodes[index].min = min;
+    _nodes[index].max = max;
+
+    if (end - start <= MESH_BVH_LEAF_SIZE)
+    {
+        _nodes[index].start = start;
+        _nodes[index].count = end - start;
+        return index;
+    }
+
+    // Split at the median of the centroids along their longest extent.
+    Vector3 extent = centroidMax - centroidMin;
+    unsigned int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+    unsigned int middle = start + (end - start) / 2;
+    std::nth_element(order.begin() + start, order.begin() + middle, order.begin() + end, MeshBVHCentroidLess(centroids, axis));
+
+    build(order, start, middle, centroids);
+    unsigned int second = build(order, middle, end, centroids);
+    _nodes[index].start = second;
+    _nodes[index].count = 0;
+    return index;
+}
+
+// Returns the distance at which a ray enters a box, or a negative value if it misses the box within maxDistance.
+static float intersectBox(const Vector3& min, const Vector3& max, const Vector3& origin, const Vector3& inverseDirection, float maxDistance)
+{
+    float t1 = (min.x - origin.x) * inverseDirection.x;
+    float t2 = (max.x - origin.x) * inverseDirection.x;
+    float tmin = std::min(t1, t2);
+    float tmax = std::max(t1, t2);
+
+    t1 = (min.y - origin.y) * inverseDirection.y;
+    t2 = (max.y - origin.y) * inverseDirection.y;
+    tmin = std::max(tmin, std::min(t1, t2));
+    tmax = std::min(tmax, std::max(t1, t2));
+
+    t1 = (min.z - origin.z) * inverseDirection.z;
+    t2 = (max.z - origin.z) * inverseDirection.z;
+    tmin = std::max(tmin, std::min(t1, t2));
+    tmax = std::min(tmax, std::max(t1, t2));
+
+    if (tmax < std::max(tmin, 0.0f) || tmin > maxDistance)
+        return -1.0f;
+    return std::max(tmin, 0.0f);
+}
+
+bool MeshBVH::intersects(const Vector3& origin, const Vector3& direction, float maxDistance, float* distance, unsigned int* triangle) const
+{
+    GP_ASSERT(distance);
+
+    if (_nodes.empty())
+        return false;
+
+    // Directions parallel to an axis divide by zero into infinities, which the slab test handles.
+    Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    float nearest = maxDistance;
+    int hit = -1;
+    unsigned int stack[MESH_BVH_STACK_SIZE];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = _nodes[stack[--stackSize]];
+        if (intersectBox(node.min, node.max, origin, inverseDirection, nearest) < 0.0f)
+            continue;
+
+        if (node.count == 0)
+        {
+            GP_ASSERT(stackSize + 2 <= MESH_BVH_STACK_SIZE);
+            unsigned int first = (unsigned int)(&node - &_nodes[0]) + 1;
+            stack[stackSize++] = node.start;
+            stack[stackSize++] = first;
+            continue;
+        }
+
+        for (unsigned int i = node.start, end = node.start + node.count; i < end; ++i)
+        {
+            // Moller-Trumbore ray/triangle intersection.
+            const Vector3& v0 = _vertices[i * 3];
+            Vector3 e1 = _vertices[i * 3 + 1] - v0;
+            Vector3 e2 = _vertices[i * 3 + 2] - v0;
+            Vector3 p;
+            Vector3::cross(direction, e2, &p);
+            float det = e1.dot(p);
+            if (det == 0.0f)
+                continue;
+
+            float inverseDet = 1.0f / det;
+            Vector3 s = origin - v0;
+            float u = s.dot(p) * inverseDet;
+            if (u < 0.0f || u > 1.0f)
+                continue;
+
+            Vector3 q;
+            Vector3::cross(s, e1, &q);
+            float v = direction.dot(q) * inverseDet;
+            if (v < 0.0f || u + v > 1.0f)
+                continue;
+
+            float t = e2.dot(q) * inverseDet;
+            if (t >= 0.0f && t <= nearest)
+            {
+                nearest = t;
+                hit = (int)i;
+            }
+        }
+    }
+
+    if (hit < 0)
+        return false;
+
+    *distance = nearest;
+    if (triangle)
+        *triangle = _triangles[hit];
+    return true;
+}
+
+unsigned int MeshBVH::getTriangleCount() const
+{
+    return (unsigned int)_triangles.size();
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef MESHBVH_H_
+#define MESHBVH_H_
+
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+class Mesh;
+
+/**
+ * Defines a bounding volume hierarchy over the triangles of a mesh, used to intersect rays
+ * with the mesh without testing every triangle.
+ *
+ * The hierarchy is built from the copy of the vertex positions and indices that a mesh keeps
+ * when picking data is retained (see Mesh::setPickingDataRetained), the first time it is
+ * requested from Mesh::getBVH. It is rebuilt after the vertex or index data of the mesh change.
+ *
+ * The triangles are stored in model space, so rays must be transformed into the space of the
+ * mesh before they are tested.
+ *
+ * @script{ignore}
+ */
+class MeshBVH
+{
+    friend class Mesh;
+    friend class MeshPart;
+
+public:
+
+    /**
+     * Finds the nearest triangle intersected by a ray.
+     *
+     * Triangles are hit from either side. The direction does not need to be normalized, and
+     * the returned distance is in multiples of its length, so a ray transformed from world space
+     * into model space without normalizing its direction reports the same distance as in world space.
+     *
+     * @param origin The origin of the ray, in model space.
+     * @param direction The direction of the ray, in model space.
+     * @param maxDistance The distance beyond which triangles are ignored.
+     * @param distance Set to the distance of the nearest intersection, if any.
+     * @param triangle Set to the index of the triangle hit, in the order the mesh defines them, or NULL.
+     *
+     * @return true if a triangle was hit within the maximum distance.
+     */
+    bool intersects(const Vector3& origin, const Vector3& direction, float maxDistance, float* distance, unsigned int* triangle = NULL) const;
+
+    /**
+     * Returns the number of triangles in the hierarchy.
+     *
+     * @return The number of triangles.
+     */
+    unsigned int getTriangleCount() const;
+
+private:
+
+    /**
+     * Defines a node of the hierarchy.
+     *
+     * The first child of an inner node follows it, and the second child is at the index given by start.
+     */
+    struct Node
+    {
+        Vector3 min;
+        Vector3 max;
+        unsigned int start;
+        unsigned int count;     // The number of triangles of a leaf, or 0 for an inner node.
+    };
+
+    /**
+     * Constructor.
+     */
+    MeshBVH();
+
+    /**
+     * Destructor.
+     */
+    ~MeshBVH();
+
+    /**
+     * Hidden copy constructor.
+     */
+    MeshBVH(const MeshBVH& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    MeshBVH& operator=(const MeshBVH&);
+
+    /**
+     * Builds the hierarchy of the triangles of a mesh from its picking data.
+     *
+     * @return The hierarchy, or NULL if the mesh has no picking data.
+     */
+    static MeshBVH* create(const Mesh* mesh);
+
+    /**
+     * Adds the triangles of a list or strip of vertex indices.
+     */
+    void addTriangles(const std::vector<float>& positions, const unsigned int* indices, unsigned int indexCount, bool strip);
+
+    /**
+     * Builds the subtree of the triangles [start, end) of order and returns the index of its root.
+     */
+    unsigned int build(std::vector<unsigned int>& order, unsigned int start, unsigned int end, const std::vector<Vector3>& centroids);
+
+    std::vector<Vector3> _vertices;         // Three per triangle, in the order of the leaves once built.
+    std::vector<unsigned int> _triangles;   // The original index of each triangle, in the order of the leaves.
+    std::vector<Node> _nodes;
+};
+
+}
+
+#endif
@@ -1,13 +1,17 @@
 #include "Base.h"
 #include "MeshBatch.h"
 #include "Material.h"
+#include "MeshPart.h"
+#include "Game.h"
+#include "GLStateCache.h"
+#include "CommandBuffer.h"
 
 namespace gameplay
 {
 
 MeshBatch::MeshBatch(const VertexFormat& vertexFormat, Mesh::PrimitiveType primitiveType, Material* material, bool indexed, unsigned int initialCapacity, unsigned int growSize)
     : _vertexFormat(vertexFormat), _primitiveType(primitiveType), _material(material), _indexed(indexed), _capacity(0), _growSize(growSize),
-    _vertexCapacity(0), _indexCapacity(0), _vertexCount(0), _indexCount(0), _vertices(NULL), _verticesPtr(NULL), _indices(NULL), _indicesPtr(NULL), _started(false)
+    _vertexCapacity(0), _indexCapacity(0), _vertexCount(0), _indexCount(0), _vertices(NULL), _verticesPtr(NULL), _indices(NULL), _indicesPtr(NULL), _mesh(NULL), _meshPart(NULL), _dirty(true), _started(false)
 {
     resize(initialCapacity);
 }
@@ -15,6 +19,7 @@ MeshBatch::MeshBatch(const VertexFormat& vertexFormat, Mesh::PrimitiveType primi
 MeshBatch::~MeshBatch()
 {
     SAFE_RELEASE(_material);
+    SAFE_RELEASE(_mesh);
     SAFE_DELETE_ARRAY(_vertices);
     SAFE_DELETE_ARRAY(_indices);
 }
@@ -101,6 +106,7 @@ void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount,
     
     _verticesPtr += vBytes;
     _vertexCount = newVertexCount;
+    _dirty = true;
 }
 
 void MeshBatch::updateVertexAttributeBinding()
@@ -116,7 +122,7 @@ void MeshBatch::updateVertexAttributeBinding()
         {
             Pass* p = t->getPassByIndex(j);
             GP_ASSERT(p);
-            VertexAttributeBinding* b = VertexAttributeBinding::create(_vertexFormat, _vertices, p->getEffect());
+            VertexAttributeBinding* b = VertexAttributeBinding::create(_mesh, p->getEffect());
             p->setVertexAttributeBinding(b);
             SAFE_RELEASE(b);
         }
@@ -211,7 +217,17 @@ bool MeshBatch::resize(unsigned int capacity)
     _vertexCapacity = vertexCapacity;
     _indexCapacity = indexCapacity;
 
-    // Update our vertex attribute bindings now that our client array pointers have changed
+    // Recreate the streaming buffers to match the new capacity.
+    SAFE_RELEASE(_mesh);
+    _meshPart = NULL;
+    _mesh = Mesh::createMesh(_vertexFormat, vertexCapacity, true);
+    if (_indexed)
+    {
+        _meshPart = _mesh->addPart(_primitiveType, Mesh::INDEX16, indexCapacity, true);
+    }
+    _dirty = true;
+
+    // Update our vertex attribute bindings now that our vertex buffer has changed
     updateVertexAttributeBinding();
 
     return true;
@@ -228,6 +244,7 @@ void MeshBatch::start()
     _indexCount = 0;
     _verticesPtr = _vertices;
     _indicesPtr = _indices;
+    _dirty = true;
     _started = true;
 }
 
@@ -241,18 +258,105 @@ void MeshBatch::finish()
     _started = false;
 }
 
+void MeshBatch::upload()
+{
+    GP_ASSERT(_mesh);
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer());
+    streamBufferData(GL_ARRAY_BUFFER, _vertices, _vertexCount * _vertexFormat.getVertexSize(), _vertexCapacity * _vertexFormat.getVertexSize());
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (_indexed)
+    {
+        GP_ASSERT(_meshPart);
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _meshPart->getIndexBuffer());
+        streamBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices, _indexCount * sizeof(unsigned short), _indexCapacity * sizeof(unsigned short));
+    }
+
+    _dirty = false;
+}
+
+void MeshBatch::recordUpload(CommandBuffer* buffer)
+{
+    GP_ASSERT(buffer);
+    GP_ASSERT(_mesh);
+
+    // The batch is filled again by the next frame while the recorded one is drawn, so the geometry is copied
+    // into the buffer, and the mesh owning the streaming buffers is kept alive until then.
+    buffer->retain(_mesh);
+    unsigned int vertexSize = _vertexCount * _vertexFormat.getVertexSize();
+    unsigned int indexSize = _indexed ? _indexCount * sizeof(unsigned short) : 0;
+    RecordedUpload* upload = (RecordedUpload*)buffer->callWithData(&MeshBatch::uploadRecorded, sizeof(RecordedUpload) + vertexSize + indexSize);
+    upload->vertexBuffer = _mesh->getVertexBuffer();
+    upload->vertexSize = vertexSize;
+    upload->vertexCapacity = _vertexCapacity * _vertexFormat.getVertexSize();
+    upload->indexBuffer = _indexed ? _meshPart->getIndexBuffer() : 0;
+    upload->indexSize = indexSize;
+    upload->indexCapacity = _indexed ? _indexCapacity * sizeof(unsigned short) : 0;
+    unsigned char* data = (unsigned char*)(upload + 1);
+    memcpy(data, _vertices, vertexSize);
+    if (indexSize > 0)
+        memcpy(data + vertexSize, _indices, indexSize);
+
+    _dirty = false;
+}
+
+void MeshBatch::uploadRecorded(void* arg)
+{
+    RecordedUpload* upload = (RecordedUpload*)arg;
+    GP_ASSERT(upload);
+    const unsigned char* data = (const unsigned char*)(upload + 1);
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, upload->vertexBuffer);
+    streamBufferData(GL_ARRAY_BUFFER, data, upload->vertexSize, upload->vertexCapacity);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (upload->indexBuffer)
+    {
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, upload->indexBuffer);
+        streamBufferData(GL_ELEMENT_ARRAY_BUFFER, data + upload->vertexSize, upload->indexSize, upload->indexCapacity);
+    }
+}
+
+void MeshBatch::streamBufferData(GLenum target, const void* data, unsigned int size, unsigned int capacity)
+{
+    Game::countBufferUpload(size);
+
+#ifdef USE_MAP_BUFFER_RANGE
+    if (glMapBufferRange)
+    {
+        // Invalidating the whole buffer lets the driver hand out fresh storage to write into directly.
+        void* ptr = glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (ptr)
+        {
+            memcpy(ptr, data, size);
+            if (glUnmapBuffer(target))
+                return;
+        }
+    }
+#endif
+
+    // Orphan the old storage before writing the new contents.
+    GL_ASSERT( glBufferData(target, capacity, NULL, GL_STREAM_DRAW) );
+    GL_ASSERT( glBufferSubData(target, 0, size, data) );
+}
+
 void MeshBatch::draw()
 {
     if (_vertexCount == 0 || (_indexed && _indexCount == 0))
         return; // nothing to draw
 
-    // Not using VBOs, so unbind the element array buffer.
-    // ARRAY_BUFFER will be unbound automatically during pass->bind().
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0 ) );
-
     GP_ASSERT(_material);
-    if (_indexed)
-        GP_ASSERT(_indices);
+
+    // Only upload geometry that changed since the last draw.
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (_dirty)
+    {
+        if (buffer)
+            recordUpload(buffer);
+        else
+            upload();
+    }
 
     // Bind the material.
     Technique* technique = _material->getTechnique();
@@ -264,18 +368,27 @@ void MeshBatch::draw()
         GP_ASSERT(pass);
         pass->bind();
 
-        if (_indexed)
+        if (buffer)
         {
-            GL_ASSERT( glDrawElements(_primitiveType, _indexCount, GL_UNSIGNED_SHORT, (GLvoid*)_indices) );
+            if (_indexed)
+                buffer->drawElements(_primitiveType, _indexCount, GL_UNSIGNED_SHORT, _meshPart->getIndexBuffer());
+            else
+                buffer->drawArrays(_primitiveType, _vertexCount);
+        }
+        else if (_indexed)
+        {
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _meshPart->getIndexBuffer());
+            GL_ASSERT( glDrawElements(_primitiveType, _indexCount, GL_UNSIGNED_SHORT, 0) );
+            Game::countDrawCall(_primitiveType, _indexCount);
         }
         else
         {
             GL_ASSERT( glDrawArrays(_primitiveType, 0, _vertexCount) );
+            Game::countDrawCall(_primitiveType, _vertexCount);
         }
 
         pass->unbind();
     }
 }
-    
 
 }
@@ -7,9 +7,15 @@ namespace gameplay
 {
 
 class Material;
+class CommandBuffer;
 
 /**
  * Defines a class for rendering multiple mesh into a single draw call on the graphics device.
+ *
+ * Geometry added to the batch is accumulated in system memory and streamed into
+ * GPU vertex and index buffers when the batch is drawn. The previous contents of
+ * these buffers are orphaned on each upload so that refilling the batch every frame
+ * never stalls on draws that are still reading last frame's geometry.
  */
 class MeshBatch
 {
@@ -164,6 +170,40 @@ private:
 
     bool resize(unsigned int capacity);
 
+    /**
+     * Uploads the batched geometry to the streaming vertex and index buffers.
+     */
+    void upload();
+
+    /**
+     * The header of the geometry copied into a command buffer by recordUpload(), followed by the vertices and indices.
+     */
+    struct RecordedUpload
+    {
+        VertexBufferHandle vertexBuffer;
+        unsigned int vertexSize;
+        unsigned int vertexCapacity;
+        IndexBufferHandle indexBuffer;
+        unsigned int indexSize;
+        unsigned int indexCapacity;
+    };
+
+    /**
+     * Records the upload of the batched geometry into the specified command buffer.
+     */
+    void recordUpload(CommandBuffer* buffer);
+
+    /**
+     * Uploads the geometry copied by recordUpload(), when the command buffer is executed.
+     */
+    static void uploadRecorded(void* arg);
+
+    /**
+     * Replaces the contents of the buffer currently bound to the given target,
+     * orphaning its previous storage so the upload does not wait on pending draws.
+     */
+    static void streamBufferData(GLenum target, const void* data, unsigned int size, unsigned int capacity);
+
     const VertexFormat _vertexFormat;
     Mesh::PrimitiveType _primitiveType;
     Material* _material;
@@ -178,6 +218,9 @@ private:
     unsigned char* _verticesPtr;
     unsigned short* _indices;
     unsigned short* _indicesPtr;
+    Mesh* _mesh;
+    MeshPart* _meshPart;
+    bool _dirty;
     bool _started;
 
 };
@@ -1,19 +1,32 @@
 #include "Base.h"
 #include "MeshPart.h"
+#include "MeshBVH.h"
+#include "Game.h"
+#include "GraphicsMemory.h"
+#include "GLStateCache.h"
 
 namespace gameplay
 {
 
 MeshPart::MeshPart() :
-    _mesh(NULL), _meshIndex(0), _primitiveType(Mesh::TRIANGLES), _indexCount(0), _indexBuffer(0), _dynamic(false)
+    _mesh(NULL), _meshIndex(0), _primitiveType(Mesh::TRIANGLES), _indexCount(0), _indexBuffer(0), _dynamic(false), _sharedPart(NULL),
+    _retainedData(NULL)
 {
 }
 
 MeshPart::~MeshPart()
 {
-    if (_indexBuffer)
+    unsigned int indexSize = _indexFormat == Mesh::INDEX32 ? 4 : (_indexFormat == Mesh::INDEX16 ? 2 : 1);
+    if (_indexBuffer && !_sharedPart)
     {
-        glDeleteBuffers(1, &_indexBuffer);
+        GraphicsMemory::untrack(GraphicsMemory::INDEX_BUFFER, indexSize * _indexCount);
+        GLStateCache::deleteBuffer(_indexBuffer);
+    }
+
+    if (_retainedData)
+    {
+        GraphicsResource::releaseMemory(indexSize * _indexCount);
+        SAFE_DELETE_ARRAY(_retainedData);
     }
 }
 
@@ -23,7 +36,7 @@ MeshPart* MeshPart::create(Mesh* mesh, unsigned int meshIndex, Mesh::PrimitiveTy
     // Create a VBO for our index buffer.
     GLuint vbo;
     GL_ASSERT( glGenBuffers(1, &vbo) );
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo) );
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo);
 
     unsigned int indexSize = 0;
     switch (indexFormat)
@@ -39,11 +52,12 @@ MeshPart* MeshPart::create(Mesh* mesh, unsigned int meshIndex, Mesh::PrimitiveTy
         break;
     default:
         GP_ERROR("Unsupported index format (%d).", indexFormat);
-        glDeleteBuffers(1, &vbo);
+        GLStateCache::deleteBuffer(vbo);
         return NULL;
     }
 
     GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * indexCount, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+    GraphicsMemory::track(GraphicsMemory::INDEX_BUFFER, indexSize * indexCount);
 
     MeshPart* part = new MeshPart();
     part->_mesh = mesh;
@@ -53,6 +67,30 @@ MeshPart* MeshPart::create(Mesh* mesh, unsigned int meshIndex, Mesh::PrimitiveTy
     part->_indexCount = indexCount;
     part->_indexBuffer = vbo;
     part->_dynamic = dynamic;
+    if (Mesh::isPickingDataRetained())
+    {
+        part->_pickIndices.resize(indexCount, 0);
+    }
+
+    return part;
+}
+
+MeshPart* MeshPart::create(Mesh* mesh, unsigned int meshIndex, const MeshPart* sharedPart)
+{
+    GP_ASSERT(sharedPart);
+
+    MeshPart* part = new MeshPart();
+    part->_mesh = mesh;
+    part->_meshIndex = meshIndex;
+    part->_primitiveType = sharedPart->_primitiveType;
+    part->_indexFormat = sharedPart->_indexFormat;
+    part->_indexCount = sharedPart->_indexCount;
+    part->_indexBuffer = sharedPart->_indexBuffer;
+    part->_dynamic = sharedPart->_dynamic;
+    part->_sharedPart = sharedPart;
+
+    // The picking data is copied, so it only follows the index data set before the part was added.
+    part->_pickIndices = sharedPart->_pickIndices;
 
     return part;
 }
@@ -89,7 +127,7 @@ bool MeshPart::isDynamic() const
 
 void MeshPart::setIndexData(const void* indexData, unsigned int indexStart, unsigned int indexCount)
 {
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer) );
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
 
     unsigned int indexSize = 0;
     switch (_indexFormat)
@@ -111,6 +149,7 @@ void MeshPart::setIndexData(const void* indexData, unsigned int indexStart, unsi
     if (indexStart == 0 && indexCount == 0)
     {
         GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * _indexCount, indexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+        Game::countBufferUpload(indexSize * _indexCount);
     }
     else
     {
@@ -120,7 +159,59 @@ void MeshPart::setIndexData(const void* indexData, unsigned int indexStart, unsi
         }
 
         GL_ASSERT( glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexStart * indexSize, indexCount * indexSize, indexData) );
+        Game::countBufferUpload(indexCount * indexSize);
+    }
+
+    // Keep a copy of the indices of static parts that cannot be read from a bundle, to restore them.
+    if (indexData && !_dynamic && !_sharedPart && _mesh->_url.empty() && (_retainedData || GraphicsResource::retainMemory(indexSize * _indexCount)))
+    {
+        if (_retainedData == NULL)
+        {
+            _retainedData = new unsigned char[indexSize * _indexCount];
+            memset(_retainedData, 0, indexSize * _indexCount);
+        }
+        unsigned int count = (indexStart == 0 && indexCount == 0) ? _indexCount : indexCount;
+        memcpy(_retainedData + indexStart * indexSize, indexData, count * indexSize);
     }
+
+    if (!_pickIndices.empty() && indexData)
+    {
+        if (indexStart == 0 && indexCount == 0)
+        {
+            indexCount = _indexCount;
+        }
+        for (unsigned int i = 0; i < indexCount; ++i)
+        {
+            switch (_indexFormat)
+            {
+            case Mesh::INDEX8:
+                _pickIndices[indexStart + i] = ((const unsigned char*)indexData)[i];
+                break;
+            case Mesh::INDEX16:
+                _pickIndices[indexStart + i] = ((const unsigned short*)indexData)[i];
+                break;
+            default:
+                _pickIndices[indexStart + i] = ((const unsigned int*)indexData)[i];
+                break;
+            }
+        }
+        SAFE_DELETE(_mesh->_bvh);
+    }
+}
+
+void MeshPart::restoreIndexBuffer(const void* indexData)
+{
+    if (_sharedPart)
+    {
+        _indexBuffer = _sharedPart->_indexBuffer;
+        return;
+    }
+
+    unsigned int indexSize = _indexFormat == Mesh::INDEX32 ? 4 : (_indexFormat == Mesh::INDEX16 ? 2 : 1);
+    GL_ASSERT( glGenBuffers(1, &_indexBuffer) );
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * _indexCount, indexData ? indexData : _retainedData,
+        _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
 }
 
 }
@@ -14,6 +14,7 @@ class MeshPart
 {
     friend class Mesh;
     friend class Model;
+    friend class MeshBVH;
 
 public:
 
@@ -98,6 +99,21 @@ private:
      */
     static MeshPart* create(Mesh* mesh, unsigned int meshIndex, Mesh::PrimitiveType primitiveType, Mesh::IndexFormat indexFormat, unsigned int indexCount, bool dynamic = false);
 
+    /**
+     * Creates a mesh part for the specified mesh that draws with the index buffer of another part.
+     *
+     * @param mesh The mesh that this is part of.
+     * @param meshIndex The index of the part within the mesh.
+     * @param sharedPart The part whose index buffer is shared.
+     */
+    static MeshPart* create(Mesh* mesh, unsigned int meshIndex, const MeshPart* sharedPart);
+
+    /**
+     * Recreates the index buffer after the GL context was lost, filled with the specified indices
+     * or else the retained ones. Shared parts take the restored buffer of the part they share.
+     */
+    void restoreIndexBuffer(const void* indexData);
+
     Mesh* _mesh;
     unsigned int _meshIndex;
     Mesh::PrimitiveType _primitiveType;
@@ -105,6 +121,9 @@ private:
     unsigned int _indexCount;
     IndexBufferHandle _indexBuffer;
     bool _dynamic;
+    const MeshPart* _sharedPart;
+    std::vector<unsigned int> _pickIndices;
+    unsigned char* _retainedData;
 };
 
 }
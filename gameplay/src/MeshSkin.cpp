@@ -1,23 +1,48 @@
 #include "Base.h"
 #include "MeshSkin.h"
 #include "Joint.h"
+#include "Game.h"
+#include "MathUtil.h"
+#include "GLStateCache.h"
+#include "Effect.h"
+#include "VertexAttributeBinding.h"
+#include "CommandBuffer.h"
+#include "ScratchMemory.h"
 
 // The number of rows in each palette matrix.
 #define PALETTE_ROWS 3
 
+// The number of rows in each palette dual quaternion.
+#define PALETTE_DUAL_QUATERNION_ROWS 2
+
+// The maximum width of the palette texture, in texels.
+#define PALETTE_TEXTURE_MAX_WIDTH 1024
+
+// The shaders skinning the vertices of vertex caches. Nothing is rasterized, so any fragment shader links.
+#define VERTEX_CACHE_VSH "res/shaders/skinning-cache.vert"
+#define VERTEX_CACHE_FSH "res/shaders/depth.frag"
+
 namespace gameplay
 {
 
+// The nodes left to visit by endJointUpdate(), with whether their parent changed.
+static std::vector<std::pair<Node*, bool> > __skeletonStack;
+
 MeshSkin::MeshSkin()
-    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL)
+    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL),
+      _bindMatricesDirty(true), _matrixPaletteDirty(true), _skinningMode(LINEAR),
+      _paletteSampler(NULL), _paletteTextureDirty(true), _jointBoundsDirty(true), _jointBoundsEnabled(false),
+      _jointBoundsPadding(0.0f), _vertexCachingEnabled(false), _updatingJoints(false)
 {
 }
 
 MeshSkin::~MeshSkin()
 {
+    clearVertexCaches();
     clearJoints();
 
     SAFE_DELETE_ARRAY(_matrixPalette);
+    SAFE_RELEASE(_paletteSampler);
 }
 
 const Matrix& MeshSkin::getBindShape() const
@@ -28,6 +53,8 @@ const Matrix& MeshSkin::getBindShape() const
 void MeshSkin::setBindShape(const float* matrix)
 {
     _bindShape.set(matrix);
+    _bindMatricesDirty = true;
+    _matrixPaletteDirty = true;
 }
 
 unsigned int MeshSkin::getJointCount() const
@@ -61,6 +88,10 @@ MeshSkin* MeshSkin::clone(NodeCloneContext &context) const
 {
     MeshSkin* skin = new MeshSkin();
     skin->_bindShape = _bindShape;
+    skin->_skinningMode = _skinningMode;
+    skin->_jointBoundsEnabled = _jointBoundsEnabled;
+    skin->_jointBoundsPadding = _jointBoundsPadding;
+    skin->_vertexCachingEnabled = _vertexCachingEnabled;
     if (_rootNode && _rootJoint)
     {
         const unsigned int jointCount = getJointCount();
@@ -122,6 +153,8 @@ void MeshSkin::setJointCount(unsigned int jointCount)
 
     // Rebuild the matrix palette. Each matrix is 3 rows of Vector4.
     SAFE_DELETE_ARRAY(_matrixPalette);
+    SAFE_RELEASE(_paletteSampler);
+    clearVertexCaches();
 
     if (jointCount > 0)
     {
@@ -133,6 +166,11 @@ void MeshSkin::setJointCount(unsigned int jointCount)
             _matrixPalette[i+2].set(0.0f, 0.0f, 1.0f, 0.0f);
         }
     }
+
+    _jointWorldMatrices.resize(jointCount);
+    _bindMatrices.resize(jointCount);
+    _bindMatricesDirty = true;
+    _matrixPaletteDirty = true;
 }
 
 void MeshSkin::setJoint(Joint* joint, unsigned int index)
@@ -152,23 +190,566 @@ void MeshSkin::setJoint(Joint* joint, unsigned int index)
         joint->addRef();
         joint->addSkin(this);
     }
+
+    _bindMatricesDirty = true;
+    _matrixPaletteDirty = true;
 }
 
 Vector4* MeshSkin::getMatrixPalette() const
 {
     GP_ASSERT(_matrixPalette);
 
-    for (size_t i = 0, count = _joints.size(); i < count; i++)
+    // Pipelined frames draw the palette computed when the scenes were captured, while the joints move for the next frame.
+    if (!Game::isRenderingCaptured() && _matrixPaletteDirty)
     {
-        GP_ASSERT(_joints[i]);
-        _joints[i]->updateJointMatrix(getBindShape(), &_matrixPalette[i * PALETTE_ROWS]);
+        gatherJointMatrices();
+        computeMatrixPalette();
     }
     return _matrixPalette;
 }
 
+void MeshSkin::updateMatrixPalette()
+{
+    if (!Game::isRenderingCaptured() && _matrixPaletteDirty && _matrixPalette)
+    {
+        gatherJointMatrices();
+        computeMatrixPalette();
+    }
+}
+
+void MeshSkin::updateMatrixPalettes(MeshSkin* const* skins, unsigned int count)
+{
+    GP_ASSERT(skins || count == 0);
+
+    // Resolve the joint world matrices here, since the node caches are not safe to update from other threads.
+    ScratchMemory::Scope scratch;
+    ScratchVector<MeshSkin*>::type dirtySkins;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MeshSkin* skin = skins[i];
+        GP_ASSERT(skin);
+        if (skin->_matrixPaletteDirty && skin->_matrixPalette)
+        {
+            skin->gatherJointMatrices();
+            dirtySkins.push_back(skin);
+        }
+    }
+    if (dirtySkins.empty())
+        return;
+
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (dirtySkins.size() > 1 && scheduler && scheduler->getWorkerCount() > 0)
+    {
+        scheduler->parallelFor((unsigned int)dirtySkins.size(), &MeshSkin::computeMatrixPaletteRange, &dirtySkins[0]);
+    }
+    else
+    {
+        computeMatrixPaletteRange(&dirtySkins[0], 0, (unsigned int)dirtySkins.size());
+    }
+}
+
+void MeshSkin::gatherJointMatrices() const
+{
+    for (size_t i = 0, count = _joints.size(); i < count; ++i)
+    {
+        GP_ASSERT(_joints[i]);
+        _jointWorldMatrices[i] = _joints[i]->getWorldMatrix();
+    }
+
+    // The joint bounds come from the same matrices as the palette.
+    if (_jointBoundsEnabled && _jointBoundsDirty && !_joints.empty())
+    {
+        computeJointBounds(&_jointWorldMatrices[0]);
+    }
+
+    if (_bindMatricesDirty)
+    {
+        for (size_t i = 0, count = _joints.size(); i < count; ++i)
+        {
+            Matrix::multiply(_joints[i]->getInverseBindPose(), _bindShape, &_bindMatrices[i]);
+        }
+        _bindMatricesDirty = false;
+    }
+}
+
+void MeshSkin::computeMatrixPalette() const
+{
+    // Each palette entry is the first three rows of (world * inverse bind pose * bind shape).
+    unsigned int jointCount = (unsigned int)_joints.size();
+    if (jointCount > 0)
+    {
+        MathUtil::multiplyMatrix4x3Array(_jointWorldMatrices[0].m, _bindMatrices[0].m, &_matrixPalette[0].x, jointCount);
+    }
+
+    if (_skinningMode == DUAL_QUATERNION)
+    {
+        // Convert each matrix in place. A joint's dual quaternion never overlaps the matrices of the joints after it.
+        Matrix m;
+        Quaternion real;
+        for (unsigned int i = 0; i < jointCount; ++i)
+        {
+            const Vector4* rows = &_matrixPalette[i * PALETTE_ROWS];
+            m.set(rows[0].x, rows[0].y, rows[0].z, rows[0].w,
+                  rows[1].x, rows[1].y, rows[1].z, rows[1].w,
+                  rows[2].x, rows[2].y, rows[2].z, rows[2].w,
+                  0.0f, 0.0f, 0.0f, 1.0f);
+            Vector3 t(rows[0].w, rows[1].w, rows[2].w);
+            m.getRotation(&real);
+
+            // The dual part is half the translation (as a pure quaternion) times the rotation.
+            Vector4* dst = &_matrixPalette[i * PALETTE_DUAL_QUATERNION_ROWS];
+            dst[0].set(real.x, real.y, real.z, real.w);
+            dst[1].set(0.5f * (real.w * t.x + t.y * real.z - t.z * real.y),
+                       0.5f * (real.w * t.y + t.z * real.x - t.x * real.z),
+                       0.5f * (real.w * t.z + t.x * real.y - t.y * real.x),
+                       -0.5f * (t.x * real.x + t.y * real.y + t.z * real.z));
+        }
+    }
+
+    _matrixPaletteDirty = false;
+    _paletteTextureDirty = true;
+    for (size_t i = 0, count = _vertexCaches.size(); i < count; ++i)
+    {
+        _vertexCaches[i]->dirty = true;
+    }
+}
+
+void MeshSkin::computeMatrixPaletteRange(void* arg, unsigned int start, unsigned int end)
+{
+    MeshSkin** skins = (MeshSkin**)arg;
+    GP_ASSERT(skins);
+    for (unsigned int i = start; i < end; ++i)
+    {
+        skins[i]->computeMatrixPalette();
+    }
+}
+
+void MeshSkin::setJointBoundsEnabled(bool enabled)
+{
+    if (_jointBoundsEnabled != enabled)
+    {
+        _jointBoundsEnabled = enabled;
+        _jointBoundsDirty = true;
+        if (_model && _model->getNode())
+        {
+            _model->getNode()->setSpatialBoundsDirty();
+        }
+    }
+}
+
+bool MeshSkin::isJointBoundsEnabled() const
+{
+    return _jointBoundsEnabled;
+}
+
+void MeshSkin::setJointBoundsPadding(float padding)
+{
+    GP_ASSERT(padding >= 0.0f);
+
+    _jointBoundsPadding = padding;
+    setJointBoundsDirty();
+}
+
+float MeshSkin::getJointBoundsPadding() const
+{
+    return _jointBoundsPadding;
+}
+
+const BoundingSphere& MeshSkin::getJointBounds() const
+{
+    if (_jointBoundsDirty)
+    {
+        if (_joints.empty())
+        {
+            _jointBounds.set(Vector3::zero(), _jointBoundsPadding);
+            _jointBoundsDirty = false;
+        }
+        else
+        {
+            for (size_t i = 0, count = _joints.size(); i < count; ++i)
+            {
+                GP_ASSERT(_joints[i]);
+                _jointWorldMatrices[i] = _joints[i]->getWorldMatrix();
+            }
+            computeJointBounds(&_jointWorldMatrices[0]);
+        }
+    }
+    return _jointBounds;
+}
+
+void MeshSkin::setJointBoundsDirty()
+{
+    // The node only needs to hear about the first joint that moves in a frame.
+    if (_jointBoundsDirty)
+        return;
+    _jointBoundsDirty = true;
+
+    if (_jointBoundsEnabled && _model && _model->getNode())
+    {
+        _model->getNode()->setSpatialBoundsDirty();
+    }
+}
+
+void MeshSkin::computeJointBounds(const Matrix* jointWorldMatrices) const
+{
+    GP_ASSERT(jointWorldMatrices);
+
+    // Center the sphere on the box around the joint positions, which is tighter than growing it one joint at a time.
+    unsigned int jointCount = (unsigned int)_joints.size();
+    const float* m = jointWorldMatrices[0].m;
+    Vector3 min(m[12], m[13], m[14]);
+    Vector3 max(min);
+    for (unsigned int i = 1; i < jointCount; ++i)
+    {
+        m = jointWorldMatrices[i].m;
+        min.set(std::min(min.x, m[12]), std::min(min.y, m[13]), std::min(min.z, m[14]));
+        max.set(std::max(max.x, m[12]), std::max(max.y, m[13]), std::max(max.z, m[14]));
+    }
+    Vector3 center((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+    float radiusSquared = 0.0f;
+    for (unsigned int i = 0; i < jointCount; ++i)
+    {
+        m = jointWorldMatrices[i].m;
+        float dx = m[12] - center.x;
+        float dy = m[13] - center.y;
+        float dz = m[14] - center.z;
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+
+    _jointBounds.set(center, sqrtf(radiusSquared) + _jointBoundsPadding);
+    _jointBoundsDirty = false;
+}
+
 unsigned int MeshSkin::getMatrixPaletteSize() const
 {
-    return (unsigned int)_joints.size() * PALETTE_ROWS;
+    return (unsigned int)_joints.size() * (_skinningMode == DUAL_QUATERNION ? PALETTE_DUAL_QUATERNION_ROWS : PALETTE_ROWS);
+}
+
+void MeshSkin::setSkinningMode(SkinningMode mode)
+{
+    if (_skinningMode != mode)
+    {
+        _skinningMode = mode;
+        _matrixPaletteDirty = true;
+        clearVertexCaches();
+    }
+}
+
+MeshSkin::SkinningMode MeshSkin::getSkinningMode() const
+{
+    return _skinningMode;
+}
+
+Texture::Sampler* MeshSkin::getMatrixPaletteSampler() const
+{
+    if (!isMatrixPaletteTextureSupported() || _joints.empty())
+        return NULL;
+
+    getMatrixPalette();
+    if (_paletteSampler == NULL || _paletteTextureDirty)
+    {
+        updatePaletteTexture();
+    }
+    return _paletteSampler;
+}
+
+const Vector2& MeshSkin::getMatrixPaletteTexelSize() const
+{
+    return _paletteTexelSize;
+}
+
+bool MeshSkin::isMatrixPaletteTextureSupported()
+{
+#ifdef USE_PALETTE_TEXTURE
+    static int supported = -1;
+    if (supported < 0)
+    {
+        GLint vertexTextureUnits = 0;
+        GL_ASSERT( glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits) );
+        supported = (GLEW_VERSION_3_0 || GLEW_ARB_texture_float) && vertexTextureUnits > 0 ? 1 : 0;
+    }
+    return supported == 1;
+#else
+    return false;
+#endif
+}
+
+void MeshSkin::updatePaletteTexture() const
+{
+#ifdef USE_PALETTE_TEXTURE
+    // Don't disturb the texture bound by the pass being bound.
+    GLuint boundTexture = GLStateCache::getTexture(GL_TEXTURE_2D);
+
+    // Size the texture for the largest palette so that the skinning mode can change.
+    unsigned int capacity = (unsigned int)_joints.size() * PALETTE_ROWS;
+    unsigned int width = std::min(capacity, (unsigned int)PALETTE_TEXTURE_MAX_WIDTH);
+    unsigned int height = (capacity + width - 1) / width;
+    if (_paletteSampler == NULL)
+    {
+        GLuint handle;
+        GL_ASSERT( glGenTextures(1, &handle) );
+        GLStateCache::bindTexture(GL_TEXTURE_2D, handle);
+        GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL) );
+
+        Texture* texture = Texture::create(handle, width, height);
+        _paletteSampler = Texture::Sampler::create(texture);
+        _paletteSampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+        _paletteSampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+        SAFE_RELEASE(texture);
+        _paletteTexelSize.set(1.0f / width, 1.0f / height);
+    }
+    else
+    {
+        GLStateCache::bindTexture(GL_TEXTURE_2D, _paletteSampler->getTexture()->getHandle());
+    }
+
+    // Upload the full rows of texels followed by the partial last row.
+    unsigned int size = getMatrixPaletteSize();
+    unsigned int rows = size / width;
+    if (rows > 0)
+    {
+        GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, rows, GL_RGBA, GL_FLOAT, _matrixPalette) );
+    }
+    if (size % width)
+    {
+        GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rows, size % width, 1, GL_RGBA, GL_FLOAT, &_matrixPalette[rows * width]) );
+    }
+    Game::countBufferUpload(sizeof(Vector4) * size);
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, boundTexture);
+#endif
+    _paletteTextureDirty = false;
+}
+
+void MeshSkin::setVertexCachingEnabled(bool enabled)
+{
+    if (_vertexCachingEnabled != enabled)
+    {
+        _vertexCachingEnabled = enabled;
+        clearVertexCaches();
+    }
+}
+
+bool MeshSkin::isVertexCachingEnabled() const
+{
+    return _vertexCachingEnabled;
+}
+
+bool MeshSkin::isVertexCachingSupported()
+{
+#ifdef USE_TRANSFORM_FEEDBACK
+    return GLEW_VERSION_3_0 ? true : false;
+#else
+    return false;
+#endif
+}
+
+static const char* getVertexCacheType(unsigned int size)
+{
+    switch (size)
+    {
+    case 1:
+        return "float";
+    case 2:
+        return "vec2";
+    case 3:
+        return "vec3";
+    default:
+        return "vec4";
+    }
+}
+
+MeshSkin::VertexCache* MeshSkin::getVertexCache(Mesh* mesh)
+{
+    GP_ASSERT(mesh);
+
+    for (size_t i = 0, count = _vertexCaches.size(); i < count; ++i)
+    {
+        if (_vertexCaches[i]->source == mesh)
+            return _vertexCaches[i];
+    }
+
+    VertexCache* cache = new VertexCache();
+    cache->source = mesh;
+    cache->source->addRef();
+    cache->mesh = NULL;
+    cache->effect = NULL;
+    cache->sourceBinding = NULL;
+    cache->dirty = true;
+    _vertexCaches.push_back(cache);
+    if (!isVertexCachingSupported())
+        return cache;
+
+    // The skinned vertices keep the elements of the mesh in order, as floats, without the blend weights and indices.
+    // Each element is declared to the shader by its type, and captured by its varying.
+    std::vector<VertexFormat::Element> elements;
+    std::string defines;
+    std::string varyings = "TRANSFORM_FEEDBACK_VARYINGS";
+    unsigned int usages = 0;
+    const VertexFormat& format = mesh->getVertexFormat();
+    for (unsigned int i = 0, count = format.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& e = format.getElement(i);
+        usages |= 1 << e.usage;
+        switch (e.usage)
+        {
+        case VertexFormat::POSITION:
+            elements.push_back(VertexFormat::Element(VertexFormat::POSITION, 3));
+            varyings += " o_position";
+            break;
+        case VertexFormat::NORMAL:
+            elements.push_back(VertexFormat::Element(VertexFormat::NORMAL, 3));
+            varyings += " o_normal";
+            defines += "LIGHTING;";
+            break;
+        case VertexFormat::TANGENT:
+            elements.push_back(VertexFormat::Element(VertexFormat::TANGENT, 3));
+            varyings += " o_tangent";
+            defines += "BUMPED;";
+            break;
+        case VertexFormat::BINORMAL:
+            elements.push_back(VertexFormat::Element(VertexFormat::BINORMAL, 3));
+            varyings += " o_binormal";
+            break;
+        case VertexFormat::BLENDWEIGHTS:
+        case VertexFormat::BLENDINDICES:
+            break;
+        case VertexFormat::COLOR:
+            elements.push_back(VertexFormat::Element(VertexFormat::COLOR, e.size));
+            varyings += " o_color";
+            defines += "COLOR_TYPE ";
+            defines += getVertexCacheType(e.size);
+            defines += ';';
+            break;
+        default:
+            {
+                char name[32];
+                unsigned int index = e.usage - VertexFormat::TEXCOORD0;
+                elements.push_back(VertexFormat::Element(e.usage, e.size));
+                sprintf(name, " o_texCoord%u", index);
+                varyings += name;
+                sprintf(name, "TEXCOORD%u_TYPE ", index);
+                defines += name;
+                defines += getVertexCacheType(e.size);
+                defines += ';';
+            }
+            break;
+        }
+    }
+
+    // The tangent space is skinned as a whole.
+    const unsigned int tangentSpace = (1 << VertexFormat::NORMAL) | (1 << VertexFormat::TANGENT) | (1 << VertexFormat::BINORMAL);
+    const unsigned int required = (1 << VertexFormat::POSITION) | (1 << VertexFormat::BLENDWEIGHTS) | (1 << VertexFormat::BLENDINDICES);
+    unsigned int tangents = usages & ((1 << VertexFormat::TANGENT) | (1 << VertexFormat::BINORMAL));
+    if ((usages & required) != required || (tangents != 0 && (usages & tangentSpace) != tangentSpace))
+    {
+        GP_WARN("The vertices of mesh '%s' can't be cached: their format is not supported.", mesh->getUrl() ? mesh->getUrl() : "");
+        return cache;
+    }
+
+    char palette[48];
+    if (isMatrixPaletteTextureSupported())
+        strcpy(palette, "SKINNING_PALETTE_TEXTURE;");
+    else
+        sprintf(palette, "SKINNING_JOINT_COUNT %u;", (unsigned int)_joints.size());
+    defines += palette;
+    if (_skinningMode == DUAL_QUATERNION)
+        defines += "SKINNING_DUAL_QUATERNION;";
+    defines += varyings;
+
+    cache->effect = Effect::createFromFile(VERTEX_CACHE_VSH, VERTEX_CACHE_FSH, defines.c_str());
+    if (cache->effect == NULL)
+        return cache;
+    cache->mesh = Mesh::createMesh(VertexFormat(&elements[0], (unsigned int)elements.size()), mesh->getVertexCount(), true);
+    cache->sourceBinding = VertexAttributeBinding::create(mesh, cache->effect);
+    return cache;
+}
+
+bool MeshSkin::updateVertexCache(Mesh* mesh)
+{
+    VertexCache* cache = getVertexCache(mesh);
+    if (cache->mesh == NULL || _joints.empty())
+        return false;
+
+    // Joints that moved mark the caches dirty when the palette is computed.
+    getMatrixPalette();
+    if (!cache->dirty || CommandBuffer::getRecording())
+        return true;
+
+#ifdef USE_TRANSFORM_FEEDBACK
+    Effect* effect = cache->effect;
+    effect->bind();
+    if (isMatrixPaletteTextureSupported())
+    {
+        Uniform* uniform = effect->getUniform("u_matrixPaletteTexture");
+        if (uniform)
+            effect->setValue(uniform, getMatrixPaletteSampler());
+        uniform = effect->getUniform("u_matrixPaletteTexelSize");
+        if (uniform)
+            effect->setValue(uniform, _paletteTexelSize);
+    }
+    else
+    {
+        Uniform* uniform = effect->getUniform("u_matrixPalette");
+        if (uniform)
+            effect->setValue(uniform, _matrixPalette, getMatrixPaletteSize());
+    }
+
+    // Each vertex is a point, skinned into the cache in the order of the source vertices.
+    cache->sourceBinding->bind();
+    GL_ASSERT( glEnable(GL_RASTERIZER_DISCARD) );
+    GL_ASSERT( glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, cache->mesh->getVertexBuffer()) );
+    GL_ASSERT( glBeginTransformFeedback(GL_POINTS) );
+    GL_ASSERT( glDrawArrays(GL_POINTS, 0, mesh->getVertexCount()) );
+    GL_ASSERT( glEndTransformFeedback() );
+    GL_ASSERT( glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0) );
+    GL_ASSERT( glDisable(GL_RASTERIZER_DISCARD) );
+    cache->sourceBinding->unbind();
+#endif
+    cache->dirty = false;
+    return true;
+}
+
+VertexAttributeBinding* MeshSkin::getVertexCacheBinding(Mesh* mesh, Effect* effect)
+{
+    GP_ASSERT(effect);
+
+    for (size_t i = 0, count = _vertexCaches.size(); i < count; ++i)
+    {
+        VertexCache* cache = _vertexCaches[i];
+        if (cache->source != mesh)
+            continue;
+        if (cache->mesh == NULL)
+            return NULL;
+
+        // The passes of the model are bound to the cache the first time each effect draws it.
+        std::map<Effect*, VertexAttributeBinding*>::iterator itr = cache->bindings.find(effect);
+        if (itr != cache->bindings.end())
+            return itr->second;
+        VertexAttributeBinding* binding = VertexAttributeBinding::create(cache->mesh, effect);
+        cache->bindings[effect] = binding;
+        return binding;
+    }
+    return NULL;
+}
+
+void MeshSkin::clearVertexCaches()
+{
+    for (size_t i = 0, count = _vertexCaches.size(); i < count; ++i)
+    {
+        VertexCache* cache = _vertexCaches[i];
+        for (std::map<Effect*, VertexAttributeBinding*>::iterator itr = cache->bindings.begin(); itr != cache->bindings.end(); ++itr)
+        {
+            SAFE_RELEASE(itr->second);
+        }
+        SAFE_RELEASE(cache->sourceBinding);
+        SAFE_RELEASE(cache->effect);
+        SAFE_RELEASE(cache->mesh);
+        SAFE_RELEASE(cache->source);
+        SAFE_DELETE(cache);
+    }
+    _vertexCaches.clear();
 }
 
 Model* MeshSkin::getModel() const
@@ -215,6 +796,65 @@ void MeshSkin::setRootJoint(Joint* joint)
     setRootNode(newRootNode);
 }
 
+void MeshSkin::beginJointUpdate()
+{
+    GP_ASSERT(!_updatingJoints);
+    _updatingJoints = true;
+}
+
+void MeshSkin::endJointUpdate()
+{
+    GP_ASSERT(_updatingJoints);
+    _updatingJoints = false;
+
+    // Walk the skeleton from the root joint, parents before children, with whether an ancestor changed.
+    if (_rootJoint)
+    {
+        __skeletonStack.push_back(std::make_pair((Node*)_rootJoint, false));
+    }
+    while (!__skeletonStack.empty())
+    {
+        Node* node = __skeletonStack.back().first;
+        bool parentChanged = __skeletonStack.back().second;
+        __skeletonStack.pop_back();
+
+        if (node->getType() != Node::JOINT)
+        {
+            // The node and everything attached below it hear about the change once.
+            if (parentChanged)
+                node->transformChanged();
+            continue;
+        }
+
+        Joint* joint = static_cast<Joint*>(node);
+        bool changed = parentChanged || joint->_skeletonChanged;
+        if (changed)
+        {
+            joint->skeletonChanged();
+        }
+        for (Node* child = joint->getFirstChild(); child != NULL; child = child->getNextSibling())
+        {
+            __skeletonStack.push_back(std::make_pair(child, changed));
+        }
+    }
+
+    // Joints outside of the hierarchy of the root joint are notified as if they were not batched.
+    for (size_t i = 0, count = _joints.size(); i < count; ++i)
+    {
+        Joint* joint = _joints[i];
+        if (joint && joint->_skeletonChanged)
+        {
+            joint->_skeletonChanged = false;
+            joint->transformChanged();
+        }
+    }
+}
+
+bool MeshSkin::isUpdatingJoints() const
+{
+    return _updatingJoints;
+}
+
 void MeshSkin::transformChanged(Transform* transform, long cookie)
 {
     switch (cookie)
@@ -3,6 +3,9 @@
 
 #include "Matrix.h"
 #include "Transform.h"
+#include "Texture.h"
+#include "Vector2.h"
+#include "BoundingSphere.h"
 
 namespace gameplay
 {
@@ -11,6 +14,9 @@ class Bundle;
 class Model;
 class Joint;
 class Node;
+class Mesh;
+class Effect;
+class VertexAttributeBinding;
 
 /**
  * Defines the skin for a mesh.
@@ -19,6 +25,22 @@ class Node;
  * vertex blending. This allows for a Model's mesh to support
  * a skeleton on joints that will influence the vertex position
  * and which the joints can be animated.
+ *
+ * The joint transforms are passed to the vertex shader as a palette of Vector4 rows,
+ * either as a uniform array (the MATRIX_PALETTE auto binding) or, on OpenGL 3 and
+ * later, as a floating point texture (the MATRIX_PALETTE_TEXTURE and
+ * MATRIX_PALETTE_TEXEL_SIZE auto bindings with the SKINNING_PALETTE_TEXTURE shader
+ * define), which is not limited by the uniform budget of the vertex shader.
+ *
+ * By default the bounds of a skinned model are those of its mesh in the bind pose, which
+ * an animation can move the vertices out of. With joint bounds enabled, the bounds instead
+ * enclose the world positions of the joints, padded by a distance that covers the vertices
+ * around them, and follow the skeleton every frame for culling, shadows and levels of detail.
+ *
+ * A model drawn by several passes (such as its shadow, depth pre-pass and reflection passes)
+ * is skinned again by the vertex shader of each one. On OpenGL 3 and later, vertex caching
+ * instead skins the vertices once into a vertex buffer by transform feedback, whenever the
+ * joints have moved, and all the passes draw the skinned vertices as a static mesh.
  */
 class MeshSkin : public Transform::Listener
 {
@@ -30,6 +52,26 @@ class MeshSkin : public Transform::Listener
 
 public:
 
+    /**
+     * Defines how the joint transforms are stored in the palette.
+     */
+    enum SkinningMode
+    {
+        /**
+         * Each joint is a 4x3 matrix stored as 3 rows. Vertices are blended linearly.
+         */
+        LINEAR,
+
+        /**
+         * Each joint is a unit dual quaternion stored as 2 rows: the rotation followed by
+         * the translation. Blending dual quaternions avoids the volume loss of linear
+         * blending at twisted joints, but any scale in the joint transforms is ignored.
+         *
+         * The materials of the model must use the SKINNING_DUAL_QUATERNION shader define.
+         */
+        DUAL_QUATERNION
+    };
+
     /**
      * Returns the bind shape matrix.
      * 
@@ -90,22 +132,199 @@ public:
      */
     int getJointIndex(Joint* joint) const;
 
+    /**
+     * Starts a batch of changes to the transforms of the joints of this skin.
+     *
+     * Changing the transform of a joint normally notifies every joint and attached node below it
+     * (and their listeners) at once, so posing a skeleton joint by joint, for instance from inverse
+     * kinematics or a ragdoll, notifies a weapon held in a hand once for each joint up the arm.
+     * Until endJointUpdate() is called, a change to a joint of this skin is only recorded instead.
+     *
+     * The world matrices of the joints below a changed joint, and of the nodes attached to them,
+     * are out of date until endJointUpdate() is called. Animations already defer the notifications
+     * of the transforms they change to the end of the update of the animation controller, so
+     * they do not need a batch.
+     *
+     * @script{ignore}
+     */
+    void beginJointUpdate();
+
+    /**
+     * Ends a batch of changes to the transforms of the joints of this skin.
+     *
+     * The world matrices of the changed joints and of the joints below them are computed in one
+     * pass from the root joint, parents first. Each of these joints then notifies its listeners
+     * once, each node attached below them is notified once, and the matrix palette is marked
+     * dirty once.
+     *
+     * @script{ignore}
+     */
+    void endJointUpdate();
+
+    /**
+     * Determines if a batch of changes to the transforms of the joints of this skin is started.
+     *
+     * @return true if between beginJointUpdate() and endJointUpdate().
+     *
+     * @script{ignore}
+     */
+    bool isUpdatingJoints() const;
+
     /**
      * Returns the pointer to the Vector4 array for the purpose of binding to a shader.
+     *
+     * The palette is updated first if any of the joints have changed since it was last updated.
      * 
      * @return The pointer to the matrix palette.
      */
     Vector4* getMatrixPalette() const;
 
+    /**
+     * Updates the matrix palette from the current joint transforms, if any of them have changed
+     * since the palette was last updated.
+     *
+     * The whole palette is computed in one pass over contiguous arrays of joint matrices.
+     */
+    void updateMatrixPalette();
+
+    /**
+     * Updates the matrix palettes of several skins, splitting the work across the job worker threads.
+     *
+     * The joint world matrices are resolved on the calling thread, and the palettes of the skins
+     * whose joints have changed are then computed as a job per skin. The scenes call this once
+     * per frame for the skins of their models after resolving their world matrices.
+     *
+     * @param skins The skins to update.
+     * @param count The number of skins.
+     *
+     * @script{ignore}
+     */
+    static void updateMatrixPalettes(MeshSkin* const* skins, unsigned int count);
+
     /**
      * Returns the number of elements in the matrix palette array.
      * Each element is a Vector4* that represents a row.
-     * Each matrix palette is represented by 3 rows of Vector4.
+     * Each joint is represented by 3 rows of Vector4 in LINEAR mode,
+     * or by 2 rows in DUAL_QUATERNION mode.
      * 
      * @return The matrix palette size.
      */
     unsigned int getMatrixPaletteSize() const;
 
+    /**
+     * Sets how the joint transforms are stored in the palette. The default is LINEAR.
+     *
+     * @param mode The skinning mode.
+     */
+    void setSkinningMode(SkinningMode mode);
+
+    /**
+     * Returns how the joint transforms are stored in the palette.
+     *
+     * @return The skinning mode.
+     */
+    SkinningMode getSkinningMode() const;
+
+    /**
+     * Returns a sampler for a floating point texture holding the matrix palette,
+     * for the purpose of binding to a shader.
+     *
+     * The texture is created the first time it is requested, and the palette is
+     * uploaded to it whenever it has changed. This must be called on the game thread.
+     *
+     * @return The palette texture sampler, or NULL if palette textures are not supported.
+     */
+    Texture::Sampler* getMatrixPaletteSampler() const;
+
+    /**
+     * Returns the size of a texel in the texture returned by getMatrixPaletteSampler(),
+     * in texture coordinates.
+     *
+     * @return The palette texel size.
+     */
+    const Vector2& getMatrixPaletteTexelSize() const;
+
+    /**
+     * Determines if matrix palette textures are supported by the graphics driver.
+     *
+     * This requires OpenGL 3 (or floating point textures) and texture sampling in vertex shaders.
+     *
+     * @return true if palette textures are supported, false otherwise.
+     */
+    static bool isMatrixPaletteTextureSupported();
+
+    /**
+     * Sets whether the bounds of the model follow the joints of the skin.
+     *
+     * @param enabled true to bound the model by its joints, false to use the bounds
+     *      of its mesh in the bind pose (the default).
+     */
+    void setJointBoundsEnabled(bool enabled);
+
+    /**
+     * Determines if the bounds of the model follow the joints of the skin.
+     *
+     * @return true if the model is bounded by its joints.
+     */
+    bool isJointBoundsEnabled() const;
+
+    /**
+     * Sets the distance the joint bounds are padded by.
+     *
+     * The padding should be the largest distance from a vertex to the nearest joint,
+     * such as the thickness of a limb, so that the joint bounds contain the whole mesh.
+     *
+     * @param padding The padding, in world units.
+     */
+    void setJointBoundsPadding(float padding);
+
+    /**
+     * Returns the distance the joint bounds are padded by.
+     *
+     * @return The padding, in world units.
+     */
+    float getJointBoundsPadding() const;
+
+    /**
+     * Returns the world-space sphere enclosing the joints of the skin, padded by the joint bounds padding.
+     *
+     * The sphere is computed whenever a joint has moved, from the same joint matrices as the palette.
+     *
+     * @return The world-space bounds of the joints.
+     */
+    const BoundingSphere& getJointBounds() const;
+
+    /**
+     * Sets whether the skinned vertices are cached in a vertex buffer.
+     *
+     * While vertex caching is enabled, the materials of the model must not use the SKINNING
+     * shader define, since the vertices they draw are already skinned. The vertices of each
+     * level of detail of the model are cached separately. Meshes with tangents must also have
+     * normals and binormals to be cached, and are otherwise skinned by each pass.
+     *
+     * Draws recorded by a CommandBuffer do not skin the vertices again and read the vertices
+     * skinned by the last draw outside of it.
+     *
+     * @param enabled true to cache the skinned vertices, false to skin them in every pass (the default).
+     *
+     * @see isVertexCachingSupported
+     */
+    void setVertexCachingEnabled(bool enabled);
+
+    /**
+     * Determines if the skinned vertices are cached in a vertex buffer.
+     *
+     * @return true if vertex caching is enabled.
+     */
+    bool isVertexCachingEnabled() const;
+
+    /**
+     * Determines if transform feedback, which vertex caching requires, is supported by the graphics driver.
+     *
+     * @return true if vertex caching is supported, false otherwise.
+     */
+    static bool isVertexCachingSupported();
+
     /**
      * Returns our parent Model.
      */
@@ -118,6 +337,19 @@ public:
 
 private:
 
+    /**
+     * The skinned vertices of a mesh, captured by transform feedback.
+     */
+    struct VertexCache
+    {
+        Mesh* source;
+        Mesh* mesh;
+        Effect* effect;
+        VertexAttributeBinding* sourceBinding;
+        std::map<Effect*, VertexAttributeBinding*> bindings;
+        bool dirty;
+    };
+
     /**
      * Constructor.
      */
@@ -175,6 +407,56 @@ private:
      */
     void clearJoints();
 
+    /**
+     * Copies the world matrix of each joint into a contiguous array, and recomputes the
+     * bind matrices if the bind shape or any inverse bind pose has changed.
+     */
+    void gatherJointMatrices() const;
+
+    /**
+     * Computes the matrix palette from the gathered joint matrices.
+     */
+    void computeMatrixPalette() const;
+
+    /**
+     * Creates the palette texture if needed and uploads the palette to it.
+     */
+    void updatePaletteTexture() const;
+
+    static void computeMatrixPaletteRange(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Marks the joint bounds dirty after a joint has moved, and the bounds of the model's node with them.
+     */
+    void setJointBoundsDirty();
+
+    /**
+     * Computes the joint bounds from the world matrices of the joints.
+     */
+    void computeJointBounds(const Matrix* jointWorldMatrices) const;
+
+    /**
+     * Returns the vertex cache of a mesh, creating it the first time. The cache has no mesh if the vertices can't be cached.
+     */
+    VertexCache* getVertexCache(Mesh* mesh);
+
+    /**
+     * Skins the vertices of a mesh into its vertex cache if the joints have moved since they were last skinned.
+     *
+     * @return true if the mesh is drawn from its vertex cache.
+     */
+    bool updateVertexCache(Mesh* mesh);
+
+    /**
+     * Returns the binding of the vertex cache of a mesh to an effect, or NULL if the mesh has no vertex cache.
+     */
+    VertexAttributeBinding* getVertexCacheBinding(Mesh* mesh, Effect* effect);
+
+    /**
+     * Releases the vertex caches, which are created again when the model is next drawn.
+     */
+    void clearVertexCaches();
+
     Matrix _bindShape;
     std::vector<Joint*> _joints;
     Joint* _rootJoint;
@@ -190,6 +472,33 @@ private:
     // The number of Vector4's is (_joints.size() * 3).
     Vector4* _matrixPalette;
     Model* _model;
+
+    // The world matrix of each joint, gathered before computing the palette.
+    mutable std::vector<Matrix> _jointWorldMatrices;
+
+    // The inverse bind pose of each joint multiplied by the bind shape.
+    mutable std::vector<Matrix> _bindMatrices;
+    mutable bool _bindMatricesDirty;
+    mutable bool _matrixPaletteDirty;
+    SkinningMode _skinningMode;
+
+    // The floating point texture holding the palette, created on demand.
+    mutable Texture::Sampler* _paletteSampler;
+    mutable Vector2 _paletteTexelSize;
+    mutable bool _paletteTextureDirty;
+
+    // The world-space bounds of the joints.
+    mutable BoundingSphere _jointBounds;
+    mutable bool _jointBoundsDirty;
+    bool _jointBoundsEnabled;
+    float _jointBoundsPadding;
+
+    // The skinned vertices of the meshes of the model, for vertex caching.
+    std::vector<VertexCache*> _vertexCaches;
+    bool _vertexCachingEnabled;
+
+    // Whether the changes to the joints are batched until endJointUpdate().
+    bool _updatingJoints;
 };
 
 }
@@ -5,12 +5,22 @@
 #include "Technique.h"
 #include "Pass.h"
 #include "Node.h"
+#include "Game.h"
+#include "CommandBuffer.h"
+#include "Profiler.h"
+#include "MemoryPool.h"
+#include "GLStateCache.h"
+
+// Default fraction of a LOD's screen size that a model must grow past before switching back to a finer LOD.
+#define LOD_HYSTERESIS 0.1f
 
 namespace gameplay
 {
 
+static float __lodHysteresis = LOD_HYSTERESIS;
+
 Model::Model(Mesh* mesh) :
-    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _node(NULL), _skin(NULL)
+    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _node(NULL), _skin(NULL), _lod(0), _sharedMaterials(false)
 {
     GP_ASSERT(mesh);
     _partCount = mesh->getPartCount();
@@ -29,6 +39,16 @@ Model::~Model()
         SAFE_DELETE_ARRAY(_partMaterials);
     }
 
+    for (size_t i = 0, count = _lods.size(); i < count; ++i)
+    {
+        Lod& lod = _lods[i];
+        for (std::map<Effect*, VertexAttributeBinding*>::iterator itr = lod.bindings.begin(); itr != lod.bindings.end(); ++itr)
+        {
+            SAFE_RELEASE(itr->second);
+        }
+        SAFE_RELEASE(lod.mesh);
+    }
+
     SAFE_RELEASE(_mesh);
 
     SAFE_DELETE(_skin);
@@ -41,6 +61,18 @@ Model* Model::create(Mesh* mesh)
     return new Model(mesh);
 }
 
+#ifndef GP_USE_MEM_LEAK_DETECTION
+void* Model::operator new(size_t size)
+{
+    return MemoryPool::allocate(size);
+}
+
+void Model::operator delete(void* pointer)
+{
+    MemoryPool::deallocate(pointer);
+}
+#endif
+
 Mesh* Model::getMesh() const
 {
     return _mesh;
@@ -79,6 +111,25 @@ Material* Model::getMaterial(int partIndex)
     return m;
 }
 
+Material* Model::getUniqueMaterial(int partIndex)
+{
+    Material* material = getMaterial(partIndex);
+    if (material == NULL || !_sharedMaterials || material->getRefCount() == 1)
+        return material;
+
+    // Copy the shared material on first write.
+    NodeCloneContext context;
+    Material* materialClone = material->clone(context);
+    if (!materialClone)
+    {
+        GP_ERROR("Failed to clone shared material for model.");
+        return material;
+    }
+    setMaterial(materialClone, partIndex);
+    materialClone->release();
+    return materialClone;
+}
+
 void Model::setMaterial(Material* material, int partIndex)
 {
     GP_ASSERT(partIndex == -1 || (partIndex >= 0 && partIndex < (int)getMeshPartCount()));
@@ -234,6 +285,25 @@ Node* Model::getNode() const
 
 void Model::setNode(Node* node)
 {
+    // Don't leave the shared materials bound to a node that may be deleted.
+    if (_sharedMaterials && _node && _node != node)
+    {
+        if (_material)
+        {
+            unbindSharedMaterial(_material, _node);
+        }
+        if (_partMaterials)
+        {
+            for (unsigned int i = 0; i < _partCount; ++i)
+            {
+                if (_partMaterials[i])
+                {
+                    unbindSharedMaterial(_partMaterials[i], _node);
+                }
+            }
+        }
+    }
+
     _node = node;
 
     // Re-bind node related material parameters
@@ -256,13 +326,108 @@ void Model::setNode(Node* node)
     }
 }
 
-static bool drawWireframe(Mesh* mesh)
+void Model::addLod(Mesh* mesh, float screenSize)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(_mesh);
+
+    if (mesh->getPartCount() != _mesh->getPartCount())
+    {
+        GP_WARN("LOD mesh '%s' has %d mesh parts but the model's mesh has %d; ignoring it.", mesh->getUrl(), mesh->getPartCount(), _mesh->getPartCount());
+        return;
+    }
+
+    Lod lod;
+    lod.mesh = mesh;
+    lod.screenSize = screenSize;
+    mesh->addRef();
+
+    // Keep the LODs ordered from the finest to the coarsest.
+    std::vector<Lod>::iterator itr = _lods.begin();
+    while (itr != _lods.end() && itr->screenSize >= screenSize)
+        ++itr;
+    _lods.insert(itr, lod);
+    _lod = 0;
+}
+
+unsigned int Model::getLodCount() const
+{
+    return (unsigned int)_lods.size() + 1;
+}
+
+Mesh* Model::getLodMesh(unsigned int index) const
+{
+    GP_ASSERT(index <= _lods.size());
+    return index == 0 ? _mesh : _lods[index - 1].mesh;
+}
+
+float Model::getLodScreenSize(unsigned int index) const
+{
+    GP_ASSERT(index <= _lods.size());
+    return index == 0 ? 0.0f : _lods[index - 1].screenSize;
+}
+
+unsigned int Model::getLod() const
+{
+    return _lod;
+}
+
+void Model::setLodHysteresis(float hysteresis)
+{
+    __lodHysteresis = std::max(0.0f, hysteresis);
+}
+
+void Model::updateLod()
 {
-    switch (mesh->getPrimitiveType())
+    if (_lods.empty())
+        return;
+
+    // Models whose size can't be estimated (or that surround the camera) use the full detail mesh.
+    float size = getScreenSize();
+    if (size <= 0.0f)
+    {
+        _lod = 0;
+        return;
+    }
+
+    // Switch to coarser LODs as soon as the model is smaller than their screen size, but only
+    // switch back once it is larger by the hysteresis margin.
+    unsigned int lod = _lod;
+    while (lod < _lods.size() && size < _lods[lod].screenSize)
+        ++lod;
+    while (lod > 0 && size > _lods[lod - 1].screenSize * (1.0f + __lodHysteresis))
+        --lod;
+    _lod = lod;
+}
+
+Mesh* Model::getDrawMesh() const
+{
+    return _lod == 0 ? _mesh : _lods[_lod - 1].mesh;
+}
+
+VertexAttributeBinding* Model::getLodBinding(Pass* pass)
+{
+    GP_ASSERT(pass);
+    if (_lod == 0)
+        return pass->getVertexAttributeBinding();
+
+    // Bindings of the LOD meshes are created the first time each effect draws them.
+    Lod& lod = _lods[_lod - 1];
+    std::map<Effect*, VertexAttributeBinding*>::iterator itr = lod.bindings.find(pass->getEffect());
+    if (itr != lod.bindings.end())
+        return itr->second;
+
+    VertexAttributeBinding* binding = VertexAttributeBinding::create(lod.mesh, pass->getEffect());
+    lod.bindings[pass->getEffect()] = binding;
+    return binding;
+}
+
+bool Model::drawWireframe(GLenum primitiveType, unsigned int vertexCount)
+{
+    switch (primitiveType)
     {
     case Mesh::TRIANGLES:
         {
-            unsigned int vertexCount = mesh->getVertexCount();
             for (unsigned int i = 0; i < vertexCount; i += 3)
             {
                 GL_ASSERT( glDrawArrays(GL_LINE_LOOP, i, 3) );
@@ -272,7 +437,6 @@ static bool drawWireframe(Mesh* mesh)
 
     case Mesh::TRIANGLE_STRIP:
         {
-            unsigned int vertexCount = mesh->getVertexCount();
             for (unsigned int i = 2; i < vertexCount; ++i)
             {
                 GL_ASSERT( glDrawArrays(GL_LINE_LOOP, i-2, 3) );
@@ -286,11 +450,10 @@ static bool drawWireframe(Mesh* mesh)
     }
 }
 
-static bool drawWireframe(MeshPart* part)
+bool Model::drawWireframe(GLenum primitiveType, unsigned int indexCount, GLenum indexFormat)
 {
-    unsigned int indexCount = part->getIndexCount();
     unsigned int indexSize = 0;
-    switch (part->getIndexFormat())
+    switch (indexFormat)
     {
     case Mesh::INDEX8:
         indexSize = 1;
@@ -302,17 +465,17 @@ static bool drawWireframe(MeshPart* part)
         indexSize = 4;
         break;
     default:
-        GP_ERROR("Unsupported index format (%d).", part->getIndexFormat());
+        GP_ERROR("Unsupported index format (%d).", indexFormat);
         return false;
     }
 
-    switch (part->getPrimitiveType())
+    switch (primitiveType)
     {
     case Mesh::TRIANGLES:
         {
             for (size_t i = 0; i < indexCount; i += 3)
             {
-                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), ((const GLvoid*)(i*indexSize))) );
+                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, indexFormat, ((const GLvoid*)(i*indexSize))) );
             }
         }
         return true;
@@ -321,7 +484,7 @@ static bool drawWireframe(MeshPart* part)
         {
             for (size_t i = 2; i < indexCount; ++i)
             {
-                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), ((const GLvoid*)((i-2)*indexSize))) );
+                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, indexFormat, ((const GLvoid*)((i-2)*indexSize))) );
             }
         }
         return true;
@@ -335,8 +498,18 @@ static bool drawWireframe(MeshPart* part)
 unsigned int Model::draw(bool wireframe)
 {
     GP_ASSERT(_mesh);
+    GP_PROFILE_SCOPE("Model::draw");
 
-    unsigned int partCount = _mesh->getPartCount();
+    updateLod();
+    Mesh* mesh = getDrawMesh();
+    mesh->loadDeferredData();
+
+    // Cached skins are skinned once here for all the passes, and only when their joints have moved.
+    if (_skin && _skin->_vertexCachingEnabled)
+    {
+        _skin->updateVertexCache(mesh);
+    }
+    unsigned int partCount = mesh->getPartCount();
     if (partCount == 0)
     {
         // No mesh parts (index buffers).
@@ -347,15 +520,7 @@ unsigned int Model::draw(bool wireframe)
             unsigned int passCount = technique->getPassCount();
             for (unsigned int i = 0; i < passCount; ++i)
             {
-                Pass* pass = technique->getPassByIndex(i);
-                GP_ASSERT(pass);
-                pass->bind();
-                GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0) );
-                if (!wireframe || !drawWireframe(_mesh))
-                {
-                    GL_ASSERT( glDrawArrays(_mesh->getPrimitiveType(), 0, _mesh->getVertexCount()) );
-                }
-                pass->unbind();
+                drawPass(technique->getPassByIndex(i), NULL, wireframe);
             }
         }
     }
@@ -363,7 +528,7 @@ unsigned int Model::draw(bool wireframe)
     {
         for (unsigned int i = 0; i < partCount; ++i)
         {
-            MeshPart* part = _mesh->getPart(i);
+            MeshPart* part = mesh->getPart(i);
             GP_ASSERT(part);
 
             // Get the material for this mesh part.
@@ -375,15 +540,7 @@ unsigned int Model::draw(bool wireframe)
                 unsigned int passCount = technique->getPassCount();
                 for (unsigned int j = 0; j < passCount; ++j)
                 {
-                    Pass* pass = technique->getPassByIndex(j);
-                    GP_ASSERT(pass);
-                    pass->bind();
-                    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->_indexBuffer) );
-                    if (!wireframe || !drawWireframe(part))
-                    {
-                        GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
-                    }
-                    pass->unbind();
+                    drawPass(technique->getPassByIndex(j), part, wireframe);
                 }
             }
         }
@@ -391,16 +548,150 @@ unsigned int Model::draw(bool wireframe)
     return partCount;
 }
 
+void Model::drawPass(Pass* pass, MeshPart* part, bool wireframe)
+{
+    GP_ASSERT(pass);
+
+    // Let streamed textures know how large they are drawn.
+    if (Texture::getStreamingBudget() > 0)
+    {
+        Texture::setStreamingScreenSize(getScreenSize());
+    }
+
+    if (_sharedMaterials && _node)
+    {
+        pass->retargetNodeBinding(_node);
+    }
+
+    VertexAttributeBinding* binding = NULL;
+    if (_skin && _skin->_vertexCachingEnabled)
+    {
+        binding = _skin->getVertexCacheBinding(getDrawMesh(), pass->getEffect());
+    }
+    if (binding == NULL)
+    {
+        binding = getLodBinding(pass);
+    }
+    pass->bind(binding);
+    Texture::setStreamingScreenSize(0.0f);
+
+    // Instanced effects read the world matrix from a vertex attribute.
+    VertexAttribute instanceAttribute = pass->getEffect()->getInstanceMatrixAttribute();
+    if (instanceAttribute != -1)
+    {
+        setInstanceMatrix(instanceAttribute, _node ? _node->getWorldMatrix() : Matrix::identity());
+    }
+
+    drawGeometry(part, wireframe);
+    pass->unbind(binding);
+}
+
+void Model::drawGeometry(MeshPart* part, bool wireframe)
+{
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        if (part)
+            buffer->drawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), part->_indexBuffer, wireframe);
+        else
+            buffer->drawArrays(getDrawMesh()->getPrimitiveType(), getDrawMesh()->getVertexCount(), wireframe);
+        return;
+    }
+
+    if (part)
+    {
+        Game::countDrawCall(part->getPrimitiveType(), part->getIndexCount());
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->_indexBuffer);
+        if (!wireframe || !drawWireframe(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat()))
+        {
+            GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
+        }
+    }
+    else
+    {
+        Mesh* mesh = getDrawMesh();
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        Game::countDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount());
+        if (!wireframe || !drawWireframe(mesh->getPrimitiveType(), mesh->getVertexCount()))
+        {
+            GL_ASSERT( glDrawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount()) );
+        }
+    }
+}
+
+float Model::getScreenSize() const
+{
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    Node* cameraNode = camera ? camera->getNode() : NULL;
+    if (cameraNode == NULL)
+        return 0.0f;
+
+    const BoundingSphere& sphere = _node->getBoundingSphere();
+    float viewportHeight = Game::getInstance()->getViewport().height;
+    if (camera->getCameraType() == Camera::ORTHOGRAPHIC)
+    {
+        return camera->getZoomY() > 0.0f ? sphere.radius * 2.0f * viewportHeight / camera->getZoomY() : 0.0f;
+    }
+
+    // Models surrounding the camera need their full resolution.
+    float distance = sphere.center.distance(cameraNode->getTranslationWorld());
+    if (distance <= sphere.radius)
+        return 0.0f;
+    return sphere.radius * viewportHeight / (distance * tan(MATH_DEG_TO_RAD(camera->getFieldOfView()) * 0.5f));
+}
+
+void Model::setInstanceMatrix(VertexAttribute attribute, const Matrix& matrix)
+{
+    // Specify the matrix columns as constant attribute values (no array is enabled).
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (buffer)
+            buffer->setVertexAttribute(attribute + i, &matrix.m[i * 4]);
+        else
+            GL_ASSERT( glVertexAttrib4fv(attribute + i, &matrix.m[i * 4]) );
+    }
+}
+
 void Model::setMaterialNodeBinding(Material *material)
 {
     GP_ASSERT(material);
 
     if (_node)
     {
+        // Shared materials are pointed at the node being drawn instead, once their auto-bindings are resolved.
+        if (_sharedMaterials && material->_nodeBinding)
+            return;
+
         material->setNodeBinding(_node);
     }
 }
 
+void Model::unbindSharedMaterial(Material* material, Node* node)
+{
+    GP_ASSERT(material);
+
+    for (unsigned int i = 0, techniqueCount = material->getTechniqueCount(); i < techniqueCount; ++i)
+    {
+        Technique* technique = material->getTechniqueByIndex(i);
+        GP_ASSERT(technique);
+        for (unsigned int j = 0, passCount = technique->getPassCount(); j < passCount; ++j)
+        {
+            Pass* pass = technique->getPassByIndex(j);
+            GP_ASSERT(pass);
+            if (pass->_nodeBinding == node)
+            {
+                pass->retargetNodeBinding(NULL);
+            }
+        }
+    }
+    if (material->_nodeBinding == node)
+    {
+        material->retargetNodeBinding(NULL);
+    }
+}
+
 Model* Model::clone(NodeCloneContext &context)
 {
     Model* model = Model::create(getMesh());
@@ -410,10 +701,37 @@ Model* Model::clone(NodeCloneContext &context)
         return NULL;
     }
 
+    for (size_t i = 0, count = _lods.size(); i < count; ++i)
+    {
+        model->addLod(_lods[i].mesh, _lods[i].screenSize);
+    }
     if (getSkin())
     {
         model->setSkin(getSkin()->clone(context));
     }
+
+    // Instances share the materials, unless custom resolvers may have bound them to this node.
+    if (context.isInstancing() && RenderState::_customAutoBindingResolvers.empty())
+    {
+        _sharedMaterials = true;
+        model->_sharedMaterials = true;
+        if (_material)
+        {
+            model->setMaterial(_material);
+        }
+        if (_partMaterials)
+        {
+            for (unsigned int i = 0; i < _partCount; ++i)
+            {
+                if (_partMaterials[i])
+                {
+                    model->setMaterial(_partMaterials[i], i);
+                }
+            }
+        }
+        return model;
+    }
+
     if (getMaterial())
     {
         Material* materialClone = getMaterial()->clone(context);
@@ -25,6 +25,9 @@ class Model : public Ref
     friend class Scene;
     friend class Mesh;
     friend class Bundle;
+    friend class RenderQueue;
+    friend class TerrainPatch;
+    friend class CommandBuffer;
 
 public:
 
@@ -34,6 +37,27 @@ public:
      */
     static Model* create(Mesh* mesh);
 
+#ifndef GP_USE_MEM_LEAK_DETECTION
+    /**
+     * Allocates models from the current memory pool.
+     *
+     * @param size The size of the object to allocate.
+     *
+     * @return The allocated memory.
+     * @see MemoryPool
+     * @script{ignore}
+     */
+    static void* operator new(size_t size);
+
+    /**
+     * Returns the memory of models to the memory pool it was allocated from.
+     *
+     * @param pointer The memory to free.
+     * @script{ignore}
+     */
+    static void operator delete(void* pointer);
+#endif
+
     /**
      * Returns the Mesh for this Model.
      *
@@ -60,6 +84,21 @@ public:
      */
     Material* getMaterial(int partIndex = -1);
 
+    /**
+     * Returns a Material of the specified mesh part that is not shared with other models.
+     *
+     * The models of node instances (see Node::instantiate) share their materials with the
+     * prototype, so changing a parameter of the Material returned by getMaterial() changes
+     * it for all of them. This method clones a shared Material the first time it is called
+     * for a mesh part and sets the clone on the part, so that its parameters can be
+     * overridden for this model only.
+     *
+     * @param partIndex The index of the mesh part whose Material to return (-1 for shared material).
+     *
+     * @return The Material, or NULL if no Material is set.
+     */
+    Material* getUniqueMaterial(int partIndex = -1);
+
     /**
      * Sets a material to be used for drawing this Model.
      *
@@ -160,8 +199,78 @@ public:
      */
     unsigned int draw(bool wireframe = false);
 
+    /**
+     * Adds a lower detail mesh that is drawn instead of the model's mesh when the model is smaller on screen.
+     *
+     * The LOD mesh must have the same vertex format and the same number of mesh parts as
+     * the model's mesh, since it is drawn with the same materials. The model keeps a
+     * reference to the mesh.
+     *
+     * Each LOD is drawn while the projected diameter of the model's bounding sphere is
+     * smaller than its screen size, down to the next LOD. LODs are kept ordered by
+     * decreasing screen size.
+     *
+     * @param mesh The LOD mesh.
+     * @param screenSize The screen size, in pixels, below which the LOD is drawn.
+     */
+    void addLod(Mesh* mesh, float screenSize);
+
+    /**
+     * Returns the number of levels of detail of this model, including the model's mesh.
+     *
+     * @return The number of levels of detail.
+     */
+    unsigned int getLodCount() const;
+
+    /**
+     * Returns the mesh of the specified level of detail.
+     *
+     * @param index The level of detail, where 0 is the model's mesh.
+     *
+     * @return The mesh of the level of detail.
+     */
+    Mesh* getLodMesh(unsigned int index) const;
+
+    /**
+     * Returns the screen size, in pixels, below which the specified level of detail is drawn.
+     *
+     * @param index The level of detail, where 0 is the model's mesh.
+     *
+     * @return The screen size of the level of detail (0 for the model's mesh).
+     */
+    float getLodScreenSize(unsigned int index) const;
+
+    /**
+     * Returns the level of detail selected the last time this model was drawn or queued.
+     *
+     * @return The current level of detail, where 0 is the model's mesh.
+     */
+    unsigned int getLod() const;
+
+    /**
+     * Sets the hysteresis of the level of detail selection of all models.
+     *
+     * A model only switches back to a higher level of detail once its screen size
+     * is larger than the screen size of its LOD scaled by (1 + hysteresis), so
+     * that models near a switching distance don't flicker between two LODs.
+     * The default is 0.1.
+     *
+     * @param hysteresis The hysteresis, as a fraction of the LOD screen size.
+     */
+    static void setLodHysteresis(float hysteresis);
+
 private:
 
+    /**
+     * Defines a lower level of detail of the model.
+     */
+    struct Lod
+    {
+        Mesh* mesh;
+        float screenSize;
+        std::map<Effect*, VertexAttributeBinding*> bindings;
+    };
+
     /**
      * Constructor.
      */
@@ -192,19 +301,80 @@ private:
     /**
      * Clones the model and returns a new model.
      *
+     * When the context is instancing, the new model shares the materials of this model.
+     *
      * @param context The clone context.
      * @return The new cloned model.
      */
     Model* clone(NodeCloneContext &context);
 
+    /**
+     * Binds the given pass and draws the specified mesh part (or the whole mesh if part is NULL).
+     */
+    void drawPass(Pass* pass, MeshPart* part, bool wireframe);
+
+    /**
+     * Draws the specified mesh part (or the whole mesh if part is NULL) with the currently bound pass.
+     */
+    void drawGeometry(MeshPart* part, bool wireframe);
+
+    /**
+     * Draws the outline of each triangle of the bound vertices, without indices.
+     *
+     * @return false if the primitive type can't be drawn in wireframe.
+     */
+    static bool drawWireframe(GLenum primitiveType, unsigned int vertexCount);
+
+    /**
+     * Draws the outline of each triangle of the bound index buffer.
+     *
+     * @return false if the primitive type or index format can't be drawn in wireframe.
+     */
+    static bool drawWireframe(GLenum primitiveType, unsigned int indexCount, GLenum indexFormat);
+
+    /**
+     * Selects the level of detail to draw from the current screen size of the model.
+     */
+    void updateLod();
+
+    /**
+     * Returns the mesh of the current level of detail.
+     */
+    Mesh* getDrawMesh() const;
+
+    /**
+     * Returns the vertex attribute binding of the current level of detail for the given pass.
+     */
+    VertexAttributeBinding* getLodBinding(Pass* pass);
+
+    /**
+     * Returns the approximate height in pixels of the model's bounds when viewed by the active camera of its scene.
+     *
+     * @return The height in pixels, or 0 if it cannot be estimated.
+     */
+    float getScreenSize() const;
+
+    /**
+     * Sets the world matrix of an instanced effect as a constant vertex attribute value.
+     */
+    static void setInstanceMatrix(VertexAttribute attribute, const Matrix& matrix);
+
     void validatePartCount();
 
+    /**
+     * Clears the node binding of the passes of a shared material that are bound to the given node.
+     */
+    static void unbindSharedMaterial(Material* material, Node* node);
+
     Mesh* _mesh;
     Material* _material;
     unsigned int _partCount;
     Material** _partMaterials;
     Node* _node;
     MeshSkin* _skin;
+    std::vector<Lod> _lods;
+    unsigned int _lod;
+    bool _sharedMaterials;
 };
 
 }
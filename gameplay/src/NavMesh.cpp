@@ -0,0 +1,423 @@
+#include "Base.h"
+#include "NavMesh.h"
+
+// Maximum number of grid cells along each axis of the triangle lookup grid.
+#define NAVMESH_GRID_SIZE_MAX 256
+
+// Tolerance for points on the edges of triangles.
+#define NAVMESH_EPSILON 1e-4f
+
+namespace gameplay
+{
+
+/**
+ * Returns twice the signed area of the triangle (o, a, b) on the X,Z plane.
+ * The area is positive when b is counter-clockwise from a around o.
+ */
+static float cross2(const Vector3& o, const Vector3& a, const Vector3& b)
+{
+    return (a.x - o.x) * (b.z - o.z) - (a.z - o.z) * (b.x - o.x);
+}
+
+/**
+ * Returns whether two points are at the same position on the X,Z plane.
+ */
+static bool equal2(const Vector3& a, const Vector3& b)
+{
+    float dx = a.x - b.x;
+    float dz = a.z - b.z;
+    return dx * dx + dz * dz < NAVMESH_EPSILON * NAVMESH_EPSILON;
+}
+
+NavMesh::NavMesh(const char* id)
+    : _cellSize(1.0f), _gridWidth(0), _gridHeight(0)
+{
+    if (id)
+    {
+        _id = id;
+    }
+}
+
+NavMesh::~NavMesh()
+{
+}
+
+NavMesh* NavMesh::create(const Vector3* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, float maxSlope)
+{
+    GP_ASSERT(vertices);
+    GP_ASSERT(indices);
+
+    NavMesh* navMesh = new NavMesh(NULL);
+    navMesh->_vertices.assign(vertices, vertices + vertexCount);
+
+    // Keep the triangles that are flat enough to walk on, whichever way they are wound.
+    float minNormalY = cos(maxSlope);
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount)
+        {
+            GP_WARN("Skipping navigation mesh triangle with an invalid vertex index.");
+            continue;
+        }
+
+        Vector3 normal;
+        Vector3::cross(vertices[indices[i + 1]] - vertices[indices[i]], vertices[indices[i + 2]] - vertices[indices[i]], &normal);
+        float length = normal.length();
+        if (length > 0.0f && fabs(normal.y) / length >= minNormalY)
+        {
+            navMesh->_indices.push_back(indices[i]);
+            navMesh->_indices.push_back(indices[i + 1]);
+            navMesh->_indices.push_back(indices[i + 2]);
+        }
+    }
+
+    navMesh->computeNeighbors();
+    navMesh->computeGrid();
+
+    return navMesh;
+}
+
+const char* NavMesh::getId() const
+{
+    return _id.c_str();
+}
+
+unsigned int NavMesh::getVertexCount() const
+{
+    return (unsigned int)_vertices.size();
+}
+
+unsigned int NavMesh::getTriangleCount() const
+{
+    return (unsigned int)(_indices.size() / 3);
+}
+
+const BoundingBox& NavMesh::getBoundingBox() const
+{
+    return _bounds;
+}
+
+void NavMesh::computeNeighbors()
+{
+    _neighbors.assign(_indices.size(), -1);
+
+    // Match each edge with the other triangle using the same pair of vertices.
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edges;
+    for (unsigned int i = 0, count = (unsigned int)_indices.size(); i < count; ++i)
+    {
+        unsigned int a = _indices[i];
+        unsigned int b = _indices[(i % 3) == 2 ? i - 2 : i + 1];
+        std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator itr = edges.find(key);
+        if (itr == edges.end())
+        {
+            edges[key] = i;
+        }
+        else if (_neighbors[itr->second] == -1)
+        {
+            _neighbors[itr->second] = (int)(i / 3);
+            _neighbors[i] = (int)(itr->second / 3);
+        }
+    }
+}
+
+void NavMesh::computeGrid()
+{
+    unsigned int triangleCount = getTriangleCount();
+
+    _centers.resize(triangleCount);
+    _bounds.set(Vector3::zero(), Vector3::zero());
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        const Vector3& v0 = _vertices[_indices[i * 3]];
+        const Vector3& v1 = _vertices[_indices[i * 3 + 1]];
+        const Vector3& v2 = _vertices[_indices[i * 3 + 2]];
+        _centers[i] = (v0 + v1 + v2) * (1.0f / 3.0f);
+
+        BoundingBox box;
+        box.set(Vector3(std::min(v0.x, std::min(v1.x, v2.x)), std::min(v0.y, std::min(v1.y, v2.y)), std::min(v0.z, std::min(v1.z, v2.z))),
+                Vector3(std::max(v0.x, std::max(v1.x, v2.x)), std::max(v0.y, std::max(v1.y, v2.y)), std::max(v0.z, std::max(v1.z, v2.z))));
+        if (i == 0)
+            _bounds.set(box);
+        else
+            _bounds.merge(box);
+    }
+
+    _cellStarts.clear();
+    _cellTriangles.clear();
+    _gridWidth = _gridHeight = 0;
+    if (triangleCount == 0)
+        return;
+
+    // Use cells about the size of a triangle, within the maximum grid size.
+    float sizeX = _bounds.max.x - _bounds.min.x;
+    float sizeZ = _bounds.max.z - _bounds.min.z;
+    _cellSize = sqrt(sizeX * sizeZ / triangleCount);
+    _cellSize = std::max(_cellSize, std::max(sizeX, sizeZ) / NAVMESH_GRID_SIZE_MAX);
+    if (_cellSize <= 0.0f)
+        _cellSize = 1.0f;
+    _gridWidth = std::max(1, std::min(NAVMESH_GRID_SIZE_MAX, (int)ceil(sizeX / _cellSize)));
+    _gridHeight = std::max(1, std::min(NAVMESH_GRID_SIZE_MAX, (int)ceil(sizeZ / _cellSize)));
+
+    // Bin the triangles by the cells their bounds overlap, counting them first.
+    _cellStarts.assign(_gridWidth * _gridHeight + 1, 0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::vector<unsigned int> offsets;
+        if (pass == 1)
+        {
+            for (size_t i = 1, count = _cellStarts.size(); i < count; ++i)
+            {
+                _cellStarts[i] += _cellStarts[i - 1];
+            }
+            _cellTriangles.resize(_cellStarts.back());
+            offsets.assign(_cellStarts.begin(), _cellStarts.end() - 1);
+        }
+
+        for (unsigned int i = 0; i < triangleCount; ++i)
+        {
+            const Vector3& v0 = _vertices[_indices[i * 3]];
+            const Vector3& v1 = _vertices[_indices[i * 3 + 1]];
+            const Vector3& v2 = _vertices[_indices[i * 3 + 2]];
+            int minX = (int)((std::min(v0.x, std::min(v1.x, v2.x)) - _bounds.min.x) / _cellSize);
+            int maxX = (int)((std::max(v0.x, std::max(v1.x, v2.x)) - _bounds.min.x) / _cellSize);
+            int minZ = (int)((std::min(v0.z, std::min(v1.z, v2.z)) - _bounds.min.z) / _cellSize);
+            int maxZ = (int)((std::max(v0.z, std::max(v1.z, v2.z)) - _bounds.min.z) / _cellSize);
+            minX = std::max(0, std::min(minX, _gridWidth - 1));
+            maxX = std::max(0, std::min(maxX, _gridWidth - 1));
+            minZ = std::max(0, std::min(minZ, _gridHeight - 1));
+            maxZ = std::max(0, std::min(maxZ, _gridHeight - 1));
+            for (int z = minZ; z <= maxZ; ++z)
+            {
+                for (int x = minX; x <= maxX; ++x)
+                {
+                    int cell = z * _gridWidth + x;
+                    if (pass == 0)
+                        ++_cellStarts[cell + 1];
+                    else
+                        _cellTriangles[offsets[cell]++] = (int)i;
+                }
+            }
+        }
+    }
+}
+
+bool NavMesh::containsPoint(int triangle, const Vector3& point, float* height) const
+{
+    const Vector3& v0 = _vertices[_indices[triangle * 3]];
+    const Vector3& v1 = _vertices[_indices[triangle * 3 + 1]];
+    const Vector3& v2 = _vertices[_indices[triangle * 3 + 2]];
+
+    // Barycentric coordinates of the point on the X,Z plane.
+    float d = (v1.z - v2.z) * (v0.x - v2.x) + (v2.x - v1.x) * (v0.z - v2.z);
+    if (fabs(d) < MATH_EPSILON)
+        return false;
+    float a = ((v1.z - v2.z) * (point.x - v2.x) + (v2.x - v1.x) * (point.z - v2.z)) / d;
+    float b = ((v2.z - v0.z) * (point.x - v2.x) + (v0.x - v2.x) * (point.z - v2.z)) / d;
+    float c = 1.0f - a - b;
+    if (a < -NAVMESH_EPSILON || b < -NAVMESH_EPSILON || c < -NAVMESH_EPSILON)
+        return false;
+
+    *height = a * v0.y + b * v1.y + c * v2.y;
+    return true;
+}
+
+int NavMesh::findTriangle(const Vector3& point) const
+{
+    if (_gridWidth == 0)
+        return -1;
+
+    int x = (int)floor((point.x - _bounds.min.x) / _cellSize);
+    int z = (int)floor((point.z - _bounds.min.z) / _cellSize);
+    if (point.x > _bounds.max.x + NAVMESH_EPSILON || point.z > _bounds.max.z + NAVMESH_EPSILON)
+        return -1;
+    x = std::min(x, _gridWidth - 1);
+    z = std::min(z, _gridHeight - 1);
+    if (x < 0 || z < 0)
+        return -1;
+
+    int cell = z * _gridWidth + x;
+    int nearest = -1;
+    float nearestDistance = 0.0f;
+    for (unsigned int i = _cellStarts[cell], end = _cellStarts[cell + 1]; i < end; ++i)
+    {
+        float height;
+        int triangle = _cellTriangles[i];
+        if (containsPoint(triangle, point, &height))
+        {
+            float distance = fabs(height - point.y);
+            if (nearest == -1 || distance < nearestDistance)
+            {
+                nearest = triangle;
+                nearestDistance = distance;
+            }
+        }
+    }
+    return nearest;
+}
+
+bool NavMesh::findPath(const Vector3& start, const Vector3& end, std::vector<Vector3>* path) const
+{
+    GP_ASSERT(path);
+
+    path->clear();
+    int startTriangle = findTriangle(start);
+    int endTriangle = findTriangle(end);
+    if (startTriangle == -1 || endTriangle == -1)
+        return false;
+
+    if (startTriangle == endTriangle)
+    {
+        path->push_back(start);
+        path->push_back(end);
+        return true;
+    }
+
+    // A* search over the triangles, moving between triangle centers.
+    // The search state is in the scratch memory of the calling thread, so that searches can run
+    // concurrently, and the scope frees it when the search ends on a worker thread.
+    ScratchMemory::Scope scratch;
+    unsigned int triangleCount = getTriangleCount();
+    ScratchVector<float>::type costs(triangleCount, FLT_MAX);
+    ScratchVector<int>::type parents(triangleCount, -1);
+    ScratchVector<unsigned char>::type closed(triangleCount, 0);
+    std::priority_queue<std::pair<float, int>, ScratchVector<std::pair<float, int> >::type, std::greater<std::pair<float, int> > > open;
+
+    costs[startTriangle] = 0.0f;
+    open.push(std::make_pair(_centers[startTriangle].distance(end), startTriangle));
+    while (!open.empty())
+    {
+        int triangle = open.top().second;
+        open.pop();
+        if (closed[triangle])
+            continue;
+        closed[triangle] = 1;
+        if (triangle == endTriangle)
+            break;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int neighbor = _neighbors[triangle * 3 + i];
+            if (neighbor == -1 || closed[neighbor])
+                continue;
+
+            float cost = costs[triangle] + _centers[triangle].distance(_centers[neighbor]);
+            if (cost < costs[neighbor])
+            {
+                costs[neighbor] = cost;
+                parents[neighbor] = triangle;
+                open.push(std::make_pair(cost + _centers[neighbor].distance(end), neighbor));
+            }
+        }
+    }
+
+    if (!closed[endTriangle])
+        return false;
+
+    ScratchVector<int>::type corridor;
+    for (int triangle = endTriangle; triangle != -1; triangle = parents[triangle])
+    {
+        corridor.push_back(triangle);
+    }
+    std::reverse(corridor.begin(), corridor.end());
+
+    straightenPath(start, end, corridor, path);
+    return true;
+}
+
+void NavMesh::getPortal(int triangle, int neighbor, Vector3* left, Vector3* right) const
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (_neighbors[triangle * 3 + i] == neighbor)
+        {
+            // Orient the edge as seen from inside the triangle.
+            const Vector3& a = _vertices[_indices[triangle * 3 + i]];
+            const Vector3& b = _vertices[_indices[triangle * 3 + (i + 1) % 3]];
+            if (cross2(_centers[triangle], a, b) > 0.0f)
+            {
+                *left = b;
+                *right = a;
+            }
+            else
+            {
+                *left = a;
+                *right = b;
+            }
+            return;
+        }
+    }
+    GP_ASSERT(false);
+}
+
+void NavMesh::straightenPath(const Vector3& start, const Vector3& end, const ScratchVector<int>::type& corridor, std::vector<Vector3>* path) const
+{
+    // The portals are the edges crossed along the corridor, between the start and end points.
+    size_t portalCount = corridor.size() + 1;
+    ScratchVector<Vector3>::type lefts(portalCount);
+    ScratchVector<Vector3>::type rights(portalCount);
+    lefts[0] = rights[0] = start;
+    for (size_t i = 1; i < corridor.size(); ++i)
+    {
+        getPortal(corridor[i - 1], corridor[i], &lefts[i], &rights[i]);
+    }
+    lefts[portalCount - 1] = rights[portalCount - 1] = end;
+
+    // Shrink a funnel from the apex through the portals. When one side of the funnel
+    // crosses over the other, the corner on that side is on the path and becomes the new apex.
+    path->push_back(start);
+    Vector3 apex = start;
+    Vector3 left = start;
+    Vector3 right = start;
+    size_t apexIndex = 0;
+    size_t leftIndex = 0;
+    size_t rightIndex = 0;
+    for (size_t i = 1; i < portalCount; ++i)
+    {
+        const Vector3& portalLeft = lefts[i];
+        const Vector3& portalRight = rights[i];
+
+        // Narrow the right side of the funnel.
+        if (equal2(apex, right) || cross2(apex, right, portalRight) > 0.0f)
+        {
+            if (equal2(apex, right) || cross2(apex, left, portalRight) <= 0.0f)
+            {
+                right = portalRight;
+                rightIndex = i;
+            }
+            else
+            {
+                path->push_back(left);
+                apex = right = left;
+                apexIndex = rightIndex = leftIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+
+        // Narrow the left side of the funnel.
+        if (equal2(apex, left) || cross2(apex, left, portalLeft) < 0.0f)
+        {
+            if (equal2(apex, left) || cross2(apex, right, portalLeft) >= 0.0f)
+            {
+                left = portalLeft;
+                leftIndex = i;
+            }
+            else
+            {
+                path->push_back(right);
+                apex = left = right;
+                apexIndex = leftIndex = rightIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+
+    if (!equal2(path->back(), end) || path->size() == 1)
+    {
+        path->push_back(end);
+    }
+}
+
+}
@@ -0,0 +1,172 @@
+#ifndef NAVMESH_H_
+#define NAVMESH_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "BoundingBox.h"
+#include "ScratchMemory.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a navigation mesh that AI agents can find paths on.
+ *
+ * A navigation mesh is made of the walkable triangles of the level geometry. Paths are
+ * found with an A* search over adjacent triangles and are then straightened so that
+ * they only turn at the corners of the walkable area.
+ *
+ * Navigation meshes are normally built offline by the encoder from the meshes of the
+ * specified nodes (using the -nav option) and loaded with Bundle::loadNavMesh(). They
+ * can also be created at runtime from triangle data.
+ *
+ * A navigation mesh is not modified once it is created, so findPath() can be called
+ * from multiple threads at once. AIAgent::findPath() requests paths asynchronously,
+ * which lets the AIController process them in batches on worker threads.
+ *
+ * @script{ignore}
+ */
+class NavMesh : public Ref
+{
+    friend class Bundle;
+
+public:
+
+    /**
+     * Creates a navigation mesh from triangle data.
+     *
+     * Triangles steeper than the specified slope are not walkable and are left out.
+     * Triangles that share an edge, by sharing the vertex indices of the edge, are
+     * connected.
+     *
+     * @param vertices The vertex positions.
+     * @param vertexCount The number of vertices.
+     * @param indices The vertex indices of the triangles, three per triangle.
+     * @param indexCount The number of indices.
+     * @param maxSlope The maximum slope of a walkable triangle, in radians.
+     *
+     * @return The new navigation mesh.
+     */
+    static NavMesh* create(const Vector3* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+                           float maxSlope = MATH_PIOVER4);
+
+    /**
+     * Returns the ID of this navigation mesh.
+     *
+     * @return The ID of this navigation mesh.
+     */
+    const char* getId() const;
+
+    /**
+     * Returns the number of vertices of this navigation mesh.
+     *
+     * @return The vertex count.
+     */
+    unsigned int getVertexCount() const;
+
+    /**
+     * Returns the number of walkable triangles of this navigation mesh.
+     *
+     * @return The triangle count.
+     */
+    unsigned int getTriangleCount() const;
+
+    /**
+     * Returns the bounding box of this navigation mesh.
+     *
+     * @return The bounding box.
+     */
+    const BoundingBox& getBoundingBox() const;
+
+    /**
+     * Returns the index of the triangle under or above the specified point.
+     *
+     * When several triangles overlap the point on the X,Z plane, the one vertically
+     * closest to the point is returned.
+     *
+     * @param point The point to find the triangle of.
+     *
+     * @return The index of the triangle, or -1 if the point is not over the navigation mesh.
+     */
+    int findTriangle(const Vector3& point) const;
+
+    /**
+     * Finds a path between two points on this navigation mesh.
+     *
+     * The path starts with the start point, ends with the end point and contains the
+     * corners of the walkable area that the path turns around.
+     *
+     * This method can be called from any thread.
+     *
+     * @param start The start point.
+     * @param end The end point.
+     * @param path The vector to store the points of the path in.
+     *
+     * @return True if a path was found, false if either point is not over the navigation
+     *      mesh or the end point cannot be reached from the start point.
+     */
+    bool findPath(const Vector3& start, const Vector3& end, std::vector<Vector3>* path) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    NavMesh(const char* id);
+
+    /**
+     * Destructor.
+     */
+    ~NavMesh();
+
+    /**
+     * Hidden copy constructor.
+     */
+    NavMesh(const NavMesh& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    NavMesh& operator=(const NavMesh&);
+
+    /**
+     * Computes the triangles adjacent to each triangle edge.
+     */
+    void computeNeighbors();
+
+    /**
+     * Computes the bounds, triangle centers and grid used to find triangles.
+     */
+    void computeGrid();
+
+    /**
+     * Returns whether a point is inside a triangle on the X,Z plane and the height of the triangle at the point.
+     */
+    bool containsPoint(int triangle, const Vector3& point, float* height) const;
+
+    /**
+     * Gets the shared edge between a triangle and one of its neighbors.
+     */
+    void getPortal(int triangle, int neighbor, Vector3* left, Vector3* right) const;
+
+    /**
+     * Straightens the path through a corridor of triangles with the funnel algorithm.
+     */
+    void straightenPath(const Vector3& start, const Vector3& end, const ScratchVector<int>::type& corridor, std::vector<Vector3>* path) const;
+
+    std::string _id;
+    std::vector<Vector3> _vertices;
+    std::vector<unsigned int> _indices;
+    std::vector<int> _neighbors;
+    std::vector<Vector3> _centers;
+    BoundingBox _bounds;
+    float _cellSize;
+    int _gridWidth;
+    int _gridHeight;
+    std::vector<unsigned int> _cellStarts;
+    std::vector<int> _cellTriangles;
+};
+
+}
+
+#endif
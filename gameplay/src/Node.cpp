@@ -10,19 +10,37 @@
 #include "PhysicsCharacter.h"
 #include "Game.h"
 #include "Terrain.h"
+#include "MemoryPool.h"
 
 // Node dirty flags
 #define NODE_DIRTY_WORLD 1
 #define NODE_DIRTY_BOUNDS 2
-#define NODE_DIRTY_ALL (NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS)
+#define NODE_DIRTY_VIEW_MATRICES 4
+#define NODE_DIRTY_CAPTURE 8
+#define NODE_DIRTY_ALL (NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS | NODE_DIRTY_VIEW_MATRICES | NODE_DIRTY_CAPTURE)
+
+// The cached view matrices of a node that are up to date
+#define NODE_VIEW_WORLD_VIEW 1
+#define NODE_VIEW_WORLD_VIEW_PROJ 2
+#define NODE_VIEW_INV_TRANS_WORLD 4
+#define NODE_VIEW_INV_TRANS_WORLD_VIEW 8
+#define NODE_VIEW_CAMERA (NODE_VIEW_WORLD_VIEW | NODE_VIEW_WORLD_VIEW_PROJ | NODE_VIEW_INV_TRANS_WORLD_VIEW)
 
 namespace gameplay
 {
 
+// The interned tag names, where the key of a tag is the index of its name.
+static std::vector<std::string> __tagNames;
+
+// The keys of the interned tag names, by the hash of the name.
+static std::multimap<unsigned int, unsigned int> __tagKeys;
+
 Node::Node(const char* id)
     : _scene(NULL), _firstChild(NULL), _nextSibling(NULL), _prevSibling(NULL), _parent(NULL), _childCount(0), _active(true),
     _tags(NULL), _camera(NULL), _light(NULL), _model(NULL), _terrain(NULL), _form(NULL), _audioSource(NULL), _particleEmitter(NULL),
-    _collisionObject(NULL), _agent(NULL), _dirtyBits(NODE_DIRTY_ALL), _notifyHierarchyChanged(true), _userData(NULL)
+    _collisionObject(NULL), _agent(NULL), _dirtyBits(NODE_DIRTY_ALL), _notifyHierarchyChanged(true), _userData(NULL),
+    _octreeCell(NULL), _octreeIndex(0), _octreeDirty(false), _potentiallyHidden(false),
+    _lookupScene(NULL), _viewMatrices(NULL), _captured(NULL), _flatIndex(0)
 {
     if (id)
     {
@@ -32,8 +50,14 @@ Node::Node(const char* id)
 
 Node::~Node()
 {
+    if (_lookupScene)
+        _lookupScene->removeFromLookup(this);
+
     removeAllChildren();
 
+    if (_octreeCell)
+        _octreeCell->tree->remove(this);
+
     if (_model)
         _model->setNode(NULL);
     if (_audioSource)
@@ -52,6 +76,8 @@ Node::~Node()
     SAFE_RELEASE(_form);
     SAFE_DELETE(_collisionObject);
     SAFE_DELETE(_tags);
+    SAFE_DELETE(_viewMatrices);
+    SAFE_DELETE(_captured);
 
     setAgent(NULL);
 
@@ -70,6 +96,18 @@ Node* Node::create(const char* id)
     return new Node(id);
 }
 
+#ifndef GP_USE_MEM_LEAK_DETECTION
+void* Node::operator new(size_t size)
+{
+    return MemoryPool::allocate(size);
+}
+
+void Node::operator delete(void* pointer)
+{
+    MemoryPool::deallocate(pointer);
+}
+#endif
+
 const char* Node::getId() const
 {
     return _id.c_str();
@@ -79,7 +117,14 @@ void Node::setId(const char* id)
 {
     if (id)
     {
+        Scene* scene = _lookupScene;
+        if (scene)
+            scene->removeLookupEntry(scene->_nodeIds, hashId(_id.c_str()), this);
+
         _id = id;
+
+        if (scene)
+            scene->_nodeIds.insert(std::make_pair(hashId(_id.c_str()), this));
     }
 }
 
@@ -138,6 +183,16 @@ void Node::addChild(Node* child)
     {
         hierarchyChanged();
     }
+
+    Scene* scene = getScene();
+    if (scene)
+    {
+        scene->addToLookup(child);
+        if (scene->_octree)
+        {
+            scene->indexNode(child, true);
+        }
+    }
 }
 
 void Node::removeChild(Node* child)
@@ -169,6 +224,17 @@ void Node::removeAllChildren()
 
 void Node::remove()
 {
+    // Remove this hierarchy from the scene's spatial index.
+    Scene* scene = getScene();
+    if (scene && scene->_octree)
+    {
+        scene->unindexNode(this);
+    }
+    if (_lookupScene)
+    {
+        _lookupScene->removeFromLookup(this);
+    }
+
     // Re-link our neighbours.
     if (_prevSibling)
     {
@@ -221,11 +287,42 @@ Node* Node::getParent() const
     return _parent;
 }
 
-bool Node::hasTag(const char* name) const
+unsigned int Node::hashId(const char* id)
+{
+    GP_ASSERT(id);
+
+    unsigned int hash = 2166136261u;
+    for (; *id; ++id)
+    {
+        hash = (hash ^ (unsigned char)*id) * 16777619u;
+    }
+    return hash;
+}
+
+unsigned int Node::getTagKey(const char* name, bool intern)
 {
     GP_ASSERT(name);
 
-    return (_tags ? _tags->find(name) != _tags->end() : false);
+    unsigned int hash = hashId(name);
+    std::pair<std::multimap<unsigned int, unsigned int>::const_iterator, std::multimap<unsigned int, unsigned int>::const_iterator> range = __tagKeys.equal_range(hash);
+    for (std::multimap<unsigned int, unsigned int>::const_iterator itr = range.first; itr != range.second; ++itr)
+    {
+        if (__tagNames[itr->second] == name)
+            return itr->second;
+    }
+
+    if (!intern)
+        return TAG_KEY_NONE;
+
+    unsigned int key = (unsigned int)__tagNames.size();
+    __tagNames.push_back(name);
+    __tagKeys.insert(std::make_pair(hash, key));
+    return key;
+}
+
+bool Node::hasTag(const char* name) const
+{
+    return getTag(name) != NULL;
 }
 
 const char* Node::getTag(const char* name) const
@@ -235,8 +332,17 @@ const char* Node::getTag(const char* name) const
     if (!_tags)
         return NULL;
 
-    std::map<std::string, std::string>::const_iterator itr = _tags->find(name);
-    return (itr == _tags->end() ? NULL : itr->second.c_str());
+    // Tags whose name was never interned can't be set on any node.
+    unsigned int key = getTagKey(name, false);
+    if (key == TAG_KEY_NONE)
+        return NULL;
+
+    for (size_t i = 0, count = _tags->size(); i < count; ++i)
+    {
+        if ((*_tags)[i].key == key)
+            return (*_tags)[i].value.c_str();
+    }
+    return NULL;
 }
 
 void Node::setTag(const char* name, const char* value)
@@ -248,7 +354,17 @@ void Node::setTag(const char* name, const char* value)
         // Removing tag
         if (_tags)
         {
-            _tags->erase(name);
+            unsigned int key = getTagKey(name, false);
+            for (size_t i = 0, count = _tags->size(); i < count; ++i)
+            {
+                if ((*_tags)[i].key == key)
+                {
+                    _tags->erase(_tags->begin() + i);
+                    if (_lookupScene)
+                        _lookupScene->removeLookupEntry(_lookupScene->_nodeTags, key, this);
+                    break;
+                }
+            }
             if (_tags->size() == 0)
                 SAFE_DELETE(_tags);
         }
@@ -256,10 +372,30 @@ void Node::setTag(const char* name, const char* value)
     else
     {
         // Setting tag
-        if (_tags == NULL)
-            _tags = new std::map<std::string, std::string>();
+        unsigned int key = getTagKey(name, true);
+        if (_tags)
+        {
+            for (size_t i = 0, count = _tags->size(); i < count; ++i)
+            {
+                if ((*_tags)[i].key == key)
+                {
+                    (*_tags)[i].value = value;
+                    return;
+                }
+            }
+        }
+        else
+        {
+            _tags = new std::vector<Tag>();
+        }
 
-        (*_tags)[name] = value;
+        Tag tag;
+        tag.key = key;
+        tag.value = value;
+        _tags->push_back(tag);
+
+        if (_lookupScene)
+            _lookupScene->_nodeTags.insert(std::make_pair(key, this));
     }
 }
 
@@ -300,6 +436,11 @@ void Node::setActive(bool active)
             _collisionObject->setEnabled(active);
 
         _active = active;
+
+        // The nodes culled from the scene change with the active nodes of the hierarchy.
+        Scene* scene = getScene();
+        if (scene && scene->_octree)
+            ++scene->_octree->_revision;
     }
 }
 
@@ -317,6 +458,7 @@ bool Node::isActiveInHierarchy() const
    {
        if (!node->_active)
            return false;
+       node = node->_parent;
    }
    return true;
 }
@@ -330,6 +472,14 @@ Node* Node::findNode(const char* id, bool recursive, bool exactMatch) const
 {
     GP_ASSERT(id);
 
+    // Look the ID up in the index of the scene instead of searching the whole hierarchy.
+    if (recursive && exactMatch && _lookupScene)
+    {
+        Node* match = NULL;
+        if (_lookupScene->lookupNode(id, this, &match))
+            return match;
+    }
+
     // If the node has a model with a mesh skin, search the skin's hierarchy as well.
     Node* rootNode = NULL;
     if (_model != NULL && _model->getSkin() != NULL && (rootNode = _model->getSkin()->_rootNode) != NULL)
@@ -376,6 +526,10 @@ unsigned int Node::findNodes(const char* id, std::vector<Node*>& nodes, bool rec
     
     unsigned int count = 0;
 
+    // Skip the search when no node of the scene has the ID.
+    if (recursive && exactMatch && _lookupScene && _lookupScene->_nodeIds.count(hashId(id)) == 0)
+        return 0;
+
     // If the node has a model with a mesh skin, search the skin's hierarchy as well.
     Node* rootNode = NULL;
     if (_model != NULL && _model->getSkin() != NULL && (rootNode = _model->getSkin()->_rootNode) != NULL)
@@ -453,6 +607,9 @@ bool Node::isStatic() const
 
 const Matrix& Node::getWorldMatrix() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->world;
+
     if (_dirtyBits & NODE_DIRTY_WORLD)
     {
         // Clear our dirty flag immediately to prevent this block from being entered if our
@@ -485,31 +642,143 @@ const Matrix& Node::getWorldMatrix() const
     return _world;
 }
 
-const Matrix& Node::getWorldViewMatrix() const
+bool Node::isParentWorldInherited() const
+{
+    return getParent() && (!_collisionObject || _collisionObject->isKinematic());
+}
+
+void Node::setWorldMatrix(const Matrix& world) const
+{
+    _world = world;
+    _dirtyBits &= ~NODE_DIRTY_WORLD;
+}
+
+void Node::getInterpolatedWorldMatrix(float alpha, Matrix* dst) const
+{
+    GP_ASSERT(dst);
+
+    // Pipelined frames draw the state captured at the end of the simulation, without interpolation.
+    if (getCaptured() || isStatic())
+    {
+        *dst = getWorldMatrix();
+        return;
+    }
+
+    // Follow the same parenting rules as getWorldMatrix().
+    getInterpolatedMatrix(alpha, dst);
+    Node* parent = getParent();
+    if (parent && (!_collisionObject || _collisionObject->isKinematic()))
+    {
+        Matrix parentWorld;
+        parent->getInterpolatedWorldMatrix(alpha, &parentWorld);
+        Matrix::multiply(parentWorld, *dst, dst);
+    }
+}
+
+Node::ViewMatrices* Node::getViewMatrices() const
+{
+    Scene* scene = getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (getCaptured())
+    {
+        // The matrices of the captured state, combined with the captured matrices of the camera.
+        unsigned int revision = camera ? camera->getRevision() : 0;
+        if (_captured->viewMatrices.cameraRevision != revision)
+        {
+            _captured->viewMatrices.cameraRevision = revision;
+            _captured->viewMatrices.bits &= ~NODE_VIEW_CAMERA;
+        }
+        return &_captured->viewMatrices;
+    }
+
+    if (_viewMatrices == NULL)
+    {
+        _viewMatrices = new ViewMatrices();
+        _viewMatrices->cameraRevision = 0;
+        _viewMatrices->bits = 0;
+    }
+
+    if (_dirtyBits & NODE_DIRTY_VIEW_MATRICES)
+    {
+        _dirtyBits &= ~NODE_DIRTY_VIEW_MATRICES;
+        _viewMatrices->bits = 0;
+    }
+
+    // Camera revisions start at 1, so 0 stands for no camera.
+    unsigned int revision = camera ? camera->getRevision() : 0;
+    if (_viewMatrices->cameraRevision != revision)
+    {
+        _viewMatrices->cameraRevision = revision;
+        _viewMatrices->bits &= ~NODE_VIEW_CAMERA;
+    }
+
+    return _viewMatrices;
+}
+
+void Node::capture() const
 {
-    static Matrix worldView;
+    if (_captured == NULL)
+    {
+        _captured = new Captured();
+        _captured->viewMatrices.cameraRevision = 0;
+        _dirtyBits |= NODE_DIRTY_CAPTURE;
+    }
 
-    Matrix::multiply(getViewMatrix(), getWorldMatrix(), &worldView);
+    if (_dirtyBits & NODE_DIRTY_CAPTURE)
+    {
+        _dirtyBits &= ~NODE_DIRTY_CAPTURE;
+        _captured->world = getWorldMatrix();
+        _captured->bounds = getBoundingSphere();
+        _captured->viewMatrices.bits = 0;
+    }
+    _captured->current = true;
 
-    return worldView;
+    if (_camera)
+    {
+        _camera->capture();
+    }
+}
+
+const Node::Captured* Node::getCaptured() const
+{
+    return _captured && _captured->current && Game::isRenderingCaptured() ? _captured : NULL;
+}
+
+const Matrix& Node::getWorldViewMatrix() const
+{
+    ViewMatrices* matrices = getViewMatrices();
+    if ((matrices->bits & NODE_VIEW_WORLD_VIEW) == 0)
+    {
+        Matrix::multiply(getViewMatrix(), getWorldMatrix(), &matrices->worldView);
+        matrices->bits |= NODE_VIEW_WORLD_VIEW;
+    }
+    return matrices->worldView;
 }
 
 const Matrix& Node::getInverseTransposeWorldViewMatrix() const
 {
-    static Matrix invTransWorldView;
-    Matrix::multiply(getViewMatrix(), getWorldMatrix(), &invTransWorldView);
-    invTransWorldView.invert();
-    invTransWorldView.transpose();
-    return invTransWorldView;
+    ViewMatrices* matrices = getViewMatrices();
+    if ((matrices->bits & NODE_VIEW_INV_TRANS_WORLD_VIEW) == 0)
+    {
+        matrices->inverseTransposeWorldView = getWorldViewMatrix();
+        matrices->inverseTransposeWorldView.invert();
+        matrices->inverseTransposeWorldView.transpose();
+        matrices->bits |= NODE_VIEW_INV_TRANS_WORLD_VIEW;
+    }
+    return matrices->inverseTransposeWorldView;
 }
 
 const Matrix& Node::getInverseTransposeWorldMatrix() const
 {
-    static Matrix invTransWorld;
-    invTransWorld = getWorldMatrix();
-    invTransWorld.invert();
-    invTransWorld.transpose();
-    return invTransWorld;
+    ViewMatrices* matrices = getViewMatrices();
+    if ((matrices->bits & NODE_VIEW_INV_TRANS_WORLD) == 0)
+    {
+        matrices->inverseTransposeWorld = getWorldMatrix();
+        matrices->inverseTransposeWorld.invert();
+        matrices->inverseTransposeWorld.transpose();
+        matrices->bits |= NODE_VIEW_INV_TRANS_WORLD;
+    }
+    return matrices->inverseTransposeWorld;
 }
 
 const Matrix& Node::getViewMatrix() const
@@ -582,13 +851,14 @@ const Matrix& Node::getInverseViewProjectionMatrix() const
 
 const Matrix& Node::getWorldViewProjectionMatrix() const
 {
-    static Matrix worldViewProj;
-
-    // Always re-calculate worldViewProjection matrix since it's extremely difficult
-    // to track whether the camera has changed (it may frequently change every frame).
-    Matrix::multiply(getViewProjectionMatrix(), getWorldMatrix(), &worldViewProj);
-
-    return worldViewProj;
+    // Computed once per change of this node or of the active camera, rather than once per pass that binds it.
+    ViewMatrices* matrices = getViewMatrices();
+    if ((matrices->bits & NODE_VIEW_WORLD_VIEW_PROJ) == 0)
+    {
+        Matrix::multiply(getViewProjectionMatrix(), getWorldMatrix(), &matrices->worldViewProjection);
+        matrices->bits |= NODE_VIEW_WORLD_VIEW_PROJ;
+    }
+    return matrices->worldViewProjection;
 }
 
 Vector3 Node::getTranslationWorld() const
@@ -675,14 +945,21 @@ Vector3 Node::getActiveCameraTranslationView() const
 
 void Node::hierarchyChanged()
 {
+    // Our scene must rebuild its flattened hierarchy before its next world matrix update.
+    Scene* scene = getScene();
+    if (scene)
+    {
+        scene->_flatNodesDirty = true;
+        scene->_lightInfluencesDirty = true;
+    }
+
     // When our hierarchy changes our world transform is affected, so we must dirty it.
     transformChanged();
 }
 
 void Node::transformChanged()
 {
-    // Our local transform was changed, so mark our world matrices dirty.
-    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
+    setTransformDirty();
 
     // Notify our children that their transform has also changed (since transforms are inherited).
     for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
@@ -705,16 +982,49 @@ void Node::transformChanged()
     Transform::transformChanged();
 }
 
+void Node::setTransformDirty()
+{
+    // Our local transform was changed, so mark our world matrices dirty.
+    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS | NODE_DIRTY_VIEW_MATRICES | NODE_DIRTY_CAPTURE;
+
+    // Copy our local transform to our scene's flat transform store, unless the store is rebuilt before its next update.
+    Scene* scene = getScene();
+    if (scene && !scene->_flatNodesDirty)
+        scene->storeFlatTransform(this);
+
+    // Moved while drawing a pipelined frame, so the captured state no longer applies.
+    if (_captured && Game::isRenderingCaptured())
+        _captured->current = false;
+
+    // Queue an update of our location in the scene's spatial index.
+    if (_octreeCell && !_octreeDirty)
+    {
+        _octreeCell->tree->setDirty(this);
+    }
+}
+
 void Node::setBoundsDirty()
 {
     // Mark ourself and our parent nodes as dirty
-    _dirtyBits |= NODE_DIRTY_BOUNDS;
+    _dirtyBits |= NODE_DIRTY_BOUNDS | NODE_DIRTY_CAPTURE;
+    if (_captured && Game::isRenderingCaptured())
+        _captured->current = false;
 
     // Mark our parent bounds as dirty as well
     if (_parent)
         _parent->setBoundsDirty();
 }
 
+void Node::setSpatialBoundsDirty()
+{
+    setBoundsDirty();
+
+    if (_octreeCell && !_octreeDirty)
+    {
+        _octreeCell->tree->setDirty(this);
+    }
+}
+
 Animation* Node::getAnimation(const char* id) const
 {
     Animation* animation = ((AnimationTarget*)this)->getAnimation(id);
@@ -838,6 +1148,10 @@ void Node::setModel(Model* model)
     {
         if (_model)
         {
+            // The joints of the model are indexed with the node.
+            if (_lookupScene && _model->_skin && _model->_skin->_rootNode)
+                _lookupScene->removeFromLookup(_model->_skin->_rootNode);
+
             _model->setNode(NULL);
             SAFE_RELEASE(_model);
         }
@@ -848,6 +1162,15 @@ void Node::setModel(Model* model)
         {
             _model->addRef();
             _model->setNode(this);
+
+            if (_lookupScene && _model->_skin && _model->_skin->_rootNode)
+                _lookupScene->addToLookup(_model->_skin->_rootNode);
+        }
+
+        Scene* scene = getScene();
+        if (scene && scene->_octree)
+        {
+            scene->indexNode(this, false);
         }
     }
 }
@@ -876,6 +1199,12 @@ void Node::setTerrain(Terrain* terrain)
         }
 
         setBoundsDirty();
+
+        Scene* scene = getScene();
+        if (scene && scene->_octree)
+        {
+            scene->indexNode(this, false);
+        }
     }
 }
 
@@ -901,11 +1230,20 @@ void Node::setForm(Form* form)
             _form->addRef();
             _form->setNode(this);
         }
+
+        Scene* scene = getScene();
+        if (scene && scene->_octree)
+        {
+            scene->indexNode(this, false);
+        }
     }
 }
 
 const BoundingSphere& Node::getBoundingSphere() const
 {
+    if (const Captured* captured = getCaptured())
+        return captured->bounds;
+
     if (_dirtyBits & NODE_DIRTY_BOUNDS)
     {
         _dirtyBits &= ~NODE_DIRTY_BOUNDS;
@@ -913,14 +1251,29 @@ const BoundingSphere& Node::getBoundingSphere() const
         const Matrix& worldMatrix = getWorldMatrix();
 
         // Start with our local bounding sphere
-        // TODO: Incorporate bounds from entities other than mesh (i.e. emitters, audiosource, etc)
+        // TODO: Incorporate bounds from entities other than mesh (i.e. audiosource, etc)
         bool empty = true;
         if (_terrain)
         {
             _bounds.set(_terrain->getBoundingBox());
             empty = false;
         }
-        if (_model && _model->getMesh())
+        if (_particleEmitter)
+        {
+            if (empty)
+            {
+                _bounds.set(_particleEmitter->getBoundingSphere());
+                empty = false;
+            }
+            else
+            {
+                _bounds.merge(_particleEmitter->getBoundingSphere());
+            }
+        }
+
+        // Joint bounds are in world space, so they are merged in after the transformation below.
+        MeshSkin* jointBoundsSkin = _model && _model->getSkin() && _model->getSkin()->isJointBoundsEnabled() ? _model->getSkin() : NULL;
+        if (_model && _model->getMesh() && !jointBoundsSkin)
         {
             if (empty)
             {
@@ -963,7 +1316,7 @@ const BoundingSphere& Node::getBoundingSphere() const
         if (!empty)
         {
             bool applyWorldTransform = true;
-            if (_model && _model->getSkin())
+            if (_model && _model->getSkin() && !jointBoundsSkin)
             {
                 // Special case: If the root joint of our mesh skin is parented by any nodes, 
                 // multiply the world matrix of the root joint's parent by this node's
@@ -990,6 +1343,18 @@ const BoundingSphere& Node::getBoundingSphere() const
                 _bounds.transform(getWorldMatrix());
             }
         }
+        if (jointBoundsSkin)
+        {
+            if (empty)
+            {
+                _bounds.set(jointBoundsSkin->getJointBounds());
+                empty = false;
+            }
+            else
+            {
+                _bounds.merge(jointBoundsSkin->getJointBounds());
+            }
+        }
 
         // Merge this world-space bounding sphere with our childrens' bounding volumes.
         for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
@@ -1019,6 +1384,13 @@ Node* Node::clone() const
     return cloneRecursive(context);
 }
 
+Node* Node::instantiate() const
+{
+    NodeCloneContext context;
+    context.setInstancing(true);
+    return cloneRecursive(context);
+}
+
 Node* Node::cloneSingleNode(NodeCloneContext &context) const
 {
     Node* copy = Node::create(getId());
@@ -1089,7 +1461,7 @@ void Node::cloneInto(Node* node, NodeCloneContext &context) const
 
     if (_tags)
     {
-        node->_tags = new std::map<std::string, std::string>(_tags->begin(), _tags->end());
+        node->_tags = new std::vector<Tag>(*_tags);
     }
 }
 
@@ -1140,6 +1512,13 @@ void Node::setParticleEmitter(ParticleEmitter* emitter)
             _particleEmitter->addRef();
             _particleEmitter->setNode(this);
         }
+        setBoundsDirty();
+
+        Scene* scene = getScene();
+        if (scene && scene->_octree)
+        {
+            scene->indexNode(this, false);
+        }
     }
 }
 
@@ -1301,6 +1680,7 @@ void Node::setAgent(AIAgent* agent)
 }
 
 NodeCloneContext::NodeCloneContext()
+    : _instancing(false)
 {
 }
 
@@ -1340,4 +1720,14 @@ void NodeCloneContext::registerClonedNode(const Node* original, Node* clone)
     _clonedNodes[original] = clone;
 }
 
+void NodeCloneContext::setInstancing(bool instancing)
+{
+    _instancing = instancing;
+}
+
+bool NodeCloneContext::isInstancing() const
+{
+    return _instancing;
+}
+
 }
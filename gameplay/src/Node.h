@@ -11,6 +11,7 @@
 #include "PhysicsCollisionObject.h"
 #include "BoundingBox.h"
 #include "AIAgent.h"
+#include "Octree.h"
 
 namespace gameplay
 {
@@ -36,6 +37,9 @@ class Node : public Transform, public Ref
     friend class Bundle;
     friend class MeshSkin;
     friend class Light;
+    friend class Octree;
+    friend class VisibilitySet;
+    friend class ParticleEmitter;
 
 public:
 
@@ -56,6 +60,27 @@ public:
      */
     static Node* create(const char* id = NULL);
 
+#ifndef GP_USE_MEM_LEAK_DETECTION
+    /**
+     * Allocates nodes (and joints) from the current memory pool.
+     *
+     * @param size The size of the object to allocate.
+     *
+     * @return The allocated memory.
+     * @see MemoryPool
+     * @script{ignore}
+     */
+    static void* operator new(size_t size);
+
+    /**
+     * Returns the memory of nodes (and joints) to the memory pool it was allocated from.
+     *
+     * @param pointer The memory to free.
+     * @script{ignore}
+     */
+    static void operator delete(void* pointer);
+#endif
+
     /**
      * Gets the identifier for the node.
      *
@@ -279,6 +304,19 @@ public:
      */
     virtual const Matrix& getWorldMatrix() const;
 
+    /**
+     * Gets the world matrix of this node interpolated between the last two fixed time steps.
+     *
+     * Each interpolated transform in the hierarchy contributes its interpolated matrix,
+     * and the others contribute their current matrices.
+     *
+     * @param alpha The interpolation factor between the previous (0) and the current (1) step,
+     *      typically Game::getInterpolationFactor().
+     * @param dst A matrix to store the result in.
+     * @see Transform::setInterpolated
+     */
+    void getInterpolatedWorldMatrix(float alpha, Matrix* dst) const;
+
     /**
      * Gets the world view matrix corresponding to this node.
      *
@@ -647,6 +685,20 @@ public:
      */
     Node* clone() const;
 
+    /**
+     * Creates an instance of the node and all of its child nodes, for spawning copies of a prototype.
+     *
+     * Unlike clone(), the instance only allocates the state of each copy (transforms, skins,
+     * animation clips, cameras, lights and audio sources) and shares the immutable data with
+     * the prototype. All clones share the meshes and the animation curves, and instances also
+     * share the materials of the models: use Model::getUniqueMaterial() to override the material
+     * parameters of a single instance.
+     *
+     * @return A new node.
+     * @script{create}
+     */
+    Node* instantiate() const;
+
 protected:
 
     /**
@@ -695,18 +747,74 @@ protected:
      */
     void transformChanged();
 
+    /**
+     * Marks the world matrix of this node dirty and queues its move in the scene's spatial index,
+     * without notifying its children or its listeners.
+     */
+    void setTransformDirty();
+
     /**
      * Called when this Node's hierarchy changes.
      */
     void hierarchyChanged();
 
+    /**
+     * Determines whether the world matrix of this node is its parent's world matrix multiplied by its own
+     * matrix, rather than its own matrix alone.
+     */
+    bool isParentWorldInherited() const;
+
+    /**
+     * Sets the world matrix of this node, as computed by its scene's flat transform store, and clears its dirty flag.
+     */
+    void setWorldMatrix(const Matrix& world) const;
+
     /**
      * Marks the bounding volume of the node as dirty.
      */
     void setBoundsDirty();
 
+    /**
+     * Marks the bounding volume of the node as dirty and queues an update of its location
+     * in the scene's spatial index, for bounds that change without the node moving.
+     */
+    void setSpatialBoundsDirty();
+
+    /**
+     * Returns the hash of a node ID, by which the scene indexes its nodes.
+     *
+     * @param id The ID.
+     *
+     * @return The FNV-1a hash of the ID.
+     */
+    static unsigned int hashId(const char* id);
+
+    /**
+     * Returns the interned key of a tag name.
+     *
+     * @param name The name of the tag.
+     * @param intern true to intern the name if it is not interned yet.
+     *
+     * @return The key of the tag, or TAG_KEY_NONE if the name is not interned.
+     */
+    static unsigned int getTagKey(const char* name, bool intern);
+
 private:
 
+    /**
+     * Defines the cached matrices of a node that combine its world matrix with the matrices
+     * of the active camera of its scene.
+     */
+    struct ViewMatrices
+    {
+        Matrix worldView;
+        Matrix worldViewProjection;
+        Matrix inverseTransposeWorld;
+        Matrix inverseTransposeWorldView;
+        unsigned int cameraRevision;
+        int bits;
+    };
+
     /**
      * Hidden copy constructor.
      */
@@ -717,11 +825,60 @@ private:
      */
     Node& operator=(const Node&);
 
+    /**
+     * Returns the cached view matrices of this node, invalidating those that are out of date
+     * because this node moved or the active camera of its scene changed.
+     */
+    ViewMatrices* getViewMatrices() const;
+
+    /**
+     * Defines the state of a node captured at the end of a pipelined frame, which is drawn
+     * while the next frame is simulated.
+     */
+    struct Captured
+    {
+        Matrix world;
+        BoundingSphere bounds;
+        ViewMatrices viewMatrices;
+        bool current;
+    };
+
+    /**
+     * Captures the world matrix, bounds and camera of this node for the next pipelined frame. Called by Scene.
+     */
+    void capture() const;
+
+    /**
+     * Returns the captured state if the calling thread draws it, or NULL otherwise.
+     */
+    const Captured* getCaptured() const;
+
 protected:
 
     /**
      * Defines a pointer and cleanup callback to custom user data that can be store in a Node.
      */
+    /**
+     * Defines a custom tag, by the interned key of its name.
+     */
+    struct Tag
+    {
+        /**
+         * The key of the name of the tag.
+         */
+        unsigned int key;
+
+        /**
+         * The value of the tag.
+         */
+        std::string value;
+    };
+
+    /**
+     * The key returned by getTagKey() for a name that is not interned.
+     */
+    static const unsigned int TAG_KEY_NONE = 0xFFFFFFFF;
+
     struct UserData
     {
         /**
@@ -783,7 +940,7 @@ protected:
     /**
      * List of custom tags for a node.
      */
-    std::map<std::string, std::string>* _tags;
+    std::vector<Tag>* _tags;
 
     /**
      * Pointer to the Camera attached to the Node.
@@ -854,6 +1011,46 @@ protected:
      * Pointer to custom UserData and cleanup call back that can be stored in a Node.
      */
     UserData* _userData;
+
+    /**
+     * The cell of the scene's spatial index containing this Node, or NULL if the Node is not indexed.
+     */
+    Octree::Cell* _octreeCell;
+
+    /**
+     * The index of this Node within its spatial index cell.
+     */
+    unsigned int _octreeIndex;
+
+    /**
+     * A flag indicating if the Node must be updated in the scene's spatial index.
+     */
+    bool _octreeDirty;
+
+    /**
+     * A flag indicating if the Node can't be seen from the camera's cell of the scene's visibility set.
+     */
+    bool _potentiallyHidden;
+
+    /**
+     * The scene whose ID and tag index contains this Node, or NULL if the Node is not indexed.
+     */
+    Scene* _lookupScene;
+
+    /**
+     * The matrices combining the world matrix with the active camera, allocated the first time one is requested.
+     */
+    mutable ViewMatrices* _viewMatrices;
+
+    /**
+     * The state captured for pipelined frames, allocated the first time the Node is captured.
+     */
+    mutable Captured* _captured;
+
+    /**
+     * The index of this Node in its scene's flat transform store, valid while the store is not rebuilt.
+     */
+    unsigned int _flatIndex;
 };
 
 /**
@@ -909,6 +1106,22 @@ public:
      */
     void registerClonedNode(const Node* original, Node* clone);
 
+    /**
+     * Sets whether the clones share the immutable data of the originals (false by default).
+     *
+     * @param instancing true to create instances, false to create deep copies.
+     *
+     * @see Node::instantiate
+     */
+    void setInstancing(bool instancing);
+
+    /**
+     * Returns whether the clones share the immutable data of the originals.
+     *
+     * @return true when creating instances, false when creating deep copies.
+     */
+    bool isInstancing() const;
+
 private:
 
     /**
@@ -923,6 +1136,7 @@ private:
 
     std::map<const Animation*, Animation*> _clonedAnimations;
     std::map<const Node*, Node*> _clonedNodes;
+    bool _instancing;
 };
 
 }
@@ -0,0 +1,527 @@
+#include "Base.h"
+
+#ifdef GP_HEADLESS
+
+#include "Thread.h"
+
+// The last name given to an object. Names are never reused, like the names of a real context.
+static volatile unsigned int __lastName = 0;
+
+static GLuint generateName()
+{
+    return gameplay::Atomic::increment(&__lastName);
+}
+
+static void generateNames(GLsizei n, GLuint* names)
+{
+    GP_ASSERT(names);
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        names[i] = generateName();
+    }
+}
+
+void glActiveTexture(GLenum texture)
+{
+}
+
+void glAttachShader(GLuint program, GLuint shader)
+{
+}
+
+void glBeginQuery(GLenum target, GLuint id)
+{
+}
+
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+}
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+}
+
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+}
+
+void glBindVertexArray(GLuint array)
+{
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+}
+
+void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+{
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+}
+
+GLenum glCheckFramebufferStatus(GLenum target)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glClear(GLbitfield mask)
+{
+}
+
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+}
+
+void glClearDepth(GLclampd depth)
+{
+}
+
+void glClearStencil(GLint s)
+{
+}
+
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+}
+
+void glCompileShader(GLuint shader)
+{
+}
+
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data)
+{
+}
+
+GLuint glCreateProgram()
+{
+    return generateName();
+}
+
+GLuint glCreateShader(GLenum type)
+{
+    return generateName();
+}
+
+void glCullFace(GLenum mode)
+{
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+}
+
+void glDeleteProgram(GLuint program)
+{
+}
+
+void glDeleteQueries(GLsizei n, const GLuint* ids)
+{
+}
+
+void glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+}
+
+void glDeleteShader(GLuint shader)
+{
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+}
+
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+}
+
+void glDepthFunc(GLenum func)
+{
+}
+
+void glDepthMask(GLboolean flag)
+{
+}
+
+void glDisable(GLenum cap)
+{
+}
+
+void glDisableVertexAttribArray(GLuint index)
+{
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+}
+
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount)
+{
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+}
+
+void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei primcount)
+{
+}
+
+void glEnable(GLenum cap)
+{
+}
+
+void glEnableVertexAttribArray(GLuint index)
+{
+}
+
+void glEndQuery(GLenum target)
+{
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+}
+
+void glFrontFace(GLenum mode)
+{
+}
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+    generateNames(n, buffers);
+}
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    generateNames(n, framebuffers);
+}
+
+void glGenQueries(GLsizei n, GLuint* ids)
+{
+    generateNames(n, ids);
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+    generateNames(n, renderbuffers);
+}
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+    generateNames(n, textures);
+}
+
+void glGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+    generateNames(n, arrays);
+}
+
+void glGenerateMipmap(GLenum target)
+{
+}
+
+void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    if (length)
+        *length = 0;
+    if (name && bufSize > 0)
+        *name = '\0';
+}
+
+void glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    if (length)
+        *length = 0;
+    if (name && bufSize > 0)
+        *name = '\0';
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name)
+{
+    return -1;
+}
+
+GLenum glGetError()
+{
+    return GL_NO_ERROR;
+}
+
+void glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint* params)
+{
+    *params = 0;
+}
+
+void glGetIntegerv(GLenum pname, GLint* params)
+{
+    GP_ASSERT(params);
+
+    switch (pname)
+    {
+    case GL_MAX_VERTEX_ATTRIBS:
+        *params = 16;
+        break;
+    case GL_MAX_COLOR_ATTACHMENTS:
+        *params = 4;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, GLvoid* binary)
+{
+    if (length)
+        *length = 0;
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    if (length)
+        *length = 0;
+    if (infoLog && bufSize > 0)
+        *infoLog = '\0';
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    *params = (pname == GL_LINK_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params)
+{
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+void glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint* params)
+{
+    *params = 0;
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    if (length)
+        *length = 0;
+    if (infoLog && bufSize > 0)
+        *infoLog = '\0';
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    *params = (pname == GL_COMPILE_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+    switch (name)
+    {
+    case GL_VENDOR:
+        return (const GLubyte*)"gameplay";
+    case GL_RENDERER:
+        return (const GLubyte*)"Null";
+    case GL_VERSION:
+        return (const GLubyte*)"2.0 Null";
+    default:
+        return (const GLubyte*)"";
+    }
+}
+
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar* name)
+{
+    return GL_INVALID_INDEX;
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name)
+{
+    return -1;
+}
+
+void glHint(GLenum target, GLenum mode)
+{
+}
+
+GLboolean glIsFramebuffer(GLuint framebuffer)
+{
+    return framebuffer != 0;
+}
+
+GLboolean glIsRenderbuffer(GLuint renderbuffer)
+{
+    return renderbuffer != 0;
+}
+
+GLboolean glIsVertexArray(GLuint array)
+{
+    return array != 0;
+}
+
+void glLinkProgram(GLuint program)
+{
+}
+
+GLvoid* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    return NULL;
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+}
+
+void glProgramBinary(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLsizei length)
+{
+}
+
+void glProgramParameteri(GLuint program, GLenum pname, GLint value)
+{
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+}
+
+void glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height)
+{
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar** string, const GLint* length)
+{
+}
+
+void glStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+}
+
+void glStencilMask(GLuint mask)
+{
+}
+
+void glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glUniform1f(GLint location, GLfloat v0)
+{
+}
+
+void glUniform1fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform1i(GLint location, GLint v0)
+{
+}
+
+void glUniform1iv(GLint location, GLsizei count, const GLint* value)
+{
+}
+
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+}
+
+void glUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+}
+
+void glUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+}
+
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+{
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+}
+
+GLboolean glUnmapBuffer(GLenum target)
+{
+    return GL_TRUE;
+}
+
+void glUseProgram(GLuint program)
+{
+}
+
+void glVertexAttrib4fv(GLuint index, const GLfloat* v)
+{
+}
+
+void glVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer)
+{
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+}
+
+#endif
@@ -0,0 +1,371 @@
+#include "Base.h"
+#include "OcclusionCuller.h"
+#include "Scene.h"
+#include "Node.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Effect.h"
+#include "VertexAttributeBinding.h"
+#include "Game.h"
+#include "GLStateCache.h"
+
+// Number of frames a node can stay out of the frustum before its query is deleted.
+#define QUERY_RETIRE_FRAMES 60
+
+namespace gameplay
+{
+
+// Vertex shader for drawing occluders and query boxes.
+static const char* OCCLUSION_VSH =
+    "uniform mat4 u_worldViewProjectionMatrix;\n"
+    "attribute vec4 a_position;\n"
+    "void main(void) {\n"
+    "    gl_Position = u_worldViewProjectionMatrix * a_position;\n"
+    "}";
+
+// Fragment shader for drawing occluders and query boxes (color writes are disabled).
+static const char* OCCLUSION_FSH =
+#ifdef OPENGL_ES
+    "precision mediump float;\n"
+#endif
+    "void main(void) {\n"
+    "    gl_FragColor = vec4(1.0);\n"
+    "}";
+
+OcclusionCuller::Query::Query()
+    : handle(0), frame(0), pending(false), visible(true)
+{
+}
+
+OcclusionCuller::OcclusionCuller()
+    : _effect(NULL), _box(NULL), _occluderState(NULL), _queryState(NULL), _frame(0), _occludedCount(0), _preserveDepth(false)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+#ifdef USE_OCCLUSION_QUERY
+    for (std::map<Node*, Query>::iterator itr = _queries.begin(); itr != _queries.end(); ++itr)
+    {
+        if (itr->second.handle)
+        {
+            GL_ASSERT( glDeleteQueries(1, &itr->second.handle) );
+        }
+    }
+#endif
+    for (size_t i = 0, count = _occluders.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_occluders[i]);
+    }
+    SAFE_RELEASE(_occluderState);
+    SAFE_RELEASE(_queryState);
+    SAFE_RELEASE(_box);
+    SAFE_RELEASE(_effect);
+}
+
+OcclusionCuller* OcclusionCuller::create()
+{
+    OcclusionCuller* culler = new OcclusionCuller();
+    if (!isSupported())
+        return culler;
+
+    culler->_effect = Effect::createFromSource(OCCLUSION_VSH, OCCLUSION_FSH);
+    if (culler->_effect == NULL)
+    {
+        GP_WARN("Failed to create the occlusion culling effect; occlusion culling is disabled.");
+        return culler;
+    }
+
+    // A unit cube that is scaled to the bounding box of each queried node.
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3)
+    };
+    static const float vertices[] =
+    {
+        0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+        0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1
+    };
+    static const unsigned short indices[] =
+    {
+        0, 2, 1,  0, 3, 2,  4, 5, 6,  4, 6, 7,
+        0, 1, 5,  0, 5, 4,  3, 7, 6,  3, 6, 2,
+        0, 4, 7,  0, 7, 3,  1, 2, 6,  1, 6, 5
+    };
+    culler->_box = Mesh::createMesh(VertexFormat(elements, 1), 8, false);
+    culler->_box->setVertexData(vertices, 0, 8);
+    MeshPart* part = culler->_box->addPart(Mesh::TRIANGLES, Mesh::INDEX16, 36, false);
+    part->setIndexData(indices, 0, 36);
+
+    // Occluders write depth. Query boxes are tested from both sides without writing depth.
+    culler->_occluderState = RenderState::StateBlock::create();
+    culler->_occluderState->setDepthTest(true);
+    culler->_occluderState->setDepthWrite(true);
+    culler->_occluderState->setDepthFunction(RenderState::DEPTH_LEQUAL);
+    culler->_occluderState->setCullFace(true);
+    culler->_occluderState->setBlend(false);
+
+    culler->_queryState = RenderState::StateBlock::create();
+    culler->_queryState->setDepthTest(true);
+    culler->_queryState->setDepthWrite(false);
+    culler->_queryState->setDepthFunction(RenderState::DEPTH_LEQUAL);
+    culler->_queryState->setCullFace(false);
+    culler->_queryState->setBlend(false);
+
+    return culler;
+}
+
+bool OcclusionCuller::isSupported()
+{
+#ifdef USE_OCCLUSION_QUERY
+    static int supported = -1;
+    if (supported < 0)
+    {
+        supported = (GLEW_VERSION_1_5 || GLEW_ARB_occlusion_query) ? 1 : 0;
+    }
+    return supported == 1;
+#else
+    return false;
+#endif
+}
+
+void OcclusionCuller::addOccluder(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (isOccluder(node))
+        return;
+
+    node->addRef();
+    _occluders.push_back(node);
+}
+
+void OcclusionCuller::removeOccluder(Node* node)
+{
+    std::vector<Node*>::iterator itr = std::find(_occluders.begin(), _occluders.end(), node);
+    if (itr != _occluders.end())
+    {
+        _occluders.erase(itr);
+        SAFE_RELEASE(node);
+    }
+}
+
+unsigned int OcclusionCuller::getOccluderCount() const
+{
+    return (unsigned int)_occluders.size();
+}
+
+void OcclusionCuller::setPreserveDepth(bool preserve)
+{
+    _preserveDepth = preserve;
+}
+
+bool OcclusionCuller::isOccluder(Node* node) const
+{
+    return std::find(_occluders.begin(), _occluders.end(), node) != _occluders.end();
+}
+
+unsigned int OcclusionCuller::getOccludedCount() const
+{
+    return _occludedCount;
+}
+
+unsigned int OcclusionCuller::cull(Scene* scene, std::vector<Node*>& nodes)
+{
+    GP_ASSERT(scene);
+
+    _occludedCount = 0;
+    Camera* camera = scene->getActiveCamera();
+    if (camera == NULL)
+        return 0;
+
+    _visible.clear();
+    scene->cull(camera, _visible);
+    if (_effect == NULL)
+    {
+        nodes.insert(nodes.end(), _visible.begin(), _visible.end());
+        return (unsigned int)_visible.size();
+    }
+
+#ifdef USE_OCCLUSION_QUERY
+    ++_frame;
+    size_t first = nodes.size();
+    const Matrix& viewProjection = camera->getViewProjectionMatrix();
+    Vector3 eye = camera->getNode() ? camera->getNode()->getTranslationWorld() : Vector3::zero();
+    float nearPlane = camera->getNearPlane();
+    GLenum target = (GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2) ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+
+    // Fill the depth buffer with the occluders that are in the frustum.
+    GL_ASSERT( glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE) );
+    _occluderState->bind();
+    _effect->bind();
+    for (size_t i = 0, count = _visible.size(); i < count; ++i)
+    {
+        Node* node = _visible[i];
+        Model* model = node->getModel();
+        if (model && isOccluder(node))
+        {
+            Matrix worldViewProjection;
+            Matrix::multiply(viewProjection, node->getWorldMatrix(), &worldViewProjection);
+            drawMesh(model->getMesh(), worldViewProjection);
+        }
+    }
+
+    // Decide the visibility of the other nodes from their completed queries and
+    // issue new queries against the occluder depth for the next frames.
+    _queryState->bind();
+    for (size_t i = 0, count = _visible.size(); i < count; ++i)
+    {
+        Node* node = _visible[i];
+        Model* model = node->getModel();
+        if (model == NULL || isOccluder(node))
+        {
+            nodes.push_back(node);
+            continue;
+        }
+
+        Query& query = _queries[node];
+        if (query.frame + 1 < _frame)
+        {
+            // The node just entered the frustum, so any earlier result is out of date.
+            query.visible = true;
+        }
+        query.frame = _frame;
+
+        if (query.pending)
+        {
+            GLuint available = 0;
+            GL_ASSERT( glGetQueryObjectuiv(query.handle, GL_QUERY_RESULT_AVAILABLE, &available) );
+            if (available)
+            {
+                GLuint samples = 0;
+                GL_ASSERT( glGetQueryObjectuiv(query.handle, GL_QUERY_RESULT, &samples) );
+                query.visible = samples > 0;
+                query.pending = false;
+            }
+        }
+
+        BoundingBox box(model->getMesh()->getBoundingBox());
+        box.transform(node->getWorldMatrix());
+        bool inside = eye.x >= box.min.x - nearPlane && eye.x <= box.max.x + nearPlane &&
+                      eye.y >= box.min.y - nearPlane && eye.y <= box.max.y + nearPlane &&
+                      eye.z >= box.min.z - nearPlane && eye.z <= box.max.z + nearPlane;
+        if (inside)
+        {
+            // The near plane may clip the box, so the query would be meaningless.
+            query.visible = true;
+        }
+        else if (!query.pending)
+        {
+            if (query.handle == 0)
+            {
+                GL_ASSERT( glGenQueries(1, &query.handle) );
+            }
+            Vector3 size = box.max - box.min;
+            Matrix world(size.x, 0, 0, box.min.x,
+                         0, size.y, 0, box.min.y,
+                         0, 0, size.z, box.min.z,
+                         0, 0, 0, 1);
+            Matrix worldViewProjection;
+            Matrix::multiply(viewProjection, world, &worldViewProjection);
+            GL_ASSERT( glBeginQuery(target, query.handle) );
+            drawMesh(_box, worldViewProjection);
+            GL_ASSERT( glEndQuery(target) );
+            query.pending = true;
+        }
+
+        if (query.visible)
+            nodes.push_back(node);
+        else
+            ++_occludedCount;
+    }
+    GL_ASSERT( glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE) );
+
+    if (!_preserveDepth)
+    {
+        // Depth writes must be enabled for the clear to have any effect.
+        _occluderState->bind();
+        GL_ASSERT( glClear(GL_DEPTH_BUFFER_BIT) );
+    }
+
+    if ((_frame % QUERY_RETIRE_FRAMES) == 0)
+    {
+        prune();
+    }
+
+    return (unsigned int)(nodes.size() - first);
+#else
+    nodes.insert(nodes.end(), _visible.begin(), _visible.end());
+    return (unsigned int)_visible.size();
+#endif
+}
+
+void OcclusionCuller::drawMesh(Mesh* mesh, const Matrix& worldViewProjection)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(_effect);
+
+    Uniform* uniform = _effect->getUniform("u_worldViewProjectionMatrix");
+    if (uniform)
+    {
+        _effect->setValue(uniform, worldViewProjection);
+    }
+
+    VertexAttributeBinding* binding = VertexAttributeBinding::create(mesh, _effect);
+    if (binding == NULL)
+        return;
+    binding->bind();
+
+    unsigned int partCount = mesh->getPartCount();
+    if (partCount == 0)
+    {
+        if (mesh->getPrimitiveType() == Mesh::TRIANGLES || mesh->getPrimitiveType() == Mesh::TRIANGLE_STRIP)
+        {
+            Game::countDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount());
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            GL_ASSERT( glDrawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount()) );
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < partCount; ++i)
+        {
+            MeshPart* part = mesh->getPart(i);
+            GP_ASSERT(part);
+            if (part->getPrimitiveType() != Mesh::TRIANGLES && part->getPrimitiveType() != Mesh::TRIANGLE_STRIP)
+                continue;
+            Game::countDrawCall(part->getPrimitiveType(), part->getIndexCount());
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->getIndexBuffer());
+            GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
+        }
+    }
+
+    binding->unbind();
+    SAFE_RELEASE(binding);
+}
+
+void OcclusionCuller::prune()
+{
+#ifdef USE_OCCLUSION_QUERY
+    // The nodes are never dereferenced here, since they may have been destroyed.
+    std::map<Node*, Query>::iterator itr = _queries.begin();
+    while (itr != _queries.end())
+    {
+        if (itr->second.frame + QUERY_RETIRE_FRAMES < _frame)
+        {
+            if (itr->second.handle)
+            {
+                GL_ASSERT( glDeleteQueries(1, &itr->second.handle) );
+            }
+            _queries.erase(itr++);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+#endif
+}
+
+}
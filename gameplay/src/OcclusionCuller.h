@@ -0,0 +1,194 @@
+#ifndef OCCLUSIONCULLER_H_
+#define OCCLUSIONCULLER_H_
+
+#include "Ref.h"
+#include "RenderState.h"
+#include "BoundingBox.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+class Mesh;
+class Effect;
+class Matrix;
+
+/**
+ * Defines an occlusion culling stage that removes the nodes hidden behind large occluders.
+ *
+ * Occluders are nodes with large, static models (such as buildings or terrain features)
+ * that are added to the culler with addOccluder(). Every frame, cull() finds the nodes
+ * within the frustum of the active camera through the spatial index of the scene, draws
+ * the occluders into the depth buffer and issues a hardware occlusion query for the
+ * world-space bounding box of each of the other nodes.
+ *
+ * To avoid stalling the pipeline, query results are only read back on a later frame,
+ * once the driver reports them as available. A node is culled when its last completed
+ * query found that no samples of its bounding box passed the depth test. Nodes that
+ * have not been queried yet, that re-enter the frustum or whose bounding box contains
+ * the camera are always drawn. Because results lag by at least a frame, a node that
+ * comes out from behind an occluder may appear one frame late.
+ *
+ * The occluders themselves are never culled and are drawn with a position-only effect,
+ * which ignores skinning. The culler should be used between clearing the depth buffer
+ * and drawing the scene:
+ *
+ * @code
+   OcclusionCuller* culler = OcclusionCuller::create();
+   culler->addOccluder(scene->findNode("building"));
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+       _nodes.clear();
+       culler->cull(scene, _nodes);
+       for (size_t i = 0; i < _nodes.size(); ++i)
+           _renderQueue.add(_nodes[i]);
+       _renderQueue.draw(scene->getActiveCamera());
+   }
+ * @endcode
+ *
+ * Where occlusion queries are not supported, cull() returns every node in the frustum.
+ *
+ * @script{ignore}
+ */
+class OcclusionCuller : public Ref
+{
+public:
+
+    /**
+     * Creates an occlusion culler.
+     *
+     * @return The new occlusion culler.
+     */
+    static OcclusionCuller* create();
+
+    /**
+     * Returns whether occlusion queries are supported by the graphics driver.
+     *
+     * @return True if occlusion queries are supported.
+     */
+    static bool isSupported();
+
+    /**
+     * Adds a node to the occluders drawn into the depth buffer before the queries.
+     *
+     * The node is referenced by the culler until it is removed.
+     *
+     * @param node The node with the model to use as an occluder.
+     */
+    void addOccluder(Node* node);
+
+    /**
+     * Removes a node from the occluders.
+     *
+     * @param node The node to remove.
+     */
+    void removeOccluder(Node* node);
+
+    /**
+     * Returns the number of occluders.
+     *
+     * @return The number of occluders.
+     */
+    unsigned int getOccluderCount() const;
+
+    /**
+     * Sets whether the depth of the occluders is kept after cull().
+     *
+     * By default the depth buffer is cleared after the queries are issued, since the
+     * occluders are drawn with a different effect than their materials and the two may
+     * not produce exactly the same depths. Keeping the depth saves overdraw when the
+     * scene is drawn, but the occluder materials must then use DEPTH_LEQUAL.
+     *
+     * @param preserve True to keep the occluder depth.
+     */
+    void setPreserveDepth(bool preserve);
+
+    /**
+     * Finds the nodes of the scene that are within the frustum of its active camera
+     * and were not hidden by the occluders on their last completed query.
+     *
+     * This draws the occluders and issues the occlusion queries of this frame, so it
+     * must be called with the frame buffer and viewport the scene is drawn into bound.
+     *
+     * @param scene The scene to cull.
+     * @param nodes The vector to append the visible nodes to.
+     *
+     * @return The number of nodes appended to the vector.
+     */
+    unsigned int cull(Scene* scene, std::vector<Node*>& nodes);
+
+    /**
+     * Returns the number of nodes in the frustum that were culled by the last call to cull().
+     *
+     * @return The number of occluded nodes.
+     */
+    unsigned int getOccludedCount() const;
+
+private:
+
+    /**
+     * Defines the occlusion state of a node.
+     */
+    struct Query
+    {
+        Query();
+
+        unsigned int handle;
+        unsigned int frame;
+        bool pending;
+        bool visible;
+    };
+
+    /**
+     * Constructor.
+     */
+    OcclusionCuller();
+
+    /**
+     * Destructor.
+     */
+    ~OcclusionCuller();
+
+    /**
+     * Hidden copy constructor.
+     */
+    OcclusionCuller(const OcclusionCuller& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    OcclusionCuller& operator=(const OcclusionCuller&);
+
+    /**
+     * Returns true if the specified node is an occluder.
+     */
+    bool isOccluder(Node* node) const;
+
+    /**
+     * Draws the triangles of a mesh with the position-only effect.
+     */
+    void drawMesh(Mesh* mesh, const Matrix& worldViewProjection);
+
+    /**
+     * Deletes the queries of the nodes that have not been in the frustum for a while.
+     */
+    void prune();
+
+    Effect* _effect;
+    Mesh* _box;
+    RenderState::StateBlock* _occluderState;
+    RenderState::StateBlock* _queryState;
+    std::vector<Node*> _occluders;
+    std::map<Node*, Query> _queries;
+    std::vector<Node*> _visible;
+    unsigned int _frame;
+    unsigned int _occludedCount;
+    bool _preserveDepth;
+};
+
+}
+
+#endif
@@ -0,0 +1,620 @@
+#include "Base.h"
+#include "Octree.h"
+#include "Node.h"
+#include "Terrain.h"
+#include "DepthPyramid.h"
+#include "Game.h"
+
+// Maximum number of times the root may double in size to enclose a single node.
+#define OCTREE_MAX_ROOT_GROWTH 32
+
+// The number of node bounds of a cell tested against the frustum at once.
+#define OCTREE_CULL_BATCH_SIZE 256
+
+namespace gameplay
+{
+
+Octree::Cell::Cell(Octree* tree, Cell* parent, const Vector3& center, float halfSize)
+    : tree(tree), parent(parent), center(center), halfSize(halfSize), count(0)
+{
+    memset(children, 0, sizeof(children));
+}
+
+Octree::Cell::~Cell()
+{
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        SAFE_DELETE(children[i]);
+    }
+}
+
+void Octree::Cell::getLooseBounds(BoundingBox* box) const
+{
+    GP_ASSERT(box);
+
+    // Loose bounds are twice the size of the cell.
+    float looseSize = halfSize * 2.0f;
+    box->set(center.x - looseSize, center.y - looseSize, center.z - looseSize,
+             center.x + looseSize, center.y + looseSize, center.z + looseSize);
+}
+
+Octree::Octree(float minCellSize)
+    : _minCellSize(minCellSize), _root(NULL), _unbounded(this, NULL, Vector3::zero(), 0.0f), _revision(0)
+{
+}
+
+Octree::~Octree()
+{
+    clear();
+}
+
+// Returns true if the sphere fits within the loose bounds of a cell.
+static bool fits(const Vector3& center, float halfSize, const BoundingSphere& sphere)
+{
+    return sphere.radius <= halfSize &&
+           fabs(sphere.center.x - center.x) <= halfSize &&
+           fabs(sphere.center.y - center.y) <= halfSize &&
+           fabs(sphere.center.z - center.z) <= halfSize;
+}
+
+void Octree::insert(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->_octreeCell && node->_octreeCell->tree != this)
+    {
+        node->_octreeCell->tree->remove(node);
+    }
+
+    ++_revision;
+    Cell* oldCell = node->_octreeCell;
+    Cell* cell = &_unbounded;
+    BoundingSphere sphere;
+    if (getNodeBounds(node, &sphere))
+    {
+        if (_root == NULL)
+        {
+            _root = new Cell(this, NULL, sphere.center, std::max(sphere.radius, _minCellSize));
+        }
+        if (growRoot(sphere))
+        {
+            cell = findCell(sphere);
+        }
+    }
+
+    if (cell == oldCell)
+    {
+        // Still in the same cell, so just update the stored bounds.
+        cell->bounds[node->_octreeIndex] = sphere;
+        return;
+    }
+
+    if (oldCell)
+    {
+        unlink(node);
+    }
+    link(cell, node, sphere);
+    if (oldCell && oldCell != &_unbounded)
+    {
+        pruneCell(oldCell);
+    }
+}
+
+void Octree::remove(Node* node)
+{
+    GP_ASSERT(node);
+
+    Cell* cell = node->_octreeCell;
+    if (cell == NULL || cell->tree != this)
+        return;
+
+    if (node->_octreeDirty)
+    {
+        std::vector<Node*>::iterator itr = std::find(_dirty.begin(), _dirty.end(), node);
+        if (itr != _dirty.end())
+            _dirty.erase(itr);
+        node->_octreeDirty = false;
+    }
+
+    ++_revision;
+    unlink(node);
+    if (cell != &_unbounded)
+    {
+        pruneCell(cell);
+    }
+}
+
+void Octree::clear()
+{
+    ++_revision;
+    for (size_t i = 0, count = _dirty.size(); i < count; ++i)
+    {
+        _dirty[i]->_octreeDirty = false;
+    }
+    _dirty.clear();
+
+    // Walk the tree and detach every node before deleting the cells.
+    std::vector<Cell*> cells;
+    cells.push_back(&_unbounded);
+    if (_root)
+        cells.push_back(_root);
+    while (!cells.empty())
+    {
+        Cell* cell = cells.back();
+        cells.pop_back();
+        for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+        {
+            cell->nodes[i]->_octreeCell = NULL;
+        }
+        cell->nodes.clear();
+        cell->bounds.clear();
+        cell->count = 0;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (cell->children[i])
+                cells.push_back(cell->children[i]);
+        }
+    }
+    SAFE_DELETE(_root);
+}
+
+void Octree::update()
+{
+    // While a pipelined frame is simulated the previous one is culled, so the nodes are re-indexed when the scenes are captured.
+    if (Game::isRenderingCaptured() || Game::isSimulatingInParallel())
+        return;
+
+    // Re-inserting a node never dirties another one, so the list is stable while iterating.
+    for (size_t i = 0, count = _dirty.size(); i < count; ++i)
+    {
+        Node* node = _dirty[i];
+        node->_octreeDirty = false;
+        insert(node);
+    }
+    _dirty.clear();
+}
+
+unsigned int Octree::cull(const Frustum& frustum, std::vector<Node*>& nodes, bool skipHidden, const DepthPyramid* depthPyramid)
+{
+    update();
+
+    unsigned int count = 0;
+    if (_root)
+    {
+        cullCell(_root, frustum, nodes, count, skipHidden, depthPyramid);
+    }
+
+    // Nodes without tracked bounds are tested individually.
+    for (size_t i = 0, size = _unbounded.nodes.size(); i < size; ++i)
+    {
+        Node* node = _unbounded.nodes[i];
+        if ((skipHidden && node->_potentiallyHidden) || !node->isActiveInHierarchy())
+            continue;
+
+        if (node->_form || node->_particleEmitter || node->getBoundingSphere().intersects(frustum))
+        {
+            nodes.push_back(node);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+unsigned int Octree::cull(const Frustum* frustums, std::vector<Node*>** nodes, unsigned int count)
+{
+    GP_ASSERT(frustums);
+    GP_ASSERT(nodes);
+    GP_ASSERT(count <= OCTREE_MAX_FRUSTUMS);
+
+    update();
+
+    unsigned int total = 0;
+    unsigned int mask = count < 32 ? (1u << count) - 1 : 0xFFFFFFFF;
+    if (_root && count > 0)
+    {
+        cullCell(_root, frustums, mask, nodes, total);
+    }
+
+    for (size_t i = 0, size = _unbounded.nodes.size(); i < size; ++i)
+    {
+        Node* node = _unbounded.nodes[i];
+        if (!node->isActiveInHierarchy())
+            continue;
+
+        bool always = node->_form || node->_particleEmitter;
+        for (unsigned int j = 0; j < count; ++j)
+        {
+            if (always || node->getBoundingSphere().intersects(frustums[j]))
+            {
+                nodes[j]->push_back(node);
+                ++total;
+            }
+        }
+    }
+
+    return total;
+}
+
+// Returns the distance at which a ray enters a sphere, 0 if it starts within it, or a negative value if it misses it.
+static float raycastSphere(const Ray& ray, const BoundingSphere& sphere)
+{
+    if (ray.getOrigin().distanceSquared(sphere.center) <= sphere.radius * sphere.radius)
+        return 0.0f;
+
+    // Spheres behind the origin report a negative distance.
+    float distance = sphere.intersects(ray);
+    return distance >= 0.0f ? distance : -1.0f;
+}
+
+unsigned int Octree::raycast(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits)
+{
+    update();
+
+    unsigned int count = 0;
+    if (_root)
+    {
+        raycastCell(_root, ray, maxDistance, hits, count);
+    }
+
+    for (size_t i = 0, size = _unbounded.nodes.size(); i < size; ++i)
+    {
+        Node* node = _unbounded.nodes[i];
+        if (node->_form || node->_particleEmitter || !node->isActiveInHierarchy())
+            continue;
+
+        float distance = raycastSphere(ray, node->getBoundingSphere());
+        if (distance >= 0.0f && distance <= maxDistance)
+        {
+            hits.push_back(std::make_pair(distance, node));
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+unsigned int Octree::query(const BoundingSphere& sphere, std::vector<Node*>& nodes)
+{
+    update();
+
+    unsigned int count = 0;
+    if (_root)
+    {
+        queryCell(_root, sphere, nodes, count);
+    }
+
+    for (size_t i = 0, size = _unbounded.nodes.size(); i < size; ++i)
+    {
+        Node* node = _unbounded.nodes[i];
+        if (node->_form || node->_particleEmitter || !node->isActiveInHierarchy())
+            continue;
+
+        if (node->getBoundingSphere().intersects(sphere))
+        {
+            nodes.push_back(node);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+unsigned int Octree::getRevision() const
+{
+    return _revision;
+}
+
+unsigned int Octree::getNodeCount() const
+{
+    return (_root ? _root->count : 0) + _unbounded.count;
+}
+
+void Octree::setDirty(Node* node)
+{
+    GP_ASSERT(node);
+
+    node->_octreeDirty = true;
+    _dirty.push_back(node);
+    ++_revision;
+}
+
+bool Octree::getNodeBounds(Node* node, BoundingSphere* sphere)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(sphere);
+
+    // Forms and emitters have no bounds and skinned models are moved by joints
+    // that do not notify the model's node, so these are tested every query.
+    MeshSkin* skin = node->_model ? node->_model->getSkin() : NULL;
+    if (node->_form || node->_particleEmitter || (skin && !skin->isJointBoundsEnabled()))
+        return false;
+
+    // Joint bounds are in world space already, and the skin queues an update of the node when a joint moves.
+    if (skin)
+    {
+        sphere->set(skin->getJointBounds());
+        return true;
+    }
+
+    bool empty = true;
+    if (node->_terrain)
+    {
+        sphere->set(node->_terrain->getBoundingBox());
+        empty = false;
+    }
+    if (node->_model && node->_model->getMesh())
+    {
+        if (empty)
+        {
+            sphere->set(node->_model->getMesh()->getBoundingSphere());
+            empty = false;
+        }
+        else
+        {
+            sphere->merge(node->_model->getMesh()->getBoundingSphere());
+        }
+    }
+    if (empty)
+        return false;
+
+    sphere->transform(node->getWorldMatrix());
+    return true;
+}
+
+void Octree::link(Cell* cell, Node* node, const BoundingSphere& sphere)
+{
+    GP_ASSERT(cell);
+    GP_ASSERT(node);
+
+    node->_octreeCell = cell;
+    node->_octreeIndex = (unsigned int)cell->nodes.size();
+    cell->nodes.push_back(node);
+    cell->bounds.push_back(sphere);
+
+    for (Cell* c = cell; c != NULL; c = c->parent)
+    {
+        ++c->count;
+    }
+}
+
+void Octree::unlink(Node* node)
+{
+    Cell* cell = node->_octreeCell;
+    GP_ASSERT(cell);
+    GP_ASSERT(node->_octreeIndex < cell->nodes.size() && cell->nodes[node->_octreeIndex] == node);
+
+    // Swap the last node into the vacated slot.
+    unsigned int index = node->_octreeIndex;
+    Node* last = cell->nodes.back();
+    cell->nodes[index] = last;
+    cell->bounds[index] = cell->bounds.back();
+    last->_octreeIndex = index;
+    cell->nodes.pop_back();
+    cell->bounds.pop_back();
+
+    for (Cell* c = cell; c != NULL; c = c->parent)
+    {
+        GP_ASSERT(c->count > 0);
+        --c->count;
+    }
+
+    node->_octreeCell = NULL;
+    node->_octreeIndex = 0;
+}
+
+bool Octree::growRoot(const BoundingSphere& sphere)
+{
+    GP_ASSERT(_root);
+
+    for (unsigned int i = 0; !fits(_root->center, _root->halfSize, sphere); ++i)
+    {
+        if (i == OCTREE_MAX_ROOT_GROWTH)
+            return false;
+
+        // Double the size of the root towards the sphere, keeping the old root as one of the octants.
+        float halfSize = _root->halfSize;
+        Vector3 center(_root->center.x + (sphere.center.x >= _root->center.x ? halfSize : -halfSize),
+                       _root->center.y + (sphere.center.y >= _root->center.y ? halfSize : -halfSize),
+                       _root->center.z + (sphere.center.z >= _root->center.z ? halfSize : -halfSize));
+        Cell* root = new Cell(this, NULL, center, halfSize * 2.0f);
+        unsigned int octant = (_root->center.x >= center.x ? 1 : 0) |
+                              (_root->center.y >= center.y ? 2 : 0) |
+                              (_root->center.z >= center.z ? 4 : 0);
+        root->children[octant] = _root;
+        root->count = _root->count;
+        _root->parent = root;
+        _root = root;
+    }
+    return true;
+}
+
+Octree::Cell* Octree::findCell(const BoundingSphere& sphere)
+{
+    Cell* cell = _root;
+    GP_ASSERT(cell);
+
+    // Descend while the sphere still fits into the next smaller cell.
+    float childHalfSize = cell->halfSize * 0.5f;
+    while (childHalfSize * 2.0f >= _minCellSize && sphere.radius <= childHalfSize)
+    {
+        unsigned int octant = (sphere.center.x >= cell->center.x ? 1 : 0) |
+                              (sphere.center.y >= cell->center.y ? 2 : 0) |
+                              (sphere.center.z >= cell->center.z ? 4 : 0);
+        if (cell->children[octant] == NULL)
+        {
+            Vector3 center(cell->center.x + ((octant & 1) ? childHalfSize : -childHalfSize),
+                           cell->center.y + ((octant & 2) ? childHalfSize : -childHalfSize),
+                           cell->center.z + ((octant & 4) ? childHalfSize : -childHalfSize));
+            cell->children[octant] = new Cell(this, cell, center, childHalfSize);
+        }
+        cell = cell->children[octant];
+        childHalfSize *= 0.5f;
+    }
+    return cell;
+}
+
+void Octree::pruneCell(Cell* cell)
+{
+    // Delete empty cells up to (but not including) the root.
+    while (cell && cell != _root && cell->count == 0)
+    {
+        Cell* parent = cell->parent;
+        GP_ASSERT(parent);
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (parent->children[i] == cell)
+            {
+                parent->children[i] = NULL;
+                break;
+            }
+        }
+        SAFE_DELETE(cell);
+        cell = parent;
+    }
+}
+
+void Octree::cullCell(Cell* cell, const Frustum& frustum, std::vector<Node*>& nodes, unsigned int& count, bool skipHidden,
+                      const DepthPyramid* depthPyramid)
+{
+    if (cell->count == 0)
+        return;
+
+    // The loose bounds of a cell contain those of its children, so a hidden cell hides its subtree.
+    BoundingBox box;
+    cell->getLooseBounds(&box);
+    if (!box.intersects(frustum) || (depthPyramid && depthPyramid->isOccluded(box)))
+        return;
+
+    // Test the bounds in batches before looking at the nodes, which are scattered in memory.
+    unsigned char visible[OCTREE_CULL_BATCH_SIZE];
+    for (size_t start = 0, size = cell->nodes.size(); start < size; start += OCTREE_CULL_BATCH_SIZE)
+    {
+        unsigned int batchSize = (unsigned int)std::min(size - start, (size_t)OCTREE_CULL_BATCH_SIZE);
+        if (frustum.intersectsSpheres(&cell->bounds[start], batchSize, visible) == 0)
+            continue;
+
+        for (unsigned int i = 0; i < batchSize; ++i)
+        {
+            Node* node = cell->nodes[start + i];
+            if (visible[i] && !(skipHidden && node->_potentiallyHidden) && node->isActiveInHierarchy() &&
+                !(depthPyramid && depthPyramid->isOccluded(cell->bounds[start + i])))
+            {
+                nodes.push_back(node);
+                ++count;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            cullCell(cell->children[i], frustum, nodes, count, skipHidden, depthPyramid);
+    }
+}
+
+void Octree::cullCell(Cell* cell, const Frustum* frustums, unsigned int mask, std::vector<Node*>** nodes, unsigned int& count)
+{
+    if (cell->count == 0)
+        return;
+
+    // Drop the frustums that miss the cell, which its children miss too.
+    BoundingBox box;
+    cell->getLooseBounds(&box);
+    for (unsigned int i = 0; i < OCTREE_MAX_FRUSTUMS && (mask >> i) != 0; ++i)
+    {
+        if ((mask & (1u << i)) && !box.intersects(frustums[i]))
+            mask &= ~(1u << i);
+    }
+    if (mask == 0)
+        return;
+
+    unsigned char visible[OCTREE_CULL_BATCH_SIZE];
+    for (size_t start = 0, size = cell->nodes.size(); start < size; start += OCTREE_CULL_BATCH_SIZE)
+    {
+        unsigned int batchSize = (unsigned int)std::min(size - start, (size_t)OCTREE_CULL_BATCH_SIZE);
+        for (unsigned int i = 0; i < OCTREE_MAX_FRUSTUMS && (mask >> i) != 0; ++i)
+        {
+            if (!(mask & (1u << i)) || frustums[i].intersectsSpheres(&cell->bounds[start], batchSize, visible) == 0)
+                continue;
+
+            for (unsigned int j = 0; j < batchSize; ++j)
+            {
+                Node* node = cell->nodes[start + j];
+                if (visible[j] && node->isActiveInHierarchy())
+                {
+                    nodes[i]->push_back(node);
+                    ++count;
+                }
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            cullCell(cell->children[i], frustums, mask, nodes, count);
+    }
+}
+
+void Octree::raycastCell(Cell* cell, const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits, unsigned int& count)
+{
+    if (cell->count == 0)
+        return;
+
+    BoundingBox box;
+    cell->getLooseBounds(&box);
+    const Vector3& origin = ray.getOrigin();
+    bool inside = origin.x >= box.min.x && origin.y >= box.min.y && origin.z >= box.min.z &&
+                  origin.x <= box.max.x && origin.y <= box.max.y && origin.z <= box.max.z;
+    if (!inside)
+    {
+        float distance = box.intersects(ray);
+        if (distance == Ray::INTERSECTS_NONE || distance > maxDistance)
+            return;
+    }
+
+    for (size_t i = 0, size = cell->nodes.size(); i < size; ++i)
+    {
+        float distance = raycastSphere(ray, cell->bounds[i]);
+        if (distance >= 0.0f && distance <= maxDistance && cell->nodes[i]->isActiveInHierarchy())
+        {
+            hits.push_back(std::make_pair(distance, cell->nodes[i]));
+            ++count;
+        }
+    }
+
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            raycastCell(cell->children[i], ray, maxDistance, hits, count);
+    }
+}
+
+void Octree::queryCell(Cell* cell, const BoundingSphere& sphere, std::vector<Node*>& nodes, unsigned int& count)
+{
+    if (cell->count == 0)
+        return;
+
+    BoundingBox box;
+    cell->getLooseBounds(&box);
+    if (!box.intersects(sphere))
+        return;
+
+    for (size_t i = 0, size = cell->nodes.size(); i < size; ++i)
+    {
+        if (cell->bounds[i].intersects(sphere) && cell->nodes[i]->isActiveInHierarchy())
+        {
+            nodes.push_back(cell->nodes[i]);
+            ++count;
+        }
+    }
+
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            queryCell(cell->children[i], sphere, nodes, count);
+    }
+}
+
+}
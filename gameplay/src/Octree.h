@@ -0,0 +1,224 @@
+#ifndef OCTREE_H_
+#define OCTREE_H_
+
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+// The most frustums a single traversal can test against.
+#define OCTREE_MAX_FRUSTUMS 32
+
+namespace gameplay
+{
+
+class Node;
+class DepthPyramid;
+
+/**
+ * Defines a loose octree used as a spatial index of the nodes within a scene.
+ *
+ * Nodes are stored in the smallest cell whose loose bounds (twice the size of
+ * the cell) fully contain the world-space bounds of the node's own content.
+ * The tree grows on demand to enclose any node that is inserted outside of its
+ * current extents, so there is no need to specify the size of the world up front.
+ *
+ * Nodes whose bounds cannot be tracked incrementally (such as skinned models,
+ * particle emitters and forms) are kept in a separate list that is tested
+ * individually on every query.
+ *
+ * The octree is owned and maintained by the Scene and is kept up to date as
+ * nodes are transformed, added and removed, so queries only pay for the nodes
+ * that changed since the previous query.
+ *
+ * @script{ignore}
+ */
+class Octree
+{
+    friend class Node;
+    friend class Scene;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param minCellSize The size of the smallest cell in the tree.
+     */
+    Octree(float minCellSize = 1.0f);
+
+    /**
+     * Destructor.
+     */
+    ~Octree();
+
+    /**
+     * Adds the specified node to the octree.
+     *
+     * Nodes that are already contained in this octree are updated instead.
+     *
+     * @param node The node to add.
+     */
+    void insert(Node* node);
+
+    /**
+     * Removes the specified node from the octree.
+     *
+     * @param node The node to remove.
+     */
+    void remove(Node* node);
+
+    /**
+     * Removes all nodes from the octree.
+     */
+    void clear();
+
+    /**
+     * Updates the position of all nodes whose bounds changed since the last update.
+     */
+    void update();
+
+    /**
+     * Finds all the nodes in the octree that intersect the specified frustum.
+     *
+     * @param frustum The frustum to test against.
+     * @param nodes The vector to append the intersecting nodes to.
+     * @param skipHidden True to skip the nodes hidden by the scene's visibility set.
+     * @param depthPyramid The depth pyramid whose hidden cells and nodes are skipped, or NULL.
+     *
+     * @return The number of nodes appended to the vector.
+     */
+    unsigned int cull(const Frustum& frustum, std::vector<Node*>& nodes, bool skipHidden = true, const DepthPyramid* depthPyramid = NULL);
+
+    /**
+     * Finds the nodes in the octree that intersect each of several frustums, in a single traversal.
+     *
+     * A cell is visited once for all the frustums it intersects, and its nodes are only tested
+     * against those frustums, so that views that overlap (such as split-screen views, or a camera
+     * and its reflection) share the traversal. The visibility set of the scene is ignored.
+     *
+     * @param frustums The frustums to test against.
+     * @param nodes The vectors to append the nodes intersecting each frustum to.
+     * @param count The number of frustums, at most OCTREE_MAX_FRUSTUMS.
+     *
+     * @return The number of nodes appended to all the vectors.
+     */
+    unsigned int cull(const Frustum* frustums, std::vector<Node*>** nodes, unsigned int count);
+
+    /**
+     * Finds all the nodes in the octree whose bounds are hit by the specified ray.
+     *
+     * Forms and particle emitters are never hit, and the visibility set of the scene is ignored.
+     *
+     * @param ray The ray to test against.
+     * @param maxDistance The distance along the ray beyond which bounds are ignored.
+     * @param hits The vector to append the nodes hit to, each paired with the distance at which
+     *      the ray enters its bounds (0 if the ray starts within them).
+     *
+     * @return The number of nodes appended to the vector.
+     */
+    unsigned int raycast(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits);
+
+    /**
+     * Finds all the nodes in the octree whose bounds intersect the specified sphere.
+     *
+     * Forms and particle emitters are never found, and the visibility set of the scene is ignored.
+     *
+     * @param sphere The sphere to test against.
+     * @param nodes The vector to append the intersecting nodes to.
+     *
+     * @return The number of nodes appended to the vector.
+     */
+    unsigned int query(const BoundingSphere& sphere, std::vector<Node*>& nodes);
+
+    /**
+     * Returns a number that changes whenever the nodes found by a query may change.
+     *
+     * It changes when nodes are added, removed, moved or resized, or when they are
+     * activated or deactivated, so results of queries can be reused while it stays the same.
+     *
+     * @return The revision of the octree.
+     */
+    unsigned int getRevision() const;
+
+    /**
+     * Returns the number of nodes contained in the octree.
+     *
+     * @return The number of nodes.
+     */
+    unsigned int getNodeCount() const;
+
+private:
+
+    /**
+     * Defines a single cell of the octree.
+     */
+    struct Cell
+    {
+        Cell(Octree* tree, Cell* parent, const Vector3& center, float halfSize);
+
+        ~Cell();
+
+        void getLooseBounds(BoundingBox* box) const;
+
+        Octree* tree;
+        Cell* parent;
+        Cell* children[8];
+        Vector3 center;
+        float halfSize;
+        std::vector<Node*> nodes;
+        std::vector<BoundingSphere> bounds;
+        unsigned int count;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    Octree(const Octree& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Octree& operator=(const Octree&);
+
+    /**
+     * Called by a node when its bounds change.
+     */
+    void setDirty(Node* node);
+
+    /**
+     * Computes the world-space bounds of the content attached to a node.
+     *
+     * @return false if the node's bounds must be tested every query.
+     */
+    static bool getNodeBounds(Node* node, BoundingSphere* sphere);
+
+    void link(Cell* cell, Node* node, const BoundingSphere& sphere);
+
+    void unlink(Node* node);
+
+    bool growRoot(const BoundingSphere& sphere);
+
+    Cell* findCell(const BoundingSphere& sphere);
+
+    void pruneCell(Cell* cell);
+
+    void cullCell(Cell* cell, const Frustum& frustum, std::vector<Node*>& nodes, unsigned int& count, bool skipHidden,
+                  const DepthPyramid* depthPyramid);
+
+    void cullCell(Cell* cell, const Frustum* frustums, unsigned int mask, std::vector<Node*>** nodes, unsigned int& count);
+
+    void raycastCell(Cell* cell, const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits, unsigned int& count);
+
+    void queryCell(Cell* cell, const BoundingSphere& sphere, std::vector<Node*>& nodes, unsigned int& count);
+
+    float _minCellSize;
+    Cell* _root;
+    Cell _unbounded;
+    std::vector<Node*> _dirty;
+    unsigned int _revision;
+};
+
+}
+
+#endif
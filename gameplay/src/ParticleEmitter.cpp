@@ -5,17 +5,48 @@
 #include "Scene.h"
 #include "Quaternion.h"
 #include "Properties.h"
+#include "MathUtil.h"
+#include "Model.h"
+#include "MeshPart.h"
+#include "FramePacer.h"
+#include "ScratchMemory.h"
+#include "CommandBuffer.h"
 
 #define PARTICLE_COUNT_MAX                       100
 #define PARTICLE_EMISSION_RATE                   10
 #define PARTICLE_EMISSION_RATE_TIME_INTERVAL     1000.0f / (float)PARTICLE_EMISSION_RATE
 #define PARTICLE_UPDATE_RATE_MAX                 8
+#define PARTICLE_GPU_VSH                         "res/shaders/particle.vert"
+#define PARTICLE_GPU_FSH                         "res/shaders/sprite.frag"
+#define PARTICLE_GPU_COUNT_MAX                   16384
+#define PARTICLE_GPU_FRAME_COUNT_MAX             64
+
+// Round particle streams up to a whole number of SIMD vectors.
+#define PARTICLE_STREAM_ALIGN(count)             (((count) + 3) & ~3)
+// Emitters with at least this many particles are updated in parallel by the job scheduler
+#define PARTICLE_PARALLEL_COUNT_MIN              4096
+#define PARTICLE_PARALLEL_GRAIN_SIZE             1024
+// Step of the updates that catch up with the time an emitter spent out of view, in milliseconds
+#define PARTICLE_FAST_FORWARD_STEP               100.0f
+
+// Sorted particles are ordered on their depths quantized to 16 bits, in two 8-bit radix passes.
+#define PARTICLE_SORT_KEY_MAX                    65535.0f
 
 namespace gameplay
 {
 
+// Scratch storage for sorting particles, shared by all emitters since they are drawn one at a time.
+static std::vector<float> __sortDepths;
+static std::vector<unsigned short> __sortKeys;
+static std::vector<unsigned int> __sortOwners;
+static std::vector<unsigned int> __sortOrder;
+static std::vector<unsigned int> __sortScratch;
+
+// The GPU simulated emitters drawn by recorded frames before their model could be created.
+static std::vector<ParticleEmitter*> __pendingGPUModels;
+
 ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) :
-    _particleCountMax(particleCountMax), _particleCount(0), _particles(NULL),
+    _particleCountMax(particleCountMax), _particleCount(0), _particleData(NULL),
     _emissionRate(PARTICLE_EMISSION_RATE), _started(false), _ellipsoid(false),
     _sizeStartMin(1.0f), _sizeStartMax(1.0f), _sizeEndMin(1.0f), _sizeEndMax(1.0f),
     _energyMin(1000L), _energyMax(1000L),
@@ -25,20 +56,25 @@ ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) :
     _acceleration(Vector3::zero()), _accelerationVar(Vector3::zero()),
     _rotationPerParticleSpeedMin(0.0f), _rotationPerParticleSpeedMax(0.0f),
     _rotationSpeedMin(0.0f), _rotationSpeedMax(0.0f),
-    _rotationAxis(Vector3::zero()), _rotation(Matrix::identity()),
+    _rotationAxis(Vector3::zero()),
     _spriteBatch(NULL), _spriteTextureBlending(BLEND_TRANSPARENT),  _spriteTextureWidth(0), _spriteTextureHeight(0), _spriteTextureWidthRatio(0), _spriteTextureHeightRatio(0), _spriteTextureCoords(NULL),
     _spriteAnimated(false),  _spriteLooped(false), _spriteFrameCount(1), _spriteFrameRandomOffset(0),_spriteFrameDuration(0L), _spriteFrameDurationSecs(0.0f), _spritePercentPerFrame(0.0f),
     _node(NULL), _orbitPosition(false), _orbitVelocity(false), _orbitAcceleration(false),
-    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0), _lastUpdated(0)
+    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0), _lastUpdated(0),
+    _gpuSimulated(false), _gpuModel(NULL), _gpuSlotCount(0), _gpuFrameCount(0), _gpuTime(0), _gpuStopTime(0),
+    _updateTime(0), _offscreenMode(OFFSCREEN_UPDATE), _offscreenTime(0), _depthSorted(false), _boundsDirty(true)
 {
     GP_ASSERT(particleCountMax);
-    _particles = new Particle[particleCountMax];
+    memset(_particleStreams, 0, sizeof(_particleStreams));
+    _particleCountMax = 0;
+    allocateParticles(particleCountMax);
 }
 
 ParticleEmitter::~ParticleEmitter()
 {
+    SAFE_RELEASE(_gpuModel);
     SAFE_DELETE(_spriteBatch);
-    SAFE_DELETE_ARRAY(_particles);
+    SAFE_DELETE_ARRAY(_particleData);
     SAFE_DELETE_ARRAY(_spriteTextureCoords);
 }
 
@@ -172,6 +208,9 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
     bool orbitPosition = properties->getBool("orbitPosition");
     bool orbitVelocity = properties->getBool("orbitVelocity");
     bool orbitAcceleration = properties->getBool("orbitAcceleration");
+    bool gpuSimulated = properties->getBool("gpuSimulated");
+    OffscreenMode offscreenMode = getOffscreenModeFromString(properties->getString("offscreen"));
+    bool depthSorted = properties->getBool("depthSorted");
 
     // Apply all properties to a newly created ParticleEmitter.
     ParticleEmitter* emitter = ParticleEmitter::create(texturePath.c_str(), textureBlending, particleCountMax);
@@ -198,6 +237,9 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
     emitter->setSpriteFrameCoords(spriteFrameCount, spriteWidth, spriteHeight);
 
     emitter->setOrbit(orbitPosition, orbitVelocity, orbitAcceleration);
+    emitter->setGPUSimulated(gpuSimulated);
+    emitter->setOffscreenMode(offscreenMode);
+    emitter->setDepthSorted(depthSorted);
 
     return emitter;
 }
@@ -225,6 +267,7 @@ void ParticleEmitter::setTexture(Texture* texture, TextureBlending textureBlendi
 
     // Free existing batch
     SAFE_DELETE(_spriteBatch);
+    SAFE_RELEASE(_gpuModel);
 
     _spriteBatch = batch;
     _spriteBatch->getStateBlock()->setDepthWrite(false);
@@ -249,7 +292,49 @@ Texture* ParticleEmitter::getTexture() const
 
 void ParticleEmitter::setParticleCountMax(unsigned int max)
 {
-    _particleCountMax = max;
+    GP_ASSERT(max);
+    allocateParticles(max);
+    SAFE_RELEASE(_gpuModel);
+}
+
+void ParticleEmitter::allocateParticles(unsigned int particleCountMax)
+{
+    // Allocate all streams in a single block, with each stream aligned to 16 bytes.
+    unsigned int stride = PARTICLE_STREAM_ALIGN(particleCountMax);
+    float* data = new float[stride * PARTICLE_STREAM_COUNT + 3];
+    memset(data, 0, sizeof(float) * (stride * PARTICLE_STREAM_COUNT + 3));
+    float* base = (float*)(((size_t)data + 15) & ~(size_t)15);
+
+    unsigned int count = std::min(_particleCount, particleCountMax);
+    for (unsigned int i = 0; i < PARTICLE_STREAM_COUNT; ++i)
+    {
+        float* stream = base + i * stride;
+        if (count > 0)
+        {
+            memcpy(stream, _particleStreams[i], sizeof(float) * count);
+        }
+        _particleStreams[i] = stream;
+    }
+
+    SAFE_DELETE_ARRAY(_particleData);
+    _particleData = data;
+    _particleCountMax = particleCountMax;
+    _particleCount = count;
+}
+
+void ParticleEmitter::removeParticle(unsigned int index)
+{
+    GP_ASSERT(index < _particleCount);
+
+    unsigned int last = _particleCount - 1;
+    if (index != last)
+    {
+        for (unsigned int i = 0; i < PARTICLE_STREAM_COUNT; ++i)
+        {
+            _particleStreams[i][index] = _particleStreams[i][last];
+        }
+    }
+    --_particleCount;
 }
 
 unsigned int ParticleEmitter::getParticleCountMax() const
@@ -271,13 +356,19 @@ void ParticleEmitter::setEmissionRate(unsigned int rate)
 
 void ParticleEmitter::start()
 {
+    if (_gpuSimulated && !isActive())
+    {
+        _gpuTime = 0;
+    }
     _started = true;
     _lastUpdated = 0;
+    _gpuStopTime = DBL_MAX;
 }
 
 void ParticleEmitter::stop()
 {
     _started = false;
+    _gpuStopTime = _gpuTime;
 }
 
 bool ParticleEmitter::isStarted() const
@@ -293,13 +384,22 @@ bool ParticleEmitter::isActive() const
     if (!_node)
         return false;
 
+    if (_gpuSimulated)
+    {
+        // Particles emitted before the emitter was stopped are alive until their energy is spent.
+        return (_gpuTime - _gpuStopTime) * 1000.0 < _energyMax;
+    }
+
     return (_particleCount > 0);
 }
 
 void ParticleEmitter::emitOnce(unsigned int particleCount)
 {
     GP_ASSERT(_node);
-    GP_ASSERT(_particles);
+    GP_ASSERT(_particleData);
+
+    if (_gpuSimulated)
+        return;
 
     // Limit particleCount so as not to go over _particleCountMax.
     if (particleCount + _particleCount > _particleCountMax)
@@ -317,63 +417,92 @@ void ParticleEmitter::emitOnce(unsigned int particleCount)
     world.m[14] = 0.0f;
 
     // Emit the new particles.
+    float** streams = _particleStreams;
+    Vector4 colorStart, colorEnd;
+    Vector3 position, velocity, acceleration, rotationAxis;
     for (unsigned int i = 0; i < particleCount; i++)
     {
-        Particle* p = &_particles[_particleCount];
-
-        generateColor(_colorStart, _colorStartVar, &p->_colorStart);
-        generateColor(_colorEnd, _colorEndVar, &p->_colorEnd);
-        p->_color.set(p->_colorStart);
-
-        p->_energy = p->_energyStart = generateScalar(_energyMin, _energyMax);
-        p->_size = p->_sizeStart = generateScalar(_sizeStartMin, _sizeStartMax);
-        p->_sizeEnd = generateScalar(_sizeEndMin, _sizeEndMax);
-        p->_rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
-        p->_angle = generateScalar(0.0f, p->_rotationPerParticleSpeed);
-        p->_rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
+        unsigned int p = _particleCount;
+
+        generateColor(_colorStart, _colorStartVar, &colorStart);
+        generateColor(_colorEnd, _colorEndVar, &colorEnd);
+        streams[PARTICLE_COLOR_START_R][p] = streams[PARTICLE_COLOR_R][p] = colorStart.x;
+        streams[PARTICLE_COLOR_START_G][p] = streams[PARTICLE_COLOR_G][p] = colorStart.y;
+        streams[PARTICLE_COLOR_START_B][p] = streams[PARTICLE_COLOR_B][p] = colorStart.z;
+        streams[PARTICLE_COLOR_START_A][p] = streams[PARTICLE_COLOR_A][p] = colorStart.w;
+        streams[PARTICLE_COLOR_END_R][p] = colorEnd.x;
+        streams[PARTICLE_COLOR_END_G][p] = colorEnd.y;
+        streams[PARTICLE_COLOR_END_B][p] = colorEnd.z;
+        streams[PARTICLE_COLOR_END_A][p] = colorEnd.w;
+
+        // Energy is tracked as the percentage of the particle's life that has been spent.
+        float energy = generateScalar(_energyMin, _energyMax);
+        streams[PARTICLE_PERCENT][p] = 0.0f;
+        streams[PARTICLE_ENERGY_INVERSE][p] = 1.0f / std::max(energy, 1.0f);
+
+        streams[PARTICLE_SIZE][p] = streams[PARTICLE_SIZE_START][p] = generateScalar(_sizeStartMin, _sizeStartMax);
+        streams[PARTICLE_SIZE_END][p] = generateScalar(_sizeEndMin, _sizeEndMax);
+        float rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
+        streams[PARTICLE_ROTATION_PER_PARTICLE_SPEED][p] = rotationPerParticleSpeed;
+        streams[PARTICLE_ANGLE][p] = generateScalar(0.0f, rotationPerParticleSpeed);
+        float rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
+        streams[PARTICLE_ROTATION_SPEED][p] = rotationSpeed;
 
         // Only initial position can be generated within an ellipsoidal domain.
-        generateVector(_position, _positionVar, &p->_position, _ellipsoid);
-        generateVector(_velocity, _velocityVar, &p->_velocity, false);
-        generateVector(_acceleration, _accelerationVar, &p->_acceleration, false);
-        generateVector(_rotationAxis, _rotationAxisVar, &p->_rotationAxis, false);
+        generateVector(_position, _positionVar, &position, _ellipsoid);
+        generateVector(_velocity, _velocityVar, &velocity, false);
+        generateVector(_acceleration, _accelerationVar, &acceleration, false);
+        generateVector(_rotationAxis, _rotationAxisVar, &rotationAxis, false);
 
         // Initial position, velocity and acceleration can all be relative to the emitter's transform.
         // Rotate specified properties by the node's rotation.
         if (_orbitPosition)
         {
-            world.transformPoint(p->_position, &p->_position);
+            world.transformPoint(position, &position);
         }
 
         if (_orbitVelocity)
         {
-            world.transformPoint(p->_velocity, &p->_velocity);
+            world.transformPoint(velocity, &velocity);
         }
 
         if (_orbitAcceleration)
         {
-            world.transformPoint(p->_acceleration, &p->_acceleration);
+            world.transformPoint(acceleration, &acceleration);
         }
 
         // The rotation axis always orbits the node.
-        if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
+        if (rotationSpeed != 0.0f && !rotationAxis.isZero())
         {
-            world.transformPoint(p->_rotationAxis, &p->_rotationAxis);
+            world.transformPoint(rotationAxis, &rotationAxis);
         }
 
         // Translate position relative to the node's world space.
-        p->_position.add(translation);
+        position.add(translation);
+
+        streams[PARTICLE_POSITION_X][p] = position.x;
+        streams[PARTICLE_POSITION_Y][p] = position.y;
+        streams[PARTICLE_POSITION_Z][p] = position.z;
+        streams[PARTICLE_VELOCITY_X][p] = velocity.x;
+        streams[PARTICLE_VELOCITY_Y][p] = velocity.y;
+        streams[PARTICLE_VELOCITY_Z][p] = velocity.z;
+        streams[PARTICLE_ACCELERATION_X][p] = acceleration.x;
+        streams[PARTICLE_ACCELERATION_Y][p] = acceleration.y;
+        streams[PARTICLE_ACCELERATION_Z][p] = acceleration.z;
+        streams[PARTICLE_ROTATION_AXIS_X][p] = rotationAxis.x;
+        streams[PARTICLE_ROTATION_AXIS_Y][p] = rotationAxis.y;
+        streams[PARTICLE_ROTATION_AXIS_Z][p] = rotationAxis.z;
 
         // Initial sprite frame.
         if (_spriteFrameRandomOffset > 0)
         {
-            p->_frame = rand() % _spriteFrameRandomOffset;
+            streams[PARTICLE_FRAME][p] = (float)(rand() % _spriteFrameRandomOffset);
         }
         else
         {
-            p->_frame = 0;
+            streams[PARTICLE_FRAME][p] = 0.0f;
         }
-        p->_timeOnCurrentFrame = 0.0f;
+        streams[PARTICLE_TIME_ON_CURRENT_FRAME][p] = 0.0f;
 
         ++_particleCount;
     }
@@ -384,6 +513,74 @@ unsigned int ParticleEmitter::getParticlesCount() const
     return _particleCount;
 }
 
+void ParticleEmitter::setGPUSimulated(bool simulated)
+{
+    if (simulated == _gpuSimulated)
+        return;
+
+    _gpuSimulated = simulated;
+    _particleCount = 0;
+    _gpuTime = 0;
+    _gpuStopTime = _started ? DBL_MAX : 0;
+    if (!simulated)
+    {
+        SAFE_RELEASE(_gpuModel);
+    }
+}
+
+bool ParticleEmitter::isGPUSimulated() const
+{
+    return _gpuSimulated;
+}
+
+void ParticleEmitter::setOffscreenMode(OffscreenMode mode)
+{
+    _offscreenMode = mode;
+    _offscreenTime = 0;
+}
+
+ParticleEmitter::OffscreenMode ParticleEmitter::getOffscreenMode() const
+{
+    return _offscreenMode;
+}
+
+void ParticleEmitter::setDepthSorted(bool sorted)
+{
+    _depthSorted = sorted;
+}
+
+bool ParticleEmitter::isDepthSorted() const
+{
+    return _depthSorted;
+}
+
+const BoundingSphere& ParticleEmitter::getBoundingSphere() const
+{
+    if (_boundsDirty)
+    {
+        _boundsDirty = false;
+
+        // Bound the distance a particle can travel in its lifetime from the largest initial
+        // offset, speed and acceleration, plus the largest size of a particle.
+        float lifetime = std::max(std::max((float)_energyMin, (float)_energyMax), 0.0f) * 0.001f;
+        float offset = _position.length() + _positionVar.length();
+        float speed = _velocity.length() + _velocityVar.length();
+        float acceleration = _acceleration.length() + _accelerationVar.length();
+        float size = std::max(std::max(fabs(_sizeStartMin), fabs(_sizeStartMax)), std::max(fabs(_sizeEndMin), fabs(_sizeEndMax)));
+        _bounds.set(Vector3::zero(), offset + speed * lifetime + 0.5f * acceleration * lifetime * lifetime + size);
+    }
+    return _bounds;
+}
+
+void ParticleEmitter::setBoundsDirty()
+{
+    _boundsDirty = true;
+    if (_node)
+    {
+        _node->setSpatialBoundsDirty();
+    }
+}
+
 void ParticleEmitter::setEllipsoid(bool ellipsoid)
 {
     _ellipsoid = ellipsoid;
@@ -400,6 +597,7 @@ void ParticleEmitter::setSize(float startMin, float startMax, float endMin, floa
     _sizeStartMax = startMax;
     _sizeEndMin = endMin;
     _sizeEndMax = endMax;
+    setBoundsDirty();
 }
 
 float ParticleEmitter::getSizeStartMin() const
@@ -426,6 +624,7 @@ void ParticleEmitter::setEnergy(long energyMin, long energyMax)
 {
     _energyMin = energyMin;
     _energyMax = energyMax;
+    setBoundsDirty();
 }
 
 long ParticleEmitter::getEnergyMin() const
@@ -470,6 +669,7 @@ void ParticleEmitter::setPosition(const Vector3& position, const Vector3& positi
 {
     _position.set(position);
     _positionVar.set(positionVar);
+    setBoundsDirty();
 }
 
 const Vector3& ParticleEmitter::getPosition() const
@@ -496,6 +696,7 @@ void ParticleEmitter::setVelocity(const Vector3& velocity, const Vector3& veloci
 {
     _velocity.set(velocity);
     _velocityVar.set(velocityVar);
+    setBoundsDirty();
 }
 
 const Vector3& ParticleEmitter::getAcceleration() const
@@ -512,6 +713,7 @@ void ParticleEmitter::setAcceleration(const Vector3& acceleration, const Vector3
 {
     _acceleration.set(acceleration);
     _accelerationVar.set(accelerationVar);
+    setBoundsDirty();
 }
 
 void ParticleEmitter::setRotationPerParticle(float speedMin, float speedMax)
@@ -563,32 +765,43 @@ void ParticleEmitter::setTextureBlending(TextureBlending textureBlending)
     GP_ASSERT(_spriteBatch);
     GP_ASSERT(_spriteBatch->getStateBlock());
 
+    applyTextureBlending(_spriteBatch->getStateBlock(), textureBlending);
+    if (_gpuModel)
+    {
+        applyTextureBlending(_gpuModel->getMaterial()->getStateBlock(), textureBlending);
+    }
+
+    _spriteTextureBlending = textureBlending;
+}
+
+void ParticleEmitter::applyTextureBlending(RenderState::StateBlock* stateBlock, TextureBlending textureBlending)
+{
+    GP_ASSERT(stateBlock);
+
     switch (textureBlending)
     {
         case BLEND_OPAQUE:
-            _spriteBatch->getStateBlock()->setBlend(false);
+            stateBlock->setBlend(false);
             break;
         case BLEND_TRANSPARENT:
-            _spriteBatch->getStateBlock()->setBlend(true);
-            _spriteBatch->getStateBlock()->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
-            _spriteBatch->getStateBlock()->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
+            stateBlock->setBlend(true);
+            stateBlock->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
+            stateBlock->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
             break;
         case BLEND_ADDITIVE:
-            _spriteBatch->getStateBlock()->setBlend(true);
-            _spriteBatch->getStateBlock()->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
-            _spriteBatch->getStateBlock()->setBlendDst(RenderState::BLEND_ONE);
+            stateBlock->setBlend(true);
+            stateBlock->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
+            stateBlock->setBlendDst(RenderState::BLEND_ONE);
             break;
         case BLEND_MULTIPLIED:
-            _spriteBatch->getStateBlock()->setBlend(true);
-            _spriteBatch->getStateBlock()->setBlendSrc(RenderState::BLEND_ZERO);
-            _spriteBatch->getStateBlock()->setBlendDst(RenderState::BLEND_SRC_COLOR);
+            stateBlock->setBlend(true);
+            stateBlock->setBlendSrc(RenderState::BLEND_ZERO);
+            stateBlock->setBlendDst(RenderState::BLEND_SRC_COLOR);
             break;
         default:
             GP_ERROR("Unsupported texture blending mode (%d).", textureBlending);
             break;
     }
-
-    _spriteTextureBlending = textureBlending;
 }
 
 ParticleEmitter::TextureBlending ParticleEmitter::getTextureBlending() const
@@ -858,24 +1071,101 @@ ParticleEmitter::TextureBlending ParticleEmitter::getTextureBlendingFromString(c
     }
 }
 
+ParticleEmitter::OffscreenMode ParticleEmitter::getOffscreenModeFromString(const char* str)
+{
+    if (str == NULL)
+    {
+        return OFFSCREEN_UPDATE;
+    }
+    else if (strcmp(str, "OFFSCREEN_PAUSE") == 0 || strcmp(str, "PAUSE") == 0)
+    {
+        return OFFSCREEN_PAUSE;
+    }
+    else if (strcmp(str, "OFFSCREEN_FAST_FORWARD") == 0 || strcmp(str, "FAST_FORWARD") == 0)
+    {
+        return OFFSCREEN_FAST_FORWARD;
+    }
+    else
+    {
+        return OFFSCREEN_UPDATE;
+    }
+}
+
 void ParticleEmitter::update(float elapsedTime)
 {
     if (!isActive())
         return;
 
+    if (_offscreenMode != OFFSCREEN_UPDATE)
+    {
+        if (!isVisible())
+        {
+            if (_offscreenMode == OFFSCREEN_FAST_FORWARD)
+                _offscreenTime += elapsedTime;
+            return;
+        }
+        if (_offscreenTime > 0)
+            fastForward();
+    }
+
+    // The visible particles move, so the frame must be drawn.
+    FramePacer::wake();
+
     // Cap particle updates at a maximum rate. This saves processing
     // and also improves precision since updating with very small
     // time increments is more lossy.
-    static double runningTime = 0;
-    runningTime += elapsedTime;
-    if (runningTime < PARTICLE_UPDATE_RATE_MAX)
-        return;    
+    _updateTime += elapsedTime;
+    if (_updateTime < PARTICLE_UPDATE_RATE_MAX)
+        return;
+
+    float elapsedMs = (float)_updateTime;
+    _updateTime = 0;
+    simulate(elapsedMs);
+}
+
+void ParticleEmitter::fastForward()
+{
+    double time = _offscreenTime;
+    _offscreenTime = 0;
 
-    float elapsedMs = runningTime;
-    runningTime = 0;
+    if (!_gpuSimulated && time > (double)_energyMax)
+    {
+        // Every particle alive when the emitter went out of view has died since, so only
+        // the particles emitted in the last lifetime need to be simulated.
+        _particleCount = 0;
+        time = (double)_energyMax;
+    }
+    while (time > 0)
+    {
+        float step = (float)std::min(time, (double)PARTICLE_FAST_FORWARD_STEP);
+        simulate(step);
+        time -= step;
+    }
+}
+
+bool ParticleEmitter::isVisible() const
+{
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL)
+        return true;
 
+    BoundingSphere bounds(getBoundingSphere());
+    bounds.transform(_node->getWorldMatrix());
+    return camera->getFrustum().intersects(bounds);
+}
+
+void ParticleEmitter::simulate(float elapsedMs)
+{
     float elapsedSecs = elapsedMs * 0.001f;
 
+    if (_gpuSimulated)
+    {
+        // Particles are simulated in the vertex shader, so only the emitter time advances.
+        _gpuTime += elapsedSecs;
+        return;
+    }
+
     if (_started && _emissionRate)
     {
         // Calculate how much time has passed since we last emitted particles.
@@ -896,88 +1186,136 @@ void ParticleEmitter::update(float elapsedTime)
     }
 
     // Now update all currently living particles.
-    GP_ASSERT(_particles);
-    for (unsigned int particlesIndex = 0; particlesIndex < _particleCount; ++particlesIndex)
-    {
-        Particle* p = &_particles[particlesIndex];
-        p->_energy -= elapsedMs;
+    GP_ASSERT(_particleData);
+    float** streams = _particleStreams;
 
-        if (p->_energy > 0L)
+    // Age all particles and remove the ones that have died.
+    MathUtil::addScaledArray(streams[PARTICLE_ENERGY_INVERSE], elapsedMs, streams[PARTICLE_PERCENT], PARTICLE_STREAM_ALIGN(_particleCount));
+    const float* percent = streams[PARTICLE_PERCENT];
+    for (unsigned int i = 0; i < _particleCount; )
+    {
+        if (percent[i] >= 1.0f)
         {
-            if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
-            {
-                Matrix::createRotation(p->_rotationAxis, p->_rotationSpeed * elapsedSecs, &_rotation);
-
-                _rotation.transformPoint(p->_velocity, &p->_velocity);
-                _rotation.transformPoint(p->_acceleration, &p->_acceleration);
-            }
+            // Particle is dead.  Move the particle furthest from the start of the array
+            // down to take its place, and re-use the slot at the end of the list of living particles.
+            removeParticle(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    if (_particleCount == 0)
+        return;
 
-            // Particle is still alive.
-            p->_velocity.x += p->_acceleration.x * elapsedSecs;
-            p->_velocity.y += p->_acceleration.y * elapsedSecs;
-            p->_velocity.z += p->_acceleration.z * elapsedSecs;
+    // Update the living particles, splitting large emitters across the job worker threads.
+    unsigned int count = PARTICLE_STREAM_ALIGN(_particleCount);
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (count >= PARTICLE_PARALLEL_COUNT_MIN && scheduler && scheduler->getWorkerCount() > 0)
+    {
+        UpdateContext context;
+        context.emitter = this;
+        context.elapsedSecs = elapsedSecs;
+        scheduler->parallelFor(count, &ParticleEmitter::updateParticleRange, &context, PARTICLE_PARALLEL_GRAIN_SIZE);
+    }
+    else
+    {
+        updateParticles(0, count, elapsedSecs);
+    }
+}
 
-            p->_position.x += p->_velocity.x * elapsedSecs;
-            p->_position.y += p->_velocity.y * elapsedSecs;
-            p->_position.z += p->_velocity.z * elapsedSecs;
+void ParticleEmitter::updateParticleRange(void* arg, unsigned int start, unsigned int end)
+{
+    UpdateContext* context = (UpdateContext*)arg;
+    GP_ASSERT(context && context->emitter);
+    context->emitter->updateParticles(start, end, context->elapsedSecs);
+}
 
-            p->_angle += p->_rotationPerParticleSpeed * elapsedSecs;
+void ParticleEmitter::updateParticles(unsigned int start, unsigned int end, float elapsedSecs)
+{
+    // The range is aligned for the array functions; per-particle loops stop at the last living particle.
+    GP_ASSERT(start % 4 == 0 && end <= PARTICLE_STREAM_ALIGN(_particleCount));
+    float** streams = _particleStreams;
+    const float* percent = streams[PARTICLE_PERCENT];
+    unsigned int last = std::min(end, _particleCount);
 
-            // Simple linear interpolation of color and size.
-            float percent = 1.0f - ((float)p->_energy / (float)p->_energyStart);
+    // Rotate the velocity and acceleration of particles that spin around an axis.
+    const float* rotationSpeed = streams[PARTICLE_ROTATION_SPEED];
+    Matrix rotation;
+    for (unsigned int i = start; i < last; ++i)
+    {
+        if (rotationSpeed[i] != 0.0f)
+        {
+            Vector3 axis(streams[PARTICLE_ROTATION_AXIS_X][i], streams[PARTICLE_ROTATION_AXIS_Y][i], streams[PARTICLE_ROTATION_AXIS_Z][i]);
+            if (axis.isZero())
+                continue;
+
+            Matrix::createRotation(axis, rotationSpeed[i] * elapsedSecs, &rotation);
+
+            Vector3 velocity(streams[PARTICLE_VELOCITY_X][i], streams[PARTICLE_VELOCITY_Y][i], streams[PARTICLE_VELOCITY_Z][i]);
+            rotation.transformPoint(&velocity);
+            streams[PARTICLE_VELOCITY_X][i] = velocity.x;
+            streams[PARTICLE_VELOCITY_Y][i] = velocity.y;
+            streams[PARTICLE_VELOCITY_Z][i] = velocity.z;
+
+            Vector3 acceleration(streams[PARTICLE_ACCELERATION_X][i], streams[PARTICLE_ACCELERATION_Y][i], streams[PARTICLE_ACCELERATION_Z][i]);
+            rotation.transformPoint(&acceleration);
+            streams[PARTICLE_ACCELERATION_X][i] = acceleration.x;
+            streams[PARTICLE_ACCELERATION_Y][i] = acceleration.y;
+            streams[PARTICLE_ACCELERATION_Z][i] = acceleration.z;
+        }
+    }
 
-            p->_color.x = p->_colorStart.x + (p->_colorEnd.x - p->_colorStart.x) * percent;
-            p->_color.y = p->_colorStart.y + (p->_colorEnd.y - p->_colorStart.y) * percent;
-            p->_color.z = p->_colorStart.z + (p->_colorEnd.z - p->_colorStart.z) * percent;
-            p->_color.w = p->_colorStart.w + (p->_colorEnd.w - p->_colorStart.w) * percent;
+    // Integrate the particles four at a time.
+    unsigned int count = end - start;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        MathUtil::addScaledArray(streams[PARTICLE_ACCELERATION_X + i] + start, elapsedSecs, streams[PARTICLE_VELOCITY_X + i] + start, count);
+        MathUtil::addScaledArray(streams[PARTICLE_VELOCITY_X + i] + start, elapsedSecs, streams[PARTICLE_POSITION_X + i] + start, count);
+    }
+    MathUtil::addScaledArray(streams[PARTICLE_ROTATION_PER_PARTICLE_SPEED] + start, elapsedSecs, streams[PARTICLE_ANGLE] + start, count);
 
-            p->_size = p->_sizeStart + (p->_sizeEnd - p->_sizeStart) * percent;
+    // Simple linear interpolation of color and size.
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        MathUtil::lerpArray(streams[PARTICLE_COLOR_START_R + i] + start, streams[PARTICLE_COLOR_END_R + i] + start, percent + start, streams[PARTICLE_COLOR_R + i] + start, count);
+    }
+    MathUtil::lerpArray(streams[PARTICLE_SIZE_START] + start, streams[PARTICLE_SIZE_END] + start, percent + start, streams[PARTICLE_SIZE] + start, count);
 
-            // Handle sprite animations.
-            if (_spriteAnimated)
+    // Handle sprite animations.
+    if (_spriteAnimated)
+    {
+        float* frame = streams[PARTICLE_FRAME];
+        float* timeOnCurrentFrame = streams[PARTICLE_TIME_ON_CURRENT_FRAME];
+        for (unsigned int i = start; i < last; ++i)
+        {
+            if (!_spriteLooped)
             {
-                if (!_spriteLooped)
+                // The last frame should finish exactly when the particle dies.
+                float percentSpent = frame[i] * _spritePercentPerFrame;
+                timeOnCurrentFrame[i] = percent[i] - percentSpent;
+                if (frame[i] < (float)(_spriteFrameCount - 1) &&
+                    timeOnCurrentFrame[i] >= _spritePercentPerFrame)
                 {
-                    // The last frame should finish exactly when the particle dies.
-                    float percentSpent = 0.0f;
-                    for (unsigned int i = 0; i < p->_frame; i++)
-                    {
-                        percentSpent += _spritePercentPerFrame;
-                    }
-                    p->_timeOnCurrentFrame = percent - percentSpent;
-                    if (p->_frame < _spriteFrameCount - 1 &&
-                        p->_timeOnCurrentFrame >= _spritePercentPerFrame)
-                    {
-                        ++p->_frame;
-                    }
+                    frame[i] += 1.0f;
                 }
-                else
+            }
+            else
+            {
+                // _spriteFrameDurationSecs is an absolute time measured in seconds,
+                // and the animation repeats indefinitely.
+                timeOnCurrentFrame[i] += elapsedSecs;
+                if (timeOnCurrentFrame[i] >= _spriteFrameDurationSecs)
                 {
-                    // _spriteFrameDurationSecs is an absolute time measured in seconds,
-                    // and the animation repeats indefinitely.
-                    p->_timeOnCurrentFrame += elapsedSecs;
-                    if (p->_timeOnCurrentFrame >= _spriteFrameDurationSecs)
+                    timeOnCurrentFrame[i] -= _spriteFrameDurationSecs;
+                    frame[i] += 1.0f;
+                    if (frame[i] >= (float)_spriteFrameCount)
                     {
-                        p->_timeOnCurrentFrame -= _spriteFrameDurationSecs;
-                        ++p->_frame;
-                        if (p->_frame == _spriteFrameCount)
-                        {
-                            p->_frame = 0;
-                        }
+                        frame[i] = 0.0f;
                     }
                 }
             }
         }
-        else
-        {
-            // Particle is dead.  Move the particle furthest from the start of the array
-            // down to take its place, and re-use the slot at the end of the list of living particles.
-            if (particlesIndex != _particleCount - 1)
-            {
-                _particles[particlesIndex] = _particles[_particleCount - 1];
-            }
-            --_particleCount;
-        }
     }
 }
 
@@ -986,10 +1324,27 @@ unsigned int ParticleEmitter::draw()
     if (!isActive())
         return 0;
 
+    if (_gpuSimulated)
+    {
+        drawGPU();
+        return 1;
+    }
+
+    if (_depthSorted && _particleCount > 1)
+    {
+        ParticleEmitter* emitter = this;
+        return drawSorted(&emitter, 1);
+    }
+
+    return drawUnsorted();
+}
+
+unsigned int ParticleEmitter::drawUnsorted()
+{
     if (_particleCount > 0)
     {
         GP_ASSERT(_spriteBatch);
-        GP_ASSERT(_particles);
+        GP_ASSERT(_particleData);
         GP_ASSERT(_spriteTextureCoords);
 
         // Set our node's view projection matrix to this emitter's effect.
@@ -1001,9 +1356,6 @@ unsigned int ParticleEmitter::draw()
         // Begin sprite batch drawing
         _spriteBatch->start();
 
-        // 2D Rotation.
-        static const Vector2 pivot(0.5f, 0.5f);
-
         // 3D Rotation so that particles always face the camera.
         GP_ASSERT(_node && _node->getScene() && _node->getScene()->getActiveCamera() && _node->getScene()->getActiveCamera()->getNode());
         const Matrix& cameraWorldMatrix = _node->getScene()->getActiveCamera()->getNode()->getWorldMatrix();
@@ -1015,11 +1367,7 @@ unsigned int ParticleEmitter::draw()
 
         for (unsigned int i = 0; i < _particleCount; i++)
         {
-            Particle* p = &_particles[i];
-
-            _spriteBatch->draw(p->_position, right, up, p->_size, p->_size,
-                                _spriteTextureCoords[p->_frame * 4], _spriteTextureCoords[p->_frame * 4 + 1], _spriteTextureCoords[p->_frame * 4 + 2], _spriteTextureCoords[p->_frame * 4 + 3],
-                                p->_color, pivot, p->_angle);
+            drawParticle(i, right, up);
         }
 
         // Render.
@@ -1028,6 +1376,326 @@ unsigned int ParticleEmitter::draw()
     return 1;
 }
 
+void ParticleEmitter::drawParticle(unsigned int index, const Vector3& right, const Vector3& up)
+{
+    // 2D Rotation.
+    static const Vector2 pivot(0.5f, 0.5f);
+
+    float** streams = _particleStreams;
+    Vector3 position(streams[PARTICLE_POSITION_X][index], streams[PARTICLE_POSITION_Y][index], streams[PARTICLE_POSITION_Z][index]);
+    Vector4 color(streams[PARTICLE_COLOR_R][index], streams[PARTICLE_COLOR_G][index], streams[PARTICLE_COLOR_B][index], streams[PARTICLE_COLOR_A][index]);
+    float size = streams[PARTICLE_SIZE][index];
+    const float* texCoords = &_spriteTextureCoords[(unsigned int)streams[PARTICLE_FRAME][index] * 4];
+
+    _spriteBatch->draw(position, right, up, size, size,
+                        texCoords[0], texCoords[1], texCoords[2], texCoords[3],
+                        color, pivot, streams[PARTICLE_ANGLE][index]);
+}
+
+unsigned int ParticleEmitter::drawSorted(ParticleEmitter** emitters, unsigned int count)
+{
+    GP_ASSERT(emitters || count == 0);
+
+    // Gather the emitters whose particles can be merged, drawing the others on their own.
+    unsigned int drawCalls = 0;
+    Camera* camera = NULL;
+    ScratchMemory::Scope scratch;
+    ScratchVector<ParticleEmitter*>::type merged;
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ParticleEmitter* emitter = emitters[i];
+        if (!emitter || !emitter->isActive())
+            continue;
+
+        Scene* scene = emitter->_node ? emitter->_node->getScene() : NULL;
+        Camera* activeCamera = scene ? scene->getActiveCamera() : NULL;
+        if (emitter->_gpuSimulated)
+        {
+            emitter->drawGPU();
+            ++drawCalls;
+            continue;
+        }
+        if (!activeCamera || (camera && activeCamera != camera))
+        {
+            drawCalls += emitter->drawUnsorted();
+            continue;
+        }
+        camera = activeCamera;
+        if (emitter->_particleCount > 0)
+        {
+            merged.push_back(emitter);
+            total += emitter->_particleCount;
+        }
+    }
+    if (total == 0)
+        return drawCalls;
+
+    GP_ASSERT(camera->getNode());
+    const Matrix& cameraWorldMatrix = camera->getNode()->getWorldMatrix();
+    Vector3 right;
+    cameraWorldMatrix.getRightVector(&right);
+    Vector3 up;
+    cameraWorldMatrix.getUpVector(&up);
+
+    // Compute the depths of the particles along the view direction of the camera.
+    SortContext context;
+    cameraWorldMatrix.getTranslation(&context.eye);
+    cameraWorldMatrix.getForwardVector(&context.forward);
+    __sortDepths.resize(total);
+    __sortOwners.resize(total);
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    unsigned int base = 0;
+    for (size_t e = 0, emitterCount = merged.size(); e < emitterCount; ++e)
+    {
+        ParticleEmitter* emitter = merged[e];
+        unsigned int particleCount = emitter->_particleCount;
+        context.emitter = emitter;
+        context.depths = &__sortDepths[base];
+        if (particleCount >= PARTICLE_PARALLEL_COUNT_MIN && scheduler && scheduler->getWorkerCount() > 0)
+            scheduler->parallelFor(particleCount, &ParticleEmitter::computeDepthRange, &context, PARTICLE_PARALLEL_GRAIN_SIZE);
+        else
+            emitter->computeDepths(0, particleCount, context.eye, context.forward, context.depths);
+        std::fill(__sortOwners.begin() + base, __sortOwners.begin() + base + particleCount, (unsigned int)e);
+        base += particleCount;
+    }
+
+    // Quantize the depths so that the farthest particle has the smallest key.
+    float minDepth = __sortDepths[0];
+    float maxDepth = __sortDepths[0];
+    for (unsigned int i = 1; i < total; ++i)
+    {
+        minDepth = std::min(minDepth, __sortDepths[i]);
+        maxDepth = std::max(maxDepth, __sortDepths[i]);
+    }
+    float scale = maxDepth > minDepth ? PARTICLE_SORT_KEY_MAX / (maxDepth - minDepth) : 0.0f;
+    __sortKeys.resize(total);
+    unsigned int histograms[2][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (unsigned int i = 0; i < total; ++i)
+    {
+        unsigned short key = (unsigned short)((maxDepth - __sortDepths[i]) * scale);
+        __sortKeys[i] = key;
+        ++histograms[0][key & 0xFF];
+        ++histograms[1][key >> 8];
+    }
+    for (unsigned int pass = 0; pass < 2; ++pass)
+    {
+        unsigned int offset = 0;
+        for (unsigned int bucket = 0; bucket < 256; ++bucket)
+        {
+            unsigned int bucketCount = histograms[pass][bucket];
+            histograms[pass][bucket] = offset;
+            offset += bucketCount;
+        }
+    }
+
+    // Sort on the low byte and then, stably, on the high byte.
+    __sortScratch.resize(total);
+    __sortOrder.resize(total);
+    for (unsigned int i = 0; i < total; ++i)
+        __sortScratch[histograms[0][__sortKeys[i] & 0xFF]++] = i;
+    for (unsigned int i = 0; i < total; ++i)
+    {
+        unsigned int index = __sortScratch[i];
+        __sortOrder[histograms[1][__sortKeys[index] >> 8]++] = index;
+    }
+
+    // Draw the particles in order, switching batches where the order moves to another emitter.
+    ScratchVector<unsigned int>::type bases(merged.size());
+    for (size_t e = 1, emitterCount = merged.size(); e < emitterCount; ++e)
+        bases[e] = bases[e - 1] + merged[e - 1]->_particleCount;
+
+    const Matrix& viewProjection = camera->getViewProjectionMatrix();
+    ParticleEmitter* current = NULL;
+    for (unsigned int i = 0; i < total; ++i)
+    {
+        unsigned int index = __sortOrder[i];
+        unsigned int owner = __sortOwners[index];
+        ParticleEmitter* emitter = merged[owner];
+        if (emitter != current)
+        {
+            if (current)
+                current->_spriteBatch->finish();
+            GP_ASSERT(emitter->_spriteBatch);
+            emitter->_spriteBatch->setProjectionMatrix(viewProjection);
+            emitter->_spriteBatch->start();
+            current = emitter;
+            ++drawCalls;
+        }
+        emitter->drawParticle(index - bases[owner], right, up);
+    }
+    current->_spriteBatch->finish();
+
+    return drawCalls;
+}
+
+void ParticleEmitter::computeDepthRange(void* arg, unsigned int start, unsigned int end)
+{
+    SortContext* context = (SortContext*)arg;
+    GP_ASSERT(context && context->emitter);
+    context->emitter->computeDepths(start, end, context->eye, context->forward, context->depths);
+}
+
+void ParticleEmitter::computeDepths(unsigned int start, unsigned int end, const Vector3& eye, const Vector3& forward, float* depths) const
+{
+    const float* x = _particleStreams[PARTICLE_POSITION_X];
+    const float* y = _particleStreams[PARTICLE_POSITION_Y];
+    const float* z = _particleStreams[PARTICLE_POSITION_Z];
+    for (unsigned int i = start; i < end; ++i)
+        depths[i] = (x[i] - eye.x) * forward.x + (y[i] - eye.y) * forward.y + (z[i] - eye.z) * forward.z;
+}
+
+bool ParticleEmitter::createGPUModel()
+{
+    GP_ASSERT(_spriteBatch);
+    GP_ASSERT(_spriteBatch->getSampler());
+
+    SAFE_RELEASE(_gpuModel);
+
+    // Each particle slot is a quad of four vertices, indexed with 16-bit indices.
+    _gpuSlotCount = _particleCountMax;
+    if (_gpuSlotCount > PARTICLE_GPU_COUNT_MAX)
+    {
+        GP_WARN("GPU simulated particle emitters are limited to %d particles.", PARTICLE_GPU_COUNT_MAX);
+        _gpuSlotCount = PARTICLE_GPU_COUNT_MAX;
+    }
+    _gpuFrameCount = std::min(_spriteFrameCount, (unsigned int)PARTICLE_GPU_FRAME_COUNT_MAX);
+
+    // Vertices hold the billboard corner followed by the slot index and a random seed.
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 2),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 2)
+    };
+    Mesh* mesh = Mesh::createMesh(VertexFormat(elements, 2), _gpuSlotCount * 4, false);
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to create mesh for GPU simulated particle emitter.");
+        return false;
+    }
+
+    static const float corners[8] = { -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f };
+    float* vertices = new float[_gpuSlotCount * 16];
+    unsigned short* indices = new unsigned short[_gpuSlotCount * 6];
+    for (unsigned int i = 0; i < _gpuSlotCount; ++i)
+    {
+        float seed = generateScalar(0.0f, 1.0f);
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            float* v = &vertices[(i * 4 + j) * 4];
+            v[0] = corners[j * 2];
+            v[1] = corners[j * 2 + 1];
+            v[2] = (float)i;
+            v[3] = seed;
+        }
+        unsigned short base = (unsigned short)(i * 4);
+        unsigned short* index = &indices[i * 6];
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base + 2;
+        index[4] = base + 1;
+        index[5] = base + 3;
+    }
+    mesh->setVertexData(vertices, 0, _gpuSlotCount * 4);
+    MeshPart* part = mesh->addPart(Mesh::TRIANGLES, Mesh::INDEX16, _gpuSlotCount * 6, false);
+    part->setIndexData(indices, 0, _gpuSlotCount * 6);
+    SAFE_DELETE_ARRAY(vertices);
+    SAFE_DELETE_ARRAY(indices);
+
+    _gpuModel = Model::create(mesh);
+    SAFE_RELEASE(mesh);
+
+    char defines[32];
+    sprintf(defines, "SPRITE_FRAME_COUNT %u", _gpuFrameCount);
+    Material* material = Material::create(PARTICLE_GPU_VSH, PARTICLE_GPU_FSH, defines);
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create material for GPU simulated particle emitter.");
+        SAFE_RELEASE(_gpuModel);
+        return false;
+    }
+    material->getParameter("u_texture")->setValue(_spriteBatch->getSampler());
+    material->getStateBlock()->setDepthWrite(false);
+    material->getStateBlock()->setDepthTest(true);
+    applyTextureBlending(material->getStateBlock(), _spriteTextureBlending);
+    _gpuModel->setMaterial(material);
+    SAFE_RELEASE(material);
+
+    return true;
+}
+
+void ParticleEmitter::drawGPU()
+{
+    GP_ASSERT(_node);
+
+    if (_gpuModel == NULL || _gpuFrameCount != std::min(_spriteFrameCount, (unsigned int)PARTICLE_GPU_FRAME_COUNT_MAX))
+    {
+        // A recorded frame has no graphics context, so the model is created between frames.
+        if (CommandBuffer::getRecording())
+        {
+            if (std::find(__pendingGPUModels.begin(), __pendingGPUModels.end(), this) == __pendingGPUModels.end())
+            {
+                addRef();
+                __pendingGPUModels.push_back(this);
+            }
+            return;
+        }
+        if (!createGPUModel())
+            return;
+    }
+
+    // Particles always face the camera.
+    GP_ASSERT(_node->getScene() && _node->getScene()->getActiveCamera() && _node->getScene()->getActiveCamera()->getNode());
+    const Matrix& cameraWorldMatrix = _node->getScene()->getActiveCamera()->getNode()->getWorldMatrix();
+    Vector3 right;
+    cameraWorldMatrix.getRightVector(&right);
+    Vector3 up;
+    cameraWorldMatrix.getUpVector(&up);
+
+    Material* material = _gpuModel->getMaterial();
+    GP_ASSERT(material);
+    material->getParameter("u_worldMatrix")->setValue(_node->getWorldMatrix());
+    material->getParameter("u_viewProjectionMatrix")->setValue(_node->getViewProjectionMatrix());
+    material->getParameter("u_cameraRight")->setValue(right);
+    material->getParameter("u_cameraUp")->setValue(up);
+    material->getParameter("u_time")->setValue(Vector4((float)_gpuTime, (float)std::min(_gpuStopTime, (double)FLT_MAX), (float)_emissionRate, (float)_gpuSlotCount));
+    material->getParameter("u_energy")->setValue(Vector2(_energyMin * 0.001f, _energyMax * 0.001f));
+    material->getParameter("u_position")->setValue(_position);
+    material->getParameter("u_positionVar")->setValue(_positionVar);
+    material->getParameter("u_velocity")->setValue(_velocity);
+    material->getParameter("u_velocityVar")->setValue(_velocityVar);
+    material->getParameter("u_acceleration")->setValue(_acceleration);
+    material->getParameter("u_accelerationVar")->setValue(_accelerationVar);
+    material->getParameter("u_colorStart")->setValue(_colorStart);
+    material->getParameter("u_colorStartVar")->setValue(_colorStartVar);
+    material->getParameter("u_colorEnd")->setValue(_colorEnd);
+    material->getParameter("u_colorEndVar")->setValue(_colorEndVar);
+    material->getParameter("u_size")->setValue(Vector4(_sizeStartMin, _sizeStartMax, _sizeEndMin, _sizeEndMax));
+    material->getParameter("u_rotationPerParticleSpeed")->setValue(Vector2(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax));
+    material->getParameter("u_sprite")->setValue(Vector4(_ellipsoid ? 1.0f : 0.0f, _spriteAnimated ? 1.0f : 0.0f, _spriteLooped ? 1.0f : 0.0f, _spriteFrameDurationSecs));
+    material->getParameter("u_spriteFrameRandomOffset")->setValue((float)_spriteFrameRandomOffset);
+    material->getParameter("u_spriteFrames")->setValue((const Vector4*)_spriteTextureCoords, _gpuFrameCount);
+
+    _gpuModel->draw();
+}
+
+void ParticleEmitter::updateGPUModels()
+{
+    for (size_t i = 0, count = __pendingGPUModels.size(); i < count; ++i)
+    {
+        ParticleEmitter* emitter = __pendingGPUModels[i];
+        if (emitter->_gpuSimulated && (emitter->_gpuModel == NULL ||
+            emitter->_gpuFrameCount != std::min(emitter->_spriteFrameCount, (unsigned int)PARTICLE_GPU_FRAME_COUNT_MAX)))
+        {
+            emitter->createGPUModel();
+        }
+        SAFE_RELEASE(emitter);
+    }
+    __pendingGPUModels.clear();
+}
+
 ParticleEmitter* ParticleEmitter::clone()
 {
     // Create a clone of this emitter
@@ -1066,6 +1734,9 @@ ParticleEmitter* ParticleEmitter::clone()
     emitter->_orbitPosition = _orbitPosition;
     emitter->_orbitVelocity = _orbitVelocity;
     emitter->_orbitAcceleration = _orbitAcceleration;
+    emitter->setGPUSimulated(_gpuSimulated);
+    emitter->_offscreenMode = _offscreenMode;
+    emitter->_depthSorted = _depthSorted;
 
     return emitter;
 }
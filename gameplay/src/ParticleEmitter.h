@@ -9,11 +9,13 @@
 #include "Rectangle.h"
 #include "SpriteBatch.h"
 #include "Properties.h"
+#include "BoundingSphere.h"
 
 namespace gameplay
 {
 
 class Node;
+class Model;
 
 /**
  * Defines a particle emitter that can be made to simulate and render a particle system.
@@ -136,11 +138,34 @@ class Node;
  * be set before rendering the particle system and then will be reset to their original
  * values.  Accepts the same symbolic constants as glBlendFunc().
  *
+ * <h2>GPU simulation:</h2>
+ *
+ * An emitter can optionally be simulated entirely on the GPU (see setGPUSimulated()).
+ * In this mode each particle is evaluated in the vertex shader as a closed-form function
+ * of the emitter properties and the particle's age, so update() only advances the
+ * emitter's time.  This is well suited to large ambient effects such as rain or dust.
+ *
+ * <h2>Bounds and off-screen emitters:</h2>
+ *
+ * The bounds of an emitter are computed conservatively from the ranges of its initial
+ * positions, velocities, accelerations, energies and sizes, and are included in the bounds
+ * of its node. An emitter can skip updates while its bounds are outside the view of the
+ * active camera (see setOffscreenMode()), which suits ambient emitters that are rarely seen.
+ *
+ * <h2>Depth sorting:</h2>
+ *
+ * Particles are drawn in the order they are stored, which is only correct for additive and
+ * multiplied blending. Alpha-blended effects such as smoke can be drawn back to front instead
+ * (see setDepthSorted()), and overlapping emitters can be drawn with their particles merged
+ * into a single back to front order (see drawSorted()).
+ *
  * @see http://blackberry.github.io/GamePlay/docs/file-formats.html#wiki-Particles
  */
 class ParticleEmitter : public Ref
 {
     friend class Node;
+    friend class SceneSnapshot;
+    friend class Game;
 
 public:
 
@@ -155,6 +180,22 @@ public:
         BLEND_MULTIPLIED
     };
 
+    /**
+     * Defines how an emitter is updated while its bounds are outside the view of the active camera.
+     */
+    enum OffscreenMode
+    {
+        /** The emitter is updated as when it is in view (default). */
+        OFFSCREEN_UPDATE,
+        /** The emitter is not updated, and continues from where it stopped when it comes back in view. */
+        OFFSCREEN_PAUSE,
+        /**
+         * The emitter is not updated, and catches up with the time it spent out of view in a few
+         * coarse steps when it comes back in view, so it looks as if it had been updated all along.
+         */
+        OFFSCREEN_FAST_FORWARD
+    };
+
     /**
      * Creates a particle emitter using the data from the Properties object defined at the specified URL, 
      * where the URL is of the format "<file-path>.<extension>#<namespace-id>/<namespace-id>/.../<namespace-id>"
@@ -218,6 +259,9 @@ public:
     /**
      * Sets the maximum number of particles that can be emitted.
      *
+     * If the new maximum is lower than the number of living particles,
+     * the excess particles are discarded.
+     *
      * @param max The maximum number of particles that can be emitted.
      */
     void setParticleCountMax(unsigned int max);
@@ -284,6 +328,79 @@ public:
      */
     void emitOnce(unsigned int particleCount);
 
+    /**
+     * Sets whether the particles of this emitter are simulated on the GPU.
+     *
+     * When enabled, a static vertex buffer holding one billboard for each of the emitter's
+     * particle slots is drawn, and every particle is computed in the vertex shader from its
+     * slot, a random seed and the emitter's time.  Particles are emitted continuously at the
+     * emission rate and are simulated in the coordinate space of the emitter's node, so they
+     * follow the node as it moves.  The rotation axis and orbit properties are not supported
+     * in this mode and emitOnce() has no effect.
+     *
+     * @param simulated true to simulate particles on the GPU, false to simulate them on the CPU.
+     */
+    void setGPUSimulated(bool simulated);
+
+    /**
+     * Gets whether the particles of this emitter are simulated on the GPU.
+     *
+     * @return true if the particles are simulated on the GPU.
+     */
+    bool isGPUSimulated() const;
+
+    /**
+     * Sets how the emitter is updated while its bounds are outside the view of the active camera
+     * of its node's scene.
+     *
+     * This can also be set with the offscreen property of a particle file (UPDATE, PAUSE or FAST_FORWARD).
+     *
+     * @param mode The off-screen mode.
+     * @script{ignore}
+     */
+    void setOffscreenMode(OffscreenMode mode);
+
+    /**
+     * Gets how the emitter is updated while it is out of view.
+     *
+     * @return The off-screen mode.
+     * @script{ignore}
+     */
+    OffscreenMode getOffscreenMode() const;
+
+    /**
+     * Sets whether the particles of this emitter are drawn sorted back to front from the active camera.
+     *
+     * The particles are sorted each time they are drawn, with a radix sort on their depths
+     * quantized to 16 bits, and the depths of large emitters are computed across the job worker
+     * threads. Particles simulated on the GPU are not sorted.
+     *
+     * This can also be set with the depthSorted property of a particle file.
+     *
+     * @param sorted true to draw the particles back to front, false to draw them in storage order.
+     * @script{ignore}
+     */
+    void setDepthSorted(bool sorted);
+
+    /**
+     * Gets whether the particles of this emitter are drawn sorted back to front.
+     *
+     * @return true if the particles are depth sorted.
+     * @script{ignore}
+     */
+    bool isDepthSorted() const;
+
+    /**
+     * Gets a conservative bounding sphere of the particles of this emitter, in the space of its node.
+     *
+     * The sphere contains every position a particle can reach in its lifetime with the current
+     * emitter properties, measured from the origin of the node.
+     *
+     * @return The bounding sphere.
+     * @script{ignore}
+     */
+    const BoundingSphere& getBoundingSphere() const;
+
     /**
      * Gets the current number of particles.
      *
@@ -704,11 +821,33 @@ public:
      */
     unsigned int draw();
 
+    /**
+     * Draws several emitters with their particles merged and sorted back to front, whether or not
+     * the emitters are depth sorted, so that overlapping effects such as fire and smoke blend correctly.
+     *
+     * The emitters must be drawn by the same active camera. An emitter is drawn on its own if it is
+     * simulated on the GPU, or if the active camera of its node's scene is not the one of the
+     * first emitter. The sprite batch of an emitter is flushed each time the sorted order moves
+     * to another emitter, so effects that are far apart cost no more than drawing them in turn.
+     *
+     * @param emitters The emitters to draw.
+     * @param count The number of emitters.
+     *
+     * @return The number of batches drawn.
+     * @script{ignore}
+     */
+    static unsigned int drawSorted(ParticleEmitter** emitters, unsigned int count);
+
     /**
      * Gets a TextureBlending enum from a corresponding string.
      */
     static TextureBlending getTextureBlendingFromString(const char* src);
 
+    /**
+     * Gets an OffscreenMode enum from a corresponding string, or OFFSCREEN_UPDATE if the string is NULL.
+     */
+    static OffscreenMode getOffscreenModeFromString(const char* src);
+
     /**
      * Sets the texture blend mode for this particle emitter.
      *
@@ -779,34 +918,156 @@ private:
     void generateColor(const Vector4& base, const Vector4& variance, Vector4* dst);
 
     /**
-     * Defines the data for a single particle in the system.
+     * Applies the specified texture blending to a render state block.
+     */
+    static void applyTextureBlending(RenderState::StateBlock* stateBlock, TextureBlending textureBlending);
+
+    /**
+     * Creates the static particle model used for GPU simulation.
+     */
+    bool createGPUModel();
+
+    /**
+     * Draws the particles when simulated on the GPU.
+     */
+    void drawGPU();
+
+    /**
+     * Creates the models of the GPU simulated emitters drawn by recorded frames. Called by Game between frames.
+     */
+    static void updateGPUModels();
+
+    /**
+     * Draws the particles in the order they are stored.
+     */
+    unsigned int drawUnsorted();
+
+    /**
+     * Draws the particle at the specified index as a billboard facing the camera.
+     */
+    void drawParticle(unsigned int index, const Vector3& right, const Vector3& up);
+
+    /**
+     * Defines the arguments of a parallel computation of particle depths.
+     */
+    struct SortContext
+    {
+        ParticleEmitter* emitter;
+        Vector3 eye;
+        Vector3 forward;
+        float* depths;
+    };
+
+    /**
+     * Computes the depths from the camera of the particles in the range [start, end).
      */
-    class Particle
+    void computeDepths(unsigned int start, unsigned int end, const Vector3& eye, const Vector3& forward, float* depths) const;
+
+    /**
+     * Job scheduler entry point for computing the depths of a range of particles.
+     */
+    static void computeDepthRange(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Defines the arguments of a parallel particle update.
+     */
+    struct UpdateContext
     {
+        ParticleEmitter* emitter;
+        float elapsedSecs;
+    };
 
-    public:
-        Vector3 _position;
-        Vector3 _velocity;
-        Vector3 _acceleration;
-        Vector4 _colorStart;
-        Vector4 _colorEnd;
-        Vector4 _color;
-        float _rotationPerParticleSpeed;
-        Vector3 _rotationAxis;
-        float _rotationSpeed;
-        float _angle;
-        long _energyStart;
-        long _energy;
-        float _sizeStart;
-        float _sizeEnd;
-        float _size;
-        unsigned int _frame;
-        float _timeOnCurrentFrame;
+    /**
+     * Advances the emission and the particles by the given time.
+     */
+    void simulate(float elapsedMs);
+
+    /**
+     * Catches up with the time the emitter spent out of view, in coarse steps.
+     */
+    void fastForward();
+
+    /**
+     * Determines if the bounds of the emitter are in the view of the active camera of its node's scene.
+     */
+    bool isVisible() const;
+
+    /**
+     * Marks the bounds of the emitter and of its node as dirty, after a property they depend on changed.
+     */
+    void setBoundsDirty();
+
+    /**
+     * Updates the particles in the range [start, end), where start is a multiple of 4.
+     */
+    void updateParticles(unsigned int start, unsigned int end, float elapsedSecs);
+
+    /**
+     * Job scheduler entry point for updating a range of particles.
+     */
+    static void updateParticleRange(void* arg, unsigned int start, unsigned int end);
+
+    /**
+     * Allocates storage for the specified maximum number of particles,
+     * preserving as many of the currently living particles as fit.
+     */
+    void allocateParticles(unsigned int particleCountMax);
+
+    /**
+     * Removes the particle at the specified index by moving the last living particle into its place.
+     */
+    void removeParticle(unsigned int index);
+
+    /**
+     * Identifies the per-particle data streams.
+     *
+     * Particle data is stored as a structure of arrays, with one 16-byte aligned
+     * array of floats per particle component, so that the update can integrate
+     * several particles at a time with SIMD instructions.
+     */
+    enum ParticleStream
+    {
+        PARTICLE_POSITION_X,
+        PARTICLE_POSITION_Y,
+        PARTICLE_POSITION_Z,
+        PARTICLE_VELOCITY_X,
+        PARTICLE_VELOCITY_Y,
+        PARTICLE_VELOCITY_Z,
+        PARTICLE_ACCELERATION_X,
+        PARTICLE_ACCELERATION_Y,
+        PARTICLE_ACCELERATION_Z,
+        PARTICLE_COLOR_START_R,
+        PARTICLE_COLOR_START_G,
+        PARTICLE_COLOR_START_B,
+        PARTICLE_COLOR_START_A,
+        PARTICLE_COLOR_END_R,
+        PARTICLE_COLOR_END_G,
+        PARTICLE_COLOR_END_B,
+        PARTICLE_COLOR_END_A,
+        PARTICLE_COLOR_R,
+        PARTICLE_COLOR_G,
+        PARTICLE_COLOR_B,
+        PARTICLE_COLOR_A,
+        PARTICLE_SIZE_START,
+        PARTICLE_SIZE_END,
+        PARTICLE_SIZE,
+        PARTICLE_ROTATION_PER_PARTICLE_SPEED,
+        PARTICLE_ANGLE,
+        PARTICLE_ROTATION_AXIS_X,
+        PARTICLE_ROTATION_AXIS_Y,
+        PARTICLE_ROTATION_AXIS_Z,
+        PARTICLE_ROTATION_SPEED,
+        PARTICLE_PERCENT,
+        PARTICLE_ENERGY_INVERSE,
+        PARTICLE_FRAME,
+        PARTICLE_TIME_ON_CURRENT_FRAME,
+        PARTICLE_STREAM_COUNT
     };
 
     unsigned int _particleCountMax;
     unsigned int _particleCount;
-    Particle* _particles;
+    float* _particleData;
+    float* _particleStreams[PARTICLE_STREAM_COUNT];
     unsigned int _emissionRate;
     bool _started;
     bool _ellipsoid;
@@ -832,7 +1093,6 @@ private:
     float _rotationSpeedMax;
     Vector3 _rotationAxis;
     Vector3 _rotationAxisVar;
-    Matrix _rotation;
     SpriteBatch* _spriteBatch;
     TextureBlending _spriteTextureBlending;
     float _spriteTextureWidth;
@@ -854,6 +1114,18 @@ private:
     float _timePerEmission;
     float _emitTime;
     double _lastUpdated;
+    bool _gpuSimulated;
+    Model* _gpuModel;
+    unsigned int _gpuSlotCount;
+    unsigned int _gpuFrameCount;
+    double _gpuTime;
+    double _gpuStopTime;
+    double _updateTime;
+    OffscreenMode _offscreenMode;
+    double _offscreenTime;
+    bool _depthSorted;
+    mutable BoundingSphere _bounds;
+    mutable bool _boundsDirty;
 };
 
 }
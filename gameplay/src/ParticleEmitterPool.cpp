@@ -0,0 +1,207 @@
+#include "Base.h"
+#include "ParticleEmitterPool.h"
+
+namespace gameplay
+{
+
+ParticleEmitterPool::ParticleEmitterPool(Scene* scene)
+    : _scene(scene), _instanceCount(0)
+{
+    GP_ASSERT(_scene);
+    _scene->addRef();
+}
+
+ParticleEmitterPool::~ParticleEmitterPool()
+{
+    for (size_t i = 0, count = _instances.size(); i < count; ++i)
+    {
+        Node* node = _instances[i].node;
+        _scene->removeNode(node);
+        SAFE_RELEASE(node);
+    }
+    for (std::map<std::string, Effect*>::iterator itr = _effects.begin(); itr != _effects.end(); ++itr)
+    {
+        Effect* effect = itr->second;
+        for (size_t i = 0, count = effect->freeNodes.size(); i < count; ++i)
+        {
+            SAFE_RELEASE(effect->freeNodes[i]);
+        }
+        SAFE_RELEASE(effect->emitter);
+        SAFE_DELETE(effect);
+    }
+    SAFE_RELEASE(_scene);
+}
+
+ParticleEmitterPool* ParticleEmitterPool::create(Scene* scene)
+{
+    GP_ASSERT(scene);
+    return new ParticleEmitterPool(scene);
+}
+
+ParticleEmitter* ParticleEmitterPool::emitAt(const char* url, const Vector3& position, float duration)
+{
+    Effect* effect = getEffect(url);
+    if (effect == NULL)
+        return NULL;
+
+    Node* node;
+    if (!effect->freeNodes.empty())
+    {
+        node = effect->freeNodes.back();
+        effect->freeNodes.pop_back();
+    }
+    else
+    {
+        node = createInstance(effect);
+    }
+
+    // The node must be in the scene and in place before emitting, since particles are emitted in world space.
+    node->setTranslation(position);
+    _scene->addNode(node);
+
+    ParticleEmitter* emitter = node->getParticleEmitter();
+    GP_ASSERT(emitter);
+    if (emitter->isGPUSimulated() && duration <= 0)
+    {
+        duration = (float)emitter->getEnergyMax();
+    }
+    if (duration > 0)
+    {
+        emitter->start();
+    }
+    else
+    {
+        emitter->emitOnce(emitter->getParticleCountMax());
+    }
+
+    Instance instance;
+    instance.node = node;
+    instance.effect = effect;
+    instance.remainingTime = duration;
+    _instances.push_back(instance);
+    ++effect->activeCount;
+
+    return emitter;
+}
+
+bool ParticleEmitterPool::reserve(const char* url, unsigned int count)
+{
+    Effect* effect = getEffect(url);
+    if (effect == NULL)
+        return false;
+
+    while (effect->freeNodes.size() < count)
+    {
+        effect->freeNodes.push_back(createInstance(effect));
+    }
+    return true;
+}
+
+void ParticleEmitterPool::update(float elapsedTime)
+{
+    for (size_t i = 0; i < _instances.size(); )
+    {
+        Instance& instance = _instances[i];
+        ParticleEmitter* emitter = instance.node->getParticleEmitter();
+        GP_ASSERT(emitter);
+
+        if (instance.remainingTime > 0)
+        {
+            instance.remainingTime -= elapsedTime;
+            if (instance.remainingTime <= 0)
+                emitter->stop();
+        }
+        emitter->update(elapsedTime);
+
+        if (emitter->isActive())
+        {
+            ++i;
+            continue;
+        }
+
+        // The instance finished, so take it out of the scene and keep it for the next emission.
+        // Removing the node from the scene releases the reference the scene holds.
+        _scene->removeNode(instance.node);
+        instance.effect->freeNodes.push_back(instance.node);
+        --instance.effect->activeCount;
+        instance = _instances.back();
+        _instances.pop_back();
+    }
+}
+
+void ParticleEmitterPool::clear()
+{
+    for (std::map<std::string, Effect*>::iterator itr = _effects.begin(); itr != _effects.end(); )
+    {
+        Effect* effect = itr->second;
+        _instanceCount -= (unsigned int)effect->freeNodes.size();
+        for (size_t i = 0, count = effect->freeNodes.size(); i < count; ++i)
+        {
+            SAFE_RELEASE(effect->freeNodes[i]);
+        }
+        effect->freeNodes.clear();
+
+        if (effect->activeCount == 0)
+        {
+            SAFE_RELEASE(effect->emitter);
+            SAFE_DELETE(effect);
+            _effects.erase(itr++);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+}
+
+Scene* ParticleEmitterPool::getScene() const
+{
+    return _scene;
+}
+
+unsigned int ParticleEmitterPool::getActiveCount() const
+{
+    return (unsigned int)_instances.size();
+}
+
+unsigned int ParticleEmitterPool::getInstanceCount() const
+{
+    return _instanceCount;
+}
+
+ParticleEmitterPool::Effect* ParticleEmitterPool::getEffect(const char* url)
+{
+    GP_ASSERT(url);
+
+    std::map<std::string, Effect*>::iterator itr = _effects.find(url);
+    if (itr != _effects.end())
+        return itr->second;
+
+    ParticleEmitter* emitter = ParticleEmitter::create(url);
+    if (emitter == NULL)
+    {
+        GP_ERROR("Failed to load particle effect '%s' for the emitter pool.", url);
+        return NULL;
+    }
+
+    Effect* effect = new Effect();
+    effect->emitter = emitter;
+    effect->activeCount = 0;
+    _effects[url] = effect;
+    return effect;
+}
+
+Node* ParticleEmitterPool::createInstance(Effect* effect)
+{
+    GP_ASSERT(effect && effect->emitter);
+
+    // Instances are cloned from the template, so the particle file is only parsed once.
+    ParticleEmitter* emitter = effect->emitter->clone();
+    Node* node = Node::create();
+    node->setParticleEmitter(emitter);
+    SAFE_RELEASE(emitter);
+    ++_instanceCount;
+    return node;
+}
+
+}
@@ -0,0 +1,157 @@
+#ifndef PARTICLEEMITTERPOOL_H_
+#define PARTICLEEMITTERPOOL_H_
+
+#include "ParticleEmitter.h"
+#include "Scene.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of particle emitters for short-lived effects such as explosions and impacts.
+ *
+ * Each particle file is loaded once, the first time it is emitted, and kept as a template.
+ * emitAt() places an instance of the template in the scene of the pool at the given position
+ * and emits it; the instance is updated by update() and returned to the pool once all of its
+ * particles have died, keeping its node, sprite batch and particle storage. The next
+ * emission of the same file reuses it, so steady-state effects load and allocate nothing.
+ *
+ * The instances are ordinary nodes of the scene with a particle emitter, drawn the same way
+ * as the other emitters of the scene. They must not be modified after they finish.
+ *
+ * @script{ignore}
+ */
+class ParticleEmitterPool : public Ref
+{
+public:
+
+    /**
+     * Creates a pool that emits into the given scene.
+     *
+     * @param scene The scene the instances are added to while they emit.
+     *
+     * @return The new pool.
+     */
+    static ParticleEmitterPool* create(Scene* scene);
+
+    /**
+     * Emits an instance of a particle effect at a position, returning it to the pool when it finishes.
+     *
+     * When duration is 0, the instance emits a single burst of particleCountMax particles. Otherwise
+     * it emits continuously at its emission rate for the duration. Emitters simulated on the GPU
+     * cannot emit bursts, so they emit for the lifetime of their particles when duration is 0.
+     *
+     * @param url The URL of the particle file, as given to ParticleEmitter::create().
+     * @param position The position to emit at, in world space.
+     * @param duration The time to emit for, in milliseconds, or 0 for a single burst.
+     *
+     * @return The emitting instance, owned by the pool, or NULL if the particle file could not be loaded.
+     */
+    ParticleEmitter* emitAt(const char* url, const Vector3& position, float duration = 0);
+
+    /**
+     * Creates instances of a particle effect ahead of time, so its first emissions do not allocate.
+     *
+     * @param url The URL of the particle file.
+     * @param count The number of free instances to keep for the effect.
+     *
+     * @return true if the particle file was loaded.
+     */
+    bool reserve(const char* url, unsigned int count);
+
+    /**
+     * Updates the emitting instances and returns the finished ones to the pool.
+     *
+     * This must be called each frame, in place of updating the instances individually.
+     *
+     * @param elapsedTime The elapsed game time, in milliseconds.
+     */
+    void update(float elapsedTime);
+
+    /**
+     * Frees the instances that are not emitting and the templates of the effects that have none emitting.
+     */
+    void clear();
+
+    /**
+     * Returns the scene the instances are added to.
+     *
+     * @return The scene.
+     */
+    Scene* getScene() const;
+
+    /**
+     * Returns the number of instances that are emitting.
+     *
+     * @return The number of active instances.
+     */
+    unsigned int getActiveCount() const;
+
+    /**
+     * Returns the number of instances allocated by the pool, including the emitting ones.
+     *
+     * @return The number of instances.
+     */
+    unsigned int getInstanceCount() const;
+
+private:
+
+    /**
+     * A particle effect and its free instances.
+     */
+    struct Effect
+    {
+        ParticleEmitter* emitter;
+        std::vector<Node*> freeNodes;
+        unsigned int activeCount;
+    };
+
+    /**
+     * An emitting instance.
+     */
+    struct Instance
+    {
+        Node* node;
+        Effect* effect;
+        float remainingTime;
+    };
+
+    /**
+     * Constructor.
+     */
+    ParticleEmitterPool(Scene* scene);
+
+    /**
+     * Destructor.
+     */
+    ~ParticleEmitterPool();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ParticleEmitterPool(const ParticleEmitterPool& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ParticleEmitterPool& operator=(const ParticleEmitterPool&);
+
+    /**
+     * Returns the effect of a particle file, loading its template the first time.
+     */
+    Effect* getEffect(const char* url);
+
+    /**
+     * Creates a node holding a new instance of an effect.
+     */
+    Node* createInstance(Effect* effect);
+
+    Scene* _scene;
+    std::map<std::string, Effect*> _effects;
+    std::vector<Instance> _instances;
+    unsigned int _instanceCount;
+};
+
+}
+
+#endif
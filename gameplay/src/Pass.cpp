@@ -4,17 +4,22 @@
 #include "Material.h"
 #include "Node.h"
 
+// The fragment shader of the depth passes, which only writes depth.
+#define PASS_DEPTH_FRAGMENT_SHADER "res/shaders/depth.frag"
+
 namespace gameplay
 {
 
 Pass::Pass(const char* id, Technique* technique) :
-    _id(id ? id : ""), _technique(technique), _effect(NULL), _vaBinding(NULL)
+    _id(id ? id : ""), _technique(technique), _effect(NULL), _vaBinding(NULL), _bindListRevision(0),
+    _depthPass(NULL), _depthPassLoaded(false)
 {
     RenderState::_parent = _technique;
 }
 
 Pass::~Pass()
 {
+    SAFE_RELEASE(_depthPass);
     SAFE_RELEASE(_effect);
     SAFE_RELEASE(_vaBinding);
 }
@@ -24,8 +29,12 @@ bool Pass::initialize(const char* vshPath, const char* fshPath, const char* defi
     GP_ASSERT(vshPath);
     GP_ASSERT(fshPath);
 
+    SAFE_RELEASE(_depthPass);
     SAFE_RELEASE(_effect);
     SAFE_RELEASE(_vaBinding);
+    _depthPassLoaded = false;
+    _vshPath = vshPath;
+    _defines = defines ? defines : "";
 
     // Attempt to create/load the effect.
     _effect = Effect::createFromFile(vshPath, fshPath, defines);
@@ -52,6 +61,12 @@ void Pass::setVertexAttributeBinding(VertexAttributeBinding* binding)
 {
     SAFE_RELEASE(_vaBinding);
 
+    // The depth pass is bound to the new mesh when it is next used.
+    if (_depthPass)
+    {
+        _depthPass->setVertexAttributeBinding(NULL);
+    }
+
     if (binding)
     {
         _vaBinding = binding;
@@ -65,6 +80,11 @@ VertexAttributeBinding* Pass::getVertexAttributeBinding() const
 }
 
 void Pass::bind()
+{
+    bind(_vaBinding);
+}
+
+void Pass::bind(VertexAttributeBinding* binding)
 {
     GP_ASSERT(_effect);
 
@@ -75,19 +95,93 @@ void Pass::bind()
     RenderState::bind(this);
 
     // If we have a vertex attribute binding, bind it
-    if (_vaBinding)
+    if (binding)
     {
-        _vaBinding->bind();
+        binding->bind();
     }
 }
 
 void Pass::unbind()
+{
+    unbind(_vaBinding);
+}
+
+void Pass::unbind(VertexAttributeBinding* binding)
 {
     // If we have a vertex attribute binding, unbind it
-    if (_vaBinding)
+    if (binding)
+    {
+        binding->unbind();
+    }
+}
+
+void Pass::compileBindList()
+{
+    GP_ASSERT(_effect);
+
+    _boundParameters.clear();
+    _boundStates.clear();
+
+    // Walk up from the pass, so the first parameter found for a uniform is the one that overrides the others.
+    for (RenderState* rs = this; rs != NULL; rs = rs->_parent)
+    {
+        if (rs->_state)
+        {
+            _boundStates.insert(_boundStates.begin(), rs->_state);
+        }
+
+        for (size_t i = rs->_parameters.size(); i > 0; --i)
+        {
+            MaterialParameter* param = rs->_parameters[i - 1];
+            GP_ASSERT(param);
+            Uniform* uniform = param->findUniform(_effect);
+            if (uniform == NULL)
+                continue;
+
+            bool overridden = false;
+            for (size_t j = 0, count = _boundParameters.size(); j < count && !overridden; ++j)
+            {
+                overridden = _boundParameters[j].uniform == uniform;
+            }
+            if (!overridden)
+            {
+                BoundParameter bound = { param, uniform };
+                _boundParameters.push_back(bound);
+            }
+        }
+    }
+
+    _bindListRevision = RenderState::_bindListRevision;
+}
+
+Pass* Pass::getDepthPass(Mesh* mesh)
+{
+    if (!_depthPassLoaded)
+    {
+        _depthPassLoaded = true;
+        if (!_vshPath.empty())
+        {
+            Pass* pass = new Pass(getId(), _technique);
+            if (pass->initialize(_vshPath.c_str(), PASS_DEPTH_FRAGMENT_SHADER, _defines.c_str()))
+            {
+                // Inherit the parameters and renderer state of this pass.
+                pass->_parent = this;
+                _depthPass = pass;
+            }
+            else
+            {
+                SAFE_RELEASE(pass);
+            }
+        }
+    }
+
+    if (_depthPass && _depthPass->_vaBinding == NULL && _vaBinding && mesh)
     {
-        _vaBinding->unbind();
+        VertexAttributeBinding* binding = VertexAttributeBinding::create(mesh, _depthPass->_effect);
+        _depthPass->setVertexAttributeBinding(binding);
+        SAFE_RELEASE(binding);
     }
+    return _depthPass;
 }
 
 Pass* Pass::clone(Technique* technique, NodeCloneContext &context) const
@@ -97,6 +191,8 @@ Pass* Pass::clone(Technique* technique, NodeCloneContext &context) const
 
     Pass* pass = new Pass(getId(), technique);
     pass->_effect = _effect;
+    pass->_vshPath = _vshPath;
+    pass->_defines = _defines;
 
     RenderState::cloneInto(pass, context);
     pass->_parent = technique;
@@ -9,6 +9,7 @@ namespace gameplay
 
 class Technique;
 class NodeCloneContext;
+class Mesh;
 
 /**
  * Defines a pass for an object to be rendered.
@@ -22,6 +23,9 @@ class Pass : public RenderState
     friend class Technique;
     friend class Material;
     friend class RenderState;
+    friend class Model;
+    friend class RenderQueue;
+    friend class TerrainPatch;
 
 public:
 
@@ -105,10 +109,59 @@ private:
      */
     Pass* clone(Technique* technique, NodeCloneContext &context) const;
 
+    /**
+     * Binds the render state for this pass with the given vertex attribute binding
+     * instead of the pass's own (used to draw a different level of detail of a model).
+     */
+    void bind(VertexAttributeBinding* binding);
+
+    /**
+     * Unbinds the render state for this pass that was bound with the given vertex attribute binding.
+     */
+    void unbind(VertexAttributeBinding* binding);
+
+    /**
+     * A material parameter of the hierarchy of the pass, with the uniform of the pass's effect that it sets.
+     */
+    struct BoundParameter
+    {
+        MaterialParameter* parameter;
+        Uniform* uniform;
+    };
+
+    /**
+     * Collects the parameters and state blocks of the hierarchy (material, technique and pass)
+     * into the flat lists bound by RenderState::bind.
+     *
+     * A parameter overrides the parameters for the same uniform above it in the hierarchy,
+     * so each uniform is set once. Uniforms that the effect does not have are left out.
+     */
+    void compileBindList();
+
+    /**
+     * Returns the pass that draws the depth of this pass in the depth pre-pass of the render queues.
+     *
+     * The depth pass links the vertex shader and defines of this pass with a fragment shader that
+     * only writes depth, so it draws the same depths as this pass. It is a child of this pass, so it
+     * binds the same parameters and renderer state. It is created the first time it is needed.
+     *
+     * @param mesh The mesh to bind the depth pass to, if this pass is bound to it.
+     *
+     * @return The depth pass, or NULL if the effect of this pass was not loaded from files.
+     */
+    Pass* getDepthPass(Mesh* mesh);
+
     std::string _id;
     Technique* _technique;
     Effect* _effect;
     VertexAttributeBinding* _vaBinding;
+    std::vector<BoundParameter> _boundParameters;
+    std::vector<StateBlock*> _boundStates;
+    unsigned int _bindListRevision;
+    std::string _vshPath;
+    std::string _defines;
+    Pass* _depthPass;
+    bool _depthPassLoaded;
 };
 
 }
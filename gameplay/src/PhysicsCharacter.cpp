@@ -53,7 +53,8 @@ PhysicsCharacter::PhysicsCharacter(Node* node, const PhysicsCollisionShape::Defi
     : PhysicsGhostObject(node, shape, group, mask), _moveVelocity(0,0,0), _forwardVelocity(0.0f), _rightVelocity(0.0f),
     _verticalVelocity(0, 0, 0), _currentVelocity(0,0,0), _normalizedVelocity(0,0,0),
     _colliding(false), _collisionNormal(0,0,0), _currentPosition(0,0,0), _stepHeight(0.1f),
-    _slopeAngle(0.0f), _cosSlopeAngle(1.0f), _physicsEnabled(true), _mass(mass), _actionInterface(NULL)
+    _slopeAngle(0.0f), _cosSlopeAngle(1.0f), _physicsEnabled(true), _mass(mass),
+    _startPosition(0, 0, 0), _lodReduced(false)
 {
     setMaxSlopeAngle(45.0f);
 
@@ -61,19 +62,21 @@ PhysicsCharacter::PhysicsCharacter(Node* node, const PhysicsCollisionShape::Defi
     GP_ASSERT(_ghostObject);
     _ghostObject->setCollisionFlags(_ghostObject->getCollisionFlags() | btCollisionObject::CF_CHARACTER_OBJECT | btCollisionObject::CF_NO_CONTACT_RESPONSE);
 
-    // Register ourselves as an action on the physics world so we are called back during physics ticks.
-    GP_ASSERT(Game::getInstance()->getPhysicsController() && Game::getInstance()->getPhysicsController()->_world);
-    _actionInterface = new ActionInterface(this);
-    Game::getInstance()->getPhysicsController()->_world->addAction(_actionInterface);
+    // Register ourselves with the controller, which updates all the characters together during physics ticks.
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(controller);
+    controller->_characters.push_back(this);
 }
 
 PhysicsCharacter::~PhysicsCharacter()
 {
-    // Unregister ourselves as action from world.
-    GP_ASSERT(Game::getInstance()->getPhysicsController() && Game::getInstance()->getPhysicsController()->_world);
-    Game::getInstance()->getPhysicsController()->_world->removeAction(_actionInterface);
-    SAFE_DELETE(_actionInterface);
-
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(controller);
+    std::vector<PhysicsCharacter*>::iterator itr = std::find(controller->_characters.begin(), controller->_characters.end(), this);
+    if (itr != controller->_characters.end())
+    {
+        controller->_characters.erase(itr);
+    }
 }
 
 PhysicsCharacter* PhysicsCharacter::create(Node* node, Properties* properties)
@@ -320,8 +323,6 @@ void PhysicsCharacter::stepUp(btCollisionWorld* collisionWorld, btScalar time)
 
 void PhysicsCharacter::stepForwardAndStrafe(btCollisionWorld* collisionWorld, float time)
 {
-    updateCurrentVelocity();
-
     // Calculate final velocity
     btVector3 velocity(_currentVelocity);
     velocity *= time; // since velocity is in meters per second
@@ -356,7 +357,8 @@ void PhysicsCharacter::stepForwardAndStrafe(btCollisionWorld* collisionWorld, fl
         updateTargetPositionFromCollision(targetPosition, _collisionNormal);
     }
 
-    int maxIter = 10;
+    // Distant characters only sweep once, sliding along the first surface they hit.
+    int maxIter = _lodReduced ? 1 : 10;
 
     GP_ASSERT(_ghostObject && _ghostObject->getBroadphaseHandle());
     GP_ASSERT(_collisionShape);
@@ -381,14 +383,8 @@ void PhysicsCharacter::stepForwardAndStrafe(btCollisionWorld* collisionWorld, fl
         {
             Vector3 normal(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
             PhysicsCollisionObject* o = Game::getInstance()->getPhysicsController()->getCollisionObject(callback.m_hitCollisionObject);
-            GP_ASSERT(o);
-            if (o->getType() == PhysicsCollisionObject::RIGID_BODY && o->isDynamic())
-            {
-                PhysicsRigidBody* rb = static_cast<PhysicsRigidBody*>(o);
-                GP_ASSERT(rb);
-                normal.normalize();
-                rb->applyImpulse(_mass * -normal * velocity.length());
-            }
+            normal.normalize();
+            addImpulse(o, _mass * -normal * velocity.length());
 
             updateTargetPositionFromCollision(targetPosition, callback.m_hitNormalWorld);
 
@@ -437,7 +433,7 @@ void PhysicsCharacter::stepDown(btCollisionWorld* collisionWorld, btScalar time)
     end.setIdentity();
 
     btScalar fraction = 1.0;
-    int maxIter = 10;
+    int maxIter = _lodReduced ? 1 : 10;
     while (fraction > btScalar(0.01) && maxIter-- > 0)
     {
         start.setOrigin(_currentPosition);
@@ -471,14 +467,7 @@ void PhysicsCharacter::stepDown(btCollisionWorld* collisionWorld, btScalar time)
             else
             {
                 PhysicsCollisionObject* o = Game::getInstance()->getPhysicsController()->getCollisionObject(callback.m_hitCollisionObject);
-                GP_ASSERT(o);
-                if (o->getType() == PhysicsCollisionObject::RIGID_BODY && o->isDynamic())
-                {
-                    PhysicsRigidBody* rb = static_cast<PhysicsRigidBody*>(o);
-                    GP_ASSERT(rb);
-                    normal.normalize();
-                    rb->applyImpulse(_mass * -normal * sqrt(BV(normal).dot(_verticalVelocity)));
-                }
+                addImpulse(o, _mass * -normal * sqrt(BV(normal).dot(_verticalVelocity)));
 
                 updateTargetPositionFromCollision(targetPosition, BV(normal));
             }
@@ -634,21 +623,16 @@ bool PhysicsCharacter::fixCollision(btCollisionWorld* world)
     return collision;
 }
 
-PhysicsCharacter::ActionInterface::ActionInterface(PhysicsCharacter* character) : character(character)
-{
-}
-
-void PhysicsCharacter::ActionInterface::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
-{
-    character->updateAction(collisionWorld, deltaTimeStep);
-}
-
-void PhysicsCharacter::ActionInterface::debugDraw(btIDebugDraw* debugDrawer)
+void PhysicsCharacter::addImpulse(PhysicsCollisionObject* object, const Vector3& impulse)
 {
-    // Not used yet.
+    GP_ASSERT(object);
+    if (object->getType() == PhysicsCollisionObject::RIGID_BODY && object->isDynamic())
+    {
+        _impulses.push_back(std::make_pair(static_cast<PhysicsRigidBody*>(object), impulse));
+    }
 }
 
-void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+void PhysicsCharacter::beginUpdate(btCollisionWorld* collisionWorld)
 {
     GP_ASSERT(_ghostObject);
     GP_ASSERT(_node);
@@ -659,15 +643,17 @@ void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar d
     // the following steps (movement) start from a clean slate, where the character
     // is not colliding with anything. Also, this step handles collision between
     // dynamic objects (i.e. objects that moved and now intersect the character).
+    // Distant characters only resolve their penetrations once, since they are not looked at closely.
     if (_physicsEnabled)
     {
         _colliding = false;
         int stepCount = 0;
+        int maxSteps = _lodReduced ? 0 : 4;
         while (fixCollision(collisionWorld))
         {
             _colliding = true;
 
-            if (++stepCount > 4)
+            if (++stepCount > maxSteps)
             {
                 // Most likely we are wedged between a number of different collision objects.
                 break;
@@ -676,9 +662,15 @@ void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar d
     }
 
     // Update current and target world positions.
-    btVector3 startPosition = _ghostObject->getWorldTransform().getOrigin();
-    _currentPosition = startPosition;
+    _startPosition = _ghostObject->getWorldTransform().getOrigin();
+    _currentPosition = _startPosition;
 
+    // The velocity depends on the world matrix of the node, which must not be computed while the characters move.
+    updateCurrentVelocity();
+}
+
+void PhysicsCharacter::move(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+{
     // Process movement in the up direction.
     if (_physicsEnabled)
         stepUp(collisionWorld, deltaTimeStep);
@@ -689,13 +681,23 @@ void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar d
     // Process movement in the down direction.
     if (_physicsEnabled)
         stepDown(collisionWorld, deltaTimeStep);
+}
+
+void PhysicsCharacter::endUpdate()
+{
+    GP_ASSERT(_node);
+
+    for (size_t i = 0, count = _impulses.size(); i < count; ++i)
+    {
+        _impulses[i].first->applyImpulse(_impulses[i].second);
+    }
+    _impulses.clear();
 
     // Set new position.
-    btVector3 newPosition = _currentPosition - startPosition;
+    btVector3 newPosition = _currentPosition - _startPosition;
     Vector3 translation = Vector3(newPosition.x(), newPosition.y(), newPosition.z());
     if (translation !=  Vector3::zero())
         _node->translate(translation);
 }
 
-
 }
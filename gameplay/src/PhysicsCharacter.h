@@ -24,6 +24,7 @@ namespace gameplay
 class PhysicsCharacter : public PhysicsGhostObject
 {
     friend class Node;
+    friend class PhysicsController;
 
 public:
 
@@ -233,23 +234,27 @@ private:
     bool fixCollision(btCollisionWorld* world);
 
     /**
-     * Hides the callback interfaces within the PhysicsCharacter.
-     * @script{ignore}
+     * Resolves the penetrations of the character and prepares its movement for the step.
+     * Called by the controller for every character before they move.
      */
-    class ActionInterface : public btActionInterface
-    {
-    public:
+    void beginUpdate(btCollisionWorld* collisionWorld);
 
-        ActionInterface(PhysicsCharacter* character);
-
-        void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+    /**
+     * Sweeps the character along its movement for the step. This only reads the world and the
+     * character itself, so the controller moves the characters in parallel.
+     */
+    void move(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
 
-        void debugDraw(btIDebugDraw* debugDrawer);
-        
-        PhysicsCharacter* character;
-    };
+    /**
+     * Applies the impulses gathered while moving and moves the node of the character.
+     * Called by the controller for every character after they moved.
+     */
+    void endUpdate();
 
-    void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+    /**
+     * Queues an impulse on a dynamic rigid body hit while moving, applied by endUpdate().
+     */
+    void addImpulse(PhysicsCollisionObject* object, const Vector3& impulse);
 
     btVector3 _moveVelocity;
     float _forwardVelocity;
@@ -266,7 +271,9 @@ private:
     float _cosSlopeAngle;
     bool _physicsEnabled;
     float _mass;
-    ActionInterface* _actionInterface;
+    btVector3 _startPosition;
+    bool _lodReduced;
+    std::vector<std::pair<PhysicsRigidBody*, Vector3> > _impulses;
 };
 
 }
@@ -231,7 +231,7 @@ bool PhysicsCollisionObject::CollisionPair::operator < (const CollisionPair& col
 }
 
 PhysicsCollisionObject::PhysicsMotionState::PhysicsMotionState(Node* node, PhysicsCollisionObject* collisionObject, const Vector3* centerOfMassOffset) :
-    _node(node), _collisionObject(collisionObject), _centerOfMassOffset(btTransform::getIdentity())
+    _node(node), _collisionObject(collisionObject), _centerOfMassOffset(btTransform::getIdentity()), _pending(false)
 {
     if (centerOfMassOffset)
     {
@@ -251,7 +251,8 @@ void PhysicsCollisionObject::PhysicsMotionState::getWorldTransform(btTransform &
     GP_ASSERT(_node);
     GP_ASSERT(_collisionObject);
 
-    if (_collisionObject->isKinematic())
+    // Kinematic transforms are refreshed by the controller before a background step, since nodes only belong to the game thread.
+    if (_collisionObject->isKinematic() && !Game::getInstance()->getPhysicsController()->_deferEvents)
         updateTransformFromNode();
 
     transform = _centerOfMassOffset.inverse() * _worldTransform;
@@ -262,10 +263,24 @@ void PhysicsCollisionObject::PhysicsMotionState::setWorldTransform(const btTrans
     GP_ASSERT(_node);
 
     _worldTransform = transform * _centerOfMassOffset;
-        
+
+    // A background step leaves the node to be updated when the controller publishes the step.
+    if (Game::getInstance()->getPhysicsController()->_deferEvents)
+    {
+        _pending = true;
+        return;
+    }
+    updateNodeFromTransform();
+}
+
+void PhysicsCollisionObject::PhysicsMotionState::updateNodeFromTransform()
+{
+    GP_ASSERT(_node);
+
     const btQuaternion& rot = _worldTransform.getRotation();
     const btVector3& pos = _worldTransform.getOrigin();
 
+    _pending = false;
     _node->setRotation(rot.x(), rot.y(), rot.z(), rot.w());
     _node->setTranslation(pos.x(), pos.y(), pos.z());
 }
@@ -302,17 +317,16 @@ void PhysicsCollisionObject::PhysicsMotionState::setCenterOfMassOffset(const Vec
 }
 
 PhysicsCollisionObject::ScriptListener::ScriptListener(const char* url)
-    : url(url)
+    : url(url), function(Game::getInstance()->getScriptController()->loadUrl(url).c_str())
 {
-    function = Game::getInstance()->getScriptController()->loadUrl(url);
 }
 
 void PhysicsCollisionObject::ScriptListener::collisionEvent(PhysicsCollisionObject::CollisionListener::EventType type,
     const PhysicsCollisionObject::CollisionPair& collisionPair, const Vector3& contactPointA, const Vector3& contactPointB)
 {
-    Game::getInstance()->getScriptController()->executeFunction<void>(function.c_str(), 
-        "[PhysicsCollisionObject::CollisionListener::EventType]<PhysicsCollisionObject::CollisionPair><Vector3><Vector3>",
-        type, &collisionPair, &contactPointA, &contactPointB);
+    function.call<void>(ScriptFunction::Enum("PhysicsCollisionObject::CollisionListener::EventType", type),
+        ScriptFunction::Object("PhysicsCollisionObject::CollisionPair", (void*)&collisionPair),
+        ScriptFunction::Object("Vector3", (void*)&contactPointA), ScriptFunction::Object("Vector3", (void*)&contactPointB));
 }
 
 }
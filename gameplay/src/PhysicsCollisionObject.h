@@ -3,6 +3,7 @@
 
 #include "Vector3.h"
 #include "PhysicsCollisionShape.h"
+#include "ScriptFunction.h"
 
 namespace gameplay
 {
@@ -28,6 +29,7 @@ class PhysicsCollisionObject
     friend class PhysicsConstraint;
     friend class PhysicsRigidBody;
     friend class PhysicsGhostObject;
+    friend class SceneSnapshot;
 
 public:
 
@@ -325,8 +327,8 @@ protected:
 
         /** The URL to the Lua script function to use as the callback. */
         std::string url;
-        /** The name of the Lua script function to use as the callback. */
-        std::string function;
+        /** The Lua script function to use as the callback. */
+        ScriptFunction function;
     };
 
     /**
@@ -402,6 +404,11 @@ private:
          * Updates the motion state's world transform from the GamePlay Node object's world transform.
          */
         void updateTransformFromNode() const;
+
+        /**
+         * Updates the GamePlay Node object's transform from the motion state's world transform.
+         */
+        void updateNodeFromTransform();
         
         /**
          * Sets the center of mass offset for the associated collision shape.
@@ -414,6 +421,7 @@ private:
         PhysicsCollisionObject* _collisionObject;
         btTransform _centerOfMassOffset;
         mutable btTransform _worldTransform;
+        bool _pending;
     };
 
     /** 
@@ -10,7 +10,7 @@ namespace gameplay
 {
 
 PhysicsCollisionShape::PhysicsCollisionShape(Type type, btCollisionShape* shape, btStridingMeshInterface* meshInterface)
-    : _type(type), _shape(shape), _meshInterface(meshInterface)
+    : _type(type), _shape(shape), _meshInterface(meshInterface), _cacheKey(0), _memoryUsage(0)
 {
     memset(&_shapeData, 0, sizeof(_shapeData));
 }
@@ -20,11 +20,13 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
     if (_shape)
     {
         // Cleanup shape-specific cached data.
+        void* bvhData = NULL;
         switch (_type)
         {
         case SHAPE_MESH:
             if (_shapeData.meshData)
             {
+                bvhData = _shapeData.meshData->bvhData;
                 SAFE_DELETE_ARRAY(_shapeData.meshData->vertexData);
                 for (unsigned int i = 0; i < _shapeData.meshData->indexData.size(); i++)
                 {
@@ -46,8 +48,12 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
             break;
         }
 
-        // Free the bullet shape.
+        // Free the bullet shape, then the BVH it was reading from the shape cache.
         SAFE_DELETE(_shape);
+        if (bvhData)
+        {
+            btAlignedFree(bvhData);
+        }
     }
 }
 
@@ -241,6 +241,10 @@ private:
     {
         float* vertexData;
         std::vector<unsigned char*> indexData;
+        std::string url;
+        Vector3 scale;
+        bool dynamic;
+        void* bvhData;
     };
 
     struct HeightfieldData
@@ -276,6 +280,12 @@ private:
     // Bullet mesh interface for mesh types (NULL otherwise)
     btStridingMeshInterface* _meshInterface;
 
+    // Key of the shape in the shape cache of the controller
+    unsigned int _cacheKey;
+
+    // Memory used by the Bullet shape and its data, in bytes
+    size_t _memoryUsage;
+
     // Shape specific cached data
     union
     {
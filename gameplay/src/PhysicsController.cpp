@@ -2,16 +2,26 @@
 #include "PhysicsController.h"
 #include "PhysicsRigidBody.h"
 #include "PhysicsCharacter.h"
+#include "PhysicsVehicle.h"
 #include "Game.h"
 #include "MeshPart.h"
 #include "Bundle.h"
 #include "Terrain.h"
+#include "Camera.h"
+#include "ScratchMemory.h"
+#include "DebugDraw.h"
 
 #ifdef GP_USE_MEM_LEAK_DETECTION
 #undef new
 #endif
 #include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
 #include "BulletCollision/CollisionShapes/btShapeHull.h"
+#ifdef USE_BULLET_MT
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+#endif
 #ifdef GP_USE_MEM_LEAK_DETECTION
 #define new DEBUG_NEW
 #endif
@@ -19,29 +29,78 @@
 // The initial capacity of the Bullet debug drawer's vertex batch.
 #define INITIAL_CAPACITY 280
 
+// The number of queries in each job of a batched ray or sweep test.
+#define PHYSICS_BATCH_GRAIN_SIZE 16
+
+// The alignment Bullet requires for serialized bounding volume hierarchies.
+#define PHYSICS_BVH_ALIGNMENT 16
+
+// The default sleeping thresholds and solver iterations of the rigid bodies whose simulation is reduced.
+#define PHYSICS_LOD_LINEAR_SLEEPING_THRESHOLD 4.0f
+#define PHYSICS_LOD_ANGULAR_SLEEPING_THRESHOLD 4.0f
+#define PHYSICS_LOD_SOLVER_ITERATIONS 2
+
+// The number of manifolds in each job of the multithreaded collision dispatcher.
+#define PHYSICS_DISPATCH_GRAIN_SIZE 40
+
+// Steps with at least this many characters move them in parallel on the job scheduler.
+#define PHYSICS_CHARACTER_PARALLEL_COUNT_MIN 16
+#define PHYSICS_CHARACTER_GRAIN_SIZE 4
+
+// The script events of the physics controller.
+#define PHYSICS_EVENT_STATUS 0
+
 namespace gameplay
 {
 
-const int PhysicsController::DIRTY         = 0x01;
-const int PhysicsController::COLLISION     = 0x02;
-const int PhysicsController::REGISTERED    = 0x04;
-const int PhysicsController::REMOVE        = 0x08;
+const int PhysicsController::COLLISION     = 0x01;
+const int PhysicsController::REGISTERED    = 0x02;
+const int PhysicsController::REMOVE        = 0x04;
+const int PhysicsController::TRIGGER       = 0x08;
+
+// The identifier of the files of the shape cache.
+static const char SHAPE_CACHE_IDENTIFIER[] = { 'G', 'P', 'B', 'V' };
+
+static const ScriptTarget::Event __physicsEvents[] =
+{
+    { "statusEvent", "[PhysicsController::Listener::EventType]" }
+};
+
+/**
+ * Returns the FNV-1a hash of a block of memory, continuing from the specified hash.
+ */
+static unsigned int hashBytes(const void* data, size_t size, unsigned int hash)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
 PhysicsController::PhysicsController()
   : _isUpdating(false), _collisionConfiguration(NULL), _dispatcher(NULL),
-    _overlappingPairCache(NULL), _solver(NULL), _world(NULL), _ghostPairCallback(NULL),
-    _debugDrawer(NULL), _status(PhysicsController::Listener::DEACTIVATED), _listeners(NULL),
-    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _collisionCallback(NULL)
+    _overlappingPairCache(NULL), _solver(NULL), _solverPool(NULL), _world(NULL), _multithreaded(false), _ghostPairCallback(NULL),
+    _shapeMemoryUsage(0), _debugDrawer(NULL), _status(PhysicsController::Listener::DEACTIVATED), _listeners(NULL),
+    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _collisionFrame(0), _stepThread(NULL),
+    _stepping(false), _stepExit(false), _stepTime(0.0f), _deferEvents(false), _statusChanged(false),
+    _characterAction(NULL), _lodCamera(NULL), _lodDistance(0.0f), _lodLinearSleepingThreshold(PHYSICS_LOD_LINEAR_SLEEPING_THRESHOLD),
+    _lodAngularSleepingThreshold(PHYSICS_LOD_ANGULAR_SLEEPING_THRESHOLD), _lodSolverIterations(PHYSICS_LOD_SOLVER_ITERATIONS)
 {
     // Default gravity is 9.8 along the negative Y axis.
-    _collisionCallback = new CollisionCallback(this);
-
-    addScriptEvent("statusEvent", "[PhysicsController::Listener::EventType]");
+    setScriptEvents(__physicsEvents, 1);
 }
 
 PhysicsController::~PhysicsController()
 {
-    SAFE_DELETE(_collisionCallback);
+    for (int i = 0; i < _collisionStatus.size(); ++i)
+    {
+        SAFE_DELETE(*_collisionStatus.getAtIndex(i));
+    }
+    _collisionStatus.clear();
+    SAFE_RELEASE(_lodCamera);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_debugDrawer);
     SAFE_DELETE(_listeners);
@@ -149,6 +208,8 @@ const Vector3& PhysicsController::getGravity() const
 
 void PhysicsController::setGravity(const Vector3& gravity)
 {
+    waitForStep();
+
     _gravity = gravity;
 
     if (_world)
@@ -159,147 +220,221 @@ void PhysicsController::drawDebug(const Matrix& viewProjection)
 {
     GP_ASSERT(_debugDrawer);
     GP_ASSERT(_world);
+    waitForStep();
+
+    // Skip walking the world when nobody looks at the lines.
+    if (!DebugDraw::isCategoryEnabled(DebugDraw::PHYSICS))
+        return;
 
     _debugDrawer->begin(viewProjection);
     _world->debugDrawWorld();
     _debugDrawer->end();
 }
 
-bool PhysicsController::rayTest(const Ray& ray, float distance, PhysicsController::HitResult* result, PhysicsController::HitFilter* filter)
+/**
+ * Finds the closest object hit by a ray, honoring a hit filter.
+ */
+class RayTestCallback : public btCollisionWorld::ClosestRayResultCallback
 {
-    class RayTestCallback : public btCollisionWorld::ClosestRayResultCallback
-    {
-    private:
+private:
 
-        HitFilter* filter;
-        HitResult hitResult;
+    PhysicsController::HitFilter* filter;
+    PhysicsController::HitResult hitResult;
 
-    public:
+public:
 
-        RayTestCallback(const btVector3& rayFromWorld, const btVector3& rayToWorld, PhysicsController::HitFilter* filter)
-            : btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld), filter(filter)
-        {
-        }
+    RayTestCallback(const btVector3& rayFromWorld, const btVector3& rayToWorld, PhysicsController::HitFilter* filter)
+        : btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld), filter(filter)
+    {
+    }
 
-        virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-        {
-            if (!btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy0))
-                return false;
+    virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+    {
+        if (!btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy0))
+            return false;
 
-            btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
-            PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(co->getUserPointer());
-            if (object == NULL)
-                return false;
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(co->getUserPointer());
+        if (object == NULL)
+            return false;
 
-            return filter ? !filter->filter(object) : true;
-        }
+        return filter ? !filter->filter(object) : true;
+    }
 
-        btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
-        {
-            GP_ASSERT(rayResult.m_collisionObject);
-            PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(rayResult.m_collisionObject->getUserPointer());
+    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
+    {
+        GP_ASSERT(rayResult.m_collisionObject);
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(rayResult.m_collisionObject->getUserPointer());
 
-            if (object == NULL)
-                return 1.0f; // ignore
+        if (object == NULL)
+            return 1.0f; // ignore
 
-            float result = btCollisionWorld::ClosestRayResultCallback::addSingleResult(rayResult, normalInWorldSpace);
+        float result = btCollisionWorld::ClosestRayResultCallback::addSingleResult(rayResult, normalInWorldSpace);
 
-            hitResult.object = object;
-            hitResult.point.set(m_hitPointWorld.x(), m_hitPointWorld.y(), m_hitPointWorld.z());
-            hitResult.fraction = m_closestHitFraction;
-            hitResult.normal.set(m_hitNormalWorld.x(), m_hitNormalWorld.y(), m_hitNormalWorld.z());
+        hitResult.object = object;
+        hitResult.point.set(m_hitPointWorld.x(), m_hitPointWorld.y(), m_hitPointWorld.z());
+        hitResult.fraction = m_closestHitFraction;
+        hitResult.normal.set(m_hitNormalWorld.x(), m_hitNormalWorld.y(), m_hitNormalWorld.z());
 
-            if (filter && !filter->hit(hitResult))
-                return 1.0f; // process next collision
+        if (filter && !filter->hit(hitResult))
+            return 1.0f; // process next collision
 
-            return result; // continue normally
-        }
-    };
+        return result; // continue normally
+    }
+};
 
-    GP_ASSERT(_world);
+/**
+ * Finds the closest object hit by a swept convex shape, honoring a hit filter.
+ */
+class SweepTestCallback : public btCollisionWorld::ClosestConvexResultCallback
+{
+private:
 
-    btVector3 rayFromWorld(BV(ray.getOrigin()));
-    btVector3 rayToWorld(rayFromWorld + BV(ray.getDirection() * distance));
+    PhysicsCollisionObject* me;
+    PhysicsController::HitFilter* filter;
+    PhysicsController::HitResult hitResult;
 
-    RayTestCallback callback(rayFromWorld, rayToWorld, filter);
-    _world->rayTest(rayFromWorld, rayToWorld, callback);
-    if (callback.hasHit())
+public:
+
+    SweepTestCallback(PhysicsCollisionObject* me, PhysicsController::HitFilter* filter)
+        : btCollisionWorld::ClosestConvexResultCallback(btVector3(0.0, 0.0, 0.0), btVector3(0.0, 0.0, 0.0)), me(me), filter(filter)
     {
-        if (result)
-        {
-            result->object = getCollisionObject(callback.m_collisionObject);
-            result->point.set(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
-            result->fraction = callback.m_closestHitFraction;
-            result->normal.set(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
-        }
+    }
 
-        return true;
+    virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+    {
+        if (!btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0))
+            return false;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(co->getUserPointer());
+        if (object == NULL || object == me)
+            return false;
+
+        return filter ? !filter->filter(object) : true;
     }
 
-    return false;
-}
+    btScalar addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace)
+    {
+        GP_ASSERT(convexResult.m_hitCollisionObject);
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(convexResult.m_hitCollisionObject->getUserPointer());
 
-bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3& endPosition, PhysicsController::HitResult* result, PhysicsController::HitFilter* filter)
+        if (object == NULL)
+            return 1.0f;
+
+        float result = ClosestConvexResultCallback::addSingleResult(convexResult, normalInWorldSpace);
+
+        hitResult.object = object;
+        hitResult.point.set(m_hitPointWorld.x(), m_hitPointWorld.y(), m_hitPointWorld.z());
+        hitResult.fraction = m_closestHitFraction;
+        hitResult.normal.set(m_hitNormalWorld.x(), m_hitNormalWorld.y(), m_hitNormalWorld.z());
+
+        if (filter && !filter->hit(hitResult))
+            return 1.0f;
+
+        return result;
+    }
+};
+
+/**
+ * Runs the narrow phase ray test against each broadphase leaf a ray passes through.
+ *
+ * Unlike btDbvtBroadphase::rayTest, this keeps no traversal state in the broadphase,
+ * so several rays can be tested at the same time.
+ */
+class BroadphaseRayTester : public btDbvt::ICollide
 {
-    class SweepTestCallback : public btCollisionWorld::ClosestConvexResultCallback
+public:
+
+    BroadphaseRayTester(const btTransform& rayFromTrans, const btTransform& rayToTrans, btCollisionWorld::RayResultCallback& callback)
+        : rayFromTrans(rayFromTrans), rayToTrans(rayToTrans), callback(callback)
     {
-    private:
+    }
 
-        PhysicsCollisionObject* me;
-        PhysicsController::HitFilter* filter;
-        PhysicsController::HitResult hitResult;
+    void Process(const btDbvtNode* leaf)
+    {
+        btBroadphaseProxy* proxy = (btBroadphaseProxy*)leaf->data;
+        if (callback.m_closestHitFraction == 0.0f || !callback.needsCollision(proxy))
+            return;
 
-    public:
+        btCollisionObject* co = (btCollisionObject*)proxy->m_clientObject;
+        btCollisionWorld::rayTestSingle(rayFromTrans, rayToTrans, co, co->getCollisionShape(), co->getWorldTransform(), callback);
+    }
 
-        SweepTestCallback(PhysicsCollisionObject* me, PhysicsController::HitFilter* filter)
-            : btCollisionWorld::ClosestConvexResultCallback(btVector3(0.0, 0.0, 0.0), btVector3(0.0, 0.0, 0.0)), me(me), filter(filter)
-        {
-        }
+private:
 
-        virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-        {
-            if (!btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0))
-                return false;
+    BroadphaseRayTester& operator=(const BroadphaseRayTester&);
 
-            btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
-            PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(co->getUserPointer());
-            if (object == NULL || object == me)
-                return false;
+    const btTransform& rayFromTrans;
+    const btTransform& rayToTrans;
+    btCollisionWorld::RayResultCallback& callback;
+};
 
-            return filter ? !filter->filter(object) : true;
-        }
+/**
+ * Runs the narrow phase sweep test against each broadphase leaf overlapping the swept bounds of a shape.
+ */
+class BroadphaseSweepTester : public btDbvt::ICollide
+{
+public:
 
-        btScalar addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace)
-        {
-            GP_ASSERT(convexResult.m_hitCollisionObject);
-            PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(convexResult.m_hitCollisionObject->getUserPointer());
+    BroadphaseSweepTester(const btConvexShape* shape, const btTransform& start, const btTransform& end, btCollisionWorld::ConvexResultCallback& callback, btScalar allowedPenetration)
+        : shape(shape), start(start), end(end), callback(callback), allowedPenetration(allowedPenetration)
+    {
+    }
 
-            if (object == NULL)
-                return 1.0f;
+    void Process(const btDbvtNode* leaf)
+    {
+        btBroadphaseProxy* proxy = (btBroadphaseProxy*)leaf->data;
+        if (callback.m_closestHitFraction == 0.0f || !callback.needsCollision(proxy))
+            return;
 
-            float result = ClosestConvexResultCallback::addSingleResult(convexResult, normalInWorldSpace);
+        btCollisionObject* co = (btCollisionObject*)proxy->m_clientObject;
+        btCollisionWorld::objectQuerySingle(shape, start, end, co, co->getCollisionShape(), co->getWorldTransform(), callback, allowedPenetration);
+    }
 
-            hitResult.object = object;
-            hitResult.point.set(m_hitPointWorld.x(), m_hitPointWorld.y(), m_hitPointWorld.z());
-            hitResult.fraction = m_closestHitFraction;
-            hitResult.normal.set(m_hitNormalWorld.x(), m_hitNormalWorld.y(), m_hitNormalWorld.z());
+private:
 
-            if (filter && !filter->hit(hitResult))
-                return 1.0f;
+    BroadphaseSweepTester& operator=(const BroadphaseSweepTester&);
 
-            return result;
-        }
-    };
+    const btConvexShape* shape;
+    const btTransform& start;
+    const btTransform& end;
+    btCollisionWorld::ConvexResultCallback& callback;
+    btScalar allowedPenetration;
+};
 
+/**
+ * The arguments of a batched ray or sweep query run by the job scheduler.
+ */
+struct BatchQuery
+{
+    PhysicsController* controller;
+    btDbvtBroadphase* broadphase;
+    const Ray* rays;
+    const float* distances;
+    PhysicsController::HitFilter* filter;
+    PhysicsController::HitResult* results;
+    const btConvexShape** shapes;
+    PhysicsCollisionObject* const* objects;
+    const btTransform* starts;
+    const btTransform* ends;
+    btScalar allowedPenetration;
+};
+
+/**
+ * Gets the start and end transforms of a sweep test, or returns false if the object's shape cannot be swept.
+ */
+static bool getSweepTransforms(PhysicsCollisionObject* object, const Vector3& endPosition, btTransform* start, btTransform* end)
+{
     GP_ASSERT(object && object->getCollisionShape());
-    PhysicsCollisionShape* shape = object->getCollisionShape();
-    PhysicsCollisionShape::Type type = shape->getType();
+    GP_ASSERT(start && end);
+
+    PhysicsCollisionShape::Type type = object->getCollisionShape()->getType();
     if (type != PhysicsCollisionShape::SHAPE_BOX && type != PhysicsCollisionShape::SHAPE_SPHERE && type != PhysicsCollisionShape::SHAPE_CAPSULE)
         return false; // unsupported type
 
     // Define the start transform.
-    btTransform start;
-    start.setIdentity();
+    start->setIdentity();
     if (object->getNode())
     {
         Vector3 translation;
@@ -308,14 +443,63 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
         m.getTranslation(&translation);
         m.getRotation(&rotation);
 
-        start.setIdentity();
-        start.setOrigin(BV(translation));
-        start.setRotation(BQ(rotation));
+        start->setOrigin(BV(translation));
+        start->setRotation(BQ(rotation));
     }
 
     // Define the end transform.
-    btTransform end(start);
-    end.setOrigin(BV(endPosition));
+    *end = *start;
+    end->setOrigin(BV(endPosition));
+    return true;
+}
+
+/**
+ * Copies the closest hit of a query callback to a hit result.
+ */
+template <class T>
+static void setHitResult(PhysicsController::HitResult* result, PhysicsCollisionObject* object, const T& callback)
+{
+    result->object = object;
+    result->point.set(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
+    result->fraction = callback.m_closestHitFraction;
+    result->normal.set(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
+}
+
+bool PhysicsController::rayTest(const Ray& ray, float distance, PhysicsController::HitResult* result, PhysicsController::HitFilter* filter)
+{
+    GP_ASSERT(_world);
+    waitForStep();
+
+    btVector3 rayFromWorld(BV(ray.getOrigin()));
+    btVector3 rayToWorld(rayFromWorld + BV(ray.getDirection() * distance));
+
+    RayTestCallback callback(rayFromWorld, rayToWorld, filter);
+    _world->rayTest(rayFromWorld, rayToWorld, callback);
+    if (callback.hasHit())
+    {
+        if (result)
+        {
+            result->object = getCollisionObject(callback.m_collisionObject);
+            result->point.set(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
+            result->fraction = callback.m_closestHitFraction;
+            result->normal.set(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3& endPosition, PhysicsController::HitResult* result, PhysicsController::HitFilter* filter)
+{
+    GP_ASSERT(object && object->getCollisionShape());
+    PhysicsCollisionShape* shape = object->getCollisionShape();
+
+    btTransform start;
+    btTransform end;
+    if (!getSweepTransforms(object, endPosition, &start, &end))
+        return false;
 
     // Perform bullet convex sweep test.
     SweepTestCallback callback(object, filter);
@@ -336,6 +520,7 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     }*/
 
     GP_ASSERT(_world);
+    waitForStep();
     _world->convexSweepTest(static_cast<btConvexShape*>(shape->getShape()), start, end, callback, _world->getDispatchInfo().m_allowedCcdPenetration);
 
     // Check for hits and store results.
@@ -355,88 +540,297 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     return false;
 }
 
-btScalar PhysicsController::CollisionCallback::addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, 
-    const btCollisionObjectWrapper* b, int partIdB, int indexB)
+unsigned int PhysicsController::rayTest(const Ray* rays, const float* distances, unsigned int count, PhysicsController::HitResult* results, PhysicsController::HitFilter* filter)
 {
-    GP_ASSERT(_pc);
-
-    // Get pointers to the PhysicsCollisionObject objects.
-    PhysicsCollisionObject* objectA = _pc->getCollisionObject(a->m_collisionObject);
-    PhysicsCollisionObject* objectB = _pc->getCollisionObject(b->m_collisionObject);
-
-    // If the given collision object pair has collided in the past, then
-    // we notify the listeners only if the pair was not colliding
-    // during the previous frame. Otherwise, it's a new pair, so add a
-    // new entry to the cache with the appropriate listeners and notify them.
-    PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
+    GP_ASSERT(rays && distances && results);
+    GP_ASSERT(_world);
+    waitForStep();
+
+    BatchQuery query;
+    memset(&query, 0, sizeof(query));
+    query.controller = this;
+    query.broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    query.rays = rays;
+    query.distances = distances;
+    query.filter = filter;
+    query.results = results;
+
+    Game::getInstance()->getJobScheduler()->parallelFor(count, &PhysicsController::rayTestRange, &query, PHYSICS_BATCH_GRAIN_SIZE);
+    return countHits(results, count);
+}
 
-    CollisionInfo* collisionInfo;
-    if (_pc->_collisionStatus.count(pair) > 0)
+unsigned int PhysicsController::sweepTest(PhysicsCollisionObject* const* objects, const Vector3* endPositions, unsigned int count,
+                                          PhysicsController::HitResult* results, PhysicsController::HitFilter* filter)
+{
+    GP_ASSERT(objects && endPositions && results);
+    GP_ASSERT(_world);
+    waitForStep();
+
+    // Node world matrices are computed lazily, so the sweeps are set up on this thread.
+    ScratchMemory::Scope scratch;
+    ScratchVector<btTransform>::type starts(count);
+    ScratchVector<btTransform>::type ends(count);
+    ScratchVector<const btConvexShape*>::type shapes(count);
+    for (unsigned int i = 0; i < count; ++i)
     {
-        collisionInfo = &_pc->_collisionStatus[pair];
+        GP_ASSERT(objects[i] && objects[i]->getCollisionShape());
+        bool supported = getSweepTransforms(objects[i], endPositions[i], &starts[i], &ends[i]);
+        shapes[i] = supported ? static_cast<const btConvexShape*>(objects[i]->getCollisionShape()->getShape()) : NULL;
     }
-    else
-    {
-        // Add a new collision pair for these objects.
-        collisionInfo = &_pc->_collisionStatus[pair];
+    if (count == 0)
+        return 0;
+
+    BatchQuery query;
+    memset(&query, 0, sizeof(query));
+    query.controller = this;
+    query.broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    query.filter = filter;
+    query.results = results;
+    query.shapes = &shapes[0];
+    query.objects = objects;
+    query.starts = &starts[0];
+    query.ends = &ends[0];
+    query.allowedPenetration = _world->getDispatchInfo().m_allowedCcdPenetration;
+
+    Game::getInstance()->getJobScheduler()->parallelFor(count, &PhysicsController::sweepTestRange, &query, PHYSICS_BATCH_GRAIN_SIZE);
+    return countHits(results, count);
+}
 
-        // Add the appropriate listeners.
-        PhysicsCollisionObject::CollisionPair p1(pair.objectA, NULL);
-        if (_pc->_collisionStatus.count(p1) > 0)
-        {
-            const CollisionInfo& ci = _pc->_collisionStatus[p1];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
-        }
-        PhysicsCollisionObject::CollisionPair p2(pair.objectB, NULL);
-        if (_pc->_collisionStatus.count(p2) > 0)
+void PhysicsController::rayTestRange(void* arg, unsigned int start, unsigned int end)
+{
+    BatchQuery* query = (BatchQuery*)arg;
+    GP_ASSERT(query && query->broadphase);
+
+    for (unsigned int i = start; i < end; ++i)
+    {
+        const Ray& ray = query->rays[i];
+        btVector3 rayFromWorld(BV(ray.getOrigin()));
+        btVector3 rayToWorld(rayFromWorld + BV(ray.getDirection() * query->distances[i]));
+        btTransform rayFromTrans(btQuaternion::getIdentity(), rayFromWorld);
+        btTransform rayToTrans(btQuaternion::getIdentity(), rayToWorld);
+
+        // Test the dynamic and static sets of the broadphase tree.
+        RayTestCallback callback(rayFromWorld, rayToWorld, query->filter);
+        BroadphaseRayTester tester(rayFromTrans, rayToTrans, callback);
+        btDbvt::rayTest(query->broadphase->m_sets[0].m_root, rayFromWorld, rayToWorld, tester);
+        btDbvt::rayTest(query->broadphase->m_sets[1].m_root, rayFromWorld, rayToWorld, tester);
+
+        query->results[i].object = NULL;
+        if (callback.hasHit())
         {
-            const CollisionInfo& ci = _pc->_collisionStatus[p2];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
+            setHitResult(&query->results[i], query->controller->getCollisionObject(callback.m_collisionObject), callback);
         }
     }
+}
+
+void PhysicsController::sweepTestRange(void* arg, unsigned int start, unsigned int end)
+{
+    BatchQuery* query = (BatchQuery*)arg;
+    GP_ASSERT(query && query->broadphase);
 
-    // Fire collision event.
-    if ((collisionInfo->_status & COLLISION) == 0)
+    for (unsigned int i = start; i < end; ++i)
     {
-        std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = collisionInfo->_listeners.begin();
-        for (; iter != collisionInfo->_listeners.end(); iter++)
+        query->results[i].object = NULL;
+        const btConvexShape* shape = query->shapes[i];
+        if (shape == NULL)
+            continue;
+
+        // Collect the leaves overlapping the bounds of the shape over the whole sweep.
+        btVector3 startMin, startMax, endMin, endMax;
+        shape->getAabb(query->starts[i], startMin, startMax);
+        shape->getAabb(query->ends[i], endMin, endMax);
+        startMin.setMin(endMin);
+        startMax.setMax(endMax);
+        btDbvtVolume bounds = btDbvtVolume::FromMM(startMin, startMax);
+
+        SweepTestCallback callback(query->objects[i], query->filter);
+        BroadphaseSweepTester tester(shape, query->starts[i], query->ends[i], callback, query->allowedPenetration);
+        query->broadphase->m_sets[0].collideTV(query->broadphase->m_sets[0].m_root, bounds, tester);
+        query->broadphase->m_sets[1].collideTV(query->broadphase->m_sets[1].m_root, bounds, tester);
+
+        if (callback.hasHit())
         {
-            GP_ASSERT(*iter);
-            if ((collisionInfo->_status & REMOVE) == 0)
-            {
-                (*iter)->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, Vector3(cp.getPositionWorldOnA().x(), cp.getPositionWorldOnA().y(), cp.getPositionWorldOnA().z()),
-                    Vector3(cp.getPositionWorldOnB().x(), cp.getPositionWorldOnB().y(), cp.getPositionWorldOnB().z()));
-            }
+            setHitResult(&query->results[i], query->controller->getCollisionObject(callback.m_hitCollisionObject), callback);
         }
     }
+}
 
-    // Update the collision status cache (we remove the dirty bit
-    // set in the controller's update so that this particular collision pair's
-    // status is not reset to 'no collision' when the controller's update completes).
-    collisionInfo->_status &= ~DIRTY;
-    collisionInfo->_status |= COLLISION;
-    return 0.0f;
+unsigned int PhysicsController::countHits(const PhysicsController::HitResult* results, unsigned int count)
+{
+    unsigned int hits = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (results[i].object)
+            ++hits;
+    }
+    return hits;
 }
 
-void PhysicsController::initialize()
+PhysicsController::CollisionPairKey::CollisionPairKey(const PhysicsCollisionObject::CollisionPair& pair)
+{
+    // Order the objects so that both orders of a pair give the same key.
+    if (pair.objectA < pair.objectB)
+    {
+        _first = pair.objectA;
+        _second = pair.objectB;
+    }
+    else
+    {
+        _first = pair.objectB;
+        _second = pair.objectA;
+    }
+}
+
+unsigned int PhysicsController::CollisionPairKey::getHash() const
+{
+    // Mix the addresses (which are aligned, so their low bits carry no information),
+    // since btHashMap indexes its buckets with the low bits of the hash.
+    unsigned int key = (unsigned int)((size_t)_first >> 3) * 31 + (unsigned int)((size_t)_second >> 3);
+    key += ~(key << 15);
+    key ^= (key >> 10);
+    key += (key << 3);
+    key ^= (key >> 6);
+    key += ~(key << 11);
+    key ^= (key >> 16);
+    return key;
+}
+
+bool PhysicsController::CollisionPairKey::equals(const CollisionPairKey& other) const
+{
+    return _first == other._first && _second == other._second;
+}
+
+PhysicsController::CollisionInfo* PhysicsController::findCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) const
+{
+    CollisionInfo* const* info = _collisionStatus.find(CollisionPairKey(pair));
+    return info ? *info : NULL;
+}
+
+#ifdef USE_BULLET_MT
+/**
+ * Runs the parallel loops of Bullet on the job scheduler of the game.
+ */
+class JobTaskScheduler : public btITaskScheduler
+{
+public:
+
+    JobTaskScheduler(JobScheduler* scheduler)
+        : btITaskScheduler("GamePlay"), _scheduler(scheduler)
+    {
+        GP_ASSERT(_scheduler);
+        _threadCount = std::min((int)_scheduler->getWorkerCount() + 1, (int)BT_MAX_THREAD_COUNT);
+    }
+
+    int getMaxNumThreads() const
+    {
+        return _threadCount;
+    }
+
+    int getNumThreads() const
+    {
+        return _threadCount;
+    }
+
+    void setNumThreads(int numThreads)
+    {
+        // The threads are owned by the job scheduler.
+    }
+
+    void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+    {
+        if (iEnd <= iBegin)
+            return;
+
+        ForContext context = { &body, iBegin };
+        _scheduler->parallelFor((unsigned int)(iEnd - iBegin), &JobTaskScheduler::forRange, &context, (unsigned int)std::max(grainSize, 1));
+    }
+
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+    {
+        if (iEnd <= iBegin)
+            return btScalar(0);
+
+        SumContext context;
+        context.body = &body;
+        context.begin = iBegin;
+        context.sum = btScalar(0);
+        _scheduler->parallelFor((unsigned int)(iEnd - iBegin), &JobTaskScheduler::sumRange, &context, (unsigned int)std::max(grainSize, 1));
+        return context.sum;
+    }
+
+private:
+
+    struct ForContext
+    {
+        const btIParallelForBody* body;
+        int begin;
+    };
+
+    struct SumContext
+    {
+        const btIParallelSumBody* body;
+        int begin;
+        btScalar sum;
+        Mutex mutex;
+    };
+
+    static void forRange(void* arg, unsigned int start, unsigned int end)
+    {
+        ForContext* context = (ForContext*)arg;
+        context->body->forLoop(context->begin + (int)start, context->begin + (int)end);
+    }
+
+    static void sumRange(void* arg, unsigned int start, unsigned int end)
+    {
+        SumContext* context = (SumContext*)arg;
+        btScalar sum = context->body->sumLoop(context->begin + (int)start, context->begin + (int)end);
+        Mutex::Lock lock(context->mutex);
+        context->sum += sum;
+    }
+
+    JobScheduler* _scheduler;
+    int _threadCount;
+};
+
+static JobTaskScheduler* __taskScheduler = NULL;
+#endif
+
+void PhysicsController::initialize(bool multithreaded)
 {
     _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>();
-    _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
     _overlappingPairCache = bullet_new<btDbvtBroadphase>();
-    _solver = bullet_new<btSequentialImpulseConstraintSolver>();
+
+#ifdef USE_BULLET_MT
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (multithreaded && scheduler)
+    {
+        // Bullet runs its parallel loops through a global task scheduler.
+        GP_ASSERT(__taskScheduler == NULL);
+        __taskScheduler = new JobTaskScheduler(scheduler);
+        btSetTaskScheduler(__taskScheduler);
+
+        // Each thread solves its islands with its own solver from the pool, and the
+        // constraints of islands too large to split are solved by a solver that is itself parallel.
+        _dispatcher = bullet_new<btCollisionDispatcherMt>(_collisionConfiguration, PHYSICS_DISPATCH_GRAIN_SIZE);
+        _solverPool = bullet_new<btConstraintSolverPoolMt>(__taskScheduler->getMaxNumThreads());
+        _solver = bullet_new<btSequentialImpulseConstraintSolverMt>();
+        _world = bullet_new<btDiscreteDynamicsWorldMt>(_dispatcher, _overlappingPairCache, (btConstraintSolverPoolMt*)_solverPool, _solver, _collisionConfiguration);
+        _multithreaded = true;
+    }
+#else
+    if (multithreaded)
+    {
+        GP_WARN("The multithreaded physics world requires building with USE_BULLET_MT; using a single-threaded world.");
+    }
+#endif
 
     // Create the world.
-    _world = bullet_new<btDiscreteDynamicsWorld>(_dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+    if (_world == NULL)
+    {
+        _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
+        _solver = bullet_new<btSequentialImpulseConstraintSolver>();
+        _world = bullet_new<btDiscreteDynamicsWorld>(_dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+    }
     _world->setGravity(BV(_gravity));
 
     // Register ghost pair callback so bullet detects collisions with ghost objects (used for character collisions).
@@ -445,6 +839,13 @@ void PhysicsController::initialize()
     _world->getPairCache()->setInternalGhostPairCallback(_ghostPairCallback);
     _world->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
 
+    // The pairs of trigger volumes are not dispatched to the narrowphase.
+    _dispatcher->setNearCallback(&PhysicsController::nearCallback);
+
+    // Characters are updated together by a single action.
+    _characterAction = new CharacterAction(this);
+    _world->addAction(_characterAction);
+
     // Set up debug drawing.
     _debugDrawer = new DebugDrawer();
     _world->setDebugDrawer(_debugDrawer);
@@ -452,13 +853,27 @@ void PhysicsController::initialize()
 
 void PhysicsController::finalize()
 {
+    setThreaded(false);
+
     // Clean up the world and its various components.
+    if (_world && _characterAction)
+        _world->removeAction(_characterAction);
+    SAFE_DELETE(_characterAction);
     SAFE_DELETE(_world);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_solver);
+    SAFE_DELETE(_solverPool);
     SAFE_DELETE(_overlappingPairCache);
     SAFE_DELETE(_dispatcher);
     SAFE_DELETE(_collisionConfiguration);
+#ifdef USE_BULLET_MT
+    if (_multithreaded)
+    {
+        btSetTaskScheduler(NULL);
+        SAFE_DELETE(__taskScheduler);
+    }
+#endif
+    _multithreaded = false;
 }
 
 void PhysicsController::pause()
@@ -474,6 +889,26 @@ void PhysicsController::resume()
 void PhysicsController::update(float elapsedTime)
 {
     GP_ASSERT(_world);
+
+    // Pick up the results of the background step started before the last frame was rendered.
+    waitForStep();
+    publishStep();
+    if (_lodCamera)
+        updateLod();
+
+    if (_stepThread && !Game::getInstance()->isPipelined())
+    {
+        // The time is stepped on the background thread once the game starts rendering.
+        _stepTime += elapsedTime;
+        return;
+    }
+
+    stepSimulation(_stepTime + elapsedTime);
+    _stepTime = 0.0f;
+}
+
+void PhysicsController::stepSimulation(float elapsedTime)
+{
     _isUpdating = true;
 
     // Update the physics simulation, with a maximum
@@ -513,122 +948,516 @@ void PhysicsController::update(float elapsedTime)
                 }
             }
 
-            if (allInactive)
-                _status = Listener::DEACTIVATED;
-        }
+            if (allInactive)
+                _status = Listener::DEACTIVATED;
+        }
+
+        // If the status has changed, notify our listeners.
+        if (oldStatus != _status)
+        {
+            if (_deferEvents)
+                _statusChanged = true;
+            else
+                fireStatusEvent();
+        }
+    }
+
+    updateCollisionStatus();
+
+    _isUpdating = false;
+}
+
+void PhysicsController::updateCollisionStatus()
+{
+    // Remove the pairs marked for removal since the last step, firing NOT_COLLIDING if appropriate.
+    for (size_t i = 0, count = _removedPairs.size(); i < count; ++i)
+    {
+        CollisionInfo* info = findCollisionInfo(_removedPairs[i]);
+        if (info == NULL || (info->_status & REMOVE) == 0)
+            continue;
+
+        if ((info->_status & TRIGGER) != 0)
+            removeTriggerOverlap(info->_pair);
+
+        if ((info->_status & COLLISION) != 0 && info->_pair.objectB)
+        {
+            PhysicsCollisionObject::CollisionPair cp(info->_pair.objectA, NULL);
+            size_t size = info->_listeners.size();
+            for (size_t j = 0; j < size; j++)
+            {
+                fireCollisionEvent(info->_listeners[j], PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, cp);
+            }
+        }
+        _collisionStatus.remove(CollisionPairKey(info->_pair));
+        SAFE_DELETE(info);
+    }
+    _removedPairs.clear();
+
+    if (_collisionStatus.size() == 0)
+    {
+        _collidingPairs.clear();
+        return;
+    }
+
+    // Visit the pairs in contact after the step. Pairs that nobody listens to are skipped,
+    // and the pairs of objects with listeners for all their collisions are added on their first contact.
+    ++_collisionFrame;
+    for (int i = 0, count = _dispatcher->getNumManifolds(); i < count; ++i)
+    {
+        btPersistentManifold* manifold = _dispatcher->getManifoldByIndexInternal(i);
+        GP_ASSERT(manifold);
+
+        // Manifolds keep the points that are about to touch, which are not collisions yet.
+        int contact = -1;
+        for (int j = 0, contactCount = manifold->getNumContacts(); j < contactCount; ++j)
+        {
+            if (manifold->getContactPoint(j).getDistance() <= 0.0f)
+            {
+                contact = j;
+                break;
+            }
+        }
+        if (contact < 0)
+            continue;
+
+        PhysicsCollisionObject* objectA = getCollisionObject(manifold->getBody0());
+        PhysicsCollisionObject* objectB = getCollisionObject(manifold->getBody1());
+        if (objectA == NULL || objectB == NULL)
+            continue;
+
+        CollisionInfo* info = getListenedCollisionInfo(objectA, objectB);
+        if (info == NULL)
+            continue;
+        info->_frame = _collisionFrame;
+
+        // Fire collision event if the pair was not colliding during the previous step.
+        if ((info->_status & COLLISION) == 0)
+        {
+            info->_status |= COLLISION;
+            _collidingPairs.push_back(info->_pair);
+            if ((info->_status & REMOVE) == 0)
+            {
+                // The contact points are given in the order of the objects of the registered pair.
+                const btManifoldPoint& point = manifold->getContactPoint(contact);
+                bool swapped = info->_pair.objectA != objectA;
+                const btVector3& pointA = swapped ? point.getPositionWorldOnB() : point.getPositionWorldOnA();
+                const btVector3& pointB = swapped ? point.getPositionWorldOnA() : point.getPositionWorldOnB();
+                size_t size = info->_listeners.size();
+                for (size_t j = 0; j < size; j++)
+                {
+                    GP_ASSERT(info->_listeners[j]);
+                    fireCollisionEvent(info->_listeners[j], PhysicsCollisionObject::CollisionListener::COLLIDING, info->_pair,
+                        Vector3(pointA.x(), pointA.y(), pointA.z()), Vector3(pointB.x(), pointB.y(), pointB.z()));
+                }
+            }
+        }
+    }
+
+    updateTriggers();
+
+    // The colliding pairs that were not visited have stopped colliding. The pairs of triggers
+    // are not visited, and keep colliding until the objects leave the trigger.
+    for (size_t i = _collidingPairs.size(); i > 0; --i)
+    {
+        CollisionInfo* info = findCollisionInfo(_collidingPairs[i - 1]);
+        if (info && (info->_status & COLLISION) != 0 && (info->_frame == _collisionFrame || (info->_status & TRIGGER) != 0))
+            continue;
+
+        _collidingPairs[i - 1] = _collidingPairs.back();
+        _collidingPairs.pop_back();
+        if (info == NULL || (info->_status & COLLISION) == 0)
+            continue;
+
+        info->_status &= ~COLLISION;
+        if (info->_pair.objectB)
+        {
+            size_t size = info->_listeners.size();
+            for (size_t j = 0; j < size; j++)
+            {
+                fireCollisionEvent(info->_listeners[j], PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, info->_pair);
+            }
+        }
+
+        // Pairs added for the listeners of all the collisions of an object are only kept while they collide.
+        if ((info->_status & (REGISTERED | REMOVE)) == 0)
+        {
+            _collisionStatus.remove(CollisionPairKey(info->_pair));
+            SAFE_DELETE(info);
+        }
+    }
+}
+
+PhysicsController::CollisionInfo* PhysicsController::getListenedCollisionInfo(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
+{
+    PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
+    CollisionInfo* info = findCollisionInfo(pair);
+    if (info)
+        return info;
+
+    CollisionInfo* infoA = findCollisionInfo(PhysicsCollisionObject::CollisionPair(objectA, NULL));
+    CollisionInfo* infoB = findCollisionInfo(PhysicsCollisionObject::CollisionPair(objectB, NULL));
+    if (infoA && (infoA->_status & REMOVE) != 0)
+        infoA = NULL;
+    if (infoB && (infoB->_status & REMOVE) != 0)
+        infoB = NULL;
+    if (infoA == NULL && infoB == NULL)
+        return NULL;
+
+    // Add a new collision pair for these objects, with the appropriate listeners.
+    info = new CollisionInfo(pair);
+    if (infoA)
+        info->_listeners.insert(info->_listeners.end(), infoA->_listeners.begin(), infoA->_listeners.end());
+    if (infoB)
+        info->_listeners.insert(info->_listeners.end(), infoB->_listeners.begin(), infoB->_listeners.end());
+    _collisionStatus.insert(CollisionPairKey(pair), info);
+    return info;
+}
+
+void PhysicsController::updateTriggers()
+{
+    for (size_t t = 0, triggerCount = _triggers.size(); t < triggerCount; ++t)
+    {
+        PhysicsGhostObject* trigger = _triggers[t];
+        btPairCachingGhostObject* ghost = trigger->_ghostObject;
+        GP_ASSERT(ghost);
+
+        // Gather the objects overlapping the trigger, which the ghost pair callback keeps up to date.
+        _triggerOverlaps.clear();
+        for (int i = 0, count = ghost->getNumOverlappingObjects(); i < count; ++i)
+        {
+            PhysicsCollisionObject* object = getCollisionObject(ghost->getOverlappingObject(i));
+            if (object && object != trigger)
+                _triggerOverlaps.push_back(object);
+        }
+        std::sort(_triggerOverlaps.begin(), _triggerOverlaps.end());
+
+        std::vector<PhysicsCollisionObject*>& reported = trigger->_triggerOverlaps;
+        if (_triggerOverlaps == reported)
+            continue;
+
+        // Compare the overlapping objects with the reported ones, both sorted, and keep the
+        // overlapping objects that are reported in place of the current ones.
+        const btVector3& triggerOrigin = ghost->getWorldTransform().getOrigin();
+        size_t i = 0, j = 0, kept = 0;
+        size_t reportedCount = reported.size(), overlapCount = _triggerOverlaps.size();
+        while (i < reportedCount || j < overlapCount)
+        {
+            if (j == overlapCount || (i < reportedCount && reported[i] < _triggerOverlaps[j]))
+            {
+                // The object left the trigger, so the pair fires NOT_COLLIDING below.
+                CollisionInfo* info = findCollisionInfo(PhysicsCollisionObject::CollisionPair(trigger, reported[i]));
+                if (info && (info->_status & TRIGGER) != 0)
+                {
+                    info->_status &= ~TRIGGER;
+                    info->_frame = 0;
+                }
+                ++i;
+            }
+            else if (i == reportedCount || _triggerOverlaps[j] < reported[i])
+            {
+                // The object entered the trigger. Objects nobody listens to are not reported,
+                // so they are checked again until they leave or a listener is added.
+                PhysicsCollisionObject* object = _triggerOverlaps[j++];
+                CollisionInfo* info = getListenedCollisionInfo(trigger, object);
+                if (info == NULL || (info->_status & REMOVE) != 0)
+                    continue;
+
+                info->_status |= TRIGGER;
+                _triggerOverlaps[kept++] = object;
+                if ((info->_status & COLLISION) == 0)
+                {
+                    info->_status |= COLLISION;
+                    _collidingPairs.push_back(info->_pair);
+
+                    // The points of the events are the origins of the objects, in the order of the pair.
+                    const btVector3& objectOrigin = object->getCollisionObject()->getWorldTransform().getOrigin();
+                    bool swapped = info->_pair.objectA != trigger;
+                    const btVector3& pointA = swapped ? objectOrigin : triggerOrigin;
+                    const btVector3& pointB = swapped ? triggerOrigin : objectOrigin;
+                    size_t size = info->_listeners.size();
+                    for (size_t k = 0; k < size; k++)
+                    {
+                        GP_ASSERT(info->_listeners[k]);
+                        fireCollisionEvent(info->_listeners[k], PhysicsCollisionObject::CollisionListener::COLLIDING, info->_pair,
+                            Vector3(pointA.x(), pointA.y(), pointA.z()), Vector3(pointB.x(), pointB.y(), pointB.z()));
+                    }
+                }
+            }
+            else
+            {
+                _triggerOverlaps[kept++] = _triggerOverlaps[j];
+                ++i;
+                ++j;
+            }
+        }
+        _triggerOverlaps.resize(kept);
+        reported.swap(_triggerOverlaps);
+    }
+}
+
+void PhysicsController::removeTrigger(PhysicsGhostObject* trigger)
+{
+    GP_ASSERT(trigger);
+
+    std::vector<PhysicsGhostObject*>::iterator itr = std::find(_triggers.begin(), _triggers.end(), trigger);
+    if (itr != _triggers.end())
+        _triggers.erase(itr);
+
+    // The reported pairs stop colliding with the next step, unless their contacts are computed.
+    for (size_t i = 0, count = trigger->_triggerOverlaps.size(); i < count; ++i)
+    {
+        CollisionInfo* info = findCollisionInfo(PhysicsCollisionObject::CollisionPair(trigger, trigger->_triggerOverlaps[i]));
+        if (info && (info->_status & TRIGGER) != 0)
+        {
+            info->_status &= ~TRIGGER;
+            info->_frame = 0;
+        }
+    }
+    trigger->_triggerOverlaps.clear();
+}
+
+void PhysicsController::removeTriggerOverlap(const PhysicsCollisionObject::CollisionPair& pair)
+{
+    for (size_t i = 0, count = _triggers.size(); i < count; ++i)
+    {
+        PhysicsGhostObject* trigger = _triggers[i];
+        if (trigger != pair.objectA && trigger != pair.objectB)
+            continue;
+
+        // Forgetting every object of the trigger only makes them checked again.
+        PhysicsCollisionObject* object = trigger == pair.objectA ? pair.objectB : pair.objectA;
+        std::vector<PhysicsCollisionObject*>& reported = trigger->_triggerOverlaps;
+        if (object == NULL)
+        {
+            reported.clear();
+            continue;
+        }
+        std::vector<PhysicsCollisionObject*>::iterator itr = std::lower_bound(reported.begin(), reported.end(), object);
+        if (itr != reported.end() && *itr == object)
+            reported.erase(itr);
+    }
+}
+
+void PhysicsController::nearCallback(btBroadphasePair& collisionPair, btCollisionDispatcher& dispatcher, const btDispatcherInfo& dispatchInfo)
+{
+    // Trigger volumes only use the overlapping pairs of the broadphase.
+    for (int i = 0; i < 2; ++i)
+    {
+        btBroadphaseProxy* proxy = i == 0 ? collisionPair.m_pProxy0 : collisionPair.m_pProxy1;
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(((btCollisionObject*)proxy->m_clientObject)->getUserPointer());
+        if (object && object->getType() == PhysicsCollisionObject::GHOST_OBJECT && static_cast<PhysicsGhostObject*>(object)->_trigger)
+            return;
+    }
+    btCollisionDispatcher::defaultNearCallback(collisionPair, dispatcher, dispatchInfo);
+}
+
+void PhysicsController::setThreaded(bool threaded)
+{
+    if (threaded == (_stepThread != NULL))
+        return;
+
+    if (threaded)
+    {
+        _stepExit = false;
+        _stepThread = Thread::create(&PhysicsController::stepThreadMain, this);
+        if (_stepThread == NULL)
+        {
+            GP_WARN("Failed to create the physics thread; stepping the simulation during update.");
+        }
+    }
+    else
+    {
+        waitForStep();
+        {
+            Mutex::Lock lock(_stepMutex);
+            _stepExit = true;
+            _stepCondition.broadcast();
+        }
+        SAFE_DELETE(_stepThread);
+
+        // Publish the last step so no transforms or events are lost.
+        publishStep();
+    }
+}
+
+bool PhysicsController::isThreaded() const
+{
+    return _stepThread != NULL;
+}
+
+bool PhysicsController::isMultithreaded() const
+{
+    return _multithreaded;
+}
+
+void PhysicsController::beginStep()
+{
+    if (_stepThread == NULL || _stepTime <= 0.0f || Game::getInstance()->isPipelined())
+        return;
 
-        // If the status has changed, notify our listeners.
-        if (oldStatus != _status)
+    // Copy the transforms of kinematic objects from their nodes while the game thread owns them.
+    for (int i = 0, count = _world->getNumCollisionObjects(); i < count; ++i)
+    {
+        PhysicsCollisionObject* object = getCollisionObject(_world->getCollisionObjectArray()[i]);
+        if (object && object->_motionState && object->isKinematic())
         {
-            if (_listeners)
-            {
-                for (unsigned int k = 0; k < _listeners->size(); k++)
-                {
-                    GP_ASSERT((*_listeners)[k]);
-                    (*_listeners)[k]->statusEvent(_status);
-                }
-            }
+            object->_motionState->updateTransformFromNode();
+        }
+    }
+
+    Mutex::Lock lock(_stepMutex);
+    _stepping = true;
+    _stepCondition.signal();
+}
 
-            fireScriptEvent<void>("statusEvent", _status);
+void PhysicsController::waitForStep()
+{
+    if (_stepThread == NULL)
+        return;
+
+    Mutex::Lock lock(_stepMutex);
+    while (_stepping)
+    {
+        _stepCondition.wait(_stepMutex);
+    }
+}
+
+void PhysicsController::publishStep()
+{
+    // Copy the interpolated transforms of the simulated objects to their nodes.
+    for (int i = 0, count = _world ? _world->getNumCollisionObjects() : 0; i < count; ++i)
+    {
+        PhysicsCollisionObject* object = getCollisionObject(_world->getCollisionObjectArray()[i]);
+        if (object && object->_motionState && object->_motionState->_pending)
+        {
+            object->_motionState->updateNodeFromTransform();
         }
     }
 
-    // All statuses are set with the DIRTY bit before collision processing occurs.
-    // During collision processing, if a collision occurs, the status is 
-    // set to COLLISION and the DIRTY bit is cleared. Then, after collision processing 
-    // is finished, if a given status is still dirty, the COLLISION bit is cleared.
-    //
-    // If an entry was marked for removal in the last frame, fire NOT_COLLIDING if appropriate and remove it now.
+    if (_statusChanged)
+    {
+        _statusChanged = false;
+        fireStatusEvent();
+    }
 
-    // Dirty the collision status cache entries.
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end();)
+    // Dispatch the queued collision events, skipping pairs whose listeners were removed since the step.
+    if (!_collisionEvents.empty())
     {
-        if ((iter->second._status & REMOVE) != 0)
+        // Listeners can queue new events, so dispatch a copy and keep the capacity of the queue.
+        ScratchMemory::Scope scratch;
+        ScratchVector<CollisionEvent>::type events(_collisionEvents.begin(), _collisionEvents.end());
+        _collisionEvents.clear();
+        for (size_t i = 0, count = events.size(); i < count; ++i)
         {
-            if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
+            const CollisionEvent& event = events[i];
+            CollisionInfo* info = findCollisionInfo(event._pair);
+            if (info == NULL || (info->_status & REMOVE) == 0)
             {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    PhysicsCollisionObject::CollisionPair cp(iter->first.objectA, NULL);
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, cp);
-                }
+                event._listener->collisionEvent(event._type, event._pair, event._contactPointA, event._contactPointB);
             }
-
-            std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator eraseIter = iter;
-            iter++;
-            _collisionStatus.erase(eraseIter);
-        }
-        else
-        {
-            iter->second._status |= DIRTY;
-            iter++;
         }
     }
+}
+
+void PhysicsController::fireCollisionEvent(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject::CollisionListener::EventType type,
+                                           const PhysicsCollisionObject::CollisionPair& pair, const Vector3& contactPointA, const Vector3& contactPointB)
+{
+    GP_ASSERT(listener);
+
+    if (_deferEvents)
+    {
+        CollisionEvent event;
+        event._listener = listener;
+        event._type = type;
+        event._pair = pair;
+        event._contactPointA = contactPointA;
+        event._contactPointB = contactPointB;
+        _collisionEvents.push_back(event);
+    }
+    else
+    {
+        listener->collisionEvent(type, pair, contactPointA, contactPointB);
+    }
+}
 
-    // Go through the collision status cache and perform all registered collision tests.
-    iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end(); iter++)
+void PhysicsController::fireStatusEvent()
+{
+    if (_listeners)
     {
-        // If this collision pair was one that was registered for listening, then perform the collision test.
-        // (In the case where we register for all collisions with a rigid body, there will be a lot
-        // of collision pairs in the status cache that we did not explicitly register for.)
-        if ((iter->second._status & REGISTERED) != 0 && (iter->second._status & REMOVE) == 0)
+        for (unsigned int k = 0; k < _listeners->size(); k++)
         {
-            if (iter->first.objectB)
-                _world->contactPairTest(iter->first.objectA->getCollisionObject(), iter->first.objectB->getCollisionObject(), *_collisionCallback);
-            else
-                _world->contactTest(iter->first.objectA->getCollisionObject(), *_collisionCallback);
+            GP_ASSERT((*_listeners)[k]);
+            (*_listeners)[k]->statusEvent(_status);
         }
     }
 
-    // Update all the collision status cache entries.
-    iter = _collisionStatus.begin();
-    for ( ; iter != _collisionStatus.end(); iter++)
+    fireScriptEvent<void>(PHYSICS_EVENT_STATUS, _status);
+}
+
+int PhysicsController::stepThreadMain(void* arg)
+{
+    PhysicsController* controller = (PhysicsController*)arg;
+    GP_ASSERT(controller);
+
+    while (true)
     {
-        if ((iter->second._status & DIRTY) != 0)
         {
-            if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
+            Mutex::Lock lock(controller->_stepMutex);
+            while (!controller->_stepping && !controller->_stepExit)
             {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, iter->first);
-                }
+                controller->_stepCondition.wait(controller->_stepMutex);
             }
-
-            iter->second._status &= ~COLLISION;
+            if (controller->_stepExit)
+                break;
         }
-    }
 
-    _isUpdating = false;
+        // The game thread does not touch the world until the step is complete.
+        controller->_deferEvents = true;
+        controller->stepSimulation(controller->_stepTime);
+        controller->_stepTime = 0.0f;
+        controller->_deferEvents = false;
+
+        Mutex::Lock lock(controller->_stepMutex);
+        controller->_stepping = false;
+        controller->_stepCondition.broadcast();
+    }
+    return 0;
 }
 
 void PhysicsController::addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
 {
     GP_ASSERT(listener);
+    waitForStep();
     
     // One of the collision objects in the pair must be non-null.
     GP_ASSERT(objectA || objectB);
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
     // Add the listener and ensure the status includes that this collision pair is registered.
-    CollisionInfo& info = _collisionStatus[pair];
-    info._listeners.push_back(listener);
-    info._status |= PhysicsController::REGISTERED;
+    CollisionInfo* info = findCollisionInfo(pair);
+    if (info == NULL)
+    {
+        info = new CollisionInfo(pair);
+        _collisionStatus.insert(CollisionPairKey(pair), info);
+    }
+    info->_listeners.push_back(listener);
+    info->_status |= PhysicsController::REGISTERED;
 }
 
 void PhysicsController::removeCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
 {
+    waitForStep();
+
     // One of the collision objects in the pair must be non-null.
     GP_ASSERT(objectA || objectB);
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
     // Mark the collision pair for these objects for removal.
-    if (_collisionStatus.count(pair) > 0)
+    CollisionInfo* info = findCollisionInfo(pair);
+    if (info && (info->_status & REMOVE) == 0)
     {
-        _collisionStatus[pair]._status |= REMOVE;
+        info->_status |= REMOVE;
+        _removedPairs.push_back(info->_pair);
     }
 }
 
@@ -636,6 +1465,7 @@ void PhysicsController::addCollisionObject(PhysicsCollisionObject* object)
 {
     GP_ASSERT(object && object->getCollisionObject());
     GP_ASSERT(_world);
+    waitForStep();
 
     // Assign user pointer for the bullet collision object to allow efficient
     // lookups of bullet objects -> gameplay objects.
@@ -668,6 +1498,8 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
 {
     GP_ASSERT(object);
     GP_ASSERT(_world);
+    waitForStep();
+
     GP_ASSERT(!_isUpdating);
 
     // Remove the collision object from the world.
@@ -690,14 +1522,24 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
         }
     }
 
+    // Drop the queued events of the object, which may be destroyed before they are dispatched.
+    for (size_t i = _collisionEvents.size(); i > 0; --i)
+    {
+        if (_collisionEvents[i - 1]._pair.objectA == object || _collisionEvents[i - 1]._pair.objectB == object)
+            _collisionEvents.erase(_collisionEvents.begin() + (i - 1));
+    }
+
     // Find all references to the object in the collision status cache and mark them for removal.
     if (removeListeners)
     {
-        std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-        for (; iter != _collisionStatus.end(); iter++)
+        for (int i = 0; i < _collisionStatus.size(); ++i)
         {
-            if (iter->first.objectA == object || iter->first.objectB == object)
-                iter->second._status |= REMOVE;
+            CollisionInfo* info = *_collisionStatus.getAtIndex(i);
+            if ((info->_pair.objectA == object || info->_pair.objectB == object) && (info->_status & REMOVE) == 0)
+            {
+                info->_status |= REMOVE;
+                _removedPairs.push_back(info->_pair);
+            }
         }
     }
 }
@@ -917,9 +1759,12 @@ PhysicsCollisionShape* PhysicsController::createBox(const Vector3& extents, cons
     PhysicsCollisionShape* shape;
 
     // Return the box shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); ++i)
+    float dimensions[3] = { halfExtents.x(), halfExtents.y(), halfExtents.z() };
+    unsigned int key = getShapeKey(PhysicsCollisionShape::SHAPE_BOX, dimensions, 3);
+    std::pair<ShapeCache::iterator, ShapeCache::iterator> range = _shapes.equal_range(key);
+    for (ShapeCache::iterator itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_BOX)
         {
@@ -934,7 +1779,7 @@ PhysicsCollisionShape* PhysicsController::createBox(const Vector3& extents, cons
 
     // Create the box shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_BOX, bullet_new<btBoxShape>(halfExtents));
-    _shapes.push_back(shape);
+    addShape(shape, key, sizeof(btBoxShape));
 
     return shape;
 }
@@ -954,9 +1799,11 @@ PhysicsCollisionShape* PhysicsController::createSphere(float radius, const Vecto
     PhysicsCollisionShape* shape;
 
     // Return the sphere shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); ++i)
+    unsigned int key = getShapeKey(PhysicsCollisionShape::SHAPE_SPHERE, &scaledRadius, 1);
+    std::pair<ShapeCache::iterator, ShapeCache::iterator> range = _shapes.equal_range(key);
+    for (ShapeCache::iterator itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_SPHERE)
         {
@@ -971,7 +1818,7 @@ PhysicsCollisionShape* PhysicsController::createSphere(float radius, const Vecto
 
     // Create the sphere shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_SPHERE, bullet_new<btSphereShape>(scaledRadius));
-    _shapes.push_back(shape);
+    addShape(shape, key, sizeof(btSphereShape));
 
     return shape;
 }
@@ -987,9 +1834,12 @@ PhysicsCollisionShape* PhysicsController::createCapsule(float radius, float heig
     PhysicsCollisionShape* shape;
 
     // Return the capsule shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); i++)
+    float dimensions[2] = { scaledRadius, scaledHeight };
+    unsigned int key = getShapeKey(PhysicsCollisionShape::SHAPE_CAPSULE, dimensions, 2);
+    std::pair<ShapeCache::iterator, ShapeCache::iterator> range = _shapes.equal_range(key);
+    for (ShapeCache::iterator itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_CAPSULE)
         {
@@ -1004,7 +1854,7 @@ PhysicsCollisionShape* PhysicsController::createCapsule(float radius, float heig
 
     // Create the capsule shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_CAPSULE, bullet_new<btCapsuleShape>(scaledRadius, scaledHeight));
-    _shapes.push_back(shape);
+    addShape(shape, key, sizeof(btCapsuleShape));
 
     return shape;
 }
@@ -1017,10 +1867,13 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
 
     // Inspect the height array for the min and max values
     float* heights = heightfield->getArray();
+    short* quantized = heightfield->getQuantizedArray();
+    float heightScale = heightfield->getQuantizationScale();
+    float heightOffset = heightfield->getQuantizationOffset();
     float minHeight = FLT_MAX, maxHeight = -FLT_MAX;
     for (unsigned int i = 0, count = heightfield->getColumnCount()*heightfield->getRowCount(); i < count; ++i)
     {
-        float h = heights[i];
+        float h = quantized ? heightOffset + quantized[i] * heightScale : heights[i];
         if (h < minHeight)
             minHeight = h;
         if (h > maxHeight)
@@ -1050,9 +1903,19 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     heightfieldData->minHeight = minHeight;
     heightfieldData->maxHeight = maxHeight;
 
-    // Create the bullet terrain shape
-    btHeightfieldTerrainShape* terrainShape = bullet_new<btHeightfieldTerrainShape>(
-        heightfield->getColumnCount(), heightfield->getRowCount(), heightfield->getArray(), 1.0f, minHeight, maxHeight, 1, PHY_FLOAT, false);
+    // Create the bullet terrain shape. Bullet reads quantized heights directly, scaled but without
+    // the offset, which does not move the shape since its center is the middle of the height range.
+    btHeightfieldTerrainShape* terrainShape;
+    if (quantized)
+    {
+        terrainShape = bullet_new<btHeightfieldTerrainShape>(heightfield->getColumnCount(), heightfield->getRowCount(),
+            quantized, heightScale, minHeight - heightOffset, maxHeight - heightOffset, 1, PHY_SHORT, false);
+    }
+    else
+    {
+        terrainShape = bullet_new<btHeightfieldTerrainShape>(heightfield->getColumnCount(), heightfield->getRowCount(),
+            heights, 1.0f, minHeight, maxHeight, 1, PHY_FLOAT, false);
+    }
 
     // Set initial bullet local scaling for the heightfield
     terrainShape->setLocalScaling(BV(scale));
@@ -1061,7 +1924,8 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     PhysicsCollisionShape* shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_HEIGHTFIELD, terrainShape);
     shape->_shapeData.heightfieldData = heightfieldData;
 
-    _shapes.push_back(shape);
+    // Heightfields are never shared, but are kept with the other shapes so their memory is reported.
+    addShape(shape, getShapeKey(PhysicsCollisionShape::SHAPE_HEIGHTFIELD, NULL, 0), sizeof(btHeightfieldTerrainShape) + sizeof(PhysicsCollisionShape::HeightfieldData));
 
     return shape;
 }
@@ -1107,6 +1971,25 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         }
     }
 
+    // Return the mesh shape from the cache if it already exists.
+    float dimensions[4] = { scale.x, scale.y, scale.z, dynamic ? 1.0f : 0.0f };
+    unsigned int key = getShapeKey(PhysicsCollisionShape::SHAPE_MESH, dimensions, 4, mesh->getUrl());
+    std::pair<ShapeCache::iterator, ShapeCache::iterator> range = _shapes.equal_range(key);
+    for (ShapeCache::iterator itr = range.first; itr != range.second; ++itr)
+    {
+        PhysicsCollisionShape* shape = itr->second;
+        GP_ASSERT(shape);
+        if (shape->getType() == PhysicsCollisionShape::SHAPE_MESH)
+        {
+            PhysicsCollisionShape::MeshData* meshData = shape->_shapeData.meshData;
+            if (meshData && meshData->dynamic == dynamic && meshData->scale == scale && meshData->url == mesh->getUrl())
+            {
+                shape->addRef();
+                return shape;
+            }
+        }
+    }
+
     // Read mesh data from URL
     Bundle::MeshData* data = Bundle::readMeshData(mesh->getUrl());
     if (data == NULL)
@@ -1118,6 +2001,10 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     // Create mesh data to be populated and store in returned collision shape.
     PhysicsCollisionShape::MeshData* shapeMeshData = new PhysicsCollisionShape::MeshData();
     shapeMeshData->vertexData = NULL;
+    shapeMeshData->url = mesh->getUrl();
+    shapeMeshData->scale = scale;
+    shapeMeshData->dynamic = dynamic;
+    shapeMeshData->bvhData = NULL;
 
     // Copy the scaled vertex position data to the rigid body's local buffer.
     Matrix m;
@@ -1126,17 +2013,21 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     shapeMeshData->vertexData = new float[vertexCount * 3];
     Vector3 v;
     int vertexStride = data->vertexFormat.getVertexSize();
+    const VertexFormat::Element& position = data->vertexFormat.getElement(0);
+    GP_ASSERT(position.usage == VertexFormat::POSITION && position.size >= 3);
     for (unsigned int i = 0; i < data->vertexCount; i++)
     {
-        v.set(*((float*)&data->vertexData[i * vertexStride + 0 * sizeof(float)]),
-                *((float*)&data->vertexData[i * vertexStride + 1 * sizeof(float)]),
-                *((float*)&data->vertexData[i * vertexStride + 2 * sizeof(float)]));
+        // Positions may be stored in a packed type (such as half floats).
+        float values[4];
+        VertexFormat::toFloat(position, &data->vertexData[i * vertexStride], values);
+        v.set(values[0], values[1], values[2]);
         v *= m;
         memcpy(&(shapeMeshData->vertexData[i * 3]), &v, sizeof(float) * 3);
     }
 
     btCollisionShape* collisionShape = NULL;
     btTriangleIndexVertexArray* meshInterface = NULL;
+    size_t memoryUsage = sizeof(PhysicsCollisionShape::MeshData);
 
     if (dynamic)
     {
@@ -1147,6 +2038,7 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
 	    btShapeHull* hull = bullet_new<btShapeHull>(originalConvexShape);
 	    hull->buildHull(originalConvexShape->getMargin());
 	    collisionShape = bullet_new<btConvexHullShape>((btScalar*)hull->getVertexPointer(), hull->numVertices());
+        memoryUsage += sizeof(btConvexHullShape) + hull->numVertices() * sizeof(btVector3);
 
         SAFE_DELETE(hull);
         SAFE_DELETE(originalConvexShape);
@@ -1194,6 +2086,7 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
                 // Set it to NULL in the MeshPartData so it is not released when the data is freed.
                 shapeMeshData->indexData.push_back(meshPart->indexData);
                 meshPart->indexData = NULL;
+                memoryUsage += meshPart->indexCount * indexStride;
 
                 // Create a btIndexedMesh object for the current mesh part.
                 btIndexedMesh indexedMesh;
@@ -1219,6 +2112,7 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
                 indexData[i] = i;
             }
             shapeMeshData->indexData.push_back((unsigned char*)indexData);
+            memoryUsage += data->vertexCount * sizeof(unsigned int);
 
             // Create a single btIndexedMesh object for the mesh interface.
             btIndexedMesh indexedMesh;
@@ -1236,14 +2130,17 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         }
 
         // Create our collision shape object and store shapeMeshData in it.
-        collisionShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+        btBvhTriangleMeshShape* triangleMeshShape = createBvhTriangleMeshShape(meshInterface, shapeMeshData, data->vertexCount);
+        memoryUsage += sizeof(btBvhTriangleMeshShape) + sizeof(btTriangleIndexVertexArray) + vertexCount * 3 * sizeof(float);
+        if (triangleMeshShape->getOptimizedBvh())
+            memoryUsage += triangleMeshShape->getOptimizedBvh()->calculateSerializeBufferSize();
+        collisionShape = triangleMeshShape;
     }
 
     // Create our collision shape object and store shapeMeshData in it.
     PhysicsCollisionShape* shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_MESH, collisionShape, meshInterface);
     shape->_shapeData.meshData = shapeMeshData;
-
-    _shapes.push_back(shape);
+    addShape(shape, key, memoryUsage);
 
     // Free the temporary mesh data now that it's stored in physics system.
     SAFE_DELETE(data);
@@ -1251,6 +2148,354 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     return shape;
 }
 
+btBvhTriangleMeshShape* PhysicsController::createBvhTriangleMeshShape(btTriangleIndexVertexArray* meshInterface, PhysicsCollisionShape::MeshData* meshData, unsigned int vertexCount)
+{
+    GP_ASSERT(meshInterface);
+    GP_ASSERT(meshData);
+
+    if (_shapeCachePath.empty())
+        return bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+
+    // The file is named after the mesh and its scale, and holds a hash of the triangles it was built from.
+    unsigned int nameHash = hashBytes(meshData->url.c_str(), meshData->url.size(), 2166136261u);
+    nameHash = hashBytes(&meshData->scale, sizeof(Vector3), nameHash);
+    unsigned int checkHash = hashBytes(meshData->vertexData, vertexCount * 3 * sizeof(float), nameHash ^ 0x5BD1E995u);
+    IndexedMeshArray& indexedMeshes = meshInterface->getIndexedMeshArray();
+    for (int i = 0; i < indexedMeshes.size(); ++i)
+    {
+        const btIndexedMesh& indexedMesh = indexedMeshes[i];
+        checkHash = hashBytes(indexedMesh.m_triangleIndexBase, indexedMesh.m_numTriangles * indexedMesh.m_triangleIndexStride, checkHash);
+    }
+    char name[16];
+    sprintf(name, "%08x.bvh", nameHash);
+    std::string path = _shapeCachePath + "/" + name;
+
+    // Header: identifier, check hash, Bullet version, scalar size and hierarchy size.
+    unsigned int header[4] = { checkHash, (unsigned int)BT_BULLET_VERSION, (unsigned int)sizeof(btScalar), 0 };
+    if (FileSystem::fileExists(path.c_str()))
+    {
+        std::auto_ptr<Stream> stream(FileSystem::open(path.c_str()));
+        char identifier[sizeof(SHAPE_CACHE_IDENTIFIER)];
+        unsigned int fileHeader[4];
+        if (stream.get() &&
+            stream->read(identifier, 1, sizeof(identifier)) == sizeof(identifier) && memcmp(identifier, SHAPE_CACHE_IDENTIFIER, sizeof(identifier)) == 0 &&
+            stream->read(fileHeader, sizeof(unsigned int), 4) == 4 && memcmp(fileHeader, header, sizeof(unsigned int) * 3) == 0 &&
+            fileHeader[3] > 0 && fileHeader[3] == stream->length() - sizeof(identifier) - sizeof(fileHeader))
+        {
+            // Bullet reads the hierarchy in place, from memory that must outlive the shape.
+            void* bvhData = btAlignedAlloc(fileHeader[3], PHYSICS_BVH_ALIGNMENT);
+            btOptimizedBvh* bvh = NULL;
+            if (stream->read(bvhData, 1, fileHeader[3]) == fileHeader[3])
+            {
+                bvh = (btOptimizedBvh*)btOptimizedBvh::deSerializeInPlace(bvhData, fileHeader[3], false);
+            }
+            if (bvh)
+            {
+                btBvhTriangleMeshShape* shape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true, false);
+                shape->setOptimizedBvh(bvh);
+                meshData->bvhData = bvhData;
+                return shape;
+            }
+            btAlignedFree(bvhData);
+        }
+    }
+
+    // Build the hierarchy and save it for the next runs.
+    btBvhTriangleMeshShape* shape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+    btOptimizedBvh* bvh = shape->getOptimizedBvh();
+    if (bvh)
+    {
+        header[3] = bvh->calculateSerializeBufferSize();
+        void* bvhData = btAlignedAlloc(header[3], PHYSICS_BVH_ALIGNMENT);
+        if (bvh->serialize(bvhData, header[3], false))
+        {
+            std::auto_ptr<Stream> stream(FileSystem::open(path.c_str(), FileSystem::WRITE));
+            if (stream.get() == NULL ||
+                stream->write(SHAPE_CACHE_IDENTIFIER, 1, sizeof(SHAPE_CACHE_IDENTIFIER)) != sizeof(SHAPE_CACHE_IDENTIFIER) ||
+                stream->write(header, sizeof(unsigned int), 4) != 4 ||
+                stream->write(bvhData, 1, header[3]) != header[3])
+            {
+                GP_WARN("Failed to write the shape cache file '%s'.", path.c_str());
+            }
+        }
+        btAlignedFree(bvhData);
+    }
+    return shape;
+}
+
+void PhysicsController::setShapeCachePath(const char* path)
+{
+    _shapeCachePath = path ? path : "";
+}
+
+unsigned int PhysicsController::getShapeCount() const
+{
+    return (unsigned int)_shapes.size();
+}
+
+size_t PhysicsController::getShapeMemoryUsage() const
+{
+    return _shapeMemoryUsage;
+}
+
+const char* PhysicsController::getShapeCachePath() const
+{
+    return _shapeCachePath.empty() ? NULL : _shapeCachePath.c_str();
+}
+
+void PhysicsController::setSolverIterations(int iterations)
+{
+    GP_ASSERT(_world);
+    GP_ASSERT(iterations > 0);
+    waitForStep();
+
+    _world->getSolverInfo().m_numIterations = iterations;
+}
+
+int PhysicsController::getSolverIterations() const
+{
+    GP_ASSERT(_world);
+    return _world->getSolverInfo().m_numIterations;
+}
+
+void PhysicsController::setSleepingEnabled(bool sleeping)
+{
+    waitForStep();
+
+    gDisableDeactivation = !sleeping;
+}
+
+bool PhysicsController::isSleepingEnabled() const
+{
+    return !gDisableDeactivation;
+}
+
+void PhysicsController::setDeactivationTime(float time)
+{
+    waitForStep();
+
+    gDeactivationTime = time;
+}
+
+float PhysicsController::getDeactivationTime() const
+{
+    return gDeactivationTime;
+}
+
+void PhysicsController::setLodCamera(Camera* camera)
+{
+    if (camera == _lodCamera)
+        return;
+
+    SAFE_RELEASE(_lodCamera);
+    _lodCamera = camera;
+    if (_lodCamera)
+    {
+        _lodCamera->addRef();
+    }
+    else
+    {
+        // Give every body its full simulation back.
+        updateLod();
+    }
+}
+
+Camera* PhysicsController::getLodCamera() const
+{
+    return _lodCamera;
+}
+
+void PhysicsController::setLodDistance(float distance)
+{
+    _lodDistance = distance;
+}
+
+float PhysicsController::getLodDistance() const
+{
+    return _lodDistance;
+}
+
+void PhysicsController::setLodSleepingThresholds(float linear, float angular)
+{
+    _lodLinearSleepingThreshold = linear;
+    _lodAngularSleepingThreshold = angular;
+}
+
+float PhysicsController::getLodLinearSleepingThreshold() const
+{
+    return _lodLinearSleepingThreshold;
+}
+
+float PhysicsController::getLodAngularSleepingThreshold() const
+{
+    return _lodAngularSleepingThreshold;
+}
+
+void PhysicsController::setLodSolverIterations(int iterations)
+{
+    GP_ASSERT(iterations > 0);
+    _lodSolverIterations = iterations;
+}
+
+int PhysicsController::getLodSolverIterations() const
+{
+    return _lodSolverIterations;
+}
+
+void PhysicsController::updateLod()
+{
+    GP_ASSERT(_world);
+    waitForStep();
+
+    const Frustum* frustum = NULL;
+    Vector3 origin;
+    if (_lodCamera)
+    {
+        frustum = &_lodCamera->getFrustum();
+        if (_lodCamera->getNode())
+            origin = _lodCamera->getNode()->getTranslationWorld();
+    }
+    float lodDistanceSquared = _lodDistance * _lodDistance;
+
+    // Reduce the dynamic bodies that are too far or out of view. Sleeping bodies keep their
+    // level of detail, since they cost nothing until something wakes them up.
+    for (int i = 0, count = _world->getNumCollisionObjects(); i < count; ++i)
+    {
+        btCollisionObject* collisionObject = _world->getCollisionObjectArray()[i];
+        PhysicsCollisionObject* object = getCollisionObject(collisionObject);
+        if (object == NULL || object->getType() != PhysicsCollisionObject::RIGID_BODY)
+            continue;
+
+        PhysicsRigidBody* body = static_cast<PhysicsRigidBody*>(object);
+        bool reduced = false;
+        if (frustum && body->_lodEnabled && !collisionObject->isStaticOrKinematicObject())
+        {
+            if (!collisionObject->isActive())
+                continue;
+
+            btVector3 min, max;
+            collisionObject->getCollisionShape()->getAabb(collisionObject->getWorldTransform(), min, max);
+            BoundingBox box(min.x(), min.y(), min.z(), max.x(), max.y(), max.z());
+            reduced = !frustum->intersects(box) ||
+                (_lodDistance > 0.0f && origin.distanceSquared(box.getCenter()) > lodDistanceSquared);
+        }
+        body->setLodReduced(reduced);
+    }
+
+    // Simplify the collisions of the characters that are too far or out of view.
+    for (size_t i = 0, count = _characters.size(); i < count; ++i)
+    {
+        PhysicsCharacter* character = _characters[i];
+        btCollisionObject* collisionObject = character->getCollisionObject();
+        bool reduced = false;
+        if (frustum && collisionObject)
+        {
+            btVector3 min, max;
+            collisionObject->getCollisionShape()->getAabb(collisionObject->getWorldTransform(), min, max);
+            BoundingBox box(min.x(), min.y(), min.z(), max.x(), max.y(), max.z());
+            reduced = !frustum->intersects(box) ||
+                (_lodDistance > 0.0f && origin.distanceSquared(box.getCenter()) > lodDistanceSquared);
+        }
+        character->_lodReduced = reduced;
+    }
+
+    // Let the reduced vehicles fall asleep, and stop casting the wheels of the sleeping ones.
+    for (size_t i = 0, count = _vehicles.size(); i < count; ++i)
+    {
+        PhysicsVehicle* vehicle = _vehicles[i];
+        btRigidBody* body = static_cast<btRigidBody*>(vehicle->getCollisionObject());
+        if (vehicle->getRigidBody()->_lodReduced)
+        {
+            if (body->getActivationState() == DISABLE_DEACTIVATION)
+                body->forceActivationState(ACTIVE_TAG);
+
+            if (body->isActive() != vehicle->_simulated)
+                vehicle->setSimulated(body->isActive());
+        }
+        else if (!vehicle->_simulated || body->getActivationState() != DISABLE_DEACTIVATION)
+        {
+            body->forceActivationState(DISABLE_DEACTIVATION);
+            vehicle->setSimulated(true);
+        }
+    }
+}
+
+void PhysicsController::updateCharacters(btCollisionWorld* collisionWorld, btScalar timeStep)
+{
+    // Penetrations are resolved one character at a time, since they dispatch the collision
+    // pairs of the characters and move their nodes.
+    unsigned int count = (unsigned int)_characters.size();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _characters[i]->beginUpdate(collisionWorld);
+    }
+
+    // The characters sweep the world as it was at the start of the step.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    CharacterContext context;
+    context.controller = this;
+    context.collisionWorld = collisionWorld;
+    context.timeStep = timeStep;
+    if (count >= PHYSICS_CHARACTER_PARALLEL_COUNT_MIN && scheduler && scheduler->getWorkerCount() > 0)
+    {
+        scheduler->parallelFor(count, &PhysicsController::moveCharacterRange, &context, PHYSICS_CHARACTER_GRAIN_SIZE);
+    }
+    else
+    {
+        moveCharacterRange(&context, 0, count);
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _characters[i]->endUpdate();
+    }
+}
+
+void PhysicsController::moveCharacterRange(void* arg, unsigned int start, unsigned int end)
+{
+    CharacterContext* context = (CharacterContext*)arg;
+    GP_ASSERT(context && context->controller);
+    for (unsigned int i = start; i < end; ++i)
+    {
+        context->controller->_characters[i]->move(context->collisionWorld, context->timeStep);
+    }
+}
+
+PhysicsController::CharacterAction::CharacterAction(PhysicsController* controller) : controller(controller)
+{
+}
+
+void PhysicsController::CharacterAction::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+{
+    GP_ASSERT(controller);
+    if (!controller->_characters.empty())
+        controller->updateCharacters(collisionWorld, deltaTimeStep);
+}
+
+void PhysicsController::CharacterAction::debugDraw(btIDebugDraw* debugDrawer)
+{
+    // Not used yet.
+}
+
+unsigned int PhysicsController::getShapeKey(PhysicsCollisionShape::Type type, const float* dimensions, unsigned int count, const char* url)
+{
+    unsigned int hash = hashBytes(&type, sizeof(type), 2166136261u);
+    if (count > 0)
+        hash = hashBytes(dimensions, count * sizeof(float), hash);
+    if (url)
+        hash = hashBytes(url, strlen(url), hash);
+    return hash;
+}
+
+void PhysicsController::addShape(PhysicsCollisionShape* shape, unsigned int key, size_t memoryUsage)
+{
+    GP_ASSERT(shape);
+    shape->_cacheKey = key;
+    shape->_memoryUsage = memoryUsage;
+    _shapes.insert(std::make_pair(key, shape));
+    _shapeMemoryUsage += memoryUsage;
+}
+
 void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
 {
     if (shape)
@@ -1258,9 +2503,16 @@ void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
         if (shape->getRefCount() == 1)
         {
             // Remove shape from shape cache.
-            std::vector<PhysicsCollisionShape*>::iterator shapeItr = std::find(_shapes.begin(), _shapes.end(), shape);
-            if (shapeItr != _shapes.end())
-                _shapes.erase(shapeItr);
+            std::pair<ShapeCache::iterator, ShapeCache::iterator> range = _shapes.equal_range(shape->_cacheKey);
+            for (ShapeCache::iterator itr = range.first; itr != range.second; ++itr)
+            {
+                if (itr->second == shape)
+                {
+                    _shapeMemoryUsage -= shape->_memoryUsage;
+                    _shapes.erase(itr);
+                    break;
+                }
+            }
         }
 
         // Release the shape.
@@ -1273,6 +2525,7 @@ void PhysicsController::addConstraint(PhysicsRigidBody* a, PhysicsRigidBody* b,
     GP_ASSERT(a);
     GP_ASSERT(constraint);
     GP_ASSERT(_world);
+    waitForStep();
 
     a->addConstraint(constraint);
     if (b)
@@ -1308,6 +2561,7 @@ void PhysicsController::removeConstraint(PhysicsConstraint* constraint)
 {
     GP_ASSERT(constraint);
     GP_ASSERT(_world);
+    waitForStep();
 
     // Find the constraint and remove it from the physics world.
     for (int i = _world->getNumConstraints() - 1; i >= 0; i--)
@@ -1323,100 +2577,28 @@ void PhysicsController::removeConstraint(PhysicsConstraint* constraint)
 
 PhysicsController::DebugDrawer::DebugDrawer()
     : _mode(btIDebugDraw::DBG_DrawAabb | btIDebugDraw::DBG_DrawConstraintLimits | btIDebugDraw::DBG_DrawConstraints | 
-       btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawWireframe), _meshBatch(NULL), _lineCount(0)
-{
-    // Vertex shader for drawing colored lines.
-    const char* vs_str = 
-    {
-        "uniform mat4 u_viewProjectionMatrix;\n"
-        "attribute vec4 a_position;\n"
-        "attribute vec4 a_color;\n"
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "    v_color = a_color;\n"
-        "    gl_Position = u_viewProjectionMatrix * a_position;\n"
-        "}"
-    };
-
-    // Fragment shader for drawing colored lines.
-    const char* fs_str = 
-    {
-    #ifdef OPENGL_ES
-        "precision highp float;\n"
-    #endif
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "   gl_FragColor = v_color;\n"
-        "}"
-    };
-
-    Effect* effect = Effect::createFromSource(vs_str, fs_str);
-    Material* material = Material::create(effect);
-    GP_ASSERT(material && material->getStateBlock());
-    material->getStateBlock()->setDepthTest(true);
-    material->getStateBlock()->setDepthFunction(RenderState::DEPTH_LEQUAL);
-
-    VertexFormat::Element elements[] =
-    {
-        VertexFormat::Element(VertexFormat::POSITION, 3),
-        VertexFormat::Element(VertexFormat::COLOR, 4),
-    };
-    _meshBatch = MeshBatch::create(VertexFormat(elements, 2), Mesh::LINES, material, false, 4096, 4096);
-    SAFE_RELEASE(material);
-    SAFE_RELEASE(effect);
+       btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawWireframe)
+{
 }
 
 PhysicsController::DebugDrawer::~DebugDrawer()
 {
-    SAFE_DELETE(_meshBatch);
 }
 
 void PhysicsController::DebugDrawer::begin(const Matrix& viewProjection)
 {
-    GP_ASSERT(_meshBatch);
-    _meshBatch->start();
-    _meshBatch->getMaterial()->getParameter("u_viewProjectionMatrix")->setValue(viewProjection);
+    _viewProjection = viewProjection;
 }
 
 void PhysicsController::DebugDrawer::end()
 {
-    GP_ASSERT(_meshBatch && _meshBatch->getMaterial());
-    _meshBatch->finish();
-    _meshBatch->draw();
-    _lineCount = 0;
+    DebugDraw::draw(_viewProjection, DebugDraw::PHYSICS);
 }
 
 void PhysicsController::DebugDrawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& fromColor, const btVector3& toColor)
 {
-    GP_ASSERT(_meshBatch);
-
-    static DebugDrawer::DebugVertex vertices[2];
-
-    vertices[0].x = from.getX();
-    vertices[0].y = from.getY();
-    vertices[0].z = from.getZ();
-    vertices[0].r = fromColor.getX();
-    vertices[0].g = fromColor.getY();
-    vertices[0].b = fromColor.getZ();
-    vertices[0].a = 1.0f;
-
-    vertices[1].x = to.getX();
-    vertices[1].y = to.getY();
-    vertices[1].z = to.getZ();
-    vertices[1].r = toColor.getX();
-    vertices[1].g = toColor.getY();
-    vertices[1].b = toColor.getZ();
-    vertices[1].a = 1.0f;
-
-    _meshBatch->add(vertices, 2);
-
-    ++_lineCount;
-    if (_lineCount >= 4096)
-    {
-        // Flush the batch when it gets full (don't want to to grow infinitely)
-        end();
-        _meshBatch->start();
-    }
+    DebugDraw::drawLine(Vector3(from.x(), from.y(), from.z()), Vector3(to.x(), to.y(), to.z()),
+        Vector4(fromColor.x(), fromColor.y(), fromColor.z(), 1.0f), Vector4(toColor.x(), toColor.y(), toColor.z(), 1.0f), DebugDraw::PHYSICS);
 }
 
 void PhysicsController::DebugDrawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& color)
@@ -1436,7 +2618,7 @@ void PhysicsController::DebugDrawer::reportErrorWarning(const char* warningStrin
 
 void PhysicsController::DebugDrawer::draw3dText(const btVector3& location, const char* textString)
 {
-    GP_WARN("Physics debug drawing: 3D text is not supported.");
+    DebugDraw::drawText(Vector3(location.x(), location.y(), location.z()), textString, Vector4::one(), DebugDraw::PHYSICS);
 }
 
 void PhysicsController::DebugDrawer::setDebugMode(int mode)
@@ -11,11 +11,16 @@
 #include "MeshBatch.h"
 #include "HeightField.h"
 #include "ScriptTarget.h"
+#include "Thread.h"
 
 namespace gameplay
 {
 
 class ScriptListener;
+class PhysicsVehicle;
+class PhysicsCharacter;
+class PhysicsGhostObject;
+class Camera;
 
 /**
  * Defines a class for controlling game physics.
@@ -31,6 +36,7 @@ class PhysicsController : public ScriptTarget
     friend class PhysicsVehicle;
     friend class PhysicsCollisionObject;
     friend class PhysicsGhostObject;
+    friend class PhysicsCollisionObject::PhysicsMotionState;
 
 public:
 
@@ -291,6 +297,9 @@ public:
 
     /**
      * Draws debugging information (rigid body outlines, etc.) using the given view projection matrix.
+     *
+     * The lines are drawn through DebugDraw, in its PHYSICS category, which can be disabled
+     * to skip generating them.
      * 
      * @param viewProjection The view projection matrix to use when drawing.
      */
@@ -329,44 +338,334 @@ public:
      */
     bool sweepTest(PhysicsCollisionObject* object, const Vector3& endPosition, PhysicsController::HitResult* result = NULL, PhysicsController::HitFilter* filter = NULL);
 
-private:
+    /**
+     * Performs a batch of ray tests on the physics world, running them in parallel on the job scheduler.
+     *
+     * Each ray is tested the same way as by the single ray test, except that the filter
+     * is called from the job worker threads and must be safe to call from several threads
+     * at the same time.
+     *
+     * @param rays The rays to test.
+     * @param distances How far along each ray to test for intersections.
+     * @param count The number of rays.
+     * @param results The array of count hit results to store the results in. The object
+     *      of the result of each ray that does not hit anything is set to NULL.
+     * @param filter Optional filter pointer used to control which objects are tested.
+     *
+     * @return The number of rays that collided with a physics object.
+     * @script{ignore}
+     */
+    unsigned int rayTest(const Ray* rays, const float* distances, unsigned int count, PhysicsController::HitResult* results,
+                         PhysicsController::HitFilter* filter = NULL);
 
     /**
-     * Internal class used to integrate with Bullet collision callbacks.
+     * Performs a batch of sweep tests on the physics world, running them in parallel on the job scheduler.
+     *
+     * Each object is swept the same way as by the single sweep test, except that the filter
+     * is called from the job worker threads and must be safe to call from several threads
+     * at the same time.
+     *
+     * @param objects The collision objects to sweep.
+     * @param endPositions The end position of each sweep test, in world space.
+     * @param count The number of sweep tests.
+     * @param results The array of count hit results to store the results in. The object
+     *      of the result of each sweep that does not hit anything is set to NULL.
+     * @param filter Optional filter pointer used to control which objects are tested.
+     *
+     * @return The number of objects that intersect any other physics objects.
+     * @script{ignore}
      */
-    class CollisionCallback : public btCollisionWorld::ContactResultCallback
-    {
-    public:
-        /**
-         * Constructor.
-         * 
-         * @param pc The physics controller that owns the callback.
-         */
-        CollisionCallback(PhysicsController* pc) : _pc(pc) {}
+    unsigned int sweepTest(PhysicsCollisionObject* const* objects, const Vector3* endPositions, unsigned int count,
+                           PhysicsController::HitResult* results, PhysicsController::HitFilter* filter = NULL);
 
-    protected:
-        /**
-            * Internal function used for Bullet integration (do not use or override).
-            */
-        btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, const btCollisionObjectWrapper* b, int partIdB, int indexB);    
+    /**
+     * Enables or disables stepping the simulation on a background thread.
+     *
+     * When threaded, the simulation is stepped on its own thread while the game renders,
+     * and the game thread picks up the results at the start of the next physics update:
+     * the interpolated transforms of the simulated objects are copied to their nodes,
+     * and collision and status events queued by the step are dispatched to the listeners.
+     *
+     * The methods of the controller wait for a step in progress, but collision objects,
+     * vehicles and the nodes they are attached to must not be changed while rendering.
+     * Characters update their nodes during the step and are not supported in threaded mode.
+     * In pipelined frame mode the simulation is already off the game thread, so it is
+     * stepped inline.
+     *
+     * The mode can also be enabled with the 'threaded' property in the 'physics' section
+     * of the game configuration file.
+     *
+     * @param threaded true to step the simulation on a background thread, false to step it during update.
+     * @script{ignore}
+     */
+    void setThreaded(bool threaded);
 
-    private:
-        PhysicsController* _pc;
-    };
+    /**
+     * Determines if the simulation is stepped on a background thread.
+     *
+     * @return true if the simulation is threaded, false otherwise.
+     * @script{ignore}
+     */
+    bool isThreaded() const;
+
+    /**
+     * Determines if the simulation uses the multithreaded dynamics world of Bullet.
+     *
+     * A multithreaded world detects collisions, solves the constraints of separate simulation
+     * islands and integrates the rigid bodies in parallel on the worker threads of the game's
+     * job scheduler, which speeds up scenes such as ragdolls and large stacks of rigid bodies.
+     * It is enabled by the 'multithreaded' property in the 'physics' section of the game
+     * configuration file, and requires the engine and Bullet to be built with USE_BULLET_MT
+     * (and Bullet with BT_THREADSAFE). It is independent of setThreaded(), which moves the
+     * whole step off the game thread.
+     *
+     * @return true if the world is multithreaded, false otherwise.
+     * @script{ignore}
+     */
+    bool isMultithreaded() const;
+
+    /**
+     * Sets the directory where the bounding volume hierarchies of static mesh shapes are cached.
+     *
+     * Building the hierarchy of a static triangle mesh shape dominates the time taken to
+     * create large static collision meshes. When a cache directory is set, the hierarchy of
+     * each static mesh shape is saved the first time it is built and mapped back on later runs
+     * instead of being built again. Cached hierarchies are keyed by the mesh URL and scale, and
+     * validated against the vertices and indices of the mesh and the version of Bullet, so
+     * changed meshes are built again. The directory must exist and be writable. Caching can
+     * also be enabled by the 'shapeCachePath' property in the 'physics' section of the game
+     * configuration file.
+     *
+     * Independently of the cache, nodes that use the same mesh at the same scale share a
+     * single collision shape.
+     *
+     * @param path The cache directory, or NULL to disable caching.
+     * @script{ignore}
+     */
+    void setShapeCachePath(const char* path);
+
+    /**
+     * Returns the directory where the hierarchies of static mesh shapes are cached.
+     *
+     * @return The cache directory, or NULL if caching is disabled.
+     * @script{ignore}
+     */
+    const char* getShapeCachePath() const;
+
+    /**
+     * Returns the number of collision shapes. Objects created with the same shape type,
+     * dimensions, scale and mesh share the same shape, so this is the number of distinct shapes.
+     *
+     * @return The number of collision shapes.
+     * @script{ignore}
+     */
+    unsigned int getShapeCount() const;
+
+    /**
+     * Returns the memory used by the collision shapes, including the vertices, indices and
+     * bounding volume hierarchies of mesh shapes (but not the heights of heightfields, which
+     * belong to their HeightField).
+     *
+     * @return The memory used by the collision shapes, in bytes.
+     * @script{ignore}
+     */
+    size_t getShapeMemoryUsage() const;
+
+    /**
+     * Sets the number of iterations of the constraint solver (10 by default).
+     *
+     * Fewer iterations make each step cheaper but let stacks and chains of constrained
+     * bodies drift. The number can also be set by the 'solverIterations' property in
+     * the 'physics' section of the game configuration file.
+     *
+     * @param iterations The number of solver iterations.
+     */
+    void setSolverIterations(int iterations);
+
+    /**
+     * Returns the number of iterations of the constraint solver.
+     *
+     * @return The number of solver iterations.
+     */
+    int getSolverIterations() const;
+
+    /**
+     * Sets whether rigid bodies that come to rest fall asleep (true by default).
+     *
+     * Bodies at rest are gathered in islands of touching bodies, and an island falls asleep
+     * once all its bodies have stayed below their sleeping thresholds for the deactivation
+     * time. Sleeping islands cost nothing to simulate until something touches them. Sleeping
+     * can also be disabled by the 'sleeping' property in the 'physics' section of the game
+     * configuration file.
+     *
+     * @param sleeping true to let bodies at rest fall asleep, false to simulate them continuously.
+     *
+     * @see PhysicsRigidBody::setSleepingThresholds
+     */
+    void setSleepingEnabled(bool sleeping);
+
+    /**
+     * Returns whether rigid bodies that come to rest fall asleep.
+     *
+     * @return true if bodies at rest fall asleep.
+     */
+    bool isSleepingEnabled() const;
+
+    /**
+     * Sets the time rigid bodies must stay below their sleeping thresholds before they fall asleep.
+     *
+     * The time can also be set by the 'deactivationTime' property in the 'physics' section
+     * of the game configuration file.
+     *
+     * @param time The deactivation time, in seconds (2 by default).
+     */
+    void setDeactivationTime(float time);
+
+    /**
+     * Returns the time rigid bodies must stay below their sleeping thresholds before they fall asleep.
+     *
+     * @return The deactivation time, in seconds.
+     */
+    float getDeactivationTime() const;
+
+    /**
+     * Sets the camera that drives the simulation level of detail of rigid bodies and vehicles.
+     *
+     * When a camera is set, each update reduces the simulation of the rigid bodies that
+     * are further than the LOD distance from the camera or outside its view, unless
+     * their level of detail is disabled:
+     *
+     * - They use the LOD sleeping thresholds, when higher than their own, so they fall asleep sooner.
+     * - The constraints between reduced bodies are solved with the LOD number of solver iterations.
+     * - Vehicles are allowed to fall asleep and their wheels are no longer cast while asleep.
+     * - Characters resolve their penetrations once and sweep their movement once per step,
+     *   sliding along the first surface they hit instead of the next ones.
+     *
+     * Bodies get their full simulation back as soon as they come close or into view again.
+     * The contacts are always solved with the number of iterations of the world, since
+     * Bullet solves them all together.
+     *
+     * @param camera The camera of the level of detail, or NULL to simulate all bodies fully.
+     * @script{ignore}
+     */
+    void setLodCamera(Camera* camera);
+
+    /**
+     * Returns the camera that drives the simulation level of detail.
+     *
+     * @return The camera of the level of detail, or NULL if all bodies are simulated fully.
+     * @script{ignore}
+     */
+    Camera* getLodCamera() const;
+
+    /**
+     * Sets the distance from the LOD camera beyond which the simulation of rigid bodies is reduced.
+     *
+     * The distance can also be set by the 'lodDistance' property in the 'physics' section
+     * of the game configuration file.
+     *
+     * @param distance The distance, or zero to only reduce the bodies outside the view of the camera.
+     */
+    void setLodDistance(float distance);
+
+    /**
+     * Returns the distance from the LOD camera beyond which the simulation of rigid bodies is reduced.
+     *
+     * @return The LOD distance.
+     */
+    float getLodDistance() const;
+
+    /**
+     * Sets the sleeping thresholds of the rigid bodies whose simulation is reduced.
+     *
+     * The thresholds can also be set by the 'lodLinearSleepingThreshold' and
+     * 'lodAngularSleepingThreshold' properties in the 'physics' section of the game
+     * configuration file.
+     *
+     * @param linear The linear velocity below which reduced bodies can fall asleep (4 by default).
+     * @param angular The angular velocity below which reduced bodies can fall asleep, in radians per second (4 by default).
+     */
+    void setLodSleepingThresholds(float linear, float angular);
+
+    /**
+     * Returns the linear sleeping threshold of the rigid bodies whose simulation is reduced.
+     *
+     * @return The linear velocity below which reduced bodies can fall asleep.
+     */
+    float getLodLinearSleepingThreshold() const;
+
+    /**
+     * Returns the angular sleeping threshold of the rigid bodies whose simulation is reduced.
+     *
+     * @return The angular velocity below which reduced bodies can fall asleep.
+     */
+    float getLodAngularSleepingThreshold() const;
+
+    /**
+     * Sets the number of solver iterations of the constraints between reduced rigid bodies.
+     *
+     * The number can also be set by the 'lodSolverIterations' property in the 'physics'
+     * section of the game configuration file.
+     *
+     * @param iterations The number of solver iterations (2 by default).
+     */
+    void setLodSolverIterations(int iterations);
+
+    /**
+     * Returns the number of solver iterations of the constraints between reduced rigid bodies.
+     *
+     * @return The number of solver iterations.
+     */
+    int getLodSolverIterations() const;
+
+private:
 
     // Internal constants for the collision status cache.
-    static const int DIRTY;
     static const int COLLISION;
     static const int REGISTERED;
     static const int REMOVE;
+    static const int TRIGGER;
 
     // Represents the collision listeners and status for a given collision pair (used by the collision status cache).
     struct CollisionInfo
     {
-        CollisionInfo() : _status(0) { }
+        CollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) : _pair(pair), _status(0), _frame(0) { }
 
+        PhysicsCollisionObject::CollisionPair _pair;
         std::vector<PhysicsCollisionObject::CollisionListener*> _listeners;
         int _status;
+        unsigned int _frame;
+    };
+
+    /**
+     * Key of the collision status cache, which matches the objects of a pair in either order.
+     */
+    class CollisionPairKey
+    {
+    public:
+
+        CollisionPairKey(const PhysicsCollisionObject::CollisionPair& pair);
+
+        // Required by btHashMap.
+        unsigned int getHash() const;
+
+        // Required by btHashMap.
+        bool equals(const CollisionPairKey& other) const;
+
+    private:
+
+        PhysicsCollisionObject* _first;
+        PhysicsCollisionObject* _second;
+    };
+
+    // A collision event queued by a threaded step to be dispatched on the game thread.
+    struct CollisionEvent
+    {
+        PhysicsCollisionObject::CollisionListener* _listener;
+        PhysicsCollisionObject::CollisionListener::EventType _type;
+        PhysicsCollisionObject::CollisionPair _pair;
+        Vector3 _contactPointA;
+        Vector3 _contactPointB;
     };
 
     /**
@@ -381,8 +680,10 @@ private:
 
     /**
      * Controller initialize.
+     *
+     * @param multithreaded true to create the multithreaded dynamics world of Bullet, when it is built in.
      */
-    void initialize();
+    void initialize(bool multithreaded = false);
 
     /**
      * Controller finalize.
@@ -404,12 +705,107 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Steps the simulation and runs the registered collision tests.
+     */
+    void stepSimulation(float elapsedTime);
+
+    /**
+     * Starts stepping the simulation on the background thread. Called by the game before rendering.
+     */
+    void beginStep();
+
+    /**
+     * Waits for the background step in progress to complete.
+     */
+    void waitForStep();
+
+    /**
+     * Copies the results of the last background step to the nodes and dispatches its queued events.
+     */
+    void publishStep();
+
+    /**
+     * Fires a collision event, or queues it when the simulation is being stepped on the background thread.
+     */
+    void fireCollisionEvent(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject::CollisionListener::EventType type,
+                            const PhysicsCollisionObject::CollisionPair& pair, const Vector3& contactPointA = Vector3::zero(),
+                            const Vector3& contactPointB = Vector3::zero());
+
+    /**
+     * Fires the status event to the status listeners and scripts.
+     */
+    void fireStatusEvent();
+
+    static int stepThreadMain(void* arg);
+
+    static void rayTestRange(void* arg, unsigned int start, unsigned int end);
+
+    static void sweepTestRange(void* arg, unsigned int start, unsigned int end);
+
+    static unsigned int countHits(const PhysicsController::HitResult* results, unsigned int count);
+
     // Adds the given collision listener for the two given collision objects.
     void addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
 
     // Removes the given collision listener.
     void removeCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
 
+    // Gets the collision status cache entry of the given pair, or NULL if there is none.
+    CollisionInfo* findCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) const;
+
+    /**
+     * Gets the collision status cache entry of two colliding objects, adding it if the objects
+     * have listeners for all their collisions. Returns NULL if nobody listens to the pair.
+     */
+    CollisionInfo* getListenedCollisionInfo(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
+
+    /**
+     * Fires the events of the objects that entered or left the trigger volumes since the last step,
+     * from the differences between the overlapping pairs of the triggers and those already reported.
+     */
+    void updateTriggers();
+
+    /**
+     * Stops tracking a trigger volume, ending the collisions reported for it.
+     */
+    void removeTrigger(PhysicsGhostObject* trigger);
+
+    /**
+     * Forgets that the collision of a pair with a trigger was reported, after the pair was removed.
+     */
+    void removeTriggerOverlap(const PhysicsCollisionObject::CollisionPair& pair);
+
+    /**
+     * Dispatches the broadphase pairs for the narrowphase, skipping the pairs of trigger volumes.
+     */
+    static void nearCallback(btBroadphasePair& collisionPair, btCollisionDispatcher& dispatcher, const btDispatcherInfo& dispatchInfo);
+
+    /**
+     * Fires the collision events of the pairs whose contacts started or ended during the last step.
+     *
+     * The contacts are read from the persistent manifolds of the dispatcher,
+     * so only the pairs that are touching or stopped touching are visited.
+     */
+    void updateCollisionStatus();
+
+    /**
+     * Reduces or restores the simulation of the rigid bodies and vehicles for the LOD camera.
+     */
+    void updateLod();
+
+    /**
+     * Updates all the characters for a step of the simulation. Penetrations are resolved
+     * on the stepping thread, the movements of the characters are swept in parallel on the
+     * job scheduler, and the results are then applied to the nodes and the bodies they hit.
+     */
+    void updateCharacters(btCollisionWorld* collisionWorld, btScalar timeStep);
+
+    /**
+     * Job scheduler entry point for moving a range of characters.
+     */
+    static void moveCharacterRange(void* arg, unsigned int start, unsigned int end);
+
     // Adds the given collision object to the world.
     void addCollisionObject(PhysicsCollisionObject* object);
     
@@ -438,6 +834,26 @@ private:
     // Creates a triangle mesh collision shape.
     PhysicsCollisionShape* createMesh(Mesh* mesh, const Vector3& scale, bool dynamic);
 
+    /**
+     * Creates the static shape of a triangle mesh, loading its hierarchy from the shape cache if possible.
+     */
+    btBvhTriangleMeshShape* createBvhTriangleMeshShape(btTriangleIndexVertexArray* meshInterface, PhysicsCollisionShape::MeshData* meshData, unsigned int vertexCount);
+
+    /**
+     * The collision shapes, indexed by the hash of their type and dimensions.
+     */
+    typedef std::multimap<unsigned int, PhysicsCollisionShape*> ShapeCache;
+
+    /**
+     * Returns the shape cache key of a shape type and its dimensions (and mesh URL).
+     */
+    static unsigned int getShapeKey(PhysicsCollisionShape::Type type, const float* dimensions, unsigned int count, const char* url = NULL);
+
+    /**
+     * Adds a new shape to the shape cache under the specified key.
+     */
+    void addShape(PhysicsCollisionShape* shape, unsigned int key, size_t memoryUsage);
+
     // Destroys a collision shape created through PhysicsController
     void destroyShape(PhysicsCollisionShape* shape);
 
@@ -457,54 +873,39 @@ private:
     void removeConstraint(PhysicsConstraint* constraint);
     
     /**
-     * Draws Bullet debug information.
+     * Updates the characters during the steps of the simulation.
      * @script{ignore}
      */
-    class DebugDrawer : public btIDebugDraw
+    class CharacterAction : public btActionInterface
     {
     public:
 
-        /** 
-         * DebugVertex.
-         * @script{ignore}
-         */
-        struct DebugVertex
-        {
-            /**
-             * The x coordinate of the vertex.
-             */
-            float x;
-    
-            /**
-             * The y coordinate of the vertex.
-             */
-            float y;
-    
-            /**
-             * The z coordinate of the vertex.
-             */
-            float z;
+        CharacterAction(PhysicsController* controller);
 
-            /**
-             * The red color component of the vertex.
-             */
-            float r;
-    
-            /**
-             * The green color component of the vertex.
-             */
-            float g;
-    
-            /**
-             * The blue color component of the vertex.
-             */
-            float b;
-    
-            /**
-             * The alpha component of the vertex.
-             */
-            float a;
-        };
+        void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+
+        void debugDraw(btIDebugDraw* debugDrawer);
+
+        PhysicsController* controller;
+    };
+
+    /**
+     * The arguments of moveCharacterRange().
+     */
+    struct CharacterContext
+    {
+        PhysicsController* controller;
+        btCollisionWorld* collisionWorld;
+        btScalar timeStep;
+    };
+
+    /**
+     * Draws Bullet debug information.
+     * @script{ignore}
+     */
+    class DebugDrawer : public btIDebugDraw
+    {
+    public:
 
         /**
          * Constructor.
@@ -531,24 +932,48 @@ private:
     private:
         
         int _mode;
-        MeshBatch* _meshBatch;
-        int _lineCount;
+        Matrix _viewProjection;
     };
 
     bool _isUpdating;
     btDefaultCollisionConfiguration* _collisionConfiguration;
     btCollisionDispatcher* _dispatcher;
     btBroadphaseInterface* _overlappingPairCache;
-    btSequentialImpulseConstraintSolver* _solver;
+    btConstraintSolver* _solver;
+    btConstraintSolver* _solverPool;
     btDynamicsWorld* _world;
+    bool _multithreaded;
     btGhostPairCallback* _ghostPairCallback;
-    std::vector<PhysicsCollisionShape*> _shapes;
+    ShapeCache _shapes;
+    size_t _shapeMemoryUsage;
     DebugDrawer* _debugDrawer;
     Listener::EventType _status;
     std::vector<Listener*>* _listeners;
     Vector3 _gravity;
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo> _collisionStatus;
-    CollisionCallback* _collisionCallback;
+    btHashMap<CollisionPairKey, CollisionInfo*> _collisionStatus;
+    std::vector<PhysicsCollisionObject::CollisionPair> _collidingPairs;
+    std::vector<PhysicsCollisionObject::CollisionPair> _removedPairs;
+    unsigned int _collisionFrame;
+    Thread* _stepThread;
+    Mutex _stepMutex;
+    Condition _stepCondition;
+    bool _stepping;
+    bool _stepExit;
+    float _stepTime;
+    bool _deferEvents;
+    bool _statusChanged;
+    std::vector<CollisionEvent> _collisionEvents;
+    std::string _shapeCachePath;
+    std::vector<PhysicsVehicle*> _vehicles;
+    std::vector<PhysicsCharacter*> _characters;
+    std::vector<PhysicsGhostObject*> _triggers;
+    std::vector<PhysicsCollisionObject*> _triggerOverlaps;
+    CharacterAction* _characterAction;
+    Camera* _lodCamera;
+    float _lodDistance;
+    float _lodLinearSleepingThreshold;
+    float _lodAngularSleepingThreshold;
+    int _lodSolverIterations;
 };
 
 }
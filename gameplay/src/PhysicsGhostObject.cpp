@@ -7,7 +7,7 @@ namespace gameplay
 {
 
 PhysicsGhostObject::PhysicsGhostObject(Node* node, const PhysicsCollisionShape::Definition& shape, int group, int mask)
-    : PhysicsCollisionObject(node, group, mask), _ghostObject(NULL)
+    : PhysicsCollisionObject(node, group, mask), _ghostObject(NULL), _trigger(false)
 {
     Vector3 centerOfMassOffset;
     PhysicsController* physicsController = Game::getInstance()->getPhysicsController();
@@ -38,6 +38,7 @@ PhysicsGhostObject::~PhysicsGhostObject()
     GP_ASSERT(_node);
     _node->removeListener(this);
 
+    setTrigger(false);
     GP_ASSERT(Game::getInstance()->getPhysicsController());
     Game::getInstance()->getPhysicsController()->removeCollisionObject(this, true);
 
@@ -76,6 +77,7 @@ PhysicsGhostObject* PhysicsGhostObject::create(Node* node, Properties* propertie
 
     // Create the ghost object.
     PhysicsGhostObject* ghost = new PhysicsGhostObject(node, shape);
+    ghost->setTrigger(properties->getBool("trigger"));
 
     return ghost;
 }
@@ -85,6 +87,37 @@ PhysicsCollisionObject::Type PhysicsGhostObject::getType() const
     return GHOST_OBJECT;
 }
 
+void PhysicsGhostObject::setTrigger(bool trigger)
+{
+    if (trigger == _trigger)
+        return;
+
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(controller);
+    controller->waitForStep();
+    _trigger = trigger;
+    if (_trigger)
+    {
+        controller->_triggers.push_back(this);
+    }
+    else
+    {
+        controller->removeTrigger(this);
+    }
+
+    // Drop the contacts computed while the ghost object was not a trigger, or compute them again.
+    GP_ASSERT(_ghostObject && controller->_world);
+    if (_ghostObject->getBroadphaseHandle())
+    {
+        controller->_world->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_ghostObject->getBroadphaseHandle(), controller->_dispatcher);
+    }
+}
+
+bool PhysicsGhostObject::isTrigger() const
+{
+    return _trigger;
+}
+
 btCollisionObject* PhysicsGhostObject::getCollisionObject() const
 {
     return _ghostObject;
@@ -28,6 +28,30 @@ public:
      */
     PhysicsCollisionObject::Type getType() const;
 
+    /**
+     * Makes the ghost object a trigger volume, or a regular ghost object.
+     *
+     * The collisions of a trigger are the objects whose bounding boxes overlap the bounding box
+     * of the trigger, as tracked by the broadphase. No contacts are computed for a trigger, so
+     * its COLLIDING and NOT_COLLIDING events only cost something on the frames objects enter or
+     * leave it, and the points of its events are the origins of the two objects. This suits the
+     * many trigger zones of a level, which are usually boxes aligned with the world axes.
+     *
+     * This can also be set with the 'trigger' property of the collision object definition.
+     *
+     * @param trigger true to make the ghost object a trigger, false to compute its contacts.
+     * @script{ignore}
+     */
+    void setTrigger(bool trigger);
+
+    /**
+     * Determines if the ghost object is a trigger volume.
+     *
+     * @return true if the ghost object is a trigger.
+     * @script{ignore}
+     */
+    bool isTrigger() const;
+
     /**
      * Used to synchronize the transform between GamePlay and Bullet.
      */
@@ -71,6 +95,16 @@ protected:
      * Pointer to the Bullet ghost collision object.
      */
     btPairCachingGhostObject* _ghostObject;
+
+    /**
+     * Whether the ghost object is a trigger volume.
+     */
+    bool _trigger;
+
+    /**
+     * The objects overlapping the trigger whose collision events were fired, sorted by address.
+     */
+    std::vector<PhysicsCollisionObject*> _triggerOverlaps;
 };
 
 }
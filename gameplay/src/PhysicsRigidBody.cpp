@@ -11,7 +11,9 @@ namespace gameplay
 {
 
 PhysicsRigidBody::PhysicsRigidBody(Node* node, const PhysicsCollisionShape::Definition& shape, const Parameters& parameters, int group, int mask)
-        : PhysicsCollisionObject(node, group, mask), _body(NULL), _mass(parameters.mass), _constraints(NULL), _inDestructor(false)
+        : PhysicsCollisionObject(node, group, mask), _body(NULL), _mass(parameters.mass), _constraints(NULL), _inDestructor(false),
+          _linearSleepingThreshold(parameters.linearSleepingThreshold), _angularSleepingThreshold(parameters.angularSleepingThreshold),
+          _sleepingAllowed(parameters.sleeping), _lodEnabled(parameters.lod), _lodReduced(false)
 {
     GP_ASSERT(Game::getInstance()->getPhysicsController());
     GP_ASSERT(_node);
@@ -37,6 +39,8 @@ PhysicsRigidBody::PhysicsRigidBody(Node* node, const PhysicsCollisionShape::Defi
     rbInfo.m_restitution = parameters.restitution;
     rbInfo.m_linearDamping = parameters.linearDamping;
     rbInfo.m_angularDamping = parameters.angularDamping;
+    rbInfo.m_linearSleepingThreshold = parameters.linearSleepingThreshold;
+    rbInfo.m_angularSleepingThreshold = parameters.angularSleepingThreshold;
 
     // Create + assign the new bullet rigid body object.
     _body = bullet_new<btRigidBody>(rbInfo);
@@ -238,6 +242,22 @@ PhysicsRigidBody* PhysicsRigidBody::create(Node* node, Properties* properties, c
         {
             properties->getVector3(NULL, &parameters.linearFactor);
         }
+        else if (strcmp(name, "linearSleepingThreshold") == 0)
+        {
+            parameters.linearSleepingThreshold = properties->getFloat();
+        }
+        else if (strcmp(name, "angularSleepingThreshold") == 0)
+        {
+            parameters.angularSleepingThreshold = properties->getFloat();
+        }
+        else if (strcmp(name, "sleeping") == 0)
+        {
+            parameters.sleeping = properties->getBool();
+        }
+        else if (strcmp(name, "lod") == 0)
+        {
+            parameters.lod = properties->getBool();
+        }
         else
         {
             // Ignore this case (the attributes for the rigid body's collision shape would end up here).
@@ -268,7 +288,89 @@ void PhysicsRigidBody::setKinematic(bool kinematic)
     else
     {
         _body->setCollisionFlags(_body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT);
-        _body->setActivationState(ACTIVE_TAG);
+        _body->forceActivationState(_sleepingAllowed ? ACTIVE_TAG : DISABLE_DEACTIVATION);
+    }
+}
+
+void PhysicsRigidBody::setSleepingThresholds(float linear, float angular)
+{
+    GP_ASSERT(_body);
+    Game::getInstance()->getPhysicsController()->waitForStep();
+
+    _linearSleepingThreshold = linear;
+    _angularSleepingThreshold = angular;
+    if (_lodReduced)
+    {
+        _lodReduced = false;
+        setLodReduced(true);
+    }
+    else
+    {
+        _body->setSleepingThresholds(linear, angular);
+    }
+}
+
+void PhysicsRigidBody::setSleepingAllowed(bool sleeping)
+{
+    GP_ASSERT(_body);
+    Game::getInstance()->getPhysicsController()->waitForStep();
+
+    _sleepingAllowed = sleeping;
+    if (!isKinematic())
+    {
+        _body->forceActivationState(sleeping ? ACTIVE_TAG : DISABLE_DEACTIVATION);
+    }
+}
+
+void PhysicsRigidBody::setLodEnabled(bool lod)
+{
+    _lodEnabled = lod;
+    if (!lod)
+    {
+        Game::getInstance()->getPhysicsController()->waitForStep();
+        setLodReduced(false);
+    }
+}
+
+void PhysicsRigidBody::setLodReduced(bool reduced)
+{
+    GP_ASSERT(_body);
+
+    if (reduced == _lodReduced)
+        return;
+
+    _lodReduced = reduced;
+    if (reduced)
+    {
+        PhysicsController* controller = Game::getInstance()->getPhysicsController();
+        GP_ASSERT(controller);
+        _body->setSleepingThresholds(std::max(_linearSleepingThreshold, controller->_lodLinearSleepingThreshold),
+            std::max(_angularSleepingThreshold, controller->_lodAngularSleepingThreshold));
+    }
+    else
+    {
+        _body->setSleepingThresholds(_linearSleepingThreshold, _angularSleepingThreshold);
+    }
+
+    if (_constraints)
+    {
+        for (size_t i = 0, count = _constraints->size(); i < count; ++i)
+        {
+            updateConstraintLod((*_constraints)[i]);
+        }
+    }
+}
+
+void PhysicsRigidBody::updateConstraintLod(PhysicsConstraint* constraint)
+{
+    GP_ASSERT(constraint);
+
+    // The constraint is only reduced when all its bodies are.
+    if (constraint->_constraint)
+    {
+        bool reduced = (constraint->_a == NULL || constraint->_a->_lodReduced) && (constraint->_b == NULL || constraint->_b->_lodReduced);
+        int iterations = reduced ? Game::getInstance()->getPhysicsController()->_lodSolverIterations : -1;
+        constraint->_constraint->setOverrideNumSolverIterations(iterations);
     }
 }
 
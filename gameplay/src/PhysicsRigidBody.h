@@ -34,6 +34,7 @@ class PhysicsRigidBody : public PhysicsCollisionObject, public Transform::Listen
     friend class PhysicsHingeConstraint;
     friend class PhysicsSocketConstraint;
     friend class PhysicsSpringConstraint;
+    friend class SceneSnapshot;
 
 public:
 
@@ -92,12 +93,34 @@ public:
          */
         Vector3 angularFactor;
 
+        /**
+         * The linear velocity below which the rigid body can fall asleep.
+         */
+        float linearSleepingThreshold;
+
+        /**
+         * The angular velocity below which the rigid body can fall asleep, in radians per second.
+         */
+        float angularSleepingThreshold;
+
+        /**
+         * Whether the rigid body can fall asleep when it comes to rest.
+         */
+        bool sleeping;
+
+        /**
+         * Whether the simulation of the rigid body is reduced when it is far from or out of view
+         * of the LOD camera of the physics controller.
+         */
+        bool lod;
+
         /**
          * Constructor.
          */
         Parameters() : mass(0.0f), friction(0.5f), restitution(0.0f),
             linearDamping(0.0f), angularDamping(0.0f),
-            kinematic(false), anisotropicFriction(Vector3::one()), linearFactor(Vector3::one()), angularFactor(Vector3::one())
+            kinematic(false), anisotropicFriction(Vector3::one()), linearFactor(Vector3::one()), angularFactor(Vector3::one()),
+            linearSleepingThreshold(0.8f), angularSleepingThreshold(1.0f), sleeping(true), lod(true)
         {
         }
 
@@ -109,7 +132,8 @@ public:
             const Vector3& anisotropicFriction = Vector3::one(), const Vector3& linearFactor = Vector3::one(), 
             const Vector3& angularFactor = Vector3::one())
             : mass(mass), friction(friction), restitution(restitution), linearDamping(linearDamping), angularDamping(angularDamping),
-              kinematic(kinematic), anisotropicFriction(anisotropicFriction), linearFactor(linearFactor), angularFactor(angularFactor)
+              kinematic(kinematic), anisotropicFriction(anisotropicFriction), linearFactor(linearFactor), angularFactor(angularFactor),
+              linearSleepingThreshold(0.8f), angularSleepingThreshold(1.0f), sleeping(true), lod(true)
         {
         }
     };
@@ -330,6 +354,83 @@ public:
      */
     void setKinematic(bool kinematic);
 
+    /**
+     * Sets the velocities below which the rigid body can fall asleep.
+     *
+     * The thresholds can also be set by the 'linearSleepingThreshold' and
+     * 'angularSleepingThreshold' properties of the rigid body in its .physics file.
+     *
+     * @param linear The linear velocity below which the body can fall asleep (0.8 by default).
+     * @param angular The angular velocity below which the body can fall asleep, in radians per second (1 by default).
+     *
+     * @see PhysicsController::setDeactivationTime
+     */
+    void setSleepingThresholds(float linear, float angular);
+
+    /**
+     * Returns the linear velocity below which the rigid body can fall asleep.
+     *
+     * @return The linear sleeping threshold.
+     */
+    inline float getLinearSleepingThreshold() const;
+
+    /**
+     * Returns the angular velocity below which the rigid body can fall asleep.
+     *
+     * @return The angular sleeping threshold, in radians per second.
+     */
+    inline float getAngularSleepingThreshold() const;
+
+    /**
+     * Sets whether the rigid body can fall asleep when it comes to rest.
+     *
+     * This can also be set by the 'sleeping' property of the rigid body in its .physics file.
+     * Kinematic bodies never fall asleep.
+     *
+     * @param sleeping true to let the body fall asleep, false to simulate it continuously.
+     */
+    void setSleepingAllowed(bool sleeping);
+
+    /**
+     * Returns whether the rigid body can fall asleep when it comes to rest.
+     *
+     * @return true if the body can fall asleep.
+     */
+    inline bool isSleepingAllowed() const;
+
+    /**
+     * Returns whether the rigid body is asleep.
+     *
+     * @return true if the body is asleep, false if it is simulated.
+     */
+    inline bool isSleeping() const;
+
+    /**
+     * Sets whether the simulation of the rigid body is reduced when it is far from or out of view
+     * of the LOD camera of the physics controller.
+     *
+     * This can also be set by the 'lod' property of the rigid body in its .physics file.
+     *
+     * @param lod true to let the simulation of the body be reduced, false to always simulate it fully.
+     *
+     * @see PhysicsController::setLodCamera
+     */
+    void setLodEnabled(bool lod);
+
+    /**
+     * Returns whether the simulation of the rigid body can be reduced.
+     *
+     * @return true if the simulation of the body can be reduced.
+     */
+    inline bool isLodEnabled() const;
+
+    /**
+     * Returns whether the simulation of the rigid body is currently reduced.
+     *
+     * @return true if the body is far from or out of view of the LOD camera.
+     */
+    inline bool isLodReduced() const;
+
     /**
      * Sets whether the rigid body is enabled or disabled in the physics world.
      *
@@ -438,10 +539,21 @@ private:
     // Used for implementing getHeight() when the heightfield has a transform that can change.
     void transformChanged(Transform* transform, long cookie);
 
+    // Applies the sleeping thresholds and solver iterations of the given level of detail.
+    void setLodReduced(bool reduced);
+
+    // Applies the solver iterations of the level of detail of the bodies of the given constraint.
+    void updateConstraintLod(PhysicsConstraint* constraint);
+
     btRigidBody* _body;
     float _mass;
     std::vector<PhysicsConstraint*>* _constraints;
     bool _inDestructor;
+    float _linearSleepingThreshold;
+    float _angularSleepingThreshold;
+    bool _sleepingAllowed;
+    bool _lodEnabled;
+    bool _lodReduced;
 
 };
 
@@ -165,6 +165,37 @@ inline void PhysicsRigidBody::setLinearFactor(float x, float y, float z)
     _body->setLinearFactor(btVector3(x, y, z));
 }
 
+inline float PhysicsRigidBody::getLinearSleepingThreshold() const
+{
+    return _linearSleepingThreshold;
+}
+
+inline float PhysicsRigidBody::getAngularSleepingThreshold() const
+{
+    return _angularSleepingThreshold;
+}
+
+inline bool PhysicsRigidBody::isSleepingAllowed() const
+{
+    return _sleepingAllowed;
+}
+
+inline bool PhysicsRigidBody::isSleeping() const
+{
+    GP_ASSERT(_body);
+    return !_body->isActive();
+}
+
+inline bool PhysicsRigidBody::isLodEnabled() const
+{
+    return _lodEnabled;
+}
+
+inline bool PhysicsRigidBody::isLodReduced() const
+{
+    return _lodReduced;
+}
+
 inline bool PhysicsRigidBody::isStatic() const
 {
     GP_ASSERT(_body);
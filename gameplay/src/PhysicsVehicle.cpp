@@ -80,7 +80,7 @@ private:
 };
 
 PhysicsVehicle::PhysicsVehicle(Node* node, const PhysicsCollisionShape::Definition& shape, const PhysicsRigidBody::Parameters& parameters)
-    : PhysicsCollisionObject(node), _speedSmoothed(0)
+    : PhysicsCollisionObject(node), _speedSmoothed(0), _simulated(true)
 {
     // Note that the constructor for PhysicsRigidBody calls addCollisionObject and so
     // that is where the rigid body gets added to the dynamics world.
@@ -90,7 +90,7 @@ PhysicsVehicle::PhysicsVehicle(Node* node, const PhysicsCollisionShape::Definiti
 }
 
 PhysicsVehicle::PhysicsVehicle(Node* node, PhysicsRigidBody* rigidBody)
-    : PhysicsCollisionObject(node), _speedSmoothed(0)
+    : PhysicsCollisionObject(node), _speedSmoothed(0), _simulated(true)
 {
     _rigidBody = rigidBody;
 
@@ -182,19 +182,34 @@ void PhysicsVehicle::initialize()
 
     // Create the vehicle and add it to world
     btRigidBody* body = static_cast<btRigidBody*>(_rigidBody->getCollisionObject());
-    btDynamicsWorld* dynamicsWorld = Game::getInstance()->getPhysicsController()->_world;
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    btDynamicsWorld* dynamicsWorld = controller->_world;
     _vehicleRaycaster = new VehicleNotMeRaycaster(dynamicsWorld, body);
     _vehicle = bullet_new<btRaycastVehicle>(_vehicleTuning, body, _vehicleRaycaster);
     body->setActivationState(DISABLE_DEACTIVATION);
     dynamicsWorld->addVehicle(_vehicle);
     _vehicle->setCoordinateSystem(0, 1, 2);
+
+    // Register with the controller, which reduces the simulation of distant vehicles.
+    controller->_vehicles.push_back(this);
 }
 
 PhysicsVehicle::~PhysicsVehicle()
 {
     // Note that the destructor for PhysicsRigidBody calls removeCollisionObject and so
     // that is where the rigid body gets removed from the dynamics world. The vehicle
-    // itself is just an action interface in the dynamics world.
+    // itself is just an action interface in the dynamics world, removed here.
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    controller->waitForStep();
+    std::vector<PhysicsVehicle*>::iterator itr = std::find(controller->_vehicles.begin(), controller->_vehicles.end(), this);
+    if (itr != controller->_vehicles.end())
+    {
+        controller->_vehicles.erase(itr);
+    }
+    if (_simulated)
+    {
+        controller->_world->removeVehicle(_vehicle);
+    }
     SAFE_DELETE(_vehicle);
     SAFE_DELETE(_vehicleRaycaster);
     SAFE_DELETE(_rigidBody);
@@ -273,6 +288,13 @@ void PhysicsVehicle::update(float elapsedTime, float steering, float braking, fl
         driving = 0;
     }
 
+    // Wake the vehicle up if it fell asleep while its simulation was reduced.
+    if (!_simulated && (steering != 0 || braking != 0 || driving != 0))
+    {
+        _rigidBody->_body->activate(true);
+        setSimulated(true);
+    }
+
     PhysicsVehicleWheel* wheel;
     for (int i = 0; i < _vehicle->getNumWheels(); i++)
     {
@@ -293,6 +315,21 @@ void PhysicsVehicle::update(float elapsedTime, float steering, float braking, fl
     }
 }
 
+void PhysicsVehicle::setSimulated(bool simulated)
+{
+    if (simulated == _simulated)
+        return;
+
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    controller->waitForStep();
+    _simulated = simulated;
+    btDynamicsWorld* dynamicsWorld = controller->_world;
+    if (simulated)
+        dynamicsWorld->addVehicle(_vehicle);
+    else
+        dynamicsWorld->removeVehicle(_vehicle);
+}
+
 void PhysicsVehicle::reset()
 {
     _rigidBody->setLinearVelocity(Vector3::zero());
@@ -368,6 +368,13 @@ private:
      */
     void applyDownforce();
 
+    /**
+     * Adds the vehicle to the dynamics world or removes it, while its chassis sleeps.
+     *
+     * @param simulated true to cast the wheels of the vehicle each step, false to stop.
+     */
+    void setSimulated(bool simulated);
+
     float _steeringGain;
     float _brakingForce;
     float _drivingForce;
@@ -386,6 +393,7 @@ private:
     btVehicleRaycaster* _vehicleRaycaster;
     btRaycastVehicle* _vehicle;
     std::vector<PhysicsVehicleWheel*> _wheels;
+    bool _simulated;
 };
 
 }
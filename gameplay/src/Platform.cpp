@@ -4,46 +4,64 @@
 #include "Game.h"
 #include "ScriptController.h"
 #include "Form.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+#include "FramePacer.h"
 
 namespace gameplay
 {
 
 void Platform::touchEventInternal(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
 {
-    if (actuallyMouse || !Form::touchEventInternal(evt, x, y, contactIndex))
-    {
-        Game::getInstance()->touchEvent(evt, x, y, contactIndex);
-        Game::getInstance()->getScriptController()->touchEvent(evt, x, y, contactIndex);
-    }
+    // Input wakes the game from idle mode, so that it is handled at the full frame rate.
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::touchEvent(evt, x, y, contactIndex, actuallyMouse))
+        return;
+
+    if (InputQueue::isQueueing())
+        InputQueue::touchEvent(evt, x, y, contactIndex, actuallyMouse);
+    else
+        deliverTouchEvent(evt, x, y, contactIndex, actuallyMouse);
 }
 
 void Platform::keyEventInternal(Keyboard::KeyEvent evt, int key)
 {
-    if (!Form::keyEventInternal(evt, key))
-    {
-        Game::getInstance()->keyEvent(evt, key);
-        Game::getInstance()->getScriptController()->keyEvent(evt, key);
-    }
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::keyEvent(evt, key))
+        return;
+
+    if (InputQueue::isQueueing())
+        InputQueue::keyEvent(evt, key);
+    else
+        deliverKeyEvent(evt, key);
 }
 
 bool Platform::mouseEventInternal(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
 {
-    if (Form::mouseEventInternal(evt, x, y, wheelDelta))
-    {
+    FramePacer::wake();
+
+    // Mouse events ignored during a replay are consumed, so the platform does not turn them into touches.
+    if (InputRecorder::isActive() && !InputRecorder::mouseEvent(evt, x, y, wheelDelta))
         return true;
-    }
-    else if (Game::getInstance()->mouseEvent(evt, x, y, wheelDelta))
+
+    if (InputQueue::isQueueing())
     {
+        // The queue turns the events nobody handles into touch events when it delivers them.
+        InputQueue::mouseEvent(evt, x, y, wheelDelta);
         return true;
     }
-    else
-    {
-        return Game::getInstance()->getScriptController()->mouseEvent(evt, x, y, wheelDelta);
-    }
+    return deliverMouseEvent(evt, x, y, wheelDelta);
 }
 
 void Platform::gestureSwipeEventInternal(int x, int y, int direction)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_SWIPE, x, y, direction, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gestureSwipeEvent(x, y, direction);
     Game::getInstance()->getScriptController()->gestureSwipeEvent(x, y, direction);
@@ -51,6 +69,11 @@ void Platform::gestureSwipeEventInternal(int x, int y, int direction)
 
 void Platform::gesturePinchEventInternal(int x, int y, float scale)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_PINCH, x, y, 0, scale))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gesturePinchEvent(x, y, scale);
     Game::getInstance()->getScriptController()->gesturePinchEvent(x, y, scale);
@@ -58,6 +81,11 @@ void Platform::gesturePinchEventInternal(int x, int y, float scale)
 
 void Platform::gestureTapEventInternal(int x, int y)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_TAP, x, y, 0, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gestureTapEvent(x, y);
     Game::getInstance()->getScriptController()->gestureTapEvent(x, y);
@@ -65,6 +93,11 @@ void Platform::gestureTapEventInternal(int x, int y)
 
 void Platform::gestureLongTapEventInternal(int x, int y, float duration)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_LONG_TAP, x, y, 0, duration))
+        return;
+
     // TODO: Add support to Form for gestures
 	Game::getInstance()->gestureLongTapEvent(x, y, duration);
 	Game::getInstance()->getScriptController()->gestureLongTapEvent(x, y, duration);
@@ -72,6 +105,11 @@ void Platform::gestureLongTapEventInternal(int x, int y, float duration)
 
 void Platform::gestureDragEventInternal(int x, int y)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_DRAG, x, y, 0, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
 	Game::getInstance()->gestureDragEvent(x, y);
 	Game::getInstance()->getScriptController()->gestureDragEvent(x, y);
@@ -79,6 +117,11 @@ void Platform::gestureDragEventInternal(int x, int y)
 
 void Platform::gestureDropEventInternal(int x, int y)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gestureEvent(Gesture::GESTURE_DROP, x, y, 0, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
 	Game::getInstance()->gestureDropEvent(x, y);
 	Game::getInstance()->getScriptController()->gestureDropEvent(x, y);
@@ -86,6 +129,8 @@ void Platform::gestureDropEventInternal(int x, int y)
 
 void Platform::resizeEventInternal(unsigned int width, unsigned int height)
 {
+    FramePacer::wake();
+
     // Update the width and height of the game
     Game* game = Game::getInstance();
     if (game->_width != width || game->_height != height)
@@ -97,10 +142,16 @@ void Platform::resizeEventInternal(unsigned int width, unsigned int height)
     }
 
     Form::resizeEventInternal(width, height);
+    Gamepad::resizeEventInternal(width, height);
 }
 
 void Platform::gamepadEventInternal(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
 {
+    FramePacer::wake();
+
+    if (InputRecorder::isActive() && !InputRecorder::gamepadEvent(evt, gamepad, analogIndex))
+        return;
+
     if (!Form::gamepadEventInternal(evt, gamepad, analogIndex))
     {
         Game::getInstance()->gamepadEvent(evt, gamepad);
@@ -119,4 +170,42 @@ void Platform::gamepadEventDisconnectedInternal(GamepadHandle handle)
     Gamepad::remove(handle);
 }
 
+void Platform::deliverTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
+{
+    // Lightweight virtual gamepads map touches before forms, since they have none.
+    if (Gamepad::touchEventInternal(evt, x, y, contactIndex))
+        return;
+
+    if (actuallyMouse || !Form::touchEventInternal(evt, x, y, contactIndex))
+    {
+        Game::getInstance()->touchEvent(evt, x, y, contactIndex);
+        Game::getInstance()->getScriptController()->touchEvent(evt, x, y, contactIndex);
+    }
+}
+
+void Platform::deliverKeyEvent(Keyboard::KeyEvent evt, int key)
+{
+    if (!Form::keyEventInternal(evt, key))
+    {
+        Game::getInstance()->keyEvent(evt, key);
+        Game::getInstance()->getScriptController()->keyEvent(evt, key);
+    }
+}
+
+bool Platform::deliverMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
+{
+    if (Form::mouseEventInternal(evt, x, y, wheelDelta))
+    {
+        return true;
+    }
+    else if (Game::getInstance()->mouseEvent(evt, x, y, wheelDelta))
+    {
+        return true;
+    }
+    else
+    {
+        return Game::getInstance()->getScriptController()->mouseEvent(evt, x, y, wheelDelta);
+    }
+}
+
 }
@@ -27,6 +27,8 @@ public:
     friend class Gamepad;
     friend class ScreenDisplayer;
     friend class FileSystem;
+    friend class InputQueue;
+    friend class InputRecorder;
 
     /**
      * Destructor.
@@ -61,6 +63,18 @@ public:
      */
     static void swapBuffers();
 
+    /**
+     * Makes the graphics context of the game current on the calling thread, or releases it.
+     *
+     * The context must be released by the thread that holds it before another thread
+     * can make it current.
+     *
+     * @param current true to make the context current on the calling thread, false to release it.
+     *
+     * @return true if successful, false if the platform does not support it.
+     */
+    static bool setGraphicsContextCurrent(bool current);
+
 private:
 
     /**
@@ -420,6 +434,21 @@ public:
 
 private:
 
+    /**
+     * Delivers a touch event to the forms, the game and the scripts.
+     */
+    static void deliverTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse);
+
+    /**
+     * Delivers a key event to the forms, the game and the scripts.
+     */
+    static void deliverKeyEvent(Keyboard::KeyEvent evt, int key);
+
+    /**
+     * Delivers a mouse event to the forms, the game and the scripts, and returns whether one of them handled it.
+     */
+    static bool deliverMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
+
     Game* _game;                // The game this platform is interfacing with.
 };
 
@@ -4,6 +4,8 @@
 #include "Platform.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "FramePacer.h"
+#include "StartupTrace.h"
 #include "Form.h"
 #include "ScriptController.h"
 #include <unistd.h>
@@ -21,6 +23,7 @@ static EGLDisplay __eglDisplay = EGL_NO_DISPLAY;
 static EGLContext __eglContext = EGL_NO_CONTEXT;
 static EGLSurface __eglSurface = EGL_NO_SURFACE;
 static EGLConfig __eglConfig = 0;
+static bool __contextLost = false;
 static int __width;
 static int __height;
 static struct timespec __timespec;
@@ -51,6 +54,22 @@ PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArrays = NULL;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArrays = NULL;
 PFNGLISVERTEXARRAYOESPROC glIsVertexArray = NULL;
 
+#ifdef USE_TIMER_QUERY
+// OpenGL timer query functions.
+PFNGLGENQUERIESEXTPROC glGenQueries = NULL;
+PFNGLDELETEQUERIESEXTPROC glDeleteQueries = NULL;
+PFNGLBEGINQUERYEXTPROC glBeginQuery = NULL;
+PFNGLENDQUERYEXTPROC glEndQuery = NULL;
+PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuiv = NULL;
+PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v = NULL;
+#endif
+
+#ifdef USE_PROGRAM_BINARY
+// OpenGL program binary functions.
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYOESPROC glProgramBinary = NULL;
+#endif
+
 #define GESTURE_TAP_DURATION_MAX			200
 #define GESTURE_LONG_TAP_DURATION_MIN   	GESTURE_TAP_DURATION_MAX
 #define GESTURE_DRAG_START_DURATION_MIN		GESTURE_LONG_TAP_DURATION_MIN
@@ -216,7 +235,7 @@ static bool initEGL()
         EGL_NONE
     };
 
-    if (__eglDisplay == EGL_NO_DISPLAY && __eglContext == EGL_NO_CONTEXT)
+    if (__eglDisplay == EGL_NO_DISPLAY)
     {
         // Get the EGL display and initialize.
         __eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
@@ -281,12 +300,22 @@ static bool initEGL()
             goto error;
         }
 
+    }
+
+    if (__eglContext == EGL_NO_CONTEXT)
+    {
         __eglContext = eglCreateContext(__eglDisplay, __eglConfig, EGL_NO_CONTEXT, eglContextAttrs);
         if (__eglContext == EGL_NO_CONTEXT)
         {
             checkErrorEGL("eglCreateContext");
             goto error;
         }
+
+        // A new context for a running game replaces a lost one, whose objects must be restored.
+        if (Game::getInstance()->getState() != Game::UNINITIALIZED)
+        {
+            __contextLost = true;
+        }
     }
     
     // EGL_NATIVE_VISUAL_ID is an attribute of the EGLConfig that is
@@ -306,8 +335,26 @@ static bool initEGL()
     
     if (eglMakeCurrent(__eglDisplay, __eglSurface, __eglSurface, __eglContext) != EGL_TRUE)
     {
-        checkErrorEGL("eglMakeCurrent");
-        goto error;
+        if (eglGetError() != EGL_CONTEXT_LOST)
+        {
+            checkErrorEGL("eglMakeCurrent");
+            goto error;
+        }
+
+        // The context was lost while the game was in the background, so replace it.
+        eglDestroyContext(__eglDisplay, __eglContext);
+        __eglContext = eglCreateContext(__eglDisplay, __eglConfig, EGL_NO_CONTEXT, eglContextAttrs);
+        if (__eglContext == EGL_NO_CONTEXT)
+        {
+            checkErrorEGL("eglCreateContext");
+            goto error;
+        }
+        if (eglMakeCurrent(__eglDisplay, __eglSurface, __eglSurface, __eglContext) != EGL_TRUE)
+        {
+            checkErrorEGL("eglMakeCurrent");
+            goto error;
+        }
+        __contextLost = true;
     }
     
     eglQuerySurface(__eglDisplay, __eglSurface, EGL_WIDTH, &__width);
@@ -329,6 +376,26 @@ static bool initEGL()
         glGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
         glIsVertexArray = (PFNGLISVERTEXARRAYOESPROC)eglGetProcAddress("glIsVertexArrayOES");
     }
+
+#ifdef USE_TIMER_QUERY
+    if (strstr(__glExtensions, "GL_EXT_disjoint_timer_query"))
+    {
+        glGenQueries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+        glDeleteQueries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+        glBeginQuery = (PFNGLBEGINQUERYEXTPROC)eglGetProcAddress("glBeginQueryEXT");
+        glEndQuery = (PFNGLENDQUERYEXTPROC)eglGetProcAddress("glEndQueryEXT");
+        glGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+        glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    }
+#endif
+
+#ifdef USE_PROGRAM_BINARY
+    if (strstr(__glExtensions, "GL_OES_get_program_binary"))
+    {
+        glGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+        glProgramBinary = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+    }
+#endif
     
     return true;
     
@@ -1052,7 +1119,9 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd)
             // The window is being shown, get it ready.
             if (app->window != NULL)
             {
+                StartupTrace::begin("Platform::initEGL");
                 initEGL();
+                StartupTrace::end();
                 __initialized = true;
             }
             break;
@@ -1238,6 +1307,13 @@ int Platform::enterMessagePump()
         // We skip rendering when the app is paused.
         if (__initialized && !__suspended)
         {
+            // Recreate the objects of the game in a context that replaced a lost one.
+            if (__contextLost)
+            {
+                __contextLost = false;
+                _game->restoreGraphicsContext();
+            }
+
             _game->frame();
 
             // Post the new frame to the display.
@@ -1250,10 +1326,12 @@ int Platform::enterMessagePump()
             //
             // 2) EGL_CONTEXT_LOST - Power management event that led to our EGL context
             //    being lost. Requires us to re-create and re-initalize our EGL context
-            //    and all OpenGL ES state.
+            //    and all OpenGL ES state, which the game restores before the next frame.
             //
-            // For now, if we get these, we'll simply exit.
-            int rc = eglSwapBuffers(__eglDisplay, __eglSurface);
+            // For any other error, we'll simply exit.
+            //
+            // Idle frames draw nothing, so the last frame stays on display.
+            int rc = FramePacer::isIdle() ? EGL_TRUE : eglSwapBuffers(__eglDisplay, __eglSurface);
             if (rc != EGL_TRUE)
             {
                 EGLint error = eglGetError();
@@ -1266,12 +1344,25 @@ int Platform::enterMessagePump()
                     }
                     __initialized = true;
                 }
+                else if (error == EGL_CONTEXT_LOST)
+                {
+                    destroyEGLSurface();
+                    eglDestroyContext(__eglDisplay, __eglContext);
+                    __eglContext = EGL_NO_CONTEXT;
+                    if (__state->window != NULL)
+                    {
+                        initEGL();
+                    }
+                }
                 else
                 {
                     perror("eglSwapBuffers");
                     break;
                 }
             }
+
+            // Sleep until the next frame is due, if the frames are paced.
+            FramePacer::wait();
         }
             
         // Display the keyboard.
@@ -1331,6 +1422,12 @@ void Platform::swapBuffers()
         eglSwapBuffers(__eglDisplay, __eglSurface);
 }
 
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    // The context is recreated when the surface is lost, so it stays on the main thread.
+    return false;
+}
+
 void Platform::sleep(long ms)
 {
     usleep(ms * 1000);
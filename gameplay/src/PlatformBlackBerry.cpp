@@ -6,6 +6,7 @@
 #include "Game.h"
 #include "Form.h"
 #include "ScriptController.h"
+#include "FramePacer.h"
 #include <unistd.h>
 #include <sys/keycodes.h>
 #include <screen/screen.h>
@@ -1371,7 +1372,9 @@ int Platform::enterMessagePump()
             //    and all OpenGL ES state.
             //
             // For now, if we get these, we'll simply exit.
-            rc = eglSwapBuffers(__eglDisplay, __eglSurface);
+            //
+            // Idle frames draw nothing, so the last frame stays on display.
+            rc = FramePacer::isIdle() ? EGL_TRUE : eglSwapBuffers(__eglDisplay, __eglSurface);
             if (rc != EGL_TRUE)
             {
                 _game->shutdown();
@@ -1439,6 +1442,12 @@ void Platform::swapBuffers()
         eglSwapBuffers(__eglDisplay, __eglSurface);
 }
 
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    // The context is recreated when the surface is lost, so it stays on the main thread.
+    return false;
+}
+
 void Platform::sleep(long ms)
 {
     usleep(ms * 1000);
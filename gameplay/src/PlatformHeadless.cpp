@@ -0,0 +1,373 @@
+#ifdef GP_HEADLESS
+
+#include "Base.h"
+#include "Platform.h"
+#include "FileSystem.h"
+#include "Game.h"
+
+#include <csignal>
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+// The default number of frames run per second.
+#define HEADLESS_TICK_RATE 60
+
+#ifndef WIN32
+int __argc = 0;
+char** __argv = 0;
+#endif
+
+static double __timeStart;
+static double __timeAbsolute;
+static bool __realtime = true;
+static double __tickTime = 1000.0 / HEADLESS_TICK_RATE;
+static unsigned int __tickLimit = 0;
+static unsigned int __displaySize[2] = { 1280, 720 };
+static bool __vsync = false;
+static bool __multiSampling = false;
+static bool __multiTouch = false;
+static volatile sig_atomic_t __stopRequested = 0;
+
+// Returns the time of the monotonic system clock, in milliseconds.
+static double getSystemTime()
+{
+#ifdef WIN32
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#endif
+}
+
+static void sleepMilliseconds(double ms)
+{
+#ifdef WIN32
+    Sleep((DWORD)ms);
+#else
+    usleep((useconds_t)(ms * 1000.0));
+#endif
+}
+
+static void requestStop(int signal)
+{
+    __stopRequested = 1;
+}
+
+namespace gameplay
+{
+
+extern void print(const char* format, ...)
+{
+    GP_ASSERT(format);
+    va_list argptr;
+    va_start(argptr, format);
+    vfprintf(stderr, format, argptr);
+    va_end(argptr);
+}
+
+extern int strcmpnocase(const char* s1, const char* s2)
+{
+#ifdef WIN32
+    return _strcmpi(s1, s2);
+#else
+    return strcasecmp(s1, s2);
+#endif
+}
+
+Platform::Platform(Game* game) : _game(game)
+{
+}
+
+Platform::~Platform()
+{
+}
+
+Platform* Platform::create(Game* game)
+{
+    GP_ASSERT(game);
+
+    FileSystem::setResourcePath("./");
+    Platform* platform = new Platform(game);
+
+    if (game->getConfig())
+    {
+        // Cameras and forms still use the size of the display, read from the window section as usual.
+        Properties* config = game->getConfig()->getNamespace("window", true);
+        if (config)
+        {
+            int width = config->getInt("width");
+            int height = config->getInt("height");
+            if (width > 0 && height > 0)
+            {
+                __displaySize[0] = (unsigned int)width;
+                __displaySize[1] = (unsigned int)height;
+            }
+        }
+
+        config = game->getConfig()->getNamespace("headless", true);
+        if (config)
+        {
+            if (config->exists("tickRate"))
+            {
+                int tickRate = config->getInt("tickRate");
+                __tickTime = tickRate > 0 ? 1000.0 / tickRate : 0.0;
+            }
+            if (config->exists("realtime"))
+            {
+                __realtime = config->getBool("realtime");
+            }
+            __tickLimit = (unsigned int)std::max(config->getInt("frames"), 0);
+        }
+    }
+
+    if (!__realtime && __tickTime <= 0.0)
+    {
+        GP_WARN("A headless game that does not run in real time needs a tick rate; using %d ticks per second.", HEADLESS_TICK_RATE);
+        __tickTime = 1000.0 / HEADLESS_TICK_RATE;
+    }
+
+    return platform;
+}
+
+int Platform::enterMessagePump()
+{
+    GP_ASSERT(_game);
+
+    // Shut down cleanly when the process is asked to stop.
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+
+    __timeStart = getSystemTime();
+    __timeAbsolute = 0.0;
+
+    // Run the game.
+    _game->run();
+
+    double nextTick = 0.0;
+    unsigned int tickCount = 0;
+    while (_game->getState() != Game::UNINITIALIZED)
+    {
+        if (__stopRequested || (__tickLimit > 0 && tickCount >= __tickLimit))
+        {
+            _game->shutdown();
+            break;
+        }
+
+        _game->frame();
+        ++tickCount;
+
+        if (!__realtime)
+        {
+            // Advance the clock by exactly one tick, however long the frame took.
+            __timeAbsolute += __tickTime;
+        }
+        else if (__tickTime > 0.0)
+        {
+            // Sleep until the next tick, without trying to catch up on the ticks that ran late.
+            nextTick += __tickTime;
+            double time = getAbsoluteTime();
+            if (nextTick > time)
+                sleepMilliseconds(nextTick - time);
+            else
+                nextTick = time;
+        }
+    }
+
+    return 0;
+}
+
+void Platform::signalShutdown()
+{
+}
+
+bool Platform::canExit()
+{
+    return true;
+}
+
+unsigned int Platform::getDisplayWidth()
+{
+    return __displaySize[0];
+}
+
+unsigned int Platform::getDisplayHeight()
+{
+    return __displaySize[1];
+}
+
+double Platform::getAbsoluteTime()
+{
+    if (__realtime)
+    {
+        __timeAbsolute = getSystemTime() - __timeStart;
+    }
+    return __timeAbsolute;
+}
+
+void Platform::setAbsoluteTime(double time)
+{
+    __timeAbsolute = time;
+}
+
+bool Platform::isVsync()
+{
+    return __vsync;
+}
+
+void Platform::setVsync(bool enable)
+{
+    __vsync = enable;
+}
+
+void Platform::swapBuffers()
+{
+}
+
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    // There is no context to hand over to a render thread.
+    return false;
+}
+
+void Platform::sleep(long ms)
+{
+    sleepMilliseconds((double)ms);
+}
+
+void Platform::setMultiSampling(bool enabled)
+{
+    __multiSampling = enabled;
+}
+
+bool Platform::isMultiSampling()
+{
+    return __multiSampling;
+}
+
+void Platform::setMultiTouch(bool enabled)
+{
+    __multiTouch = enabled;
+}
+
+bool Platform::isMultiTouch()
+{
+    return __multiTouch;
+}
+
+bool Platform::hasAccelerometer()
+{
+    return false;
+}
+
+void Platform::getAccelerometerValues(float* pitch, float* roll)
+{
+    GP_ASSERT(pitch);
+    GP_ASSERT(roll);
+
+    *pitch = 0;
+    *roll = 0;
+}
+
+void Platform::getSensorValues(float* accelX, float* accelY, float* accelZ, float* gyroX, float* gyroY, float* gyroZ)
+{
+    if (accelX)
+        *accelX = 0;
+    if (accelY)
+        *accelY = 0;
+    if (accelZ)
+        *accelZ = 0;
+    if (gyroX)
+        *gyroX = 0;
+    if (gyroY)
+        *gyroY = 0;
+    if (gyroZ)
+        *gyroZ = 0;
+}
+
+void Platform::getArguments(int* argc, char*** argv)
+{
+    if (argc)
+        *argc = __argc;
+    if (argv)
+        *argv = __argv;
+}
+
+bool Platform::hasMouse()
+{
+    return false;
+}
+
+void Platform::setMouseCaptured(bool captured)
+{
+}
+
+bool Platform::isMouseCaptured()
+{
+    return false;
+}
+
+void Platform::setCursorVisible(bool visible)
+{
+}
+
+bool Platform::isCursorVisible()
+{
+    return false;
+}
+
+void Platform::displayKeyboard(bool display)
+{
+}
+
+void Platform::shutdownInternal()
+{
+    Game::getInstance()->shutdown();
+}
+
+bool Platform::isGestureSupported(Gesture::GestureEvent evt)
+{
+    return false;
+}
+
+void Platform::registerGesture(Gesture::GestureEvent evt)
+{
+}
+
+void Platform::unregisterGesture(Gesture::GestureEvent evt)
+{
+}
+
+bool Platform::isGestureRegistered(Gesture::GestureEvent evt)
+{
+    return false;
+}
+
+void Platform::pollGamepadState(Gamepad* gamepad)
+{
+}
+
+bool Platform::launchURL(const char* url)
+{
+    return false;
+}
+
+std::string Platform::displayFileDialog(size_t mode, const char* title, const char* filterDescription, const char* filterExtensions, const char* initialDirectory)
+{
+    return "";
+}
+
+}
+
+#endif
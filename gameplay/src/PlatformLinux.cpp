@@ -1,9 +1,11 @@
-#ifdef __linux__
+#if defined(__linux__) && !defined(GP_HEADLESS)
 
 #include "Base.h"
 #include "Platform.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "FramePacer.h"
+#include "StartupTrace.h"
 #include "Form.h"
 #include "ScriptController.h"
 
@@ -81,6 +83,10 @@ struct ConnectedGamepadDevInfo
 struct timespec __timespec;
 static double __timeStart;
 static double __timeAbsolute;
+static double __timeCreateStart;
+static double __timeCreateEnd;
+
+double timespec2millis(struct timespec *a);
 static bool __vsync = WINDOW_VSYNC;
 static bool __mouseCaptured = false;
 static float __mouseCapturePointX = 0;
@@ -565,10 +571,15 @@ Platform* Platform::create(Game* game)
 
     GP_ASSERT(game);
 
+    // Time the creation of the window and context for the startup trace, before the game clock starts.
+    clock_gettime(CLOCK_REALTIME, &__timespec);
+    __timeCreateStart = timespec2millis(&__timespec);
+
     FileSystem::setResourcePath("./");
     Platform* platform = new Platform(game);
 
-    // Get the display and initialize
+    // Get the display and initialize (Xlib is also used by the render thread to swap buffers)
+    XInitThreads();
     __display = XOpenDisplay(NULL);
     if (__display == NULL)
     {
@@ -739,6 +750,9 @@ Platform* Platform::create(Game* game)
     else if(glXSwapIntervalMESA)
         glXSwapIntervalMESA(__vsync ? 1 : 0);
 
+    clock_gettime(CLOCK_REALTIME, &__timespec);
+    __timeCreateEnd = timespec2millis(&__timespec);
+
     return platform;
 }
 
@@ -1131,6 +1145,7 @@ int Platform::enterMessagePump()
     clock_gettime(CLOCK_REALTIME, &__timespec);
     __timeStart = timespec2millis(&__timespec);
     __timeAbsolute = 0L;
+    StartupTrace::record("Platform::create", __timeCreateStart - __timeStart, __timeCreateEnd - __timeStart);
 
     // Run the game.
     _game->run();
@@ -1171,6 +1186,7 @@ int Platform::enterMessagePump()
 
                 case Expose:
                     {
+                        FramePacer::wake();
                         updateWindowSize();
                     }
                     break;
@@ -1329,7 +1345,12 @@ int Platform::enterMessagePump()
             _game->frame();
         }
 
-        glXSwapBuffers(__display, __window);
+        // The render thread swaps the buffers it draws. Idle frames draw nothing, so the last frame stays on display.
+        if (!_game->isRenderThreaded() && !FramePacer::isIdle())
+            glXSwapBuffers(__display, __window);
+
+        // Sleep until the next frame is due, if the frames are paced.
+        FramePacer::wait();
     }
 
     cleanupX11();
@@ -1391,6 +1412,11 @@ void Platform::swapBuffers()
     glXSwapBuffers(__display, __window);
 }
 
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    return glXMakeCurrent(__display, current ? __window : None, current ? __context : NULL) == True;
+}
+
 void Platform::sleep(long ms)
 {
     usleep(ms * 1000);
@@ -1,4 +1,4 @@
-#ifdef __APPLE__
+#if defined(__APPLE__) && !defined(GP_HEADLESS)
 
 #include "Base.h"
 #include "Platform.h"
@@ -6,6 +6,7 @@
 #include "Game.h"
 #include "Form.h"
 #include "ScriptController.h"
+#include "FramePacer.h"
 #include <unistd.h>
 #include <IOKit/hid/IOHIDLib.h>
 #import <Cocoa/Cocoa.h>
@@ -817,7 +818,9 @@ double getMachTimeInMilliseconds()
         
         _game->frame();
     }
-    CGLFlushDrawable((CGLContextObj)[[self openGLContext] CGLContextObj]);
+    // Idle frames draw nothing, so the last frame stays on display.
+    if (!FramePacer::isIdle())
+        CGLFlushDrawable((CGLContextObj)[[self openGLContext] CGLContextObj]);
     CGLUnlockContext((CGLContextObj)[[self openGLContext] CGLContextObj]);  
 
     [gameLock unlock];
@@ -1812,6 +1815,11 @@ void Platform::swapBuffers()
         CGLFlushDrawable((CGLContextObj)[[__view openGLContext] CGLContextObj]);
 }
 
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    return false;
+}
+
 void Platform::sleep(long ms)
 {
     usleep(ms * 1000);
@@ -1,9 +1,11 @@
-#ifdef WIN32
+#if defined(WIN32) && !defined(GP_HEADLESS)
 
 #include "Base.h"
 #include "Platform.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "FramePacer.h"
+#include "StartupTrace.h"
 #include "Form.h"
 #include "Vector2.h"
 #include "ScriptController.h"
@@ -27,6 +29,8 @@ using gameplay::print;
 static double __timeTicksPerMillis;
 static double __timeStart;
 static double __timeAbsolute;
+static LONGLONG __timeCreateStart;
+static LONGLONG __timeCreateEnd;
 static bool __vsync = WINDOW_VSYNC;
 static HINSTANCE __hinstance = 0;
 static HWND __hwnd = 0;
@@ -798,6 +802,11 @@ Platform* Platform::create(Game* game)
 {
     GP_ASSERT(game);
 
+    // Time the creation of the window and context for the startup trace, before the game clock starts.
+    LARGE_INTEGER createTime;
+    QueryPerformanceCounter(&createTime);
+    __timeCreateStart = createTime.QuadPart;
+
     FileSystem::setResourcePath("./");
     Platform* platform = new Platform(game);
 
@@ -958,6 +967,9 @@ Platform* Platform::create(Game* game)
     }
 #endif
 
+    QueryPerformanceCounter(&createTime);
+    __timeCreateEnd = createTime.QuadPart;
+
     return platform;
 
 error:
@@ -978,6 +990,8 @@ int Platform::enterMessagePump()
     QueryPerformanceCounter(&queryTime);
     GP_ASSERT(__timeTicksPerMillis);
     __timeStart = queryTime.QuadPart / __timeTicksPerMillis;
+    if (__timeCreateEnd > 0)
+        StartupTrace::record("Platform::create", __timeCreateStart / __timeTicksPerMillis - __timeStart, __timeCreateEnd / __timeTicksPerMillis - __timeStart);
 
     SwapBuffers(__hdc);
 
@@ -1020,7 +1034,13 @@ int Platform::enterMessagePump()
             }
 #endif
             _game->frame();
-            SwapBuffers(__hdc);
+
+            // The render thread swaps the buffers it draws. Idle frames draw nothing, so the last frame stays on display.
+            if (!_game->isRenderThreaded() && !FramePacer::isIdle())
+                SwapBuffers(__hdc);
+
+            // Sleep until the next frame is due, if the frames are paced.
+            FramePacer::wait();
         }
 
         // If we are done, then exit.
@@ -1090,6 +1110,11 @@ void Platform::swapBuffers()
         SwapBuffers(__hdc);
 }
 
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    return wglMakeCurrent(current ? __hdc : NULL, current ? __hrc : NULL) == TRUE;
+}
+
 void Platform::sleep(long ms)
 {
     Sleep(ms);
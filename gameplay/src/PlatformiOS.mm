@@ -6,6 +6,7 @@
 #include "Game.h"
 #include "Form.h"
 #include "ScriptController.h"
+#include "FramePacer.h"
 #include <unistd.h>
 #include <sys/time.h>
 #import <UIKit/UIKit.h>
@@ -501,8 +502,9 @@ int getUnicode(int key);
         if (game)
             game->frame();
         
-        // Present the contents of the color buffer
-        [self swapBuffers];
+        // Present the contents of the color buffer, unless the idle frame drew nothing
+        if (!FramePacer::isIdle())
+            [self swapBuffers];
     }
 }
 
@@ -1548,6 +1550,11 @@ void Platform::swapBuffers()
     if (__view)
         [__view swapBuffers];
 }
+
+bool Platform::setGraphicsContextCurrent(bool current)
+{
+    return false;
+}
 void Platform::sleep(long ms)
 {
     usleep(ms * 1000);
@@ -0,0 +1,367 @@
+#include "Base.h"
+#include "PostProcessChain.h"
+#include "RenderTargetPool.h"
+#include "FrameBuffer.h"
+#include "FileSystem.h"
+#include "Material.h"
+#include "Effect.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Game.h"
+
+namespace gameplay
+{
+
+// Vertex shader shared by all the stages of post-processing chains.
+static const char* POSTPROCESS_VSH =
+    "attribute vec4 a_position;\n"
+    "attribute vec2 a_texCoord;\n"
+    "varying vec2 v_texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = a_position;\n"
+    "    v_texCoord = a_texCoord;\n"
+    "}\n";
+
+// Declarations that precede the sources of the passes in the fragment shader of a stage.
+static const char* POSTPROCESS_FSH_HEADER =
+    "#ifdef OPENGL_ES\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "#endif\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform sampler2D u_sceneTexture;\n"
+    "uniform vec2 u_texelSize;\n"
+    "varying vec2 v_texCoord;\n";
+
+PostProcessChain::Pass::Pass(PostProcessChain* chain, const char* id, Type type, const char* source, float scale)
+    : _chain(chain), _id(id ? id : ""), _type(type), _source(source), _scale(scale), _enabled(true)
+{
+}
+
+PostProcessChain::Pass::~Pass()
+{
+}
+
+const char* PostProcessChain::Pass::getId() const
+{
+    return _id.c_str();
+}
+
+PostProcessChain::Pass::Type PostProcessChain::Pass::getType() const
+{
+    return _type;
+}
+
+float PostProcessChain::Pass::getScale() const
+{
+    return _scale;
+}
+
+void PostProcessChain::Pass::setEnabled(bool enabled)
+{
+    if (enabled != _enabled)
+    {
+        _enabled = enabled;
+        _chain->_dirty = true;
+    }
+}
+
+bool PostProcessChain::Pass::isEnabled() const
+{
+    return _enabled;
+}
+
+PostProcessChain::PostProcessChain(Texture::Format format)
+    : _format(format), _dirty(true), _quad(NULL), _frameBuffer(NULL)
+{
+}
+
+PostProcessChain::~PostProcessChain()
+{
+    clearStages();
+    for (size_t i = 0, count = _passes.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_passes[i]);
+    }
+    for (std::map<Texture*, Texture::Sampler*>::iterator itr = _samplers.begin(); itr != _samplers.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    SAFE_RELEASE(_frameBuffer);
+    SAFE_RELEASE(_quad);
+}
+
+PostProcessChain* PostProcessChain::create(Texture::Format format)
+{
+    GP_ASSERT(format == Texture::RGB || format == Texture::RGBA);
+
+    Mesh* quad = Mesh::createQuadFullscreen();
+    if (quad == NULL)
+    {
+        GP_ERROR("Failed to create the quad of a post-processing chain.");
+        return NULL;
+    }
+
+    static unsigned int chainCount = 0;
+    char id[32];
+    sprintf(id, "__postProcessChain%u", chainCount++);
+    FrameBuffer* frameBuffer = FrameBuffer::create(id);
+    if (frameBuffer == NULL)
+    {
+        GP_ERROR("Failed to create the frame buffer of a post-processing chain.");
+        SAFE_RELEASE(quad);
+        return NULL;
+    }
+
+    PostProcessChain* chain = new PostProcessChain(format);
+    chain->_quad = quad;
+    chain->_frameBuffer = frameBuffer;
+    return chain;
+}
+
+PostProcessChain::Pass* PostProcessChain::addTexturePass(const char* id, const char* path, float scale)
+{
+    GP_ASSERT(scale > 0.0f && scale <= 1.0f);
+
+    return addPass(id, Pass::TEXTURE, path, scale);
+}
+
+PostProcessChain::Pass* PostProcessChain::addColorPass(const char* id, const char* path)
+{
+    return addPass(id, Pass::COLOR, path, 1.0f);
+}
+
+PostProcessChain::Pass* PostProcessChain::addPass(const char* id, Pass::Type type, const char* path, float scale)
+{
+    GP_ASSERT(path);
+
+    char* source = FileSystem::readAll(path);
+    if (source == NULL)
+    {
+        GP_ERROR("Failed to read post-processing pass from file '%s'.", path);
+        return NULL;
+    }
+
+    Pass* pass = new Pass(this, id, type, source, scale);
+    SAFE_DELETE_ARRAY(source);
+
+    _passes.push_back(pass);
+    _dirty = true;
+    return pass;
+}
+
+unsigned int PostProcessChain::getPassCount() const
+{
+    return (unsigned int)_passes.size();
+}
+
+PostProcessChain::Pass* PostProcessChain::getPass(unsigned int index) const
+{
+    GP_ASSERT(index < _passes.size());
+    return _passes[index];
+}
+
+PostProcessChain::Pass* PostProcessChain::getPass(const char* id) const
+{
+    GP_ASSERT(id);
+
+    for (size_t i = 0, count = _passes.size(); i < count; ++i)
+    {
+        if (_passes[i]->_id == id)
+            return _passes[i];
+    }
+    return NULL;
+}
+
+unsigned int PostProcessChain::getStageCount()
+{
+    if (_dirty)
+        build();
+
+    return (unsigned int)_stages.size();
+}
+
+void PostProcessChain::draw(Texture* input, FrameBuffer* destination)
+{
+    GP_ASSERT(input);
+
+    if (_dirty)
+        build();
+
+    Game* game = Game::getInstance();
+    GP_ASSERT(game);
+    Rectangle viewport = game->getViewport();
+    if (destination == NULL)
+    {
+        destination = FrameBuffer::getCurrent();
+    }
+
+    // Draw each stage into a pooled render target, the last one into the destination.
+    Texture::Sampler* inputSampler = getSampler(input);
+    Texture* source = input;
+    RenderTarget* sourceTarget = NULL;
+    for (size_t i = 0, count = _stages.size(); i < count; ++i)
+    {
+        Stage& stage = _stages[i];
+        RenderTarget* target = NULL;
+        if (i + 1 < count)
+        {
+            unsigned int width = std::max(1u, (unsigned int)(viewport.width * stage.scale));
+            unsigned int height = std::max(1u, (unsigned int)(viewport.height * stage.scale));
+            target = RenderTargetPool::acquire(width, height, _format);
+            if (target == NULL)
+                break;
+
+            _frameBuffer->setRenderTarget(target);
+            _frameBuffer->bind();
+            game->setViewport(Rectangle(0, 0, width, height));
+        }
+        else
+        {
+            destination->bind();
+            game->setViewport(viewport);
+        }
+
+        Material* material = stage.model->getMaterial();
+        material->getParameter("u_texture")->setValue(getSampler(source));
+        if (stage.usesScene)
+        {
+            material->getParameter("u_sceneTexture")->setValue(inputSampler);
+        }
+        if (stage.usesTexelSize)
+        {
+            material->getParameter("u_texelSize")->setValue(Vector2(1.0f / source->getWidth(), 1.0f / source->getHeight()));
+        }
+        stage.model->draw();
+
+        // The source of this stage is no longer needed.
+        if (sourceTarget)
+        {
+            RenderTargetPool::release(sourceTarget);
+        }
+        sourceTarget = target;
+        if (target)
+        {
+            source = target->getTexture();
+        }
+    }
+
+    if (sourceTarget)
+    {
+        RenderTargetPool::release(sourceTarget);
+    }
+    _frameBuffer->setRenderTarget(NULL);
+    destination->bind();
+    game->setViewport(viewport);
+}
+
+void PostProcessChain::build()
+{
+    clearStages();
+    _dirty = false;
+
+    // Every texture pass starts a new stage, and color passes join the stage before them.
+    std::vector<Pass*> passes;
+    for (size_t i = 0, count = _passes.size(); i <= count; ++i)
+    {
+        Pass* pass = i < count ? _passes[i] : NULL;
+        if (pass && !pass->_enabled)
+            continue;
+
+        if (pass == NULL || (pass->_type == Pass::TEXTURE && !passes.empty()))
+        {
+            Stage stage;
+            if (buildStage(passes, stage))
+            {
+                _stages.push_back(stage);
+            }
+            passes.clear();
+        }
+        if (pass)
+        {
+            passes.push_back(pass);
+        }
+    }
+}
+
+bool PostProcessChain::buildStage(const std::vector<Pass*>& passes, Stage& stage)
+{
+    // Rename the function of each pass so that several passes can share the shader.
+    std::string fsh = POSTPROCESS_FSH_HEADER;
+    std::string body = "void main()\n{\n";
+    if (passes.empty() || passes[0]->_type != Pass::TEXTURE)
+    {
+        body += "    vec4 color = texture2D(u_texture, v_texCoord);\n";
+    }
+    for (size_t i = 0, count = passes.size(); i < count; ++i)
+    {
+        const char* function = passes[i]->_type == Pass::TEXTURE ? "processTexture" : "processColor";
+        char name[32];
+        sprintf(name, "%s%u", function, (unsigned int)i);
+        fsh += std::string("#define ") + function + " " + name + "\n";
+        fsh += passes[i]->_source;
+        fsh += std::string("\n#undef ") + function + "\n";
+
+        if (passes[i]->_type == Pass::TEXTURE)
+            body += std::string("    vec4 color = ") + name + "(u_texture, v_texCoord, u_texelSize);\n";
+        else
+            body += std::string("    color = ") + name + "(color);\n";
+    }
+    fsh += body + "    gl_FragColor = color;\n}\n";
+
+    Effect* effect = Effect::createFromSource(POSTPROCESS_VSH, fsh.c_str());
+    if (effect == NULL)
+    {
+        GP_ERROR("Failed to compile post-processing pass '%s'.", passes.empty() ? "" : passes[0]->getId());
+        return false;
+    }
+
+    // The parameters of the passes are inherited, so that they outlive the stage.
+    Material* material = Material::create(effect);
+    RenderState* parent = NULL;
+    for (size_t i = 0, count = passes.size(); i < count; ++i)
+    {
+        passes[i]->_parent = parent;
+        parent = passes[i];
+    }
+    material->_parent = parent;
+    ++RenderState::_bindListRevision;
+
+    stage.model = Model::create(_quad);
+    stage.model->setMaterial(material);
+    stage.scale = passes.empty() ? 1.0f : passes[0]->_scale;
+    stage.usesScene = effect->getUniform("u_sceneTexture") != NULL;
+    stage.usesTexelSize = effect->getUniform("u_texelSize") != NULL;
+
+    SAFE_RELEASE(material);
+    SAFE_RELEASE(effect);
+    return true;
+}
+
+void PostProcessChain::clearStages()
+{
+    for (size_t i = 0, count = _stages.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_stages[i].model);
+    }
+    _stages.clear();
+}
+
+Texture::Sampler* PostProcessChain::getSampler(Texture* texture)
+{
+    std::map<Texture*, Texture::Sampler*>::const_iterator itr = _samplers.find(texture);
+    if (itr != _samplers.end())
+        return itr->second;
+
+    Texture::Sampler* sampler = Texture::Sampler::create(texture);
+    sampler->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    _samplers[texture] = sampler;
+    return sampler;
+}
+
+}
@@ -0,0 +1,287 @@
+#ifndef POSTPROCESSCHAIN_H_
+#define POSTPROCESSCHAIN_H_
+
+#include "Ref.h"
+#include "RenderState.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+class Model;
+class Mesh;
+class FrameBuffer;
+class RenderTarget;
+
+/**
+ * Defines a chain of full-screen post-processing passes.
+ *
+ * Each pass is a fragment shader file that defines one of two functions, depending on
+ * the type of the pass:
+ *
+ * @code
+   // Texture passes read their source image freely (blurs, anti-aliasing...).
+   vec4 processTexture(sampler2D source, vec2 texCoord, vec2 texelSize);
+
+   // Color passes only transform the color of each pixel (tone mapping, grading...).
+   vec4 processColor(vec4 color);
+ * @endcode
+ *
+ * The shaders of the passes also have access to the u_sceneTexture uniform, which is the
+ * input of the chain, so that later passes can combine it with their source. A pass must
+ * not declare u_texture, u_sceneTexture, u_texelSize or v_texCoord itself.
+ *
+ * The chain merges each color pass into the shader of the pass before it, so that consecutive
+ * passes are drawn at once instead of going through an intermediate render target. Texture
+ * passes can render at a fraction of the output resolution (for example 0.5 for half size),
+ * which makes wide blurs cheap. The intermediate render targets come from the RenderTargetPool,
+ * so drawing the chain allocates nothing once the first frame has been drawn.
+ *
+ * Passes are render states: their uniforms are set with getParameter() and keep their values
+ * when the chain merges its passes differently, for example after a pass has been disabled.
+ * Passes merged into the same shader must not declare uniforms or functions with the same names.
+ *
+ * @code
+   PostProcessChain* chain = PostProcessChain::create();
+   chain->addTexturePass("bright", "res/shaders/postprocess-bright.frag", 0.5f)->getParameter("u_bloomThreshold")->setValue(0.7f);
+   chain->addTexturePass("blurX", "res/shaders/postprocess-blur.frag", 0.5f)->getParameter("u_blurDirection")->setValue(Vector2(1, 0));
+   chain->addTexturePass("blurY", "res/shaders/postprocess-blur.frag", 0.5f)->getParameter("u_blurDirection")->setValue(Vector2(0, 1));
+   chain->addTexturePass("bloom", "res/shaders/postprocess-bloom.frag")->getParameter("u_bloomIntensity")->setValue(1.0f);
+   chain->addColorPass("tonemap", "res/shaders/postprocess-tonemap.frag")->getParameter("u_exposure")->setValue(1.5f);
+   chain->addTexturePass("fxaa", "res/shaders/postprocess-fxaa.frag");
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       FrameBuffer* previous = _sceneBuffer->bind();
+       ... draw the scene ...
+       previous->bind();
+       chain->draw(_sceneBuffer->getRenderTarget()->getTexture());
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class PostProcessChain : public Ref
+{
+public:
+
+    /**
+     * Defines a pass of a post-processing chain.
+     */
+    class Pass : public RenderState
+    {
+        friend class PostProcessChain;
+
+    public:
+
+        /**
+         * Defines the types of passes.
+         */
+        enum Type
+        {
+            TEXTURE,
+            COLOR
+        };
+
+        /**
+         * Returns the ID of this pass.
+         *
+         * @return The ID of this pass.
+         */
+        const char* getId() const;
+
+        /**
+         * Returns the type of this pass.
+         *
+         * @return The type of this pass.
+         */
+        Type getType() const;
+
+        /**
+         * Returns the resolution of this pass, relative to the output of the chain.
+         *
+         * @return The scale of this pass (always 1 for color passes).
+         */
+        float getScale() const;
+
+        /**
+         * Sets whether this pass is drawn.
+         *
+         * @param enabled true to draw this pass, false to skip it.
+         */
+        void setEnabled(bool enabled);
+
+        /**
+         * Returns whether this pass is drawn.
+         *
+         * @return true if this pass is drawn.
+         */
+        bool isEnabled() const;
+
+    private:
+
+        /**
+         * Constructor.
+         */
+        Pass(PostProcessChain* chain, const char* id, Type type, const char* source, float scale);
+
+        /**
+         * Destructor.
+         */
+        ~Pass();
+
+        /**
+         * Hidden copy constructor.
+         */
+        Pass(const Pass& copy);
+
+        /**
+         * Hidden copy assignment operator.
+         */
+        Pass& operator=(const Pass&);
+
+        PostProcessChain* _chain;
+        std::string _id;
+        Type _type;
+        std::string _source;
+        float _scale;
+        bool _enabled;
+    };
+
+    /**
+     * Creates an empty post-processing chain.
+     *
+     * @param format The format of the intermediate render targets (RGB or RGBA).
+     *
+     * @return The new post-processing chain.
+     */
+    static PostProcessChain* create(Texture::Format format = Texture::RGBA);
+
+    /**
+     * Adds a texture pass at the end of the chain.
+     *
+     * The last texture pass of the chain always renders at the full output resolution.
+     *
+     * @param id The ID of the pass.
+     * @param path The path of the fragment shader defining processTexture().
+     * @param scale The resolution of the pass, relative to the output of the chain.
+     *
+     * @return The new pass, or NULL if the shader could not be read.
+     */
+    Pass* addTexturePass(const char* id, const char* path, float scale = 1.0f);
+
+    /**
+     * Adds a color pass at the end of the chain.
+     *
+     * @param id The ID of the pass.
+     * @param path The path of the fragment shader defining processColor().
+     *
+     * @return The new pass, or NULL if the shader could not be read.
+     */
+    Pass* addColorPass(const char* id, const char* path);
+
+    /**
+     * Returns the number of passes in the chain.
+     *
+     * @return The number of passes.
+     */
+    unsigned int getPassCount() const;
+
+    /**
+     * Returns the pass at the specified index.
+     *
+     * @param index The index of the pass.
+     *
+     * @return The pass.
+     */
+    Pass* getPass(unsigned int index) const;
+
+    /**
+     * Returns the pass with the specified ID.
+     *
+     * @param id The ID of the pass.
+     *
+     * @return The pass, or NULL if there is no pass with this ID.
+     */
+    Pass* getPass(const char* id) const;
+
+    /**
+     * Returns the number of draws needed by the enabled passes once they have been merged.
+     *
+     * @return The number of stages of the chain.
+     */
+    unsigned int getStageCount();
+
+    /**
+     * Draws the chain.
+     *
+     * The output is drawn over the viewport of the game, into the destination frame buffer.
+     * Intermediate passes are drawn into pooled render targets, which are given back to the
+     * pool before this method returns.
+     *
+     * @param input The texture to post-process, typically the color target of the scene.
+     * @param destination The frame buffer to draw into, or NULL for the current frame buffer.
+     */
+    void draw(Texture* input, FrameBuffer* destination = NULL);
+
+private:
+
+    /**
+     * Defines a group of passes drawn with a single shader.
+     */
+    struct Stage
+    {
+        Model* model;
+        float scale;
+        bool usesScene;
+        bool usesTexelSize;
+    };
+
+    /**
+     * Constructor.
+     */
+    PostProcessChain(Texture::Format format);
+
+    /**
+     * Destructor.
+     */
+    ~PostProcessChain();
+
+    /**
+     * Hidden copy constructor.
+     */
+    PostProcessChain(const PostProcessChain& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    PostProcessChain& operator=(const PostProcessChain&);
+
+    Pass* addPass(const char* id, Pass::Type type, const char* path, float scale);
+
+    /**
+     * Merges the enabled passes into stages and compiles their shaders.
+     */
+    void build();
+
+    /**
+     * Compiles the shader of the stage drawing the specified passes.
+     */
+    bool buildStage(const std::vector<Pass*>& passes, Stage& stage);
+
+    void clearStages();
+
+    Texture::Sampler* getSampler(Texture* texture);
+
+    Texture::Format _format;
+    std::vector<Pass*> _passes;
+    std::vector<Stage> _stages;
+    bool _dirty;
+    Mesh* _quad;
+    FrameBuffer* _frameBuffer;
+    std::map<Texture*, Texture::Sampler*> _samplers;
+};
+
+}
+
+#endif
@@ -0,0 +1,264 @@
+#include "Base.h"
+#include "Profiler.h"
+#include "Game.h"
+#include "Font.h"
+#include "FileSystem.h"
+#include "Stream.h"
+#include "Thread.h"
+
+// Interval (in milliseconds) over which timings are averaged for display
+#define PROFILER_DISPLAY_INTERVAL 1000.0
+
+namespace gameplay
+{
+
+/**
+ * A single timed block within a frame.
+ */
+struct ProfilerSample
+{
+    const char* name;
+    unsigned int depth;
+    double start;
+    double end;
+};
+
+/**
+ * The accumulated time of a block over several frames.
+ */
+struct ProfilerStat
+{
+    const char* name;
+    unsigned int depth;
+    double total;
+};
+
+static bool __enabled = true;
+static std::vector<ProfilerSample> __samples;
+static std::vector<ProfilerSample> __lastFrame;
+static std::vector<size_t> __stack;
+static std::vector<ProfilerStat> __stats;
+static std::vector<ProfilerStat> __display;
+static unsigned int __statFrameCount = 0;
+static double __statStartTime = 0.0;
+static bool __capturing = false;
+static double __captureStartTime = 0.0;
+static std::vector<ProfilerSample> __capture;
+
+// The thread timing the frames. Blocks timed on other threads (such as update() in pipelined mode) are ignored.
+static bool __frameStarted = false;
+static Thread::Id __frameThread;
+
+static bool isFrameThread()
+{
+    return __frameStarted && Thread::isCurrent(__frameThread);
+}
+
+void Profiler::begin(const char* name)
+{
+    GP_ASSERT(name);
+
+    if (!__enabled || !isFrameThread())
+        return;
+
+    ProfilerSample sample;
+    sample.name = name;
+    sample.depth = (unsigned int)__stack.size();
+    sample.start = Game::getAbsoluteTime();
+    sample.end = sample.start;
+    __stack.push_back(__samples.size());
+    __samples.push_back(sample);
+}
+
+void Profiler::end()
+{
+    if (!isFrameThread() || __stack.empty())
+        return;
+
+    __samples[__stack.back()].end = Game::getAbsoluteTime();
+    __stack.pop_back();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    __enabled = enabled;
+}
+
+bool Profiler::isEnabled()
+{
+    return __enabled;
+}
+
+float Profiler::getTime(const char* name)
+{
+    GP_ASSERT(name);
+
+    for (size_t i = 0, count = __display.size(); i < count; ++i)
+    {
+        if (strcmp(__display[i].name, name) == 0)
+            return (float)__display[i].total;
+    }
+    return 0.0f;
+}
+
+float Profiler::getFrameTime(const char* name)
+{
+    GP_ASSERT(name);
+
+    double total = 0.0;
+    for (size_t i = 0, count = __lastFrame.size(); i < count; ++i)
+    {
+        if (strcmp(__lastFrame[i].name, name) == 0)
+            total += __lastFrame[i].end - __lastFrame[i].start;
+    }
+    return (float)total;
+}
+
+void Profiler::drawOverlay(Font* font, int x, int y, const Vector4& color)
+{
+    GP_ASSERT(font);
+
+    if (__display.empty())
+        return;
+
+    GP_PROFILE_SCOPE("Profiler");
+
+    unsigned int size = font->getSize();
+    char text[128];
+    font->start();
+    for (size_t i = 0, count = __display.size(); i < count; ++i)
+    {
+        const ProfilerStat& stat = __display[i];
+        sprintf(text, "%*s%s: %.2f ms", (int)(stat.depth * 2), "", stat.name, stat.total);
+        font->drawText(text, x, y + (int)(i * size), color, size);
+    }
+    font->finish();
+}
+
+void Profiler::startCapture()
+{
+    __capture.clear();
+    __capturing = true;
+    __captureStartTime = Game::getAbsoluteTime();
+}
+
+bool Profiler::stopCapture(const char* path)
+{
+    GP_ASSERT(path);
+
+    __capturing = false;
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open file '%s' to write the profiler capture.", path);
+        __capture.clear();
+        return false;
+    }
+
+    // Write each block as a complete event, with times in microseconds.
+    char event[256];
+    const char* header = "{\"traceEvents\":[\n";
+    stream->write(header, 1, strlen(header));
+    for (size_t i = 0, count = __capture.size(); i < count; ++i)
+    {
+        const ProfilerSample& sample = __capture[i];
+        int length = sprintf(event, "%s{\"name\":\"%.128s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+            i > 0 ? ",\n" : "", sample.name, (sample.start - __captureStartTime) * 1000.0, (sample.end - sample.start) * 1000.0);
+        stream->write(event, 1, length);
+    }
+    const char* footer = "\n]}\n";
+    stream->write(footer, 1, strlen(footer));
+    stream->close();
+
+    __capture.clear();
+    return true;
+}
+
+bool Profiler::isCapturing()
+{
+    return __capturing;
+}
+
+void Profiler::beginFrame()
+{
+    __frameThread = Thread::getCurrentId();
+    __frameStarted = true;
+    __samples.clear();
+    __stack.clear();
+    begin("Frame");
+}
+
+void Profiler::endFrame()
+{
+    // Close the frame and any blocks that were left open.
+    while (!__stack.empty())
+    {
+        end();
+    }
+
+    for (size_t i = 0, count = __samples.size(); i < count; ++i)
+    {
+        const ProfilerSample& sample = __samples[i];
+        size_t j = 0;
+        size_t statCount = __stats.size();
+        while (j < statCount && (__stats[j].name != sample.name || __stats[j].depth != sample.depth))
+        {
+            ++j;
+        }
+        if (j == statCount)
+        {
+            ProfilerStat stat;
+            stat.name = sample.name;
+            stat.depth = sample.depth;
+            stat.total = 0.0;
+            __stats.push_back(stat);
+        }
+        __stats[j].total += sample.end - sample.start;
+    }
+
+    if (__capturing)
+    {
+        __capture.insert(__capture.end(), __samples.begin(), __samples.end());
+    }
+
+    // Publish the averaged timings once per display interval.
+    ++__statFrameCount;
+    double time = Game::getAbsoluteTime();
+    if (time - __statStartTime >= PROFILER_DISPLAY_INTERVAL)
+    {
+        __display.swap(__stats);
+        for (size_t i = 0, count = __display.size(); i < count; ++i)
+        {
+            __display[i].total /= __statFrameCount;
+        }
+        __stats.clear();
+        __statFrameCount = 0;
+        __statStartTime = time;
+    }
+
+    // Keep the blocks of the frame for getFrameTime(). beginFrame() clears the list swapped in.
+    __lastFrame.swap(__samples);
+}
+
+
+unsigned int Profiler::getFrameBlockCount()
+{
+    return (unsigned int)__lastFrame.size();
+}
+
+const char* Profiler::getFrameBlock(unsigned int index, unsigned int* depth, double* start, double* end)
+{
+    GP_ASSERT(index < __lastFrame.size());
+
+    const ProfilerSample& sample = __lastFrame[index];
+    if (depth)
+        *depth = sample.depth;
+    if (start)
+        *start = sample.start;
+    if (end)
+        *end = sample.end;
+    return sample.name;
+}
+
+}
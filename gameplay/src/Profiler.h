@@ -0,0 +1,198 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "Vector4.h"
+
+/**
+ * The profiler macros are compiled into debug builds by default. Define GP_USE_PROFILER
+ * to keep them in release builds, or GP_NO_PROFILER to remove them from debug builds.
+ */
+#if defined(_DEBUG) && !defined(GP_NO_PROFILER) && !defined(GP_USE_PROFILER)
+#define GP_USE_PROFILER
+#endif
+
+#ifdef GP_USE_PROFILER
+/** Times the enclosing scope. The name must be a string literal. */
+#define GP_PROFILE_SCOPE(name) gameplay::Profiler::Scope __gp_profileScope(name)
+/** Starts timing a block of code. The name must be a string literal. */
+#define GP_PROFILE_BEGIN(name) gameplay::Profiler::begin(name)
+/** Stops timing the block of code started by the matching GP_PROFILE_BEGIN. */
+#define GP_PROFILE_END() gameplay::Profiler::end()
+#else
+#define GP_PROFILE_SCOPE(name)
+#define GP_PROFILE_BEGIN(name)
+#define GP_PROFILE_END()
+#endif
+
+namespace gameplay
+{
+
+class Font;
+
+/**
+ * Defines a lightweight hierarchical CPU profiler.
+ *
+ * Code is timed by wrapping it with the GP_PROFILE_SCOPE or GP_PROFILE_BEGIN/GP_PROFILE_END
+ * macros, which can be nested. The game times each of its update and render phases every
+ * frame, and the timings averaged over the last second can be drawn on screen with
+ * drawOverlay(). A capture of every timed block can also be recorded and saved in the
+ * Chrome trace event format (open it with chrome://tracing).
+ *
+ * The profiler only times blocks on the game thread. Blocks timed on other threads, such as
+ * the job worker threads and update() in pipelined mode, are ignored.
+ *
+ * @script{ignore}
+ */
+class Profiler
+{
+    friend class Game;
+    friend class Telemetry;
+
+public:
+
+    /**
+     * Times a block of code for the lifetime of the scope it is declared in.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Constructor. Starts timing the block.
+         *
+         * @param name The name of the block. This must be a string literal.
+         */
+        Scope(const char* name)
+        {
+            Profiler::begin(name);
+        }
+
+        /**
+         * Destructor. Stops timing the block.
+         */
+        ~Scope()
+        {
+            Profiler::end();
+        }
+
+    private:
+
+        Scope(const Scope& copy);
+
+        Scope& operator=(const Scope&);
+    };
+
+    /**
+     * Starts timing a block of code.
+     *
+     * @param name The name of the block. This must be a string literal (or otherwise
+     *      outlive the profiler) since only the pointer is stored.
+     */
+    static void begin(const char* name);
+
+    /**
+     * Stops timing the most recently started block of code.
+     */
+    static void end();
+
+    /**
+     * Enables or disables the profiler. The profiler is enabled by default.
+     *
+     * @param enabled true to enable the profiler, false to disable it.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Determines if the profiler is enabled.
+     *
+     * @return true if the profiler is enabled, false otherwise.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the average time spent in a named block over the last second.
+     *
+     * @param name The name of the block.
+     *
+     * @return The average time per frame in milliseconds, or 0 if the block was not timed.
+     */
+    static float getTime(const char* name);
+
+    /**
+     * Returns the time spent in a named block during the last completed frame.
+     *
+     * Unlike getTime(), this is not averaged, so that tools can gather the timings of
+     * every frame, for instance to compute percentiles. The time of every block with
+     * the name is summed.
+     *
+     * @param name The name of the block.
+     *
+     * @return The time in milliseconds, or 0 if the block was not timed in the last frame.
+     */
+    static float getFrameTime(const char* name);
+
+    /**
+     * Draws the averaged timings of the last second as an indented list.
+     *
+     * This must be called while rendering a frame.
+     *
+     * @param font The font to draw the timings with.
+     * @param x The x coordinate of the top left corner of the list.
+     * @param y The y coordinate of the top left corner of the list.
+     * @param color The color of the text.
+     */
+    static void drawOverlay(Font* font, int x, int y, const Vector4& color = Vector4::one());
+
+    /**
+     * Starts recording every timed block for a trace capture.
+     */
+    static void startCapture();
+
+    /**
+     * Stops the current capture and writes it to a file in the Chrome trace event format.
+     *
+     * @param path The path of the file to write.
+     *
+     * @return true if the capture was written, false otherwise.
+     */
+    static bool stopCapture(const char* path);
+
+    /**
+     * Determines if a trace capture is being recorded.
+     *
+     * @return true if a capture is in progress, false otherwise.
+     */
+    static bool isCapturing();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Profiler();
+
+    /**
+     * Starts timing a new frame. Called by the game.
+     */
+    static void beginFrame();
+
+    /**
+     * Stops timing the current frame and accumulates its timings. Called by the game.
+     */
+    static void endFrame();
+
+    /**
+     * Returns the number of blocks timed during the last completed frame.
+     */
+    static unsigned int getFrameBlockCount();
+
+    /**
+     * Returns the name of a block timed during the last completed frame, in the order the blocks
+     * started, and its depth and its start and end times in milliseconds (any of which can be NULL).
+     */
+    static const char* getFrameBlock(unsigned int index, unsigned int* depth, double* start, double* end);
+};
+
+}
+
+#endif
@@ -2,10 +2,26 @@
 #include "Properties.h"
 #include "FileSystem.h"
 #include "Quaternion.h"
+#include "Thread.h"
+
+// Identifies a compiled properties file. It is followed by the format version.
+static const unsigned char PROPERTIES_BINARY_IDENTIFIER[] = { 0xAB, 'G', 'P', 'P', 0xBB, '\r', '\n', 0x1A, '\n' };
+#define PROPERTIES_BINARY_VERSION 1
+
+// Namespaces with fewer properties or nested namespaces than this are searched linearly.
+#define PROPERTIES_INDEX_MIN_SIZE 8
 
 namespace gameplay
 {
 
+// Directory of the compiled copies of text properties files, or empty when caching is disabled.
+static std::string __cachePath;
+
+// Parsed properties files by path, kept while the file cache is retained.
+static std::map<std::string, Properties*> __fileCache;
+static unsigned int __fileCacheRefCount = 0;
+static Mutex __fileCacheMutex;
+
 /**
  * Reads the next character from the stream. Returns EOF if the end of the stream is reached.
  */
@@ -26,12 +42,12 @@ void calculateNamespacePath(const std::string& urlString, std::string& fileStrin
 Properties* getPropertiesFromNamespacePath(Properties* properties, const std::vector<std::string>& namespacePath);
 
 Properties::Properties()
-    : _variables(NULL), _dirPath(NULL), _parent(NULL)
+    : _variables(NULL), _dirPath(NULL), _parent(NULL), _indexed(false)
 {
 }
 
 Properties::Properties(const Properties& copy)
-    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _variables(NULL), _dirPath(NULL), _parent(copy._parent)
+    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _variables(NULL), _dirPath(NULL), _parent(copy._parent), _indexed(false)
 {
     setDirectoryPath(copy._dirPath);
     _namespaces = std::vector<Properties*>();
@@ -45,14 +61,14 @@ Properties::Properties(const Properties& copy)
 }
 
 Properties::Properties(Stream* stream)
-    : _variables(NULL), _dirPath(NULL), _parent(NULL)
+    : _variables(NULL), _dirPath(NULL), _parent(NULL), _indexed(false)
 {
     readProperties(stream);
     rewind();
 }
 
 Properties::Properties(Stream* stream, const char* name, const char* id, const char* parentID, Properties* parent)
-    : _namespace(name), _variables(NULL), _dirPath(NULL), _parent(parent)
+    : _namespace(name), _variables(NULL), _dirPath(NULL), _parent(parent), _indexed(false)
 {
     if (id)
     {
@@ -80,36 +96,476 @@ Properties* Properties::create(const char* url)
     std::vector<std::string> namespacePath;
     calculateNamespacePath(urlString, fileString, namespacePath);
 
-    std::auto_ptr<Stream> stream(FileSystem::open(fileString.c_str()));
+    // Clone the specified properties object from the parsed file if the file is cached.
+    Properties* p = NULL;
+    {
+        Mutex::Lock lock(__fileCacheMutex);
+        std::map<std::string, Properties*>::const_iterator itr = __fileCache.find(fileString);
+        if (itr != __fileCache.end())
+        {
+            p = getPropertiesFromNamespacePath(itr->second, namespacePath);
+            if (!p)
+            {
+                GP_WARN("Failed to load properties from url '%s'.", url);
+                return NULL;
+            }
+            p = p->clone();
+        }
+    }
+
+    if (p == NULL)
+    {
+        Properties* properties = loadFile(fileString.c_str());
+        if (properties == NULL)
+            return NULL;
+
+        // Get the specified properties object.
+        p = getPropertiesFromNamespacePath(properties, namespacePath);
+        if (!p)
+        {
+            GP_WARN("Failed to load properties from url '%s'.", url);
+            SAFE_DELETE(properties);
+            return NULL;
+        }
+
+        // Keep the parsed file while the file cache is retained, and return a copy of the
+        // specified properties object. Otherwise, if the specified properties object is not
+        // the root namespace, clone it and delete the root namespace so that we don't leak memory.
+        Mutex::Lock lock(__fileCacheMutex);
+        if (__fileCacheRefCount > 0 && __fileCache.find(fileString) == __fileCache.end())
+        {
+            properties->buildIndex();
+            __fileCache[fileString] = properties;
+            p = p->clone();
+        }
+        else if (p != properties)
+        {
+            p = p->clone();
+            SAFE_DELETE(properties);
+        }
+    }
+    p->setDirectoryPath(FileSystem::getDirectoryName(fileString.c_str()));
+    p->buildIndex();
+    return p;
+}
+
+/**
+ * Returns the FNV-1a hash of the specified bytes.
+ */
+static unsigned int hashBytes(const unsigned char* data, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Reads an unsigned int from compiled properties, moving the data pointer past it.
+ */
+static bool readUint(const unsigned char** data, const unsigned char* end, unsigned int* value)
+{
+    if (end - *data < (long)sizeof(unsigned int))
+        return false;
+    memcpy(value, *data, sizeof(unsigned int));
+    *data += sizeof(unsigned int);
+    return true;
+}
+
+/**
+ * Reads an index into the string table of compiled properties.
+ */
+static bool readStringIndex(const unsigned char** data, const unsigned char* end, const std::vector<std::string>& strings, unsigned int* index)
+{
+    return readUint(data, end, index) && *index < strings.size();
+}
+
+/**
+ * Appends an unsigned int to compiled properties.
+ */
+static void writeUint(std::vector<unsigned char>* buffer, unsigned int value)
+{
+    const unsigned char* bytes = (const unsigned char*)&value;
+    buffer->insert(buffer->end(), bytes, bytes + sizeof(unsigned int));
+}
+
+/**
+ * Adds a string to the string table of compiled properties, if it is not already there.
+ */
+static void addBinaryString(std::map<std::string, unsigned int>* indices, std::vector<const std::string*>* strings, const std::string& str)
+{
+    if (indices->find(str) == indices->end())
+    {
+        (*indices)[str] = (unsigned int)strings->size();
+        strings->push_back(&str);
+    }
+}
+
+void Properties::retainFileCache()
+{
+    Mutex::Lock lock(__fileCacheMutex);
+    ++__fileCacheRefCount;
+}
+
+void Properties::releaseFileCache()
+{
+    Mutex::Lock lock(__fileCacheMutex);
+    GP_ASSERT(__fileCacheRefCount > 0);
+    if (--__fileCacheRefCount == 0)
+    {
+        for (std::map<std::string, Properties*>::iterator itr = __fileCache.begin(); itr != __fileCache.end(); ++itr)
+        {
+            SAFE_DELETE(itr->second);
+        }
+        __fileCache.clear();
+    }
+}
+
+Properties* Properties::loadFile(const char* path)
+{
+    std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED));
     if (stream.get() == NULL)
     {
-        GP_WARN("Failed to open file '%s'.", fileString.c_str());
+        GP_WARN("Failed to open file '%s'.", path);
         return NULL;
     }
 
-    Properties* properties = new Properties(stream.get());
-    properties->resolveInheritance();
+    Properties* properties = load(stream.get(), path);
     stream->close();
+    if (properties == NULL)
+    {
+        GP_WARN("Failed to load properties file '%s'.", path);
+        return NULL;
+    }
+    properties->setDirectoryPath(FileSystem::getDirectoryName(path));
+    return properties;
+}
+
+Properties* Properties::loadCachedFile(const char* path)
+{
+    GP_ASSERT(path);
+
+    {
+        Mutex::Lock lock(__fileCacheMutex);
+        GP_ASSERT(__fileCacheRefCount > 0);
+        std::map<std::string, Properties*>::const_iterator itr = __fileCache.find(path);
+        if (itr != __fileCache.end())
+            return itr->second;
+    }
+
+    // Parse the file without holding the lock. If another thread cached the same file
+    // in the meantime, keep that one.
+    Properties* properties = loadFile(path);
+    if (properties == NULL)
+        return NULL;
+    properties->buildIndex();
 
-    // Get the specified properties object.
-    Properties* p = getPropertiesFromNamespacePath(properties, namespacePath);
-    if (!p)
+    Mutex::Lock lock(__fileCacheMutex);
+    std::map<std::string, Properties*>::const_iterator itr = __fileCache.find(path);
+    if (itr != __fileCache.end())
     {
-        GP_WARN("Failed to load properties from url '%s'.", url);
         SAFE_DELETE(properties);
+        return itr->second;
+    }
+    __fileCache[path] = properties;
+    return properties;
+}
+
+Properties* Properties::load(Stream* stream, const char* path)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(path);
+
+    // Compiled files and cached files need the whole contents of the file, which is either
+    // mapped into memory or read at once.
+    size_t length = stream->length();
+    const unsigned char* data = (const unsigned char*)stream->getBuffer();
+    std::vector<unsigned char> contents;
+    if (data == NULL)
+    {
+        unsigned char header[sizeof(PROPERTIES_BINARY_IDENTIFIER)];
+        bool compiled = stream->read(header, 1, sizeof(header)) == sizeof(header) &&
+            memcmp(header, PROPERTIES_BINARY_IDENTIFIER, sizeof(header)) == 0;
+        stream->rewind();
+        if ((compiled || !__cachePath.empty()) && length > 0)
+        {
+            contents.resize(length);
+            if (stream->read(&contents[0], 1, length) != length)
+            {
+                GP_ERROR("Failed to read properties file '%s'.", path);
+                return NULL;
+            }
+            stream->rewind();
+            data = &contents[0];
+        }
+    }
+
+    if (data && length >= sizeof(PROPERTIES_BINARY_IDENTIFIER) &&
+        memcmp(data, PROPERTIES_BINARY_IDENTIFIER, sizeof(PROPERTIES_BINARY_IDENTIFIER)) == 0)
+    {
+        Properties* properties = readBinary(data, length, NULL, NULL);
+        if (properties == NULL)
+        {
+            GP_ERROR("Invalid compiled properties file '%s'.", path);
+        }
+        return properties;
+    }
+
+    if (__cachePath.empty() || data == NULL)
+        return parse(stream);
+
+    // Use the cached copy of the file while the contents of the file are unchanged.
+    unsigned int sourceHash = hashBytes(data, length);
+    char name[16];
+    sprintf(name, "%08x.gpp", hashBytes((const unsigned char*)path, strlen(path)));
+    std::string cacheFile = __cachePath + "/" + name;
+    if (FileSystem::fileExists(cacheFile.c_str()))
+    {
+        std::auto_ptr<Stream> cache(FileSystem::open(cacheFile.c_str(), FileSystem::READ | FileSystem::MAPPED));
+        if (cache.get())
+        {
+            size_t cacheLength = cache->length();
+            const unsigned char* cacheData = (const unsigned char*)cache->getBuffer();
+            std::vector<unsigned char> cacheContents;
+            if (cacheData == NULL && cacheLength > 0)
+            {
+                cacheContents.resize(cacheLength);
+                if (cache->read(&cacheContents[0], 1, cacheLength) == cacheLength)
+                    cacheData = &cacheContents[0];
+            }
+
+            unsigned int cachedLength = 0;
+            unsigned int cachedHash = 0;
+            Properties* properties = cacheData ? readBinary(cacheData, cacheLength, &cachedLength, &cachedHash) : NULL;
+            cache->close();
+            if (properties && cachedLength == (unsigned int)length && cachedHash == sourceHash)
+                return properties;
+            SAFE_DELETE(properties);
+        }
+    }
+
+    Properties* properties = parse(stream);
+    std::auto_ptr<Stream> cache(FileSystem::open(cacheFile.c_str(), FileSystem::WRITE));
+    if (cache.get() == NULL || !properties->writeBinary(cache.get(), (unsigned int)length, sourceHash))
+    {
+        GP_WARN("Failed to write cached properties file '%s'.", cacheFile.c_str());
+    }
+    if (cache.get())
+    {
+        cache->close();
+    }
+    return properties;
+}
+
+Properties* Properties::parse(Stream* stream)
+{
+    Properties* properties = new Properties(stream);
+    properties->resolveInheritance();
+    return properties;
+}
+
+bool Properties::compile(const char* path, const char* outputPath)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(outputPath);
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open file '%s'.", path);
+        return false;
+    }
+    Properties* properties = parse(stream.get());
+    stream->close();
+
+    std::auto_ptr<Stream> output(FileSystem::open(outputPath, FileSystem::WRITE));
+    bool result = output.get() && properties->writeBinary(output.get(), 0, 0);
+    if (!result)
+    {
+        GP_WARN("Failed to write compiled properties file '%s'.", outputPath);
+    }
+    if (output.get())
+    {
+        output->close();
+    }
+    SAFE_DELETE(properties);
+    return result;
+}
+
+const char* Properties::getCachePath()
+{
+    return __cachePath.empty() ? NULL : __cachePath.c_str();
+}
+
+void Properties::setCachePath(const char* path)
+{
+    __cachePath = path ? path : "";
+}
+
+Properties* Properties::readBinary(const unsigned char* data, size_t length, unsigned int* sourceLength, unsigned int* sourceHash)
+{
+    GP_ASSERT(data);
+
+    const unsigned char* end = data + length;
+    size_t headerSize = sizeof(PROPERTIES_BINARY_IDENTIFIER) + 1;
+    if (length < headerSize || memcmp(data, PROPERTIES_BINARY_IDENTIFIER, sizeof(PROPERTIES_BINARY_IDENTIFIER)) != 0 ||
+        data[sizeof(PROPERTIES_BINARY_IDENTIFIER)] != PROPERTIES_BINARY_VERSION)
+    {
+        return NULL;
+    }
+    data += headerSize;
+
+    unsigned int fileLength, fileHash, stringCount;
+    if (!readUint(&data, end, &fileLength) || !readUint(&data, end, &fileHash) || !readUint(&data, end, &stringCount) ||
+        stringCount > (unsigned int)(end - data) / sizeof(unsigned int))
+    {
         return NULL;
     }
 
-    // If the loaded properties object is not the root namespace,
-    // then we have to clone it and delete the root namespace
-    // so that we don't leak memory.
-    if (p != properties)
+    // Read the string table.
+    std::vector<std::string> strings(stringCount);
+    for (unsigned int i = 0; i < stringCount; ++i)
+    {
+        unsigned int stringLength;
+        if (!readUint(&data, end, &stringLength) || stringLength > (unsigned int)(end - data))
+            return NULL;
+        strings[i].assign((const char*)data, stringLength);
+        data += stringLength;
+    }
+
+    Properties* properties = new Properties();
+    if (!properties->readBinaryNamespace(&data, end, strings))
     {
-        p = p->clone();
         SAFE_DELETE(properties);
+        return NULL;
+    }
+
+    if (sourceLength)
+        *sourceLength = fileLength;
+    if (sourceHash)
+        *sourceHash = fileHash;
+    return properties;
+}
+
+bool Properties::readBinaryNamespace(const unsigned char** data, const unsigned char* end, const std::vector<std::string>& strings)
+{
+    unsigned int name, value, count;
+    if (!readStringIndex(data, end, strings, &name) || !readStringIndex(data, end, strings, &value))
+        return false;
+    _namespace = strings[name];
+    _id = strings[value];
+
+    // Properties and variables are stored as pairs of string indices.
+    if (!readUint(data, end, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!readStringIndex(data, end, strings, &name) || !readStringIndex(data, end, strings, &value))
+            return false;
+        _properties.push_back(Property(strings[name].c_str(), strings[value].c_str()));
+    }
+
+    if (!readUint(data, end, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!readStringIndex(data, end, strings, &name) || !readStringIndex(data, end, strings, &value))
+            return false;
+        if (!_variables)
+            _variables = new std::vector<Property>();
+        _variables->push_back(Property(strings[name].c_str(), strings[value].c_str()));
+    }
+
+    if (!readUint(data, end, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Properties* space = new Properties();
+        space->_parent = this;
+        _namespaces.push_back(space);
+        if (!space->readBinaryNamespace(data, end, strings))
+            return false;
+    }
+
+    rewind();
+    return true;
+}
+
+bool Properties::writeBinary(Stream* stream, unsigned int sourceLength, unsigned int sourceHash) const
+{
+    GP_ASSERT(stream);
+
+    std::map<std::string, unsigned int> indices;
+    std::vector<const std::string*> strings;
+    addBinaryStrings(&indices, &strings);
+
+    // Build the whole file in memory to write it at once.
+    std::vector<unsigned char> buffer(PROPERTIES_BINARY_IDENTIFIER, PROPERTIES_BINARY_IDENTIFIER + sizeof(PROPERTIES_BINARY_IDENTIFIER));
+    buffer.push_back(PROPERTIES_BINARY_VERSION);
+    writeUint(&buffer, sourceLength);
+    writeUint(&buffer, sourceHash);
+    writeUint(&buffer, (unsigned int)strings.size());
+    for (size_t i = 0, count = strings.size(); i < count; ++i)
+    {
+        writeUint(&buffer, (unsigned int)strings[i]->size());
+        buffer.insert(buffer.end(), strings[i]->begin(), strings[i]->end());
+    }
+    writeBinaryNamespace(&buffer, indices);
+
+    return stream->write(&buffer[0], 1, buffer.size()) == buffer.size();
+}
+
+void Properties::addBinaryStrings(std::map<std::string, unsigned int>* indices, std::vector<const std::string*>* strings) const
+{
+    addBinaryString(indices, strings, _namespace);
+    addBinaryString(indices, strings, _id);
+    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        addBinaryString(indices, strings, itr->name);
+        addBinaryString(indices, strings, itr->value);
+    }
+    if (_variables)
+    {
+        for (size_t i = 0, count = _variables->size(); i < count; ++i)
+        {
+            addBinaryString(indices, strings, (*_variables)[i].name);
+            addBinaryString(indices, strings, (*_variables)[i].value);
+        }
+    }
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        _namespaces[i]->addBinaryStrings(indices, strings);
+    }
+}
+
+void Properties::writeBinaryNamespace(std::vector<unsigned char>* buffer, const std::map<std::string, unsigned int>& indices) const
+{
+    writeUint(buffer, indices.find(_namespace)->second);
+    writeUint(buffer, indices.find(_id)->second);
+
+    writeUint(buffer, (unsigned int)_properties.size());
+    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        writeUint(buffer, indices.find(itr->name)->second);
+        writeUint(buffer, indices.find(itr->value)->second);
+    }
+
+    unsigned int variableCount = _variables ? (unsigned int)_variables->size() : 0;
+    writeUint(buffer, variableCount);
+    for (unsigned int i = 0; i < variableCount; ++i)
+    {
+        writeUint(buffer, indices.find((*_variables)[i].name)->second);
+        writeUint(buffer, indices.find((*_variables)[i].value)->second);
+    }
+
+    writeUint(buffer, (unsigned int)_namespaces.size());
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        _namespaces[i]->writeBinaryNamespace(buffer, indices);
     }
-    p->setDirectoryPath(FileSystem::getDirectoryName(fileString.c_str()));
-    return p;
 }
 
 static bool isVariable(const char* str, char* outName, size_t outSize)
@@ -597,10 +1053,184 @@ void Properties::rewind()
     _namespacesItr = _namespaces.end();
 }
 
+/**
+ * Returns the name or ID of a namespace, which is its key in a namespace lookup table.
+ */
+static const char* getNamespaceKey(const Properties* properties, bool searchNames)
+{
+    return searchNames ? properties->getNamespace() : properties->getId();
+}
+
+/**
+ * Returns the size of a lookup table for the specified number of entries.
+ *
+ * Tables are a power of two in size and at most half full, so that probe sequences stay short.
+ */
+static size_t getIndexSize(size_t count)
+{
+    size_t size = 1;
+    while (size < count * 2)
+        size <<= 1;
+    return size;
+}
+
+/**
+ * Adds a namespace to a lookup table, unless an earlier namespace already has the same key.
+ */
+static void indexNamespace(std::vector<Properties*>* index, Properties* properties, bool searchNames, unsigned int hash)
+{
+    const char* key = getNamespaceKey(properties, searchNames);
+    size_t mask = index->size() - 1;
+    size_t slot = hash & mask;
+    while ((*index)[slot])
+    {
+        if (strcmp(getNamespaceKey((*index)[slot], searchNames), key) == 0)
+            return;
+        slot = (slot + 1) & mask;
+    }
+    (*index)[slot] = properties;
+}
+
+/**
+ * Returns the namespace with the specified key in a lookup table, or NULL.
+ */
+static Properties* findIndexedNamespace(const std::vector<Properties*>& index, const char* id, bool searchNames, unsigned int hash)
+{
+    size_t mask = index.size() - 1;
+    for (size_t slot = hash & mask; index[slot]; slot = (slot + 1) & mask)
+    {
+        if (strcmp(getNamespaceKey(index[slot], searchNames), id) == 0)
+            return index[slot];
+    }
+    return NULL;
+}
+
+unsigned int Properties::hashName(const char* name)
+{
+    GP_ASSERT(name);
+    return hashBytes((const unsigned char*)name, strlen(name));
+}
+
+void Properties::buildIndex()
+{
+    _indexed = true;
+    indexProperties();
+
+    // Nested namespaces are indexed by name and by ID, both among the direct children and
+    // among all descendants in the order that recursive searches visit them.
+    _childNameIndex.clear();
+    _childIdIndex.clear();
+    if (_namespaces.size() >= PROPERTIES_INDEX_MIN_SIZE)
+    {
+        _childNameIndex.resize(getIndexSize(_namespaces.size()), NULL);
+        _childIdIndex.resize(_childNameIndex.size(), NULL);
+        indexNamespaces(&_childNameIndex, &_childIdIndex, false);
+    }
+    _descendantNameIndex.clear();
+    _descendantIdIndex.clear();
+    size_t descendantCount = getNamespaceCount(true);
+    if (descendantCount >= PROPERTIES_INDEX_MIN_SIZE)
+    {
+        _descendantNameIndex.resize(getIndexSize(descendantCount), NULL);
+        _descendantIdIndex.resize(_descendantNameIndex.size(), NULL);
+        indexNamespaces(&_descendantNameIndex, &_descendantIdIndex, true);
+    }
+
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        _namespaces[i]->buildIndex();
+    }
+}
+
+void Properties::indexProperties()
+{
+    _propertyIndex.clear();
+    size_t count = 0;
+    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        ++count;
+    }
+    if (count < PROPERTIES_INDEX_MIN_SIZE)
+        return;
+
+    // Only the first property of each name is indexed, since lookups return the first match.
+    _propertyIndex.resize(getIndexSize(count), NULL);
+    size_t mask = _propertyIndex.size() - 1;
+    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        size_t slot = itr->hash & mask;
+        while (_propertyIndex[slot] && _propertyIndex[slot]->name != itr->name)
+        {
+            slot = (slot + 1) & mask;
+        }
+        if (_propertyIndex[slot] == NULL)
+        {
+            _propertyIndex[slot] = &(*itr);
+        }
+    }
+}
+
+void Properties::indexNamespaces(std::vector<Properties*>* names, std::vector<Properties*>* ids, bool recurse) const
+{
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        Properties* space = _namespaces[i];
+        indexNamespace(names, space, true, hashName(space->_namespace.c_str()));
+        indexNamespace(ids, space, false, hashName(space->_id.c_str()));
+        if (recurse)
+        {
+            space->indexNamespaces(names, ids, true);
+        }
+    }
+}
+
+size_t Properties::getNamespaceCount(bool recurse) const
+{
+    size_t count = _namespaces.size();
+    if (recurse)
+    {
+        for (size_t i = 0, childCount = _namespaces.size(); i < childCount; ++i)
+        {
+            count += _namespaces[i]->getNamespaceCount(true);
+        }
+    }
+    return count;
+}
+
+const Properties::Property* Properties::findProperty(const char* name) const
+{
+    GP_ASSERT(name);
+
+    unsigned int hash = hashName(name);
+    if (_propertyIndex.empty())
+    {
+        for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+        {
+            if (itr->hash == hash && itr->name == name)
+                return &(*itr);
+        }
+        return NULL;
+    }
+
+    size_t mask = _propertyIndex.size() - 1;
+    for (size_t slot = hash & mask; _propertyIndex[slot]; slot = (slot + 1) & mask)
+    {
+        const Property* property = _propertyIndex[slot];
+        if (property->hash == hash && property->name == name)
+            return property;
+    }
+    return NULL;
+}
+
 Properties* Properties::getNamespace(const char* id, bool searchNames, bool recurse) const
 {
     GP_ASSERT(id);
 
+    const std::vector<Properties*>& index = recurse ? (searchNames ? _descendantNameIndex : _descendantIdIndex) :
+                                                      (searchNames ? _childNameIndex : _childIdIndex);
+    if (!index.empty())
+        return findIndexedNamespace(index, id, searchNames, hashName(id));
+
     for (std::vector<Properties*>::const_iterator it = _namespaces.begin(); it < _namespaces.end(); ++it)
     {
         Properties* p = *it;
@@ -634,13 +1264,7 @@ bool Properties::exists(const char* name) const
     if (name == NULL)
         return false;
 
-    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
-    {
-        if (itr->name == name)
-            return true;
-    }
-
-    return false;
+    return findProperty(name) != NULL;
 }
 
 static const bool isStringNumeric(const char* str)
@@ -724,13 +1348,10 @@ const char* Properties::getString(const char* name, const char* defaultValue) co
             return getVariable(variable, defaultValue);
         }
 
-        for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+        const Property* property = findProperty(name);
+        if (property)
         {
-            if (itr->name == name)
-            {
-                value = itr->value.c_str();
-                break;
-            }
+            value = property->value.c_str();
         }
     }
     else
@@ -758,18 +1379,20 @@ bool Properties::setString(const char* name, const char* value)
 {
     if (name)
     {
-        for (std::list<Property>::iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+        // Update the first property that matches this name
+        Property* property = const_cast<Property*>(findProperty(name));
+        if (property)
         {
-            if (itr->name == name)
-            {
-                // Update the first property that matches this name
-                itr->value = value ? value : "";
-                return true;
-            }
+            property->value = value ? value : "";
+            return true;
         }
 
         // There is no property with this name, so add one
         _properties.push_back(Property(name, value ? value : ""));
+        if (_indexed)
+        {
+            indexProperties();
+        }
     }
     else
     {
@@ -1076,43 +1699,18 @@ Properties* getPropertiesFromNamespacePath(Properties* properties, const std::ve
 {
     // If the url references a specific namespace within the file,
     // return the specified namespace or notify the user if it cannot be found.
-    if (namespacePath.size() > 0)
+    // The namespace iterators are left untouched, since the file may be shared
+    // through the file cache.
+    for (size_t i = 0, size = namespacePath.size(); i < size; ++i)
     {
-        size_t size = namespacePath.size();
-        properties->rewind();
-        Properties* iter = properties->getNextNamespace();
-        for (size_t i = 0; i < size; )
+        properties = properties->getNamespace(namespacePath[i].c_str(), false, false);
+        if (properties == NULL)
         {
-            while (true)
-            {
-                if (iter == NULL)
-                {
-                    GP_WARN("Failed to load properties object from url.");
-                    return NULL;
-                }
-
-                if (strcmp(iter->getId(), namespacePath[i].c_str()) == 0)
-                {
-                    if (i != size - 1)
-                    {
-                        properties = iter->getNextNamespace();
-                        iter = properties;
-                    }
-                    else
-                        properties = iter;
-
-                    i++;
-                    break;
-                }
-                
-                iter = properties->getNextNamespace();
-            }
+            GP_WARN("Failed to load properties object from url.");
+            return NULL;
         }
-
-        return properties;
     }
-    else
-        return properties;
+    return properties;
 }
 
 bool Properties::parseVector2(const char* str, Vector2* out)
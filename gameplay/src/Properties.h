@@ -126,6 +126,7 @@ class Properties;
 class Properties
 {
     friend class Game;
+    friend class SceneLoader;
 
 public:
 
@@ -155,6 +156,67 @@ public:
      */
     static Properties* create(const char* url);
 
+    /**
+     * Compiles a properties file into the binary properties format.
+     *
+     * A compiled file contains the namespaces and properties of the source file with their
+     * inheritance already resolved and their strings stored once in a string table, so it is
+     * loaded with a single read and no parsing. create() recognizes compiled files by their
+     * header, so a compiled file can be shipped in place of the text file with the same name.
+     *
+     * @param path The path of the text properties file to compile.
+     * @param outputPath The path of the compiled file to write.
+     *
+     * @return True if the file was compiled, false if an error occurred.
+     * @script{ignore}
+     */
+    static bool compile(const char* path, const char* outputPath);
+
+    /**
+     * Returns the directory where text properties files are cached in the binary format.
+     *
+     * @return The cache directory, or NULL if caching is disabled.
+     * @script{ignore}
+     */
+    static const char* getCachePath();
+
+    /**
+     * Sets the directory where text properties files are cached in the binary format.
+     *
+     * When set, the first load of a text properties file writes its compiled form to the cache
+     * directory, and later loads read the compiled form instead of parsing the text. A cached file
+     * is used only while the contents of its source file are unchanged. The directory must exist
+     * and be writable. Caching can also be enabled by the 'cachePath' property in the 'properties'
+     * section of the game configuration file.
+     *
+     * @param path The cache directory, or NULL to disable caching.
+     * @script{ignore}
+     */
+    static void setCachePath(const char* path);
+
+    /**
+     * Starts keeping the properties files loaded by create() parsed in memory.
+     *
+     * While the file cache is retained, each properties file is parsed only the first time
+     * create() loads it, and later calls clone the requested namespace from the parsed file.
+     * This avoids parsing a shared file, such as a material file with many namespaces, once
+     * for every reference to it. SceneLoader retains the cache for the duration of each
+     * scene load.
+     *
+     * Calls can be nested. The cached files are freed when releaseFileCache() has been called
+     * as many times as this method.
+     *
+     * @script{ignore}
+     */
+    static void retainFileCache();
+
+    /**
+     * Releases the file cache retained by retainFileCache().
+     *
+     * @script{ignore}
+     */
+    static void releaseFileCache();
+
     /**
      * Destructor.
      */
@@ -515,7 +577,8 @@ private:
     {
         std::string name;
         std::string value;
-        Property(const char* name, const char* value) : name(name), value(value) { }
+        unsigned int hash;
+        Property(const char* name, const char* value) : name(name), value(value), hash(hashName(name)) { }
     };
 
     /**
@@ -554,6 +617,51 @@ private:
     void setDirectoryPath(const std::string* path);
     void setDirectoryPath(const std::string& path);
 
+    // Opens and loads a properties file.
+    static Properties* loadFile(const char* path);
+
+    // Returns a file from the retained file cache, loading it if it is not cached yet.
+    static Properties* loadCachedFile(const char* path);
+
+    // Loads the properties from an opened file, which is either text or compiled.
+    static Properties* load(Stream* stream, const char* path);
+
+    // Parses text properties and resolves their inheritance.
+    static Properties* parse(Stream* stream);
+
+    // Reads compiled properties from memory, along with the length and hash of their source file.
+    static Properties* readBinary(const unsigned char* data, size_t length, unsigned int* sourceLength, unsigned int* sourceHash);
+
+    // Reads a namespace of compiled properties and its nested namespaces.
+    bool readBinaryNamespace(const unsigned char** data, const unsigned char* end, const std::vector<std::string>& strings);
+
+    // Writes compiled properties, along with the length and hash of their source file.
+    bool writeBinary(Stream* stream, unsigned int sourceLength, unsigned int sourceHash) const;
+
+    // Gathers the strings of this namespace and its nested namespaces into a string table.
+    void addBinaryStrings(std::map<std::string, unsigned int>* indices, std::vector<const std::string*>* strings) const;
+
+    // Appends a namespace of compiled properties and its nested namespaces to a buffer.
+    void writeBinaryNamespace(std::vector<unsigned char>* buffer, const std::map<std::string, unsigned int>& indices) const;
+
+    // Returns the hash of a property or namespace name.
+    static unsigned int hashName(const char* name);
+
+    // Builds the lookup tables of this namespace and its nested namespaces.
+    void buildIndex();
+
+    // Rebuilds the lookup table of the properties of this namespace.
+    void indexProperties();
+
+    // Adds the nested namespaces of this namespace to lookup tables by name and by ID.
+    void indexNamespaces(std::vector<Properties*>* names, std::vector<Properties*>* ids, bool recurse) const;
+
+    // Returns the number of nested namespaces, optionally including their nested namespaces.
+    size_t getNamespaceCount(bool recurse) const;
+
+    // Returns the first property with the specified name, or NULL.
+    const Property* findProperty(const char* name) const;
+
     std::string _namespace;
     std::string _id;
     std::string _parentID;
@@ -564,6 +672,12 @@ private:
     std::vector<Property>* _variables;
     std::string* _dirPath;
     Properties* _parent;
+    bool _indexed;
+    std::vector<const Property*> _propertyIndex;
+    std::vector<Properties*> _childNameIndex;
+    std::vector<Properties*> _childIdIndex;
+    std::vector<Properties*> _descendantNameIndex;
+    std::vector<Properties*> _descendantIdIndex;
 };
 
 }
@@ -1,6 +1,10 @@
 #include "Base.h"
 #include "Quaternion.h"
 
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace gameplay
 {
 
@@ -271,6 +275,93 @@ void Quaternion::slerp(const Quaternion& q1, const Quaternion& q2, float t, Quat
     slerp(q1.x, q1.y, q1.z, q1.w, q2.x, q2.y, q2.z, q2.w, t, &dst->x, &dst->y, &dst->z, &dst->w);
 }
 
+void Quaternion::nlerp(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst)
+{
+    GP_ASSERT(dst);
+    nlerp(q1.x, q1.y, q1.z, q1.w, q2.x, q2.y, q2.z, q2.w, t, &dst->x, &dst->y, &dst->z, &dst->w);
+}
+
+void Quaternion::nlerp(const float* q1, const float* q2, const float* t, float* dst, unsigned int count)
+{
+    GP_ASSERT((q1 && q2 && t && dst) || count == 0);
+
+    unsigned int i = 0;
+#if defined(USE_SSE)
+    __m128 zero = _mm_setzero_ps();
+    __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        // Transpose four quaternions into vectors of each component.
+        __m128 x1 = _mm_loadu_ps(q1 + i * 4), y1 = _mm_loadu_ps(q1 + i * 4 + 4), z1 = _mm_loadu_ps(q1 + i * 4 + 8), w1 = _mm_loadu_ps(q1 + i * 4 + 12);
+        __m128 x2 = _mm_loadu_ps(q2 + i * 4), y2 = _mm_loadu_ps(q2 + i * 4 + 4), z2 = _mm_loadu_ps(q2 + i * 4 + 8), w2 = _mm_loadu_ps(q2 + i * 4 + 12);
+        _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+        _MM_TRANSPOSE4_PS(x2, y2, z2, w2);
+        __m128 s = _mm_loadu_ps(t + i);
+
+        // Interpolate along the shorter arc.
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, x2), _mm_mul_ps(y1, y2)), _mm_add_ps(_mm_mul_ps(z1, z2), _mm_mul_ps(w1, w2)));
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit);
+        __m128 x = _mm_add_ps(x1, _mm_mul_ps(s, _mm_sub_ps(_mm_xor_ps(x2, flip), x1)));
+        __m128 y = _mm_add_ps(y1, _mm_mul_ps(s, _mm_sub_ps(_mm_xor_ps(y2, flip), y1)));
+        __m128 z = _mm_add_ps(z1, _mm_mul_ps(s, _mm_sub_ps(_mm_xor_ps(z2, flip), z1)));
+        __m128 w = _mm_add_ps(w1, _mm_mul_ps(s, _mm_sub_ps(_mm_xor_ps(w2, flip), w1)));
+
+        __m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        n = _mm_div_ps(one, _mm_sqrt_ps(n));
+        x = _mm_mul_ps(x, n);
+        y = _mm_mul_ps(y, n);
+        z = _mm_mul_ps(z, n);
+        w = _mm_mul_ps(w, n);
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(dst + i * 4, x);
+        _mm_storeu_ps(dst + i * 4 + 4, y);
+        _mm_storeu_ps(dst + i * 4 + 8, z);
+        _mm_storeu_ps(dst + i * 4 + 12, w);
+    }
+#elif defined(USE_NEON)
+    uint32x4_t signBit = vdupq_n_u32(0x80000000);
+    for (; i + 4 <= count; i += 4)
+    {
+        // Load four quaternions deinterleaved into vectors of each component.
+        float32x4x4_t a = vld4q_f32(q1 + i * 4);
+        float32x4x4_t b = vld4q_f32(q2 + i * 4);
+        float32x4_t s = vld1q_f32(t + i);
+
+        // Interpolate along the shorter arc.
+        float32x4_t dot = vmlaq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(a.val[0], b.val[0]), a.val[1], b.val[1]), a.val[2], b.val[2]), a.val[3], b.val[3]);
+        uint32x4_t flip = vandq_u32(vcltq_f32(dot, vdupq_n_f32(0.0f)), signBit);
+        float32x4_t n = vdupq_n_f32(0.0f);
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            float32x4_t c = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(b.val[j]), flip));
+            a.val[j] = vmlaq_f32(a.val[j], s, vsubq_f32(c, a.val[j]));
+            n = vmlaq_f32(n, a.val[j], a.val[j]);
+        }
+
+        // Refine the reciprocal square root estimate with two Newton-Raphson steps.
+        float32x4_t r = vrsqrteq_f32(n);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(n, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(n, r), r));
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            a.val[j] = vmulq_f32(a.val[j], r);
+        }
+        vst4q_f32(dst + i * 4, a);
+    }
+#endif
+
+    // Remaining quaternions.
+    for (; i < count; ++i)
+    {
+        const float* a = q1 + i * 4;
+        const float* b = q2 + i * 4;
+        float* d = dst + i * 4;
+        nlerp(a[0], a[1], a[2], a[3], b[0], b[1], b[2], b[3], t[i], d, d + 1, d + 2, d + 3);
+    }
+}
+
 void Quaternion::squad(const Quaternion& q1, const Quaternion& q2, const Quaternion& s1, const Quaternion& s2, float t, Quaternion* dst)
 {
     GP_ASSERT(!(t < 0.0f || t > 1.0f));
@@ -382,6 +473,40 @@ void Quaternion::slerp(float q1x, float q1y, float q1z, float q1w, float q2x, fl
     *dstz = z * f1;
 }
 
+void Quaternion::nlerp(float q1x, float q1y, float q1z, float q1w, float q2x, float q2y, float q2z, float q2w, float t, float* dstx, float* dsty, float* dstz, float* dstw)
+{
+    GP_ASSERT(dstx && dsty && dstz && dstw);
+
+    // Interpolate along the shorter arc.
+    if (q1x * q2x + q1y * q2y + q1z * q2z + q1w * q2w < 0.0f)
+    {
+        q2x = -q2x;
+        q2y = -q2y;
+        q2z = -q2z;
+        q2w = -q2w;
+    }
+
+    float x = q1x + t * (q2x - q1x);
+    float y = q1y + t * (q2y - q1y);
+    float z = q1z + t * (q2z - q1z);
+    float w = q1w + t * (q2w - q1w);
+
+    float n = x * x + y * y + z * z + w * w;
+    if (n > 0.0f)
+    {
+        n = 1.0f / sqrt(n);
+        x *= n;
+        y *= n;
+        z *= n;
+        w *= n;
+    }
+
+    *dstx = x;
+    *dsty = y;
+    *dstz = z;
+    *dstw = w;
+}
+
 void Quaternion::slerpForSquad(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst)
 {
     GP_ASSERT(dst);
@@ -314,6 +314,36 @@ public:
      */
     static void slerp(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst);
     
+    /**
+     * Interpolates between two quaternions using normalized linear interpolation.
+     *
+     * The quaternions are interpolated linearly along the shorter arc and the result is
+     * normalized. It rotates at a slightly uneven rate compared to slerp, which cannot be
+     * seen between closely spaced keyframes or when blending, and costs a fraction of it.
+     *
+     * @param q1 The first quaternion.
+     * @param q2 The second quaternion.
+     * @param t The interpolation coefficient.
+     * @param dst A quaternion to store the result in.
+     */
+    static void nlerp(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst);
+
+    /**
+     * Interpolates between each pair of quaternions of two arrays using normalized linear interpolation.
+     *
+     * The quaternions are stored as four consecutive floats (x, y, z, w). Four pairs are
+     * interpolated at a time where SIMD is available. The destination may be either source.
+     * The quaternions must be at (or close to) unit length.
+     *
+     * @param q1 The first quaternions.
+     * @param q2 The second quaternions.
+     * @param t The interpolation coefficient of each pair.
+     * @param dst The array to store the results in.
+     * @param count The number of pairs to interpolate.
+     * @script{ignore}
+     */
+    static void nlerp(const float* q1, const float* q2, const float* t, float* dst, unsigned int count);
+
     /**
      * Interpolates over a series of quaternions using spherical spline interpolation.
      *
@@ -379,6 +409,25 @@ private:
      */
     static void slerp(float q1x, float q1y, float q1z, float q1w, float q2x, float q2y, float q2z, float q2w, float t, float* dstx, float* dsty, float* dstz, float* dstw);
 
+    /**
+     * Interpolates between two quaternions using normalized linear interpolation.
+     *
+     * @param q1x The x component of the first quaternion.
+     * @param q1y The y component of the first quaternion.
+     * @param q1z The z component of the first quaternion.
+     * @param q1w The w component of the first quaternion.
+     * @param q2x The x component of the second quaternion.
+     * @param q2y The y component of the second quaternion.
+     * @param q2z The z component of the second quaternion.
+     * @param q2w The w component of the second quaternion.
+     * @param t The interpolation coefficient.
+     * @param dstx A pointer to store the x component of the nlerp in.
+     * @param dsty A pointer to store the y component of the nlerp in.
+     * @param dstz A pointer to store the z component of the nlerp in.
+     * @param dstw A pointer to store the w component of the nlerp in.
+     */
+    static void nlerp(float q1x, float q1y, float q1z, float q1w, float q2x, float q2y, float q2z, float q2w, float t, float* dstx, float* dsty, float* dstz, float* dstw);
+
     static void slerpForSquad(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst);
 };
 
@@ -1,6 +1,7 @@
 #include "Base.h"
 #include "Ref.h"
 #include "Game.h"
+#include "Thread.h"
 
 namespace gameplay
 {
@@ -32,12 +33,40 @@ Ref::~Ref()
 
 void Ref::addRef()
 {
+#ifdef GP_NO_ATOMIC_REF_COUNT
     ++_refCount;
+#else
+    Atomic::increment(&_refCount);
+#endif
+}
+
+bool Ref::tryAddRef()
+{
+#ifdef GP_NO_ATOMIC_REF_COUNT
+    if (_refCount == 0)
+        return false;
+    ++_refCount;
+    return true;
+#else
+    unsigned int count = _refCount;
+    while (count != 0)
+    {
+        unsigned int previous = Atomic::compareExchange(&_refCount, count, count + 1);
+        if (previous == count)
+            return true;
+        count = previous;
+    }
+    return false;
+#endif
 }
 
 void Ref::release()
 {
-    if ((--_refCount) <= 0)
+#ifdef GP_NO_ATOMIC_REF_COUNT
+    if ((--_refCount) == 0)
+#else
+    if (Atomic::decrement(&_refCount) == 0)
+#endif
     {
 #ifdef GP_USE_MEM_LEAK_DETECTION
         untrackRef(this, __record);
@@ -62,9 +91,12 @@ struct RefAllocationRecord
 
 RefAllocationRecord* __refAllocations = 0;
 int __refAllocationCount = 0;
+static Mutex __refAllocationMutex;
 
 void Ref::printLeaks()
 {
+    Mutex::Lock lock(__refAllocationMutex);
+
     // Dump Ref object memory leaks
     if (__refAllocationCount == 0)
     {
@@ -90,9 +122,10 @@ void* trackRef(Ref* ref)
     // Create memory allocation record.
     RefAllocationRecord* rec = (RefAllocationRecord*)malloc(sizeof(RefAllocationRecord));
     rec->ref = ref;
+
+    Mutex::Lock lock(__refAllocationMutex);
     rec->next = __refAllocations;
     rec->prev = 0;
-
     if (__refAllocations)
         __refAllocations->prev = rec;
     __refAllocations = rec;
@@ -117,6 +150,7 @@ void untrackRef(Ref* ref, void* record)
     }
 
     // Link this item out.
+    Mutex::Lock lock(__refAllocationMutex);
     if (__refAllocations == rec)
         __refAllocations = rec->next;
     if (rec->prev)
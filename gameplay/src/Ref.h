@@ -13,6 +13,10 @@ namespace gameplay
  * reference counting eliminates the need for programmers to manually
  * keep track of object ownership and having to worry about when to
  * safely delete such objects.
+ *
+ * The reference count is changed atomically, so references to an object can be
+ * added and released from several threads at once. Single-threaded builds can
+ * define GP_NO_ATOMIC_REF_COUNT to use plain increments and decrements instead.
  */
 class Ref
 {
@@ -62,9 +66,19 @@ protected:
      */
     virtual ~Ref();
 
+    /**
+     * Increments the reference count of this object, unless it already reached zero.
+     *
+     * Caches that hand out the objects they hold use this to avoid returning an object
+     * that another thread has released and is destroying while it is still in the cache.
+     *
+     * @return true if a reference was added, false if the object is being destroyed.
+     */
+    bool tryAddRef();
+
 private:
 
-    unsigned int _refCount;
+    volatile unsigned int _refCount;
 
     // Memory leak diagnostic data (only included when GP_USE_MEM_LEAK_DETECTION is defined)
 #ifdef GP_USE_MEM_LEAK_DETECTION
@@ -0,0 +1,310 @@
+#include "Base.h"
+#include "ReflectionProbe.h"
+#include "Game.h"
+#include "Scene.h"
+#include "SceneView.h"
+#include "FrameBuffer.h"
+#include "Model.h"
+#include "Material.h"
+
+// The distances of the near and far planes of the cameras of the faces, by default.
+#define REFLECTION_PROBE_NEAR_PLANE 0.1f
+#define REFLECTION_PROBE_FAR_PLANE 1000.0f
+
+// The radius of influence of a probe, by default.
+#define REFLECTION_PROBE_RADIUS 100.0f
+
+// The faces of a cube map, as a bit each.
+#define REFLECTION_PROBE_ALL_FACES 0x3F
+
+namespace gameplay
+{
+
+static std::vector<ReflectionProbe*> __probes;
+static unsigned int __probeCount = 0;
+
+// The directions the cameras of the faces look at, and their up vectors. The up vectors point
+// down the cube map's t axis, so that the rows the frame buffers draw bottom-up match its texels.
+static const Vector3 __faceDirections[6] =
+{
+    Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0), Vector3(0, 0, 1), Vector3(0, 0, -1)
+};
+static const Vector3 __faceUps[6] =
+{
+    Vector3(0, -1, 0), Vector3(0, -1, 0), Vector3(0, 0, 1), Vector3(0, 0, -1), Vector3(0, -1, 0), Vector3(0, -1, 0)
+};
+
+ReflectionProbe::ReflectionProbe(Node* node)
+    : _node(node), _size(0), _updateMode(UPDATE_ON_DEMAND), _radius(REFLECTION_PROBE_RADIUS), _clearColor(0, 0, 0, 1),
+      _texture(NULL), _sampler(NULL), _dirtyFaces(REFLECTION_PROBE_ALL_FACES), _nextFace(0)
+{
+    GP_ASSERT(node);
+    _node->addRef();
+    memset(_frameBuffers, 0, sizeof(_frameBuffers));
+    memset(_cameraNodes, 0, sizeof(_cameraNodes));
+    memset(_views, 0, sizeof(_views));
+    __probes.push_back(this);
+}
+
+ReflectionProbe::~ReflectionProbe()
+{
+    std::vector<ReflectionProbe*>::iterator itr = std::find(__probes.begin(), __probes.end(), this);
+    if (itr != __probes.end())
+        __probes.erase(itr);
+
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        SAFE_RELEASE(_views[i]);
+        SAFE_RELEASE(_cameraNodes[i]);
+        SAFE_RELEASE(_frameBuffers[i]);
+    }
+    SAFE_RELEASE(_sampler);
+    SAFE_RELEASE(_texture);
+    SAFE_RELEASE(_node);
+}
+
+ReflectionProbe* ReflectionProbe::create(Node* node, unsigned int size)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(size > 0);
+
+    Texture* texture = Texture::createCube(Texture::RGBA, size);
+    if (texture == NULL)
+    {
+        GP_WARN("Failed to create the cube map of a reflection probe.");
+        return NULL;
+    }
+
+    ReflectionProbe* probe = new ReflectionProbe(node);
+    probe->_size = size;
+    probe->_texture = texture;
+    probe->_sampler = Texture::Sampler::create(texture);
+    probe->_sampler->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    probe->_sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+
+    // The faces share a depth buffer, since they are drawn one after the other.
+    char id[48];
+    sprintf(id, "__reflectionProbe%u", ++__probeCount);
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(id, DepthStencilTarget::DEPTH, size, size);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        sprintf(id, "__reflectionProbe%u_%u", __probeCount, i);
+        RenderTarget* renderTarget = RenderTarget::create(id, texture, i);
+        FrameBuffer* frameBuffer = FrameBuffer::create(id);
+        if (renderTarget == NULL || frameBuffer == NULL)
+        {
+            SAFE_RELEASE(renderTarget);
+            SAFE_RELEASE(frameBuffer);
+            SAFE_RELEASE(depthTarget);
+            SAFE_RELEASE(probe);
+            GP_WARN("Failed to create the frame buffers of a reflection probe.");
+            return NULL;
+        }
+        frameBuffer->setRenderTarget(renderTarget);
+        if (depthTarget)
+            frameBuffer->setDepthStencilTarget(depthTarget);
+        SAFE_RELEASE(renderTarget);
+        probe->_frameBuffers[i] = frameBuffer;
+
+        Camera* camera = Camera::createPerspective(90.0f, 1.0f, REFLECTION_PROBE_NEAR_PLANE, REFLECTION_PROBE_FAR_PLANE);
+        probe->_cameraNodes[i] = Node::create(id);
+        probe->_cameraNodes[i]->setCamera(camera);
+        probe->_views[i] = SceneView::create(camera);
+        SAFE_RELEASE(camera);
+    }
+    SAFE_RELEASE(depthTarget);
+
+    return probe;
+}
+
+ReflectionProbe* ReflectionProbe::select(const Vector3& position, Scene* scene)
+{
+    ReflectionProbe* nearest = NULL;
+    float nearestDistance = 0.0f;
+    bool nearestInside = false;
+    for (size_t i = 0, count = __probes.size(); i < count; ++i)
+    {
+        ReflectionProbe* probe = __probes[i];
+        if (scene && probe->_node->getScene() != scene)
+            continue;
+
+        float distance = position.distanceSquared(probe->_node->getTranslationWorld());
+        bool inside = distance <= probe->_radius * probe->_radius;
+        if (nearest == NULL || (inside && !nearestInside) || (inside == nearestInside && distance < nearestDistance))
+        {
+            nearest = probe;
+            nearestDistance = distance;
+            nearestInside = inside;
+        }
+    }
+    return nearest;
+}
+
+ReflectionProbe* ReflectionProbe::bindNearest(Node* node)
+{
+    GP_ASSERT(node);
+
+    Model* model = node->getModel();
+    Scene* scene = node->getScene();
+    if (model == NULL || scene == NULL)
+        return NULL;
+
+    ReflectionProbe* probe = select(node->getTranslationWorld(), scene);
+    if (probe)
+    {
+        if (model->getMaterial())
+            probe->bind(model->getMaterial());
+        for (unsigned int i = 0, count = model->getMeshPartCount(); i < count; ++i)
+        {
+            if (model->hasMaterial(i))
+                probe->bind(model->getMaterial(i));
+        }
+    }
+    return probe;
+}
+
+Node* ReflectionProbe::getNode() const
+{
+    return _node;
+}
+
+Texture* ReflectionProbe::getTexture() const
+{
+    return _texture;
+}
+
+void ReflectionProbe::setUpdateMode(UpdateMode mode)
+{
+    _updateMode = mode;
+}
+
+ReflectionProbe::UpdateMode ReflectionProbe::getUpdateMode() const
+{
+    return _updateMode;
+}
+
+void ReflectionProbe::setRadius(float radius)
+{
+    _radius = radius;
+}
+
+float ReflectionProbe::getRadius() const
+{
+    return _radius;
+}
+
+void ReflectionProbe::setClipPlanes(float nearPlane, float farPlane)
+{
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        Camera* camera = _cameraNodes[i]->getCamera();
+        camera->setNearPlane(nearPlane);
+        camera->setFarPlane(farPlane);
+    }
+    _dirtyFaces = REFLECTION_PROBE_ALL_FACES;
+}
+
+void ReflectionProbe::setClearColor(const Vector4& color)
+{
+    _clearColor = color;
+    _dirtyFaces = REFLECTION_PROBE_ALL_FACES;
+}
+
+void ReflectionProbe::invalidate()
+{
+    _dirtyFaces = REFLECTION_PROBE_ALL_FACES;
+}
+
+unsigned int ReflectionProbe::update(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    // Pick the faces due this update. Invalidated faces are all rendered at once.
+    unsigned int faces = _dirtyFaces;
+    if (faces == 0)
+    {
+        switch (_updateMode)
+        {
+        case UPDATE_TIME_SLICED:
+            faces = 1u << _nextFace;
+            _nextFace = (_nextFace + 1) % 6;
+            break;
+        case UPDATE_EVERY_FRAME:
+            faces = REFLECTION_PROBE_ALL_FACES;
+            break;
+        default:
+            return 0;
+        }
+    }
+
+    // Cull the faces together, or reuse their queues if nothing moved since they were culled.
+    updateCameras();
+    SceneView* views[6];
+    unsigned int viewCount = 0;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        if (faces & (1u << i))
+            views[viewCount++] = _views[i];
+    }
+    scene->cull(views, viewCount);
+
+    Game* game = Game::getInstance();
+    Camera* previousCamera = scene->getActiveCamera();
+    if (previousCamera)
+        previousCamera->addRef();
+    FrameBuffer* previousFrameBuffer = FrameBuffer::getCurrent();
+    Rectangle previousViewport = game->getViewport();
+    game->setViewport(Rectangle(0, 0, (float)_size, (float)_size));
+
+    unsigned int rendered = 0;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        if (faces & (1u << i))
+        {
+            renderFace(scene, i);
+            ++rendered;
+        }
+    }
+    _dirtyFaces = 0;
+
+    game->setViewport(previousViewport);
+    previousFrameBuffer->bind();
+    scene->setActiveCamera(previousCamera);
+    SAFE_RELEASE(previousCamera);
+
+    return rendered;
+}
+
+void ReflectionProbe::bind(RenderState* renderState)
+{
+    GP_ASSERT(renderState);
+
+    renderState->getParameter("u_reflectionTexture")->setValue(_sampler);
+}
+
+void ReflectionProbe::updateCameras()
+{
+    Vector3 position = _node->getTranslationWorld();
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        // The camera's world matrix is the inverse of the view matrix looking down the face.
+        Matrix view;
+        Matrix::createLookAt(position, position + __faceDirections[i], __faceUps[i], &view);
+        view.invert();
+        Quaternion rotation;
+        view.getRotation(&rotation);
+        _cameraNodes[i]->setTranslation(position);
+        _cameraNodes[i]->setRotation(rotation);
+    }
+}
+
+void ReflectionProbe::renderFace(Scene* scene, unsigned int face)
+{
+    _frameBuffers[face]->bind();
+    Game::getInstance()->clear(Game::CLEAR_COLOR_DEPTH, _clearColor, 1.0f, 0);
+
+    scene->setActiveCamera(_cameraNodes[face]->getCamera());
+    _views[face]->draw();
+}
+
+}
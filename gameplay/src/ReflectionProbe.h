@@ -0,0 +1,233 @@
+#ifndef REFLECTIONPROBE_H_
+#define REFLECTIONPROBE_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+class Node;
+class Scene;
+class Camera;
+class FrameBuffer;
+class SceneView;
+class RenderState;
+
+/**
+ * Defines a reflection probe, which renders the scene around the position of a node into a cube map.
+ *
+ * The faces of the cube map are rendered through the render targets of a FrameBuffer for each
+ * face, and cached: update() only renders the faces that are due, according to the update mode.
+ * A probe rendered on demand renders its six faces once, and again only after invalidate() is
+ * called. A time-sliced probe renders one face per update, so that its reflections follow the
+ * scene within six frames at a sixth of the cost. The cull and the sorted render queue of each
+ * face are also kept while the probe and the scene do not move (see SceneView).
+ *
+ * Effects sample the probe when compiled with the REFLECTION_PROBE define. The colored and
+ * textured shaders support it for lit materials, and blend the reflection into the lit color
+ * by the u_reflectivity uniform, which the material sets. Call bind() for each material pass
+ * that uses such an effect, or bindNearest() to bind the materials of a node to the probe
+ * nearest to it:
+ *
+ * @code
+   ReflectionProbe* probe = ReflectionProbe::create(probeNode, 128);
+   probe->setUpdateMode(ReflectionProbe::UPDATE_TIME_SLICED);
+   ReflectionProbe::bindNearest(carNode);
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       probe->update(scene);
+       ...
+   }
+ * @endcode
+ *
+ * While a face is rendered, the camera of the face is made the active camera of the scene, so
+ * that the auto-bindings of the materials use it. The models in the scene are drawn with their
+ * render queue; terrains, particle emitters and forms are not drawn into probes.
+ *
+ * @script{ignore}
+ */
+class ReflectionProbe : public Ref
+{
+public:
+
+    /**
+     * Defines when the faces of the cube map are rendered.
+     */
+    enum UpdateMode
+    {
+        /** The faces are rendered once, and again after invalidate() is called. */
+        UPDATE_ON_DEMAND,
+        /** One face is rendered on each update, in turn. */
+        UPDATE_TIME_SLICED,
+        /** The six faces are rendered on each update. */
+        UPDATE_EVERY_FRAME
+    };
+
+    /**
+     * Creates a reflection probe at the position of a node.
+     *
+     * @param node The node whose world position the probe renders the scene from.
+     * @param size The width and height of each face of the cube map, in texels.
+     *
+     * @return The new probe, or NULL if its frame buffers could not be created.
+     */
+    static ReflectionProbe* create(Node* node, unsigned int size = 128);
+
+    /**
+     * Returns the probe nearest to a position.
+     *
+     * The probes whose radius of influence contains the position are preferred over the others.
+     *
+     * @param position The world position.
+     * @param scene The scene of the probes to select from, or NULL for the probes of any scene.
+     *
+     * @return The nearest probe, or NULL if there are no probes.
+     */
+    static ReflectionProbe* select(const Vector3& position, Scene* scene = NULL);
+
+    /**
+     * Binds the materials of the model of a node to the probe nearest to the node.
+     *
+     * The node must be in a scene. Nodes that move far should be bound again.
+     *
+     * @param node The node.
+     *
+     * @return The probe the materials were bound to, or NULL if there is no probe in the scene of the node.
+     */
+    static ReflectionProbe* bindNearest(Node* node);
+
+    /**
+     * Returns the node the probe renders the scene from.
+     *
+     * @return The node.
+     */
+    Node* getNode() const;
+
+    /**
+     * Returns the cube map the probe renders into.
+     *
+     * @return The cube map texture.
+     */
+    Texture* getTexture() const;
+
+    /**
+     * Sets when the faces of the cube map are rendered.
+     *
+     * @param mode The update mode (UPDATE_ON_DEMAND by default).
+     */
+    void setUpdateMode(UpdateMode mode);
+
+    /**
+     * Returns when the faces of the cube map are rendered.
+     *
+     * @return The update mode.
+     */
+    UpdateMode getUpdateMode() const;
+
+    /**
+     * Sets the radius of the sphere around the probe within which select() prefers it.
+     *
+     * @param radius The radius of influence (100 by default).
+     */
+    void setRadius(float radius);
+
+    /**
+     * Returns the radius of the sphere around the probe within which select() prefers it.
+     *
+     * @return The radius of influence.
+     */
+    float getRadius() const;
+
+    /**
+     * Sets the distances of the near and far planes of the cameras of the faces.
+     *
+     * @param nearPlane The near plane distance (0.1 by default).
+     * @param farPlane The far plane distance (1000 by default).
+     */
+    void setClipPlanes(float nearPlane, float farPlane);
+
+    /**
+     * Sets the color the faces are cleared to before the scene is drawn.
+     *
+     * @param color The clear color (black by default).
+     */
+    void setClearColor(const Vector4& color);
+
+    /**
+     * Makes the six faces due on the next update, whatever the update mode.
+     */
+    void invalidate();
+
+    /**
+     * Renders the faces of the cube map that are due.
+     *
+     * The current frame buffer, viewport and active camera of the scene are restored afterwards.
+     *
+     * @param scene The scene to render.
+     *
+     * @return The number of faces rendered.
+     */
+    unsigned int update(Scene* scene);
+
+    /**
+     * Binds the reflection uniforms of a render state to this probe.
+     *
+     * The render state keeps a sampler of the cube map of this probe.
+     *
+     * @param renderState The render state (typically a Material) to bind.
+     */
+    void bind(RenderState* renderState);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    ReflectionProbe(Node* node);
+
+    /**
+     * Destructor.
+     */
+    ~ReflectionProbe();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ReflectionProbe(const ReflectionProbe& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ReflectionProbe& operator=(const ReflectionProbe&);
+
+    /**
+     * Moves the cameras of the faces to the position of the node of the probe.
+     */
+    void updateCameras();
+
+    /**
+     * Renders the scene into a face of the cube map.
+     */
+    void renderFace(Scene* scene, unsigned int face);
+
+    Node* _node;
+    unsigned int _size;
+    UpdateMode _updateMode;
+    float _radius;
+    Vector4 _clearColor;
+    Texture* _texture;
+    Texture::Sampler* _sampler;
+    FrameBuffer* _frameBuffers[6];
+    Node* _cameraNodes[6];
+    SceneView* _views[6];
+    unsigned int _dirtyFaces;
+    unsigned int _nextFace;
+};
+
+}
+
+#endif
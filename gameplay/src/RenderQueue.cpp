@@ -0,0 +1,370 @@
+#include "Base.h"
+#include "RenderQueue.h"
+#include "Node.h"
+#include "MeshPart.h"
+#include "Game.h"
+#include "CommandBuffer.h"
+#include "GLStateCache.h"
+
+namespace gameplay
+{
+
+static bool __depthPrePass = false;
+
+RenderQueue::RenderQueue()
+    : _instanceBuffer(0), _depthEqualState(NULL), _sortedCamera(NULL), _sortDirty(true)
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+    if (_instanceBuffer)
+    {
+        GLStateCache::deleteBuffer(_instanceBuffer);
+        _instanceBuffer = 0;
+    }
+    SAFE_RELEASE(_depthEqualState);
+}
+
+void RenderQueue::setDepthPrePass(bool enabled)
+{
+    __depthPrePass = enabled;
+}
+
+bool RenderQueue::isDepthPrePass()
+{
+    return __depthPrePass;
+}
+
+unsigned int RenderQueue::add(Node* node)
+{
+    GP_ASSERT(node);
+
+    Model* model = node->getModel();
+    return model ? add(model) : 0;
+}
+
+unsigned int RenderQueue::add(Model* model)
+{
+    GP_ASSERT(model);
+    GP_ASSERT(model->getMesh());
+
+    // Queue the parts of the level of detail the model is drawn at this frame.
+    model->updateLod();
+
+    size_t count = _items.size();
+    Mesh* mesh = model->getDrawMesh();
+    unsigned int partCount = mesh->getPartCount();
+    if (partCount == 0)
+    {
+        addItems(model, mesh, NULL, model->getMaterial());
+    }
+    else
+    {
+        for (unsigned int i = 0; i < partCount; ++i)
+        {
+            addItems(model, mesh, mesh->getPart(i), model->getMaterial(i));
+        }
+    }
+    return (unsigned int)(_items.size() - count);
+}
+
+void RenderQueue::addItems(Model* model, Mesh* mesh, MeshPart* part, Material* material)
+{
+    if (material == NULL)
+        return;
+
+    Technique* technique = material->getTechnique();
+    GP_ASSERT(technique);
+    for (unsigned int i = 0, count = technique->getPassCount(); i < count; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+
+        Item item;
+        item.model = model;
+        item.mesh = mesh;
+        item.part = part;
+        item.pass = pass;
+        item.effect = pass->getEffect();
+        item.passIndex = i;
+        bool depthWritten;
+        item.stateKey = pass->getStateKey(&item.transparent, &depthWritten);
+        item.textureKey = pass->getTextureKey();
+        item.depth = 0.0f;
+
+        // Only opaque items that test and write depth can be drawn with the depths of the pre-pass.
+        item.depthPass = NULL;
+        if (__depthPrePass && !item.transparent && depthWritten && material->isDepthPrePass())
+        {
+            item.depthPass = pass->getDepthPass(model->getMesh());
+        }
+        _items.push_back(item);
+        _sortDirty = true;
+    }
+}
+
+void RenderQueue::clear()
+{
+    _items.clear();
+    _sorted.clear();
+    _sortDirty = true;
+}
+
+unsigned int RenderQueue::getItemCount() const
+{
+    return (unsigned int)_items.size();
+}
+
+bool RenderQueue::compareItems(const Item* a, const Item* b)
+{
+    // Opaque items are drawn before transparent ones.
+    if (a->transparent != b->transparent)
+        return b->transparent;
+
+    // Transparent items must be drawn back-to-front to blend correctly.
+    if (a->transparent)
+        return a->depth > b->depth;
+
+    // Keep multi-pass techniques drawing in pass order.
+    if (a->passIndex != b->passIndex)
+        return a->passIndex < b->passIndex;
+    if (a->effect != b->effect)
+        return a->effect < b->effect;
+    if (a->stateKey != b->stateKey)
+        return a->stateKey < b->stateKey;
+    if (a->textureKey != b->textureKey)
+        return a->textureKey < b->textureKey;
+
+    // Group items sharing a pass and geometry so they can be instanced.
+    if (a->pass != b->pass)
+        return a->pass < b->pass;
+    if (a->part != b->part)
+        return a->part < b->part;
+    if (a->mesh != b->mesh)
+        return a->mesh < b->mesh;
+
+    // Draw opaque items front-to-back to take advantage of early depth rejection.
+    return a->depth < b->depth;
+}
+
+unsigned int RenderQueue::draw(Camera* camera, bool wireframe)
+{
+    // A queue drawn again from the same place, with no items added, keeps its order.
+    Node* cameraNode = camera ? camera->getNode() : NULL;
+    Vector3 eye = cameraNode ? cameraNode->getTranslationWorld() : Vector3::zero();
+    if (_sortDirty || camera != _sortedCamera || eye != _sortedEye)
+    {
+        // Compute the distance of each item from the camera.
+        if (cameraNode)
+        {
+            for (size_t i = 0, count = _items.size(); i < count; ++i)
+            {
+                Node* node = _items[i].model->getNode();
+                if (node)
+                {
+                    _items[i].depth = eye.distanceSquared(node->getTranslationWorld());
+                }
+            }
+        }
+
+        _sorted.resize(_items.size());
+        for (size_t i = 0, count = _items.size(); i < count; ++i)
+        {
+            _sorted[i] = &_items[i];
+        }
+        std::sort(_sorted.begin(), _sorted.end(), compareItems);
+        _sortedCamera = camera;
+        _sortedEye = eye;
+        _sortDirty = false;
+    }
+
+    // The color mask of the pre-pass can't be recorded, so recorded queues draw without one.
+    bool depthPrePass = false;
+    if (!wireframe && !CommandBuffer::getRecording())
+    {
+        for (size_t i = 0, count = _sorted.size(); i < count && !depthPrePass; ++i)
+        {
+            depthPrePass = _sorted[i]->depthPass != NULL;
+        }
+    }
+
+    unsigned int drawCalls = 0;
+    if (depthPrePass)
+    {
+        GL_ASSERT( glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE) );
+        drawCalls += drawItems(true, false, false);
+        GL_ASSERT( glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE) );
+
+        if (_depthEqualState == NULL)
+        {
+            _depthEqualState = RenderState::StateBlock::create();
+            _depthEqualState->setDepthWrite(false);
+            _depthEqualState->setDepthFunction(RenderState::DEPTH_EQUAL);
+        }
+    }
+    drawCalls += drawItems(false, depthPrePass, wireframe);
+
+    return drawCalls;
+}
+
+unsigned int RenderQueue::drawItems(bool depthOnly, bool depthEqual, bool wireframe)
+{
+    unsigned int drawCalls = 0;
+    for (size_t i = 0, count = _sorted.size(); i < count;)
+    {
+        Item* item = _sorted[i];
+        Pass* pass = depthOnly ? item->depthPass : item->pass;
+        if (pass == NULL)
+        {
+            ++i;
+            continue;
+        }
+        GP_ASSERT(pass->getEffect());
+
+        // Find the run of items that can be drawn as one instanced batch.
+        size_t last = i + 1;
+        if (pass->getEffect()->getInstanceMatrixAttribute() != -1 && !item->model->getSkin())
+        {
+            while (last < count && _sorted[last]->pass == item->pass && _sorted[last]->part == item->part &&
+                   _sorted[last]->mesh == item->mesh)
+            {
+                ++last;
+            }
+        }
+
+        // Passes whose depth was drawn by the pre-pass only shade the fragments left visible by it.
+        RenderState::_stateOverride = depthEqual && item->depthPass ? _depthEqualState : NULL;
+        if (last - i > 1)
+        {
+            drawInstanced(i, last, pass, wireframe);
+        }
+        else
+        {
+            item->model->drawPass(pass, item->part, wireframe);
+        }
+        i = last;
+        ++drawCalls;
+    }
+    RenderState::_stateOverride = NULL;
+
+    return drawCalls;
+}
+
+void RenderQueue::drawInstanced(size_t first, size_t last, Pass* pass, bool wireframe)
+{
+    Item* item = _sorted[first];
+    Model* model = item->model;
+    VertexAttribute attribute = pass->getEffect()->getInstanceMatrixAttribute();
+
+    // Streamed textures are loaded at the size of the largest instance on screen.
+    if (Texture::getStreamingBudget() > 0)
+    {
+        float screenSize = 0.0f;
+        for (size_t i = first; i < last; ++i)
+        {
+            float size = _sorted[i]->model->getScreenSize();
+            if (size <= 0.0f)
+            {
+                screenSize = 0.0f;
+                break;
+            }
+            screenSize = std::max(screenSize, size);
+        }
+        Texture::setStreamingScreenSize(screenSize);
+    }
+
+    if (model->_sharedMaterials && model->_node)
+    {
+        pass->retargetNodeBinding(model->_node);
+    }
+
+    VertexAttributeBinding* binding = model->getLodBinding(pass);
+    pass->bind(binding);
+    Texture::setStreamingScreenSize(0.0f);
+
+#ifdef USE_INSTANCING
+    if (!wireframe && glDrawElementsInstanced && glDrawArraysInstanced && glVertexAttribDivisor)
+    {
+        Mesh* mesh = item->mesh;
+        unsigned int instanceCount = (unsigned int)(last - first);
+
+        // Gather the world matrices of all instances.
+        _instanceData.resize(instanceCount * 16);
+        for (size_t i = first; i < last; ++i)
+        {
+            Node* node = _sorted[i]->model->getNode();
+            memcpy(&_instanceData[(i - first) * 16], node ? node->getWorldMatrix().m : Matrix::identity().m, sizeof(float) * 16);
+        }
+
+        GLenum primitiveType = item->part ? item->part->getPrimitiveType() : mesh->getPrimitiveType();
+        unsigned int count = item->part ? item->part->getIndexCount() : mesh->getVertexCount();
+        GLenum indexFormat = item->part ? item->part->getIndexFormat() : Mesh::INDEX16;
+        IndexBufferHandle indexBuffer = item->part ? item->part->getIndexBuffer() : 0;
+        CommandBuffer* buffer = CommandBuffer::getRecording();
+        if (buffer)
+            buffer->drawInstanced(primitiveType, count, indexFormat, indexBuffer, attribute, &_instanceData[0], instanceCount);
+        else
+            drawInstancedGeometry(&_instanceBuffer, &_instanceData[0], instanceCount, attribute, primitiveType, count, indexFormat, indexBuffer);
+
+        pass->unbind(binding);
+        return;
+    }
+#endif
+
+    // Fallback: bind the pass once and draw each instance with a constant world matrix attribute.
+    for (size_t i = first; i < last; ++i)
+    {
+        Node* node = _sorted[i]->model->getNode();
+        Model::setInstanceMatrix(attribute, node ? node->getWorldMatrix() : Matrix::identity());
+        _sorted[i]->model->drawGeometry(item->part, wireframe);
+    }
+
+    pass->unbind(binding);
+}
+
+void RenderQueue::drawInstancedGeometry(VertexBufferHandle* instanceBuffer, const float* matrices, unsigned int instanceCount, VertexAttribute attribute,
+                                        GLenum primitiveType, unsigned int count, GLenum indexFormat, IndexBufferHandle indexBuffer)
+{
+    GP_ASSERT(instanceBuffer);
+    GP_ASSERT(matrices);
+
+#ifdef USE_INSTANCING
+    // Stream the world matrices of all instances into the instance buffer.
+    if (*instanceBuffer == 0)
+    {
+        GL_ASSERT( glGenBuffers(1, instanceBuffer) );
+    }
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, *instanceBuffer);
+    GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16 * instanceCount, matrices, GL_STREAM_DRAW) );
+    Game::countBufferUpload(sizeof(float) * 16 * instanceCount);
+    for (int i = 0; i < 4; ++i)
+    {
+        GL_ASSERT( glEnableVertexAttribArray(attribute + i) );
+        GL_ASSERT( glVertexAttribPointer(attribute + i, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (const GLvoid*)(sizeof(float) * 4 * i)) );
+        GL_ASSERT( glVertexAttribDivisor(attribute + i, 1) );
+    }
+
+    if (indexBuffer)
+    {
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        GL_ASSERT( glDrawElementsInstanced(primitiveType, count, indexFormat, 0, instanceCount) );
+    }
+    else
+    {
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GL_ASSERT( glDrawArraysInstanced(primitiveType, 0, count, instanceCount) );
+    }
+    Game::countDrawCall(primitiveType, count, instanceCount);
+
+    // Restore the attribute state so non-instanced draws of this binding use constant values.
+    for (int i = 0; i < 4; ++i)
+    {
+        GL_ASSERT( glVertexAttribDivisor(attribute + i, 0) );
+        GL_ASSERT( glDisableVertexAttribArray(attribute + i) );
+    }
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
+
+}
@@ -0,0 +1,206 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include "Model.h"
+#include "Camera.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a queue of draw items that are sorted to minimize renderer state changes.
+ *
+ * Rather than drawing each Model as the scene is visited, models are added to a
+ * RenderQueue which records a draw item for every (Pass, MeshPart, Node) combination.
+ * When the queue is drawn, opaque items are sorted by pass index, effect, renderer
+ * state and texture set (and then front-to-back), while transparent items (those with
+ * blending enabled) are drawn afterwards, sorted back-to-front.
+ *
+ * Consecutive items that share the same Pass and mesh geometry and whose effect
+ * was compiled with the INSTANCED define are drawn as a single instanced batch.
+ * Their world matrices are streamed into a per-instance vertex buffer and drawn
+ * with glDrawElementsInstanced where supported. On platforms without instancing
+ * support (OpenGL ES 2.0), the pass is still only bound once for the whole batch
+ * and each instance is drawn with its world matrix set as a constant attribute.
+ * Models sharing a Material for instancing should avoid node-specific auto
+ * bindings (such as WORLD_VIEW_PROJECTION_MATRIX) since they are bound only once.
+ *
+ * With the depth pre-pass enabled, the opaque items that test and write depth are first
+ * drawn with color writes disabled, by effects that link their vertex shaders with a
+ * fragment shader that only writes depth. Their passes are then drawn with the
+ * DEPTH_EQUAL depth function and depth writes disabled, so their fragment shaders only
+ * run for the fragments that are visible. This saves the shading of the fragments drawn
+ * over by closer ones, which pays off for expensive lighting on desktop GPUs, but costs a
+ * second draw of the geometry that tile-based mobile GPUs rarely recover. It is disabled
+ * by default, and can be enabled for all render queues in game.config:
+ * @code
+   graphics
+   {
+       depthPrePass = true
+   }
+ * @endcode
+ * Materials can opt out with Material::setDepthPrePass.
+ *
+ * A RenderQueue does not hold references to the models added to it, so it should be
+ * cleared (or drawn) every frame before any of the queued models are released. A queue
+ * that is drawn again from the same camera position, with no items added, is not sorted
+ * again (see SceneView, which keeps the queues of static cameras from frame to frame).
+ *
+ * @script{ignore}
+ */
+class RenderQueue
+{
+    friend class CommandBuffer;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    RenderQueue();
+
+    /**
+     * Destructor.
+     */
+    ~RenderQueue();
+
+    /**
+     * Adds the model attached to the specified node to the queue.
+     *
+     * @param node The node whose model to add.
+     *
+     * @return The number of draw items added.
+     */
+    unsigned int add(Node* node);
+
+    /**
+     * Adds the specified model to the queue.
+     *
+     * @param model The model to add.
+     *
+     * @return The number of draw items added.
+     */
+    unsigned int add(Model* model);
+
+    /**
+     * Removes all draw items from the queue.
+     */
+    void clear();
+
+    /**
+     * Returns the number of draw items in the queue.
+     *
+     * @return The number of draw items.
+     */
+    unsigned int getItemCount() const;
+
+    /**
+     * Sorts and draws all the items in the queue.
+     *
+     * @param camera The camera used to sort items by depth, or NULL to ignore depth.
+     * @param wireframe If true, draw the models in wireframe mode.
+     *
+     * @return The number of draw calls issued (an instanced batch counts as one).
+     */
+    unsigned int draw(Camera* camera = NULL, bool wireframe = false);
+
+    /**
+     * Sets whether render queues draw the depth of their opaque items in a pre-pass.
+     *
+     * This applies to the items added to the queues after it is set.
+     *
+     * @param enabled true to draw a depth pre-pass.
+     */
+    static void setDepthPrePass(bool enabled);
+
+    /**
+     * Determines whether render queues draw the depth of their opaque items in a pre-pass.
+     *
+     * @return true if the depth pre-pass is enabled.
+     */
+    static bool isDepthPrePass();
+
+private:
+
+    /**
+     * Defines a single draw item.
+     */
+    struct Item
+    {
+        Model* model;
+        Mesh* mesh;
+        MeshPart* part;
+        Pass* pass;
+        Pass* depthPass;
+        Effect* effect;
+        unsigned int passIndex;
+        unsigned int stateKey;
+        unsigned int textureKey;
+        float depth;
+        bool transparent;
+    };
+
+    /**
+     * Orders items for drawing.
+     */
+    static bool compareItems(const Item* a, const Item* b);
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderQueue(const RenderQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderQueue& operator=(const RenderQueue&);
+
+    void addItems(Model* model, Mesh* mesh, MeshPart* part, Material* material);
+
+    /**
+     * Draws the sorted items, batching the runs of items that can be instanced.
+     *
+     * @param depthOnly Draws the depth passes of the items that have one, instead of their passes.
+     * @param depthEqual Draws the passes of the items that have a depth pass with the depths drawn by it.
+     * @param wireframe If true, draw the models in wireframe mode.
+     *
+     * @return The number of draw calls issued.
+     */
+    unsigned int drawItems(bool depthOnly, bool depthEqual, bool wireframe);
+
+    /**
+     * Draws the sorted items in the range [first, last) as a single instanced batch, with the specified pass of the first item.
+     */
+    void drawInstanced(size_t first, size_t last, Pass* pass, bool wireframe);
+
+    /**
+     * Streams the world matrices of a batch of instances into an instance buffer, and draws the batch
+     * with the currently bound pass.
+     *
+     * @param instanceBuffer The instance buffer, which is created the first time it is used.
+     * @param matrices The world matrices of the instances, 16 floats each.
+     * @param instanceCount The number of instances.
+     * @param attribute The first vertex attribute of the instance matrix.
+     * @param primitiveType The primitive type of the geometry.
+     * @param count The number of indices to draw, or vertices if indexBuffer is 0.
+     * @param indexFormat The format of the indices.
+     * @param indexBuffer The index buffer, or 0 to draw the vertices in order.
+     */
+    static void drawInstancedGeometry(VertexBufferHandle* instanceBuffer, const float* matrices, unsigned int instanceCount, VertexAttribute attribute,
+                                      GLenum primitiveType, unsigned int count, GLenum indexFormat, IndexBufferHandle indexBuffer);
+
+    std::vector<Item> _items;
+    std::vector<Item*> _sorted;
+    std::vector<float> _instanceData;
+    VertexBufferHandle _instanceBuffer;
+    RenderState::StateBlock* _depthEqualState;
+    Camera* _sortedCamera;
+    Vector3 _sortedEye;
+    bool _sortDirty;
+};
+
+}
+
+#endif
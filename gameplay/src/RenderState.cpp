@@ -5,6 +5,8 @@
 #include "Technique.h"
 #include "Node.h"
 #include "Scene.h"
+#include "Game.h"
+#include "CommandBuffer.h"
 
 // Render state override bits
 #define RS_BLEND 1
@@ -22,11 +24,18 @@
 
 #define RS_ALL_ONES 0xFFFFFFFF
 
+// The number of lights of each type bound by the POINT_LIGHT_* and SPOT_LIGHT_* auto bindings.
+#define RS_NODE_LIGHT_COUNT 8
+
 namespace gameplay
 {
 
 RenderState::StateBlock* RenderState::StateBlock::_defaultState = NULL;
 std::vector<RenderState::AutoBindingResolver*> RenderState::_customAutoBindingResolvers;
+GLuint RenderState::_frameUniformBuffer = 0;
+RenderState::FrameUniforms RenderState::_frameUniforms;
+unsigned int RenderState::_bindListRevision = 1;
+RenderState::StateBlock* RenderState::_stateOverride = NULL;
 
 RenderState::RenderState()
     : _nodeBinding(NULL), _state(NULL), _parent(NULL)
@@ -35,6 +44,7 @@ RenderState::RenderState()
 
 RenderState::~RenderState()
 {
+    ++_bindListRevision;
     SAFE_RELEASE(_state);
 
     // Destroy all the material parameters
@@ -55,6 +65,71 @@ void RenderState::initialize()
 void RenderState::finalize()
 {
     SAFE_RELEASE(StateBlock::_defaultState);
+
+    if (_frameUniformBuffer)
+    {
+        GL_ASSERT( glDeleteBuffers(1, &_frameUniformBuffer) );
+        _frameUniformBuffer = 0;
+    }
+}
+
+bool RenderState::isFrameUniformBufferSupported()
+{
+#ifdef USE_UNIFORM_BUFFER
+    return GLEW_ARB_uniform_buffer_object != 0;
+#else
+    return false;
+#endif
+}
+
+void RenderState::bindFrameUniforms(Node* node)
+{
+#ifdef USE_UNIFORM_BUFFER
+    FrameUniforms uniforms;
+    memcpy(uniforms.viewMatrix, node ? node->getViewMatrix().m : Matrix::identity().m, sizeof(uniforms.viewMatrix));
+    memcpy(uniforms.projectionMatrix, node ? node->getProjectionMatrix().m : Matrix::identity().m, sizeof(uniforms.projectionMatrix));
+    memcpy(uniforms.viewProjectionMatrix, node ? node->getViewProjectionMatrix().m : Matrix::identity().m, sizeof(uniforms.viewProjectionMatrix));
+    Vector3 position = node ? node->getActiveCameraTranslationWorld() : Vector3::zero();
+    uniforms.cameraWorldPosition[0] = position.x;
+    uniforms.cameraWorldPosition[1] = position.y;
+    uniforms.cameraWorldPosition[2] = position.z;
+    uniforms.cameraWorldPosition[3] = 1.0f;
+    position = node ? node->getActiveCameraTranslationView() : Vector3::zero();
+    uniforms.cameraViewPosition[0] = position.x;
+    uniforms.cameraViewPosition[1] = position.y;
+    uniforms.cameraViewPosition[2] = position.z;
+    uniforms.cameraViewPosition[3] = 1.0f;
+
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+        buffer->setFrameUniforms(uniforms);
+    else
+        uploadFrameUniforms(uniforms);
+#endif
+}
+
+void RenderState::uploadFrameUniforms(const FrameUniforms& uniforms)
+{
+#ifdef USE_UNIFORM_BUFFER
+    // The buffer stays bound to its binding point, so it is only touched when the camera changes.
+    if (_frameUniformBuffer == 0)
+    {
+        GL_ASSERT( glGenBuffers(1, &_frameUniformBuffer) );
+        GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, _frameUniformBuffer) );
+        GL_ASSERT( glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &uniforms, GL_DYNAMIC_DRAW) );
+        GL_ASSERT( glBindBufferBase(GL_UNIFORM_BUFFER, Effect::FRAME_UNIFORMS_BINDING, _frameUniformBuffer) );
+        GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, 0) );
+        Game::countBufferUpload(sizeof(FrameUniforms));
+    }
+    else if (memcmp(&uniforms, &_frameUniforms, sizeof(FrameUniforms)) != 0)
+    {
+        GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, _frameUniformBuffer) );
+        GL_ASSERT( glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms) );
+        GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, 0) );
+        Game::countBufferUpload(sizeof(FrameUniforms));
+    }
+    _frameUniforms = uniforms;
+#endif
 }
 
 MaterialParameter* RenderState::getParameter(const char* name) const
@@ -76,6 +151,7 @@ MaterialParameter* RenderState::getParameter(const char* name) const
     // Create a new parameter and store it in our list.
     param = new MaterialParameter(name);
     _parameters.push_back(param);
+    ++_bindListRevision;
 
     return param;
 }
@@ -94,6 +170,7 @@ void RenderState::addParameter(MaterialParameter* param)
 {
     _parameters.push_back(param);
     param->addRef();
+    ++_bindListRevision;
 }
 
 void RenderState::removeParameter(const char* name)
@@ -105,63 +182,86 @@ void RenderState::removeParameter(const char* name)
         {
             _parameters.erase(_parameters.begin() + i);
             SAFE_RELEASE(p);
+            ++_bindListRevision;
             break;
         }
     }
 }
 
-/**
- * @script{ignore}
- */
-const char* autoBindingToString(RenderState::AutoBinding autoBinding)
-{
-    // NOTE: As new AutoBinding values are added, this switch statement must be updatd.
-    switch (autoBinding)
-    {
-    case RenderState::NONE:
+// The names of the built-in auto-bindings, in the order of the AutoBinding values after NONE.
+// NOTE: As new AutoBinding values are added, this table must be updated.
+static const struct
+{
+    const char* name;
+    RenderState::AutoBinding autoBinding;
+} __autoBindingNames[] =
+{
+    { "WORLD_MATRIX", RenderState::WORLD_MATRIX },
+    { "VIEW_MATRIX", RenderState::VIEW_MATRIX },
+    { "PROJECTION_MATRIX", RenderState::PROJECTION_MATRIX },
+    { "WORLD_VIEW_MATRIX", RenderState::WORLD_VIEW_MATRIX },
+    { "VIEW_PROJECTION_MATRIX", RenderState::VIEW_PROJECTION_MATRIX },
+    { "WORLD_VIEW_PROJECTION_MATRIX", RenderState::WORLD_VIEW_PROJECTION_MATRIX },
+    { "INVERSE_TRANSPOSE_WORLD_MATRIX", RenderState::INVERSE_TRANSPOSE_WORLD_MATRIX },
+    { "INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX", RenderState::INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX },
+    { "CAMERA_WORLD_POSITION", RenderState::CAMERA_WORLD_POSITION },
+    { "CAMERA_VIEW_POSITION", RenderState::CAMERA_VIEW_POSITION },
+    { "MATRIX_PALETTE", RenderState::MATRIX_PALETTE },
+    { "MATRIX_PALETTE_TEXTURE", RenderState::MATRIX_PALETTE_TEXTURE },
+    { "MATRIX_PALETTE_TEXEL_SIZE", RenderState::MATRIX_PALETTE_TEXEL_SIZE },
+    { "SCENE_AMBIENT_COLOR", RenderState::SCENE_AMBIENT_COLOR },
+    { "POINT_LIGHT_COLOR", RenderState::POINT_LIGHT_COLOR },
+    { "POINT_LIGHT_POSITION", RenderState::POINT_LIGHT_POSITION },
+    { "POINT_LIGHT_RANGE_INVERSE", RenderState::POINT_LIGHT_RANGE_INVERSE },
+    { "SPOT_LIGHT_COLOR", RenderState::SPOT_LIGHT_COLOR },
+    { "SPOT_LIGHT_POSITION", RenderState::SPOT_LIGHT_POSITION },
+    { "SPOT_LIGHT_DIRECTION", RenderState::SPOT_LIGHT_DIRECTION },
+    { "SPOT_LIGHT_RANGE_INVERSE", RenderState::SPOT_LIGHT_RANGE_INVERSE },
+    { "SPOT_LIGHT_INNER_ANGLE_COS", RenderState::SPOT_LIGHT_INNER_ANGLE_COS },
+    { "SPOT_LIGHT_OUTER_ANGLE_COS", RenderState::SPOT_LIGHT_OUTER_ANGLE_COS },
+};
+
+static const char* autoBindingToString(RenderState::AutoBinding autoBinding)
+{
+    size_t index = (size_t)autoBinding - 1;
+    if (autoBinding == RenderState::NONE || index >= sizeof(__autoBindingNames) / sizeof(__autoBindingNames[0]))
         return NULL;
 
-    case RenderState::VIEW_MATRIX:
-        return "VIEW_MATRIX";
-
-    case RenderState::PROJECTION_MATRIX:
-        return "PROJECTION_MATRIX";
-
-    case RenderState::WORLD_VIEW_MATRIX:
-        return "WORLD_VIEW_MATRIX";
-
-    case RenderState::VIEW_PROJECTION_MATRIX:
-        return "VIEW_PROJECTION_MATRIX";
-
-    case RenderState::WORLD_VIEW_PROJECTION_MATRIX:
-        return "WORLD_VIEW_PROJECTION_MATRIX";
-
-    case RenderState::INVERSE_TRANSPOSE_WORLD_MATRIX:
-        return "INVERSE_TRANSPOSE_WORLD_MATRIX";
-
-    case RenderState::INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX:
-        return "INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX";
-
-    case RenderState::CAMERA_WORLD_POSITION:
-        return "CAMERA_WORLD_POSITION";
-
-    case RenderState::CAMERA_VIEW_POSITION:
-        return "CAMERA_VIEW_POSITION";
-
-    case RenderState::MATRIX_PALETTE:
-        return "MATRIX_PALETTE";
+    GP_ASSERT(__autoBindingNames[index].autoBinding == autoBinding);
+    return __autoBindingNames[index].name;
+}
 
-    case RenderState::SCENE_AMBIENT_COLOR:
-        return "SCENE_AMBIENT_COLOR";
+static RenderState::AutoBinding parseAutoBinding(const char* autoBinding)
+{
+    GP_ASSERT(autoBinding);
 
-    default:
-        return "";
+    for (size_t i = 0, count = sizeof(__autoBindingNames) / sizeof(__autoBindingNames[0]); i < count; ++i)
+    {
+        if (strcmp(autoBinding, __autoBindingNames[i].name) == 0)
+            return __autoBindingNames[i].autoBinding;
     }
+    return RenderState::NONE;
 }
 
 void RenderState::setParameterAutoBinding(const char* name, AutoBinding autoBinding)
 {
-    setParameterAutoBinding(name, autoBindingToString(autoBinding));
+    GP_ASSERT(name);
+
+    if (autoBinding == NONE)
+    {
+        // Remove an existing auto-binding
+        for (size_t i = 0, count = _autoBindings.size(); i < count; ++i)
+        {
+            if (_autoBindings[i].uniformName == name)
+            {
+                _autoBindings.erase(_autoBindings.begin() + i);
+                break;
+            }
+        }
+        return;
+    }
+
+    setParameterAutoBinding(name, autoBinding, NULL);
 }
 
 void RenderState::setParameterAutoBinding(const char* name, const char* autoBinding)
@@ -169,23 +269,34 @@ void RenderState::setParameterAutoBinding(const char* name, const char* autoBind
     GP_ASSERT(name);
     GP_ASSERT(autoBinding);
 
-    if (autoBinding == NULL)
+    // Resolve the name once, so that binding a node does not compare strings.
+    AutoBinding builtIn = parseAutoBinding(autoBinding);
+    setParameterAutoBinding(name, builtIn, builtIn == NONE ? autoBinding : NULL);
+}
+
+void RenderState::setParameterAutoBinding(const char* name, AutoBinding autoBinding, const char* customBinding)
+{
+    // Add/update an auto-binding
+    AutoBindingEntry* entry = NULL;
+    for (size_t i = 0, count = _autoBindings.size(); i < count && entry == NULL; ++i)
     {
-        // Remove an existing auto-binding
-        std::map<std::string, std::string>::iterator itr = _autoBindings.find(name);
-        if (itr != _autoBindings.end())
-            _autoBindings.erase(itr);
+        if (_autoBindings[i].uniformName == name)
+            entry = &_autoBindings[i];
     }
-    else
+    if (entry == NULL)
     {
-        // Add/update an auto-binding
-        _autoBindings[name] = autoBinding;
+        _autoBindings.push_back(AutoBindingEntry());
+        entry = &_autoBindings.back();
+        entry->uniformName = name;
     }
+    entry->autoBinding = autoBinding;
+    entry->customBinding = customBinding ? customBinding : "";
 
-    // If we already have a node binding set, pass it to our handler now
-    if (_nodeBinding)
+    // Built-in auto-bindings read the node binding when they are bound, so they are applied once now.
+    // Custom ones are resolved for a node, so they wait for one.
+    if (autoBinding != NONE || _nodeBinding)
     {
-        applyAutoBinding(name, autoBinding);
+        applyAutoBinding(*entry);
     }
 }
 
@@ -196,6 +307,7 @@ void RenderState::setStateBlock(StateBlock* state)
         SAFE_RELEASE(_state);
 
         _state = state;
+        ++_bindListRevision;
 
         if (_state)
         {
@@ -209,6 +321,7 @@ RenderState::StateBlock* RenderState::getStateBlock() const
     if (_state == NULL)
     {
         _state = StateBlock::create();
+        ++_bindListRevision;
     }
 
     return _state;
@@ -222,34 +335,47 @@ void RenderState::setNodeBinding(Node* node)
 
         if (_nodeBinding)
         {
-            // Apply all existing auto-bindings using this node.
-            std::map<std::string, std::string>::const_iterator itr = _autoBindings.begin();
-            while (itr != _autoBindings.end())
+            // Resolve the custom auto-bindings for this node. The built-in ones were applied when they
+            // were set, unless custom resolvers may override them for each node.
+            bool resolvers = !_customAutoBindingResolvers.empty();
+            for (size_t i = 0, count = _autoBindings.size(); i < count; ++i)
             {
-                applyAutoBinding(itr->first.c_str(), itr->second.c_str());
-                ++itr;
+                if (resolvers || _autoBindings[i].autoBinding == NONE)
+                {
+                    applyAutoBinding(_autoBindings[i]);
+                }
             }
         }
     }
 }
 
-void RenderState::applyAutoBinding(const char* uniformName, const char* autoBinding)
+void RenderState::retargetNodeBinding(Node* node)
 {
-    GP_ASSERT(_nodeBinding);
+    for (RenderState* rs = this; rs != NULL; rs = rs->_parent)
+    {
+        rs->_nodeBinding = node;
+    }
+}
 
-    MaterialParameter* param = getParameter(uniformName);
+void RenderState::applyAutoBinding(const AutoBindingEntry& entry)
+{
+    MaterialParameter* param = getParameter(entry.uniformName.c_str());
     GP_ASSERT(param);
 
     bool bound = false;
 
-    // First attempt to resolve the binding using custom registered resolvers.
-    for (size_t i = 0, count = _customAutoBindingResolvers.size(); i < count; ++i)
+    // First attempt to resolve the binding using custom registered resolvers, which need a node.
+    const char* autoBinding = entry.autoBinding == NONE ? entry.customBinding.c_str() : autoBindingToString(entry.autoBinding);
+    if (_nodeBinding)
     {
-        if (_customAutoBindingResolvers[i]->resolveAutoBinding(autoBinding, _nodeBinding, param))
+        for (size_t i = 0, count = _customAutoBindingResolvers.size(); i < count; ++i)
         {
-            // Handled by custom auto binding resolver
-            bound = true;
-            break;
+            if (_customAutoBindingResolvers[i]->resolveAutoBinding(autoBinding, _nodeBinding, param))
+            {
+                // Handled by custom auto binding resolver
+                bound = true;
+                break;
+            }
         }
     }
 
@@ -258,58 +384,92 @@ void RenderState::applyAutoBinding(const char* uniformName, const char* autoBind
     {
         bound = true;
 
-        if (strcmp(autoBinding, "WORLD_MATRIX") == 0)
+        switch (entry.autoBinding)
         {
+        case WORLD_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetWorldMatrix);
-        }
-        else if (strcmp(autoBinding, "VIEW_MATRIX") == 0)
-        {
+            break;
+        case VIEW_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetViewMatrix);
-        }
-        else if (strcmp(autoBinding, "PROJECTION_MATRIX") == 0)
-        {
+            break;
+        case PROJECTION_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "WORLD_VIEW_MATRIX") == 0)
-        {
+            break;
+        case WORLD_VIEW_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetWorldViewMatrix);
-        }
-        else if (strcmp(autoBinding, "VIEW_PROJECTION_MATRIX") == 0)
-        {
+            break;
+        case VIEW_PROJECTION_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetViewProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "WORLD_VIEW_PROJECTION_MATRIX") == 0)
-        {
+            break;
+        case WORLD_VIEW_PROJECTION_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetWorldViewProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "INVERSE_TRANSPOSE_WORLD_MATRIX") == 0)
-        {
+            break;
+        case INVERSE_TRANSPOSE_WORLD_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetInverseTransposeWorldMatrix);
-        }
-        else if (strcmp(autoBinding, "INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX") == 0)
-        {
+            break;
+        case INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX:
             param->bindValue(this, &RenderState::autoBindingGetInverseTransposeWorldViewMatrix);
-        }
-        else if (strcmp(autoBinding, "CAMERA_WORLD_POSITION") == 0)
-        {
+            break;
+        case CAMERA_WORLD_POSITION:
             param->bindValue(this, &RenderState::autoBindingGetCameraWorldPosition);
-        }
-        else if (strcmp(autoBinding, "CAMERA_VIEW_POSITION") == 0)
-        {
+            break;
+        case CAMERA_VIEW_POSITION:
             param->bindValue(this, &RenderState::autoBindingGetCameraViewPosition);
-        }
-        else if (strcmp(autoBinding, "MATRIX_PALETTE") == 0)
-        {
+            break;
+        case MATRIX_PALETTE:
             param->bindValue(this, &RenderState::autoBindingGetMatrixPalette, &RenderState::autoBindingGetMatrixPaletteSize);
-        }
-        else if (strcmp(autoBinding, "SCENE_AMBIENT_COLOR") == 0)
-        {
+            break;
+        case MATRIX_PALETTE_TEXTURE:
+            if (MeshSkin::isMatrixPaletteTextureSupported())
+            {
+                param->bindValue(this, &RenderState::autoBindingGetMatrixPaletteSampler);
+            }
+            else
+            {
+                bound = false;
+                GP_WARN("Matrix palette textures are not supported by the graphics driver (%s).", autoBinding);
+            }
+            break;
+        case MATRIX_PALETTE_TEXEL_SIZE:
+            param->bindValue(this, &RenderState::autoBindingGetMatrixPaletteTexelSize);
+            break;
+        case SCENE_AMBIENT_COLOR:
             param->bindValue(this, &RenderState::autoBindingGetAmbientColor);
-        }
-        else
-        {
+            break;
+        case POINT_LIGHT_COLOR:
+            param->bindValue(this, &RenderState::autoBindingGetPointLightColor, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case POINT_LIGHT_POSITION:
+            param->bindValue(this, &RenderState::autoBindingGetPointLightPosition, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case POINT_LIGHT_RANGE_INVERSE:
+            param->bindValue(this, &RenderState::autoBindingGetPointLightRangeInverse, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_COLOR:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightColor, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_POSITION:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightPosition, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_DIRECTION:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightDirection, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_RANGE_INVERSE:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightRangeInverse, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_INNER_ANGLE_COS:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightInnerAngleCos, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        case SPOT_LIGHT_OUTER_ANGLE_COS:
+            param->bindValue(this, &RenderState::autoBindingGetSpotLightOuterAngleCos, &RenderState::autoBindingGetNodeLightCount);
+            break;
+        default:
             bound = false;
-            GP_WARN("Unsupported auto binding type (%s).", autoBinding);
+            if (_nodeBinding)
+            {
+                GP_WARN("Unsupported auto binding type (%s).", autoBinding);
+            }
+            break;
         }
     }
 
@@ -385,69 +545,279 @@ unsigned int RenderState::autoBindingGetMatrixPaletteSize() const
     return skin ? skin->getMatrixPaletteSize() : 0;
 }
 
+const Texture::Sampler* RenderState::autoBindingGetMatrixPaletteSampler() const
+{
+    Model* model = _nodeBinding ? _nodeBinding->getModel() : NULL;
+    MeshSkin* skin = model ? model->getSkin() : NULL;
+    Texture::Sampler* sampler = skin ? skin->getMatrixPaletteSampler() : NULL;
+    GP_ASSERT(sampler);
+    return sampler;
+}
+
+const Vector2& RenderState::autoBindingGetMatrixPaletteTexelSize() const
+{
+    Model* model = _nodeBinding ? _nodeBinding->getModel() : NULL;
+    MeshSkin* skin = model ? model->getSkin() : NULL;
+    return skin ? skin->getMatrixPaletteTexelSize() : Vector2::zero();
+}
+
 const Vector3& RenderState::autoBindingGetAmbientColor() const
 {
     Scene* scene = _nodeBinding ? _nodeBinding->getScene() : NULL;
     return scene ? scene->getAmbientColor() : Vector3::zero();
 }
 
+// Scratch arrays filled by the light auto bindings, whose values are uploaded (or recorded) as soon as they are returned.
+static Vector3 __nodeLightVectors[RS_NODE_LIGHT_COUNT];
+static float __nodeLightFloats[RS_NODE_LIGHT_COUNT];
+
+// Selects the lights of a type that influence a node the most, and returns how many were selected.
+static unsigned int getNodeLights(Node* node, Light::Type type, Light** lights)
+{
+    Scene* scene = node ? node->getScene() : NULL;
+    return scene ? scene->getNodeLights(node, type, lights, RS_NODE_LIGHT_COUNT) : 0;
+}
+
+// Fills the scratch vectors with the colors of the lights of a type that influence a node the most.
+static const Vector3* getNodeLightColors(Node* node, Light::Type type)
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(node, type, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        // Black lights past the selected ones add nothing to the shading.
+        __nodeLightVectors[i] = i < count ? lights[i]->getColor() : Vector3::zero();
+    }
+    return __nodeLightVectors;
+}
+
+// Fills the scratch vectors with the view-space positions of the lights of a type that influence a node the most.
+static const Vector3* getNodeLightPositions(Node* node, Light::Type type)
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(node, type, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        __nodeLightVectors[i] = i < count && lights[i]->getNode() ? lights[i]->getNode()->getTranslationView() : Vector3::zero();
+    }
+    return __nodeLightVectors;
+}
+
+// Fills the scratch values with the inverse ranges of the lights of a type that influence a node the most.
+static const float* getNodeLightRangeInverses(Node* node, Light::Type type)
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(node, type, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        __nodeLightFloats[i] = i < count ? lights[i]->getRangeInverse() : 0.0f;
+    }
+    return __nodeLightFloats;
+}
+
+const Vector3* RenderState::autoBindingGetPointLightColor() const
+{
+    return getNodeLightColors(_nodeBinding, Light::POINT);
+}
+
+const Vector3* RenderState::autoBindingGetPointLightPosition() const
+{
+    return getNodeLightPositions(_nodeBinding, Light::POINT);
+}
+
+const float* RenderState::autoBindingGetPointLightRangeInverse() const
+{
+    return getNodeLightRangeInverses(_nodeBinding, Light::POINT);
+}
+
+const Vector3* RenderState::autoBindingGetSpotLightColor() const
+{
+    return getNodeLightColors(_nodeBinding, Light::SPOT);
+}
+
+const Vector3* RenderState::autoBindingGetSpotLightPosition() const
+{
+    return getNodeLightPositions(_nodeBinding, Light::SPOT);
+}
+
+const Vector3* RenderState::autoBindingGetSpotLightDirection() const
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(_nodeBinding, Light::SPOT, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        __nodeLightVectors[i] = i < count && lights[i]->getNode() ? lights[i]->getNode()->getForwardVectorView() : Vector3::zero();
+    }
+    return __nodeLightVectors;
+}
+
+const float* RenderState::autoBindingGetSpotLightRangeInverse() const
+{
+    return getNodeLightRangeInverses(_nodeBinding, Light::SPOT);
+}
+
+const float* RenderState::autoBindingGetSpotLightInnerAngleCos() const
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(_nodeBinding, Light::SPOT, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        __nodeLightFloats[i] = i < count ? lights[i]->getInnerAngleCos() : 1.0f;
+    }
+    return __nodeLightFloats;
+}
+
+const float* RenderState::autoBindingGetSpotLightOuterAngleCos() const
+{
+    Light* lights[RS_NODE_LIGHT_COUNT];
+    unsigned int count = getNodeLights(_nodeBinding, Light::SPOT, lights);
+    for (unsigned int i = 0; i < RS_NODE_LIGHT_COUNT; ++i)
+    {
+        // Keep the cone of the padding lights valid (outer below inner), so that shaders stay well defined.
+        __nodeLightFloats[i] = i < count ? lights[i]->getOuterAngleCos() : 0.0f;
+    }
+    return __nodeLightFloats;
+}
+
+unsigned int RenderState::autoBindingGetNodeLightCount() const
+{
+    return RS_NODE_LIGHT_COUNT;
+}
+
 void RenderState::bind(Pass* pass)
 {
     GP_ASSERT(pass);
 
+    // Recompile the bind lists of the pass if any hierarchy changed since they were compiled.
+    if (pass->_bindListRevision != _bindListRevision)
+    {
+        pass->compileBindList();
+    }
+
     // Get the combined modified state bits for our RenderState hierarchy.
-    long stateOverrideBits = _state ? _state->_bits : 0;
-    RenderState* rs = _parent;
-    while (rs)
+    long stateOverrideBits = 0;
+    for (size_t i = 0, count = pass->_boundStates.size(); i < count; ++i)
     {
-        if (rs->_state)
-        {
-            stateOverrideBits |= rs->_state->_bits;
-        }
-        rs = rs->_parent;
+        stateOverrideBits |= pass->_boundStates[i]->_bits;
+    }
+    if (_stateOverride)
+    {
+        stateOverrideBits |= _stateOverride->_bits;
     }
 
     // Restore renderer state to its default, except for explicitly specified states
     StateBlock::restore(stateOverrideBits);
 
-    // Apply parameter bindings and renderer state for the entire hierarchy, top-down.
-    rs = NULL;
+    // Update the shared camera parameters for effects that read them from the frame uniform buffer.
     Effect* effect = pass->getEffect();
-    while ((rs = getTopmost(rs)))
+    if (effect->hasFrameUniforms())
     {
-        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        Node* node = NULL;
+        for (RenderState* rs = this; rs != NULL && node == NULL; rs = rs->_parent)
         {
-            GP_ASSERT(rs->_parameters[i]);
-            rs->_parameters[i]->bind(effect);
+            node = rs->_nodeBinding;
         }
+        bindFrameUniforms(node);
+    }
 
-        if (rs->_state)
-        {
-            rs->_state->bindNoRestore();
-        }
+    // Apply the parameter bindings, then the renderer state of the hierarchy top-down.
+    for (size_t i = 0, count = pass->_boundParameters.size(); i < count; ++i)
+    {
+        const Pass::BoundParameter& bound = pass->_boundParameters[i];
+        bound.parameter->_uniform = bound.uniform;
+        bound.parameter->applyValue(effect);
+    }
+    for (size_t i = 0, count = pass->_boundStates.size(); i < count; ++i)
+    {
+        pass->_boundStates[i]->bindNoRestore();
+    }
+    if (_stateOverride)
+    {
+        _stateOverride->bindNoRestore();
     }
 }
 
-RenderState* RenderState::getTopmost(RenderState* below)
+// Mixes a value into a running sort key.
+static unsigned int mixKey(unsigned int key, unsigned int value)
 {
-    RenderState* rs = this;
-    if (rs == below)
+    return (key ^ value) * 16777619U;
+}
+
+unsigned int RenderState::getStateKey(bool* blended, bool* depthWritten) const
+{
+    // Resolve the effective state of the hierarchy. States set lower in the
+    // hierarchy override those above, so only the first value found is kept.
+    unsigned int key = 2166136261U;
+    bool blend = false;
+    bool depthTest = false;
+    bool depthWrite = true;
+    long resolved = 0;
+    for (const RenderState* rs = this; rs != NULL; rs = rs->_parent)
     {
-        // Nothing below ourself.
-        return NULL;
+        const StateBlock* state = rs->_state;
+        if (state == NULL)
+            continue;
+
+        long bits = state->_bits & ~resolved;
+        if (bits & RS_BLEND)
+            blend = state->_blendEnabled;
+        if (bits & RS_BLEND_FUNC)
+            key = mixKey(mixKey(key, state->_blendSrc), state->_blendDst);
+        if (bits & RS_CULL_FACE)
+            key = mixKey(key, state->_cullFaceEnabled ? 1 : 0);
+        if (bits & RS_CULL_FACE_SIDE)
+            key = mixKey(key, state->_cullFaceSide);
+        if (bits & RS_FRONT_FACE)
+            key = mixKey(key, state->_frontFace);
+        if (bits & RS_DEPTH_TEST)
+        {
+            depthTest = state->_depthTestEnabled;
+            key = mixKey(key, depthTest ? 1 : 0);
+        }
+        if (bits & RS_DEPTH_WRITE)
+        {
+            depthWrite = state->_depthWriteEnabled;
+            key = mixKey(key, depthWrite ? 1 : 0);
+        }
+        if (bits & RS_DEPTH_FUNC)
+            key = mixKey(key, state->_depthFunction);
+        if (bits & RS_STENCIL_TEST)
+            key = mixKey(key, state->_stencilTestEnabled ? 1 : 0);
+        if (bits & RS_STENCIL_WRITE)
+            key = mixKey(key, state->_stencilWrite);
+        if (bits & RS_STENCIL_FUNC)
+            key = mixKey(mixKey(mixKey(key, state->_stencilFunction), state->_stencilFunctionRef), state->_stencilFunctionMask);
+        if (bits & RS_STENCIL_OP)
+            key = mixKey(mixKey(mixKey(key, state->_stencilOpSfail), state->_stencilOpDpfail), state->_stencilOpDppass);
+
+        // Mix in which states were resolved so that different combinations never collide trivially.
+        key = mixKey(key, (unsigned int)bits);
+        resolved |= state->_bits;
     }
 
-    while (rs)
+    if (blended)
+        *blended = blend;
+    if (depthWritten)
+        *depthWritten = depthTest && depthWrite;
+
+    return mixKey(key, blend ? 1 : 0);
+}
+
+unsigned int RenderState::getTextureKey() const
+{
+    unsigned int key = 2166136261U;
+    for (const RenderState* rs = this; rs != NULL; rs = rs->_parent)
     {
-        if (rs->_parent == below || rs->_parent == NULL)
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
         {
-            // Stop traversing up here.
-            return rs;
+            Texture::Sampler* sampler = rs->_parameters[i]->getSampler();
+            if (sampler && sampler->getTexture())
+            {
+                key = mixKey(key, (unsigned int)sampler->getTexture()->getHandle());
+            }
         }
-        rs = rs->_parent;
     }
-
-    return NULL;
+    return key;
 }
 
 void RenderState::cloneInto(RenderState* renderState, NodeCloneContext& context) const
@@ -455,9 +825,10 @@ void RenderState::cloneInto(RenderState* renderState, NodeCloneContext& context)
     GP_ASSERT(renderState);
 
     // Clone parameters
-    for (std::map<std::string, std::string>::const_iterator it = _autoBindings.begin(); it != _autoBindings.end(); ++it)
+    for (size_t i = 0, count = _autoBindings.size(); i < count; ++i)
     {
-        renderState->setParameterAutoBinding(it->first.c_str(), it->second.c_str());
+        const AutoBindingEntry& entry = _autoBindings[i];
+        renderState->setParameterAutoBinding(entry.uniformName.c_str(), entry.autoBinding, entry.customBinding.c_str());
     }
     for (std::vector<MaterialParameter*>::const_iterator it = _parameters.begin(); it != _parameters.end(); ++it)
     {
@@ -473,6 +844,7 @@ void RenderState::cloneInto(RenderState* renderState, NodeCloneContext& context)
         param->cloneInto(paramCopy);
 
         renderState->_parameters.push_back(paramCopy);
+        ++_bindListRevision;
     }
 
     // Clone our state block
@@ -526,6 +898,13 @@ void RenderState::StateBlock::bindNoRestore()
 {
     GP_ASSERT(_defaultState);
 
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->bindState(this);
+        return;
+    }
+
     // Update any state that differs from _defaultState and flip _defaultState bits
     if ((_bits & RS_BLEND) && (_blendEnabled != _defaultState->_blendEnabled))
     {
@@ -616,6 +995,13 @@ void RenderState::StateBlock::restore(long stateOverrideBits)
 {
     GP_ASSERT(_defaultState);
 
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->restoreState(stateOverrideBits);
+        return;
+    }
+
     // If there is no state to restore (i.e. no non-default state), do nothing.
     if (_defaultState->_bits == 0)
     {
@@ -2,8 +2,10 @@
 #define RENDERSTATE_H_
 
 #include "Ref.h"
+#include "Vector2.h"
 #include "Vector3.h"
 #include "Vector4.h"
+#include "Texture.h"
 
 namespace gameplay
 {
@@ -23,6 +25,9 @@ class RenderState : public Ref
     friend class Technique;
     friend class Pass;
     friend class Model;
+    friend class RenderQueue;
+    friend class PostProcessChain;
+    friend class CommandBuffer;
 
 public:
 
@@ -156,10 +161,69 @@ public:
          */
         MATRIX_PALETTE,
 
+        /**
+         * Binds a sampler for the matrix palette texture of MeshSkin attached to a node's model.
+         */
+        MATRIX_PALETTE_TEXTURE,
+
+        /**
+         * Binds the texel size (Vector2) of the matrix palette texture of MeshSkin attached to a node's model.
+         */
+        MATRIX_PALETTE_TEXEL_SIZE,
+
         /**
          * Binds the current scene's ambient color (Vector3).
          */
-        SCENE_AMBIENT_COLOR
+        SCENE_AMBIENT_COLOR,
+
+        /**
+         * Binds the colors (Vector3 array) of the point lights that influence a node the most (see Scene::getNodeLights).
+         *
+         * Up to 8 lights are bound, most influential first, and the colors past the selected lights are black,
+         * so a shader that declares fewer lights uses the lights that matter most and ignores the rest.
+         */
+        POINT_LIGHT_COLOR,
+
+        /**
+         * Binds the view-space positions (Vector3 array) of the point lights that influence a node the most.
+         */
+        POINT_LIGHT_POSITION,
+
+        /**
+         * Binds the inverse ranges (float array) of the point lights that influence a node the most.
+         */
+        POINT_LIGHT_RANGE_INVERSE,
+
+        /**
+         * Binds the colors (Vector3 array) of the spot lights that influence a node the most,
+         * in the same way as POINT_LIGHT_COLOR.
+         */
+        SPOT_LIGHT_COLOR,
+
+        /**
+         * Binds the view-space positions (Vector3 array) of the spot lights that influence a node the most.
+         */
+        SPOT_LIGHT_POSITION,
+
+        /**
+         * Binds the view-space directions (Vector3 array) of the spot lights that influence a node the most.
+         */
+        SPOT_LIGHT_DIRECTION,
+
+        /**
+         * Binds the inverse ranges (float array) of the spot lights that influence a node the most.
+         */
+        SPOT_LIGHT_RANGE_INVERSE,
+
+        /**
+         * Binds the cosines of the inner angles (float array) of the spot lights that influence a node the most.
+         */
+        SPOT_LIGHT_INNER_ANGLE_COS,
+
+        /**
+         * Binds the cosines of the outer angles (float array) of the spot lights that influence a node the most.
+         */
+        SPOT_LIGHT_OUTER_ANGLE_COS
     };
 
     /**
@@ -272,6 +336,7 @@ public:
     {
         friend class RenderState;
         friend class Game;
+        friend class CommandBuffer;
 
     public:
 
@@ -515,7 +580,7 @@ public:
      * Sets a material parameter auto-binding.
      *
      * @param name The name of the material parameter to store an auto-binding for.
-     * @param autoBinding A valid AutoBinding value.
+     * @param autoBinding A valid AutoBinding value, or NONE to remove the auto-binding.
      */
     void setParameterAutoBinding(const char* name, AutoBinding autoBinding);
 
@@ -571,6 +636,20 @@ public:
      */
     virtual void setNodeBinding(Node* node);
 
+    /**
+     * Returns whether effects can read the camera parameters from the shared frame uniform buffer.
+     *
+     * When supported (uniform buffer objects on desktop OpenGL), every shader is compiled
+     * with the FRAME_UNIFORMS define, and shaders can then declare the "FrameUniforms"
+     * uniform block by including res/shaders/frame-uniforms.vert. The view, projection
+     * and view-projection matrices and the world and view space positions of the active
+     * camera are uploaded to a single buffer when the camera changes, and shared by all
+     * effects, instead of being set for the pass of every drawn material.
+     *
+     * @return True if the frame uniform buffer is supported.
+     */
+    static bool isFrameUniformBufferSupported();
+
 protected:
 
     /**
@@ -594,23 +673,50 @@ protected:
     static void finalize();
 
     /**
-     * Applies the specified custom auto-binding.
+     * Points the auto-bindings of this render state and of its parents at another node,
+     * without resolving them again.
      *
-     * @param uniformName Name of the shader uniform.
-     * @param autoBinding Name of the auto binding.s
+     * The built-in auto-bindings read the node binding when they are bound, so this lets a
+     * material shared by several models be drawn for each of their nodes in turn.
+     *
+     * @param node The node to use for the built-in auto-bindings.
      */
-    void applyAutoBinding(const char* uniformName, const char* autoBinding);
+    void retargetNodeBinding(Node* node);
 
     /**
-     * Binds the render state for this RenderState and any of its parents, top-down, 
-     * for the given pass.
+     * Defines an auto-binding of a material parameter, resolved when it is set.
      */
-    void bind(Pass* pass);
+    struct AutoBindingEntry
+    {
+        /** The name of the shader uniform. */
+        std::string uniformName;
+        /** The built-in auto-binding, or NONE for a custom one. */
+        AutoBinding autoBinding;
+        /** The name of the custom auto-binding, resolved by the registered AutoBindingResolvers. */
+        std::string customBinding;
+    };
+
+    /**
+     * Adds or updates an auto-binding, and applies it if it can be resolved now.
+     *
+     * @param name The name of the material parameter.
+     * @param autoBinding The built-in auto-binding, or NONE for a custom one.
+     * @param customBinding The name of the custom auto-binding, if autoBinding is NONE.
+     */
+    void setParameterAutoBinding(const char* name, AutoBinding autoBinding, const char* customBinding);
 
     /**
-     * Returns the topmost RenderState in the hierarchy below the given RenderState.
+     * Binds the material parameter of the specified auto-binding.
+     *
+     * @param entry The auto-binding.
+     */
+    void applyAutoBinding(const AutoBindingEntry& entry);
+
+    /**
+     * Binds the render state for this RenderState and any of its parents, top-down, 
+     * for the given pass.
      */
-    RenderState* getTopmost(RenderState* below);
+    void bind(Pass* pass);
 
     /**
      * Copies the data from this RenderState into the given RenderState.
@@ -620,6 +726,25 @@ protected:
      */
     void cloneInto(RenderState* renderState, NodeCloneContext& context) const;
 
+    /**
+     * Computes a key identifying the combined renderer state of this RenderState hierarchy.
+     *
+     * RenderStates that produce the same key apply the same renderer state when bound.
+     *
+     * @param blended Set to true if the combined state enables blending.
+     * @param depthWritten Set to true if the combined state both tests and writes depth.
+     *
+     * @return The state key.
+     */
+    unsigned int getStateKey(bool* blended, bool* depthWritten = NULL) const;
+
+    /**
+     * Computes a key identifying the set of textures bound by this RenderState hierarchy.
+     *
+     * @return The texture key.
+     */
+    unsigned int getTextureKey() const;
+
 private:
 
     /**
@@ -632,6 +757,30 @@ private:
      */
     RenderState& operator=(const RenderState&);
 
+    /**
+     * Defines the contents of the frame uniform buffer, laid out to match the std140
+     * layout of the FrameUniforms block.
+     */
+    struct FrameUniforms
+    {
+        float viewMatrix[16];
+        float projectionMatrix[16];
+        float viewProjectionMatrix[16];
+        float cameraWorldPosition[4];
+        float cameraViewPosition[4];
+    };
+
+    /**
+     * Uploads the camera parameters of the specified node's scene to the frame uniform
+     * buffer, if they changed since the last upload.
+     */
+    static void bindFrameUniforms(Node* node);
+
+    /**
+     * Uploads the specified camera parameters to the frame uniform buffer, if they changed.
+     */
+    static void uploadFrameUniforms(const FrameUniforms& uniforms);
+
     // Internal auto binding handler methods.
     const Matrix& autoBindingGetWorldMatrix() const;
     const Matrix& autoBindingGetViewMatrix() const;
@@ -645,7 +794,19 @@ private:
     Vector3 autoBindingGetCameraViewPosition() const;
     const Vector4* autoBindingGetMatrixPalette() const;
     unsigned int autoBindingGetMatrixPaletteSize() const;
+    const Texture::Sampler* autoBindingGetMatrixPaletteSampler() const;
+    const Vector2& autoBindingGetMatrixPaletteTexelSize() const;
     const Vector3& autoBindingGetAmbientColor() const;
+    const Vector3* autoBindingGetPointLightColor() const;
+    const Vector3* autoBindingGetPointLightPosition() const;
+    const float* autoBindingGetPointLightRangeInverse() const;
+    const Vector3* autoBindingGetSpotLightColor() const;
+    const Vector3* autoBindingGetSpotLightPosition() const;
+    const Vector3* autoBindingGetSpotLightDirection() const;
+    const float* autoBindingGetSpotLightRangeInverse() const;
+    const float* autoBindingGetSpotLightInnerAngleCos() const;
+    const float* autoBindingGetSpotLightOuterAngleCos() const;
+    unsigned int autoBindingGetNodeLightCount() const;
     const Vector3& autoBindingGetLightColor() const;
     const Vector3& autoBindingGetLightDirection() const;
 
@@ -657,9 +818,9 @@ protected:
     mutable std::vector<MaterialParameter*> _parameters;
 
     /**
-     * Map of parameter names to auto binding strings.
+     * The auto-bindings of the parameters, resolved to AutoBinding values when they are set.
      */
-    std::map<std::string, std::string> _autoBindings;
+    std::vector<AutoBindingEntry> _autoBindings;
 
     /**
      * The Node bound to the RenderState.
@@ -680,6 +841,25 @@ protected:
      * Map of custom auto binding resolvers.
      */
     static std::vector<AutoBindingResolver*> _customAutoBindingResolvers;
+
+    /**
+     * The shared frame uniform buffer and its last uploaded contents.
+     */
+    static GLuint _frameUniformBuffer;
+    static FrameUniforms _frameUniforms;
+
+    /**
+     * Changed whenever the parameters, state block or parent of any RenderState change,
+     * so that passes recompile their bind lists before they are next bound.
+     */
+    static unsigned int _bindListRevision;
+
+    /**
+     * A state block applied over the state of every pass that is bound, or NULL.
+     *
+     * Render queues use it to draw their opaque passes with the depth pre-pass results.
+     */
+    static StateBlock* _stateOverride;
 };
 
 }
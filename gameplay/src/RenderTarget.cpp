@@ -7,7 +7,7 @@ namespace gameplay
 static std::vector<RenderTarget*> __renderTargets;
 
 RenderTarget::RenderTarget(const char* id)
-    : _id(id ? id : ""), _texture(NULL)
+    : _id(id ? id : ""), _texture(NULL), _face(0)
 {
 }
 
@@ -44,12 +44,23 @@ RenderTarget* RenderTarget::create(const char* id, Texture* texture)
     RenderTarget* renderTarget = new RenderTarget(id);
     renderTarget->_texture = texture;
     renderTarget->_texture->addRef();
+    renderTarget->_texture->setMemoryCategory(GraphicsMemory::RENDER_TARGET);
 
     __renderTargets.push_back(renderTarget);
 
     return renderTarget;
 }
 
+RenderTarget* RenderTarget::create(const char* id, Texture* texture, unsigned int face)
+{
+    GP_ASSERT(texture && texture->getType() == Texture::TEXTURE_CUBE);
+    GP_ASSERT(face < 6);
+
+    RenderTarget* renderTarget = create(id, texture);
+    renderTarget->_face = face;
+    return renderTarget;
+}
+
 RenderTarget* RenderTarget::getRenderTarget(const char* id)
 {
     GP_ASSERT(id);
@@ -79,6 +90,11 @@ Texture* RenderTarget::getTexture() const
     return _texture;
 }
 
+unsigned int RenderTarget::getFace() const
+{
+    return _face;
+}
+
 unsigned int RenderTarget::getWidth() const
 {
     return _texture->getWidth();
@@ -46,6 +46,19 @@ public:
      */
     static RenderTarget* create(const char* id, Texture* texture);
 
+    /**
+     * Create a RenderTarget that draws into a face of a cube map texture, and add it to the
+     * list of available RenderTargets.
+     *
+     * @param id The ID of the new RenderTarget.
+     * @param texture The cube map texture (see Texture::createCube).
+     * @param face The face drawn into, from 0 to 5 in the order +X, -X, +Y, -Y, +Z, -Z.
+     *
+     * @return A newly created RenderTarget.
+     * @script{ignore}
+     */
+    static RenderTarget* create(const char* id, Texture* texture, unsigned int face);
+
     /**
      * Get a named RenderTarget from its ID.
      *
@@ -69,6 +82,14 @@ public:
      */
     Texture* getTexture() const;
 
+    /**
+     * Returns the face of the cube map texture this RenderTarget draws into.
+     *
+     * @return The face, or 0 for a 2D texture.
+     * @script{ignore}
+     */
+    unsigned int getFace() const;
+
     /**
      * Returns the width of the RenderTarget.
      *
@@ -102,6 +123,7 @@ private:
 
     std::string _id;
     Texture* _texture;
+    unsigned int _face;
 };
 
 }
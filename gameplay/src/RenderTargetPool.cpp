@@ -0,0 +1,116 @@
+#include "Base.h"
+#include "RenderTargetPool.h"
+
+namespace gameplay
+{
+
+/**
+ * Identifies the render targets that can be exchanged for one another.
+ */
+struct RenderTargetKey
+{
+    RenderTargetKey(unsigned int width, unsigned int height, Texture::Format format)
+        : width(width), height(height), format(format)
+    {
+    }
+
+    bool operator<(const RenderTargetKey& key) const
+    {
+        if (width != key.width)
+            return width < key.width;
+        if (height != key.height)
+            return height < key.height;
+        return format < key.format;
+    }
+
+    unsigned int width;
+    unsigned int height;
+    Texture::Format format;
+};
+
+static std::map<RenderTargetKey, std::vector<RenderTarget*> > __freeTargets;
+static std::vector<RenderTarget*> __acquiredTargets;
+static unsigned int __pooledTargetCount = 0;
+
+RenderTarget* RenderTargetPool::acquire(unsigned int width, unsigned int height, Texture::Format format)
+{
+    GP_ASSERT(width > 0 && height > 0);
+    GP_ASSERT(format == Texture::RGB || format == Texture::RGBA);
+
+    RenderTarget* renderTarget = NULL;
+    std::vector<RenderTarget*>& targets = __freeTargets[RenderTargetKey(width, height, format)];
+    if (!targets.empty())
+    {
+        renderTarget = targets.back();
+        targets.pop_back();
+    }
+    else
+    {
+        Texture* texture = Texture::create(format, width, height, NULL, false);
+        if (texture == NULL)
+        {
+            GP_ERROR("Failed to create texture for pooled render target.");
+            return NULL;
+        }
+
+        char id[32];
+        sprintf(id, "__pooledTarget%u", __pooledTargetCount++);
+        renderTarget = RenderTarget::create(id, texture);
+        SAFE_RELEASE(texture);
+    }
+
+    __acquiredTargets.push_back(renderTarget);
+    return renderTarget;
+}
+
+void RenderTargetPool::release(RenderTarget* renderTarget)
+{
+    GP_ASSERT(renderTarget);
+
+    std::vector<RenderTarget*>::iterator itr = std::find(__acquiredTargets.begin(), __acquiredTargets.end(), renderTarget);
+    if (itr == __acquiredTargets.end())
+    {
+        GP_ERROR("Render target '%s' was not acquired from the pool.", renderTarget->getId());
+        return;
+    }
+    __acquiredTargets.erase(itr);
+
+    Texture* texture = renderTarget->getTexture();
+    GP_ASSERT(texture);
+    __freeTargets[RenderTargetKey(texture->getWidth(), texture->getHeight(), texture->getFormat())].push_back(renderTarget);
+}
+
+void RenderTargetPool::clear()
+{
+    for (std::map<RenderTargetKey, std::vector<RenderTarget*> >::iterator itr = __freeTargets.begin(); itr != __freeTargets.end(); ++itr)
+    {
+        std::vector<RenderTarget*>& targets = itr->second;
+        for (size_t i = 0, count = targets.size(); i < count; ++i)
+        {
+            SAFE_RELEASE(targets[i]);
+        }
+    }
+    __freeTargets.clear();
+}
+
+unsigned int RenderTargetPool::getTargetCount()
+{
+    unsigned int count = (unsigned int)__acquiredTargets.size();
+    for (std::map<RenderTargetKey, std::vector<RenderTarget*> >::const_iterator itr = __freeTargets.begin(); itr != __freeTargets.end(); ++itr)
+    {
+        count += (unsigned int)itr->second.size();
+    }
+    return count;
+}
+
+void RenderTargetPool::finalize()
+{
+    for (size_t i = 0, count = __acquiredTargets.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(__acquiredTargets[i]);
+    }
+    __acquiredTargets.clear();
+    clear();
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef RENDERTARGETPOOL_H_
+#define RENDERTARGETPOOL_H_
+
+#include "RenderTarget.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of render targets that are reused by size and format.
+ *
+ * Effects that render into intermediate targets every frame (such as post-processing)
+ * acquire a render target from the pool, draw into it and release it back once it has
+ * been consumed. Released targets are handed out again by the next acquire() with the
+ * same size and format, so steady-state frames allocate no textures.
+ *
+ * Pooled render targets stay allocated until clear() is called, for example after the
+ * window has been resized. The pool is cleared when the game shuts down.
+ *
+ * @script{ignore}
+ */
+class RenderTargetPool
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Acquires a render target of the specified size and format.
+     *
+     * The render target is taken from the pool if one of the same size and format is free,
+     * and created otherwise. It must be given back with release() once it is no longer used.
+     *
+     * @param width The width of the render target.
+     * @param height The height of the render target.
+     * @param format The format of the render target texture (RGB or RGBA).
+     *
+     * @return The render target, owned by the pool.
+     */
+    static RenderTarget* acquire(unsigned int width, unsigned int height, Texture::Format format = Texture::RGBA);
+
+    /**
+     * Gives a render target back to the pool.
+     *
+     * @param renderTarget The render target previously returned by acquire().
+     */
+    static void release(RenderTarget* renderTarget);
+
+    /**
+     * Frees the render targets that are not currently acquired.
+     */
+    static void clear();
+
+    /**
+     * Returns the number of render targets allocated by the pool, including acquired ones.
+     *
+     * @return The number of render targets.
+     */
+    static unsigned int getTargetCount();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    RenderTargetPool();
+
+    /**
+     * Frees all the render targets of the pool.
+     */
+    static void finalize();
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "Base.h"
+#include "RenderThread.h"
+#include "Platform.h"
+#include "Game.h"
+
+namespace gameplay
+{
+
+RenderThread::RenderThread()
+    : _thread(NULL), _recordIndex(0), _pending(false), _present(true), _exit(false)
+{
+}
+
+RenderThread::~RenderThread()
+{
+    waitForFrame();
+    {
+        Mutex::Lock lock(_mutex);
+        _exit = true;
+        _condition.broadcast();
+    }
+    SAFE_DELETE(_thread);
+
+    // Take the context back to release the references of the buffers.
+    if (!Platform::setGraphicsContextCurrent(true))
+    {
+        GP_ERROR("Failed to make the graphics context current on the game thread.");
+    }
+    _buffers[0].reset();
+    _buffers[1].reset();
+}
+
+RenderThread* RenderThread::create()
+{
+    if (!Platform::setGraphicsContextCurrent(false))
+    {
+        GP_WARN("The graphics context cannot be moved to a render thread on this platform; rendering on the game thread.");
+        return NULL;
+    }
+
+    RenderThread* renderThread = new RenderThread();
+    renderThread->_thread = Thread::create(&RenderThread::renderThreadMain, renderThread);
+    if (renderThread->_thread == NULL)
+    {
+        GP_WARN("Failed to create the render thread; rendering on the game thread.");
+        SAFE_DELETE(renderThread);
+    }
+    return renderThread;
+}
+
+void RenderThread::beginFrame()
+{
+    _buffers[_recordIndex].begin();
+
+    // The viewport may have been set while nothing was recorded.
+    _buffers[_recordIndex].setViewport(Game::getInstance()->getViewport());
+}
+
+void RenderThread::endFrame()
+{
+    _buffers[_recordIndex].end();
+
+    waitForFrame();
+    if (!Platform::setGraphicsContextCurrent(true))
+    {
+        GP_ERROR("Failed to make the graphics context current on the game thread.");
+    }
+}
+
+void RenderThread::submitFrame(bool present)
+{
+    // The buffer drawn last is recorded next; release what it referenced while the context is current.
+    _buffers[1 - _recordIndex].reset();
+    Platform::setGraphicsContextCurrent(false);
+
+    Mutex::Lock lock(_mutex);
+    _recordIndex = 1 - _recordIndex;
+    _pending = true;
+    _present = present;
+    _condition.broadcast();
+}
+
+void RenderThread::waitForFrame()
+{
+    Mutex::Lock lock(_mutex);
+    while (_pending)
+    {
+        _condition.wait(_mutex);
+    }
+}
+
+int RenderThread::renderThreadMain(void* arg)
+{
+    RenderThread* renderThread = (RenderThread*)arg;
+    GP_ASSERT(renderThread);
+    Game* game = Game::getInstance();
+    GP_ASSERT(game);
+
+    while (true)
+    {
+        CommandBuffer* buffer;
+        bool present;
+        {
+            Mutex::Lock lock(renderThread->_mutex);
+            while (!renderThread->_pending && !renderThread->_exit)
+            {
+                renderThread->_condition.wait(renderThread->_mutex);
+            }
+            if (renderThread->_exit)
+                break;
+
+            // The game thread records into the other buffer until this one is drawn.
+            buffer = &renderThread->_buffers[1 - renderThread->_recordIndex];
+            present = renderThread->_present;
+        }
+
+        if (Platform::setGraphicsContextCurrent(true))
+        {
+            game->beginRenderStats();
+            buffer->execute();
+            game->endRenderStats();
+            if (present)
+                Platform::swapBuffers();
+            Platform::setGraphicsContextCurrent(false);
+        }
+        else
+        {
+            GP_ERROR("Failed to make the graphics context current on the render thread.");
+        }
+
+        Mutex::Lock lock(renderThread->_mutex);
+        renderThread->_pending = false;
+        renderThread->_condition.broadcast();
+    }
+    return 0;
+}
+
+}
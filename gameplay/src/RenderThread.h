@@ -0,0 +1,92 @@
+#ifndef RENDERTHREAD_H_
+#define RENDERTHREAD_H_
+
+#include "CommandBuffer.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the thread that executes the drawing recorded by the game thread.
+ *
+ * Each frame, the game thread records its rendering into one of two command buffers
+ * while the render thread executes the other one, recorded during the previous frame,
+ * and swaps the buffers of the display. The graphics context moves between the threads:
+ * the render thread holds it while executing a frame, and the game thread holds it
+ * between frames, while it completes the resource loads that need it.
+ *
+ * @see Game::setRenderThreaded
+ */
+class RenderThread
+{
+    friend class Game;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    RenderThread();
+
+    /**
+     * Destructor. Waits for the submitted frame to be drawn and takes the graphics context back.
+     */
+    ~RenderThread();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderThread(const RenderThread& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderThread& operator=(const RenderThread&);
+
+    /**
+     * Starts the render thread and gives it the graphics context of the calling thread.
+     *
+     * @return The render thread, or NULL if the platform cannot share the context between threads.
+     */
+    static RenderThread* create();
+
+    /**
+     * Starts recording the drawing of the calling thread.
+     */
+    void beginFrame();
+
+    /**
+     * Stops recording, waits for the previous frame to be drawn and makes the graphics
+     * context current on the calling thread.
+     */
+    void endFrame();
+
+    /**
+     * Releases the graphics context and has the render thread draw the recorded frame.
+     *
+     * @param present true to swap the buffers of the display once the frame is drawn, false
+     *      to keep showing the last frame presented, when nothing new was drawn.
+     */
+    void submitFrame(bool present = true);
+
+    /**
+     * Waits until the render thread has drawn the submitted frame.
+     */
+    void waitForFrame();
+
+    static int renderThreadMain(void* arg);
+
+    Thread* _thread;
+    Mutex _mutex;
+    Condition _condition;
+    CommandBuffer _buffers[2];
+    unsigned int _recordIndex;
+    bool _pending;
+    bool _present;
+    bool _exit;
+};
+
+}
+
+#endif
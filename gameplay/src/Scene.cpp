@@ -6,6 +6,19 @@
 #include "Joint.h"
 #include "Terrain.h"
 #include "Bundle.h"
+#include "MeshBVH.h"
+#include "ScriptFunction.h"
+
+// The number of steps a ray takes over the heights of a terrain, across the diagonal of its bounds.
+#define SCENE_RAYCAST_TERRAIN_STEPS 256
+
+// The number of bisections that find where a ray passes below the heights of a terrain within a step.
+#define SCENE_RAYCAST_TERRAIN_BISECTIONS 10
+
+// How the world matrix of a node in the flat transform store is computed.
+#define SCENE_FLAT_STATIC 0
+#define SCENE_FLAT_LOCAL 1
+#define SCENE_FLAT_INHERITED 2
 
 namespace gameplay
 {
@@ -13,6 +26,9 @@ namespace gameplay
 // Global list of active scenes
 static std::vector<Scene*> __sceneList;
 
+// Skins gathered for the batched matrix palette update
+static std::vector<MeshSkin*> __skins;
+
 static inline char lowercase(char c)
 {
     if (c >= 'A' && c <='Z')
@@ -60,8 +76,9 @@ static bool endsWith(const char* str, const char* suffix, bool ignoreCase)
 
 
 Scene::Scene()
-    : _id(""), _activeCamera(NULL), _firstNode(NULL), _lastNode(NULL), _nodeCount(0), _bindAudioListenerToCamera(true), 
-      _nextItr(NULL), _nextReset(true)
+    : _id(""), _activeCamera(NULL), _capturedActiveCamera(NULL), _firstNode(NULL), _lastNode(NULL), _nodeCount(0), _bindAudioListenerToCamera(true), 
+      _nextItr(NULL), _nextReset(true), _octree(NULL), _visibilitySet(NULL), _depthPyramid(NULL), _flatNodesDirty(true),
+      _lightInfluencesDirty(true), _capturedOctreeRevision(0)
 {
     __sceneList.push_back(this);
 }
@@ -79,10 +96,16 @@ Scene::~Scene()
 
         SAFE_RELEASE(_activeCamera);
     }
+    SAFE_RELEASE(_capturedActiveCamera);
+
+    SAFE_RELEASE(_visibilitySet);
+    SAFE_RELEASE(_depthPyramid);
 
     // Remove all nodes from the scene
     removeAllNodes();
 
+    SAFE_DELETE(_octree);
+
     // Remove the scene from global list
     std::vector<Scene*>::iterator itr = std::find(__sceneList.begin(), __sceneList.end(), this);
     if (itr != __sceneList.end())
@@ -141,6 +164,14 @@ Node* Scene::findNode(const char* id, bool recursive, bool exactMatch) const
 {
     GP_ASSERT(id);
 
+    // Look the ID up in the index instead of searching the whole scene.
+    if (recursive && exactMatch)
+    {
+        Node* match = NULL;
+        if (lookupNode(id, NULL, &match))
+            return match;
+    }
+
     // Search immediate children first.
     for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
     {
@@ -172,6 +203,10 @@ unsigned int Scene::findNodes(const char* id, std::vector<Node*>& nodes, bool re
 
     unsigned int count = 0;
 
+    // Skip the search when no node of the scene has the ID.
+    if (recursive && exactMatch && _nodeIds.count(Node::hashId(id)) == 0)
+        return 0;
+
     // Search immediate children first.
     for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
     {
@@ -195,27 +230,99 @@ unsigned int Scene::findNodes(const char* id, std::vector<Node*>& nodes, bool re
     return count;
 }
 
-void Scene::visitNode(Node* node, const char* visitMethod)
+unsigned int Scene::findNodesByTag(const char* name, std::vector<Node*>& nodes, const char* value) const
 {
-    ScriptController* sc = Game::getInstance()->getScriptController();
+    GP_ASSERT(name);
 
-    // Invoke the visit method for this node.
-    if (!sc->executeFunction<bool>(visitMethod, "<Node>", node))
-        return;
+    unsigned int key = Node::getTagKey(name, false);
+    if (key == Node::TAG_KEY_NONE)
+        return 0;
 
-    // If this node has a model with a mesh skin, visit the joint hierarchy within it
-    // since we don't add joint hierarcies directly to the scene. If joints are never
-    // visited, it's possible that nodes embedded within the joint hierarchy that contain
-    // models will never get visited (and therefore never get drawn).
-    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    unsigned int count = 0;
+    std::pair<std::multimap<unsigned int, Node*>::const_iterator, std::multimap<unsigned int, Node*>::const_iterator> range = _nodeTags.equal_range(key);
+    for (std::multimap<unsigned int, Node*>::const_iterator itr = range.first; itr != range.second; ++itr)
     {
-        visitNode(node->_model->_skin->_rootNode, visitMethod);
+        if (value == NULL || strcmp(itr->second->getTag(name), value) == 0)
+        {
+            nodes.push_back(itr->second);
+            ++count;
+        }
     }
+    return count;
+}
 
-    // Recurse for all children.
+void Scene::visit(const char* visitMethod)
+{
+    ScriptFunction function(visitMethod);
+    visit(function);
+}
+
+void Scene::visit(ScriptFunction& visitMethod)
+{
+    std::vector<Node*> stack;
+    pushVisitRoots(stack);
+    while (!stack.empty())
+    {
+        Node* node = stack.back();
+        stack.pop_back();
+        if (visitMethod.call<bool>(ScriptFunction::Object("Node", node)))
+        {
+            pushVisitChildren(node, stack);
+        }
+    }
+}
+
+void Scene::pushVisitRoots(std::vector<Node*>& stack) const
+{
+    size_t first = stack.size();
+    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        stack.push_back(node);
+    }
+    std::reverse(stack.begin() + first, stack.end());
+}
+
+void Scene::pushVisitChildren(Node* node, std::vector<Node*>& stack)
+{
+    GP_ASSERT(node);
+
+    size_t first = stack.size();
     for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
     {
-        visitNode(child, visitMethod);
+        stack.push_back(child);
+    }
+    std::reverse(stack.begin() + first, stack.end());
+
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        stack.push_back(node->_model->_skin->_rootNode);
+    }
+}
+
+void Scene::gatherVisitNodes(std::vector<Node*>& nodes) const
+{
+    nodes.reserve(_nodeCount);
+    std::vector<Node*> stack;
+    pushVisitRoots(stack);
+    while (!stack.empty())
+    {
+        Node* node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+        pushVisitChildren(node, stack);
+    }
+}
+
+void Scene::visitRanges(unsigned int count, JobScheduler::RangeFunction function, void* arg, unsigned int grainSize)
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler && scheduler->getWorkerCount() > 0 && count > grainSize)
+    {
+        scheduler->parallelFor(count, function, arg, grainSize);
+    }
+    else
+    {
+        function(arg, 0, count);
     }
 }
 
@@ -268,8 +375,16 @@ void Scene::addNode(Node* node)
     }
 
     node->_scene = this;
+    addToLookup(node);
 
     ++_nodeCount;
+    _flatNodesDirty = true;
+    _lightInfluencesDirty = true;
+
+    if (_octree)
+    {
+        indexNode(node, true);
+    }
 
     // If we don't have an active camera set, then check for one and set it.
     if (_activeCamera == NULL)
@@ -304,6 +419,8 @@ void Scene::removeNode(Node* node)
     SAFE_RELEASE(node);
 
     --_nodeCount;
+    _flatNodesDirty = true;
+    _lightInfluencesDirty = true;
 }
 
 void Scene::removeAllNodes()
@@ -326,11 +443,21 @@ Node* Scene::getFirstNode() const
 
 Camera* Scene::getActiveCamera()
 {
-    return _activeCamera;
+    return Game::isRenderingCaptured() && _capturedActiveCamera ? _capturedActiveCamera : _activeCamera;
 }
 
 void Scene::setActiveCamera(Camera* camera)
 {
+    if (Game::isRenderingCaptured() && _capturedActiveCamera)
+    {
+        // Set while drawing a pipelined frame, so the camera is only active for the rest of the frame.
+        if (camera)
+            camera->addRef();
+        SAFE_RELEASE(_capturedActiveCamera);
+        _capturedActiveCamera = camera;
+        return;
+    }
+
     // Make sure we don't release the camera if the same camera is set twice.
     if (_activeCamera != camera)
     {
@@ -384,6 +511,769 @@ void Scene::setAmbientColor(float red, float green, float blue)
     _ambientColor.set(red, green, blue);
 }
 
+unsigned int Scene::cull(Camera* camera, std::vector<Node*>& nodes)
+{
+    GP_ASSERT(camera);
+
+    buildOctree();
+
+    if (_visibilitySet)
+    {
+        // Hide the nodes of the visibility set that can't be seen from the camera's cell.
+        Node* cameraNode = camera->getNode();
+        _visibilitySet->setCell(cameraNode ? _visibilitySet->getCell(cameraNode->getTranslationWorld()) : -1);
+    }
+
+    if (_depthPyramid)
+    {
+        _depthPyramid->resolve();
+    }
+
+    return _octree->cull(camera->getFrustum(), nodes, true, _depthPyramid);
+}
+
+unsigned int Scene::cull(const Frustum& frustum, std::vector<Node*>& nodes)
+{
+    buildOctree();
+
+    return _octree->cull(frustum, nodes, false);
+}
+
+unsigned int Scene::cull(const Frustum* frustums, std::vector<Node*>** nodes, unsigned int count)
+{
+    buildOctree();
+
+    unsigned int total = 0;
+    for (unsigned int start = 0; start < count; start += OCTREE_MAX_FRUSTUMS)
+    {
+        total += _octree->cull(frustums + start, nodes + start, std::min(count - start, (unsigned int)OCTREE_MAX_FRUSTUMS));
+    }
+    return total;
+}
+
+unsigned int Scene::cull(SceneView** views, unsigned int count)
+{
+    GP_ASSERT(views || count == 0);
+
+    buildOctree();
+
+    // Nodes moved since the last cull change the revision once they are re-indexed.
+    _octree->update();
+    unsigned int revision = Game::isRenderingCaptured() ? _capturedOctreeRevision : _octree->getRevision();
+
+    std::vector<SceneView*> culled;
+    std::vector<Frustum> frustums;
+    std::vector<std::vector<Node*>*> nodes;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        SceneView* view = views[i];
+        GP_ASSERT(view);
+        view->_cached = view->isValid(revision);
+        if (view->_cached || std::find(culled.begin(), culled.end(), view) != culled.end())
+            continue;
+
+        view->_nodes.clear();
+        culled.push_back(view);
+        frustums.push_back(view->_camera->getFrustum());
+        nodes.push_back(&view->_nodes);
+    }
+    if (culled.empty())
+        return 0;
+
+    cull(&frustums[0], &nodes[0], (unsigned int)culled.size());
+
+    for (size_t i = 0, culledCount = culled.size(); i < culledCount; ++i)
+    {
+        SceneView* view = culled[i];
+        view->_queue.clear();
+        for (size_t j = 0, nodeCount = view->_nodes.size(); j < nodeCount; ++j)
+        {
+            view->_queue.add(view->_nodes[j]);
+        }
+        view->_viewProjection = view->_camera->getViewProjectionMatrix();
+        view->_revision = revision;
+        view->_valid = true;
+    }
+    return (unsigned int)culled.size();
+}
+
+Scene::RaycastFilter::RaycastFilter()
+{
+}
+
+Scene::RaycastFilter::~RaycastFilter()
+{
+}
+
+bool Scene::RaycastFilter::filter(Node* node)
+{
+    return false;
+}
+
+// Marches a ray over the heights of a terrain, and bisects the step where it passes below them.
+static bool raycastTerrain(Node* node, Terrain* terrain, const Ray& ray, float maxDistance, float* distance)
+{
+    BoundingBox box(terrain->getBoundingBox());
+    box.transform(node->getWorldMatrix());
+
+    const Vector3& origin = ray.getOrigin();
+    const Vector3& direction = ray.getDirection();
+    bool inside = origin.x >= box.min.x && origin.y >= box.min.y && origin.z >= box.min.z &&
+                  origin.x <= box.max.x && origin.y <= box.max.y && origin.z <= box.max.z;
+    float start = 0.0f;
+    if (!inside)
+    {
+        start = box.intersects(ray);
+        if (start == Ray::INTERSECTS_NONE || start > maxDistance)
+            return false;
+    }
+
+    float length = box.min.distance(box.max);
+    float end = std::min(start + length, maxDistance);
+    float step = length / SCENE_RAYCAST_TERRAIN_STEPS;
+    if (step <= 0.0f)
+        return false;
+
+    float previous = start;
+    for (float t = start; t <= end + step; t += step)
+    {
+        t = std::min(t, end);
+        Vector3 point = origin + direction * t;
+        if (point.x < box.min.x || point.z < box.min.z || point.x > box.max.x || point.z > box.max.z)
+        {
+            if (t > start)
+                break;
+        }
+        else if (point.y <= terrain->getHeight(point.x, point.z))
+        {
+            // The ray is below the surface at t and was above it at the previous step.
+            float above = previous;
+            float below = t;
+            for (unsigned int i = 0; i < SCENE_RAYCAST_TERRAIN_BISECTIONS && below > above; ++i)
+            {
+                float middle = (above + below) * 0.5f;
+                Vector3 p = origin + direction * middle;
+                if (p.y <= terrain->getHeight(p.x, p.z))
+                    below = middle;
+                else
+                    above = middle;
+            }
+            *distance = below;
+            return true;
+        }
+        previous = t;
+        if (t >= end)
+            break;
+    }
+    return false;
+}
+
+// Tests a ray against the content of a node whose bounds it hit, and returns the distance of the hit.
+static bool raycastNode(Node* node, const Ray& ray, float boundsDistance, float maxDistance, float* distance, int* triangle)
+{
+    *triangle = -1;
+    bool tested = false;
+    bool hit = false;
+    float nearest = maxDistance;
+
+    Model* model = node->getModel();
+    Mesh* mesh = model ? model->getMesh() : NULL;
+    if (mesh && model->getSkin() == NULL && mesh->hasPickingData())
+    {
+        tested = true;
+
+        // The direction is transformed without being normalized, so the distance along it stays in world units.
+        Matrix inverse;
+        const MeshBVH* bvh = mesh->getBVH();
+        if (bvh && node->getWorldMatrix().invert(&inverse))
+        {
+            Vector3 origin;
+            Vector3 direction;
+            inverse.transformPoint(ray.getOrigin(), &origin);
+            inverse.transformVector(ray.getDirection(), &direction);
+            float meshDistance;
+            unsigned int meshTriangle;
+            if (bvh->intersects(origin, direction, nearest, &meshDistance, &meshTriangle))
+            {
+                nearest = meshDistance;
+                *triangle = (int)meshTriangle;
+                hit = true;
+            }
+        }
+    }
+
+    Terrain* terrain = node->getTerrain();
+    if (terrain)
+    {
+        tested = true;
+        float terrainDistance;
+        if (raycastTerrain(node, terrain, ray, nearest, &terrainDistance))
+        {
+            nearest = terrainDistance;
+            *triangle = -1;
+            hit = true;
+        }
+    }
+
+    if (!tested)
+    {
+        *distance = boundsDistance;
+        return true;
+    }
+    if (hit)
+    {
+        *distance = nearest;
+    }
+    return hit;
+}
+
+bool Scene::raycast(const Ray& ray, float distance, RaycastHit* result, RaycastFilter* filter)
+{
+    buildOctree();
+
+    std::vector<std::pair<float, Node*> > candidates;
+    if (_octree->raycast(ray, distance, candidates) == 0)
+        return false;
+
+    // Test the nodes nearest first, until the next bounds are farther than the nearest hit.
+    std::sort(candidates.begin(), candidates.end());
+    Node* nearestNode = NULL;
+    float nearest = distance;
+    int nearestTriangle = -1;
+    for (size_t i = 0, count = candidates.size(); i < count && candidates[i].first <= nearest; ++i)
+    {
+        Node* node = candidates[i].second;
+        if (filter && filter->filter(node))
+            continue;
+
+        float nodeDistance;
+        int triangle;
+        if (raycastNode(node, ray, candidates[i].first, nearest, &nodeDistance, &triangle) && nodeDistance <= nearest)
+        {
+            nearestNode = node;
+            nearest = nodeDistance;
+            nearestTriangle = triangle;
+        }
+    }
+
+    if (nearestNode == NULL)
+        return false;
+
+    if (result)
+    {
+        result->node = nearestNode;
+        result->point = ray.getOrigin() + ray.getDirection() * nearest;
+        result->distance = nearest;
+        result->triangle = nearestTriangle;
+    }
+    return true;
+}
+
+void Scene::buildOctree()
+{
+    if (_octree == NULL)
+    {
+        // Build the spatial index on first use.
+        _octree = new Octree();
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            indexNode(node, true);
+        }
+    }
+}
+
+bool Scene::LightInfluence::operator<(const LightInfluence& other) const
+{
+    // Group the influences by node, most influential first.
+    if (node != other.node)
+        return std::less<Node*>()(node, other.node);
+    return influence > other.influence;
+}
+
+unsigned int Scene::getNodeLights(Node* node, Light::Type type, Light** lights, unsigned int maxCount)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(lights || maxCount == 0);
+
+    // The influences of pipelined frames are selected when the scenes are captured.
+    if (_lightInfluencesDirty && !Game::isRenderingCaptured() && !Game::isSimulatingInParallel())
+    {
+        updateLightInfluences();
+    }
+
+    LightInfluence key;
+    key.node = node;
+    key.light = NULL;
+    key.type = type;
+    key.influence = FLT_MAX;
+    std::vector<LightInfluence>::const_iterator itr = std::lower_bound(_lightInfluences.begin(), _lightInfluences.end(), key);
+
+    unsigned int count = 0;
+    for (; itr != _lightInfluences.end() && itr->node == node && count < maxCount; ++itr)
+    {
+        if (itr->type == type)
+        {
+            lights[count++] = itr->light;
+        }
+    }
+    return count;
+}
+
+void Scene::updateLightInfluences()
+{
+    _lightInfluencesDirty = false;
+    _lightInfluences.clear();
+
+    buildOctree();
+    if (_flatNodesDirty)
+    {
+        flattenNodes();
+    }
+
+    std::vector<Node*> nodes;
+    for (size_t i = 0, count = _flatNodes.size(); i < count; ++i)
+    {
+        Node* lightNode = _flatNodes[i];
+        Light* light = lightNode->getLight();
+        if (light == NULL || light->getLightType() == Light::DIRECTIONAL || !lightNode->isActiveInHierarchy())
+            continue;
+
+        // Relative luminance of the light color.
+        const Vector3& color = light->getColor();
+        float luminance = 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+        float range = light->getRange();
+        if (luminance <= 0.0f || range <= 0.0f)
+            continue;
+
+        Vector3 position = lightNode->getTranslationWorld();
+        Vector3 direction;
+        float sinAngle = 0.0f;
+        if (light->getLightType() == Light::SPOT)
+        {
+            direction = lightNode->getForwardVectorWorld();
+            direction.normalize();
+            sinAngle = sqrt(std::max(1.0f - light->getOuterAngleCos() * light->getOuterAngleCos(), 0.0f));
+        }
+
+        nodes.clear();
+        _octree->query(BoundingSphere(position, range), nodes);
+        for (size_t j = 0, nodeCount = nodes.size(); j < nodeCount; ++j)
+        {
+            Node* node = nodes[j];
+            const BoundingSphere& bounds = node->getBoundingSphere();
+            Vector3 offset = bounds.center - position;
+            float distance = offset.length();
+
+            if (light->getLightType() == Light::SPOT && distance > bounds.radius)
+            {
+                // Skip the bounds outside of the cone. The distance to the surface of the cone
+                // is underestimated behind the light, which never skips a lit node.
+                float along = offset.dot(direction);
+                float across = sqrt(std::max(distance * distance - along * along, 0.0f));
+                if (across * light->getOuterAngleCos() - along * sinAngle > bounds.radius)
+                    continue;
+            }
+
+            LightInfluence influence;
+            influence.node = node;
+            influence.light = light;
+            influence.type = light->getLightType();
+            influence.influence = luminance * std::max(1.0f - std::max(distance - bounds.radius, 0.0f) / range, 0.0f);
+            _lightInfluences.push_back(influence);
+        }
+    }
+
+    std::sort(_lightInfluences.begin(), _lightInfluences.end());
+}
+
+void Scene::setVisibilitySet(VisibilitySet* visibilitySet)
+{
+    if (_visibilitySet == visibilitySet)
+        return;
+
+    if (_visibilitySet)
+    {
+        _visibilitySet->setCell(-1);
+        SAFE_RELEASE(_visibilitySet);
+    }
+    _visibilitySet = visibilitySet;
+    if (_visibilitySet)
+    {
+        _visibilitySet->addRef();
+    }
+}
+
+VisibilitySet* Scene::getVisibilitySet() const
+{
+    return _visibilitySet;
+}
+
+void Scene::setDepthPyramid(DepthPyramid* depthPyramid)
+{
+    if (_depthPyramid == depthPyramid)
+        return;
+
+    if (depthPyramid)
+    {
+        depthPyramid->addRef();
+    }
+    SAFE_RELEASE(_depthPyramid);
+    _depthPyramid = depthPyramid;
+}
+
+DepthPyramid* Scene::getDepthPyramid() const
+{
+    return _depthPyramid;
+}
+
+void Scene::updateWorldMatrices()
+{
+    if (_flatNodesDirty)
+    {
+        flattenNodes();
+    }
+
+    // Parents come before their children, so a parent's world matrix is always up to date when its children are updated.
+    // A change to a node's transform dirties its children too, so only the nodes flagged dirty are computed, and only
+    // those are written back to their node.
+    Matrix* worldMatrices = _flatWorldMatrices.empty() ? NULL : &_flatWorldMatrices[0];
+    Matrix local;
+    for (size_t i = 0, count = _flatNodes.size(); i < count; ++i)
+    {
+        if (!_flatDirty[i])
+            continue;
+        _flatDirty[i] = 0;
+
+        switch (_flatModes[i])
+        {
+        case SCENE_FLAT_STATIC:
+            // Static nodes keep the world matrix they had when they became static.
+            worldMatrices[i] = _flatNodes[i]->_world;
+            continue;
+        case SCENE_FLAT_LOCAL:
+            Matrix::createTranslation(_flatTranslations[i], &worldMatrices[i]);
+            worldMatrices[i].rotate(_flatRotations[i]);
+            worldMatrices[i].scale(_flatScales[i]);
+            break;
+        default:
+            GP_ASSERT(_flatParents[i] >= 0);
+            Matrix::createTranslation(_flatTranslations[i], &local);
+            local.rotate(_flatRotations[i]);
+            local.scale(_flatScales[i]);
+            Matrix::multiply(worldMatrices[_flatParents[i]], local, &worldMatrices[i]);
+            break;
+        }
+        _flatNodes[i]->setWorldMatrix(worldMatrices[i]);
+    }
+
+    // Lights may have moved, so select the lights of the nodes again when they are next requested.
+    _lightInfluencesDirty = true;
+}
+
+unsigned int Scene::getFlatNodeCount() const
+{
+    return (unsigned int)_flatNodes.size();
+}
+
+Node* const* Scene::getFlatNodes() const
+{
+    return _flatNodes.empty() ? NULL : &_flatNodes[0];
+}
+
+const int* Scene::getFlatParents() const
+{
+    return _flatParents.empty() ? NULL : &_flatParents[0];
+}
+
+const Matrix* Scene::getFlatWorldMatrices() const
+{
+    return _flatWorldMatrices.empty() ? NULL : &_flatWorldMatrices[0];
+}
+
+void Scene::flattenNodes()
+{
+    _flatNodes.clear();
+    _flatParents.clear();
+    _flatNodes.reserve(_nodeCount);
+    _flatParents.reserve(_nodeCount);
+
+    // Walk each hierarchy depth first without recursion, appending nodes in pre-order.
+    // The stack holds the index of each ancestor of the current node.
+    std::vector<int> ancestors;
+    for (Node* root = getFirstNode(); root != NULL; root = root->getNextSibling())
+    {
+        Node* node = root;
+        while (node)
+        {
+            _flatParents.push_back(ancestors.empty() ? -1 : ancestors.back());
+            _flatNodes.push_back(node);
+            if (node->getFirstChild())
+            {
+                ancestors.push_back((int)_flatNodes.size() - 1);
+                node = node->getFirstChild();
+                continue;
+            }
+            while (node != root && node->getNextSibling() == NULL)
+            {
+                node = node->getParent();
+                ancestors.pop_back();
+            }
+            node = node == root ? NULL : node->getNextSibling();
+        }
+    }
+    size_t count = _flatNodes.size();
+    _flatModes.resize(count);
+    _flatDirty.resize(count);
+    _flatScales.resize(count);
+    _flatRotations.resize(count);
+    _flatTranslations.resize(count);
+    _flatWorldMatrices.resize(count);
+    _flatNodesDirty = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        _flatNodes[i]->_flatIndex = (unsigned int)i;
+        storeFlatTransform(_flatNodes[i]);
+    }
+}
+
+void Scene::storeFlatTransform(const Node* node)
+{
+    GP_ASSERT(node);
+
+    unsigned int i = node->_flatIndex;
+    if (i >= _flatNodes.size() || _flatNodes[i] != node)
+    {
+        // The node joined the scene without the store being marked for a rebuild.
+        _flatNodesDirty = true;
+        return;
+    }
+
+    _flatModes[i] = node->isStatic() ? SCENE_FLAT_STATIC : (node->isParentWorldInherited() ? SCENE_FLAT_INHERITED : SCENE_FLAT_LOCAL);
+    _flatDirty[i] = 1;
+    _flatScales[i] = node->getScale();
+    _flatRotations[i] = node->getRotation();
+    _flatTranslations[i] = node->getTranslation();
+}
+
+void Scene::updateAllWorldMatrices()
+{
+    for (size_t i = 0, count = __sceneList.size(); i < count; ++i)
+    {
+        __sceneList[i]->updateWorldMatrices();
+    }
+
+    // Update the matrix palettes of all skinned models in one batch.
+    __skins.clear();
+    for (size_t i = 0, count = __sceneList.size(); i < count; ++i)
+    {
+        const std::vector<Node*>& nodes = __sceneList[i]->_flatNodes;
+        for (size_t j = 0, nodeCount = nodes.size(); j < nodeCount; ++j)
+        {
+            Model* model = nodes[j]->getModel();
+            if (model && model->getSkin())
+            {
+                __skins.push_back(model->getSkin());
+            }
+        }
+    }
+    if (!__skins.empty())
+    {
+        MeshSkin::updateMatrixPalettes(&__skins[0], (unsigned int)__skins.size());
+    }
+}
+
+void Scene::capture()
+{
+    // Re-index the nodes that moved, so that culling the captured frame doesn't touch the spatial index.
+    buildOctree();
+    _octree->update();
+    _capturedOctreeRevision = _octree->getRevision();
+
+    if (_lightInfluencesDirty)
+    {
+        updateLightInfluences();
+    }
+
+    if (_capturedActiveCamera != _activeCamera)
+    {
+        if (_activeCamera)
+            _activeCamera->addRef();
+        SAFE_RELEASE(_capturedActiveCamera);
+        _capturedActiveCamera = _activeCamera;
+    }
+    if (_activeCamera)
+    {
+        _activeCamera->capture();
+    }
+
+    for (size_t i = 0, count = _flatNodes.size(); i < count; ++i)
+    {
+        _flatNodes[i]->capture();
+    }
+}
+
+void Scene::captureAll()
+{
+    for (size_t i = 0, count = __sceneList.size(); i < count; ++i)
+    {
+        __sceneList[i]->capture();
+    }
+}
+
+void Scene::indexNode(Node* node, bool recursive)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(_octree);
+
+    if (node->_model || node->_terrain || node->_particleEmitter || node->_form)
+    {
+        _octree->insert(node);
+    }
+    else
+    {
+        _octree->remove(node);
+    }
+
+    if (recursive)
+    {
+        // Joint hierarchies are not part of the scene, so index them through the mesh skin.
+        if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+        {
+            indexNode(node->_model->_skin->_rootNode, true);
+        }
+        for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+        {
+            indexNode(child, true);
+        }
+    }
+}
+
+void Scene::unindexNode(Node* node)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(_octree);
+
+    _octree->remove(node);
+
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        unindexNode(node->_model->_skin->_rootNode);
+    }
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        unindexNode(child);
+    }
+}
+
+void Scene::addToLookup(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->_lookupScene == this)
+        return;
+    if (node->_lookupScene)
+        node->_lookupScene->removeFromLookup(node);
+
+    node->_lookupScene = this;
+    _nodeIds.insert(std::make_pair(Node::hashId(node->_id.c_str()), node));
+    if (node->_tags)
+    {
+        for (size_t i = 0, count = node->_tags->size(); i < count; ++i)
+        {
+            _nodeTags.insert(std::make_pair((*node->_tags)[i].key, node));
+        }
+    }
+
+    // Joint hierarchies are not part of the scene, so index them through the mesh skin.
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        addToLookup(node->_model->_skin->_rootNode);
+    }
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        addToLookup(child);
+    }
+}
+
+void Scene::removeFromLookup(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->_lookupScene != this)
+        return;
+
+    node->_lookupScene = NULL;
+    removeLookupEntry(_nodeIds, Node::hashId(node->_id.c_str()), node);
+    if (node->_tags)
+    {
+        for (size_t i = 0, count = node->_tags->size(); i < count; ++i)
+        {
+            removeLookupEntry(_nodeTags, (*node->_tags)[i].key, node);
+        }
+    }
+
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        removeFromLookup(node->_model->_skin->_rootNode);
+    }
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        removeFromLookup(child);
+    }
+}
+
+void Scene::removeLookupEntry(std::multimap<unsigned int, Node*>& lookup, unsigned int key, Node* node)
+{
+    std::pair<std::multimap<unsigned int, Node*>::iterator, std::multimap<unsigned int, Node*>::iterator> range = lookup.equal_range(key);
+    for (std::multimap<unsigned int, Node*>::iterator itr = range.first; itr != range.second; ++itr)
+    {
+        if (itr->second == node)
+        {
+            lookup.erase(itr);
+            return;
+        }
+    }
+}
+
+bool Scene::lookupNode(const char* id, const Node* root, Node** match) const
+{
+    GP_ASSERT(id);
+    GP_ASSERT(match);
+
+    *match = NULL;
+    std::pair<std::multimap<unsigned int, Node*>::const_iterator, std::multimap<unsigned int, Node*>::const_iterator> range = _nodeIds.equal_range(Node::hashId(id));
+    for (std::multimap<unsigned int, Node*>::const_iterator itr = range.first; itr != range.second; ++itr)
+    {
+        Node* node = itr->second;
+        if (node == root || node->_id != id)
+            continue;
+
+        if (root)
+        {
+            // Skip the nodes that are not below the root.
+            const Node* top = node;
+            while (top->_parent && top->_parent != root)
+            {
+                top = top->_parent;
+            }
+            if (top->_parent == NULL)
+            {
+                if (top->_scene == this)
+                    continue;
+
+                // The node is in a joint hierarchy, which can only be traced back to its model by searching.
+                return false;
+            }
+        }
+
+        // The search makes the first of several matches deterministic.
+        if (*match)
+            return false;
+        *match = node;
+    }
+    return true;
+}
+
 void Scene::update(float elapsedTime)
 {
     for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
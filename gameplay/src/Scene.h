@@ -5,10 +5,16 @@
 #include "MeshBatch.h"
 #include "ScriptController.h"
 #include "Light.h"
+#include "VisibilitySet.h"
+#include "DepthPyramid.h"
+#include "SceneView.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
 
+class ScriptFunction;
+
 /**
  * Defines the root container for a hierarchy of Node objects.
  *
@@ -16,8 +22,68 @@ namespace gameplay
  */
 class Scene : public Ref
 {
+    friend class Node;
+    friend class Game;
+
 public:
 
+    /**
+     * Defines the result of a ray test against the nodes of the scene.
+     *
+     * @script{ignore}
+     */
+    struct RaycastHit
+    {
+        /**
+         * The node that was hit.
+         */
+        Node* node;
+
+        /**
+         * The point where the ray hit the node, in world space.
+         */
+        Vector3 point;
+
+        /**
+         * The distance from the origin of the ray to the point.
+         */
+        float distance;
+
+        /**
+         * The index of the triangle of the node's mesh that was hit, or -1 if the node was hit by its bounds or its terrain.
+         */
+        int triangle;
+    };
+
+    /**
+     * Class that can be overridden to exclude nodes from the ray tests of a scene.
+     *
+     * @script{ignore}
+     */
+    class RaycastFilter
+    {
+    public:
+
+        /**
+         * Constructor.
+         */
+        RaycastFilter();
+
+        /**
+         * Virtual destructor.
+         */
+        virtual ~RaycastFilter();
+
+        /**
+         * Called for each node whose bounds the ray hits, before it is tested any further.
+         *
+         * @param node The node to be tested.
+         *
+         * @return True if the node should be filtered out, or false to include the node in the test (default).
+         */
+        virtual bool filter(Node* node);
+    };
+
     /**
      * Creates a new empty scene.
      *
@@ -89,6 +155,21 @@ public:
      */
     unsigned int findNodes(const char* id, std::vector<Node*>& nodes, bool recursive = true, bool exactMatch = true) const;
 
+    /**
+     * Returns all nodes in the scene (including the joints of skinned models) that have the given tag.
+     *
+     * The nodes are looked up in an index of the tags of the scene, so the cost does not
+     * depend on the size of the scene. The nodes are returned in no particular order.
+     *
+     * @param name The name of the tag.
+     * @param nodes Vector of nodes to be populated with matches.
+     * @param value The value the tag must have, or NULL to return the nodes with any value.
+     *
+     * @return The number of matches found.
+     * @script{ignore}
+     */
+    unsigned int findNodesByTag(const char* name, std::vector<Node*>& nodes, const char* value = NULL) const;
+
     /**
      * Creates and adds a new node to the scene.
      *
@@ -232,7 +313,235 @@ public:
      *
      * @param visitMethod The name of the Lua function to call for each node in the scene.
      */
-    inline void visit(const char* visitMethod);
+    void visit(const char* visitMethod);
+
+    /**
+     * Visits each node in the scene and calls the specified Lua function.
+     *
+     * The function is resolved once by the handle, instead of being looked up by name
+     * for each node, and receives each node as its single argument. The traversal is the
+     * same as for visit(const char*).
+     *
+     * @param visitMethod The handle of the Lua function to call for each node in the scene.
+     * @script{ignore}
+     */
+    void visit(ScriptFunction& visitMethod);
+
+    /**
+     * Visits each node in the scene, splitting the nodes across the job worker threads.
+     *
+     * The nodes of the scene (and the joint hierarchies of its skinned models) are gathered
+     * into an array without recursion, and the visit method is called for chunks of the array
+     * in parallel. Every node is visited, in no particular order, so the visit method returns
+     * nothing. It must be safe to call from several threads at once: it may read the node it
+     * is given and write state owned by that node, but must not change the hierarchy or touch
+     * other nodes. Without worker threads, the nodes are visited on the calling thread.
+     *
+     * @param instance The pointer to an instance of the object that contains visitMethod.
+     * @param visitMethod The pointer to the class method to call for each node in the scene.
+     * @param grainSize The minimum number of nodes visited by each job.
+     * @script{ignore}
+     */
+    template <class T>
+    void visitParallel(T* instance, void (T::*visitMethod)(Node*), unsigned int grainSize = 64);
+
+    /**
+     * Finds all the drawable nodes in the scene that are visible to the specified camera.
+     *
+     * Nodes containing a Model, Terrain, ParticleEmitter or Form are considered drawable.
+     * Only nodes that are active in the scene hierarchy are returned.
+     *
+     * The first call to this method builds a spatial index (loose octree) of the world-space
+     * bounds of all drawable nodes in the scene. The index is then kept up to date as nodes
+     * are transformed, added and removed, so this method does not need to walk the entire
+     * scene hierarchy on each call.
+     *
+     * @param camera The camera whose view frustum the nodes are tested against.
+     * @param nodes The vector to append the visible nodes to.
+     *
+     * @return The number of visible nodes appended to the vector.
+     * @script{ignore}
+     */
+    unsigned int cull(Camera* camera, std::vector<Node*>& nodes);
+
+    /**
+     * Finds all the drawable nodes in the scene that intersect the specified frustum.
+     *
+     * Unlike cull(Camera*, std::vector<Node*>&), this ignores the visibility set of the scene,
+     * so it is suited to views other than the camera's (such as the views of shadow casting lights).
+     *
+     * @param frustum The frustum the nodes are tested against.
+     * @param nodes The vector to append the intersecting nodes to.
+     *
+     * @return The number of nodes appended to the vector.
+     * @script{ignore}
+     */
+    unsigned int cull(const Frustum& frustum, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the drawable nodes in the scene that intersect each of several frustums, visiting the spatial index once.
+     *
+     * Each cell of the index is tested against all the frustums at once, and its nodes only against
+     * the frustums that intersect it, so the shadow cascades of a light or the views of a split
+     * screen cost little more than the largest of them. Like cull(const Frustum&, std::vector<Node*>&),
+     * this ignores the visibility set of the scene.
+     *
+     * @param frustums The frustums the nodes are tested against.
+     * @param nodes The vectors to append the nodes intersecting each frustum to.
+     * @param count The number of frustums (and of vectors).
+     *
+     * @return The number of nodes appended to all the vectors.
+     * @script{ignore}
+     */
+    unsigned int cull(const Frustum* frustums, std::vector<Node*>** nodes, unsigned int count);
+
+    /**
+     * Culls several views of the scene together, and fills their render queues.
+     *
+     * The views whose camera and scene did not change since they were last culled keep their
+     * nodes and their sorted render queues (see SceneView). The other views are culled
+     * together by a single visit of the spatial index, as by cull(const Frustum*, std::vector<Node*>**, unsigned int).
+     *
+     * @param views The views to cull.
+     * @param count The number of views.
+     *
+     * @return The number of views that were culled again.
+     * @script{ignore}
+     */
+    unsigned int cull(SceneView** views, unsigned int count);
+
+    /**
+     * Finds the nearest node in the scene hit by the specified ray.
+     *
+     * The ray is tested against the bounds of the nodes in the spatial index of the scene (see cull()),
+     * nearest first. The models whose mesh has picking data (see Mesh::setPickingDataRetained) are then
+     * tested against the triangles of the mesh, through a bounding volume hierarchy built the first time
+     * the mesh is hit, and terrains are tested against their heights. Other models, including skinned
+     * models, are hit at their bounds. Forms and particle emitters are never hit, and nodes that are not
+     * active in the scene hierarchy are skipped. This does not require the nodes to have physics collision objects.
+     *
+     * @param ray The ray to test, in world space.
+     * @param distance The distance along the ray beyond which nodes are not hit.
+     * @param result Set to the nearest hit, or NULL.
+     * @param filter The filter that excludes nodes from the test, or NULL to test every node.
+     *
+     * @return True if a node was hit, false otherwise.
+     * @script{ignore}
+     */
+    bool raycast(const Ray& ray, float distance, RaycastHit* result = NULL, RaycastFilter* filter = NULL);
+
+    /**
+     * Selects the lights of a type that influence the specified node the most.
+     *
+     * Once per frame, after the world matrices of the scene are updated, the range of every active
+     * point and spot light in the scene is tested against the spatial index of the scene (see cull()),
+     * and each node in range is given the influence of the light: the luminance of its color, attenuated
+     * linearly over its range from the nearest point of the bounds of the node. Spot lights skip nodes
+     * outside their cone. The lights are returned most influential first, so that forward lighting
+     * shaders compiled for a small fixed number of lights can shade scenes with many lights.
+     *
+     * The lights are bound to materials by the POINT_LIGHT_* and SPOT_LIGHT_* auto bindings
+     * (see RenderState::AutoBinding).
+     *
+     * @param node The drawable node to select the lights of.
+     * @param type The type of lights to select (Light::POINT or Light::SPOT).
+     * @param lights The array to fill with the selected lights.
+     * @param maxCount The largest number of lights to select.
+     *
+     * @return The number of lights written to the array.
+     * @script{ignore}
+     */
+    unsigned int getNodeLights(Node* node, Light::Type type, Light** lights, unsigned int maxCount);
+
+    /**
+     * Sets the precomputed potentially visible set used by cull().
+     *
+     * While the camera is within the grid of the set, cull() skips the nodes of the set
+     * that cannot be seen from the camera's cell before testing nodes against the frustum.
+     *
+     * @param visibilitySet The visibility set of this scene's static nodes, or NULL to disable it.
+     * @script{ignore}
+     */
+    void setVisibilitySet(VisibilitySet* visibilitySet);
+
+    /**
+     * Returns the potentially visible set used by cull().
+     *
+     * @return The visibility set, or NULL if there is none.
+     * @script{ignore}
+     */
+    VisibilitySet* getVisibilitySet() const;
+
+    /**
+     * Sets the depth pyramid of a previous frame that cull() and the terrains of the scene test bounds against.
+     *
+     * cull() skips the cells of the spatial index and the nodes whose bounds are hidden behind
+     * the depth of the pyramid, and terrains skip the regions of their quadtree that are. Views
+     * other than the camera's (see cull(const Frustum&, std::vector<Node*>&)) ignore the pyramid.
+     *
+     * @param depthPyramid The depth pyramid, or NULL to disable it.
+     * @script{ignore}
+     */
+    void setDepthPyramid(DepthPyramid* depthPyramid);
+
+    /**
+     * Returns the depth pyramid used by cull().
+     *
+     * @return The depth pyramid, or NULL if there is none.
+     * @script{ignore}
+     */
+    DepthPyramid* getDepthPyramid() const;
+
+    /**
+     * Computes the world matrices of all the nodes in the scene whose transforms changed.
+     *
+     * The nodes are processed from a flat array in parent-before-child order, so each
+     * changed world matrix is computed exactly once, instead of being resolved by the
+     * recursive walks of Node::getWorldMatrix(). The game calls this for every scene
+     * after the update phase of each frame.
+     *
+     * @script{ignore}
+     */
+    void updateWorldMatrices();
+
+    /**
+     * Gets the number of nodes in the flat transform store of the scene.
+     *
+     * The store holds every node in the scene in parent-before-child order, along with
+     * the index of its parent, a copy of its local scale, rotation and translation, and a
+     * contiguous copy of its world matrix, so that systems processing many nodes can
+     * iterate arrays instead of following node pointers. The local transforms are copied
+     * as they change, and the world matrices are brought up to date by updateWorldMatrices().
+     * The indices into the store are only valid until the hierarchy of the scene next changes.
+     *
+     * @return The number of nodes in the store.
+     * @script{ignore}
+     */
+    unsigned int getFlatNodeCount() const;
+
+    /**
+     * Gets the nodes of the flat transform store, in parent-before-child order.
+     *
+     * @return The array of getFlatNodeCount() nodes.
+     * @script{ignore}
+     */
+    Node* const* getFlatNodes() const;
+
+    /**
+     * Gets the index of the parent of each node in the flat transform store.
+     *
+     * @return The array of getFlatNodeCount() parent indices, with -1 for nodes at the root of the scene.
+     * @script{ignore}
+     */
+    const int* getFlatParents() const;
+
+    /**
+     * Gets the world matrix of each node in the flat transform store.
+     *
+     * @return The array of getFlatNodeCount() world matrices, as of the last call to updateWorldMatrices().
+     * @script{ignore}
+     */
+    const Matrix* getFlatWorldMatrices() const;
 
     /**
      * Updates all the active nodes in the scene.
@@ -272,28 +581,136 @@ private:
     Scene& operator=(const Scene&);
 
     /**
-     * Visits the given node and all of its children recursively.
+     * Defines the arguments of the jobs of visitParallel().
      */
     template <class T>
-    void visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*));
+    struct ParallelVisit
+    {
+        T* instance;
+        void (T::*visitMethod)(Node*);
+        Node* const* nodes;
+
+        static void visitRange(void* arg, unsigned int start, unsigned int end);
+    };
 
     /**
-     * Visits the given node and all of its children recursively.
+     * Pushes the root nodes of the scene onto the stack of a traversal, so that the first node is on top.
      */
-    template <class T, class C>
-    void visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*,C), C cookie);
+    void pushVisitRoots(std::vector<Node*>& stack) const;
+
+    /**
+     * Pushes the children of a visited node onto the stack of a traversal.
+     *
+     * The joint hierarchy of a skinned model is pushed last, so that it is visited before the
+     * children of the node, since joint hierarchies are not added to the scene directly. If
+     * joints were never visited, nodes embedded within the joint hierarchy that contain models
+     * would never get visited (and therefore never get drawn).
+     */
+    static void pushVisitChildren(Node* node, std::vector<Node*>& stack);
+
+    /**
+     * Gathers every node of the scene and of the joint hierarchies of its skinned models, in depth-first order.
+     */
+    void gatherVisitNodes(std::vector<Node*>& nodes) const;
 
     /**
-     * Visits the given node and all of its children recursively.
+     * Runs a range function over the gathered nodes of the scene, on the job worker threads if there are any.
      */
-    void visitNode(Node* node, const char* visitMethod);
+    static void visitRanges(unsigned int count, JobScheduler::RangeFunction function, void* arg, unsigned int grainSize);
+
+    /**
+     * Builds the spatial index of the scene if it doesn't exist yet.
+     */
+    void buildOctree();
+
+    /**
+     * Adds or updates the given node (and optionally its children) in the spatial index.
+     */
+    void indexNode(Node* node, bool recursive);
+
+    /**
+     * Removes the given node and all of its children from the spatial index.
+     */
+    void unindexNode(Node* node);
+
+    /**
+     * Adds the given node and all of its children to the ID and tag index.
+     */
+    void addToLookup(Node* node);
+
+    /**
+     * Removes the given node and all of its children from the ID and tag index.
+     */
+    void removeFromLookup(Node* node);
+
+    /**
+     * Removes the entry of a node for the given key from an index.
+     */
+    static void removeLookupEntry(std::multimap<unsigned int, Node*>& lookup, unsigned int key, Node* node);
+
+    /**
+     * Looks up the node of the given ID in the ID index.
+     *
+     * @param id The ID of the node.
+     * @param root The node below which the node must be, or NULL to look up the whole scene.
+     * @param match Set to the node found, or NULL if no node has the ID.
+     *
+     * @return true if the index resolved the lookup, or false if the hierarchy must be searched
+     *      instead to find which of several matches comes first.
+     */
+    bool lookupNode(const char* id, const Node* root, Node** match) const;
 
     Node* findNextVisibleSibling(Node* node);
 
     bool isNodeVisible(Node* node);
 
+    /**
+     * Defines the influence of a light on a node.
+     */
+    struct LightInfluence
+    {
+        Node* node;
+        Light* light;
+        Light::Type type;
+        float influence;
+
+        bool operator<(const LightInfluence& other) const;
+    };
+
+    /**
+     * Rebuilds the flat parent-before-child array of the nodes in the scene.
+     */
+    void flattenNodes();
+
+    /**
+     * Copies the local transform of a node to the flat transform store, and marks its world matrix dirty.
+     */
+    void storeFlatTransform(const Node* node);
+
+    /**
+     * Rebuilds the influences of the lights in the scene on the nodes in their range.
+     */
+    void updateLightInfluences();
+
+    /**
+     * Calls updateWorldMatrices() on every scene, then updates the matrix palettes
+     * of the skinned models in the scenes.
+     */
+    static void updateAllWorldMatrices();
+
+    /**
+     * Captures the state of the scene drawn by the next pipelined frame.
+     */
+    void capture();
+
+    /**
+     * Calls capture() on every scene. Called by Game once the world matrices are up to date.
+     */
+    static void captureAll();
+
     std::string _id;
     Camera* _activeCamera;
+    Camera* _capturedActiveCamera;
     Node* _firstNode;
     Node* _lastNode;
     unsigned int _nodeCount;
@@ -301,77 +718,84 @@ private:
     bool _bindAudioListenerToCamera;
     Node* _nextItr;
     bool _nextReset;
+    Octree* _octree;
+    VisibilitySet* _visibilitySet;
+    DepthPyramid* _depthPyramid;
+    std::vector<Node*> _flatNodes;
+    std::vector<int> _flatParents;
+    std::vector<unsigned char> _flatModes;
+    std::vector<unsigned char> _flatDirty;
+    std::vector<Vector3> _flatScales;
+    std::vector<Quaternion> _flatRotations;
+    std::vector<Vector3> _flatTranslations;
+    std::vector<Matrix> _flatWorldMatrices;
+    bool _flatNodesDirty;
+    std::vector<LightInfluence> _lightInfluences;
+    bool _lightInfluencesDirty;
+    unsigned int _capturedOctreeRevision;
+    std::multimap<unsigned int, Node*> _nodeIds;
+    std::multimap<unsigned int, Node*> _nodeTags;
 };
 
 template <class T>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*))
 {
-    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    // Traverse depth first with an explicit stack, so that deep hierarchies can't overflow the call stack.
+    std::vector<Node*> stack;
+    pushVisitRoots(stack);
+    while (!stack.empty())
     {
-        visitNode(node, instance, visitMethod);
+        Node* node = stack.back();
+        stack.pop_back();
+        if ((instance->*visitMethod)(node))
+        {
+            pushVisitChildren(node, stack);
+        }
     }
 }
 
 template <class T, class C>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*,C), C cookie)
 {
-    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    std::vector<Node*> stack;
+    pushVisitRoots(stack);
+    while (!stack.empty())
     {
-        visitNode(node, instance, visitMethod, cookie);
-    }
-}
-
-inline void Scene::visit(const char* visitMethod)
-{
-    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
-    {
-        visitNode(node, visitMethod);
+        Node* node = stack.back();
+        stack.pop_back();
+        if ((instance->*visitMethod)(node, cookie))
+        {
+            pushVisitChildren(node, stack);
+        }
     }
 }
 
 template <class T>
-void Scene::visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*))
+void Scene::visitParallel(T* instance, void (T::*visitMethod)(Node*), unsigned int grainSize)
 {
-    // Invoke the visit method for this node.
-    if (!(instance->*visitMethod)(node))
-        return;
+    GP_ASSERT(instance);
+    GP_ASSERT(visitMethod);
 
-    // If this node has a model with a mesh skin, visit the joint hierarchy within it
-    // since we don't add joint hierarchies directly to the scene. If joints are never
-    // visited, it's possible that nodes embedded within the joint hierarchy that contain
-    // models will never get visited (and therefore never get drawn).
-    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
-    {
-        visitNode(node->_model->_skin->_rootNode, instance, visitMethod);
-    }
+    std::vector<Node*> nodes;
+    gatherVisitNodes(nodes);
+    if (nodes.empty())
+        return;
 
-    // Recurse for all children.
-    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
-    {
-        visitNode(child, instance, visitMethod);
-    }
+    ParallelVisit<T> visit;
+    visit.instance = instance;
+    visit.visitMethod = visitMethod;
+    visit.nodes = &nodes[0];
+    visitRanges((unsigned int)nodes.size(), &ParallelVisit<T>::visitRange, &visit, grainSize);
 }
 
-template <class T, class C>
-void Scene::visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*,C), C cookie)
+template <class T>
+void Scene::ParallelVisit<T>::visitRange(void* arg, unsigned int start, unsigned int end)
 {
-    // Invoke the visit method for this node.
-    if (!(instance->*visitMethod)(node, cookie))
-        return;
-
-    // If this node has a model with a mesh skin, visit the joint hierarchy within it
-    // since we don't add joint hierarchies directly to the scene. If joints are never
-    // visited, it's possible that nodes embedded within the joint hierarchy that contain
-    // models will never get visited (and therefore never get drawn).
-    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
-    {
-        visitNode(node->_model->_skin->_rootNode, instance, visitMethod, cookie);
-    }
-
-    // Recurse for all children.
-    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    ParallelVisit<T>* visit = (ParallelVisit<T>*)arg;
+    GP_ASSERT(visit);
+    for (unsigned int i = start; i < end; ++i)
     {
-        visitNode(child, instance, visitMethod, cookie);
+        (visit->instance->*visit->visitMethod)(visit->nodes[i]);
     }
 }
 
@@ -5,6 +5,7 @@
 #include "SceneLoader.h"
 #include "Terrain.h"
 #include "Light.h"
+#include "StaticGeometry.h"
 
 namespace gameplay
 {
@@ -19,8 +20,13 @@ SceneLoader::SceneLoader() : _scene(NULL)
 
 Scene* SceneLoader::load(const char* url)
 {
+    // Parse each properties file referenced by the scene, such as a shared material
+    // file, only once for the whole load.
+    Properties::retainFileCache();
     SceneLoader loader;
-    return loader.loadInternal(url);
+    Scene* scene = loader.loadInternal(url);
+    Properties::releaseFileCache();
+    return scene;
 }
 
 Scene* SceneLoader::loadInternal(const char* url)
@@ -58,6 +64,10 @@ Scene* SceneLoader::loadInternal(const char* url)
     buildReferenceTables(sceneProperties);
     loadReferencedFiles();
 
+    // Start decoding the scene's textures and heightfields on worker threads while
+    // the main scene data is read below.
+    prefetchResources();
+
     // Load the main scene data from GPB and apply the global scene properties.
     if (!_gpbPath.empty())
     {
@@ -66,6 +76,7 @@ Scene* SceneLoader::loadInternal(const char* url)
         if (!_scene)
         {
             GP_WARN("Failed to load main scene from bundle.");
+            clearPrefetch();
             SAFE_DELETE(properties);
             return NULL;
         }
@@ -76,6 +87,10 @@ Scene* SceneLoader::loadInternal(const char* url)
         _scene = Scene::create(sceneProperties->getId());
     }
 
+    // Wait for the decoding jobs and upload the decoded textures, which puts them in
+    // the texture cache for the materials and particle emitters created below.
+    finishPrefetch();
+
     // First apply the node url properties. Following that,
     // apply the normal node properties and create the animations.
     // We apply physics properties after all other node properties
@@ -134,12 +149,13 @@ Scene* SceneLoader::loadInternal(const char* url)
     if (physics)
         loadPhysics(physics);
 
-    // Clean up all loaded properties objects.
-    std::map<std::string, Properties*>::iterator iter = _propertiesFromFile.begin();
-    for (; iter != _propertiesFromFile.end(); ++iter)
-    {
-        SAFE_DELETE(iter->second);
-    }
+    // Merge the models of the static nodes, which the collision objects created above mark as static.
+    if (sceneProperties->getBool("mergeStatic"))
+        StaticGeometry::merge(_scene, sceneProperties->getFloat("mergeCellSize"), &_materialUrls);
+    _materialUrls.clear();
+
+    // Release the prefetched resources that were not used.
+    clearPrefetch();
 
     // Clean up the .scene file's properties object.
     SAFE_DELETE(properties);
@@ -278,6 +294,8 @@ void SceneLoader::applyNodeProperty(SceneNode& sceneNode, Node* node, const Prop
             {
                 Material* material = Material::create(p);
                 node->getModel()->setMaterial(material, snp._index);
+                if (material)
+                    _materialUrls[material] = snp._value;
                 SAFE_RELEASE(material);
             }
             break;
@@ -290,7 +308,8 @@ void SceneLoader::applyNodeProperty(SceneNode& sceneNode, Node* node, const Prop
         }
         case SceneNodeProperty::TERRAIN:
         {
-            Terrain* terrain = Terrain::create(p);
+            HeightField* heightfield = takePrefetchedHeightField(snp._value);
+            Terrain* terrain = heightfield ? Terrain::create(heightfield, p, p->getNamespace()) : Terrain::create(p);
             node->setTerrain(terrain);
             SAFE_RELEASE(terrain);
             break;
@@ -1062,24 +1081,12 @@ void SceneLoader::loadReferencedFiles()
             std::vector<std::string> namespacePath;
             calculateNamespacePath(iter->first, fileString, namespacePath);
 
-            // Check if the referenced properties file has already been loaded.
-            Properties* properties = NULL;
-            std::map<std::string, Properties*>::iterator pffIter = _propertiesFromFile.find(fileString);
-            if (pffIter != _propertiesFromFile.end() && pffIter->second)
+            // The file cache parses each referenced file once and owns it for the whole load.
+            Properties* properties = Properties::loadCachedFile(fileString.c_str());
+            if (properties == NULL)
             {
-                properties = pffIter->second;
-            }
-            else
-            {
-                properties = Properties::create(fileString.c_str());
-                if (properties == NULL)
-                {
-                    GP_WARN("Failed to load referenced properties file '%s'.", fileString.c_str());
-                    continue;
-                }
-
-                // Add the properties object to the cache.
-                _propertiesFromFile.insert(std::make_pair(fileString, properties));
+                GP_WARN("Failed to load referenced properties file '%s'.", fileString.c_str());
+                continue;
             }
 
             Properties* p = getPropertiesFromNamespacePath(properties, namespacePath);
@@ -1093,6 +1100,196 @@ void SceneLoader::loadReferencedFiles()
     }
 }
 
+void SceneLoader::prefetchResources()
+{
+    // Find the textures and terrains referenced by the node properties.
+    std::set<std::string> texturePaths;
+    std::set<std::string> terrainUrls;
+    std::vector<const SceneNode*> sceneNodes;
+    for (size_t i = 0, count = _sceneNodes.size(); i < count; ++i)
+    {
+        sceneNodes.push_back(&_sceneNodes[i]);
+    }
+    while (!sceneNodes.empty())
+    {
+        const SceneNode* sceneNode = sceneNodes.back();
+        sceneNodes.pop_back();
+        for (size_t i = 0, count = sceneNode->_children.size(); i < count; ++i)
+        {
+            sceneNodes.push_back(&sceneNode->_children[i]);
+        }
+
+        for (size_t i = 0, count = sceneNode->_properties.size(); i < count; ++i)
+        {
+            const SceneNodeProperty& snp = sceneNode->_properties[i];
+            if (snp._type != SceneNodeProperty::MATERIAL && snp._type != SceneNodeProperty::PARTICLE &&
+                snp._type != SceneNodeProperty::TERRAIN)
+            {
+                continue;
+            }
+
+            std::map<std::string, Properties*>::const_iterator itr = _properties.find(snp._value);
+            Properties* p = itr != _properties.end() ? itr->second : NULL;
+            if (p == NULL)
+                continue;
+            p->rewind();
+            p = (strlen(p->getNamespace()) > 0) ? p : p->getNextNamespace();
+            if (p == NULL)
+                continue;
+
+            if (snp._type == SceneNodeProperty::TERRAIN)
+            {
+                // Each node gets its own terrain, so only the first use of a definition is prefetched.
+                if (terrainUrls.insert(snp._value).second)
+                {
+                    PrefetchedResource resource;
+                    resource._type = PrefetchedResource::HEIGHTFIELD;
+                    resource._path = snp._value;
+                    resource._mipmap = false;
+                    resource._properties = p;
+                    resource._image = NULL;
+                    resource._heightfield = NULL;
+                    _prefetched.push_back(resource);
+                }
+            }
+            else
+            {
+                prefetchTextures(p, &texturePaths);
+            }
+        }
+    }
+
+    // The resources are only written by their own job, so no locking is needed until the group is waited on.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = _prefetched.size(); i < count; ++i)
+    {
+        if (scheduler)
+        {
+            scheduler->run(_prefetchGroup, decodePrefetchedResource, &_prefetched[i]);
+        }
+        else
+        {
+            decodePrefetchedResource(&_prefetched[i]);
+        }
+    }
+}
+
+void SceneLoader::prefetchTextures(Properties* properties, std::set<std::string>* paths)
+{
+    GP_ASSERT(properties);
+    GP_ASSERT(paths);
+
+    // Material samplers and particle sprites name their PNG images with a 'path' property.
+    // Visiting every namespace leaves the iterators rewound for the loaders.
+    Properties* ns;
+    properties->rewind();
+    while ((ns = properties->getNextNamespace()) != NULL)
+    {
+        bool sprite = strcmp(ns->getNamespace(), "sprite") == 0;
+        std::string path;
+        if ((sprite || strcmp(ns->getNamespace(), "sampler") == 0) && ns->getPath("path", &path) &&
+            FileSystem::getExtension(path.c_str()) == ".PNG" && Texture::findCached(path.c_str()) == NULL &&
+            paths->insert(path).second)
+        {
+            PrefetchedResource resource;
+            resource._type = PrefetchedResource::TEXTURE;
+            resource._path = path;
+            resource._mipmap = sprite || ns->getBool("mipmap");
+            resource._properties = NULL;
+            resource._image = NULL;
+            resource._heightfield = NULL;
+            _prefetched.push_back(resource);
+        }
+
+        prefetchTextures(ns, paths);
+    }
+}
+
+void SceneLoader::decodePrefetchedResource(void* arg)
+{
+    PrefetchedResource* resource = (PrefetchedResource*)arg;
+    GP_ASSERT(resource);
+
+    switch (resource->_type)
+    {
+    case PrefetchedResource::TEXTURE:
+        resource->_image = Image::create(resource->_path.c_str());
+        break;
+    case PrefetchedResource::HEIGHTFIELD:
+        GP_ASSERT(resource->_properties);
+        resource->_heightfield = Terrain::loadHeightField(resource->_properties, resource->_properties->getNamespace());
+        break;
+    }
+}
+
+void SceneLoader::finishPrefetch()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler)
+    {
+        scheduler->wait(_prefetchGroup);
+    }
+
+    // Uploading textures needs the graphics context, so it happens here on the game thread.
+    for (size_t i = 0, count = _prefetched.size(); i < count; ++i)
+    {
+        PrefetchedResource& resource = _prefetched[i];
+        if (resource._image)
+        {
+            Texture* texture = Texture::findCached(resource._path.c_str());
+            if (texture)
+            {
+                texture->addRef();
+            }
+            else
+            {
+                texture = Texture::createCached(resource._path.c_str(), resource._image, resource._mipmap);
+            }
+            if (texture)
+            {
+                _prefetchedTextures.push_back(texture);
+            }
+            SAFE_RELEASE(resource._image);
+        }
+    }
+}
+
+void SceneLoader::clearPrefetch()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler)
+    {
+        scheduler->wait(_prefetchGroup);
+    }
+
+    for (size_t i = 0, count = _prefetched.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_prefetched[i]._image);
+        SAFE_RELEASE(_prefetched[i]._heightfield);
+    }
+    _prefetched.clear();
+    for (size_t i = 0, count = _prefetchedTextures.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_prefetchedTextures[i]);
+    }
+    _prefetchedTextures.clear();
+}
+
+HeightField* SceneLoader::takePrefetchedHeightField(const std::string& url)
+{
+    for (size_t i = 0, count = _prefetched.size(); i < count; ++i)
+    {
+        PrefetchedResource& resource = _prefetched[i];
+        if (resource._type == PrefetchedResource::HEIGHTFIELD && resource._heightfield && resource._path == url)
+        {
+            HeightField* heightfield = resource._heightfield;
+            resource._heightfield = NULL;
+            return heightfield;
+        }
+    }
+    return NULL;
+}
+
 PhysicsConstraint* SceneLoader::loadSocketConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB)
 {
     GP_ASSERT(rbA);
@@ -6,13 +6,22 @@
 #include "PhysicsRigidBody.h"
 #include "Properties.h"
 #include "Scene.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
 
+class HeightField;
+
 /**
  * Defines an internal helper class for loading scenes from .scene files.
  *
+ * Resources that do not depend on the graphics context, which are the PNG textures of the
+ * scene's materials and particle emitters and the heightfields of its terrains, are decoded
+ * by jobs on the game's JobScheduler while the main scene data is read from its bundle. The
+ * steps that create graphics objects, including uploading the decoded textures, then run in
+ * order on the game thread once the jobs have finished.
+ *
  * @script{ignore}
  */
 class SceneLoader
@@ -81,6 +90,25 @@ private:
         std::map<std::string, std::string> _tags;
     };
 
+    /**
+     * Defines a resource decoded by a job while the scene is loading.
+     */
+    struct PrefetchedResource
+    {
+        enum Type
+        {
+            TEXTURE,
+            HEIGHTFIELD
+        };
+
+        Type _type;
+        std::string _path;          // The texture path, or the URL of the terrain definition.
+        bool _mipmap;
+        Properties* _properties;    // The terrain definition.
+        Image* _image;
+        HeightField* _heightfield;
+    };
+
     SceneLoader();
 
     Scene* loadInternal(const char* url);
@@ -119,17 +147,32 @@ private:
 
     void loadReferencedFiles();
 
+    void prefetchResources();
+
+    void prefetchTextures(Properties* properties, std::set<std::string>* paths);
+
+    void finishPrefetch();
+
+    void clearPrefetch();
+
+    HeightField* takePrefetchedHeightField(const std::string& url);
+
+    static void decodePrefetchedResource(void* arg);
+
     PhysicsConstraint* loadSocketConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB);
 
     PhysicsConstraint* loadSpringConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB);
 
-    std::map<std::string, Properties*> _propertiesFromFile; // Holds the properties object for a given file.
     std::map<std::string, Properties*> _properties;         // Holds the properties object for a given URL.
     std::vector<SceneAnimation> _animations;                // Holds the animations declared in the .scene file.
     std::vector<SceneNode> _sceneNodes;                     // Holds all the nodes+properties declared in the .scene file.
     std::string _gpbPath;                                   // The path of the main GPB for the scene being loaded.
     std::string _path;                                      // The path of the scene file being loaded.
     Scene* _scene;                                          // The scene being loaded
+    std::map<Material*, std::string> _materialUrls;         // Holds the url each node material was loaded from, so static geometry merges by url.
+    std::vector<PrefetchedResource> _prefetched;           // Holds the resources decoded by jobs during the load.
+    std::vector<Texture*> _prefetchedTextures;              // Holds the textures created from the decoded resources.
+    JobScheduler::Group _prefetchGroup;                     // The group of the decoding jobs.
 };
 
 /**
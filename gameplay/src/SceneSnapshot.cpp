@@ -0,0 +1,466 @@
+#include "Base.h"
+#include "SceneSnapshot.h"
+#include "Scene.h"
+#include "Game.h"
+#include "Animation.h"
+#include "AnimationClip.h"
+#include "AnimationController.h"
+#include "ParticleEmitter.h"
+#include "PhysicsRigidBody.h"
+#include "AIAgent.h"
+
+// The version of the snapshot data, which must change with its layout.
+#define SNAPSHOT_VERSION 1
+
+// The state recorded for each node.
+#define SNAPSHOT_NODE_ACTIVE 0x01
+#define SNAPSHOT_NODE_COLLISION_OBJECT 0x02
+#define SNAPSHOT_NODE_COLLISION_ENABLED 0x04
+#define SNAPSHOT_NODE_RIGID_BODY 0x08
+#define SNAPSHOT_NODE_PARTICLE_EMITTER 0x10
+#define SNAPSHOT_NODE_AGENT 0x20
+#define SNAPSHOT_NODE_AGENT_ENABLED 0x40
+
+namespace gameplay
+{
+
+// The identifier of the snapshot data.
+static const char SNAPSHOT_IDENTIFIER[] = { 'G', 'P', 'S', 'S' };
+
+/**
+ * Returns the FNV-1a hash of a string, or of the empty string if it is NULL.
+ */
+static unsigned int hashString(const char* s)
+{
+    unsigned int hash = 2166136261u;
+    for (; s && *s; ++s)
+    {
+        hash ^= (unsigned char)*s;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Appends a node and its descendants to the list of nodes, in depth-first order.
+ */
+static void appendNodes(Node* node, std::vector<Node*>* nodes)
+{
+    nodes->push_back(node);
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        appendNodes(child, nodes);
+    }
+}
+
+template<typename T> T SceneSnapshot::Reader::read()
+{
+    T value;
+    if (position + sizeof(T) > end)
+    {
+        position = end;
+        memset(&value, 0, sizeof(T));
+        return value;
+    }
+    memcpy(&value, position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+bool SceneSnapshot::Reader::skip(unsigned int size)
+{
+    if (size > (unsigned int)(end - position))
+    {
+        position = end;
+        return false;
+    }
+    position += size;
+    return true;
+}
+
+SceneSnapshot::SceneSnapshot()
+{
+}
+
+SceneSnapshot::~SceneSnapshot()
+{
+}
+
+SceneSnapshot* SceneSnapshot::create(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    SceneSnapshot* snapshot = new SceneSnapshot();
+    snapshot->capture(scene);
+    return snapshot;
+}
+
+SceneSnapshot* SceneSnapshot::create(Stream* stream)
+{
+    GP_ASSERT(stream);
+
+    size_t length = stream->length();
+    char identifier[sizeof(SNAPSHOT_IDENTIFIER)];
+    unsigned int version;
+    if (length < sizeof(identifier) + sizeof(version) ||
+        stream->read(identifier, 1, sizeof(identifier)) != sizeof(identifier) || memcmp(identifier, SNAPSHOT_IDENTIFIER, sizeof(identifier)) != 0 ||
+        stream->read(&version, sizeof(version), 1) != 1 || version != SNAPSHOT_VERSION)
+    {
+        GP_WARN("Failed to read scene snapshot: the stream does not hold a snapshot of this version.");
+        return NULL;
+    }
+
+    SceneSnapshot* snapshot = new SceneSnapshot();
+    snapshot->_data.resize(length);
+    memcpy(&snapshot->_data[0], identifier, sizeof(identifier));
+    memcpy(&snapshot->_data[sizeof(identifier)], &version, sizeof(version));
+    size_t remaining = length - sizeof(identifier) - sizeof(version);
+    if (remaining > 0 && stream->read(&snapshot->_data[length - remaining], 1, remaining) != remaining)
+    {
+        GP_WARN("Failed to read scene snapshot: the stream ended early.");
+        SAFE_RELEASE(snapshot);
+    }
+    return snapshot;
+}
+
+void SceneSnapshot::getNodes(Scene* scene, std::vector<Node*>* nodes, std::vector<Animation*>* animations)
+{
+    for (Node* node = scene->getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        appendNodes(node, nodes);
+    }
+
+    // Record each animation once, in the order of the first node it targets.
+    std::set<Animation*> found;
+    for (size_t i = 0, count = nodes->size(); i < count; ++i)
+    {
+        std::vector<Animation::Channel*>* channels = (*nodes)[i]->_animationChannels;
+        if (!channels)
+            continue;
+        for (size_t j = 0; j < channels->size(); ++j)
+        {
+            Animation* animation = (*channels)[j]->_animation;
+            if (found.insert(animation).second)
+                animations->push_back(animation);
+        }
+    }
+}
+
+template<typename T> void SceneSnapshot::append(const T& value)
+{
+    size_t size = _data.size();
+    _data.resize(size + sizeof(T));
+    memcpy(&_data[size], &value, sizeof(T));
+}
+
+void SceneSnapshot::capture(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    std::vector<Node*> nodes;
+    std::vector<Animation*> animations;
+    getNodes(scene, &nodes, &animations);
+
+    // The header holds what identifies the nodes and animations, so a mismatch is found before restoring anything.
+    _data.clear();
+    _data.insert(_data.end(), SNAPSHOT_IDENTIFIER, SNAPSHOT_IDENTIFIER + sizeof(SNAPSHOT_IDENTIFIER));
+    append<unsigned int>(SNAPSHOT_VERSION);
+    append<unsigned int>((unsigned int)nodes.size());
+    append<unsigned int>((unsigned int)animations.size());
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        append<unsigned int>(hashString(nodes[i]->getId()));
+    }
+    for (size_t i = 0, count = animations.size(); i < count; ++i)
+    {
+        append<unsigned int>(hashString(animations[i]->getId()));
+        append<unsigned int>(animations[i]->getClipCount());
+    }
+
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        captureNode(nodes[i]);
+    }
+    for (size_t i = 0, count = animations.size(); i < count; ++i)
+    {
+        for (unsigned int j = 0, clipCount = animations[i]->getClipCount(); j < clipCount; ++j)
+        {
+            captureClip(animations[i]->getClip(j));
+        }
+    }
+}
+
+void SceneSnapshot::captureNode(Node* node)
+{
+    PhysicsCollisionObject* object = node->getCollisionObject();
+    PhysicsRigidBody* body = NULL;
+    if (object && object->getType() == PhysicsCollisionObject::RIGID_BODY && !object->isStatic() && !object->isKinematic())
+        body = static_cast<PhysicsRigidBody*>(object);
+    ParticleEmitter* emitter = node->getParticleEmitter();
+    AIAgent* agent = node->getAgent();
+
+    unsigned char flags = 0;
+    if (node->isActive())
+        flags |= SNAPSHOT_NODE_ACTIVE;
+    if (object)
+        flags |= SNAPSHOT_NODE_COLLISION_OBJECT | (object->isEnabled() ? SNAPSHOT_NODE_COLLISION_ENABLED : 0);
+    if (body)
+        flags |= SNAPSHOT_NODE_RIGID_BODY;
+    if (emitter)
+        flags |= SNAPSHOT_NODE_PARTICLE_EMITTER;
+    if (agent)
+        flags |= SNAPSHOT_NODE_AGENT | (agent->isEnabled() ? SNAPSHOT_NODE_AGENT_ENABLED : 0);
+    append(flags);
+
+    append(node->getScale());
+    append(node->getRotation());
+    append(node->getTranslation());
+
+    if (body)
+    {
+        append(body->getLinearVelocity());
+        append(body->getAngularVelocity());
+        append<int>(body->_body->getActivationState());
+    }
+
+    if (emitter)
+    {
+        append<unsigned char>(emitter->_started ? 1 : 0);
+        append<unsigned char>(emitter->_gpuSimulated ? 1 : 0);
+        append(emitter->_emitTime);
+        append(emitter->_gpuTime);
+        append(emitter->_gpuStopTime);
+
+        // GPU emitters simulate their particles from the emitter time alone.
+        unsigned int particleCount = emitter->_gpuSimulated ? 0 : emitter->_particleCount;
+        append(particleCount);
+        if (particleCount > 0)
+        {
+            size_t size = _data.size();
+            _data.resize(size + sizeof(float) * particleCount * ParticleEmitter::PARTICLE_STREAM_COUNT);
+            for (unsigned int i = 0; i < ParticleEmitter::PARTICLE_STREAM_COUNT; ++i)
+            {
+                memcpy(&_data[size + sizeof(float) * particleCount * i], emitter->_particleStreams[i], sizeof(float) * particleCount);
+            }
+        }
+    }
+
+    if (agent)
+    {
+        AIState* state = agent->getStateMachine()->getActiveState();
+        const char* id = state ? state->getId() : "";
+        unsigned char length = (unsigned char)std::min(strlen(id), (size_t)255);
+        append(length);
+        _data.insert(_data.end(), id, id + length);
+    }
+}
+
+void SceneSnapshot::captureClip(AnimationClip* clip)
+{
+    GP_ASSERT(clip);
+
+    // Cross fades and restarts are not recorded, so a clip is either stopped, started or waiting to start.
+    unsigned char bits = 0;
+    if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT) && !clip->isClipStateBitSet(AnimationClip::CLIP_IS_MARKED_FOR_REMOVAL_BIT))
+        bits = clip->_stateBits & (AnimationClip::CLIP_IS_PLAYING_BIT | AnimationClip::CLIP_IS_STARTED_BIT | AnimationClip::CLIP_IS_PAUSED_BIT);
+    append(bits);
+    append(clip->_elapsedTime);
+    append(clip->_speed);
+    append(clip->_blendWeight);
+    append(Game::getGameTime() - clip->_timeStarted);
+}
+
+bool SceneSnapshot::restore(Scene* scene) const
+{
+    GP_ASSERT(scene);
+
+    std::vector<Node*> nodes;
+    std::vector<Animation*> animations;
+    getNodes(scene, &nodes, &animations);
+
+    Reader reader;
+    reader.position = _data.empty() ? NULL : &_data[0];
+    reader.end = reader.position + _data.size();
+    reader.skip(sizeof(SNAPSHOT_IDENTIFIER) + sizeof(unsigned int));
+    if (reader.read<unsigned int>() != nodes.size() || reader.read<unsigned int>() != animations.size())
+    {
+        GP_WARN("Failed to restore scene snapshot: the scene '%s' does not have the nodes of the snapshot.", scene->getId());
+        return false;
+    }
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        if (reader.read<unsigned int>() != hashString(nodes[i]->getId()))
+        {
+            GP_WARN("Failed to restore scene snapshot: node '%s' of scene '%s' is not the node of the snapshot.", nodes[i]->getId(), scene->getId());
+            return false;
+        }
+    }
+    for (size_t i = 0, count = animations.size(); i < count; ++i)
+    {
+        if (reader.read<unsigned int>() != hashString(animations[i]->getId()) || reader.read<unsigned int>() != animations[i]->getClipCount())
+        {
+            GP_WARN("Failed to restore scene snapshot: animation '%s' is not the animation of the snapshot.", animations[i]->getId());
+            return false;
+        }
+    }
+
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        restoreNode(nodes[i], &reader);
+    }
+    for (size_t i = 0, count = animations.size(); i < count; ++i)
+    {
+        for (unsigned int j = 0, clipCount = animations[i]->getClipCount(); j < clipCount; ++j)
+        {
+            restoreClip(animations[i]->getClip(j), &reader);
+        }
+    }
+    return true;
+}
+
+void SceneSnapshot::restoreNode(Node* node, Reader* reader)
+{
+    unsigned char flags = reader->read<unsigned char>();
+    Vector3 scale = reader->read<Vector3>();
+    Quaternion rotation = reader->read<Quaternion>();
+    Vector3 translation = reader->read<Vector3>();
+    node->set(scale, rotation, translation);
+    node->setActive((flags & SNAPSHOT_NODE_ACTIVE) != 0);
+
+    // Components added or removed since the snapshot keep their state, and their recorded state is skipped.
+    PhysicsCollisionObject* object = node->getCollisionObject();
+    if (object && (flags & SNAPSHOT_NODE_COLLISION_OBJECT))
+        object->setEnabled((flags & SNAPSHOT_NODE_COLLISION_ENABLED) != 0);
+
+    if (flags & SNAPSHOT_NODE_RIGID_BODY)
+    {
+        Vector3 linearVelocity = reader->read<Vector3>();
+        Vector3 angularVelocity = reader->read<Vector3>();
+        int activationState = reader->read<int>();
+        if (object && object->getType() == PhysicsCollisionObject::RIGID_BODY && !object->isStatic() && !object->isKinematic())
+        {
+            // Dynamic bodies move their nodes, so the body is moved to the restored node.
+            PhysicsRigidBody* body = static_cast<PhysicsRigidBody*>(object);
+            btTransform transform;
+            body->_motionState->updateTransformFromNode();
+            body->_motionState->getWorldTransform(transform);
+            body->_body->setWorldTransform(transform);
+            body->_body->setInterpolationWorldTransform(transform);
+            body->_body->setLinearVelocity(BV(linearVelocity));
+            body->_body->setAngularVelocity(BV(angularVelocity));
+            body->_body->setInterpolationLinearVelocity(BV(linearVelocity));
+            body->_body->setInterpolationAngularVelocity(BV(angularVelocity));
+            body->_body->clearForces();
+            body->_body->forceActivationState(activationState);
+        }
+    }
+
+    if (flags & SNAPSHOT_NODE_PARTICLE_EMITTER)
+    {
+        bool started = reader->read<unsigned char>() != 0;
+        bool gpuSimulated = reader->read<unsigned char>() != 0;
+        float emitTime = reader->read<float>();
+        double gpuTime = reader->read<double>();
+        double gpuStopTime = reader->read<double>();
+        unsigned int particleCount = reader->read<unsigned int>();
+        ParticleEmitter* emitter = node->getParticleEmitter();
+        if (emitter && emitter->_gpuSimulated == gpuSimulated)
+        {
+            emitter->_started = started;
+            emitter->_emitTime = emitTime;
+            emitter->_gpuTime = gpuTime;
+            emitter->_gpuStopTime = gpuStopTime;
+            emitter->_lastUpdated = 0;
+            if (!gpuSimulated)
+            {
+                // Particles beyond the capacity of the emitter are dropped.
+                unsigned int count = std::min(particleCount, emitter->_particleCountMax);
+                for (unsigned int i = 0; i < ParticleEmitter::PARTICLE_STREAM_COUNT; ++i)
+                {
+                    if (count > 0 && reader->position + sizeof(float) * particleCount <= reader->end)
+                        memcpy(emitter->_particleStreams[i], reader->position, sizeof(float) * count);
+                    reader->skip(sizeof(float) * particleCount);
+                }
+                emitter->_particleCount = count;
+            }
+        }
+        else
+        {
+            reader->skip(sizeof(float) * particleCount * ParticleEmitter::PARTICLE_STREAM_COUNT);
+        }
+    }
+
+    if (flags & SNAPSHOT_NODE_AGENT)
+    {
+        unsigned char length = reader->read<unsigned char>();
+        std::string id((const char*)reader->position, std::min((size_t)length, (size_t)(reader->end - reader->position)));
+        reader->skip(length);
+        AIAgent* agent = node->getAgent();
+        if (agent)
+        {
+            agent->setEnabled((flags & SNAPSHOT_NODE_AGENT_ENABLED) != 0);
+
+            // The state machine leaves and enters states immediately, rather than through messages that arrive later.
+            AIStateMachine* stateMachine = agent->getStateMachine();
+            AIState* state = stateMachine->getState(id.c_str());
+            if (state && state != stateMachine->getActiveState())
+                stateMachine->setStateInternal(state);
+        }
+    }
+}
+
+void SceneSnapshot::restoreClip(AnimationClip* clip, Reader* reader)
+{
+    GP_ASSERT(clip);
+
+    unsigned char bits = reader->read<unsigned char>();
+    float elapsedTime = reader->read<float>();
+    float speed = reader->read<float>();
+    float blendWeight = reader->read<float>();
+    double startedAgo = reader->read<double>();
+
+    AnimationController* controller = Game::getInstance()->getAnimationController();
+    bool scheduled = clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT);
+    bool playing = (bits & AnimationClip::CLIP_IS_PLAYING_BIT) != 0;
+    if (scheduled && !playing)
+        controller->unschedule(clip);
+    else if (!scheduled && playing)
+        controller->schedule(clip);
+
+    // A cross fade in progress is cancelled.
+    if (clip->_crossFadeToClip && clip->isClipStateBitSet(AnimationClip::CLIP_IS_FADING_OUT_BIT))
+        clip->_crossFadeToClip->resetClipStateBit(AnimationClip::CLIP_IS_FADING_IN_BIT);
+    clip->_stateBits = bits;
+    clip->_crossFadeToClip = NULL;
+    clip->_elapsedTime = elapsedTime;
+    clip->_speed = speed;
+    clip->_blendWeight = blendWeight;
+    clip->_timeStarted = Game::getGameTime() - startedAgo;
+
+    // The listener events before the restored time (after it when playing in reverse) have already been sent.
+    unsigned int cursor = 0;
+    while (cursor < clip->_listeners.size() && (speed >= 0.0f ? elapsedTime >= (long)clip->_listeners[cursor]._eventTime :
+        elapsedTime > (long)clip->_listeners[cursor]._eventTime))
+    {
+        ++cursor;
+    }
+    clip->_listenerCursor = cursor;
+}
+
+bool SceneSnapshot::write(Stream* stream) const
+{
+    GP_ASSERT(stream);
+    return _data.empty() || stream->write(&_data[0], 1, _data.size()) == _data.size();
+}
+
+const unsigned char* SceneSnapshot::getData() const
+{
+    return _data.empty() ? NULL : &_data[0];
+}
+
+unsigned int SceneSnapshot::getSize() const
+{
+    return (unsigned int)_data.size();
+}
+
+}
@@ -0,0 +1,170 @@
+#ifndef SCENESNAPSHOT_H_
+#define SCENESNAPSHOT_H_
+
+#include "Ref.h"
+#include "Stream.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+class Animation;
+class AnimationClip;
+
+/**
+ * Defines a snapshot of the runtime state of a scene, which can be restored in place.
+ *
+ * A snapshot records the state that changes while a scene is played, without its assets:
+ * - The transform and active flag of every node.
+ * - Whether collision objects are enabled, and the velocities and activation of dynamic rigid bodies.
+ * - Whether particle emitters are started, and their living particles.
+ * - Whether AI agents are enabled, and the active state of their state machines.
+ * - The playback state of the clips of the animations that target nodes (cross fades are not recorded).
+ *
+ * Restoring a snapshot sets this state back on the nodes of the scene it was captured from,
+ * so a level can be restarted from a checkpoint without loading it again. Nodes are matched
+ * by their order in the scene and their IDs, so the snapshot can only be restored on a scene
+ * with the same hierarchy, such as the same scene or a scene loaded from the same file.
+ *
+ * The state is stored in a compact binary blob, which can be written to a file and read back
+ * by the same build of the game on the same platform.
+ *
+ * @script{ignore}
+ */
+class SceneSnapshot : public Ref
+{
+public:
+
+    /**
+     * Captures a snapshot of the given scene.
+     *
+     * @param scene The scene to capture.
+     *
+     * @return The new snapshot.
+     */
+    static SceneSnapshot* create(Scene* scene);
+
+    /**
+     * Reads a snapshot written by write().
+     *
+     * @param stream The stream to read the snapshot from.
+     *
+     * @return The snapshot, or NULL if the stream does not hold a snapshot.
+     */
+    static SceneSnapshot* create(Stream* stream);
+
+    /**
+     * Replaces this snapshot with a snapshot of the given scene, reusing its memory.
+     *
+     * @param scene The scene to capture.
+     */
+    void capture(Scene* scene);
+
+    /**
+     * Restores the state recorded by this snapshot on the given scene.
+     *
+     * Clips that are restored playing resume from their recorded time without firing their
+     * begin listeners, and clips that are restored stopped do not fire their end listeners.
+     * This must not be called while the scene is being updated.
+     *
+     * @param scene The scene to restore, which must have the hierarchy of the captured scene.
+     *
+     * @return true if the snapshot was restored, false if the scene does not match the snapshot,
+     *      in which case the scene is left unchanged.
+     */
+    bool restore(Scene* scene) const;
+
+    /**
+     * Writes this snapshot to the given stream.
+     *
+     * @param stream The stream to write the snapshot to.
+     *
+     * @return true if the snapshot was written.
+     */
+    bool write(Stream* stream) const;
+
+    /**
+     * Returns the binary data of this snapshot.
+     *
+     * @return The data of the snapshot.
+     */
+    const unsigned char* getData() const;
+
+    /**
+     * Returns the size of the binary data of this snapshot.
+     *
+     * @return The size in bytes.
+     */
+    unsigned int getSize() const;
+
+private:
+
+    /**
+     * Reads the values of a snapshot in order.
+     */
+    struct Reader
+    {
+        const unsigned char* position;
+        const unsigned char* end;
+
+        template<typename T> T read();
+        bool skip(unsigned int size);
+    };
+
+    /**
+     * Constructor.
+     */
+    SceneSnapshot();
+
+    /**
+     * Destructor.
+     */
+    ~SceneSnapshot();
+
+    /**
+     * Hidden copy constructor.
+     */
+    SceneSnapshot(const SceneSnapshot& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    SceneSnapshot& operator=(const SceneSnapshot&);
+
+    /**
+     * Appends the nodes of the scene, in order, and the animations targeting them.
+     */
+    static void getNodes(Scene* scene, std::vector<Node*>* nodes, std::vector<Animation*>* animations);
+
+    /**
+     * Appends a value to the data of the snapshot.
+     */
+    template<typename T> void append(const T& value);
+
+    /**
+     * Appends the state of a node.
+     */
+    void captureNode(Node* node);
+
+    /**
+     * Appends the state of a clip.
+     */
+    void captureClip(AnimationClip* clip);
+
+    /**
+     * Reads the state of a node and sets it on the node.
+     */
+    static void restoreNode(Node* node, Reader* reader);
+
+    /**
+     * Reads the state of a clip and sets it on the clip.
+     */
+    static void restoreClip(AnimationClip* clip, Reader* reader);
+
+    std::vector<unsigned char> _data;
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "Base.h"
+#include "SceneView.h"
+#include "Camera.h"
+
+namespace gameplay
+{
+
+SceneView::SceneView(Camera* camera)
+    : _camera(camera), _revision(0), _valid(false), _cached(false), _cachingEnabled(true)
+{
+    GP_ASSERT(camera);
+    camera->addRef();
+}
+
+SceneView::~SceneView()
+{
+    SAFE_RELEASE(_camera);
+}
+
+SceneView* SceneView::create(Camera* camera)
+{
+    return new SceneView(camera);
+}
+
+Camera* SceneView::getCamera() const
+{
+    return _camera;
+}
+
+void SceneView::setCamera(Camera* camera)
+{
+    GP_ASSERT(camera);
+
+    if (_camera != camera)
+    {
+        camera->addRef();
+        SAFE_RELEASE(_camera);
+        _camera = camera;
+        _valid = false;
+    }
+}
+
+const std::vector<Node*>& SceneView::getNodes() const
+{
+    return _nodes;
+}
+
+RenderQueue* SceneView::getRenderQueue()
+{
+    return &_queue;
+}
+
+bool SceneView::isCached() const
+{
+    return _cached;
+}
+
+void SceneView::setCachingEnabled(bool enabled)
+{
+    _cachingEnabled = enabled;
+}
+
+bool SceneView::isCachingEnabled() const
+{
+    return _cachingEnabled;
+}
+
+void SceneView::invalidate()
+{
+    _valid = false;
+}
+
+unsigned int SceneView::draw(bool wireframe)
+{
+    return _queue.draw(_camera, wireframe);
+}
+
+bool SceneView::isValid(unsigned int revision) const
+{
+    if (!_valid || !_cachingEnabled || _revision != revision)
+        return false;
+
+    // The camera moved, or its projection changed, if its view projection matrix did.
+    return memcmp(_viewProjection.m, _camera->getViewProjectionMatrix().m, sizeof(_viewProjection.m)) == 0;
+}
+
+}
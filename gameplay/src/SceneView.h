@@ -0,0 +1,148 @@
+#ifndef SCENEVIEW_H_
+#define SCENEVIEW_H_
+
+#include "Ref.h"
+#include "RenderQueue.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Node;
+
+/**
+ * Defines a view of a scene through a camera, with the nodes culled for it and a render queue of their models.
+ *
+ * The views of a frame (such as the views of split-screen players, or of a camera and its
+ * reflection) are culled together by Scene::cull(SceneView**, unsigned int), which visits the
+ * spatial index of the scene once for all of them instead of once per view.
+ *
+ * A view also keeps its nodes and its sorted render queue from one frame to the next. While
+ * its camera does not move and no node of the scene is added, removed, moved or activated,
+ * culling the view reuses them instead of culling and sorting again, so static cameras (such
+ * as security cameras or the views of a paused game) cost almost nothing. Changes that do not
+ * move nodes, such as new materials or levels of detail, are not detected, so invalidate()
+ * must be called after them.
+ *
+ * Unlike Scene::cull(Camera*, std::vector<Node*>&), views ignore the visibility set of the scene.
+ *
+ * @script{ignore}
+ */
+class SceneView : public Ref
+{
+    friend class Scene;
+
+public:
+
+    /**
+     * Creates a view through a camera.
+     *
+     * @param camera The camera of the view.
+     *
+     * @return The new view.
+     */
+    static SceneView* create(Camera* camera);
+
+    /**
+     * Returns the camera of this view.
+     *
+     * @return The camera.
+     */
+    Camera* getCamera() const;
+
+    /**
+     * Sets the camera of this view.
+     *
+     * @param camera The camera.
+     */
+    void setCamera(Camera* camera);
+
+    /**
+     * Returns the nodes found by the last cull of this view.
+     *
+     * @return The visible drawable nodes.
+     */
+    const std::vector<Node*>& getNodes() const;
+
+    /**
+     * Returns the render queue of the models of the nodes found by the last cull of this view.
+     *
+     * @return The render queue.
+     */
+    RenderQueue* getRenderQueue();
+
+    /**
+     * Determines if the last cull of this view reused the results of the previous one.
+     *
+     * @return true if the nodes and the render queue were reused.
+     */
+    bool isCached() const;
+
+    /**
+     * Sets whether the results of a cull are reused while the camera and the scene do not change.
+     *
+     * @param enabled true to reuse the results (the default).
+     */
+    void setCachingEnabled(bool enabled);
+
+    /**
+     * Determines if the results of a cull are reused while the camera and the scene do not change.
+     *
+     * @return true if the results are reused.
+     */
+    bool isCachingEnabled() const;
+
+    /**
+     * Makes the next cull of this view cull and sort again.
+     */
+    void invalidate();
+
+    /**
+     * Draws the render queue of this view.
+     *
+     * @param wireframe true to draw the models in wireframe.
+     *
+     * @return The number of draw calls issued.
+     */
+    unsigned int draw(bool wireframe = false);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    SceneView(Camera* camera);
+
+    /**
+     * Destructor.
+     */
+    ~SceneView();
+
+    /**
+     * Hidden copy constructor.
+     */
+    SceneView(const SceneView& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    SceneView& operator=(const SceneView&);
+
+    /**
+     * Determines if the results of the last cull are still valid for the camera and the revision of the scene's spatial index.
+     */
+    bool isValid(unsigned int revision) const;
+
+    Camera* _camera;
+    std::vector<Node*> _nodes;
+    RenderQueue _queue;
+    Matrix _viewProjection;
+    unsigned int _revision;
+    bool _valid;
+    bool _cached;
+    bool _cachingEnabled;
+};
+
+}
+
+#endif
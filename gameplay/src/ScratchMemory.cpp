@@ -0,0 +1,188 @@
+#include "Base.h"
+#include "ScratchMemory.h"
+#include "Thread.h"
+
+#ifdef _MSC_VER
+#define SCRATCH_THREAD_LOCAL __declspec(thread)
+#else
+#define SCRATCH_THREAD_LOCAL __thread
+#endif
+
+// The size of the first block of scratch memory of each thread.
+#define SCRATCH_MEMORY_BLOCK_SIZE 65536
+
+// The most blocks a thread can use in a frame. Each block is at least twice the size of the one before.
+#define SCRATCH_MEMORY_MAX_BLOCKS 24
+
+// The alignment of the allocations.
+#define SCRATCH_MEMORY_ALIGNMENT 16
+
+namespace gameplay
+{
+
+/**
+ * The scratch memory of a thread. The blocks after the current one are kept for reuse
+ * until the memory is reset, where they are merged into a single block.
+ */
+struct ScratchArena
+{
+    char* blocks[SCRATCH_MEMORY_MAX_BLOCKS];
+    size_t sizes[SCRATCH_MEMORY_MAX_BLOCKS];
+    unsigned int blockCount;
+    unsigned int block;
+    size_t used;
+    size_t previousUsed;
+    unsigned int frame;
+    unsigned int scopes;
+};
+
+// The arenas are plain memory, so that they don't depend on the order of static constructors and destructors.
+static SCRATCH_THREAD_LOCAL ScratchArena* __arena = NULL;
+static volatile unsigned int __frame = 0;
+
+static void resetArena(ScratchArena* arena)
+{
+    // Merge the blocks the frame needed into one, so that the next frames fit in a single block.
+    if (arena->blockCount > 1)
+    {
+        size_t capacity = 0;
+        for (unsigned int i = 0; i < arena->blockCount; ++i)
+        {
+            capacity += arena->sizes[i];
+            free(arena->blocks[i]);
+        }
+        arena->blocks[0] = (char*)malloc(capacity);
+        arena->sizes[0] = capacity;
+        arena->blockCount = 1;
+    }
+    arena->block = 0;
+    arena->used = 0;
+    arena->previousUsed = 0;
+    arena->frame = __frame;
+}
+
+static ScratchArena* getArena()
+{
+    ScratchArena* arena = __arena;
+    if (arena == NULL)
+    {
+        arena = (ScratchArena*)calloc(1, sizeof(ScratchArena));
+        arena->blocks[0] = (char*)malloc(SCRATCH_MEMORY_BLOCK_SIZE);
+        arena->sizes[0] = SCRATCH_MEMORY_BLOCK_SIZE;
+        arena->blockCount = 1;
+        arena->frame = __frame;
+        __arena = arena;
+    }
+    else if (arena->frame != __frame && arena->scopes == 0)
+    {
+        // The first allocation of a thread in a new frame frees what it allocated in the previous ones.
+        resetArena(arena);
+    }
+    return arena;
+}
+
+ScratchMemory::Scope::Scope()
+{
+    ScratchArena* arena = getArena();
+    _block = arena->block;
+    _used = arena->used;
+    ++arena->scopes;
+}
+
+ScratchMemory::Scope::~Scope()
+{
+    ScratchArena* arena = __arena;
+    GP_ASSERT(arena && arena->scopes > 0);
+    --arena->scopes;
+
+    // Go back to the block the scope started in. The blocks after it stay allocated for reuse.
+    while (arena->block > _block)
+    {
+        --arena->block;
+        arena->previousUsed -= arena->sizes[arena->block];
+    }
+    arena->used = _used;
+}
+
+void* ScratchMemory::allocate(size_t size)
+{
+    ScratchArena* arena = getArena();
+    size = (size + SCRATCH_MEMORY_ALIGNMENT - 1) & ~(size_t)(SCRATCH_MEMORY_ALIGNMENT - 1);
+
+    if (arena->used + size > arena->sizes[arena->block])
+    {
+        // Move on to the next block, replacing it by a larger one if the allocation doesn't fit.
+        size_t blockSize = std::max(arena->sizes[arena->block] * 2, size);
+        unsigned int next = arena->block + 1;
+        GP_ASSERT(next < SCRATCH_MEMORY_MAX_BLOCKS);
+        if (next < arena->blockCount && arena->sizes[next] < size)
+        {
+            free(arena->blocks[next]);
+            arena->blocks[next] = (char*)malloc(blockSize);
+            arena->sizes[next] = blockSize;
+        }
+        else if (next >= arena->blockCount)
+        {
+            arena->blocks[next] = (char*)malloc(blockSize);
+            arena->sizes[next] = blockSize;
+            arena->blockCount = next + 1;
+        }
+        arena->previousUsed += arena->sizes[arena->block];
+        arena->block = next;
+        arena->used = 0;
+    }
+
+    void* pointer = arena->blocks[arena->block] + arena->used;
+    arena->used += size;
+    return pointer;
+}
+
+void ScratchMemory::deallocate(void* pointer, size_t size)
+{
+    ScratchArena* arena = __arena;
+    if (pointer == NULL || arena == NULL)
+        return;
+
+    // Only the last allocation can be given back, which covers containers that grow one at a time.
+    size = (size + SCRATCH_MEMORY_ALIGNMENT - 1) & ~(size_t)(SCRATCH_MEMORY_ALIGNMENT - 1);
+    if (arena->used >= size && (char*)pointer == arena->blocks[arena->block] + arena->used - size)
+    {
+        arena->used -= size;
+    }
+}
+
+size_t ScratchMemory::getUsedSize()
+{
+    ScratchArena* arena = __arena;
+    if (arena == NULL || (arena->frame != __frame && arena->scopes == 0))
+        return 0;
+    return arena->previousUsed + arena->used;
+}
+
+size_t ScratchMemory::getCapacity()
+{
+    ScratchArena* arena = __arena;
+    if (arena == NULL)
+        return 0;
+
+    size_t capacity = 0;
+    for (unsigned int i = 0; i < arena->blockCount; ++i)
+    {
+        capacity += arena->sizes[i];
+    }
+    return capacity;
+}
+
+void ScratchMemory::endFrame()
+{
+    // The other threads reset their memory when they next allocate.
+    Atomic::increment(&__frame);
+
+    ScratchArena* arena = __arena;
+    if (arena && arena->scopes == 0)
+    {
+        resetArena(arena);
+    }
+}
+
+}
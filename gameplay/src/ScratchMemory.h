@@ -0,0 +1,192 @@
+#ifndef SCRATCHMEMORY_H_
+#define SCRATCHMEMORY_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines the scratch memory of each thread, a linear allocator for the transient data of a frame.
+ *
+ * Allocating scratch memory only bumps a pointer into a block owned by the calling thread, and
+ * nothing is freed one allocation at a time: the scratch memory of the game thread is reset at
+ * the end of each frame, all at once. The engine builds the temporary arrays of its hot paths
+ * (text layout, batched physics queries, collision events, navigation queries and skinning)
+ * in scratch memory, so they cost no heap allocations once the blocks have grown to the needs
+ * of a frame. Containers use it through ScratchAllocator:
+ *
+ * @code
+   ScratchVector<Node*>::type visible;
+   for (Node* node = scene->getFirstNode(); node; node = node->getNextSibling())
+   {
+       if (node->getModel() && node->getBoundingSphere().intersects(camera->getFrustum()))
+           visible.push_back(node);
+   }
+ * @endcode
+ *
+ * Scratch memory must not be kept past the end of the frame it was allocated in, and must be
+ * freed by the thread that allocated it. Other threads (such as the threads of the JobScheduler)
+ * reset their scratch memory the first time they allocate in a new frame, so their work must
+ * not keep scratch memory across frames either, unless it is within a Scope.
+ *
+ * A Scope frees the scratch memory allocated while it is open when it closes, which bounds
+ * the memory used by loops, and holds back the reset of the memory of its thread.
+ *
+ * The blocks of each thread start at 64 KB and grow to what the busiest frame allocated. They
+ * are kept until the process exits.
+ *
+ * @script{ignore}
+ */
+class ScratchMemory
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Frees the scratch memory of the calling thread allocated while it is in scope.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Constructor. Marks the scratch memory allocated so far on the calling thread.
+         */
+        Scope();
+
+        /**
+         * Destructor. Frees the scratch memory allocated since the constructor on the calling thread.
+         */
+        ~Scope();
+
+    private:
+
+        Scope(const Scope& copy);
+
+        Scope& operator=(const Scope&);
+
+        unsigned int _block;
+        size_t _used;
+    };
+
+    /**
+     * Allocates scratch memory on the calling thread.
+     *
+     * @param size The size of the memory to allocate, in bytes.
+     *
+     * @return The allocated memory, aligned for any type, valid until the end of the frame.
+     */
+    static void* allocate(size_t size);
+
+    /**
+     * Frees scratch memory allocated by allocate() on the calling thread.
+     *
+     * The memory is only reused before the end of the frame if it was the last allocated.
+     *
+     * @param pointer The memory to free, or NULL.
+     * @param size The size the memory was allocated with.
+     */
+    static void deallocate(void* pointer, size_t size);
+
+    /**
+     * Returns the scratch memory in use on the calling thread.
+     *
+     * @return The size of the live allocations, in bytes.
+     */
+    static size_t getUsedSize();
+
+    /**
+     * Returns the size of the blocks of scratch memory held by the calling thread.
+     *
+     * @return The size of the blocks, in bytes.
+     */
+    static size_t getCapacity();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    ScratchMemory();
+
+    /**
+     * Resets the scratch memory of the game thread, and starts a new frame for the other threads. Called by Game::frame.
+     */
+    static void endFrame();
+};
+
+/**
+ * Defines an allocator for standard containers that allocates from the scratch memory of the calling thread.
+ *
+ * The containers must be destroyed before the end of the frame, on the thread that created them.
+ *
+ * @script{ignore}
+ */
+template <class T>
+class ScratchAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef ScratchAllocator<U> other;
+    };
+
+    ScratchAllocator() { }
+
+    ScratchAllocator(const ScratchAllocator&) { }
+
+    template <class U>
+    ScratchAllocator(const ScratchAllocator<U>&) { }
+
+    pointer address(reference value) const { return &value; }
+
+    const_pointer address(const_reference value) const { return &value; }
+
+    pointer allocate(size_type count, const void* hint = 0) { return (pointer)ScratchMemory::allocate(count * sizeof(T)); }
+
+    void deallocate(pointer p, size_type count) { ScratchMemory::deallocate(p, count * sizeof(T)); }
+
+    size_type max_size() const { return ((size_type)-1) / sizeof(T); }
+
+    void construct(pointer p, const T& value)
+    {
+#ifdef GP_USE_MEM_LEAK_DETECTION
+#undef new
+        new ((void*)p) T(value);
+#define new DEBUG_NEW
+#else
+        new ((void*)p) T(value);
+#endif
+    }
+
+    void destroy(pointer p) { p->~T(); }
+
+    bool operator==(const ScratchAllocator&) const { return true; }
+
+    bool operator!=(const ScratchAllocator&) const { return false; }
+};
+
+/**
+ * Defines the type of a vector allocated from scratch memory.
+ *
+ * @script{ignore}
+ */
+template <class T>
+struct ScratchVector
+{
+    typedef std::vector<T, ScratchAllocator<T> > type;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "Base.h"
 #include "FileSystem.h"
 #include "ScriptController.h"
+#include "MemoryTracker.h"
 
 #ifndef NO_LUA_BINDINGS
 #include "lua/lua_all_bindings.h"
@@ -42,6 +43,13 @@
     \
     return arr
 
+// The end of the lists of tasks of the pool.
+#define SCRIPT_TASK_NONE 0xFFFFFFFF
+
+// The number of bits of the index of a task in its handle, below the serial of the task.
+#define SCRIPT_TASK_INDEX_BITS 16
+#define SCRIPT_TASK_INDEX_MASK ((1 << SCRIPT_TASK_INDEX_BITS) - 1)
+
 #define PUSH_NESTED_VARIABLE(name, defaultValue) \
     int top = lua_gettop(_lua); \
     if (!getNestedVariable(_lua, (name))) \
@@ -153,6 +161,18 @@ void ScriptUtil::registerConstantBool(const std::string& name, bool value, const
 {
     ScriptController* sc = Game::getInstance()->getScriptController();
 
+    // Keep the constants of classes that are not registered yet until they are.
+    if (!scopePath.empty() && sc->_lazyClasses.find(scopePath[0]) != sc->_lazyClasses.end())
+    {
+        ScriptController::LazyConstant constant;
+        constant.name = name;
+        constant.type = LUA_TBOOLEAN;
+        constant.boolean = value;
+        constant.scopePath = scopePath;
+        sc->_lazyConstants[scopePath[0]].push_back(constant);
+        return;
+    }
+
     // If the constant is within a scope, get the correct parent 
     // table on the stack before setting its value.
     if (!scopePath.empty())
@@ -186,6 +206,18 @@ void ScriptUtil::registerConstantNumber(const std::string& name, double value, c
 {
     ScriptController* sc = Game::getInstance()->getScriptController();
 
+    // Keep the constants of classes that are not registered yet until they are.
+    if (!scopePath.empty() && sc->_lazyClasses.find(scopePath[0]) != sc->_lazyClasses.end())
+    {
+        ScriptController::LazyConstant constant;
+        constant.name = name;
+        constant.type = LUA_TNUMBER;
+        constant.number = value;
+        constant.scopePath = scopePath;
+        sc->_lazyConstants[scopePath[0]].push_back(constant);
+        return;
+    }
+
     // If the constant is within a scope, get the correct parent 
     // table on the stack before setting its value.
     if (!scopePath.empty())
@@ -219,6 +251,18 @@ void ScriptUtil::registerConstantString(const std::string& name, const std::stri
 {
     ScriptController* sc = Game::getInstance()->getScriptController();
 
+    // Keep the constants of classes that are not registered yet until they are.
+    if (!scopePath.empty() && sc->_lazyClasses.find(scopePath[0]) != sc->_lazyClasses.end())
+    {
+        ScriptController::LazyConstant constant;
+        constant.name = name;
+        constant.type = LUA_TSTRING;
+        constant.string = value;
+        constant.scopePath = scopePath;
+        sc->_lazyConstants[scopePath[0]].push_back(constant);
+        return;
+    }
+
     // If the constant is within a scope, get the correct parent 
     // table on the stack before setting its value.
     if (!scopePath.empty())
@@ -334,6 +378,26 @@ void ScriptUtil::registerClass(const char* name, const luaL_Reg* members, lua_CF
     }
 }
 
+void ScriptUtil::registerClassLazy(const char* scope, const char* type, luaRegisterFunction registerFunction)
+{
+    GP_ASSERT(scope);
+    GP_ASSERT(type);
+    GP_ASSERT(registerFunction);
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    ScriptController::LazyClass lazyClass;
+    lazyClass.type = type;
+    lazyClass.registerFunction = registerFunction;
+
+    // The class that owns the scope is registered before the classes within it.
+    std::vector<ScriptController::LazyClass>& classes = sc->_lazyClasses[scope];
+    if (strcmp(scope, type) == 0)
+        classes.insert(classes.begin(), lazyClass);
+    else
+        classes.push_back(lazyClass);
+    sc->_lazyTypes[type] = scope;
+}
+
 void ScriptUtil::registerFunction(const char* luaFunction, lua_CFunction cppFunction)
 {
     lua_pushcfunction(Game::getInstance()->getScriptController()->_lua, cppFunction);
@@ -413,6 +477,69 @@ const char* ScriptUtil::getString(int index, bool isStdString)
     }
 }
 
+void ScriptUtil::pushObject(lua_State* state, void* instance, const char* type, bool owns, bool cache)
+{
+    if (instance == NULL)
+    {
+        lua_pushnil(state);
+        return;
+    }
+
+    if (cache)
+    {
+        GP_ASSERT(!owns);
+
+        // Look up the wrapper in the cache, creating the cache (with weak values) the first time.
+        lua_getfield(state, LUA_REGISTRYINDEX, "gameplay.objects");
+        if (lua_isnil(state, -1))
+        {
+            lua_pop(state, 1);
+            lua_newtable(state);
+            lua_newtable(state);
+            lua_pushstring(state, "v");
+            lua_setfield(state, -2, "__mode");
+            lua_setmetatable(state, -2);
+            lua_pushvalue(state, -1);
+            lua_setfield(state, LUA_REGISTRYINDEX, "gameplay.objects");
+        }
+        lua_pushlightuserdata(state, instance);
+        lua_rawget(state, -2);
+
+        // Objects may share an address with their first member, so the type must match too.
+        if (lua_isuserdata(state, -1) && lua_getmetatable(state, -1))
+        {
+            luaL_getmetatable(state, type);
+            bool sameType = lua_rawequal(state, -1, -2) != 0;
+            lua_pop(state, 2);
+            if (sameType)
+            {
+                lua_remove(state, -2);
+                return;
+            }
+        }
+        lua_pop(state, 1);
+    }
+
+    LuaObject* object = (LuaObject*)lua_newuserdata(state, sizeof(LuaObject));
+    object->instance = instance;
+    object->owns = owns;
+    luaL_getmetatable(state, type);
+    if (lua_isnil(state, -1) && Game::getInstance()->getScriptController()->registerLazyType(type))
+    {
+        lua_pop(state, 1);
+        luaL_getmetatable(state, type);
+    }
+    lua_setmetatable(state, -2);
+
+    if (cache)
+    {
+        lua_pushlightuserdata(state, instance);
+        lua_pushvalue(state, -2);
+        lua_rawset(state, -4);
+        lua_remove(state, -2);
+    }
+}
+
 bool ScriptUtil::luaCheckBool(lua_State* state, int n)
 {
     if (!lua_isboolean(state, n))
@@ -425,6 +552,12 @@ bool ScriptUtil::luaCheckBool(lua_State* state, int n)
 }
 
 
+static int writeBytecode(lua_State* state, const void* data, size_t size, void* bytecode)
+{
+    ((std::string*)bytecode)->append((const char*)data, size);
+    return 0;
+}
+
 void ScriptController::loadScript(const char* path, bool forceReload)
 {
     GP_ASSERT(path);
@@ -435,33 +568,15 @@ void ScriptController::loadScript(const char* path, bool forceReload)
         if (iter == _loadedScripts.end())
             _loadedScripts.insert(path); // insert before loading script to prevent load recursion
 
-#ifdef __ANDROID__
-        const char* scriptContents = FileSystem::readAll(path);
-        if (luaL_dostring(_lua, scriptContents))
-        {
-            GP_WARN("Failed to run Lua script with error: '%s'.", lua_tostring(_lua, -1));
-        }
-        else
-        {
-            success = true;
-        }
-        SAFE_DELETE_ARRAY(scriptContents);
-#else
-        std::string fullPath;
-        if (!FileSystem::isAbsolutePath(path))
-        {
-            fullPath.append(FileSystem::getResourcePath());
-        }
-        fullPath.append(path);
-        if (luaL_dofile(_lua, fullPath.c_str()))
+        if (!loadChunk(path) || lua_pcall(_lua, 0, 0, 0))
         {
             GP_WARN("Failed to run Lua script with error: '%s'.", lua_tostring(_lua, -1));
+            lua_pop(_lua, 1);
         }
         else
         {
             success = true;
         }
-#endif
         if (!success && (iter == _loadedScripts.end()))
         {
             iter = _loadedScripts.find(path);
@@ -470,6 +585,68 @@ void ScriptController::loadScript(const char* path, bool forceReload)
     }
 }
 
+bool ScriptController::loadChunk(const char* path)
+{
+    std::string chunkName = "@";
+    chunkName.append(path);
+
+    // Prefer bytecode precompiled at build time, falling back to the source if it is incompatible.
+    std::string bytecodePath = path;
+    bytecodePath.append("c");
+    if (FileSystem::fileExists(bytecodePath.c_str()))
+    {
+        int size = 0;
+        char* bytecode = FileSystem::readAll(bytecodePath.c_str(), &size);
+        if (bytecode)
+        {
+            int status = luaL_loadbuffer(_lua, bytecode, size, chunkName.c_str());
+            SAFE_DELETE_ARRAY(bytecode);
+            if (status == 0)
+                return true;
+            GP_WARN("Failed to load precompiled Lua script '%s' with error: '%s'.", bytecodePath.c_str(), lua_tostring(_lua, -1));
+            lua_pop(_lua, 1);
+        }
+    }
+
+    int size = 0;
+    char* source = FileSystem::readAll(path, &size);
+    if (source == NULL)
+    {
+        lua_pushfstring(_lua, "cannot read %s", path);
+        return false;
+    }
+
+    // Reuse the bytecode of a script with the same contents if it was compiled before.
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < size; ++i)
+    {
+        hash = (hash ^ (unsigned char)source[i]) * 16777619u;
+    }
+    std::map<unsigned int, std::string>::iterator itr = _bytecode.find(hash);
+    if (itr != _bytecode.end() && luaL_loadbuffer(_lua, itr->second.data(), itr->second.size(), chunkName.c_str()) == 0)
+    {
+        SAFE_DELETE_ARRAY(source);
+        return true;
+    }
+    if (itr != _bytecode.end())
+    {
+        lua_pop(_lua, 1);
+        _bytecode.erase(itr);
+    }
+
+    int status = luaL_loadbuffer(_lua, source, size, chunkName.c_str());
+    SAFE_DELETE_ARRAY(source);
+    if (status != 0)
+        return false;
+
+    std::string& bytecode = _bytecode[hash];
+    if (lua_dump(_lua, writeBytecode, &bytecode) != 0)
+    {
+        _bytecode.erase(hash);
+    }
+    return true;
+}
+
 std::string ScriptController::loadUrl(const char* url)
 {
     std::string file;
@@ -668,7 +845,8 @@ void ScriptController::print(const char* str1, const char* str2)
     gameplay::print("%s%s", str1, str2);
 }
 
-ScriptController::ScriptController() : _lua(NULL)
+ScriptController::ScriptController() : _lua(NULL), _gcBudget(0.0f), _collectedBytes(0),
+    _freeTask(SCRIPT_TASK_NONE), _taskCount(0), _runningTask(SCRIPT_TASK_NONE)
 {
 }
 
@@ -681,15 +859,15 @@ static const char* lua_print_function =
     "    ScriptController.print(table.concat({...},\"\\t\"), \"\\n\")\n"
     "end\n";
 
+// Relative paths are read through the FileSystem, so that Android assets are read in place from the package.
 static const char* lua_loadfile_function = 
     "do\n"
     "    local oldLoadfile = loadfile\n"
-    "    loadfile = function(filename)\n"
+    "    loadfile = function(filename, ...)\n"
     "        if filename ~= nil and not FileSystem.isAbsolutePath(filename) then\n"
-    "            FileSystem.createFileFromAsset(filename)\n"
-    "            filename = FileSystem.getResourcePath() .. filename\n"
+    "            return loadResourceFile(filename)\n"
     "        end\n"
-    "        return oldLoadfile(filename)\n"
+    "        return oldLoadfile(filename, ...)\n"
     "    end\n"
     "end\n";
 
@@ -698,13 +876,30 @@ static const char* lua_dofile_function =
     "    local oldDofile = dofile\n"
     "    dofile = function(filename)\n"
     "        if filename ~= nil and not FileSystem.isAbsolutePath(filename) then\n"
-    "            FileSystem.createFileFromAsset(filename)\n"
-    "            filename = FileSystem.getResourcePath() .. filename\n"
+    "            local chunk, message = loadResourceFile(filename)\n"
+    "            if chunk == nil then\n"
+    "                error(message, 2)\n"
+    "            end\n"
+    "            return chunk()\n"
     "        end\n"
     "        return oldDofile(filename)\n"
     "    end\n"
     "end\n";
 
+// Modules are looked up in the resources before the LUA_PATH, since the path cannot reach Android assets.
+static const char* lua_searcher_function = 
+    "table.insert(package.searchers, 2, function(name)\n"
+    "    local filename = string.gsub(name, '%.', '/') .. '.lua'\n"
+    "    if not FileSystem.fileExists(filename) then\n"
+    "        return \"\\n\\tno resource '\" .. filename .. \"'\"\n"
+    "    end\n"
+    "    local chunk, message = loadResourceFile(filename)\n"
+    "    if chunk == nil then\n"
+    "        error(message, 2)\n"
+    "    end\n"
+    "    return chunk, filename\n"
+    "end)\n";
+
 /**
  * @script{ignore}
  */
@@ -728,18 +923,67 @@ void appendLuaPath(lua_State* state, const char* path)
     lua_pop(state, 1);
 }
 
+/**
+ * Allocates the memory of the Lua state, counting it against the script memory.
+ */
+static void* allocateLua(void* userData, void* pointer, size_t oldSize, size_t newSize)
+{
+    // The old size is not the size of a block when there is no block.
+    if (pointer)
+        MemoryTracker::untrack(MemoryTracker::SCRIPT, (unsigned int)oldSize);
+    if (newSize == 0)
+    {
+        free(pointer);
+        return NULL;
+    }
+
+    void* block = realloc(pointer, newSize);
+    if (block)
+        MemoryTracker::track(MemoryTracker::SCRIPT, (unsigned int)newSize);
+    else if (pointer)
+        MemoryTracker::track(MemoryTracker::SCRIPT, (unsigned int)oldSize);
+    return block;
+}
+
+/**
+ * Reports the errors raised outside of a protected call, like the panic function of luaL_newstate().
+ */
+static int panicLua(lua_State* state)
+{
+    GP_ERROR("Unprotected error in call to Lua API (%s).", lua_tostring(state, -1));
+    return 0;
+}
+
 void ScriptController::initialize()
 {
-    _lua = luaL_newstate();
+    _lua = lua_newstate(allocateLua, NULL);
+    if (_lua)
+        lua_atpanic(_lua, panicLua);
     if (!_lua)
         GP_ERROR("Failed to initialize Lua scripting engine.");
     luaL_openlibs(_lua);
 
 #ifndef NO_LUA_BINDINGS
+    // Register the classes of the bindings when scripts first read them, through the metatable of the global table.
+    lua_pushglobaltable(_lua);
+    lua_newtable(_lua);
+    lua_pushcfunction(_lua, indexGlobals);
+    lua_setfield(_lua, -2, "__index");
+    lua_setmetatable(_lua, -2);
+    lua_pop(_lua, 1);
+
     lua_RegisterAllBindings();
     ScriptUtil::registerFunction("convert", ScriptController::convert);
 #endif
 
+    // Register the functions of the tasks.
+    ScriptUtil::registerFunction("startTask", ScriptController::luaStartTask);
+    ScriptUtil::registerFunction("cancelTask", ScriptController::luaCancelTask);
+    ScriptUtil::registerFunction("waitTime", ScriptController::luaWaitTime);
+    ScriptUtil::registerFunction("waitFrames", ScriptController::luaWaitFrames);
+    ScriptUtil::registerFunction("waitForClip", ScriptController::luaWaitForClip);
+    ScriptUtil::registerFunction("loadResourceFile", ScriptController::luaLoadResourceFile);
+
     // Append to the LUA_PATH to allow scripts to be found in the resource folder on all platforms
     appendLuaPath(_lua, FileSystem::getResourcePath());
 
@@ -752,6 +996,8 @@ void ScriptController::initialize()
         GP_ERROR("Failed to load custom loadfile() function with error: '%s'.", lua_tostring(_lua, -1));
     if (luaL_dostring(_lua, lua_dofile_function))
         GP_ERROR("Failed to load custom dofile() function with error: '%s'.", lua_tostring(_lua, -1));
+    if (luaL_dostring(_lua, lua_searcher_function))
+        GP_ERROR("Failed to load the resource module searcher with error: '%s'.", lua_tostring(_lua, -1));
 
     // Write game command-line arguments to a global lua "arg" table
     std::ostringstream args;
@@ -773,23 +1019,38 @@ void ScriptController::initialize()
 
 void ScriptController::initializeGame()
 {
-    std::vector<std::string>& list = _callbacks[INITIALIZE];
+    std::vector<ScriptFunction>& list = _callbacks[INITIALIZE];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str());
+        list[i].call<void>();
 }
 
 void ScriptController::finalize()
 {
+    // Cancel the timers and release the clips of the pending tasks.
+    for (unsigned int i = 0, count = (unsigned int)_tasks.size(); i < count; ++i)
+    {
+        if (_tasks[i].active)
+            releaseTask(i, false);
+    }
+    _tasks.clear();
+    _frameTasks.clear();
+    _resumedTasks.clear();
+    _freeTask = SCRIPT_TASK_NONE;
+    _taskCount = 0;
+
     if (_lua)
 	{
         lua_close(_lua);
 		_lua = NULL;
 	}
+    _lazyClasses.clear();
+    _lazyTypes.clear();
+    _lazyConstants.clear();
 }
 
 void ScriptController::finalizeGame()
 {
-    std::vector<std::string> finalizeCallbacks = _callbacks[FINALIZE]; // no & : makes a copy of the vector
+    std::vector<ScriptFunction> finalizeCallbacks = _callbacks[FINALIZE]; // no & : makes a copy of the vector
 
 	// Remove any registered callbacks so they don't get called after shutdown
 	for (unsigned int i = 0; i < CALLBACK_COUNT; i++)
@@ -797,7 +1058,7 @@ void ScriptController::finalizeGame()
 
 	// Fire script finalize callbacks
     for (size_t i = 0; i < finalizeCallbacks.size(); ++i)
-        executeFunction<void>(finalizeCallbacks[i].c_str());
+        finalizeCallbacks[i].call<void>();
 
     // Perform a full garbage collection cycle.
 	// Note that this does NOT free any global variables declared in scripts, since 
@@ -806,47 +1067,98 @@ void ScriptController::finalizeGame()
     lua_gc(_lua, LUA_GCCOLLECT, 0);
 }
 
+void ScriptController::setGarbageCollectionBudget(float budget)
+{
+    GP_ASSERT(_lua);
+    GP_ASSERT(budget >= 0.0f);
+
+    if (budget > 0.0f && _gcBudget <= 0.0f)
+        lua_gc(_lua, LUA_GCSTOP, 0);
+    else if (budget <= 0.0f && _gcBudget > 0.0f)
+        lua_gc(_lua, LUA_GCRESTART, 0);
+    _gcBudget = budget;
+    _collectedBytes = 0;
+}
+
+float ScriptController::getGarbageCollectionBudget() const
+{
+    return _gcBudget;
+}
+
+unsigned int ScriptController::getCollectedBytes() const
+{
+    return _collectedBytes;
+}
+
+unsigned int ScriptController::getMemoryUsage() const
+{
+    GP_ASSERT(_lua);
+    return (unsigned int)lua_gc(_lua, LUA_GCCOUNT, 0) * 1024 + (unsigned int)lua_gc(_lua, LUA_GCCOUNTB, 0);
+}
+
+void ScriptController::collectGarbage()
+{
+    _collectedBytes = 0;
+    if (_gcBudget <= 0.0f || !_lua)
+        return;
+
+    // Step the collector until the budget is spent or a cycle completes.
+    unsigned int memory = getMemoryUsage();
+    double end = Game::getAbsoluteTime() + _gcBudget;
+    while (lua_gc(_lua, LUA_GCSTEP, 0) == 0 && Game::getAbsoluteTime() < end)
+    {
+    }
+
+    // No scripts run while stepping, so the memory difference is what was freed.
+    unsigned int remaining = getMemoryUsage();
+    _collectedBytes = memory > remaining ? memory - remaining : 0;
+}
+
 void ScriptController::update(float elapsedTime)
 {
-    std::vector<std::string>& list = _callbacks[UPDATE];
+    // Tasks only count the updates of the running game.
+    if (!_frameTasks.empty() && Game::getInstance()->getState() == Game::RUNNING)
+        resumeFrameTasks();
+
+    std::vector<ScriptFunction>& list = _callbacks[UPDATE];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "f", elapsedTime);
+        list[i].call<void>(elapsedTime);
 }
 
 void ScriptController::render(float elapsedTime)
 {
-    std::vector<std::string>& list = _callbacks[RENDER];
+    std::vector<ScriptFunction>& list = _callbacks[RENDER];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "f", elapsedTime);
+        list[i].call<void>(elapsedTime);
 }
 
 void ScriptController::resizeEvent(unsigned int width, unsigned int height)
 {
-    std::vector<std::string>& list = _callbacks[RESIZE_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[RESIZE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "uiui", width, height);
+        list[i].call<void>(width, height);
 }
 
 void ScriptController::keyEvent(Keyboard::KeyEvent evt, int key)
 {
-    std::vector<std::string>& list = _callbacks[KEY_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[KEY_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Keyboard::KeyEvent][Keyboard::Key]", evt, key);
+        list[i].call<void>(ScriptFunction::Enum("Keyboard::KeyEvent", evt), ScriptFunction::Enum("Keyboard::Key", key));
 }
 
 void ScriptController::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
 {
-    std::vector<std::string>& list = _callbacks[TOUCH_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[TOUCH_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Touch::TouchEvent]iiui", evt, x, y, contactIndex);
+        list[i].call<void>(ScriptFunction::Enum("Touch::TouchEvent", evt), x, y, contactIndex);
 }
 
 bool ScriptController::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
 {
-    std::vector<std::string>& list = _callbacks[MOUSE_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[MOUSE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
     {
-        if (executeFunction<bool>(list[i].c_str(), "[Mouse::MouseEvent]iii", evt, x, y, wheelDelta))
+        if (list[i].call<bool>(ScriptFunction::Enum("Mouse::MouseEvent", evt), x, y, wheelDelta))
             return true;
     }
     return false;
@@ -854,23 +1166,23 @@ bool ScriptController::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheel
 
 void ScriptController::gestureSwipeEvent(int x, int y, int direction)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_SWIPE_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[GESTURE_SWIPE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "iii", x, y, direction);
+        list[i].call<void>(x, y, direction);
 }
 
 void ScriptController::gesturePinchEvent(int x, int y, float scale)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_PINCH_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[GESTURE_PINCH_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "iif", x, y, scale);
+        list[i].call<void>(x, y, scale);
 }
 
 void ScriptController::gestureTapEvent(int x, int y)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_TAP_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[GESTURE_TAP_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "ii", x, y);
+        list[i].call<void>(x, y);
 }
 
 void ScriptController::gestureLongTapEvent(int x, int y, float duration)
@@ -887,9 +1199,9 @@ void ScriptController::gestureDropEvent(int x, int y)
 
 void ScriptController::gamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
 {
-    std::vector<std::string>& list = _callbacks[GAMEPAD_EVENT];
+    std::vector<ScriptFunction>& list = _callbacks[GAMEPAD_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Gamepad::GamepadEvent]<Gamepad>", evt, gamepad);
+        list[i].call<void>(ScriptFunction::Enum("Gamepad::GamepadEvent", evt), ScriptFunction::Object("Gamepad", gamepad));
 }
 
 void ScriptController::executeFunctionHelper(int resultCount, const char* func, const char* args, va_list* list)
@@ -909,10 +1221,337 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
         return;
     }
 
+    // Push the arguments to the Lua stack if there are any.
+    int argumentCount = pushArguments(args, list);
+
+    // Perform the function call.
+    if (lua_pcall(_lua, argumentCount, resultCount, 0) != 0)
+        GP_WARN("Failed to call function '%s' with error '%s'.", func, lua_tostring(_lua, -1));
+}
+
+unsigned int ScriptController::startTask(const char* function)
+{
+    GP_ASSERT(_lua && function);
+
+    std::string name = loadUrl(function);
+    int top = lua_gettop(_lua);
+    if (!pushVariable(name.c_str()) || !lua_isfunction(_lua, -1))
+    {
+        GP_WARN("Failed to start task: function '%s' does not exist.", name.c_str());
+        lua_settop(_lua, top);
+        return 0;
+    }
+    return startTask(_lua, 0);
+}
+
+bool ScriptController::cancelTask(unsigned int handle)
+{
+    Task* task = getTask(handle);
+    if (!task)
+        return false;
+
+    unsigned int index = handle & SCRIPT_TASK_INDEX_MASK;
+    if (index == _runningTask)
+    {
+        // The coroutine cannot be released while it runs, so it is released when it waits.
+        task->cancelled = true;
+        --_taskCount;
+    }
+    else
+    {
+        releaseTask(index, false);
+    }
+    return true;
+}
+
+unsigned int ScriptController::getTaskCount() const
+{
+    return _taskCount;
+}
+
+unsigned int ScriptController::startTask(lua_State* state, int argumentCount)
+{
+    GP_ASSERT(state && lua_isfunction(state, -argumentCount - 1));
+
+    unsigned int index = _freeTask;
+    if (index == SCRIPT_TASK_NONE)
+    {
+        index = (unsigned int)_tasks.size();
+        if (index > SCRIPT_TASK_INDEX_MASK)
+        {
+            GP_WARN("Failed to start task: there are too many tasks.");
+            lua_pop(state, argumentCount + 1);
+            return 0;
+        }
+
+        Task task;
+        task.thread = NULL;
+        task.ref = LUA_NOREF;
+        task.serial = 0;
+        _tasks.push_back(task);
+    }
+    else
+    {
+        _freeTask = _tasks[index].next;
+    }
+
+    Task& task = _tasks[index];
+    if (!task.thread)
+    {
+        // The registry keeps the coroutine alive while the task holds it.
+        task.thread = lua_newthread(state);
+        task.ref = luaL_ref(state, LUA_REGISTRYINDEX);
+    }
+    task.serial = (task.serial + 1) & (0xFFFFFFFF >> SCRIPT_TASK_INDEX_BITS);
+    if (task.serial == 0)
+        task.serial = 1;
+    task.active = true;
+    task.cancelled = false;
+    task.wait = TASK_RUNNING;
+    task.frames = 0;
+    task.timeEvent = 0;
+    task.clip = NULL;
+    task.next = SCRIPT_TASK_NONE;
+    ++_taskCount;
+
+    lua_xmove(state, task.thread, argumentCount + 1);
+    unsigned int handle = getTaskHandle(index);
+    resumeTask(index, argumentCount);
+    return handle;
+}
+
+void ScriptController::resumeTask(unsigned int index, int argumentCount)
+{
+    GP_ASSERT(index < _tasks.size() && _tasks[index].active);
+
+    // The bindings read their arguments from _lua, so it refers to the coroutine while it runs.
+    lua_State* thread = _tasks[index].thread;
+    lua_State* previousLua = _lua;
+    unsigned int previousTask = _runningTask;
+    _lua = thread;
+    _runningTask = index;
+    int result = lua_resume(thread, previousLua, argumentCount);
+    _lua = previousLua;
+    _runningTask = previousTask;
+
+    // The task may have started other tasks, which can move the pool.
+    Task& task = _tasks[index];
+    if (result == LUA_YIELD)
+    {
+        if (task.cancelled)
+        {
+            releaseTask(index, false);
+            return;
+        }
+
+        // Discard the values passed to yield.
+        lua_settop(thread, 0);
+        if (task.wait == TASK_RUNNING)
+        {
+            // A plain coroutine.yield() waits for the next update.
+            task.wait = TASK_WAIT_FRAMES;
+            task.frames = 1;
+        }
+        if (task.wait != TASK_WAIT_TIME)
+            _frameTasks.push_back(getTaskHandle(index));
+    }
+    else if (result == LUA_OK)
+    {
+        // The coroutine returned, so it can run the function of the next task.
+        lua_settop(thread, 0);
+        releaseTask(index, true);
+    }
+    else
+    {
+        GP_WARN("Task failed with error '%s'.", lua_tostring(thread, -1));
+        releaseTask(index, false);
+    }
+}
+
+void ScriptController::releaseTask(unsigned int index, bool reuseThread)
+{
+    Task& task = _tasks[index];
+    GP_ASSERT(task.active);
+
+    if (!task.cancelled)
+        --_taskCount;
+    if (task.timeEvent)
+        Game::getInstance()->cancelTimeEvent(task.timeEvent);
+    SAFE_RELEASE(task.clip);
+    if (!reuseThread && task.thread)
+    {
+        if (_lua)
+            luaL_unref(_lua, LUA_REGISTRYINDEX, task.ref);
+        task.thread = NULL;
+        task.ref = LUA_NOREF;
+    }
+    task.active = false;
+    task.cancelled = false;
+    task.timeEvent = 0;
+    task.next = _freeTask;
+    _freeTask = index;
+}
+
+void ScriptController::resumeFrameTasks()
+{
+    // Tasks that wait again are added to the cleared list.
+    _resumedTasks.swap(_frameTasks);
+    _frameTasks.clear();
+    for (size_t i = 0, count = _resumedTasks.size(); i < count; ++i)
+    {
+        unsigned int handle = _resumedTasks[i];
+        Task* task = getTask(handle);
+        if (!task)
+            continue;
+
+        bool ready;
+        if (task->wait == TASK_WAIT_FRAMES)
+            ready = --task->frames == 0;
+        else
+            ready = task->wait != TASK_WAIT_CLIP || !task->clip->isPlaying();
+        if (!ready)
+        {
+            _frameTasks.push_back(handle);
+            continue;
+        }
+
+        task->wait = TASK_RUNNING;
+        SAFE_RELEASE(task->clip);
+        resumeTask(handle & SCRIPT_TASK_INDEX_MASK, 0);
+    }
+    _resumedTasks.clear();
+}
+
+ScriptController::Task* ScriptController::getTask(unsigned int handle)
+{
+    unsigned int index = handle & SCRIPT_TASK_INDEX_MASK;
+    if (index >= _tasks.size())
+        return NULL;
+
+    Task& task = _tasks[index];
+    if (!task.active || task.cancelled || task.serial != handle >> SCRIPT_TASK_INDEX_BITS)
+        return NULL;
+    return &task;
+}
+
+unsigned int ScriptController::getTaskHandle(unsigned int index) const
+{
+    return (_tasks[index].serial << SCRIPT_TASK_INDEX_BITS) | index;
+}
+
+unsigned int ScriptController::getRunningTask(lua_State* state, const char* function)
+{
+    if (_runningTask == SCRIPT_TASK_NONE || _tasks[_runningTask].thread != state)
+        luaL_error(state, "%s must be called from a task (see startTask).", function);
+    return _runningTask;
+}
+
+int ScriptController::luaStartTask(lua_State* state)
+{
+    luaL_checktype(state, 1, LUA_TFUNCTION);
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int argumentCount = lua_gettop(state) - 1;
+    unsigned int handle = sc->startTask(state, argumentCount);
+    lua_pushunsigned(state, handle);
+    return 1;
+}
+
+int ScriptController::luaCancelTask(lua_State* state)
+{
+    unsigned int handle = luaL_checkunsigned(state, 1);
+    lua_pushboolean(state, Game::getInstance()->getScriptController()->cancelTask(handle));
+    return 1;
+}
+
+int ScriptController::luaWaitTime(lua_State* state)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    unsigned int index = sc->getRunningTask(state, "waitTime");
+    float time = (float)luaL_checknumber(state, 1);
+
+    Task& task = sc->_tasks[index];
+    task.wait = TASK_WAIT_TIME;
+    task.timeEvent = Game::getInstance()->schedule(time, &sc->_taskTimeListener, (void*)(size_t)sc->getTaskHandle(index));
+    return lua_yield(state, 0);
+}
+
+int ScriptController::luaWaitFrames(lua_State* state)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    unsigned int index = sc->getRunningTask(state, "waitFrames");
+    int frames = luaL_optint(state, 1, 1);
+
+    Task& task = sc->_tasks[index];
+    task.wait = TASK_WAIT_FRAMES;
+    task.frames = frames > 1 ? (unsigned int)frames : 1;
+    return lua_yield(state, 0);
+}
+
+int ScriptController::luaWaitForClip(lua_State* state)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    unsigned int index = sc->getRunningTask(state, "waitForClip");
+    bool success;
+    ScriptUtil::LuaArray<AnimationClip> clip = ScriptUtil::getObjectPointer<AnimationClip>(1, "AnimationClip", true, &success);
+    if (!success)
+        luaL_argerror(state, 1, "expected an AnimationClip");
+
+    // Clips have no listener that can be removed for a single task, so the task checks its clip each update.
+    Task& task = sc->_tasks[index];
+    task.wait = TASK_WAIT_CLIP;
+    task.clip = clip;
+    task.clip->addRef();
+    return lua_yield(state, 0);
+}
+
+int ScriptController::luaLoadResourceFile(lua_State* state)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    const char* path = luaL_checkstring(state, 1);
+    std::string bytecodePath = path;
+    bytecodePath.append("c");
+    if (!FileSystem::fileExists(path) && !FileSystem::fileExists(bytecodePath.c_str()))
+    {
+        lua_pushnil(state);
+        lua_pushfstring(state, "cannot open %s", path);
+        return 2;
+    }
+
+    // The chunk (or the error message) is left on the main stack, which may not be the calling thread.
+    bool loaded = sc->loadChunk(path);
+    if (state != sc->_lua)
+        lua_xmove(sc->_lua, state, 1);
+    if (loaded)
+        return 1;
+    lua_pushnil(state);
+    lua_insert(state, -2);
+    return 2;
+}
+
+void ScriptController::TaskTimeListener::timeEvent(long timeDiff, void* cookie)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    unsigned int handle = (unsigned int)(size_t)cookie;
+    Task* task = sc->getTask(handle);
+    if (!task || task->wait != TASK_WAIT_TIME)
+        return;
+
+    task->wait = TASK_RUNNING;
+    task->timeEvent = 0;
+    sc->resumeTask(handle & SCRIPT_TASK_INDEX_MASK, 0);
+}
+
+bool ScriptController::pushVariable(const char* name)
+{
+    GP_ASSERT(_lua && name);
+    return getNestedVariable(_lua, name);
+}
+
+int ScriptController::pushArguments(const char* args, va_list* list)
+{
     const char* sig = args;
     int argumentCount = 0;
-
-    // Push the arguments to the Lua stack if there are any.
     if (sig)
     {
         while (true)
@@ -961,14 +1600,7 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
                 // Skip past the closing ']' (the semi-colon here is intentional-do not remove).
                 while (*sig++ != ']');
 
-                unsigned int value = va_arg(*list, int);
-                std::string enumStr = "";
-                for (unsigned int i = 0; enumStr.size() == 0 && i < _stringFromEnum.size(); i++)
-                {
-                    enumStr = (*_stringFromEnum[i])(type, value);
-                }
-
-                lua_pushstring(_lua, enumStr.c_str());
+                pushEnum(type.c_str(), va_arg(*list, int));
                 break;
             }
             // Object references/pointers (Lua userdata).
@@ -980,29 +1612,7 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
                 // Skip past the closing '>' (the semi-colon here is intentional-do not remove).
                 while (*sig++ != '>');
 
-                // Calculate the unique Lua type name.
-                size_t i = type.find("::");
-                while (i != std::string::npos)
-                {
-                    // We use "" as the replacement here-this must match the preprocessor
-                    // define SCOPE_REPLACEMENT from the gameplay-luagen project.
-                    type.replace(i, 2, "");
-                    i = type.find("::");
-                }
-
-                void* ptr = va_arg(*list, void*);
-                if (ptr == NULL)
-                {
-                    lua_pushnil(_lua);
-                }
-                else
-                {
-                    ScriptUtil::LuaObject* object = (ScriptUtil::LuaObject*)lua_newuserdata(_lua, sizeof(ScriptUtil::LuaObject));
-                    object->instance = ptr;
-                    object->owns = false;
-                    luaL_getmetatable(_lua, type.c_str());
-                    lua_setmetatable(_lua, -2);
-                }
+                pushObject(type.c_str(), va_arg(*list, void*));
                 break;
             }
             default:
@@ -1014,10 +1624,41 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
             luaL_checkstack(_lua, 1, "Too many arguments.");
         }
     }
+    return argumentCount;
+}
 
-    // Perform the function call.
-    if (lua_pcall(_lua, argumentCount, resultCount, 0) != 0)
-        GP_WARN("Failed to call function '%s' with error '%s'.", func, lua_tostring(_lua, -1));
+void ScriptController::pushEnum(const char* type, int value)
+{
+    std::string typeName = type;
+    std::string enumStr = "";
+    for (unsigned int i = 0; enumStr.size() == 0 && i < _stringFromEnum.size(); i++)
+    {
+        enumStr = (*_stringFromEnum[i])(typeName, value);
+    }
+
+    lua_pushstring(_lua, enumStr.c_str());
+}
+
+void ScriptController::pushObject(const char* type, void* ptr)
+{
+    if (ptr == NULL)
+    {
+        lua_pushnil(_lua);
+        return;
+    }
+
+    // Calculate the unique Lua type name.
+    std::string typeName = type;
+    size_t i = typeName.find("::");
+    while (i != std::string::npos)
+    {
+        // We use "" as the replacement here-this must match the preprocessor
+        // define SCOPE_REPLACEMENT from the gameplay-luagen project.
+        typeName.replace(i, 2, "");
+        i = typeName.find("::");
+    }
+
+    ScriptUtil::pushObject(_lua, ptr, typeName.c_str(), false, true);
 }
 
 void ScriptController::registerCallback(const char* callback, const char* function)
@@ -1025,7 +1666,7 @@ void ScriptController::registerCallback(const char* callback, const char* functi
     ScriptCallback scb = toCallback(callback);
     if (scb < INVALID_CALLBACK)
     {
-        _callbacks[scb].push_back(function);
+        _callbacks[scb].push_back(ScriptFunction(function));
     }
     else
     {
@@ -1038,10 +1679,15 @@ void ScriptController::unregisterCallback(const char* callback, const char* func
     ScriptCallback scb = toCallback(callback);
     if (scb < INVALID_CALLBACK)
     {
-        std::vector<std::string>& list = _callbacks[scb];
-        std::vector<std::string>::iterator itr = std::find(list.begin(), list.end(), std::string(function));
-        if (itr != list.end())
-            list.erase(itr);
+        std::vector<ScriptFunction>& list = _callbacks[scb];
+        for (std::vector<ScriptFunction>::iterator itr = list.begin(); itr != list.end(); ++itr)
+        {
+            if (strcmp(itr->getName(), function) == 0)
+            {
+                list.erase(itr);
+                break;
+            }
+        }
     }
     else
     {
@@ -1079,6 +1725,74 @@ ScriptController::ScriptCallback ScriptController::toCallback(const char* name)
         return ScriptController::INVALID_CALLBACK;
 }
 
+bool ScriptController::registerLazyScope(const std::string& scope)
+{
+    std::map<std::string, std::vector<LazyClass> >::iterator itr = _lazyClasses.find(scope);
+    if (itr == _lazyClasses.end())
+        return false;
+
+    // Take the classes out first, since registering an inner class reads the global of its scope again.
+    std::vector<LazyClass> classes;
+    classes.swap(itr->second);
+    _lazyClasses.erase(itr);
+    for (size_t i = 0, count = classes.size(); i < count; ++i)
+    {
+        _lazyTypes.erase(classes[i].type);
+        classes[i].registerFunction();
+    }
+
+    std::map<std::string, std::vector<LazyConstant> >::iterator constantItr = _lazyConstants.find(scope);
+    if (constantItr != _lazyConstants.end())
+    {
+        std::vector<LazyConstant> constants;
+        constants.swap(constantItr->second);
+        _lazyConstants.erase(constantItr);
+        for (size_t i = 0, count = constants.size(); i < count; ++i)
+        {
+            const LazyConstant& constant = constants[i];
+            switch (constant.type)
+            {
+            case LUA_TBOOLEAN:
+                ScriptUtil::registerConstantBool(constant.name, constant.boolean, constant.scopePath);
+                break;
+            case LUA_TNUMBER:
+                ScriptUtil::registerConstantNumber(constant.name, constant.number, constant.scopePath);
+                break;
+            default:
+                ScriptUtil::registerConstantString(constant.name, constant.string, constant.scopePath);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool ScriptController::registerLazyType(const char* type)
+{
+    GP_ASSERT(type);
+
+    std::map<std::string, std::string>::iterator itr = _lazyTypes.find(type);
+    if (itr == _lazyTypes.end())
+        return false;
+    std::string scope = itr->second;
+    return registerLazyScope(scope);
+}
+
+int ScriptController::indexGlobals(lua_State* state)
+{
+    // Only globals that are not set reach here, with the global table and the name of the global.
+    if (lua_type(state, 2) == LUA_TSTRING)
+    {
+        ScriptController* sc = Game::getInstance()->getScriptController();
+        if (sc->registerLazyScope(lua_tostring(state, 2)))
+        {
+            lua_rawget(state, 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int ScriptController::convert(lua_State* state)
 {
     // Get the number of parameters.
@@ -1095,6 +1809,11 @@ int ScriptController::convert(lua_State* state)
                 if (param2 != NULL)
                 {
                     luaL_getmetatable(state, param2);
+                    if (lua_isnil(state, -1) && Game::getInstance()->getScriptController()->registerLazyType(param2))
+                    {
+                        lua_pop(state, 1);
+                        luaL_getmetatable(state, param2);
+                    }
                     lua_setmetatable(state, -3);
                 }
                 return 0;
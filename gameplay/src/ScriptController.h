@@ -4,6 +4,7 @@
 #include "Base.h"
 #include "Game.h"
 #include "Control.h"
+#include "ScriptFunction.h"
 
 namespace gameplay
 {
@@ -11,6 +12,9 @@ namespace gameplay
 /** Function pointer typedef for string-from-enum conversion functions. */
 typedef const char* (*luaStringEnumConversionFunction)(std::string&, unsigned int);
 
+/** Function pointer typedef for the functions that register a class of the Lua script bindings. */
+typedef void (*luaRegisterFunction)();
+
 /**
  * Functions and structures used by the generated Lua script bindings.
  */
@@ -157,6 +161,21 @@ void registerConstantString(const std::string& name, const std::string& value, c
 void registerClass(const char* name, const luaL_Reg* members, lua_CFunction newFunction, lua_CFunction deleteFunction, const luaL_Reg* statics,
                    const std::vector<std::string>& scopePath);
 
+/**
+ * Registers a class with Lua the first time it is used, rather than immediately.
+ *
+ * The class is registered when a script first reads the global named by the scope,
+ * or when an object of the class is first pushed onto the Lua stack. Constants
+ * registered within the scope are kept until then as well.
+ *
+ * @param scope The global name the class is reached through: the name of the class, or of its outermost containing class.
+ * @param type The unique Lua type name of the class.
+ * @param registerFunction The function that registers the class.
+ *
+ * @script{ignore}
+ */
+void registerClassLazy(const char* scope, const char* type, luaRegisterFunction registerFunction);
+
 /**
  * Register a function with Lua.
  * 
@@ -326,6 +345,23 @@ LuaArray<T> getObjectPointer(int index, const char* type, bool nonNull, bool* su
  */
 const char* getString(int index, bool isStdString);
 
+/**
+ * Pushes a wrapper for the given object onto the Lua stack, or nil if the object is <code>NULL</code>.
+ * 
+ * Cached wrappers are kept in a weak table in the registry keyed by the object's address,
+ * so pushing the same object again reuses its wrapper instead of allocating a new userdata.
+ * Only wrappers that Lua does not own may be cached.
+ * 
+ * @param state The Lua state.
+ * @param instance The object instance.
+ * @param type The unique Lua type name of the object.
+ * @param owns Whether the wrapper owns the object (and deletes or releases it when collected).
+ * @param cache Whether to reuse a cached wrapper for the object.
+ * 
+ * @script{ignore}
+ */
+void pushObject(lua_State* state, void* instance, const char* type, bool owns, bool cache);
+
 /**
  * Checks that the parameter at the given stack position is a boolean and returns it.
  * 
@@ -347,12 +383,21 @@ class ScriptController
 {
     friend class Game;
     friend class Platform;
+    friend class ScriptFunction;
 
 public:
 
     /**
      * Loads the given script file and executes its global code.
      * 
+     * If a file with the same path followed by 'c' exists (e.g. 'game.luac' for 'game.lua'),
+     * it is loaded instead. Such files hold bytecode precompiled at build time with luac,
+     * which loads without parsing the script. Bytecode must be compiled by the same version
+     * of Lua the game uses; if it fails to load, the script source is loaded instead.
+     * 
+     * Scripts compiled from source are kept as bytecode keyed by a hash of their contents,
+     * so reloading a script that has not changed does not parse it again.
+     * 
      * @param path The path to the script.
      * @param forceReload Whether the script should be reloaded if it has already been loaded.
      */
@@ -737,6 +782,90 @@ public:
      */
     template<typename T>void setObjectPointer(const char* type, const char* name, T* v);
 
+    /**
+     * Sets the time the Lua garbage collector may run each frame.
+     *
+     * By default Lua collects garbage whenever its allocator decides to, which can stall
+     * a frame for several milliseconds. With a budget, automatic collection is stopped and
+     * the game instead runs incremental collection steps once per frame, after rendering,
+     * until the budget is used up or a collection cycle completes. If the budget is too
+     * small for the amount of garbage the scripts create, memory use keeps growing.
+     *
+     * The budget can also be set with the 'gcBudget' property in the 'lua' section of the
+     * game configuration file.
+     *
+     * @param budget The time budget in milliseconds, or 0 to let Lua collect automatically.
+     */
+    void setGarbageCollectionBudget(float budget);
+
+    /**
+     * Returns the time the Lua garbage collector may run each frame.
+     *
+     * @return The time budget in milliseconds, or 0 if Lua collects automatically.
+     */
+    float getGarbageCollectionBudget() const;
+
+    /**
+     * Returns the number of bytes freed by the garbage collection steps of the last frame.
+     *
+     * This is always 0 when Lua collects automatically.
+     *
+     * @return The number of bytes collected.
+     */
+    unsigned int getCollectedBytes() const;
+
+    /**
+     * Returns the memory allocated by Lua.
+     *
+     * @return The memory in use, in bytes.
+     */
+    unsigned int getMemoryUsage() const;
+
+    /**
+     * Starts a task that runs the given Lua function as a coroutine, until it returns.
+     *
+     * Tasks let scripts wait without polling, by calling these functions from the task:
+     * - waitTime(ms) resumes the task after the given number of game milliseconds.
+     * - waitFrames(count) resumes the task after the given number of updates (1 by default).
+     *   Calling coroutine.yield() from a task also waits for the next update.
+     * - waitForClip(clip) resumes the task once the given AnimationClip is no longer playing.
+     *
+     * The task runs until its first wait before this returns. Scripts start tasks with
+     * startTask(function, ...), which passes the extra arguments to the function and returns
+     * the handle of the task, and cancel them with cancelTask(handle).
+     *
+     * Waiting tasks do not run any script, so the timers are resumed from the scheduled time
+     * events (see Game::schedule) and the other waits are checked at the start of each
+     * update while the game is running. The coroutines of the tasks that returned are reused
+     * by the next tasks.
+     *
+     * @param function The Lua function to run, or the URL of a script and function (see loadUrl).
+     *
+     * @return The handle of the task, or 0 if the function could not be found.
+     * @script{ignore}
+     */
+    unsigned int startTask(const char* function);
+
+    /**
+     * Cancels a task started by startTask() so that it is never resumed.
+     *
+     * A task that cancels itself stops at its next wait.
+     *
+     * @param handle The handle of the task.
+     *
+     * @return true if the task was cancelled, false if it has already returned or been cancelled.
+     * @script{ignore}
+     */
+    bool cancelTask(unsigned int handle);
+
+    /**
+     * Returns the number of tasks that have not returned or been cancelled.
+     *
+     * @return The number of tasks.
+     * @script{ignore}
+     */
+    unsigned int getTaskCount() const;
+
     /**
      * Prints the string to the platform's output stream or log file.
      * Used for overriding Lua's print function.
@@ -811,6 +940,11 @@ private:
      * Finalizes the game using the appropriate callback script (if it was specified).
      */
     void finalizeGame();
+
+    /**
+     * Runs incremental garbage collection steps within the per-frame budget.
+     */
+    void collectGarbage();
     
     /**
      * Callback for when the controller receives a frame update event.
@@ -959,6 +1093,51 @@ private:
      */
     void executeFunctionHelper(int resultCount, const char* func, const char* args, va_list* list);
 
+    /**
+     * Pushes the value of a global variable, or of a variable nested in tables, onto the Lua stack.
+     *
+     * @param name The name of the variable, of the form "A.B.C" for nested variables.
+     *
+     * @return True if the value was pushed, false otherwise.
+     */
+    bool pushVariable(const char* name);
+
+    /**
+     * Pushes the arguments of a function call onto the Lua stack.
+     *
+     * @param args The argument signature (see executeFunctionHelper), or NULL.
+     * @param list The variable argument list.
+     *
+     * @return The number of arguments pushed.
+     */
+    int pushArguments(const char* args, va_list* list);
+
+    /**
+     * Pushes the string name of an enumerated value onto the Lua stack.
+     *
+     * @param type The qualified name of the enumeration type.
+     * @param value The enumerated value.
+     */
+    void pushEnum(const char* type, int value);
+
+    /**
+     * Pushes an object onto the Lua stack as a userdata value that is not owned by Lua.
+     *
+     * @param type The qualified name of the class of the object.
+     * @param ptr The object, which is pushed as nil if it is NULL.
+     */
+    void pushObject(const char* type, void* ptr);
+
+    /**
+     * Loads the given script file (or its precompiled bytecode) and pushes it onto the
+     * Lua stack as a function, or pushes an error message if it fails to load.
+     *
+     * @param path The path to the script.
+     *
+     * @return True if the script was loaded, false otherwise.
+     */
+    bool loadChunk(const char* path);
+
     /**
      * Converts the given string to a valid script callback enumeration value
      * or to ScriptController::INVALID_CALLBACK if there is no valid conversion.
@@ -995,6 +1174,170 @@ private:
      */
     static int convert(lua_State* state);
 
+    /**
+     * Registers the lazily registered classes reached through a global, and the constants within them.
+     *
+     * @param scope The name of the global.
+     *
+     * @return True if any class was registered.
+     */
+    bool registerLazyScope(const std::string& scope);
+
+    /**
+     * Registers a lazily registered class, given its Lua type name, along with the rest of its scope.
+     *
+     * @param type The unique Lua type name of the class.
+     *
+     * @return True if the class was registered.
+     */
+    bool registerLazyType(const char* type);
+
+    /**
+     * The __index metamethod of the global table, which registers lazily registered classes when they are first read.
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     */
+    static int indexGlobals(lua_State* state);
+
+    /**
+     * What a task is waiting for.
+     */
+    enum TaskWait
+    {
+        TASK_RUNNING,
+        TASK_WAIT_TIME,
+        TASK_WAIT_FRAMES,
+        TASK_WAIT_CLIP
+    };
+
+    /**
+     * A task started by startTask(), or an unused entry of the pool of tasks.
+     */
+    struct Task
+    {
+        lua_State* thread;
+        int ref;
+        unsigned int serial;
+        bool active;
+        bool cancelled;
+        TaskWait wait;
+        unsigned int frames;
+        unsigned int timeEvent;
+        AnimationClip* clip;
+        unsigned int next;
+    };
+
+    /**
+     * Resumes the tasks waiting for a time event.
+     */
+    struct TaskTimeListener : public TimeListener
+    {
+        /**
+         * @see TimeListener::timeEvent
+         */
+        void timeEvent(long timeDiff, void* cookie);
+    };
+
+    /**
+     * Starts a task running the function on the top of the stack, below the given number of arguments.
+     *
+     * @param state The Lua state the function and arguments are on, which are popped.
+     * @param argumentCount The number of arguments to pass to the function.
+     *
+     * @return The handle of the task.
+     */
+    unsigned int startTask(lua_State* state, int argumentCount);
+
+    /**
+     * Resumes a task until it waits again or returns.
+     *
+     * @param index The index of the task.
+     * @param argumentCount The number of arguments on the stack of the task to pass to the resumed function.
+     */
+    void resumeTask(unsigned int index, int argumentCount);
+
+    /**
+     * Returns a task to the pool.
+     *
+     * @param index The index of the task.
+     * @param reuseThread true to keep the coroutine for the next task, which is only possible once it returned.
+     */
+    void releaseTask(unsigned int index, bool reuseThread);
+
+    /**
+     * Resumes the tasks whose frame or clip waits are over. Called at the start of each update.
+     */
+    void resumeFrameTasks();
+
+    /**
+     * Returns the task of a handle, or NULL if it has returned or been cancelled.
+     */
+    Task* getTask(unsigned int handle);
+
+    /**
+     * Returns the handle of a task.
+     */
+    unsigned int getTaskHandle(unsigned int index) const;
+
+    /**
+     * Returns the task running on the given Lua thread, or raises a Lua error if it is not a task.
+     */
+    unsigned int getRunningTask(lua_State* state, const char* function);
+
+    /**
+     * The script function startTask(function, ...).
+     */
+    static int luaStartTask(lua_State* state);
+
+    /**
+     * The script function cancelTask(handle).
+     */
+    static int luaCancelTask(lua_State* state);
+
+    /**
+     * The script function waitTime(ms).
+     */
+    static int luaWaitTime(lua_State* state);
+
+    /**
+     * The script function waitFrames(count).
+     */
+    static int luaWaitFrames(lua_State* state);
+
+    /**
+     * The script function waitForClip(clip).
+     */
+    static int luaWaitForClip(lua_State* state);
+
+    /**
+     * The script function loadResourceFile(filename), which loads a chunk through the FileSystem.
+     */
+    static int luaLoadResourceFile(lua_State* state);
+
+    /**
+     * A class whose registration is deferred until it is first used.
+     */
+    struct LazyClass
+    {
+        std::string type;
+        luaRegisterFunction registerFunction;
+    };
+
+    /**
+     * A constant within the scope of a class whose registration is deferred.
+     */
+    struct LazyConstant
+    {
+        std::string name;
+        int type;
+        bool boolean;
+        double number;
+        std::string string;
+        std::vector<std::string> scopePath;
+    };
+
     // Friend functions (used by Lua script bindings).
     friend void ScriptUtil::registerLibrary(const char* name, const luaL_Reg* functions);
     friend void ScriptUtil::registerConstantBool(const std::string& name, bool value, const std::vector<std::string>& scopePath);
@@ -1002,7 +1345,9 @@ private:
     friend void ScriptUtil::registerConstantString(const std::string& name, const std::string& value, const std::vector<std::string>& scopePath);
     friend void ScriptUtil::registerClass(const char* name, const luaL_Reg* members, lua_CFunction newFunction,
         lua_CFunction deleteFunction, const luaL_Reg* statics, const std::vector<std::string>& scopePath);
+    friend void ScriptUtil::registerClassLazy(const char* scope, const char* type, luaRegisterFunction registerFunction);
     friend void ScriptUtil::registerFunction(const char* luaFunction, lua_CFunction cppFunction);
+    friend void ScriptUtil::pushObject(lua_State* state, void* instance, const char* type, bool owns, bool cache);
     friend void ScriptUtil::setGlobalHierarchyPair(const std::string& base, const std::string& derived);
     friend void ScriptUtil::addStringFromEnumConversionFunction(luaStringEnumConversionFunction stringFromEnum);
     friend ScriptUtil::LuaArray<bool> ScriptUtil::getBoolPointer(int index);
@@ -1021,9 +1366,22 @@ private:
     lua_State* _lua;
     unsigned int _returnCount;
     std::map<std::string, std::vector<std::string> > _hierarchy;
-    std::vector<std::string> _callbacks[CALLBACK_COUNT];
+    std::vector<ScriptFunction> _callbacks[CALLBACK_COUNT];
     std::set<std::string> _loadedScripts;
+    std::map<unsigned int, std::string> _bytecode;
+    float _gcBudget;
+    unsigned int _collectedBytes;
     std::vector<luaStringEnumConversionFunction> _stringFromEnum;
+    std::map<std::string, std::vector<LazyClass> > _lazyClasses;
+    std::map<std::string, std::string> _lazyTypes;
+    std::map<std::string, std::vector<LazyConstant> > _lazyConstants;
+    std::vector<Task> _tasks;
+    unsigned int _freeTask;
+    unsigned int _taskCount;
+    unsigned int _runningTask;
+    std::vector<unsigned int> _frameTasks;
+    std::vector<unsigned int> _resumedTasks;
+    TaskTimeListener _taskTimeListener;
 };
 
 /** Template specialization. */
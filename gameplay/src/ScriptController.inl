@@ -314,6 +314,11 @@ template<typename T>void ScriptController::setObjectPointer(const char* type, co
     object->instance = (void*)v;
     object->owns = false;
     luaL_getmetatable(_lua, type);
+    if (lua_isnil(_lua, -1) && registerLazyType(type))
+    {
+        lua_pop(_lua, 1);
+        luaL_getmetatable(_lua, type);
+    }
     lua_setmetatable(_lua, -2);
     lua_setglobal(_lua, name);
 }
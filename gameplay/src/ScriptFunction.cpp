@@ -0,0 +1,108 @@
+#include "Base.h"
+#include "ScriptFunction.h"
+#include "ScriptController.h"
+
+namespace gameplay
+{
+
+ScriptFunction::ScriptFunction()
+    : _ref(LUA_NOREF)
+{
+}
+
+ScriptFunction::ScriptFunction(const char* name)
+    : _name(name ? name : ""), _ref(LUA_NOREF)
+{
+}
+
+ScriptFunction::ScriptFunction(const ScriptFunction& copy)
+    : _name(copy._name), _ref(LUA_NOREF)
+{
+}
+
+ScriptFunction::~ScriptFunction()
+{
+    // The reference is gone already if the Lua state was closed.
+    lua_State* lua = getState();
+    if (lua && _ref != LUA_NOREF)
+        luaL_unref(lua, LUA_REGISTRYINDEX, _ref);
+}
+
+ScriptFunction& ScriptFunction::operator=(const ScriptFunction& function)
+{
+    if (this != &function)
+    {
+        lua_State* lua = getState();
+        if (lua && _ref != LUA_NOREF)
+            luaL_unref(lua, LUA_REGISTRYINDEX, _ref);
+        _ref = LUA_NOREF;
+        _name = function._name;
+    }
+    return *this;
+}
+
+const char* ScriptFunction::getName() const
+{
+    return _name.c_str();
+}
+
+lua_State* ScriptFunction::getState()
+{
+    Game* game = Game::getInstance();
+    ScriptController* sc = game ? game->getScriptController() : NULL;
+    return sc ? sc->_lua : NULL;
+}
+
+bool ScriptFunction::pushFunction(lua_State* lua)
+{
+    GP_ASSERT(lua);
+
+    if (_ref == LUA_NOREF)
+    {
+        // Look the function up and keep it in the registry; failures are retried on the next call
+        // since the script defining the function may not be loaded yet.
+        if (_name.empty() || !Game::getInstance()->getScriptController()->pushVariable(_name.c_str()))
+        {
+            GP_WARN("Failed to call function '%s'", _name.c_str());
+            return false;
+        }
+        if (!lua_isfunction(lua, -1))
+        {
+            lua_pop(lua, 1);
+            GP_WARN("Failed to call function '%s'", _name.c_str());
+            return false;
+        }
+        _ref = luaL_ref(lua, LUA_REGISTRYINDEX);
+    }
+
+    lua_rawgeti(lua, LUA_REGISTRYINDEX, _ref);
+    return true;
+}
+
+bool ScriptFunction::pcall(lua_State* lua, int argumentCount, int resultCount)
+{
+    if (lua_pcall(lua, argumentCount, resultCount, 0) != 0)
+    {
+        GP_WARN("Failed to call function '%s' with error '%s'.", _name.c_str(), lua_tostring(lua, -1));
+        return false;
+    }
+    return true;
+}
+
+bool ScriptFunction::pcall(lua_State* lua, const char* args, va_list* list, int resultCount)
+{
+    int argumentCount = Game::getInstance()->getScriptController()->pushArguments(args, list);
+    return pcall(lua, argumentCount, resultCount);
+}
+
+void ScriptFunction::push(lua_State* lua, const Enum& value)
+{
+    Game::getInstance()->getScriptController()->pushEnum(value.type, value.value);
+}
+
+void ScriptFunction::push(lua_State* lua, const Object& value)
+{
+    Game::getInstance()->getScriptController()->pushObject(value.type, value.instance);
+}
+
+}
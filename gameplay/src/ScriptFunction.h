@@ -0,0 +1,312 @@
+#ifndef SCRIPTFUNCTION_H_
+#define SCRIPTFUNCTION_H_
+
+#include "Base.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a handle to a Lua script function that can be called repeatedly.
+ *
+ * The function is looked up by name the first time it is called and is kept in the Lua
+ * registry from then on, so later calls neither look it up again nor parse an argument
+ * signature. Arguments are pushed according to their C++ types: bools, integers, floating
+ * point numbers and strings are passed as the matching Lua types, while enumerated values
+ * and object pointers must be wrapped in Enum and Object.
+ *
+ * Since the function is only looked up once, a handle keeps calling the original function
+ * if a script later assigns a new function to the same name.
+ *
+ * @script{ignore}
+ */
+class ScriptFunction
+{
+public:
+
+    /**
+     * Wraps an enumerated value, which scripts receive as the string name of the value.
+     */
+    struct Enum
+    {
+        /**
+         * Constructor.
+         *
+         * @param type The qualified name of the enumeration type (for example, "Keyboard::Key").
+         * @param value The enumerated value.
+         */
+        Enum(const char* type, int value) : type(type), value(value) { }
+
+        /** The qualified name of the enumeration type. */
+        const char* type;
+        /** The enumerated value. */
+        int value;
+    };
+
+    /**
+     * Wraps a pointer to an object, which scripts receive as a userdata value of the object's class.
+     */
+    struct Object
+    {
+        /**
+         * Constructor.
+         *
+         * @param type The qualified name of the class of the object (for example, "Gamepad").
+         * @param instance The object, which is passed as nil if it is NULL.
+         */
+        Object(const char* type, void* instance) : type(type), instance(instance) { }
+
+        /** The qualified name of the class of the object. */
+        const char* type;
+        /** The object. */
+        void* instance;
+    };
+
+    /**
+     * Constructor.
+     *
+     * Creates a handle that does not refer to any function.
+     */
+    ScriptFunction();
+
+    /**
+     * Constructor.
+     *
+     * @param name The name of a global function, or a '.' separated path to a function that is nested in tables.
+     */
+    explicit ScriptFunction(const char* name);
+
+    /**
+     * Copy constructor.
+     */
+    ScriptFunction(const ScriptFunction& copy);
+
+    /**
+     * Destructor.
+     */
+    ~ScriptFunction();
+
+    /**
+     * Copy assignment operator.
+     */
+    ScriptFunction& operator=(const ScriptFunction& function);
+
+    /**
+     * Returns the name of the function.
+     *
+     * @return The function name.
+     */
+    const char* getName() const;
+
+    /**
+     * Calls the function without arguments.
+     *
+     * Supported return types are void, bool, int, unsigned int, float and double.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R> R call();
+
+    /**
+     * Calls the function with one argument.
+     *
+     * @param a1 The first argument.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R, typename A1> R call(A1 a1);
+
+    /**
+     * Calls the function with two arguments.
+     *
+     * @param a1 The first argument.
+     * @param a2 The second argument.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R, typename A1, typename A2> R call(A1 a1, A2 a2);
+
+    /**
+     * Calls the function with three arguments.
+     *
+     * @param a1 The first argument.
+     * @param a2 The second argument.
+     * @param a3 The third argument.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R, typename A1, typename A2, typename A3> R call(A1 a1, A2 a2, A3 a3);
+
+    /**
+     * Calls the function with four arguments.
+     *
+     * @param a1 The first argument.
+     * @param a2 The second argument.
+     * @param a3 The third argument.
+     * @param a4 The fourth argument.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R, typename A1, typename A2, typename A3, typename A4> R call(A1 a1, A2 a2, A3 a3, A4 a4);
+
+    /**
+     * Calls the function with arguments described by an argument signature.
+     *
+     * This is slower than the typed call() functions, but supports arguments that are only
+     * known at runtime, such as those of ScriptTarget events.
+     *
+     * @param args The argument signature (see ScriptController::executeFunction).
+     * @param list The variable argument list.
+     *
+     * @return The value returned by the function, or a default value if the call failed.
+     */
+    template<typename R> R call(const char* args, va_list* list);
+
+private:
+
+    /**
+     * Converts the results of a function call.
+     */
+    template<typename R> struct Result;
+
+    static lua_State* getState();
+
+    bool pushFunction(lua_State* lua);
+
+    bool pcall(lua_State* lua, int argumentCount, int resultCount);
+
+    bool pcall(lua_State* lua, const char* args, va_list* list, int resultCount);
+
+    static void push(lua_State* lua, bool value) { lua_pushboolean(lua, value); }
+    static void push(lua_State* lua, char value) { lua_pushinteger(lua, value); }
+    static void push(lua_State* lua, short value) { lua_pushinteger(lua, value); }
+    static void push(lua_State* lua, int value) { lua_pushinteger(lua, value); }
+    static void push(lua_State* lua, long value) { lua_pushinteger(lua, value); }
+    static void push(lua_State* lua, unsigned char value) { lua_pushunsigned(lua, value); }
+    static void push(lua_State* lua, unsigned short value) { lua_pushunsigned(lua, value); }
+    static void push(lua_State* lua, unsigned int value) { lua_pushunsigned(lua, value); }
+    static void push(lua_State* lua, unsigned long value) { lua_pushunsigned(lua, value); }
+    static void push(lua_State* lua, float value) { lua_pushnumber(lua, value); }
+    static void push(lua_State* lua, double value) { lua_pushnumber(lua, value); }
+    static void push(lua_State* lua, const char* value) { lua_pushstring(lua, value); }
+    static void push(lua_State* lua, const std::string& value) { lua_pushlstring(lua, value.c_str(), value.size()); }
+    static void push(lua_State* lua, const Enum& value);
+    static void push(lua_State* lua, const Object& value);
+
+    std::string _name;
+    int _ref;
+};
+
+template<> struct ScriptFunction::Result<void>
+{
+    static const int count = 0;
+    static void pop(lua_State* lua, int top, bool called) { if (lua) lua_settop(lua, top); }
+};
+
+template<> struct ScriptFunction::Result<bool>
+{
+    static const int count = 1;
+    static bool pop(lua_State* lua, int top, bool called) { bool value = called && lua_toboolean(lua, -1) != 0; if (lua) lua_settop(lua, top); return value; }
+};
+
+template<> struct ScriptFunction::Result<int>
+{
+    static const int count = 1;
+    static int pop(lua_State* lua, int top, bool called) { int value = called ? (int)lua_tointeger(lua, -1) : 0; if (lua) lua_settop(lua, top); return value; }
+};
+
+template<> struct ScriptFunction::Result<unsigned int>
+{
+    static const int count = 1;
+    static unsigned int pop(lua_State* lua, int top, bool called) { unsigned int value = called ? (unsigned int)lua_tounsigned(lua, -1) : 0; if (lua) lua_settop(lua, top); return value; }
+};
+
+template<> struct ScriptFunction::Result<float>
+{
+    static const int count = 1;
+    static float pop(lua_State* lua, int top, bool called) { float value = called ? (float)lua_tonumber(lua, -1) : 0.0f; if (lua) lua_settop(lua, top); return value; }
+};
+
+template<> struct ScriptFunction::Result<double>
+{
+    static const int count = 1;
+    static double pop(lua_State* lua, int top, bool called) { double value = called ? (double)lua_tonumber(lua, -1) : 0.0; if (lua) lua_settop(lua, top); return value; }
+};
+
+template<typename R> R ScriptFunction::call()
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = lua && pushFunction(lua) && pcall(lua, 0, Result<R>::count);
+    return Result<R>::pop(lua, top, called);
+}
+
+template<typename R, typename A1> R ScriptFunction::call(A1 a1)
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = false;
+    if (lua && pushFunction(lua))
+    {
+        push(lua, a1);
+        called = pcall(lua, 1, Result<R>::count);
+    }
+    return Result<R>::pop(lua, top, called);
+}
+
+template<typename R, typename A1, typename A2> R ScriptFunction::call(A1 a1, A2 a2)
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = false;
+    if (lua && pushFunction(lua))
+    {
+        push(lua, a1);
+        push(lua, a2);
+        called = pcall(lua, 2, Result<R>::count);
+    }
+    return Result<R>::pop(lua, top, called);
+}
+
+template<typename R, typename A1, typename A2, typename A3> R ScriptFunction::call(A1 a1, A2 a2, A3 a3)
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = false;
+    if (lua && pushFunction(lua))
+    {
+        push(lua, a1);
+        push(lua, a2);
+        push(lua, a3);
+        called = pcall(lua, 3, Result<R>::count);
+    }
+    return Result<R>::pop(lua, top, called);
+}
+
+template<typename R, typename A1, typename A2, typename A3, typename A4> R ScriptFunction::call(A1 a1, A2 a2, A3 a3, A4 a4)
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = false;
+    if (lua && pushFunction(lua))
+    {
+        push(lua, a1);
+        push(lua, a2);
+        push(lua, a3);
+        push(lua, a4);
+        called = pcall(lua, 4, Result<R>::count);
+    }
+    return Result<R>::pop(lua, top, called);
+}
+
+template<typename R> R ScriptFunction::call(const char* args, va_list* list)
+{
+    lua_State* lua = getState();
+    int top = lua ? lua_gettop(lua) : 0;
+    bool called = lua && pushFunction(lua) && pcall(lua, args, list, Result<R>::count);
+    return Result<R>::pop(lua, top, called);
+}
+
+}
+
+#endif
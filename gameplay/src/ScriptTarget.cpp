@@ -7,97 +7,72 @@ namespace gameplay
 
 extern void splitURL(const std::string& url, std::string* file, std::string* id);
 
-ScriptTarget::ScriptTarget()
+ScriptTarget::ScriptTarget() : _scriptEvents(NULL), _scriptEventCount(0), _scriptCallbacks(NULL)
+{
+}
+
+ScriptTarget::ScriptTarget(const ScriptTarget& copy)
+    : _scriptEvents(copy._scriptEvents), _scriptEventCount(copy._scriptEventCount), _scriptCallbacks(NULL)
 {
 }
 
 ScriptTarget::~ScriptTarget()
 {
-    std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.begin();
-    for (; iter != _callbacks.end(); iter++)
-    {
-        SAFE_DELETE(iter->second);
-    }
+    SAFE_DELETE_ARRAY(_scriptCallbacks);
 }
 
-template<> void ScriptTarget::fireScriptEvent<void>(const char* eventName, ...)
+ScriptTarget& ScriptTarget::operator=(const ScriptTarget&)
 {
-    va_list list;
-    va_start(list, eventName);
+    return *this;
+}
 
-    std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end() && iter->second != NULL)
-    {
-        ScriptController* sc = Game::getInstance()->getScriptController();
+template<> void ScriptTarget::fireScriptEvent<void>(unsigned int eventId, ...)
+{
+    if (!hasScriptCallbacks(eventId))
+        return;
 
-        if (_events[eventName].size() > 0)
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                sc->executeFunction<void>((*iter->second)[i].function.c_str(), _events[eventName].c_str(), &list);
-            }
-        }
-        else
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                sc->executeFunction<void>((*iter->second)[i].function.c_str(), _events[eventName].c_str());
-            }
-        }
+    // Callbacks keep their function resolved, so only the event arguments are parsed on each call.
+    const char* args = _scriptEvents[eventId].args;
+    std::vector<Callback>& callbacks = _scriptCallbacks[eventId];
+    for (size_t i = 0; i < callbacks.size(); i++)
+    {
+        va_list list;
+        va_start(list, eventId);
+        callbacks[i].function.call<void>(args, &list);
+        va_end(list);
     }
-
-    va_end(list);
 }
 
-template<> bool ScriptTarget::fireScriptEvent<bool>(const char* eventName, ...)
+template<> bool ScriptTarget::fireScriptEvent<bool>(unsigned int eventId, ...)
 {
-    va_list list;
-    va_start(list, eventName);
+    if (!hasScriptCallbacks(eventId))
+        return false;
 
-    std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end() && iter->second)
+    const char* args = _scriptEvents[eventId].args;
+    std::vector<Callback>& callbacks = _scriptCallbacks[eventId];
+    for (size_t i = 0; i < callbacks.size(); i++)
     {
-        ScriptController* sc = Game::getInstance()->getScriptController();
-
-        if (_events[eventName].size() > 0)
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                if (sc->executeFunction<bool>((*iter->second)[i].function.c_str(), _events[eventName].c_str(), &list))
-                {
-                    va_end(list);
-                    return true;
-                }
-            }
-        }
-        else
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                if (sc->executeFunction<bool>((*iter->second)[i].function.c_str(), _events[eventName].c_str()))
-                {
-                    va_end(list);
-                    return true;
-                }
-            }
-        }
+        va_list list;
+        va_start(list, eventId);
+        bool result = callbacks[i].function.call<bool>(args, &list);
+        va_end(list);
+        if (result)
+            return true;
     }
-
-    va_end(list);
     return false;
 }
 
 void ScriptTarget::addScriptCallback(const std::string& eventName, const std::string& function)
 {
-    std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end())
+    int eventId = getScriptEvent(eventName);
+    if (eventId >= 0)
     {
-        if (!iter->second)
-            iter->second = new std::vector<Callback>();
+        if (!_scriptCallbacks)
+            _scriptCallbacks = new std::vector<Callback>[_scriptEventCount];
 
         // Add the function to the list of callbacks.
         std::string functionName = Game::getInstance()->getScriptController()->loadUrl(function.c_str());
-        iter->second->push_back(Callback(functionName));
+        _scriptCallbacks[eventId].push_back(Callback(functionName));
     }
     else
     {
@@ -107,10 +82,10 @@ void ScriptTarget::addScriptCallback(const std::string& eventName, const std::st
 
 void ScriptTarget::removeScriptCallback(const std::string& eventName, const std::string& function)
 {
-    std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end())
+    int eventId = getScriptEvent(eventName);
+    if (eventId >= 0)
     {
-        if (!iter->second)
+        if (!_scriptCallbacks)
             return;
 
         std::string file;
@@ -122,11 +97,12 @@ void ScriptTarget::removeScriptCallback(const std::string& eventName, const std:
             return;
 
         // Remove the function from the list of callbacks.
-        for (unsigned int i = 0; i < iter->second->size(); i++)
+        std::vector<Callback>& callbacks = _scriptCallbacks[eventId];
+        for (unsigned int i = 0; i < callbacks.size(); i++)
         {
-            if ((*iter->second)[i].function == id)
+            if (id == callbacks[i].function.getName())
             {
-                iter->second->erase(iter->second->begin() + i);
+                callbacks.erase(callbacks.begin() + i);
                 return;
             }
         }
@@ -137,13 +113,35 @@ void ScriptTarget::removeScriptCallback(const std::string& eventName, const std:
     }
 }
 
-void ScriptTarget::addScriptEvent(const std::string& eventName, const char* argsString)
+void ScriptTarget::setScriptEvents(const Event* events, unsigned int eventCount)
 {
-    _events[eventName] = (argsString ? argsString : "");
-    _callbacks[eventName] = NULL;
+    GP_ASSERT(events || eventCount == 0);
+    GP_ASSERT(eventCount >= _scriptEventCount);
+
+    // Keep the callbacks added for the events of a base class.
+    if (_scriptCallbacks && eventCount != _scriptEventCount)
+    {
+        std::vector<Callback>* callbacks = new std::vector<Callback>[eventCount];
+        for (unsigned int i = 0; i < _scriptEventCount; ++i)
+            callbacks[i].swap(_scriptCallbacks[i]);
+        SAFE_DELETE_ARRAY(_scriptCallbacks);
+        _scriptCallbacks = callbacks;
+    }
+    _scriptEvents = events;
+    _scriptEventCount = eventCount;
+}
+
+int ScriptTarget::getScriptEvent(const std::string& eventName) const
+{
+    for (unsigned int i = 0; i < _scriptEventCount; ++i)
+    {
+        if (eventName == _scriptEvents[i].name)
+            return (int)i;
+    }
+    return -1;
 }
 
-ScriptTarget::Callback::Callback(const std::string& function) : function(function)
+ScriptTarget::Callback::Callback(const std::string& function) : function(function.c_str())
 {
 }
 
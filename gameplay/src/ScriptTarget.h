@@ -2,6 +2,7 @@
 #define SCRIPTTARGET_H_
 
 #include "Base.h"
+#include "ScriptFunction.h"
 
 namespace gameplay
 {
@@ -13,6 +14,22 @@ class ScriptTarget
 {
 public:
 
+    /**
+     * Defines an event that script callbacks can be added for.
+     *
+     * The events of a class of script targets are listed in a static table shared by
+     * its instances, and are fired by their index in the table.
+     *
+     * @script{ignore}
+     */
+    struct Event
+    {
+        /** The name of the event. */
+        const char* name;
+        /** The argument string of the event ({@link ScriptController::executeFunction}). */
+        const char* args;
+    };
+
     /**
      * Adds the given Lua script function as a callback for the given event.
      * 
@@ -38,26 +55,49 @@ protected:
      */
     ScriptTarget();
 
+    /**
+     * Copy constructor. Copies the supported events, but not the callbacks.
+     */
+    ScriptTarget(const ScriptTarget& copy);
+
     /**
      * Destructor.
      */
     virtual ~ScriptTarget();
 
     /**
-     * Adds the given event with the given Lua script parameter string ({@link ScriptController::executeFunction})
-     * as a supported event for this script target.
+     * Copy assignment operator. Keeps the events and callbacks of this script target.
+     */
+    ScriptTarget& operator=(const ScriptTarget&);
+
+    /**
+     * Sets the events supported by this script target.
+     *
+     * Subclasses that support more events than their base class must set a table
+     * that starts with the events of the base class, in the same order.
      * 
-     * @param eventName The name of the event.
-     * @param argsString The argument string for the event.
+     * @param events The table of events, which must outlive this script target.
+     * @param eventCount The number of events in the table.
      */
-    void addScriptEvent(const std::string& eventName, const char* argsString = NULL);
+    void setScriptEvents(const Event* events, unsigned int eventCount);
 
     /**
-     * Fires the event with the given event name and the given arguments.
+     * Determines if a script callback was added for the given event.
+     *
+     * @param eventId The index of the event in the table of events.
+     *
+     * @return true if the event has a callback.
+     */
+    inline bool hasScriptCallbacks(unsigned int eventId) const;
+
+    /**
+     * Fires the given event with the given arguments.
+     *
+     * Firing an event without callbacks does nothing, so the event does not need to be checked first.
      * 
-     * @param eventName The name of the event.
+     * @param eventId The index of the event in the table of events.
      */
-    template<typename T> T fireScriptEvent(const char* eventName, ...);
+    template<typename T> T fireScriptEvent(unsigned int eventId, ...);
 
     /** Used to store a script callbacks for given event. */
     struct Callback
@@ -66,24 +106,39 @@ protected:
         Callback(const std::string& string);
 
         /** Holds the Lua script callback function. */
-        std::string function;
+        ScriptFunction function;
     };
 
+private:
+
+    /**
+     * Returns the index of the event with the given name, or -1 if it is not supported.
+     */
+    int getScriptEvent(const std::string& eventName) const;
+
     /** Holds the supported events for this script target. */
-    std::map<std::string, std::string> _events;
-    /** Holds the callbacks for this script target's events. */
-    std::map<std::string, std::vector<Callback>*> _callbacks;
+    const Event* _scriptEvents;
+    /** Holds the number of supported events. */
+    unsigned int _scriptEventCount;
+    /** Holds the callbacks of each event, allocated when the first callback is added. */
+    std::vector<Callback>* _scriptCallbacks;
 };
 
-template<typename T> T ScriptTarget::fireScriptEvent(const char* eventName, ...)
+inline bool ScriptTarget::hasScriptCallbacks(unsigned int eventId) const
+{
+    GP_ASSERT(eventId < _scriptEventCount);
+    return _scriptCallbacks && !_scriptCallbacks[eventId].empty();
+}
+
+template<typename T> T ScriptTarget::fireScriptEvent(unsigned int eventId, ...)
 {
     GP_ERROR("Unsupported return type!");
 }
 
 /** Template specialization. */
-template<> void ScriptTarget::fireScriptEvent<void>(const char* eventName, ...);
+template<> void ScriptTarget::fireScriptEvent<void>(unsigned int eventId, ...);
 /** Template specialization. */
-template<> bool ScriptTarget::fireScriptEvent<bool>(const char* eventName, ...);
+template<> bool ScriptTarget::fireScriptEvent<bool>(unsigned int eventId, ...);
 
 }
 
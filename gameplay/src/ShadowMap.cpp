@@ -0,0 +1,436 @@
+#include "Base.h"
+#include "ShadowMap.h"
+#include "Light.h"
+#include "Scene.h"
+#include "Node.h"
+#include "Model.h"
+#include "MeshPart.h"
+#include "MeshSkin.h"
+#include "Effect.h"
+#include "FrameBuffer.h"
+#include "VertexAttributeBinding.h"
+#include "Game.h"
+#include "GLStateCache.h"
+
+// Blend between logarithmic (1) and uniform (0) cascade splits.
+#define CASCADE_SPLIT_LAMBDA 0.75f
+
+// Number of steps across a cascade that its center is snapped to in light space.
+#define CASCADE_SNAP_DIVISIONS 8
+
+// Near plane of spot light shadow maps, relative to the light's range.
+#define SPOT_SHADOW_NEAR 0.01f
+
+namespace gameplay
+{
+
+// Vertex shader for drawing shadow casters.
+static const char* SHADOW_CASTER_VSH =
+    "uniform mat4 u_worldViewProjectionMatrix;\n"
+    "attribute vec4 a_position;\n"
+    "void main(void) {\n"
+    "    gl_Position = u_worldViewProjectionMatrix * a_position;\n"
+    "}";
+
+// Fragment shader for drawing shadow casters, which packs the window depth into RGBA.
+static const char* SHADOW_CASTER_FSH =
+#ifdef OPENGL_ES
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+#endif
+    "void main(void) {\n"
+    "    vec4 packed = fract(vec4(1.0, 255.0, 65025.0, 16581375.0) * gl_FragCoord.z);\n"
+    "    gl_FragColor = packed - packed.yzww * vec4(1.0 / 255.0, 1.0 / 255.0, 1.0 / 255.0, 0.0);\n"
+    "}";
+
+static unsigned int __shadowMapCount = 0;
+
+ShadowMap::Cascade::Cascade()
+    : casterHash(0), valid(false)
+{
+}
+
+ShadowMap::ShadowMap(Light* light, unsigned int size, unsigned int cascadeCount)
+    : _light(light), _size(size), _cascadeCount(cascadeCount), _shadowDistance(100.0f), _casterDistance(100.0f),
+    _depthBias(0.002f), _renderedCount(0), _frameBuffer(NULL), _sampler(NULL), _effect(NULL), _casterState(NULL)
+{
+    _light->addRef();
+}
+
+ShadowMap::~ShadowMap()
+{
+    SAFE_RELEASE(_casterState);
+    SAFE_RELEASE(_effect);
+    SAFE_RELEASE(_sampler);
+    SAFE_RELEASE(_frameBuffer);
+    SAFE_RELEASE(_light);
+}
+
+ShadowMap* ShadowMap::create(Light* light, unsigned int size, unsigned int cascadeCount)
+{
+    GP_ASSERT(light);
+    GP_ASSERT(size > 0);
+
+    if (light->getLightType() == Light::POINT)
+    {
+        GP_WARN("Shadow maps are not supported for point lights.");
+        return NULL;
+    }
+    cascadeCount = light->getLightType() == Light::SPOT ? 1 : std::max(1u, std::min(cascadeCount, MAX_CASCADES));
+
+    // Cascades are laid out in two columns of the shadow texture.
+    unsigned int width = size * (cascadeCount > 1 ? 2 : 1);
+    unsigned int height = size * (cascadeCount > 2 ? 2 : 1);
+
+    char id[32];
+    sprintf(id, "__shadowMap%u", ++__shadowMapCount);
+    FrameBuffer* frameBuffer = FrameBuffer::create(id, width, height);
+    if (frameBuffer == NULL || frameBuffer->getRenderTarget() == NULL)
+    {
+        GP_ERROR("Failed to create the frame buffer of a shadow map.");
+        SAFE_RELEASE(frameBuffer);
+        return NULL;
+    }
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(id, DepthStencilTarget::DEPTH, width, height);
+    frameBuffer->setDepthStencilTarget(depthTarget);
+    SAFE_RELEASE(depthTarget);
+
+    Effect* effect = Effect::createFromSource(SHADOW_CASTER_VSH, SHADOW_CASTER_FSH);
+    if (effect == NULL)
+    {
+        GP_ERROR("Failed to create the shadow caster effect.");
+        SAFE_RELEASE(frameBuffer);
+        return NULL;
+    }
+
+    ShadowMap* shadowMap = new ShadowMap(light, size, cascadeCount);
+    shadowMap->_frameBuffer = frameBuffer;
+    shadowMap->_effect = effect;
+
+    // Packed depths can't be filtered, so the receivers filter the comparisons instead.
+    shadowMap->_sampler = Texture::Sampler::create(frameBuffer->getRenderTarget()->getTexture());
+    shadowMap->_sampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    shadowMap->_sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    shadowMap->_texelSize.set(1.0f / width, 1.0f / height);
+
+    shadowMap->_casterState = RenderState::StateBlock::create();
+    shadowMap->_casterState->setDepthTest(true);
+    shadowMap->_casterState->setDepthWrite(true);
+    shadowMap->_casterState->setDepthFunction(RenderState::DEPTH_LESS);
+    shadowMap->_casterState->setCullFace(false);
+    shadowMap->_casterState->setBlend(false);
+
+    shadowMap->_cascadeFar.set(FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX);
+
+    return shadowMap;
+}
+
+Light* ShadowMap::getLight() const
+{
+    return _light;
+}
+
+unsigned int ShadowMap::getCascadeCount() const
+{
+    return _cascadeCount;
+}
+
+void ShadowMap::setShadowDistance(float distance)
+{
+    _shadowDistance = distance;
+}
+
+void ShadowMap::setCasterDistance(float distance)
+{
+    _casterDistance = distance;
+}
+
+void ShadowMap::setDepthBias(float bias)
+{
+    _depthBias = bias;
+    invalidate();
+}
+
+void ShadowMap::invalidate()
+{
+    for (unsigned int i = 0; i < MAX_CASCADES; ++i)
+    {
+        _cascades[i].valid = false;
+    }
+}
+
+unsigned int ShadowMap::getRenderedCount() const
+{
+    return _renderedCount;
+}
+
+void ShadowMap::update(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    _renderedCount = 0;
+    Node* lightNode = _light->getNode();
+    if (lightNode == NULL)
+        return;
+
+    Matrix viewProjections[MAX_CASCADES];
+    if (_light->getLightType() == Light::DIRECTIONAL)
+    {
+        Camera* camera = scene->getActiveCamera();
+        if (camera == NULL || !computeDirectionalCascades(camera, viewProjections))
+            return;
+    }
+    else
+    {
+        Vector3 position = lightNode->getTranslationWorld();
+        Vector3 forward = lightNode->getForwardVectorWorld();
+        Vector3 up = lightNode->getUpVectorWorld();
+        Matrix view;
+        Matrix::createLookAt(position, position + forward, up, &view);
+        Matrix projection;
+        float range = _light->getRange();
+        Matrix::createPerspective(MATH_RAD_TO_DEG(_light->getOuterAngle() * 2.0f), 1.0f, range * SPOT_SHADOW_NEAR, range, &projection);
+        Matrix::multiply(projection, view, &viewProjections[0]);
+    }
+
+    for (unsigned int i = 0; i < _cascadeCount; ++i)
+    {
+        // Find the casters of the cascade and hash their transforms to detect movement.
+        std::vector<Node*> nodes;
+        scene->cull(Frustum(viewProjections[i]), nodes);
+        _casters.clear();
+        unsigned int hash = 2166136261u;
+        for (size_t j = 0, count = nodes.size(); j < count; ++j)
+        {
+            Node* node = nodes[j];
+            Model* model = node->getModel();
+            if (model == NULL || model->getSkin())
+                continue;
+
+            _casters.push_back(node);
+            const unsigned char* bytes = (const unsigned char*)&node;
+            for (size_t k = 0; k < sizeof(Node*); ++k)
+                hash = (hash ^ bytes[k]) * 16777619u;
+            bytes = (const unsigned char*)node->getWorldMatrix().m;
+            for (size_t k = 0; k < sizeof(float) * 16; ++k)
+                hash = (hash ^ bytes[k]) * 16777619u;
+        }
+
+        Cascade& cascade = _cascades[i];
+        if (cascade.valid && cascade.casterHash == hash && memcmp(cascade.viewProjection.m, viewProjections[i].m, sizeof(float) * 16) == 0)
+            continue;
+
+        cascade.viewProjection = viewProjections[i];
+        cascade.casterHash = hash;
+        cascade.valid = true;
+        renderCascade(i, _casters);
+        ++_renderedCount;
+    }
+    _casters.clear();
+}
+
+bool ShadowMap::computeDirectionalCascades(Camera* camera, Matrix* viewProjections)
+{
+    Node* cameraNode = camera->getNode();
+    if (cameraNode == NULL)
+        return false;
+
+    const Matrix& cameraWorld = cameraNode->getWorldMatrix();
+    float nearPlane = camera->getNearPlane();
+    float farPlane = std::min(camera->getFarPlane(), _shadowDistance);
+    if (farPlane <= nearPlane)
+        return false;
+
+    // Light space is only a rotation, so that cascades can be snapped to a fixed grid in it.
+    Vector3 lightDirection = _light->getNode()->getForwardVectorWorld();
+    lightDirection.normalize();
+    Vector3 up = fabs(lightDirection.y) > 0.99f ? Vector3::unitZ() : Vector3::unitY();
+    Matrix lightView;
+    Matrix::createLookAt(Vector3::zero(), lightDirection, up, &lightView);
+
+    float* cascadeFar = &_cascadeFar.x;
+    float splitNear = nearPlane;
+    for (unsigned int i = 0; i < _cascadeCount; ++i)
+    {
+        float t = (float)(i + 1) / _cascadeCount;
+        float splitFar = CASCADE_SPLIT_LAMBDA * nearPlane * pow(farPlane / nearPlane, t) +
+                         (1.0f - CASCADE_SPLIT_LAMBDA) * (nearPlane + (farPlane - nearPlane) * t);
+        cascadeFar[i] = splitFar;
+
+        // Find the corners of the slice of the camera frustum, in light space.
+        Vector3 corners[8];
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+            float depth = j == 0 ? splitNear : splitFar;
+            float halfWidth, halfHeight;
+            if (camera->getCameraType() == Camera::PERSPECTIVE)
+            {
+                halfHeight = depth * tan(MATH_DEG_TO_RAD(camera->getFieldOfView() * 0.5f));
+                halfWidth = halfHeight * camera->getAspectRatio();
+            }
+            else
+            {
+                halfWidth = camera->getZoomX() * 0.5f;
+                halfHeight = camera->getZoomY() * 0.5f;
+            }
+            for (unsigned int k = 0; k < 4; ++k)
+            {
+                Vector3 corner((k & 1) ? halfWidth : -halfWidth, (k & 2) ? halfHeight : -halfHeight, -depth);
+                cameraWorld.transformPoint(&corner);
+                lightView.transformPoint(corner, &corners[j * 4 + k]);
+            }
+        }
+
+        // Fit a sphere to the slice, whose size does not change as the camera turns, and round
+        // its radius up so that it also stays the same from one frame to the next.
+        Vector3 center;
+        for (unsigned int j = 0; j < 8; ++j)
+            center += corners[j];
+        center *= 0.125f;
+        float radius = 0.0f;
+        for (unsigned int j = 0; j < 8; ++j)
+            radius = std::max(radius, center.distance(corners[j]));
+        float quantum = pow(2.0f, floor(log(radius) / log(2.0f)) - 4.0f);
+        radius = ceil(radius / quantum) * quantum;
+
+        // Snap the center to a coarse grid and pad the cascade so that it still covers the slice.
+        float step = 2.0f * radius / CASCADE_SNAP_DIVISIONS;
+        center.set(floor(center.x / step + 0.5f) * step, floor(center.y / step + 0.5f) * step, floor(center.z / step + 0.5f) * step);
+        float halfSize = radius + step;
+
+        // The view looks down -z, so casters towards the light have greater z.
+        Matrix projection;
+        Matrix::createOrthographicOffCenter(center.x - halfSize, center.x + halfSize, center.y - halfSize, center.y + halfSize,
+                                            -center.z - halfSize - _casterDistance, -center.z + halfSize, &projection);
+        Matrix::multiply(projection, lightView, &viewProjections[i]);
+
+        splitNear = splitFar;
+    }
+    return true;
+}
+
+void ShadowMap::renderCascade(unsigned int index, const std::vector<Node*>& casters)
+{
+    Cascade& cascade = _cascades[index];
+
+    // Map the projection to the texture coordinates of the cascade's tile, with the depth biased.
+    unsigned int columns = _cascadeCount > 1 ? 2 : 1;
+    unsigned int rows = _cascadeCount > 2 ? 2 : 1;
+    unsigned int column = index % 2;
+    unsigned int row = index / 2;
+    Matrix tile(0.5f / columns, 0.0f, 0.0f, (0.5f + column) / columns,
+                0.0f, 0.5f / rows, 0.0f, (0.5f + row) / rows,
+                0.0f, 0.0f, 0.5f, 0.5f - _depthBias,
+                0.0f, 0.0f, 0.0f, 1.0f);
+    Matrix::multiply(tile, cascade.viewProjection, &_matrices[index]);
+
+    FrameBuffer* previousFrameBuffer = _frameBuffer->bind();
+    Game* game = Game::getInstance();
+    Rectangle previousViewport = game->getViewport();
+    game->setViewport(Rectangle(column * _size, row * _size, _size, _size));
+    GL_ASSERT( glEnable(GL_SCISSOR_TEST) );
+    GL_ASSERT( glScissor(column * _size, row * _size, _size, _size) );
+
+    _casterState->bind();
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::one(), 1.0f, 0);
+
+    _effect->bind();
+    for (size_t i = 0, count = casters.size(); i < count; ++i)
+    {
+        Node* node = casters[i];
+        Matrix worldViewProjection;
+        Matrix::multiply(cascade.viewProjection, node->getWorldMatrix(), &worldViewProjection);
+        drawMesh(node->getModel()->getMesh(), worldViewProjection);
+    }
+
+    GL_ASSERT( glDisable(GL_SCISSOR_TEST) );
+    game->setViewport(previousViewport);
+    previousFrameBuffer->bind();
+}
+
+void ShadowMap::drawMesh(Mesh* mesh, const Matrix& worldViewProjection)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(_effect);
+
+    Uniform* uniform = _effect->getUniform("u_worldViewProjectionMatrix");
+    if (uniform)
+    {
+        _effect->setValue(uniform, worldViewProjection);
+    }
+
+    VertexAttributeBinding* binding = VertexAttributeBinding::create(mesh, _effect);
+    if (binding == NULL)
+        return;
+    binding->bind();
+
+    unsigned int partCount = mesh->getPartCount();
+    if (partCount == 0)
+    {
+        if (mesh->getPrimitiveType() == Mesh::TRIANGLES || mesh->getPrimitiveType() == Mesh::TRIANGLE_STRIP)
+        {
+            Game::countDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount());
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            GL_ASSERT( glDrawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount()) );
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < partCount; ++i)
+        {
+            MeshPart* part = mesh->getPart(i);
+            GP_ASSERT(part);
+            if (part->getPrimitiveType() != Mesh::TRIANGLES && part->getPrimitiveType() != Mesh::TRIANGLE_STRIP)
+                continue;
+            Game::countDrawCall(part->getPrimitiveType(), part->getIndexCount());
+            GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->getIndexBuffer());
+            GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
+        }
+    }
+
+    binding->unbind();
+    SAFE_RELEASE(binding);
+}
+
+void ShadowMap::bind(RenderState* renderState)
+{
+    GP_ASSERT(renderState);
+
+    // Receivers need the world position and the view-space depth of each vertex.
+    renderState->setParameterAutoBinding("u_worldMatrix", RenderState::WORLD_MATRIX);
+    renderState->setParameterAutoBinding("u_worldViewMatrix", RenderState::WORLD_VIEW_MATRIX);
+
+    if (_light->getLightType() == Light::DIRECTIONAL)
+    {
+        renderState->getParameter("u_shadowTexture")->setValue(_sampler);
+        renderState->getParameter("u_shadowTexelSize")->bindValue(this, &ShadowMap::getTexelSize);
+        renderState->getParameter("u_shadowCascadeFar")->bindValue(this, &ShadowMap::getCascadeFar);
+        renderState->getParameter("u_shadowMatrix")->bindValue(this, &ShadowMap::getMatrices, &ShadowMap::getCascadeCount);
+    }
+    else
+    {
+        renderState->getParameter("u_spotShadowTexture")->setValue(_sampler);
+        renderState->getParameter("u_spotShadowTexelSize")->bindValue(this, &ShadowMap::getTexelSize);
+        renderState->getParameter("u_spotShadowMatrix")->bindValue(this, &ShadowMap::getMatrices, &ShadowMap::getCascadeCount);
+    }
+}
+
+const Matrix* ShadowMap::getMatrices() const
+{
+    return _matrices;
+}
+
+const Vector4& ShadowMap::getCascadeFar() const
+{
+    return _cascadeFar;
+}
+
+const Vector2& ShadowMap::getTexelSize() const
+{
+    return _texelSize;
+}
+
+}
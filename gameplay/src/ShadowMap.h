@@ -0,0 +1,230 @@
+#ifndef SHADOWMAP_H_
+#define SHADOWMAP_H_
+
+#include "Ref.h"
+#include "Matrix.h"
+#include "Vector2.h"
+#include "Vector4.h"
+#include "Texture.h"
+#include "RenderState.h"
+
+namespace gameplay
+{
+
+class Light;
+class Scene;
+class Camera;
+class Node;
+class Mesh;
+class Effect;
+class FrameBuffer;
+
+/**
+ * Defines the shadow maps of a directional or spot light.
+ *
+ * Directional lights get cascaded shadow maps: the view frustum of the camera is split
+ * into up to MAX_CASCADES depth ranges, and each cascade is rendered into its own tile of
+ * a shared shadow texture with an orthographic projection that fits the range. Spot lights
+ * get a single shadow map rendered with a perspective projection matching the light's cone.
+ *
+ * Shadow maps are cached. Every frame, update() finds the casters of each cascade (or of the
+ * spot light) through the spatial index of the scene and only renders the cascades whose
+ * projection or casters changed since they were last rendered. Cascades are placed on a
+ * coarse grid in light space, so the camera can move a fair distance before a cascade has
+ * to follow it. A scene lit by a static sun therefore costs little more than the caster
+ * culling per frame.
+ *
+ * Depths are packed into an RGBA texture, which works on every platform. Skinned models,
+ * particle emitters and forms do not cast shadows.
+ *
+ * Effects receive the shadows when compiled with the SHADOW_CASCADE_COUNT define (set to the
+ * cascade count) for the first directional light, or with the SPOT_SHADOW define for the first
+ * spot light. The textured and colored shaders support both. Call bind() once for each
+ * material pass that uses such an effect, and update() every frame before drawing:
+ *
+ * @code
+   ShadowMap* shadows = ShadowMap::create(sunNode->getLight());
+   shadows->bind(material);
+   ...
+   void MyGame::render(float elapsedTime)
+   {
+       shadows->update(scene);
+       ...
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class ShadowMap : public Ref
+{
+public:
+
+    /**
+     * The maximum number of cascades of a directional light.
+     */
+    static const unsigned int MAX_CASCADES = 4;
+
+    /**
+     * Creates shadow maps for the specified light.
+     *
+     * @param light The directional or spot light casting the shadows.
+     * @param size The width and height of each shadow map, in texels.
+     * @param cascadeCount The number of cascades of a directional light, between 1 and MAX_CASCADES.
+     *
+     * @return The new shadow maps, or NULL if the light type does not support shadows.
+     */
+    static ShadowMap* create(Light* light, unsigned int size = 1024, unsigned int cascadeCount = MAX_CASCADES);
+
+    /**
+     * Returns the light casting the shadows.
+     *
+     * @return The light.
+     */
+    Light* getLight() const;
+
+    /**
+     * Returns the number of cascades (1 for a spot light).
+     *
+     * @return The number of cascades.
+     */
+    unsigned int getCascadeCount() const;
+
+    /**
+     * Sets the distance from the camera up to which directional shadows are drawn.
+     *
+     * The cascades are split between the near plane of the camera and this distance
+     * (or the far plane, if it is closer). The default distance is 100.
+     *
+     * @param distance The shadow distance.
+     */
+    void setShadowDistance(float distance);
+
+    /**
+     * Sets how far towards the light casters outside of a cascade are still rendered.
+     *
+     * The default distance is 100.
+     *
+     * @param distance The caster distance.
+     */
+    void setCasterDistance(float distance);
+
+    /**
+     * Sets the depth bias that prevents surfaces from shadowing themselves.
+     *
+     * The bias is in normalized depth units. The default bias is 0.002.
+     *
+     * @param bias The depth bias.
+     */
+    void setDepthBias(float bias);
+
+    /**
+     * Forces all the cascades to be rendered on the next update.
+     */
+    void invalidate();
+
+    /**
+     * Renders the cascades whose projection or casters changed.
+     *
+     * Directional shadows follow the active camera of the scene. The current frame buffer
+     * and viewport are restored afterwards.
+     *
+     * @param scene The scene containing the casters.
+     */
+    void update(Scene* scene);
+
+    /**
+     * Returns the number of cascades rendered by the last update.
+     *
+     * @return The number of cascades rendered.
+     */
+    unsigned int getRenderedCount() const;
+
+    /**
+     * Binds the shadow uniforms of the specified render state to these shadow maps.
+     *
+     * This also binds the world and world view matrices that the receiving effects need.
+     * The render state keeps pointers to these shadow maps, which must be kept alive for
+     * as long as the render state is used.
+     *
+     * @param renderState The render state (typically a Material) to bind.
+     */
+    void bind(RenderState* renderState);
+
+private:
+
+    /**
+     * Defines the state of a single cascade.
+     */
+    struct Cascade
+    {
+        Cascade();
+
+        Matrix viewProjection;
+        unsigned int casterHash;
+        bool valid;
+    };
+
+    /**
+     * Constructor.
+     */
+    ShadowMap(Light* light, unsigned int size, unsigned int cascadeCount);
+
+    /**
+     * Destructor.
+     */
+    ~ShadowMap();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ShadowMap(const ShadowMap& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ShadowMap& operator=(const ShadowMap&);
+
+    /**
+     * Computes the light view projection of each cascade of a directional light.
+     *
+     * @return false if there is no camera to fit the cascades to.
+     */
+    bool computeDirectionalCascades(Camera* camera, Matrix* viewProjections);
+
+    /**
+     * Renders the casters of a cascade into its tile of the shadow texture.
+     */
+    void renderCascade(unsigned int index, const std::vector<Node*>& casters);
+
+    /**
+     * Draws the triangles of a mesh with the caster effect.
+     */
+    void drawMesh(Mesh* mesh, const Matrix& worldViewProjection);
+
+    const Matrix* getMatrices() const;
+
+    const Vector4& getCascadeFar() const;
+
+    const Vector2& getTexelSize() const;
+
+    Light* _light;
+    unsigned int _size;
+    unsigned int _cascadeCount;
+    float _shadowDistance;
+    float _casterDistance;
+    float _depthBias;
+    unsigned int _renderedCount;
+    FrameBuffer* _frameBuffer;
+    Texture::Sampler* _sampler;
+    Effect* _effect;
+    RenderState::StateBlock* _casterState;
+    Cascade _cascades[MAX_CASCADES];
+    Matrix _matrices[MAX_CASCADES];
+    Vector4 _cascadeFar;
+    Vector2 _texelSize;
+    std::vector<Node*> _casters;
+};
+
+}
+
+#endif
@@ -19,13 +19,18 @@
 #define SPRITE_VSH "res/shaders/sprite.vert"
 #define SPRITE_FSH "res/shaders/sprite.frag"
 
+// Nine-slice sprite shaders
+#define SPRITE_NINESLICE_VSH "res/shaders/sprite-nineslice.vert"
+#define SPRITE_NINESLICE_FSH "res/shaders/sprite-nineslice.frag"
+
 namespace gameplay
 {
 
 static Effect* __spriteEffect = NULL;
+static Effect* __nineSliceEffect = NULL;
 
 SpriteBatch::SpriteBatch()
-    : _batch(NULL), _sampler(NULL), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f)
+    : _batch(NULL), _sampler(NULL), _customEffect(false), _nineSlice(false), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f)
 {
 }
 
@@ -33,7 +38,19 @@ SpriteBatch::~SpriteBatch()
 {
     SAFE_DELETE(_batch);
     SAFE_RELEASE(_sampler);
-    if (!_customEffect)
+    if (_nineSlice)
+    {
+        if (__nineSliceEffect && __nineSliceEffect->getRefCount() == 1)
+        {
+            __nineSliceEffect->release();
+            __nineSliceEffect = NULL;
+        }
+        else
+        {
+            __nineSliceEffect->release();
+        }
+    }
+    else if (!_customEffect)
     {
         if (__spriteEffect && __spriteEffect->getRefCount() == 1)
         {
@@ -80,6 +97,78 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
         }
     }
 
+    // Define the vertex format for the batch
+    VertexFormat::Element vertexElements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
+        VertexFormat::Element(VertexFormat::COLOR, 4)
+    };
+    VertexFormat vertexFormat(vertexElements, 3);
+
+    SpriteBatch* batch = createBatch(texture, effect, vertexFormat, initialCapacity);
+    if (batch == NULL)
+    {
+        SAFE_RELEASE(effect);
+        return NULL;
+    }
+    batch->_customEffect = customEffect;
+    return batch;
+}
+
+SpriteBatch* SpriteBatch::createNineSlice(Texture* texture, unsigned int initialCapacity)
+{
+    GP_ASSERT(texture != NULL);
+
+    // Create our static nine-slice effect.
+    if (__nineSliceEffect == NULL)
+    {
+        __nineSliceEffect = Effect::createFromFile(SPRITE_NINESLICE_VSH, SPRITE_NINESLICE_FSH);
+        if (__nineSliceEffect == NULL)
+        {
+            GP_WARN("Unable to load nine-slice sprite effect.");
+            return NULL;
+        }
+    }
+    else
+    {
+        __nineSliceEffect->addRef();
+    }
+
+    VertexFormat::Element vertexElements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::COLOR, 4),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 4),
+        VertexFormat::Element(VertexFormat::TEXCOORD1, 4),
+        VertexFormat::Element(VertexFormat::TEXCOORD2, 4),
+        VertexFormat::Element(VertexFormat::TEXCOORD3, 4)
+    };
+    VertexFormat vertexFormat(vertexElements, 6);
+    GP_ASSERT(vertexFormat.getVertexSize() == sizeof(NineSliceVertex));
+
+    Effect* effect = __nineSliceEffect;
+    SpriteBatch* batch = createBatch(texture, effect, vertexFormat, initialCapacity);
+    if (batch)
+    {
+        batch->_nineSlice = true;
+    }
+    else if (effect->getRefCount() == 1)
+    {
+        SAFE_RELEASE(__nineSliceEffect);
+    }
+    else
+    {
+        effect->release();
+    }
+    return batch;
+}
+
+SpriteBatch* SpriteBatch::createBatch(Texture* texture, Effect* effect, const VertexFormat& vertexFormat, unsigned int initialCapacity)
+{
+    GP_ASSERT(texture);
+    GP_ASSERT(effect);
+
     // Search for the first sampler uniform in the effect.
     Uniform* samplerUniform = NULL;
     for (unsigned int i = 0, count = effect->getUniformCount(); i < count; ++i)
@@ -94,7 +183,6 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
     if (!samplerUniform)
     {
         GP_ERROR("No uniform of type GL_SAMPLER_2D found in sprite effect.");
-        SAFE_RELEASE(effect);
         return NULL;
     }
 
@@ -110,15 +198,6 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
     // Bind the texture to the material as a sampler
     Texture::Sampler* sampler = Texture::Sampler::create(texture); // +ref texture
     material->getParameter(samplerUniform->getName())->setValue(sampler);
-    
-    // Define the vertex format for the batch
-    VertexFormat::Element vertexElements[] =
-    {
-        VertexFormat::Element(VertexFormat::POSITION, 3),
-        VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
-        VertexFormat::Element(VertexFormat::COLOR, 4)
-    };
-    VertexFormat vertexFormat(vertexElements, 3);
 
     // Create the mesh batch
     MeshBatch* meshBatch = MeshBatch::create(vertexFormat, Mesh::TRIANGLE_STRIP, material, true, initialCapacity > 0 ? initialCapacity : SPRITE_BATCH_DEFAULT_SIZE);
@@ -127,7 +206,6 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
     // Create the batch
     SpriteBatch* batch = new SpriteBatch();
     batch->_sampler = sampler;
-    batch->_customEffect = customEffect;
     batch->_batch = meshBatch;
     batch->_textureWidthRatio = 1.0f / (float)texture->getWidth();
     batch->_textureHeightRatio = 1.0f / (float)texture->getHeight();
@@ -375,6 +453,55 @@ void SpriteBatch::draw(float x, float y, float z, float width, float height, flo
     _batch->add(v, 4, indices, 4);
 }
 
+void SpriteBatch::drawNineSlice(const Rectangle& dst, const Vector4& border, const Vector4& uvs, const Vector4& innerUVs, const Vector4& color, const Rectangle& clip)
+{
+    GP_ASSERT(_nineSlice);
+
+    // Clip the quad. The distances to the edges of the sprite are interpolated linearly across
+    // the quad, so they are clipped with it and the slices stay where they are.
+    float x1 = std::max(dst.x, clip.x);
+    float y1 = std::max(dst.y, clip.y);
+    float x2 = std::min(dst.x + dst.width, clip.x + clip.width);
+    float y2 = std::min(dst.y + dst.height, clip.y + clip.height);
+    if (x1 >= x2 || y1 >= y2)
+        return;
+
+    static NineSliceVertex v[4];
+    const float x[4] = { x1, x1, x2, x2 };
+    const float y[4] = { y1, y2, y1, y2 };
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        NineSliceVertex& vertex = v[i];
+        vertex.x = x[i];
+        vertex.y = y[i];
+        vertex.z = 0;
+        vertex.r = color.x;
+        vertex.g = color.y;
+        vertex.b = color.z;
+        vertex.a = color.w;
+        vertex.edges[0] = x[i] - dst.x;
+        vertex.edges[1] = y[i] - dst.y;
+        vertex.edges[2] = dst.x + dst.width - x[i];
+        vertex.edges[3] = dst.y + dst.height - y[i];
+        vertex.border[0] = border.x;
+        vertex.border[1] = border.y;
+        vertex.border[2] = border.z;
+        vertex.border[3] = border.w;
+        vertex.uvs[0] = uvs.x;
+        vertex.uvs[1] = uvs.y;
+        vertex.uvs[2] = uvs.z;
+        vertex.uvs[3] = uvs.w;
+        vertex.innerUVs[0] = innerUVs.x;
+        vertex.innerUVs[1] = innerUVs.y;
+        vertex.innerUVs[2] = innerUVs.z;
+        vertex.innerUVs[3] = innerUVs.w;
+    }
+
+    static unsigned short indices[4] = { 0, 1, 2, 3 };
+
+    _batch->add(v, 4, indices, 4);
+}
+
 void SpriteBatch::finish()
 {
     // Finish and draw the batch
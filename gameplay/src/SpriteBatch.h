@@ -83,6 +83,24 @@ public:
      */
     static SpriteBatch* create(Texture* texture, Effect* effect = NULL, unsigned int initialCapacity = 0);
 
+    /**
+     * Creates a new SpriteBatch for drawing nine-slice sprites with the given texture.
+     *
+     * A nine-slice sprite is a rectangle whose corners are drawn unscaled, whose edges are
+     * stretched along one axis and whose center is stretched along both, such as the skin of
+     * a control. Each nine-slice sprite is drawn as a single quad: its borders are passed as
+     * vertex attributes and the shader maps the position of each fragment to the slice it is in.
+     *
+     * Batches created by this method can only draw with drawNineSlice().
+     *
+     * @param texture The texture for this sprite batch.
+     * @param initialCapacity An optional initial capacity of the batch (number of sprites).
+     *
+     * @return A new SpriteBatch, or NULL if the nine-slice effect could not be loaded.
+     * @script{ignore}
+     */
+    static SpriteBatch* createNineSlice(Texture* texture, unsigned int initialCapacity = 0);
+
     /**
      * Destructor.
      */
@@ -261,6 +279,19 @@ public:
      */
     void draw(float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color, bool positionIsCenter = false);
 
+    /**
+     * Draws a nine-slice sprite, clipped within a rectangle. The batch must have been created with createNineSlice().
+     *
+     * @param dst The destination rectangle.
+     * @param border The widths of the left, top, right and bottom borders of the destination, in pixels.
+     * @param uvs The texture coordinates of the outer edges of the source (u1, v1, u2, v2).
+     * @param innerUVs The texture coordinates of the inner edges of the source borders (u1, v1, u2, v2).
+     * @param color The color to tint the sprite. Use white for no tint.
+     * @param clip The clip rectangle.
+     * @script{ignore}
+     */
+    void drawNineSlice(const Rectangle& dst, const Vector4& border, const Vector4& uvs, const Vector4& innerUVs, const Vector4& color, const Rectangle& clip);
+
     /**
      * Finishes sprite drawing.
      *
@@ -333,6 +364,24 @@ private:
         float a;
     };
 
+    /**
+     * Vertex of a nine-slice sprite.
+     */
+    struct NineSliceVertex
+    {
+        float x;
+        float y;
+        float z;
+        float r;
+        float g;
+        float b;
+        float a;
+        float edges[4];     // distances to the left, top, right and bottom edges of the sprite
+        float border[4];
+        float uvs[4];
+        float innerUVs[4];
+    };
+
     /**
      * Constructor.
      */
@@ -395,9 +444,15 @@ private:
      */
     bool clipSprite(const Rectangle& clip, float& x, float& y, float& width, float& height, float& u1, float& v1, float& u2, float& v2);
 
+    /**
+     * Creates a sprite batch drawing vertices of the given format with an effect.
+     */
+    static SpriteBatch* createBatch(Texture* texture, Effect* effect, const VertexFormat& vertexFormat, unsigned int initialCapacity);
+
     MeshBatch* _batch;
     Texture::Sampler* _sampler;
     bool _customEffect;
+    bool _nineSlice;
     float _textureWidthRatio;
     float _textureHeightRatio;
     mutable Matrix _projectionMatrix;
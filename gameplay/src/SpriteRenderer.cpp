@@ -0,0 +1,332 @@
+#include "Base.h"
+#include "SpriteRenderer.h"
+#include "Game.h"
+#include "Material.h"
+
+// Default size of a newly created sprite renderer
+#define SPRITE_RENDERER_DEFAULT_SIZE 128
+
+// The largest number of textures sampled by one draw call. OpenGL ES 2.0 guarantees 8 fragment texture units.
+#define SPRITE_RENDERER_MAX_TEXTURES 8
+
+// The largest number of sprites in one draw call, whose vertices must be addressable by 16-bit indices.
+#define SPRITE_RENDERER_MAX_SPRITES 16384
+
+// Default sprite renderer shaders
+#define SPRITE_RENDERER_VSH "res/shaders/sprite-textures.vert"
+#define SPRITE_RENDERER_FSH "res/shaders/sprite-textures.frag"
+
+namespace gameplay
+{
+
+static Effect* __spriteRendererEffect = NULL;
+static unsigned int __textureCount = 0;
+
+SpriteRenderer::SpriteLess::SpriteLess(bool sortTextures) : sortTextures(sortTextures)
+{
+}
+
+bool SpriteRenderer::SpriteLess::operator()(const Sprite& a, const Sprite& b) const
+{
+    if (a.layer != b.layer)
+        return a.layer < b.layer;
+    if (sortTextures && a.sampler != b.sampler)
+        return std::less<Texture::Sampler*>()(a.sampler, b.sampler);
+    return a.order < b.order;
+}
+
+SpriteRenderer::SpriteRenderer()
+    : _batch(NULL), _sortTextures(false), _started(false)
+{
+}
+
+SpriteRenderer::~SpriteRenderer()
+{
+    SAFE_DELETE(_batch);
+    for (std::map<Texture*, Texture::Sampler*>::iterator itr = _samplers.begin(); itr != _samplers.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+
+    if (__spriteRendererEffect && __spriteRendererEffect->getRefCount() == 1)
+    {
+        __spriteRendererEffect->release();
+        __spriteRendererEffect = NULL;
+    }
+    else
+    {
+        SAFE_RELEASE(__spriteRendererEffect);
+    }
+}
+
+SpriteRenderer* SpriteRenderer::create(unsigned int initialCapacity)
+{
+    // Create our static effect, with as many samplers as the fragment shader can use.
+    if (__spriteRendererEffect == NULL)
+    {
+        GLint units = 0;
+        GL_ASSERT( glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units) );
+        __textureCount = (unsigned int)std::max(std::min(units, (GLint)SPRITE_RENDERER_MAX_TEXTURES), (GLint)1);
+
+        char defines[32];
+        sprintf(defines, "TEXTURE_COUNT %u", __textureCount);
+        __spriteRendererEffect = Effect::createFromFile(SPRITE_RENDERER_VSH, SPRITE_RENDERER_FSH, defines);
+        if (__spriteRendererEffect == NULL)
+        {
+            GP_ERROR("Unable to load sprite renderer effect.");
+            return NULL;
+        }
+    }
+    else
+    {
+        __spriteRendererEffect->addRef();
+    }
+
+    // Wrap the effect in a material
+    Material* material = Material::create(__spriteRendererEffect); // +ref effect
+
+    // Set initial material state
+    material->getStateBlock()->setBlend(true);
+    material->getStateBlock()->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
+    material->getStateBlock()->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
+
+    // Define the vertex format for the batch
+    VertexFormat::Element vertexElements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
+        VertexFormat::Element(VertexFormat::COLOR, 4),
+        VertexFormat::Element(VertexFormat::TEXCOORD1, 1)
+    };
+    VertexFormat vertexFormat(vertexElements, 4);
+
+    // Create the mesh batch, which holds the sprites of one draw call at a time.
+    unsigned int capacity = std::min(initialCapacity > 0 ? initialCapacity : SPRITE_RENDERER_DEFAULT_SIZE, (unsigned int)SPRITE_RENDERER_MAX_SPRITES);
+    MeshBatch* meshBatch = MeshBatch::create(vertexFormat, Mesh::TRIANGLE_STRIP, material, true, capacity * 4, capacity * 4);
+    material->release(); // don't call SAFE_RELEASE since material is used below
+
+    SpriteRenderer* renderer = new SpriteRenderer();
+    renderer->_batch = meshBatch;
+    renderer->_slots.resize(__textureCount, NULL);
+    renderer->_sprites.reserve(capacity);
+    renderer->_vertices.reserve(capacity * 4);
+
+    // Bind an ortho projection to the material by default (user can override with setProjectionMatrix)
+    Game* game = Game::getInstance();
+    Matrix::createOrthographicOffCenter(0, game->getViewport().width, game->getViewport().height, 0, 0, 1, &renderer->_projectionMatrix);
+    material->getParameter("u_projectionMatrix")->bindValue(renderer, &SpriteRenderer::getProjectionMatrix);
+
+    return renderer;
+}
+
+void SpriteRenderer::start()
+{
+    _sprites.clear();
+    _vertices.clear();
+    _started = true;
+}
+
+bool SpriteRenderer::isStarted() const
+{
+    return _started;
+}
+
+void SpriteRenderer::draw(Texture* texture, const Rectangle& dst, const Rectangle& src, const Vector4& color, int layer)
+{
+    GP_ASSERT(texture);
+
+    // Calculate uvs.
+    float widthRatio = 1.0f / (float)texture->getWidth();
+    float heightRatio = 1.0f / (float)texture->getHeight();
+    float u1 = widthRatio * src.x;
+    float v1 = 1.0f - heightRatio * src.y;
+    float u2 = u1 + widthRatio * src.width;
+    float v2 = v1 - heightRatio * src.height;
+
+    draw(texture, dst.x, dst.y, 0, dst.width, dst.height, u1, v1, u2, v2, color, layer);
+}
+
+void SpriteRenderer::draw(Texture* texture, const Vector3& dst, const Rectangle& src, const Vector2& scale, const Vector4& color,
+                          const Vector2& rotationPoint, float rotationAngle, int layer)
+{
+    GP_ASSERT(texture);
+
+    // Calculate uvs.
+    float widthRatio = 1.0f / (float)texture->getWidth();
+    float heightRatio = 1.0f / (float)texture->getHeight();
+    float u1 = widthRatio * src.x;
+    float v1 = 1.0f - heightRatio * src.y;
+    float u2 = u1 + widthRatio * src.width;
+    float v2 = v1 - heightRatio * src.height;
+
+    // Expand the destination position by scale into 4 points, and rotate them around the pivot.
+    float x2 = dst.x + scale.x;
+    float y2 = dst.y + scale.y;
+    Vector2 upLeft(dst.x, dst.y);
+    Vector2 upRight(x2, dst.y);
+    Vector2 downLeft(dst.x, y2);
+    Vector2 downRight(x2, y2);
+    Vector2 pivotPoint(dst.x + rotationPoint.x * scale.x, dst.y + rotationPoint.y * scale.y);
+    upLeft.rotate(pivotPoint, rotationAngle);
+    upRight.rotate(pivotPoint, rotationAngle);
+    downLeft.rotate(pivotPoint, rotationAngle);
+    downRight.rotate(pivotPoint, rotationAngle);
+
+    SpriteVertex* v = addSprite(texture, layer);
+
+    const Vector2* corners[4] = { &downLeft, &upLeft, &downRight, &upRight };
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        v[i].x = corners[i]->x;
+        v[i].y = corners[i]->y;
+        v[i].z = dst.z;
+        v[i].u = i < 2 ? u1 : u2;
+        v[i].v = (i & 1) ? v2 : v1;
+        v[i].r = color.x;
+        v[i].g = color.y;
+        v[i].b = color.z;
+        v[i].a = color.w;
+    }
+}
+
+void SpriteRenderer::draw(Texture* texture, float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2,
+                          const Vector4& color, int layer)
+{
+    SpriteVertex* v = addSprite(texture, layer);
+
+    // Same vertex order as SpriteBatch, so both draw sprites with the same orientation.
+    const float x2 = x + width;
+    const float y2 = y + height;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        v[i].x = i < 2 ? x : x2;
+        v[i].y = (i & 1) ? y2 : y;
+        v[i].z = z;
+        v[i].u = i < 2 ? u1 : u2;
+        v[i].v = (i & 1) ? v2 : v1;
+        v[i].r = color.x;
+        v[i].g = color.y;
+        v[i].b = color.z;
+        v[i].a = color.w;
+    }
+}
+
+SpriteRenderer::SpriteVertex* SpriteRenderer::addSprite(Texture* texture, int layer)
+{
+    GP_ASSERT(texture);
+    GP_ASSERT(_started);
+
+    Sprite sprite;
+    sprite.layer = layer;
+    sprite.sampler = getSampler(texture);
+    sprite.order = (unsigned int)_sprites.size();
+    _sprites.push_back(sprite);
+
+    _vertices.resize(_vertices.size() + 4);
+    return &_vertices[sprite.order * 4];
+}
+
+void SpriteRenderer::finish()
+{
+    GP_ASSERT(_started);
+    _started = false;
+
+    if (_sprites.empty())
+        return;
+
+    std::stable_sort(_sprites.begin(), _sprites.end(), SpriteLess(_sortTextures));
+
+    // Give each texture a sampler slot in the current draw call, and draw the call
+    // when the next sprite needs more slots (or vertices) than the call has left.
+    static const unsigned short indices[4] = { 0, 1, 2, 3 };
+    unsigned int slotCount = 0;
+    unsigned int spriteCount = 0;
+    _batch->start();
+    for (size_t i = 0, count = _sprites.size(); i < count; ++i)
+    {
+        const Sprite& sprite = _sprites[i];
+        unsigned int slot = 0;
+        while (slot < slotCount && _slots[slot] != sprite.sampler)
+        {
+            ++slot;
+        }
+        if ((slot == slotCount && slotCount == __textureCount) || spriteCount == SPRITE_RENDERER_MAX_SPRITES)
+        {
+            flush(slotCount);
+            _batch->start();
+            slotCount = slot = 0;
+            spriteCount = 0;
+        }
+        if (slot == slotCount)
+        {
+            _slots[slotCount++] = sprite.sampler;
+        }
+
+        SpriteVertex* v = &_vertices[sprite.order * 4];
+        v[0].texture = v[1].texture = v[2].texture = v[3].texture = (float)slot;
+        _batch->add(v, 4, indices, 4);
+        ++spriteCount;
+    }
+    flush(slotCount);
+}
+
+void SpriteRenderer::flush(unsigned int slotCount)
+{
+    GP_ASSERT(slotCount > 0);
+
+    _batch->finish();
+
+    // Unused slots must still hold a valid sampler.
+    for (unsigned int i = slotCount; i < __textureCount; ++i)
+    {
+        _slots[i] = _slots[0];
+    }
+    _batch->getMaterial()->getParameter("u_textures")->setValue(&_slots[0], __textureCount);
+
+    _batch->draw();
+}
+
+void SpriteRenderer::setTextureSorting(bool sort)
+{
+    _sortTextures = sort;
+}
+
+bool SpriteRenderer::isTextureSorting() const
+{
+    return _sortTextures;
+}
+
+unsigned int SpriteRenderer::getTextureCount()
+{
+    return __textureCount;
+}
+
+Texture::Sampler* SpriteRenderer::getSampler(Texture* texture)
+{
+    GP_ASSERT(texture);
+
+    std::map<Texture*, Texture::Sampler*>::iterator itr = _samplers.find(texture);
+    if (itr != _samplers.end())
+        return itr->second;
+
+    Texture::Sampler* sampler = Texture::Sampler::create(texture); // +ref texture
+    _samplers[texture] = sampler;
+    return sampler;
+}
+
+RenderState::StateBlock* SpriteRenderer::getStateBlock() const
+{
+    return _batch->getMaterial()->getStateBlock();
+}
+
+void SpriteRenderer::setProjectionMatrix(const Matrix& matrix)
+{
+    _projectionMatrix = matrix;
+}
+
+const Matrix& SpriteRenderer::getProjectionMatrix() const
+{
+    return _projectionMatrix;
+}
+
+}
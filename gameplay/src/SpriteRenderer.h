@@ -0,0 +1,247 @@
+#ifndef SPRITERENDERER_H_
+#define SPRITERENDERER_H_
+
+#include "Texture.h"
+#include "Rectangle.h"
+#include "Matrix.h"
+#include "RenderState.h"
+#include "MeshBatch.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a class for drawing sprites from many textures in few draw calls.
+ *
+ * Unlike SpriteBatch, which is bound to a single texture, each sprite drawn with a
+ * SpriteRenderer names its own texture and a layer. The sprites queued between start()
+ * and finish() are drawn when finish() is called, in the order of their layers (lower
+ * layers first), and in the order they were drawn within a layer. Consecutive sprites
+ * share a draw call as long as they use no more than getTextureCount() different textures,
+ * since the shader of the renderer samples the texture of each sprite from an array of samplers.
+ *
+ * When the sprites of a layer do not overlap (or their order does not matter), the
+ * renderer can sort them by texture as well (see setTextureSorting), which packs the
+ * sprites of many textures into the fewest draw calls.
+ *
+ * The renderer keeps a sampler, and so a reference, for each texture it has drawn
+ * until it is destroyed.
+ *
+ * @script{ignore}
+ */
+class SpriteRenderer
+{
+public:
+
+    /**
+     * Creates a new sprite renderer.
+     *
+     * The renderer draws with a default effect that applies an orthographic projection
+     * for the currently bound viewport, and blends sprites using their alpha.
+     *
+     * @param initialCapacity An optional initial capacity of the renderer (number of sprites).
+     *
+     * @return A new sprite renderer, or NULL if its effect could not be loaded.
+     */
+    static SpriteRenderer* create(unsigned int initialCapacity = 0);
+
+    /**
+     * Destructor.
+     */
+    ~SpriteRenderer();
+
+    /**
+     * Starts queuing sprites, discarding the sprites queued since the last call to finish().
+     */
+    void start();
+
+    /**
+     * Determines if the renderer is currently started and not finished.
+     *
+     * @return True if the renderer is started and not finished.
+     */
+    bool isStarted() const;
+
+    /**
+     * Queues a sprite for drawing.
+     *
+     * @param texture The texture of the sprite.
+     * @param dst The destination rectangle.
+     * @param src The source rectangle, in pixels of the texture.
+     * @param color The color to tint the sprite. Use white for no tint.
+     * @param layer The layer of the sprite. Lower layers are drawn first.
+     */
+    void draw(Texture* texture, const Rectangle& dst, const Rectangle& src, const Vector4& color = Vector4::one(), int layer = 0);
+
+    /**
+     * Queues a rotated sprite for drawing.
+     *
+     * @param texture The texture of the sprite.
+     * @param dst The destination position.
+     * @param src The source rectangle, in pixels of the texture.
+     * @param scale The X and Y scale.
+     * @param color The color to tint the sprite. Use white for no tint.
+     * @param rotationPoint The point to rotate around, relative to dst's x and y values.
+     *                      (e.g. Use Vector2(0.5f, 0.5f) to rotate around the quad's center.)
+     * @param rotationAngle The rotation angle in radians.
+     * @param layer The layer of the sprite. Lower layers are drawn first.
+     */
+    void draw(Texture* texture, const Vector3& dst, const Rectangle& src, const Vector2& scale, const Vector4& color,
+              const Vector2& rotationPoint, float rotationAngle, int layer = 0);
+
+    /**
+     * Queues a sprite for drawing.
+     *
+     * @param texture The texture of the sprite.
+     * @param x The x coordinate.
+     * @param y The y coordinate.
+     * @param z The z coordinate.
+     * @param width The sprite width.
+     * @param height The sprite height.
+     * @param u1 Texture coordinate.
+     * @param v1 Texture coordinate.
+     * @param u2 Texture coordinate.
+     * @param v2 Texture coordinate.
+     * @param color The color to tint the sprite. Use white for no tint.
+     * @param layer The layer of the sprite. Lower layers are drawn first.
+     */
+    void draw(Texture* texture, float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2,
+              const Vector4& color, int layer = 0);
+
+    /**
+     * Sorts the queued sprites and draws them.
+     */
+    void finish();
+
+    /**
+     * Sets whether the sprites of a layer are sorted by texture.
+     *
+     * Sorting by texture lets sprites of the same texture that were drawn apart share a draw call,
+     * but changes the order in which the sprites of a layer are drawn, so it is only correct when
+     * they do not overlap. It is disabled by default.
+     *
+     * @param sort true to sort the sprites of each layer by texture.
+     */
+    void setTextureSorting(bool sort);
+
+    /**
+     * Determines if the sprites of a layer are sorted by texture.
+     *
+     * @return true if the sprites of each layer are sorted by texture.
+     */
+    bool isTextureSorting() const;
+
+    /**
+     * Returns the largest number of textures that the sprites of a single draw call can use.
+     *
+     * @return The number of samplers of the renderer's effect.
+     */
+    static unsigned int getTextureCount();
+
+    /**
+     * Returns the sampler used to draw the sprites of a texture, which sets how they are filtered and wrapped.
+     *
+     * @param texture The texture.
+     *
+     * @return The sampler of the texture.
+     */
+    Texture::Sampler* getSampler(Texture* texture);
+
+    /**
+     * Gets the state block used to draw the sprites.
+     *
+     * @return The state block.
+     */
+    RenderState::StateBlock* getStateBlock() const;
+
+    /**
+     * Sets a custom projection matrix to use with the renderer.
+     *
+     * @param matrix The new projection matrix to be used with the default effect.
+     */
+    void setProjectionMatrix(const Matrix& matrix);
+
+    /**
+     * Gets the projection matrix of the renderer.
+     *
+     * @return The projection matrix.
+     */
+    const Matrix& getProjectionMatrix() const;
+
+private:
+
+    /**
+     * Defines a vertex of a sprite.
+     */
+    struct SpriteVertex
+    {
+        float x;
+        float y;
+        float z;
+        float u;
+        float v;
+        float r;
+        float g;
+        float b;
+        float a;
+        float texture;      // The index of the sampler of the sprite within its draw call.
+    };
+
+    /**
+     * Defines a queued sprite.
+     */
+    struct Sprite
+    {
+        int layer;
+        Texture::Sampler* sampler;
+        unsigned int order;     // The index of the sprite in drawing order, whose vertices start at order * 4.
+    };
+
+    /**
+     * Orders sprites by layer, and then by drawing order or by texture.
+     */
+    struct SpriteLess
+    {
+        SpriteLess(bool sortTextures);
+        bool operator()(const Sprite& a, const Sprite& b) const;
+        bool sortTextures;
+    };
+
+    /**
+     * Constructor.
+     */
+    SpriteRenderer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    SpriteRenderer(const SpriteRenderer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    SpriteRenderer& operator=(const SpriteRenderer&);
+
+    /**
+     * Queues the four vertices of a sprite, in triangle strip order.
+     */
+    SpriteVertex* addSprite(Texture* texture, int layer);
+
+    /**
+     * Draws the sprites of the batch accumulated so far with the samplers bound to its slots.
+     */
+    void flush(unsigned int slotCount);
+
+    MeshBatch* _batch;
+    std::map<Texture*, Texture::Sampler*> _samplers;
+    std::vector<Sprite> _sprites;
+    std::vector<SpriteVertex> _vertices;
+    std::vector<const Texture::Sampler*> _slots;
+    bool _sortTextures;
+    bool _started;
+    mutable Matrix _projectionMatrix;
+};
+
+}
+
+#endif
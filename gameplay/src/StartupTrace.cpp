@@ -0,0 +1,139 @@
+#include "Base.h"
+#include "StartupTrace.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "Stream.h"
+
+namespace gameplay
+{
+
+/**
+ * A single timed phase of startup.
+ */
+struct StartupPhase
+{
+    const char* name;
+    unsigned int depth;
+    double start;
+    double end;
+};
+
+static bool __recording = true;
+static std::vector<StartupPhase> __phases;
+static std::vector<size_t> __stack;
+static double __startupTime = 0.0;
+
+void StartupTrace::begin(const char* name)
+{
+    GP_ASSERT(name);
+
+    if (!__recording)
+        return;
+
+    StartupPhase phase;
+    phase.name = name;
+    phase.depth = (unsigned int)__stack.size();
+    phase.start = Game::getAbsoluteTime();
+    phase.end = phase.start;
+    __stack.push_back(__phases.size());
+    __phases.push_back(phase);
+}
+
+void StartupTrace::end()
+{
+    if (__stack.empty())
+        return;
+
+    __phases[__stack.back()].end = Game::getAbsoluteTime();
+    __stack.pop_back();
+}
+
+void StartupTrace::record(const char* name, double start, double end)
+{
+    GP_ASSERT(name);
+
+    if (!__recording)
+        return;
+
+    StartupPhase phase;
+    phase.name = name;
+    phase.depth = (unsigned int)__stack.size();
+    phase.start = start;
+    phase.end = end;
+    __phases.push_back(phase);
+}
+
+bool StartupTrace::isRecording()
+{
+    return __recording;
+}
+
+double StartupTrace::getStartupTime()
+{
+    return __startupTime;
+}
+
+void StartupTrace::finish()
+{
+    if (!__recording)
+        return;
+
+    // Close any phases that were left open, and stop recording.
+    while (!__stack.empty())
+    {
+        end();
+    }
+    __recording = false;
+
+    double origin = 0.0;
+    for (size_t i = 0, count = __phases.size(); i < count; ++i)
+    {
+        origin = std::min(origin, __phases[i].start);
+    }
+    __startupTime = Game::getAbsoluteTime() - origin;
+
+    Properties* config = Game::getInstance()->getConfig();
+    Properties* startup = config ? config->getNamespace("startup", true) : NULL;
+    if (startup && startup->getBool("log"))
+    {
+        for (size_t i = 0, count = __phases.size(); i < count; ++i)
+        {
+            const StartupPhase& phase = __phases[i];
+            Logger::log(Logger::LEVEL_INFO, "Startup: %*s%s %.2f ms (at %.2f ms)\n", (int)(phase.depth * 2), "", phase.name,
+                phase.end - phase.start, phase.start - origin);
+        }
+        Logger::log(Logger::LEVEL_INFO, "Startup: first frame ended at %.2f ms\n", __startupTime);
+    }
+
+    const char* path = startup ? startup->getString("traceFile") : NULL;
+    if (path)
+    {
+        std::auto_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+        if (stream.get() == NULL)
+        {
+            GP_WARN("Failed to open file '%s' to write the startup trace.", path);
+        }
+        else
+        {
+            // Write each phase as a complete event, with times in microseconds from the earliest phase.
+            char event[256];
+            const char* header = "{\"traceEvents\":[\n";
+            stream->write(header, 1, strlen(header));
+            for (size_t i = 0, count = __phases.size(); i < count; ++i)
+            {
+                const StartupPhase& phase = __phases[i];
+                int length = sprintf(event, "%s{\"name\":\"%.128s\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+                    i > 0 ? ",\n" : "", phase.name, (phase.start - origin) * 1000.0, (phase.end - phase.start) * 1000.0);
+                stream->write(event, 1, length);
+            }
+            const char* footer = "\n]}\n";
+            stream->write(footer, 1, strlen(footer));
+            stream->close();
+        }
+    }
+
+    std::vector<StartupPhase>().swap(__phases);
+    std::vector<size_t>().swap(__stack);
+}
+
+}
@@ -0,0 +1,123 @@
+#ifndef STARTUPTRACE_H_
+#define STARTUPTRACE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a trace of the phases of starting the game.
+ *
+ * The platform and the game time each phase of startup, from the creation of the
+ * platform (its window and graphics context) through the startup of the controllers,
+ * the loading of the configuration, the registration of the script bindings and the
+ * game's initialize() to the end of the first frame. Games can time their own phases
+ * within initialize() the same way. The phases are always recorded, since there are
+ * only a few of them, and recording stops at the end of the first frame.
+ *
+ * The trace can be reported at the end of the first frame by the "startup" section of
+ * game.config, which logs the time of each phase and can write them to a file in the
+ * Chrome trace event format (open it with chrome://tracing):
+ * @code
+   startup
+   {
+       log = true
+       traceFile = startup.json
+   }
+ * @endcode
+ *
+ * Times are in milliseconds of the game clock. Phases that run before the platform
+ * starts the game clock have negative times. The trace must only be used from the
+ * game thread.
+ *
+ * @script{ignore}
+ */
+class StartupTrace
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Times a phase of startup for the lifetime of the scope it is declared in.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Constructor. Starts timing the phase.
+         *
+         * @param name The name of the phase. This must be a string literal.
+         */
+        Scope(const char* name)
+        {
+            StartupTrace::begin(name);
+        }
+
+        /**
+         * Destructor. Stops timing the phase.
+         */
+        ~Scope()
+        {
+            StartupTrace::end();
+        }
+
+    private:
+
+        Scope(const Scope& copy);
+
+        Scope& operator=(const Scope&);
+    };
+
+    /**
+     * Starts timing a phase of startup, within the phase currently timed.
+     *
+     * @param name The name of the phase. This must be a string literal (or otherwise
+     *      outlive the trace) since only the pointer is stored.
+     */
+    static void begin(const char* name);
+
+    /**
+     * Stops timing the most recently started phase.
+     */
+    static void end();
+
+    /**
+     * Records a phase timed by the caller, such as a phase that ran before the game clock started.
+     *
+     * @param name The name of the phase. This must be a string literal.
+     * @param start The time the phase started, in milliseconds of the game clock.
+     * @param end The time the phase ended, in milliseconds of the game clock.
+     */
+    static void record(const char* name, double start, double end);
+
+    /**
+     * Determines if the phases of startup are still being recorded, which they are until the end of the first frame.
+     *
+     * @return true if the trace is recording.
+     */
+    static bool isRecording();
+
+    /**
+     * Returns the time from the start of the earliest phase to the end of the first frame.
+     *
+     * @return The startup time in milliseconds, or 0 until the first frame has ended.
+     */
+    static double getStartupTime();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    StartupTrace();
+
+    /**
+     * Stops recording and reports the trace as configured. Called by Game::frame at the end of the first frame.
+     */
+    static void finish();
+};
+
+}
+
+#endif
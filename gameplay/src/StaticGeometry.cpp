@@ -0,0 +1,527 @@
+#include "Base.h"
+#include "StaticGeometry.h"
+#include "Scene.h"
+#include "Bundle.h"
+#include "Model.h"
+#include "MeshPart.h"
+#include "Material.h"
+
+// The most vertices a merged mesh can index with 16-bit indices.
+#define STATIC_GEOMETRY_MAX_VERTICES 65535
+
+// The number of cells the longest side of the static geometry is split into when no cell size is given.
+#define STATIC_GEOMETRY_DEFAULT_CELLS 8
+
+namespace gameplay
+{
+
+/**
+ * The vertices and the triangle indices of a mesh of a static node, read from its bundle.
+ */
+struct StaticMesh
+{
+    StaticMesh(const VertexFormat& format) : format(format), vertexCount(0) { }
+
+    VertexFormat format;
+    unsigned int vertexCount;
+    std::vector<unsigned char> vertexData;
+    std::vector<std::vector<unsigned int> > parts;
+};
+
+/**
+ * A mesh part of a static node, to be merged.
+ */
+struct StaticPart
+{
+    Node* node;
+    const StaticMesh* mesh;
+    unsigned int part;
+};
+
+/**
+ * The parts merged into the meshes of a cell, which share a material and a vertex format.
+ */
+struct StaticGroup
+{
+    Material* material;
+    unsigned int format;
+    std::vector<StaticPart> parts;
+};
+
+static void gatherNodes(Node* node, std::vector<Node*>* nodes)
+{
+    for (; node != NULL; node = node->getNextSibling())
+    {
+        nodes->push_back(node);
+        gatherNodes(node->getFirstChild(), nodes);
+    }
+}
+
+/**
+ * Determines if the vertices of a format can be transformed into world space.
+ */
+static bool isMergeable(const VertexFormat& format)
+{
+    bool position = false;
+    for (unsigned int i = 0, count = format.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& e = format.getElement(i);
+        switch (e.usage)
+        {
+        case VertexFormat::POSITION:
+            if (e.type != VertexFormat::FLOAT || e.size != 3)
+                return false;
+            position = true;
+            break;
+        case VertexFormat::NORMAL:
+        case VertexFormat::BINORMAL:
+            if (e.type != VertexFormat::FLOAT || e.size != 3)
+                return false;
+            break;
+        case VertexFormat::TANGENT:
+            if (e.type != VertexFormat::FLOAT || (e.size != 3 && e.size != 4))
+                return false;
+            break;
+        case VertexFormat::BLENDWEIGHTS:
+        case VertexFormat::BLENDINDICES:
+            return false;
+        default:
+            break;
+        }
+    }
+    return position;
+}
+
+/**
+ * Determines if every part of a mesh fits in a merged mesh.
+ */
+static bool isMergeable(const StaticMesh* mesh)
+{
+    std::vector<unsigned int> used(mesh->vertexCount, UINT_MAX);
+    for (unsigned int i = 0, count = (unsigned int)mesh->parts.size(); i < count; ++i)
+    {
+        const std::vector<unsigned int>& indices = mesh->parts[i];
+        if (indices.empty())
+            return false;
+
+        unsigned int vertexCount = 0;
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            if (indices[j] >= mesh->vertexCount)
+                return false;
+            if (used[indices[j]] != i)
+            {
+                used[indices[j]] = i;
+                ++vertexCount;
+            }
+        }
+        if (vertexCount > STATIC_GEOMETRY_MAX_VERTICES)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Determines if the model of a node can be merged, before its mesh data is read.
+ */
+static bool isCandidate(Node* node)
+{
+    Model* model = node->getModel();
+    if (model == NULL || !node->isStatic() || model->getSkin() || model->getLodCount() > 0)
+        return false;
+
+    Mesh* mesh = model->getMesh();
+    if (strchr(mesh->getUrl(), '#') == NULL || mesh->getPartCount() == 0)
+        return false;
+    for (unsigned int i = 0, count = model->getMeshPartCount(); i < count; ++i)
+    {
+        if (model->getMaterial(i) == NULL)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Accumulates the transformed vertices and the indices of a merged mesh.
+ */
+class StaticBatch
+{
+public:
+
+    StaticBatch(const VertexFormat& format, Material* material)
+        : _format(format), _material(material), _vertexCount(0), _empty(true)
+    {
+    }
+
+    ~StaticBatch()
+    {
+        for (size_t i = 0, count = _meshes.size(); i < count; ++i)
+        {
+            SAFE_RELEASE(_meshes[i]);
+        }
+    }
+
+    /**
+     * Adds the triangles of a part, first creating a mesh for the parts added so far if the part would not fit.
+     */
+    void add(const StaticPart& part)
+    {
+        const std::vector<unsigned int>& indices = part.mesh->parts[part.part];
+
+        // Only the vertices the part indexes are copied.
+        std::vector<int> remap(part.mesh->vertexCount, -1);
+        std::vector<unsigned int> vertices;
+        for (size_t i = 0, count = indices.size(); i < count; ++i)
+        {
+            unsigned int index = indices[i];
+            if (remap[index] < 0)
+            {
+                remap[index] = (int)vertices.size();
+                vertices.push_back(index);
+            }
+        }
+        if (_vertexCount + vertices.size() > STATIC_GEOMETRY_MAX_VERTICES)
+            flush();
+
+        const Matrix& world = part.node->getWorldMatrix();
+        Matrix normalMatrix;
+        world.invert(&normalMatrix);
+        normalMatrix.transpose();
+        bool mirrored = world.determinant() < 0.0f;
+
+        unsigned int vertexSize = _format.getVertexSize();
+        size_t start = _vertexData.size();
+        _vertexData.resize(start + vertices.size() * vertexSize);
+        for (size_t i = 0, count = vertices.size(); i < count; ++i)
+        {
+            unsigned char* vertex = &_vertexData[start + i * vertexSize];
+            memcpy(vertex, &part.mesh->vertexData[vertices[i] * vertexSize], vertexSize);
+            transform(vertex, world, normalMatrix, mirrored);
+        }
+
+        // Mirroring transforms reverse the winding of the triangles, which is swapped back.
+        for (size_t i = 0, count = indices.size(); i + 2 < count; i += 3)
+        {
+            unsigned int a = indices[i];
+            unsigned int b = indices[i + 1];
+            unsigned int c = indices[i + 2];
+            _indices.push_back((unsigned short)(_vertexCount + remap[a]));
+            _indices.push_back((unsigned short)(_vertexCount + remap[mirrored ? c : b]));
+            _indices.push_back((unsigned short)(_vertexCount + remap[mirrored ? b : c]));
+        }
+        _vertexCount += (unsigned int)vertices.size();
+    }
+
+    /**
+     * Creates a mesh from the parts added so far.
+     */
+    void flush()
+    {
+        if (_indices.empty())
+            return;
+
+        Mesh* mesh = Mesh::createMesh(_format, _vertexCount, false);
+        if (mesh == NULL)
+        {
+            GP_WARN("Failed to create a merged static mesh.");
+            clear();
+            return;
+        }
+        mesh->setVertexData((const float*)&_vertexData[0], 0, _vertexCount);
+        MeshPart* meshPart = mesh->addPart(Mesh::TRIANGLES, Mesh::INDEX16, (unsigned int)_indices.size(), false);
+        meshPart->setIndexData(&_indices[0], 0, (unsigned int)_indices.size());
+        mesh->setBoundingBox(_bounds);
+        Vector3 center = _bounds.getCenter();
+        mesh->setBoundingSphere(BoundingSphere(center, center.distance(_bounds.max)));
+        _meshes.push_back(mesh);
+        clear();
+    }
+
+    /**
+     * Returns the merged meshes.
+     */
+    const std::vector<Mesh*>& getMeshes() const
+    {
+        return _meshes;
+    }
+
+    Material* getMaterial() const
+    {
+        return _material;
+    }
+
+private:
+
+    StaticBatch(const StaticBatch&);
+    StaticBatch& operator=(const StaticBatch&);
+
+    void transform(unsigned char* vertex, const Matrix& world, const Matrix& normalMatrix, bool mirrored)
+    {
+        for (unsigned int i = 0, count = _format.getElementCount(); i < count; ++i)
+        {
+            const VertexFormat::Element& e = _format.getElement(i);
+            float* value = (float*)vertex;
+            vertex += e.getByteSize();
+            if (e.usage != VertexFormat::POSITION && e.usage != VertexFormat::NORMAL &&
+                e.usage != VertexFormat::TANGENT && e.usage != VertexFormat::BINORMAL)
+                continue;
+
+            Vector3 v(value[0], value[1], value[2]);
+            switch (e.usage)
+            {
+            case VertexFormat::POSITION:
+                world.transformPoint(&v);
+                if (_empty)
+                    _bounds.set(v, v);
+                _empty = false;
+                _bounds.min.set(std::min(_bounds.min.x, v.x), std::min(_bounds.min.y, v.y), std::min(_bounds.min.z, v.z));
+                _bounds.max.set(std::max(_bounds.max.x, v.x), std::max(_bounds.max.y, v.y), std::max(_bounds.max.z, v.z));
+                break;
+            case VertexFormat::NORMAL:
+                normalMatrix.transformVector(&v);
+                v.normalize();
+                break;
+            case VertexFormat::TANGENT:
+                world.transformVector(&v);
+                v.normalize();
+                if (e.size == 4 && mirrored)
+                    value[3] = -value[3];
+                break;
+            case VertexFormat::BINORMAL:
+                world.transformVector(&v);
+                v.normalize();
+                break;
+            default:
+                break;
+            }
+            value[0] = v.x;
+            value[1] = v.y;
+            value[2] = v.z;
+        }
+    }
+
+    void clear()
+    {
+        _vertexData.clear();
+        _indices.clear();
+        _vertexCount = 0;
+        _empty = true;
+    }
+
+    const VertexFormat& _format;
+    Material* _material;
+    std::vector<unsigned char> _vertexData;
+    std::vector<unsigned short> _indices;
+    unsigned int _vertexCount;
+    BoundingBox _bounds;
+    bool _empty;
+    std::vector<Mesh*> _meshes;
+};
+
+StaticGeometry::StaticGeometry()
+{
+}
+
+unsigned int StaticGeometry::merge(Scene* scene, float cellSize)
+{
+    return merge(scene, cellSize, NULL);
+}
+
+unsigned int StaticGeometry::merge(Scene* scene, float cellSize, const std::map<Material*, std::string>* materialKeys)
+{
+    GP_ASSERT(scene);
+
+    std::vector<Node*> nodes;
+    gatherNodes(scene->getFirstNode(), &nodes);
+
+    // Find the static nodes, and the bounds of their models.
+    std::map<std::string, StaticMesh*> meshes;
+    std::vector<std::pair<Node*, StaticMesh*> > sources;
+    std::vector<Vector3> centers;
+    BoundingBox bounds;
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        if (!isCandidate(nodes[i]))
+            continue;
+
+        // The data of meshes drawn by several nodes is read once.
+        Mesh* mesh = nodes[i]->getModel()->getMesh();
+        std::map<std::string, StaticMesh*>::iterator itr = meshes.find(mesh->getUrl());
+        if (itr == meshes.end())
+        {
+            StaticMesh* staticMesh = NULL;
+            Bundle::MeshData* meshData = Bundle::readMeshData(mesh->getUrl());
+            if (meshData && isMergeable(meshData->vertexFormat) && meshData->parts.size() == mesh->getPartCount())
+            {
+                staticMesh = new StaticMesh(meshData->vertexFormat);
+                staticMesh->vertexCount = meshData->vertexCount;
+                staticMesh->vertexData.assign(meshData->vertexData, meshData->vertexData + meshData->vertexCount * meshData->vertexFormat.getVertexSize());
+                staticMesh->parts.resize(meshData->parts.size());
+                for (size_t j = 0, partCount = meshData->parts.size(); j < partCount; ++j)
+                {
+                    const Bundle::MeshPartData* part = meshData->parts[j];
+                    if (part->primitiveType != Mesh::TRIANGLES)
+                    {
+                        SAFE_DELETE(staticMesh);
+                        break;
+                    }
+                    std::vector<unsigned int>& indices = staticMesh->parts[j];
+                    indices.resize(part->indexCount);
+                    for (unsigned int k = 0; k < part->indexCount; ++k)
+                    {
+                        if (part->indexFormat == Mesh::INDEX8)
+                            indices[k] = ((const unsigned char*)part->indexData)[k];
+                        else if (part->indexFormat == Mesh::INDEX16)
+                            indices[k] = ((const unsigned short*)part->indexData)[k];
+                        else
+                            indices[k] = ((const unsigned int*)part->indexData)[k];
+                    }
+                }
+                if (staticMesh && !isMergeable(staticMesh))
+                    SAFE_DELETE(staticMesh);
+            }
+            SAFE_DELETE(meshData);
+            itr = meshes.insert(std::make_pair(std::string(mesh->getUrl()), staticMesh)).first;
+        }
+        StaticMesh* data = itr->second;
+        if (data == NULL)
+            continue;
+
+        BoundingSphere sphere(nodes[i]->getModel()->getMesh()->getBoundingSphere());
+        sphere.transform(nodes[i]->getWorldMatrix());
+        if (sources.empty())
+            bounds.set(sphere.center, sphere.center);
+        bounds.merge(BoundingBox(sphere.center, sphere.center));
+        sources.push_back(std::make_pair(nodes[i], data));
+        centers.push_back(sphere.center);
+    }
+
+    if (cellSize <= 0.0f)
+    {
+        Vector3 size = bounds.max - bounds.min;
+        cellSize = std::max(std::max(size.x, size.y), size.z) / STATIC_GEOMETRY_DEFAULT_CELLS;
+    }
+
+    // Group the parts by material, vertex format and cell. The node of a model is in the cell of its center.
+    std::vector<VertexFormat> formats;
+    std::map<std::string, StaticGroup> groups;
+    for (size_t i = 0, count = sources.size(); i < count; ++i)
+    {
+        Node* node = sources[i].first;
+        StaticMesh* data = sources[i].second;
+
+        unsigned int format = 0;
+        while (format < formats.size() && formats[format] != data->format)
+            ++format;
+        if (format == formats.size())
+            formats.push_back(data->format);
+
+        int cell[3] = { 0, 0, 0 };
+        if (cellSize > 0.0f)
+        {
+            cell[0] = (int)floor((centers[i].x - bounds.min.x) / cellSize);
+            cell[1] = (int)floor((centers[i].y - bounds.min.y) / cellSize);
+            cell[2] = (int)floor((centers[i].z - bounds.min.z) / cellSize);
+        }
+
+        for (unsigned int j = 0, partCount = node->getModel()->getMeshPartCount(); j < partCount; ++j)
+        {
+            Material* material = node->getModel()->getMaterial(j);
+            std::string key;
+            std::map<Material*, std::string>::const_iterator itr;
+            if (materialKeys && (itr = materialKeys->find(material)) != materialKeys->end())
+            {
+                key = itr->second;
+            }
+            else
+            {
+                char pointer[32];
+                sprintf(pointer, "%p", (void*)material);
+                key = pointer;
+            }
+            char suffix[64];
+            sprintf(suffix, "|%u|%d|%d|%d", format, cell[0], cell[1], cell[2]);
+            key += suffix;
+
+            StaticGroup& group = groups[key];
+            if (group.parts.empty())
+            {
+                group.material = material;
+                group.format = format;
+            }
+            StaticPart part = { node, data, j };
+            group.parts.push_back(part);
+        }
+    }
+
+    // Build the merged meshes first, since the world matrices are read from the nodes.
+    unsigned int nodeCount = 0;
+    std::vector<StaticBatch*> batches;
+    for (std::map<std::string, StaticGroup>::iterator itr = groups.begin(); itr != groups.end(); ++itr)
+    {
+        StaticGroup& group = itr->second;
+        StaticBatch* batch = new StaticBatch(formats[group.format], group.material);
+        for (size_t i = 0, count = group.parts.size(); i < count; ++i)
+        {
+            batch->add(group.parts[i]);
+        }
+        batch->flush();
+        batches.push_back(batch);
+    }
+
+    // Keep the materials while the models of the merged nodes are removed, so that the
+    // first merged model of each material can take it over instead of a copy.
+    std::set<Material*> materials;
+    for (std::map<std::string, StaticGroup>::iterator itr = groups.begin(); itr != groups.end(); ++itr)
+    {
+        if (materials.insert(itr->second.material).second)
+            itr->second.material->addRef();
+    }
+    for (size_t i = 0, count = sources.size(); i < count; ++i)
+    {
+        sources[i].first->setModel(NULL);
+    }
+
+    for (size_t i = 0, count = batches.size(); i < count; ++i)
+    {
+        const std::vector<Mesh*>& meshes = batches[i]->getMeshes();
+        for (size_t j = 0, meshCount = meshes.size(); j < meshCount; ++j)
+        {
+            // A material drawn by other models is copied, since its node bindings point at the node of one model.
+            Material* material = batches[i]->getMaterial();
+            if (material->getRefCount() > 1)
+            {
+                NodeCloneContext context;
+                material = material->clone(context);
+            }
+            else
+            {
+                material->addRef();
+            }
+
+            Model* model = Model::create(meshes[j]);
+            model->setMaterial(material);
+            SAFE_RELEASE(material);
+
+            char id[32];
+            sprintf(id, "staticGeometry%u", nodeCount++);
+            Node* node = scene->addNode(id);
+            node->setModel(model);
+            SAFE_RELEASE(model);
+        }
+        SAFE_DELETE(batches[i]);
+    }
+    for (std::set<Material*>::iterator itr = materials.begin(); itr != materials.end(); ++itr)
+    {
+        Material* material = *itr;
+        SAFE_RELEASE(material);
+    }
+    for (std::map<std::string, StaticMesh*>::iterator itr = meshes.begin(); itr != meshes.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second);
+    }
+
+    return (unsigned int)sources.size();
+}
+
+}
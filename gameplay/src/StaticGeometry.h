@@ -0,0 +1,85 @@
+#ifndef STATICGEOMETRY_H_
+#define STATICGEOMETRY_H_
+
+namespace gameplay
+{
+
+class Scene;
+class Material;
+
+/**
+ * Defines a helper that merges the models of static nodes into a few larger meshes,
+ * so that scenery made of many small pieces is drawn with few draw calls.
+ *
+ * Like a MeshBatch, the mesh parts that share a material and a vertex format are
+ * concatenated into the vertex and index buffers of one mesh, with their vertices
+ * transformed into world space. Unlike a MeshBatch, this is done once, when the scene
+ * is loaded, and the merged meshes are static. The parts are also split by a grid of
+ * cells, with a merged mesh per cell, so that the merged geometry is still culled
+ * against the view frustum a cell at a time.
+ *
+ * A node is merged when it has a static collision object (see Node::isStatic) and a model
+ * loaded from a bundle whose mesh parts are indexed triangle lists, that has a material
+ * for every part and no skin or levels of detail. The positions, normals, tangents and
+ * binormals must be floats. The model of each merged node is removed, and the merged
+ * models are drawn by new nodes added to the root of the scene, while the original
+ * nodes keep their collision objects, tags and children. Merged nodes should therefore
+ * not be moved, hidden or given another material afterward.
+ *
+ * Merging is enabled in .scene files with the mergeStatic property, where mesh parts
+ * merge when their materials are loaded from the same url:
+ * @code
+   scene
+   {
+       path = res/level.gpb
+       mergeStatic = true
+       mergeCellSize = 50
+       ...
+   }
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class StaticGeometry
+{
+    friend class SceneLoader;
+
+public:
+
+    /**
+     * Merges the models of the static nodes of a scene.
+     *
+     * Mesh parts merge when they share the same material object. The merged meshes
+     * have 16-bit indices, so a cell with more vertices is split into several meshes.
+     *
+     * @param scene The scene to merge the static nodes of.
+     * @param cellSize The size of the cells of the grid the merged geometry is split by,
+     *      or 0 to split the bounds of the static geometry into 8 cells along its longest side.
+     *
+     * @return The number of nodes whose models were merged.
+     */
+    static unsigned int merge(Scene* scene, float cellSize = 0.0f);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    StaticGeometry();
+
+    /**
+     * Merges the models of the static nodes of a scene, with a key for each material.
+     *
+     * @param scene The scene to merge the static nodes of.
+     * @param cellSize The size of the cells of the grid, or 0 to compute it.
+     * @param materialKeys The key of each material, so that the parts of different materials
+     *      with the same key merge (with the first of those materials), or NULL.
+     *
+     * @return The number of nodes whose models were merged.
+     */
+    static unsigned int merge(Scene* scene, float cellSize, const std::map<Material*, std::string>* materialKeys);
+};
+
+}
+
+#endif
@@ -155,6 +155,17 @@ public:
      */
     virtual bool rewind() = 0;
 
+    /**
+     * Returns a pointer to the contents of the stream if the stream is mapped into memory.
+     *
+     * The pointer remains valid until the stream is closed.
+     *
+     * @return A pointer to the start of the stream, or NULL if the stream is not memory-mapped.
+     *
+     * @see FileSystem::MAPPED
+     */
+    virtual const void* getBuffer() { return NULL; }
+
 protected:
     Stream() {};
 private:
@@ -7,7 +7,7 @@ namespace gameplay
 {
 
 Technique::Technique(const char* id, Material* material)
-    : _id(id ? id : ""), _material(material)
+    : _id(id ? id : ""), _material(material), _quality(0)
 {
     RenderState::_parent = material;
 }
@@ -53,6 +53,11 @@ Pass* Technique::getPass(const char* id) const
     return NULL;
 }
 
+unsigned int Technique::getQuality() const
+{
+    return _quality;
+}
+
 void Technique::setNodeBinding(Node* node)
 {
     RenderState::setNodeBinding(node);
@@ -66,6 +71,7 @@ void Technique::setNodeBinding(Node* node)
 Technique* Technique::clone(Material* material, NodeCloneContext &context) const
 {
     Technique* technique = new Technique(getId(), material);
+    technique->_quality = _quality;
     for (std::vector<Pass*>::const_iterator it = _passes.begin(); it != _passes.end(); ++it)
     {
         Pass* pass = *it;
@@ -55,6 +55,18 @@ public:
      */
     Pass* getPass(const char* id) const;
 
+    /**
+     * Gets the quality tier of this technique, which is its relative cost.
+     *
+     * The tier is set by the "quality" property of the technique in a material file.
+     * Tier 0 is the cheapest, and the default.
+     *
+     * @return The quality tier of this technique.
+     *
+     * @see Material::setQualityLevel
+     */
+    unsigned int getQuality() const;
+
     /**
      * @see RenderState::setNodeBinding
      */
@@ -87,6 +99,7 @@ private:
     std::string _id;
     Material* _material;
     std::vector<Pass*> _passes;
+    unsigned int _quality;
 };
 
 }
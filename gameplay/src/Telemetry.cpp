@@ -0,0 +1,434 @@
+#include "Base.h"
+#include "Telemetry.h"
+#include "Game.h"
+#include "Profiler.h"
+#include "GraphicsMemory.h"
+#include "Properties.h"
+#include "ScriptController.h"
+#include "Thread.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+// The version of the stream, which must change with the layout of its records.
+#define TELEMETRY_VERSION 1
+
+// The port the viewer listens on, by default.
+#define TELEMETRY_DEFAULT_PORT 7150
+
+// The number of bytes that can be queued while the viewer does not keep up, after which records are dropped.
+#define TELEMETRY_MAX_QUEUED (256 * 1024)
+
+// The delay (in milliseconds) between attempts to connect to the viewer.
+#define TELEMETRY_RETRY_INTERVAL 1000
+
+// The delay (in milliseconds) between checks for a stop while waiting to connect again.
+#define TELEMETRY_POLL_INTERVAL 50
+
+#ifdef WIN32
+typedef SOCKET TelemetrySocket;
+#define TELEMETRY_INVALID_SOCKET INVALID_SOCKET
+#define TELEMETRY_CLOSE_SOCKET closesocket
+#else
+typedef int TelemetrySocket;
+#define TELEMETRY_INVALID_SOCKET -1
+#define TELEMETRY_CLOSE_SOCKET close
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define TELEMETRY_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define TELEMETRY_SEND_FLAGS 0
+#endif
+
+namespace gameplay
+{
+
+static Thread* __sendThread = NULL;
+static Mutex __mutex;
+static Condition __condition;
+static volatile bool __running = false;
+static volatile bool __connected = false;
+static unsigned int __generation = 0;
+static std::vector<unsigned char> __queued;
+static std::vector<unsigned char> __sending;
+static std::string __host;
+static unsigned short __port = TELEMETRY_DEFAULT_PORT;
+static Telemetry::Mode __mode = Telemetry::MODE_SAMPLED;
+static unsigned int __sampleInterval = 30;
+static unsigned int __dropped = 0;
+
+// The state of the game thread.
+static std::vector<unsigned char> __record;
+static unsigned int __writtenGeneration = 0;
+static unsigned int __frameIndex = 0;
+static double __lastFrameTime = 0.0;
+static std::map<const char*, unsigned int> __nameIndices;
+static std::vector<const char*> __names;
+static unsigned int __namesSent = 0;
+
+static void writeU8(std::vector<unsigned char>& out, unsigned int value)
+{
+    out.push_back((unsigned char)value);
+}
+
+static void writeU16(std::vector<unsigned char>& out, unsigned int value)
+{
+    out.push_back((unsigned char)value);
+    out.push_back((unsigned char)(value >> 8));
+}
+
+static void writeU32(std::vector<unsigned char>& out, unsigned int value)
+{
+    out.push_back((unsigned char)value);
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 24));
+}
+
+static void writeFloat(std::vector<unsigned char>& out, float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeU32(out, bits);
+}
+
+static TelemetrySocket connectTo(const char* host, unsigned short port)
+{
+    char service[8];
+    sprintf(service, "%u", (unsigned int)port);
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* addresses = NULL;
+    if (getaddrinfo(host, service, &hints, &addresses) != 0 || addresses == NULL)
+        return TELEMETRY_INVALID_SOCKET;
+
+    TelemetrySocket s = TELEMETRY_INVALID_SOCKET;
+    for (addrinfo* address = addresses; address != NULL; address = address->ai_next)
+    {
+        s = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (s == TELEMETRY_INVALID_SOCKET)
+            continue;
+        if (connect(s, address->ai_addr, (int)address->ai_addrlen) == 0)
+            break;
+        TELEMETRY_CLOSE_SOCKET(s);
+        s = TELEMETRY_INVALID_SOCKET;
+    }
+    freeaddrinfo(addresses);
+
+    if (s != TELEMETRY_INVALID_SOCKET)
+    {
+        // The records are small and sent as they come, so they must not wait to be coalesced.
+        int option = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&option, sizeof(option));
+#ifdef SO_NOSIGPIPE
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&option, sizeof(option));
+#endif
+    }
+    return s;
+}
+
+static bool sendAll(TelemetrySocket s, const unsigned char* data, size_t size)
+{
+    while (size > 0)
+    {
+        int sent = (int)send(s, (const char*)data, (int)size, TELEMETRY_SEND_FLAGS);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static unsigned int internName(const char* name)
+{
+    std::map<const char*, unsigned int>::iterator itr = __nameIndices.find(name);
+    if (itr != __nameIndices.end())
+        return itr->second;
+
+    unsigned int index = (unsigned int)__names.size();
+    __nameIndices[name] = index;
+    __names.push_back(name);
+    return index;
+}
+
+bool Telemetry::start(const char* host, unsigned short port, Mode mode, unsigned int sampleInterval)
+{
+    GP_ASSERT(host);
+
+    stop();
+
+#ifdef WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        GP_WARN("Failed to start Windows Sockets for telemetry.");
+        return false;
+    }
+#endif
+
+    __host = host;
+    __port = port;
+    __mode = mode;
+    __sampleInterval = std::max(sampleInterval, 1u);
+    __dropped = 0;
+    __connected = false;
+    __queued.clear();
+    __frameIndex = 0;
+    __lastFrameTime = Game::getAbsoluteTime();
+
+    __running = true;
+    __sendThread = Thread::create(sendThread, NULL);
+    if (__sendThread == NULL)
+    {
+        __running = false;
+#ifdef WIN32
+        WSACleanup();
+#endif
+        GP_WARN("Failed to start the thread of telemetry.");
+        return false;
+    }
+    return true;
+}
+
+void Telemetry::stop()
+{
+    if (__sendThread == NULL)
+        return;
+
+    __mutex.lock();
+    __running = false;
+    __condition.broadcast();
+    __mutex.unlock();
+    __sendThread->join();
+    SAFE_DELETE(__sendThread);
+    __connected = false;
+
+#ifdef WIN32
+    WSACleanup();
+#endif
+}
+
+bool Telemetry::isStarted()
+{
+    return __sendThread != NULL;
+}
+
+bool Telemetry::isConnected()
+{
+    return __connected;
+}
+
+Telemetry::Mode Telemetry::getMode()
+{
+    return __mode;
+}
+
+unsigned int Telemetry::getDroppedCount()
+{
+    return __dropped;
+}
+
+void Telemetry::configure(Properties* properties)
+{
+    Properties* telemetry = properties ? properties->getNamespace("telemetry", true) : NULL;
+    if (!telemetry || !telemetry->exists("host"))
+        return;
+
+    int port = telemetry->exists("port") ? telemetry->getInt("port") : TELEMETRY_DEFAULT_PORT;
+    const char* mode = telemetry->getString("mode");
+    int sampleInterval = telemetry->exists("sampleInterval") ? telemetry->getInt("sampleInterval") : 30;
+    start(telemetry->getString("host"), (unsigned short)port, mode && strcmp(mode, "full") == 0 ? MODE_FULL : MODE_SAMPLED,
+        (unsigned int)std::max(sampleInterval, 1));
+}
+
+void Telemetry::endFrame()
+{
+    if (__sendThread == NULL)
+        return;
+
+    double time = Game::getAbsoluteTime();
+    float frameTime = (float)(time - __lastFrameTime);
+    __lastFrameTime = time;
+    unsigned int frame = __frameIndex++;
+
+    Mutex::Lock lock(__mutex);
+    if (!__connected)
+    {
+        ++__dropped;
+        return;
+    }
+
+    // A new connection starts with the header, and needs the names again.
+    __record.clear();
+    if (__writtenGeneration != __generation)
+    {
+        __record.push_back('G');
+        __record.push_back('P');
+        __record.push_back('T');
+        __record.push_back('M');
+        writeU16(__record, TELEMETRY_VERSION);
+        writeU16(__record, __mode);
+    }
+
+    writeU8(__record, RECORD_FRAME);
+    writeU32(__record, frame);
+    writeFloat(__record, frameTime);
+    if (__mode == MODE_FULL || frame % __sampleInterval == 0)
+    {
+        writeCounters(frame);
+    }
+    unsigned int namesSent = __writtenGeneration != __generation ? 0 : __namesSent;
+    if (__mode == MODE_FULL)
+    {
+        writeBlocks(frame, namesSent);
+    }
+
+    if (__queued.size() + __record.size() > TELEMETRY_MAX_QUEUED)
+    {
+        ++__dropped;
+        return;
+    }
+    __queued.insert(__queued.end(), __record.begin(), __record.end());
+    __writtenGeneration = __generation;
+    __namesSent = (unsigned int)__names.size();
+    __condition.signal();
+}
+
+void Telemetry::writeCounters(unsigned int frame)
+{
+    const Game::RenderStats& stats = Game::getInstance()->getRenderStats();
+    writeU8(__record, RECORD_COUNTERS);
+    writeU32(__record, frame);
+    writeFloat(__record, stats.gpuTime);
+    writeU32(__record, stats.drawCalls);
+    writeU32(__record, stats.triangles);
+    writeU32(__record, stats.programBinds);
+    writeU32(__record, stats.textureBinds);
+    writeU32(__record, stats.redundantBinds);
+    writeU32(__record, stats.bufferUploads);
+    writeU32(__record, stats.bufferUploadSize);
+    writeU8(__record, GraphicsMemory::CATEGORY_COUNT);
+    for (unsigned int i = 0; i < GraphicsMemory::CATEGORY_COUNT; ++i)
+    {
+        writeU32(__record, GraphicsMemory::getUsage((GraphicsMemory::Category)i));
+    }
+    ScriptController* scriptController = Game::getInstance()->getScriptController();
+    writeU32(__record, scriptController ? scriptController->getMemoryUsage() : 0);
+    writeU32(__record, scriptController ? scriptController->getCollectedBytes() : 0);
+}
+
+void Telemetry::writeBlocks(unsigned int frame, unsigned int namesSent)
+{
+    unsigned int count = std::min(Profiler::getFrameBlockCount(), 0xFFFFu);
+    if (count == 0)
+        return;
+
+    // Name the blocks first, since the names of a frame must come before the frame.
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        internName(Profiler::getFrameBlock(i, NULL, NULL, NULL));
+    }
+    for (unsigned int i = namesSent, nameCount = std::min((unsigned int)__names.size(), 0x10000u); i < nameCount; ++i)
+    {
+        size_t length = std::min(strlen(__names[i]), (size_t)255);
+        writeU8(__record, RECORD_NAME);
+        writeU16(__record, i);
+        writeU8(__record, (unsigned int)length);
+        __record.insert(__record.end(), __names[i], __names[i] + length);
+    }
+
+    writeU8(__record, RECORD_BLOCKS);
+    writeU32(__record, frame);
+    writeU16(__record, count);
+    double frameStart = 0.0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int depth;
+        double start, end;
+        const char* name = Profiler::getFrameBlock(i, &depth, &start, &end);
+        if (i == 0)
+            frameStart = start;
+        writeU16(__record, std::min(__nameIndices[name], 0xFFFFu));
+        writeU8(__record, std::min(depth, 255u));
+        writeFloat(__record, (float)(start - frameStart));
+        writeFloat(__record, (float)(end - start));
+    }
+}
+
+int Telemetry::sendThread(void* arg)
+{
+    TelemetrySocket s = TELEMETRY_INVALID_SOCKET;
+    while (__running)
+    {
+        if (s == TELEMETRY_INVALID_SOCKET)
+        {
+            s = connectTo(__host.c_str(), __port);
+            if (s == TELEMETRY_INVALID_SOCKET)
+            {
+                for (unsigned int waited = 0; waited < TELEMETRY_RETRY_INTERVAL && __running; waited += TELEMETRY_POLL_INTERVAL)
+                {
+                    Thread::sleep(TELEMETRY_POLL_INTERVAL);
+                }
+                continue;
+            }
+
+            Mutex::Lock lock(__mutex);
+            __queued.clear();
+            ++__generation;
+            __connected = true;
+        }
+
+        __mutex.lock();
+        while (__running && __queued.empty())
+        {
+            __condition.wait(__mutex);
+        }
+        __sending.swap(__queued);
+        __mutex.unlock();
+
+        // Send outside of the lock, so that the game thread never waits on the network.
+        if (!__sending.empty() && !sendAll(s, &__sending[0], __sending.size()))
+        {
+            TELEMETRY_CLOSE_SOCKET(s);
+            s = TELEMETRY_INVALID_SOCKET;
+            __mutex.lock();
+            __connected = false;
+            __mutex.unlock();
+        }
+        __sending.clear();
+    }
+
+    if (s != TELEMETRY_INVALID_SOCKET)
+    {
+        // Send what the game queued before it stopped.
+        __mutex.lock();
+        __sending.swap(__queued);
+        __connected = false;
+        __mutex.unlock();
+        if (!__sending.empty())
+            sendAll(s, &__sending[0], __sending.size());
+        __sending.clear();
+        TELEMETRY_CLOSE_SOCKET(s);
+    }
+    return 0;
+}
+
+}
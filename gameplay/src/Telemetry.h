@@ -0,0 +1,165 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+namespace gameplay
+{
+
+class Properties;
+
+/**
+ * Defines a stream of the performance counters of the game to a viewer over a TCP connection.
+ *
+ * Once started, the game connects to a viewer listening at a host and port, and sends it a
+ * compact binary record at the end of every frame, so that devices can be profiled from a
+ * desktop without an overlay on their screen, and a farm of test devices can report their frame
+ * times to one collector. The records are queued on the game thread and sent by a thread of
+ * their own, so a slow network never stalls a frame: while the viewer cannot keep up (or is not
+ * connected), records are dropped and counted instead of queued without bounds. The game keeps
+ * trying to connect, once per second, until telemetry is stopped.
+ *
+ * In the sampled mode, each frame only costs a record of its time, and the counters (GPU time,
+ * draw calls, triangles, binds, uploads, graphics memory and Lua memory) are sampled every few
+ * frames. This is cheap enough to leave on in test builds, and still gives the time of every
+ * frame for percentiles. The full mode also sends the counters of every frame and the timed
+ * blocks of the Profiler, which are only recorded in builds with GP_USE_PROFILER.
+ *
+ * Telemetry can be started from the "telemetry" section of game.config:
+ * @code
+   telemetry
+   {
+       host = 192.168.1.10
+       port = 7150
+       mode = sampled
+       sampleInterval = 30
+   }
+ * @endcode
+ *
+ * The stream starts with the 4 bytes "GPTM", followed by a 16-bit version and a 16-bit mode,
+ * and then holds records that start with a byte of their type. All values are little-endian:
+ * - RECORD_FRAME: the 32-bit frame index and the frame time in milliseconds (a 32-bit float).
+ * - RECORD_COUNTERS: the 32-bit frame index, the GPU time in milliseconds (a float, -1 if unknown),
+ *   then 32-bit draw calls, triangles, program binds, texture binds, redundant binds, buffer
+ *   uploads and bytes uploaded, a byte of the count of graphics memory categories followed by
+ *   the 32-bit bytes of each, and the 32-bit bytes used and collected by Lua.
+ * - RECORD_NAME: a 16-bit name index, a byte of length and the characters of the name. Names are
+ *   sent once per connection, before the first record that uses them.
+ * - RECORD_BLOCKS: the 32-bit frame index, a 16-bit count of blocks, then for each block its
+ *   16-bit name index, a byte of its depth, and its start (from the start of the frame) and its
+ *   duration in milliseconds as floats.
+ *
+ * Telemetry must only be started, stopped and fed from the game thread.
+ *
+ * @script{ignore}
+ */
+class Telemetry
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines what is sent for each frame.
+     */
+    enum Mode
+    {
+        /** The time of every frame, and the counters sampled every few frames. */
+        MODE_SAMPLED,
+        /** The time, the counters and the timed blocks of every frame. */
+        MODE_FULL
+    };
+
+    /**
+     * Defines the types of the records of the stream.
+     */
+    enum RecordType
+    {
+        RECORD_FRAME = 1,
+        RECORD_COUNTERS = 2,
+        RECORD_NAME = 3,
+        RECORD_BLOCKS = 4
+    };
+
+    /**
+     * Starts streaming to a viewer, stopping any stream already started.
+     *
+     * This returns without waiting for the connection, which is made by the thread of the stream.
+     *
+     * @param host The host name or IPv4 address of the viewer.
+     * @param port The TCP port the viewer listens on.
+     * @param mode What is sent for each frame.
+     * @param sampleInterval The number of frames between samples of the counters in the sampled mode.
+     *
+     * @return true if the stream was started, false if the thread of the stream could not be started.
+     */
+    static bool start(const char* host, unsigned short port, Mode mode = MODE_SAMPLED, unsigned int sampleInterval = 30);
+
+    /**
+     * Stops streaming, sending the records still queued if the viewer is connected.
+     */
+    static void stop();
+
+    /**
+     * Determines if telemetry is started.
+     *
+     * @return true if telemetry is started, even if the viewer is not connected yet.
+     */
+    static bool isStarted();
+
+    /**
+     * Determines if the viewer is connected.
+     *
+     * @return true if the records are being sent.
+     */
+    static bool isConnected();
+
+    /**
+     * Returns the mode of the stream.
+     *
+     * @return The mode.
+     */
+    static Mode getMode();
+
+    /**
+     * Returns the number of frames whose records were dropped since telemetry was started,
+     * because the viewer was not connected or could not keep up.
+     *
+     * @return The number of dropped frames.
+     */
+    static unsigned int getDroppedCount();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Telemetry();
+
+    /**
+     * Starts streaming as configured by game.config. Called by the game at startup.
+     */
+    static void configure(Properties* properties);
+
+    /**
+     * Queues the records of the frame that ended. Called by the game at the end of each frame.
+     */
+    static void endFrame();
+
+    /**
+     * Queues the counters of the frame that ended.
+     */
+    static void writeCounters(unsigned int frame);
+
+    /**
+     * Queues the timed blocks of the frame that ended, after the names from namesSent on.
+     */
+    static void writeBlocks(unsigned int frame, unsigned int namesSent);
+
+    /**
+     * Connects to the viewer and sends the queued records until telemetry is stopped.
+     */
+    static int sendThread(void* arg);
+};
+
+}
+
+#endif
@@ -2,7 +2,11 @@
 #include "Terrain.h"
 #include "TerrainPatch.h"
 #include "Node.h"
+#include "Scene.h"
+#include "Game.h"
 #include "FileSystem.h"
+#include "FrameBuffer.h"
+#include "CommandBuffer.h"
 
 namespace gameplay
 {
@@ -24,11 +28,15 @@ static const float DEFAULT_TERRAIN_HEIGHT_RATIO = 0.3f;
 
 // Terrain dirty flags
 static const unsigned int DIRTY_FLAG_INVERSE_WORLD = 1;
+static const unsigned int DIRTY_FLAG_QUADTREE_BOUNDS = 2;
+static const unsigned int DIRTY_FLAG_COMPOSITE = 4;
 
 static float getDefaultHeight(unsigned int width, unsigned int height);
 
 Terrain::Terrain() :
-    _heightfield(NULL), _node(NULL), _normalMap(NULL), _flags(FRUSTUM_CULLING | LEVEL_OF_DETAIL), _dirtyFlags(DIRTY_FLAG_INVERSE_WORLD)
+    _heightfield(NULL), _node(NULL), _normalMap(NULL), _flags(FRUSTUM_CULLING | LEVEL_OF_DETAIL),
+    _dirtyFlags(DIRTY_FLAG_INVERSE_WORLD | DIRTY_FLAG_QUADTREE_BOUNDS), _levelCount(1), _morphDistance(0.0f),
+    _compositeSize(0), _compositeLevel(0), _compositeMap(NULL)
 {
 }
 
@@ -38,6 +46,7 @@ Terrain::~Terrain()
     {
         SAFE_DELETE(_patches[i]);
     }
+    clearComposite();
     SAFE_RELEASE(_normalMap);
     SAFE_RELEASE(_heightfield);
 }
@@ -58,13 +67,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
     Properties* p = properties;
     Properties* pTerrain = NULL;
     bool externalProperties = (p != NULL);
-    HeightField* heightfield = NULL;
-    Vector3 terrainSize;
-    int patchSize = 0;
-    int detailLevels = 1;
-    float skirtScale = 0;
-    const char* normalMap = NULL;
-    std::string materialPath;
 
     if (!p && path)
     {
@@ -86,6 +88,25 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         return NULL;
     }
 
+    Terrain* terrain = NULL;
+    HeightField* heightfield = loadHeightField(pTerrain, path);
+    if (heightfield)
+    {
+        terrain = create(heightfield, pTerrain, path);
+    }
+
+    if (!externalProperties)
+        SAFE_DELETE(p);
+
+    return terrain;
+}
+
+HeightField* Terrain::loadHeightField(Properties* pTerrain, const char* path)
+{
+    GP_ASSERT(pTerrain);
+
+    HeightField* heightfield = NULL;
+
     // Read heightmap info
     Properties* pHeightmap = pTerrain->getNamespace("heightmap", true);
     if (pHeightmap)
@@ -95,8 +116,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         if (!pHeightmap->getPath("path", &heightmap))
         {
             GP_WARN("No 'path' property supplied in heightmap section of terrain definition: %s", path);
-            if (!externalProperties)
-                SAFE_DELETE(p);
             return NULL;
         }
 
@@ -113,8 +132,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
             if (!pHeightmap->getVector2("size", &imageSize))
             {
                 GP_WARN("Invalid or missing 'size' attribute in heightmap defintion of terrain definition: %s", path);
-                if (!externalProperties)
-                    SAFE_DELETE(p);
                 return NULL;
             }
 
@@ -125,8 +142,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         {
             // Unsupported heightmap format
             GP_WARN("Unsupported heightmap format ('%s') in terrain definition: %s", heightmap.c_str(), path);
-            if (!externalProperties)
-                SAFE_DELETE(p);
             return NULL;
         }
     }
@@ -137,8 +152,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         if (!pTerrain->getPath("heightmap", &heightmap))
         {
             GP_WARN("No 'heightmap' property supplied in terrain definition: %s", path);
-            if (!externalProperties)
-                SAFE_DELETE(p);
             return NULL;
         }
 
@@ -151,19 +164,35 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         else if (ext == ".RAW" || ext == ".R16")
         {
             GP_WARN("RAW heightmaps must be specified inside a heightmap block with width and height properties.");
-            if (!externalProperties)
-                SAFE_DELETE(p);
             return NULL;
         }
         else
         {
             GP_WARN("Unsupported 'heightmap' format ('%s') in terrain definition: %s.", heightmap.c_str(), path);
-            if (!externalProperties)
-                SAFE_DELETE(p);
             return NULL;
         }
     }
 
+    if (heightfield == NULL)
+    {
+        GP_WARN("Failed to read heightfield heights for terrain definition: %s", path);
+    }
+
+    return heightfield;
+}
+
+Terrain* Terrain::create(HeightField* heightfield, Properties* pTerrain, const char* path)
+{
+    GP_ASSERT(heightfield);
+    GP_ASSERT(pTerrain);
+
+    Vector3 terrainSize;
+    int patchSize = 0;
+    int detailLevels = 1;
+    float skirtScale = 0;
+    const char* normalMap = NULL;
+    std::string materialPath;
+
     // Read terrain 'size'
     if (pTerrain->exists("size"))
     {
@@ -197,14 +226,6 @@ Terrain* Terrain::create(const char* path, Properties* properties)
     // Read 'material'
     materialPath = pTerrain->getString("material", "");
 
-    if (heightfield == NULL)
-    {
-        GP_WARN("Failed to read heightfield heights for terrain definition: %s", path);
-        if (!externalProperties)
-            SAFE_DELETE(p);
-        return NULL;
-    }
-
     if (terrainSize.isZero())
     {
         terrainSize.set(heightfield->getColumnCount(), getDefaultHeight(heightfield->getColumnCount(), heightfield->getRowCount()), heightfield->getRowCount());
@@ -225,12 +246,7 @@ Terrain* Terrain::create(const char* path, Properties* properties)
     Vector3 scale(terrainSize.x / (heightfield->getColumnCount()-1), terrainSize.y, terrainSize.z / (heightfield->getRowCount()-1));
 
     // Create terrain
-    Terrain* terrain = create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, materialPath.c_str(), pTerrain);
-
-    if (!externalProperties)
-        SAFE_DELETE(p);
-
-    return terrain;
+    return create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, materialPath.c_str(), pTerrain);
 }
 
 Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigned int patchSize, unsigned int detailLevels, float skirtScale, const char* normalMapPath, const char* materialPath)
@@ -243,6 +259,7 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
     const char* normalMapPath, const char* materialPath, Properties* properties)
 {
     GP_ASSERT(heightfield);
+    GP_ASSERT(heightfield->getArray());
 
     unsigned int width = heightfield->getColumnCount();
     unsigned int height = heightfield->getRowCount();
@@ -269,6 +286,11 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
     // level detail terrain patch.
     unsigned int maxStep = (unsigned int)std::pow(2.0, (double)(detailLevels-1));
 
+    // Geomorphing terrains blend between levels in the vertex shader instead of hiding cracks with skirts.
+    bool morph = properties && detailLevels > 1 && properties->getBool("geomorphing");
+    if (morph)
+        skirtScale = 0.0f;
+
     // Create terrain patches
     unsigned int x1, x2, z1, z2;
     unsigned int row = 0, column = 0;
@@ -283,7 +305,7 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
             x2 = std::min(x1 + patchSize, width-1);
 
             // Create this patch
-            TerrainPatch* patch = TerrainPatch::create(terrain, terrain->_patches.size(), row, column, heightfield->getArray(), width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale);
+            TerrainPatch* patch = TerrainPatch::create(terrain, terrain->_patches.size(), row, column, heightfield->getArray(), width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale, morph);
             terrain->_patches.push_back(patch);
 
             // Append the new patch's local bounds to the terrain local bounds
@@ -291,6 +313,27 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
         }
     }
 
+    // The patches no longer need the float heights, so they can be stored compactly for height queries.
+    if (properties && properties->getBool("quantizeHeights"))
+    {
+        heightfield->quantize();
+    }
+
+    // Use at least twice the diagonal of a patch as the level 0 distance, so that neighboring
+    // patches are at most one level apart and both draw the same geometry along their edges.
+    if (morph && terrain->_patches.size() > 0)
+    {
+        const BoundingBox& patchBounds = terrain->_patches[0]->getBoundingBox(false);
+        float minDistance = patchBounds.min.distance(patchBounds.max) * 2.0f;
+        terrain->_morphDistance = std::max(properties->getFloat("morphDistance"), minDistance);
+    }
+
+    // Organize the patches in a quadtree for hierarchical culling and level of detail selection
+    unsigned int columns = (width - 2) / patchSize + 1;
+    terrain->_levelCount = detailLevels;
+    terrain->_quadTree.reserve(terrain->_patches.size() * 2);
+    terrain->buildQuadTree(0, 0, row, columns, columns);
+
     // Read additional layer information from properties (if specified)
     if (properties)
     {
@@ -361,6 +404,10 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
                     GP_WARN("Failed to load terrain layer: %s", textureMap.c_str());
                 }
             }
+            else if (strcmp(lp->getNamespace(), "composite") == 0)
+            {
+                terrain->setComposite((unsigned int)lp->getInt("size"), (unsigned int)lp->getInt("level"));
+            }
         }
     }
 
@@ -392,14 +439,28 @@ void Terrain::setNode(Node* node)
         {
             _patches[i]->updateNodeBindings();
         }
+        for (size_t i = 0, count = _compositeMaterials.size(); i < count; ++i)
+        {
+            _compositeMaterials[i]->setNodeBinding(_node);
+        }
 
-        _dirtyFlags |= DIRTY_FLAG_INVERSE_WORLD;
+        _dirtyFlags |= DIRTY_FLAG_INVERSE_WORLD | DIRTY_FLAG_QUADTREE_BOUNDS;
+        for (size_t i = 0, count = _patches.size(); i < count; ++i)
+        {
+            _patches[i]->setBoundsDirty();
+        }
     }
 }
 
 void Terrain::transformChanged(Transform* transform, long cookie)
 {
-    _dirtyFlags |= DIRTY_FLAG_INVERSE_WORLD;
+    _dirtyFlags |= DIRTY_FLAG_INVERSE_WORLD | DIRTY_FLAG_QUADTREE_BOUNDS;
+
+    // Patches compute their world bounds lazily
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    {
+        _patches[i]->setBoundsDirty();
+    }
 }
 
 const Matrix& Terrain::getInverseWorldMatrix() const
@@ -439,6 +500,9 @@ bool Terrain::setLayer(int index, const char* texturePath, const Vector2& textur
         }
     }
 
+    if (_compositeSize > 0)
+        _dirtyFlags |= DIRTY_FLAG_COMPOSITE;
+
     return result;
 }
 
@@ -531,12 +595,313 @@ float Terrain::getHeight(float x, float z) const
 
 unsigned int Terrain::draw(bool wireframe)
 {
-    size_t visibleCount = 0;
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (!camera || _quadTree.empty())
+        return 0;
+
+    if (_dirtyFlags & DIRTY_FLAG_QUADTREE_BOUNDS)
+    {
+        _dirtyFlags &= ~DIRTY_FLAG_QUADTREE_BOUNDS;
+        updateQuadTreeBounds(0);
+    }
+
+    // The composite is baked with immediate draws, so it waits for a frame that is not recorded.
+    if ((_dirtyFlags & DIRTY_FLAG_COMPOSITE) && !CommandBuffer::getRecording())
+    {
+        _dirtyFlags &= ~DIRTY_FLAG_COMPOSITE;
+        bakeComposite();
+    }
+
+    // Regions hidden behind the depth of a previous frame are skipped with the frustum culling.
+    DepthPyramid* depthPyramid = isFlagSet(FRUSTUM_CULLING) ? scene->getDepthPyramid() : NULL;
+    if (depthPyramid)
+        depthPyramid->resolve();
+
+    return drawQuadTree(0, camera, wireframe, isFlagSet(FRUSTUM_CULLING), -1, depthPyramid);
+}
+
+void Terrain::setComposite(unsigned int size, unsigned int level)
+{
+    if ((size & (size - 1)) != 0)
+    {
+        GP_WARN("Terrain composite size must be a power of two: %u", size);
+        return;
+    }
+
+    clearComposite();
+    _compositeSize = size;
+    _compositeLevel = level;
+    if (size > 0)
+        _dirtyFlags |= DIRTY_FLAG_COMPOSITE;
+    else
+        _dirtyFlags &= ~DIRTY_FLAG_COMPOSITE;
+}
+
+void Terrain::bakeComposite()
+{
+    clearComposite();
+    if (_compositeLevel >= _levelCount)
+    {
+        GP_WARN("Terrain composite level %u is not a level of detail of the terrain.", _compositeLevel);
+        return;
+    }
+
+    FrameBuffer* frameBuffer = FrameBuffer::create("terrainComposite", _compositeSize, _compositeSize);
+    if (!frameBuffer)
+    {
+        GP_WARN("Failed to create the terrain composite frame buffer.");
+        return;
+    }
+
+    // Draw each patch over its region of the composite, with its layers blended and without lighting.
+    Game* game = Game::getInstance();
+    Rectangle viewport = game->getViewport();
+    FrameBuffer* previous = frameBuffer->bind();
+    game->setViewport(Rectangle((float)_compositeSize, (float)_compositeSize));
+    game->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0f, 0);
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    {
+        _patches[i]->bakeComposite();
+    }
+    previous->bind();
+    game->setViewport(viewport);
+
+    Texture* texture = frameBuffer->getRenderTarget()->getTexture();
+    GP_ASSERT(texture);
+    texture->generateMipmaps();
+    _compositeMap = Texture::Sampler::create(texture);
+    _compositeMap->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    _compositeMap->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    SAFE_RELEASE(frameBuffer);
+
+    // The patches drawn at each composite level share one material.
+    for (unsigned int level = _compositeLevel; level < _levelCount; ++level)
+    {
+        Material* material = Material::create(_materialPath.c_str(), &compositePassCallback, this);
+        if (!material)
+        {
+            GP_WARN("Failed to load composite material for terrain: %s", _materialPath.c_str());
+            clearComposite();
+            return;
+        }
+        material->getParameter("u_compositeMap")->setValue(_compositeMap);
+        if (_morphDistance > 0.0f)
+        {
+            material->setParameterAutoBinding("u_worldViewMatrix", RenderState::WORLD_VIEW_MATRIX);
+            material->getParameter("u_morph")->setValue(getMorphRange(level));
+        }
+        material->setNodeBinding(_node);
+        _compositeMaterials.push_back(material);
+    }
+}
+
+void Terrain::clearComposite()
+{
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
     {
-        visibleCount += _patches[i]->draw(wireframe);
+        _patches[i]->clearCompositeBindings();
+    }
+    for (size_t i = 0, count = _compositeMaterials.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_compositeMaterials[i]);
+    }
+    _compositeMaterials.clear();
+    SAFE_RELEASE(_compositeMap);
+}
+
+Material* Terrain::getCompositeMaterial(unsigned int level) const
+{
+    if (level < _compositeLevel || level - _compositeLevel >= _compositeMaterials.size() || isFlagSet(DEBUG_PATCHES))
+        return NULL;
+    return _compositeMaterials[level - _compositeLevel];
+}
+
+std::string Terrain::compositePassCallback(Pass* pass, void* cookie)
+{
+    Terrain* terrain = reinterpret_cast<Terrain*>(cookie);
+    GP_ASSERT(terrain);
+
+    std::ostringstream defines;
+    defines << "LAYER_COUNT 0;SAMPLER_COUNT 0;COMPOSITE";
+    if (terrain->_normalMap)
+        defines << ";NORMAL_MAP";
+    if (terrain->_morphDistance > 0.0f)
+        defines << ";MORPHING";
+    return defines.str();
+}
+
+int Terrain::buildQuadTree(unsigned int row1, unsigned int column1, unsigned int row2, unsigned int column2, unsigned int columns)
+{
+    GP_ASSERT(row1 < row2 && column1 < column2);
+
+    int index = (int)_quadTree.size();
+    QuadNode node;
+    node.children[0] = node.children[1] = node.children[2] = node.children[3] = -1;
+    node.patch = NULL;
+    _quadTree.push_back(node);
+
+    if (row2 - row1 == 1 && column2 - column1 == 1)
+    {
+        GP_ASSERT(row1 * columns + column1 < _patches.size());
+        _quadTree[index].patch = _patches[row1 * columns + column1];
+        return index;
+    }
+
+    // Split the range in half along each axis, skipping empty halves of single rows or columns
+    unsigned int rowSplit = row1 + (row2 - row1 + 1) / 2;
+    unsigned int columnSplit = column1 + (column2 - column1 + 1) / 2;
+    const unsigned int rows[3] = { row1, rowSplit, row2 };
+    const unsigned int cols[3] = { column1, columnSplit, column2 };
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        unsigned int r = i / 2;
+        unsigned int c = i % 2;
+        if (rows[r] < rows[r + 1] && cols[c] < cols[c + 1])
+        {
+            int child = buildQuadTree(rows[r], cols[c], rows[r + 1], cols[c + 1], columns);
+            _quadTree[index].children[i] = child;
+        }
+    }
+    return index;
+}
+
+void Terrain::updateQuadTreeBounds(int index)
+{
+    QuadNode& node = _quadTree[index];
+    if (node.patch)
+    {
+        node.bounds.set(node.patch->getBoundingBox(true));
+        return;
+    }
+
+    bool first = true;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        if (node.children[i] >= 0)
+        {
+            updateQuadTreeBounds(node.children[i]);
+            if (first)
+                node.bounds.set(_quadTree[node.children[i]].bounds);
+            else
+                node.bounds.merge(_quadTree[node.children[i]].bounds);
+            first = false;
+        }
+    }
+}
+
+unsigned int Terrain::drawQuadTree(int index, Camera* camera, bool wireframe, bool cull, int level, const DepthPyramid* depthPyramid)
+{
+    const QuadNode& node = _quadTree[index];
+
+    // Cull the whole region if it is outside the frustum, and skip the tests below it if it is inside
+    if (cull)
+    {
+        const Frustum& frustum = camera->getFrustum();
+        const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(),
+                                   &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+        cull = false;
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            float result = node.bounds.intersects(*planes[i]);
+            if (result == Plane::INTERSECTS_BACK)
+                return 0;
+            if (result == Plane::INTERSECTS_INTERSECTING)
+                cull = true;
+        }
+
+        // A region entirely in view that is small enough on screen for the lowest level of detail
+        // uses it for all of its patches, since the patches inside it cover even less of the screen.
+        if (!cull && level < 0 && isFlagSet(LEVEL_OF_DETAIL) && _levelCount > 1 &&
+            computeLevel(camera, node.bounds, _levelCount) == _levelCount - 1)
+        {
+            level = (int)_levelCount - 1;
+        }
+    }
+
+    // A region hidden behind hills hides all of its patches, even inside the frustum.
+    if (depthPyramid && depthPyramid->isOccluded(node.bounds))
+        return 0;
+
+    if (node.patch)
+    {
+        return node.patch->draw(camera, wireframe, level);
     }
-    return visibleCount;
+
+    unsigned int drawCalls = 0;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        if (node.children[i] >= 0)
+        {
+            drawCalls += drawQuadTree(node.children[i], camera, wireframe, cull, level, depthPyramid);
+        }
+    }
+    return drawCalls;
+}
+
+unsigned int Terrain::computeLevel(Camera* camera, const BoundingBox& worldBounds, unsigned int levelCount) const
+{
+    GP_ASSERT(camera);
+    GP_ASSERT(levelCount > 0);
+
+    if (_morphDistance > 0.0f)
+    {
+        // Level 0 is used within the morph distance, and each further level doubles the distance.
+        Node* cameraNode = camera->getNode();
+        Vector3 eye = cameraNode ? cameraNode->getTranslationWorld() : Vector3::zero();
+        Vector3 closest(std::min(std::max(eye.x, worldBounds.min.x), worldBounds.max.x),
+                        std::min(std::max(eye.y, worldBounds.min.y), worldBounds.max.y),
+                        std::min(std::max(eye.z, worldBounds.min.z), worldBounds.max.z));
+        float distance = eye.distance(closest);
+        unsigned int level = 0;
+        for (float range = _morphDistance; distance >= range && level < levelCount - 1; range *= 2.0f)
+            ++level;
+        return level;
+    }
+
+    // Compute LOD to use based on very simple distance metric. TODO: Optimize me.
+    Game* game = Game::getInstance();
+    Rectangle vp(0, 0, game->getWidth(), game->getHeight());
+    Vector3 corners[8];
+    Vector2 min(FLT_MAX, FLT_MAX);
+    Vector2 max(-FLT_MAX, -FLT_MAX);
+    worldBounds.getCorners(corners);
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        float x, y;
+        camera->project(vp, corners[i], &x, &y);
+        if (x < min.x)
+            min.x = x;
+        if (y < min.y)
+            min.y = y;
+        if (x > max.x)
+            max.x = x;
+        if (y > max.y)
+            max.y = y;
+    }
+    float area = (max.x - min.x) * (max.y - min.y);
+    float screenArea = game->getWidth() * game->getHeight() / 10.0f;
+    float error = screenArea / area;
+
+    // Level LOD based on distance from camera
+    size_t maxLod = levelCount - 1;
+    size_t lod = (size_t)error;
+    lod = std::max(lod, (size_t)0);
+    lod = std::min(lod, maxLod);
+    return (unsigned int)lod;
+}
+
+Vector3 Terrain::getMorphRange(unsigned int level) const
+{
+    // The last level never morphs.
+    if (level + 1 >= _levelCount)
+        return Vector3((float)level, 0.0f, 0.0f);
+
+    // Vertices morph over the second half of the distances each level is used at,
+    // reaching the next level's geometry at the distance the next level takes over.
+    float end = _morphDistance * (float)(1u << level);
+    float start = level == 0 ? end * 0.5f : end * 0.75f;
+    return Vector3((float)level, start, 1.0f / (end - start));
 }
 
 static float getDefaultHeight(unsigned int width, unsigned int height)
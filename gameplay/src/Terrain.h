@@ -13,6 +13,7 @@ namespace gameplay
 
 class Node;
 class TerrainPatch;
+class DepthPyramid;
 class TerrainAutoBindingResolver;
 
 /**
@@ -86,6 +87,8 @@ class Terrain : public Ref, private Transform::Listener
     friend class PhysicsController;
     friend class PhysicsRigidBody;
     friend class TerrainPatch;
+    friend class TerrainPager;
+    friend class SceneLoader;
     friend class TerrainAutoBindingResolver;
 
 public:
@@ -126,6 +129,20 @@ public:
      * details and vertical skirt size. A custom terrain material file can also be specified,
      * otherwise the terrain will look for a material file at res/materials/terrain.material.
      *
+     * Setting the 'geomorphing' property to true creates a terrain with continuous level of
+     * detail: each patch keeps a single vertex buffer, its levels are index buffers shared by
+     * all patches of the same size, and the vertex shader morphs vertices toward the next level
+     * as they get further from the camera, so levels change without popping or cracks and no
+     * vertical skirts are generated. Level 0 is used within 'morphDistance' of the camera and
+     * each further level covers twice the distance of the previous one. The distance is raised
+     * to at least twice the diagonal of a patch, so that neighboring patches never differ by
+     * more than one level. The terrain material must handle the MORPHING define, as the
+     * default terrain shaders do.
+     *
+     * Setting the 'quantizeHeights' property to true stores the heights that the terrain keeps
+     * for getHeight() and physics as 16-bit values once the patches are built, halving their
+     * memory (see HeightField::quantize()).
+     *
      * @param path Path to a properties file describing the terrain.
      *
      * @return A new Terrain.
@@ -231,6 +248,11 @@ public:
     /**
      * Draws the terrain.
      *
+     * The patches are organized in a quadtree, so whole regions of the terrain outside the
+     * view frustum are culled with a single test, and regions entirely inside it skip the
+     * tests of their patches. Regions far enough away to use the lowest level of detail
+     * select it for all of their patches at once.
+     *
      * @param wireframe True to draw the terrain as wireframe, false to draw it solid (default).
      * @return The number of draw calls taken to drawn the terrain
      */
@@ -277,6 +299,33 @@ public:
         const char* blendPath = NULL, int blendChannel = 0,
         int row = -1, int column = -1);
 
+    /**
+     * Sets the size of the composite texture and the first level of detail drawn with it.
+     *
+     * The composite is a single low resolution texture that the layers of the whole terrain are
+     * baked into. Patches drawn at the given level of detail or a coarser one sample it instead of
+     * blending their layers, and share one material per level, so far terrain costs a single
+     * texture fetch per fragment and no material changes between patches. The composite is baked
+     * before the terrain is next drawn, and again when a layer changes. Patches are drawn with their
+     * own materials while the DEBUG_PATCHES flag is set.
+     *
+     * The composite can also be set in the terrain file with a composite section:
+     * @code
+       composite
+       {
+           size = 1024
+           level = 2
+       }
+     * @endcode
+     *
+     * @param size The width and height of the composite texture, which must be a power of two, or 0
+     *      to blend the layers of every patch (default).
+     * @param level The first level of detail that is drawn with the composite.
+     *
+     * @script{ignore}
+     */
+    void setComposite(unsigned int size, unsigned int level);
+
 private:
 
     /**
@@ -311,6 +360,23 @@ private:
      */
     static Terrain* create(const char* path, Properties* properties);
 
+    /**
+     * Loads the heightfield described by the 'heightmap' property or section of a terrain definition.
+     *
+     * @param pTerrain The terrain namespace.
+     * @param path The path of the terrain definition, used for error messages.
+     *
+     * @return The loaded heightfield, or NULL if it could not be loaded.
+     */
+    static HeightField* loadHeightField(Properties* pTerrain, const char* path);
+
+    /**
+     * Creates a terrain from a loaded heightfield and the remaining properties of a terrain definition.
+     *
+     * The terrain takes ownership of the heightfield.
+     */
+    static Terrain* create(HeightField* heightfield, Properties* pTerrain, const char* path);
+
     /**
      * Sets the node that the terrain is attached to.
      */
@@ -332,6 +398,78 @@ private:
      */
     BoundingBox getBoundingBox(bool worldSpace) const;
 
+    /**
+     * Defines a node of the quadtree the patches are organized in.
+     */
+    struct QuadNode
+    {
+        /** The world-space bounds of all the patches under the node. */
+        BoundingBox bounds;
+        /** The indices of the child nodes, or -1 for missing children. */
+        int children[4];
+        /** The patch of a leaf node, or NULL for an inner node. */
+        TerrainPatch* patch;
+    };
+
+    /**
+     * Adds the quadtree nodes for the patches in the given range of rows and columns.
+     *
+     * @return The index of the node for the range.
+     */
+    int buildQuadTree(unsigned int row1, unsigned int column1, unsigned int row2, unsigned int column2, unsigned int columns);
+
+    /**
+     * Recomputes the world-space bounds of a quadtree node and its children.
+     */
+    void updateQuadTreeBounds(int index);
+
+    /**
+     * Draws the patches under a quadtree node.
+     *
+     * @param index The index of the node.
+     * @param camera The camera to draw from.
+     * @param wireframe Whether to draw the patches as wireframe.
+     * @param cull Whether the node must be tested against the view frustum (false if the parent is inside it).
+     * @param level The level of detail for all the patches under the node, or -1 to compute it for each patch.
+     * @param depthPyramid The depth pyramid of the scene to skip the hidden nodes with, or NULL.
+     */
+    unsigned int drawQuadTree(int index, Camera* camera, bool wireframe, bool cull, int level, const DepthPyramid* depthPyramid);
+
+    /**
+     * Computes the level of detail for a region of the terrain seen from the given camera.
+     *
+     * Geomorphing terrains select levels by distance, so that they match the distances
+     * the vertex shader morphs between levels at. Other terrains select them by the area
+     * the region covers on screen.
+     */
+    unsigned int computeLevel(Camera* camera, const BoundingBox& worldBounds, unsigned int levelCount) const;
+
+    /**
+     * Returns the morph parameters of a geomorphing level of detail: the level, the distance
+     * its vertices start morphing to the next level at, and the inverse of the morph distance.
+     */
+    Vector3 getMorphRange(unsigned int level) const;
+
+    /**
+     * Bakes the layers of every patch into the composite texture, and creates the composite materials.
+     */
+    void bakeComposite();
+
+    /**
+     * Releases the composite texture and materials.
+     */
+    void clearComposite();
+
+    /**
+     * Returns the material that the patches drawn at a level of detail share, or NULL if they are drawn with their own.
+     */
+    Material* getCompositeMaterial(unsigned int level) const;
+
+    /**
+     * Builds the preprocessor definitions of the composite materials.
+     */
+    static std::string compositePassCallback(Pass* pass, void* cookie);
+
     std::string _materialPath;
     HeightField* _heightfield;
     Node* _node;
@@ -342,6 +480,14 @@ private:
     mutable Matrix _inverseWorldMatrix;
     mutable unsigned int _dirtyFlags;
     BoundingBox _boundingBox;
+    std::vector<QuadNode> _quadTree;
+    unsigned int _levelCount;
+    float _morphDistance;
+    std::map<std::pair<unsigned int, unsigned int>, MeshPart*> _sharedIndices;
+    unsigned int _compositeSize;
+    unsigned int _compositeLevel;
+    Texture::Sampler* _compositeMap;
+    std::vector<Material*> _compositeMaterials;
 };
 
 }
@@ -0,0 +1,392 @@
+#include "Base.h"
+#include "TerrainPager.h"
+#include "Terrain.h"
+#include "Game.h"
+
+// Tiles are kept until they are this much farther than the load distance, so that
+// tiles near the edge of the load distance are not reloaded as the camera moves back and forth.
+#define UNLOAD_DISTANCE_SCALE 1.25f
+
+// Estimated memory of a heightfield sample: the height itself and a patch vertex
+// (position, normal and texture coordinates).
+#define TILE_SAMPLE_SIZE (sizeof(float) * 9)
+
+// The longest path of a tile file, including the terminating null character.
+#define TILE_PATH_MAX 1024
+
+#ifdef _MSC_VER
+#define snprintf _snprintf
+#endif
+
+namespace gameplay
+{
+
+/**
+ * Determines if a tile path pattern formats the column and the row of a tile and nothing else:
+ * it must have exactly two %d specifiers (with an optional width), and no other specifier than %%.
+ */
+static bool isTilePattern(const char* pattern)
+{
+    unsigned int count = 0;
+    for (const char* p = pattern; *p; ++p)
+    {
+        if (*p != '%')
+            continue;
+        ++p;
+        if (*p == '%')
+            continue;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+        if (*p != 'd')
+            return false;
+        ++count;
+    }
+    return count == 2;
+}
+
+TerrainPager::TerrainPager()
+    : _node(NULL), _columns(0), _rows(0), _tileSize(0.0f), _loadDistance(0.0f),
+    _memoryBudget(0), _memoryUsage(0), _collision(false), _friction(0.5f), _restitution(0.0f),
+    _loadedCount(0), _pending(NULL)
+{
+}
+
+TerrainPager::~TerrainPager()
+{
+    if (_pending)
+    {
+        Game::getInstance()->getJobScheduler()->wait(_pending->group);
+        SAFE_RELEASE(_pending->heightfield);
+        SAFE_DELETE(_pending->properties);
+        SAFE_DELETE(_pending);
+    }
+    for (int i = 0, count = (int)_tiles.size(); i < count; ++i)
+    {
+        unloadTile(i);
+    }
+    SAFE_RELEASE(_node);
+}
+
+TerrainPager* TerrainPager::create(const char* path)
+{
+    Properties* properties = Properties::create(path);
+    if (properties == NULL)
+    {
+        GP_WARN("Failed to load paged terrain definition: %s", path);
+        return NULL;
+    }
+
+    TerrainPager* pager = create(strlen(properties->getNamespace()) > 0 ? properties : properties->getNextNamespace());
+    SAFE_DELETE(properties);
+    return pager;
+}
+
+TerrainPager* TerrainPager::create(Properties* properties)
+{
+    if (properties == NULL || strcmp(properties->getNamespace(), "terrainPager") != 0)
+    {
+        GP_WARN("Properties object must be non-null and have namespace equal to 'terrainPager'.");
+        return NULL;
+    }
+
+    const char* tiles = properties->getString("tiles");
+    int columns = properties->getInt("columns");
+    int rows = properties->getInt("rows");
+    float tileSize = properties->getFloat("tileSize");
+    if (tiles == NULL || columns <= 0 || rows <= 0 || tileSize <= 0.0f)
+    {
+        GP_WARN("Paged terrain definition requires 'tiles', 'columns', 'rows' and 'tileSize' properties.");
+        return NULL;
+    }
+    if (!isTilePattern(tiles))
+    {
+        GP_WARN("Paged terrain 'tiles' pattern must contain exactly two %%d specifiers (column and row): %s", tiles);
+        return NULL;
+    }
+
+    // The last tile has the longest path.
+    char path[TILE_PATH_MAX];
+    int length = snprintf(path, sizeof(path), tiles, columns - 1, rows - 1);
+    if (length < 0 || length >= (int)sizeof(path))
+    {
+        GP_WARN("Paged terrain 'tiles' pattern is too long: %s", tiles);
+        return NULL;
+    }
+
+    TerrainPager* pager = new TerrainPager();
+    pager->_node = Node::create(properties->getId());
+    pager->_tilePath = tiles;
+    pager->_columns = columns;
+    pager->_rows = rows;
+    pager->_tileSize = tileSize;
+    pager->_loadDistance = properties->exists("loadDistance") ? properties->getFloat("loadDistance") : tileSize;
+    pager->_memoryBudget = (size_t)(properties->getFloat("memoryBudget") * 1024.0f * 1024.0f);
+    pager->_collision = properties->getBool("collision");
+    if (properties->exists("friction"))
+        pager->_friction = properties->getFloat("friction");
+    pager->_restitution = properties->getFloat("restitution");
+
+    Tile tile;
+    tile.node = NULL;
+    tile.memory = 0;
+    pager->_tiles.resize(columns * rows, tile);
+
+    return pager;
+}
+
+Node* TerrainPager::getNode() const
+{
+    return _node;
+}
+
+void TerrainPager::update(const Vector3& position)
+{
+    // Create the terrain of a tile whose heightfield has finished loading.
+    if (_pending && Game::getInstance()->getJobScheduler()->isDone(_pending->group))
+    {
+        finishLoad();
+    }
+
+    // Tiles are laid out in the space of the pager's node.
+    Matrix inverse = _node->getWorldMatrix();
+    inverse.invert();
+    Vector3 local;
+    inverse.transformPoint(position, &local);
+
+    // Unload tiles that moved out of range.
+    float unloadDistance = _loadDistance * UNLOAD_DISTANCE_SCALE;
+    for (int i = 0, count = (int)_tiles.size(); i < count; ++i)
+    {
+        if (_tiles[i].node && getTileDistance(i, local) > unloadDistance)
+        {
+            unloadTile(i);
+        }
+    }
+
+    // Unload the farthest tiles until the loaded tiles fit in the budget.
+    int farthest = -1;
+    float farthestDistance = 0.0f;
+    while (true)
+    {
+        farthest = -1;
+        for (int i = 0, count = (int)_tiles.size(); i < count; ++i)
+        {
+            float distance = getTileDistance(i, local);
+            if (_tiles[i].node && (farthest == -1 || distance > farthestDistance))
+            {
+                farthest = i;
+                farthestDistance = distance;
+            }
+        }
+        if (farthest == -1 || _memoryBudget == 0 || _memoryUsage <= _memoryBudget)
+            break;
+        unloadTile(farthest);
+    }
+
+    if (_pending)
+        return;
+
+    // Find the nearest tile in range that is not loaded.
+    int nearest = -1;
+    float nearestDistance = 0.0f;
+    for (int i = 0, count = (int)_tiles.size(); i < count; ++i)
+    {
+        float distance = getTileDistance(i, local);
+        if (!_tiles[i].node && distance <= _loadDistance && (nearest == -1 || distance < nearestDistance))
+        {
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    if (nearest == -1)
+        return;
+
+    // When the budget is used up, only make room for a tile nearer than the farthest loaded one.
+    if (_memoryBudget > 0 && _memoryUsage >= _memoryBudget)
+    {
+        if (farthest == -1 || farthestDistance <= nearestDistance)
+            return;
+        unloadTile(farthest);
+    }
+
+    char path[TILE_PATH_MAX];
+    int length = snprintf(path, sizeof(path), _tilePath.c_str(), nearest % _columns, nearest / _columns);
+    if (length < 0 || length >= (int)sizeof(path))
+    {
+        GP_WARN("Paged terrain tile path is too long: %s", _tilePath.c_str());
+        return;
+    }
+
+    _pending = new PendingTile();
+    _pending->index = nearest;
+    _pending->path = path;
+    _pending->properties = NULL;
+    _pending->definition = NULL;
+    _pending->heightfield = NULL;
+
+    // Read and decode the heightmap in the background, or right away without worker threads.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler->getWorkerCount() > 0)
+    {
+        scheduler->run(_pending->group, &TerrainPager::loadTile, _pending);
+    }
+    else
+    {
+        loadTile(_pending);
+        finishLoad();
+    }
+}
+
+Terrain* TerrainPager::getTerrain(float x, float z) const
+{
+    int index = getTileIndex(x, z);
+    return (index != -1 && _tiles[index].node) ? _tiles[index].node->getTerrain() : NULL;
+}
+
+float TerrainPager::getHeight(float x, float z) const
+{
+    Terrain* terrain = getTerrain(x, z);
+    return terrain ? terrain->getHeight(x, z) : 0.0f;
+}
+
+unsigned int TerrainPager::getLoadedTileCount() const
+{
+    return _loadedCount;
+}
+
+size_t TerrainPager::getMemoryUsage() const
+{
+    return _memoryUsage;
+}
+
+size_t TerrainPager::getMemoryBudget() const
+{
+    return _memoryBudget;
+}
+
+void TerrainPager::setMemoryBudget(size_t bytes)
+{
+    _memoryBudget = bytes;
+}
+
+float TerrainPager::getLoadDistance() const
+{
+    return _loadDistance;
+}
+
+void TerrainPager::setLoadDistance(float distance)
+{
+    _loadDistance = distance;
+}
+
+bool TerrainPager::isCollisionEnabled() const
+{
+    return _collision;
+}
+
+float TerrainPager::getTileDistance(int index, const Vector3& position) const
+{
+    // Distance from the position to the closest point of the tile's square.
+    float minX = (index % _columns) * _tileSize;
+    float minZ = (index / _columns) * _tileSize;
+    float dx = std::max(0.0f, std::max(minX - position.x, position.x - (minX + _tileSize)));
+    float dz = std::max(0.0f, std::max(minZ - position.z, position.z - (minZ + _tileSize)));
+    return sqrt(dx * dx + dz * dz);
+}
+
+int TerrainPager::getTileIndex(float x, float z) const
+{
+    Matrix inverse = _node->getWorldMatrix();
+    inverse.invert();
+    Vector3 local;
+    inverse.transformPoint(Vector3(x, 0.0f, z), &local);
+
+    int column = (int)floor(local.x / _tileSize);
+    int row = (int)floor(local.z / _tileSize);
+    if (column < 0 || column >= _columns || row < 0 || row >= _rows)
+        return -1;
+    return row * _columns + column;
+}
+
+void TerrainPager::finishLoad()
+{
+    GP_ASSERT(_pending);
+
+    PendingTile* pending = _pending;
+    _pending = NULL;
+
+    if (pending->heightfield)
+    {
+        size_t memory = (size_t)pending->heightfield->getRowCount() * pending->heightfield->getColumnCount() * TILE_SAMPLE_SIZE;
+
+        // The terrain takes ownership of the heightfield.
+        Terrain* terrain = Terrain::create(pending->heightfield, pending->definition, pending->path.c_str());
+        pending->heightfield = NULL;
+        if (terrain)
+        {
+            int column = pending->index % _columns;
+            int row = pending->index / _columns;
+
+            Node* node = Node::create();
+            node->setTranslation((column + 0.5f) * _tileSize, 0.0f, (row + 0.5f) * _tileSize);
+            node->setTerrain(terrain);
+            SAFE_RELEASE(terrain);
+            _node->addChild(node);
+
+            // The heightfield shape shares the terrain's height data.
+            if (_collision)
+            {
+                PhysicsRigidBody::Parameters parameters(0.0f, _friction, _restitution);
+                node->setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::heightfield(), &parameters);
+            }
+
+            _tiles[pending->index].node = node;
+            _tiles[pending->index].memory = memory;
+            _memoryUsage += memory;
+            ++_loadedCount;
+        }
+    }
+    else
+    {
+        GP_WARN("Failed to load terrain tile: %s", pending->path.c_str());
+    }
+
+    SAFE_DELETE(pending->properties);
+    SAFE_DELETE(pending);
+}
+
+void TerrainPager::unloadTile(int index)
+{
+    Tile& tile = _tiles[index];
+    if (tile.node == NULL)
+        return;
+
+    // Remove the rigid body from the physics world now, even if something else still references the node.
+    if (tile.node->getCollisionObject())
+    {
+        tile.node->setCollisionObject(PhysicsCollisionObject::NONE);
+    }
+    _node->removeChild(tile.node);
+    SAFE_RELEASE(tile.node);
+    _memoryUsage -= tile.memory;
+    tile.memory = 0;
+    --_loadedCount;
+}
+
+void TerrainPager::loadTile(void* arg)
+{
+    PendingTile* pending = (PendingTile*)arg;
+    GP_ASSERT(pending);
+
+    pending->properties = Properties::create(pending->path.c_str());
+    if (pending->properties == NULL)
+        return;
+
+    pending->definition = strlen(pending->properties->getNamespace()) > 0 ? pending->properties : pending->properties->getNextNamespace();
+    if (pending->definition)
+    {
+        pending->heightfield = Terrain::loadHeightField(pending->definition, pending->path.c_str());
+    }
+}
+
+}
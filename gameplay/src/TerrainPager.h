@@ -0,0 +1,270 @@
+#ifndef TERRAINPAGER_H_
+#define TERRAINPAGER_H_
+
+#include "Ref.h"
+#include "Node.h"
+#include "Properties.h"
+#include "JobScheduler.h"
+
+namespace gameplay
+{
+
+class Terrain;
+class HeightField;
+
+/**
+ * Defines a paged terrain that streams tiles of a large world in and out around a position.
+ *
+ * The world is split into a grid of square tiles, each stored on disk as a regular
+ * terrain definition file with its own heightmap and layer blend maps. Tiles within
+ * the load distance of the position passed to update() are loaded on demand, nearest
+ * first, and tiles that move out of range are unloaded. When the estimated memory used
+ * by the loaded tiles exceeds the memory budget, the farthest tiles are unloaded first.
+ *
+ * The heightmap of a tile is read and decoded on a worker thread of the game's
+ * JobScheduler, while the terrain patches and blend map textures are created on the
+ * game thread. At most one tile is loaded at a time to keep the cost per frame bounded.
+ *
+ * A paged terrain is defined in a properties file:
+ *
+ * @verbatim
+   terrainPager
+   {
+        // Path pattern of the tile terrain files, where the first %d is replaced
+        // by the tile column and the second %d by the tile row.
+        tiles = res/world/tile_%d_%d.terrain
+
+        // Number of tile columns and rows in the world.
+        columns = 16
+        rows = 16
+
+        // Size of a tile in world units along X and Z (must match the 'size' of each tile).
+        tileSize = 512
+
+        // Distance from the camera, in world units, within which tiles are loaded.
+        loadDistance = 1024
+
+        // Maximum estimated memory used by the loaded tiles, in megabytes (0 for no limit).
+        memoryBudget = 32
+
+        // Whether each loaded tile gets a static heightfield rigid body (false by default),
+        // and the friction and restitution of those rigid bodies.
+        collision = true
+        friction = 0.5
+        restitution = 0.0
+   }
+ @endverbatim
+ *
+ * Tile (column, row) is centered at ((column + 0.5) * tileSize, 0, (row + 0.5) * tileSize)
+ * relative to the pager's node. Neighboring tiles should share the heights along their
+ * common edges so that the seams match.
+ *
+ * With collision enabled, the rigid body of a tile is added to the physics world when the
+ * tile is loaded and removed when it is unloaded, so the physics world only contains the
+ * tiles around the camera. The rigid body references the tile's heightfield, including its
+ * 16-bit heights when the tile sets 'quantizeHeights', instead of copying it.
+ *
+ * @script{ignore}
+ */
+class TerrainPager : public Ref
+{
+public:
+
+    /**
+     * Creates a paged terrain from the specified properties file.
+     *
+     * @param path Path to the properties file, which may contain a '#' namespace suffix.
+     *
+     * @return The new paged terrain, or NULL if the definition is invalid.
+     */
+    static TerrainPager* create(const char* path);
+
+    /**
+     * Creates a paged terrain from the specified 'terrainPager' properties namespace.
+     *
+     * @param properties The properties namespace of the paged terrain.
+     *
+     * @return The new paged terrain, or NULL if the definition is invalid.
+     */
+    static TerrainPager* create(Properties* properties);
+
+    /**
+     * Returns the node that the loaded tiles are attached to.
+     *
+     * Add this node to a scene to draw the paged terrain. Each loaded tile is a child
+     * node with a Terrain.
+     *
+     * @return The root node of the paged terrain.
+     */
+    Node* getNode() const;
+
+    /**
+     * Loads and unloads tiles around the specified position.
+     *
+     * This should be called once per frame, typically with the position of the active camera.
+     *
+     * @param position The position, in world space, around which tiles are loaded.
+     */
+    void update(const Vector3& position);
+
+    /**
+     * Returns the terrain of the loaded tile that contains the specified position.
+     *
+     * @param x The X coordinate, in world space.
+     * @param z The Z coordinate, in world space.
+     *
+     * @return The terrain at the specified position, or NULL if its tile is not loaded.
+     */
+    Terrain* getTerrain(float x, float z) const;
+
+    /**
+     * Gets the world-space height of the terrain at the specified position on the X,Z plane.
+     *
+     * @param x The X coordinate, in world space.
+     * @param z The Z coordinate, in world space.
+     *
+     * @return The height at the specified point, or zero if its tile is not loaded.
+     */
+    float getHeight(float x, float z) const;
+
+    /**
+     * Returns the number of tiles that are currently loaded.
+     *
+     * @return The number of loaded tiles.
+     */
+    unsigned int getLoadedTileCount() const;
+
+    /**
+     * Returns the estimated memory used by the loaded tiles.
+     *
+     * The estimate includes the heightfield and the vertex data of each tile.
+     *
+     * @return The estimated memory used by the loaded tiles, in bytes.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Returns the memory budget for the loaded tiles.
+     *
+     * @return The memory budget, in bytes, or zero if there is no limit.
+     */
+    size_t getMemoryBudget() const;
+
+    /**
+     * Sets the memory budget for the loaded tiles.
+     *
+     * Tiles beyond the budget are unloaded farthest first on the next call to update().
+     *
+     * @param bytes The memory budget, in bytes, or zero for no limit.
+     */
+    void setMemoryBudget(size_t bytes);
+
+    /**
+     * Returns the distance within which tiles are loaded.
+     *
+     * @return The load distance, in world units.
+     */
+    float getLoadDistance() const;
+
+    /**
+     * Returns whether loaded tiles get heightfield rigid bodies.
+     *
+     * @return True if the tiles have collision.
+     */
+    bool isCollisionEnabled() const;
+
+    /**
+     * Sets the distance within which tiles are loaded.
+     *
+     * @param distance The load distance, in world units.
+     */
+    void setLoadDistance(float distance);
+
+private:
+
+    /**
+     * Defines a tile of the world grid.
+     */
+    struct Tile
+    {
+        Node* node;
+        size_t memory;
+    };
+
+    /**
+     * Defines a tile being loaded on a worker thread.
+     */
+    struct PendingTile
+    {
+        int index;
+        std::string path;
+        Properties* properties;
+        Properties* definition;
+        HeightField* heightfield;
+        JobScheduler::Group group;
+    };
+
+    /**
+     * Constructor.
+     */
+    TerrainPager();
+
+    /**
+     * Destructor.
+     */
+    ~TerrainPager();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TerrainPager(const TerrainPager& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TerrainPager& operator=(const TerrainPager&);
+
+    /**
+     * Returns the distance on the X,Z plane from a position in the pager's space to a tile.
+     */
+    float getTileDistance(int index, const Vector3& position) const;
+
+    /**
+     * Returns the index of the tile containing a world-space position, or -1 if it is outside the world.
+     */
+    int getTileIndex(float x, float z) const;
+
+    /**
+     * Creates the terrain of the pending tile once its heightfield has been loaded.
+     */
+    void finishLoad();
+
+    /**
+     * Unloads the tile at the specified index.
+     */
+    void unloadTile(int index);
+
+    /**
+     * Reads the definition and heightfield of a pending tile (runs on a worker thread).
+     */
+    static void loadTile(void* arg);
+
+    Node* _node;
+    std::string _tilePath;
+    int _columns;
+    int _rows;
+    float _tileSize;
+    float _loadDistance;
+    size_t _memoryBudget;
+    size_t _memoryUsage;
+    bool _collision;
+    float _friction;
+    float _restitution;
+    unsigned int _loadedCount;
+    std::vector<Tile> _tiles;
+    PendingTile* _pending;
+};
+
+}
+
+#endif
@@ -40,6 +40,10 @@ TerrainPatch::~TerrainPatch()
     {
         Level* level = _levels[i];
 
+        for (size_t j = 0, bindingCount = level->compositeBindings.size(); j < bindingCount; ++j)
+        {
+            SAFE_RELEASE(level->compositeBindings[j]);
+        }
         SAFE_RELEASE(level->model);
         SAFE_DELETE(level);
     }
@@ -56,7 +60,7 @@ TerrainPatch* TerrainPatch::create(Terrain* terrain, unsigned int index,
                                    float* heights, unsigned int width, unsigned int height,
                                    unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
                                    float xOffset, float zOffset,
-                                   unsigned int maxStep, float verticalSkirtSize)
+                                   unsigned int maxStep, float verticalSkirtSize, bool morph)
 {
     // Create patch
     TerrainPatch* patch = new TerrainPatch();
@@ -66,9 +70,19 @@ TerrainPatch* TerrainPatch::create(Terrain* terrain, unsigned int index,
     patch->_column = column;
 
     // Add patch lods
-    for (unsigned int step = 1; step <= maxStep; step *= 2)
+    if (morph)
     {
-        patch->addLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, step, verticalSkirtSize);
+        unsigned int levelCount = 1;
+        for (unsigned int step = 2; step <= maxStep; step *= 2)
+            ++levelCount;
+        patch->addMorphLODs(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, levelCount);
+    }
+    else
+    {
+        for (unsigned int step = 1; step <= maxStep; step *= 2)
+        {
+            patch->addLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, step, verticalSkirtSize);
+        }
     }
 
     // Set our bounding box using the base LOD mesh
@@ -97,9 +111,9 @@ Material* TerrainPatch::getMaterial(int index) const
         {
             _level = 0;
         }
-        return _levels[_level]->model->getMaterial();
+        return _levels[_level]->model->getMaterial(_levels[_level]->partIndex);
     }
-    return _levels[index]->model->getMaterial();
+    return _levels[index]->model->getMaterial(_levels[index]->partIndex);
 }
 
 void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int height,
@@ -342,6 +356,232 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     _levels.push_back(level);
 }
 
+// Returns the coarsest level of detail that includes the given row or column of a patch,
+// where level n includes every 2^n-th one plus the last one.
+static unsigned int getGridLevel(unsigned int i, unsigned int last, unsigned int maxLevel)
+{
+    if (i == 0 || i == last)
+        return maxLevel;
+    unsigned int level = 0;
+    while (level < maxLevel && (i & (1u << level)) == 0)
+        ++level;
+    return level;
+}
+
+// Finds the rows or columns of the next coarser level of detail on either side of the given one.
+static float getCoarseRange(unsigned int i, unsigned int last, unsigned int level, unsigned int gridLevel, unsigned int* prev, unsigned int* next)
+{
+    if (gridLevel > level)
+    {
+        *prev = *next = i;
+        return 0.0f;
+    }
+    unsigned int coarseStep = 1u << (level + 1);
+    *prev = (i / coarseStep) * coarseStep;
+    *next = std::min(*prev + coarseStep, last);
+    return (float)(i - *prev) / (float)(*next - *prev);
+}
+
+void TerrainPatch::addMorphLODs(float* heights, unsigned int width, unsigned int height,
+                                unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+                                float xOffset, float zOffset, unsigned int levelCount)
+{
+    GP_ASSERT(levelCount > 0);
+
+    // All levels of detail draw the full resolution vertices, so there is a single vertex buffer.
+    unsigned int patchWidth = (x2 - x1) + 1;
+    unsigned int patchHeight = (z2 - z1) + 1;
+    unsigned int vertexCount = patchWidth * patchHeight;
+    if (vertexCount > USHRT_MAX)
+    {
+        GP_WARN("Vertex count of %d for terrain patch exceeds the limit of 65535. Please specifiy a smaller patch size.", vertexCount);
+        GP_ASSERT(vertexCount <= USHRT_MAX);
+    }
+
+    unsigned int maxLevel = levelCount - 1;
+    unsigned int vertexElements = _terrain->_normalMap ? 7 : 10; //<x,y,z>[i,j,k]<u,v><morphHeight,level>
+    float* vertices = new float[vertexCount * vertexElements];
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (unsigned int z = 0; z < patchHeight; ++z)
+    {
+        unsigned int levelZ = getGridLevel(z, patchHeight - 1, maxLevel);
+        for (unsigned int x = 0; x < patchWidth; ++x)
+        {
+            unsigned int levelX = getGridLevel(x, patchWidth - 1, maxLevel);
+            float* v = vertices + ((z * patchWidth + x) * vertexElements);
+
+            // Compute position - apply the local scale of the terrain into the vertex data
+            v[0] = (x1 + x + xOffset) * _terrain->_localScale.x;
+            v[1] = computeHeight(heights, width, x1 + x, z1 + z);
+            v[2] = (z1 + z + zOffset) * _terrain->_localScale.z;
+
+            if (v[0] < min.x)
+                min.x = v[0];
+            if (v[1] < min.y)
+                min.y = v[1];
+            if (v[2] < min.z)
+                min.z = v[2];
+            if (v[0] > max.x)
+                max.x = v[0];
+            if (v[1] > max.y)
+                max.y = v[1];
+            if (v[2] > max.z)
+                max.z = v[2];
+            float vertexHeight = v[1];
+            v += 3;
+
+            // Compute normal from the neighboring heights
+            if (!_terrain->_normalMap)
+            {
+                unsigned int gx = x1 + x;
+                unsigned int gz = z1 + z;
+                unsigned int xw = gx > 0 ? gx - 1 : gx;
+                unsigned int xe = gx < width - 1 ? gx + 1 : gx;
+                unsigned int zs = gz > 0 ? gz - 1 : gz;
+                unsigned int zn = gz < height - 1 ? gz + 1 : gz;
+                float dx = (computeHeight(heights, width, xe, gz) - computeHeight(heights, width, xw, gz)) / ((xe - xw) * _terrain->_localScale.x);
+                float dz = (computeHeight(heights, width, gx, zn) - computeHeight(heights, width, gx, zs)) / ((zn - zs) * _terrain->_localScale.z);
+                Vector3 normal(-dx, 1.0f, -dz);
+                normal.normalize();
+                v[0] = normal.x;
+                v[1] = normal.y;
+                v[2] = normal.z;
+                v += 3;
+            }
+
+            // Compute texture coord
+            v[0] = (float)(x1 + x) / width;
+            v[1] = 1.0f - (float)(z1 + z) / height;
+            v += 2;
+
+            // A vertex moves only when drawn at the coarsest level that includes it, where it morphs
+            // to the height of the next coarser level's triangle beneath it.
+            unsigned int level = std::min(levelX, levelZ);
+            float morphHeight = vertexHeight;
+            if (level < maxLevel)
+            {
+                unsigned int xp, xn, zp, zn;
+                float u = getCoarseRange(x, patchWidth - 1, level, levelX, &xp, &xn);
+                float t = getCoarseRange(z, patchHeight - 1, level, levelZ, &zp, &zn);
+
+                // Coarse quads are split along the diagonal from (xn, zp) to (xp, zn).
+                float h10 = computeHeight(heights, width, x1 + xn, z1 + zp);
+                float h01 = computeHeight(heights, width, x1 + xp, z1 + zn);
+                if (u + t <= 1.0f)
+                {
+                    float h00 = computeHeight(heights, width, x1 + xp, z1 + zp);
+                    morphHeight = h00 + u * (h10 - h00) + t * (h01 - h00);
+                }
+                else
+                {
+                    float h11 = computeHeight(heights, width, x1 + xn, z1 + zn);
+                    morphHeight = h11 + (1.0f - u) * (h01 - h11) + (1.0f - t) * (h10 - h11);
+                }
+            }
+            v[0] = morphHeight;
+            v[1] = (float)level;
+        }
+    }
+
+    Vector3 center(min + ((max - min) * 0.5f));
+
+    // Create mesh
+    VertexFormat::Element elements[4];
+    elements[0] = VertexFormat::Element(VertexFormat::POSITION, 3);
+    if (_terrain->_normalMap)
+    {
+        elements[1] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
+        elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD1, 2);
+    }
+    else
+    {
+        elements[1] = VertexFormat::Element(VertexFormat::NORMAL, 3);
+        elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
+        elements[3] = VertexFormat::Element(VertexFormat::TEXCOORD1, 2);
+    }
+    VertexFormat format(elements, _terrain->_normalMap ? 3 : 4);
+    Mesh* mesh = Mesh::createMesh(format, vertexCount);
+    mesh->setVertexData(vertices);
+    mesh->setBoundingBox(BoundingBox(min, max));
+    mesh->setBoundingSphere(BoundingSphere(center, center.distance(max)));
+    SAFE_DELETE_ARRAY(vertices);
+
+    // Add a part per level of detail. Patches of the same size have the same indices, so they share them.
+    std::vector<unsigned int> columns;
+    std::vector<unsigned int> rows;
+    std::vector<unsigned short> indices;
+    for (unsigned int level = 0; level < levelCount; ++level)
+    {
+        std::pair<unsigned int, unsigned int> key(patchWidth * 65536 + patchHeight, level);
+        std::map<std::pair<unsigned int, unsigned int>, MeshPart*>::iterator itr = _terrain->_sharedIndices.find(key);
+        if (itr != _terrain->_sharedIndices.end())
+        {
+            mesh->addPart(itr->second);
+            continue;
+        }
+
+        unsigned int step = 1u << level;
+        columns.clear();
+        rows.clear();
+        for (unsigned int x = 0; x < patchWidth - 1; x += step)
+            columns.push_back(x);
+        columns.push_back(patchWidth - 1);
+        for (unsigned int z = 0; z < patchHeight - 1; z += step)
+            rows.push_back(z);
+        rows.push_back(patchHeight - 1);
+
+        // Triangle strip rows joined with degenerate triangles, as in addLOD
+        indices.clear();
+        unsigned int columnCount = (unsigned int)columns.size();
+        for (unsigned int z = 0; z + 1 < rows.size(); ++z)
+        {
+            unsigned int i1 = rows[z] * patchWidth;
+            unsigned int i2 = rows[z + 1] * patchWidth;
+            if (z % 2 == 0)
+            {
+                if (z > 0)
+                {
+                    indices.push_back(indices.back());
+                    indices.push_back(i1 + columns[0]);
+                }
+                for (unsigned int x = 0; x < columnCount; ++x)
+                {
+                    indices.push_back(i1 + columns[x]);
+                    indices.push_back(i2 + columns[x]);
+                }
+            }
+            else
+            {
+                indices.push_back(indices.back());
+                indices.push_back(i2 + columns[columnCount - 1]);
+                for (int x = (int)columnCount - 1; x >= 0; --x)
+                {
+                    indices.push_back(i2 + columns[x]);
+                    indices.push_back(i1 + columns[x]);
+                }
+            }
+        }
+
+        MeshPart* part = mesh->addPart(Mesh::TRIANGLE_STRIP, Mesh::INDEX16, (unsigned int)indices.size());
+        part->setIndexData(&indices[0], 0, (unsigned int)indices.size());
+        _terrain->_sharedIndices[key] = part;
+    }
+
+    // Create model, drawing one part for each level
+    Model* model = Model::create(mesh);
+    mesh->release();
+    for (unsigned int i = 0; i < levelCount; ++i)
+    {
+        if (i > 0)
+            model->addRef();
+        Level* level = new Level();
+        level->model = model;
+        level->partIndex = (int)i;
+        _levels.push_back(level);
+    }
+}
+
 void TerrainPatch::deleteLayer(Layer* layer)
 {
     // Release layer samplers
@@ -464,10 +704,18 @@ std::string TerrainPatch::passCallback(Pass* pass, void* cookie)
     TerrainPatch* patch = reinterpret_cast<TerrainPatch*>(cookie);
     GP_ASSERT(patch);
 
-    return patch->passCreated(pass);
+    return patch->passCreated(pass, false);
 }
 
-std::string TerrainPatch::passCreated(Pass* pass)
+std::string TerrainPatch::bakePassCallback(Pass* pass, void* cookie)
+{
+    TerrainPatch* patch = reinterpret_cast<TerrainPatch*>(cookie);
+    GP_ASSERT(patch);
+
+    return patch->passCreated(pass, true);
+}
+
+std::string TerrainPatch::passCreated(Pass* pass, bool bake)
 {
     // Build preprocessor string to be passed to the terrain shader.
     // NOTE: I make heavy use of preprocessor definitions, rather than passing in arrays and doing
@@ -477,15 +725,26 @@ std::string TerrainPatch::passCreated(Pass* pass)
     defines << "LAYER_COUNT " << _layers.size();
     defines << ";SAMPLER_COUNT " << _samplers.size();
 
-    if (_terrain->isFlagSet(Terrain::DEBUG_PATCHES))
+    if (bake)
     {
-        defines << ";DEBUG_PATCHES";
-        pass->getParameter("u_row")->setFloat(_row);
-        pass->getParameter("u_column")->setFloat(_column);
+        // The composite holds the blended layers only, and is lit when it is drawn.
+        defines << ";COMPOSITE_BAKE";
     }
+    else
+    {
+        if (_terrain->isFlagSet(Terrain::DEBUG_PATCHES))
+        {
+            defines << ";DEBUG_PATCHES";
+            pass->getParameter("u_row")->setFloat(_row);
+            pass->getParameter("u_column")->setFloat(_column);
+        }
 
-    if (_terrain->_normalMap)
-        defines << ";NORMAL_MAP";
+        if (_terrain->_normalMap)
+            defines << ";NORMAL_MAP";
+
+        if (_terrain->_morphDistance > 0.0f)
+            defines << ";MORPHING";
+    }
 
     // Append texture and blend index constants to preprocessor definition.
     // We need to do this since older versions of GLSL only allow sampler arrays
@@ -532,10 +791,17 @@ bool TerrainPatch::updateMaterial()
             return false;
         }
 
+        // Morphing levels blend toward the next level as their vertices get further from the camera
+        if (_levels[i]->partIndex >= 0)
+        {
+            material->setParameterAutoBinding("u_worldViewMatrix", RenderState::WORLD_VIEW_MATRIX);
+            material->getParameter("u_morph")->setValue(_terrain->getMorphRange((unsigned int)i));
+        }
+
         material->setNodeBinding(_terrain->_node);
 
         // Set material on this lod level
-        _levels[i]->model->setMaterial(material);
+        _levels[i]->model->setMaterial(material, _levels[i]->partIndex);
 
         material->release();
     }
@@ -550,33 +816,131 @@ void TerrainPatch::updateNodeBindings()
     __currentPatchIndex = _index;
     for (size_t i = 0, count = _levels.size(); i < count; ++i)
     {
-        _levels[i]->model->getMaterial()->setNodeBinding(_terrain->_node);
+        _levels[i]->model->getMaterial(_levels[i]->partIndex)->setNodeBinding(_terrain->_node);
     }
     __currentPatchIndex = -1;
 }
 
-unsigned int TerrainPatch::draw(bool wireframe)
+unsigned int TerrainPatch::draw(Camera* camera, bool wireframe, int level)
 {
-    Scene* scene = _terrain->_node ? _terrain->_node->getScene() : NULL;
-    Camera* camera = scene ? scene->getActiveCamera() : NULL;
-    if (!camera)
-        return 0;
-
-    // Get our world-space bounding box
-    BoundingBox bounds = getBoundingBox(true);
-
-    // If the box does not intersect the view frustum, cull it
-    if (_terrain->isFlagSet(Terrain::FRUSTUM_CULLING) && !camera->getFrustum().intersects(bounds))
-        return 0;
+    GP_ASSERT(camera);
 
     if (!updateMaterial())
         return 0;
 
-    // Compute the LOD level from the camera's perspective
-    _level = computeLOD(camera, bounds);
+    // Use the level of detail selected for the patch's region, or compute it from the camera's perspective
+    if (level >= 0)
+    {
+        setCamera(camera);
+        _level = (unsigned int)level;
+        _bits &= ~TERRAINPATCH_DIRTY_LEVEL;
+    }
+    else
+    {
+        _level = computeLOD(camera, getBoundingBox(true));
+    }
 
     // Draw the model for the current LOD
-    return _levels[_level]->model->draw(wireframe);
+    Level* current = _levels[_level];
+
+    // Distant levels share the material that samples the terrain composite
+    Material* composite = _terrain->getCompositeMaterial(_level);
+    if (composite)
+    {
+        drawPasses(current, composite, &current->compositeBindings, wireframe);
+        return 1;
+    }
+
+    if (current->partIndex < 0)
+        return current->model->draw(wireframe);
+
+    // Morphing levels are parts of a single model
+    Material* material = current->model->getMaterial(current->partIndex);
+    MeshPart* part = current->model->getMesh()->getPart(current->partIndex);
+    GP_ASSERT(material && part);
+    Technique* technique = material->getTechnique();
+    GP_ASSERT(technique);
+    for (unsigned int i = 0, count = technique->getPassCount(); i < count; ++i)
+    {
+        current->model->drawPass(technique->getPassByIndex(i), part, wireframe);
+    }
+    return 1;
+}
+
+void TerrainPatch::drawPasses(Level* level, Material* material, std::vector<VertexAttributeBinding*>* bindings, bool wireframe)
+{
+    GP_ASSERT(level && material && bindings);
+
+    Mesh* mesh = level->model->getMesh();
+    MeshPart* part = NULL;
+    if (level->partIndex >= 0)
+        part = mesh->getPart(level->partIndex);
+    else if (mesh->getPartCount() > 0)
+        part = mesh->getPart(0);
+
+    // The material is not the model's, so the mesh is bound to its passes here.
+    Technique* technique = material->getTechnique();
+    GP_ASSERT(technique);
+    bindings->resize(technique->getPassCount(), NULL);
+    for (unsigned int i = 0, count = technique->getPassCount(); i < count; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+        if ((*bindings)[i] == NULL)
+            (*bindings)[i] = VertexAttributeBinding::create(mesh, pass->getEffect());
+
+        pass->bind((*bindings)[i]);
+        level->model->drawGeometry(part, wireframe);
+        pass->unbind((*bindings)[i]);
+    }
+}
+
+void TerrainPatch::bakeComposite()
+{
+    if (_levels.empty())
+        return;
+
+    Material* material = Material::create(_terrain->_materialPath.c_str(), &bakePassCallback, this);
+    if (!material)
+    {
+        GP_WARN("Failed to load material for terrain patch: %s", _terrain->_materialPath.c_str());
+        return;
+    }
+
+    // Patches are drawn in texture space, so they face either way and never overlap.
+    RenderState::StateBlock* state = material->getStateBlock();
+    state->setCullFace(false);
+    state->setDepthTest(false);
+    state->setDepthWrite(false);
+    state->setBlend(false);
+
+    // The material is not bound to the terrain node, so the layer maps are set directly.
+    if (_layers.size() > 0)
+    {
+        MaterialParameter* parameter = material->getParameter("u_surfaceLayerMaps");
+        parameter->setValue((const Texture::Sampler**)&_samplers[0], (unsigned int)_samplers.size());
+    }
+
+    std::vector<VertexAttributeBinding*> bindings;
+    drawPasses(_levels[0], material, &bindings, false);
+    for (size_t i = 0, count = bindings.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(bindings[i]);
+    }
+    SAFE_RELEASE(material);
+}
+
+void TerrainPatch::clearCompositeBindings()
+{
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        std::vector<VertexAttributeBinding*>& bindings = _levels[i]->compositeBindings;
+        for (size_t j = 0, bindingCount = bindings.size(); j < bindingCount; ++j)
+        {
+            SAFE_RELEASE(bindings[j]);
+        }
+        bindings.clear();
+    }
 }
 
 const BoundingBox& TerrainPatch::getBoundingBox(bool worldSpace) const
@@ -605,6 +969,23 @@ void TerrainPatch::cameraChanged(Camera* camera)
 }
 
 unsigned int TerrainPatch::computeLOD(Camera* camera, const BoundingBox& worldBounds) 
+{
+    setCamera(camera);
+
+    // base level
+    if (!_terrain->isFlagSet(Terrain::LEVEL_OF_DETAIL) || _levels.size() == 0)
+        return 0;
+
+    if (!(_bits & TERRAINPATCH_DIRTY_LEVEL))
+        return _level;
+
+    _bits &= ~TERRAINPATCH_DIRTY_LEVEL;
+
+    _level = _terrain->computeLevel(camera, worldBounds, (unsigned int)_levels.size());
+    return _level;
+}
+
+void TerrainPatch::setCamera(Camera* camera)
 {
     if (camera != _camera)
     {
@@ -618,49 +999,6 @@ unsigned int TerrainPatch::computeLOD(Camera* camera, const BoundingBox& worldBo
         _camera->addListener(this);
         _bits |= TERRAINPATCH_DIRTY_LEVEL;
     }
-
-    // base level
-    if (!_terrain->isFlagSet(Terrain::LEVEL_OF_DETAIL) || _levels.size() == 0)
-        return 0;
-
-    if (!(_bits & TERRAINPATCH_DIRTY_LEVEL))
-        return _level;
-
-    _bits &= ~TERRAINPATCH_DIRTY_LEVEL;
-
-    // Compute LOD to use based on very simple distance metric. TODO: Optimize me.
-    Game* game = Game::getInstance();
-    Rectangle vp(0, 0, game->getWidth(), game->getHeight());
-    Vector3 corners[8];
-    Vector2 min(FLT_MAX, FLT_MAX);
-    Vector2 max(-FLT_MAX, -FLT_MAX);
-    worldBounds.getCorners(corners);
-    for (unsigned int i = 0; i < 8; ++i)
-    {
-        const Vector3& corner = corners[i];
-        float x, y;
-        camera->project(vp, corners[i], &x, &y);
-        if (x < min.x)
-            min.x = x;
-        if (y < min.y)
-            min.y = y;
-        if (x > max.x)
-            max.x = x;
-        if (y > max.y)
-            max.y = y;
-    }
-    float area = (max.x - min.x) * (max.y - min.y);
-    float screenArea = game->getWidth() * game->getHeight() / 10.0f;
-    float error = screenArea / area;
-
-    // Level LOD based on distance from camera
-    size_t maxLod = _levels.size()-1;
-    size_t lod = (size_t)error;
-    lod = std::max(lod, (size_t)0);
-    lod = std::min(lod, maxLod);
-    _level = lod;
-
-    return _level;
 }
 
 const Vector3& TerrainPatch::getAmbientColor() const
@@ -674,6 +1012,11 @@ void TerrainPatch::setMaterialDirty()
     _bits |= TERRAINPATCH_DIRTY_MATERIAL;
 }
 
+void TerrainPatch::setBoundsDirty()
+{
+    _bits |= TERRAINPATCH_DIRTY_BOUNDS | TERRAINPATCH_DIRTY_LEVEL;
+}
+
 float TerrainPatch::computeHeight(float* heights, unsigned int width, unsigned int x, unsigned int z)
 {
     return heights[z * width + x] * _terrain->_localScale.y;
@@ -688,7 +1031,7 @@ TerrainPatch::Layer::~Layer()
 {
 }
 
-TerrainPatch::Level::Level() : model(NULL)
+TerrainPatch::Level::Level() : model(NULL), partIndex(-1)
 {
 }
 
@@ -52,6 +52,13 @@ public:
      */
     static std::string passCallback(Pass* pass, void* cookie);
 
+    /**
+     * Internal use only.
+     *
+     * @script{ignore}
+     */
+    static std::string bakePassCallback(Pass* pass, void* cookie);
+
 private:
 
     /**
@@ -96,6 +103,8 @@ private:
     struct Level
     {
         Model* model;
+        int partIndex;
+        std::vector<VertexAttributeBinding*> compositeBindings;
 
         Level();
     };
@@ -109,12 +118,16 @@ private:
                                 unsigned int row, unsigned int column,
                                 float* heights, unsigned int width, unsigned int height,
                                 unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
-                                float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize);
+                                float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize, bool morph);
 
     void addLOD(float* heights, unsigned int width, unsigned int height,
                 unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
                 float xOffset, float zOffset, unsigned int step, float verticalSkirtSize);
 
+    void addMorphLODs(float* heights, unsigned int width, unsigned int height,
+                      unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+                      float xOffset, float zOffset, unsigned int levelCount);
+
 
     bool setLayer(int index, const char* texturePath, const Vector2& textureRepeat, const char* blendPath, int blendChannel);
 
@@ -122,21 +135,40 @@ private:
 
     int addSampler(const char* path);
 
-    unsigned int draw(bool wireframe);
+    unsigned int draw(Camera* camera, bool wireframe, int level);
+
+    /**
+     * Draws a level of detail with the passes of another material, binding the mesh to each pass.
+     */
+    void drawPasses(Level* level, Material* material, std::vector<VertexAttributeBinding*>* bindings, bool wireframe);
+
+    /**
+     * Draws the layers of the base level of detail over the region of the patch in the terrain composite.
+     */
+    void bakeComposite();
+
+    /**
+     * Releases the vertex bindings of the levels to the composite materials.
+     */
+    void clearCompositeBindings();
 
     bool updateMaterial();
 
     unsigned int computeLOD(Camera* camera, const BoundingBox& worldBounds);
 
+    void setCamera(Camera* camera);
+
     const Vector3& getAmbientColor() const;
 
     void setMaterialDirty();
 
+    void setBoundsDirty();
+
     float computeHeight(float* heights, unsigned int width, unsigned int x, unsigned int z);
 
     void updateNodeBindings();
 
-    std::string passCreated(Pass* pass);
+    std::string passCreated(Pass* pass, bool bake);
 
     Terrain* _terrain;
     unsigned int _index;
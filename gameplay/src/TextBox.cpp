@@ -9,13 +9,20 @@ static bool space(char c)
     return isspace(c);
 }
 
-TextBox::TextBox() : _caretLocation(0), _lastKeypress(0), _fontSize(0), _caretImage(NULL), _passwordChar('*'), _inputMode(TEXT), _ctrlPressed(false)
+static bool isSameRectangle(const Rectangle& a, const Rectangle& b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+TextBox::TextBox() : _caretLocation(0), _lastKeypress(0), _fontSize(0), _caretImage(NULL), _passwordChar('*'), _inputMode(TEXT), _ctrlPressed(false),
+    _layoutFont(NULL), _layoutFontSize(0), _layoutAlignment(Font::ALIGN_TOP_LEFT), _layoutRightToLeft(false)
 {
     _canFocus = true;
 }
 
 TextBox::~TextBox()
 {
+    clearLayout();
 }
 
 TextBox* TextBox::create(const char* id, Theme::Style* style)
@@ -330,11 +337,10 @@ unsigned int TextBox::drawImages(Form* form, const Rectangle& clip)
 
             float caretWidth = region.width * _fontSize / region.height;
 
-            Font* font = getFont(state);
             unsigned int fontSize = getFontSize(state);
             Vector2 point;
-            font->getLocationAtIndex(getDisplayedText().c_str(), _textBounds, fontSize, &point, _caretLocation, 
-                 getTextAlignment(state), true, getTextRightToLeft(state));
+            updateLayout(state);
+            getLocationAtIndex(_caretLocation, &point);
 
             SpriteBatch* batch = _style->getTheme()->getSpriteBatch();
             startBatch(form, batch);
@@ -353,16 +359,20 @@ unsigned int TextBox::drawText(Form* form, const Rectangle& clip)
     if (_text.size() <= 0)
         return 0;
 
-    // Draw the text.
+    // Draw the text from the cached layout of its lines.
     if (_font)
     {
         Control::State state = getState();
-        const std::string displayedText = getDisplayedText();
         unsigned int fontSize = getFontSize(state);
+        updateLayout(state);
 
         SpriteBatch* batch = _font->getSpriteBatch(fontSize);
         startBatch(form, batch);
-        _font->drawText(displayedText.c_str(), _textBounds, _textColor, fontSize, getTextAlignment(state), true, getTextRightToLeft(state), &_viewportClipBounds);
+        for (size_t i = 0, count = _lines.size(); i < count; ++i)
+        {
+            if (_lines[i].text)
+                _font->drawText(_lines[i].text);
+        }
         finishBatch(form, batch);
 
         return 1;
@@ -371,6 +381,164 @@ unsigned int TextBox::drawText(Form* form, const Rectangle& clip)
     return 0;
 }
 
+void TextBox::updateLayout(State state)
+{
+    Font* font = getFont(state);
+    GP_ASSERT(font);
+    unsigned int fontSize = getFontSize(state);
+    Font::Justify alignment = getTextAlignment(state);
+    bool rightToLeft = getTextRightToLeft(state);
+    const std::string text = getDisplayedText();
+
+    // Lay out every line again when the style or the bounds change.
+    if (font != _layoutFont || fontSize != _layoutFontSize || alignment != _layoutAlignment || rightToLeft != _layoutRightToLeft ||
+        _textColor != _layoutColor || !isSameRectangle(_textBounds, _layoutBounds) || !isSameRectangle(_viewportClipBounds, _layoutClip))
+    {
+        clearLayout();
+        _layoutFont = font;
+        _layoutFontSize = fontSize;
+        _layoutAlignment = alignment;
+        _layoutRightToLeft = rightToLeft;
+        _layoutColor = _textColor;
+        _layoutBounds = _textBounds;
+        _layoutClip = _viewportClipBounds;
+    }
+
+    // Vertically centered or bottom aligned text depends on the height of all its lines, so it is laid out as one line.
+    bool topAligned = (alignment & (Font::ALIGN_VCENTER | Font::ALIGN_BOTTOM)) == 0;
+    if (!topAligned && text != _layoutText)
+    {
+        clearLayout();
+    }
+
+    if (_lines.empty())
+    {
+        _layoutText = text;
+        splitLines(0, (unsigned int)text.length(), 0);
+    }
+    else if (text != _layoutText)
+    {
+        // Find the range of the text that changed.
+        size_t oldLength = _layoutText.length();
+        size_t newLength = text.length();
+        size_t prefix = 0;
+        while (prefix < oldLength && prefix < newLength && _layoutText[prefix] == text[prefix])
+            ++prefix;
+        size_t suffix = 0;
+        while (suffix < oldLength - prefix && suffix < newLength - prefix && _layoutText[oldLength - 1 - suffix] == text[newLength - 1 - suffix])
+            ++suffix;
+        size_t oldEnd = oldLength - suffix;
+
+        // Split the lines touching the changed range again, and move the lines after them.
+        size_t first = 0;
+        while (first + 1 < _lines.size() && _lines[first].start + _lines[first].length < prefix)
+            ++first;
+        size_t last = first;
+        while (last + 1 < _lines.size() && _lines[last + 1].start <= oldEnd)
+            ++last;
+
+        int delta = (int)newLength - (int)oldLength;
+        unsigned int start = _lines[first].start;
+        unsigned int end = (unsigned int)((int)(_lines[last].start + _lines[last].length) + delta);
+        for (size_t i = first; i <= last; ++i)
+        {
+            SAFE_DELETE(_lines[i].text);
+        }
+        _lines.erase(_lines.begin() + first, _lines.begin() + last + 1);
+        for (size_t i = first, count = _lines.size(); i < count; ++i)
+        {
+            _lines[i].start = (unsigned int)((int)_lines[i].start + delta);
+        }
+
+        _layoutText = text;
+        splitLines(start, end, first);
+    }
+
+    // Lay out the lines that are new, or that moved because the lines before them wrapped differently.
+    int y = (int)_textBounds.y;
+    int bottom = (int)(_textBounds.y + _textBounds.height);
+    for (size_t i = 0, count = _lines.size(); i < count; ++i)
+    {
+        Line& line = _lines[i];
+        const std::string lineText = topAligned ? _layoutText.substr(line.start, line.length) : _layoutText;
+        if (line.height == 0)
+        {
+            // Each character wraps to at most one more line, which bounds the height of the line.
+            Rectangle bounds;
+            float maxHeight = (float)((lineText.length() + 1) * fontSize);
+            font->measureText(lineText.c_str(), Rectangle(_textBounds.x, y, _textBounds.width, maxHeight), fontSize, &bounds, alignment, true, true);
+            line.height = std::max((unsigned int)bounds.height, fontSize);
+        }
+        if (line.text && line.y != y)
+        {
+            SAFE_DELETE(line.text);
+        }
+        line.y = y;
+
+        // Only the lines in the bounds and the clip are laid out.
+        bool visible = y + (int)fontSize <= bottom && y < _viewportClipBounds.y + _viewportClipBounds.height && y + (int)line.height > _viewportClipBounds.y;
+        if (line.text == NULL && visible && line.length > 0)
+        {
+            Rectangle area = topAligned ? Rectangle(_textBounds.x, y, _textBounds.width, std::min((int)line.height, bottom - y)) : _textBounds;
+            line.text = font->createText(lineText.c_str(), area, _textColor, fontSize, alignment, true, rightToLeft, &_viewportClipBounds);
+        }
+        y += (int)line.height;
+    }
+}
+
+void TextBox::splitLines(unsigned int start, unsigned int end, size_t position)
+{
+    GP_ASSERT(end <= _layoutText.length());
+
+    bool topAligned = (_layoutAlignment & (Font::ALIGN_VCENTER | Font::ALIGN_BOTTOM)) == 0;
+    std::vector<Line> lines;
+    unsigned int lineStart = start;
+    for (unsigned int i = start; ; ++i)
+    {
+        if (i == end || (topAligned && _layoutText[i] == '\n'))
+        {
+            Line line = { lineStart, i - lineStart, 0, 0, NULL };
+            lines.push_back(line);
+            if (i == end)
+                break;
+            lineStart = i + 1;
+        }
+    }
+    _lines.insert(_lines.begin() + position, lines.begin(), lines.end());
+}
+
+void TextBox::clearLayout()
+{
+    for (size_t i = 0, count = _lines.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_lines[i].text);
+    }
+    _lines.clear();
+    _layoutText.clear();
+}
+
+void TextBox::getLocationAtIndex(unsigned int index, Vector2* point) const
+{
+    GP_ASSERT(point);
+    GP_ASSERT(_layoutFont);
+    GP_ASSERT(!_lines.empty());
+
+    // Only the line holding the character is measured.
+    size_t i = 0;
+    while (i + 1 < _lines.size() && _lines[i + 1].start <= index)
+        ++i;
+    const Line& line = _lines[i];
+    if ((_layoutAlignment & (Font::ALIGN_VCENTER | Font::ALIGN_BOTTOM)) != 0)
+    {
+        _layoutFont->getLocationAtIndex(_layoutText.c_str(), _textBounds, _layoutFontSize, point, index, _layoutAlignment, true, _layoutRightToLeft);
+        return;
+    }
+    const std::string lineText = _layoutText.substr(line.start, line.length);
+    Rectangle area(_textBounds.x, line.y, _textBounds.width, line.height);
+    _layoutFont->getLocationAtIndex(lineText.c_str(), area, _layoutFontSize, point, std::min(index - line.start, line.length),
+        _layoutAlignment, true, _layoutRightToLeft);
+}
+
 void TextBox::setCaretLocation(int x, int y)
 {
     Control::State state = getState();
@@ -434,8 +602,8 @@ void TextBox::getCaretLocation(Vector2* p)
 {
     GP_ASSERT(p);
 
-    State state = getState();
-    getFont(state)->getLocationAtIndex(getDisplayedText().c_str(), _textBounds, getFontSize(state), p, _caretLocation, getTextAlignment(state), true, getTextRightToLeft(state));
+    updateLayout(getState());
+    getLocationAtIndex(_caretLocation, p);
 }
 
 const char* TextBox::getType() const
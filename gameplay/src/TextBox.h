@@ -238,6 +238,18 @@ protected:
 
 private:
 
+    /**
+     * Defines the cached layout of a line of the displayed text, up to a line break.
+     */
+    struct Line
+    {
+        unsigned int start;
+        unsigned int length;
+        unsigned int height;
+        int y;
+        Font::Text* text;
+    };
+
     /**
      * Constructor.
      */
@@ -246,6 +258,39 @@ private:
     void setCaretLocation(int x, int y);
 
     void getCaretLocation(Vector2* p);
+
+    /**
+     * Updates the cached layout of the displayed text, laying out only the lines that changed.
+     */
+    void updateLayout(State state);
+
+    /**
+     * Deletes the cached layout.
+     */
+    void clearLayout();
+
+    /**
+     * Splits the displayed text from start to end into lines, inserted before the given line.
+     */
+    void splitLines(unsigned int start, unsigned int end, size_t position);
+
+    /**
+     * Returns the location of the character at the given index of the displayed text, using the cached layout.
+     */
+    void getLocationAtIndex(unsigned int index, Vector2* point) const;
+
+    /**
+     * The cached layout of the displayed text, and the text and style it was laid out with.
+     */
+    std::vector<Line> _lines;
+    std::string _layoutText;
+    Font* _layoutFont;
+    unsigned int _layoutFontSize;
+    Font::Justify _layoutAlignment;
+    bool _layoutRightToLeft;
+    Rectangle _layoutBounds;
+    Rectangle _layoutClip;
+    Vector4 _layoutColor;
 };
 
 }
@@ -2,6 +2,12 @@
 #include "Image.h"
 #include "Texture.h"
 #include "FileSystem.h"
+#include "Game.h"
+#include "JobScheduler.h"
+#include "CommandBuffer.h"
+#include "MemoryTracker.h"
+#include "GraphicsMemory.h"
+#include "GLStateCache.h"
 
 // PVRTC (GL_IMG_texture_compression_pvrtc) : Imagination based gpus
 #ifndef GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG
@@ -47,61 +53,250 @@
 namespace gameplay
 {
 
-static std::vector<Texture*> __textureCache;
+// The largest size of the levels loaded when a streamed texture is created.
+#define STREAMING_MIN_SIZE 64
+
+// The number of frames a streamed texture must go undrawn before it drops back to its smallest levels.
+#define STREAMING_IDLE_FRAMES 300
+
+// The maximum number of streamed textures whose larger levels are loaded each frame.
+#define STREAMING_LOADS_PER_FRAME 2
+
+// Default time (in milliseconds) spent per frame uploading asynchronously loaded textures
+#define TEXTURE_ASYNC_LOAD_BUDGET 4.0f
+
+static std::multimap<unsigned int, Texture*> __textureCache;
+static Mutex __textureCacheMutex;
 static TextureHandle __currentTextureId;
+static unsigned int __streamingBudget = 0;
+static unsigned int __streamingFrame = 0;
+static float __streamingScreenSize = 0.0f;
+
+/**
+ * Returns the FNV-1a hash of a texture path, by which the texture cache is indexed.
+ */
+static unsigned int hashPath(const char* path)
+{
+    unsigned int hash = 2166136261u;
+    for (; *path; ++path)
+    {
+        hash = (hash ^ (unsigned char)*path) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Returns the size of the pixels of the base level of an uncompressed texture.
+ */
+static unsigned int getDataSize(Texture::Format format, unsigned int width, unsigned int height)
+{
+    return width * height * (format == Texture::ALPHA ? 1 : (format == Texture::RGB ? 3 : 4));
+}
+
+#ifdef USE_SAMPLER_OBJECTS
+/**
+ * Defines a GL sampler object, shared by the samplers with the same state.
+ */
+struct SamplerObject
+{
+    Texture::Filter minFilter;
+    Texture::Filter magFilter;
+    Texture::Wrap wrapS;
+    Texture::Wrap wrapT;
+    GLuint handle;
+};
+
+static std::vector<SamplerObject> __samplerObjects;
 
-Texture::Texture() : _handle(0), _format(UNKNOWN), _width(0), _height(0), _mipmapped(false), _cached(false), _compressed(false),
-    _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _minFilter(Texture::NEAREST_MIPMAP_LINEAR), _magFilter(Texture::LINEAR)
+// Creates the GL sampler object of a sampler state.
+static void createSamplerObject(SamplerObject* object)
+{
+    object->handle = 0;
+    GL_ASSERT( glGenSamplers(1, &object->handle) );
+    GL_ASSERT( glSamplerParameteri(object->handle, GL_TEXTURE_MIN_FILTER, (GLenum)object->minFilter) );
+    GL_ASSERT( glSamplerParameteri(object->handle, GL_TEXTURE_MAG_FILTER, (GLenum)object->magFilter) );
+    GL_ASSERT( glSamplerParameteri(object->handle, GL_TEXTURE_WRAP_S, (GLenum)object->wrapS) );
+    GL_ASSERT( glSamplerParameteri(object->handle, GL_TEXTURE_WRAP_T, (GLenum)object->wrapT) );
+}
+
+// Returns the index (plus one) of the sampler object with the specified state, creating it the first time it is requested.
+// Samplers keep the index rather than the handle, so the objects can be recreated after the GL context is lost.
+static unsigned int getSamplerObject(Texture::Filter minFilter, Texture::Filter magFilter, Texture::Wrap wrapS, Texture::Wrap wrapT)
+{
+    // Materials only use a handful of distinct sampler states.
+    for (size_t i = 0, count = __samplerObjects.size(); i < count; ++i)
+    {
+        const SamplerObject& object = __samplerObjects[i];
+        if (object.minFilter == minFilter && object.magFilter == magFilter && object.wrapS == wrapS && object.wrapT == wrapT)
+            return (unsigned int)i + 1;
+    }
+
+    SamplerObject object;
+    object.minFilter = minFilter;
+    object.magFilter = magFilter;
+    object.wrapS = wrapS;
+    object.wrapT = wrapT;
+    createSamplerObject(&object);
+    __samplerObjects.push_back(object);
+    return (unsigned int)__samplerObjects.size();
+}
+#endif
+
+struct Texture::AsyncLoad
+{
+    AsyncLoad();
+    ~AsyncLoad();
+
+    std::string path;
+    bool generateMipmaps;
+    TextureLoadCallback callback;
+    void* cookie;
+    JobScheduler::Group group;
+    bool queued;
+    // The texture restored by the load after the GL context was lost, or NULL for a new texture.
+    Texture* restore;
+    // Written by the decoding job and read once 'decoded' is set (guarded by _asyncMutex).
+    Image* image;
+    bool decoded;
+};
+
+std::vector<Texture::AsyncLoad*> Texture::_asyncLoads;
+Mutex Texture::_asyncMutex;
+float Texture::_asyncLoadBudget = TEXTURE_ASYNC_LOAD_BUDGET;
+
+Texture::Texture() : GraphicsResource(RESTORE_TEXTURES), _handle(0), _type(TEXTURE_2D), _format(UNKNOWN), _width(0), _height(0), _mipmapped(false), _cached(false), _compressed(false),
+    _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _minFilter(Texture::NEAREST_MIPMAP_LINEAR), _magFilter(Texture::LINEAR),
+    _memorySize(0), _memoryCategory(GraphicsMemory::TEXTURE), _levelCount(1), _residentLevel(0), _streamed(false), _minStreamingLevel(0), _requestedLevel(0),
+    _frameRequestedLevel(0), _lastUsedFrame(0), _retainedData(NULL)
 {
 }
 
 Texture::~Texture()
 {
+    GraphicsMemory::untrack(_memoryCategory, _memorySize);
+
+    if (_retainedData)
+    {
+        releaseMemory(getDataSize(_format, _width, _height));
+        SAFE_DELETE_ARRAY(_retainedData);
+    }
+
     if (_handle)
     {
-        GL_ASSERT( glDeleteTextures(1, &_handle) );
+        GLStateCache::deleteTexture(_handle);
         _handle = 0;
     }
 
     // Remove ourself from the texture cache.
     if (_cached)
     {
-        std::vector<Texture*>::iterator itr = std::find(__textureCache.begin(), __textureCache.end(), this);
-        if (itr != __textureCache.end())
+        Mutex::Lock lock(__textureCacheMutex);
+        std::pair<std::multimap<unsigned int, Texture*>::iterator, std::multimap<unsigned int, Texture*>::iterator> range =
+            __textureCache.equal_range(hashPath(_path.c_str()));
+        for (std::multimap<unsigned int, Texture*>::iterator itr = range.first; itr != range.second; ++itr)
         {
-            __textureCache.erase(itr);
+            if (itr->second == this)
+            {
+                __textureCache.erase(itr);
+                break;
+            }
         }
     }
 }
 
-Texture* Texture::create(const char* path, bool generateMipmaps)
+Texture* Texture::findCached(const char* path)
 {
     GP_ASSERT(path);
 
-    // Search texture cache first.
-    for (size_t i = 0, count = __textureCache.size(); i < count; ++i)
+    Mutex::Lock lock(__textureCacheMutex);
+    std::pair<std::multimap<unsigned int, Texture*>::iterator, std::multimap<unsigned int, Texture*>::iterator> range =
+        __textureCache.equal_range(hashPath(path));
+    for (std::multimap<unsigned int, Texture*>::iterator itr = range.first; itr != range.second; ++itr)
     {
-        Texture* t = __textureCache[i];
+        Texture* t = itr->second;
         GP_ASSERT(t);
         if (t->_path == path)
         {
-            // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
-            // texture to generate its mipmap chain if it hasn't already done so.
-            if (generateMipmaps)
-            {
-                t->generateMipmaps();
-            }
+            return t;
+        }
+    }
+    return NULL;
+}
 
-            // Found a match.
-            t->addRef();
+Texture* Texture::findCachedRef(const char* path)
+{
+    GP_ASSERT(path);
 
+    Mutex::Lock lock(__textureCacheMutex);
+    std::pair<std::multimap<unsigned int, Texture*>::iterator, std::multimap<unsigned int, Texture*>::iterator> range =
+        __textureCache.equal_range(hashPath(path));
+    for (std::multimap<unsigned int, Texture*>::iterator itr = range.first; itr != range.second; ++itr)
+    {
+        Texture* t = itr->second;
+        GP_ASSERT(t);
+
+        // A texture released by another thread stays in the cache until its destructor removes it.
+        if (t->_path == path && t->tryAddRef())
+        {
             return t;
         }
     }
+    return NULL;
+}
 
-    Texture* texture = NULL;
+Texture* Texture::create(const char* path, bool generateMipmaps)
+{
+    GP_ASSERT(path);
+
+    MemoryTracker::Scope scope(MemoryTracker::TEXTURE);
+
+    // Search texture cache first.
+    Texture* t = findCachedRef(path);
+    if (t)
+    {
+        // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
+        // texture to generate its mipmap chain if it hasn't already done so.
+        if (generateMipmaps)
+        {
+            t->generateMipmaps();
+        }
+
+        return t;
+    }
+
+    // Streamed textures start with only their smallest levels loaded.
+    unsigned int maxSize = __streamingBudget > 0 ? STREAMING_MIN_SIZE : 0;
+    Texture* texture = createFromFile(path, generateMipmaps, maxSize);
+    if (texture)
+    {
+        texture->_path = path;
+        texture->_cached = true;
+        if (maxSize > 0 && texture->_levelCount > 1)
+        {
+            texture->_streamed = true;
+            texture->_minStreamingLevel = texture->_residentLevel;
+            texture->_requestedLevel = texture->_residentLevel;
+            texture->_frameRequestedLevel = texture->_levelCount;
+            texture->_lastUsedFrame = __streamingFrame;
+        }
+
+        // Add to texture cache.
+        Mutex::Lock lock(__textureCacheMutex);
+        __textureCache.insert(std::make_pair(hashPath(path), texture));
+
+        return texture;
+    }
+
+    GP_ERROR("Failed to load texture from file '%s'.", path);
+    return NULL;
+}
+
+Texture* Texture::createFromFile(const char* path, bool generateMipmaps, unsigned int maxSize)
+{
+    GP_ASSERT(path);
 
     // Filter loading based on file extension.
+    Texture* texture = NULL;
     const char* ext = strrchr(FileSystem::resolvePath(path), '.');
     if (ext)
     {
@@ -112,48 +307,223 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
             {
                 Image* image = Image::create(path);
                 if (image)
-                    texture = create(image, generateMipmaps);
+                    texture = createFromImage(image, generateMipmaps);
                 SAFE_RELEASE(image);
             }
             else if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'v' && tolower(ext[3]) == 'r')
             {
                 // PowerVR Compressed Texture RGBA.
-                texture = createCompressedPVRTC(path);
+                texture = createCompressedPVRTC(path, maxSize);
             }
             else if (tolower(ext[1]) == 'd' && tolower(ext[2]) == 'd' && tolower(ext[3]) == 's')
             {
                 // DDS file format (DXT/S3TC) compressed textures
-                texture = createCompressedDDS(path);
+                texture = createCompressedDDS(path, maxSize);
+            }
+            else if (tolower(ext[1]) == 'k' && tolower(ext[2]) == 't' && tolower(ext[3]) == 'x')
+            {
+                // KTX container (ETC2/EAC, ASTC or any other GL format)
+                texture = createCompressedKTX(path, maxSize);
             }
             break;
         }
     }
 
+    return texture;
+}
+
+void Texture::createAsync(const char* path, TextureLoadCallback callback, void* cookie, bool generateMipmaps)
+{
+    GP_ASSERT(path);
+
+    AsyncLoad* load = new AsyncLoad();
+    load->path = path;
+    load->generateMipmaps = generateMipmaps;
+    load->callback = callback;
+    load->cookie = cookie;
+    _asyncLoads.push_back(load);
+
+    // Only PNG images need decoding; other files are read when they are uploaded.
+    const char* ext = strrchr(FileSystem::resolvePath(path), '.');
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (findCached(path) == NULL && scheduler && ext && strlen(ext) == 4 &&
+        tolower(ext[1]) == 'p' && tolower(ext[2]) == 'n' && tolower(ext[3]) == 'g')
+    {
+        load->queued = true;
+        scheduler->run(load->group, decodeAsyncLoad, load);
+    }
+    else
+    {
+        Mutex::Lock lock(_asyncMutex);
+        load->decoded = true;
+    }
+}
+
+unsigned int Texture::getAsyncLoadCount()
+{
+    return (unsigned int)_asyncLoads.size();
+}
+
+void Texture::setAsyncLoadBudget(float milliseconds)
+{
+    _asyncLoadBudget = milliseconds;
+}
+
+void Texture::decodeAsyncLoad(void* arg)
+{
+    AsyncLoad* load = (AsyncLoad*)arg;
+    GP_ASSERT(load);
+
+    MemoryTracker::Scope scope(MemoryTracker::TEXTURE);
+    Image* image = Image::create(load->path.c_str());
+
+    Mutex::Lock lock(_asyncMutex);
+    load->image = image;
+    load->decoded = true;
+}
+
+void Texture::updateAsyncLoads()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    double startTime = Game::getAbsoluteTime();
+    bool busy = false;
+    for (size_t i = 0; i < _asyncLoads.size();)
+    {
+        if (busy && Game::getAbsoluteTime() - startTime >= _asyncLoadBudget)
+            return;
+
+        AsyncLoad* load = _asyncLoads[i];
+        bool decoded;
+        {
+            Mutex::Lock lock(_asyncMutex);
+            decoded = load->decoded;
+        }
+        if (!decoded && scheduler && scheduler->getWorkerCount() > 0)
+        {
+            ++i;
+            continue;
+        }
+
+        // Without worker threads the decoding job only runs once it is waited on.
+        if (load->queued)
+        {
+            GP_ASSERT(scheduler);
+            scheduler->wait(load->group);
+        }
+
+        // Another load may have created the texture in the meantime. The load is removed
+        // first so the callback may start new loads.
+        _asyncLoads.erase(_asyncLoads.begin() + i);
+        if (load->restore)
+        {
+            load->restore->finishRestore(load->image);
+            SAFE_DELETE(load);
+            busy = true;
+            continue;
+        }
+        Texture* texture = findCachedRef(load->path.c_str());
+        if (texture)
+        {
+            if (load->generateMipmaps)
+                texture->generateMipmaps();
+        }
+        else if (load->image)
+        {
+            texture = createCached(load->path.c_str(), load->image, load->generateMipmaps);
+        }
+        else if (load->queued)
+        {
+            GP_ERROR("Failed to decode texture from file '%s'.", load->path.c_str());
+        }
+        else
+        {
+            texture = create(load->path.c_str(), load->generateMipmaps);
+        }
+        if (load->callback)
+        {
+            load->callback(texture, load->cookie);
+        }
+        SAFE_RELEASE(texture);
+        SAFE_DELETE(load);
+        busy = true;
+    }
+}
+
+Texture* Texture::createCached(const char* path, Image* image, bool generateMipmaps)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(image);
+
+    Texture* texture = createFromImage(image, generateMipmaps);
     if (texture)
     {
         texture->_path = path;
         texture->_cached = true;
+        Mutex::Lock lock(__textureCacheMutex);
+        __textureCache.insert(std::make_pair(hashPath(path), texture));
+    }
+    return texture;
+}
 
-        // Add to texture cache.
-        __textureCache.push_back(texture);
+void Texture::releaseSamplerObjects()
+{
+#ifdef USE_SAMPLER_OBJECTS
+    for (size_t i = 0, count = __samplerObjects.size(); i < count; ++i)
+    {
+        GLStateCache::deleteSampler(__samplerObjects[i].handle);
+    }
+    __samplerObjects.clear();
+#endif
+}
 
-        return texture;
+void Texture::cancelAsyncLoads()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = _asyncLoads.size(); i < count; ++i)
+    {
+        if (_asyncLoads[i]->queued)
+        {
+            GP_ASSERT(scheduler);
+            scheduler->wait(_asyncLoads[i]->group);
+        }
+        SAFE_DELETE(_asyncLoads[i]);
     }
+    _asyncLoads.clear();
+}
 
-    GP_ERROR("Failed to load texture from file '%s'.", path);
-    return NULL;
+Texture::AsyncLoad::AsyncLoad()
+    : generateMipmaps(false), callback(NULL), cookie(NULL), queued(false), restore(NULL), image(NULL), decoded(false)
+{
+}
+
+Texture::AsyncLoad::~AsyncLoad()
+{
+    SAFE_RELEASE(restore);
+    SAFE_RELEASE(image);
 }
 
 Texture* Texture::create(Image* image, bool generateMipmaps)
 {
     GP_ASSERT(image);
 
+    Texture* texture = createFromImage(image, generateMipmaps);
+    if (texture)
+    {
+        texture->retainData(image->getData());
+    }
+    return texture;
+}
+
+Texture* Texture::createFromImage(Image* image, bool generateMipmaps)
+{
+    GP_ASSERT(image);
+
     switch (image->getFormat())
     {
     case Image::RGB:
-        return create(Texture::RGB, image->getWidth(), image->getHeight(), image->getData(), generateMipmaps);
+        return createFromData(Texture::RGB, image->getWidth(), image->getHeight(), image->getData(), generateMipmaps);
     case Image::RGBA:
-        return create(Texture::RGBA, image->getWidth(), image->getHeight(), image->getData(), generateMipmaps);
+        return createFromData(Texture::RGBA, image->getWidth(), image->getHeight(), image->getData(), generateMipmaps);
     default:
         GP_ERROR("Unsupported image format (%d).", image->getFormat());
         return NULL;
@@ -162,10 +532,23 @@ Texture* Texture::create(Image* image, bool generateMipmaps)
 
 Texture* Texture::create(Format format, unsigned int width, unsigned int height, const unsigned char* data, bool generateMipmaps)
 {
-    // Create and load the texture.
+    Texture* texture = createFromData(format, width, height, data, generateMipmaps);
+    if (texture && data)
+    {
+        texture->retainData(data);
+    }
+    return texture;
+}
+
+/**
+ * Creates and binds a GL texture holding the base level of an uncompressed texture,
+ * whose pixels are undefined if data is NULL.
+ */
+static GLuint createTextureObject(Texture::Format format, unsigned int width, unsigned int height, const unsigned char* data, bool generateMipmaps)
+{
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, textureId);
     GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
 #ifndef OPENGL_ES
     // glGenerateMipmap is new in OpenGL 3.0. For OpenGL 2.0 we must fallback to use glTexParameteri
@@ -176,22 +559,72 @@ Texture* Texture::create(Format format, unsigned int width, unsigned int height,
     GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, (GLenum)format, width, height, 0, (GLenum)format, GL_UNSIGNED_BYTE, data) );
 
     // Set initial minification filter based on whether or not mipmaping was enabled.
-    Filter minFilter = generateMipmaps ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    Texture::Filter minFilter = generateMipmaps ? Texture::NEAREST_MIPMAP_LINEAR : Texture::LINEAR;
     GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter) );
+    return textureId;
+}
+
+Texture* Texture::createFromData(Format format, unsigned int width, unsigned int height, const unsigned char* data, bool generateMipmaps)
+{
+    // Create and load the texture.
+    GLuint textureId = createTextureObject(format, width, height, data, generateMipmaps);
 
     Texture* texture = new Texture();
     texture->_handle = textureId;
     texture->_format = format;
     texture->_width = width;
     texture->_height = height;
-    texture->_minFilter = minFilter;
+    texture->_minFilter = generateMipmaps ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    texture->_memorySize = getDataSize(format, width, height);
+    GraphicsMemory::track(GraphicsMemory::TEXTURE, texture->_memorySize);
     if (generateMipmaps)
     {
         texture->generateMipmaps();
     }
 
     // Restore the texture id
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, __currentTextureId) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
+
+    return texture;
+}
+
+/**
+ * Creates and binds a GL cube map texture whose six faces have undefined pixels.
+ */
+static GLuint createCubeTextureObject(Texture::Format format, unsigned int size)
+{
+    GLuint textureId;
+    GL_ASSERT( glGenTextures(1, &textureId) );
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, textureId);
+    for (unsigned int face = 0; face < 6; ++face)
+    {
+        GL_ASSERT( glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, (GLenum)format, size, size, 0, (GLenum)format, GL_UNSIGNED_BYTE, NULL) );
+    }
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE) );
+    return textureId;
+}
+
+Texture* Texture::createCube(Format format, unsigned int size)
+{
+    GP_ASSERT(size > 0);
+
+    GLuint textureId = createCubeTextureObject(format, size);
+
+    Texture* texture = new Texture();
+    texture->_handle = textureId;
+    texture->_type = TEXTURE_CUBE;
+    texture->_format = format;
+    texture->_width = size;
+    texture->_height = size;
+    texture->_minFilter = LINEAR;
+    texture->_wrapS = CLAMP;
+    texture->_wrapT = CLAMP;
+    texture->_memorySize = getDataSize(format, size, size) * 6;
+    GraphicsMemory::track(GraphicsMemory::TEXTURE, texture->_memorySize);
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
 
     return texture;
 }
@@ -232,7 +665,7 @@ static unsigned int computePVRTCDataSize(int width, int height, int bpp)
     return widthBlocks * heightBlocks * ((blockSize  * bpp) >> 3);
 }
 
-Texture* Texture::createCompressedPVRTC(const char* path)
+Texture* Texture::createCompressedPVRTC(const char* path, unsigned int maxSize)
 {
     std::auto_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
@@ -286,7 +719,7 @@ Texture* Texture::createCompressedPVRTC(const char* path)
     // Generate our texture.
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, textureId);
 
     Filter minFilter = mipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
     GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter) );
@@ -298,15 +731,25 @@ Texture* Texture::createCompressedPVRTC(const char* path)
     texture->_mipmapped = mipMapCount > 1;
     texture->_compressed = true;
     texture->_minFilter = minFilter;
+    texture->_levelCount = mipMapCount;
 
-    // Load the data for each level.
+    // Load the data for each level, skipping the ones larger than the requested size.
     GLubyte* ptr = data;
     for (unsigned int level = 0; level < mipMapCount; ++level)
     {
         unsigned int dataSize = computePVRTCDataSize(width, height, bpp);
 
-        // Upload data to GL.
-        GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, dataSize, ptr) );
+        if (maxSize > 0 && (unsigned int)std::max(width, height) > maxSize && level + 1 < mipMapCount)
+        {
+            texture->_residentLevel = level + 1;
+        }
+        else
+        {
+            // Upload data to GL.
+            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, level - texture->_residentLevel, format, width, height, 0, dataSize, ptr) );
+            texture->_memorySize += dataSize;
+            GraphicsMemory::track(GraphicsMemory::TEXTURE, dataSize);
+        }
 
         width = std::max(width >> 1, 1);
         height = std::max(height >> 1, 1);
@@ -511,7 +954,7 @@ int Texture::getMaskByteIndex(unsigned int mask)
     }
 }
 
-Texture* Texture::createCompressedDDS(const char* path)
+Texture* Texture::createCompressedDDS(const char* path, unsigned int maxSize)
 {
     GP_ASSERT(path);
 
@@ -786,7 +1229,7 @@ Texture* Texture::createCompressedDDS(const char* path)
     // Generate GL texture.
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    GLStateCache::bindTexture(GL_TEXTURE_2D, textureId);
 
     Filter minFilter = header.dwMipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
     GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter ) );
@@ -799,18 +1242,27 @@ Texture* Texture::createCompressedDDS(const char* path)
     texture->_compressed = compressed;
     texture->_mipmapped = header.dwMipMapCount > 1;
     texture->_minFilter = minFilter;
+    texture->_levelCount = header.dwMipMapCount;
 
-    // Load texture data.
+    // Load texture data, skipping the levels larger than the requested size.
     for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
     {
         dds_mip_level& level = mipLevels[i];
-        if (compressed)
+        if (maxSize > 0 && (unsigned int)std::max(level.width, level.height) > maxSize && i + 1 < header.dwMipMapCount)
+        {
+            texture->_residentLevel = i + 1;
+        }
+        else if (compressed)
         {
-            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, level.size, level.data) );
+            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, i - texture->_residentLevel, format, level.width, level.height, 0, level.size, level.data) );
+            texture->_memorySize += level.size;
+            GraphicsMemory::track(GraphicsMemory::TEXTURE, level.size);
         }
         else
         {
-            GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data) );
+            GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, i - texture->_residentLevel, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data) );
+            texture->_memorySize += level.size;
+            GraphicsMemory::track(GraphicsMemory::TEXTURE, level.size);
         }
 
         // Clean up the texture data.
@@ -823,6 +1275,167 @@ Texture* Texture::createCompressedDDS(const char* path)
     return texture;
 }
 
+Texture* Texture::createCompressedKTX(const char* path, unsigned int maxSize)
+{
+    GP_ASSERT(path);
+
+    // KTX file header.
+    struct ktx_header
+    {
+        unsigned char identifier[12];
+        unsigned int endianness;
+        unsigned int glType;
+        unsigned int glTypeSize;
+        unsigned int glFormat;
+        unsigned int glInternalFormat;
+        unsigned int glBaseInternalFormat;
+        unsigned int pixelWidth;
+        unsigned int pixelHeight;
+        unsigned int pixelDepth;
+        unsigned int numberOfArrayElements;
+        unsigned int numberOfFaces;
+        unsigned int numberOfMipmapLevels;
+        unsigned int bytesOfKeyValueData;
+    };
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to open file '%s'.", path);
+        return NULL;
+    }
+
+    // Validate the KTX identifier and header.
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    ktx_header header;
+    if (stream->read(&header, sizeof(ktx_header), 1) != 1 || memcmp(header.identifier, identifier, sizeof(identifier)) != 0)
+    {
+        GP_ERROR("Failed to read KTX file '%s': invalid KTX header.", path);
+        return NULL;
+    }
+    if (header.endianness != 0x04030201)
+    {
+        GP_ERROR("Failed to read KTX file '%s': big endian files are not supported.", path);
+        return NULL;
+    }
+    if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || (header.numberOfFaces != 1 && header.numberOfFaces != 6))
+    {
+        GP_ERROR("Failed to read KTX file '%s': 3D textures and texture arrays are not supported.", path);
+        return NULL;
+    }
+    if (stream->seek(header.bytesOfKeyValueData, SEEK_CUR) == false)
+    {
+        GP_ERROR("Failed to skip the key/value data of KTX file '%s'.", path);
+        return NULL;
+    }
+
+    // A glType of 0 means the data is compressed in glInternalFormat.
+    bool compressed = header.glType == 0;
+    unsigned int levelCount = std::max(header.numberOfMipmapLevels, 1u);
+    Type type = header.numberOfFaces == 6 ? TEXTURE_CUBE : TEXTURE_2D;
+
+    GLuint textureId;
+    GL_ASSERT( glGenTextures(1, &textureId) );
+    GLStateCache::bindTexture((GLenum)type, textureId);
+
+    Filter minFilter = levelCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    GL_ASSERT( glTexParameteri((GLenum)type, GL_TEXTURE_MIN_FILTER, minFilter) );
+
+    Texture* texture = new Texture();
+    texture->_handle = textureId;
+    texture->_type = type;
+    texture->_width = header.pixelWidth;
+    texture->_height = header.pixelHeight;
+    texture->_compressed = compressed;
+    texture->_mipmapped = levelCount > 1;
+    texture->_minFilter = minFilter;
+    texture->_levelCount = levelCount;
+    if (!compressed)
+    {
+        if (header.glBaseInternalFormat == GL_RGB)
+            texture->_format = RGB;
+        else if (header.glBaseInternalFormat == GL_RGBA)
+            texture->_format = RGBA;
+        else if (header.glBaseInternalFormat == GL_ALPHA)
+            texture->_format = ALPHA;
+    }
+
+    // Load each level, skipping the ones larger than the requested size.
+    std::vector<GLubyte> data;
+    GLsizei width = header.pixelWidth;
+    GLsizei height = std::max(header.pixelHeight, 1u);
+    for (unsigned int i = 0; i < levelCount; ++i)
+    {
+        unsigned int imageSize;
+        if (stream->read(&imageSize, sizeof(unsigned int), 1) != 1)
+        {
+            GP_ERROR("Failed to read the size of level %d of KTX file '%s'.", i, path);
+            SAFE_RELEASE(texture);
+            return NULL;
+        }
+
+        // Each face (and level) is padded to a multiple of 4 bytes.
+        unsigned int paddedSize = (imageSize + 3) & ~3u;
+        bool skip = maxSize > 0 && (unsigned int)std::max(width, height) > maxSize && i + 1 < levelCount;
+        if (skip)
+        {
+            texture->_residentLevel = i + 1;
+        }
+        for (unsigned int face = 0; face < header.numberOfFaces; ++face)
+        {
+            if (skip)
+            {
+                if (stream->seek(paddedSize, SEEK_CUR) == false)
+                {
+                    GP_ERROR("Failed to skip level %d of KTX file '%s'.", i, path);
+                    SAFE_RELEASE(texture);
+                    return NULL;
+                }
+                continue;
+            }
+
+            data.resize(std::max(imageSize, 1u));
+            if (stream->read(&data[0], 1, imageSize) != imageSize ||
+                (paddedSize > imageSize && stream->seek(paddedSize - imageSize, SEEK_CUR) == false))
+            {
+                GP_ERROR("Failed to read level %d of KTX file '%s'.", i, path);
+                SAFE_RELEASE(texture);
+                return NULL;
+            }
+
+            GLenum target = type == TEXTURE_CUBE ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            GLint level = (GLint)(i - texture->_residentLevel);
+            if (compressed)
+            {
+                GL_ASSERT( glCompressedTexImage2D(target, level, header.glInternalFormat, width, height, 0, imageSize, &data[0]) );
+            }
+            else
+            {
+                GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 4) );
+                GL_ASSERT( glTexImage2D(target, level, header.glBaseInternalFormat, width, height, 0, header.glFormat, header.glType, &data[0]) );
+            }
+            texture->_memorySize += imageSize;
+            GraphicsMemory::track(GraphicsMemory::TEXTURE, imageSize);
+        }
+
+        width = std::max(1, width >> 1);
+        height = std::max(1, height >> 1);
+    }
+
+    // Uncompressed files without mipmaps ask for them to be generated.
+    if (header.numberOfMipmapLevels == 0 && !compressed)
+    {
+        texture->generateMipmaps();
+    }
+
+    return texture;
+}
+
+Texture::Type Texture::getType() const
+{
+    return _type;
+}
+
 Texture::Format Texture::getFormat() const
 {
     return _format;
@@ -852,11 +1465,18 @@ void Texture::generateMipmaps()
 {
     if (!_mipmapped)
     {
-        GL_ASSERT( glBindTexture(GL_TEXTURE_2D, _handle) );
+        GLStateCache::bindTexture((GLenum)_type, _handle);
         GL_ASSERT( glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST) );
         if (glGenerateMipmap)
-            GL_ASSERT( glGenerateMipmap(GL_TEXTURE_2D) );
+            GL_ASSERT( glGenerateMipmap((GLenum)_type) );
 
+        // The smaller levels hold about a third of the memory of the base level.
+        if (!_compressed)
+        {
+            unsigned int levelsSize = _memorySize / 3;
+            _memorySize += levelsSize;
+            GraphicsMemory::track(_memoryCategory, levelsSize);
+        }
         _mipmapped = true;
     }
 }
@@ -871,8 +1491,313 @@ bool Texture::isCompressed() const
     return _compressed;
 }
 
+void Texture::setStreamingBudget(unsigned int bytes)
+{
+    __streamingBudget = bytes;
+}
+
+unsigned int Texture::getStreamingBudget()
+{
+    return __streamingBudget;
+}
+
+unsigned int Texture::getStreamingMemory()
+{
+    unsigned int memory = 0;
+    Mutex::Lock lock(__textureCacheMutex);
+    for (std::multimap<unsigned int, Texture*>::const_iterator itr = __textureCache.begin(); itr != __textureCache.end(); ++itr)
+    {
+        if (itr->second->_streamed)
+            memory += itr->second->_memorySize;
+    }
+    return memory;
+}
+
+bool Texture::isStreamed() const
+{
+    return _streamed;
+}
+
+unsigned int Texture::getResidentLevel() const
+{
+    return _residentLevel;
+}
+
+void Texture::setStreamingScreenSize(float size)
+{
+    __streamingScreenSize = size;
+}
+
+void Texture::requestStreamingLevel()
+{
+    GP_ASSERT(_streamed);
+
+    // Pick the level whose size matches the screen size, assuming the texture covers the model once.
+    unsigned int level = 0;
+    if (__streamingScreenSize > 0.0f)
+    {
+        float size = (float)std::max(_width, _height);
+        while (level < _minStreamingLevel && size * 0.5f >= __streamingScreenSize)
+        {
+            size *= 0.5f;
+            ++level;
+        }
+    }
+    _frameRequestedLevel = std::min(_frameRequestedLevel, level);
+    _lastUsedFrame = __streamingFrame;
+}
+
+unsigned int Texture::getStreamingMemory(unsigned int level) const
+{
+    // Each larger level holds about four times the memory of all the levels below it.
+    unsigned int memory = _memorySize;
+    for (unsigned int i = level; i < _residentLevel; ++i)
+    {
+        memory = memory > UINT_MAX / 4 ? UINT_MAX : memory * 4;
+    }
+    for (unsigned int i = _residentLevel; i < level; ++i)
+    {
+        memory /= 4;
+    }
+    return memory;
+}
+
+bool Texture::loadStreamingLevel(unsigned int level)
+{
+    GP_ASSERT(_streamed);
+    GP_ASSERT(level < _levelCount);
+
+    unsigned int maxSize = std::max(std::max(_width, _height) >> level, 1u);
+    const char* ext = strrchr(FileSystem::resolvePath(_path.c_str()), '.');
+    Texture* texture = NULL;
+    if (ext && tolower(ext[1]) == 'd')
+        texture = createCompressedDDS(_path.c_str(), maxSize);
+    else if (ext && tolower(ext[1]) == 'k')
+        texture = createCompressedKTX(_path.c_str(), maxSize);
+    else
+        texture = createCompressedPVRTC(_path.c_str(), maxSize);
+    if (texture == NULL)
+        return false;
+
+    takeOver(texture);
+    SAFE_RELEASE(texture);
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
+    return true;
+}
+
+void Texture::setMemoryCategory(GraphicsMemory::Category category)
+{
+    GraphicsMemory::untrack(_memoryCategory, _memorySize);
+    _memoryCategory = category;
+    GraphicsMemory::track(_memoryCategory, _memorySize);
+}
+
+void Texture::takeOver(Texture* texture)
+{
+    GP_ASSERT(texture);
+
+    // Take over the new GL texture, whose sampler state has not been set yet.
+    std::swap(_handle, texture->_handle);
+    std::swap(_memorySize, texture->_memorySize);
+    _residentLevel = texture->_residentLevel;
+    _mipmapped = texture->_mipmapped;
+    _minFilter = texture->_minFilter;
+    _magFilter = texture->_magFilter;
+    _wrapS = texture->_wrapS;
+    _wrapT = texture->_wrapT;
+}
+
+void Texture::retainData(const unsigned char* data)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(_retainedData == NULL);
+
+    unsigned int size = getDataSize(_format, _width, _height);
+    if (retainMemory(size))
+    {
+        _retainedData = new unsigned char[size];
+        memcpy(_retainedData, data, size);
+    }
+}
+
+void Texture::discardGraphics()
+{
+    _handle = 0;
+}
+
+void Texture::restoreGraphics()
+{
+    if (_cached)
+    {
+        // Reload the file like an asynchronous load, so images are decoded on the worker threads
+        // and only a few textures are uploaded per frame. Until then the texture samples as black.
+        AsyncLoad* load = new AsyncLoad();
+        load->path = _path;
+        load->restore = this;
+        addRef();
+        _asyncLoads.push_back(load);
+
+        const char* ext = strrchr(FileSystem::resolvePath(_path.c_str()), '.');
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (scheduler && ext && strlen(ext) == 4 && tolower(ext[1]) == 'p' && tolower(ext[2]) == 'n' && tolower(ext[3]) == 'g')
+        {
+            load->queued = true;
+            scheduler->run(load->group, decodeAsyncLoad, load);
+        }
+        else
+        {
+            Mutex::Lock lock(_asyncMutex);
+            load->decoded = true;
+        }
+        return;
+    }
+
+    if (_type == TEXTURE_CUBE && _format != UNKNOWN && !_compressed)
+    {
+        // Cube maps are only created to be drawn into, so their pixels are undefined until they are drawn again.
+        _handle = createCubeTextureObject(_format, _width);
+        _minFilter = LINEAR;
+        _magFilter = LINEAR;
+        _wrapS = CLAMP;
+        _wrapT = CLAMP;
+        GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
+        return;
+    }
+
+    if (_type != TEXTURE_2D || _format == UNKNOWN || _compressed)
+    {
+        GP_WARN("Cannot restore a texture of %ux%u pixels that was not loaded from a file.", _width, _height);
+        return;
+    }
+    // Without retained pixels (such as for render targets), the pixels are undefined until they are drawn again.
+    _handle = createTextureObject(_format, _width, _height, _retainedData, _mipmapped);
+    _minFilter = _mipmapped ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    _magFilter = LINEAR;
+    _wrapS = REPEAT;
+    _wrapT = REPEAT;
+    if (_mipmapped && glGenerateMipmap)
+    {
+        GL_ASSERT( glGenerateMipmap(GL_TEXTURE_2D) );
+    }
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
+}
+
+void Texture::finishRestore(Image* image)
+{
+    // The context may have been lost again while the file was decoded, in which case the newest load restores it.
+    if (_handle)
+        return;
+
+    Texture* texture = NULL;
+    if (image)
+    {
+        texture = createFromImage(image, _mipmapped);
+    }
+    else
+    {
+        unsigned int maxSize = _streamed ? std::max(std::max(_width, _height) >> _residentLevel, 1u) : 0;
+        texture = createFromFile(_path.c_str(), _mipmapped, maxSize);
+    }
+    if (texture == NULL)
+    {
+        GP_WARN("Failed to restore texture from file '%s'; it will be drawn empty.", _path.c_str());
+        return;
+    }
+
+    takeOver(texture);
+    SAFE_RELEASE(texture);
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, __currentTextureId);
+}
+
+void Texture::restoreSamplerObjects()
+{
+#ifdef USE_SAMPLER_OBJECTS
+    for (size_t i = 0, count = __samplerObjects.size(); i < count; ++i)
+    {
+        createSamplerObject(&__samplerObjects[i]);
+    }
+#endif
+}
+
+bool Texture::compareStreamingPriority(const Texture* a, const Texture* b)
+{
+    if (a->_lastUsedFrame != b->_lastUsedFrame)
+        return a->_lastUsedFrame > b->_lastUsedFrame;
+    return a->_requestedLevel < b->_requestedLevel;
+}
+
+void Texture::updateStreaming()
+{
+    if (__streamingBudget == 0)
+        return;
+
+    std::vector<Texture*> textures;
+    __textureCacheMutex.lock();
+    for (std::multimap<unsigned int, Texture*>::const_iterator itr = __textureCache.begin(); itr != __textureCache.end(); ++itr)
+    {
+        Texture* texture = itr->second;
+        if (texture->_streamed)
+        {
+            // Textures keep the level requested the last time they were drawn until they become idle.
+            if (texture->_lastUsedFrame == __streamingFrame)
+                texture->_requestedLevel = texture->_frameRequestedLevel;
+            else if (__streamingFrame - texture->_lastUsedFrame > STREAMING_IDLE_FRAMES)
+                texture->_requestedLevel = texture->_minStreamingLevel;
+            texture->_frameRequestedLevel = texture->_levelCount;
+            textures.push_back(texture);
+        }
+    }
+    __textureCacheMutex.unlock();
+    ++__streamingFrame;
+    if (textures.empty())
+        return;
+
+    // Give the most recently drawn textures their requested levels first, and smaller levels once the budget runs out.
+    std::sort(textures.begin(), textures.end(), compareStreamingPriority);
+    std::vector<unsigned int> levels(textures.size());
+
+    // The GPU memory budget can leave the streamed textures less than their own budget.
+    unsigned int streamingMemory = 0;
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        streamingMemory += textures[i]->_memorySize;
+    }
+    unsigned int remaining = std::min(__streamingBudget, GraphicsMemory::getStreamingLimit(streamingMemory));
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        Texture* texture = textures[i];
+        unsigned int level = texture->_requestedLevel;
+        while (level < texture->_minStreamingLevel && texture->getStreamingMemory(level) > remaining)
+        {
+            ++level;
+        }
+        unsigned int memory = texture->getStreamingMemory(level);
+        remaining = memory < remaining ? remaining - memory : 0;
+        levels[i] = level;
+    }
+
+    // Evict first to make room, then load a few larger levels per frame to spread the cost.
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        if (levels[i] > textures[i]->_residentLevel)
+            textures[i]->loadStreamingLevel(levels[i]);
+    }
+    unsigned int loads = 0;
+    for (size_t i = 0, count = textures.size(); i < count && loads < STREAMING_LOADS_PER_FRAME; ++i)
+    {
+        if (levels[i] < textures[i]->_residentLevel)
+        {
+            textures[i]->loadStreamingLevel(levels[i]);
+            ++loads;
+        }
+    }
+}
+
 Texture::Sampler::Sampler(Texture* texture)
-    : _texture(texture), _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT)
+    : _texture(texture), _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _samplerObjectIndex(0)
 {
     GP_ASSERT(texture);
     _minFilter = texture->_minFilter;
@@ -901,12 +1826,14 @@ void Texture::Sampler::setWrapMode(Wrap wrapS, Wrap wrapT)
 {
     _wrapS = wrapS;
     _wrapT = wrapT;
+    _samplerObjectIndex = 0;
 }
 
 void Texture::Sampler::setFilterMode(Filter minificationFilter, Filter magnificationFilter)
 {
     _minFilter = minificationFilter;
     _magFilter = magnificationFilter;
+    _samplerObjectIndex = 0;
 }
 
 Texture* Texture::Sampler::getTexture() const
@@ -918,30 +1845,49 @@ void Texture::Sampler::bind()
 {
     GP_ASSERT(_texture);
 
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, _texture->_handle) );
+    if (GLStateCache::bindTexture((GLenum)_texture->_type, _texture->_handle))
+        ++Game::_renderStats.textureBinds;
+
+    // Recorded samplers requested their level when they were recorded.
+    if (_texture->_streamed && !CommandBuffer::isExecuting())
+    {
+        _texture->requestStreamingLevel();
+    }
+
+#ifdef USE_SAMPLER_OBJECTS
+    if (glGenSamplers)
+    {
+        if (_samplerObjectIndex == 0 || _samplerObjectIndex > __samplerObjects.size())
+        {
+            _samplerObjectIndex = getSamplerObject(_minFilter, _magFilter, _wrapS, _wrapT);
+        }
+        GLStateCache::bindSampler(__samplerObjects[_samplerObjectIndex - 1].handle);
+        return;
+    }
+#endif
 
     if (_texture->_minFilter != _minFilter)
     {
         _texture->_minFilter = _minFilter;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLenum)_minFilter) );
+        GL_ASSERT( glTexParameteri((GLenum)_texture->_type, GL_TEXTURE_MIN_FILTER, (GLenum)_minFilter) );
     }
 
     if (_texture->_magFilter != _magFilter)
     {
         _texture->_magFilter = _magFilter;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLenum)_magFilter) );
+        GL_ASSERT( glTexParameteri((GLenum)_texture->_type, GL_TEXTURE_MAG_FILTER, (GLenum)_magFilter) );
     }
 
     if (_texture->_wrapS != _wrapS)
     {
         _texture->_wrapS = _wrapS;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLenum)_wrapS) );
+        GL_ASSERT( glTexParameteri((GLenum)_texture->_type, GL_TEXTURE_WRAP_S, (GLenum)_wrapS) );
     }
 
     if (_texture->_wrapT != _wrapT)
     {
         _texture->_wrapT = _wrapT;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLenum)_wrapT) );
+        GL_ASSERT( glTexParameteri((GLenum)_texture->_type, GL_TEXTURE_WRAP_T, (GLenum)_wrapT) );
     }
 }
 
@@ -3,6 +3,9 @@
 
 #include "Ref.h"
 #include "Stream.h"
+#include "Thread.h"
+#include "GraphicsResource.h"
+#include "GraphicsMemory.h"
 
 namespace gameplay
 {
@@ -12,12 +15,26 @@ class Image;
 /**
  * Defines a standard texture.
  */
-class Texture : public Ref
+class Texture : public Ref, private GraphicsResource
 {
     friend class Sampler;
+    friend class Game;
+    friend class Model;
+    friend class RenderQueue;
+    friend class SceneLoader;
+    friend class CommandBuffer;
+    friend class RenderTarget;
 
 public:
 
+    /**
+     * Defines the callback invoked when an asynchronous texture load completes.
+     *
+     * @param texture The loaded texture, or NULL if the texture could not be loaded.
+     * @param cookie The user data passed to Texture::createAsync.
+     */
+    typedef void (*TextureLoadCallback)(Texture* texture, void* cookie);
+
     /**
      * Defines the set of supported texture formats.
      */
@@ -29,6 +46,15 @@ public:
         ALPHA   = GL_ALPHA
     };
 
+    /**
+     * Defines the set of supported texture types.
+     */
+    enum Type
+    {
+        TEXTURE_2D = GL_TEXTURE_2D,
+        TEXTURE_CUBE = GL_TEXTURE_CUBE_MAP
+    };
+
     /**
      * Defines the set of supported texture filters.
      */
@@ -116,6 +142,10 @@ public:
 
         /**
          * Binds the texture of this sampler to the renderer and applies the sampler state.
+         *
+         * Where GL sampler objects are supported, the sampler state is applied by binding a sampler
+         * object to the active texture unit, which samplers with the same state share. Otherwise the
+         * texture parameters are set, but only those that differ from the previous sampler of the texture.
          */
         void bind();
 
@@ -136,11 +166,15 @@ public:
         Wrap _wrapT;
         Filter _minFilter;
         Filter _magFilter;
+        unsigned int _samplerObjectIndex;
     };
 
     /**
      * Creates a texture from the given image resource.
      *
+     * Supported files are PNG images, PVRTC (.pvr), DDS (.dds) and KTX (.ktx) containers. KTX files can hold
+     * any compressed format supported by the GPU, such as ETC2/EAC or ASTC, as well as cube maps.
+     *
      * Note that for textures that include mipmap data in the source data (such as most compressed textures),
      * the generateMipmaps flags should NOT be set to true.
      *
@@ -152,6 +186,45 @@ public:
      */
     static Texture* create(const char* path, bool generateMipmaps = false);
 
+    /**
+     * Creates a texture from the given image resource without blocking the game thread.
+     *
+     * PNG images are decoded by a job on the game's job scheduler. The decoded images are
+     * then uploaded on the game thread over one or more subsequent frames, limited by the
+     * time budget set with setAsyncLoadBudget(). Compressed containers need no decoding and
+     * are read and uploaded within the same budget. If the texture is already loaded, the
+     * callback is invoked with it on the next frame.
+     *
+     * The callback is invoked on the game thread. The texture is released after the callback
+     * returns, so the callback must call addRef() on the texture to keep it.
+     *
+     * @param path The image resource path.
+     * @param callback The function to call when the texture has been loaded.
+     * @param cookie User data to pass to the callback.
+     * @param generateMipmaps true to auto-generate a full mipmap chain, false otherwise.
+     * @script{ignore}
+     */
+    static void createAsync(const char* path, TextureLoadCallback callback, void* cookie = NULL, bool generateMipmaps = false);
+
+    /**
+     * Returns the number of asynchronous texture loads that have not completed yet.
+     *
+     * @return The number of pending asynchronous texture loads.
+     * @script{ignore}
+     */
+    static unsigned int getAsyncLoadCount();
+
+    /**
+     * Sets the time the game thread may spend each frame uploading asynchronously loaded textures.
+     *
+     * At least one texture is uploaded per frame regardless of the budget so that loads
+     * always make progress. The default budget is 4 milliseconds.
+     *
+     * @param milliseconds The time budget per frame, in milliseconds.
+     * @script{ignore}
+     */
+    static void setAsyncLoadBudget(float milliseconds);
+
     /**
      * Creates a texture from the given image.
      *
@@ -179,6 +252,18 @@ public:
      */
     static Texture* create(Format format, unsigned int width, unsigned int height, const unsigned char* data, bool generateMipmaps = false);
 
+    /**
+     * Creates a cube map texture with undefined pixels, to be drawn into through the render targets of its faces.
+     *
+     * @param format The format of the texture, which must be uncompressed.
+     * @param size The width and height of each face.
+     *
+     * @return The new texture.
+     * @see RenderTarget::create(const char*, Texture*, unsigned int)
+     * @script{ignore}
+     */
+    static Texture* createCube(Format format, unsigned int size);
+
     /**
      * Creates a texture object to wrap the specified pre-created native texture handle.
      *
@@ -213,6 +298,13 @@ public:
      */
     Format getFormat() const;
 
+    /**
+     * Gets the type of the texture.
+     *
+     * @return The texture type.
+     */
+    Type getType() const;
+
     /**
      * Gets the texture width.
      *
@@ -251,8 +343,57 @@ public:
      */
     TextureHandle getHandle() const;
 
+    /**
+     * Sets the memory budget for streamed textures and enables texture streaming if it is non-zero.
+     *
+     * While streaming is enabled, mipmapped PVRTC and DDS textures loaded from file are streamed:
+     * only their smallest mipmap levels are loaded at first, and larger levels are loaded once
+     * the texture is drawn at a size that needs them. Textures that have not been drawn for a
+     * while, and the least recently drawn textures when the budget is exceeded, drop back to
+     * smaller levels. Textures loaded before streaming is enabled are not streamed.
+     *
+     * The budget can also be set with the 'streamingBudget' property (in megabytes) of the
+     * 'textures' section of the game configuration file. Streaming is disabled by default.
+     *
+     * @param bytes The maximum number of bytes used by streamed textures, or 0 to disable streaming.
+     */
+    static void setStreamingBudget(unsigned int bytes);
+
+    /**
+     * Returns the memory budget for streamed textures.
+     *
+     * @return The budget in bytes, or 0 if texture streaming is disabled.
+     */
+    static unsigned int getStreamingBudget();
+
+    /**
+     * Returns the memory currently used by the loaded levels of all streamed textures.
+     *
+     * @return The number of bytes used by streamed textures.
+     */
+    static unsigned int getStreamingMemory();
+
+    /**
+     * Determines if this texture is streamed.
+     *
+     * @return True if this texture is streamed, false if all of its levels are always loaded.
+     */
+    bool isStreamed() const;
+
+    /**
+     * Returns the largest mipmap level of this texture that is currently loaded.
+     *
+     * @return The index of the largest loaded level, which is 0 unless the texture is streamed.
+     */
+    unsigned int getResidentLevel() const;
+
 private:
 
+    /**
+     * Defines an asynchronous texture load.
+     */
+    struct AsyncLoad;
+
     /**
      * Constructor.
      */
@@ -273,9 +414,149 @@ private:
      */
     Texture& operator=(const Texture&);
 
-    static Texture* createCompressedPVRTC(const char* path);
+    /**
+     * Loads a PVRTC texture, skipping the mipmap levels larger than maxSize (0 loads every level).
+     */
+    static Texture* createCompressedPVRTC(const char* path, unsigned int maxSize = 0);
+
+    /**
+     * Loads a DDS texture, skipping the mipmap levels larger than maxSize (0 loads every level).
+     */
+    static Texture* createCompressedDDS(const char* path, unsigned int maxSize = 0);
+
+    /**
+     * Creates a GL texture from pixel data, without keeping a copy of the data to restore it.
+     */
+    static Texture* createFromData(Format format, unsigned int width, unsigned int height, const unsigned char* data, bool generateMipmaps);
+
+    /**
+     * Creates a GL texture from an image, without keeping a copy of its pixels to restore it.
+     */
+    static Texture* createFromImage(Image* image, bool generateMipmaps);
+
+    /**
+     * Loads a texture from a file by its extension, skipping the mipmap levels larger than maxSize (0 loads every level).
+     */
+    static Texture* createFromFile(const char* path, bool generateMipmaps, unsigned int maxSize);
+
+    /**
+     * Keeps a copy of the pixel data this texture was created from, if it fits in the retain budget.
+     */
+    void retainData(const unsigned char* data);
+
+    /**
+     * Counts the memory of this texture against another category of GPU memory.
+     */
+    void setMemoryCategory(GraphicsMemory::Category category);
 
-    static Texture* createCompressedDDS(const char* path);
+    /**
+     * Takes over the GL texture of a texture just loaded from the file of this texture.
+     */
+    void takeOver(Texture* texture);
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     *
+     * Textures loaded from files are reloaded by an asynchronous load.
+     */
+    void restoreGraphics();
+
+    /**
+     * Reloads this texture from its file, with the image decoded by a restoring asynchronous load.
+     */
+    void finishRestore(Image* image);
+
+    /**
+     * Recreates the GL sampler objects shared by the samplers, after the GL context was lost.
+     *
+     * Called by the game when it restores the context.
+     */
+    static void restoreSamplerObjects();
+
+    /**
+     * Finds a loaded texture in the texture cache.
+     */
+    static Texture* findCached(const char* path);
+
+    /**
+     * Finds a loaded texture in the texture cache and adds a reference to it.
+     */
+    static Texture* findCachedRef(const char* path);
+
+    /**
+     * Creates a texture from an image decoded from the specified path and adds it to the texture cache.
+     */
+    static Texture* createCached(const char* path, Image* image, bool generateMipmaps);
+
+    /**
+     * Job that decodes the image of an asynchronous load.
+     */
+    static void decodeAsyncLoad(void* arg);
+
+    /**
+     * Uploads pending asynchronous loads within the per-frame time budget.
+     *
+     * Called by the game every frame.
+     */
+    static void updateAsyncLoads();
+
+    /**
+     * Waits for the decoding jobs and discards all pending asynchronous loads.
+     *
+     * Called by the game when it shuts down.
+     */
+    static void cancelAsyncLoads();
+
+    /**
+     * Deletes the GL sampler objects shared by the samplers.
+     *
+     * Called by the game when it shuts down.
+     */
+    static void releaseSamplerObjects();
+
+    /**
+     * Sets the size in pixels at which the model being drawn appears on screen, or 0 if it is unknown.
+     *
+     * Streamed textures bound while drawing request the mipmap level matching this size.
+     */
+    static void setStreamingScreenSize(float size);
+
+    /**
+     * Loads and evicts levels of the streamed textures based on how they were drawn during the frame.
+     *
+     * Called by the game at the end of each frame.
+     */
+    static void updateStreaming();
+
+    /**
+     * Compares streamed textures by how recently and how large they were drawn.
+     */
+    static bool compareStreamingPriority(const Texture* a, const Texture* b);
+
+    /**
+     * Records that this streamed texture was bound for drawing at the current streaming screen size.
+     */
+    void requestStreamingLevel();
+
+    /**
+     * Reloads this streamed texture from file with the given level as its largest level.
+     */
+    bool loadStreamingLevel(unsigned int level);
+
+    /**
+     * Estimates the memory used by this streamed texture with the given level as its largest level.
+     */
+    unsigned int getStreamingMemory(unsigned int level) const;
+
+    /**
+     * Loads a KTX texture, skipping the mipmap levels larger than maxSize (0 loads every level).
+     */
+    static Texture* createCompressedKTX(const char* path, unsigned int maxSize = 0);
 
     static GLubyte* readCompressedPVRTC(const char* path, Stream* stream, GLsizei* width, GLsizei* height, GLenum* format, unsigned int* mipMapCount);
 
@@ -285,6 +566,7 @@ private:
 
     std::string _path;
     TextureHandle _handle;
+    Type _type;
     Format _format;
     unsigned int _width;
     unsigned int _height;
@@ -295,6 +577,20 @@ private:
     Wrap _wrapT;
     Filter _minFilter;
     Filter _magFilter;
+    unsigned int _memorySize;
+    GraphicsMemory::Category _memoryCategory;
+    unsigned int _levelCount;
+    unsigned int _residentLevel;
+    bool _streamed;
+    unsigned int _minStreamingLevel;
+    unsigned int _requestedLevel;
+    unsigned int _frameRequestedLevel;
+    unsigned int _lastUsedFrame;
+    unsigned char* _retainedData;
+
+    static std::vector<AsyncLoad*> _asyncLoads;
+    static Mutex _asyncMutex;
+    static float _asyncLoadBudget;
 };
 
 }
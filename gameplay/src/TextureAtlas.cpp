@@ -0,0 +1,219 @@
+#include "Base.h"
+#include "TextureAtlas.h"
+#include "Image.h"
+#include "GLStateCache.h"
+
+// Size of the shared atlases
+#define SHARED_ATLAS_SIZE 1024
+
+// Largest image width or height added to a shared atlas
+#define SHARED_ATLAS_MAX_IMAGE_SIZE 256
+
+namespace gameplay
+{
+
+static std::vector<TextureAtlas*> __sharedAtlases;
+
+TextureAtlas::TextureAtlas()
+    : _texture(NULL), _batch(NULL), _width(0), _height(0), _shared(false)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    SAFE_DELETE(_batch);
+    SAFE_RELEASE(_texture);
+
+    if (_shared)
+    {
+        std::vector<TextureAtlas*>::iterator itr = std::find(__sharedAtlases.begin(), __sharedAtlases.end(), this);
+        if (itr != __sharedAtlases.end())
+        {
+            __sharedAtlases.erase(itr);
+        }
+    }
+}
+
+TextureAtlas* TextureAtlas::create(unsigned int width, unsigned int height)
+{
+    GP_ASSERT(width > 0 && height > 0);
+
+    Texture* texture = Texture::create(Texture::RGBA, width, height, NULL, false);
+    if (texture == NULL)
+        return NULL;
+
+    SpriteBatch* batch = SpriteBatch::create(texture);
+    if (batch == NULL)
+    {
+        SAFE_RELEASE(texture);
+        return NULL;
+    }
+    batch->getSampler()->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    batch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+
+    TextureAtlas* atlas = new TextureAtlas();
+    atlas->_texture = texture;
+    atlas->_batch = batch;
+    atlas->_width = width;
+    atlas->_height = height;
+    return atlas;
+}
+
+TextureAtlas* TextureAtlas::addShared(const char* path, Rectangle* region)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(region);
+
+    for (size_t i = 0, count = __sharedAtlases.size(); i < count; ++i)
+    {
+        if (__sharedAtlases[i]->findImage(path, region))
+        {
+            __sharedAtlases[i]->addRef();
+            return __sharedAtlases[i];
+        }
+    }
+
+    // Only PNG images are decoded by Image.
+    const char* ext = strrchr(path, '.');
+    if (ext == NULL || strlen(ext) != 4 || tolower(ext[1]) != 'p' || tolower(ext[2]) != 'n' || tolower(ext[3]) != 'g')
+        return NULL;
+
+    Image* image = Image::create(path);
+    if (image == NULL)
+        return NULL;
+    if (image->getWidth() > SHARED_ATLAS_MAX_IMAGE_SIZE || image->getHeight() > SHARED_ATLAS_MAX_IMAGE_SIZE)
+    {
+        SAFE_RELEASE(image);
+        return NULL;
+    }
+
+    TextureAtlas* atlas = NULL;
+    for (size_t i = 0, count = __sharedAtlases.size(); i < count && atlas == NULL; ++i)
+    {
+        if (__sharedAtlases[i]->addImage(path, image, region))
+        {
+            atlas = __sharedAtlases[i];
+            atlas->addRef();
+        }
+    }
+    if (atlas == NULL)
+    {
+        atlas = create(SHARED_ATLAS_SIZE, SHARED_ATLAS_SIZE);
+        if (atlas)
+        {
+            atlas->_shared = true;
+            __sharedAtlases.push_back(atlas);
+            if (!atlas->addImage(path, image, region))
+            {
+                SAFE_RELEASE(atlas);
+            }
+        }
+    }
+    SAFE_RELEASE(image);
+    return atlas;
+}
+
+bool TextureAtlas::addImage(const char* id, Image* image, Rectangle* region)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(image);
+    GP_ASSERT(region);
+
+    // Reserve a one pixel border around the image.
+    unsigned int width = image->getWidth();
+    unsigned int height = image->getHeight();
+    unsigned int x, y;
+    if (!allocate(width + 2, height + 2, &x, &y))
+        return false;
+
+    // Copy the image into an RGBA block with its edge pixels repeated in the border.
+    unsigned int bytesPerPixel = image->getFormat() == Image::RGBA ? 4 : 3;
+    const unsigned char* src = image->getData();
+    std::vector<unsigned char> block((width + 2) * (height + 2) * 4);
+    for (unsigned int row = 0; row < height + 2; ++row)
+    {
+        unsigned int srcRow = std::min(std::max(row, 1u) - 1, height - 1);
+        for (unsigned int column = 0; column < width + 2; ++column)
+        {
+            unsigned int srcColumn = std::min(std::max(column, 1u) - 1, width - 1);
+            const unsigned char* pixel = &src[(srcRow * width + srcColumn) * bytesPerPixel];
+            unsigned char* dst = &block[(row * (width + 2) + column) * 4];
+            dst[0] = pixel[0];
+            dst[1] = pixel[1];
+            dst[2] = pixel[2];
+            dst[3] = bytesPerPixel == 4 ? pixel[3] : 255;
+        }
+    }
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _texture->getHandle());
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    GL_ASSERT( glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width + 2, height + 2, GL_RGBA, GL_UNSIGNED_BYTE, &block[0]) );
+
+    region->set((float)(x + 1), (float)(y + 1), (float)width, (float)height);
+    _regions[id] = *region;
+    return true;
+}
+
+bool TextureAtlas::findImage(const char* id, Rectangle* region) const
+{
+    GP_ASSERT(id);
+    GP_ASSERT(region);
+
+    std::map<std::string, Rectangle>::const_iterator itr = _regions.find(id);
+    if (itr == _regions.end())
+        return false;
+    *region = itr->second;
+    return true;
+}
+
+Texture* TextureAtlas::getTexture() const
+{
+    return _texture;
+}
+
+SpriteBatch* TextureAtlas::getSpriteBatch() const
+{
+    return _batch;
+}
+
+bool TextureAtlas::allocate(unsigned int width, unsigned int height, unsigned int* x, unsigned int* y)
+{
+    GP_ASSERT(x);
+    GP_ASSERT(y);
+
+    if (width > _width || height > _height)
+        return false;
+
+    // Use the lowest shelf that fits the block without wasting more than half its height.
+    Shelf* best = NULL;
+    for (size_t i = 0, count = _shelves.size(); i < count; ++i)
+    {
+        Shelf& shelf = _shelves[i];
+        if (shelf.height >= height && shelf.height <= height * 2 && shelf.width + width <= _width)
+        {
+            if (best == NULL || shelf.height < best->height)
+                best = &shelf;
+        }
+    }
+
+    // Otherwise start a new shelf on top of the last one.
+    if (best == NULL)
+    {
+        unsigned int top = _shelves.empty() ? 0 : _shelves.back().y + _shelves.back().height;
+        if (top + height > _height)
+            return false;
+        Shelf shelf;
+        shelf.y = top;
+        shelf.height = height;
+        shelf.width = 0;
+        _shelves.push_back(shelf);
+        best = &_shelves.back();
+    }
+
+    *x = best->width;
+    *y = best->y;
+    best->width += width;
+    return true;
+}
+
+}
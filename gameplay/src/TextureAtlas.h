@@ -0,0 +1,136 @@
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include "Ref.h"
+#include "Texture.h"
+#include "SpriteBatch.h"
+#include "Rectangle.h"
+
+namespace gameplay
+{
+
+class Image;
+
+/**
+ * Defines a texture that packs many small images so they can be drawn by a single SpriteBatch.
+ *
+ * Images are packed into rows (shelves) of the atlas as they are added, with a one pixel
+ * border copied from their edges so that filtering does not bleed in neighbouring images.
+ * UI controls add the small images they display to shared atlases, so that a form draws
+ * its images with as few sprite batches as possible.
+ *
+ * Regions are returned in atlas pixels, with the origin at the bottom left as in GL.
+ *
+ * @script{ignore}
+ */
+class TextureAtlas : public Ref
+{
+public:
+
+    /**
+     * Creates an empty texture atlas.
+     *
+     * @param width The width of the atlas texture.
+     * @param height The height of the atlas texture.
+     *
+     * @return The new atlas.
+     */
+    static TextureAtlas* create(unsigned int width, unsigned int height);
+
+    /**
+     * Adds the image at the given path to a shared atlas, creating a new shared atlas if none has room.
+     *
+     * Images that are already in a shared atlas are not added again. Images that are too
+     * large to share an atlas, or that cannot be loaded, are not added.
+     *
+     * @param path The path of a PNG image.
+     * @param region Destination for the region of the image in the atlas.
+     *
+     * @return The atlas holding the image with its reference count increased, or NULL if it was not added.
+     */
+    static TextureAtlas* addShared(const char* path, Rectangle* region);
+
+    /**
+     * Adds an image to the atlas.
+     *
+     * @param id The ID of the image, used to find it again with findImage().
+     * @param image The image to add.
+     * @param region Destination for the region of the image in the atlas.
+     *
+     * @return True if the image was added, false if the atlas has no room left for it.
+     */
+    bool addImage(const char* id, Image* image, Rectangle* region);
+
+    /**
+     * Finds an image previously added to the atlas.
+     *
+     * @param id The ID the image was added with.
+     * @param region Destination for the region of the image in the atlas.
+     *
+     * @return True if the image is in the atlas, false otherwise.
+     */
+    bool findImage(const char* id, Rectangle* region) const;
+
+    /**
+     * Returns the atlas texture.
+     *
+     * @return The texture holding the packed images.
+     */
+    Texture* getTexture() const;
+
+    /**
+     * Returns the sprite batch that draws from the atlas texture.
+     *
+     * @return The sprite batch of the atlas.
+     */
+    SpriteBatch* getSpriteBatch() const;
+
+private:
+
+    /**
+     * Defines a row of packed images.
+     */
+    struct Shelf
+    {
+        unsigned int y;
+        unsigned int height;
+        unsigned int width;
+    };
+
+    /**
+     * Constructor.
+     */
+    TextureAtlas();
+
+    /**
+     * Destructor.
+     */
+    ~TextureAtlas();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TextureAtlas(const TextureAtlas& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TextureAtlas& operator=(const TextureAtlas&);
+
+    /**
+     * Finds room for a block of the given size, returning its bottom left corner.
+     */
+    bool allocate(unsigned int width, unsigned int height, unsigned int* x, unsigned int* y);
+
+    Texture* _texture;
+    SpriteBatch* _batch;
+    unsigned int _width;
+    unsigned int _height;
+    std::vector<Shelf> _shelves;
+    std::map<std::string, Rectangle> _regions;
+    bool _shared;
+};
+
+}
+
+#endif
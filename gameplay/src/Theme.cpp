@@ -3,14 +3,29 @@
 #include "ThemeStyle.h"
 #include "Game.h"
 #include "FileSystem.h"
+#include "MemoryTracker.h"
 
 namespace gameplay
 {
 
-static std::vector<Theme*> __themeCache;
+static std::multimap<unsigned int, Theme*> __themeCache;
 static Theme* __defaultTheme = NULL;
 
-Theme::Theme() : _texture(NULL), _spriteBatch(NULL), _emptyImage(NULL)
+/**
+ * Returns the FNV-1a hash of a string, ignoring case if requested.
+ */
+static unsigned int hashString(const char* str, bool ignoreCase)
+{
+    unsigned int hash = 2166136261u;
+    for (; *str; ++str)
+    {
+        unsigned char c = (unsigned char)*str;
+        hash = (hash ^ (ignoreCase ? (unsigned char)tolower(c) : c)) * 16777619u;
+    }
+    return hash;
+}
+
+Theme::Theme() : _texture(NULL), _spriteBatch(NULL), _nineSliceBatch(NULL), _emptyImage(NULL)
 {
 }
 
@@ -42,13 +57,19 @@ Theme::~Theme()
     }
 
     SAFE_DELETE(_spriteBatch);
+    SAFE_DELETE(_nineSliceBatch);
     SAFE_RELEASE(_texture);
 
     // Remove ourself from the theme cache.
-    std::vector<Theme*>::iterator itr = std::find(__themeCache.begin(), __themeCache.end(), this);
-    if (itr != __themeCache.end())
+    std::pair<std::multimap<unsigned int, Theme*>::iterator, std::multimap<unsigned int, Theme*>::iterator> range =
+        __themeCache.equal_range(hashString(_url.c_str(), false));
+    for (std::multimap<unsigned int, Theme*>::iterator itr = range.first; itr != range.second; ++itr)
     {
-        __themeCache.erase(itr);
+        if (itr->second == this)
+        {
+            __themeCache.erase(itr);
+            break;
+        }
     }
 
     SAFE_RELEASE(_emptyImage);
@@ -79,9 +100,7 @@ Theme* Theme::getDefault()
             unsigned int color = 0x00000000;
             __defaultTheme->_texture = Texture::create(Texture::RGBA, 1, 1, (unsigned char*)&color, false);
             __defaultTheme->_emptyImage = new Theme::ThemeImage(1.0f, 1.0f, Rectangle::empty(), Vector4::zero());
-            __defaultTheme->_spriteBatch = SpriteBatch::create(__defaultTheme->_texture);
-            __defaultTheme->_spriteBatch->getSampler()->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
-            __defaultTheme->_spriteBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+            __defaultTheme->createSpriteBatches();
         }
 
 		// TODO: Use a built-in (compiled-in) default theme resource as the final fallback so that
@@ -100,10 +119,14 @@ Theme* Theme::create(const char* url)
 {
     GP_ASSERT(url);
 
+    MemoryTracker::Scope scope(MemoryTracker::UI);
+
     // Search theme cache first.
-    for (size_t i = 0, count = __themeCache.size(); i < count; ++i)
+    unsigned int urlHash = hashString(url, false);
+    std::pair<std::multimap<unsigned int, Theme*>::iterator, std::multimap<unsigned int, Theme*>::iterator> range = __themeCache.equal_range(urlHash);
+    for (std::multimap<unsigned int, Theme*>::iterator itr = range.first; itr != range.second; ++itr)
     {
-        Theme* t = __themeCache[i];
+        Theme* t = itr->second;
         if (t->_url == url)
         {
             // Found a match.
@@ -139,10 +162,7 @@ Theme* Theme::create(const char* url)
     themeProperties->getPath("texture", &textureFile);
     theme->_texture = Texture::create(textureFile.c_str(), true);
     GP_ASSERT(theme->_texture);
-    theme->_spriteBatch = SpriteBatch::create(theme->_texture);
-    GP_ASSERT(theme->_spriteBatch);
-    theme->_spriteBatch->getSampler()->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
-    theme->_spriteBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    theme->createSpriteBatches();
 
     float tw = 1.0f / theme->_texture->getWidth();
     float th = 1.0f / theme->_texture->getHeight();
@@ -489,14 +509,14 @@ Theme* Theme::create(const char* url)
 
             Theme::Style* s = new Theme::Style(theme, space->getId(), tw, th, margin, padding, normal, focus, active, disabled, hover);
             GP_ASSERT(s);
-            theme->_styles.push_back(s);
+            theme->addStyle(s);
         }
 
         space = themeProperties->getNextNamespace();
     }
 
     // Add this theme to the cache.
-    __themeCache.push_back(theme);
+    __themeCache.insert(std::make_pair(urlHash, theme));
 
     SAFE_DELETE(properties);
 
@@ -507,18 +527,28 @@ Theme::Style* Theme::getStyle(const char* name) const
 {
     GP_ASSERT(name);
 
-    for (size_t i = 0, count = _styles.size(); i < count; ++i)
+    std::pair<std::multimap<unsigned int, Style*>::const_iterator, std::multimap<unsigned int, Style*>::const_iterator> range =
+        _styleIndex.equal_range(hashString(name, true));
+    for (std::multimap<unsigned int, Style*>::const_iterator itr = range.first; itr != range.second; ++itr)
     {
-        GP_ASSERT(_styles[i]);
-        if (strcmpnocase(name, _styles[i]->getId()) == 0)
+        GP_ASSERT(itr->second);
+        if (strcmpnocase(name, itr->second->getId()) == 0)
         {
-            return _styles[i];
+            return itr->second;
         }
     }
 
     return NULL;
 }
 
+void Theme::addStyle(Style* style)
+{
+    GP_ASSERT(style);
+
+    _styles.push_back(style);
+    _styleIndex.insert(std::make_pair(hashString(style->getId(), true), style));
+}
+
 Theme::Style* Theme::getEmptyStyle()
 {
     Theme::Style* emptyStyle = getStyle("EMPTY_STYLE");
@@ -531,7 +561,7 @@ Theme::Style* Theme::getEmptyStyle()
         emptyStyle = new Theme::Style(const_cast<Theme*>(this), "EMPTY_STYLE", 1.0f / _texture->getWidth(), 1.0f / _texture->getHeight(),
             Theme::Margin::empty(), Theme::Border::empty(), overlay, overlay, NULL, overlay, NULL);
 
-        _styles.push_back(emptyStyle);
+        addStyle(emptyStyle);
     }
 
     return emptyStyle;
@@ -541,6 +571,26 @@ void Theme::setProjectionMatrix(const Matrix& matrix)
 {
     GP_ASSERT(_spriteBatch);
     _spriteBatch->setProjectionMatrix(matrix);
+    if (_nineSliceBatch)
+        _nineSliceBatch->setProjectionMatrix(matrix);
+}
+
+void Theme::createSpriteBatches()
+{
+    GP_ASSERT(_texture);
+
+    _spriteBatch = SpriteBatch::create(_texture);
+    GP_ASSERT(_spriteBatch);
+    _spriteBatch->getSampler()->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    _spriteBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+
+    // Skins are drawn with the nine-slice batch when its effect is available, and as nine sprites otherwise.
+    _nineSliceBatch = SpriteBatch::createNineSlice(_texture);
+    if (_nineSliceBatch)
+    {
+        _nineSliceBatch->getSampler()->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+        _nineSliceBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    }
 }
 
 SpriteBatch* Theme::getSpriteBatch() const
@@ -29,6 +29,7 @@ class Theme: public Ref
     friend class Form;
     friend class Skin;
     friend class Game;
+    friend class Gamepad;
 
 public:
 
@@ -377,11 +378,23 @@ private:
 
     void lookUpSprites(const Properties* overlaySpace, ImageList** imageList, ThemeImage** mouseCursor, Skin** skin);
 
+    /**
+     * Adds a style to the styles of this theme, and to the index of their names.
+     */
+    void addStyle(Style* style);
+
+    /**
+     * Creates the sprite batches of this theme for its texture.
+     */
+    void createSpriteBatches();
+
     std::string _url;
     Texture* _texture;
     SpriteBatch* _spriteBatch;
+    SpriteBatch* _nineSliceBatch; // draws the skins in one quad each, or NULL if the nine-slice effect is unavailable
     Theme::ThemeImage* _emptyImage;
     std::vector<Style*> _styles;
+    std::multimap<unsigned int, Style*> _styleIndex; // styles by the hash of their lowercase ID
     std::vector<ThemeImage*> _images;
     std::vector<ImageList*> _imageLists;
     std::vector<Skin*> _skins;
@@ -0,0 +1,200 @@
+#include "Base.h"
+#include "Thread.h"
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+namespace gameplay
+{
+
+Thread::Thread(Function function, void* arg)
+    : _function(function), _arg(arg), _result(0), _joined(false)
+{
+}
+
+Thread::~Thread()
+{
+    join();
+}
+
+Thread* Thread::create(Function function, void* arg)
+{
+    GP_ASSERT(function);
+
+    Thread* thread = new Thread(function, arg);
+#ifdef WIN32
+    thread->_handle = CreateThread(NULL, 0, &Thread::run, thread, 0, NULL);
+    if (thread->_handle == NULL)
+#else
+    if (pthread_create(&thread->_handle, NULL, &Thread::run, thread) != 0)
+#endif
+    {
+        GP_WARN("Failed to create thread.");
+        thread->_joined = true;
+        SAFE_DELETE(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+int Thread::join()
+{
+    if (!_joined)
+    {
+#ifdef WIN32
+        WaitForSingleObject(_handle, INFINITE);
+        CloseHandle(_handle);
+#else
+        pthread_join(_handle, NULL);
+#endif
+        _joined = true;
+    }
+    return _result;
+}
+
+void Thread::sleep(unsigned int milliseconds)
+{
+#ifdef WIN32
+    Sleep(milliseconds);
+#else
+    usleep(milliseconds * 1000);
+#endif
+}
+
+unsigned int Thread::getProcessorCount()
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (unsigned int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (unsigned int)count : 1;
+#endif
+}
+
+Thread::Id Thread::getCurrentId()
+{
+#ifdef WIN32
+    return GetCurrentThreadId();
+#else
+    return pthread_self();
+#endif
+}
+
+bool Thread::isCurrent(Id id)
+{
+#ifdef WIN32
+    return GetCurrentThreadId() == id;
+#else
+    return pthread_equal(pthread_self(), id) != 0;
+#endif
+}
+
+#ifdef WIN32
+DWORD WINAPI Thread::run(LPVOID arg)
+{
+    Thread* thread = (Thread*)arg;
+    thread->_result = thread->_function(thread->_arg);
+    return 0;
+}
+#else
+void* Thread::run(void* arg)
+{
+    Thread* thread = (Thread*)arg;
+    thread->_result = thread->_function(thread->_arg);
+    return NULL;
+}
+#endif
+
+Mutex::Mutex()
+{
+#ifdef WIN32
+    InitializeCriticalSection(&_handle);
+#else
+    pthread_mutex_init(&_handle, NULL);
+#endif
+}
+
+Mutex::~Mutex()
+{
+#ifdef WIN32
+    DeleteCriticalSection(&_handle);
+#else
+    pthread_mutex_destroy(&_handle);
+#endif
+}
+
+void Mutex::lock()
+{
+#ifdef WIN32
+    EnterCriticalSection(&_handle);
+#else
+    pthread_mutex_lock(&_handle);
+#endif
+}
+
+void Mutex::unlock()
+{
+#ifdef WIN32
+    LeaveCriticalSection(&_handle);
+#else
+    pthread_mutex_unlock(&_handle);
+#endif
+}
+
+Mutex::Lock::Lock(Mutex& mutex)
+    : _mutex(mutex)
+{
+    _mutex.lock();
+}
+
+Mutex::Lock::~Lock()
+{
+    _mutex.unlock();
+}
+
+Condition::Condition()
+{
+#ifdef WIN32
+    InitializeConditionVariable(&_handle);
+#else
+    pthread_cond_init(&_handle, NULL);
+#endif
+}
+
+Condition::~Condition()
+{
+#ifndef WIN32
+    pthread_cond_destroy(&_handle);
+#endif
+}
+
+void Condition::wait(Mutex& mutex)
+{
+#ifdef WIN32
+    SleepConditionVariableCS(&_handle, &mutex._handle, INFINITE);
+#else
+    pthread_cond_wait(&_handle, &mutex._handle);
+#endif
+}
+
+void Condition::signal()
+{
+#ifdef WIN32
+    WakeConditionVariable(&_handle);
+#else
+    pthread_cond_signal(&_handle);
+#endif
+}
+
+void Condition::broadcast()
+{
+#ifdef WIN32
+    WakeAllConditionVariable(&_handle);
+#else
+    pthread_cond_broadcast(&_handle);
+#endif
+}
+
+}
@@ -0,0 +1,380 @@
+#ifndef THREAD_H_
+#define THREAD_H_
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace gameplay
+{
+
+/**
+ * Defines a thread of execution that runs a function concurrently with the game thread.
+ *
+ * None of the engine's objects are safe to use from multiple threads unless stated
+ * otherwise, and all graphics calls must be made from the game thread.
+ *
+ * @script{ignore}
+ */
+class Thread
+{
+public:
+
+    /**
+     * Defines the signature of a function that can be run by a thread.
+     *
+     * @param arg The argument passed to Thread::create.
+     *
+     * @return The exit code of the thread.
+     */
+    typedef int (*Function)(void* arg);
+
+    /**
+     * Defines the identifier of a thread.
+     */
+#ifdef WIN32
+    typedef DWORD Id;
+#else
+    typedef pthread_t Id;
+#endif
+
+    /**
+     * Creates and starts a new thread.
+     *
+     * @param function The function to run on the new thread.
+     * @param arg The argument to pass to the function.
+     *
+     * @return The new thread, or NULL if the thread could not be started.
+     */
+    static Thread* create(Function function, void* arg);
+
+    /**
+     * Destructor.
+     *
+     * Waits for the thread to finish if it has not been joined.
+     */
+    ~Thread();
+
+    /**
+     * Waits for the thread to finish running.
+     *
+     * @return The exit code of the thread function.
+     */
+    int join();
+
+    /**
+     * Suspends the calling thread for the specified time.
+     *
+     * @param milliseconds The time to sleep, in milliseconds.
+     */
+    static void sleep(unsigned int milliseconds);
+
+    /**
+     * Returns the number of processors (logical cores) available to the game.
+     *
+     * @return The number of processors, which is at least 1.
+     */
+    static unsigned int getProcessorCount();
+
+    /**
+     * Returns the identifier of the calling thread.
+     *
+     * @return The identifier of the calling thread.
+     */
+    static Id getCurrentId();
+
+    /**
+     * Determines if the specified identifier is the one of the calling thread.
+     *
+     * @param id The thread identifier to compare.
+     *
+     * @return true if id identifies the calling thread.
+     */
+    static bool isCurrent(Id id);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Thread(Function function, void* arg);
+
+    /**
+     * Hidden copy constructor.
+     */
+    Thread(const Thread& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Thread& operator=(const Thread&);
+
+#ifdef WIN32
+    static DWORD WINAPI run(LPVOID arg);
+
+    HANDLE _handle;
+#else
+    static void* run(void* arg);
+
+    pthread_t _handle;
+#endif
+    Function _function;
+    void* _arg;
+    int _result;
+    bool _joined;
+};
+
+/**
+ * Defines a mutual exclusion lock used to protect data shared between threads.
+ *
+ * @script{ignore}
+ */
+class Mutex
+{
+    friend class Condition;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    Mutex();
+
+    /**
+     * Destructor.
+     */
+    ~Mutex();
+
+    /**
+     * Acquires the lock, waiting until it is available.
+     */
+    void lock();
+
+    /**
+     * Releases the lock.
+     */
+    void unlock();
+
+    /**
+     * Acquires a mutex for the lifetime of the scope it is declared in.
+     */
+    class Lock
+    {
+    public:
+
+        /**
+         * Constructor. Acquires the mutex.
+         */
+        Lock(Mutex& mutex);
+
+        /**
+         * Destructor. Releases the mutex.
+         */
+        ~Lock();
+
+    private:
+
+        Lock(const Lock& copy);
+
+        Lock& operator=(const Lock&);
+
+        Mutex& _mutex;
+    };
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    Mutex(const Mutex& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Mutex& operator=(const Mutex&);
+
+#ifdef WIN32
+    CRITICAL_SECTION _handle;
+#else
+    pthread_mutex_t _handle;
+#endif
+};
+
+/**
+ * Defines a condition variable that lets threads wait until they are notified by another thread.
+ *
+ * As with any condition variable, a waiting thread may wake up spuriously, so the
+ * condition being waited for must be checked again after wait() returns.
+ *
+ * @script{ignore}
+ */
+class Condition
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    Condition();
+
+    /**
+     * Destructor.
+     */
+    ~Condition();
+
+    /**
+     * Atomically releases the mutex and waits until the condition is notified,
+     * then reacquires the mutex.
+     *
+     * @param mutex The mutex protecting the condition, which must be locked by the calling thread.
+     */
+    void wait(Mutex& mutex);
+
+    /**
+     * Wakes up one thread waiting on the condition.
+     */
+    void signal();
+
+    /**
+     * Wakes up all threads waiting on the condition.
+     */
+    void broadcast();
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    Condition(const Condition& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Condition& operator=(const Condition&);
+
+#ifdef WIN32
+    CONDITION_VARIABLE _handle;
+#else
+    pthread_cond_t _handle;
+#endif
+};
+
+/**
+ * Defines atomic operations on integers shared between threads.
+ *
+ * Each operation is a full memory barrier, so the writes made by a thread before
+ * it changes a value are visible to the thread that observes the change.
+ *
+ * @script{ignore}
+ */
+class Atomic
+{
+public:
+
+    /**
+     * Increments a value.
+     *
+     * @param value The value to increment.
+     *
+     * @return The incremented value.
+     */
+    static inline unsigned int increment(volatile unsigned int* value);
+
+    /**
+     * Decrements a value.
+     *
+     * @param value The value to decrement.
+     *
+     * @return The decremented value.
+     */
+    static inline unsigned int decrement(volatile unsigned int* value);
+
+    /**
+     * Adds an amount to a value.
+     *
+     * @param value The value to add to.
+     * @param amount The amount to add.
+     *
+     * @return The value after the addition.
+     */
+    static inline unsigned int add(volatile unsigned int* value, unsigned int amount);
+
+    /**
+     * Subtracts an amount from a value.
+     *
+     * @param value The value to subtract from.
+     * @param amount The amount to subtract.
+     *
+     * @return The value after the subtraction.
+     */
+    static inline unsigned int subtract(volatile unsigned int* value, unsigned int amount);
+
+    /**
+     * Sets a value to another if it still holds the expected one.
+     *
+     * @param value The value to set.
+     * @param expected The value expected to be held.
+     * @param desired The value to set.
+     *
+     * @return The value held before the call, which equals expected if the value was set.
+     */
+    static inline unsigned int compareExchange(volatile unsigned int* value, unsigned int expected, unsigned int desired);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Atomic();
+};
+
+inline unsigned int Atomic::increment(volatile unsigned int* value)
+{
+#ifdef WIN32
+    return (unsigned int)InterlockedIncrement((volatile LONG*)value);
+#else
+    return __sync_add_and_fetch(value, 1u);
+#endif
+}
+
+inline unsigned int Atomic::decrement(volatile unsigned int* value)
+{
+#ifdef WIN32
+    return (unsigned int)InterlockedDecrement((volatile LONG*)value);
+#else
+    return __sync_sub_and_fetch(value, 1u);
+#endif
+}
+
+inline unsigned int Atomic::add(volatile unsigned int* value, unsigned int amount)
+{
+#ifdef WIN32
+    return (unsigned int)InterlockedExchangeAdd((volatile LONG*)value, (LONG)amount) + amount;
+#else
+    return __sync_add_and_fetch(value, amount);
+#endif
+}
+
+inline unsigned int Atomic::subtract(volatile unsigned int* value, unsigned int amount)
+{
+#ifdef WIN32
+    return (unsigned int)InterlockedExchangeAdd((volatile LONG*)value, -(LONG)amount) - amount;
+#else
+    return __sync_sub_and_fetch(value, amount);
+#endif
+}
+
+inline unsigned int Atomic::compareExchange(volatile unsigned int* value, unsigned int expected, unsigned int desired)
+{
+#ifdef WIN32
+    return (unsigned int)InterlockedCompareExchange((volatile LONG*)value, (LONG)desired, (LONG)expected);
+#else
+    return __sync_val_compare_and_swap(value, expected, desired);
+#endif
+}
+
+}
+
+#endif
@@ -13,6 +13,11 @@ class TimeListener
 {
 public:
 
+    /**
+     * Destructor.
+     */
+    virtual ~TimeListener() { }
+
     /**
      * Callback method that is called when the scheduled event is fired.
      * 
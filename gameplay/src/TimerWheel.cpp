@@ -0,0 +1,259 @@
+#include "Base.h"
+#include "TimerWheel.h"
+
+// The number of levels of the wheel, and the number of slots of each level (as a power of two).
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// The number of bits of a handle holding the index of its timer in the pool; the others hold its serial.
+#define TIMER_WHEEL_INDEX_BITS 20
+#define TIMER_WHEEL_INDEX_MASK ((1u << TIMER_WHEEL_INDEX_BITS) - 1)
+#define TIMER_WHEEL_SERIAL_MASK (0xFFFFFFFFu >> TIMER_WHEEL_INDEX_BITS)
+
+// Marks the end of a list of timers, and an unlinked timer.
+#define TIMER_WHEEL_NONE 0xFFFFFFFFu
+
+// The furthest an event can be scheduled in the future, in ticks.
+#define TIMER_WHEEL_MAX_DELAY 0x7FFFFFFFu
+
+namespace gameplay
+{
+
+TimerWheel::TimerWheel(double time)
+    : _slots(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS, TIMER_WHEEL_NONE), _levelCounts(TIMER_WHEEL_LEVELS, 0), _freeTimer(TIMER_WHEEL_NONE),
+      _pendingCount(0), _tick(0), _tickTime(time)
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    clear();
+}
+
+unsigned int TimerWheel::schedule(double time, TimeListener* listener, void* cookie, bool ownsListener)
+{
+    unsigned int index = _freeTimer;
+    if (index != TIMER_WHEEL_NONE)
+    {
+        _freeTimer = _timers[index].next;
+    }
+    else
+    {
+        GP_ASSERT(_timers.size() <= TIMER_WHEEL_INDEX_MASK);
+        index = (unsigned int)_timers.size();
+        Timer timer;
+        timer.serial = 1;
+        _timers.push_back(timer);
+    }
+
+    // Events due before the next tick fire with it.
+    double delay = ceil(time - _tickTime);
+    Timer& timer = _timers[index];
+    timer.time = time;
+    timer.listener = listener;
+    timer.cookie = cookie;
+    timer.ownsListener = ownsListener;
+    timer.tick = _tick + (delay > 0.0 ? (unsigned int)std::min(delay, (double)TIMER_WHEEL_MAX_DELAY) : 0);
+    link(index);
+    ++_pendingCount;
+
+    return (timer.serial << TIMER_WHEEL_INDEX_BITS) | index;
+}
+
+bool TimerWheel::cancel(unsigned int handle)
+{
+    unsigned int index = handle & TIMER_WHEEL_INDEX_MASK;
+    if (index >= _timers.size() || _timers[index].serial != (handle >> TIMER_WHEEL_INDEX_BITS) || _timers[index].slot == TIMER_WHEEL_NONE)
+        return false;
+
+    release(index);
+    return true;
+}
+
+unsigned int TimerWheel::cancel(TimeListener* listener)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0, timerCount = (unsigned int)_timers.size(); i < timerCount; ++i)
+    {
+        if (_timers[i].slot != TIMER_WHEEL_NONE && _timers[i].listener == listener)
+        {
+            release(i);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void TimerWheel::fire(double time)
+{
+    while (_tickTime <= time)
+    {
+        // Nothing fires until the events of the finest level holding any are moved down, which
+        // happens at the ticks that are multiples of the reach of the level below it.
+        unsigned int level = 0;
+        while (level < TIMER_WHEEL_LEVELS && _levelCounts[level] == 0)
+        {
+            ++level;
+        }
+        if (level > 0)
+        {
+            // Skip to that tick, or past the given time. Tick numbers wrap around.
+            double ticks = floor(time - _tickTime) + 1.0;
+            if (level < TIMER_WHEEL_LEVELS)
+            {
+                unsigned int reach = 1u << (level * TIMER_WHEEL_SLOT_BITS);
+                unsigned int offset = _tick & (reach - 1);
+                ticks = offset == 0 ? 0.0 : std::min(ticks, (double)(reach - offset));
+            }
+            if (ticks > 0.0)
+            {
+                _tick += (unsigned int)fmod(ticks, 4294967296.0);
+                _tickTime += ticks;
+                continue;
+            }
+        }
+
+        // Move the events of the coarser slots coming within reach down to the finer levels.
+        unsigned int index = _tick & TIMER_WHEEL_SLOT_MASK;
+        if (index == 0 && cascade(1) == 0 && cascade(2) == 0)
+            cascade(3);
+
+        // Fire the events of the tick. The head is read again after each call back, since the
+        // listeners may schedule events due in this tick or cancel the events that follow.
+        while (_slots[index] != TIMER_WHEEL_NONE)
+        {
+            unsigned int timerIndex = _slots[index];
+            Timer& timer = _timers[timerIndex];
+            TimeListener* listener = timer.listener;
+            void* cookie = timer.cookie;
+            double eventTime = timer.time;
+            bool ownsListener = timer.ownsListener;
+
+            // The listener is deleted after its call back.
+            timer.ownsListener = false;
+            release(timerIndex);
+
+            if (listener)
+            {
+                listener->timeEvent((long)(time - eventTime), cookie);
+            }
+            if (ownsListener)
+            {
+                SAFE_DELETE(listener);
+            }
+        }
+
+        ++_tick;
+        _tickTime += 1.0;
+    }
+}
+
+void TimerWheel::clear()
+{
+    for (unsigned int i = 0, count = (unsigned int)_timers.size(); i < count; ++i)
+    {
+        if (_timers[i].slot != TIMER_WHEEL_NONE)
+            release(i);
+    }
+}
+
+unsigned int TimerWheel::getPendingCount() const
+{
+    return _pendingCount;
+}
+
+void TimerWheel::link(unsigned int index)
+{
+    Timer& timer = _timers[index];
+
+    // Each level holds the events within 256 times the reach of the level below it.
+    unsigned int delay = timer.tick - _tick;
+    unsigned int level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delay >= (1u << ((level + 1) * TIMER_WHEEL_SLOT_BITS)))
+    {
+        ++level;
+    }
+    unsigned int slot = level * TIMER_WHEEL_SLOTS + ((timer.tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK);
+
+    // Append the timer, so the events of a tick fire in the order they were scheduled in.
+    ++_levelCounts[level];
+    timer.slot = slot;
+    timer.next = TIMER_WHEEL_NONE;
+    unsigned int head = _slots[slot];
+    if (head == TIMER_WHEEL_NONE)
+    {
+        timer.prev = index;
+        _slots[slot] = index;
+    }
+    else
+    {
+        // The head keeps the last timer of the slot as its previous timer.
+        Timer& first = _timers[head];
+        timer.prev = first.prev;
+        _timers[first.prev].next = index;
+        first.prev = index;
+    }
+}
+
+void TimerWheel::unlink(unsigned int index)
+{
+    Timer& timer = _timers[index];
+    GP_ASSERT(timer.slot != TIMER_WHEEL_NONE);
+
+    --_levelCounts[timer.slot / TIMER_WHEEL_SLOTS];
+    unsigned int& head = _slots[timer.slot];
+    if (head == index)
+    {
+        head = timer.next;
+        if (head != TIMER_WHEEL_NONE)
+            _timers[head].prev = timer.prev;
+    }
+    else
+    {
+        _timers[timer.prev].next = timer.next;
+        if (timer.next != TIMER_WHEEL_NONE)
+            _timers[timer.next].prev = timer.prev;
+        else
+            _timers[head].prev = timer.prev;
+    }
+    timer.slot = TIMER_WHEEL_NONE;
+}
+
+void TimerWheel::release(unsigned int index)
+{
+    unlink(index);
+
+    Timer& timer = _timers[index];
+    if (timer.ownsListener)
+    {
+        SAFE_DELETE(timer.listener);
+    }
+    timer.listener = NULL;
+
+    // Invalidate the handles of the timer, skipping serial zero so that handles are never zero.
+    timer.serial = (timer.serial & TIMER_WHEEL_SERIAL_MASK) == TIMER_WHEEL_SERIAL_MASK ? 1 : timer.serial + 1;
+    timer.next = _freeTimer;
+    _freeTimer = index;
+    --_pendingCount;
+}
+
+unsigned int TimerWheel::cascade(unsigned int level)
+{
+    unsigned int index = (_tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    unsigned int slot = level * TIMER_WHEEL_SLOTS + index;
+
+    unsigned int timerIndex = _slots[slot];
+    _slots[slot] = TIMER_WHEEL_NONE;
+    while (timerIndex != TIMER_WHEEL_NONE)
+    {
+        unsigned int next = _timers[timerIndex].next;
+        --_levelCounts[level];
+        link(timerIndex);
+        timerIndex = next;
+    }
+    return index;
+}
+
+}
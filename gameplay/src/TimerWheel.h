@@ -0,0 +1,158 @@
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include "TimeListener.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the hierarchical timer wheel that holds the time events scheduled by Game::schedule.
+ *
+ * Time is divided into ticks of one millisecond. The wheel has four levels of 256 slots: the
+ * first level holds the events due in the next 256 ticks, one slot per tick, and each higher
+ * level holds events 256 times further away, 256 times coarser. Scheduling and cancelling an
+ * event only link it into or out of a slot, whatever the number of pending events. As time
+ * advances, the events of a coarse slot are moved down to the finer level once its range comes
+ * within reach, so each event is moved at most three times before it fires. The ticks before
+ * the next move of the finest level holding events are skipped, so firing events after a long
+ * frame does not visit every tick.
+ *
+ * Events are stored in a pool, which reuses the storage of the events that fired or were
+ * cancelled, and are referred to by handles that become invalid once the event has fired
+ * or was cancelled.
+ *
+ * @script{ignore}
+ */
+class TimerWheel
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param time The current game time, in milliseconds, which starts the first tick.
+     */
+    TimerWheel(double time);
+
+    /**
+     * Destructor. Deletes the listeners owned by the pending events.
+     */
+    ~TimerWheel();
+
+    /**
+     * Schedules a time event.
+     *
+     * @param time The game time to fire the event at, in milliseconds.
+     * @param listener The listener to send the event to.
+     * @param cookie The cookie data that the time event will contain.
+     * @param ownsListener true to delete the listener once the event has fired or was cancelled.
+     *
+     * @return The handle of the event, which is never zero.
+     */
+    unsigned int schedule(double time, TimeListener* listener, void* cookie, bool ownsListener);
+
+    /**
+     * Cancels a pending time event.
+     *
+     * @param handle The handle of the event.
+     *
+     * @return true if the event was cancelled, false if it has already fired or was cancelled.
+     */
+    bool cancel(unsigned int handle);
+
+    /**
+     * Cancels every pending time event sent to the given listener.
+     *
+     * This visits every pending event, so cancelling events by handle should be preferred.
+     *
+     * @param listener The listener to cancel the events of.
+     *
+     * @return The number of events cancelled.
+     */
+    unsigned int cancel(TimeListener* listener);
+
+    /**
+     * Fires the events due by the given time, in the order of their ticks.
+     *
+     * Events scheduled by a listener while events are fired are fired in the same call if they are
+     * already due. Events whose time falls within a tick fire once the whole tick is due.
+     *
+     * @param time The current game time, in milliseconds.
+     */
+    void fire(double time);
+
+    /**
+     * Cancels every pending event.
+     */
+    void clear();
+
+    /**
+     * Returns the number of pending events.
+     *
+     * @return The number of events not yet fired or cancelled.
+     */
+    unsigned int getPendingCount() const;
+
+private:
+
+    /**
+     * A pending event, or an unused entry of the pool.
+     */
+    struct Timer
+    {
+        double time;
+        TimeListener* listener;
+        void* cookie;
+        bool ownsListener;
+        unsigned int tick;
+        unsigned int serial;
+        unsigned int slot;
+        unsigned int prev;
+        unsigned int next;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    TimerWheel(const TimerWheel& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TimerWheel& operator=(const TimerWheel&);
+
+    /**
+     * Links a timer into the slot of its tick.
+     */
+    void link(unsigned int index);
+
+    /**
+     * Unlinks a timer from its slot.
+     */
+    void unlink(unsigned int index);
+
+    /**
+     * Unlinks a timer and returns it to the pool, deleting its listener if it owns it.
+     */
+    void release(unsigned int index);
+
+    /**
+     * Moves the timers of a slot of a coarse level to the slots of their ticks.
+     *
+     * @return The index of the slot within its level.
+     */
+    unsigned int cascade(unsigned int level);
+
+    std::vector<Timer> _timers;             // The pool of timers.
+    std::vector<unsigned int> _slots;       // The first timer of each slot of each level.
+    std::vector<unsigned int> _levelCounts; // The number of timers in the slots of each level.
+    unsigned int _freeTimer;                // The first unused timer of the pool.
+    unsigned int _pendingCount;             // The number of pending timers.
+    unsigned int _tick;                     // The next tick to fire.
+    double _tickTime;                       // The game time the next tick is due at.
+};
+
+}
+
+#endif
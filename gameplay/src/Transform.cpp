@@ -2,47 +2,61 @@
 #include "Transform.h"
 #include "Game.h"
 #include "Node.h"
+#include "FramePacer.h"
+#include "Thread.h"
 
 namespace gameplay
 {
 
+// The script events of transforms.
+#define TRANSFORM_EVENT_CHANGED 0
+
+static const ScriptTarget::Event __transformEvents[] =
+{
+    { "transformChanged", "<Transform>" }
+};
+
 int Transform::_suspendTransformChanged(0);
 std::vector<Transform*> Transform::_transformsChanged;
+std::vector<Transform*> Transform::_interpolatedTransforms;
+std::vector<Transform*> Transform::_deferredScriptEvents;
+static Mutex __deferredScriptEventsMutex;
 
 Transform::Transform()
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _interpolated(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     _scale.set(Vector3::one());
-    addScriptEvent("transformChanged", "<Transform>");
+    setScriptEvents(__transformEvents, 1);
 }
 
 Transform::Transform(const Vector3& scale, const Quaternion& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _interpolated(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(scale, rotation, translation);
-    addScriptEvent("transformChanged", "<Transform>");
+    setScriptEvents(__transformEvents, 1);
 }
 
 Transform::Transform(const Vector3& scale, const Matrix& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _interpolated(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(scale, rotation, translation);
-    addScriptEvent("transformChanged", "<Transform>");
+    setScriptEvents(__transformEvents, 1);
 }
 
 Transform::Transform(const Transform& copy)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _interpolated(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(copy);
-    addScriptEvent("transformChanged", "<Transform>");
+    setScriptEvents(__transformEvents, 1);
 }
 
 Transform::~Transform()
 {
+    setInterpolated(false);
     SAFE_DELETE(_listeners);
 }
 
@@ -132,6 +146,64 @@ const Matrix& Transform::getMatrix() const
     return _matrix;
 }
 
+void Transform::setInterpolated(bool interpolated)
+{
+    if (_interpolated == interpolated)
+        return;
+
+    _interpolated = interpolated;
+    if (interpolated)
+    {
+        _previousScale = _scale;
+        _previousRotation = _rotation;
+        _previousTranslation = _translation;
+        _interpolatedTransforms.push_back(this);
+    }
+    else
+    {
+        std::vector<Transform*>::iterator itr = std::find(_interpolatedTransforms.begin(), _interpolatedTransforms.end(), this);
+        GP_ASSERT(itr != _interpolatedTransforms.end());
+        *itr = _interpolatedTransforms.back();
+        _interpolatedTransforms.pop_back();
+    }
+}
+
+bool Transform::isInterpolated() const
+{
+    return _interpolated;
+}
+
+void Transform::getInterpolatedMatrix(float alpha, Matrix* dst) const
+{
+    GP_ASSERT(dst);
+
+    if (!_interpolated || alpha >= 1.0f)
+    {
+        *dst = getMatrix();
+        return;
+    }
+
+    Vector3 scale(_previousScale + (_scale - _previousScale) * alpha);
+    Vector3 translation(_previousTranslation + (_translation - _previousTranslation) * alpha);
+    Quaternion rotation;
+    Quaternion::slerp(_previousRotation, _rotation, alpha, &rotation);
+
+    Matrix::createTranslation(translation, dst);
+    dst->rotate(rotation);
+    dst->scale(scale);
+}
+
+void Transform::storeInterpolationStates()
+{
+    for (size_t i = 0, count = _interpolatedTransforms.size(); i < count; ++i)
+    {
+        Transform* transform = _interpolatedTransforms[i];
+        transform->_previousScale = transform->_scale;
+        transform->_previousRotation = transform->_rotation;
+        transform->_previousTranslation = transform->_translation;
+    }
+}
+
 const Vector3& Transform::getScale() const
 {
     return _scale;
@@ -922,9 +994,78 @@ void Transform::setAnimationPropertyValue(int propertyId, AnimationValue* value,
     }
 }
 
+const signed char* Transform::getAnimationPoseLayout(int propertyId)
+{
+    static const signed char scaleUnit[10] = { 0, 0, 0, -1, -1, -1, -1, -1, -1, -1 };
+    static const signed char scale[10] = { 0, 1, 2, -1, -1, -1, -1, -1, -1, -1 };
+    static const signed char scaleX[10] = { 0, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+    static const signed char scaleY[10] = { -1, 0, -1, -1, -1, -1, -1, -1, -1, -1 };
+    static const signed char scaleZ[10] = { -1, -1, 0, -1, -1, -1, -1, -1, -1, -1 };
+    static const signed char rotate[10] = { -1, -1, -1, 0, 1, 2, 3, -1, -1, -1 };
+    static const signed char translate[10] = { -1, -1, -1, -1, -1, -1, -1, 0, 1, 2 };
+    static const signed char translateX[10] = { -1, -1, -1, -1, -1, -1, -1, 0, -1, -1 };
+    static const signed char translateY[10] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, -1 };
+    static const signed char translateZ[10] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, 0 };
+    static const signed char rotateTranslate[10] = { -1, -1, -1, 0, 1, 2, 3, 4, 5, 6 };
+    static const signed char scaleRotate[10] = { 0, 1, 2, 3, 4, 5, 6, -1, -1, -1 };
+    static const signed char scaleTranslate[10] = { 0, 1, 2, -1, -1, -1, -1, 3, 4, 5 };
+    static const signed char scaleRotateTranslate[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    switch (propertyId)
+    {
+        case ANIMATE_SCALE_UNIT:
+            return scaleUnit;
+        case ANIMATE_SCALE:
+            return scale;
+        case ANIMATE_SCALE_X:
+            return scaleX;
+        case ANIMATE_SCALE_Y:
+            return scaleY;
+        case ANIMATE_SCALE_Z:
+            return scaleZ;
+        case ANIMATE_ROTATE:
+            return rotate;
+        case ANIMATE_TRANSLATE:
+            return translate;
+        case ANIMATE_TRANSLATE_X:
+            return translateX;
+        case ANIMATE_TRANSLATE_Y:
+            return translateY;
+        case ANIMATE_TRANSLATE_Z:
+            return translateZ;
+        case ANIMATE_ROTATE_TRANSLATE:
+            return rotateTranslate;
+        case ANIMATE_SCALE_ROTATE:
+            return scaleRotate;
+        case ANIMATE_SCALE_TRANSLATE:
+            return scaleTranslate;
+        case ANIMATE_SCALE_ROTATE_TRANSLATE:
+            return scaleRotateTranslate;
+        default:
+            return NULL;
+    }
+}
+
+void Transform::setAnimationPose(const float* pose, char matrixDirtyBits)
+{
+    GP_ASSERT(pose);
+
+    if (isStatic() || matrixDirtyBits == 0)
+        return;
+
+    if (matrixDirtyBits & DIRTY_SCALE)
+        _scale.set(pose[0], pose[1], pose[2]);
+    if (matrixDirtyBits & DIRTY_ROTATION)
+        _rotation.set(pose[3], pose[4], pose[5], pose[6]);
+    if (matrixDirtyBits & DIRTY_TRANSLATION)
+        _translation.set(pose[7], pose[8], pose[9]);
+    dirty(matrixDirtyBits);
+}
+
 void Transform::dirty(char matrixDirtyBits)
 {
     _matrixDirtyBits |= matrixDirtyBits;
+    FramePacer::wake();
     if (isTransformChangedSuspended())
     {
         if (!isDirty(DIRTY_NOTIFY))
@@ -991,7 +1132,41 @@ void Transform::transformChanged()
             l.listener->transformChanged(this, l.cookie);
         }
     }
-    fireScriptEvent<void>("transformChanged", this);
+    if (!hasScriptCallbacks(TRANSFORM_EVENT_CHANGED))
+        return;
+
+    if (Game::isSimulatingInParallel())
+    {
+        // Scripts only run on the game thread, which is drawing the previous frame.
+        Mutex::Lock lock(__deferredScriptEventsMutex);
+        _deferredScriptEvents.push_back(this);
+    }
+    else
+    {
+        fireScriptEvent<void>(TRANSFORM_EVENT_CHANGED, this);
+    }
+}
+
+void Transform::fireDeferredScriptEvents()
+{
+    if (_deferredScriptEvents.empty())
+        return;
+
+    // Each transform gets a single event however many times it changed, in the order of its first change.
+    std::vector<Transform*> transforms;
+    transforms.swap(_deferredScriptEvents);
+    std::vector<Transform*> sorted(transforms);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    std::vector<bool> fired(sorted.size(), false);
+    for (size_t i = 0, count = transforms.size(); i < count; ++i)
+    {
+        size_t index = std::lower_bound(sorted.begin(), sorted.end(), transforms[i]) - sorted.begin();
+        if (fired[index])
+            continue;
+        fired[index] = true;
+        transforms[i]->fireScriptEvent<void>(TRANSFORM_EVENT_CHANGED, transforms[i]);
+    }
 }
 
 void Transform::cloneInto(Transform* transform, NodeCloneContext &context) const
@@ -1011,6 +1186,13 @@ void Transform::applyAnimationValueRotation(AnimationValue* value, unsigned int
         return;
 
     GP_ASSERT(value);
+    if (Curve::getRotationInterpolation() == Curve::ROTATION_NLERP)
+    {
+        Quaternion::nlerp(_rotation.x, _rotation.y, _rotation.z, _rotation.w, value->getFloat(index), value->getFloat(index + 1), value->getFloat(index + 2), value->getFloat(index + 3), blendWeight, 
+            &_rotation.x, &_rotation.y, &_rotation.z, &_rotation.w);
+        dirty(DIRTY_ROTATION);
+        return;
+    }
     Quaternion::slerp(_rotation.x, _rotation.y, _rotation.z, _rotation.w, value->getFloat(index), value->getFloat(index + 1), value->getFloat(index + 2), value->getFloat(index + 3), blendWeight, 
         &_rotation.x, &_rotation.y, &_rotation.z, &_rotation.w);
     dirty(DIRTY_ROTATION);
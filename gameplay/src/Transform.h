@@ -31,6 +31,9 @@ class ScriptListener;
  */
 class Transform : public AnimationTarget, public ScriptTarget
 {
+    friend class Game;
+    friend class AnimationController;
+
 public:
 
     /**
@@ -187,6 +190,36 @@ public:
      */
     const Matrix& getMatrix() const;
 
+    /**
+     * Enables or disables interpolation of this transform between fixed time steps.
+     *
+     * When the game runs with a fixed time step, the scale, rotation and translation of
+     * an interpolated transform are recorded before each step so that it can be drawn
+     * part way between the last two steps with getInterpolatedMatrix().
+     *
+     * @param interpolated true to record this transform for interpolation, false otherwise.
+     * @see Game::setFixedTimeStep
+     */
+    void setInterpolated(bool interpolated);
+
+    /**
+     * Determines if this transform is interpolated between fixed time steps.
+     *
+     * @return true if this transform is interpolated, false otherwise.
+     */
+    bool isInterpolated() const;
+
+    /**
+     * Gets the matrix of this transform interpolated between the last two fixed time steps.
+     *
+     * The matrix of a transform that is not interpolated is its current matrix.
+     *
+     * @param alpha The interpolation factor between the previous (0) and the current (1) step,
+     *      typically Game::getInterpolationFactor().
+     * @param dst A matrix to store the result in.
+     */
+    void getInterpolatedMatrix(float alpha, Matrix* dst) const;
+
     /**
      * Returns the scale for this transform.
      */
@@ -836,6 +869,11 @@ protected:
      */
     static void suspendTransformChange(Transform* transform);
 
+    /**
+     * Records the current state of every interpolated transform, before a fixed time step.
+     */
+    static void storeInterpolationStates();
+
     /**
      * Called when the transform changes.
      */
@@ -879,12 +917,53 @@ protected:
      */
     std::list<TransformListener>* _listeners;
 
+    /**
+     * The scale, rotation and translation before the current fixed time step, if interpolated.
+     */
+    Vector3 _previousScale;
+    Quaternion _previousRotation;
+    Vector3 _previousTranslation;
+
+    /**
+     * If the transform is interpolated between fixed time steps.
+     */
+    bool _interpolated;
+
 private:
    
     void applyAnimationValueRotation(AnimationValue* value, unsigned int index, float blendWeight);
 
+    /**
+     * Returns the layout of the values of an animated property in a pose of the transform.
+     *
+     * A pose holds the scale (x, y, z), the rotation (x, y, z, w) and the translation (x, y, z).
+     * For each of these ten components, the layout holds the index of the component of the
+     * property values that sets it, or -1 if the property does not set it.
+     *
+     * @param propertyId The animated property.
+     *
+     * @return The layout, or NULL if the property is not part of the pose.
+     */
+    static const signed char* getAnimationPoseLayout(int propertyId);
+
+    /**
+     * Sets the components of a pose blended by the animation controller, and marks them dirty at once.
+     *
+     * @param pose The scale, rotation and translation of the pose.
+     * @param matrixDirtyBits The components of the pose to set.
+     */
+    void setAnimationPose(const float* pose, char matrixDirtyBits);
+
+    /**
+     * Fires the script events of the transforms that changed while a pipelined frame was
+     * simulated on another thread. Called by Game on the game thread once the simulation is done.
+     */
+    static void fireDeferredScriptEvents();
+
     static int _suspendTransformChanged;
     static std::vector<Transform*> _transformsChanged;
+    static std::vector<Transform*> _interpolatedTransforms;
+    static std::vector<Transform*> _deferredScriptEvents;
     
 };
 
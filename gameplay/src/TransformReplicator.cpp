@@ -0,0 +1,431 @@
+#include "Base.h"
+#include "TransformReplicator.h"
+#include "Node.h"
+
+// The kinds of data written by a replicator.
+#define REPLICATION_CHANGES 1
+#define REPLICATION_STATE 2
+
+// The components written for a node.
+#define REPLICATION_TRANSLATION 0x01
+#define REPLICATION_ROTATION 0x02
+#define REPLICATION_SCALE 0x04
+#define REPLICATION_ALL (REPLICATION_TRANSLATION | REPLICATION_ROTATION | REPLICATION_SCALE)
+
+// The largest magnitude of a quantized translation or scale, so that differences fit in an int.
+#define REPLICATION_QUANTIZED_MAX (1 << 29)
+
+// The number of bits of each of the three smallest components of a quantized rotation.
+#define REPLICATION_ROTATION_BITS 10
+#define REPLICATION_ROTATION_MAX ((1 << REPLICATION_ROTATION_BITS) - 1)
+#define REPLICATION_SQRT2 1.41421356f
+
+namespace gameplay
+{
+
+/**
+ * Quantizes a value to a multiple of the given step.
+ */
+static int quantizeValue(float value, float step)
+{
+    float q = floorf(value / step + 0.5f);
+    if (q > (float)REPLICATION_QUANTIZED_MAX)
+        return REPLICATION_QUANTIZED_MAX;
+    if (q < -(float)REPLICATION_QUANTIZED_MAX)
+        return -REPLICATION_QUANTIZED_MAX;
+    return (int)q;
+}
+
+/**
+ * Quantizes a rotation to the index of its largest component and its three other components.
+ */
+static unsigned int quantizeRotation(const Quaternion& rotation)
+{
+    float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (length < MATH_EPSILON)
+    {
+        q[0] = q[1] = q[2] = 0.0f;
+        q[3] = length = 1.0f;
+    }
+
+    unsigned int largest = 0;
+    for (unsigned int i = 1; i < 4; ++i)
+    {
+        if (fabsf(q[i]) > fabsf(q[largest]))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so the largest component is made positive and left out.
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    float scale = sign / length * REPLICATION_SQRT2 * 0.5f;
+    unsigned int code = largest;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        // The other components are within [-1/sqrt(2), 1/sqrt(2)].
+        int c = (int)floorf((q[i] * scale + 0.5f) * REPLICATION_ROTATION_MAX + 0.5f);
+        c = std::max(0, std::min(c, REPLICATION_ROTATION_MAX));
+        code = (code << REPLICATION_ROTATION_BITS) | (unsigned int)c;
+    }
+    return code;
+}
+
+/**
+ * Returns the rotation of a quantized rotation.
+ */
+static Quaternion dequantizeRotation(unsigned int code)
+{
+    float q[4];
+    unsigned int largest = code >> (REPLICATION_ROTATION_BITS * 3);
+    float sum = 0.0f;
+    for (int i = 3, shift = 0; i >= 0; --i)
+    {
+        if (i == (int)largest)
+            continue;
+        unsigned int c = (code >> shift) & REPLICATION_ROTATION_MAX;
+        q[i] = ((float)c / REPLICATION_ROTATION_MAX - 0.5f) * REPLICATION_SQRT2;
+        sum += q[i] * q[i];
+        shift += REPLICATION_ROTATION_BITS;
+    }
+    q[largest] = sqrtf(std::max(0.0f, 1.0f - sum));
+
+    Quaternion rotation(q[0], q[1], q[2], q[3]);
+    rotation.normalize();
+    return rotation;
+}
+
+/**
+ * Appends an unsigned value in a variable length encoding of 7 bits per byte.
+ */
+static void writeVarint(std::vector<unsigned char>* data, unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        data->push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    data->push_back((unsigned char)value);
+}
+
+/**
+ * Appends a signed value, with small magnitudes written in few bytes.
+ */
+static void writeSigned(std::vector<unsigned char>* data, int value)
+{
+    writeVarint(data, ((unsigned int)value << 1) ^ (unsigned int)(value >> 31));
+}
+
+/**
+ * Reads an unsigned value written by writeVarint.
+ */
+static bool readVarint(const unsigned char** position, const unsigned char* end, unsigned int* value)
+{
+    *value = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7)
+    {
+        if (*position >= end)
+            return false;
+        unsigned char byte = *(*position)++;
+        *value |= (unsigned int)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Reads a signed value written by writeSigned.
+ */
+static bool readSigned(const unsigned char** position, const unsigned char* end, int* value)
+{
+    unsigned int v;
+    if (!readVarint(position, end, &v))
+        return false;
+    *value = (int)(v >> 1) ^ -(int)(v & 1);
+    return true;
+}
+
+TransformReplicator::TransformReplicator(float translationPrecision, float scalePrecision)
+    : _translationPrecision(translationPrecision), _scalePrecision(scalePrecision), _applying(false)
+{
+    GP_ASSERT(translationPrecision > 0.0f && scalePrecision > 0.0f);
+}
+
+TransformReplicator::~TransformReplicator()
+{
+    for (unsigned int i = 0, count = (unsigned int)_entries.size(); i < count; ++i)
+    {
+        removeNode(i);
+    }
+}
+
+TransformReplicator::Entry& TransformReplicator::getEntry(unsigned int id)
+{
+    if (id >= _entries.size())
+    {
+        // Both sides start from the same zero transforms.
+        Entry entry;
+        memset(&entry, 0, sizeof(entry));
+        _entries.resize(id + 1, entry);
+    }
+    return _entries[id];
+}
+
+void TransformReplicator::addNode(unsigned int id, Node* node)
+{
+    GP_ASSERT(node);
+
+    removeNode(id);
+    Entry& entry = getEntry(id);
+    entry.node = node;
+    node->addRef();
+    node->addListener(this, (long)id);
+
+    // The first changes write the whole transform, whatever the receiver's node was.
+    entry.added = true;
+    if (!entry.dirty)
+    {
+        entry.dirty = true;
+        _dirtyEntries.push_back(id);
+    }
+}
+
+void TransformReplicator::removeNode(unsigned int id)
+{
+    if (id >= _entries.size() || !_entries[id].node)
+        return;
+
+    // The last transforms are kept, so the node can be added again on both sides.
+    Entry& entry = _entries[id];
+    entry.node->removeListener(this);
+    SAFE_RELEASE(entry.node);
+    entry.added = false;
+}
+
+Node* TransformReplicator::getNode(unsigned int id) const
+{
+    return id < _entries.size() ? _entries[id].node : NULL;
+}
+
+void TransformReplicator::quantize(Node* node, Entry* entry) const
+{
+    const Vector3& translation = node->getTranslation();
+    const Vector3& scale = node->getScale();
+    entry->translation[0] = quantizeValue(translation.x, _translationPrecision);
+    entry->translation[1] = quantizeValue(translation.y, _translationPrecision);
+    entry->translation[2] = quantizeValue(translation.z, _translationPrecision);
+    entry->rotation = quantizeRotation(node->getRotation());
+    entry->scale[0] = quantizeValue(scale.x, _scalePrecision);
+    entry->scale[1] = quantizeValue(scale.y, _scalePrecision);
+    entry->scale[2] = quantizeValue(scale.z, _scalePrecision);
+}
+
+void TransformReplicator::writeEntry(std::vector<unsigned char>* data, unsigned char mask, const Entry& entry, const Entry& base)
+{
+    data->push_back(mask);
+    if (mask & REPLICATION_TRANSLATION)
+    {
+        for (unsigned int i = 0; i < 3; ++i)
+            writeSigned(data, entry.translation[i] - base.translation[i]);
+    }
+    if (mask & REPLICATION_ROTATION)
+    {
+        // Rotation codes do not change by small differences, so they are written whole.
+        for (unsigned int i = 0; i < 4; ++i)
+            data->push_back((unsigned char)(entry.rotation >> (i * 8)));
+    }
+    if (mask & REPLICATION_SCALE)
+    {
+        for (unsigned int i = 0; i < 3; ++i)
+            writeSigned(data, entry.scale[i] - base.scale[i]);
+    }
+}
+
+unsigned int TransformReplicator::writeChanges(std::vector<unsigned char>* data)
+{
+    GP_ASSERT(data);
+
+    // Nodes are written in the order of their IDs, so each ID is written as the gap from the previous one.
+    std::sort(_dirtyEntries.begin(), _dirtyEntries.end());
+    _changes.clear();
+    for (size_t i = 0, count = _dirtyEntries.size(); i < count; ++i)
+    {
+        unsigned int id = _dirtyEntries[i];
+        Entry& entry = _entries[id];
+        entry.dirty = false;
+        if (!entry.node)
+            continue;
+
+        Entry current = entry;
+        quantize(entry.node, &current);
+        current.added = false;
+        if (entry.added || memcmp(current.translation, entry.translation, sizeof(entry.translation)) != 0 ||
+            current.rotation != entry.rotation || memcmp(current.scale, entry.scale, sizeof(entry.scale)) != 0)
+        {
+            _changes.push_back(std::make_pair(id, current));
+        }
+    }
+    _dirtyEntries.clear();
+
+    if (_changes.empty())
+        return 0;
+
+    data->push_back(REPLICATION_CHANGES);
+    writeVarint(data, (unsigned int)_changes.size());
+    unsigned int previous = 0;
+    for (size_t i = 0, count = _changes.size(); i < count; ++i)
+    {
+        unsigned int id = _changes[i].first;
+        const Entry& current = _changes[i].second;
+        Entry& entry = _entries[id];
+
+        unsigned char mask = REPLICATION_ALL;
+        if (!entry.added)
+        {
+            mask = 0;
+            if (memcmp(current.translation, entry.translation, sizeof(entry.translation)) != 0)
+                mask |= REPLICATION_TRANSLATION;
+            if (current.rotation != entry.rotation)
+                mask |= REPLICATION_ROTATION;
+            if (memcmp(current.scale, entry.scale, sizeof(entry.scale)) != 0)
+                mask |= REPLICATION_SCALE;
+        }
+
+        writeVarint(data, id - previous);
+        previous = id;
+        writeEntry(data, mask, current, entry);
+        entry = current;
+    }
+    return (unsigned int)_changes.size();
+}
+
+void TransformReplicator::writeState(std::vector<unsigned char>* data) const
+{
+    GP_ASSERT(data);
+
+    unsigned int count = 0;
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        if (_entries[i].node)
+            ++count;
+    }
+
+    Entry base;
+    memset(&base, 0, sizeof(base));
+    data->push_back(REPLICATION_STATE);
+    writeVarint(data, count);
+    unsigned int previous = 0;
+    for (unsigned int id = 0; id < _entries.size(); ++id)
+    {
+        if (!_entries[id].node)
+            continue;
+        writeVarint(data, id - previous);
+        previous = id;
+        writeEntry(data, REPLICATION_ALL, _entries[id], base);
+    }
+}
+
+bool TransformReplicator::applyChanges(const unsigned char* data, unsigned int size)
+{
+    GP_ASSERT(data || size == 0);
+
+    const unsigned char* position = data + 1;
+    const unsigned char* end = data + size;
+    unsigned int count;
+    if (size == 0 || (data[0] != REPLICATION_CHANGES && data[0] != REPLICATION_STATE) || !readVarint(&position, end, &count))
+    {
+        GP_WARN("Failed to apply replicated transforms: the data is malformed.");
+        return false;
+    }
+
+    Entry zero;
+    memset(&zero, 0, sizeof(zero));
+    bool state = data[0] == REPLICATION_STATE;
+
+    // The transforms set here do not need to be written back.
+    _applying = true;
+    bool valid = true;
+    unsigned int id = 0;
+    for (unsigned int i = 0; i < count && valid; ++i)
+    {
+        // Bound the IDs, since the entries up to each ID are allocated.
+        unsigned int gap;
+        if (!readVarint(&position, end, &gap) || position >= end || gap > 0xFFFF)
+        {
+            valid = false;
+            break;
+        }
+        id += gap;
+        Entry& entry = getEntry(id);
+        const Entry base = state ? zero : entry;
+        unsigned char mask = *position++;
+
+        if (mask & REPLICATION_TRANSLATION)
+        {
+            for (unsigned int j = 0; j < 3 && valid; ++j)
+            {
+                int difference;
+                valid = readSigned(&position, end, &difference);
+                entry.translation[j] = base.translation[j] + difference;
+            }
+        }
+        if ((mask & REPLICATION_ROTATION) && valid)
+        {
+            valid = end - position >= 4;
+            if (valid)
+            {
+                entry.rotation = position[0] | (position[1] << 8) | (position[2] << 16) | ((unsigned int)position[3] << 24);
+                position += 4;
+            }
+        }
+        if (mask & REPLICATION_SCALE)
+        {
+            for (unsigned int j = 0; j < 3 && valid; ++j)
+            {
+                int difference;
+                valid = readSigned(&position, end, &difference);
+                entry.scale[j] = base.scale[j] + difference;
+            }
+        }
+        if (!valid)
+            break;
+
+        if (entry.node)
+        {
+            if (mask & REPLICATION_TRANSLATION)
+                entry.node->setTranslation(entry.translation[0] * _translationPrecision, entry.translation[1] * _translationPrecision,
+                    entry.translation[2] * _translationPrecision);
+            if (mask & REPLICATION_ROTATION)
+                entry.node->setRotation(dequantizeRotation(entry.rotation));
+            if (mask & REPLICATION_SCALE)
+                entry.node->setScale(entry.scale[0] * _scalePrecision, entry.scale[1] * _scalePrecision, entry.scale[2] * _scalePrecision);
+        }
+    }
+    _applying = false;
+
+    if (!valid)
+    {
+        GP_WARN("Failed to apply replicated transforms: the data is malformed.");
+        return false;
+    }
+    return true;
+}
+
+void TransformReplicator::transformChanged(Transform* transform, long cookie)
+{
+    if (_applying)
+        return;
+
+    unsigned int id = (unsigned int)cookie;
+    GP_ASSERT(id < _entries.size());
+    Entry& entry = _entries[id];
+    if (!entry.dirty)
+    {
+        entry.dirty = true;
+        _dirtyEntries.push_back(id);
+    }
+}
+
+}
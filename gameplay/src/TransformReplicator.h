@@ -0,0 +1,165 @@
+#ifndef TRANSFORMREPLICATOR_H_
+#define TRANSFORMREPLICATOR_H_
+
+#include "Transform.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a replicator of node transforms, which writes the changes of the transforms
+ * of a set of nodes as a compact byte stream and applies that stream to another set of nodes.
+ *
+ * The sending side of a multiplayer game adds the nodes it replicates, each with a small
+ * integer ID shared with the receiving side, and writes the changes once per tick. The
+ * receiving side adds its copies of the nodes with the same IDs and applies the data it
+ * receives, in the order it was written.
+ *
+ * Transforms are quantized before they are sent: translations and scales to a fixed step,
+ * and rotations to 32 bits (the three smallest components at 10 bits each). Each side keeps
+ * the last quantized transform sent or received for each node, so only the nodes whose
+ * quantized transform changed are written, as the differences from those values in a
+ * variable length encoding. Nodes are tracked through their transform listeners, so
+ * writing the changes only visits the nodes that moved.
+ *
+ * The changes of a tick are relative to the changes of the previous ticks, so they must be
+ * delivered reliably and in order. A receiver that joins late, or lost data, is sent the
+ * whole state with writeState(), which it applies like the changes.
+ *
+ * @script{ignore}
+ */
+class TransformReplicator : public Transform::Listener
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * Both sides must use the same precisions.
+     *
+     * @param translationPrecision The step that translations are quantized to.
+     * @param scalePrecision The step that scales are quantized to.
+     */
+    TransformReplicator(float translationPrecision = 0.001f, float scalePrecision = 0.001f);
+
+    /**
+     * Destructor.
+     */
+    ~TransformReplicator();
+
+    /**
+     * Adds a node to replicate.
+     *
+     * IDs should be small, since the replicator keeps an entry for each ID below the largest.
+     * Nodes added to a sending replicator are written with the next changes.
+     *
+     * @param id The ID of the node, which must be the same on both sides.
+     * @param node The node.
+     */
+    void addNode(unsigned int id, Node* node);
+
+    /**
+     * Stops replicating a node.
+     *
+     * @param id The ID of the node.
+     */
+    void removeNode(unsigned int id);
+
+    /**
+     * Returns the node replicated with the given ID.
+     *
+     * @param id The ID of the node.
+     *
+     * @return The node, or NULL if no node has the ID.
+     */
+    Node* getNode(unsigned int id) const;
+
+    /**
+     * Writes the changes of the transforms since the last changes were written.
+     *
+     * @param data The vector to append the changes to.
+     *
+     * @return The number of nodes written, which is 0 when nothing changed (and nothing is appended).
+     */
+    unsigned int writeChanges(std::vector<unsigned char>* data);
+
+    /**
+     * Writes the transforms of every node, as they were last written, for a receiver that joins late.
+     *
+     * The changes that have not been written yet are not included, so this should be called after
+     * writeChanges() in a tick.
+     *
+     * @param data The vector to append the state to.
+     */
+    void writeState(std::vector<unsigned char>* data) const;
+
+    /**
+     * Applies changes or state written by the sending replicator to the nodes of this replicator.
+     *
+     * Data for IDs without a node updates the last received transforms only.
+     *
+     * @param data The data.
+     * @param size The size of the data, in bytes.
+     *
+     * @return true if the data was applied, false if it is malformed.
+     */
+    bool applyChanges(const unsigned char* data, unsigned int size);
+
+    /**
+     * @see Transform::Listener::transformChanged
+     */
+    void transformChanged(Transform* transform, long cookie);
+
+private:
+
+    /**
+     * The last transform sent or received for a node.
+     */
+    struct Entry
+    {
+        Node* node;
+        int translation[3];
+        unsigned int rotation;
+        int scale[3];
+        bool dirty;
+        bool added;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    TransformReplicator(const TransformReplicator& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TransformReplicator& operator=(const TransformReplicator&);
+
+    /**
+     * Returns the entry of an ID, adding the entries up to it.
+     */
+    Entry& getEntry(unsigned int id);
+
+    /**
+     * Quantizes the transform of a node into an entry.
+     */
+    void quantize(Node* node, Entry* entry) const;
+
+    /**
+     * Writes the components of an entry selected by the mask, as differences from the given entry.
+     */
+    static void writeEntry(std::vector<unsigned char>* data, unsigned char mask, const Entry& entry, const Entry& base);
+
+    std::vector<Entry> _entries;
+    std::vector<unsigned int> _dirtyEntries;
+    std::vector<std::pair<unsigned int, Entry> > _changes;
+    float _translationPrecision;
+    float _scalePrecision;
+    bool _applying;
+};
+
+}
+
+#endif
@@ -2,14 +2,16 @@
 #include "VertexAttributeBinding.h"
 #include "Mesh.h"
 #include "Effect.h"
+#include "CommandBuffer.h"
+#include "GLStateCache.h"
 
 namespace gameplay
 {
 
 static GLuint __maxVertexAttribs = 0;
-static std::vector<VertexAttributeBinding*> __vertexAttributeBindingCache;
+static std::map<std::pair<Mesh*, Effect*>, VertexAttributeBinding*> __vertexAttributeBindingCache;
 
-VertexAttributeBinding::VertexAttributeBinding() :
+VertexAttributeBinding::VertexAttributeBinding() : GraphicsResource(RESTORE_ATTACHMENTS),
     _handle(0), _attributes(NULL), _mesh(NULL), _effect(NULL)
 {
 }
@@ -17,10 +19,13 @@ VertexAttributeBinding::VertexAttributeBinding() :
 VertexAttributeBinding::~VertexAttributeBinding()
 {
     // Delete from the vertex attribute binding cache.
-    std::vector<VertexAttributeBinding*>::iterator itr = std::find(__vertexAttributeBindingCache.begin(), __vertexAttributeBindingCache.end(), this);
-    if (itr != __vertexAttributeBindingCache.end())
+    if (_mesh)
     {
-        __vertexAttributeBindingCache.erase(itr);
+        std::map<std::pair<Mesh*, Effect*>, VertexAttributeBinding*>::iterator itr = __vertexAttributeBindingCache.find(std::make_pair(_mesh, _effect));
+        if (itr != __vertexAttributeBindingCache.end() && itr->second == this)
+        {
+            __vertexAttributeBindingCache.erase(itr);
+        }
     }
 
     SAFE_RELEASE(_mesh);
@@ -29,7 +34,8 @@ VertexAttributeBinding::~VertexAttributeBinding()
 
     if (_handle)
     {
-        GL_ASSERT( glDeleteVertexArrays(1, &_handle) );
+        // Deleting a bound vertex array object binds the default one.
+        GLStateCache::deleteVertexArray(_handle);
         _handle = 0;
     }
 }
@@ -39,25 +45,22 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, Effect* effec
     GP_ASSERT(mesh);
 
     // Search for an existing vertex attribute binding that can be used.
-    VertexAttributeBinding* b;
-    for (size_t i = 0, count = __vertexAttributeBindingCache.size(); i < count; ++i)
+    std::pair<Mesh*, Effect*> key(mesh, effect);
+    std::map<std::pair<Mesh*, Effect*>, VertexAttributeBinding*>::const_iterator itr = __vertexAttributeBindingCache.find(key);
+    if (itr != __vertexAttributeBindingCache.end())
     {
-        b = __vertexAttributeBindingCache[i];
-        GP_ASSERT(b);
-        if (b->_mesh == mesh && b->_effect == effect)
-        {
-            // Found a match!
-            b->addRef();
-            return b;
-        }
+        // Found a match!
+        GP_ASSERT(itr->second);
+        itr->second->addRef();
+        return itr->second;
     }
 
-    b = create(mesh, mesh->getVertexFormat(), 0, effect);
+    VertexAttributeBinding* b = create(mesh, mesh->getVertexFormat(), 0, effect);
 
     // Add the new vertex attribute binding to the cache.
     if (b)
     {
-        __vertexAttributeBindingCache.push_back(b);
+        __vertexAttributeBindingCache[key] = b;
     }
 
     return b;
@@ -92,8 +95,8 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
 #ifdef USE_VAO
     if (mesh && glGenVertexArrays)
     {
-        GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
-        GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0) );
+        GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         // Use hardware VAOs.
         GL_ASSERT( glGenVertexArrays(1, &b->_handle) );
@@ -106,10 +109,10 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
         }
 
         // Bind the new VAO.
-        GL_ASSERT( glBindVertexArray(b->_handle) );
+        GLStateCache::bindVertexArray(b->_handle);
 
         // Bind the Mesh VBO so our glVertexAttribPointer calls use it.
-        GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, mesh->getVertexBuffer()) );
+        GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mesh->getVertexBuffer());
     }
     else
 #endif
@@ -139,6 +142,20 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
     effect->addRef();
 
     // Call setVertexAttribPointer for each vertex element.
+    b->setVertexAttributes(vertexFormat, vertexPointer);
+
+    if (b->_handle)
+    {
+        GLStateCache::bindVertexArray(0);
+    }
+
+    return b;
+}
+
+void VertexAttributeBinding::setVertexAttributes(const VertexFormat& vertexFormat, void* vertexPointer)
+{
+    GP_ASSERT(_effect);
+
     std::string name;
     size_t offset = 0;
     for (size_t i = 0, count = vertexFormat.getElementCount(); i < count; ++i)
@@ -150,28 +167,28 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
         switch (e.usage)
         {
         case VertexFormat::POSITION:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
             break;
         case VertexFormat::NORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
             break;
         case VertexFormat::COLOR:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
             break;
         case VertexFormat::TANGENT:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
             break;
         case VertexFormat::BINORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
             break;
         case VertexFormat::BLENDWEIGHTS:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
             break;
         case VertexFormat::BLENDINDICES:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
+            attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
             break;
         case VertexFormat::TEXCOORD0:
-            if ((attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
+            if ((attrib = _effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
                 break;
 
         case VertexFormat::TEXCOORD1:
@@ -183,7 +200,7 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
         case VertexFormat::TEXCOORD7:
             name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
             name += '0' + (e.usage - VertexFormat::TEXCOORD0);
-            attrib = effect->getVertexAttribute(name.c_str());
+            attrib = _effect->getVertexAttribute(name.c_str());
             break;
         default:
             // This happens whenever vertex data contains extra information (not an error).
@@ -193,23 +210,46 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
 
         if (attrib == -1)
         {
-            //GP_WARN("Warning: Vertex element with usage '%s' in mesh '%s' does not correspond to an attribute in effect '%s'.", VertexFormat::toString(e.usage), mesh->getUrl(), effect->getId());
+            //GP_WARN("Warning: Vertex element with usage '%s' in mesh '%s' does not correspond to an attribute in effect '%s'.", VertexFormat::toString(e.usage), _mesh->getUrl(), _effect->getId());
         }
         else
         {
             void* pointer = vertexPointer ? (void*)(((unsigned char*)vertexPointer) + offset) : (void*)offset;
-            b->setVertexAttribPointer(attrib, (GLint)e.size, GL_FLOAT, GL_FALSE, (GLsizei)vertexFormat.getVertexSize(), pointer);
+            setVertexAttribPointer(attrib, (GLint)e.size, (GLenum)e.type, e.normalized ? GL_TRUE : GL_FALSE, (GLsizei)vertexFormat.getVertexSize(), pointer);
         }
 
-        offset += e.size * sizeof(float);
+        offset += e.getByteSize();
     }
+}
 
-    if (b->_handle)
+void VertexAttributeBinding::discardGraphics()
+{
+    _handle = 0;
+}
+
+void VertexAttributeBinding::restoreGraphics()
+{
+#ifdef USE_VAO
+    // Software bindings have no GL objects, and keep the locations of the relinked effect.
+    if (_mesh == NULL || _attributes)
+        return;
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    GL_ASSERT( glGenVertexArrays(1, &_handle) );
+    if (_handle == 0)
     {
-        GL_ASSERT( glBindVertexArray(0) );
+        GP_ERROR("Failed to recreate VAO handle.");
+        return;
     }
 
-    return b;
+    // Rebind the restored vertex buffer of the mesh to the new VAO.
+    GLStateCache::bindVertexArray(_handle);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer());
+    setVertexAttributes(_mesh->getVertexFormat(), 0);
+    GLStateCache::bindVertexArray(0);
+#endif
 }
 
 void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer)
@@ -237,21 +277,30 @@ void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLe
 
 void VertexAttributeBinding::bind()
 {
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
+    {
+        buffer->bindVertexAttributes(this);
+        return;
+    }
+
     if (_handle)
     {
         // Hardware mode
-        GL_ASSERT( glBindVertexArray(_handle) );
+        GLStateCache::bindVertexArray(_handle);
     }
     else
     {
-        // Software mode
+        // Software mode: attribute pointers must not change a vertex array object left bound.
+        resetBinding();
+
         if (_mesh)
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer()) );
+            GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer());
         }
         else
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
+            GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
         }
 
         GP_ASSERT(_attributes);
@@ -269,17 +318,20 @@ void VertexAttributeBinding::bind()
 
 void VertexAttributeBinding::unbind()
 {
-    if (_handle)
+    CommandBuffer* buffer = CommandBuffer::getRecording();
+    if (buffer)
     {
-        // Hardware mode
-        GL_ASSERT( glBindVertexArray(0) );
+        buffer->unbindVertexAttributes(this);
+        return;
     }
-    else
+
+    // In hardware mode the vertex array object stays bound until a different binding is bound.
+    if (_handle == 0)
     {
         // Software mode
         if (_mesh)
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
+            GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
         }
 
         GP_ASSERT(_attributes);
@@ -293,4 +345,11 @@ void VertexAttributeBinding::unbind()
     }
 }
 
+void VertexAttributeBinding::resetBinding()
+{
+#ifdef USE_VAO
+    GLStateCache::bindVertexArray(0);
+#endif
+}
+
 }
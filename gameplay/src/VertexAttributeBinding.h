@@ -3,6 +3,7 @@
 
 #include "Ref.h"
 #include "VertexFormat.h"
+#include "GraphicsResource.h"
 
 namespace gameplay
 {
@@ -29,7 +30,7 @@ class Effect;
  * arrays, since it is slower than the server-side VAOs used by OpenGL
  * (when creating a VertexAttributeBinding between a Mesh and Effect).
  */
-class VertexAttributeBinding : public Ref
+class VertexAttributeBinding : public Ref, private GraphicsResource
 {
 public:
 
@@ -75,9 +76,20 @@ public:
 
     /**
      * Unbinds this vertex array object.
+     *
+     * A hardware vertex array object is left bound, so that drawing with the same binding
+     * again does not bind it again. Code that sets vertex attribute state directly through
+     * OpenGL after drawing should call resetBinding() first.
      */
     void unbind();
 
+    /**
+     * Binds the default vertex array object if a vertex array object was left bound.
+     *
+     * @script{ignore}
+     */
+    static void resetBinding();
+
 private:
 
     class VertexAttribute
@@ -110,6 +122,21 @@ private:
 
     void setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer);
 
+    /**
+     * Sets the attribute pointer of each element of the vertex format to the matching attribute of the effect.
+     */
+    void setVertexAttributes(const VertexFormat& vertexFormat, void* vertexPointer);
+
+    /**
+     * @see GraphicsResource::discardGraphics
+     */
+    void discardGraphics();
+
+    /**
+     * @see GraphicsResource::restoreGraphics
+     */
+    void restoreGraphics();
+
     GLuint _handle;
     VertexAttribute* _attributes;
     Mesh* _mesh;
@@ -17,7 +17,7 @@ VertexFormat::VertexFormat(const Element* elements, unsigned int elementCount)
         memcpy(&element, &elements[i], sizeof(Element));
         _elements.push_back(element);
 
-        _vertexSize += element.size * sizeof(float);
+        _vertexSize += element.getByteSize();
     }
 }
 
@@ -62,18 +62,33 @@ bool VertexFormat::operator != (const VertexFormat& f) const
 }
 
 VertexFormat::Element::Element() :
-    usage(POSITION), size(0)
+    usage(POSITION), size(0), type(FLOAT), normalized(false)
 {
 }
 
-VertexFormat::Element::Element(Usage usage, unsigned int size) :
-    usage(usage), size(size)
+VertexFormat::Element::Element(Usage usage, unsigned int size, Type type, bool normalized) :
+    usage(usage), size(size), type(type), normalized(normalized)
 {
 }
 
+unsigned int VertexFormat::Element::getByteSize() const
+{
+    switch (type)
+    {
+    case HALF_FLOAT:
+        return (size * 2 + 3) & ~3;
+    case UNSIGNED_BYTE:
+        return (size + 3) & ~3;
+    case INT_2_10_10_10_REV:
+        return 4;
+    default:
+        return size * sizeof(float);
+    }
+}
+
 bool VertexFormat::Element::operator == (const VertexFormat::Element& e) const
 {
-    return (size == e.size && usage == e.usage);
+    return (size == e.size && usage == e.usage && type == e.type && normalized == e.normalized);
 }
 
 bool VertexFormat::Element::operator != (const VertexFormat::Element& e) const
@@ -120,4 +135,104 @@ const char* VertexFormat::toString(Usage usage)
     }
 }
 
+bool VertexFormat::isTypeSupported(Type type)
+{
+    switch (type)
+    {
+    case FLOAT:
+    case UNSIGNED_BYTE:
+        return true;
+#ifdef USE_PACKED_VERTEX_TYPES
+    case HALF_FLOAT:
+        return GLEW_VERSION_3_0 || GLEW_ARB_half_float_vertex;
+    case INT_2_10_10_10_REV:
+        return GLEW_VERSION_3_3 || GLEW_ARB_vertex_type_2_10_10_10_rev;
+#endif
+    default:
+        return false;
+    }
+}
+
+static float halfToFloat(unsigned short half)
+{
+    unsigned int sign = (half & 0x8000) << 16;
+    unsigned int exponent = (half >> 10) & 0x1F;
+    unsigned int mantissa = half & 0x3FF;
+
+    unsigned int bits;
+    if (exponent == 0)
+    {
+        // Zero or denormal: renormalize the mantissa.
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            exponent = 127 - 14;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else if (exponent == 31)
+    {
+        // Infinity or NaN.
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+void VertexFormat::toFloat(const Element& element, const void* data, float* values)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(values);
+
+    switch (element.type)
+    {
+    case HALF_FLOAT:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            values[i] = halfToFloat(((const unsigned short*)data)[i]);
+        }
+        break;
+    case UNSIGNED_BYTE:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            unsigned char value = ((const unsigned char*)data)[i];
+            values[i] = element.normalized ? value / 255.0f : (float)value;
+        }
+        break;
+    case INT_2_10_10_10_REV:
+        {
+            unsigned int packed;
+            memcpy(&packed, data, sizeof(unsigned int));
+            for (unsigned int i = 0; i < element.size && i < 4; ++i)
+            {
+                // Sign extend the 10-bit (or 2-bit) component.
+                unsigned int bits = i < 3 ? 10 : 2;
+                int value = (int)(packed >> (i * 10)) & ((1 << bits) - 1);
+                if (value & (1 << (bits - 1)))
+                    value -= 1 << bits;
+                float maxValue = (float)((1 << (bits - 1)) - 1);
+                values[i] = element.normalized ? std::max(value / maxValue, -1.0f) : (float)value;
+            }
+        }
+        break;
+    default:
+        memcpy(values, data, element.size * sizeof(float));
+        break;
+    }
+}
+
 }
@@ -35,13 +35,27 @@ public:
         TEXCOORD7 = 15
     };
 
+    /**
+     * Defines the data types of vertex element values.
+     */
+    enum Type
+    {
+        FLOAT = 0x1406,             // GL_FLOAT
+        HALF_FLOAT = 0x140B,        // GL_HALF_FLOAT
+        UNSIGNED_BYTE = 0x1401,     // GL_UNSIGNED_BYTE
+        INT_2_10_10_10_REV = 0x8D9F // GL_INT_2_10_10_10_REV
+    };
+
     /**
      * Defines a single element within a vertex format.
      *
-     * All vertex elements are assumed to be of type float, but can
-     * have a varying number of float values (1-4), which is represented
-     * by the size attribute. Additionally, vertex elements are assumed
-     * to be tightly packed.
+     * Vertex elements have a varying number of values (1-4), which is
+     * represented by the size attribute, of the element's type. Elements
+     * are float unless specified otherwise. Integer values can be normalized,
+     * in which case shaders see them in the [0,1] range (or [-1,1] for signed
+     * types); INT_2_10_10_10_REV elements always have 4 values packed in
+     * 32 bits. Vertex elements are tightly packed, except that each element
+     * is padded to a multiple of 4 bytes.
      */
     class Element
     {
@@ -56,6 +70,16 @@ public:
          */
         unsigned int size;
 
+        /**
+         * The type of the values in the vertex element.
+         */
+        Type type;
+
+        /**
+         * Whether integer values are normalized to the [0,1] or [-1,1] range.
+         */
+        bool normalized;
+
         /**
          * Constructor.
          */
@@ -65,9 +89,18 @@ public:
          * Constructor.
          *
          * @param usage The vertex element usage semantic.
-         * @param size The number of float values in the vertex element.
+         * @param size The number of values in the vertex element.
+         * @param type The type of the values in the vertex element.
+         * @param normalized Whether integer values are normalized.
          */
-        Element(Usage usage, unsigned int size);
+        Element(Usage usage, unsigned int size, Type type = FLOAT, bool normalized = false);
+
+        /**
+         * Returns the size of the vertex element in bytes, including padding.
+         *
+         * @return The size of the vertex element in bytes.
+         */
+        unsigned int getByteSize() const;
 
         /**
          * Compares two vertex elements for equality.
@@ -145,6 +178,26 @@ public:
      */
     static const char* toString(Usage usage);
 
+    /**
+     * Returns whether the graphics driver can read vertex elements of the specified type.
+     *
+     * Meshes with vertex elements of unsupported types are converted to floats when they are loaded.
+     *
+     * @param type The vertex element type.
+     *
+     * @return True if the type is supported.
+     */
+    static bool isTypeSupported(Type type);
+
+    /**
+     * Converts the values of a vertex element to floats.
+     *
+     * @param element The vertex element.
+     * @param data The packed values of the element.
+     * @param values Receives the element.size float values.
+     */
+    static void toFloat(const Element& element, const void* data, float* values);
+
 private:
 
     std::vector<Element> _elements;
@@ -0,0 +1,82 @@
+#include "Base.h"
+#include "VisibilitySet.h"
+#include "Node.h"
+
+namespace gameplay
+{
+
+VisibilitySet::VisibilitySet(const char* id)
+    : _cellSize(1.0f), _stride(0), _cell(-1)
+{
+    if (id)
+    {
+        _id = id;
+    }
+    _dimensions[0] = _dimensions[1] = _dimensions[2] = 0;
+}
+
+VisibilitySet::~VisibilitySet()
+{
+    setCell(-1);
+    for (size_t i = 0, count = _nodes.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_nodes[i]);
+    }
+}
+
+const char* VisibilitySet::getId() const
+{
+    return _id.c_str();
+}
+
+unsigned int VisibilitySet::getNodeCount() const
+{
+    return (unsigned int)_nodes.size();
+}
+
+Node* VisibilitySet::getNode(unsigned int index) const
+{
+    GP_ASSERT(index < _nodes.size());
+    return _nodes[index];
+}
+
+unsigned int VisibilitySet::getCellCount() const
+{
+    return _dimensions[0] * _dimensions[1] * _dimensions[2];
+}
+
+int VisibilitySet::getCell(const Vector3& position) const
+{
+    float x = (position.x - _origin.x) / _cellSize;
+    float y = (position.y - _origin.y) / _cellSize;
+    float z = (position.z - _origin.z) / _cellSize;
+    if (x < 0.0f || y < 0.0f || z < 0.0f || x >= _dimensions[0] || y >= _dimensions[1] || z >= _dimensions[2])
+        return -1;
+
+    return (int)x + ((int)y + (int)z * _dimensions[1]) * _dimensions[0];
+}
+
+bool VisibilitySet::isVisible(unsigned int cell, unsigned int node) const
+{
+    GP_ASSERT(cell < getCellCount());
+    GP_ASSERT(node < _nodes.size());
+
+    return (_bits[cell * _stride + node / 8] & (1 << (node % 8))) != 0;
+}
+
+void VisibilitySet::setCell(int cell)
+{
+    if (cell == _cell)
+        return;
+
+    _cell = cell;
+    for (unsigned int i = 0, count = (unsigned int)_nodes.size(); i < count; ++i)
+    {
+        if (_nodes[i])
+        {
+            _nodes[i]->_potentiallyHidden = cell >= 0 && !isVisible((unsigned int)cell, i);
+        }
+    }
+}
+
+}
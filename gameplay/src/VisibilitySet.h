@@ -0,0 +1,126 @@
+#ifndef VISIBILITYSET_H_
+#define VISIBILITYSET_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a precomputed potentially visible set (PVS) of the static nodes of a scene.
+ *
+ * The bounds of the static nodes are divided into a grid of cubic cells, and for each
+ * cell the set stores which of the nodes can be seen from somewhere within the cell.
+ * Visibility sets are built offline by the encoder (using the -pvs option) and loaded
+ * with Bundle::loadVisibilitySet().
+ *
+ * Once a visibility set is given to a Scene with Scene::setVisibilitySet(), Scene::cull()
+ * finds the cell of the camera and skips the nodes that cannot be seen from it before
+ * testing them against the frustum. Nodes that are not part of the set, and every node
+ * while the camera is outside the grid, are culled by the frustum alone.
+ *
+ * A visibility set holds references to its nodes. It is only valid while the nodes stay
+ * where they were when the set was computed.
+ *
+ * @script{ignore}
+ */
+class VisibilitySet : public Ref
+{
+    friend class Bundle;
+    friend class Scene;
+
+public:
+
+    /**
+     * Returns the ID of this visibility set.
+     *
+     * @return The ID of this visibility set.
+     */
+    const char* getId() const;
+
+    /**
+     * Returns the number of nodes in this visibility set.
+     *
+     * @return The number of nodes.
+     */
+    unsigned int getNodeCount() const;
+
+    /**
+     * Returns the node at the specified index.
+     *
+     * @param index The index of the node.
+     *
+     * @return The node, or NULL if it was not found when the set was loaded.
+     */
+    Node* getNode(unsigned int index) const;
+
+    /**
+     * Returns the number of cells in the grid.
+     *
+     * @return The number of cells.
+     */
+    unsigned int getCellCount() const;
+
+    /**
+     * Returns the cell containing the specified world-space position.
+     *
+     * @param position The position.
+     *
+     * @return The index of the cell, or -1 if the position is outside the grid.
+     */
+    int getCell(const Vector3& position) const;
+
+    /**
+     * Returns whether the node at the specified index can be seen from the specified cell.
+     *
+     * @param cell The index of the cell.
+     * @param node The index of the node.
+     *
+     * @return True if the node is potentially visible from the cell.
+     */
+    bool isVisible(unsigned int cell, unsigned int node) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    VisibilitySet(const char* id);
+
+    /**
+     * Destructor.
+     */
+    ~VisibilitySet();
+
+    /**
+     * Hidden copy constructor.
+     */
+    VisibilitySet(const VisibilitySet& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    VisibilitySet& operator=(const VisibilitySet&);
+
+    /**
+     * Marks the nodes that cannot be seen from the specified cell (or none if the cell is -1)
+     * so that the octree skips them.
+     */
+    void setCell(int cell);
+
+    std::string _id;
+    Vector3 _origin;
+    float _cellSize;
+    unsigned int _dimensions[3];
+    unsigned int _stride;
+    std::vector<Node*> _nodes;
+    std::vector<unsigned char> _bits;
+    int _cell;
+};
+
+}
+
+#endif
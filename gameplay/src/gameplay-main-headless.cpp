@@ -0,0 +1,29 @@
+#ifdef GP_HEADLESS
+
+#include "gameplay.h"
+
+using namespace gameplay;
+
+#ifndef WIN32
+extern int __argc;
+extern char** __argv;
+#endif
+
+/**
+ * Main entry point.
+ */
+int main(int argc, char** argv)
+{
+#ifndef WIN32
+    __argc = argc;
+    __argv = argv;
+#endif
+    Game* game = Game::getInstance();
+    Platform* platform = Platform::create(game);
+    GP_ASSERT(platform);
+    int result = platform->enterMessagePump();
+    delete platform;
+    return result;
+}
+
+#endif
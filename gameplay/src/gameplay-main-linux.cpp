@@ -1,4 +1,4 @@
-#ifdef __linux__
+#if defined(__linux__) && !defined(GP_HEADLESS)
 
 #include "gameplay.h"
 
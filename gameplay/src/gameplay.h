@@ -7,10 +7,21 @@
 #include "Touch.h"
 #include "Gesture.h"
 #include "Gamepad.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+#include "Telemetry.h"
 #include "FileSystem.h"
 #include "Bundle.h"
 #include "MathUtil.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include "JobScheduler.h"
+#include "MemoryPool.h"
+#include "MemoryTracker.h"
+#include "ScratchMemory.h"
+#include "GraphicsMemory.h"
+#include "FramePacer.h"
+#include "StartupTrace.h"
 
 // Math
 #include "Rectangle.h"
@@ -20,6 +31,7 @@
 #include "Quaternion.h"
 #include "Matrix.h"
 #include "Transform.h"
+#include "TransformReplicator.h"
 #include "Ray.h"
 #include "Plane.h"
 #include "Frustum.h"
@@ -32,27 +44,49 @@
 #include "Image.h"
 #include "Mesh.h"
 #include "MeshPart.h"
+#include "MeshBVH.h"
 #include "Effect.h"
+#include "GLStateCache.h"
+#include "GraphicsResource.h"
 #include "Material.h"
 #include "RenderState.h"
+#include "CommandBuffer.h"
 #include "VertexFormat.h"
 #include "VertexAttributeBinding.h"
 #include "Model.h"
 #include "Camera.h"
 #include "Light.h"
+#include "LightClusters.h"
+#include "OcclusionCuller.h"
+#include "DepthPyramid.h"
+#include "ShadowMap.h"
+#include "ReflectionProbe.h"
 #include "Node.h"
 #include "Joint.h"
 #include "Scene.h"
+#include "SceneSnapshot.h"
+#include "SceneView.h"
+#include "VisibilitySet.h"
+#include "StaticGeometry.h"
 #include "Font.h"
 #include "SpriteBatch.h"
+#include "SpriteRenderer.h"
+#include "BillboardSet.h"
+#include "TextureAtlas.h"
 #include "ParticleEmitter.h"
+#include "ParticleEmitterPool.h"
 #include "FrameBuffer.h"
 #include "RenderTarget.h"
+#include "RenderTargetPool.h"
+#include "DebugDraw.h"
+#include "PostProcessChain.h"
+#include "DynamicResolution.h"
 #include "DepthStencilTarget.h"
 #include "ScreenDisplayer.h"
 #include "HeightField.h"
 #include "Terrain.h"
 #include "TerrainPatch.h"
+#include "TerrainPager.h"
 
 
 // Audio
@@ -89,6 +123,7 @@
 #include "AIAgent.h"
 #include "AIState.h"
 #include "AIStateMachine.h"
+#include "NavMesh.h"
 
 // UI
 #include "Theme.h"
@@ -104,6 +139,7 @@
 #include "Slider.h"
 #include "ImageControl.h"
 #include "JoystickControl.h"
+#include "ListView.h"
 #include "Layout.h"
 #include "AbsoluteLayout.h"
 #include "VerticalLayout.h"
@@ -205,18 +205,7 @@ int lua_AIAgent_getNode(lua_State* state)
             {
                 AIAgent* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -284,18 +273,7 @@ int lua_AIAgent_getStateMachine(lua_State* state)
             {
                 AIAgent* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStateMachine();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "AIStateMachine");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AIStateMachine", false, false);
 
                 return 1;
             }
@@ -510,18 +488,7 @@ int lua_AIAgent_static_create(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)AIAgent::create();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "AIAgent");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "AIAgent", true, false);
 
             return 1;
             break;
@@ -352,18 +352,7 @@ int lua_AIState_static_create(lua_State* state)
                 const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                 void* returnPtr = (void*)AIState::create(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "AIState");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AIState", true, false);
 
                 return 1;
             }
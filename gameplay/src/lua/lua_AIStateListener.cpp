@@ -84,18 +84,7 @@ int lua_AIStateListener__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new AIState::Listener();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "AIStateListener");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "AIStateListener", true, false);
 
             return 1;
             break;
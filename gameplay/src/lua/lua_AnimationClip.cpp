@@ -408,18 +408,7 @@ int lua_AnimationClip_getAnimation(lua_State* state)
             {
                 AnimationClip* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAnimation();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Animation");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                 return 1;
             }
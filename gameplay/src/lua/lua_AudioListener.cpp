@@ -60,18 +60,7 @@ int lua_AudioListener_getCamera(lua_State* state)
             {
                 AudioListener* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getCamera();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Camera");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Camera", false, true);
 
                 return 1;
             }
@@ -139,18 +128,7 @@ int lua_AudioListener_getOrientationForward(lua_State* state)
             {
                 AudioListener* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getOrientationForward());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -183,18 +161,7 @@ int lua_AudioListener_getOrientationUp(lua_State* state)
             {
                 AudioListener* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getOrientationUp());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -227,18 +194,7 @@ int lua_AudioListener_getPosition(lua_State* state)
             {
                 AudioListener* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getPosition());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -271,18 +227,7 @@ int lua_AudioListener_getVelocity(lua_State* state)
             {
                 AudioListener* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getVelocity());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -622,18 +567,7 @@ int lua_AudioListener_static_getInstance(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)AudioListener::getInstance();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "AudioListener");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "AudioListener", false, false);
 
             return 1;
             break;
@@ -179,18 +179,7 @@ int lua_AudioSource_getNode(lua_State* state)
             {
                 AudioSource* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -328,18 +317,7 @@ int lua_AudioSource_getVelocity(lua_State* state)
             {
                 AudioSource* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getVelocity());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -750,18 +728,7 @@ int lua_AudioSource_static_create(lua_State* state)
                     const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                     void* returnPtr = (void*)AudioSource::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "AudioSource");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "AudioSource", true, false);
 
                     return 1;
                 }
@@ -778,18 +745,7 @@ int lua_AudioSource_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)AudioSource::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "AudioSource");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "AudioSource", true, false);
 
                     return 1;
                 }
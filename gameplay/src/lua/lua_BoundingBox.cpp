@@ -90,18 +90,7 @@ int lua_BoundingBox__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new BoundingBox();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "BoundingBox");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", true, false);
 
             return 1;
             break;
@@ -119,18 +108,7 @@ int lua_BoundingBox__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new BoundingBox(*param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "BoundingBox");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", true, false);
 
                     return 1;
                 }
@@ -160,18 +138,7 @@ int lua_BoundingBox__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new BoundingBox(*param1, *param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "BoundingBox");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", true, false);
 
                     return 1;
                 }
@@ -211,18 +178,7 @@ int lua_BoundingBox__init(lua_State* state)
                     float param6 = (float)luaL_checknumber(state, 6);
 
                     void* returnPtr = (void*)new BoundingBox(param1, param2, param3, param4, param5, param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "BoundingBox");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", true, false);
 
                     return 1;
                 }
@@ -258,18 +214,7 @@ int lua_BoundingBox_getCenter(lua_State* state)
                 {
                     BoundingBox* instance = getInstance(state);
                     void* returnPtr = (void*)new Vector3(instance->getCenter());
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Vector3");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
                     return 1;
                 }
@@ -546,18 +491,7 @@ int lua_BoundingBox_max(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->max);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -650,18 +584,7 @@ int lua_BoundingBox_min(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->min);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -810,18 +733,7 @@ int lua_BoundingBox_static_empty(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)&(BoundingBox::empty());
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "BoundingBox");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", false, false);
 
             return 1;
             break;
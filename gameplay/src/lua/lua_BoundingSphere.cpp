@@ -87,18 +87,7 @@ int lua_BoundingSphere__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new BoundingSphere();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "BoundingSphere");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingSphere", true, false);
 
             return 1;
             break;
@@ -116,18 +105,7 @@ int lua_BoundingSphere__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new BoundingSphere(*param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "BoundingSphere");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingSphere", true, false);
 
                     return 1;
                 }
@@ -154,18 +132,7 @@ int lua_BoundingSphere__init(lua_State* state)
                     float param2 = (float)luaL_checknumber(state, 2);
 
                     void* returnPtr = (void*)new BoundingSphere(*param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "BoundingSphere");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingSphere", true, false);
 
                     return 1;
                 }
@@ -212,18 +179,7 @@ int lua_BoundingSphere_center(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->center);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -581,18 +537,7 @@ int lua_BoundingSphere_static_empty(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)&(BoundingSphere::empty());
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "BoundingSphere");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingSphere", false, false);
 
             return 1;
             break;
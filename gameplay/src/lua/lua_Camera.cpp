@@ -339,18 +339,7 @@ int lua_Camera_getFrustum(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getFrustum());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Frustum");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Frustum", false, false);
 
                 return 1;
             }
@@ -383,18 +372,7 @@ int lua_Camera_getInverseViewMatrix(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getInverseViewMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -427,18 +405,7 @@ int lua_Camera_getInverseViewProjectionMatrix(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getInverseViewProjectionMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -506,18 +473,7 @@ int lua_Camera_getNode(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -550,18 +506,7 @@ int lua_Camera_getProjectionMatrix(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getProjectionMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -629,18 +574,7 @@ int lua_Camera_getViewMatrix(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getViewMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -673,18 +607,7 @@ int lua_Camera_getViewProjectionMatrix(lua_State* state)
             {
                 Camera* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getViewProjectionMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -1307,18 +1230,7 @@ int lua_Camera_static_create(lua_State* state)
                 }
 
                 void* returnPtr = (void*)Camera::create(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Camera");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Camera", false, true);
 
                 return 1;
             }
@@ -1369,18 +1281,7 @@ int lua_Camera_static_createOrthographic(lua_State* state)
                 float param5 = (float)luaL_checknumber(state, 5);
 
                 void* returnPtr = (void*)Camera::createOrthographic(param1, param2, param3, param4, param5);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Camera");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Camera", false, true);
 
                 return 1;
             }
@@ -1427,18 +1328,7 @@ int lua_Camera_static_createPerspective(lua_State* state)
                 float param4 = (float)luaL_checknumber(state, 4);
 
                 void* returnPtr = (void*)Camera::createPerspective(param1, param2, param3, param4);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Camera");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Camera", false, true);
 
                 return 1;
             }
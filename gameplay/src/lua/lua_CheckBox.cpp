@@ -372,18 +372,7 @@ int lua_CheckBox_createAnimation(lua_State* state)
 
                     CheckBox* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createAnimation(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Animation");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                     return 1;
                 }
@@ -406,18 +395,7 @@ int lua_CheckBox_createAnimation(lua_State* state)
 
                     CheckBox* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createAnimation(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Animation");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                     return 1;
                 }
@@ -459,18 +437,7 @@ int lua_CheckBox_createAnimation(lua_State* state)
 
                     CheckBox* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createAnimation(param1, param2, param3, param4, param5, param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Animation");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                     return 1;
                 }
@@ -520,18 +487,7 @@ int lua_CheckBox_createAnimation(lua_State* state)
 
                     CheckBox* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createAnimation(param1, param2, param3, param4, param5, param6, param7, param8);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Animation");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                     return 1;
                 }
@@ -589,18 +545,7 @@ int lua_CheckBox_createAnimationFromBy(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createAnimationFromBy(param1, param2, param3, param4, param5, param6);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Animation");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                 return 1;
             }
@@ -657,18 +602,7 @@ int lua_CheckBox_createAnimationFromTo(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createAnimationFromTo(param1, param2, param3, param4, param5, param6);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Animation");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                 return 1;
             }
@@ -751,18 +685,7 @@ int lua_CheckBox_getAbsoluteBounds(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getAbsoluteBounds());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -830,18 +753,7 @@ int lua_CheckBox_getAnimation(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAnimation();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Animation");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                 return 1;
             }
@@ -860,18 +772,7 @@ int lua_CheckBox_getAnimation(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAnimation(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Animation");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Animation", false, true);
 
                 return 1;
             }
@@ -1024,18 +925,7 @@ int lua_CheckBox_getBorder(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBorder());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeSideRegions");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeSideRegions", false, false);
 
                 return 1;
             }
@@ -1054,18 +944,7 @@ int lua_CheckBox_getBorder(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBorder(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeSideRegions");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeSideRegions", false, false);
 
                 return 1;
             }
@@ -1098,18 +977,7 @@ int lua_CheckBox_getBounds(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBounds());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -1142,18 +1010,7 @@ int lua_CheckBox_getClip(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getClip());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -1186,18 +1043,7 @@ int lua_CheckBox_getClipBounds(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getClipBounds());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -1269,18 +1115,7 @@ int lua_CheckBox_getCursorColor(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getCursorColor(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -1317,18 +1152,7 @@ int lua_CheckBox_getCursorRegion(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getCursorRegion(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -1365,18 +1189,7 @@ int lua_CheckBox_getCursorUVs(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getCursorUVs(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeUVs");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeUVs", false, false);
 
                 return 1;
             }
@@ -1444,18 +1257,7 @@ int lua_CheckBox_getFont(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getFont();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Font");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Font", false, true);
 
                 return 1;
             }
@@ -1474,18 +1276,7 @@ int lua_CheckBox_getFont(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getFont(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Font");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Font", false, true);
 
                 return 1;
             }
@@ -1652,18 +1443,7 @@ int lua_CheckBox_getImageColor(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getImageColor(param1, param2));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -1704,18 +1484,7 @@ int lua_CheckBox_getImageRegion(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getImageRegion(param1, param2));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -1756,18 +1525,7 @@ int lua_CheckBox_getImageUVs(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getImageUVs(param1, param2));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeUVs");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeUVs", false, false);
 
                 return 1;
             }
@@ -1800,18 +1558,7 @@ int lua_CheckBox_getMargin(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getMargin());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeSideRegions");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeSideRegions", false, false);
 
                 return 1;
             }
@@ -1900,18 +1647,7 @@ int lua_CheckBox_getPadding(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getPadding());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeSideRegions");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeSideRegions", false, false);
 
                 return 1;
             }
@@ -1944,18 +1680,7 @@ int lua_CheckBox_getParent(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParent();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Control");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Control", false, true);
 
                 return 1;
             }
@@ -2023,18 +1748,7 @@ int lua_CheckBox_getSkinColor(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getSkinColor());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -2053,18 +1767,7 @@ int lua_CheckBox_getSkinColor(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getSkinColor(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -2097,18 +1800,7 @@ int lua_CheckBox_getSkinRegion(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getSkinRegion());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -2127,18 +1819,7 @@ int lua_CheckBox_getSkinRegion(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getSkinRegion(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -2206,18 +1887,7 @@ int lua_CheckBox_getStyle(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStyle();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ThemeStyle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ThemeStyle", false, false);
 
                 return 1;
             }
@@ -2341,18 +2011,7 @@ int lua_CheckBox_getTextColor(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getTextColor());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -2371,18 +2030,7 @@ int lua_CheckBox_getTextColor(lua_State* state)
 
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getTextColor(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -2471,18 +2119,7 @@ int lua_CheckBox_getTheme(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getTheme();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Theme");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Theme", false, true);
 
                 return 1;
             }
@@ -2515,18 +2152,7 @@ int lua_CheckBox_getTopLevelForm(lua_State* state)
             {
                 CheckBox* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getTopLevelForm();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Form");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Form", false, true);
 
                 return 1;
             }
@@ -5242,18 +4868,7 @@ int lua_CheckBox_static_create(lua_State* state)
                 const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                 void* returnPtr = (void*)CheckBox::create(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "CheckBox");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "CheckBox", true, false);
 
                 return 1;
             }
@@ -5280,18 +4895,7 @@ int lua_CheckBox_static_create(lua_State* state)
                 }
 
                 void* returnPtr = (void*)CheckBox::create(param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "CheckBox");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "CheckBox", true, false);
 
                 return 1;
             }
@@ -382,18 +382,7 @@ int lua_DepthStencilTarget_static_create(lua_State* state)
                 unsigned int param4 = (unsigned int)luaL_checkunsigned(state, 4);
 
                 void* returnPtr = (void*)DepthStencilTarget::create(param1, param2, param3, param4);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "DepthStencilTarget");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "DepthStencilTarget", true, false);
 
                 return 1;
             }
@@ -428,18 +417,7 @@ int lua_DepthStencilTarget_static_getDepthStencilTarget(lua_State* state)
                 const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                 void* returnPtr = (void*)DepthStencilTarget::getDepthStencilTarget(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "DepthStencilTarget");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "DepthStencilTarget", false, true);
 
                 return 1;
             }
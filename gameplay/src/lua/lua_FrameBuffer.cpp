@@ -135,18 +135,7 @@ int lua_FrameBuffer_bind(lua_State* state)
             {
                 FrameBuffer* instance = getInstance(state);
                 void* returnPtr = (void*)instance->bind();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "FrameBuffer");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", false, true);
 
                 return 1;
             }
@@ -179,18 +168,7 @@ int lua_FrameBuffer_getDepthStencilTarget(lua_State* state)
             {
                 FrameBuffer* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getDepthStencilTarget();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "DepthStencilTarget");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "DepthStencilTarget", false, true);
 
                 return 1;
             }
@@ -328,18 +306,7 @@ int lua_FrameBuffer_getRenderTarget(lua_State* state)
             {
                 FrameBuffer* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getRenderTarget();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderTarget");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderTarget", false, true);
 
                 return 1;
             }
@@ -358,18 +325,7 @@ int lua_FrameBuffer_getRenderTarget(lua_State* state)
 
                 FrameBuffer* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getRenderTarget(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderTarget");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderTarget", false, true);
 
                 return 1;
             }
@@ -648,18 +604,7 @@ int lua_FrameBuffer_static_bindDefault(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)FrameBuffer::bindDefault();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "FrameBuffer");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", false, true);
 
             return 1;
             break;
@@ -692,18 +637,7 @@ int lua_FrameBuffer_static_create(lua_State* state)
                     const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                     void* returnPtr = (void*)FrameBuffer::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "FrameBuffer");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", true, false);
 
                     return 1;
                 }
@@ -731,18 +665,7 @@ int lua_FrameBuffer_static_create(lua_State* state)
                     unsigned int param3 = (unsigned int)luaL_checkunsigned(state, 3);
 
                     void* returnPtr = (void*)FrameBuffer::create(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "FrameBuffer");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", true, false);
 
                     return 1;
                 }
@@ -773,18 +696,7 @@ int lua_FrameBuffer_static_createScreenshot(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)FrameBuffer::createScreenshot();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "Image");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "Image", false, true);
 
             return 1;
             break;
@@ -810,18 +722,7 @@ int lua_FrameBuffer_static_getCurrent(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)FrameBuffer::getCurrent();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "FrameBuffer");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", false, true);
 
             return 1;
             break;
@@ -852,18 +753,7 @@ int lua_FrameBuffer_static_getFrameBuffer(lua_State* state)
                 const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                 void* returnPtr = (void*)FrameBuffer::getFrameBuffer(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "FrameBuffer");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "FrameBuffer", false, true);
 
                 return 1;
             }
@@ -89,18 +89,7 @@ int lua_Frustum__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new Frustum();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "Frustum");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "Frustum", true, false);
 
             return 1;
             break;
@@ -118,18 +107,7 @@ int lua_Frustum__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new Frustum(*param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Frustum");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Frustum", true, false);
 
                     return 1;
                 }
@@ -146,18 +124,7 @@ int lua_Frustum__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new Frustum(*param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Frustum");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Frustum", true, false);
 
                     return 1;
                 }
@@ -191,18 +158,7 @@ int lua_Frustum_getBottom(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBottom());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
@@ -277,18 +233,7 @@ int lua_Frustum_getFar(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getFar());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
@@ -363,18 +308,7 @@ int lua_Frustum_getLeft(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getLeft());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
@@ -449,18 +383,7 @@ int lua_Frustum_getNear(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getNear());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
@@ -535,18 +458,7 @@ int lua_Frustum_getRight(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getRight());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
@@ -579,18 +491,7 @@ int lua_Frustum_getTop(lua_State* state)
             {
                 Frustum* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getTop());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Plane");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Plane", false, false);
 
                 return 1;
             }
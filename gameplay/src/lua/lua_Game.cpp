@@ -26,6 +26,7 @@ void luaRegister_Game()
     const luaL_Reg lua_members[] = 
     {
         {"canExit", lua_Game_canExit},
+        {"cancelTimeEvent", lua_Game_cancelTimeEvent},
         {"clear", lua_Game_clear},
         {"displayKeyboard", lua_Game_displayKeyboard},
         {"exit", lua_Game_exit},
@@ -175,6 +176,45 @@ int lua_Game_canExit(lua_State* state)
     return 0;
 }
 
+int lua_Game_cancelTimeEvent(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                unsigned int param1 = (unsigned int)luaL_checkunsigned(state, 2);
+
+                Game* instance = getInstance(state);
+                bool result = instance->cancelTimeEvent(param1);
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Game_cancelTimeEvent - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Game_clear(lua_State* state)
 {
     // Get the number of parameters.
@@ -686,18 +726,7 @@ int lua_Game_getAIController(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAIController();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "AIController");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AIController", false, false);
 
                 return 1;
             }
@@ -770,18 +799,7 @@ int lua_Game_getAnimationController(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAnimationController();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "AnimationController");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AnimationController", false, false);
 
                 return 1;
             }
@@ -849,18 +867,7 @@ int lua_Game_getAudioController(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAudioController();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "AudioController");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AudioController", false, false);
 
                 return 1;
             }
@@ -893,18 +900,7 @@ int lua_Game_getAudioListener(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getAudioListener();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "AudioListener");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "AudioListener", false, false);
 
                 return 1;
             }
@@ -937,18 +933,7 @@ int lua_Game_getConfig(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getConfig();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Properties");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Properties", false, false);
 
                 return 1;
             }
@@ -1020,18 +1005,7 @@ int lua_Game_getGamepad(lua_State* state)
 
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getGamepad(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Gamepad");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Gamepad", false, false);
 
                 return 1;
             }
@@ -1054,18 +1028,7 @@ int lua_Game_getGamepad(lua_State* state)
 
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getGamepad(param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Gamepad");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Gamepad", false, false);
 
                 return 1;
             }
@@ -1168,18 +1131,7 @@ int lua_Game_getPhysicsController(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getPhysicsController();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsController");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsController", false, false);
 
                 return 1;
             }
@@ -1212,18 +1164,7 @@ int lua_Game_getScriptController(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getScriptController();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ScriptController");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ScriptController", false, false);
 
                 return 1;
             }
@@ -1347,18 +1288,7 @@ int lua_Game_getViewport(lua_State* state)
             {
                 Game* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getViewport());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Rectangle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Rectangle", false, false);
 
                 return 1;
             }
@@ -2061,9 +1991,12 @@ int lua_Game_schedule(lua_State* state)
                 const char* param2 = gameplay::ScriptUtil::getString(3, false);
 
                 Game* instance = getInstance(state);
-                instance->schedule(param1, param2);
-                
-                return 0;
+                unsigned int result = instance->schedule(param1, param2);
+
+                // Push the return value onto the stack.
+                lua_pushunsigned(state, result);
+
+                return 1;
             }
 
             lua_pushstring(state, "lua_Game_schedule - Failed to match the given parameters to a valid function signature.");
@@ -2333,18 +2266,7 @@ int lua_Game_static_getInstance(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)Game::getInstance();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = false;
-                luaL_getmetatable(state, "Game");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "Game", false, false);
 
             return 1;
             break;
@@ -76,6 +76,7 @@ int lua_Joint_getWorldMatrix(lua_State* state);
 int lua_Joint_getWorldViewMatrix(lua_State* state);
 int lua_Joint_getWorldViewProjectionMatrix(lua_State* state);
 int lua_Joint_hasTag(lua_State* state);
+int lua_Joint_instantiate(lua_State* state);
 int lua_Joint_isActive(lua_State* state);
 int lua_Joint_isActiveInHierarchy(lua_State* state);
 int lua_Joint_isStatic(lua_State* state);
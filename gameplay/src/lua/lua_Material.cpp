@@ -38,8 +38,10 @@ void luaRegister_Material()
         {"getTechnique", lua_Material_getTechnique},
         {"getTechniqueByIndex", lua_Material_getTechniqueByIndex},
         {"getTechniqueCount", lua_Material_getTechniqueCount},
+        {"isDepthPrePass", lua_Material_isDepthPrePass},
         {"release", lua_Material_release},
         {"removeParameter", lua_Material_removeParameter},
+        {"setDepthPrePass", lua_Material_setDepthPrePass},
         {"setNodeBinding", lua_Material_setNodeBinding},
         {"setParameterAutoBinding", lua_Material_setParameterAutoBinding},
         {"setStateBlock", lua_Material_setStateBlock},
@@ -49,6 +51,10 @@ void luaRegister_Material()
     const luaL_Reg lua_statics[] = 
     {
         {"create", lua_Material_static_create},
+        {"getQualityLevel", lua_Material_static_getQualityLevel},
+        {"isAdaptiveQuality", lua_Material_static_isAdaptiveQuality},
+        {"setAdaptiveQuality", lua_Material_static_setAdaptiveQuality},
+        {"setQualityLevel", lua_Material_static_setQualityLevel},
         {NULL, NULL}
     };
     std::vector<std::string> scopePath;
@@ -193,18 +199,7 @@ int lua_Material_getParameter(lua_State* state)
 
                 Material* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameter(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -241,18 +236,7 @@ int lua_Material_getParameterByIndex(lua_State* state)
 
                 Material* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameterByIndex(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -355,18 +339,7 @@ int lua_Material_getStateBlock(lua_State* state)
             {
                 Material* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStateBlock();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderStateStateBlock");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderStateStateBlock", false, true);
 
                 return 1;
             }
@@ -401,18 +374,7 @@ int lua_Material_getTechnique(lua_State* state)
                 {
                     Material* instance = getInstance(state);
                     void* returnPtr = (void*)instance->getTechnique();
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Technique");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Technique", false, true);
 
                     return 1;
                 }
@@ -434,18 +396,7 @@ int lua_Material_getTechnique(lua_State* state)
 
                     Material* instance = getInstance(state);
                     void* returnPtr = (void*)instance->getTechnique(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Technique");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Technique", false, true);
 
                     return 1;
                 }
@@ -483,18 +434,7 @@ int lua_Material_getTechniqueByIndex(lua_State* state)
 
                 Material* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getTechniqueByIndex(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Technique");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Technique", false, true);
 
                 return 1;
             }
@@ -548,6 +488,41 @@ int lua_Material_getTechniqueCount(lua_State* state)
     return 0;
 }
 
+int lua_Material_isDepthPrePass(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Material* instance = getInstance(state);
+                bool result = instance->isDepthPrePass();
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Material_isDepthPrePass - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Material_release(lua_State* state)
 {
     // Get the number of parameters.
@@ -616,6 +591,42 @@ int lua_Material_removeParameter(lua_State* state)
     return 0;
 }
 
+int lua_Material_setDepthPrePass(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TBOOLEAN)
+            {
+                // Get parameter 1 off the stack.
+                bool param1 = gameplay::ScriptUtil::luaCheckBool(state, 2);
+
+                Material* instance = getInstance(state);
+                instance->setDepthPrePass(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Material_setDepthPrePass - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Material_setNodeBinding(lua_State* state)
 {
     // Get the number of parameters.
@@ -816,18 +827,7 @@ int lua_Material_static_create(lua_State* state)
                     const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                     void* returnPtr = (void*)Material::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", true, false);
 
                     return 1;
                 }
@@ -844,18 +844,7 @@ int lua_Material_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)Material::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", true, false);
 
                     return 1;
                 }
@@ -872,18 +861,7 @@ int lua_Material_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)Material::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", true, false);
 
                     return 1;
                 }
@@ -907,18 +885,7 @@ int lua_Material_static_create(lua_State* state)
                     const char* param2 = gameplay::ScriptUtil::getString(2, false);
 
                     void* returnPtr = (void*)Material::create(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", true, false);
 
                     return 1;
                 }
@@ -946,18 +913,7 @@ int lua_Material_static_create(lua_State* state)
                     const char* param3 = gameplay::ScriptUtil::getString(3, false);
 
                     void* returnPtr = (void*)Material::create(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", true, false);
 
                     return 1;
                 }
@@ -977,4 +933,129 @@ int lua_Material_static_create(lua_State* state)
     return 0;
 }
 
+
+int lua_Material_static_getQualityLevel(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 0:
+        {
+            unsigned int result = Material::getQualityLevel();
+
+            // Push the return value onto the stack.
+            lua_pushunsigned(state, result);
+
+            return 1;
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 0).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Material_static_isAdaptiveQuality(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 0:
+        {
+            bool result = Material::isAdaptiveQuality();
+
+            // Push the return value onto the stack.
+            lua_pushboolean(state, result);
+
+            return 1;
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 0).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Material_static_setAdaptiveQuality(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if (lua_type(state, 1) == LUA_TBOOLEAN)
+            {
+                // Get parameter 1 off the stack.
+                bool param1 = gameplay::ScriptUtil::luaCheckBool(state, 1);
+
+                Material::setAdaptiveQuality(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Material_static_setAdaptiveQuality - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Material_static_setQualityLevel(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if (lua_type(state, 1) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                unsigned int param1 = (unsigned int)luaL_checkunsigned(state, 1);
+
+                Material::setQualityLevel(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Material_static_setQualityLevel - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 }
@@ -16,13 +16,19 @@ int lua_Material_getStateBlock(lua_State* state);
 int lua_Material_getTechnique(lua_State* state);
 int lua_Material_getTechniqueByIndex(lua_State* state);
 int lua_Material_getTechniqueCount(lua_State* state);
+int lua_Material_isDepthPrePass(lua_State* state);
 int lua_Material_release(lua_State* state);
 int lua_Material_removeParameter(lua_State* state);
+int lua_Material_setDepthPrePass(lua_State* state);
 int lua_Material_setNodeBinding(lua_State* state);
 int lua_Material_setParameterAutoBinding(lua_State* state);
 int lua_Material_setStateBlock(lua_State* state);
 int lua_Material_setTechnique(lua_State* state);
 int lua_Material_static_create(lua_State* state);
+int lua_Material_static_getQualityLevel(lua_State* state);
+int lua_Material_static_isAdaptiveQuality(lua_State* state);
+int lua_Material_static_setAdaptiveQuality(lua_State* state);
+int lua_Material_static_setQualityLevel(lua_State* state);
 
 void luaRegister_Material();
 
@@ -125,18 +125,7 @@ int lua_Mesh_addPart(lua_State* state)
 
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)instance->addPart(param1, param2, param3);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MeshPart");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MeshPart", false, false);
 
                 return 1;
             }
@@ -167,18 +156,7 @@ int lua_Mesh_addPart(lua_State* state)
 
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)instance->addPart(param1, param2, param3, param4);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MeshPart");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MeshPart", false, false);
 
                 return 1;
             }
@@ -243,18 +221,7 @@ int lua_Mesh_getBoundingBox(lua_State* state)
             {
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBoundingBox());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "BoundingBox");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", false, false);
 
                 return 1;
             }
@@ -287,18 +254,7 @@ int lua_Mesh_getBoundingSphere(lua_State* state)
             {
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBoundingSphere());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "BoundingSphere");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingSphere", false, false);
 
                 return 1;
             }
@@ -335,18 +291,7 @@ int lua_Mesh_getPart(lua_State* state)
 
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getPart(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MeshPart");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MeshPart", false, false);
 
                 return 1;
             }
@@ -519,18 +464,7 @@ int lua_Mesh_getVertexBuffer(lua_State* state)
             {
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)new GLuint(instance->getVertexBuffer());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "GLuint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "GLuint", true, false);
 
                 return 1;
             }
@@ -598,18 +532,7 @@ int lua_Mesh_getVertexFormat(lua_State* state)
             {
                 Mesh* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getVertexFormat());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "VertexFormat");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "VertexFormat", false, false);
 
                 return 1;
             }
@@ -956,18 +879,7 @@ int lua_Mesh_static_createBoundingBox(lua_State* state)
                 }
 
                 void* returnPtr = (void*)Mesh::createBoundingBox(*param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Mesh");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                 return 1;
             }
@@ -1012,18 +924,7 @@ int lua_Mesh_static_createLines(lua_State* state)
                 unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 2);
 
                 void* returnPtr = (void*)Mesh::createLines(param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Mesh");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                 return 1;
             }
@@ -1068,18 +969,7 @@ int lua_Mesh_static_createMesh(lua_State* state)
                 unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 2);
 
                 void* returnPtr = (void*)Mesh::createMesh(*param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Mesh");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                 return 1;
             }
@@ -1110,18 +1000,7 @@ int lua_Mesh_static_createMesh(lua_State* state)
                 bool param3 = gameplay::ScriptUtil::luaCheckBool(state, 3);
 
                 void* returnPtr = (void*)Mesh::createMesh(*param1, param2, param3);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Mesh");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                 return 1;
             }
@@ -1182,18 +1061,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)Mesh::createQuad(*param1, *param2, *param3, *param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1219,18 +1087,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                     float param4 = (float)luaL_checknumber(state, 4);
 
                     void* returnPtr = (void*)Mesh::createQuad(param1, param2, param3, param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1266,18 +1123,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                     float param5 = (float)luaL_checknumber(state, 5);
 
                     void* returnPtr = (void*)Mesh::createQuad(param1, param2, param3, param4, param5);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1317,18 +1163,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                     float param6 = (float)luaL_checknumber(state, 6);
 
                     void* returnPtr = (void*)Mesh::createQuad(param1, param2, param3, param4, param5, param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1372,18 +1207,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                     float param7 = (float)luaL_checknumber(state, 7);
 
                     void* returnPtr = (void*)Mesh::createQuad(param1, param2, param3, param4, param5, param6, param7);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1431,18 +1255,7 @@ int lua_Mesh_static_createQuad(lua_State* state)
                     float param8 = (float)luaL_checknumber(state, 8);
 
                     void* returnPtr = (void*)Mesh::createQuad(param1, param2, param3, param4, param5, param6, param7, param8);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Mesh");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
                     return 1;
                 }
@@ -1473,18 +1286,7 @@ int lua_Mesh_static_createQuadFullscreen(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)Mesh::createQuadFullscreen();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "Mesh");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", true, false);
 
             return 1;
             break;
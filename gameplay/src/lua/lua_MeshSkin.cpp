@@ -60,18 +60,7 @@ int lua_MeshSkin_getBindShape(lua_State* state)
             {
                 MeshSkin* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBindShape());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -110,18 +99,7 @@ int lua_MeshSkin_getJoint(lua_State* state)
 
                     MeshSkin* instance = getInstance(state);
                     void* returnPtr = (void*)instance->getJoint(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Joint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Joint", false, true);
 
                     return 1;
                 }
@@ -137,18 +115,7 @@ int lua_MeshSkin_getJoint(lua_State* state)
 
                     MeshSkin* instance = getInstance(state);
                     void* returnPtr = (void*)instance->getJoint(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Joint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Joint", false, true);
 
                     return 1;
                 }
@@ -262,18 +229,7 @@ int lua_MeshSkin_getMatrixPalette(lua_State* state)
             {
                 MeshSkin* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMatrixPalette();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -341,18 +297,7 @@ int lua_MeshSkin_getModel(lua_State* state)
             {
                 MeshSkin* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getModel();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Model");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Model", false, true);
 
                 return 1;
             }
@@ -385,18 +330,7 @@ int lua_MeshSkin_getRootJoint(lua_State* state)
             {
                 MeshSkin* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getRootJoint();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Joint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Joint", false, true);
 
                 return 1;
             }
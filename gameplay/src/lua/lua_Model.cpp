@@ -26,6 +26,7 @@ void luaRegister_Model()
         {"getNode", lua_Model_getNode},
         {"getRefCount", lua_Model_getRefCount},
         {"getSkin", lua_Model_getSkin},
+        {"getUniqueMaterial", lua_Model_getUniqueMaterial},
         {"hasMaterial", lua_Model_hasMaterial},
         {"release", lua_Model_release},
         {"setMaterial", lua_Model_setMaterial},
@@ -189,18 +190,7 @@ int lua_Model_getMaterial(lua_State* state)
             {
                 Model* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMaterial();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Material");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                 return 1;
             }
@@ -219,18 +209,7 @@ int lua_Model_getMaterial(lua_State* state)
 
                 Model* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMaterial(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Material");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                 return 1;
             }
@@ -263,18 +242,7 @@ int lua_Model_getMesh(lua_State* state)
             {
                 Model* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMesh();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Mesh");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Mesh", false, true);
 
                 return 1;
             }
@@ -342,18 +310,7 @@ int lua_Model_getNode(lua_State* state)
             {
                 Model* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -421,18 +378,7 @@ int lua_Model_getSkin(lua_State* state)
             {
                 Model* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getSkin();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MeshSkin");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MeshSkin", false, true);
 
                 return 1;
             }
@@ -451,6 +397,58 @@ int lua_Model_getSkin(lua_State* state)
     return 0;
 }
 
+int lua_Model_getUniqueMaterial(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Model* instance = getInstance(state);
+                void* returnPtr = (void*)instance->getUniqueMaterial();
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Model_getUniqueMaterial - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                int param1 = (int)luaL_checkint(state, 2);
+
+                Model* instance = getInstance(state);
+                void* returnPtr = (void*)instance->getUniqueMaterial(param1);
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Model_getUniqueMaterial - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1 or 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Model_hasMaterial(lua_State* state)
 {
     // Get the number of parameters.
@@ -560,18 +558,7 @@ int lua_Model_setMaterial(lua_State* state)
 
                     Model* instance = getInstance(state);
                     void* returnPtr = (void*)instance->setMaterial(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                     return 1;
                 }
@@ -619,18 +606,7 @@ int lua_Model_setMaterial(lua_State* state)
 
                     Model* instance = getInstance(state);
                     void* returnPtr = (void*)instance->setMaterial(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                     return 1;
                 }
@@ -650,18 +626,7 @@ int lua_Model_setMaterial(lua_State* state)
 
                     Model* instance = getInstance(state);
                     void* returnPtr = (void*)instance->setMaterial(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                     return 1;
                 }
@@ -691,18 +656,7 @@ int lua_Model_setMaterial(lua_State* state)
 
                     Model* instance = getInstance(state);
                     void* returnPtr = (void*)instance->setMaterial(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                     return 1;
                 }
@@ -736,18 +690,7 @@ int lua_Model_setMaterial(lua_State* state)
 
                     Model* instance = getInstance(state);
                     void* returnPtr = (void*)instance->setMaterial(param1, param2, param3, param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "Material");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                     return 1;
                 }
@@ -831,18 +774,7 @@ int lua_Model_static_create(lua_State* state)
                 }
 
                 void* returnPtr = (void*)Model::create(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Model");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Model", true, false);
 
                 return 1;
             }
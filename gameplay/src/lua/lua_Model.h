@@ -14,6 +14,7 @@ int lua_Model_getMeshPartCount(lua_State* state);
 int lua_Model_getNode(lua_State* state);
 int lua_Model_getRefCount(lua_State* state);
 int lua_Model_getSkin(lua_State* state);
+int lua_Model_getUniqueMaterial(lua_State* state);
 int lua_Model_hasMaterial(lua_State* state);
 int lua_Model_release(lua_State* state);
 int lua_Model_setMaterial(lua_State* state);
@@ -75,6 +75,7 @@ int lua_Node_getWorldMatrix(lua_State* state);
 int lua_Node_getWorldViewMatrix(lua_State* state);
 int lua_Node_getWorldViewProjectionMatrix(lua_State* state);
 int lua_Node_hasTag(lua_State* state);
+int lua_Node_instantiate(lua_State* state);
 int lua_Node_isActive(lua_State* state);
 int lua_Node_isActiveInHierarchy(lua_State* state);
 int lua_Node_isStatic(lua_State* state);
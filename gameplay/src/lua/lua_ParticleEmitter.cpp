@@ -192,18 +192,7 @@ int lua_ParticleEmitter_clone(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->clone();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "ParticleEmitter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "ParticleEmitter", false, true);
 
                 return 1;
             }
@@ -307,18 +296,7 @@ int lua_ParticleEmitter_getAcceleration(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getAcceleration());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -351,18 +329,7 @@ int lua_ParticleEmitter_getAccelerationVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getAccelerationVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -395,18 +362,7 @@ int lua_ParticleEmitter_getColorEnd(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getColorEnd());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -439,18 +395,7 @@ int lua_ParticleEmitter_getColorEndVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getColorEndVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -483,18 +428,7 @@ int lua_ParticleEmitter_getColorStart(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getColorStart());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -527,18 +461,7 @@ int lua_ParticleEmitter_getColorStartVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getColorStartVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector4");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector4", false, false);
 
                 return 1;
             }
@@ -676,18 +599,7 @@ int lua_ParticleEmitter_getNode(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -895,18 +807,7 @@ int lua_ParticleEmitter_getPosition(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getPosition());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -939,18 +840,7 @@ int lua_ParticleEmitter_getPositionVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getPositionVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -1018,18 +908,7 @@ int lua_ParticleEmitter_getRotationAxis(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getRotationAxis());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -1062,18 +941,7 @@ int lua_ParticleEmitter_getRotationAxisVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getRotationAxisVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -1561,18 +1429,7 @@ int lua_ParticleEmitter_getTexture(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getTexture();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Texture");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Texture", false, true);
 
                 return 1;
             }
@@ -1640,18 +1497,7 @@ int lua_ParticleEmitter_getVelocity(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getVelocity());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -1684,18 +1530,7 @@ int lua_ParticleEmitter_getVelocityVariance(lua_State* state)
             {
                 ParticleEmitter* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getVelocityVariance());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
@@ -2899,18 +2734,7 @@ int lua_ParticleEmitter_static_create(lua_State* state)
                     const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                     void* returnPtr = (void*)ParticleEmitter::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "ParticleEmitter");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "ParticleEmitter", true, false);
 
                     return 1;
                 }
@@ -2927,18 +2751,7 @@ int lua_ParticleEmitter_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)ParticleEmitter::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "ParticleEmitter");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "ParticleEmitter", true, false);
 
                     return 1;
                 }
@@ -2966,18 +2779,7 @@ int lua_ParticleEmitter_static_create(lua_State* state)
                     unsigned int param3 = (unsigned int)luaL_checkunsigned(state, 3);
 
                     void* returnPtr = (void*)ParticleEmitter::create(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "ParticleEmitter");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "ParticleEmitter", true, false);
 
                     return 1;
                 }
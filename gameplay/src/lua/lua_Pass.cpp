@@ -216,18 +216,7 @@ int lua_Pass_getEffect(lua_State* state)
             {
                 Pass* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getEffect();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Effect");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Effect", false, true);
 
                 return 1;
             }
@@ -299,18 +288,7 @@ int lua_Pass_getParameter(lua_State* state)
 
                 Pass* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameter(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -347,18 +325,7 @@ int lua_Pass_getParameterByIndex(lua_State* state)
 
                 Pass* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameterByIndex(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -461,18 +428,7 @@ int lua_Pass_getStateBlock(lua_State* state)
             {
                 Pass* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStateBlock();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderStateStateBlock");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderStateStateBlock", false, true);
 
                 return 1;
             }
@@ -505,18 +461,7 @@ int lua_Pass_getVertexAttributeBinding(lua_State* state)
             {
                 Pass* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getVertexAttributeBinding();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "VertexAttributeBinding");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "VertexAttributeBinding", false, true);
 
                 return 1;
             }
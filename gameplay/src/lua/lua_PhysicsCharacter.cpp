@@ -199,18 +199,7 @@ int lua_PhysicsCharacter_asCharacter(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asCharacter();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCharacter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCharacter", false, false);
 
                 return 1;
             }
@@ -243,18 +232,7 @@ int lua_PhysicsCharacter_asGhostObject(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asGhostObject();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsGhostObject");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGhostObject", false, false);
 
                 return 1;
             }
@@ -287,18 +265,7 @@ int lua_PhysicsCharacter_asRigidBody(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asRigidBody();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsRigidBody");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBody", false, false);
 
                 return 1;
             }
@@ -331,18 +298,7 @@ int lua_PhysicsCharacter_asVehicle(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicle();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicle", false, false);
 
                 return 1;
             }
@@ -375,18 +331,7 @@ int lua_PhysicsCharacter_asVehicleWheel(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicleWheel();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicleWheel");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicleWheel", false, false);
 
                 return 1;
             }
@@ -464,18 +409,7 @@ int lua_PhysicsCharacter_getCollisionShape(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getCollisionShape();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCollisionShape");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShape", false, true);
 
                 return 1;
             }
@@ -508,18 +442,7 @@ int lua_PhysicsCharacter_getCurrentVelocity(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)new Vector3(instance->getCurrentVelocity());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
                 return 1;
             }
@@ -622,18 +545,7 @@ int lua_PhysicsCharacter_getNode(lua_State* state)
             {
                 PhysicsCharacter* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -217,18 +217,7 @@ int lua_PhysicsCollisionObject_asCharacter(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asCharacter();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCharacter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCharacter", false, false);
 
                 return 1;
             }
@@ -261,18 +250,7 @@ int lua_PhysicsCollisionObject_asGhostObject(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asGhostObject();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsGhostObject");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGhostObject", false, false);
 
                 return 1;
             }
@@ -305,18 +283,7 @@ int lua_PhysicsCollisionObject_asRigidBody(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asRigidBody();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsRigidBody");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBody", false, false);
 
                 return 1;
             }
@@ -349,18 +316,7 @@ int lua_PhysicsCollisionObject_asVehicle(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicle();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicle", false, false);
 
                 return 1;
             }
@@ -393,18 +349,7 @@ int lua_PhysicsCollisionObject_asVehicleWheel(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicleWheel();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicleWheel");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicleWheel", false, false);
 
                 return 1;
             }
@@ -482,18 +427,7 @@ int lua_PhysicsCollisionObject_getCollisionShape(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getCollisionShape();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCollisionShape");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShape", false, true);
 
                 return 1;
             }
@@ -526,18 +460,7 @@ int lua_PhysicsCollisionObject_getNode(lua_State* state)
             {
                 PhysicsCollisionObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -85,18 +85,7 @@ int lua_PhysicsCollisionShapeDefinition__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new PhysicsCollisionShape::Definition();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "PhysicsCollisionShapeDefinition");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShapeDefinition", true, false);
 
             return 1;
             break;
@@ -114,18 +103,7 @@ int lua_PhysicsCollisionShapeDefinition__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new PhysicsCollisionShape::Definition(*param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsCollisionShapeDefinition");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShapeDefinition", true, false);
 
                     return 1;
                 }
@@ -155,18 +155,7 @@ int lua_PhysicsController_createFixedConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createFixedConstraint(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsFixedConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsFixedConstraint", false, false);
 
                 return 1;
             }
@@ -201,18 +190,7 @@ int lua_PhysicsController_createFixedConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createFixedConstraint(param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsFixedConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsFixedConstraint", false, false);
 
                 return 1;
             }
@@ -254,18 +232,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -297,18 +264,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -347,18 +303,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1, *param2, *param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -404,18 +349,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1, *param2, *param3, param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -468,18 +402,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1, *param2, *param3, param4, *param5);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -539,18 +462,7 @@ int lua_PhysicsController_createGenericConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createGenericConstraint(param1, *param2, *param3, param4, *param5, *param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsGenericConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGenericConstraint", false, false);
 
                     return 1;
                 }
@@ -614,18 +526,7 @@ int lua_PhysicsController_createHingeConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createHingeConstraint(param1, *param2, *param3);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsHingeConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsHingeConstraint", false, false);
 
                 return 1;
             }
@@ -680,18 +581,7 @@ int lua_PhysicsController_createHingeConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createHingeConstraint(param1, *param2, *param3, param4);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsHingeConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsHingeConstraint", false, false);
 
                 return 1;
             }
@@ -756,18 +646,7 @@ int lua_PhysicsController_createHingeConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createHingeConstraint(param1, *param2, *param3, param4, *param5);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsHingeConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsHingeConstraint", false, false);
 
                 return 1;
             }
@@ -842,18 +721,7 @@ int lua_PhysicsController_createHingeConstraint(lua_State* state)
 
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)instance->createHingeConstraint(param1, *param2, *param3, param4, *param5, *param6);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsHingeConstraint");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsHingeConstraint", false, false);
 
                 return 1;
             }
@@ -895,18 +763,7 @@ int lua_PhysicsController_createSocketConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSocketConstraint(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSocketConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSocketConstraint", false, false);
 
                     return 1;
                 }
@@ -938,18 +795,7 @@ int lua_PhysicsController_createSocketConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSocketConstraint(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSocketConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSocketConstraint", false, false);
 
                     return 1;
                 }
@@ -975,18 +821,7 @@ int lua_PhysicsController_createSocketConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSocketConstraint(param1, *param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSocketConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSocketConstraint", false, false);
 
                     return 1;
                 }
@@ -1025,18 +860,7 @@ int lua_PhysicsController_createSocketConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSocketConstraint(param1, *param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSocketConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSocketConstraint", false, false);
 
                     return 1;
                 }
@@ -1082,18 +906,7 @@ int lua_PhysicsController_createSocketConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSocketConstraint(param1, *param2, param3, *param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSocketConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSocketConstraint", false, false);
 
                     return 1;
                 }
@@ -1143,18 +956,7 @@ int lua_PhysicsController_createSpringConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSpringConstraint(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSpringConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSpringConstraint", false, false);
 
                     return 1;
                 }
@@ -1214,18 +1016,7 @@ int lua_PhysicsController_createSpringConstraint(lua_State* state)
 
                     PhysicsController* instance = getInstance(state);
                     void* returnPtr = (void*)instance->createSpringConstraint(param1, *param2, *param3, param4, *param5, *param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = false;
-                        luaL_getmetatable(state, "PhysicsSpringConstraint");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsSpringConstraint", false, false);
 
                     return 1;
                 }
@@ -1301,18 +1092,7 @@ int lua_PhysicsController_getGravity(lua_State* state)
             {
                 PhysicsController* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getGravity());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Vector3");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", false, false);
 
                 return 1;
             }
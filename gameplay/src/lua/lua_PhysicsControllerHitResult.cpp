@@ -89,18 +89,7 @@ int lua_PhysicsControllerHitResult__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new PhysicsController::HitResult();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "PhysicsControllerHitResult");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsControllerHitResult", true, false);
 
             return 1;
             break;
@@ -171,18 +160,7 @@ int lua_PhysicsControllerHitResult_normal(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->normal);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -215,18 +193,7 @@ int lua_PhysicsControllerHitResult_object(lua_State* state)
     else
     {
         void* returnPtr = (void*)instance->object;
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = false;
-            luaL_getmetatable(state, "PhysicsCollisionObject");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionObject", false, false);
 
         return 1;
     }
@@ -259,18 +226,7 @@ int lua_PhysicsControllerHitResult_point(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->point);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
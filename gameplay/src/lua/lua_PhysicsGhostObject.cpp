@@ -185,18 +185,7 @@ int lua_PhysicsGhostObject_asCharacter(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asCharacter();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCharacter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCharacter", false, false);
 
                 return 1;
             }
@@ -229,18 +218,7 @@ int lua_PhysicsGhostObject_asGhostObject(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asGhostObject();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsGhostObject");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGhostObject", false, false);
 
                 return 1;
             }
@@ -273,18 +251,7 @@ int lua_PhysicsGhostObject_asRigidBody(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asRigidBody();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsRigidBody");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBody", false, false);
 
                 return 1;
             }
@@ -317,18 +284,7 @@ int lua_PhysicsGhostObject_asVehicle(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicle();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicle", false, false);
 
                 return 1;
             }
@@ -361,18 +317,7 @@ int lua_PhysicsGhostObject_asVehicleWheel(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicleWheel();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicleWheel");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicleWheel", false, false);
 
                 return 1;
             }
@@ -450,18 +395,7 @@ int lua_PhysicsGhostObject_getCollisionShape(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getCollisionShape();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCollisionShape");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShape", false, true);
 
                 return 1;
             }
@@ -494,18 +428,7 @@ int lua_PhysicsGhostObject_getNode(lua_State* state)
             {
                 PhysicsGhostObject* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -105,18 +105,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
         case 0:
         {
             void* returnPtr = (void*)new PhysicsRigidBody::Parameters();
-            if (returnPtr)
-            {
-                gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                object->instance = returnPtr;
-                object->owns = true;
-                luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                lua_setmetatable(state, -2);
-            }
-            else
-            {
-                lua_pushnil(state);
-            }
+            gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
             return 1;
             break;
@@ -131,18 +120,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     float param1 = (float)luaL_checknumber(state, 1);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -166,18 +144,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     float param2 = (float)luaL_checknumber(state, 2);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -205,18 +172,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     float param3 = (float)luaL_checknumber(state, 3);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -248,18 +204,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     float param4 = (float)luaL_checknumber(state, 4);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -295,18 +240,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     float param5 = (float)luaL_checknumber(state, 5);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4, param5);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -346,18 +280,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     bool param6 = gameplay::ScriptUtil::luaCheckBool(state, 6);
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4, param5, param6);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -404,18 +327,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4, param5, param6, *param7);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -469,18 +381,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4, param5, param6, *param7, *param8);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -541,18 +442,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)new PhysicsRigidBody::Parameters(param1, param2, param3, param4, param5, param6, *param7, *param8, *param9);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "PhysicsRigidBodyParameters");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBodyParameters", true, false);
 
                     return 1;
                 }
@@ -628,18 +518,7 @@ int lua_PhysicsRigidBodyParameters_angularFactor(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->angularFactor);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -672,18 +551,7 @@ int lua_PhysicsRigidBodyParameters_anisotropicFriction(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->anisotropicFriction);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
@@ -803,18 +671,7 @@ int lua_PhysicsRigidBodyParameters_linearFactor(lua_State* state)
     else
     {
         void* returnPtr = (void*)new Vector3(instance->linearFactor);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushObject(state, returnPtr, "Vector3", true, false);
 
         return 1;
     }
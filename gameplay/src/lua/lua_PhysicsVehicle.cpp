@@ -250,18 +250,7 @@ int lua_PhysicsVehicle_asCharacter(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asCharacter();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCharacter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCharacter", false, false);
 
                 return 1;
             }
@@ -294,18 +283,7 @@ int lua_PhysicsVehicle_asGhostObject(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asGhostObject();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsGhostObject");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsGhostObject", false, false);
 
                 return 1;
             }
@@ -338,18 +316,7 @@ int lua_PhysicsVehicle_asRigidBody(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asRigidBody();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsRigidBody");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBody", false, false);
 
                 return 1;
             }
@@ -382,18 +349,7 @@ int lua_PhysicsVehicle_asVehicle(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicle();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicle");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicle", false, false);
 
                 return 1;
             }
@@ -426,18 +382,7 @@ int lua_PhysicsVehicle_asVehicleWheel(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->asVehicleWheel();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicleWheel");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicleWheel", false, false);
 
                 return 1;
             }
@@ -690,18 +635,7 @@ int lua_PhysicsVehicle_getCollisionShape(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getCollisionShape();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsCollisionShape");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsCollisionShape", false, true);
 
                 return 1;
             }
@@ -874,18 +808,7 @@ int lua_PhysicsVehicle_getNode(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getNode();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Node");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Node", false, true);
 
                 return 1;
             }
@@ -953,18 +876,7 @@ int lua_PhysicsVehicle_getRigidBody(lua_State* state)
             {
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getRigidBody();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsRigidBody");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsRigidBody", false, false);
 
                 return 1;
             }
@@ -1246,18 +1158,7 @@ int lua_PhysicsVehicle_getWheel(lua_State* state)
 
                 PhysicsVehicle* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getWheel(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "PhysicsVehicleWheel");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "PhysicsVehicleWheel", false, false);
 
                 return 1;
             }
@@ -18,6 +18,8 @@ static const char* luaEnumString_RenderStateAutoBinding_INVERSE_TRANSPOSE_WORLD_
 static const char* luaEnumString_RenderStateAutoBinding_CAMERA_WORLD_POSITION = "CAMERA_WORLD_POSITION";
 static const char* luaEnumString_RenderStateAutoBinding_CAMERA_VIEW_POSITION = "CAMERA_VIEW_POSITION";
 static const char* luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE = "MATRIX_PALETTE";
+static const char* luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXTURE = "MATRIX_PALETTE_TEXTURE";
+static const char* luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXEL_SIZE = "MATRIX_PALETTE_TEXEL_SIZE";
 static const char* luaEnumString_RenderStateAutoBinding_SCENE_AMBIENT_COLOR = "SCENE_AMBIENT_COLOR";
 
 RenderState::AutoBinding lua_enumFromString_RenderStateAutoBinding(const char* s)
@@ -46,6 +48,10 @@ RenderState::AutoBinding lua_enumFromString_RenderStateAutoBinding(const char* s
         return RenderState::CAMERA_VIEW_POSITION;
     if (strcmp(s, luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE) == 0)
         return RenderState::MATRIX_PALETTE;
+    if (strcmp(s, luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXTURE) == 0)
+        return RenderState::MATRIX_PALETTE_TEXTURE;
+    if (strcmp(s, luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXEL_SIZE) == 0)
+        return RenderState::MATRIX_PALETTE_TEXEL_SIZE;
     if (strcmp(s, luaEnumString_RenderStateAutoBinding_SCENE_AMBIENT_COLOR) == 0)
         return RenderState::SCENE_AMBIENT_COLOR;
     return RenderState::NONE;
@@ -77,6 +83,10 @@ const char* lua_stringFromEnum_RenderStateAutoBinding(RenderState::AutoBinding e
         return luaEnumString_RenderStateAutoBinding_CAMERA_VIEW_POSITION;
     if (e == RenderState::MATRIX_PALETTE)
         return luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE;
+    if (e == RenderState::MATRIX_PALETTE_TEXTURE)
+        return luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXTURE;
+    if (e == RenderState::MATRIX_PALETTE_TEXEL_SIZE)
+        return luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE_TEXEL_SIZE;
     if (e == RenderState::SCENE_AMBIENT_COLOR)
         return luaEnumString_RenderStateAutoBinding_SCENE_AMBIENT_COLOR;
     return enumStringEmpty;
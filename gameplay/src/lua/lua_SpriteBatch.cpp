@@ -987,18 +987,7 @@ int lua_SpriteBatch_getMaterial(lua_State* state)
             {
                 SpriteBatch* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMaterial();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Material");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                 return 1;
             }
@@ -1031,18 +1020,7 @@ int lua_SpriteBatch_getProjectionMatrix(lua_State* state)
             {
                 SpriteBatch* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getProjectionMatrix());
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Matrix");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Matrix", false, false);
 
                 return 1;
             }
@@ -1075,18 +1053,7 @@ int lua_SpriteBatch_getSampler(lua_State* state)
             {
                 SpriteBatch* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getSampler();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "TextureSampler");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "TextureSampler", false, true);
 
                 return 1;
             }
@@ -1119,18 +1086,7 @@ int lua_SpriteBatch_getStateBlock(lua_State* state)
             {
                 SpriteBatch* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStateBlock();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderStateStateBlock");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderStateStateBlock", false, true);
 
                 return 1;
             }
@@ -1276,18 +1232,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                     const char* param1 = gameplay::ScriptUtil::getString(1, false);
 
                     void* returnPtr = (void*)SpriteBatch::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
@@ -1304,18 +1249,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)SpriteBatch::create(param1);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
@@ -1342,18 +1276,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)SpriteBatch::create(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
@@ -1377,18 +1300,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                         break;
 
                     void* returnPtr = (void*)SpriteBatch::create(param1, param2);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
@@ -1419,18 +1331,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                     unsigned int param3 = (unsigned int)luaL_checkunsigned(state, 3);
 
                     void* returnPtr = (void*)SpriteBatch::create(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
@@ -1458,18 +1359,7 @@ int lua_SpriteBatch_static_create(lua_State* state)
                     unsigned int param3 = (unsigned int)luaL_checkunsigned(state, 3);
 
                     void* returnPtr = (void*)SpriteBatch::create(param1, param2, param3);
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "SpriteBatch");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushObject(state, returnPtr, "SpriteBatch", true, false);
 
                     return 1;
                 }
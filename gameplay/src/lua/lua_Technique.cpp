@@ -34,6 +34,7 @@ void luaRegister_Technique()
         {"getPass", lua_Technique_getPass},
         {"getPassByIndex", lua_Technique_getPassByIndex},
         {"getPassCount", lua_Technique_getPassCount},
+        {"getQuality", lua_Technique_getQuality},
         {"getRefCount", lua_Technique_getRefCount},
         {"getStateBlock", lua_Technique_getStateBlock},
         {"release", lua_Technique_release},
@@ -221,18 +222,7 @@ int lua_Technique_getParameter(lua_State* state)
 
                 Technique* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameter(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -269,18 +259,7 @@ int lua_Technique_getParameterByIndex(lua_State* state)
 
                 Technique* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getParameterByIndex(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "MaterialParameter");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "MaterialParameter", false, true);
 
                 return 1;
             }
@@ -352,18 +331,7 @@ int lua_Technique_getPass(lua_State* state)
 
                 Technique* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getPass(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Pass");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Pass", false, true);
 
                 return 1;
             }
@@ -400,18 +368,7 @@ int lua_Technique_getPassByIndex(lua_State* state)
 
                 Technique* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getPassByIndex(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Pass");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Pass", false, true);
 
                 return 1;
             }
@@ -465,6 +422,41 @@ int lua_Technique_getPassCount(lua_State* state)
     return 0;
 }
 
+int lua_Technique_getQuality(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Technique* instance = getInstance(state);
+                unsigned int result = instance->getQuality();
+
+                // Push the return value onto the stack.
+                lua_pushunsigned(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Technique_getQuality - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Technique_getRefCount(lua_State* state)
 {
     // Get the number of parameters.
@@ -514,18 +506,7 @@ int lua_Technique_getStateBlock(lua_State* state)
             {
                 Technique* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getStateBlock();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "RenderStateStateBlock");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "RenderStateStateBlock", false, true);
 
                 return 1;
             }
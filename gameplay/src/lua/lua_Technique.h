@@ -15,6 +15,7 @@ int lua_Technique_getParameterCount(lua_State* state);
 int lua_Technique_getPass(lua_State* state);
 int lua_Technique_getPassByIndex(lua_State* state);
 int lua_Technique_getPassCount(lua_State* state);
+int lua_Technique_getQuality(lua_State* state);
 int lua_Technique_getRefCount(lua_State* state);
 int lua_Technique_getStateBlock(lua_State* state);
 int lua_Technique_release(lua_State* state);
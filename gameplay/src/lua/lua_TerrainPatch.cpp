@@ -98,18 +98,7 @@ int lua_TerrainPatch_getBoundingBox(lua_State* state)
 
                 TerrainPatch* instance = getInstance(state);
                 void* returnPtr = (void*)&(instance->getBoundingBox(param1));
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "BoundingBox");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "BoundingBox", false, false);
 
                 return 1;
             }
@@ -142,18 +131,7 @@ int lua_TerrainPatch_getMaterial(lua_State* state)
             {
                 TerrainPatch* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMaterial();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Material");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                 return 1;
             }
@@ -172,18 +150,7 @@ int lua_TerrainPatch_getMaterial(lua_State* state)
 
                 TerrainPatch* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getMaterial(param1);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Material");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Material", false, true);
 
                 return 1;
             }
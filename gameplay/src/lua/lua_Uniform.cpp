@@ -46,18 +46,7 @@ int lua_Uniform_getEffect(lua_State* state)
             {
                 Uniform* instance = getInstance(state);
                 void* returnPtr = (void*)instance->getEffect();
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = false;
-                    luaL_getmetatable(state, "Effect");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "Effect", false, true);
 
                 return 1;
             }
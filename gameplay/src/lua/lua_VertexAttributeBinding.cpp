@@ -240,18 +240,7 @@ int lua_VertexAttributeBinding_static_create(lua_State* state)
                 }
 
                 void* returnPtr = (void*)VertexAttributeBinding::create(param1, param2);
-                if (returnPtr)
-                {
-                    gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                    object->instance = returnPtr;
-                    object->owns = true;
-                    luaL_getmetatable(state, "VertexAttributeBinding");
-                    lua_setmetatable(state, -2);
-                }
-                else
-                {
-                    lua_pushnil(state);
-                }
+                gameplay::ScriptUtil::pushObject(state, returnPtr, "VertexAttributeBinding", true, false);
 
                 return 1;
             }
@@ -1,4 +1,5 @@
 #include "Base.h"
+#include "ScriptController.h"
 #include "lua_all_bindings.h"
 
 namespace gameplay
@@ -6,131 +7,131 @@ namespace gameplay
 
 void lua_RegisterAllBindings()
 {
-    luaRegister_AIAgent();
-    luaRegister_AIAgentListener();
-    luaRegister_AIController();
-    luaRegister_AIMessage();
-    luaRegister_AIState();
-    luaRegister_AIStateListener();
-    luaRegister_AIStateMachine();
-    luaRegister_AbsoluteLayout();
-    luaRegister_Animation();
-    luaRegister_AnimationClip();
-    luaRegister_AnimationClipListener();
-    luaRegister_AnimationController();
-    luaRegister_AnimationTarget();
-    luaRegister_AnimationValue();
-    luaRegister_AudioBuffer();
-    luaRegister_AudioController();
-    luaRegister_AudioListener();
-    luaRegister_AudioSource();
-    luaRegister_BoundingBox();
-    luaRegister_BoundingSphere();
-    luaRegister_Bundle();
-    luaRegister_Button();
-    luaRegister_Camera();
-    luaRegister_CameraListener();
-    luaRegister_CheckBox();
-    luaRegister_Container();
-    luaRegister_Control();
-    luaRegister_ControlListener();
-    luaRegister_Curve();
-    luaRegister_DepthStencilTarget();
-    luaRegister_Effect();
-    luaRegister_FileSystem();
-    luaRegister_FlowLayout();
-    luaRegister_Font();
-    luaRegister_FontText();
-    luaRegister_Form();
-    luaRegister_FrameBuffer();
-    luaRegister_Frustum();
-    luaRegister_Game();
-    luaRegister_Gamepad();
-    luaRegister_Gesture();
-    luaRegister_HeightField();
-    luaRegister_Image();
-    luaRegister_ImageControl();
-    luaRegister_Joint();
-    luaRegister_JoystickControl();
-    luaRegister_Keyboard();
-    luaRegister_Label();
-    luaRegister_Layout();
-    luaRegister_Light();
-    luaRegister_Logger();
-    luaRegister_Material();
-    luaRegister_MaterialParameter();
-    luaRegister_MathUtil();
-    luaRegister_Matrix();
-    luaRegister_Mesh();
-    luaRegister_MeshBatch();
-    luaRegister_MeshPart();
-    luaRegister_MeshSkin();
-    luaRegister_Model();
-    luaRegister_Mouse();
-    luaRegister_Node();
-    luaRegister_NodeCloneContext();
-    luaRegister_ParticleEmitter();
-    luaRegister_Pass();
-    luaRegister_PhysicsCharacter();
-    luaRegister_PhysicsCollisionObject();
-    luaRegister_PhysicsCollisionObjectCollisionListener();
-    luaRegister_PhysicsCollisionObjectCollisionPair();
-    luaRegister_PhysicsCollisionShape();
-    luaRegister_PhysicsCollisionShapeDefinition();
-    luaRegister_PhysicsConstraint();
-    luaRegister_PhysicsController();
-    luaRegister_PhysicsControllerHitFilter();
-    luaRegister_PhysicsControllerHitResult();
-    luaRegister_PhysicsControllerListener();
-    luaRegister_PhysicsFixedConstraint();
-    luaRegister_PhysicsGenericConstraint();
-    luaRegister_PhysicsGhostObject();
-    luaRegister_PhysicsHingeConstraint();
-    luaRegister_PhysicsRigidBody();
-    luaRegister_PhysicsRigidBodyParameters();
-    luaRegister_PhysicsSocketConstraint();
-    luaRegister_PhysicsSpringConstraint();
-    luaRegister_PhysicsVehicle();
-    luaRegister_PhysicsVehicleWheel();
-    luaRegister_Plane();
-    luaRegister_Platform();
-    luaRegister_Properties();
-    luaRegister_Quaternion();
-    luaRegister_RadioButton();
-    luaRegister_Ray();
-    luaRegister_Rectangle();
-    luaRegister_Ref();
-    luaRegister_RenderState();
-    luaRegister_RenderStateStateBlock();
-    luaRegister_RenderTarget();
-    luaRegister_Scene();
-    luaRegister_ScreenDisplayer();
-    luaRegister_ScriptController();
-    luaRegister_ScriptTarget();
-    luaRegister_Slider();
-    luaRegister_SpriteBatch();
-    luaRegister_Technique();
-    luaRegister_Terrain();
-    luaRegister_TerrainPatch();
-    luaRegister_TextBox();
-    luaRegister_Texture();
-    luaRegister_TextureSampler();
-    luaRegister_Theme();
-    luaRegister_ThemeSideRegions();
-    luaRegister_ThemeStyle();
-    luaRegister_ThemeThemeImage();
-    luaRegister_ThemeUVs();
-    luaRegister_Touch();
-    luaRegister_Transform();
-    luaRegister_TransformListener();
-    luaRegister_Uniform();
-    luaRegister_Vector2();
-    luaRegister_Vector3();
-    luaRegister_Vector4();
-    luaRegister_VertexAttributeBinding();
-    luaRegister_VertexFormat();
-    luaRegister_VertexFormatElement();
-    luaRegister_VerticalLayout();
+    gameplay::ScriptUtil::registerClassLazy("AIAgent", "AIAgent", luaRegister_AIAgent);
+    gameplay::ScriptUtil::registerClassLazy("AIAgent", "AIAgentListener", luaRegister_AIAgentListener);
+    gameplay::ScriptUtil::registerClassLazy("AIController", "AIController", luaRegister_AIController);
+    gameplay::ScriptUtil::registerClassLazy("AIMessage", "AIMessage", luaRegister_AIMessage);
+    gameplay::ScriptUtil::registerClassLazy("AIState", "AIState", luaRegister_AIState);
+    gameplay::ScriptUtil::registerClassLazy("AIState", "AIStateListener", luaRegister_AIStateListener);
+    gameplay::ScriptUtil::registerClassLazy("AIStateMachine", "AIStateMachine", luaRegister_AIStateMachine);
+    gameplay::ScriptUtil::registerClassLazy("AbsoluteLayout", "AbsoluteLayout", luaRegister_AbsoluteLayout);
+    gameplay::ScriptUtil::registerClassLazy("Animation", "Animation", luaRegister_Animation);
+    gameplay::ScriptUtil::registerClassLazy("AnimationClip", "AnimationClip", luaRegister_AnimationClip);
+    gameplay::ScriptUtil::registerClassLazy("AnimationClip", "AnimationClipListener", luaRegister_AnimationClipListener);
+    gameplay::ScriptUtil::registerClassLazy("AnimationController", "AnimationController", luaRegister_AnimationController);
+    gameplay::ScriptUtil::registerClassLazy("AnimationTarget", "AnimationTarget", luaRegister_AnimationTarget);
+    gameplay::ScriptUtil::registerClassLazy("AnimationValue", "AnimationValue", luaRegister_AnimationValue);
+    gameplay::ScriptUtil::registerClassLazy("AudioBuffer", "AudioBuffer", luaRegister_AudioBuffer);
+    gameplay::ScriptUtil::registerClassLazy("AudioController", "AudioController", luaRegister_AudioController);
+    gameplay::ScriptUtil::registerClassLazy("AudioListener", "AudioListener", luaRegister_AudioListener);
+    gameplay::ScriptUtil::registerClassLazy("AudioSource", "AudioSource", luaRegister_AudioSource);
+    gameplay::ScriptUtil::registerClassLazy("BoundingBox", "BoundingBox", luaRegister_BoundingBox);
+    gameplay::ScriptUtil::registerClassLazy("BoundingSphere", "BoundingSphere", luaRegister_BoundingSphere);
+    gameplay::ScriptUtil::registerClassLazy("Bundle", "Bundle", luaRegister_Bundle);
+    gameplay::ScriptUtil::registerClassLazy("Button", "Button", luaRegister_Button);
+    gameplay::ScriptUtil::registerClassLazy("Camera", "Camera", luaRegister_Camera);
+    gameplay::ScriptUtil::registerClassLazy("Camera", "CameraListener", luaRegister_CameraListener);
+    gameplay::ScriptUtil::registerClassLazy("CheckBox", "CheckBox", luaRegister_CheckBox);
+    gameplay::ScriptUtil::registerClassLazy("Container", "Container", luaRegister_Container);
+    gameplay::ScriptUtil::registerClassLazy("Control", "Control", luaRegister_Control);
+    gameplay::ScriptUtil::registerClassLazy("Control", "ControlListener", luaRegister_ControlListener);
+    gameplay::ScriptUtil::registerClassLazy("Curve", "Curve", luaRegister_Curve);
+    gameplay::ScriptUtil::registerClassLazy("DepthStencilTarget", "DepthStencilTarget", luaRegister_DepthStencilTarget);
+    gameplay::ScriptUtil::registerClassLazy("Effect", "Effect", luaRegister_Effect);
+    gameplay::ScriptUtil::registerClassLazy("FileSystem", "FileSystem", luaRegister_FileSystem);
+    gameplay::ScriptUtil::registerClassLazy("FlowLayout", "FlowLayout", luaRegister_FlowLayout);
+    gameplay::ScriptUtil::registerClassLazy("Font", "Font", luaRegister_Font);
+    gameplay::ScriptUtil::registerClassLazy("Font", "FontText", luaRegister_FontText);
+    gameplay::ScriptUtil::registerClassLazy("Form", "Form", luaRegister_Form);
+    gameplay::ScriptUtil::registerClassLazy("FrameBuffer", "FrameBuffer", luaRegister_FrameBuffer);
+    gameplay::ScriptUtil::registerClassLazy("Frustum", "Frustum", luaRegister_Frustum);
+    gameplay::ScriptUtil::registerClassLazy("Game", "Game", luaRegister_Game);
+    gameplay::ScriptUtil::registerClassLazy("Gamepad", "Gamepad", luaRegister_Gamepad);
+    gameplay::ScriptUtil::registerClassLazy("Gesture", "Gesture", luaRegister_Gesture);
+    gameplay::ScriptUtil::registerClassLazy("HeightField", "HeightField", luaRegister_HeightField);
+    gameplay::ScriptUtil::registerClassLazy("Image", "Image", luaRegister_Image);
+    gameplay::ScriptUtil::registerClassLazy("ImageControl", "ImageControl", luaRegister_ImageControl);
+    gameplay::ScriptUtil::registerClassLazy("Joint", "Joint", luaRegister_Joint);
+    gameplay::ScriptUtil::registerClassLazy("JoystickControl", "JoystickControl", luaRegister_JoystickControl);
+    gameplay::ScriptUtil::registerClassLazy("Keyboard", "Keyboard", luaRegister_Keyboard);
+    gameplay::ScriptUtil::registerClassLazy("Label", "Label", luaRegister_Label);
+    gameplay::ScriptUtil::registerClassLazy("Layout", "Layout", luaRegister_Layout);
+    gameplay::ScriptUtil::registerClassLazy("Light", "Light", luaRegister_Light);
+    gameplay::ScriptUtil::registerClassLazy("Logger", "Logger", luaRegister_Logger);
+    gameplay::ScriptUtil::registerClassLazy("Material", "Material", luaRegister_Material);
+    gameplay::ScriptUtil::registerClassLazy("MaterialParameter", "MaterialParameter", luaRegister_MaterialParameter);
+    gameplay::ScriptUtil::registerClassLazy("MathUtil", "MathUtil", luaRegister_MathUtil);
+    gameplay::ScriptUtil::registerClassLazy("Matrix", "Matrix", luaRegister_Matrix);
+    gameplay::ScriptUtil::registerClassLazy("Mesh", "Mesh", luaRegister_Mesh);
+    gameplay::ScriptUtil::registerClassLazy("MeshBatch", "MeshBatch", luaRegister_MeshBatch);
+    gameplay::ScriptUtil::registerClassLazy("MeshPart", "MeshPart", luaRegister_MeshPart);
+    gameplay::ScriptUtil::registerClassLazy("MeshSkin", "MeshSkin", luaRegister_MeshSkin);
+    gameplay::ScriptUtil::registerClassLazy("Model", "Model", luaRegister_Model);
+    gameplay::ScriptUtil::registerClassLazy("Mouse", "Mouse", luaRegister_Mouse);
+    gameplay::ScriptUtil::registerClassLazy("Node", "Node", luaRegister_Node);
+    gameplay::ScriptUtil::registerClassLazy("NodeCloneContext", "NodeCloneContext", luaRegister_NodeCloneContext);
+    gameplay::ScriptUtil::registerClassLazy("ParticleEmitter", "ParticleEmitter", luaRegister_ParticleEmitter);
+    gameplay::ScriptUtil::registerClassLazy("Pass", "Pass", luaRegister_Pass);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCharacter", "PhysicsCharacter", luaRegister_PhysicsCharacter);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCollisionObject", "PhysicsCollisionObject", luaRegister_PhysicsCollisionObject);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCollisionObject", "PhysicsCollisionObjectCollisionListener", luaRegister_PhysicsCollisionObjectCollisionListener);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCollisionObject", "PhysicsCollisionObjectCollisionPair", luaRegister_PhysicsCollisionObjectCollisionPair);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCollisionShape", "PhysicsCollisionShape", luaRegister_PhysicsCollisionShape);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsCollisionShape", "PhysicsCollisionShapeDefinition", luaRegister_PhysicsCollisionShapeDefinition);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsConstraint", "PhysicsConstraint", luaRegister_PhysicsConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsController", "PhysicsController", luaRegister_PhysicsController);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsController", "PhysicsControllerHitFilter", luaRegister_PhysicsControllerHitFilter);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsController", "PhysicsControllerHitResult", luaRegister_PhysicsControllerHitResult);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsController", "PhysicsControllerListener", luaRegister_PhysicsControllerListener);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsFixedConstraint", "PhysicsFixedConstraint", luaRegister_PhysicsFixedConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsGenericConstraint", "PhysicsGenericConstraint", luaRegister_PhysicsGenericConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsGhostObject", "PhysicsGhostObject", luaRegister_PhysicsGhostObject);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsHingeConstraint", "PhysicsHingeConstraint", luaRegister_PhysicsHingeConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsRigidBody", "PhysicsRigidBody", luaRegister_PhysicsRigidBody);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsRigidBody", "PhysicsRigidBodyParameters", luaRegister_PhysicsRigidBodyParameters);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsSocketConstraint", "PhysicsSocketConstraint", luaRegister_PhysicsSocketConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsSpringConstraint", "PhysicsSpringConstraint", luaRegister_PhysicsSpringConstraint);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsVehicle", "PhysicsVehicle", luaRegister_PhysicsVehicle);
+    gameplay::ScriptUtil::registerClassLazy("PhysicsVehicleWheel", "PhysicsVehicleWheel", luaRegister_PhysicsVehicleWheel);
+    gameplay::ScriptUtil::registerClassLazy("Plane", "Plane", luaRegister_Plane);
+    gameplay::ScriptUtil::registerClassLazy("Platform", "Platform", luaRegister_Platform);
+    gameplay::ScriptUtil::registerClassLazy("Properties", "Properties", luaRegister_Properties);
+    gameplay::ScriptUtil::registerClassLazy("Quaternion", "Quaternion", luaRegister_Quaternion);
+    gameplay::ScriptUtil::registerClassLazy("RadioButton", "RadioButton", luaRegister_RadioButton);
+    gameplay::ScriptUtil::registerClassLazy("Ray", "Ray", luaRegister_Ray);
+    gameplay::ScriptUtil::registerClassLazy("Rectangle", "Rectangle", luaRegister_Rectangle);
+    gameplay::ScriptUtil::registerClassLazy("Ref", "Ref", luaRegister_Ref);
+    gameplay::ScriptUtil::registerClassLazy("RenderState", "RenderState", luaRegister_RenderState);
+    gameplay::ScriptUtil::registerClassLazy("RenderState", "RenderStateStateBlock", luaRegister_RenderStateStateBlock);
+    gameplay::ScriptUtil::registerClassLazy("RenderTarget", "RenderTarget", luaRegister_RenderTarget);
+    gameplay::ScriptUtil::registerClassLazy("Scene", "Scene", luaRegister_Scene);
+    gameplay::ScriptUtil::registerClassLazy("ScreenDisplayer", "ScreenDisplayer", luaRegister_ScreenDisplayer);
+    gameplay::ScriptUtil::registerClassLazy("ScriptController", "ScriptController", luaRegister_ScriptController);
+    gameplay::ScriptUtil::registerClassLazy("ScriptTarget", "ScriptTarget", luaRegister_ScriptTarget);
+    gameplay::ScriptUtil::registerClassLazy("Slider", "Slider", luaRegister_Slider);
+    gameplay::ScriptUtil::registerClassLazy("SpriteBatch", "SpriteBatch", luaRegister_SpriteBatch);
+    gameplay::ScriptUtil::registerClassLazy("Technique", "Technique", luaRegister_Technique);
+    gameplay::ScriptUtil::registerClassLazy("Terrain", "Terrain", luaRegister_Terrain);
+    gameplay::ScriptUtil::registerClassLazy("TerrainPatch", "TerrainPatch", luaRegister_TerrainPatch);
+    gameplay::ScriptUtil::registerClassLazy("TextBox", "TextBox", luaRegister_TextBox);
+    gameplay::ScriptUtil::registerClassLazy("Texture", "Texture", luaRegister_Texture);
+    gameplay::ScriptUtil::registerClassLazy("Texture", "TextureSampler", luaRegister_TextureSampler);
+    gameplay::ScriptUtil::registerClassLazy("Theme", "Theme", luaRegister_Theme);
+    gameplay::ScriptUtil::registerClassLazy("Theme", "ThemeSideRegions", luaRegister_ThemeSideRegions);
+    gameplay::ScriptUtil::registerClassLazy("Theme", "ThemeStyle", luaRegister_ThemeStyle);
+    gameplay::ScriptUtil::registerClassLazy("Theme", "ThemeThemeImage", luaRegister_ThemeThemeImage);
+    gameplay::ScriptUtil::registerClassLazy("Theme", "ThemeUVs", luaRegister_ThemeUVs);
+    gameplay::ScriptUtil::registerClassLazy("Touch", "Touch", luaRegister_Touch);
+    gameplay::ScriptUtil::registerClassLazy("Transform", "Transform", luaRegister_Transform);
+    gameplay::ScriptUtil::registerClassLazy("Transform", "TransformListener", luaRegister_TransformListener);
+    gameplay::ScriptUtil::registerClassLazy("Uniform", "Uniform", luaRegister_Uniform);
+    gameplay::ScriptUtil::registerClassLazy("Vector2", "Vector2", luaRegister_Vector2);
+    gameplay::ScriptUtil::registerClassLazy("Vector3", "Vector3", luaRegister_Vector3);
+    gameplay::ScriptUtil::registerClassLazy("Vector4", "Vector4", luaRegister_Vector4);
+    gameplay::ScriptUtil::registerClassLazy("VertexAttributeBinding", "VertexAttributeBinding", luaRegister_VertexAttributeBinding);
+    gameplay::ScriptUtil::registerClassLazy("VertexFormat", "VertexFormat", luaRegister_VertexFormat);
+    gameplay::ScriptUtil::registerClassLazy("VertexFormat", "VertexFormatElement", luaRegister_VertexFormatElement);
+    gameplay::ScriptUtil::registerClassLazy("VerticalLayout", "VerticalLayout", luaRegister_VerticalLayout);
     luaRegister_lua_Global();
 }
 
@@ -0,0 +1,384 @@
+#include "BenchmarkGame.h"
+
+// Declare our game instance
+BenchmarkGame game;
+
+// The number of matrices and points the math kernels cycle through.
+#define MATRIX_COUNT 64
+#define POINT_COUNT 1024
+
+// The number of animated nodes and of keyframes of their animation.
+#define ANIMATED_NODE_COUNT 64
+#define KEYFRAME_COUNT 16
+
+// The number of buttons of the form that is laid out.
+#define BUTTON_COUNT 100
+
+static const char* __paragraph =
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. "
+    "How vexingly quick daft zebras jump! Sphinx of black quartz, judge my vow. "
+    "The five boxing wizards jump quickly. Jackdaws love my big sphinx of quartz. "
+    "Crazy Fredrick bought many very exquisite opal jewels. We promptly judged antique ivory buckles for the next prize.";
+
+BenchmarkGame::BenchmarkGame()
+    : _sampleCount(9), _outputPath("benchmarks.csv"), _done(false), _sink(0.0f), _curve(NULL), _skinnedNode(NULL),
+      _font(NULL), _emitterNode(NULL), _theme(NULL), _form(NULL)
+{
+}
+
+BenchmarkGame::~BenchmarkGame()
+{
+}
+
+void BenchmarkGame::initialize()
+{
+    Properties* config = getConfig()->getNamespace("benchmarks", true);
+    if (config)
+    {
+        if (config->exists("samples"))
+            _sampleCount = std::max(1, config->getInt("samples"));
+        _filter = config->getString("filter", "");
+        _outputPath = config->getString("output", _outputPath.c_str());
+    }
+
+    createFixtures();
+}
+
+void BenchmarkGame::finalize()
+{
+    SAFE_RELEASE(_curve);
+    for (size_t i = 0, count = _animatedNodes.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_animatedNodes[i]);
+    }
+    _animatedNodes.clear();
+    SAFE_RELEASE(_skinnedNode);
+    SAFE_RELEASE(_font);
+    SAFE_RELEASE(_emitterNode);
+    SAFE_RELEASE(_form);
+    SAFE_RELEASE(_theme);
+}
+
+void BenchmarkGame::update(float elapsedTime)
+{
+}
+
+void BenchmarkGame::render(float elapsedTime)
+{
+    clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+
+    // Run the benchmarks from the first frame, once the renderer is ready.
+    if (!_done)
+    {
+        _done = true;
+        runBenchmarks();
+        writeResults();
+        exit();
+    }
+}
+
+void BenchmarkGame::runBenchmarks()
+{
+    static const Benchmark benchmarks[] =
+    {
+        { "matrix.multiply", &BenchmarkGame::matrixMultiply, 100000 },
+        { "matrix.invert", &BenchmarkGame::matrixInvert, 100000 },
+        { "matrix.transformPoint", &BenchmarkGame::matrixTransformPoint, 100000 },
+        { "mathutil.smooth", &BenchmarkGame::mathUtilSmooth, 100000 },
+        { "curve.evaluate", &BenchmarkGame::curveEvaluate, 100000 },
+        { "animationclip.update", &BenchmarkGame::animationClipUpdate, 1000 },
+        { "joint.updateJointMatrix", &BenchmarkGame::jointUpdateJointMatrix, 1000 },
+        { "properties.parse", &BenchmarkGame::propertiesParse, 100 },
+        { "bundle.loadNode", &BenchmarkGame::bundleLoadNode, 20 },
+        { "font.drawText", &BenchmarkGame::fontDrawText, 200 },
+        { "particleemitter.update", &BenchmarkGame::particleEmitterUpdate, 1000 },
+        { "container.layout", &BenchmarkGame::containerLayout, 200 }
+    };
+
+    print("%-28s %10s %14s %14s\n", "benchmark", "iterations", "min (ns)", "median (ns)");
+    for (unsigned int i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+    {
+        if (_filter.empty() || strstr(benchmarks[i].name, _filter.c_str()) != NULL)
+        {
+            runBenchmark(benchmarks[i]);
+        }
+    }
+}
+
+void BenchmarkGame::runBenchmark(const Benchmark& benchmark)
+{
+    // Warm up the caches and the lazily created resources first.
+    (this->*benchmark.kernel)(benchmark.iterations);
+
+    std::vector<double> samples(_sampleCount);
+    for (unsigned int i = 0; i < _sampleCount; ++i)
+    {
+        double start = getAbsoluteTime();
+        (this->*benchmark.kernel)(benchmark.iterations);
+        samples[i] = (getAbsoluteTime() - start) * 1000000.0 / benchmark.iterations;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = benchmark.iterations;
+    result.minimum = samples[0];
+    result.median = samples[_sampleCount / 2];
+    _results.push_back(result);
+
+    print("%-28s %10u %14.1f %14.1f\n", benchmark.name, benchmark.iterations, result.minimum, result.median);
+}
+
+void BenchmarkGame::writeResults()
+{
+    std::ostringstream csv;
+    csv << "benchmark,iterations,min_ns,median_ns\n";
+    for (size_t i = 0, count = _results.size(); i < count; ++i)
+    {
+        const Result& result = _results[i];
+        csv << result.name << "," << result.iterations << "," << result.minimum << "," << result.median << "\n";
+    }
+
+    Stream* stream = FileSystem::open(_outputPath.c_str(), FileSystem::WRITE);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to write the benchmark results to '%s'.", _outputPath.c_str());
+        return;
+    }
+    std::string text = csv.str();
+    stream->write(text.c_str(), 1, text.size());
+    stream->close();
+    SAFE_DELETE(stream);
+    print("Results written to '%s'.\n", _outputPath.c_str());
+}
+
+void BenchmarkGame::createFixtures()
+{
+    // Seed the generator so that every run benchmarks the same data.
+    srand(1);
+
+    _matrices.resize(MATRIX_COUNT);
+    for (unsigned int i = 0; i < MATRIX_COUNT; ++i)
+    {
+        Vector3 axis(MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1() + 2.0f);
+        Matrix::createRotation(axis.normalize(), MATH_RANDOM_0_1() * MATH_PIX2, &_matrices[i]);
+        _matrices[i].translate(MATH_RANDOM_MINUS1_1() * 10.0f, MATH_RANDOM_MINUS1_1() * 10.0f, MATH_RANDOM_MINUS1_1() * 10.0f);
+        _matrices[i].scale(0.5f + MATH_RANDOM_0_1());
+    }
+    _points.resize(POINT_COUNT);
+    for (unsigned int i = 0; i < POINT_COUNT; ++i)
+    {
+        _points[i].set(MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1());
+    }
+
+    // A curve of 64 points of 4 components.
+    _curve = Curve::create(64, 4);
+    for (unsigned int i = 0; i < 64; ++i)
+    {
+        float value[4] = { MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1(), MATH_RANDOM_MINUS1_1() };
+        _curve->setPoint(i, i / 63.0f, value, Curve::LINEAR);
+    }
+
+    // Nodes playing a looping rotate-translate animation.
+    unsigned int keyTimes[KEYFRAME_COUNT];
+    float keyValues[KEYFRAME_COUNT * 7];
+    for (unsigned int i = 0; i < ANIMATED_NODE_COUNT; ++i)
+    {
+        for (unsigned int j = 0; j < KEYFRAME_COUNT; ++j)
+        {
+            Quaternion rotation;
+            Quaternion::createFromAxisAngle(Vector3::unitY(), MATH_RANDOM_0_1() * MATH_PIX2, &rotation);
+            keyTimes[j] = j * 100;
+            float* value = &keyValues[j * 7];
+            value[0] = rotation.x;
+            value[1] = rotation.y;
+            value[2] = rotation.z;
+            value[3] = rotation.w;
+            value[4] = MATH_RANDOM_MINUS1_1();
+            value[5] = MATH_RANDOM_MINUS1_1();
+            value[6] = MATH_RANDOM_MINUS1_1();
+        }
+        Node* node = Node::create();
+        Animation* animation = node->createAnimation("benchmark", Transform::ANIMATE_ROTATE_TRANSLATE, KEYFRAME_COUNT, keyTimes, keyValues, Curve::LINEAR);
+        animation->getClip()->setRepeatCount(AnimationClip::REPEAT_INDEFINITE);
+        animation->play();
+        _animatedNodes.push_back(node);
+    }
+
+    // The skinned character of the character sample.
+    Bundle* bundle = Bundle::create("res/common/sample.gpb");
+    if (bundle)
+    {
+        _skinnedNode = bundle->loadNode("boymesh");
+        SAFE_RELEASE(bundle);
+    }
+    if (_skinnedNode == NULL || _skinnedNode->getModel() == NULL || _skinnedNode->getModel()->getSkin() == NULL)
+    {
+        GP_WARN("Failed to load the skinned model of the joint benchmark.");
+        SAFE_RELEASE(_skinnedNode);
+    }
+
+    _font = Font::create("res/ui/arial.gpb");
+
+    ParticleEmitter* emitter = ParticleEmitter::create("res/logo_powered_white.png", ParticleEmitter::BLEND_ADDITIVE, 2000);
+    emitter->setEmissionRate(2000);
+    emitter->setEnergy(1000, 2000);
+    emitter->start();
+    _emitterNode = Node::create("emitter");
+    _emitterNode->setParticleEmitter(emitter);
+    SAFE_RELEASE(emitter);
+
+    // A flow layout form of buttons.
+    _theme = Theme::create("res/ui/default.theme");
+    _form = Form::create("benchmark", _theme->getStyle("Form"), Layout::LAYOUT_FLOW);
+    _form->setSize(getWidth(), getHeight());
+    for (unsigned int i = 0; i < BUTTON_COUNT; ++i)
+    {
+        Button* button = Button::create("button", _theme->getStyle("Button"));
+        button->setSize(100, 40);
+        button->setText("Button");
+        _form->addControl(button);
+        button->release();
+    }
+}
+
+void BenchmarkGame::matrixMultiply(unsigned int iterations)
+{
+    Matrix result;
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Matrix::multiply(_matrices[i % MATRIX_COUNT], _matrices[(i + 1) % MATRIX_COUNT], &result);
+        sum += result.m[0];
+    }
+    _sink = sum;
+}
+
+void BenchmarkGame::matrixInvert(unsigned int iterations)
+{
+    Matrix result;
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        _matrices[i % MATRIX_COUNT].invert(&result);
+        sum += result.m[0];
+    }
+    _sink = sum;
+}
+
+void BenchmarkGame::matrixTransformPoint(unsigned int iterations)
+{
+    Vector3 result;
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        _matrices[i % MATRIX_COUNT].transformPoint(_points[i % POINT_COUNT], &result);
+        sum += result.x;
+    }
+    _sink = sum;
+}
+
+void BenchmarkGame::mathUtilSmooth(unsigned int iterations)
+{
+    float x = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        MathUtil::smooth(&x, (i & 64) ? 1.0f : -1.0f, 16.0f, 100.0f);
+    }
+    _sink = x;
+}
+
+void BenchmarkGame::curveEvaluate(unsigned int iterations)
+{
+    float value[4];
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        _curve->evaluate((i % POINT_COUNT) / (float)(POINT_COUNT - 1), value);
+        sum += value[0];
+    }
+    _sink = sum;
+}
+
+void BenchmarkGame::animationClipUpdate(unsigned int iterations)
+{
+    // Each update advances the clips of all the animated nodes by one frame.
+    AnimationController* controller = getAnimationController();
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        controller->update(16.0f);
+    }
+    _sink = _animatedNodes[0]->getTranslationX();
+}
+
+void BenchmarkGame::jointUpdateJointMatrix(unsigned int iterations)
+{
+    if (_skinnedNode == NULL)
+        return;
+
+    // Moving the root joint dirties every joint of the skin.
+    MeshSkin* skin = _skinnedNode->getModel()->getSkin();
+    Joint* root = skin->getRootJoint();
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        root->rotateY(0.001f);
+        sum += skin->getMatrixPalette()[0].x;
+    }
+    _sink = sum;
+}
+
+void BenchmarkGame::propertiesParse(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Properties* properties = Properties::create("res/ui/default.theme");
+        SAFE_DELETE(properties);
+    }
+}
+
+void BenchmarkGame::bundleLoadNode(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Bundle* bundle = Bundle::create("res/mesh.gpb");
+        if (bundle == NULL)
+            return;
+        Node* node = bundle->loadNode("duck");
+        SAFE_RELEASE(node);
+        SAFE_RELEASE(bundle);
+    }
+}
+
+void BenchmarkGame::fontDrawText(unsigned int iterations)
+{
+    if (_font == NULL)
+        return;
+
+    Rectangle area(0, 0, getWidth() / 2, getHeight());
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        _font->start();
+        _font->drawText(__paragraph, area, Vector4::one(), _font->getSize(), Font::ALIGN_TOP_LEFT, true);
+        _font->finish();
+    }
+}
+
+void BenchmarkGame::particleEmitterUpdate(unsigned int iterations)
+{
+    ParticleEmitter* emitter = _emitterNode->getParticleEmitter();
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        emitter->update(16.0f);
+    }
+}
+
+void BenchmarkGame::containerLayout(unsigned int iterations)
+{
+    // Resizing the form dirties the flow layout of all its buttons.
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        _form->setWidth((i & 1) ? getWidth() : getWidth() - 100.0f);
+        _form->update(0.0f);
+    }
+}
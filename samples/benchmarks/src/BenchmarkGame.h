@@ -0,0 +1,132 @@
+#ifndef BENCHMARKGAME_H_
+#define BENCHMARKGAME_H_
+
+#include "gameplay.h"
+
+using namespace gameplay;
+
+/**
+ * Runs repeatable microbenchmarks of the core engine kernels and reports their timings.
+ *
+ * Each benchmark times a fixed number of iterations of a kernel on fixed data. It is run
+ * once to warm up, then for a number of timed samples, and the fastest and median times
+ * per iteration are reported. The results are printed and written as comma separated
+ * values, so that the runs of successive engine versions can be compared.
+ *
+ * The number of samples, a filter on the names of the benchmarks to run and the file
+ * to write the results to are read from the "benchmarks" section of game.config.
+ */
+class BenchmarkGame: public Game
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    BenchmarkGame();
+
+    /**
+     * Destructor.
+     */
+    virtual ~BenchmarkGame();
+
+protected:
+
+    /**
+     * @see Game::initialize
+     */
+    void initialize();
+
+    /**
+     * @see Game::finalize
+     */
+    void finalize();
+
+    /**
+     * @see Game::update
+     */
+    void update(float elapsedTime);
+
+    /**
+     * @see Game::render
+     */
+    void render(float elapsedTime);
+
+private:
+
+    /**
+     * Runs a number of iterations of a kernel.
+     */
+    typedef void (BenchmarkGame::*Kernel)(unsigned int iterations);
+
+    /**
+     * Defines a benchmark.
+     */
+    struct Benchmark
+    {
+        const char* name;
+        Kernel kernel;
+        unsigned int iterations;
+    };
+
+    /**
+     * Defines the timings of a benchmark.
+     */
+    struct Result
+    {
+        std::string name;
+        unsigned int iterations;
+        double minimum;
+        double median;
+    };
+
+    void runBenchmarks();
+
+    void runBenchmark(const Benchmark& benchmark);
+
+    void writeResults();
+
+    void createFixtures();
+
+    void matrixMultiply(unsigned int iterations);
+
+    void matrixInvert(unsigned int iterations);
+
+    void matrixTransformPoint(unsigned int iterations);
+
+    void mathUtilSmooth(unsigned int iterations);
+
+    void curveEvaluate(unsigned int iterations);
+
+    void animationClipUpdate(unsigned int iterations);
+
+    void jointUpdateJointMatrix(unsigned int iterations);
+
+    void propertiesParse(unsigned int iterations);
+
+    void bundleLoadNode(unsigned int iterations);
+
+    void fontDrawText(unsigned int iterations);
+
+    void particleEmitterUpdate(unsigned int iterations);
+
+    void containerLayout(unsigned int iterations);
+
+    unsigned int _sampleCount;
+    std::string _filter;
+    std::string _outputPath;
+    std::vector<Result> _results;
+    bool _done;
+    volatile float _sink;
+    std::vector<Matrix> _matrices;
+    std::vector<Vector3> _points;
+    Curve* _curve;
+    std::vector<Node*> _animatedNodes;
+    Node* _skinnedNode;
+    Font* _font;
+    Node* _emitterNode;
+    Theme* _theme;
+    Form* _form;
+};
+
+#endif
@@ -81,6 +81,7 @@ LOCAL_SRC_FILES := ../../../gameplay/src/gameplay-main-android.cpp \
 	PhysicsCollisionObjectSample.cpp \
     PostProcessSample.cpp \
 	SpriteBatchSample.cpp \
+    StressSample.cpp \
 	TerrainSample.cpp \
     TextSample.cpp \
     TextureSample.cpp \
@@ -67,6 +67,27 @@ void SamplesGame::initialize()
             gamepad->getForm()->setEnabled(false);
         }
     }
+
+    // Run the sample named in the config right away, for scripted runs.
+    Properties* config = getConfig()->getNamespace("samples", true);
+    const char* start = config ? config->getString("start") : NULL;
+    if (start)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const SampleRecordList& list = (*_samples)[i];
+            for (size_t j = 0, listSize = list.size(); j < listSize; ++j)
+            {
+                if (list[j].title.compare(start) == 0)
+                {
+                    _sampleSelectForm->setEnabled(false);
+                    runSample(list[j].funcPtr);
+                    return;
+                }
+            }
+        }
+        GP_WARN("No sample is titled '%s'.", start);
+    }
 }
 
 void SamplesGame::finalize()
@@ -0,0 +1,544 @@
+#include "StressSample.h"
+#include "SamplesGame.h"
+
+#if defined(ADD_SAMPLE)
+    ADD_SAMPLE("Stress", "Stress Scenarios", StressSample, 1);
+#endif
+
+// The size of each scenario, multiplied by the configured scale.
+#define STRESS_CHARACTER_COUNT 100
+#define STRESS_PARTICLE_COUNT 10000
+#define STRESS_CONTROL_COUNT 200
+#define STRESS_RIGID_BODY_COUNT 200
+#define STRESS_LIGHT_COUNT 32
+
+// The number of particles of each particle emitter.
+#define STRESS_PARTICLES_PER_EMITTER 1000
+
+// The distance between the objects laid out on a grid.
+#define STRESS_GRID_SPACING 3.0f
+
+static const char* __scenarioNames[] = { "characters", "particles", "controls", "rigidBodies", "lights" };
+
+// The blocks timed by the game every frame, and those timed by this sample.
+static const char* __phaseNames[] =
+{
+    "Frame", "Animation", "Physics", "AI", "Gamepad", "Update", "Forms", "Script", "Transforms", "Audio",
+    "Render", "Script Render", "Script GC", "Texture Streaming", "Render Thread Wait", "Stress Update", "Stress Render"
+};
+
+static const unsigned int __phaseCount = sizeof(__phaseNames) / sizeof(__phaseNames[0]);
+
+/**
+ * Returns the value below which a fraction of the sorted values fall.
+ */
+static float percentile(const std::vector<float>& sorted, float fraction)
+{
+    if (sorted.empty())
+        return 0.0f;
+    size_t index = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+    return sorted[index];
+}
+
+StressSample::StressSample()
+    : _font(NULL), _scene(NULL), _lightNode(NULL), _form(NULL), _frameCount(600), _warmupFrameCount(60), _scale(1.0f),
+      _outputPath("stress.json"), _exitWhenDone(false), _vsync(true), _scenario(SCENARIO_COUNT), _frame(0), _frameStartTime(0.0)
+{
+}
+
+void StressSample::initialize()
+{
+    Properties* config = Game::getInstance()->getConfig()->getNamespace("stress", true);
+    if (config)
+    {
+        if (config->exists("frames"))
+            _frameCount = std::max(1, config->getInt("frames"));
+        if (config->exists("warmupFrames"))
+            _warmupFrameCount = std::max(0, config->getInt("warmupFrames"));
+        if (config->exists("scale"))
+            _scale = std::max(0.01f, config->getFloat("scale"));
+        _outputPath = config->getString("output", _outputPath.c_str());
+        _exitWhenDone = config->getBool("exit");
+    }
+
+    _font = Font::create("res/ui/arial.gpb");
+
+    // Measure the time the engine takes, not the refresh rate of the display.
+    _vsync = isVsync();
+    setVsync(false);
+
+    startScenario(CHARACTERS);
+}
+
+void StressSample::finalize()
+{
+    stopScenario();
+    setVsync(_vsync);
+    SAFE_RELEASE(_font);
+}
+
+void StressSample::update(float elapsedTime)
+{
+    if (_scenario >= SCENARIO_COUNT)
+        return;
+
+    // The first frames of a scenario include its creation and are not measured.
+    double time = Game::getAbsoluteTime();
+    if (_frame > _warmupFrameCount)
+    {
+        _results.back().frameTimes.push_back((float)(time - _frameStartTime));
+        recordFrame();
+    }
+    _frameStartTime = time;
+
+    if (_frame == _warmupFrameCount + _frameCount)
+    {
+        stopScenario();
+        if (_scenario + 1 < SCENARIO_COUNT)
+        {
+            startScenario((Scenario)(_scenario + 1));
+            return;
+        }
+
+        _scenario = SCENARIO_COUNT;
+        writeResults();
+        if (_exitWhenDone)
+        {
+            exit();
+        }
+        return;
+    }
+
+    GP_PROFILE_BEGIN("Stress Update");
+    updateScenario(elapsedTime);
+    GP_PROFILE_END();
+    ++_frame;
+}
+
+void StressSample::render(float elapsedTime)
+{
+    clear(CLEAR_COLOR_DEPTH, 0.1f, 0.1f, 0.15f, 1.0f, 1.0f, 0);
+
+    GP_PROFILE_BEGIN("Stress Render");
+    if (_scene)
+    {
+        _scene->visit(this, &StressSample::drawScene);
+    }
+    if (_form)
+    {
+        _form->draw();
+    }
+    GP_PROFILE_END();
+
+    char text[256];
+    if (_scenario < SCENARIO_COUNT)
+    {
+        sprintf(text, "%s x %u: frame %u of %u", __scenarioNames[_scenario], _results.back().count, _frame, _warmupFrameCount + _frameCount);
+    }
+    else
+    {
+        sprintf(text, "Results written to '%s'.", _outputPath.c_str());
+    }
+    _font->start();
+    _font->drawText(text, 5, getHeight() - _font->getSize() - 5, Vector4::one(), _font->getSize());
+    _font->finish();
+
+    drawFrameRate(_font, Vector4(0, 0.5f, 1, 1), 5, 1, getFrameRate());
+}
+
+void StressSample::startScenario(Scenario scenario)
+{
+    GP_ASSERT(scenario < SCENARIO_COUNT);
+
+    // Seed the generator so that every run builds the same scene.
+    srand(1);
+    _scenario = scenario;
+    _frame = 0;
+
+    _scene = Scene::create();
+    _scene->setAmbientColor(0.2f, 0.2f, 0.2f);
+
+    // The camera orbits around the origin with its pivot.
+    Camera* camera = Camera::createPerspective(45.0f, getAspectRatio(), 0.25f, 500.0f);
+    Node* cameraPivot = _scene->addNode("cameraPivot");
+    Node* cameraNode = Node::create("camera");
+    cameraPivot->addChild(cameraNode);
+    cameraNode->setCamera(camera);
+    _scene->setActiveCamera(camera);
+    SAFE_RELEASE(camera);
+
+    Light* light = Light::createDirectional(0.8f, 0.8f, 0.8f);
+    _lightNode = _scene->addNode("light");
+    _lightNode->setLight(light);
+    _lightNode->rotateX(MATH_DEG_TO_RAD(-60.0f));
+    _lightNode->rotateY(MATH_DEG_TO_RAD(30.0f));
+    SAFE_RELEASE(light);
+
+    Result result;
+    result.name = __scenarioNames[scenario];
+    result.phaseTotals.resize(__phaseCount, 0.0);
+    switch (scenario)
+    {
+    case CHARACTERS:
+        result.count = std::max(1u, (unsigned int)(STRESS_CHARACTER_COUNT * _scale));
+        createCharacters(result.count);
+        break;
+    case PARTICLES:
+        result.count = std::max(1u, (unsigned int)(STRESS_PARTICLE_COUNT * _scale));
+        createParticles(result.count);
+        break;
+    case CONTROLS:
+        result.count = std::max(1u, (unsigned int)(STRESS_CONTROL_COUNT * _scale));
+        createControls(result.count);
+        break;
+    case RIGID_BODIES:
+        result.count = std::max(1u, (unsigned int)(STRESS_RIGID_BODY_COUNT * _scale));
+        createRigidBodies(result.count);
+        break;
+    case LIGHTS:
+        result.count = std::max(1u, (unsigned int)(STRESS_LIGHT_COUNT * _scale));
+        createLights(result.count);
+        break;
+    default:
+        result.count = 0;
+        break;
+    }
+    result.frameTimes.reserve(_frameCount);
+    _results.push_back(result);
+
+    // Frame the objects laid out by the scenario.
+    float size = 0.0f;
+    for (Node* node = _scene->getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        size = std::max(size, std::max(fabsf(node->getTranslationX()), fabsf(node->getTranslationZ())));
+    }
+    cameraNode->setTranslation(0.0f, size * 0.8f + 5.0f, size * 1.5f + 10.0f);
+    cameraNode->rotateX(MATH_DEG_TO_RAD(-30.0f));
+    SAFE_RELEASE(cameraNode);
+}
+
+void StressSample::stopScenario()
+{
+    _lights.clear();
+    _lightNode = NULL;
+    SAFE_RELEASE(_form);
+    SAFE_RELEASE(_scene);
+}
+
+void StressSample::updateScenario(float elapsedTime)
+{
+    // Orbit the camera by a fixed angle each frame, so that every run renders the same views.
+    Node* cameraPivot = _scene->getActiveCamera()->getNode()->getParent();
+    cameraPivot->setRotation(Vector3::unitY(), MATH_DEG_TO_RAD(_frame * 0.2f));
+
+    switch (_scenario)
+    {
+    case PARTICLES:
+        for (Node* node = _scene->getFirstNode(); node != NULL; node = node->getNextSibling())
+        {
+            if (node->getParticleEmitter())
+                node->getParticleEmitter()->update(elapsedTime);
+        }
+        break;
+    case CONTROLS:
+        {
+            // Moving the sliders forces the form to lay out and redraw its controls.
+            const std::vector<Control*>& controls = _form->getControls();
+            for (size_t i = 0, count = controls.size(); i < count; ++i)
+            {
+                if (strcmp(controls[i]->getType(), "slider") == 0)
+                    static_cast<Slider*>(controls[i])->setValue((float)((_frame + i) % 100));
+            }
+        }
+        break;
+    case LIGHTS:
+        for (size_t i = 0, count = _lights.size(); i < count; ++i)
+        {
+            float angle = _frame * 0.05f + i;
+            _lights[i]->setTranslation(cosf(angle) * 1.5f, 1.5f, sinf(angle) * 1.5f);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void StressSample::createCharacters(unsigned int count)
+{
+    Node* prototype = loadPrototype("res/common/duck.gpb", "duck", "res/common/duck.material");
+    if (prototype == NULL)
+        return;
+
+    // Each character plays its own looping walk cycle, turning and bobbing in place.
+    unsigned int keyTimes[4] = { 0, 500, 1000, 1500 };
+    float keyValues[4 * 7];
+    unsigned int columns = (unsigned int)ceilf(sqrtf((float)count));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float x = ((i % columns) - columns * 0.5f) * STRESS_GRID_SPACING;
+        float z = ((i / columns) - columns * 0.5f) * STRESS_GRID_SPACING;
+        float heading = MATH_RANDOM_0_1() * MATH_PIX2;
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            Quaternion rotation;
+            Quaternion::createFromAxisAngle(Vector3::unitY(), heading + MATH_PIOVER2 * j, &rotation);
+            float* value = &keyValues[j * 7];
+            value[0] = rotation.x;
+            value[1] = rotation.y;
+            value[2] = rotation.z;
+            value[3] = rotation.w;
+            value[4] = x;
+            value[5] = (j & 1) ? 0.5f : 0.0f;
+            value[6] = z;
+        }
+
+        Node* node = prototype->instantiate();
+        _scene->addNode(node);
+        Animation* animation = node->createAnimation("stress", Transform::ANIMATE_ROTATE_TRANSLATE, 4, keyTimes, keyValues, Curve::LINEAR);
+        animation->getClip()->setRepeatCount(AnimationClip::REPEAT_INDEFINITE);
+        animation->getClip()->setSpeed(0.5f + MATH_RANDOM_0_1());
+        animation->play();
+        SAFE_RELEASE(node);
+    }
+    SAFE_RELEASE(prototype);
+}
+
+void StressSample::createParticles(unsigned int count)
+{
+    unsigned int emitterCount = (count + STRESS_PARTICLES_PER_EMITTER - 1) / STRESS_PARTICLES_PER_EMITTER;
+    unsigned int columns = (unsigned int)ceilf(sqrtf((float)emitterCount));
+    for (unsigned int i = 0; i < emitterCount; ++i)
+    {
+        // Emit for as long as the particles live, so that every emitter stays full.
+        unsigned int particleCount = std::min(count - i * STRESS_PARTICLES_PER_EMITTER, (unsigned int)STRESS_PARTICLES_PER_EMITTER);
+        ParticleEmitter* emitter = ParticleEmitter::create("res/png/light-point.png", ParticleEmitter::BLEND_ADDITIVE, particleCount);
+        emitter->setEmissionRate(particleCount);
+        emitter->setEnergy(1000, 1000);
+        emitter->setSize(0.3f, 0.4f, 0.05f, 0.1f);
+        emitter->setVelocity(Vector3(0.0f, 3.0f, 0.0f), Vector3(2.0f, 1.0f, 2.0f));
+        emitter->setColor(Vector4(MATH_RANDOM_0_1(), MATH_RANDOM_0_1(), 1.0f, 1.0f), Vector4::zero(), Vector4(1.0f, 0.5f, 0.0f, 0.0f), Vector4::zero());
+        emitter->start();
+
+        Node* node = Node::create("emitter");
+        node->setParticleEmitter(emitter);
+        node->setTranslation(((i % columns) - columns * 0.5f) * STRESS_GRID_SPACING * 2.0f, 0.0f, ((i / columns) - columns * 0.5f) * STRESS_GRID_SPACING * 2.0f);
+        _scene->addNode(node);
+        SAFE_RELEASE(emitter);
+        SAFE_RELEASE(node);
+    }
+}
+
+void StressSample::createControls(unsigned int count)
+{
+    _form = Form::create("stress", NULL, Layout::LAYOUT_FLOW);
+    _form->setSize(getWidth(), getHeight());
+    _form->setScroll(Container::SCROLL_VERTICAL);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Control* control;
+        switch (i % 3)
+        {
+        case 0:
+            {
+                Button* button = Button::create("button");
+                button->setText("Button");
+                button->setSize(120, 40);
+                control = button;
+            }
+            break;
+        case 1:
+            {
+                Slider* slider = Slider::create("slider");
+                slider->setMin(0.0f);
+                slider->setMax(100.0f);
+                slider->setValueTextVisible(true);
+                slider->setSize(200, 50);
+                control = slider;
+            }
+            break;
+        default:
+            {
+                CheckBox* checkBox = CheckBox::create("checkBox");
+                checkBox->setText("Check");
+                checkBox->setChecked(MATH_RANDOM_0_1() > 0.5f);
+                checkBox->setSize(120, 40);
+                control = checkBox;
+            }
+            break;
+        }
+        _form->addControl(control);
+        control->release();
+    }
+}
+
+void StressSample::createRigidBodies(unsigned int count)
+{
+    Node* prototype = loadPrototype("res/common/box.gpb", "box", "res/common/box.material#lambert1");
+    if (prototype == NULL)
+        return;
+
+    Node* ground = _scene->addNode("ground");
+    ground->setTranslation(0.0f, -1.0f, 0.0f);
+    PhysicsRigidBody::Parameters groundParameters(0.0f);
+    ground->setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::box(Vector3(200.0f, 2.0f, 200.0f)), &groundParameters);
+
+    // Drop the boxes in columns, so that they pile up on each other.
+    PhysicsRigidBody::Parameters parameters(1.0f);
+    unsigned int columns = (unsigned int)ceilf(sqrtf(count / 4.0f));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int column = i % (columns * columns);
+        Node* node = prototype->instantiate();
+        node->setTranslation((column % columns - columns * 0.5f) * STRESS_GRID_SPACING + MATH_RANDOM_MINUS1_1() * 0.2f,
+            2.0f + (i / (columns * columns)) * 2.5f,
+            (column / columns - columns * 0.5f) * STRESS_GRID_SPACING + MATH_RANDOM_MINUS1_1() * 0.2f);
+        node->rotateY(MATH_RANDOM_0_1() * MATH_PIX2);
+        _scene->addNode(node);
+        node->setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::box(), &parameters);
+        SAFE_RELEASE(node);
+    }
+    SAFE_RELEASE(prototype);
+}
+
+void StressSample::createLights(unsigned int count)
+{
+    // Each box is lit by its own point light circling around it.
+    Bundle* bundle = Bundle::create("res/common/box.gpb");
+    if (bundle == NULL)
+        return;
+
+    unsigned int columns = (unsigned int)ceilf(sqrtf((float)count));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Node* boxNode = bundle->loadNode("box");
+        if (boxNode == NULL || boxNode->getModel() == NULL)
+        {
+            SAFE_RELEASE(boxNode);
+            break;
+        }
+        boxNode->setTranslation(((i % columns) - columns * 0.5f) * STRESS_GRID_SPACING * 2.0f, 0.0f, ((i / columns) - columns * 0.5f) * STRESS_GRID_SPACING * 2.0f);
+        _scene->addNode(boxNode);
+
+        Light* light = Light::createPoint(MATH_RANDOM_0_1(), MATH_RANDOM_0_1(), 1.0f, 6.0f);
+        Node* lightNode = Node::create("pointLight");
+        lightNode->setLight(light);
+        boxNode->addChild(lightNode);
+        _lights.push_back(lightNode);
+
+        Material* material = boxNode->getModel()->setMaterial("res/common/light.material");
+        material->setTechnique("point");
+        Technique* technique = material->getTechnique();
+        technique->getParameter("u_ambientColor")->setValue(Vector3(0.1f, 0.1f, 0.1f));
+        technique->getParameter("u_pointLightColor[0]")->setValue(light->getColor());
+        technique->getParameter("u_pointLightPosition[0]")->bindValue(lightNode, &Node::getTranslationView);
+        technique->getParameter("u_pointLightRangeInverse[0]")->setValue(light->getRangeInverse());
+
+        SAFE_RELEASE(light);
+        SAFE_RELEASE(lightNode);
+        SAFE_RELEASE(boxNode);
+    }
+    SAFE_RELEASE(bundle);
+}
+
+Node* StressSample::loadPrototype(const char* path, const char* id, const char* material)
+{
+    Bundle* bundle = Bundle::create(path);
+    Node* node = bundle ? bundle->loadNode(id) : NULL;
+    SAFE_RELEASE(bundle);
+    if (node == NULL || node->getModel() == NULL)
+    {
+        GP_WARN("Failed to load node '%s' from '%s'.", id, path);
+        SAFE_RELEASE(node);
+        return NULL;
+    }
+
+    // The instances share the material of the prototype, so the light only needs to be bound once.
+    Material* prototypeMaterial = node->getModel()->setMaterial(material);
+    prototypeMaterial->getParameter("u_directionalLightColor[0]")->setValue(_lightNode->getLight()->getColor());
+    prototypeMaterial->getParameter("u_directionalLightDirection[0]")->bindValue(_lightNode, &Node::getForwardVectorView);
+    return node;
+}
+
+void StressSample::recordFrame()
+{
+    // The game has closed the previous frame, so its timings are available.
+    Result& result = _results.back();
+    for (unsigned int i = 0; i < __phaseCount; ++i)
+    {
+        result.phaseTotals[i] += Profiler::getFrameTime(__phaseNames[i]);
+    }
+}
+
+void StressSample::writeResults()
+{
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"frames\": " << _frameCount << ",\n";
+    json << "  \"warmupFrames\": " << _warmupFrameCount << ",\n";
+    json << "  \"scale\": " << _scale << ",\n";
+    json << "  \"scenarios\": [\n";
+    for (size_t i = 0, count = _results.size(); i < count; ++i)
+    {
+        Result& result = _results[i];
+        std::vector<float> sorted(result.frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (size_t j = 0, frameCount = sorted.size(); j < frameCount; ++j)
+        {
+            total += sorted[j];
+        }
+        float frameCount = (float)std::max((size_t)1, sorted.size());
+
+        json << "    {\n";
+        json << "      \"name\": \"" << result.name << "\",\n";
+        json << "      \"count\": " << result.count << ",\n";
+        json << "      \"frameTime\": { \"mean\": " << total / frameCount
+             << ", \"p50\": " << percentile(sorted, 0.5f)
+             << ", \"p90\": " << percentile(sorted, 0.9f)
+             << ", \"p95\": " << percentile(sorted, 0.95f)
+             << ", \"p99\": " << percentile(sorted, 0.99f)
+             << ", \"max\": " << (sorted.empty() ? 0.0f : sorted.back()) << " },\n";
+
+        // Average time per frame of the phases that were timed.
+        json << "      \"phases\": {";
+        bool first = true;
+        for (unsigned int j = 0; j < __phaseCount; ++j)
+        {
+            if (result.phaseTotals[j] > 0.0)
+            {
+                json << (first ? " " : ", ") << "\"" << __phaseNames[j] << "\": " << result.phaseTotals[j] / frameCount;
+                first = false;
+            }
+        }
+        json << " }\n";
+        json << "    }" << (i + 1 < count ? "," : "") << "\n";
+
+        print("[stress] %-12s %6u  mean %7.2f ms  p50 %7.2f  p95 %7.2f  p99 %7.2f  max %7.2f\n", result.name, result.count,
+            total / frameCount, percentile(sorted, 0.5f), percentile(sorted, 0.95f), percentile(sorted, 0.99f), sorted.empty() ? 0.0f : sorted.back());
+    }
+    json << "  ]\n";
+    json << "}\n";
+
+    Stream* stream = FileSystem::open(_outputPath.c_str(), FileSystem::WRITE);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to write the stress results to '%s'.", _outputPath.c_str());
+        return;
+    }
+    std::string text = json.str();
+    stream->write(text.c_str(), 1, text.size());
+    stream->close();
+    SAFE_DELETE(stream);
+    print("[stress] Results written to '%s'.\n", _outputPath.c_str());
+}
+
+bool StressSample::drawScene(Node* node)
+{
+    Model* model = node->getModel();
+    if (model)
+        model->draw();
+    ParticleEmitter* emitter = node->getParticleEmitter();
+    if (emitter)
+        emitter->draw();
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef STRESSSAMPLE_H_
+#define STRESSSAMPLE_H_
+
+#include "gameplay.h"
+#include "Sample.h"
+
+using namespace gameplay;
+
+/**
+ * Runs scene-scale stress scenarios and reports their frame times.
+ *
+ * The scenarios (animated characters, particles, UI controls, rigid bodies and point lights)
+ * are run one after the other, each for a number of warm-up frames and then a fixed number
+ * of measured frames. The scenes are built from a seeded random generator and the camera
+ * follows a path driven by the frame index, so that every run renders the same frames.
+ *
+ * The percentiles of the frame times and the average time of each engine phase are written
+ * as JSON once all the scenarios ran. The phases, including the update and render of the
+ * sample itself, are only timed when the profiler is compiled in (see Profiler.h).
+ *
+ * The number of frames, the number of warm-up frames, a scale applied to the size of every
+ * scenario, the file to write the results to and whether to exit the game once done are
+ * read from the "stress" section of game.config.
+ */
+class StressSample : public Sample
+{
+public:
+
+    StressSample();
+
+protected:
+
+    void initialize();
+
+    void finalize();
+
+    void update(float elapsedTime);
+
+    void render(float elapsedTime);
+
+private:
+
+    enum Scenario
+    {
+        CHARACTERS,
+        PARTICLES,
+        CONTROLS,
+        RIGID_BODIES,
+        LIGHTS,
+        SCENARIO_COUNT
+    };
+
+    /**
+     * The timings of a scenario.
+     */
+    struct Result
+    {
+        const char* name;
+        unsigned int count;
+        std::vector<float> frameTimes;
+        std::vector<double> phaseTotals;
+    };
+
+    void startScenario(Scenario scenario);
+
+    void stopScenario();
+
+    void updateScenario(float elapsedTime);
+
+    void createCharacters(unsigned int count);
+
+    void createParticles(unsigned int count);
+
+    void createControls(unsigned int count);
+
+    void createRigidBodies(unsigned int count);
+
+    void createLights(unsigned int count);
+
+    Node* loadPrototype(const char* path, const char* id, const char* material);
+
+    void recordFrame();
+
+    void writeResults();
+
+    bool drawScene(Node* node);
+
+    Font* _font;
+    Scene* _scene;
+    Node* _lightNode;
+    Form* _form;
+    std::vector<Node*> _lights;
+    unsigned int _frameCount;
+    unsigned int _warmupFrameCount;
+    float _scale;
+    std::string _outputPath;
+    bool _exitWhenDone;
+    bool _vsync;
+    int _scenario;
+    unsigned int _frame;
+    double _frameStartTime;
+    std::vector<Result> _results;
+};
+
+#endif
@@ -1,10 +1,63 @@
 #include "Base.h"
 #include "AnimationChannel.h"
 #include "Transform.h"
+#include "EncoderArguments.h"
+
+// Animation channel formats
+#define ANIMATION_FORMAT_FLOAT          0
+#define ANIMATION_FORMAT_QUANTIZED      1
+
+// Quaternion offset of quantized channels without a rotation
+#define ANIMATION_NO_QUATERNION         0xFFFFFFFF
+
+// The largest number of components of a quantized channel.
+#define ANIMATION_QUANTIZED_MAX_COMPONENTS 16
+
+// The largest value of the three smallest components of a unit quaternion (1 / sqrt(2)).
+#define QUANTIZED_QUATERNION_RANGE 0.707106781186547524401f
 
 namespace gameplay
 {
 
+/**
+ * Quantizes a quaternion to its three smallest components, in 15 bits each, with the
+ * index of the largest component in the high bits of the first two values.
+ */
+static void quantizeQuaternion(const float* q, std::vector<unsigned short>* values)
+{
+    float n[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float length = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (length > 0.0f)
+    {
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            n[i] = q[i] / length;
+        }
+    }
+
+    unsigned int largest = 0;
+    for (unsigned int i = 1; i < 4; ++i)
+    {
+        if (fabs(n[i]) > fabs(n[largest]))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so make the largest component positive to be able to rebuild it.
+    float sign = n[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned short packed[3];
+    for (unsigned int i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = sign * n[i] / QUANTIZED_QUATERNION_RANGE;
+        value = std::max(-1.0f, std::min(1.0f, value));
+        packed[j++] = (unsigned short)((value * 0.5f + 0.5f) * 32767.0f + 0.5f);
+    }
+    packed[0] |= (unsigned short)((largest & 1) << 15);
+    packed[1] |= (unsigned short)((largest >> 1) << 15);
+    values->insert(values->end(), packed, packed + 3);
+}
+
 AnimationChannel::AnimationChannel(void) :
     _targetAttrib(0)
 {
@@ -28,6 +81,13 @@ void AnimationChannel::writeBinary(FILE* file)
     Object::writeBinary(file);
     write(_targetId, file);
     write(_targetAttrib, file);
+    if (EncoderArguments::getInstance()->compressAnimationsEnabled() && canQuantize())
+    {
+        write((unsigned int)ANIMATION_FORMAT_QUANTIZED, file);
+        writeQuantized(file);
+        return;
+    }
+    write((unsigned int)ANIMATION_FORMAT_FLOAT, file);
     write((unsigned int)_keytimes.size(), file);
     for (std::vector<float>::const_iterator i = _keytimes.begin(); i != _keytimes.end(); ++i)
     {
@@ -175,6 +235,91 @@ void AnimationChannel::removeDuplicates()
     LOG(3, "      Removed %d duplicate keyframes from channel.\n", startCount- _keytimes.size());
 }
 
+bool AnimationChannel::canQuantize() const
+{
+    // The runtime only loads linear channels and ignores tangents, so only the key values need to be kept.
+    size_t propSize = Transform::getPropertySize(_targetAttrib);
+    return propSize > 0 && propSize <= ANIMATION_QUANTIZED_MAX_COMPONENTS && !_keytimes.empty() &&
+        _keyValues.size() == _keytimes.size() * propSize;
+}
+
+int AnimationChannel::getQuaternionOffset() const
+{
+    // Matches the properties that the runtime interpolates with a quaternion (see Animation::setTransformRotationOffset).
+    switch (_targetAttrib)
+    {
+    case Transform::ANIMATE_ROTATE:
+    case Transform::ANIMATE_ROTATE_TRANSLATE:
+        return 0;
+    case Transform::ANIMATE_SCALE_ROTATE_TRANSLATE:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+void AnimationChannel::writeQuantized(FILE* file)
+{
+    size_t propSize = Transform::getPropertySize(_targetAttrib);
+    size_t keyCount = _keytimes.size();
+    int quaternionOffset = getQuaternionOffset();
+
+    // Find the range of each component that is not part of the quaternion.
+    std::vector<float> ranges;
+    for (size_t i = 0; i < propSize; ++i)
+    {
+        if (quaternionOffset >= 0 && i >= (size_t)quaternionOffset && i < (size_t)quaternionOffset + 4)
+            continue;
+        float minValue = _keyValues[i];
+        float maxValue = _keyValues[i];
+        for (size_t k = 1; k < keyCount; ++k)
+        {
+            float value = _keyValues[k * propSize + i];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+        ranges.push_back(minValue);
+        ranges.push_back(maxValue - minValue);
+    }
+
+    // Quantize the key values.
+    std::vector<unsigned short> values;
+    values.reserve(keyCount * (quaternionOffset >= 0 ? propSize - 1 : propSize));
+    for (size_t k = 0; k < keyCount; ++k)
+    {
+        const float* key = &_keyValues[k * propSize];
+        const float* range = ranges.empty() ? NULL : &ranges[0];
+        for (size_t i = 0; i < propSize;)
+        {
+            if (quaternionOffset >= 0 && i == (size_t)quaternionOffset)
+            {
+                quantizeQuaternion(key + i, &values);
+                i += 4;
+            }
+            else
+            {
+                float fraction = range[1] > 0.0f ? (key[i] - range[0]) / range[1] : 0.0f;
+                fraction = std::max(0.0f, std::min(1.0f, fraction));
+                values.push_back((unsigned short)(fraction * 65535.0f + 0.5f));
+                range += 2;
+                ++i;
+            }
+        }
+    }
+
+    LOG(3, "      Quantized %u keyframes of channel with target attribute: %u.\n", (unsigned int)keyCount, _targetAttrib);
+
+    write((unsigned int)keyCount, file);
+    for (std::vector<float>::const_iterator i = _keytimes.begin(); i != _keytimes.end(); ++i)
+    {
+        write((unsigned int)*i, file);
+    }
+    write((unsigned int)propSize, file);
+    write(quaternionOffset >= 0 ? (unsigned int)quaternionOffset : (unsigned int)ANIMATION_NO_QUATERNION, file);
+    write(ranges, file);
+    write(values, file);
+}
+
 unsigned int AnimationChannel::getInterpolationType(const char* str)
 {
     unsigned int value = 0;
@@ -86,6 +86,24 @@ private:
      */
     void deleteRange(size_t begin, size_t end, size_t propSize);
 
+    /**
+     * Determines whether the key values of this channel can be quantized.
+     */
+    bool canQuantize() const;
+
+    /**
+     * Returns the offset of the rotation quaternion within the key values of this channel,
+     * or -1 if the runtime does not interpolate part of them as a quaternion.
+     */
+    int getQuaternionOffset() const;
+
+    /**
+     * Writes the key times and quantized key values of this channel.
+     * 
+     * @param file The binary file stream.
+     */
+    void writeQuantized(FILE* file);
+
 private:
 
     std::string _targetId;
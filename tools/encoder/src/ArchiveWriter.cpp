@@ -0,0 +1,331 @@
+#include "Base.h"
+#include "ArchiveWriter.h"
+#include "StringUtil.h"
+#include "FileIO.h"
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <dirent.h>
+#endif
+
+// The version of the archive format.
+#define ARCHIVE_VERSION 1
+
+// The flag of the archive entries that are compressed with LZ4.
+#define ARCHIVE_ENTRY_LZ4 1
+
+// The alignment of the names and contents of the entries in the archive.
+#define ARCHIVE_ALIGNMENT 16
+
+namespace gameplay
+{
+
+struct ArchiveEntry
+{
+    unsigned int hash;
+    unsigned int nameOffset;
+    unsigned int nameLength;
+    unsigned int flags;
+    unsigned int offset;
+    unsigned int size;
+    unsigned int originalSize;
+    std::vector<unsigned char> data;
+
+    bool operator<(const ArchiveEntry& entry) const
+    {
+        return hash < entry.hash;
+    }
+};
+
+static unsigned int hashPath(const std::string& path)
+{
+    // FNV-1a, as hashed by the runtime.
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int readUint(const unsigned char* data)
+{
+    unsigned int value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static void writeLength(size_t length, std::vector<unsigned char>& out)
+{
+    // Lengths of 15 or more continue in bytes of 255 up to a last smaller byte.
+    for (length -= 15; length >= 255; length -= 255)
+    {
+        out.push_back(255);
+    }
+    out.push_back((unsigned char)length);
+}
+
+static void writeSequence(const unsigned char* literals, size_t literalLength, size_t offset, size_t matchLength, std::vector<unsigned char>& out)
+{
+    unsigned char token = (unsigned char)(std::min(literalLength, (size_t)15) << 4);
+    if (matchLength > 0)
+    {
+        token |= (unsigned char)std::min(matchLength - 4, (size_t)15);
+    }
+    out.push_back(token);
+    if (literalLength >= 15)
+    {
+        writeLength(literalLength, out);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength > 0)
+    {
+        out.push_back((unsigned char)(offset & 0xFF));
+        out.push_back((unsigned char)(offset >> 8));
+        if (matchLength - 4 >= 15)
+        {
+            writeLength(matchLength - 4, out);
+        }
+    }
+}
+
+/**
+ * Compresses data in the LZ4 block format with a greedy search of 4-byte matches.
+ */
+static void compressLZ4(const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    // The format ends with at least 5 literals, and the last match starts at least 12 bytes before the end.
+    const size_t lastLiterals = 5;
+    const size_t matchLimit = 12;
+    std::vector<int> table(1 << 16, -1);
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + matchLimit < size)
+    {
+        unsigned int sequence = readUint(data + i);
+        unsigned int hash = (sequence * 2654435761u) >> 16;
+        int candidate = table[hash];
+        table[hash] = (int)i;
+        if (candidate >= 0 && i - candidate <= 65535 && readUint(data + candidate) == sequence)
+        {
+            size_t matchLength = 4;
+            size_t maxLength = size - lastLiterals - i;
+            while (matchLength < maxLength && data[candidate + matchLength] == data[i + matchLength])
+            {
+                ++matchLength;
+            }
+            writeSequence(data + anchor, i - anchor, i - candidate, matchLength, out);
+            i += matchLength;
+            anchor = i;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    writeSequence(data + anchor, size - anchor, 0, 0, out);
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    bool result = size >= 0 && (size == 0 || fread(&data[0], 1, data.size(), file) == data.size());
+    fclose(file);
+    return result;
+}
+
+static void writePadding(unsigned int position, FILE* file)
+{
+    while (position % ARCHIVE_ALIGNMENT != 0)
+    {
+        fputc(0, file);
+        ++position;
+    }
+}
+
+static unsigned int align(unsigned int position)
+{
+    return (position + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+}
+
+ArchiveWriter::ArchiveWriter(const char* directory, const char* outputFile, bool compress)
+    : _directory(directory), _outputFile(outputFile), _compress(compress)
+{
+    while (_directory.size() > 1 && _directory[_directory.size() - 1] == '/')
+    {
+        _directory.erase(_directory.size() - 1);
+    }
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+}
+
+void ArchiveWriter::listFiles(const std::string& path, const std::string& name)
+{
+#ifdef WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        std::string filename(data.cFileName);
+        if (filename == "." || filename == "..")
+            continue;
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+        {
+            listFiles(path + "/" + filename, name + "/" + filename);
+        }
+        else
+        {
+            _paths.push_back(path + "/" + filename);
+            _names.push_back(name + "/" + filename);
+        }
+    } while (FindNextFileA(find, &data) != 0);
+    FindClose(find);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL)
+        return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        std::string filename(entry->d_name);
+        if (filename == "." || filename == "..")
+            continue;
+        struct stat buf;
+        std::string filePath = path + "/" + filename;
+        if (stat(filePath.c_str(), &buf) != 0)
+            continue;
+        if (S_ISDIR(buf.st_mode))
+        {
+            listFiles(filePath, name + "/" + filename);
+        }
+        else
+        {
+            _paths.push_back(filePath);
+            _names.push_back(name + "/" + filename);
+        }
+    }
+    closedir(dir);
+#endif
+}
+
+bool ArchiveWriter::write()
+{
+    _paths.clear();
+    _names.clear();
+    listFiles(_directory, getFilenameFromFilePath(_directory));
+
+    // Read the files, compressing the ones that shrink.
+    std::vector<ArchiveEntry> entries;
+    size_t originalTotal = 0;
+    size_t storedTotal = 0;
+    for (size_t i = 0; i < _paths.size(); ++i)
+    {
+        if (_paths[i] == _outputFile)
+            continue;
+
+        entries.push_back(ArchiveEntry());
+        ArchiveEntry& entry = entries.back();
+        if (!readFile(_paths[i], entry.data))
+        {
+            LOG(1, "Error: Failed to read file: %s\n", _paths[i].c_str());
+            return false;
+        }
+        entry.hash = hashPath(_names[i]);
+        entry.nameLength = (unsigned int)_names[i].size();
+        entry.flags = 0;
+        entry.originalSize = (unsigned int)entry.data.size();
+        if (_compress && !entry.data.empty())
+        {
+            std::vector<unsigned char> compressed;
+            compressLZ4(&entry.data[0], entry.data.size(), compressed);
+            if (compressed.size() < entry.data.size())
+            {
+                entry.data.swap(compressed);
+                entry.flags |= ARCHIVE_ENTRY_LZ4;
+            }
+        }
+        entry.size = (unsigned int)entry.data.size();
+        originalTotal += entry.originalSize;
+        storedTotal += entry.size;
+
+        // Keep the name with the entry through the sort below.
+        entry.nameOffset = (unsigned int)i;
+    }
+    std::stable_sort(entries.begin(), entries.end());
+
+    // Lay out the names after the index, then the contents.
+    unsigned int position = 4 + 3 * sizeof(unsigned int) + (unsigned int)(entries.size() * 7 * sizeof(unsigned int));
+    unsigned int namesSize = 0;
+    std::vector<unsigned int> nameIndices(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        nameIndices[i] = entries[i].nameOffset;
+        entries[i].nameOffset = position + namesSize;
+        namesSize += entries[i].nameLength;
+    }
+    position = align(position + namesSize);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i].offset = position;
+        position = align(position + entries[i].size);
+    }
+
+    FILE* file = fopen(_outputFile.c_str(), "wb");
+    if (file == NULL)
+    {
+        LOG(1, "Error: Failed to open file: %s\n", _outputFile.c_str());
+        return false;
+    }
+    fwrite("GPAK", 1, 4, file);
+    gameplay::write((unsigned int)ARCHIVE_VERSION, file);
+    gameplay::write((unsigned int)entries.size(), file);
+    gameplay::write(namesSize, file);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const ArchiveEntry& entry = entries[i];
+        gameplay::write(entry.hash, file);
+        gameplay::write(entry.nameOffset, file);
+        gameplay::write(entry.nameLength, file);
+        gameplay::write(entry.flags, file);
+        gameplay::write(entry.offset, file);
+        gameplay::write(entry.size, file);
+        gameplay::write(entry.originalSize, file);
+    }
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const std::string& name = _names[nameIndices[i]];
+        fwrite(name.c_str(), 1, name.size(), file);
+    }
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        writePadding((unsigned int)ftell(file), file);
+        if (!entries[i].data.empty())
+        {
+            fwrite(&entries[i].data[0], 1, entries[i].data.size(), file);
+        }
+    }
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        LOG(1, "Error: Failed to write file: %s\n", _outputFile.c_str());
+        return false;
+    }
+
+    LOG(1, "Packed %u files (%u bytes stored of %u) into: %s\n", (unsigned int)entries.size(), (unsigned int)storedTotal, (unsigned int)originalTotal, _outputFile.c_str());
+    return true;
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef ARCHIVEWRITER_H_
+#define ARCHIVEWRITER_H_
+
+namespace gameplay
+{
+
+/**
+ * Packs a directory of resources into a single archive file, to be mounted at runtime
+ * with FileSystem::mountArchive().
+ *
+ * An archive starts with the identifier "GPAK", the version, the number of entries and
+ * the size of the names. The index follows, sorted by the FNV-1a hash of the names of the
+ * entries, then the names and the contents of the entries, each aligned to 16 bytes.
+ * Every value is a little-endian 32-bit unsigned integer. Each entry of the index is made
+ * of the hash, offset and length of its name, its flags (1 if compressed with LZ4), and the
+ * offset, stored size and original size of its contents. Offsets are from the start of the file.
+ */
+class ArchiveWriter
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param directory The directory to pack. The names of the entries start with its name.
+     * @param outputFile The archive file to write.
+     * @param compress true to compress the entries with LZ4 when it makes them smaller.
+     */
+    ArchiveWriter(const char* directory, const char* outputFile, bool compress);
+    ~ArchiveWriter();
+
+    /**
+     * Writes the archive.
+     *
+     * @return true if successful.
+     */
+    bool write();
+
+private:
+
+    // Hidden copy/assignment
+    ArchiveWriter(const ArchiveWriter&);
+    ArchiveWriter& operator=(const ArchiveWriter&);
+
+    /**
+     * Adds the files in a directory, and in its subdirectories, to the list of files to pack.
+     */
+    void listFiles(const std::string& path, const std::string& name);
+
+    std::string _directory;
+    std::string _outputFile;
+    bool _compress;
+    std::vector<std::string> _paths;
+    std::vector<std::string> _names;
+};
+
+}
+
+#endif
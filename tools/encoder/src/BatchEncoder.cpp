@@ -0,0 +1,177 @@
+#include "Base.h"
+#include "BatchEncoder.h"
+#include "Thread.h"
+
+#ifdef WIN32
+    #define popen _popen
+    #define pclose _pclose
+    #define BATCH_NULL_INPUT "NUL"
+#else
+    #include <sys/wait.h>
+    #define BATCH_NULL_INPUT "/dev/null"
+#endif
+
+namespace gameplay
+{
+
+static MUTEX_HANDLE __mutex;
+
+BatchEncoder::BatchEncoder(const char* executable, const char* manifest, unsigned int jobCount, const std::string& options) :
+    _executable(executable), _manifest(manifest), _options(options), _jobCount(jobCount), _nextJob(0), _finishedJobs(0)
+{
+    if (_jobCount == 0)
+        _jobCount = getProcessorCount();
+}
+
+BatchEncoder::~BatchEncoder()
+{
+}
+
+bool BatchEncoder::run()
+{
+    if (!readManifest())
+        return false;
+
+    if (_jobs.empty())
+    {
+        LOG(1, "Warning: No inputs listed in manifest: %s\n", _manifest.c_str());
+        return true;
+    }
+
+    unsigned int threadCount = std::min(_jobCount, (unsigned int)_jobs.size());
+    LOG(1, "Encoding %u inputs with %u workers.\n", (unsigned int)_jobs.size(), threadCount);
+
+    createMutex(&__mutex);
+    std::vector<THREAD_HANDLE> threads(threadCount);
+    unsigned int started = 0;
+    for (; started < threadCount; ++started)
+    {
+        if (!createThread(&threads[started], &workerThread, this))
+            break;
+    }
+    if (started == 0)
+    {
+        // Encode on this thread when no worker could be started.
+        LOG(1, "Warning: Failed to start worker threads, encoding one input at a time.\n");
+        workerThread(this);
+    }
+    else
+    {
+        waitForThreads(started, &threads[0]);
+        for (unsigned int i = 0; i < started; ++i)
+        {
+            closeThread(threads[i]);
+        }
+    }
+    destroyMutex(&__mutex);
+
+    unsigned int failed = 0;
+    for (size_t i = 0, count = _jobs.size(); i < count; ++i)
+    {
+        if (_jobs[i].result != 0)
+        {
+            if (failed++ == 0)
+                LOG(1, "\nFailed inputs:\n");
+            LOG(1, "  %s:%u: %s\n", _manifest.c_str(), _jobs[i].line, _jobs[i].arguments.c_str());
+        }
+    }
+    LOG(1, "\n%u of %u inputs encoded successfully.\n", (unsigned int)_jobs.size() - failed, (unsigned int)_jobs.size());
+
+    return failed == 0;
+}
+
+bool BatchEncoder::readManifest()
+{
+    std::ifstream stream(_manifest.c_str());
+    if (!stream)
+    {
+        LOG(1, "Error: Failed to open manifest: %s\n", _manifest.c_str());
+        return false;
+    }
+
+    std::string text;
+    unsigned int line = 0;
+    while (std::getline(stream, text))
+    {
+        ++line;
+
+        // Trim the line, including the carriage return of manifests written on Windows.
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string::npos || text[start] == '#')
+            continue;
+        size_t end = text.find_last_not_of(" \t\r");
+
+        Job job;
+        job.arguments = text.substr(start, end - start + 1);
+        job.line = line;
+        job.result = 0;
+        _jobs.push_back(job);
+    }
+    return true;
+}
+
+int BatchEncoder::workerThread(void* data)
+{
+    BatchEncoder* encoder = static_cast<BatchEncoder*>(data);
+    std::string output;
+    while (true)
+    {
+        lockMutex(&__mutex);
+        size_t index = encoder->_nextJob++;
+        unlockMutex(&__mutex);
+        if (index >= encoder->_jobs.size())
+            break;
+
+        Job& job = encoder->_jobs[index];
+        output.clear();
+        job.result = encoder->encode(job, &output);
+
+        // Print the whole output of the input at once, so that the outputs of the workers don't interleave.
+        lockMutex(&__mutex);
+        size_t finished = ++encoder->_finishedJobs;
+        LOG(1, "[%u/%u] %s: %s\n", (unsigned int)finished, (unsigned int)encoder->_jobs.size(), job.result == 0 ? "OK" : "FAILED", job.arguments.c_str());
+        if (job.result != 0 || __logVerbosity > 1)
+        {
+            LOG(1, "%s", output.c_str());
+        }
+        unlockMutex(&__mutex);
+    }
+    return 0;
+}
+
+int BatchEncoder::encode(const Job& job, std::string* output) const
+{
+    // Prompts for missing options read end-of-file instead of blocking the batch.
+    std::string command = "\"" + _executable + "\" " + _options + job.arguments + " < " BATCH_NULL_INPUT " 2>&1";
+#ifdef WIN32
+    // cmd.exe strips the outer quotes of the command line.
+    command = "\"" + command + "\"";
+#endif
+
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == NULL)
+    {
+        *output = "Error: Failed to start the encoder.\n";
+        return -1;
+    }
+
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+    {
+        output->append(buffer, read);
+    }
+
+    int status = pclose(pipe);
+#ifndef WIN32
+    status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+
+    // Not every failure of the encoder sets its exit code, but every one of them logs an error.
+    if (status == 0 && (output->compare(0, 6, "Error:") == 0 || output->find("\nError:") != std::string::npos))
+        status = -1;
+
+    return status;
+}
+
+}
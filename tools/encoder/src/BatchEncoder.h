@@ -0,0 +1,83 @@
+#ifndef BATCHENCODER_H_
+#define BATCHENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Encodes the inputs listed in a manifest file in parallel.
+ *
+ * Each line of the manifest holds the arguments of one invocation of the encoder, exactly as
+ * they would be given on the command line (options, input file and optional output file).
+ * Blank lines and lines starting with '#' are skipped.
+ *
+ * Each line is encoded by a separate encoder process, so that an input that crashes the
+ * encoder or its libraries only fails its own line, and the processes are run by a pool of
+ * worker threads. The output of each process is printed in one piece once it has finished,
+ * along with whether it succeeded. A summary of the failed lines is printed at the end.
+ */
+class BatchEncoder
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param executable The path of the encoder executable (argv[0]).
+     * @param manifest The path of the manifest file.
+     * @param jobCount The number of inputs encoded at once, or 0 for the number of processors.
+     * @param options The options added ahead of the arguments of every line, or an empty string.
+     */
+    BatchEncoder(const char* executable, const char* manifest, unsigned int jobCount, const std::string& options);
+    ~BatchEncoder();
+
+    /**
+     * Encodes every input of the manifest.
+     *
+     * @return true if every input was encoded successfully.
+     */
+    bool run();
+
+private:
+
+    /**
+     * Defines a line of the manifest.
+     */
+    struct Job
+    {
+        std::string arguments;
+        unsigned int line;
+        int result;
+    };
+
+    // Hidden copy/assignment
+    BatchEncoder(const BatchEncoder&);
+    BatchEncoder& operator=(const BatchEncoder&);
+
+    /**
+     * Reads the jobs from the manifest.
+     */
+    bool readManifest();
+
+    /**
+     * Runs jobs until there are none left. Started on each worker thread.
+     */
+    static int workerThread(void* data);
+
+    /**
+     * Runs the encoder process of a job and returns its exit code, with its output in output.
+     */
+    int encode(const Job& job, std::string* output) const;
+
+    std::string _executable;
+    std::string _manifest;
+    std::string _options;
+    unsigned int _jobCount;
+    std::vector<Job> _jobs;
+    size_t _nextJob;
+    size_t _finishedJobs;
+};
+
+}
+
+#endif
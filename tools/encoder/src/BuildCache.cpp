@@ -0,0 +1,244 @@
+#include "Base.h"
+#include "BuildCache.h"
+#include "StringUtil.h"
+
+#ifdef WIN32
+    #include <direct.h>
+    #define mkdir(path, mode) _mkdir(path)
+#endif
+
+// The first line of the cache entries, changed when their format changes.
+#define BUILD_CACHE_HEADER "gameplay-encoder cache 1"
+
+// The range of font sizes accepted when the encoder prompts for them.
+#define BUILD_CACHE_MIN_FONT_SIZE 8
+#define BUILD_CACHE_MAX_FONT_SIZE 96
+
+// The parameters of the 64-bit FNV-1a hash.
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+namespace gameplay
+{
+
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static unsigned long long hashString(unsigned long long hash, const std::string& str)
+{
+    // Include the terminator so that consecutive strings can't run into each other.
+    return hashBytes(hash, str.c_str(), str.length() + 1);
+}
+
+static bool getModifiedTime(const std::string& path, time_t* time)
+{
+    struct stat s;
+    if (stat(path.c_str(), &s) != 0)
+        return false;
+    *time = s.st_mtime;
+    return true;
+}
+
+BuildCache::BuildCache(const char* directory, const EncoderArguments& arguments) :
+    _startTime(time(NULL)), _valid(false)
+{
+    unsigned long long key, size;
+    if (!hashFile(arguments.getFilePath(), &key, &size))
+    {
+        LOG(1, "Warning: Failed to read the input file, not using the cache: %s\n", arguments.getFilePathPointer());
+        return;
+    }
+    key = hashString(key, arguments.getCommandLine());
+    key = hashString(key, arguments.getFilePath());
+    key = hashString(key, arguments.getOutputFilePath());
+    key = hashString(key, EncoderArguments::getVersion());
+
+    std::string path(directory);
+    if (!path.empty() && path[path.length() - 1] != '/' && path[path.length() - 1] != '\\')
+        path.append("/");
+    struct stat s;
+    if (stat(directory, &s) != 0 && mkdir(directory, 0777) != 0)
+    {
+        LOG(1, "Warning: Failed to create the cache directory, not using the cache: %s\n", directory);
+        return;
+    }
+
+    char name[32];
+    sprintf(name, "%016llx.txt", key);
+    _entryPath = path + name;
+
+    listOutputs(arguments);
+    _valid = true;
+}
+
+BuildCache::~BuildCache()
+{
+}
+
+bool BuildCache::isUpToDate() const
+{
+    if (!_valid)
+        return false;
+
+    std::ifstream stream(_entryPath.c_str());
+    std::string line;
+    if (!stream || !std::getline(stream, line) || line != BUILD_CACHE_HEADER)
+        return false;
+
+    unsigned int outputCount = 0;
+    while (std::getline(stream, line))
+    {
+        // Each line holds the hash, size and path of an output, separated by single spaces.
+        size_t first = line.find(' ');
+        size_t second = first == std::string::npos ? first : line.find(' ', first + 1);
+        if (second == std::string::npos)
+            return false;
+
+        Output output;
+        if (sscanf(line.c_str(), "%llx %llu", &output.hash, &output.size) != 2)
+            return false;
+        output.path = line.substr(second + 1);
+
+        unsigned long long hash, size;
+        if (!hashFile(output.path, &hash, &size) || hash != output.hash || size != output.size)
+        {
+            LOG(2, "Output changed since it was cached: %s\n", output.path.c_str());
+            return false;
+        }
+        ++outputCount;
+    }
+    return outputCount > 0;
+}
+
+bool BuildCache::record()
+{
+    if (!_valid)
+        return false;
+
+    time_t time;
+    if (!getModifiedTime(_mainOutput, &time) || time < _startTime)
+        return false;
+
+    std::vector<Output> outputs;
+    for (size_t i = 0, count = _outputs.size(); i < count; ++i)
+    {
+        // Outputs left over from earlier encodings with other arguments are not ours.
+        Output output;
+        output.path = _outputs[i];
+        if (!getModifiedTime(output.path, &time) || time < _startTime)
+            continue;
+        if (!hashFile(output.path, &output.hash, &output.size))
+            continue;
+        outputs.push_back(output);
+    }
+
+    // Write the entry under another name first, so that an interrupted encoder never leaves a partial entry.
+    std::string tempPath = _entryPath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "w");
+    if (file == NULL)
+    {
+        LOG(1, "Warning: Failed to write the cache entry: %s\n", _entryPath.c_str());
+        return false;
+    }
+    fprintf(file, "%s\n", BUILD_CACHE_HEADER);
+    for (size_t i = 0, count = outputs.size(); i < count; ++i)
+    {
+        fprintf(file, "%016llx %llu %s\n", outputs[i].hash, outputs[i].size, outputs[i].path.c_str());
+    }
+    bool written = ferror(file) == 0;
+    written = fclose(file) == 0 && written;
+
+    remove(_entryPath.c_str());
+    if (!written || rename(tempPath.c_str(), _entryPath.c_str()) != 0)
+    {
+        LOG(1, "Warning: Failed to write the cache entry: %s\n", _entryPath.c_str());
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BuildCache::listOutputs(const EncoderArguments& arguments)
+{
+    std::string outputFilePath = arguments.getOutputFilePath();
+    std::string outputNoExt = getFilenameNoExt(outputFilePath);
+
+    switch (arguments.getFileFormat())
+    {
+    case EncoderArguments::FILEFORMAT_FBX:
+        {
+            // Same names as FBXSceneEncoder::write.
+            int pos = outputFilePath.find_last_of('.');
+            std::string base = pos > 2 ? outputFilePath.substr(0, pos) : std::string();
+            _mainOutput = arguments.textOutputEnabled() ? base + ".xml" : outputFilePath;
+            _outputs.push_back(_mainOutput);
+            if (arguments.outputMaterialEnabled() && !base.empty())
+                _outputs.push_back(base + ".material");
+
+            const std::vector<EncoderArguments::HeightmapOption>& heightmaps = arguments.getHeightmapOptions();
+            for (size_t i = 0, count = heightmaps.size(); i < count; ++i)
+            {
+                _outputs.push_back(heightmaps[i].filename);
+            }
+        }
+        break;
+
+    case EncoderArguments::FILEFORMAT_TTF:
+        {
+            _mainOutput = outputFilePath;
+            _outputs.push_back(_mainOutput);
+            if (arguments.fontPreviewEnabled())
+            {
+                // Without -s the size is prompted for (or 48 for distance fields), so list the sizes that can be entered.
+                std::vector<unsigned int> sizes = arguments.getFontSizes();
+                if (sizes.empty())
+                {
+                    for (unsigned int size = BUILD_CACHE_MIN_FONT_SIZE; size <= BUILD_CACHE_MAX_FONT_SIZE; ++size)
+                        sizes.push_back(size);
+                }
+                for (size_t i = 0, count = sizes.size(); i < count; ++i)
+                {
+                    char suffix[16];
+                    sprintf(suffix, "-%u.pgm", sizes[i]);
+                    _outputs.push_back(outputNoExt + suffix);
+                }
+            }
+        }
+        break;
+
+    default:
+        _mainOutput = outputFilePath;
+        _outputs.push_back(_mainOutput);
+        break;
+    }
+}
+
+bool BuildCache::hashFile(const std::string& path, unsigned long long* hash, unsigned long long* size)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    *hash = FNV_OFFSET_BASIS;
+    *size = 0;
+    char buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        *hash = hashBytes(*hash, buffer, read);
+        *size += read;
+    }
+    bool error = ferror(file) != 0;
+    fclose(file);
+    return !error;
+}
+
+}
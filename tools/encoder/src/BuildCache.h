@@ -0,0 +1,90 @@
+#ifndef BUILDCACHE_H_
+#define BUILDCACHE_H_
+
+#include "EncoderArguments.h"
+
+namespace gameplay
+{
+
+/**
+ * Skips encoding an input whose contents and options have not changed since it was last encoded.
+ *
+ * The cache is a directory with one entry file per input. An entry is named after a 64-bit FNV-1a
+ * hash of the contents of the input file, the arguments of the encoder (without -cache) and the
+ * version of the encoder, and lists the hash, size and path of each file written by the encoder
+ * for it. An input is up to date when its entry exists and every file listed in it still exists
+ * with the same hash, so the outputs that were deleted or edited since are encoded again.
+ *
+ * Only the input file itself is hashed. The files it refers to, such as the textures of a scene,
+ * are not, so an encoder option or the input file must change for them to be encoded again.
+ *
+ * Since each input has its own entry file, inputs encoded in parallel by -batch can share a cache.
+ */
+class BuildCache
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param directory The directory of the cache, created if it does not exist.
+     * @param arguments The arguments of the encoder.
+     */
+    BuildCache(const char* directory, const EncoderArguments& arguments);
+    ~BuildCache();
+
+    /**
+     * Determines if the outputs of the input are up to date.
+     *
+     * @return true if the input was encoded with the same contents and arguments, and its outputs are unchanged.
+     */
+    bool isUpToDate() const;
+
+    /**
+     * Records the outputs of the input, after it was encoded.
+     *
+     * Nothing is recorded unless the main output of the encoder was written since the cache was
+     * created, so that a failed encoding is performed again the next time.
+     *
+     * @return true if the entry was written.
+     */
+    bool record();
+
+private:
+
+    /**
+     * Defines an output file of an entry.
+     */
+    struct Output
+    {
+        std::string path;
+        unsigned long long hash;
+        unsigned long long size;
+    };
+
+    // Hidden copy/assignment
+    BuildCache(const BuildCache&);
+    BuildCache& operator=(const BuildCache&);
+
+    /**
+     * Adds the paths of the files the encoder can write for the arguments.
+     */
+    void listOutputs(const EncoderArguments& arguments);
+
+    /**
+     * Computes the FNV-1a hash and the size of a file.
+     *
+     * @return false if the file could not be read.
+     */
+    static bool hashFile(const std::string& path, unsigned long long* hash, unsigned long long* size);
+
+    std::string _entryPath;
+    std::string _mainOutput;
+    std::vector<std::string> _outputs;
+    time_t _startTime;
+    bool _valid;
+};
+
+}
+
+#endif
@@ -27,8 +27,22 @@ EncoderArguments::EncoderArguments(size_t argc, const char** argv) :
     _fontFormat(Font::BITMAP),
     _textOutput(false),
     _optimizeAnimations(false),
+    _compressAnimations(false),
+    _optimizeMeshes(false),
+    _optimizeOverdraw(false),
+    _compressVertices(false),
+    _compressPositions(false),
+    _compressMeshes(false),
+    _archive(false),
+    _compressArchive(false),
+    _batch(false),
+    _batchJobCount(0),
     _animationGrouping(ANIMATIONGROUP_PROMPT),
-    _outputMaterial(false)
+    _outputMaterial(false),
+    _texture(false),
+    _textureMipmaps(true),
+    _powerOfTwo(false),
+    _maxTextureSize(0)
 {
     __instance = this;
 
@@ -60,6 +74,18 @@ EncoderArguments::EncoderArguments(size_t argc, const char** argv) :
         {
             setInputfilePath(arguments[index]);
         }
+
+        // The arguments that change the outputs, which key the entries of the build cache.
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            if (arguments[i] == "-cache")
+            {
+                ++i;
+                continue;
+            }
+            _commandLine.append(arguments[i]);
+            _commandLine.append(1, '\0');
+        }
     }
     else
     {
@@ -102,12 +128,17 @@ std::string EncoderArguments::getOutputDirPath() const
 
 std::string EncoderArguments::getOutputFileExtension() const
 {
+    if (_archive)
+        return ".pak";
+
     switch (getFileFormat())
     {
     case FILEFORMAT_PNG:
     case FILEFORMAT_RAW:
         if (_normalMap)
             return ".png";
+        if (_texture)
+            return ".ktx";
 
     default:
         return ".gpb";
@@ -123,6 +154,12 @@ std::string EncoderArguments::getOutputFilePath() const
     }
     else
     {
+        // Archives are named after the directory they pack
+        if (_archive)
+        {
+            return _filePath + getOutputFileExtension();
+        }
+
         // Generate an output file path
         int pos = _filePath.find_last_of('.');
         std::string outputFilePath(pos > 0 ? _filePath.substr(0, pos) : _filePath);
@@ -175,6 +212,21 @@ const std::vector<EncoderArguments::HeightmapOption>& EncoderArguments::getHeigh
     return _heightmaps;
 }
 
+const std::vector<EncoderArguments::NavMeshOption>& EncoderArguments::getNavMeshOptions() const
+{
+    return _navMeshes;
+}
+
+const std::vector<EncoderArguments::VisibilitySetOption>& EncoderArguments::getVisibilitySetOptions() const
+{
+    return _visibilitySets;
+}
+
+const std::vector<float>& EncoderArguments::getLodScreenSizes() const
+{
+    return _lodScreenSizes;
+}
+
 unsigned int EncoderArguments::tangentBinormalIdCount() const
 {
     return _tangentBinormalId.size();
@@ -261,6 +313,33 @@ void EncoderArguments::printUsage() const
         "\t\tremoving any channels that contain default/identity values\n" \
         "\t\tand removing any duplicate contiguous keyframes, which are \n" \
         "\t\tcommon when exporting baked animation data.\n" \
+    "  -ca\n" \
+        "\t\tCompresses animations by quantizing the key values of\n" \
+        "\t\tanimation channels: rotations are stored in 48 bits and\n" \
+        "\t\tother components in 16 bits within the range of the channel.\n" \
+        "\t\tCan be combined with -oa.\n" \
+    "  -cv\n" \
+        "\t\tCompresses vertices: normals, tangents and binormals are\n" \
+        "\t\tstored as 10:10:10:2 normalized integers, texture coordinates\n" \
+        "\t\tas half floats and colors, blend weights and blend indices\n" \
+        "\t\tin bytes. Drivers that can't read these types get floats.\n" \
+    "  -cv:positions\n" \
+        "\t\tSame as -cv, and also stores positions as half floats, which\n" \
+        "\t\tis only precise enough for small meshes.\n" \
+    "  -cm\n" \
+        "\t\tCompresses the vertices and indices of meshes losslessly with\n" \
+        "\t\tdelta coding and bit packing, which the runtime decodes at\n" \
+        "\t\tload time (on its worker threads for large meshes). Combine\n" \
+        "\t\twith -om and -cv for the smallest meshes.\n" \
+    "  -om\n" \
+        "\t\tOptimizes meshes for the GPU: reorders the triangles of each\n" \
+        "\t\tmesh part for the post-transform vertex cache and the vertices\n" \
+        "\t\tin the order they are used, so that mesh parts use 16-bit\n" \
+        "\t\tindices whenever their vertices allow it.\n" \
+    "  -om:overdraw\n" \
+        "\t\tSame as -om, and also sorts clusters of triangles so that\n" \
+        "\t\toutward facing triangles are drawn first, reducing overdraw\n" \
+        "\t\tfrom most view directions.\n" \
     "  -h <size> \"<node ids>\" <filename>\n" \
         "\t\tGenerates a single heightmap image using meshes from the \n" \
         "\t\tspecified nodes. \n" \
@@ -270,6 +349,66 @@ void EncoderArguments::printUsage() const
         "\t\tFilename is the name of the image (PNG) to be saved.\n" \
         "\t\tMultiple -h arguments can be supplied to generate more than one \n" \
         "\t\theightmap. For 24-bit packed height data use -hp instead of -h.\n" \
+    "  -nav \"<node ids>\" <navmesh id>\n" \
+        "\t\tGenerates a navigation mesh from the walkable triangles of the\n" \
+        "\t\tmeshes of the specified nodes, to be loaded with\n" \
+        "\t\tBundle::loadNavMesh(). Triangles steeper than 45 degrees are\n" \
+        "\t\tleft out. <node ids> is a comma-separated list of node ids.\n" \
+        "\t\tMultiple -nav arguments can be supplied.\n" \
+    "  -pvs \"<node ids>\" <pvs id> <cell size>\n" \
+        "\t\tPrecomputes a potentially visible set for the static meshes of\n" \
+        "\t\tthe specified nodes, to be loaded with\n" \
+        "\t\tBundle::loadVisibilitySet(). The bounds of the nodes are\n" \
+        "\t\tdivided into cubic cells of <cell size> and the nodes that can\n" \
+        "\t\tbe seen from each cell are stored. <node ids> is a\n" \
+        "\t\tcomma-separated list of node ids.\n" \
+        "\t\tMultiple -pvs arguments can be supplied.\n" \
+    "  -lod <screen sizes>\n" \
+        "\t\tGenerates simplified levels of detail for the mesh of each\n" \
+        "\t\tmodel. <screen sizes> is a comma-separated list of sizes in\n" \
+        "\t\tpixels, one per level of detail, below which the level of\n" \
+        "\t\tdetail is drawn. Each level has about half the triangles of\n" \
+        "\t\tthe previous one.\n" \
+    "\n" \
+    "Batch options:\n" \
+    "  -batch\tEncodes the inputs listed in the input file, a manifest with\n" \
+        "\t\tthe arguments of one encoder invocation per line (options,\n" \
+        "\t\tinput file and optional output file). Blank lines and lines\n" \
+        "\t\tstarting with '#' are skipped. The lines are encoded in\n" \
+        "\t\tparallel by separate processes, and the failed lines are\n" \
+        "\t\tlisted at the end.\n" \
+    "  -j <jobs>\tNumber of inputs encoded at once by -batch (defaults to the\n" \
+        "\t\tnumber of processors).\n" \
+    "\n" \
+    "Cache options:\n" \
+    "  -cache <dir>\tSkips encoding the input when its contents and the other\n" \
+        "\t\targuments are the same as when it was last encoded, and its\n" \
+        "\t\toutputs are unchanged. The hashes of the inputs and outputs\n" \
+        "\t\tare kept in <dir>. Files referred to by the input, such as\n" \
+        "\t\ttextures, are not checked. With -batch, the cache is used by\n" \
+        "\t\tevery line of the manifest.\n" \
+    "\n" \
+    "Archive options:\n" \
+    "  -pak\t\tPacks the input directory, and its subdirectories, into a single\n" \
+        "\t\tarchive (<directory>.pak unless an output file is given) to be\n" \
+        "\t\tmounted with FileSystem::mountArchive(). The names of the\n" \
+        "\t\tentries start with the name of the directory, such as\n" \
+        "\t\t\"res/shaders/colored.vert\" when packing \"res\".\n" \
+    "  -pak:lz4\tSame as -pak, and also compresses the entries with LZ4 when\n" \
+        "\t\tit makes them smaller.\n" \
+    "\n" \
+    "Texture options:\n" \
+    "  -tex\t\tEncodes a PNG image as a KTX texture (<image>.ktx unless an\n" \
+        "\t\toutput file is given) holding its whole mipmap chain, which the\n" \
+        "\t\truntime uploads directly instead of generating mipmaps at load\n" \
+        "\t\ttime. The levels are filtered with a Lanczos filter in linear\n" \
+        "\t\tspace, weighted by alpha.\n" \
+    "  -tex:nomips\tSame as -tex, but only stores the base level.\n" \
+    "  -pot\t\tResizes the texture to the nearest powers of two.\n" \
+    "  -maxsize <size>\n" \
+        "\t\tClamps the width and height of the texture to <size>, keeping\n" \
+        "\t\tits aspect ratio. Use a batch manifest per platform to encode\n" \
+        "\t\tsmaller textures for the platforms with less memory.\n" \
     "\n" \
     "Normal map options:\n" \
         "  -n\t\tGenerate normal map (requires input file of type PNG or RAW)\n" \
@@ -290,6 +429,8 @@ void EncoderArguments::printUsage() const
     "  -s <sizes>\tComma-separated list of font sizes (in pixels).\n" \
     "  -p\t\tOutput font preview.\n" \
     "  -f\t\tFormat of font. -f:b (BITMAP), -f:d (DISTANCE_FIELD).\n" \
+    "  \t\tA distance field font is encoded at a single size (the largest\n" \
+    "  \t\tof -s, or 48) and scaled to any size at runtime.\n" \
     "\n");
     exit(8);
 }
@@ -314,11 +455,96 @@ bool EncoderArguments::optimizeAnimationsEnabled() const
     return _optimizeAnimations;
 }
 
+bool EncoderArguments::optimizeMeshesEnabled() const
+{
+    return _optimizeMeshes;
+}
+
+bool EncoderArguments::optimizeOverdrawEnabled() const
+{
+    return _optimizeOverdraw;
+}
+
+bool EncoderArguments::compressVerticesEnabled() const
+{
+    return _compressVertices;
+}
+
+bool EncoderArguments::compressPositionsEnabled() const
+{
+    return _compressPositions;
+}
+
+bool EncoderArguments::compressMeshesEnabled() const
+{
+    return _compressMeshes;
+}
+
+bool EncoderArguments::archiveEnabled() const
+{
+    return _archive;
+}
+
+bool EncoderArguments::compressArchiveEnabled() const
+{
+    return _compressArchive;
+}
+
+bool EncoderArguments::batchEnabled() const
+{
+    return _batch;
+}
+
+unsigned int EncoderArguments::getBatchJobCount() const
+{
+    return _batchJobCount;
+}
+
+const std::string& EncoderArguments::getCachePath() const
+{
+    return _cachePath;
+}
+
+const std::string& EncoderArguments::getCommandLine() const
+{
+    return _commandLine;
+}
+
+const char* EncoderArguments::getVersion()
+{
+    return ENCODER_VERSION;
+}
+
+bool EncoderArguments::compressAnimationsEnabled() const
+{
+    return _compressAnimations;
+}
+
 bool EncoderArguments::outputMaterialEnabled() const
 {
     return _outputMaterial;
 }
 
+bool EncoderArguments::textureEnabled() const
+{
+    return _texture;
+}
+
+bool EncoderArguments::textureMipmapsEnabled() const
+{
+    return _textureMipmaps;
+}
+
+bool EncoderArguments::powerOfTwoEnabled() const
+{
+    return _powerOfTwo;
+}
+
+unsigned int EncoderArguments::getMaxTextureSize() const
+{
+    return _maxTextureSize;
+}
+
 const char* EncoderArguments::getNodeId() const
 {
     if (_nodeId.length() == 0)
@@ -387,6 +613,48 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
     }
     switch (str[1])
     {
+    case 'b':
+        if (str == "-batch")
+        {
+            // Encode the inputs listed in a manifest
+            _batch = true;
+        }
+        break;
+    case 'c':
+        if (str == "-ca")
+        {
+            // Compress animations
+            _compressAnimations = true;
+        }
+        else if (str == "-cache")
+        {
+            // Skip inputs that have not changed since they were last encoded
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: -cache requires a directory.\n");
+                _parseError = true;
+                return;
+            }
+            _cachePath = options[*index];
+        }
+        else if (str == "-cm")
+        {
+            // Compress mesh data
+            _compressMeshes = true;
+        }
+        else if (str == "-cv")
+        {
+            // Compress vertices
+            _compressVertices = true;
+        }
+        else if (str == "-cv:positions")
+        {
+            // Compress vertices, including positions
+            _compressVertices = true;
+            _compressPositions = true;
+        }
+        break;
     case 'f':
         if (str.compare("-f:b") == 0)
         {
@@ -442,6 +710,17 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
             // Optimize animations
             _optimizeAnimations = true;
         }
+        else if (str == "-om")
+        {
+            // Optimize meshes for the vertex cache
+            _optimizeMeshes = true;
+        }
+        else if (str == "-om:overdraw")
+        {
+            // Optimize meshes for the vertex cache and overdraw
+            _optimizeMeshes = true;
+            _optimizeOverdraw = true;
+        }
         break;
     case 'h':
         {
@@ -509,15 +788,84 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
             }
         }
         break;
+    case 'j':
+        if (str == "-j")
+        {
+            (*index)++;
+            if (*index >= options.size() || atoi(options[*index].c_str()) <= 0)
+            {
+                LOG(1, "Error: -j requires a positive number of jobs.\n");
+                _parseError = true;
+                return;
+            }
+            _batchJobCount = (unsigned int)atoi(options[*index].c_str());
+        }
+        break;
+    case 'l':
+        if (str.compare("-lod") == 0)
+        {
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: -lod requires 1 argument.\n");
+                _parseError = true;
+                return;
+            }
+            std::vector<std::string> parts;
+            splitString(options[*index].c_str(), &parts);
+            for (size_t i = 0; i < parts.size(); ++i)
+            {
+                float size = (float)atof(parts[i].c_str());
+                if (size <= 0.0f)
+                {
+                    LOG(1, "Error: invalid LOD screen size provided: %s\n", parts[i].c_str());
+                    _parseError = true;
+                    return;
+                }
+                _lodScreenSizes.push_back(size);
+            }
+        }
+        break;
     case 'm':
         if (str.compare("-m") == 0)
         {
             // generate a material file
             _outputMaterial = true;
         }
+        else if (str == "-maxsize")
+        {
+            // Clamp the size of textures
+            (*index)++;
+            if (*index >= options.size() || atoi(options[*index].c_str()) <= 0)
+            {
+                LOG(1, "Error: -maxsize requires a positive size.\n");
+                _parseError = true;
+                return;
+            }
+            _maxTextureSize = (unsigned int)atoi(options[*index].c_str());
+        }
         break;
     case 'n':
-        _normalMap = true;
+        if (str.compare("-nav") == 0)
+        {
+            // read two strings, make sure not to go out of bounds
+            if ((*index + 2) >= options.size())
+            {
+                LOG(1, "Error: -nav requires 2 arguments.\n");
+                _parseError = true;
+                return;
+            }
+            _navMeshes.resize(_navMeshes.size() + 1);
+            NavMeshOption& navMesh = _navMeshes.back();
+            (*index)++;
+            splitString(options[*index].c_str(), &navMesh.nodeIds);
+            (*index)++;
+            navMesh.id = options[*index];
+        }
+        else
+        {
+            _normalMap = true;
+        }
         break;
     case 'w':
         {
@@ -549,7 +897,44 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         }
         break;
     case 'p':
-        _fontPreview = true;
+        if (str.compare("-pvs") == 0)
+        {
+            // read three strings, make sure not to go out of bounds
+            if ((*index + 3) >= options.size())
+            {
+                LOG(1, "Error: -pvs requires 3 arguments.\n");
+                _parseError = true;
+                return;
+            }
+            _visibilitySets.resize(_visibilitySets.size() + 1);
+            VisibilitySetOption& visibilitySet = _visibilitySets.back();
+            (*index)++;
+            splitString(options[*index].c_str(), &visibilitySet.nodeIds);
+            (*index)++;
+            visibilitySet.id = options[*index];
+            (*index)++;
+            visibilitySet.cellSize = (float)atof(options[*index].c_str());
+        }
+        else if (str == "-pak")
+        {
+            // Pack a directory into an archive
+            _archive = true;
+        }
+        else if (str == "-pak:lz4")
+        {
+            // Pack a directory into an archive of compressed entries
+            _archive = true;
+            _compressArchive = true;
+        }
+        else if (str == "-pot")
+        {
+            // Resize textures to powers of two
+            _powerOfTwo = true;
+        }
+        else
+        {
+            _fontPreview = true;
+        }
         break;
     case 's':
         if (_normalMap)
@@ -637,6 +1022,17 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         {
             _textOutput = true;
         }
+        else if (str == "-tex")
+        {
+            // Encode an image as a texture with its mipmaps
+            _texture = true;
+        }
+        else if (str == "-tex:nomips")
+        {
+            // Encode an image as a texture without mipmaps
+            _texture = true;
+            _textureMipmaps = false;
+        }
         else if (str.compare("-tb") == 0)
         {
             if ((*index + 1) >= options.size())
@@ -35,6 +35,19 @@ public:
         int height;
     };
 
+    struct NavMeshOption
+    {
+        std::vector<std::string> nodeIds;
+        std::string id;
+    };
+
+    struct VisibilitySetOption
+    {
+        std::vector<std::string> nodeIds;
+        std::string id;
+        float cellSize;
+    };
+
     struct NormalMapOption
     {
         std::string inputFile;
@@ -106,6 +119,15 @@ public:
 
     const std::vector<HeightmapOption>& getHeightmapOptions() const;
 
+    const std::vector<NavMeshOption>& getNavMeshOptions() const;
+
+    const std::vector<VisibilitySetOption>& getVisibilitySetOptions() const;
+
+    /**
+     * Returns the screen sizes, in pixels, of the levels of detail to generate for each model.
+     */
+    const std::vector<float>& getLodScreenSizes() const;
+
     /**
      * Returns the number of node IDs that were marked as needing to compute tangents and binormals.
      */
@@ -162,8 +184,90 @@ public:
 
     bool optimizeAnimationsEnabled() const;
 
+    bool compressAnimationsEnabled() const;
+
+    /**
+     * Returns true if the triangles and vertices of meshes should be reordered for the GPU vertex cache.
+     */
+    bool optimizeMeshesEnabled() const;
+
+    /**
+     * Returns true if the triangles of meshes should also be reordered to reduce overdraw.
+     */
+    bool optimizeOverdrawEnabled() const;
+
+    /**
+     * Returns true if vertex elements should be stored in compact types.
+     */
+    bool compressVerticesEnabled() const;
+
+    /**
+     * Returns true if vertex positions should also be stored as half floats.
+     */
+    bool compressPositionsEnabled() const;
+
+    /**
+     * Returns true if the vertices and indices of meshes should be compressed in the bundle.
+     */
+    bool compressMeshesEnabled() const;
+
+    /**
+     * Returns true if the input directory should be packed into an archive.
+     */
+    bool archiveEnabled() const;
+
+    /**
+     * Returns true if the entries of the archive should be compressed with LZ4.
+     */
+    bool compressArchiveEnabled() const;
+
+    /**
+     * Returns true if the input file is a manifest of inputs to encode in parallel.
+     */
+    bool batchEnabled() const;
+
+    /**
+     * Returns the number of inputs encoded at once in batch mode, or 0 for the number of processors.
+     */
+    unsigned int getBatchJobCount() const;
+
+    /**
+     * Returns the directory of the build cache, or an empty string if the cache is not used.
+     */
+    const std::string& getCachePath() const;
+
+    /**
+     * Returns the arguments of the encoder, except for -cache, each followed by a null character.
+     */
+    const std::string& getCommandLine() const;
+
+    /**
+     * Returns the version of the encoder.
+     */
+    static const char* getVersion();
+
     bool outputMaterialEnabled() const;
 
+    /**
+     * Returns true if the input image should be encoded as a KTX texture.
+     */
+    bool textureEnabled() const;
+
+    /**
+     * Returns true if the mipmap chain of the texture should be stored.
+     */
+    bool textureMipmapsEnabled() const;
+
+    /**
+     * Returns true if the texture should be resized to powers of two.
+     */
+    bool powerOfTwoEnabled() const;
+
+    /**
+     * Returns the largest width and height of the texture, or 0 for no limit.
+     */
+    unsigned int getMaxTextureSize() const;
+
     const char* getNodeId() const;
 
     static std::string getRealPath(const std::string& filepath);
@@ -197,6 +301,8 @@ private:
     std::string _filePath;
     std::string _fileOutputPath;
     std::string _nodeId;
+    std::string _cachePath;
+    std::string _commandLine;
 
     bool _normalMap;
     Vector3 _heightmapWorldSize;
@@ -208,12 +314,29 @@ private:
     Font::FontFormat _fontFormat;
     bool _textOutput;
     bool _optimizeAnimations;
+    bool _compressAnimations;
+    bool _optimizeMeshes;
+    bool _optimizeOverdraw;
+    bool _compressVertices;
+    bool _compressPositions;
+    bool _compressMeshes;
+    bool _archive;
+    bool _compressArchive;
+    bool _batch;
+    unsigned int _batchJobCount;
     AnimationGroupOption _animationGrouping;
     bool _outputMaterial;
+    bool _texture;
+    bool _textureMipmaps;
+    bool _powerOfTwo;
+    unsigned int _maxTextureSize;
 
     std::vector<std::string> _groupAnimationNodeId;
     std::vector<std::string> _groupAnimationAnimationId;
     std::vector<HeightmapOption> _heightmaps;
+    std::vector<NavMeshOption> _navMeshes;
+    std::vector<VisibilitySetOption> _visibilitySets;
+    std::vector<float> _lodScreenSizes;
     std::set<std::string> _tangentBinormalId;
 
 };
@@ -6,6 +6,7 @@
 #include "Transform.h"
 #include "Vector3.h"
 #include "Vector2.h"
+#include "Thread.h"
 
 using namespace gameplay;
 using std::string;
@@ -753,7 +754,11 @@ bool isBlack(FbxDouble3& fbxDouble)
     return fbxDouble[0] == 0.0 && fbxDouble[1] == 0.0 && fbxDouble[2] == 0.0;
 }
 
-void generateTangentsAndBinormals(FbxNode* fbxNode, const EncoderArguments& arguments)
+/**
+ * Recursively gathers the meshes of the nodes that were specified in the command line arguments,
+ * listing each mesh once when nodes share it.
+ */
+static void gatherTangentBinormalMeshes(FbxNode* fbxNode, const EncoderArguments& arguments, vector<FbxMesh*>& meshes)
 {
     if (!fbxNode)
         return;
@@ -761,16 +766,33 @@ void generateTangentsAndBinormals(FbxNode* fbxNode, const EncoderArguments& argu
     if (name && strlen(name) > 0)
     {
         FbxMesh* fbxMesh = fbxNode->GetMesh();
-        if (fbxMesh && arguments.isGenerateTangentBinormalId(string(name)))
+        if (fbxMesh && arguments.isGenerateTangentBinormalId(string(name)) && std::find(meshes.begin(), meshes.end(), fbxMesh) == meshes.end())
         {
-            fbxMesh->GenerateTangentsDataForAllUVSets();
+            meshes.push_back(fbxMesh);
         }
     }
     // visit child nodes
     const int childCount = fbxNode->GetChildCount();
     for (int i = 0; i < childCount; ++i)
     {
-        generateTangentsAndBinormals(fbxNode->GetChild(i), arguments);
+        gatherTangentBinormalMeshes(fbxNode->GetChild(i), arguments, meshes);
+    }
+}
+
+static void generateMeshTangentsAndBinormals(void* meshes, int index)
+{
+    FbxMesh* fbxMesh = ((FbxMesh**)meshes)[index];
+    fbxMesh->GenerateTangentsDataForAllUVSets();
+}
+
+void generateTangentsAndBinormals(FbxNode* fbxNode, const EncoderArguments& arguments)
+{
+    // Each mesh only reads and writes its own layers, so the meshes are processed in parallel.
+    vector<FbxMesh*> meshes;
+    gatherTangentBinormalMeshes(fbxNode, arguments, meshes);
+    if (!meshes.empty())
+    {
+        parallelFor((int)meshes.size(), &generateMeshTangentsAndBinormals, &meshes[0]);
     }
 }
 
@@ -191,6 +191,7 @@ bool isBlack(FbxDouble3& fbxDouble);
 
 /**
  * Recursively generates the tangents and binormals for all nodes that were specified in the command line arguments.
+ * The meshes of the nodes are processed in parallel.
  */
 void generateTangentsAndBinormals(FbxNode* fbxNode, const EncoderArguments& arguments);
 
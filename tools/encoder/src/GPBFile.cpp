@@ -4,6 +4,10 @@
 #include "StringUtil.h"
 #include "EncoderArguments.h"
 #include "Heightmap.h"
+#include "NavMesh.h"
+#include "VisibilitySet.h"
+#include "MeshOptimizer.h"
+#include "Thread.h"
 
 #define EPSILON 1.2e-7f;
 
@@ -41,6 +45,35 @@ static Node* getCommonNodeAncestor(const std::vector<Node*>& nodes);
  */
 static void getNodeAncestors(Node* node, std::list<Node*>& ancestors);
 
+/**
+ * Decomposes an ANIMATE_SCALE_ROTATE_TRANSLATE channel into 3 new channels. (Scale, Rotate and Translate)
+ *
+ * @param channel The animation channel to decompose.
+ * @param decomposed The output scale, rotate and translate channels. A channel is NULL when it would
+ *                   only hold default/identity values.
+ */
+static void decomposeTransformAnimationChannel(AnimationChannel* channel, AnimationChannel** decomposed);
+
+// Data shared by the meshes processed in parallel by adjust()
+struct MeshProcessData
+{
+    Mesh** meshes;              // [in/out]
+    bool optimize;              // [in]
+    bool optimizeOverdraw;      // [in]
+    bool compress;              // [in]
+    bool compressPositions;     // [in]
+};
+
+// Data shared by the animation channels decomposed in parallel by optimizeAnimations()
+struct DecomposeChannelData
+{
+    std::vector<AnimationChannel*> channels;    // [in]
+    std::vector<AnimationChannel*> decomposed;  // [out] 3 entries per channel.
+};
+
+static void processMesh(void* meshData, int index);
+static void decomposeChannel(void* channelData, int index);
+
 
 GPBFile::GPBFile(void)
     : _file(NULL), _animationsAdded(false)
@@ -320,6 +353,30 @@ void GPBFile::adjust()
         computeBounds(*i);
     }
 
+    const std::vector<float>& lodScreenSizes = EncoderArguments::getInstance()->getLodScreenSizes();
+    if (!lodScreenSizes.empty())
+    {
+        LOG(1, "Generating levels of detail.\n");
+        generateLods(lodScreenSizes);
+    }
+
+    // The meshes share no data, so each one is optimized and compressed on its own thread.
+    MeshProcessData meshData;
+    meshData.optimize = EncoderArguments::getInstance()->optimizeMeshesEnabled();
+    meshData.optimizeOverdraw = EncoderArguments::getInstance()->optimizeOverdrawEnabled();
+    meshData.compress = EncoderArguments::getInstance()->compressVerticesEnabled();
+    meshData.compressPositions = EncoderArguments::getInstance()->compressPositionsEnabled();
+    if ((meshData.optimize || meshData.compress) && !_geometry.empty())
+    {
+        if (meshData.optimize)
+            LOG(1, "Optimizing meshes.\n");
+        if (meshData.compress)
+            LOG(1, "Compressing vertices.\n");
+        std::vector<Mesh*> meshes(_geometry.begin(), _geometry.end());
+        meshData.meshes = &meshes[0];
+        parallelFor((int)meshes.size(), &processMesh, &meshData);
+    }
+
     if (EncoderArguments::getInstance()->optimizeAnimationsEnabled())
     {
         LOG(1, "Optimizing animations.\n");
@@ -345,6 +402,20 @@ void GPBFile::adjust()
     {
         Heightmap::generate(heightmaps[i].nodeIds, heightmaps[i].width, heightmaps[i].height, heightmaps[i].filename.c_str(), heightmaps[i].isHighPrecision);
     }
+
+    // Generate navigation meshes
+    const std::vector<EncoderArguments::NavMeshOption>& navMeshes = EncoderArguments::getInstance()->getNavMeshOptions();
+    for (unsigned int i = 0, count = navMeshes.size(); i < count; ++i)
+    {
+        NavMesh::generate(navMeshes[i].nodeIds, navMeshes[i].id.c_str());
+    }
+
+    // Generate potentially visible sets
+    const std::vector<EncoderArguments::VisibilitySetOption>& visibilitySets = EncoderArguments::getInstance()->getVisibilitySetOptions();
+    for (unsigned int i = 0, count = visibilitySets.size(); i < count; ++i)
+    {
+        VisibilitySet::generate(visibilitySets[i].nodeIds, visibilitySets[i].id.c_str(), visibilitySets[i].cellSize);
+    }
 }
 
 void GPBFile::groupMeshSkinAnimations()
@@ -398,6 +469,60 @@ void GPBFile::computeBounds(Node* node)
     }
 }
 
+void GPBFile::generateLods(const std::vector<float>& screenSizes)
+{
+    // Models sharing a mesh share its levels of detail.
+    std::map<Mesh*, std::vector<Mesh*> > lods;
+    for (std::list<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+    {
+        Model* model = (*i)->getModel();
+        Mesh* mesh = model ? model->getMesh() : NULL;
+        if (mesh == NULL || model->getLodCount() > 0)
+            continue;
+
+        std::map<Mesh*, std::vector<Mesh*> >::iterator itr = lods.find(mesh);
+        if (itr == lods.end())
+        {
+            itr = lods.insert(std::make_pair(mesh, std::vector<Mesh*>())).first;
+
+            unsigned int triangleCount = 0;
+            for (std::vector<MeshPart*>::const_iterator j = mesh->parts.begin(); j != mesh->parts.end(); ++j)
+            {
+                triangleCount += (*j)->getIndicesCount() / 3;
+            }
+
+            // Each level of detail has about half the triangles of the previous one.
+            for (unsigned int j = 0; j < screenSizes.size(); ++j)
+            {
+                triangleCount /= 2;
+                Mesh* lod = mesh->simplify(triangleCount);
+                if (lod == NULL)
+                    break;
+
+                char suffix[16];
+                sprintf(suffix, "_lod%u", j + 1);
+                std::string id = mesh->getId() + suffix;
+                if (idExists(id))
+                {
+                    LOG(1, "WARNING: Skipping level of detail '%s'. The id is already used.\n", id.c_str());
+                    delete lod;
+                    break;
+                }
+                lod->setId(id);
+                lod->computeBounds();
+                addMesh(lod);
+                itr->second.push_back(lod);
+                LOG(2, "Generated level of detail '%s' with %u vertices.\n", id.c_str(), (unsigned int)lod->getVertexCount());
+            }
+        }
+
+        for (unsigned int j = 0; j < itr->second.size(); ++j)
+        {
+            model->addLod(itr->second[j], screenSizes[j]);
+        }
+    }
+}
+
 void GPBFile::optimizeAnimations()
 {
     const unsigned int animationCount = _animations.getAnimationCount();
@@ -410,32 +535,54 @@ void GPBFile::optimizeAnimations()
 
         LOG(2, "Optimizing %d channel(s) in animation '%s'.\n", channelCount, animation->getId().c_str());
 
-        // loop backwards because we will be adding and removing channels
-        for (int channelIndex = channelCount -1; channelIndex >= 0 ; --channelIndex)
+        // Optimize node animation channels. The channels are decomposed in parallel, since
+        // baked animations have many keyframes in each channel.
+        DecomposeChannelData data;
+        std::vector<int> channelIndices;
+        for (int channelIndex = 0; channelIndex < channelCount; ++channelIndex)
         {
             AnimationChannel* channel = animation->getAnimationChannel(channelIndex);
             assert(channel);
 
-            // Optimize node animation channels
             const Object* obj = _refTable.get(channel->getTargetId());
-            if (obj && obj->getTypeId() == Object::NODE_ID)
+            if (obj && obj->getTypeId() == Object::NODE_ID && channel->getTargetAttribute() == Transform::ANIMATE_SCALE_ROTATE_TRANSLATE)
             {
-                if (channel->getTargetAttribute() == Transform::ANIMATE_SCALE_ROTATE_TRANSLATE)
+                data.channels.push_back(channel);
+                channelIndices.push_back(channelIndex);
+            }
+        }
+        const int decomposeCount = (int)data.channels.size();
+        data.decomposed.resize(decomposeCount * 3, NULL);
+        parallelFor(decomposeCount, &decomposeChannel, &data);
+
+        // Replace the channels by their decomposed channels, backwards because we will be adding and
+        // removing channels, so that they are added in the same order as when decomposed one after the other.
+        static const char* channelNames[3] = { "scale", "rotation", "translation" };
+        for (int i = decomposeCount - 1; i >= 0; --i)
+        {
+            AnimationChannel* channel = data.channels[i];
+            LOG(2, "  Optimizing animaton channel %s:%d.\n", animation->getId().c_str(), channelIndices[i] + 1);
+            for (int j = 0; j < 3; ++j)
+            {
+                AnimationChannel* decomposed = data.decomposed[i * 3 + j];
+                if (decomposed)
                 {
-                    decomposeTransformAnimationChannel(animation, channel, channelIndex);
-
-                    animation->remove(channel);
-                    SAFE_DELETE(channel);
+                    LOG(3, "    Keeping %s channel.\n", channelNames[j]);
+                    animation->add(decomposed);
+                }
+                else
+                {
+                    LOG(2, "    Discarding %s channel.\n", channelNames[j]);
                 }
             }
+            animation->remove(channel);
+            SAFE_DELETE(channel);
         }
     }
 }
 
-void GPBFile::decomposeTransformAnimationChannel(Animation* animation, AnimationChannel* channel, int channelIndex)
+void decomposeTransformAnimationChannel(AnimationChannel* channel, AnimationChannel** decomposed)
 {
-    LOG(2, "  Optimizing animaton channel %s:%d.\n", animation->getId().c_str(), channelIndex+1);
-
     const std::vector<float>& keyTimes = channel->getKeyTimes();
     const std::vector<float>& keyValues = channel->getKeyValues();
     const size_t keyTimesSize = keyTimes.size();
@@ -469,13 +616,9 @@ void GPBFile::decomposeTransformAnimationChannel(Animation* animation, Animation
 
     // Don't add the scale channel if all the key values are close to 1.0
     size_t oneCount = (size_t)std::count_if(scaleKeyValues.begin(), scaleKeyValues.end(), isAlmostOne);
-    if (scaleKeyValues.size() == oneCount)
-    {
-        LOG(2, "    Discarding scale channel.\n");
-    }
-    else
+    decomposed[0] = decomposed[1] = decomposed[2] = NULL;
+    if (scaleKeyValues.size() != oneCount)
     {
-        LOG(3, "    Keeping scale channel.\n");
         AnimationChannel* scaleChannel = new AnimationChannel();
         scaleChannel->setTargetId(channel->getTargetId());
         scaleChannel->setKeyTimes(channel->getKeyTimes());
@@ -485,7 +628,7 @@ void GPBFile::decomposeTransformAnimationChannel(Animation* animation, Animation
         scaleChannel->setTargetAttribute(Transform::ANIMATE_SCALE);
         scaleChannel->setKeyValues(scaleKeyValues);
         scaleChannel->removeDuplicates();
-        animation->add(scaleChannel);
+        decomposed[0] = scaleChannel;
     }
 
     // Don't add the rotation channel if all quaternions are close to identity
@@ -498,22 +641,9 @@ void GPBFile::decomposeTransformAnimationChannel(Animation* animation, Animation
         float w = rotateKeyValues[i+3];
         if (ISZERO(x) && ISZERO(y) && ISZERO(z) && ISONE(w))
             ++oneCount;
-        else
-        {
-            LOG(4, "Rotation not identity: %u\n", i);
-            Quaternion q(x, y, z, w);
-            Vector3 axis;
-            float angle = q.toAxisAngle(&axis);
-            angle = 0;
-        }
-    }
-    if ((rotateKeyValues.size()>>2) == oneCount)
-    {
-        LOG(2, "    Discarding rotation channel.\n");
     }
-    else
+    if ((rotateKeyValues.size()>>2) != oneCount)
     {
-        LOG(3, "    Keeping rotation channel.\n");
         AnimationChannel* rotateChannel = new AnimationChannel();
         rotateChannel->setTargetId(channel->getTargetId());
         rotateChannel->setKeyTimes(channel->getKeyTimes());
@@ -523,18 +653,13 @@ void GPBFile::decomposeTransformAnimationChannel(Animation* animation, Animation
         rotateChannel->setTargetAttribute(Transform::ANIMATE_ROTATE);
         rotateChannel->setKeyValues(rotateKeyValues);
         rotateChannel->removeDuplicates();
-        animation->add(rotateChannel);
+        decomposed[1] = rotateChannel;
     }
 
     // Don't add the translation channel if all values are close to zero
     oneCount = (size_t)std::count_if(translateKeyValues.begin(), translateKeyValues.end(), isAlmostZero);
-    if (translateKeyValues.size() == oneCount)
+    if (translateKeyValues.size() != oneCount)
     {
-        LOG(2, "    Discarding translation channel.\n");
-    }
-    else
-    {
-        LOG(3, "    Keeping translation channel.\n");
         AnimationChannel* translateChannel = new AnimationChannel();
         translateChannel->setTargetId(channel->getTargetId());
         translateChannel->setKeyTimes(channel->getKeyTimes());
@@ -544,10 +669,30 @@ void GPBFile::decomposeTransformAnimationChannel(Animation* animation, Animation
         translateChannel->setTargetAttribute(Transform::ANIMATE_TRANSLATE);
         translateChannel->setKeyValues(translateKeyValues);
         translateChannel->removeDuplicates();
-        animation->add(translateChannel);
+        decomposed[2] = translateChannel;
+    }
+}
+
+void processMesh(void* meshData, int index)
+{
+    MeshProcessData* data = (MeshProcessData*)meshData;
+    Mesh* mesh = data->meshes[index];
+    if (data->optimize)
+    {
+        MeshOptimizer::optimize(mesh, data->optimizeOverdraw);
+    }
+    if (data->compress)
+    {
+        mesh->compressVertices(data->compressPositions);
     }
 }
 
+void decomposeChannel(void* channelData, int index)
+{
+    DecomposeChannelData* data = (DecomposeChannelData*)channelData;
+    decomposeTransformAnimationChannel(data->channels[index], &data->decomposed[index * 3]);
+}
+
 void GPBFile::moveAnimationChannels(Node* node, Animation* dstAnimation)
 {
     // Loop through the animations and channels backwards because they will be removed when found.
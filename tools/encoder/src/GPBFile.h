@@ -21,7 +21,7 @@ namespace gameplay
  * Increment the version number when making a change that break binary compatibility.
  * [0] is major, [1] is minor.
  */
-const unsigned char GPB_VERSION[2] = {1, 4};
+const unsigned char GPB_VERSION[2] = {1, 8};
 
 /**
  * The GamePlay Binary file class handles writing the GamePlay Binary file.
@@ -133,13 +133,9 @@ private:
     void optimizeAnimations();
 
     /**
-     * Decomposes an ANIMATE_SCALE_ROTATE_TRANSLATE channel into 3 new channels. (Scale, Rotate and Translate)
-     * 
-     * @param animation The animation that the channel belongs to.
-     * @param channel The animation channel to decompose.
-     * @param channelIndex Index of the channel.
+     * Generates the simplified level of detail meshes of all models, at the screen sizes given by the -lod option.
      */
-    void decomposeTransformAnimationChannel(Animation* animation, AnimationChannel* channel, int channelIndex);
+    void generateLods(const std::vector<float>& screenSizes);
 
     /**
      * Moves the animation channels that target the given node and its children to be under the given animation.
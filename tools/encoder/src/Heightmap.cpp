@@ -6,50 +6,61 @@
 namespace gameplay
 {
 
-// Number of threads to spawn for the heightmap generator
-#define THREAD_COUNT 8
+// The average number of triangles in each cell of the grid the rays are cast through.
+#define HEIGHTMAP_TRIANGLES_PER_CELL 4
+
+/**
+ * A uniform grid over the XZ plane that lists the triangles overlapping each of its cells, so that
+ * a vertical ray is only tested against the triangles of the cell it goes through.
+ */
+struct HeightmapGrid
+{
+    float minX;
+    float minZ;
+    float cellSizeX;
+    float cellSizeZ;
+    int columns;
+    int rows;
+    std::vector<float> triangles;           // The positions of the vertices of each triangle (9 floats per triangle).
+    std::vector<unsigned int> cellStarts;   // The first entry of each cell in cellTriangles (columns * rows + 1 entries).
+    std::vector<unsigned int> cellTriangles;
+
+    int getColumn(float x) const
+    {
+        return max(min((int)((x - minX) / cellSizeX), columns - 1), 0);
+    }
+
+    int getRow(float z) const
+    {
+        return max(min((int)((z - minZ) / cellSizeZ), rows - 1), 0);
+    }
+};
 
-// Thread data structure
-struct HeightmapThreadData
+// Data shared by the rows of a heightmap
+struct HeightmapRowData
 {
+    const HeightmapGrid* grid;          // [in]
     float rayHeight;                    // [in]
-    const Vector3* rayDirection;        // [in]
-    const std::vector<Mesh*>* meshes;   // [in]
-    const BoundingVolume* bounds;       // [in]
     float minX;                         // [in]
-    float maxX;                         // [in]
     float minZ;                         // [in]
-    float maxZ;                         // [in]
     float stepX;                        // [in]
     float stepZ;                        // [in]
-    float minHeight;                    // [out]
-    float maxHeight;                    // [out]
-    float* heights;                     // [in][out]
     int width;                          // [in]
-    int height;                         // [in]
-    int heightIndex;                    // [in]
+    float* heights;                     // [out]
+    float* rowMinHeights;               // [out]
+    float* rowMaxHeights;               // [out]
+    int* rowFailedRayCasts;             // [out]
 };
 
-// Globals used by thread
-int __processedHeightmapScanLines = 0;
-int __totalHeightmapScanlines = 0;
-int __failedRayCasts = 0;
-
 // Forward declarations
-int generateHeightmapChunk(void* threadData);
-bool intersect(const Vector3& rayOrigin, const Vector3& rayDirection, const Vector3& boxMin, const Vector3& boxMax, float* distance = NULL);
+static void buildGrid(const std::vector<Mesh*>& meshes, const BoundingVolume& bounds, int maxColumns, int maxRows, HeightmapGrid* grid);
+static void generateHeightmapRow(void* rowData, int row);
 int intersect_triangle(const float orig[3], const float dir[3], const float vert0[3], const float vert1[3], const float vert2[3], float *t, float *u, float *v);
-bool intersect(const Vector3& rayOrigin, const Vector3& rayDirection, const std::vector<Vertex>& vertices, const std::vector<MeshPart*>& parts, Vector3* point);
 
 void Heightmap::generate(const std::vector<std::string>& nodeIds, int width, int height, const char* filename, bool highP)
 {
     LOG(1, "Generating heightmap: %s...\n", filename);
 
-    // Initialize state variables
-    __processedHeightmapScanLines = 0;
-    __totalHeightmapScanlines = 0;
-    __failedRayCasts = 0;
-
     GPBFile* gpbFile = GPBFile::getInstance();
 
     // Lookup nodes in GPB file and compute a single bounding volume that encapsulates all meshes
@@ -91,79 +102,56 @@ void Heightmap::generate(const std::vector<std::string>& nodeIds, int width, int
         return;
     }
 
+    // Bin the triangles of the meshes into a grid, so that each ray is only tested against
+    // the few triangles below it.
+    HeightmapGrid grid;
+    buildGrid(meshes, bounds, width, height, &grid);
+
     // Shoot rays down from a point just above the max Y position of the mesh.
     // Compute ray-triangle intersection tests against the ray and this mesh to 
-    // generate heightmap data.
-    Vector3 rayOrigin(0, bounds.max.y + 10, 0);
-    Vector3 rayDirection(0, -1, 0);
-
-    float minX = bounds.min.x;
-    float maxX = bounds.max.x;
-    float minZ = bounds.min.z;
-    float maxZ = bounds.max.z;
+    // generate heightmap data. The rows are computed in parallel, on as many
+    // threads as there are processors.
     int size = width * height;
     float* heights = new float[size];
+    float* rowMinHeights = new float[height];
+    float* rowMaxHeights = new float[height];
+    int* rowFailedRayCasts = new int[height];
+
+    HeightmapRowData data;
+    data.grid = &grid;
+    data.rayHeight = bounds.max.y + 10;
+    data.minX = bounds.min.x;
+    data.minZ = bounds.min.z;
+    data.stepX = (bounds.max.x - bounds.min.x) / width;
+    data.stepZ = (bounds.max.z - bounds.min.z) / height;
+    data.width = width;
+    data.heights = heights;
+    data.rowMinHeights = rowMinHeights;
+    data.rowMaxHeights = rowMaxHeights;
+    data.rowFailedRayCasts = rowFailedRayCasts;
+    parallelFor(height, &generateHeightmapRow, &data, "\t");
+
+    // Update min/max height from all rows
     float minHeight = FLT_MAX;
     float maxHeight = -FLT_MAX;
-
-    __totalHeightmapScanlines = height;
-
-    // Determine # of threads to spawn
-    int threadCount = min(THREAD_COUNT, height);
-
-    // Split the work into separate threads to make max use of available cpu cores and speed up computation.
-    HeightmapThreadData* threadData = new HeightmapThreadData[threadCount];
-    THREAD_HANDLE* threads = new THREAD_HANDLE[threadCount];
-    int stepSize = height / threadCount;
-    for (int i = 0, remaining = height; i < threadCount; ++i, remaining -= stepSize)
-    {
-        HeightmapThreadData& data = threadData[i];
-        data.rayHeight = rayOrigin.y;
-        data.rayDirection = &rayDirection;
-        data.bounds = &bounds;
-        data.meshes = &meshes;
-        data.minX = minX;
-        data.maxX = maxX;
-        data.minZ = minZ + (stepSize * i);
-        data.maxZ = data.minZ + stepSize - 1;
-        if (i == threadCount - 1)
-            data.maxZ = maxZ;
-        data.stepX = (maxX - minX) / width;
-        data.stepZ = (maxZ - minZ) / height;
-        data.heights = heights;
-        data.width = width;
-        data.height = remaining > stepSize ? stepSize : remaining;
-        data.heightIndex = width * (stepSize * i);
-
-        // Start the processing thread
-        if (!createThread(&threads[i], &generateHeightmapChunk, &data))
-        {
-            LOG(1, "ERROR: Failed to spawn worker thread for generation of heightmap: %s\n", filename);
-            return;
-        }
-    }
-
-    // Wait for all threads to terminate
-    waitForThreads(threadCount, threads);
-
-    // Close all thread handles and free memory allocations.
-    for (int i = 0; i < threadCount; ++i)
-        closeThread(threads[i]);
-
-    // Update min/max height from all completed threads
-    for (int i = 0; i < threadCount; ++i)
+    int failedRayCasts = 0;
+    for (int i = 0; i < height; ++i)
     {
-        if (threadData[i].minHeight < minHeight)
-            minHeight = threadData[i].minHeight;
-        if (threadData[i].maxHeight > maxHeight)
-            maxHeight = threadData[i].maxHeight;
+        if (rowMinHeights[i] < minHeight)
+            minHeight = rowMinHeights[i];
+        if (rowMaxHeights[i] > maxHeight)
+            maxHeight = rowMaxHeights[i];
+        failedRayCasts += rowFailedRayCasts[i];
     }
+    delete[] rowMinHeights;
+    delete[] rowMaxHeights;
+    delete[] rowFailedRayCasts;
 
     LOG(1, "\r\tDone.\n");
 
-    if (__failedRayCasts)
+    if (failedRayCasts)
     {
-        LOG(2, "Warning: %d triangle intersections failed for heightmap: %s\n", __failedRayCasts, filename);
+        LOG(2, "Warning: %d triangle intersections failed for heightmap: %s\n", failedRayCasts, filename);
 
         // Go through and clamp any height values that are set to -FLT_MAX to the min recorded height value
         // (otherwise the range of height values will be far too large).
@@ -244,10 +232,6 @@ void Heightmap::generate(const std::vector<std::string>& nodeIds, int width, int
     LOG(1, "Saved heightmap: %s\n", filename);
 
 error:
-    if (threadData)
-        delete[] threadData;
-    if (threads)
-        delete[] threads;
     if (heights)
         delete[] heights;
     if (fp)
@@ -260,73 +244,139 @@ error:
         png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
 }
 
-int generateHeightmapChunk(void* threadData)
+static void buildGrid(const std::vector<Mesh*>& meshes, const BoundingVolume& bounds, int maxColumns, int maxRows, HeightmapGrid* grid)
 {
-    HeightmapThreadData* data = (HeightmapThreadData*)threadData;
+    // Gather the triangles of the meshes
+    for (unsigned int i = 0, meshCount = meshes.size(); i < meshCount; ++i)
+    {
+        const Mesh* mesh = meshes[i];
+        for (unsigned int j = 0, partCount = mesh->parts.size(); j < partCount; ++j)
+        {
+            MeshPart* part = mesh->parts[j];
+            for (unsigned int k = 0, indexCount = part->getIndicesCount(); k + 2 < indexCount; k += 3)
+            {
+                for (unsigned int v = 0; v < 3; ++v)
+                {
+                    const Vector3& position = mesh->vertices[part->getIndex(k + v)].position;
+                    grid->triangles.push_back(position.x);
+                    grid->triangles.push_back(position.y);
+                    grid->triangles.push_back(position.z);
+                }
+            }
+        }
+    }
+    unsigned int triangleCount = grid->triangles.size() / 9;
+
+    // Use square cells holding a few triangles on average, and no more cells than pixels.
+    float sizeX = max(bounds.max.x - bounds.min.x, (float)MATH_EPSILON);
+    float sizeZ = max(bounds.max.z - bounds.min.z, (float)MATH_EPSILON);
+    float cellSize = sqrtf(sizeX * sizeZ * HEIGHTMAP_TRIANGLES_PER_CELL / max(triangleCount, 1u));
+    grid->columns = max(min((int)(sizeX / cellSize), maxColumns), 1);
+    grid->rows = max(min((int)(sizeZ / cellSize), maxRows), 1);
+    grid->minX = bounds.min.x;
+    grid->minZ = bounds.min.z;
+    grid->cellSizeX = sizeX / grid->columns;
+    grid->cellSizeZ = sizeZ / grid->rows;
+
+    // Compute the range of cells overlapped by the 2D bounds of each triangle.
+    std::vector<int> ranges(triangleCount * 4);
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        const float* v = &grid->triangles[t * 9];
+        int* range = &ranges[t * 4];
+        range[0] = grid->getColumn(min(min(v[0], v[3]), v[6]));
+        range[1] = grid->getColumn(max(max(v[0], v[3]), v[6]));
+        range[2] = grid->getRow(min(min(v[2], v[5]), v[8]));
+        range[3] = grid->getRow(max(max(v[2], v[5]), v[8]));
+    }
 
-    Vector3 rayOrigin(0, data->rayHeight, 0);
-    const Vector3& rayDirection = *data->rayDirection;
-    const std::vector<Mesh*>& meshes = *data->meshes;
-    float* heights = data->heights;
+    // Count the triangles of each cell, then list them.
+    int cellCount = grid->columns * grid->rows;
+    grid->cellStarts.assign(cellCount + 1, 0);
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        const int* range = &ranges[t * 4];
+        for (int z = range[2]; z <= range[3]; ++z)
+        {
+            for (int x = range[0]; x <= range[1]; ++x)
+                ++grid->cellStarts[z * grid->columns + x + 1];
+        }
+    }
+    for (int i = 0; i < cellCount; ++i)
+        grid->cellStarts[i + 1] += grid->cellStarts[i];
 
-    Vector3 intersectionPoint;
+    grid->cellTriangles.resize(grid->cellStarts[cellCount]);
+    std::vector<unsigned int> cellEnds(grid->cellStarts.begin(), grid->cellStarts.end() - 1);
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        const int* range = &ranges[t * 4];
+        for (int z = range[2]; z <= range[3]; ++z)
+        {
+            for (int x = range[0]; x <= range[1]; ++x)
+                grid->cellTriangles[cellEnds[z * grid->columns + x]++] = t;
+        }
+    }
+}
+
+static void generateHeightmapRow(void* rowData, int row)
+{
+    const HeightmapRowData* data = (const HeightmapRowData*)rowData;
+    const HeightmapGrid& grid = *data->grid;
+
+    float orig[3] = { 0, data->rayHeight, data->minZ + data->stepZ * row };
+    const float dir[3] = { 0, -1, 0 };
+    int cellRow = grid.getRow(orig[2]);
+
+    float* heights = data->heights + row * data->width;
     float minHeight = FLT_MAX;
     float maxHeight = -FLT_MAX;
-    int index = data->heightIndex;
+    int failedRayCasts = 0;
 
-    int zi = 0;
-    for (float z = data->minZ; zi < data->height; z += data->stepZ, ++zi)
+    for (int x = 0; x < data->width; ++x)
     {
-        LOG(1, "\r\t%d%%", (int)(((float)__processedHeightmapScanLines / __totalHeightmapScanlines) * 100.0f));
-
-        rayOrigin.z = z;
+        orig[0] = data->minX + data->stepX * x;
+        int cell = cellRow * grid.columns + grid.getColumn(orig[0]);
 
-        int xi = 0;
-        for (float x = data->minX; xi < data->width; x += data->stepX, ++xi)
+        // Pick the nearest, and so highest, intersection below the ray origin
+        float minT = FLT_MAX;
+        for (unsigned int i = grid.cellStarts[cell], end = grid.cellStarts[cell + 1]; i < end; ++i)
         {
-            float h = -FLT_MAX;
-            rayOrigin.x = x;
+            const float* v0 = &grid.triangles[grid.cellTriangles[i] * 9];
+            const float* v1 = v0 + 3;
+            const float* v2 = v0 + 6;
 
-            for (unsigned int i = 0, count = meshes.size(); i < count; ++i)
-            {
-                // Pick the highest intersecting Y value of all meshes
-                Mesh* mesh = meshes[i];
-
-                // Perform a quick ray/bounding box test to quick-out
-                if (!intersect(rayOrigin, rayDirection, mesh->bounds.min, mesh->bounds.max))
-                    continue;
+            // Perform a quick check (in 2D) to determine if the point is definitely NOT in the triangle
+            if ((orig[0] < v0[0] && orig[0] < v1[0] && orig[0] < v2[0]) || (orig[0] > v0[0] && orig[0] > v1[0] && orig[0] > v2[0]) ||
+                (orig[2] < v0[2] && orig[2] < v1[2] && orig[2] < v2[2]) || (orig[2] > v0[2] && orig[2] > v1[2] && orig[2] > v2[2]))
+                continue;
 
-                // Compute the intersection point of ray with mesh
-                if (intersect(rayOrigin, rayDirection, mesh->vertices, mesh->parts, &intersectionPoint))
-                {
-                    if (intersectionPoint.y > h)
-                    {
-                        h = intersectionPoint.y;
-
-                        // Update min/max height values
-                        if (h < minHeight)
-                            minHeight = h;
-                        if (h > maxHeight)
-                            maxHeight = h;
-                    }
-                }
-            }
+            // Perform a full ray/traingle intersection test in 3D to get the intersection point
+            float t, u, v;
+            if (intersect_triangle(orig, dir, v0, v1, v2, &t, &u, &v) && t < minT)
+                minT = t;
+        }
 
-            // Update the glboal height array
-            heights[index++] = h;
+        float h = -FLT_MAX;
+        if (minT != FLT_MAX)
+        {
+            h = orig[1] - minT;
 
-            if (h == -FLT_MAX)
-                ++__failedRayCasts;
+            // Update min/max height values
+            if (h < minHeight)
+                minHeight = h;
+            if (h > maxHeight)
+                maxHeight = h;
         }
-
-        ++__processedHeightmapScanLines;
+        else
+        {
+            ++failedRayCasts;
+        }
+        heights[x] = h;
     }
 
-    // Update min/max height for this thread data
-    data->minHeight = minHeight;
-    data->maxHeight = maxHeight;
-
-    return 0;
+    data->rowMinHeights[row] = minHeight;
+    data->rowMaxHeights[row] = maxHeight;
+    data->rowFailedRayCasts[row] = failedRayCasts;
 }
 
 /////////////////////////////////////////////////////////////
@@ -393,154 +443,4 @@ int intersect_triangle(const float orig[3], const float dir[3], const float vert
    return 1;
 }
 
-// Performs an intersection test between a ray and the given mesh part and stores the result in "point".
-bool intersect(const Vector3& rayOrigin, const Vector3& rayDirection, const std::vector<Vertex>& vertices, const std::vector<MeshPart*>& parts, Vector3* point)
-{
-    const float* orig = &rayOrigin.x;
-    const float* dir = &rayDirection.x;
-
-    float minT = FLT_MAX;
-
-    for (unsigned int i = 0, partCount = parts.size(); i < partCount; ++i)
-    {
-        MeshPart* part = parts[i];
-
-        for (unsigned int j = 0, indexCount = part->getIndicesCount(); j < indexCount; j += 3)
-        {
-            const float* v0 = &vertices[part->getIndex( j )].position.x;
-            const float* v1 = &vertices[part->getIndex(j+1)].position.x;
-            const float* v2 = &vertices[part->getIndex(j+2)].position.x;
-
-            // Perform a quick check (in 2D) to determine if the point is definitely NOT in the triangle
-            float xmin, xmax, zmin, zmax;
-            xmin = v0[0] < v1[0] ? v0[0] : v1[0]; xmin = xmin < v2[0] ? xmin : v2[0];
-            xmax = v0[0] > v1[0] ? v0[0] : v1[0]; xmax = xmax > v2[0] ? xmax : v2[0];
-            zmin = v0[2] < v1[2] ? v0[2] : v1[2]; zmin = zmin < v2[2] ? zmin : v2[2];
-            zmax = v0[2] > v1[2] ? v0[2] : v1[2]; zmax = zmax > v2[2] ? zmax : v2[2];
-            if (orig[0] < xmin || orig[0] > xmax || orig[2] < zmin || orig[2] > zmax)
-                continue;
-
-            // Perform a full ray/traingle intersection test in 3D to get the intersection point
-            float t, u, v;
-            if (intersect_triangle(orig, dir, v0, v1, v2, &t, &u, &v))
-            {
-                // Found an intersection!
-                if (t < minT)
-                {
-                    minT = t;
-
-                    if (point)
-                    {
-                        Vector3 rd(rayDirection);
-                        rd.scale(t);
-                        Vector3::add(rayOrigin, rd, point);
-                    }
-                }
-                //return true;
-            }
-        }
-    }
-
-    return (minT != FLT_MAX);//false;
-}
-
-// Ray/Box intersection test.
-bool intersect(const Vector3& rayOrigin, const Vector3& rayDirection, const Vector3& boxMin, const Vector3& boxMax, float* distance)
-{
-    const Vector3& origin = rayOrigin;
-    const Vector3& direction = rayDirection;
-    const Vector3& min = boxMin;
-    const Vector3& max = boxMax;
-
-    // Intermediate calculation variables.
-    float dnear = 0.0f;
-    float dfar = 0.0f;
-    float tmin = 0.0f;
-    float tmax = 0.0f;
-
-    // X direction.
-    float div = 1.0f / direction.x;
-    if (div >= 0.0f)
-    {
-        tmin = (min.x - origin.x) * div;
-        tmax = (max.x - origin.x) * div;
-    }
-    else
-    {
-        tmin = (max.x - origin.x) * div;
-        tmax = (min.x - origin.x) * div;
-    }
-    dnear = tmin;
-    dfar = tmax;
-
-    // Check if the ray misses the box.
-    if (dnear > dfar || dfar < 0.0f)
-    {
-        return false;
-    }
-
-    // Y direction.
-    div = 1.0f / direction.y;
-    if (div >= 0.0f)
-    {
-        tmin = (min.y - origin.y) * div;
-        tmax = (max.y - origin.y) * div;
-    }
-    else
-    {
-        tmin = (max.y - origin.y) * div;
-        tmax = (min.y - origin.y) * div;
-    }
-
-    // Update the near and far intersection distances.
-    if (tmin > dnear)
-    {
-        dnear = tmin;
-    }
-    if (tmax < dfar)
-    {
-        dfar = tmax;
-    }
-    // Check if the ray misses the box.
-    if (dnear > dfar || dfar < 0.0f)
-    {
-        return false;
-    }
-
-    // Z direction.
-    div = 1.0f / direction.z;
-    if (div >= 0.0f)
-    {
-        tmin = (min.z - origin.z) * div;
-        tmax = (max.z - origin.z) * div;
-    }
-    else
-    {
-        tmin = (max.z - origin.z) * div;
-        tmax = (min.z - origin.z) * div;
-    }
-
-    // Update the near and far intersection distances.
-    if (tmin > dnear)
-    {
-        dnear = tmin;
-    }
-    if (tmax < dfar)
-    {
-        dfar = tmax;
-    }
-
-    // Check if the ray misses the box.
-    if (dnear > dfar || dfar < 0.0f)
-    {
-        return false;
-    }
-
-    // The ray intersects the box
-    if (distance)
-        *distance = dnear;
-
-    return true;
-}
-
 }
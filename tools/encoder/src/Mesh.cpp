@@ -1,6 +1,11 @@
 #include "Base.h"
 #include "Mesh.h"
 #include "Model.h"
+#include "MeshCompressor.h"
+#include "EncoderArguments.h"
+
+// Maximum number of grid cells along each axis when simplifying a mesh.
+#define MAX_SIMPLIFY_RESOLUTION 1024
 
 namespace gameplay
 {
@@ -32,21 +37,68 @@ void Mesh::writeBinary(FILE* file)
     {
         i->writeBinary(file);
     }
+    // encoding
+    std::vector<unsigned char> encodedVertices;
+    unsigned int vertexByteCount = 0;
+    bool compressed = EncoderArguments::getInstance()->compressMeshesEnabled() && compressVertexData(encodedVertices, &vertexByteCount);
+    write(compressed ? (unsigned int)ENCODING_COMPRESSED : (unsigned int)ENCODING_RAW, file);
     // vertices
-    writeBinaryVertices(file);
+    if (compressed)
+    {
+        write(vertexByteCount, file);
+        write((unsigned int)encodedVertices.size(), file);
+        fwrite(&encodedVertices[0], 1, encodedVertices.size(), file);
+        writeBinaryBounds(file);
+    }
+    else
+    {
+        writeBinaryVertices(file);
+    }
     // parts
-    writeBinaryObjects(parts, file);
+    write((unsigned int)parts.size(), file);
+    for (std::vector<MeshPart*>::const_iterator i = parts.begin(); i != parts.end(); ++i)
+    {
+        (*i)->writeBinary(file, compressed);
+    }
 }
 
 void Mesh::writeBinaryVertices(FILE* file)
 {
     if (vertices.size() > 0)
     {
-        // Assumes that all vertices are the same size.
-        // Write the number of bytes for the vertex data
-        const Vertex& vertex = vertices.front();
-        write((unsigned int)(vertices.size() * vertex.byteSize()), file); // (vertex count) * (vertex size)
+        // Write the number of bytes for the vertex data, then the vertices
+        write((unsigned int)(vertices.size() * getVertexSize()), file);
+        writeBinaryVertexData(file);
+    }
+    else
+    {
+        // No vertex data
+        writeZero(file);
+    }
+    writeBinaryBounds(file);
+}
 
+void Mesh::writeBinaryVertexData(FILE* file)
+{
+    bool packed = false;
+    for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        packed |= i->type != VertexElement::FLOAT;
+    }
+
+    if (packed)
+    {
+        // Write each element of each vertex in its type
+        for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+        {
+            for (std::vector<VertexElement>::const_iterator j = _vertexFormat.begin(); j != _vertexFormat.end(); ++j)
+            {
+                j->writeBinaryValues(getVertexValues(*i, j->usage), file);
+            }
+        }
+    }
+    else
+    {
         // for each vertex
         for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
         {
@@ -54,12 +106,57 @@ void Mesh::writeBinaryVertices(FILE* file)
             i->writeBinary(file);
         }
     }
-    else
+}
+
+bool Mesh::compressVertexData(std::vector<unsigned char>& encoded, unsigned int* byteCount)
+{
+    if (vertices.empty())
+        return false;
+
+    // Write the vertices to a temporary file to read back the bytes to compress.
+    FILE* buffer = tmpfile();
+    if (buffer == NULL)
     {
-        // No vertex data
-        writeZero(file);
+        LOG(1, "Warning: Failed to create a temporary file to compress mesh %s, writing it uncompressed.\n", getId().c_str());
+        return false;
+    }
+    writeBinaryVertexData(buffer);
+    std::vector<unsigned char> data((size_t)ftell(buffer));
+    rewind(buffer);
+    size_t n = fread(&data[0], 1, data.size(), buffer);
+    fclose(buffer);
+    unsigned int vertexSize = 0;
+    for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        vertexSize += i->byteSize();
+    }
+    if (n != data.size() || data.size() != vertices.size() * vertexSize)
+    {
+        LOG(1, "Warning: Failed to read back the vertices of mesh %s, writing it uncompressed.\n", getId().c_str());
+        return false;
+    }
+
+    // Tiny meshes don't shrink, so they are left uncompressed.
+    MeshCompressor::compressVertices(data, (unsigned int)vertices.size(), _vertexFormat, encoded);
+    *byteCount = (unsigned int)data.size();
+    return encoded.size() < data.size();
+}
+
+unsigned int Mesh::getVertexSize() const
+{
+    bool packed = false;
+    unsigned int vertexSize = 0;
+    for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        packed |= i->type != VertexElement::FLOAT;
+        vertexSize += i->byteSize();
     }
+    // Assumes that all vertices are the same size.
+    return packed || vertices.empty() ? vertexSize : vertices.front().byteSize();
+}
 
+void Mesh::writeBinaryBounds(FILE* file)
+{
     // Write bounds
     write(&bounds.min.x, 3, file);
     write(&bounds.max.x, 3, file);
@@ -230,4 +327,217 @@ void Mesh::computeBounds()
     bounds.radius = sqrt(bounds.radius);
 }
 
+const float* Mesh::getVertexValues(const Vertex& vertex, unsigned int usage)
+{
+    switch (usage)
+    {
+    case POSITION:
+        return &vertex.position.x;
+    case NORMAL:
+        return &vertex.normal.x;
+    case TANGENT:
+        return &vertex.tangent.x;
+    case BINORMAL:
+        return &vertex.binormal.x;
+    case COLOR:
+        return &vertex.diffuse.x;
+    case BLENDWEIGHTS:
+        return &vertex.blendWeights.x;
+    case BLENDINDICES:
+        return &vertex.blendIndices.x;
+    default:
+        assert(usage >= TEXCOORD0 && usage <= TEXCOORD7);
+        return &vertex.texCoord[usage - TEXCOORD0].x;
+    }
+}
+
+void Mesh::compressVertices(bool positions)
+{
+    // Blend indices only fit in bytes when there are fewer than 256 joints.
+    float maxJoint = 0.0f;
+    for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+    {
+        if (i->hasWeights)
+        {
+            maxJoint = std::max(maxJoint, std::max(std::max(i->blendIndices.x, i->blendIndices.y), std::max(i->blendIndices.z, i->blendIndices.w)));
+        }
+    }
+
+    for (std::vector<VertexElement>::iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        VertexElement& element = *i;
+        switch (element.usage)
+        {
+        case POSITION:
+            if (positions)
+            {
+                element.type = VertexElement::HALF_FLOAT;
+            }
+            break;
+        case NORMAL:
+        case TANGENT:
+        case BINORMAL:
+            element.type = VertexElement::INT_2_10_10_10_REV;
+            element.normalized = true;
+            element.size = 4;
+            break;
+        case COLOR:
+        case BLENDWEIGHTS:
+            element.type = VertexElement::UNSIGNED_BYTE;
+            element.normalized = true;
+            break;
+        case BLENDINDICES:
+            if (maxJoint < 256.0f)
+            {
+                element.type = VertexElement::UNSIGNED_BYTE;
+            }
+            break;
+        default:
+            if (element.usage >= TEXCOORD0 && element.usage <= TEXCOORD7)
+            {
+                element.type = VertexElement::HALF_FLOAT;
+            }
+            break;
+        }
+    }
+}
+
+Mesh* Mesh::simplify(unsigned int triangleCount) const
+{
+    if (vertices.empty() || parts.empty())
+        return NULL;
+
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+    {
+        min.x = std::min(min.x, i->position.x);
+        min.y = std::min(min.y, i->position.y);
+        min.z = std::min(min.z, i->position.z);
+        max.x = std::max(max.x, i->position.x);
+        max.y = std::max(max.y, i->position.y);
+        max.z = std::max(max.z, i->position.z);
+    }
+    float extent = std::max(max.x - min.x, std::max(max.y - min.y, max.z - min.z));
+    if (extent <= 0.0f)
+        return NULL;
+
+    // Find the finest grid whose clustered mesh fits in the triangle count.
+    std::vector<unsigned int> cells;
+    std::vector<unsigned int> bestCells;
+    unsigned int low = 1;
+    unsigned int high = MAX_SIMPLIFY_RESOLUTION;
+    while (low <= high)
+    {
+        unsigned int resolution = (low + high) / 2;
+        unsigned int count = clusterVertices(resolution, min, extent / resolution, &cells);
+        if (count > 0 && count <= triangleCount)
+        {
+            bestCells.swap(cells);
+            low = resolution + 1;
+        }
+        else if (count == 0)
+        {
+            low = resolution + 1;
+        }
+        else
+        {
+            high = resolution - 1;
+        }
+    }
+    if (bestCells.empty())
+        return NULL;
+
+    // Each cell is represented by its vertex closest to the average position of the cell's vertices.
+    std::map<unsigned int, std::pair<Vector3, unsigned int> > centers;
+    for (unsigned int i = 0, count = vertices.size(); i < count; ++i)
+    {
+        std::pair<Vector3, unsigned int>& center = centers[bestCells[i]];
+        center.first.add(vertices[i].position);
+        ++center.second;
+    }
+    std::map<unsigned int, unsigned int> representatives;
+    for (unsigned int i = 0, count = vertices.size(); i < count; ++i)
+    {
+        std::pair<Vector3, unsigned int>& center = centers[bestCells[i]];
+        Vector3 average = center.first;
+        average.scale(1.0f / center.second);
+        std::map<unsigned int, unsigned int>::iterator itr = representatives.find(bestCells[i]);
+        if (itr == representatives.end())
+        {
+            representatives[bestCells[i]] = i;
+        }
+        else if (vertices[i].position.distanceSquared(average) < vertices[itr->second].position.distanceSquared(average))
+        {
+            itr->second = i;
+        }
+    }
+
+    Mesh* mesh = new Mesh();
+    mesh->_vertexFormat = _vertexFormat;
+
+    // Keep the triangles whose corners are in three different cells.
+    std::map<unsigned int, unsigned int> indices;
+    for (std::vector<MeshPart*>::const_iterator i = parts.begin(); i != parts.end(); ++i)
+    {
+        MeshPart* part = *i;
+        MeshPart* simplifiedPart = new MeshPart();
+        for (unsigned int j = 0, count = part->getIndicesCount(); j + 2 < count; j += 3)
+        {
+            unsigned int a = bestCells[part->getIndex(j)];
+            unsigned int b = bestCells[part->getIndex(j + 1)];
+            unsigned int c = bestCells[part->getIndex(j + 2)];
+            if (a == b || b == c || a == c)
+                continue;
+
+            unsigned int cell[3] = { a, b, c };
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                std::map<unsigned int, unsigned int>::iterator itr = indices.find(cell[k]);
+                if (itr == indices.end())
+                {
+                    itr = indices.insert(std::make_pair(cell[k], (unsigned int)mesh->vertices.size())).first;
+                    mesh->vertices.push_back(vertices[representatives[cell[k]]]);
+                }
+                simplifiedPart->addIndex(itr->second);
+            }
+        }
+        mesh->addMeshPart(simplifiedPart);
+    }
+
+    return mesh;
+}
+
+unsigned int Mesh::clusterVertices(unsigned int resolution, const Vector3& min, float cellSize, std::vector<unsigned int>* cells) const
+{
+    cells->resize(vertices.size());
+    for (unsigned int i = 0, count = vertices.size(); i < count; ++i)
+    {
+        const Vector3& position = vertices[i].position;
+        unsigned int x = std::min((unsigned int)((position.x - min.x) / cellSize), resolution - 1);
+        unsigned int y = std::min((unsigned int)((position.y - min.y) / cellSize), resolution - 1);
+        unsigned int z = std::min((unsigned int)((position.z - min.z) / cellSize), resolution - 1);
+        (*cells)[i] = x + resolution * (y + resolution * z);
+    }
+
+    unsigned int triangleCount = 0;
+    for (std::vector<MeshPart*>::const_iterator i = parts.begin(); i != parts.end(); ++i)
+    {
+        MeshPart* part = *i;
+        unsigned int partTriangleCount = 0;
+        for (unsigned int j = 0, count = part->getIndicesCount(); j + 2 < count; j += 3)
+        {
+            unsigned int a = (*cells)[part->getIndex(j)];
+            unsigned int b = (*cells)[part->getIndex(j + 1)];
+            unsigned int c = (*cells)[part->getIndex(j + 2)];
+            if (a != b && b != c && a != c)
+                ++partTriangleCount;
+        }
+        if (partTriangleCount == 0)
+            return 0;
+        triangleCount += partTriangleCount;
+    }
+    return triangleCount;
+}
+
 }
@@ -31,6 +31,15 @@ public:
     virtual unsigned int getTypeId(void) const;
     virtual const char* getElementName(void) const;
 
+    /**
+     * The encodings of the vertex and index data of meshes.
+     */
+    enum Encoding
+    {
+        ENCODING_RAW = 0,
+        ENCODING_COMPRESSED = 1
+    };
+
     virtual void writeBinary(FILE* file);
     void writeBinaryVertices(FILE* file);
 
@@ -65,6 +74,27 @@ public:
 
     void computeBounds();
 
+    /**
+     * Creates a simplified copy of this mesh with at most the given number of triangles,
+     * by clustering the vertices on a grid. The copy has the same vertex format and
+     * mesh parts as this mesh.
+     *
+     * @param triangleCount The maximum number of triangles of the simplified mesh.
+     *
+     * @return The simplified mesh, or NULL if the mesh can't be simplified that much.
+     */
+    Mesh* simplify(unsigned int triangleCount) const;
+
+    /**
+     * Stores the vertex elements in compact types: normals, tangents and binormals as
+     * 10:10:10:2 signed normalized integers, texture coordinates as half floats, colors and
+     * blend weights as normalized bytes and blend indices as bytes (when there are fewer
+     * than 256 joints).
+     *
+     * @param positions True to also store positions as half floats.
+     */
+    void compressVertices(bool positions);
+
     Model* model;
     std::vector<Vertex> vertices;
     std::vector<MeshPart*> parts;
@@ -72,6 +102,38 @@ public:
     std::map<Vertex, unsigned int> vertexLookupTable;
 
 private:
+
+    /**
+     * Returns the float values of the vertex element with the given usage.
+     */
+    static const float* getVertexValues(const Vertex& vertex, unsigned int usage);
+
+    /**
+     * Writes the vertices in the vertex format, without their byte count.
+     */
+    void writeBinaryVertexData(FILE* file);
+
+    /**
+     * Writes the bounds of the mesh.
+     */
+    void writeBinaryBounds(FILE* file);
+
+    /**
+     * Compresses the vertices with MeshCompressor, returning false if they could not be compressed.
+     */
+    bool compressVertexData(std::vector<unsigned char>& encoded, unsigned int* byteCount);
+
+    /**
+     * Returns the size of a vertex in bytes.
+     */
+    unsigned int getVertexSize() const;
+
+    /**
+     * Computes the grid cell of each vertex for a grid with the given number of cells along each axis
+     * and returns the number of triangles that don't collapse, or 0 if all the triangles of a mesh part collapse.
+     */
+    unsigned int clusterVertices(unsigned int resolution, const Vector3& min, float cellSize, std::vector<unsigned int>* cells) const;
+
     std::vector<VertexElement> _vertexFormat;
 
 };
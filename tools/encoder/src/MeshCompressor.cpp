@@ -0,0 +1,160 @@
+#include "Base.h"
+#include "MeshCompressor.h"
+
+// Number of vertices and indices in the independently decoded blocks, which must match the runtime.
+#define VERTEX_BLOCK_SIZE 4096
+#define INDEX_BLOCK_SIZE 16384
+
+namespace gameplay
+{
+
+/**
+ * Appends a little endian unsigned int.
+ */
+static void append(unsigned int value, std::vector<unsigned char>& output)
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        output.push_back((unsigned char)(value >> (i * 8)));
+    }
+}
+
+/**
+ * Overwrites the size of the block that starts at the given offset, once its data has been appended.
+ */
+static void endBlock(size_t start, std::vector<unsigned char>& output)
+{
+    unsigned int size = (unsigned int)(output.size() - start - 4);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        output[start + i] = (unsigned char)(size >> (i * 8));
+    }
+}
+
+void MeshCompressor::compressVertices(const std::vector<unsigned char>& vertices, unsigned int vertexCount,
+                                      const std::vector<VertexElement>& vertexFormat, std::vector<unsigned char>& output)
+{
+    // Split each vertex in components of 1, 2 or 4 bytes.
+    std::vector<unsigned int> componentSizes;
+    unsigned int vertexSize = 0;
+    for (std::vector<VertexElement>::const_iterator i = vertexFormat.begin(); i != vertexFormat.end(); ++i)
+    {
+        unsigned int componentSize = i->type == VertexElement::UNSIGNED_BYTE ? 1 : (i->type == VertexElement::HALF_FLOAT ? 2 : 4);
+        componentSizes.insert(componentSizes.end(), i->byteSize() / componentSize, componentSize);
+        vertexSize += i->byteSize();
+    }
+    assert(vertices.size() >= (size_t)vertexCount * vertexSize);
+
+    std::vector<unsigned char> planes;
+    for (unsigned int first = 0; first < vertexCount; first += VERTEX_BLOCK_SIZE)
+    {
+        unsigned int count = std::min(vertexCount - first, (unsigned int)VERTEX_BLOCK_SIZE);
+        planes.assign((size_t)vertexSize * count, 0);
+
+        // Transpose the zigzag encoded differences from the previous vertex of the block into byte planes.
+        unsigned int offset = 0;
+        for (size_t c = 0; c < componentSizes.size(); ++c)
+        {
+            unsigned int size = componentSizes[c];
+            unsigned int mask = size == 4 ? 0xFFFFFFFFu : (1u << (size * 8)) - 1;
+            unsigned int previous = 0;
+            for (unsigned int v = 0; v < count; ++v)
+            {
+                const unsigned char* src = &vertices[(size_t)(first + v) * vertexSize + offset];
+                unsigned int value = 0;
+                for (unsigned int b = 0; b < size; ++b)
+                {
+                    value |= (unsigned int)src[b] << (b * 8);
+                }
+                unsigned int delta = (value - previous) & mask;
+                unsigned int zigzag = ((delta << 1) ^ (0u - (delta >> (size * 8 - 1)))) & mask;
+                for (unsigned int b = 0; b < size; ++b)
+                {
+                    planes[(size_t)(offset + b) * count + v] = (unsigned char)(zigzag >> (b * 8));
+                }
+                previous = value;
+            }
+            offset += size;
+        }
+
+        size_t start = output.size();
+        append(0, output);
+        for (unsigned int i = 0; i < vertexSize; ++i)
+        {
+            packBytePlane(&planes[(size_t)i * count], count, output);
+        }
+        endBlock(start, output);
+    }
+}
+
+void MeshCompressor::compressIndices(const std::vector<unsigned int>& indices, std::vector<unsigned char>& output)
+{
+    unsigned int indexCount = (unsigned int)indices.size();
+    for (unsigned int first = 0; first < indexCount; first += INDEX_BLOCK_SIZE)
+    {
+        unsigned int count = std::min(indexCount - first, (unsigned int)INDEX_BLOCK_SIZE);
+        size_t start = output.size();
+        append(0, output);
+        unsigned int previous = 0;
+        for (unsigned int i = first; i < first + count; ++i)
+        {
+            unsigned int delta = indices[i] - previous;
+            unsigned int zigzag = (delta << 1) ^ (0u - (delta >> 31));
+            while (zigzag >= 0x80)
+            {
+                output.push_back((unsigned char)(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            output.push_back((unsigned char)zigzag);
+            previous = indices[i];
+        }
+        endBlock(start, output);
+    }
+}
+
+void MeshCompressor::packBytePlane(const unsigned char* plane, unsigned int count, std::vector<unsigned char>& output)
+{
+    for (unsigned int i = 0; i < count; i += 64)
+    {
+        size_t header = output.size();
+        output.push_back(0);
+        unsigned int shift = 0;
+        for (unsigned int group = i; group < count && group < i + 64; group += 16, shift += 2)
+        {
+            // Use the fewest bits that hold every byte of the group.
+            unsigned int n = std::min(count - group, 16u);
+            unsigned char maximum = 0;
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                maximum = std::max(maximum, plane[group + j]);
+            }
+            unsigned int mode = maximum == 0 ? 0 : (maximum < 4 ? 1 : (maximum < 16 ? 2 : 3));
+            output[header] |= (unsigned char)(mode << shift);
+
+            unsigned char packed[16] = { 0 };
+            switch (mode)
+            {
+            case 1:
+                for (unsigned int j = 0; j < n; ++j)
+                {
+                    packed[j >> 2] |= (unsigned char)(plane[group + j] << ((j & 3) * 2));
+                }
+                output.insert(output.end(), packed, packed + 4);
+                break;
+            case 2:
+                for (unsigned int j = 0; j < n; ++j)
+                {
+                    packed[j >> 1] |= (unsigned char)(plane[group + j] << ((j & 1) * 4));
+                }
+                output.insert(output.end(), packed, packed + 8);
+                break;
+            case 3:
+                memcpy(packed, plane + group, n);
+                output.insert(output.end(), packed, packed + 16);
+                break;
+            }
+        }
+    }
+}
+
+}
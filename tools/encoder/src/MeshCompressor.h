@@ -0,0 +1,63 @@
+#ifndef MESHCOMPRESSOR_H_
+#define MESHCOMPRESSOR_H_
+
+#include "VertexElement.h"
+
+namespace gameplay
+{
+
+/**
+ * Compresses the vertices and indices of meshes for bundles, in an encoding that the runtime decodes
+ * in a single pass at load time.
+ *
+ * Vertices and indices are split into blocks that are decoded independently, so the runtime can decode
+ * the blocks of large meshes on its worker threads. Each block is written as its size in bytes followed
+ * by its data:
+ * - A block of vertices holds the differences between the components of consecutive vertices, zigzag
+ *   encoded in the size of the component (1 byte for bytes, 2 for half floats and 4 otherwise). The
+ *   differences are transposed into one plane per byte of a vertex, and each plane is packed in groups
+ *   of 16 bytes of 0, 2, 4 or 8 bits, with the sizes of four groups in a header byte before them. The
+ *   high bytes of components that change slowly from one vertex to the next are mostly zero, so they
+ *   pack into very little, while the values themselves are preserved exactly.
+ * - A block of indices holds the zigzag encoded differences between consecutive indices in LEB128,
+ *   which takes one byte for most indices of meshes optimized for the vertex cache.
+ */
+class MeshCompressor
+{
+public:
+
+    /**
+     * Compresses vertex data.
+     *
+     * @param vertices The vertex data, as written to an uncompressed bundle.
+     * @param vertexCount The number of vertices.
+     * @param vertexFormat The format of the vertices.
+     * @param output The vector to append the compressed data to.
+     */
+    static void compressVertices(const std::vector<unsigned char>& vertices, unsigned int vertexCount,
+                                 const std::vector<VertexElement>& vertexFormat, std::vector<unsigned char>& output);
+
+    /**
+     * Compresses indices.
+     *
+     * @param indices The indices.
+     * @param output The vector to append the compressed data to.
+     */
+    static void compressIndices(const std::vector<unsigned int>& indices, std::vector<unsigned char>& output);
+
+private:
+
+    /**
+     * Packs a byte plane of a vertex block.
+     */
+    static void packBytePlane(const unsigned char* plane, unsigned int count, std::vector<unsigned char>& output);
+
+    /**
+     * Hidden constructor.
+     */
+    MeshCompressor();
+};
+
+}
+
+#endif
@@ -0,0 +1,379 @@
+#include "Base.h"
+#include "MeshOptimizer.h"
+
+// Size of the vertex cache modeled by the triangle reordering.
+#define VERTEX_CACHE_SIZE 32
+
+// Size of the FIFO vertex cache simulated to measure the cache efficiency and find cluster boundaries.
+#define FIFO_CACHE_SIZE 16
+
+namespace gameplay
+{
+
+/**
+ * Returns the score of a vertex from its position in the modeled LRU cache (or -1 if it is not
+ * in the cache) and the number of triangles that still use it.
+ */
+static float computeVertexScore(int cachePosition, unsigned int valence)
+{
+    if (valence == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score so that the next triangle
+        // doesn't simply reuse the same edge, which makes strips less efficient.
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = pow(1.0f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Favor vertices with few remaining triangles, to finish them off and avoid isolated triangles.
+    return score + 2.0f * pow((float)valence, -0.5f);
+}
+
+MeshOptimizer::MeshOptimizer()
+{
+}
+
+void MeshOptimizer::optimize(Mesh* mesh, bool overdraw)
+{
+    assert(mesh);
+    if (mesh->parts.empty() || mesh->vertices.empty())
+        return;
+
+    unsigned int vertexCount = mesh->getVertexCount();
+    std::vector<std::vector<unsigned int> > partIndices(mesh->parts.size());
+    for (unsigned int i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        MeshPart* part = mesh->parts[i];
+        std::vector<unsigned int>& indices = partIndices[i];
+        indices.resize(part->getIndicesCount());
+        for (unsigned int j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            indices[j] = part->getIndex(j);
+        }
+
+        float before = computeCacheMissRatio(indices, vertexCount);
+        optimizeVertexCache(indices, vertexCount);
+        if (overdraw)
+        {
+            optimizeOverdraw(indices, mesh->vertices);
+        }
+        LOG(2, "Optimized mesh part %u of mesh '%s': ACMR %.3f -> %.3f\n", i, mesh->getId().c_str(), before, computeCacheMissRatio(indices, vertexCount));
+    }
+
+    optimizeVertexFetch(mesh, partIndices);
+}
+
+float MeshOptimizer::computeCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+
+    // A vertex is in the cache if fewer than FIFO_CACHE_SIZE vertices were loaded since it was.
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = FIFO_CACHE_SIZE + 1;
+    unsigned int misses = 0;
+    for (unsigned int i = 0; i < triangleCount * 3; ++i)
+    {
+        unsigned int vertex = indices[i];
+        if (time - timestamps[vertex] > FIFO_CACHE_SIZE)
+        {
+            timestamps[vertex] = time++;
+            ++misses;
+        }
+    }
+    return (float)misses / triangleCount;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Build the list of triangles that use each vertex.
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int i = 0; i < triangleCount * 3; ++i)
+    {
+        ++offsets[indices[i] + 1];
+    }
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<unsigned int> valences(vertexCount, 0);
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    for (unsigned int i = 0; i < triangleCount * 3; ++i)
+    {
+        unsigned int vertex = indices[i];
+        adjacency[offsets[vertex] + valences[vertex]++] = i / 3;
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        vertexScores[i] = computeVertexScore(-1, valences[i]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        const unsigned int* triangle = &indices[i * 3];
+        triangleScores[i] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+        if (triangleScores[i] > triangleScores[best])
+            best = i;
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    unsigned int cache[VERTEX_CACHE_SIZE + 3];
+    unsigned int cacheSize = 0;
+    unsigned int cursor = 0;
+    while (best >= 0)
+    {
+        // Emit the best triangle and remove it from the triangle lists of its vertices.
+        emitted[best] = true;
+        const unsigned int* triangle = &indices[best * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            unsigned int vertex = triangle[i];
+            unsigned int* triangles = &adjacency[offsets[vertex]];
+            for (unsigned int j = 0; j < valences[vertex]; ++j)
+            {
+                if (triangles[j] == (unsigned int)best)
+                {
+                    triangles[j] = triangles[valences[vertex] - 1];
+                    break;
+                }
+            }
+            --valences[vertex];
+        }
+
+        // Move the vertices of the triangle to the front of the cache.
+        unsigned int newCache[VERTEX_CACHE_SIZE + 3];
+        unsigned int newCacheSize = 0;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (std::find(newCache, newCache + newCacheSize, triangle[i]) == newCache + newCacheSize)
+                newCache[newCacheSize++] = triangle[i];
+        }
+        for (unsigned int i = 0; i < cacheSize; ++i)
+        {
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                newCache[newCacheSize++] = cache[i];
+        }
+
+        // Update the scores of the vertices whose cache position changed (including the ones
+        // pushed out of the cache) and of their remaining triangles.
+        for (unsigned int i = 0; i < newCacheSize; ++i)
+        {
+            unsigned int vertex = newCache[i];
+            int position = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+            cachePositions[vertex] = position;
+            float score = computeVertexScore(position, valences[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            const unsigned int* triangles = &adjacency[offsets[vertex]];
+            for (unsigned int j = 0; j < valences[vertex]; ++j)
+            {
+                triangleScores[triangles[j]] += delta;
+            }
+        }
+        cacheSize = std::min(newCacheSize, (unsigned int)VERTEX_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheSize, cache);
+
+        // The next triangle is the best one using a cached vertex.
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int i = 0; i < cacheSize; ++i)
+        {
+            unsigned int vertex = cache[i];
+            const unsigned int* triangles = &adjacency[offsets[vertex]];
+            for (unsigned int j = 0; j < valences[vertex]; ++j)
+            {
+                if (triangleScores[triangles[j]] > bestScore)
+                {
+                    best = triangles[j];
+                    bestScore = triangleScores[best];
+                }
+            }
+        }
+
+        // When no cached vertex has triangles left, continue with the next triangle in input order.
+        if (best < 0)
+        {
+            while (cursor < triangleCount && emitted[cursor])
+                ++cursor;
+            best = cursor < triangleCount ? (int)cursor : -1;
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // A new cluster starts wherever all the vertices of a triangle miss the cache, so the
+    // clusters can be reordered without hurting the vertex cache efficiency much.
+    std::vector<unsigned int> clusterStarts;
+    std::vector<unsigned int> timestamps(vertices.size(), 0);
+    unsigned int time = FIFO_CACHE_SIZE + 1;
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        unsigned int misses = 0;
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            unsigned int vertex = indices[i * 3 + j];
+            if (time - timestamps[vertex] > FIFO_CACHE_SIZE)
+            {
+                timestamps[vertex] = time++;
+                ++misses;
+            }
+        }
+        if (i == 0 || misses == 3)
+            clusterStarts.push_back(i);
+    }
+    clusterStarts.push_back(triangleCount);
+    unsigned int clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    // Compute the area weighted center and normal of the mesh part and of each cluster.
+    std::vector<Vector3> centers(clusterCount);
+    std::vector<Vector3> normals(clusterCount);
+    Vector3 meshCenter;
+    float meshArea = 0.0f;
+    for (unsigned int i = 0; i < clusterCount; ++i)
+    {
+        float clusterArea = 0.0f;
+        for (unsigned int j = clusterStarts[i]; j < clusterStarts[i + 1]; ++j)
+        {
+            const Vector3& p0 = vertices[indices[j * 3]].position;
+            const Vector3& p1 = vertices[indices[j * 3 + 1]].position;
+            const Vector3& p2 = vertices[indices[j * 3 + 2]].position;
+            Vector3 edge1, edge2, normal;
+            Vector3::subtract(p1, p0, &edge1);
+            Vector3::subtract(p2, p0, &edge2);
+            Vector3::cross(edge1, edge2, &normal);
+            float area = normal.length() * 0.5f;
+
+            Vector3 center(p0);
+            center.add(p1);
+            center.add(p2);
+            center.scale(area / 3.0f);
+            centers[i].add(center);
+            normals[i].add(normal);
+            clusterArea += area;
+        }
+        meshCenter.add(centers[i]);
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f)
+            centers[i].scale(1.0f / clusterArea);
+    }
+    if (meshArea > 0.0f)
+        meshCenter.scale(1.0f / meshArea);
+
+    // Clusters facing away from the center are most likely to occlude the rest of the mesh.
+    std::vector<std::pair<float, unsigned int> > order(clusterCount);
+    for (unsigned int i = 0; i < clusterCount; ++i)
+    {
+        Vector3 direction;
+        Vector3::subtract(centers[i], meshCenter, &direction);
+        if (normals[i].lengthSquared() > 0.0f)
+            normals[i].normalize();
+        order[i].first = -Vector3::dot(direction, normals[i]);
+        order[i].second = i;
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int i = 0; i < clusterCount; ++i)
+    {
+        unsigned int cluster = order[i].second;
+        result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+    }
+    result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh* mesh, std::vector<std::vector<unsigned int> >& partIndices)
+{
+    unsigned int vertexCount = mesh->getVertexCount();
+
+    // Number the vertices of the mesh parts with the fewest vertices first, so that as many
+    // mesh parts as possible only use the vertices that 16-bit indices can address.
+    std::vector<unsigned int> marks(vertexCount, 0);
+    std::vector<std::pair<unsigned int, unsigned int> > parts(partIndices.size());
+    for (unsigned int i = 0, count = partIndices.size(); i < count; ++i)
+    {
+        unsigned int partVertexCount = 0;
+        for (unsigned int j = 0, indexCount = partIndices[i].size(); j < indexCount; ++j)
+        {
+            unsigned int vertex = partIndices[i][j];
+            if (marks[vertex] != i + 1)
+            {
+                marks[vertex] = i + 1;
+                ++partVertexCount;
+            }
+        }
+        parts[i] = std::make_pair(partVertexCount, i);
+    }
+    std::stable_sort(parts.begin(), parts.end());
+
+    const unsigned int unused = (unsigned int)-1;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    unsigned int next = 0;
+    for (unsigned int i = 0, count = parts.size(); i < count; ++i)
+    {
+        std::vector<unsigned int>& indices = partIndices[parts[i].second];
+        for (unsigned int j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            if (remap[indices[j]] == unused)
+                remap[indices[j]] = next++;
+        }
+    }
+
+    // Vertices that no mesh part uses are kept at the end.
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        if (remap[i] == unused)
+            remap[i] = next++;
+    }
+
+    std::vector<Vertex> vertices(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        vertices[remap[i]] = mesh->vertices[i];
+    }
+    mesh->vertices.swap(vertices);
+    mesh->vertexLookupTable.clear();
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        mesh->vertexLookupTable[mesh->vertices[i]] = i;
+    }
+
+    for (unsigned int i = 0, count = partIndices.size(); i < count; ++i)
+    {
+        std::vector<unsigned int>& indices = partIndices[i];
+        for (unsigned int j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            indices[j] = remap[indices[j]];
+        }
+        mesh->parts[i]->setIndices(indices);
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef MESHOPTIMIZER_H_
+#define MESHOPTIMIZER_H_
+
+#include "Mesh.h"
+
+namespace gameplay
+{
+
+/**
+ * Reorders the triangles and vertices of meshes so that they are drawn faster by the GPU.
+ */
+class MeshOptimizer
+{
+public:
+
+    /**
+     * Optimizes the specified mesh.
+     *
+     * The triangles of each mesh part are reordered to make the best use of the post-transform
+     * vertex cache, then the vertices are reordered in the order the mesh parts use them, so
+     * that vertex fetches are mostly sequential and mesh parts whose vertices all fit in the
+     * first 65536 vertices use 16-bit indices. Mesh parts with the fewest vertices are given
+     * the lowest vertex indices.
+     *
+     * @param mesh The mesh to optimize.
+     * @param overdraw True to also sort clusters of triangles to reduce overdraw.
+     */
+    static void optimize(Mesh* mesh, bool overdraw);
+
+    /**
+     * Returns the average number of vertices transformed per triangle (ACMR) when drawing
+     * the specified indices, simulating a FIFO post-transform vertex cache.
+     *
+     * @param indices The triangle list indices.
+     * @param vertexCount The number of vertices referenced by the indices.
+     *
+     * @return The average cache miss ratio, between 0.5 (ideal) and 3.
+     */
+    static float computeCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+private:
+
+    /**
+     * Reorders triangles for the vertex cache (Tom Forsyth's linear-speed vertex cache optimization).
+     */
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+    /**
+     * Splits the cache optimized triangles into clusters where the cache is restarted and sorts the
+     * clusters so that the ones facing away from the center of the mesh are drawn first.
+     */
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+    /**
+     * Renumbers the vertices of the mesh in the order they are first used by the mesh parts.
+     */
+    static void optimizeVertexFetch(Mesh* mesh, std::vector<std::vector<unsigned int> >& partIndices);
+
+    /**
+     * Hidden constructor.
+     */
+    MeshOptimizer();
+};
+
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "MeshPart.h"
+#include "MeshCompressor.h"
 
 namespace gameplay
 {
@@ -25,6 +26,11 @@ const char* MeshPart::getElementName(void) const
 }
 
 void MeshPart::writeBinary(FILE* file)
+{
+    writeBinary(file, false);
+}
+
+void MeshPart::writeBinary(FILE* file, bool compressed)
 {
     Object::writeBinary(file);
 
@@ -33,6 +39,18 @@ void MeshPart::writeBinary(FILE* file)
 
     // write the number of bytes
     write(indicesByteSize(), file);
+    if (compressed)
+    {
+        // write the number of compressed bytes, then the compressed indices
+        std::vector<unsigned char> encoded;
+        MeshCompressor::compressIndices(_indices, encoded);
+        write((unsigned int)encoded.size(), file);
+        if (!encoded.empty())
+        {
+            fwrite(&encoded[0], 1, encoded.size(), file);
+        }
+        return;
+    }
     // for each index
     for (std::vector<unsigned int>::const_iterator i = _indices.begin(); i != _indices.end(); ++i)
     {
@@ -86,6 +104,17 @@ unsigned int MeshPart::getIndex(unsigned int i) const
     return _indices[i];
 }
 
+void MeshPart::setIndices(const std::vector<unsigned int>& indices)
+{
+    _indexFormat = INDEX16;
+    _indices.clear();
+    _indices.reserve(indices.size());
+    for (std::vector<unsigned int>::const_iterator i = indices.begin(); i != indices.end(); ++i)
+    {
+        addIndex(*i);
+    }
+}
+
 void MeshPart::writeBinaryIndex(unsigned int index, FILE* file)
 {
     switch (_indexFormat)
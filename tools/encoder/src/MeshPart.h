@@ -42,6 +42,11 @@ public:
     virtual void writeBinary(FILE* file);
     virtual void writeText(FILE* file);
 
+    /**
+     * Writes the mesh part to the binary file stream, compressing the indices if the mesh is compressed.
+     */
+    void writeBinary(FILE* file, bool compressed);
+
     /**
      * Adds an index to the list of indices.
      */
@@ -62,6 +67,11 @@ public:
      */
     unsigned int getIndex(unsigned int i) const;
 
+    /**
+     * Replaces the list of indices, recomputing the index format.
+     */
+    void setIndices(const std::vector<unsigned int>& indices);
+
 private:
 
     /**
@@ -72,6 +72,13 @@ void Model::writeBinary(FILE* file)
             }
         }
     }
+    // Write the list of level of detail meshes and their screen sizes
+    write((unsigned int)_lods.size(), file);
+    for (unsigned int i = 0; i < _lods.size(); ++i)
+    {
+        _lods[i].first->writeBinaryXref(file);
+        write(_lods[i].second, file);
+    }
 }
 
 void Model::writeText(FILE* file)
@@ -98,6 +105,11 @@ void Model::writeText(FILE* file)
             fprintfElement(file, "material", mat->getId().c_str());
         }
     }
+    for (unsigned int i = 0; i < _lods.size(); ++i)
+    {
+        fprintfElement(file, "lod", _lods[i].first->getId());
+        fprintfElement(file, "lodScreenSize", _lods[i].second);
+    }
     fprintElementEnd(file);
 }
 
@@ -136,6 +148,16 @@ void Model::setSkin(MeshSkin* skin)
     }
 }
 
+void Model::addLod(Mesh* mesh, float screenSize)
+{
+    _lods.push_back(std::make_pair(mesh, screenSize));
+}
+
+unsigned int Model::getLodCount() const
+{
+    return (unsigned int)_lods.size();
+}
+
 void Model::setMaterial(Material* material, int partIndex)
 {
     if (partIndex < 0)
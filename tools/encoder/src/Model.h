@@ -34,12 +34,23 @@ public:
     void setSkin(MeshSkin* skin);
     void setMaterial(Material* material, int partIndex = -1);
 
+    /**
+     * Adds a lower level of detail mesh, drawn when the model is smaller on screen than the given size in pixels.
+     */
+    void addLod(Mesh* mesh, float screenSize);
+
+    /**
+     * Returns the number of lower level of detail meshes of this model.
+     */
+    unsigned int getLodCount() const;
+
 private:
 
     Mesh* _mesh;
     MeshSkin* _meshSkin;
     std::vector<Material*> _materials;
     Material* _material;
+    std::vector<std::pair<Mesh*, float> > _lods;
 };
 
 }
@@ -0,0 +1,177 @@
+#include "Base.h"
+#include "NavMesh.h"
+#include "GPBFile.h"
+
+namespace gameplay
+{
+
+// Vertices closer than this are merged so that triangles from different mesh parts connect.
+#define NAVMESH_WELD_DISTANCE 0.001f
+
+// Neighbor index written for triangle edges on the border of the navigation mesh.
+#define NAVMESH_NO_NEIGHBOR 0xFFFFFFFF
+
+NavMesh::NavMesh(void)
+{
+}
+
+NavMesh::~NavMesh(void)
+{
+}
+
+unsigned int NavMesh::getTypeId(void) const
+{
+    return NAVMESH_ID;
+}
+
+const char* NavMesh::getElementName(void) const
+{
+    return "NavMesh";
+}
+
+void NavMesh::writeBinary(FILE* file)
+{
+    Object::writeBinary(file);
+    write(_vertices, file);
+    write(_indices, file);
+    write(_neighbors, file);
+}
+
+void NavMesh::writeText(FILE* file)
+{
+    fprintElementStart(file);
+    fprintfElement(file, "%f ", "vertices", _vertices);
+    fprintfElement(file, "%u ", "indices", _indices);
+    fprintfElement(file, "%d ", "neighbors", _neighbors);
+    fprintElementEnd(file);
+}
+
+void NavMesh::generate(const std::vector<std::string>& nodeIds, const char* id, float maxSlope)
+{
+    LOG(1, "Generating navigation mesh: %s...\n", id);
+
+    GPBFile* gpbFile = GPBFile::getInstance();
+    if (gpbFile->idExists(id))
+    {
+        LOG(1, "WARNING: Skipping generation of navigation mesh '%s'. The id is already used.\n", id);
+        return;
+    }
+
+    NavMesh* navMesh = new NavMesh();
+    navMesh->setId(id);
+
+    float minNormalY = cos(MATH_DEG_TO_RAD(maxSlope));
+    unsigned int triangleCount = 0;
+    for (unsigned int i = 0, count = nodeIds.size(); i < count; ++i)
+    {
+        Node* node = gpbFile->getNode(nodeIds[i].c_str());
+        if (node == NULL)
+        {
+            LOG(1, "WARNING: Failed to locate node for navigation mesh argument: %s\n", nodeIds[i].c_str());
+            continue;
+        }
+        Mesh* mesh = node->getModel() ? node->getModel()->getMesh() : NULL;
+        if (mesh == NULL)
+        {
+            LOG(1, "WARNING: Node passed to navigation mesh argument does not have a mesh: %s\n", nodeIds[i].c_str());
+            continue;
+        }
+
+        const Matrix& world = node->getWorldMatrix();
+        for (unsigned int j = 0, partCount = mesh->parts.size(); j < partCount; ++j)
+        {
+            MeshPart* part = mesh->parts[j];
+            for (unsigned int k = 0, indexCount = part->getIndicesCount(); k + 2 < indexCount; k += 3)
+            {
+                ++triangleCount;
+
+                Vector3 v[3];
+                for (unsigned int l = 0; l < 3; ++l)
+                {
+                    world.transformPoint(mesh->vertices[part->getIndex(k + l)].position, &v[l]);
+                }
+
+                // Leave out the triangles too steep to walk on, whichever way they are wound.
+                Vector3 normal;
+                Vector3::cross(v[1] - v[0], v[2] - v[0], &normal);
+                float length = normal.length();
+                if (length > 0.0f && fabs(normal.y) / length >= minNormalY)
+                {
+                    navMesh->addTriangle(v[0], v[1], v[2]);
+                }
+            }
+        }
+    }
+
+    if (navMesh->_indices.empty())
+    {
+        LOG(1, "WARNING: Skipping generation of navigation mesh '%s'. No walkable triangles found.\n", id);
+        delete navMesh;
+        return;
+    }
+
+    navMesh->computeNeighbors();
+    navMesh->_vertexLookup.clear();
+    LOG(2, "Navigation mesh '%s' has %u walkable triangles out of %u.\n", id, (unsigned int)(navMesh->_indices.size() / 3), triangleCount);
+
+    gpbFile->addToRefTable(navMesh);
+    gpbFile->add(navMesh);
+}
+
+void NavMesh::addTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2)
+{
+    unsigned int i0 = addVertex(v0);
+    unsigned int i1 = addVertex(v1);
+    unsigned int i2 = addVertex(v2);
+
+    // Skip the triangles that collapse once their vertices are merged.
+    if (i0 == i1 || i1 == i2 || i2 == i0)
+        return;
+
+    _indices.push_back(i0);
+    _indices.push_back(i1);
+    _indices.push_back(i2);
+}
+
+unsigned int NavMesh::addVertex(const Vector3& position)
+{
+    std::pair<std::pair<int, int>, int> key(std::make_pair((int)floor(position.x / NAVMESH_WELD_DISTANCE + 0.5f),
+                                                           (int)floor(position.y / NAVMESH_WELD_DISTANCE + 0.5f)),
+                                            (int)floor(position.z / NAVMESH_WELD_DISTANCE + 0.5f));
+    std::map<std::pair<std::pair<int, int>, int>, unsigned int>::iterator itr = _vertexLookup.find(key);
+    if (itr != _vertexLookup.end())
+        return itr->second;
+
+    unsigned int index = (unsigned int)(_vertices.size() / 3);
+    _vertices.push_back(position.x);
+    _vertices.push_back(position.y);
+    _vertices.push_back(position.z);
+    _vertexLookup[key] = index;
+    return index;
+}
+
+void NavMesh::computeNeighbors()
+{
+    _neighbors.assign(_indices.size(), NAVMESH_NO_NEIGHBOR);
+
+    // Match each edge with the other triangle using the same pair of vertices.
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edges;
+    for (unsigned int i = 0, count = _indices.size(); i < count; ++i)
+    {
+        unsigned int a = _indices[i];
+        unsigned int b = _indices[(i % 3) == 2 ? i - 2 : i + 1];
+        std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator itr = edges.find(key);
+        if (itr == edges.end())
+        {
+            edges[key] = i;
+        }
+        else if (_neighbors[itr->second] == NAVMESH_NO_NEIGHBOR)
+        {
+            _neighbors[itr->second] = i / 3;
+            _neighbors[i] = itr->second / 3;
+        }
+    }
+}
+
+}
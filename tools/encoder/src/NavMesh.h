@@ -0,0 +1,69 @@
+#ifndef NAVMESH_H_
+#define NAVMESH_H_
+
+#include "Object.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+/**
+ * A navigation mesh built from the walkable triangles of the meshes of a set of nodes.
+ */
+class NavMesh : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    NavMesh(void);
+
+    /**
+     * Destructor.
+     */
+    virtual ~NavMesh(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+
+    /**
+     * Generates a navigation mesh from the meshes of the specified nodes and adds it to the GPB file.
+     *
+     * The triangles are transformed to world space, the vertices shared by triangles are merged
+     * and triangles steeper than maxSlope are left out.
+     *
+     * @param nodeIds List of node ids to include in the navigation mesh.
+     * @param id The id of the navigation mesh.
+     * @param maxSlope The maximum slope of a walkable triangle, in degrees.
+     */
+    static void generate(const std::vector<std::string>& nodeIds, const char* id, float maxSlope = 45.0f);
+
+private:
+
+    /**
+     * Adds a walkable triangle, merging its vertices with the existing ones.
+     */
+    void addTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2);
+
+    /**
+     * Returns the index of a vertex at the specified position, adding it if there isn't one.
+     */
+    unsigned int addVertex(const Vector3& position);
+
+    /**
+     * Computes the triangles adjacent to each triangle edge.
+     */
+    void computeNeighbors();
+
+    std::vector<float> _vertices;
+    std::vector<unsigned int> _indices;
+    std::vector<unsigned int> _neighbors;
+    std::map<std::pair<std::pair<int, int>, int>, unsigned int> _vertexLookup;
+};
+
+}
+
+#endif
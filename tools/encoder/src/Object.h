@@ -31,6 +31,8 @@ public:
         MESH_ID = 34,
         MESHPART_ID = 35,
         MESHSKIN_ID = 36,
+        NAVMESH_ID = 40,
+        VISIBILITYSET_ID = 41,
         FONT_ID = 128,
     };
 
@@ -4,6 +4,36 @@
 namespace gameplay
 {
 
+/**
+ * Returns the FNV-1a hash of a string, which the runtime binary searches the reference table by.
+ */
+static unsigned int hashString(const std::string& str)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0, length = str.length(); i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * A reference and the hash of its xref, in the order the references are written.
+ */
+struct HashedReference
+{
+    unsigned int hash;
+    const std::string* xref;
+    Reference* ref;
+
+    bool operator<(const HashedReference& r) const
+    {
+        if (hash != r.hash)
+            return hash < r.hash;
+        return *xref < *r.xref;
+    }
+};
+
 ReferenceTable::ReferenceTable(void)
 {
 }
@@ -30,10 +60,23 @@ Object* ReferenceTable::get(const std::string& xref)
 
 void ReferenceTable::writeBinary(FILE* file)
 {
-    write((unsigned int)_table.size(), file);
-    for ( std::map<std::string, Reference>::iterator i=_table.begin() ; i != _table.end(); ++i)
+    // Write the references sorted by the hash of their xrefs, so that the runtime can binary search them.
+    std::vector<HashedReference> refs;
+    refs.reserve(_table.size());
+    for (std::map<std::string, Reference>::iterator i = _table.begin(); i != _table.end(); ++i)
+    {
+        HashedReference ref;
+        ref.hash = hashString(i->first);
+        ref.xref = &i->first;
+        ref.ref = &i->second;
+        refs.push_back(ref);
+    }
+    std::sort(refs.begin(), refs.end());
+
+    write((unsigned int)refs.size(), file);
+    for (std::vector<HashedReference>::iterator i = refs.begin(); i != refs.end(); ++i)
     {
-        i->second.writeBinary(file);
+        i->ref->writeBinary(file);
     }
 }
 
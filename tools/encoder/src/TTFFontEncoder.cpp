@@ -157,6 +157,9 @@ int writeFont(const char* inFilePath, const char* outFilePath, std::vector<unsig
 
     std::vector<FontData*> fonts;
 
+    // Distance fields need enough space around each glyph that neighbouring glyphs do not bleed into its field.
+    const int glyphPadding = fontFormat == Font::DISTANCE_FIELD ? DISTANCE_FIELD_PADDING : GLYPH_PADDING;
+
     for (size_t fontIndex = 0, count = fontSizes.size(); fontIndex < count; ++fontIndex)
     {
         unsigned int fontSize = fontSizes[fontIndex];
@@ -230,7 +233,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, std::vector<unsig
         }
 
         // Include padding in the rowSize.
-        rowSize += GLYPH_PADDING;
+        rowSize += glyphPadding;
 
         // Initialize with padding.
         int penX = 0;
@@ -267,7 +270,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, std::vector<unsig
                 int glyphWidth = slot->bitmap.pitch;
                 int glyphHeight = slot->bitmap.rows;
 
-                advance = glyphWidth + GLYPH_PADDING; 
+                advance = glyphWidth + glyphPadding; 
 
                 // If we reach the end of the image wrap aroud to the next row.
                 if ((penX + advance) > (int)imageWidth)
@@ -334,7 +337,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, std::vector<unsig
             int glyphWidth = slot->bitmap.pitch;
             int glyphHeight = slot->bitmap.rows;
 
-            advance = glyphWidth + GLYPH_PADDING;
+            advance = glyphWidth + glyphPadding;
 
             // If we reach the end of the image wrap aroud to the next row.
             if ((penX + advance) > (int)imageWidth)
@@ -360,13 +363,13 @@ int writeFont(const char* inFilePath, const char* outFilePath, std::vector<unsig
             penY = row * rowSize;
 
             glyphArray[i].index = ascii;
-            glyphArray[i].width = advance - GLYPH_PADDING;
+            glyphArray[i].width = advance - glyphPadding;
 
             // Generate UV coords.
             glyphArray[i].uvCoords[0] = (float)penX / (float)imageWidth;
             glyphArray[i].uvCoords[1] = (float)penY / (float)imageHeight;
-            glyphArray[i].uvCoords[2] = (float)(penX + advance - GLYPH_PADDING) / (float)imageWidth;
-            glyphArray[i].uvCoords[3] = (float)(penY + rowSize - GLYPH_PADDING) / (float)imageHeight;
+            glyphArray[i].uvCoords[2] = (float)(penX + advance - glyphPadding) / (float)imageWidth;
+            glyphArray[i].uvCoords[3] = (float)(penY + rowSize - glyphPadding) / (float)imageHeight;
 
             // Set the pen position for the next glyph
             penX += advance;
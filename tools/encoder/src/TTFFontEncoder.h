@@ -5,6 +5,7 @@
 #define START_INDEX     32
 #define END_INDEX       127
 #define GLYPH_PADDING   4
+#define DISTANCE_FIELD_PADDING 8    // covers the 8 pixel spread of the distance fields
 
 namespace gameplay
 {
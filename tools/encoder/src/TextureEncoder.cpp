@@ -0,0 +1,294 @@
+#include "Base.h"
+#include "TextureEncoder.h"
+#include "Image.h"
+#include "FileIO.h"
+
+// The GL enums written in the KTX header.
+#define KTX_GL_UNSIGNED_BYTE 0x1401
+#define KTX_GL_RGB 0x1907
+#define KTX_GL_RGBA 0x1908
+
+// The number of lobes of the Lanczos filter.
+#define LANCZOS_RADIUS 3.0f
+
+namespace gameplay
+{
+
+/**
+ * The texels a filtered texel is made of, along one axis.
+ */
+struct FilterTap
+{
+    unsigned int first;
+    std::vector<float> weights;
+};
+
+static float lanczos(float x)
+{
+    x = fabs(x);
+    if (x < 1.0e-5f)
+        return 1.0f;
+    if (x >= LANCZOS_RADIUS)
+        return 0.0f;
+    float px = MATH_PI * x;
+    return LANCZOS_RADIUS * sin(px) * sin(px / LANCZOS_RADIUS) / (px * px);
+}
+
+/**
+ * Computes the taps that resample a row of srcSize texels to dstSize texels, clamping at the edges.
+ */
+static void computeTaps(unsigned int srcSize, unsigned int dstSize, std::vector<FilterTap>* taps)
+{
+    // The filter is widened when minifying, so that every source texel contributes.
+    float scale = (float)srcSize / (float)dstSize;
+    float width = std::max(scale, 1.0f);
+    float support = LANCZOS_RADIUS * width;
+
+    taps->resize(dstSize);
+    for (unsigned int i = 0; i < dstSize; ++i)
+    {
+        float center = (i + 0.5f) * scale;
+        int first = (int)floor(center - support);
+        int last = (int)ceil(center + support);
+        FilterTap& tap = (*taps)[i];
+        tap.first = (unsigned int)std::max(first, 0);
+        tap.weights.assign(std::min(last, (int)srcSize - 1) - (int)tap.first + 1, 0.0f);
+
+        // Texels past the edges add their weight to the edge texels.
+        float total = 0.0f;
+        for (int j = first; j <= last; ++j)
+        {
+            float weight = lanczos((j + 0.5f - center) / width);
+            int index = std::min(std::max(j, 0), (int)srcSize - 1) - (int)tap.first;
+            tap.weights[index] += weight;
+            total += weight;
+        }
+        for (size_t j = 0; j < tap.weights.size(); ++j)
+        {
+            tap.weights[j] /= total;
+        }
+    }
+}
+
+/**
+ * Resamples an image of premultiplied linear RGBA texels with a separable Lanczos filter.
+ */
+static void resample(const std::vector<float>& src, unsigned int srcWidth, unsigned int srcHeight,
+                     std::vector<float>* dst, unsigned int dstWidth, unsigned int dstHeight)
+{
+    std::vector<FilterTap> taps;
+
+    // Filter the rows, then the columns.
+    std::vector<float> rows(dstWidth * srcHeight * 4, 0.0f);
+    computeTaps(srcWidth, dstWidth, &taps);
+    for (unsigned int y = 0; y < srcHeight; ++y)
+    {
+        for (unsigned int x = 0; x < dstWidth; ++x)
+        {
+            const FilterTap& tap = taps[x];
+            float* out = &rows[(y * dstWidth + x) * 4];
+            for (size_t i = 0; i < tap.weights.size(); ++i)
+            {
+                const float* in = &src[(y * srcWidth + tap.first + i) * 4];
+                for (unsigned int c = 0; c < 4; ++c)
+                    out[c] += in[c] * tap.weights[i];
+            }
+        }
+    }
+
+    dst->assign(dstWidth * dstHeight * 4, 0.0f);
+    computeTaps(srcHeight, dstHeight, &taps);
+    for (unsigned int y = 0; y < dstHeight; ++y)
+    {
+        const FilterTap& tap = taps[y];
+        for (unsigned int x = 0; x < dstWidth; ++x)
+        {
+            float* out = &(*dst)[(y * dstWidth + x) * 4];
+            for (size_t i = 0; i < tap.weights.size(); ++i)
+            {
+                const float* in = &rows[((tap.first + i) * dstWidth + x) * 4];
+                for (unsigned int c = 0; c < 4; ++c)
+                    out[c] += in[c] * tap.weights[i];
+            }
+        }
+    }
+}
+
+static float srgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static unsigned int nearestPowerOfTwo(unsigned int size)
+{
+    unsigned int lower = 1;
+    while (lower * 2 <= size)
+        lower *= 2;
+    return (size - lower) <= (lower * 2 - size) ? lower : lower * 2;
+}
+
+TextureEncoder::TextureEncoder(const char* inputFile, const char* outputFile, unsigned int maxSize, bool powerOfTwo, bool mipmaps)
+    : _inputFile(inputFile), _outputFile(outputFile), _maxSize(maxSize), _powerOfTwo(powerOfTwo), _mipmaps(mipmaps)
+{
+}
+
+TextureEncoder::~TextureEncoder()
+{
+}
+
+void TextureEncoder::getBaseSize(unsigned int width, unsigned int height, unsigned int* baseWidth, unsigned int* baseHeight) const
+{
+    // Clamp the larger side to the maximum size, keeping the aspect ratio.
+    if (_maxSize > 0 && std::max(width, height) > _maxSize)
+    {
+        float scale = (float)_maxSize / (float)std::max(width, height);
+        width = std::max((unsigned int)(width * scale + 0.5f), 1u);
+        height = std::max((unsigned int)(height * scale + 0.5f), 1u);
+    }
+    if (_powerOfTwo)
+    {
+        width = nearestPowerOfTwo(width);
+        height = nearestPowerOfTwo(height);
+        while (_maxSize > 0 && std::max(width, height) > _maxSize && std::max(width, height) > 1)
+        {
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+    }
+    *baseWidth = width;
+    *baseHeight = height;
+}
+
+bool TextureEncoder::write()
+{
+    Image* image = Image::create(_inputFile.c_str());
+    if (image == NULL)
+    {
+        LOG(1, "Error: Failed to load image: %s\n", _inputFile.c_str());
+        return false;
+    }
+    unsigned int width = image->getWidth();
+    unsigned int height = image->getHeight();
+    unsigned int bpp = image->getBpp();
+    bool alpha = image->getFormat() == Image::RGBA;
+    const unsigned char* data = (const unsigned char*)image->getData();
+
+    // Convert the texels to premultiplied linear RGBA, so that filtering blends them as light and coverage.
+    float linear[256];
+    for (unsigned int i = 0; i < 256; ++i)
+    {
+        linear[i] = srgbToLinear(i / 255.0f);
+    }
+    std::vector<float> texels(width * height * 4);
+    for (unsigned int i = 0, count = width * height; i < count; ++i)
+    {
+        const unsigned char* in = data + i * bpp;
+        float a = alpha ? in[3] / 255.0f : 1.0f;
+        texels[i * 4 + 0] = linear[in[0]] * a;
+        texels[i * 4 + 1] = linear[in[bpp >= 3 ? 1 : 0]] * a;
+        texels[i * 4 + 2] = linear[in[bpp >= 3 ? 2 : 0]] * a;
+        texels[i * 4 + 3] = a;
+    }
+    delete image;
+
+    unsigned int levelWidth, levelHeight;
+    getBaseSize(width, height, &levelWidth, &levelHeight);
+    if (levelWidth != width || levelHeight != height)
+    {
+        std::vector<float> resized;
+        resample(texels, width, height, &resized, levelWidth, levelHeight);
+        texels.swap(resized);
+        LOG(2, "Resized %s from %ux%u to %ux%u.\n", _inputFile.c_str(), width, height, levelWidth, levelHeight);
+    }
+
+    unsigned int levelCount = 1;
+    if (_mipmaps)
+    {
+        for (unsigned int size = std::max(levelWidth, levelHeight); size > 1; size /= 2)
+            ++levelCount;
+    }
+
+    FILE* file = fopen(_outputFile.c_str(), "wb");
+    if (file == NULL)
+    {
+        LOG(1, "Error: Failed to open file: %s\n", _outputFile.c_str());
+        return false;
+    }
+
+    // Write the KTX header of an uncompressed 2D texture without key/value data.
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    unsigned int format = alpha ? KTX_GL_RGBA : KTX_GL_RGB;
+    unsigned int channels = alpha ? 4 : 3;
+    fwrite(identifier, 1, sizeof(identifier), file);
+    gameplay::write((unsigned int)0x04030201, file);
+    gameplay::write((unsigned int)KTX_GL_UNSIGNED_BYTE, file);
+    gameplay::write((unsigned int)1, file);
+    gameplay::write(format, file);
+    gameplay::write(format, file);
+    gameplay::write(format, file);
+    gameplay::write(levelWidth, file);
+    gameplay::write(levelHeight, file);
+    gameplay::write((unsigned int)0, file);
+    gameplay::write((unsigned int)0, file);
+    gameplay::write((unsigned int)1, file);
+    gameplay::write(levelCount, file);
+    gameplay::write((unsigned int)0, file);
+
+    // Each level is filtered from the previous one, and stored with its rows padded to 4 bytes.
+    unsigned int totalSize = 0;
+    std::vector<unsigned char> pixels;
+    for (unsigned int level = 0; level < levelCount; ++level)
+    {
+        if (level > 0)
+        {
+            unsigned int nextWidth = std::max(levelWidth / 2, 1u);
+            unsigned int nextHeight = std::max(levelHeight / 2, 1u);
+            std::vector<float> next;
+            resample(texels, levelWidth, levelHeight, &next, nextWidth, nextHeight);
+            texels.swap(next);
+            levelWidth = nextWidth;
+            levelHeight = nextHeight;
+        }
+
+        unsigned int stride = (levelWidth * channels + 3) & ~3u;
+        pixels.assign(stride * levelHeight, 0);
+        for (unsigned int y = 0; y < levelHeight; ++y)
+        {
+            for (unsigned int x = 0; x < levelWidth; ++x)
+            {
+                const float* in = &texels[(y * levelWidth + x) * 4];
+                unsigned char* out = &pixels[y * stride + x * channels];
+                float a = std::min(std::max(in[3], 0.0f), 1.0f);
+                for (unsigned int c = 0; c < 3; ++c)
+                {
+                    float value = a > 0.0f ? in[c] / a : 0.0f;
+                    value = linearToSrgb(std::min(std::max(value, 0.0f), 1.0f));
+                    out[c] = (unsigned char)(value * 255.0f + 0.5f);
+                }
+                if (alpha)
+                    out[3] = (unsigned char)(a * 255.0f + 0.5f);
+            }
+        }
+        gameplay::write((unsigned int)pixels.size(), file);
+        fwrite(&pixels[0], 1, pixels.size(), file);
+        totalSize += (unsigned int)pixels.size();
+    }
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        LOG(1, "Error: Failed to write file: %s\n", _outputFile.c_str());
+        return false;
+    }
+
+    LOG(1, "Wrote %u levels (%u bytes) to: %s\n", levelCount, totalSize, _outputFile.c_str());
+    return true;
+}
+
+}
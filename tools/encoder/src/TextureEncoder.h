@@ -0,0 +1,64 @@
+#ifndef TEXTUREENCODER_H_
+#define TEXTUREENCODER_H_
+
+namespace gameplay
+{
+
+class Image;
+
+/**
+ * Encodes a PNG image into a KTX texture holding its whole mipmap chain, which the runtime
+ * uploads level by level with glTexImage2D instead of generating the mipmaps at load time.
+ *
+ * The image can first be resized to powers of two and clamped to a maximum size, so that the
+ * textures of a platform with less memory can be encoded from the same sources (with a batch
+ * manifest per platform). Resizing and each smaller mipmap level use a Lanczos filter in
+ * linear space, weighted by alpha so that transparent texels do not bleed their color.
+ *
+ * Grayscale images are stored as RGB, since the runtime has no luminance format. Rows are
+ * padded to 4 bytes, as the KTX format requires for uncompressed data.
+ */
+class TextureEncoder
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param inputFile The PNG image to encode.
+     * @param outputFile The KTX file to write.
+     * @param maxSize The largest width and height of the texture, or 0 for no limit.
+     * @param powerOfTwo true to resize the image to the nearest powers of two.
+     * @param mipmaps true to store the mipmap chain, false to store the base level only.
+     */
+    TextureEncoder(const char* inputFile, const char* outputFile, unsigned int maxSize, bool powerOfTwo, bool mipmaps);
+    ~TextureEncoder();
+
+    /**
+     * Writes the texture.
+     *
+     * @return true if successful.
+     */
+    bool write();
+
+private:
+
+    // Hidden copy/assignment
+    TextureEncoder(const TextureEncoder&);
+    TextureEncoder& operator=(const TextureEncoder&);
+
+    /**
+     * Computes the size of the base level of the texture of an image of the given size.
+     */
+    void getBaseSize(unsigned int width, unsigned int height, unsigned int* baseWidth, unsigned int* baseHeight) const;
+
+    std::string _inputFile;
+    std::string _outputFile;
+    unsigned int _maxSize;
+    bool _powerOfTwo;
+    bool _mipmaps;
+};
+
+}
+
+#endif
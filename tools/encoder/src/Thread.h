@@ -16,7 +16,7 @@ namespace gameplay
         void* arg;
     };
 
-    DWORD WINAPI WindowsThreadProc(LPVOID lpParam)
+    static DWORD WINAPI WindowsThreadProc(LPVOID lpParam)
     {
         WindowsThreadData* data = (WindowsThreadData*)lpParam;
         int(*threadFunction)(void*) = data->threadFunction;
@@ -45,9 +45,39 @@ namespace gameplay
         CloseHandle(thread);
     }
 
+    typedef CRITICAL_SECTION MUTEX_HANDLE;
+
+    static void createMutex(MUTEX_HANDLE* mutex)
+    {
+        InitializeCriticalSection(mutex);
+    }
+
+    static void lockMutex(MUTEX_HANDLE* mutex)
+    {
+        EnterCriticalSection(mutex);
+    }
+
+    static void unlockMutex(MUTEX_HANDLE* mutex)
+    {
+        LeaveCriticalSection(mutex);
+    }
+
+    static void destroyMutex(MUTEX_HANDLE* mutex)
+    {
+        DeleteCriticalSection(mutex);
+    }
+
+    static unsigned int getProcessorCount()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (unsigned int)info.dwNumberOfProcessors : 1;
+    }
+
 #else
 
     #include <pthread.h>
+    #include <unistd.h>
 
     typedef pthread_t THREAD_HANDLE;
 
@@ -57,7 +87,7 @@ namespace gameplay
         void* arg;
     };
 
-    void* PThreadProc(void* threadData)
+    static void* PThreadProc(void* threadData)
     {
         PThreadData* data = (PThreadData*)threadData;
         int(*threadFunction)(void*) = data->threadFunction;
@@ -92,8 +122,122 @@ namespace gameplay
         // nothing to do... waitForThreads (which calls join) cleans up
     }
 
+    typedef pthread_mutex_t MUTEX_HANDLE;
+
+    static void createMutex(MUTEX_HANDLE* mutex)
+    {
+        pthread_mutex_init(mutex, NULL);
+    }
+
+    static void lockMutex(MUTEX_HANDLE* mutex)
+    {
+        pthread_mutex_lock(mutex);
+    }
+
+    static void unlockMutex(MUTEX_HANDLE* mutex)
+    {
+        pthread_mutex_unlock(mutex);
+    }
+
+    static void destroyMutex(MUTEX_HANDLE* mutex)
+    {
+        pthread_mutex_destroy(mutex);
+    }
+
+    static unsigned int getProcessorCount()
+    {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (unsigned int)count : 1;
+    }
+
 #endif
 
+    struct ParallelForData
+    {
+        void(*function)(void*, int);
+        void* arg;
+        int count;
+        int next;
+        int finished;
+        int percent;
+        const char* label;
+        MUTEX_HANDLE mutex;
+    };
+
+    static int ParallelForProc(void* threadData)
+    {
+        ParallelForData* data = (ParallelForData*)threadData;
+        while (true)
+        {
+            lockMutex(&data->mutex);
+            int index = data->next++;
+            unlockMutex(&data->mutex);
+            if (index >= data->count)
+                break;
+
+            data->function(data->arg, index);
+
+            lockMutex(&data->mutex);
+            int percent = (int)((++data->finished * 100.0) / data->count);
+            if (data->label && percent != data->percent)
+            {
+                data->percent = percent;
+                LOG(1, "\r%s%d%%", data->label, percent);
+            }
+            unlockMutex(&data->mutex);
+        }
+        return 0;
+    }
+
+    /**
+     * Calls a function for every index from 0 to count - 1, on as many threads as there are processors.
+     *
+     * The indices are handed out one at a time in order, so each call should do a fair amount of work,
+     * such as a row of an image. The calls must not depend on each other.
+     *
+     * @param count The number of indices.
+     * @param function The function called with arg and each index.
+     * @param arg The first argument of the function.
+     * @param progressLabel The text printed ahead of the percentage of indices done, or NULL.
+     */
+    static void parallelFor(int count, void(*function)(void*, int), void* arg, const char* progressLabel = NULL)
+    {
+        if (count <= 0)
+            return;
+
+        ParallelForData data;
+        data.function = function;
+        data.arg = arg;
+        data.count = count;
+        data.next = 0;
+        data.finished = 0;
+        data.percent = -1;
+        data.label = progressLabel;
+        createMutex(&data.mutex);
+
+        int threadCount = min((int)getProcessorCount(), count);
+        std::vector<THREAD_HANDLE> threads(threadCount);
+        int started = 0;
+        for (; started < threadCount; ++started)
+        {
+            if (!createThread(&threads[started], &ParallelForProc, &data))
+                break;
+        }
+
+        // Do the work on this thread when no thread could be started.
+        if (started == 0)
+        {
+            ParallelForProc(&data);
+        }
+        else
+        {
+            waitForThreads(started, &threads[0]);
+            for (int i = 0; i < started; ++i)
+                closeThread(threads[i]);
+        }
+        destroyMutex(&data.mutex);
+    }
+
 }
 
 #endif
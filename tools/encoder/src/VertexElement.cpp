@@ -6,7 +6,9 @@ namespace gameplay
 
 VertexElement::VertexElement(unsigned int t, unsigned int c) :
     usage(t),
-    size(c)
+    size(c),
+    type(FLOAT),
+    normalized(false)
 {
 }
 
@@ -23,12 +25,16 @@ void VertexElement::writeBinary(FILE* file)
     Object::writeBinary(file);
     write(usage, file);
     write(size, file);
+    write((unsigned int)type, file);
+    write(normalized, file);
 }
 void VertexElement::writeText(FILE* file)
 {
     fprintElementStart(file);
     fprintfElement(file, "usage", usageStr(usage));
     fprintfElement(file, "size", size);
+    fprintfElement(file, "type", (unsigned int)type);
+    fprintfElement(file, "normalized", (unsigned int)normalized);
     fprintElementEnd(file);
 }
 
@@ -73,4 +79,101 @@ const char* VertexElement::usageStr(unsigned int usage)
     }
 }
 
+unsigned int VertexElement::byteSize() const
+{
+    switch (type)
+    {
+    case HALF_FLOAT:
+        return (size * 2 + 3) & ~3;
+    case UNSIGNED_BYTE:
+        return (size + 3) & ~3;
+    case INT_2_10_10_10_REV:
+        return 4;
+    default:
+        return size * sizeof(float);
+    }
+}
+
+/**
+ * Converts a float to a half float, rounding to the nearest value.
+ */
+static unsigned short floatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    unsigned int mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31)
+    {
+        // Too large (or infinity/NaN): clamp to infinity, keeping NaNs.
+        return sign | 0x7C00 | (((bits & 0x7F800000) == 0x7F800000 && mantissa) ? 0x200 : 0);
+    }
+    if (exponent <= 0)
+    {
+        // Denormal or zero.
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        unsigned int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            ++half;
+        return sign | (unsigned short)half;
+    }
+
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        ++half; // Rounding can carry into the exponent, which is still correct.
+    return sign | (unsigned short)std::min(half, 0x7C00u);
+}
+
+void VertexElement::writeBinaryValues(const float* values, FILE* file) const
+{
+    switch (type)
+    {
+    case HALF_FLOAT:
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            write(floatToHalf(values[i]), file);
+        }
+        if (size & 1)
+        {
+            write((unsigned short)0, file);
+        }
+        break;
+    case UNSIGNED_BYTE:
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            float value = normalized ? values[i] * 255.0f : values[i];
+            write((unsigned char)std::max(0.0f, std::min(value + 0.5f, 255.0f)), file);
+        }
+        for (unsigned int i = size; i < byteSize(); ++i)
+        {
+            write((unsigned char)0, file);
+        }
+        break;
+    case INT_2_10_10_10_REV:
+        {
+            // Signed normalized: x, y and z in 10 bits each and w (always 0) in the top 2 bits.
+            unsigned int packed = 0;
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                float value = i < 3 ? std::max(-1.0f, std::min(values[i], 1.0f)) : 0.0f;
+                int maxValue = i < 3 ? 511 : 1;
+                int bits = i < 3 ? 10 : 2;
+                int quantized = (int)floor(value * maxValue + 0.5f);
+                packed |= ((unsigned int)quantized & ((1u << bits) - 1)) << (i * 10);
+            }
+            write(packed, file);
+        }
+        break;
+    default:
+        write(values, (int)size, file);
+        break;
+    }
+}
+
 }
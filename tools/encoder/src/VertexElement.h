@@ -10,6 +10,17 @@ class VertexElement : public Object
 {
 public:
 
+    /**
+     * The data types of vertex element values (matching the GL enums).
+     */
+    enum Type
+    {
+        FLOAT = 0x1406,             // GL_FLOAT
+        HALF_FLOAT = 0x140B,        // GL_HALF_FLOAT
+        UNSIGNED_BYTE = 0x1401,     // GL_UNSIGNED_BYTE
+        INT_2_10_10_10_REV = 0x8D9F // GL_INT_2_10_10_10_REV
+    };
+
     /**
      * Constructor.
      */
@@ -26,8 +37,20 @@ public:
 
     static const char* usageStr(unsigned int usage);
 
+    /**
+     * Returns the size of the element in bytes, padded to a multiple of 4 bytes.
+     */
+    unsigned int byteSize() const;
+
+    /**
+     * Writes the values of the element in the element's type.
+     */
+    void writeBinaryValues(const float* values, FILE* file) const;
+
     unsigned int usage;
     unsigned int size;
+    Type type;
+    bool normalized;
 };
 
 }
@@ -0,0 +1,306 @@
+#include "Base.h"
+#include "VisibilitySet.h"
+#include "GPBFile.h"
+
+namespace gameplay
+{
+
+// The maximum number of cells along each axis of the grid.
+#define VISIBILITY_MAX_CELLS 64
+
+// The maximum number of mesh vertices used as ray targets for each node.
+#define VISIBILITY_MAX_VERTEX_SAMPLES 32
+
+// Fraction of the ends of each ray that is not tested, so that rays do not hit the
+// surfaces they start or end on.
+#define VISIBILITY_RAY_EPSILON 0.001f
+
+VisibilitySet::VisibilitySet(void) :
+    _cellSize(0.0f)
+{
+    _dimensions[0] = _dimensions[1] = _dimensions[2] = 0;
+}
+
+VisibilitySet::~VisibilitySet(void)
+{
+}
+
+unsigned int VisibilitySet::getTypeId(void) const
+{
+    return VISIBILITYSET_ID;
+}
+
+const char* VisibilitySet::getElementName(void) const
+{
+    return "VisibilitySet";
+}
+
+void VisibilitySet::writeBinary(FILE* file)
+{
+    Object::writeBinary(file);
+    writeVectorBinary(_origin, file);
+    write(_cellSize, file);
+    write(_dimensions[0], file);
+    write(_dimensions[1], file);
+    write(_dimensions[2], file);
+    write(_nodeIds, file);
+    write(_bits, file);
+}
+
+void VisibilitySet::writeText(FILE* file)
+{
+    fprintElementStart(file);
+    float origin[3] = { _origin.x, _origin.y, _origin.z };
+    float dimensions[3] = { (float)_dimensions[0], (float)_dimensions[1], (float)_dimensions[2] };
+    fprintfElement(file, "origin", origin, 3);
+    fprintfElement(file, "cellSize", _cellSize);
+    fprintfElement(file, "dimensions", dimensions, 3);
+    for (size_t i = 0, count = _nodeIds.size(); i < count; ++i)
+    {
+        fprintfElement(file, "node", _nodeIds[i]);
+    }
+    fprintfElement(file, "bytes", (unsigned int)_bits.size());
+    fprintElementEnd(file);
+}
+
+static Vector3 lerp(const Vector3& a, const Vector3& b, float t)
+{
+    return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+void VisibilitySet::generate(const std::vector<std::string>& nodeIds, const char* id, float cellSize)
+{
+    LOG(1, "Generating visibility set: %s...\n", id);
+
+    GPBFile* gpbFile = GPBFile::getInstance();
+    if (gpbFile->idExists(id))
+    {
+        LOG(1, "WARNING: Skipping generation of visibility set '%s'. The id is already used.\n", id);
+        return;
+    }
+    if (cellSize <= 0.0f)
+    {
+        LOG(1, "WARNING: Skipping generation of visibility set '%s'. The cell size must be positive.\n", id);
+        return;
+    }
+
+    VisibilitySet* set = new VisibilitySet();
+    set->setId(id);
+
+    // Gather the world-space triangles and bounds of the nodes.
+    std::vector<Occluder> occluders;
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (unsigned int i = 0, count = nodeIds.size(); i < count; ++i)
+    {
+        Node* node = gpbFile->getNode(nodeIds[i].c_str());
+        if (node == NULL)
+        {
+            LOG(1, "WARNING: Failed to locate node for visibility set argument: %s\n", nodeIds[i].c_str());
+            continue;
+        }
+        Mesh* mesh = node->getModel() ? node->getModel()->getMesh() : NULL;
+        if (mesh == NULL || mesh->vertices.empty())
+        {
+            LOG(1, "WARNING: Node passed to visibility set argument does not have a mesh: %s\n", nodeIds[i].c_str());
+            continue;
+        }
+
+        occluders.push_back(Occluder());
+        Occluder& occluder = occluders.back();
+        occluder.min.set(FLT_MAX, FLT_MAX, FLT_MAX);
+        occluder.max.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        set->_nodeIds.push_back(nodeIds[i]);
+
+        const Matrix& world = node->getWorldMatrix();
+        unsigned int vertexCount = mesh->vertices.size();
+        unsigned int step = std::max(1u, vertexCount / VISIBILITY_MAX_VERTEX_SAMPLES);
+        for (unsigned int j = 0; j < vertexCount; ++j)
+        {
+            Vector3 v;
+            world.transformPoint(mesh->vertices[j].position, &v);
+            occluder.min.set(std::min(occluder.min.x, v.x), std::min(occluder.min.y, v.y), std::min(occluder.min.z, v.z));
+            occluder.max.set(std::max(occluder.max.x, v.x), std::max(occluder.max.y, v.y), std::max(occluder.max.z, v.z));
+            if (j % step == 0)
+                occluder.samples.push_back(v);
+        }
+        for (unsigned int j = 0, partCount = mesh->parts.size(); j < partCount; ++j)
+        {
+            MeshPart* part = mesh->parts[j];
+            for (unsigned int k = 0, indexCount = part->getIndicesCount(); k + 2 < indexCount; k += 3)
+            {
+                for (unsigned int l = 0; l < 3; ++l)
+                {
+                    Vector3 v;
+                    world.transformPoint(mesh->vertices[part->getIndex(k + l)].position, &v);
+                    occluder.triangles.push_back(v);
+                }
+            }
+        }
+
+        // The center and corners of the bounds (pulled in slightly, since they usually
+        // lie on the surface of the mesh) are also ray targets.
+        Vector3 center = lerp(occluder.min, occluder.max, 0.5f);
+        occluder.samples.push_back(center);
+        for (unsigned int j = 0; j < 8; ++j)
+        {
+            Vector3 corner((j & 1) ? occluder.max.x : occluder.min.x,
+                           (j & 2) ? occluder.max.y : occluder.min.y,
+                           (j & 4) ? occluder.max.z : occluder.min.z);
+            occluder.samples.push_back(lerp(center, corner, 0.95f));
+        }
+
+        min.set(std::min(min.x, occluder.min.x), std::min(min.y, occluder.min.y), std::min(min.z, occluder.min.z));
+        max.set(std::max(max.x, occluder.max.x), std::max(max.y, occluder.max.y), std::max(max.z, occluder.max.z));
+    }
+
+    if (occluders.empty())
+    {
+        LOG(1, "WARNING: Skipping generation of visibility set '%s'. No meshes found.\n", id);
+        delete set;
+        return;
+    }
+
+    // Lay out the grid over the bounds of all the nodes.
+    set->_origin = min;
+    set->_cellSize = cellSize;
+    float extents[3] = { max.x - min.x, max.y - min.y, max.z - min.z };
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        unsigned int cells = (unsigned int)ceil(extents[i] / cellSize);
+        set->_dimensions[i] = std::max(1u, std::min(cells, (unsigned int)VISIBILITY_MAX_CELLS));
+    }
+    if (ceil(std::max(extents[0], std::max(extents[1], extents[2])) / cellSize) > VISIBILITY_MAX_CELLS)
+    {
+        set->_cellSize = std::max(extents[0], std::max(extents[1], extents[2])) / VISIBILITY_MAX_CELLS;
+        LOG(1, "WARNING: Visibility set '%s' cell size increased to %f to fit the grid.\n", id, set->_cellSize);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            set->_dimensions[i] = std::max(1u, std::min((unsigned int)ceil(extents[i] / set->_cellSize), (unsigned int)VISIBILITY_MAX_CELLS));
+        }
+    }
+
+    unsigned int cellCount = set->_dimensions[0] * set->_dimensions[1] * set->_dimensions[2];
+    unsigned int stride = (occluders.size() + 7) / 8;
+    set->_bits.resize(cellCount * stride, 0);
+
+    unsigned int visibleCount = 0;
+    float size = set->_cellSize;
+    for (unsigned int z = 0; z < set->_dimensions[2]; ++z)
+    {
+        for (unsigned int y = 0; y < set->_dimensions[1]; ++y)
+        {
+            for (unsigned int x = 0; x < set->_dimensions[0]; ++x)
+            {
+                unsigned int cell = x + (y + z * set->_dimensions[1]) * set->_dimensions[0];
+                Vector3 cellMin(min.x + x * size, min.y + y * size, min.z + z * size);
+                Vector3 cellMax(cellMin.x + size, cellMin.y + size, cellMin.z + size);
+
+                // Sample the center of the cell and the centers of its eight octants.
+                std::vector<Vector3> points;
+                points.push_back(lerp(cellMin, cellMax, 0.5f));
+                for (unsigned int i = 0; i < 8; ++i)
+                {
+                    points.push_back(Vector3(cellMin.x + size * ((i & 1) ? 0.75f : 0.25f),
+                                             cellMin.y + size * ((i & 2) ? 0.75f : 0.25f),
+                                             cellMin.z + size * ((i & 4) ? 0.75f : 0.25f)));
+                }
+
+                for (size_t i = 0, count = occluders.size(); i < count; ++i)
+                {
+                    const Occluder& target = occluders[i];
+                    bool visible = cellMin.x <= target.max.x && cellMax.x >= target.min.x &&
+                                   cellMin.y <= target.max.y && cellMax.y >= target.min.y &&
+                                   cellMin.z <= target.max.z && cellMax.z >= target.min.z;
+                    for (size_t j = 0; !visible && j < points.size(); ++j)
+                    {
+                        for (size_t k = 0; !visible && k < target.samples.size(); ++k)
+                        {
+                            visible = !isBlocked(occluders, i, points[j], target.samples[k]);
+                        }
+                    }
+                    if (visible)
+                    {
+                        set->_bits[cell * stride + i / 8] |= (unsigned char)(1 << (i % 8));
+                        ++visibleCount;
+                    }
+                }
+            }
+        }
+    }
+
+    LOG(2, "Visibility set '%s' has %u cells, with %.1f of %u nodes visible per cell on average.\n",
+        id, cellCount, (float)visibleCount / cellCount, (unsigned int)occluders.size());
+
+    gpbFile->addToRefTable(set);
+    gpbFile->add(set);
+}
+
+bool VisibilitySet::isBlocked(const std::vector<Occluder>& occluders, size_t ignore, const Vector3& a, const Vector3& b)
+{
+    Vector3 direction(b.x - a.x, b.y - a.y, b.z - a.z);
+    float tmin = VISIBILITY_RAY_EPSILON;
+    float tmax = 1.0f - VISIBILITY_RAY_EPSILON;
+
+    for (size_t i = 0, count = occluders.size(); i < count; ++i)
+    {
+        if (i == ignore)
+            continue;
+        const Occluder& occluder = occluders[i];
+
+        // Reject the occluders whose bounds the segment misses (slab test).
+        float t0 = tmin, t1 = tmax;
+        const float origin[3] = { a.x, a.y, a.z };
+        const float dir[3] = { direction.x, direction.y, direction.z };
+        const float bmin[3] = { occluder.min.x, occluder.min.y, occluder.min.z };
+        const float bmax[3] = { occluder.max.x, occluder.max.y, occluder.max.z };
+        bool miss = false;
+        for (unsigned int axis = 0; axis < 3 && !miss; ++axis)
+        {
+            if (fabs(dir[axis]) < 1e-12f)
+            {
+                miss = origin[axis] < bmin[axis] || origin[axis] > bmax[axis];
+                continue;
+            }
+            float inverse = 1.0f / dir[axis];
+            float tNear = (bmin[axis] - origin[axis]) * inverse;
+            float tFar = (bmax[axis] - origin[axis]) * inverse;
+            if (tNear > tFar)
+                std::swap(tNear, tFar);
+            t0 = std::max(t0, tNear);
+            t1 = std::min(t1, tFar);
+            miss = t0 > t1;
+        }
+        if (miss)
+            continue;
+
+        // Intersect the triangles (Moller-Trumbore), from either side.
+        for (size_t j = 0, triangleCount = occluder.triangles.size(); j + 2 < triangleCount; j += 3)
+        {
+            const Vector3& v0 = occluder.triangles[j];
+            Vector3 edge1(occluder.triangles[j + 1].x - v0.x, occluder.triangles[j + 1].y - v0.y, occluder.triangles[j + 1].z - v0.z);
+            Vector3 edge2(occluder.triangles[j + 2].x - v0.x, occluder.triangles[j + 2].y - v0.y, occluder.triangles[j + 2].z - v0.z);
+            Vector3 p;
+            Vector3::cross(direction, edge2, &p);
+            float determinant = Vector3::dot(edge1, p);
+            if (fabs(determinant) < 1e-12f)
+                continue;
+            float inverse = 1.0f / determinant;
+            Vector3 s(a.x - v0.x, a.y - v0.y, a.z - v0.z);
+            float u = Vector3::dot(s, p) * inverse;
+            if (u < 0.0f || u > 1.0f)
+                continue;
+            Vector3 q;
+            Vector3::cross(s, edge1, &q);
+            float v = Vector3::dot(direction, q) * inverse;
+            if (v < 0.0f || u + v > 1.0f)
+                continue;
+            float t = Vector3::dot(edge2, q) * inverse;
+            if (t > tmin && t < tmax)
+                return true;
+        }
+    }
+    return false;
+}
+
+}
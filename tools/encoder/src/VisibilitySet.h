@@ -0,0 +1,75 @@
+#ifndef VISIBILITYSET_H_
+#define VISIBILITYSET_H_
+
+#include "Object.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+/**
+ * A potentially visible set (PVS): for each cell of a uniform grid covering a set of
+ * static nodes, the nodes that can be seen from somewhere within the cell.
+ */
+class VisibilitySet : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    VisibilitySet(void);
+
+    /**
+     * Destructor.
+     */
+    virtual ~VisibilitySet(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+
+    /**
+     * Generates a potentially visible set for the specified nodes and adds it to the GPB file.
+     *
+     * The world-space bounds of the meshes of the nodes are divided into cubic cells. A node
+     * is visible from a cell if the cell overlaps its bounds, or if any of the rays cast from
+     * sample points in the cell to sample points of the node's bounds and vertices is not
+     * blocked by the triangles of the other nodes.
+     *
+     * @param nodeIds List of node ids to include in the set. Their meshes are the occluders.
+     * @param id The id of the visibility set.
+     * @param cellSize The size of the cells.
+     */
+    static void generate(const std::vector<std::string>& nodeIds, const char* id, float cellSize);
+
+private:
+
+    /**
+     * Defines the world-space triangles and bounds of a node.
+     */
+    struct Occluder
+    {
+        Vector3 min;
+        Vector3 max;
+        std::vector<Vector3> triangles;
+        std::vector<Vector3> samples;
+    };
+
+    /**
+     * Returns true if the segment from a to b is blocked by the triangles of any occluder
+     * other than the one at index ignore.
+     */
+    static bool isBlocked(const std::vector<Occluder>& occluders, size_t ignore, const Vector3& a, const Vector3& b);
+
+    std::vector<std::string> _nodeIds;
+    Vector3 _origin;
+    float _cellSize;
+    unsigned int _dimensions[3];
+    std::vector<unsigned char> _bits;
+};
+
+}
+
+#endif
@@ -4,6 +4,10 @@
 #include "GPBDecoder.h"
 #include "EncoderArguments.h"
 #include "NormalMapGenerator.h"
+#include "ArchiveWriter.h"
+#include "BatchEncoder.h"
+#include "BuildCache.h"
+#include "TextureEncoder.h"
 #include "Font.h"
 
 using namespace gameplay;
@@ -74,6 +78,7 @@ static std::vector<unsigned int> promptUserFontSize()
  * usage:   gameplay-encoder[options] <file_list>
  * example: gameplay-encoder C:/assets/duck.fbx
  * example: gameplay-encoder -i boy duck.fbx
+ * example: gameplay-encoder -batch -j 8 assets.txt
  *
  * @stod: Improve argument parsing.
  */
@@ -94,6 +99,39 @@ int main(int argc, const char** argv)
         return -1;
     }
 
+    if (arguments.batchEnabled())
+    {
+        LOG(1, "Encoding manifest: %s\n", arguments.getFilePathPointer());
+        std::string options;
+        if (!arguments.getCachePath().empty())
+        {
+            // Every line shares the cache of the batch.
+            options = "-cache \"" + arguments.getCachePath() + "\" ";
+        }
+        BatchEncoder encoder(argv[0], arguments.getFilePath().c_str(), arguments.getBatchJobCount(), options);
+        return encoder.run() ? 0 : -1;
+    }
+
+    if (arguments.archiveEnabled())
+    {
+        LOG(1, "Packing directory: %s\n", arguments.getFilePathPointer());
+        ArchiveWriter writer(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), arguments.compressArchiveEnabled());
+        return writer.write() ? 0 : -1;
+    }
+
+    // Decoding a binary only prints it, so there is nothing to cache.
+    BuildCache* cache = NULL;
+    if (!arguments.getCachePath().empty() && arguments.getFileFormat() != EncoderArguments::FILEFORMAT_GPB)
+    {
+        cache = new BuildCache(arguments.getCachePath().c_str(), arguments);
+        if (cache->isUpToDate())
+        {
+            LOG(1, "Up to date: %s\n", arguments.getFilePathPointer());
+            delete cache;
+            return 0;
+        }
+    }
+
     // File exists
     LOG(1, "Encoding file: %s\n", arguments.getFilePathPointer());
 
@@ -102,6 +140,7 @@ int main(int argc, const char** argv)
     case EncoderArguments::FILEFORMAT_DAE:
         {
             LOG(1, "Error: Collada support has been removed. Convert your DAE file to FBX.\n");
+            delete cache;
             return -1;
         }
     case EncoderArguments::FILEFORMAT_FBX:
@@ -125,11 +164,18 @@ int main(int argc, const char** argv)
             }
             else
             {
-                // Distance fields use size
+                // Distance fields use a single size that is scaled to every size at runtime.
                 if (fontSizes.size() == 0)
                 {
                     fontSizes.push_back(FONT_SIZE_DISTANCEFIELD);
                 }
+                else if (fontSizes.size() > 1)
+                {
+                    unsigned int fontSize = *std::max_element(fontSizes.begin(), fontSizes.end());
+                    LOG(1, "Distance field fonts scale to all sizes, only encoding size %u.\n", fontSize);
+                    fontSizes.clear();
+                    fontSizes.push_back(fontSize);
+                }
             }
             std::string id = getBaseName(arguments.getFilePath());
             writeFont(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), fontSizes, id.c_str(), arguments.fontPreviewEnabled(), fontFormat);
@@ -152,9 +198,20 @@ int main(int argc, const char** argv)
                 NormalMapGenerator generator(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), x, y, arguments.getHeightmapWorldSize());
                 generator.generate();
             }
+            else if (arguments.textureEnabled() && arguments.getFileFormat() == EncoderArguments::FILEFORMAT_PNG)
+            {
+                TextureEncoder encoder(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(),
+                    arguments.getMaxTextureSize(), arguments.powerOfTwoEnabled(), arguments.textureMipmapsEnabled());
+                if (!encoder.write())
+                {
+                    delete cache;
+                    return -1;
+                }
+            }
             else
             {
                 LOG(1, "Error: Nothing to do for specified file format. Did you forget an option?\n");
+                delete cache;
                 return -1;
             }
             break;
@@ -162,9 +219,16 @@ int main(int argc, const char** argv)
    default:
         {
             LOG(1, "Error: Unsupported file format: %s\n", arguments.getFilePathPointer());
+            delete cache;
             return -1;
         }
     }
 
+    if (cache)
+    {
+        cache->record();
+        delete cache;
+    }
+
     return 0;
 }
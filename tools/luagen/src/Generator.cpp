@@ -1390,6 +1390,7 @@ void Generator::generateBindings(string* bindingNS)
     string luaAllCppStr = _outDir + string(LUA_ALL_BINDINGS_FILENAME) + string(".cpp");
     ostringstream luaAllCpp;
     luaAllCpp << "#include \"Base.h\"\n";
+    luaAllCpp << "#include \"ScriptController.h\"\n";
     luaAllCpp << "#include \"" << string(LUA_ALL_BINDINGS_FILENAME) << ".h\"\n\n";
     if (bindingNS)
     {
@@ -1411,7 +1412,12 @@ void Generator::generateBindings(string* bindingNS)
                 iter->second.write(_outDir, _includes[iter->second.include], bindingNS);
 
                 luaAllH << "#include \"lua_" << iter->second.uniquename << ".h\"\n";
-                luaAllCpp << "    luaRegister_" << iter->second.uniquename << "();\n";
+
+                // Classes are registered the first time they are used, through the global of their outermost scope.
+                vector<string> scopePath = Generator::getScopePath(iter->second.classname, iter->second.ns);
+                const string& scope = scopePath.empty() ? iter->second.uniquename : scopePath[0];
+                luaAllCpp << "    gameplay::ScriptUtil::registerClassLazy(\"" << scope << "\", \"" << iter->second.uniquename << "\", ";
+                luaAllCpp << "luaRegister_" << iter->second.uniquename << ");\n";
             }
         }
     }